@@ -0,0 +1,120 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_ADAPTIVE_PARTICLE_RESOLUTION3_H_
+#define INCLUDE_JET_ADAPTIVE_PARTICLE_RESOLUTION3_H_
+
+#include <jet/particle_system_data3.h>
+#include <jet/scalar_field3.h>
+#include <memory>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D adaptive particle resolution by splitting and merging.
+//!
+//! This class gives each particle its own mass and radius, stored in two
+//! custom scalar data layers of the particle system, and refines the
+//! particles near a surface while coarsening the ones far from it. The target
+//! radius grows linearly from the min radius on the surface to the max radius
+//! at the transition distance, measured with the absolute value of the
+//! surface SDF. A particle larger than its target splits into two halves of
+//! the mass, and two nearby particles smaller than their targets merge into
+//! one, so the total mass and momentum are conserved. The other data layers
+//! are copied on split and mass-weighted on merge.
+//!
+//! The particle system keeps its uniform radius and mass, which the solvers
+//! still use. The layers are for the code that consumes the variable
+//! resolution.
+//!
+class AdaptiveParticleResolution3 {
+ public:
+    //!
+    //! \brief Constructs the adapter of the given particles.
+    //!
+    //! The mass and radius layers are added to \p particles, initialized with
+    //! its uniform mass and radius. The min and max radii default to the
+    //! uniform radius, which disables the adaptation until they are set.
+    //!
+    explicit AdaptiveParticleResolution3(
+        const ParticleSystemData3Ptr& particles);
+
+    //! Returns the index of the scalar data layer of the particle masses.
+    size_t massDataId() const;
+
+    //! Returns the index of the scalar data layer of the particle radii.
+    size_t radiusDataId() const;
+
+    //! Returns the radius of the particles on the surface.
+    double minRadius() const;
+
+    //! Sets the radius of the particles on the surface.
+    void setMinRadius(double newMinRadius);
+
+    //! Returns the radius of the particles beyond the transition distance.
+    double maxRadius() const;
+
+    //! Sets the radius of the particles beyond the transition distance.
+    void setMaxRadius(double newMaxRadius);
+
+    //! Returns the distance from the surface where the radius reaches max.
+    double transitionDistance() const;
+
+    //! Sets the distance from the surface where the radius reaches max.
+    void setTransitionDistance(double newDistance);
+
+    //! Returns the signed distance field of the surface.
+    const ScalarField3Ptr& surface() const;
+
+    //!
+    //! \brief Sets the signed distance field of the surface.
+    //!
+    //! It can be the fluid SDF of a solver, such as
+    //! PicSolver3::signedDistanceField, or any user-defined field. Without a
+    //! surface, update() does nothing.
+    //!
+    void setSurface(const ScalarField3Ptr& newSurface);
+
+    //! Returns the target radius at the given position.
+    double targetRadius(const Vector3D& x) const;
+
+    //!
+    //! \brief Splits and merges the particles toward their target radii.
+    //!
+    //! Each particle is split or merged at most once per call, so the
+    //! resolution changes by a factor of two in mass per call. Like resize,
+    //! this invalidates the neighbor searcher and lists of the particles.
+    //!
+    void update();
+
+    //! Returns the number of particles split by the last update.
+    size_t lastNumberOfSplits() const;
+
+    //! Returns the number of particle pairs merged by the last update.
+    size_t lastNumberOfMerges() const;
+
+ private:
+    ParticleSystemData3Ptr _particles;
+    ScalarField3Ptr _surface;
+    size_t _massDataId;
+    size_t _radiusDataId;
+    double _minRadius;
+    double _maxRadius;
+    double _transitionDistance = 1.0;
+    size_t _lastNumberOfSplits = 0;
+    size_t _lastNumberOfMerges = 0;
+
+    void split(
+        const Array1<double>& targetRadii, std::vector<char>* isChanged);
+
+    void merge(
+        const Array1<double>& targetRadii, const std::vector<char>& isChanged);
+};
+
+//! Shared pointer type for the AdaptiveParticleResolution3.
+typedef std::shared_ptr<AdaptiveParticleResolution3>
+    AdaptiveParticleResolution3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_ADAPTIVE_PARTICLE_RESOLUTION3_H_
@@ -10,6 +10,7 @@
 #include <jet/scalar_grid3.h>
 #include <limits>
 #include <memory>
+#include <vector>
 
 namespace jet {
 
@@ -17,7 +18,10 @@ namespace jet {
 //! \brief Abstract based class for 3-D grid-based advection solver.
 //!
 //! The implementation of this abstract base class should solve 3-D advection
-//! equation for scalar and vector fields.
+//! equation for scalar and vector fields. GridFluidSolver3 calls the advect
+//! functions from multiple threads at the same time for different outputs,
+//! so an implementation that keeps temporary buffers should not share them
+//! between the calls.
 //!
 class AdvectionSolver3 {
  public:
@@ -52,6 +56,32 @@ class AdvectionSolver3 {
         const ScalarField3& boundarySdf
             = ConstantScalarField3(kMaxD)) = 0;
 
+    //!
+    //! \brief Solves advection equation for given single-precision scalar
+    //! grid.
+    //!
+    //! Same as the double-precision version, but the input and the output
+    //! keep their data in floats, such as the passive scalars that do not
+    //! need double precision. The default implementation stages the grids
+    //! through double-precision cell-centered or vertex-centered grids, and
+    //! throws std::invalid_argument for the other grid types. Override this
+    //! function to sample the floats directly.
+    //!
+    //! \param input Input scalar grid.
+    //! \param flow Vector field that advects the input field.
+    //! \param dt Time-step for the advection.
+    //! \param output Output scalar grid.
+    //! \param boundarySdf Boundary interface defined by signed-distance
+    //!     field.
+    //!
+    virtual void advect(
+        const ScalarGrid3F& input,
+        const VectorField3& flow,
+        double dt,
+        ScalarGrid3F* output,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(kMaxD));
+
     //!
     //! \brief Solves advection equation for given collocated vector grid.
     //!
@@ -105,6 +135,35 @@ class AdvectionSolver3 {
         FaceCenteredGrid3* output,
         const ScalarField3& boundarySdf
             = ConstantScalarField3(kMaxD));
+
+    //!
+    //! \brief Solves advection equation for multiple collocated grids.
+    //!
+    //! This function advects every scalar grid in \p scalarInputs and every
+    //! collocated vector grid in \p vectorInputs with the same vector field
+    //! \p flow and time-step \p dt. The solution for the n-th input is stored
+    //! in the n-th grid of \p scalarOutputs or \p vectorOutputs. The default
+    //! implementation advects each grid separately. Override this function to
+    //! share the work between the grids.
+    //!
+    //! \param scalarInputs Input scalar grids.
+    //! \param vectorInputs Input collocated vector grids.
+    //! \param flow Vector field that advects the input fields.
+    //! \param dt Time-step for the advection.
+    //! \param scalarOutputs Output scalar grids.
+    //! \param vectorOutputs Output collocated vector grids.
+    //! \param boundarySdf Boundary interface defined by signed-distance
+    //!     field.
+    //!
+    virtual void advect(
+        const std::vector<const ScalarGrid3*>& scalarInputs,
+        const std::vector<const CollocatedVectorGrid3*>& vectorInputs,
+        const VectorField3& flow,
+        double dt,
+        const std::vector<ScalarGrid3*>& scalarOutputs,
+        const std::vector<CollocatedVectorGrid3*>& vectorOutputs,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(kMaxD));
 };
 
 typedef std::shared_ptr<AdvectionSolver3> AdvectionSolver3Ptr;
@@ -4,7 +4,10 @@
 #define INCLUDE_JET_ANIMATION_H_
 
 #include <jet/macros.h>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 
 namespace jet {
 
@@ -66,6 +69,33 @@ class Animation {
     //!
     void update(const Frame& frame);
 
+    //!
+    //! \brief Updates animation state for given \p frame on another thread.
+    //!
+    //! This function returns immediately, and the update runs on a thread of
+    //! its own, so that the caller, such as a viewport or an exporter, keeps
+    //! working while the animation advances. The update starts after the
+    //! previous asynchronous updates have finished, so the frames are
+    //! advanced in the order of the calls. The returned future becomes ready
+    //! when the update is done, and rethrows its exception if it throws. The
+    //! animation must not be destroyed nor modified before the future is
+    //! ready, except through readState, and this function must not be called
+    //! from several threads at once.
+    //!
+    std::shared_future<void> updateAsync(const Frame& frame);
+
+    //!
+    //! \brief Calls \p reader with the animation state in between updates.
+    //!
+    //! The updates and the readers exclude each other, so \p reader sees a
+    //! consistent state, such as the data of the last advanced frame, even
+    //! while an asynchronous update is running. It waits until the running
+    //! update, if any, finishes. It can also be called from a callback
+    //! invoked by the update itself, such as the frame callback of
+    //! PhysicsAnimation, in which case it runs immediately.
+    //!
+    void readState(const std::function<void()>& reader) const;
+
  protected:
     //!
     //! \brief The implementation of this function should update the animation
@@ -76,6 +106,10 @@ class Animation {
     //! this function and implement its logic for updating the animation state.
     //!
     virtual void onUpdate(const Frame& frame) = 0;
+
+ private:
+    mutable std::recursive_mutex _stateMutex;
+    std::shared_future<void> _lastAsyncUpdate;
 };
 
 typedef std::shared_ptr<Animation> AnimationPtr;
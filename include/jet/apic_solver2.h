@@ -0,0 +1,45 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_APIC_SOLVER2_H_
+#define INCLUDE_JET_APIC_SOLVER2_H_
+
+#include <jet/pic_solver2.h>
+
+namespace jet {
+
+//!
+//! \brief 2-D Affine Particle-in-Cell (APIC) implementation.
+//!
+//! This class implements 2-D Affine Particle-in-Cell (APIC) solver from the
+//! SIGGRAPH paper, Jiang et al. 2015. In addition to the velocity, each
+//! particle carries an affine velocity field which is stored as two extra
+//! vector data layers of the particle system data. The APIC transfer is
+//! stable like PIC while preserving the angular momentum, which allows
+//! larger time steps (higher max CFL) than FLIP for the same quality.
+//!
+//! \see Jiang, Chenfanfu, et al. "The affine particle-in-cell method."
+//!      ACM Transactions on Graphics (TOG) 34.4 (2015): 51.
+//!
+class ApicSolver2 : public PicSolver2 {
+ public:
+    //! Default constructor.
+    ApicSolver2();
+
+    //! Default destructor.
+    virtual ~ApicSolver2();
+
+ protected:
+    //! Transfers velocity field from particles to grids.
+    void transferFromParticlesToGrids() override;
+
+    //! Transfers velocity field from grids to particles.
+    void transferFromGridsToParticles() override;
+
+ private:
+    size_t _cXDataId;
+    size_t _cYDataId;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_APIC_SOLVER2_H_
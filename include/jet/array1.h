@@ -5,6 +5,7 @@
 
 #include <jet/array.h>
 #include <jet/array_accessor1.h>
+#include <jet/array_allocator.h>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -18,14 +19,16 @@ namespace jet {
 //!
 //! This class represents 1-D array data structure. This class is a simple
 //! wrapper around std::vector with some additional features such as the array
-//! accessor object, parallel for-loop and serialization.
+//! accessor object, parallel for-loop and serialization. The memory is
+//! accounted to MemoryTracker with the tag of the current MemoryTagScope, and
+//! the elements are initialized in parallel (see ArrayAllocator).
 //!
 //! \tparam T - Type to store in the array.
 //!
 template <typename T>
 class Array<T, 1> final {
  public:
-    typedef std::vector<T> ContainerType;
+    typedef std::vector<T, ArrayAllocator<T>> ContainerType;
 
     //! Constructs zero-sized 1-D array.
     Array();
@@ -52,6 +55,10 @@ class Array<T, 1> final {
     //! Copy constructor.
     Array(const Array& other);
 
+    //! Move constructor. Takes over the buffer of \p other, which is left
+    //! empty.
+    Array(Array&& other) noexcept;
+
     //! Sets entire array with given \p value.
     void set(const T& value);
 
@@ -67,6 +74,18 @@ class Array<T, 1> final {
     //! Resizes the array with \p size and fill the new element with \p initVal.
     void resize(size_t size, const T& initVal = T());
 
+    //!
+    //! \brief Reserves the memory for at least \p numberOfElements elements.
+    //!
+    //! This function does not change the size of the array, but the following
+    //! resize or append calls will not reallocate the memory until the size
+    //! exceeds the capacity.
+    //!
+    void reserve(size_t numberOfElements);
+
+    //! Returns the number of elements that can be stored without reallocation.
+    size_t capacity() const;
+
     //! Returns the reference to the i-th element.
     T& at(size_t i);
 
@@ -224,6 +243,9 @@ class Array<T, 1> final {
     //! Copies given array \p other to this array.
     Array& operator=(const Array& other);
 
+    //! Moves given array \p other to this array, leaving \p other empty.
+    Array& operator=(Array&& other) noexcept;
+
     //! Copies given initializer list \p lst to this array.
     Array& operator=(const std::initializer_list<T>& lst);
 
@@ -235,6 +257,10 @@ class Array<T, 1> final {
 
  private:
     ContainerType _data;
+
+    // Initializes the elements from beginIndex with valueAt(i) in parallel
+    template <typename Callback>
+    void initialize(size_t beginIndex, const Callback& valueAt);
 };
 
 template <typename T> using Array1 = Array<T, 1>;
@@ -5,6 +5,7 @@
 
 #include <jet/array.h>
 #include <jet/array_accessor2.h>
+#include <jet/array_allocator.h>
 #include <jet/size2.h>
 #include <fstream>
 #include <functional>
@@ -31,12 +32,14 @@ namespace jet {
 //! }
 //! \endcode
 //!
+//! The elements are initialized in parallel (see ArrayAllocator).
+//!
 //! \tparam T - Type to store in the array.
 //!
 template <typename T>
 class Array<T, 2> final {
  public:
-    typedef std::vector<T> ContainerType;
+    typedef std::vector<T, ArrayAllocator<T>> ContainerType;
 
     //! Constructs zero-sized 2-D array.
     Array();
@@ -76,6 +79,10 @@ class Array<T, 2> final {
     //! Copy constructor.
     Array(const Array& other);
 
+    //! Move constructor. Takes over the buffer of \p other, which is left
+    //! empty.
+    Array(Array&& other) noexcept;
+
     //! Sets entire array with given \p value.
     void set(const T& value);
 
@@ -105,7 +112,13 @@ class Array<T, 2> final {
     //! Clears the array and resizes to zero.
     void clear();
 
-    //! Resizes the array with \p size and fill the new element with \p initVal.
+    //!
+    //! \brief Resizes the array with \p size and fill the new element with
+    //!     \p initVal.
+    //!
+    //! Resizing to the current size leaves the array untouched, without
+    //! reallocating it.
+    //!
     void resize(const Size2& size, const T& initVal = T());
 
     //! Resizes the array with size \p width x \p height and fill the new
@@ -343,6 +356,9 @@ class Array<T, 2> final {
     //! Copies given array \p other to this array.
     Array& operator=(const Array& other);
 
+    //! Moves given array \p other to this array, leaving \p other empty.
+    Array& operator=(Array&& other) noexcept;
+
     //!
     //! Copies given initializer list \p lst to this array.
     //!
@@ -372,7 +388,11 @@ class Array<T, 2> final {
 
  private:
     Size2 _size;
-    std::vector<T> _data;
+    ContainerType _data;
+
+    // Initializes the elements with valueAt(i, j) in parallel
+    template <typename Callback>
+    void initialize(const Callback& valueAt);
 };
 
 template <typename T> using Array2 = Array<T, 2>;
@@ -5,6 +5,7 @@
 
 #include <jet/array.h>
 #include <jet/array_accessor3.h>
+#include <jet/array_allocator.h>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -32,12 +33,14 @@ namespace jet {
 //! }
 //! \endcode
 //!
+//! The elements are initialized in parallel (see ArrayAllocator).
+//!
 //! \tparam T - Type to store in the array.
 //!
 template <typename T>
 class Array<T, 3> final {
  public:
-    typedef std::vector<T> ContainerType;
+    typedef std::vector<T, ArrayAllocator<T>> ContainerType;
 
     //! Constructs zero-sized 3-D array.
     Array();
@@ -84,6 +87,10 @@ class Array<T, 3> final {
     //! Copy constructor.
     Array(const Array& other);
 
+    //! Move constructor. Takes over the buffer of \p other, which is left
+    //! empty.
+    Array(Array&& other) noexcept;
+
     //! Sets entire array with given \p value.
     void set(const T& value);
 
@@ -118,7 +125,13 @@ class Array<T, 3> final {
     //! Clears the array and resizes to zero.
     void clear();
 
-    //! Resizes the array with \p size and fill the new element with \p initVal.
+    //!
+    //! \brief Resizes the array with \p size and fill the new element with
+    //!     \p initVal.
+    //!
+    //! Resizing to the current size leaves the array untouched, without
+    //! reallocating it.
+    //!
     void resize(const Size3& size, const T& initVal = T());
 
     //! Resizes the array with size \p width x \p height and fill the new
@@ -188,6 +201,26 @@ class Array<T, 3> final {
     //! Returns the const raw pointer to the array data.
     const T* const data() const;
 
+    //! Returns the pointer to the x-row at (j, k) of width() elements.
+    T* row(size_t j, size_t k);
+
+    //! Returns the const pointer to the x-row at (j, k) of width() elements.
+    const T* row(size_t j, size_t k) const;
+
+    //! Returns the pointer to the xy-slice at k of width() * height()
+    //! elements.
+    T* slice(size_t k);
+
+    //! Returns the const pointer to the xy-slice at k of width() * height()
+    //! elements.
+    const T* slice(size_t k) const;
+
+    //! Returns the distance in elements between the x-rows at j and j + 1.
+    size_t rowStride() const;
+
+    //! Returns the distance in elements between the xy-slices at k and k + 1.
+    size_t sliceStride() const;
+
     //! Returns the array accessor.
     ArrayAccessor3<T> accessor();
 
@@ -301,6 +334,46 @@ class Array<T, 3> final {
     template <typename Callback>
     void parallelForEachIndex(Callback func) const;
 
+    //!
+    //! \brief Iterates the x-rows of the array and invokes given \p func for
+    //!     each of them.
+    //!
+    //! The callback function takes the (j, k) indices of the row, whose
+    //! elements are contiguous, in the same order as the nested for-loop
+    //! below:
+    //!
+    //! \code{.cpp}
+    //! for (size_t k = 0; k < array.depth(); ++k) {
+    //!     for (size_t j = 0; j < array.height(); ++j) {
+    //!         func(j, k);
+    //!     }
+    //! }
+    //! \endcode
+    //!
+    template <typename Callback>
+    void forEachRow(Callback func) const;
+
+    //!
+    //! \brief Iterates the x-rows of the array and invokes given \p func for
+    //!     each of them in parallel.
+    //!
+    //! The callback function takes the (j, k) indices of the row. The order
+    //! of execution will be non-deterministic since it runs in parallel.
+    //! Below is the sample usage:
+    //!
+    //! \code{.cpp}
+    //! Array<double, 3> array(100, 200, 150, 4.0);
+    //! array.parallelForEachRow([&](size_t j, size_t k) {
+    //!     double* row = array.row(j, k);
+    //!     for (size_t i = 0; i < array.width(); ++i) {
+    //!         row[i] *= 2.0;
+    //!     }
+    //! });
+    //! \endcode
+    //!
+    template <typename Callback>
+    void parallelForEachRow(Callback func) const;
+
     //!
     //! \brief Serializes the content of the array to the output stream \p strm.
     //!
@@ -368,6 +441,9 @@ class Array<T, 3> final {
     //! Copies given array \p other to this array.
     Array& operator=(const Array& other);
 
+    //! Moves given array \p other to this array, leaving \p other empty.
+    Array& operator=(Array&& other) noexcept;
+
     //!
     //! Copies given initializer list \p lst to this array.
     //!
@@ -401,7 +477,11 @@ class Array<T, 3> final {
 
  private:
     Size3 _size;
-    std::vector<T> _data;
+    ContainerType _data;
+
+    // Initializes the elements with valueAt(i, j, k) in parallel
+    template <typename Callback>
+    void initialize(const Callback& valueAt);
 };
 
 template <typename T> using Array3 = Array<T, 3>;
@@ -99,6 +99,19 @@ class ArrayAccessor<T, 3> final {
     //! Returns the raw pointer to the array data.
     T* const data() const;
 
+    //! Returns the pointer to the x-row at (j, k) of width() elements.
+    T* row(size_t j, size_t k) const;
+
+    //! Returns the pointer to the xy-slice at k of width() * height()
+    //! elements.
+    T* slice(size_t k) const;
+
+    //! Returns the distance in elements between the x-rows at j and j + 1.
+    size_t rowStride() const;
+
+    //! Returns the distance in elements between the xy-slices at k and k + 1.
+    size_t sliceStride() const;
+
     //! Swaps the content of with \p other array accessor.
     void swap(ArrayAccessor& other);
 
@@ -212,6 +225,46 @@ class ArrayAccessor<T, 3> final {
     template <typename Callback>
     void parallelForEachIndex(Callback func) const;
 
+    //!
+    //! \brief Iterates the x-rows of the array and invokes given \p func for
+    //!     each of them.
+    //!
+    //! The callback function takes the (j, k) indices of the row, whose
+    //! elements are contiguous, so the kernel can run a plain loop over the
+    //! pointers of row(j, k) and of its neighbors. The order of execution
+    //! will be the same as the nested for-loop below:
+    //!
+    //! \code{.cpp}
+    //! for (size_t k = 0; k < acc.depth(); ++k) {
+    //!     for (size_t j = 0; j < acc.height(); ++j) {
+    //!         func(j, k);
+    //!     }
+    //! }
+    //! \endcode
+    //!
+    template <typename Callback>
+    void forEachRow(Callback func) const;
+
+    //!
+    //! \brief Iterates the x-rows of the array and invokes given \p func for
+    //!     each of them in parallel.
+    //!
+    //! The callback function takes the (j, k) indices of the row. The order
+    //! of execution will be non-deterministic since it runs in parallel.
+    //! Below is the sample usage:
+    //!
+    //! \code{.cpp}
+    //! acc.parallelForEachRow([&](size_t j, size_t k) {
+    //!     double* row = acc.row(j, k);
+    //!     for (size_t i = 0; i < acc.width(); ++i) {
+    //!         row[i] *= 2.0;
+    //!     }
+    //! });
+    //! \endcode
+    //!
+    template <typename Callback>
+    void parallelForEachRow(Callback func) const;
+
     //! Returns the linear index of the given 3-D coordinate (pt.x, pt.y, pt.z).
     size_t index(const Point3UI& pt) const;
 
@@ -316,6 +369,19 @@ class ConstArrayAccessor<T, 3> {
     //! Returns the raw pointer to the array data.
     const T* const data() const;
 
+    //! Returns the pointer to the x-row at (j, k) of width() elements.
+    const T* row(size_t j, size_t k) const;
+
+    //! Returns the pointer to the xy-slice at k of width() * height()
+    //! elements.
+    const T* slice(size_t k) const;
+
+    //! Returns the distance in elements between the x-rows at j and j + 1.
+    size_t rowStride() const;
+
+    //! Returns the distance in elements between the xy-slices at k and k + 1.
+    size_t sliceStride() const;
+
     //!
     //! \brief Iterates the array and invoke given \p func for each index.
     //!
@@ -403,6 +469,26 @@ class ConstArrayAccessor<T, 3> {
     template <typename Callback>
     void parallelForEachIndex(Callback func) const;
 
+    //!
+    //! \brief Iterates the x-rows of the array and invokes given \p func for
+    //!     each of them.
+    //!
+    //! The callback function takes the (j, k) indices of the row, and the
+    //! rows are visited in the same order as ArrayAccessor3::forEachRow.
+    //!
+    template <typename Callback>
+    void forEachRow(Callback func) const;
+
+    //!
+    //! \brief Iterates the x-rows of the array and invokes given \p func for
+    //!     each of them in parallel.
+    //!
+    //! The callback function takes the (j, k) indices of the row. The order
+    //! of execution will be non-deterministic since it runs in parallel.
+    //!
+    template <typename Callback>
+    void parallelForEachRow(Callback func) const;
+
     //! Returns the linear index of the given 3-D coordinate (pt.x, pt.y, pt.z).
     size_t index(const Point3UI& pt) const;
 
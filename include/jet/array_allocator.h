@@ -0,0 +1,157 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_ARRAY_ALLOCATOR_H_
+#define INCLUDE_JET_ARRAY_ALLOCATOR_H_
+
+#include <jet/memory_tracker.h>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace jet {
+
+//! Alignment in bytes of the elements of Array1, Array2 and Array3.
+const size_t kArrayAlignment = 64;
+
+//!
+//! \brief Huge page policies of the large arrays.
+//!
+//! A 512^3 grid of doubles spans a quarter million 4 KB pages, so the random
+//! accesses of the samplers and the particle-to-grid transfers miss the TLB
+//! on most loads. Backing the arrays with 2 MB pages cuts the number of the
+//! pages by 512.
+//!
+enum class ArrayHugePagePolicy {
+    //! Regular pages from operator new.
+    None = 0,
+
+    //! Transparent huge pages requested with madvise(MADV_HUGEPAGE).
+    Transparent,
+
+    //! Explicit huge pages from the pool reserved by the system, such as
+    //! with mmap(MAP_HUGETLB), which falls back to Transparent if the pool
+    //! runs out.
+    Explicit
+};
+
+//!
+//! \brief      Returns the huge page policy of the large arrays.
+//!
+//! The default is ArrayHugePagePolicy::None.
+//!
+ArrayHugePagePolicy arrayHugePagePolicy();
+
+//!
+//! \brief      Sets the huge page policy of the large arrays.
+//!
+//! The policy applies to the arrays allocated afterwards, whose size is at
+//! least arrayHugePageMinBytes(). If the pages cannot be mapped, the arrays
+//! fall back to operator new. Throws std::invalid_argument if the policy is
+//! not supported on this platform.
+//!
+//! \param[in]  policy The huge page policy.
+//!
+void setArrayHugePagePolicy(ArrayHugePagePolicy policy);
+
+//!
+//! \brief      Returns true if the huge page policy is supported.
+//!
+//! ArrayHugePagePolicy::None is always supported, and the others are only
+//! supported on Linux.
+//!
+bool isArrayHugePagePolicySupported(ArrayHugePagePolicy policy);
+
+//! Returns the min bytes of an array that follows the huge page policy.
+size_t arrayHugePageMinBytes();
+
+//!
+//! \brief      Sets the min bytes of an array that follows the huge page
+//!             policy.
+//!
+//! The arrays are mapped in multiples of 2 MB, so the default is 32 MB,
+//! which keeps the waste of the last page under 7%.
+//!
+//! \param[in]  bytes The min bytes.
+//!
+void setArrayHugePageMinBytes(size_t bytes);
+
+//!
+//! \brief Allocator of the arrays that leaves the elements to be initialized
+//!     by the arrays in parallel.
+//!
+//! Operating systems map a page to the NUMA node of the thread that touches
+//! it first. If std::vector value-initializes the elements on the calling
+//! thread, all the pages of an array land on one node, and the parallel
+//! loops over the array are then bound by the bandwidth of that node. This
+//! allocator skips the value-initialization of the trivially destructible
+//! types, and Array1, Array2 and Array3 construct the elements over the same
+//! chunks as their parallelForEachIndex, so each page is first touched by
+//! the thread that will sweep it. The memory is accounted to MemoryTracker
+//! like MemoryTrackingAllocator, and the first element is aligned to
+//! kArrayAlignment bytes, which is a cache line and the widest SIMD register,
+//! so that the vectorized kernels never split a load across two lines at the
+//! beginning of an array.
+//!
+template <typename T>
+class ArrayAllocator : public MemoryTrackingAllocator<T> {
+ public:
+    template <typename U>
+    struct rebind {
+        typedef ArrayAllocator<U> other;
+    };
+
+    ArrayAllocator() = default;
+
+    template <typename U>
+    ArrayAllocator(const ArrayAllocator<U>&) {}
+
+    //! Allocates memory for \p n objects aligned to kArrayAlignment bytes.
+    T* allocate(size_t n);
+
+    //! Releases the memory for \p n objects at \p p.
+    void deallocate(T* p, size_t n);
+
+    //! Leaves the trivially destructible element at \p p uninitialized.
+    template <typename U>
+    typename std::enable_if<std::is_trivially_destructible<U>::value>::type
+    construct(U* p);
+
+    //! Value-initializes the element at \p p.
+    template <typename U>
+    typename std::enable_if<!std::is_trivially_destructible<U>::value>::type
+    construct(U* p);
+
+    //! Constructs the element at \p p with \p args.
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args);
+};
+
+namespace internal {
+
+//! Min bytes of an array that is initialized in parallel.
+const size_t kFirstTouchMinBytes = 1 << 16;
+
+//!
+//! Maps at least \p bytes with huge pages following the huge page policy,
+//! and returns the address aligned to the huge page size, or nullptr if the
+//! pages cannot be mapped. The mapped bytes are stored in \p mappedBytes.
+//!
+void* mapHugePageArrayMemory(size_t bytes, size_t* mappedBytes);
+
+//! Unmaps \p mappedBytes at \p block mapped by mapHugePageArrayMemory.
+void unmapHugePageArrayMemory(void* block, size_t mappedBytes);
+
+//!
+//! Initializes the element at \p element, which is left uninitialized by
+//! ArrayAllocator if T is trivially destructible, with \p value.
+//!
+template <typename T>
+void initializeArrayElement(T* element, const T& value);
+
+}  // namespace internal
+
+}  // namespace jet
+
+#include "detail/array_allocator-inl.h"
+
+#endif  // INCLUDE_JET_ARRAY_ALLOCATOR_H_
@@ -61,6 +61,11 @@ class LinearArraySampler<T, R, 2> final {
         std::array<Point2UI, 4>* indices,
         std::array<R, 4>* weights) const;
 
+    void getCoordinatesAndGradientWeights(
+        const Vector2<R>& pt,
+        std::array<Point2UI, 4>* indices,
+        std::array<Vector2<R>, 4>* weights) const;
+
     std::function<T(const Vector2<R>&)> functor() const;
 
  private:
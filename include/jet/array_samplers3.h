@@ -6,6 +6,7 @@
 #include <jet/array_samplers.h>
 #include <jet/array_accessor3.h>
 #include <jet/vector3.h>
+#include <array>
 #include <functional>
 
 namespace jet {
@@ -40,6 +41,33 @@ template <typename T, typename R> using NearestArraySampler3
     = NearestArraySampler<T, R, 3>;
 
 
+//!
+//! \brief Taps and fractions of a trilinear sample point.
+//!
+//! The taps are the 2 x 2 x 2 corners of the cell that contains the point,
+//! clamped to the array. They are given by the two x indices and the four
+//! offsets of the (y, z) rows, so the stencil is valid for any array of the
+//! same size.
+//!
+template <typename R>
+struct LinearSamplerStencil3 {
+    //! Clamped x indices of the taps.
+    std::array<size_t, 2> i;
+
+    //! Offsets of the 2 x 2 (y, z) rows of the taps, y-first.
+    std::array<size_t, 4> rowOffsets;
+
+    //! Fractions of the point within the cell.
+    Vector3<R> fraction;
+};
+
+//!
+//! \brief 3-D trilinear array sampler.
+//!
+//! A stencil from getStencil can be reused by all samplers of arrays with the
+//! same size, grid spacing, and origin, which gives the same samples as
+//! operator() without locating the point for each array.
+//!
 template <typename T, typename R>
 class LinearArraySampler<T, R, 3> final {
  public:
@@ -56,11 +84,23 @@ class LinearArraySampler<T, R, 3> final {
 
     T operator()(const Vector3<R>& pt) const;
 
+    //! Returns the sample with the stencil of a point.
+    T sample(const LinearSamplerStencil3<R>& stencil) const;
+
+    //! Computes the taps and the fractions of the given point.
+    void getStencil(
+        const Vector3<R>& pt, LinearSamplerStencil3<R>* stencil) const;
+
     void getCoordinatesAndWeights(
         const Vector3<R>& pt,
         std::array<Point3UI, 8>* indices,
         std::array<R, 8>* weights) const;
 
+    void getCoordinatesAndGradientWeights(
+        const Vector3<R>& pt,
+        std::array<Point3UI, 8>* indices,
+        std::array<Vector3<R>, 8>* weights) const;
+
     std::function<T(const Vector3<R>&)> functor() const;
 
  private:
@@ -73,6 +113,45 @@ template <typename T, typename R> using LinearArraySampler3
     = LinearArraySampler<T, R, 3>;
 
 
+//!
+//! \brief Taps and weights of a tricubic sample point.
+//!
+//! The taps are the 4 x 4 x 4 neighbors of the point, clamped to the array.
+//! They are given by the four x indices and the sixteen offsets of the (y, z)
+//! rows, so the stencil is valid for any array of the same size. The
+//! fractions and the Catmull-Rom weights are separate per axis.
+//!
+template <typename R>
+struct CubicSamplerStencil3 {
+    //! Clamped x indices of the taps.
+    std::array<size_t, 4> i;
+
+    //! Offsets of the 4 x 4 (y, z) rows of the taps, y-first.
+    std::array<size_t, 16> rowOffsets;
+
+    //! Fractions of the point within the center cell.
+    Vector3<R> fraction;
+
+    //! Catmull-Rom weights of the taps along x.
+    std::array<R, 4> wx;
+
+    //! Catmull-Rom weights of the taps along y.
+    std::array<R, 4> wy;
+
+    //! Catmull-Rom weights of the taps along z.
+    std::array<R, 4> wz;
+};
+
+//!
+//! \brief 3-D tricubic array sampler using Catmull-Rom splines.
+//!
+//! The monotonic sampler (default) limits the slopes of each spline to avoid
+//! overshoots, so it evaluates the 21 splines one after another. Otherwise
+//! the interpolation is linear in the samples, and it is evaluated as the
+//! separable sum of the 64 taps with the per-axis weights. Either way, a
+//! stencil from getStencil can be reused by all samplers of arrays with the
+//! same size, grid spacing, and origin.
+//!
 template <typename T, typename R>
 class CubicArraySampler<T, R, 3> final {
  public:
@@ -83,18 +162,30 @@ class CubicArraySampler<T, R, 3> final {
     explicit CubicArraySampler(
         const ConstArrayAccessor3<T>& accessor,
         const Vector3<R>& gridSpacing,
-        const Vector3<R>& gridOrigin);
+        const Vector3<R>& gridOrigin,
+        bool isMonotonic = true);
 
     CubicArraySampler(const CubicArraySampler& other);
 
     T operator()(const Vector3<R>& pt) const;
 
+    //! Returns the sample with the stencil of a point.
+    T sample(const CubicSamplerStencil3<R>& stencil) const;
+
+    //! Computes the taps and the weights of the given point.
+    void getStencil(
+        const Vector3<R>& pt, CubicSamplerStencil3<R>* stencil) const;
+
+    //! Returns true if the slopes are limited to be monotonic.
+    bool isMonotonic() const;
+
     std::function<T(const Vector3<R>&)> functor() const;
 
  private:
     Vector3<R> _gridSpacing;
     Vector3<R> _origin;
     ConstArrayAccessor3<T> _accessor;
+    bool _isMonotonic = true;
 };
 
 template <typename T, typename R> using CubicArraySampler3
@@ -8,6 +8,8 @@
 #include <jet/array1.h>
 #include <jet/array2.h>
 #include <jet/array3.h>
+#include <jet/bit_array3.h>
+#include <vector>
 
 namespace jet {
 
@@ -128,6 +130,31 @@ void copyRange3(
     size_t endZ,
     ArrayType2* output);
 
+//!
+//! \brief Copies 3-D \p input array to \p output array shifted by \p offset.
+//!
+//! The element of \p output at (i, j, k) takes the element of \p input at
+//! (i, j, k) + \p offset. The elements whose source is out of \p input take
+//! the value of the nearest element inside, which extends the data with the
+//! zero gradient. The arrays can have different sizes, but must not overlap.
+//!
+template <typename T>
+void copyShiftedRange3(
+    const ConstArrayAccessor3<T>& input,
+    const Point3I& offset,
+    ArrayAccessor3<T> output);
+
+//!
+//! \brief Shifts 3-D \p output array by \p offset in place.
+//!
+//! The element at (i, j, k) takes the value that was at (i, j, k) + \p offset.
+//! The elements whose source is out of the array take the value of the
+//! nearest element inside, which extends the data with the zero gradient.
+//! The array is copied once to a temporary buffer.
+//!
+template <typename T>
+void shiftRange3(const Point3I& offset, ArrayAccessor3<T> output);
+
 //!
 //! \brief Extrapolates 2-D input data from 'valid' (1) to 'invalid' (0) region.
 //!
@@ -170,6 +197,82 @@ void extrapolateToRegion(
     unsigned int numberOfIterations,
     ArrayAccessor3<T> output);
 
+//!
+//! \brief Scratch buffers for the 3-D extrapolateToRegion.
+//!
+//! The buffers can be kept by the caller between the calls so that the
+//! extrapolation does not allocate memory once the buffers have grown.
+//!
+struct ExtrapolationBuffers3 {
+    //! Validity of each data point during the extrapolation.
+    BitArray3 valid;
+
+    //! Invalid data points next to the valid region, to be filled in the
+    //! current pass.
+    BitArray3 front;
+
+    //! Front of the next pass.
+    BitArray3 nextFront;
+
+    //! Indices (j + ny * k) of the rows that hold the front.
+    std::vector<size_t> frontRows;
+
+    //! Indices of the rows that may hold the next front.
+    std::vector<size_t> candidateRows;
+
+    //! Per-row flags, which are all cleared between the uses.
+    std::vector<char> rowFlags;
+};
+
+//!
+//! \brief Extrapolates 3-D input data from 'valid' (1) to 'invalid' (0) region
+//! using given scratch buffers.
+//!
+//! This function gives the same result as the function above. The validity
+//! is kept as a bit mask, and the front, which is the set of invalid points
+//! next to the valid region, is found by dilating the mask 64 points at a
+//! time. Each iteration fills the front in parallel and grows the valid
+//! region by one layer. After the first iteration, only the rows around the
+//! front are visited, so the work is bounded by the band of
+//! \p numberOfIterations points around the valid region rather than the
+//! whole array. The data is not copied when \p input and \p output are the
+//! same array.
+//!
+//! \param input - data to extrapolate
+//! \param valid - set 1 if valid, else 0.
+//! \param numberOfIterations - number of iterations for propagation
+//! \param output - extrapolated output
+//! \param buffers - scratch buffers
+//!
+template <typename T>
+void extrapolateToRegion(
+    const ConstArrayAccessor3<T>& input,
+    const ConstArrayAccessor3<char>& valid,
+    unsigned int numberOfIterations,
+    ArrayAccessor3<T> output,
+    ExtrapolationBuffers3* buffers);
+
+//!
+//! \brief Extrapolates 3-D input data from the set bits of 'valid' to the
+//! other bits using given scratch buffers.
+//!
+//! Same as the function above, but takes the validity as a bit mask, which
+//! saves the conversion from the byte markers.
+//!
+//! \param input - data to extrapolate
+//! \param valid - set if valid.
+//! \param numberOfIterations - number of iterations for propagation
+//! \param output - extrapolated output
+//! \param buffers - scratch buffers
+//!
+template <typename T>
+void extrapolateToRegion(
+    const ConstArrayAccessor3<T>& input,
+    const BitArray3& valid,
+    unsigned int numberOfIterations,
+    ArrayAccessor3<T> output,
+    ExtrapolationBuffers3* buffers);
+
 //!
 //! Converts 2-D array to Comma Separated Value (CSV) stream.
 //!
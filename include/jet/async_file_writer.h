@@ -0,0 +1,80 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_ASYNC_FILE_WRITER_H_
+#define INCLUDE_JET_ASYNC_FILE_WRITER_H_
+
+#include <jet/macros.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace jet {
+
+//!
+//! \brief Writes files on a background thread.
+//!
+//! Each write is queued with a function that writes the data to the opened
+//! file stream. The writes run one after another on the background thread in
+//! the order they were queued, so the function should only touch the data it
+//! owns, such as a snapshot of the simulation state captured by value or by a
+//! shared pointer. When the max number of writes are pending, write blocks
+//! until the oldest one finishes, which bounds the memory held by the
+//! snapshots. For example, with the default of two, the next frame can be
+//! simulated while the current one is written.
+//!
+//! If a write function throws, the exception is rethrown from the next call
+//! to write or flush, and the writes queued later still run.
+//!
+class AsyncFileWriter {
+ public:
+    JET_NON_COPYABLE(AsyncFileWriter)
+
+    //! Function that writes the data to the given file stream.
+    typedef std::function<void(std::ostream*)> WriteFunction;
+
+    //! Constructs a writer holding up to \p maxNumberOfPendingWrites writes.
+    explicit AsyncFileWriter(size_t maxNumberOfPendingWrites = 2);
+
+    //! Waits for the pending writes and stops the background thread.
+    ~AsyncFileWriter();
+
+    //! Queues a write of \p filename, blocking while the queue is full.
+    void write(const std::string& filename, const WriteFunction& func);
+
+    //! Waits until all the pending writes finish.
+    void flush();
+
+    //! Returns the max number of pending writes.
+    size_t maxNumberOfPendingWrites() const;
+
+    //! Returns the number of the queued or running writes.
+    size_t numberOfPendingWrites() const;
+
+ private:
+    struct Task {
+        std::string filename;
+        WriteFunction func;
+    };
+
+    size_t _maxNumberOfPendingWrites;
+    std::deque<Task> _tasks;
+    bool _isStopping = false;
+    std::exception_ptr _exception;
+    mutable std::mutex _mutex;
+    std::condition_variable _taskQueued;
+    std::condition_variable _taskFinished;
+    std::thread _thread;
+
+    void run();
+
+    void rethrowException();
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_ASYNC_FILE_WRITER_H_
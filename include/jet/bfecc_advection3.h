@@ -0,0 +1,29 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_BFECC_ADVECTION3_H_
+#define INCLUDE_JET_BFECC_ADVECTION3_H_
+
+#include <jet/error_corrected_semi_lagrangian3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D back and forth error compensation and correction (BFECC)
+//! advection solver.
+//!
+//! This class advects the input forward and backward by the semi-Lagrangian
+//! method, corrects the input by half of the round-trip error, and advects
+//! the corrected input forward. It costs three semi-Lagrangian samples per
+//! data point and is second-order accurate where the field is smooth.
+//!
+//! \see Kim, ByungMoon, et al. "FlowFixer: Using BFECC for fluid
+//!     simulation." Eurographics Workshop on Natural Phenomena (2005).
+//!
+class BfeccAdvection3 final : public ErrorCorrectedSemiLagrangian3 {
+ public:
+    BfeccAdvection3();
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_BFECC_ADVECTION3_H_
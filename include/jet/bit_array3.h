@@ -0,0 +1,127 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_BIT_ARRAY3_H_
+#define INCLUDE_JET_BIT_ARRAY3_H_
+
+#include <jet/array_accessor3.h>
+#include <jet/size3.h>
+#include <cstdint>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D bit array class.
+//!
+//! This class represents a 3-D array of flags such as the markers of the
+//! valid or the fluid data points, with one bit per element. The bits along
+//! the x-axis are packed into 64-bit words, and each (j, k) row starts with a
+//! new word, so a row is a contiguous span of wordsPerRow() words. The bits
+//! past the width of the last word of a row are always zero. Set operations
+//! and the dilation work on the whole words, 64 elements at a time.
+//!
+//! Writing a bit modifies the word that contains it, so two threads must not
+//! write to the same row at the same time. The parallel functions of this
+//! class assign each row to a single thread.
+//!
+class BitArray3 final {
+ public:
+    //! Storage type of the packed bits.
+    typedef uint64_t Word;
+
+    //! Number of bits per word.
+    static const size_t kBitsPerWord = 64;
+
+    //! Constructs zero-sized 3-D bit array.
+    BitArray3();
+
+    //! Constructs 3-D bit array with given \p size and \p initVal.
+    explicit BitArray3(const Size3& size, bool initVal = false);
+
+    //! Resizes the array and sets all the bits to \p initVal.
+    void resize(const Size3& size, bool initVal = false);
+
+    //! Sets all the bits to \p value.
+    void set(bool value);
+
+    //! Sets the bits where \p mask is non-zero, after resizing to its size.
+    void set(const ConstArrayAccessor3<char>& mask);
+
+    //! Sets the (i, j, k) bit to \p value.
+    void set(size_t i, size_t j, size_t k, bool value);
+
+    //! Returns the (i, j, k) bit.
+    bool operator()(size_t i, size_t j, size_t k) const;
+
+    //! Returns the size of the array.
+    Size3 size() const;
+
+    //! Returns the number of words per (j, k) row.
+    size_t wordsPerRow() const;
+
+    //! Returns the pointer to the first word of the (j, k) row.
+    Word* row(size_t j, size_t k);
+
+    //! Returns the pointer to the first word of the (j, k) row.
+    const Word* row(size_t j, size_t k) const;
+
+    //! Returns the number of the set bits.
+    size_t count() const;
+
+    //!
+    //! \brief Dilates the set bits by one element into \p output.
+    //!
+    //! An output bit is set if the input bit or any of its six face neighbors
+    //! is set. The output is resized to the size of this array.
+    //!
+    void dilate(BitArray3* output) const;
+
+    //! Sets the bits that are set in \p other. The sizes should match.
+    BitArray3& operator|=(const BitArray3& other);
+
+    //! Clears the bits that are not set in \p other. The sizes should match.
+    BitArray3& operator&=(const BitArray3& other);
+
+    //! Clears the bits that are set in \p other. The sizes should match.
+    void andNot(const BitArray3& other);
+
+    //! Swaps the content with \p other.
+    void swap(BitArray3& other);
+
+    //!
+    //! \brief Sets each bit to the return value of the callback in parallel.
+    //!
+    //! The callback takes (i, j, k) and returns the bit. The words are built
+    //! in registers and written once, and each row is built by one thread.
+    //!
+    template <typename Callback>
+    void parallelSet(const Callback& func);
+
+    //! Iterates the indices of the set bits, i first, j and k next.
+    template <typename Callback>
+    void forEachSetIndex(const Callback& func) const;
+
+    //!
+    //! \brief Iterates the indices of the set bits in parallel.
+    //!
+    //! The rows are distributed over the threads, and the words that are zero
+    //! are skipped without visiting their elements.
+    //!
+    template <typename Callback>
+    void parallelForEachSetIndex(const Callback& func) const;
+
+ private:
+    Size3 _size;
+    size_t _wordsPerRow = 0;
+    Word _lastWordMask = 0;
+    std::vector<Word> _data;
+
+    template <typename Callback>
+    void forEachSetIndexInRow(size_t j, size_t k, const Callback& func) const;
+};
+
+}  // namespace jet
+
+#include "detail/bit_array3-inl.h"
+
+#endif  // INCLUDE_JET_BIT_ARRAY3_H_
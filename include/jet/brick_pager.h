@@ -0,0 +1,136 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_BRICK_PAGER_H_
+#define INCLUDE_JET_BRICK_PAGER_H_
+
+#include <jet/macros.h>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Pages fixed-size bricks between the memory and a scratch file.
+//!
+//! This class keeps up to maxNumberOfResidentBricks() bricks in the memory
+//! and stores the others in an anonymous scratch file, which is created on
+//! the first write-back and removed when the pager is destroyed. A brick is
+//! pinned in the memory from acquire() to release(). When a brick that is not
+//! resident is acquired and the cache is full, the least recently used brick
+//! that is not pinned is evicted, and it is written to the file only if it
+//! was acquired for writing since it was loaded. A brick that has never been
+//! written to the file is loaded as a copy of the initial brick, so a new
+//! pager does no I/O until the cache overflows. If all the resident bricks
+//! are pinned, the cache grows past the max until some are released.
+//!
+//! The bricks are stored in the file in the order of their indices, so a
+//! sweep in that order reads the file sequentially. acquire() can also hint
+//! the operating system to read the bricks that follow the loaded one ahead
+//! of time.
+//!
+//! The functions are thread-safe, and the file I/O is done while holding the
+//! lock, so the threads that sweep a paged array in parallel overlap their
+//! computation but not their I/O. Throws std::runtime_error if the scratch
+//! file cannot be created, read, or written.
+//!
+class BrickPager final {
+ public:
+    JET_NON_COPYABLE(BrickPager)
+
+    //!
+    //! \brief Constructs a pager of \p numberOfBricks bricks.
+    //!
+    //! The size of the bricks is the size of \p initialBrick, which is the
+    //! initial content of all the bricks.
+    //!
+    BrickPager(
+        size_t numberOfBricks,
+        const std::vector<char>& initialBrick,
+        size_t maxNumberOfResidentBricks);
+
+    //! Releases the memory and removes the scratch file.
+    ~BrickPager();
+
+    //!
+    //! \brief Pins the brick in the memory and returns its data.
+    //!
+    //! The data stays valid until the matching release(). Pass true to
+    //! \p isWriting if the data will be modified, so that the brick is written
+    //! back when it is evicted. If the brick is loaded from the file, the
+    //! read-ahead of the \p prefetchDistance bricks that follow it is hinted,
+    //! which is supported on Linux only.
+    //!
+    char* acquire(size_t brick, bool isWriting, size_t prefetchDistance = 0);
+
+    //! Unpins the brick acquired by acquire().
+    void release(size_t brick);
+
+    //! Returns the number of the bricks.
+    size_t numberOfBricks() const;
+
+    //! Returns the size of a brick in bytes.
+    size_t bytesPerBrick() const;
+
+    //! Returns the max number of the bricks kept in the memory.
+    size_t maxNumberOfResidentBricks() const;
+
+    //!
+    //! \brief Sets the max number of the bricks kept in the memory.
+    //!
+    //! The least recently used bricks that are not pinned are evicted until
+    //! the number of the resident bricks is within the new max. The max is at
+    //! least one.
+    //!
+    void setMaxNumberOfResidentBricks(size_t numberOfBricks);
+
+    //! Returns the number of the bricks in the memory.
+    size_t numberOfResidentBricks() const;
+
+    //! Returns the number of the bricks read from the scratch file so far.
+    size_t numberOfBrickReads() const;
+
+    //! Returns the number of the bricks written to the scratch file so far.
+    size_t numberOfBrickWrites() const;
+
+ private:
+    struct Slot {
+        size_t brick;
+        size_t numberOfPins;
+        uint64_t lastUse;
+        bool isDirty;
+        std::vector<char> data;
+    };
+
+    size_t _numberOfBricks;
+    std::vector<char> _initialBrick;
+    size_t _maxNumberOfResidentBricks;
+
+    std::vector<Slot> _slots;
+    std::vector<size_t> _brickToSlot;
+    std::vector<char> _isStored;
+    uint64_t _clock = 0;
+    size_t _numberOfBrickReads = 0;
+    size_t _numberOfBrickWrites = 0;
+    std::FILE* _file = nullptr;
+    mutable std::mutex _mutex;
+
+    size_t leastRecentlyUsedSlot() const;
+
+    void evict(size_t slot);
+
+    void removeSlot(size_t slot);
+
+    void readBrick(size_t brick, char* data);
+
+    void writeBrick(size_t brick, const char* data);
+
+    void seek(size_t brick);
+
+    void prefetch(size_t firstBrick, size_t numberOfBricks);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_BRICK_PAGER_H_
@@ -0,0 +1,144 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_BRICKED_ARRAY3_H_
+#define INCLUDE_JET_BRICKED_ARRAY3_H_
+
+#include <jet/array3.h>
+#include <jet/point3.h>
+#include <jet/size3.h>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D array class with bricked memory layout.
+//!
+//! Unlike Array3, which stores the (i, j, k) element at
+//! (i + width * (j + height * k)), this class divides the array into bricks
+//! of BrickSize x BrickSize x BrickSize elements and stores each brick
+//! contiguously. The neighbors of an element in all three directions are then
+//! mostly within the same brick, so stencil operations at large resolutions
+//! touch a few pages instead of jumping by whole planes in k. The iterators
+//! visit the elements brick by brick in the same spirit.
+//!
+//! Since the storage is not linear, this class does not provide the
+//! ArrayAccessor3 views of Array3. Use set() and copyTo() to convert from and
+//! to Array3.
+//!
+//! \tparam T - Type to store in the array.
+//! \tparam BrickSize - Number of elements of a brick along each axis, which
+//!                     must be a power of two such as 4 or 8.
+//!
+template <typename T, size_t BrickSize = 8>
+class BrickedArray3 final {
+ public:
+    static_assert(
+        BrickSize > 0 && (BrickSize & (BrickSize - 1)) == 0,
+        "BrickSize should be a power of two.");
+
+    //! Constructs zero-sized 3-D array.
+    BrickedArray3();
+
+    //! Constructs 3-D array with given \p size and fill it with \p initVal.
+    explicit BrickedArray3(const Size3& size, const T& initVal = T());
+
+    //! Constructs 3-D array with size \p width x \p height x \p depth and fill
+    //! it with \p initVal.
+    BrickedArray3(
+        size_t width, size_t height, size_t depth, const T& initVal = T());
+
+    //! Constructs 3-D array with the size and elements of \p dense.
+    explicit BrickedArray3(const ConstArrayAccessor3<T>& dense);
+
+    //! Sets entire array with given \p value.
+    void set(const T& value);
+
+    //! Resizes the array to the size of \p dense and copies its elements.
+    void set(const ConstArrayAccessor3<T>& dense);
+
+    //! Copies the elements to \p dense, which is resized to this array.
+    void copyTo(Array3<T>* dense) const;
+
+    //! Clears the array and resizes to zero.
+    void clear();
+
+    //! Resizes the array with \p size and fill the new element with
+    //! \p initVal. The elements within the new size are preserved.
+    void resize(const Size3& size, const T& initVal = T());
+
+    //! Resizes the array with size \p width x \p height x \p depth and fill
+    //! the new element with \p initVal.
+    void resize(
+        size_t width, size_t height, size_t depth, const T& initVal = T());
+
+    //! Returns the size of the array.
+    Size3 size() const;
+
+    //! Returns the width of the array.
+    size_t width() const;
+
+    //! Returns the height of the array.
+    size_t height() const;
+
+    //! Returns the depth of the array.
+    size_t depth() const;
+
+    //! Returns the reference to the element at (pt.x, pt.y, pt.z).
+    T& operator()(const Point3UI& pt);
+
+    //! Returns the const reference to the element at (pt.x, pt.y, pt.z).
+    const T& operator()(const Point3UI& pt) const;
+
+    //! Returns the reference to the element at (i, j, k).
+    T& operator()(size_t i, size_t j, size_t k);
+
+    //! Returns the const reference to the element at (i, j, k).
+    const T& operator()(size_t i, size_t j, size_t k) const;
+
+    //! Swaps the content of the array with \p other array.
+    void swap(BrickedArray3& other);
+
+    //!
+    //! \brief Iterates the array brick by brick.
+    //!
+    //! The callback takes (i, j, k) of every element. The bricks are visited
+    //! in the order of (i, j, k) of the bricks, and the elements within a
+    //! brick in the order of (i, j, k) as well.
+    //!
+    template <typename Callback>
+    void forEachIndex(Callback func) const;
+
+    //!
+    //! \brief Iterates the array brick by brick in parallel.
+    //!
+    //! Same as forEachIndex, but the bricks are distributed over the threads,
+    //! so the execution order is not guaranteed.
+    //!
+    template <typename Callback>
+    void parallelForEachIndex(Callback func) const;
+
+ private:
+    static const size_t kBrickVolume = BrickSize * BrickSize * BrickSize;
+
+    Size3 _size;
+    Size3 _numberOfBricks;
+    std::vector<T> _data;
+
+    template <typename Callback>
+    void forEachIndexInBrick(size_t bi, size_t bj, size_t bk, Callback func)
+        const;
+
+    size_t index(size_t i, size_t j, size_t k) const;
+};
+
+//! 3-D array with 4 x 4 x 4 bricks.
+template <typename T> using BrickedArray3x4 = BrickedArray3<T, 4>;
+
+//! 3-D array with 8 x 8 x 8 bricks.
+template <typename T> using BrickedArray3x8 = BrickedArray3<T, 8>;
+
+}  // namespace jet
+
+#include "detail/bricked_array3-inl.h"
+
+#endif  // INCLUDE_JET_BRICKED_ARRAY3_H_
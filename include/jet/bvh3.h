@@ -0,0 +1,193 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_BVH3_H_
+#define INCLUDE_JET_BVH3_H_
+
+#include <jet/bounding_box3.h>
+#include <jet/ray3.h>
+#include <cstdint>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D bounding volume hierarchy over a list of bounding boxes.
+//!
+//! This class builds a bounding volume hierarchy (BVH) over the bounding boxes
+//! of items, such as triangles or child surfaces, using the binned surface
+//! area heuristic. The queries take callbacks that evaluate a single item by
+//! its index, and only the items whose boxes can affect the result are
+//! evaluated. Items with unbounded boxes, such as planes, are kept out of the
+//! tree and evaluated by every query.
+//!
+class Bvh3 {
+ public:
+    //! Max number of the queries in a packet.
+    static const size_t kPacketSize = 64;
+
+    //! Max number of the items that a leaf callback evaluates at once.
+    static const size_t kLeafChunkSize = 4;
+
+    //! Default constructor.
+    Bvh3();
+
+    //! Builds the hierarchy from the bounding boxes of the items.
+    void build(const std::vector<BoundingBox3D>& itemBounds);
+
+    //!
+    //! \brief Updates the node bounds while keeping the tree structure.
+    //!
+    //! \p itemBounds should have the same items as the ones used to build the
+    //! hierarchy, and the unbounded items should stay unbounded.
+    //!
+    void refit(const std::vector<BoundingBox3D>& itemBounds);
+
+    //! Removes all the items.
+    void clear();
+
+    //! Returns true if there is no item.
+    bool empty() const;
+
+    //!
+    //! \brief Returns the items in the order of the leaves.
+    //!
+    //! The items of each leaf are contiguous, and the unbounded items come
+    //! last. The leaf callbacks take positions in this list, so the callers
+    //! can keep the data of the items in the same order.
+    //!
+    const std::vector<size_t>& orderedItems() const;
+
+    //!
+    //! \brief Returns the item closest to the given point \p pt.
+    //!
+    //! \p distanceSquaredFunc(i) returns the squared distance from \p pt to
+    //! the i-th item, which must not be less than the squared distance to the
+    //! bounding box of the item. Ties go to the lower index, and kMaxSize is
+    //! returned if there is no item.
+    //!
+    template <typename DistanceSquaredFunc>
+    size_t nearest(
+        const Vector3D& pt,
+        const DistanceSquaredFunc& distanceSquaredFunc) const;
+
+    //!
+    //! \brief Returns the item closest to the given point \p pt, evaluating
+    //!        the items a chunk at a time.
+    //!
+    //! This function gives the same result as nearest(), but
+    //! \p leafDistanceSquaredFunc(position, count, distancesSquared) writes
+    //! the squared distances to the \p count items from \p position of
+    //! orderedItems() at once, so the items of a leaf can be evaluated by
+    //! vectorized kernels. \p count is at most kLeafChunkSize.
+    //!
+    template <typename LeafDistanceSquaredFunc>
+    size_t nearestInLeaves(
+        const Vector3D& pt,
+        const LeafDistanceSquaredFunc& leafDistanceSquaredFunc) const;
+
+    //!
+    //! \brief Returns the smallest signed distance from \p pt over the items.
+    //!
+    //! \p signedDistanceFunc(i) returns the signed distance to the i-th item.
+    //! Outside of its bounding box, an item must report a signed distance
+    //! that is not less than the distance to the box, meaning that the inside
+    //! of the item is bounded by the box. kMaxD is returned if there is no
+    //! item.
+    //!
+    template <typename SignedDistanceFunc>
+    double minimumSignedDistance(
+        const Vector3D& pt,
+        const SignedDistanceFunc& signedDistanceFunc) const;
+
+    //!
+    //! \brief Visits the items that can be the closest hit of the \p ray.
+    //!
+    //! \p intersectFunc(i) returns the hit distance of the i-th item, or the
+    //! max double value if the ray misses it. Items whose boxes are entered
+    //! after the closest hit found so far are skipped.
+    //!
+    template <typename IntersectFunc>
+    void forEachRayCandidate(
+        const Ray3D& ray,
+        const IntersectFunc& intersectFunc) const;
+
+    //! Returns true if \p hitFunc(i) is true for any item whose bounding box
+    //! intersects with the \p ray.
+    template <typename HitFunc>
+    bool anyRayHit(const Ray3D& ray, const HitFunc& hitFunc) const;
+
+    //!
+    //! \brief Finds the item closest to each point of a packet.
+    //!
+    //! This function gives the same results as nearest() for each of the
+    //! \p count points at \p pts, which are stored in \p results, but the
+    //! hierarchy is traversed once for the packet. A node is visited if any
+    //! point of the packet can have its closest item in the node, and the
+    //! items of a leaf are only evaluated for those points, so the nearby
+    //! points share the loads of the nodes. \p distanceSquaredFunc(i, k)
+    //! returns the squared distance from the k-th point to the i-th item.
+    //! \p count should not be greater than kPacketSize.
+    //!
+    template <typename DistanceSquaredFunc>
+    void nearestPacket(
+        const Vector3D* pts,
+        size_t count,
+        const DistanceSquaredFunc& distanceSquaredFunc,
+        size_t* results) const;
+
+    //!
+    //! \brief Finds the item closest to each point of a packet, evaluating
+    //!        the items a chunk at a time.
+    //!
+    //! This function gives the same results as nearestPacket(), but
+    //! \p leafDistanceSquaredFunc(position, count, k, distancesSquared)
+    //! writes the squared distances from the k-th point to the \p count
+    //! items from \p position of orderedItems() at once. \p count is at most
+    //! kLeafChunkSize.
+    //!
+    template <typename LeafDistanceSquaredFunc>
+    void nearestPacketInLeaves(
+        const Vector3D* pts,
+        size_t count,
+        const LeafDistanceSquaredFunc& leafDistanceSquaredFunc,
+        size_t* results) const;
+
+    //!
+    //! \brief Visits the items that can be the closest hit of each ray of a
+    //!        packet.
+    //!
+    //! This function visits the items of forEachRayCandidate() for each of
+    //! the \p count rays at \p rays in the same order, but the hierarchy is
+    //! traversed once for the packet. \p intersectFunc(i, k) returns the hit
+    //! distance of the k-th ray to the i-th item, or the max double value if
+    //! the ray misses it. \p count should not be greater than kPacketSize.
+    //!
+    template <typename IntersectFunc>
+    void forEachRayCandidatePacket(
+        const Ray3D* rays,
+        size_t count,
+        const IntersectFunc& intersectFunc) const;
+
+ private:
+    // Flattened in depth-first order, so the first child of an internal node
+    // is the next node
+    struct Node {
+        BoundingBox3D bound;
+        size_t start = 0;
+        size_t count = 0;
+        size_t secondChild = 0;
+    };
+
+    std::vector<Node> _nodes;
+
+    // Bounded items in the order of the leaves, followed by the unbounded
+    // items
+    std::vector<size_t> _items;
+    std::vector<size_t> _unboundedItems;
+};
+
+}  // namespace jet
+
+#include "detail/bvh3-inl.h"
+
+#endif  // INCLUDE_JET_BVH3_H_
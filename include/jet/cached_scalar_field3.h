@@ -0,0 +1,184 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_CACHED_SCALAR_FIELD3_H_
+#define INCLUDE_JET_CACHED_SCALAR_FIELD3_H_
+
+#include <jet/bounding_box3.h>
+#include <jet/implicit_surface3.h>
+#include <jet/scalar_field3.h>
+#include <jet/size3.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D scalar field that caches the samples of an expensive field.
+//!
+//! The fields such as CustomScalarField3 with a costly function, or the
+//! signed distance of an ImplicitSurfaceSet3 or a SurfaceToImplicit3 of a
+//! triangle mesh, are evaluated again at every step by the emitters and the
+//! colliders, even when the geometry does not move. This class samples the
+//! field on the nodes of a regular lattice over the domain and interpolates
+//! them trilinearly. The lattice is divided into tiles of 8^3 cells, and a
+//! tile is sampled at once with batchSample() the first time a point inside
+//! it is queried, so only the tiles near the queries are ever computed. The
+//! least recently used tiles are dropped when the number of the tiles
+//! exceeds maxNumberOfTiles(), which bounds the memory. The points outside
+//! the domain are sampled from the field directly.
+//!
+//! The cache has to be invalidated when the field changes, with invalidate()
+//! or with a version stamp of the source passed to setSourceVersion(), such
+//! as Collider3::version().
+//!
+//! The functions are thread-safe. The tiles are computed without holding the
+//! lock, but every query of sample() takes the lock to find its tile, so
+//! batchSample(), which finds the tile once for the consecutive points in the
+//! same tile, is cheaper for many points.
+//!
+class CachedScalarField3 final : public ScalarField3 {
+ public:
+    //!
+    //! \brief Constructs a cache of \p field on the lattice of \p spacing
+    //! over \p domain.
+    //!
+    //! The spacing should be positive.
+    //!
+    CachedScalarField3(
+        const ScalarField3Ptr& field,
+        const BoundingBox3D& domain,
+        double spacing,
+        size_t maxNumberOfTiles = 4096);
+
+    //!
+    //! \brief Constructs a cache of the signed distance of \p surface on the
+    //! lattice of \p spacing over \p domain.
+    //!
+    //! The tiles are sampled with ImplicitSurface3::batchSignedDistance. The
+    //! spacing should be positive.
+    //!
+    CachedScalarField3(
+        const ImplicitSurface3Ptr& surface,
+        const BoundingBox3D& domain,
+        double spacing,
+        size_t maxNumberOfTiles = 4096);
+
+    //! Returns the interpolated value at given position \p x.
+    double sample(const Vector3D& x) const override;
+
+    //! Samples the field at the positions \p x into \p result.
+    void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<double> result) const override;
+
+    //!
+    //! \brief Returns the gradient at given position \p x.
+    //!
+    //! Inside the domain, this is the gradient of the trilinear interpolant.
+    //!
+    Vector3D gradient(const Vector3D& x) const override;
+
+    //!
+    //! \brief Returns the Laplacian at given position \p x.
+    //!
+    //! Inside the domain, the Laplacian is the central difference of the
+    //! interpolated values with the lattice spacing.
+    //!
+    double laplacian(const Vector3D& x) const override;
+
+    //! Returns the cached field.
+    const ScalarField3Ptr& field() const;
+
+    //! Returns the domain of the lattice.
+    const BoundingBox3D& domain() const;
+
+    //! Returns the spacing of the lattice.
+    double spacing() const;
+
+    //! Returns the max number of the tiles kept in the cache.
+    size_t maxNumberOfTiles() const;
+
+    //!
+    //! \brief Sets the max number of the tiles kept in the cache.
+    //!
+    //! The least recently used tiles are dropped until the number of the
+    //! tiles is within the new max. The max is at least one. A tile takes
+    //! 9^3 doubles.
+    //!
+    void setMaxNumberOfTiles(size_t numberOfTiles);
+
+    //! Returns the number of the tiles in the cache.
+    size_t numberOfTiles() const;
+
+    //! Returns the number of the tiles sampled from the field so far.
+    size_t numberOfTileFills() const;
+
+    //! Returns the version of the cache, which invalidate() increments.
+    uint64_t version() const;
+
+    //! Drops all the tiles, so that they are sampled again from the field.
+    void invalidate();
+
+    //!
+    //! \brief Invalidates the cache if \p sourceVersion differs from the one
+    //! of the last call.
+    //!
+    //! A caller can pass the version stamp of the geometry of the field at
+    //! each step, so the cache is only dropped when the geometry changes.
+    //!
+    void setSourceVersion(uint64_t sourceVersion);
+
+ private:
+    typedef std::shared_ptr<const std::vector<double>> TileData;
+
+    struct TileEntry {
+        TileData data;
+        std::list<size_t>::iterator use;
+    };
+
+    ScalarField3Ptr _field;
+    BoundingBox3D _domain;
+    double _spacing;
+    double _invSpacing;
+    Size3 _resolution;
+    Size3 _numberOfTiles;
+    size_t _maxNumberOfTiles;
+
+    mutable std::mutex _mutex;
+    mutable std::unordered_map<size_t, TileEntry> _tiles;
+    mutable std::list<size_t> _leastRecentlyUsed;
+    mutable size_t _numberOfTileFills = 0;
+    uint64_t _version = 0;
+    uint64_t _sourceVersion = 0;
+    bool _hasSourceVersion = false;
+
+    void initialize(size_t maxNumberOfTiles);
+
+    // Finds the cell of x, and returns false if x is outside the domain.
+    bool findCell(
+        const Vector3D& x, Size3* cell, Vector3D* fraction) const;
+
+    size_t tileIndex(const Size3& cell) const;
+
+    TileData tile(size_t index) const;
+
+    TileData fillTile(size_t index) const;
+
+    void evict() const;
+
+    // Finds the values at the eight corners of the cell of x, x-first, and
+    // returns false if x is outside the domain.
+    bool findCorners(
+        const Vector3D& x, double* corners, Vector3D* fraction) const;
+};
+
+typedef std::shared_ptr<CachedScalarField3> CachedScalarField3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_CACHED_SCALAR_FIELD3_H_
@@ -16,14 +16,15 @@ namespace jet {
 //! center of a grid cell. Thus, the dimension of data points are equal to the
 //! dimension of the cells.
 //!
-class CellCenteredScalarGrid3 final : public ScalarGrid3 {
+template <typename T>
+class CellCenteredScalarGrid3T final : public ScalarGrid3T<T> {
  public:
     //! Constructs zero-sized grid.
-    CellCenteredScalarGrid3();
+    CellCenteredScalarGrid3T();
 
     //! Constructs a grid with given resolution, grid spacing, origin and
     //! initial value.
-    CellCenteredScalarGrid3(
+    CellCenteredScalarGrid3T(
         size_t resolutionX,
         size_t resolutionY,
         size_t resolutionZ,
@@ -33,18 +34,22 @@ class CellCenteredScalarGrid3 final : public ScalarGrid3 {
         double originX = 0.0,
         double originY = 0.0,
         double originZ = 0.0,
-        double initialValue = 0.0);
+        T initialValue = 0);
 
     //! Constructs a grid with given resolution, grid spacing, origin and
     //! initial value.
-    CellCenteredScalarGrid3(
+    CellCenteredScalarGrid3T(
         const Size3& resolution,
         const Vector3D& gridSpacing = Vector3D(1.0, 1.0, 1.0),
         const Vector3D& origin = Vector3D(),
-        double initialValue = 0.0);
+        T initialValue = 0);
 
     //! Copy constructor.
-    CellCenteredScalarGrid3(const CellCenteredScalarGrid3& other);
+    CellCenteredScalarGrid3T(const CellCenteredScalarGrid3T& other);
+
+    //! Move constructor. Takes over the data of \p other, which is left
+    //! with the contents of a default-constructed grid.
+    CellCenteredScalarGrid3T(CellCenteredScalarGrid3T&& other);
 
     //! Returns the actual data point size.
     Size3 dataSize() const override;
@@ -55,7 +60,7 @@ class CellCenteredScalarGrid3 final : public ScalarGrid3 {
     Vector3D dataOrigin() const override;
 
     //! Returns the copy of the grid instance.
-    std::shared_ptr<ScalarGrid3> clone() const override;
+    std::shared_ptr<ScalarGrid3T<T>> clone() const override;
 
     //!
     //! \brief Swaps the contents with the given \p other grid.
@@ -66,32 +71,53 @@ class CellCenteredScalarGrid3 final : public ScalarGrid3 {
     void swap(Grid3* other) override;
 
     //! Sets the contents with the given \p other grid.
-    void set(const CellCenteredScalarGrid3& other);
+    void set(const CellCenteredScalarGrid3T& other);
 
     //! Sets the contents with the given \p other grid.
-    CellCenteredScalarGrid3& operator=(const CellCenteredScalarGrid3& other);
+    CellCenteredScalarGrid3T& operator=(const CellCenteredScalarGrid3T& other);
+
+    //! Moves the contents of the given \p other grid by swapping them.
+    CellCenteredScalarGrid3T& operator=(CellCenteredScalarGrid3T&& other);
 
     //! Returns the grid builder instance.
-    static ScalarGridBuilder3Ptr builder();
+    static std::shared_ptr<ScalarGridBuilder3T<T>> builder();
 };
 
 //! A grid builder class that returns 3-D cell-centered scalar grid.
-class CellCenteredScalarGridBuilder3 final : public ScalarGridBuilder3 {
+template <typename T>
+class CellCenteredScalarGridBuilder3T final
+    : public ScalarGridBuilder3T<T> {
  public:
     //! Returns a cell-centered grid for given parameters.
-    ScalarGrid3Ptr build(
+    std::shared_ptr<ScalarGrid3T<T>> build(
         const Size3& resolution,
         const Vector3D& gridSpacing,
         const Vector3D& gridOrigin,
         double initialVal) const override {
-        return std::make_shared<CellCenteredScalarGrid3>(
+        return std::make_shared<CellCenteredScalarGrid3T<T>>(
             resolution,
             gridSpacing,
             gridOrigin,
-            initialVal);
+            static_cast<T>(initialVal));
     }
 };
 
+//! Double-precision 3-D cell-centered scalar grid.
+typedef CellCenteredScalarGrid3T<double> CellCenteredScalarGrid3;
+
+//! Single-precision 3-D cell-centered scalar grid.
+typedef CellCenteredScalarGrid3T<float> CellCenteredScalarGrid3F;
+
+//! Builder type of the CellCenteredScalarGrid3.
+typedef CellCenteredScalarGridBuilder3T<double>
+    CellCenteredScalarGridBuilder3;
+
+//! Builder type of the CellCenteredScalarGrid3F.
+typedef CellCenteredScalarGridBuilder3T<float>
+    CellCenteredScalarGridBuilder3F;
+
 }  // namespace jet
 
+#include "detail/cell_centered_scalar_grid3-inl.h"
+
 #endif  // INCLUDE_JET_CELL_CENTERED_SCALAR_GRID3_H_
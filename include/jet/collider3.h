@@ -4,6 +4,7 @@
 #define INCLUDE_JET_COLLIDER3_H_
 
 #include <jet/surface3.h>
+#include <cstdint>
 
 namespace jet {
 
@@ -55,6 +56,24 @@ class Collider3 {
     //! Returns the surface instance.
     const Surface3Ptr& surface() const;
 
+    //!
+    //! \brief Returns the version stamp of the collider surface.
+    //!
+    //! The stamp changes whenever the surface is replaced or markDirty() is
+    //! called, and no two colliders share a stamp. Grid-based solvers compare
+    //! the stamp with the one they rasterized last, so a static collider is
+    //! only rasterized once.
+    //!
+    uint64_t version() const;
+
+    //!
+    //! \brief Notifies that the surface has changed.
+    //!
+    //! Call this function after modifying the surface instance in place, such
+    //! as moving it, so that the cached signed-distance fields get rebuilt.
+    //!
+    virtual void markDirty();
+
  protected:
     //! Internal query result structure.
     struct ColliderQueryResult final {
@@ -82,6 +101,7 @@ class Collider3 {
  private:
     Surface3Ptr _surface;
     double _frictionCoeffient = 0.0;
+    uint64_t _version;
 };
 
 typedef std::shared_ptr<Collider3> Collider3Ptr;
@@ -9,7 +9,14 @@
 
 namespace jet {
 
-//! Collection of 3-D colliders
+//!
+//! \brief Collection of 3-D colliders
+//!
+//! The velocity is taken from the collider closest to the query point, which
+//! is found with the BVH of the surface set over the bounds of the colliders,
+//! so a query only evaluates the colliders near the point. If a collider is
+//! moved after being added, call markDirty() on the set.
+//!
 class ColliderSet3 final : public Collider3 {
  public:
     //! Default constructor.
@@ -21,6 +28,9 @@ class ColliderSet3 final : public Collider3 {
     //! Adds a collider to the set.
     void addCollider(const Collider3Ptr& collider);
 
+    //! Notifies that the colliders have changed, which also rebuilds the BVH.
+    void markDirty() override;
+
  private:
     std::vector<Collider3Ptr> _colliders;
 };
@@ -72,6 +72,27 @@ class CollocatedVectorGrid3 : public VectorGrid3 {
     void parallelForEachDataPointIndex(
         const std::function<void(size_t, size_t, size_t)>& func) const;
 
+    //!
+    //! \brief Invokes the given function \p func for each x-row of the data
+    //! points.
+    //!
+    //! The input parameters are the j and k indices of a row, whose data
+    //! points are contiguous in the data accessor. The order of execution is
+    //! j-first, k-last.
+    //!
+    void forEachDataPointRow(
+        const std::function<void(size_t, size_t)>& func) const;
+
+    //!
+    //! \brief Invokes the given function \p func for each x-row of the data
+    //! points parallelly.
+    //!
+    //! The input parameters are the j and k indices of a row. The order of
+    //! execution can be arbitrary since it's multi-threaded.
+    //!
+    void parallelForEachDataPointRow(
+        const std::function<void(size_t, size_t)>& func) const;
+
     //! Serializes the grid instance to the output stream \p strm.
     void serialize(std::ostream* strm) const override;
 
@@ -83,6 +104,11 @@ class CollocatedVectorGrid3 : public VectorGrid3 {
     //! Returns sampled value at given position \p x.
     Vector3D sample(const Vector3D& x) const override;
 
+    //! Samples the positions \p x with the inlined linear sampler.
+    void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<Vector3D> result) const override;
+
     //! Returns divergence at given position \p x.
     double divergence(const Vector3D& x) const override;
 
@@ -97,6 +123,15 @@ class CollocatedVectorGrid3 : public VectorGrid3 {
     //!
     std::function<Vector3D(const Vector3D&)> sampler() const override;
 
+    //!
+    //! \brief Returns the linear sampler of the data.
+    //!
+    //! Unlike sampler(), the returned object can be inlined into the caller's
+    //! loop. It refers to the data of this grid, so it is invalidated when the
+    //! grid is resized.
+    //!
+    const LinearArraySampler3<Vector3D, double>& linearSampler() const;
+
  protected:
     //! Swaps the data storage and predefined samplers with given grid.
     void swapCollocatedVectorGrid(CollocatedVectorGrid3* other);
@@ -107,7 +142,6 @@ class CollocatedVectorGrid3 : public VectorGrid3 {
  private:
     Array3<Vector3D> _data;
     LinearArraySampler3<Vector3D, double> _linearSampler;
-    std::function<Vector3D(const Vector3D&)> _sampler;
 
     void onResize(
         const Size3& resolution,
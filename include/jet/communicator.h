@@ -0,0 +1,163 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_COMMUNICATOR_H_
+#define INCLUDE_JET_COMMUNICATOR_H_
+
+#include <jet/array_accessor1.h>
+#include <cstddef>
+#include <memory>
+
+namespace jet {
+
+//! Rank number which means no rank, such as the neighbor of the last rank.
+const int kNoRank = -1;
+
+//!
+//! \brief Abstract base class for the communication between the processes
+//!        (ranks) which share a distributed simulation.
+//!
+//! The collective operations, sum and max, must be called by all the ranks in
+//! the same order. Every rank gets the same result.
+//!
+class Communicator {
+ public:
+    //! Default constructor.
+    Communicator();
+
+    //! Destructor.
+    virtual ~Communicator();
+
+    //! Returns the rank of this process, from 0 to size() - 1.
+    virtual int rank() const = 0;
+
+    //! Returns the number of ranks.
+    virtual int size() const = 0;
+
+    //! Returns the sum of \p value over all the ranks.
+    virtual double sum(double value) = 0;
+
+    //! Returns the max of \p value over all the ranks.
+    virtual double max(double value) = 0;
+
+    //!
+    //! \brief Replaces each element with its sum over all the ranks.
+    //!
+    //! The default implementation calls sum(double) for each element. The
+    //! arrays must have the same size on all the ranks.
+    //!
+    virtual void sum(ArrayAccessor1<double> values);
+
+    //!
+    //! \brief      Sends a buffer to one rank while receiving one from another.
+    //!
+    //! \param[in]  sendData     The data to send.
+    //! \param[in]  sendBytes    The number of bytes to send.
+    //! \param[in]  destination  The rank to send to, or kNoRank to skip.
+    //! \param[out] receiveData  The buffer to receive into.
+    //! \param[in]  receiveBytes The number of bytes to receive.
+    //! \param[in]  source       The rank to receive from, or kNoRank to skip.
+    //!
+    virtual void sendReceive(
+        const void* sendData,
+        size_t sendBytes,
+        int destination,
+        void* receiveData,
+        size_t receiveBytes,
+        int source) = 0;
+};
+
+//! Shared pointer for the Communicator type.
+typedef std::shared_ptr<Communicator> CommunicatorPtr;
+
+//!
+//! \brief Communicator of a single process.
+//!
+//! The reductions return the input, and the only peer of sendReceive is the
+//! rank itself.
+//!
+class SerialCommunicator final : public Communicator {
+ public:
+    //! Default constructor.
+    SerialCommunicator();
+
+    //! Returns 0.
+    int rank() const override;
+
+    //! Returns 1.
+    int size() const override;
+
+    //! Returns \p value.
+    double sum(double value) override;
+
+    using Communicator::sum;
+
+    //! Returns \p value.
+    double max(double value) override;
+
+    //! Copies the data if both \p destination and \p source are 0.
+    void sendReceive(
+        const void* sendData,
+        size_t sendBytes,
+        int destination,
+        void* receiveData,
+        size_t receiveBytes,
+        int source) override;
+};
+
+//! Shared pointer for the SerialCommunicator type.
+typedef std::shared_ptr<SerialCommunicator> SerialCommunicatorPtr;
+
+//!
+//! \brief Communicator over MPI_COMM_WORLD.
+//!
+//! Requires the library built with JET_USE_MPI. The application initializes
+//! and finalizes MPI.
+//!
+class MpiCommunicator final : public Communicator {
+ public:
+    //!
+    //! \brief Constructs the communicator of MPI_COMM_WORLD.
+    //!
+    //! Throws std::runtime_error if the library is built without MPI or MPI
+    //! is not initialized.
+    //!
+    MpiCommunicator();
+
+    //! Returns the rank in MPI_COMM_WORLD.
+    int rank() const override;
+
+    //! Returns the size of MPI_COMM_WORLD.
+    int size() const override;
+
+    //! Returns the sum of \p value over all the ranks with MPI_Allreduce.
+    double sum(double value) override;
+
+    //! Returns the max of \p value over all the ranks with MPI_Allreduce.
+    double max(double value) override;
+
+    //! Sums the elements over all the ranks with one MPI_Allreduce.
+    void sum(ArrayAccessor1<double> values) override;
+
+    //! Exchanges the buffers with MPI_Sendrecv.
+    void sendReceive(
+        const void* sendData,
+        size_t sendBytes,
+        int destination,
+        void* receiveData,
+        size_t receiveBytes,
+        int source) override;
+
+    //! Returns true if the library is built with MPI and MPI is initialized.
+    static bool isAvailable();
+
+ private:
+    int _rank = 0;
+    int _size = 1;
+};
+
+//! Shared pointer for the MpiCommunicator type.
+typedef std::shared_ptr<MpiCommunicator> MpiCommunicatorPtr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_COMMUNICATOR_H_
@@ -0,0 +1,91 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_COMPOSITE_PHYSICS_ANIMATION_H_
+#define INCLUDE_JET_COMPOSITE_PHYSICS_ANIMATION_H_
+
+#include <jet/physics_animation.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Animation that advances several physics animations together.
+//!
+//! The animations, such as a smoke solver and a particle solver, are grouped
+//! in stages. For each frame, the stages run in the increasing order, and the
+//! animations of a stage are advanced concurrently on the shared thread pool.
+//! Each animation keeps its own sub-time-step scheduling, so a stiff solver
+//! can take many small steps while the others take a few large ones.
+//!
+//! The animations of a stage must not touch each other's data. A one-way
+//! coupling, such as a particle solver blown by the velocity of a smoke
+//! solver, is made by putting the consumer in a later stage than the
+//! producer, and by adding a coupling callback to the consumer's stage. The
+//! couplings of a stage run in order on the calling thread before the
+//! animations of that stage, when the earlier stages have finished the
+//! frame, so they can copy the fields of the producers into the inputs of the
+//! consumers without racing with either of them.
+//!
+//! The statistics of the memory tracker and the profiler are process-wide,
+//! so those of the animations that run together are mixed.
+//!
+class CompositePhysicsAnimation final : public Animation {
+ public:
+    //! Function that transfers the fields between the animations of a frame.
+    typedef std::function<void(const Frame&)> CouplingCallback;
+
+    CompositePhysicsAnimation();
+
+    virtual ~CompositePhysicsAnimation();
+
+    //!
+    //! \brief Adds an animation to given stage.
+    //!
+    //! The stages in between are created as empty ones when \p stage is past
+    //! the last stage.
+    //!
+    void addAnimation(const PhysicsAnimationPtr& animation, size_t stage = 0);
+
+    //! Adds a coupling callback that runs before the animations of \p stage.
+    void addCoupling(const CouplingCallback& callback, size_t stage);
+
+    //! Returns the number of stages.
+    size_t numberOfStages() const;
+
+    //! Returns the animations of given stage.
+    const std::vector<PhysicsAnimationPtr>& animations(size_t stage) const;
+
+    //! Returns the last advanced frame.
+    const Frame& currentFrame() const;
+
+ protected:
+    //!
+    //! \brief Advances the animations up to given frame.
+    //!
+    //! Like PhysicsAnimation, the frames after the current one are advanced
+    //! one by one, and the couplings run for each of them.
+    //!
+    void onUpdate(const Frame& frame) override;
+
+ private:
+    struct Stage {
+        std::vector<CouplingCallback> couplings;
+        std::vector<PhysicsAnimationPtr> animations;
+    };
+
+    std::vector<Stage> _stages;
+    Frame _currentFrame;
+
+    Stage& stage(size_t index);
+
+    void advanceFrame(const Frame& frame);
+};
+
+typedef std::shared_ptr<CompositePhysicsAnimation>
+    CompositePhysicsAnimationPtr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_COMPOSITE_PHYSICS_ANIMATION_H_
@@ -14,9 +14,17 @@ class ConstantVectorField3 final : public VectorField3 {
     //! Constructs a constant vector field with given \p value.
     explicit ConstantVectorField3(const Vector3D& value);
 
+    //! Returns the value of the field.
+    const Vector3D& value() const;
+
     //! Returns the sampled value at given position \p x.
     Vector3D sample(const Vector3D& x) const override;
 
+    //! Fills \p result with the value.
+    void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<Vector3D> result) const override;
+
     //! Returns the sampler function.
     std::function<Vector3D(const Vector3D&)> sampler() const override;
 
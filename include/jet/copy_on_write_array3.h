@@ -0,0 +1,79 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_COPY_ON_WRITE_ARRAY3_H_
+#define INCLUDE_JET_COPY_ON_WRITE_ARRAY3_H_
+
+#include <jet/array3.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace jet {
+
+//!
+//! \brief 3-D array storage that is shared between copies until written.
+//!
+//! Copying this class shares the underlying Array3 instead of duplicating
+//! it, so the copy costs O(1). The first call to mutate() on a shared
+//! storage copies the array once, and the later calls return the private
+//! array directly. The reads go to the shared array without any check.
+//!
+//! mutate() can be called from several threads at once; the threads that
+//! find the storage shared wait for the one that copies it. The accessors
+//! obtained before a copy still refer to the shared array, so they must not
+//! be used for writing after this storage is copied.
+//!
+template <typename T>
+class CopyOnWriteArray3 final {
+ public:
+    //! Constructs an empty storage.
+    CopyOnWriteArray3();
+
+    //! Constructs a storage that shares the array of \p other.
+    CopyOnWriteArray3(const CopyOnWriteArray3& other);
+
+    //! Shares the array of \p other.
+    CopyOnWriteArray3& operator=(const CopyOnWriteArray3& other);
+
+    //! Returns the array for reading.
+    const Array3<T>& get() const;
+
+    //! Returns the (i, j, k) element for reading.
+    const T& operator()(size_t i, size_t j, size_t k) const;
+
+    //! Returns the size of the array.
+    Size3 size() const;
+
+    //! Returns the read-only accessor of the array.
+    ConstArrayAccessor3<T> constAccessor() const;
+
+    //! Returns true if the array may be shared with another storage.
+    bool isShared() const;
+
+    //!
+    //! \brief Returns the array for writing, copying it first if shared.
+    //!
+    //! \p onCopy is called right after the copy, while the other threads
+    //! are waiting, so that the objects that refer to the array such as
+    //! samplers can be pointed to the new one.
+    //!
+    template <typename Callback>
+    Array3<T>& mutate(const Callback& onCopy);
+
+    //! Returns the array for writing, copying it first if shared.
+    Array3<T>& mutate();
+
+    //! Swaps the storage with \p other.
+    void swap(CopyOnWriteArray3& other);
+
+ private:
+    std::shared_ptr<Array3<T>> _array;
+    mutable std::atomic<bool> _isShared{false};
+    std::mutex _mutex;
+};
+
+}  // namespace jet
+
+#include "detail/copy_on_write_array3-inl.h"
+
+#endif  // INCLUDE_JET_COPY_ON_WRITE_ARRAY3_H_
@@ -11,11 +11,20 @@ namespace jet {
 //! \brief Implementation of 3-D cubic semi-Lagrangian advection solver.
 //!
 //! This class implements 3rd-order cubic 3-D semi-Lagrangian advection solver.
+//! The Catmull-Rom interpolation is monotonic by default. Without the limiter,
+//! it is a separable weighted sum whose per-axis weights are computed once
+//! per traced point and shared by all channels of the batched advection.
 //!
 class CubicSemiLagrangian3 final : public SemiLagrangian3 {
  public:
     CubicSemiLagrangian3();
 
+    //! Returns true if the slopes of the interpolation are limited.
+    bool isMonotonic() const;
+
+    //! Sets true to limit the slopes of the interpolation (default).
+    void setIsMonotonic(bool isMonotonic);
+
  protected:
     //!
     //! \brief Returns spatial interpolation function object for given scalar
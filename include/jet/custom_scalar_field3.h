@@ -4,12 +4,20 @@
 #define INCLUDE_JET_CUSTOM_SCALAR_FIELD3_H_
 
 #include <jet/scalar_field3.h>
+#include <array>
+#include <functional>
 
 namespace jet {
 
 //! 3-D scalar field with custom field function.
 class CustomScalarField3 final : public ScalarField3 {
  public:
+    //! Function that samples the field at the positions of the first
+    //! accessor into the second one.
+    typedef std::function<void(
+        const ConstArrayAccessor1<Vector3D>&,
+        ArrayAccessor1<double>)> BatchFunction;
+
     //!
     //! \brief Constructs a field with given function.
     //!
@@ -41,9 +49,32 @@ class CustomScalarField3 final : public ScalarField3 {
         const std::function<Vector3D(const Vector3D&)>& customGradientFunction,
         const std::function<double(const Vector3D&)>& customLaplacianFunction);
 
+    //!
+    //! \brief Constructs a field with given batch function.
+    //!
+    //! This constructor creates a field with user-provided function object
+    //! that samples a block of positions at once, which batchSample() calls
+    //! directly. The derivatives are computed by finite differencing, and the
+    //! six neighbor samples of the stencil are taken in a single call.
+    //!
+    CustomScalarField3(
+        const BatchFunction& customBatchFunction,
+        double derivativeResolution = 1e-3);
+
+    //! Constructs a field with given batch, gradient, and Laplacian function.
+    CustomScalarField3(
+        const BatchFunction& customBatchFunction,
+        const std::function<Vector3D(const Vector3D&)>& customGradientFunction,
+        const std::function<double(const Vector3D&)>& customLaplacianFunction);
+
     //! Returns the sampled value at given position \p x.
     double sample(const Vector3D& x) const override;
 
+    //! Samples the field at the positions \p x into \p result.
+    void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<double> result) const override;
+
     //! Returns the sampler function.
     std::function<double(const Vector3D&)> sampler() const override;
 
@@ -55,9 +86,14 @@ class CustomScalarField3 final : public ScalarField3 {
 
  private:
     std::function<double(const Vector3D&)> _customFunction;
+    BatchFunction _customBatchFunction;
     std::function<Vector3D(const Vector3D&)> _customGradientFunction;
     std::function<double(const Vector3D&)> _customLaplacianFunction;
     double _resolution = 1e-3;
+
+    // Samples the left, right, bottom, top, back, and front neighbors of x
+    // that are half the resolution away
+    void sampleStencil(const Vector3D& x, std::array<double, 6>* values) const;
 };
 
 }  // namespace jet
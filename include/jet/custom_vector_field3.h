@@ -4,12 +4,20 @@
 #define INCLUDE_JET_CUSTOM_VECTOR_FIELD3_H_
 
 #include <jet/vector_field3.h>
+#include <array>
+#include <functional>
 
 namespace jet {
 
 //! 3-D vector field with custom field function.
 class CustomVectorField3 final : public VectorField3 {
  public:
+    //! Function that samples the field at the positions of the first
+    //! accessor into the second one.
+    typedef std::function<void(
+        const ConstArrayAccessor1<Vector3D>&,
+        ArrayAccessor1<Vector3D>)> BatchFunction;
+
     //!
     //! \brief Constructs a field with given function.
     //!
@@ -41,9 +49,32 @@ class CustomVectorField3 final : public VectorField3 {
         const std::function<double(const Vector3D&)>& customDivergenceFunction,
         const std::function<Vector3D(const Vector3D&)>& customCurlFunction);
 
+    //!
+    //! \brief Constructs a field with given batch function.
+    //!
+    //! This constructor creates a field with user-provided function object
+    //! that samples a block of positions at once, which batchSample() calls
+    //! directly. The derivatives are computed by finite differencing, and the
+    //! six samples of the stencil are taken in a single call.
+    //!
+    CustomVectorField3(
+        const BatchFunction& customBatchFunction,
+        double derivativeResolution = 1e-3);
+
+    //! Constructs a field with given batch, divergence, and curl function.
+    CustomVectorField3(
+        const BatchFunction& customBatchFunction,
+        const std::function<double(const Vector3D&)>& customDivergenceFunction,
+        const std::function<Vector3D(const Vector3D&)>& customCurlFunction);
+
     //! Returns the sampled value at given position \p x.
     Vector3D sample(const Vector3D& x) const override;
 
+    //! Samples the field at the positions \p x into \p result.
+    void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<Vector3D> result) const override;
+
     //! Returns the divergence at given position \p x.
     double divergence(const Vector3D& x) const override;
 
@@ -55,9 +86,15 @@ class CustomVectorField3 final : public VectorField3 {
 
  private:
     std::function<Vector3D(const Vector3D&)> _customFunction;
+    BatchFunction _customBatchFunction;
     std::function<double(const Vector3D&)> _customDivergenceFunction;
     std::function<Vector3D(const Vector3D&)> _customCurlFunction;
     double _resolution = 1e-3;
+
+    // Samples the left, right, bottom, top, back, and front neighbors of x
+    // that are half the resolution away
+    void sampleStencil(
+        const Vector3D& x, std::array<Vector3D, 6>* values) const;
 };
 
 }  // namespace jet
@@ -52,6 +52,12 @@ class Cylinder3 final : public Surface3 {
 
     SurfaceRayIntersection3 actualClosestIntersection(
         const Ray3D& ray) const override;
+
+    //! Computes the distances to the cylinder in closed form with vectorized
+    //! kernels.
+    void actualBatchClosestSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
 };
 
 typedef std::shared_ptr<Cylinder3> Cylinder3Ptr;
@@ -30,6 +30,12 @@ Array<T, 1>::Array(const Array& other) {
     set(other);
 }
 
+template <typename T>
+Array<T, 1>::Array(Array&& other) noexcept
+    : _data(std::move(other._data)) {
+    other._data.clear();
+}
+
 template <typename T>
 void Array<T, 1>::set(const T& value) {
     for (auto& v : _data) {
@@ -40,7 +46,7 @@ void Array<T, 1>::set(const T& value) {
 template <typename T>
 void Array<T, 1>::set(const Array& other) {
     _data.resize(other._data.size());
-    std::copy(other._data.begin(), other._data.end(), _data.begin());
+    initialize(0, [&](size_t i) -> const T& { return other._data[i]; });
 }
 
 template <typename T>
@@ -61,7 +67,36 @@ void Array<T, 1>::clear() {
 
 template <typename T>
 void Array<T, 1>::resize(size_t size, const T& initVal) {
-    _data.resize(size, initVal);
+    size_t oldSize = _data.size();
+    if (size <= oldSize) {
+        _data.resize(size);
+        return;
+    }
+
+    if (size <= _data.capacity()) {
+        _data.resize(size);
+        initialize(oldSize, [&](size_t) -> const T& { return initVal; });
+    } else {
+        // Grows geometrically like std::vector, and the old elements are
+        // copied in parallel as well
+        ContainerType oldData;
+        oldData.reserve(std::max(size, 2 * oldSize));
+        oldData.resize(size);
+        _data.swap(oldData);
+        initialize(0, [&](size_t i) -> const T& {
+            return (i < oldSize) ? oldData[i] : initVal;
+        });
+    }
+}
+
+template <typename T>
+void Array<T, 1>::reserve(size_t numberOfElements) {
+    _data.reserve(numberOfElements);
+}
+
+template <typename T>
+size_t Array<T, 1>::capacity() const {
+    return _data.capacity();
 }
 
 template <typename T>
@@ -160,6 +195,25 @@ void Array<T, 1>::parallelForEachIndex(Callback func) const {
     constAccessor().parallelForEachIndex(func);
 }
 
+template <typename T>
+template <typename Callback>
+void Array<T, 1>::initialize(size_t beginIndex, const Callback& valueAt) {
+    size_t n = _data.size();
+    T* elements = _data.data();
+    auto initializeRange = [&](size_t begin, size_t end) {
+        for (size_t i = std::max(begin, beginIndex); i < end; ++i) {
+            internal::initializeArrayElement(elements + i, valueAt(i));
+        }
+    };
+
+    // Same chunks as parallelForEachIndex
+    if (n * sizeof(T) < internal::kFirstTouchMinBytes) {
+        initializeRange(kZeroSize, n);
+    } else {
+        parallelRangeFor(kZeroSize, n, initializeRange);
+    }
+}
+
 template <typename T>
 void Array<T, 1>::serialize(std::ostream* strm) const {
     uint64_t s64 = size();
@@ -207,6 +261,13 @@ Array<T, 1>& Array<T, 1>::operator=(const Array& other) {
     return *this;
 }
 
+template <typename T>
+Array<T, 1>& Array<T, 1>::operator=(Array&& other) noexcept {
+    _data = std::move(other._data);
+    other._data.clear();
+    return *this;
+}
+
 template <typename T>
 Array<T, 1>& Array<T, 1>::operator=(const std::initializer_list<T>& lst) {
     set(lst);
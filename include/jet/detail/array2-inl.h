@@ -35,6 +35,13 @@ Array<T, 2>::Array(const Array& other) {
     set(other);
 }
 
+template <typename T>
+Array<T, 2>::Array(Array&& other) noexcept
+    : _size(other._size), _data(std::move(other._data)) {
+    other._size = Size2();
+    other._data.clear();
+}
+
 template <typename T>
 void Array<T, 2>::set(const T& value) {
     for (auto& v : _data) {
@@ -45,8 +52,8 @@ void Array<T, 2>::set(const T& value) {
 template <typename T>
 void Array<T, 2>::set(const Array& other) {
     _data.resize(other._data.size());
-    std::copy(other._data.begin(), other._data.end(), _data.begin());
     _size = other._size;
+    initialize([&](size_t i, size_t j) -> const T& { return other(i, j); });
 }
 
 template <typename T>
@@ -75,16 +82,20 @@ void Array<T, 2>::clear() {
 
 template <typename T>
 void Array<T, 2>::resize(const Size2& size, const T& initVal) {
+    // All the elements are kept, so the solvers can resize their buffers
+    // every step without reallocating them
+    if (size == _size) {
+        return;
+    }
+
     Array grid;
-    grid._data.resize(size.x * size.y, initVal);
+    grid._data.resize(size.x * size.y);
     grid._size = size;
     size_t iMin = std::min(size.x, _size.x);
     size_t jMin = std::min(size.y, _size.y);
-    for (size_t j = 0; j < jMin; ++j) {
-        for (size_t i = 0; i < iMin; ++i) {
-            grid(i, j) = at(i, j);
-        }
-    }
+    grid.initialize([&](size_t i, size_t j) -> const T& {
+        return (i < iMin && j < jMin) ? at(i, j) : initVal;
+    });
 
     swap(grid);
 }
@@ -213,6 +224,29 @@ void Array<T, 2>::parallelForEachIndex(Callback func) const {
     constAccessor().parallelForEachIndex(func);
 }
 
+template <typename T>
+template <typename Callback>
+void Array<T, 2>::initialize(const Callback& valueAt) {
+    T* elements = _data.data();
+    auto initializeRange = [&](
+        size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd) {
+        for (size_t j = jBegin; j < jEnd; ++j) {
+            T* row = elements + _size.x * j;
+            for (size_t i = iBegin; i < iEnd; ++i) {
+                internal::initializeArrayElement(row + i, valueAt(i, j));
+            }
+        }
+    };
+
+    // Same chunks as parallelForEachIndex
+    if (_data.size() * sizeof(T) < internal::kFirstTouchMinBytes) {
+        initializeRange(kZeroSize, _size.x, kZeroSize, _size.y);
+    } else {
+        parallelRangeFor(
+            kZeroSize, _size.x, kZeroSize, _size.y, initializeRange);
+    }
+}
+
 template <typename T>
 void Array<T, 2>::serialize(std::ostream* strm) const {
     uint64_t size64[2] = { _size.x, _size.y };
@@ -288,6 +322,15 @@ Array<T, 2>& Array<T, 2>::operator=(const Array& other) {
     return *this;
 }
 
+template <typename T>
+Array<T, 2>& Array<T, 2>::operator=(Array&& other) noexcept {
+    _size = other._size;
+    _data = std::move(other._data);
+    other._size = Size2();
+    other._data.clear();
+    return *this;
+}
+
 template <typename T>
 Array<T, 2>& Array<T, 2>::operator=(
     const std::initializer_list<std::initializer_list<T>>& lst) {
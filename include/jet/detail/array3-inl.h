@@ -38,6 +38,13 @@ Array<T, 3>::Array(const Array& other) {
     set(other);
 }
 
+template <typename T>
+Array<T, 3>::Array(Array&& other) noexcept
+    : _size(other._size), _data(std::move(other._data)) {
+    other._size = Size3();
+    other._data.clear();
+}
+
 template <typename T>
 void Array<T, 3>::set(const T& value) {
     for (auto& v : _data) {
@@ -48,8 +55,10 @@ void Array<T, 3>::set(const T& value) {
 template <typename T>
 void Array<T, 3>::set(const Array& other) {
     _data.resize(other._data.size());
-    std::copy(other._data.begin(), other._data.end(), _data.begin());
     _size = other._size;
+    initialize([&](size_t i, size_t j, size_t k) -> const T& {
+        return other(i, j, k);
+    });
 }
 
 template <typename T>
@@ -86,19 +95,21 @@ void Array<T, 3>::clear() {
 
 template <typename T>
 void Array<T, 3>::resize(const Size3& size, const T& initVal) {
+    // All the elements are kept, so the solvers can resize their buffers
+    // every step without reallocating them
+    if (size == _size) {
+        return;
+    }
+
     Array grid;
-    grid._data.resize(size.x * size.y * size.z, initVal);
+    grid._data.resize(size.x * size.y * size.z);
     grid._size = size;
     size_t iMin = std::min(size.x, _size.x);
     size_t jMin = std::min(size.y, _size.y);
     size_t kMin = std::min(size.z, _size.z);
-    for (size_t k = 0; k < kMin; ++k) {
-        for (size_t j = 0; j < jMin; ++j) {
-            for (size_t i = 0; i < iMin; ++i) {
-                grid(i, j, k) = at(i, j, k);
-            }
-        }
-    }
+    grid.initialize([&](size_t i, size_t j, size_t k) -> const T& {
+        return (i < iMin && j < jMin && k < kMin) ? at(i, j, k) : initVal;
+    });
 
     swap(grid);
 }
@@ -193,6 +204,40 @@ typename Array<T, 3>::ContainerType::const_iterator Array<T, 3>::end() const {
     return _data.end();
 }
 
+template <typename T>
+T* Array<T, 3>::row(size_t j, size_t k) {
+    JET_ASSERT(j < _size.y && k < _size.z);
+    return _data.data() + _size.x * (j + _size.y * k);
+}
+
+template <typename T>
+const T* Array<T, 3>::row(size_t j, size_t k) const {
+    JET_ASSERT(j < _size.y && k < _size.z);
+    return _data.data() + _size.x * (j + _size.y * k);
+}
+
+template <typename T>
+T* Array<T, 3>::slice(size_t k) {
+    JET_ASSERT(k < _size.z);
+    return _data.data() + _size.x * _size.y * k;
+}
+
+template <typename T>
+const T* Array<T, 3>::slice(size_t k) const {
+    JET_ASSERT(k < _size.z);
+    return _data.data() + _size.x * _size.y * k;
+}
+
+template <typename T>
+size_t Array<T, 3>::rowStride() const {
+    return _size.x;
+}
+
+template <typename T>
+size_t Array<T, 3>::sliceStride() const {
+    return _size.x * _size.y;
+}
+
 template <typename T>
 ArrayAccessor3<T> Array<T, 3>::accessor() {
     return ArrayAccessor3<T>(size(), data());
@@ -233,6 +278,50 @@ void Array<T, 3>::parallelForEachIndex(Callback func) const {
     constAccessor().parallelForEachIndex(func);
 }
 
+template <typename T>
+template <typename Callback>
+void Array<T, 3>::forEachRow(Callback func) const {
+    constAccessor().forEachRow(func);
+}
+
+template <typename T>
+template <typename Callback>
+void Array<T, 3>::parallelForEachRow(Callback func) const {
+    constAccessor().parallelForEachRow(func);
+}
+
+template <typename T>
+template <typename Callback>
+void Array<T, 3>::initialize(const Callback& valueAt) {
+    T* elements = _data.data();
+    auto initializeRange = [&](
+        size_t iBegin, size_t iEnd,
+        size_t jBegin, size_t jEnd,
+        size_t kBegin, size_t kEnd) {
+        for (size_t k = kBegin; k < kEnd; ++k) {
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                T* row = elements + _size.x * (j + _size.y * k);
+                for (size_t i = iBegin; i < iEnd; ++i) {
+                    internal::initializeArrayElement(
+                        row + i, valueAt(i, j, k));
+                }
+            }
+        }
+    };
+
+    // Same bricks as parallelForEachIndex
+    if (_data.size() * sizeof(T) < internal::kFirstTouchMinBytes) {
+        initializeRange(
+            kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z);
+    } else {
+        parallelRangeFor(
+            kZeroSize, _size.x,
+            kZeroSize, _size.y,
+            kZeroSize, _size.z,
+            initializeRange);
+    }
+}
+
 template <typename T>
 void Array<T, 3>::serialize(std::ostream* strm) const {
     uint64_t size64[3] = { _size.x, _size.y, _size.z };
@@ -309,6 +398,15 @@ Array<T, 3>& Array<T, 3>::operator=(const Array& other) {
     return *this;
 }
 
+template <typename T>
+Array<T, 3>& Array<T, 3>::operator=(Array&& other) noexcept {
+    _size = other._size;
+    _data = std::move(other._data);
+    other._size = Size3();
+    other._data.clear();
+    return *this;
+}
+
 template <typename T>
 Array<T, 3>& Array<T, 3>::operator=(
     const std::initializer_list<
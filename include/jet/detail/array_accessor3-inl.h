@@ -137,6 +137,28 @@ T* const ArrayAccessor<T, 3>::data() const {
     return _data;
 }
 
+template <typename T>
+T* ArrayAccessor<T, 3>::row(size_t j, size_t k) const {
+    JET_ASSERT(j < _size.y && k < _size.z);
+    return _data + _size.x * (j + _size.y * k);
+}
+
+template <typename T>
+T* ArrayAccessor<T, 3>::slice(size_t k) const {
+    JET_ASSERT(k < _size.z);
+    return _data + _size.x * _size.y * k;
+}
+
+template <typename T>
+size_t ArrayAccessor<T, 3>::rowStride() const {
+    return _size.x;
+}
+
+template <typename T>
+size_t ArrayAccessor<T, 3>::sliceStride() const {
+    return _size.x * _size.y;
+}
+
 template <typename T>
 void ArrayAccessor<T, 3>::swap(ArrayAccessor& other) {
     std::swap(other._data, _data);
@@ -170,17 +192,57 @@ void ArrayAccessor<T, 3>::forEachIndex(Callback func) const {
 template <typename T>
 template <typename Callback>
 void ArrayAccessor<T, 3>::parallelForEach(Callback func) {
-    parallelFor(kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z,
-        [&](size_t i, size_t j, size_t k) {
-            func(at(i, j, k));
+    parallelRangeFor(
+        kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z,
+        [&](size_t iBegin, size_t iEnd,
+            size_t jBegin, size_t jEnd,
+            size_t kBegin, size_t kEnd) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    T* row = _data + index(0, j, k);
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        func(row[i]);
+                    }
+                }
+            }
         });
 }
 
 template <typename T>
 template <typename Callback>
 void ArrayAccessor<T, 3>::parallelForEachIndex(Callback func) const {
-    parallelFor(
-        kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z, func);
+    parallelRangeFor(
+        kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z,
+        [&](size_t iBegin, size_t iEnd,
+            size_t jBegin, size_t jEnd,
+            size_t kBegin, size_t kEnd) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        func(i, j, k);
+                    }
+                }
+            }
+        });
+}
+
+template <typename T>
+template <typename Callback>
+void ArrayAccessor<T, 3>::forEachRow(Callback func) const {
+    for (size_t k = 0; k < _size.z; ++k) {
+        for (size_t j = 0; j < _size.y; ++j) {
+            func(j, k);
+        }
+    }
+}
+
+template <typename T>
+template <typename Callback>
+void ArrayAccessor<T, 3>::parallelForEachRow(Callback func) const {
+    const size_t height = _size.y;
+    parallelFor(kZeroSize, height * _size.z, [&](size_t r) {
+        func(r % height, r / height);
+    });
 }
 
 template <typename T>
@@ -312,6 +374,28 @@ const T* const ConstArrayAccessor<T, 3>::data() const {
     return _data;
 }
 
+template <typename T>
+const T* ConstArrayAccessor<T, 3>::row(size_t j, size_t k) const {
+    JET_ASSERT(j < _size.y && k < _size.z);
+    return _data + _size.x * (j + _size.y * k);
+}
+
+template <typename T>
+const T* ConstArrayAccessor<T, 3>::slice(size_t k) const {
+    JET_ASSERT(k < _size.z);
+    return _data + _size.x * _size.y * k;
+}
+
+template <typename T>
+size_t ConstArrayAccessor<T, 3>::rowStride() const {
+    return _size.x;
+}
+
+template <typename T>
+size_t ConstArrayAccessor<T, 3>::sliceStride() const {
+    return _size.x * _size.y;
+}
+
 template <typename T>
 template <typename Callback>
 void ConstArrayAccessor<T, 3>::forEach(Callback func) const {
@@ -339,8 +423,38 @@ void ConstArrayAccessor<T, 3>::forEachIndex(Callback func) const {
 template <typename T>
 template <typename Callback>
 void ConstArrayAccessor<T, 3>::parallelForEachIndex(Callback func) const {
-    parallelFor(
-        kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z, func);
+    parallelRangeFor(
+        kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z,
+        [&](size_t iBegin, size_t iEnd,
+            size_t jBegin, size_t jEnd,
+            size_t kBegin, size_t kEnd) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        func(i, j, k);
+                    }
+                }
+            }
+        });
+}
+
+template <typename T>
+template <typename Callback>
+void ConstArrayAccessor<T, 3>::forEachRow(Callback func) const {
+    for (size_t k = 0; k < _size.z; ++k) {
+        for (size_t j = 0; j < _size.y; ++j) {
+            func(j, k);
+        }
+    }
+}
+
+template <typename T>
+template <typename Callback>
+void ConstArrayAccessor<T, 3>::parallelForEachRow(Callback func) const {
+    const size_t height = _size.y;
+    parallelFor(kZeroSize, height * _size.z, [&](size_t r) {
+        func(r % height, r / height);
+    });
 }
 
 template <typename T>
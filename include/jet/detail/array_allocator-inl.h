@@ -0,0 +1,130 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_ARRAY_ALLOCATOR_INL_H_
+#define INCLUDE_JET_DETAIL_ARRAY_ALLOCATOR_INL_H_
+
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jet {
+
+namespace internal {
+
+// Holds the tag and the address returned by operator new, or by
+// mapHugePageArrayMemory if mappedBytes is not zero, in front of the aligned
+// block
+struct ArrayAllocationHeader {
+    void* block;
+    size_t mappedBytes;
+    MemoryTag tag;
+};
+
+static_assert(
+    sizeof(ArrayAllocationHeader) <= kArrayAlignment,
+    "The header should fit in front of the first element.");
+
+}  // namespace internal
+
+template <typename T>
+T* ArrayAllocator<T>::allocate(size_t n) {
+    static_assert(
+        alignof(T) <= kArrayAlignment,
+        "Over-aligned types are not supported.");
+
+    const size_t padding
+        = sizeof(internal::ArrayAllocationHeader) + kArrayAlignment - 1;
+    if (n > (std::numeric_limits<size_t>::max() - padding) / sizeof(T)) {
+        throw std::bad_alloc();
+    }
+
+    size_t bytes = n * sizeof(T);
+    MemoryTag tag = MemoryTracker::currentTag();
+
+    // The huge pages are aligned to kArrayAlignment already, so the header
+    // takes the first kArrayAlignment bytes
+    void* block = nullptr;
+    size_t mappedBytes = 0;
+    uintptr_t address = 0;
+    if (bytes >= arrayHugePageMinBytes()
+        && arrayHugePagePolicy() != ArrayHugePagePolicy::None) {
+        block = internal::mapHugePageArrayMemory(
+            kArrayAlignment + bytes, &mappedBytes);
+        address = reinterpret_cast<uintptr_t>(block) + kArrayAlignment;
+    }
+
+    if (block == nullptr) {
+        block = ::operator new(padding + bytes);
+        address = reinterpret_cast<uintptr_t>(block)
+            + sizeof(internal::ArrayAllocationHeader);
+        address = (address + kArrayAlignment - 1)
+            & ~static_cast<uintptr_t>(kArrayAlignment - 1);
+    }
+
+    internal::ArrayAllocationHeader* header
+        = reinterpret_cast<internal::ArrayAllocationHeader*>(address) - 1;
+    header->block = block;
+    header->mappedBytes = mappedBytes;
+    header->tag = tag;
+    MemoryTracker::onAllocate(tag, bytes);
+
+    return reinterpret_cast<T*>(address);
+}
+
+template <typename T>
+void ArrayAllocator<T>::deallocate(T* p, size_t n) {
+    const internal::ArrayAllocationHeader* header
+        = reinterpret_cast<const internal::ArrayAllocationHeader*>(p) - 1;
+    MemoryTracker::onDeallocate(header->tag, n * sizeof(T));
+    if (header->mappedBytes > 0) {
+        internal::unmapHugePageArrayMemory(
+            header->block, header->mappedBytes);
+    } else {
+        ::operator delete(header->block);
+    }
+}
+
+template <typename T>
+template <typename U>
+typename std::enable_if<std::is_trivially_destructible<U>::value>::type
+ArrayAllocator<T>::construct(U*) {
+}
+
+template <typename T>
+template <typename U>
+typename std::enable_if<!std::is_trivially_destructible<U>::value>::type
+ArrayAllocator<T>::construct(U* p) {
+    ::new (static_cast<void*>(p)) U();
+}
+
+template <typename T>
+template <typename U, typename... Args>
+void ArrayAllocator<T>::construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+}
+
+namespace internal {
+
+template <typename T>
+void initializeArrayElement(T* element, const T& value, std::true_type) {
+    ::new (static_cast<void*>(element)) T(value);
+}
+
+template <typename T>
+void initializeArrayElement(T* element, const T& value, std::false_type) {
+    *element = value;
+}
+
+template <typename T>
+void initializeArrayElement(T* element, const T& value) {
+    initializeArrayElement(
+        element, value, std::is_trivially_destructible<T>());
+}
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_ARRAY_ALLOCATOR_INL_H_
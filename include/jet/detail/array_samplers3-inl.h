@@ -142,6 +142,64 @@ T LinearArraySampler3<T, R>::operator()(const Vector3<R>& x) const {
         fz);
 }
 
+template <typename T, typename R>
+T LinearArraySampler3<T, R>::sample(
+    const LinearSamplerStencil3<R>& stencil) const {
+    const T* data = _accessor.data();
+    const size_t i0 = stencil.i[0];
+    const size_t i1 = stencil.i[1];
+    const T* row00 = data + stencil.rowOffsets[0];
+    const T* row10 = data + stencil.rowOffsets[1];
+    const T* row01 = data + stencil.rowOffsets[2];
+    const T* row11 = data + stencil.rowOffsets[3];
+
+    return trilerp(
+        row00[i0],
+        row00[i1],
+        row10[i0],
+        row10[i1],
+        row01[i0],
+        row01[i1],
+        row11[i0],
+        row11[i1],
+        stencil.fraction.x,
+        stencil.fraction.y,
+        stencil.fraction.z);
+}
+
+template <typename T, typename R>
+void LinearArraySampler3<T, R>::getStencil(
+    const Vector3<R>& x, LinearSamplerStencil3<R>* stencil) const {
+    ssize_t i, j, k;
+    R fx, fy, fz;
+
+    JET_ASSERT(_gridSpacing.x > std::numeric_limits<R>::epsilon() &&
+               _gridSpacing.y > std::numeric_limits<R>::epsilon() &&
+               _gridSpacing.z > std::numeric_limits<R>::epsilon());
+    Vector3<R> normalizedX = (x - _origin) / _gridSpacing;
+
+    ssize_t iSize = static_cast<ssize_t>(_accessor.size().x);
+    ssize_t jSize = static_cast<ssize_t>(_accessor.size().y);
+    ssize_t kSize = static_cast<ssize_t>(_accessor.size().z);
+
+    getBarycentric(normalizedX.x, 0, iSize, &i, &fx);
+    getBarycentric(normalizedX.y, 0, jSize, &j, &fy);
+    getBarycentric(normalizedX.z, 0, kSize, &k, &fz);
+
+    ssize_t ip1 = std::min(i + 1, iSize - 1);
+    ssize_t jp1 = std::min(j + 1, jSize - 1);
+    ssize_t kp1 = std::min(k + 1, kSize - 1);
+
+    stencil->i[0] = static_cast<size_t>(i);
+    stencil->i[1] = static_cast<size_t>(ip1);
+    stencil->rowOffsets[0] = static_cast<size_t>((j + jSize * k) * iSize);
+    stencil->rowOffsets[1] = static_cast<size_t>((jp1 + jSize * k) * iSize);
+    stencil->rowOffsets[2] = static_cast<size_t>((j + jSize * kp1) * iSize);
+    stencil->rowOffsets[3]
+        = static_cast<size_t>((jp1 + jSize * kp1) * iSize);
+    stencil->fraction = Vector3<R>(fx, fy, fz);
+}
+
 template <typename T, typename R>
 void LinearArraySampler3<T, R>::getCoordinatesAndWeights(
     const Vector3<R>& x,
@@ -186,6 +244,78 @@ void LinearArraySampler3<T, R>::getCoordinatesAndWeights(
     (*weights)[7] = fx * fy * fz;
 }
 
+template <typename T, typename R>
+void LinearArraySampler3<T, R>::getCoordinatesAndGradientWeights(
+    const Vector3<R>& x,
+    std::array<Point3UI, 8>* indices,
+    std::array<Vector3<R>, 8>* weights) const {
+    ssize_t i, j, k;
+    R fx, fy, fz;
+
+    JET_ASSERT(
+        _gridSpacing.x > 0.0 && _gridSpacing.y > 0.0 && _gridSpacing.z > 0.0);
+
+    const Vector3<R> normalizedX = (x - _origin) / _gridSpacing;
+
+    const ssize_t iSize = static_cast<ssize_t>(_accessor.size().x);
+    const ssize_t jSize = static_cast<ssize_t>(_accessor.size().y);
+    const ssize_t kSize = static_cast<ssize_t>(_accessor.size().z);
+
+    getBarycentric(normalizedX.x, 0, iSize, &i, &fx);
+    getBarycentric(normalizedX.y, 0, jSize, &j, &fy);
+    getBarycentric(normalizedX.z, 0, kSize, &k, &fz);
+
+    const ssize_t ip1 = std::min(i + 1, iSize - 1);
+    const ssize_t jp1 = std::min(j + 1, jSize - 1);
+    const ssize_t kp1 = std::min(k + 1, kSize - 1);
+
+    (*indices)[0] = Point3UI(i, j, k);
+    (*indices)[1] = Point3UI(ip1, j, k);
+    (*indices)[2] = Point3UI(i, jp1, k);
+    (*indices)[3] = Point3UI(ip1, jp1, k);
+    (*indices)[4] = Point3UI(i, j, kp1);
+    (*indices)[5] = Point3UI(ip1, j, kp1);
+    (*indices)[6] = Point3UI(i, jp1, kp1);
+    (*indices)[7] = Point3UI(ip1, jp1, kp1);
+
+    const R invDx = 1 / _gridSpacing.x;
+    const R invDy = 1 / _gridSpacing.y;
+    const R invDz = 1 / _gridSpacing.z;
+
+    (*weights)[0] = Vector3<R>(
+        (-invDx) * (1 - fy) * (1 - fz),
+        (1 - fx) * (-invDy) * (1 - fz),
+        (1 - fx) * (1 - fy) * (-invDz));
+    (*weights)[1] = Vector3<R>(
+        invDx * (1 - fy) * (1 - fz),
+        fx * (-invDy) * (1 - fz),
+        fx * (1 - fy) * (-invDz));
+    (*weights)[2] = Vector3<R>(
+        (-invDx) * fy * (1 - fz),
+        (1 - fx) * invDy * (1 - fz),
+        (1 - fx) * fy * (-invDz));
+    (*weights)[3] = Vector3<R>(
+        invDx * fy * (1 - fz),
+        fx * invDy * (1 - fz),
+        fx * fy * (-invDz));
+    (*weights)[4] = Vector3<R>(
+        (-invDx) * (1 - fy) * fz,
+        (1 - fx) * (-invDy) * fz,
+        (1 - fx) * (1 - fy) * invDz);
+    (*weights)[5] = Vector3<R>(
+        invDx * (1 - fy) * fz,
+        fx * (-invDy) * fz,
+        fx * (1 - fy) * invDz);
+    (*weights)[6] = Vector3<R>(
+        (-invDx) * fy * fz,
+        (1 - fx) * invDy * fz,
+        (1 - fx) * fy * invDz);
+    (*weights)[7] = Vector3<R>(
+        invDx * fy * fz,
+        fx * invDy * fz,
+        fx * fy * invDz);
+}
+
 template <typename T, typename R>
 std::function<T(const Vector3<R>&)> LinearArraySampler3<T, R>::functor() const {
     LinearArraySampler sampler(*this);
@@ -198,10 +328,12 @@ template <typename T, typename R>
 CubicArraySampler3<T, R>::CubicArraySampler(
     const ConstArrayAccessor3<T>& accessor,
     const Vector3<R>& gridSpacing,
-    const Vector3<R>& gridOrigin) {
+    const Vector3<R>& gridOrigin,
+    bool isMonotonic) {
     _gridSpacing = gridSpacing;
     _origin = gridOrigin;
     _accessor = accessor;
+    _isMonotonic = isMonotonic;
 }
 
 
@@ -211,10 +343,68 @@ CubicArraySampler3<T, R>::CubicArraySampler(
     _gridSpacing = other._gridSpacing;
     _origin = other._origin;
     _accessor = other._accessor;
+    _isMonotonic = other._isMonotonic;
 }
 
 template <typename T, typename R>
 T CubicArraySampler3<T, R>::operator()(const Vector3<R>& x) const {
+    CubicSamplerStencil3<R> stencil;
+    getStencil(x, &stencil);
+    return sample(stencil);
+}
+
+template <typename T, typename R>
+T CubicArraySampler3<T, R>::sample(
+    const CubicSamplerStencil3<R>& stencil) const {
+    const T* data = _accessor.data();
+    const std::array<size_t, 4>& is = stencil.i;
+    T kValues[4];
+
+    if (_isMonotonic) {
+        for (int kk = 0; kk < 4; ++kk) {
+            T jValues[4];
+
+            for (int jj = 0; jj < 4; ++jj) {
+                const T* row = data + stencil.rowOffsets[4 * kk + jj];
+                jValues[jj] = monotonicCatmullRom(
+                    row[is[0]], row[is[1]], row[is[2]], row[is[3]],
+                    stencil.fraction.x);
+            }
+
+            kValues[kk] = monotonicCatmullRom(
+                jValues[0], jValues[1], jValues[2], jValues[3],
+                stencil.fraction.y);
+        }
+
+        return monotonicCatmullRom(
+            kValues[0], kValues[1], kValues[2], kValues[3],
+            stencil.fraction.z);
+    }
+
+    const std::array<R, 4>& wx = stencil.wx;
+    const std::array<R, 4>& wy = stencil.wy;
+    const std::array<R, 4>& wz = stencil.wz;
+
+    for (int kk = 0; kk < 4; ++kk) {
+        T jValues[4];
+
+        for (int jj = 0; jj < 4; ++jj) {
+            const T* row = data + stencil.rowOffsets[4 * kk + jj];
+            jValues[jj] = wx[0] * row[is[0]] + wx[1] * row[is[1]]
+                + wx[2] * row[is[2]] + wx[3] * row[is[3]];
+        }
+
+        kValues[kk] = wy[0] * jValues[0] + wy[1] * jValues[1]
+            + wy[2] * jValues[2] + wy[3] * jValues[3];
+    }
+
+    return wz[0] * kValues[0] + wz[1] * kValues[1]
+        + wz[2] * kValues[2] + wz[3] * kValues[3];
+}
+
+template <typename T, typename R>
+void CubicArraySampler3<T, R>::getStencil(
+    const Vector3<R>& x, CubicSamplerStencil3<R>* stencil) const {
     ssize_t i, j, k;
     ssize_t iSize = static_cast<ssize_t>(_accessor.size().x);
     ssize_t jSize = static_cast<ssize_t>(_accessor.size().y);
@@ -249,26 +439,35 @@ T CubicArraySampler3<T, R>::operator()(const Vector3<R>& x) const {
         std::min(k + 2, kSize - 1)
     };
 
-    T kValues[4];
-
+    for (int n = 0; n < 4; ++n) {
+        stencil->i[n] = static_cast<size_t>(is[n]);
+    }
     for (int kk = 0; kk < 4; ++kk) {
-        T jValues[4];
-
         for (int jj = 0; jj < 4; ++jj) {
-            jValues[jj] = monotonicCatmullRom(
-                _accessor(is[0], js[jj], ks[kk]),
-                _accessor(is[1], js[jj], ks[kk]),
-                _accessor(is[2], js[jj], ks[kk]),
-                _accessor(is[3], js[jj], ks[kk]),
-                fx);
+            stencil->rowOffsets[4 * kk + jj]
+                = static_cast<size_t>((js[jj] + jSize * ks[kk]) * iSize);
         }
-
-        kValues[kk] = monotonicCatmullRom(
-            jValues[0], jValues[1], jValues[2], jValues[3], fy);
     }
 
-    return monotonicCatmullRom(
-        kValues[0], kValues[1], kValues[2], kValues[3], fz);
+    stencil->fraction = Vector3<R>(fx, fy, fz);
+
+    // Catmull-Rom spline as a weighted sum of the four samples
+    auto weights = [](R t, std::array<R, 4>* w) {
+        R t2 = t * t;
+        R t3 = t2 * t;
+        (*w)[0] = (-t + 2 * t2 - t3) / 2;
+        (*w)[1] = (2 - 5 * t2 + 3 * t3) / 2;
+        (*w)[2] = (t + 4 * t2 - 3 * t3) / 2;
+        (*w)[3] = (t3 - t2) / 2;
+    };
+    weights(fx, &stencil->wx);
+    weights(fy, &stencil->wy);
+    weights(fz, &stencil->wz);
+}
+
+template <typename T, typename R>
+bool CubicArraySampler3<T, R>::isMonotonic() const {
+    return _isMonotonic;
 }
 
 template <typename T, typename R>
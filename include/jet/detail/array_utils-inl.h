@@ -6,10 +6,13 @@
 #include <jet/array1.h>
 #include <jet/array2.h>
 #include <jet/array3.h>
+#include <jet/math_utils.h>
 #include <jet/parallel.h>
 #include <jet/serial.h>
 #include <jet/type_helpers.h>
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace jet {
 
@@ -171,68 +174,292 @@ void extrapolateToRegion(
     const ConstArrayAccessor3<char>& valid,
     unsigned int numberOfIterations,
     ArrayAccessor3<T> output) {
+    ExtrapolationBuffers3 buffers;
+    extrapolateToRegion(input, valid, numberOfIterations, output, &buffers);
+}
+
+namespace internal {
+
+// Extrapolates from buffers->valid, which is updated as the valid region
+// grows. Each pass fills the front, which is the dilation of the valid
+// region minus the region itself, with the average of the valid neighbors.
+// The front points are invalid, so none of them reads the value of another.
+//
+// Only the first front is found from the whole mask. Any later front point
+// touches the previous front, since its other neighbors were already valid
+// before, so the next front is the dilation of the front minus the valid
+// region. It is built over the (j, k) rows that hold the front and their
+// neighbor rows only, which keeps the work within the band.
+template <typename T>
+void extrapolateFromValidMask(
+    const ConstArrayAccessor3<T>& input,
+    unsigned int numberOfIterations,
+    ArrayAccessor3<T> output,
+    ExtrapolationBuffers3* buffers) {
+    typedef BitArray3::Word Word;
+
     const Size3 size = input.size();
+    BitArray3& valid = buffers->valid;
+    BitArray3& front = buffers->front;
+    BitArray3& nextFront = buffers->nextFront;
+    std::vector<size_t>& rows = buffers->frontRows;
+    std::vector<size_t>& candidates = buffers->candidateRows;
+    std::vector<char>& rowFlags = buffers->rowFlags;
 
     JET_ASSERT(size == valid.size());
     JET_ASSERT(size == output.size());
 
-    Array3<char> valid0(size);
-    Array3<char> valid1(size);
+    // The solvers extrapolate their grids in place
+    if (input.data() != output.data()) {
+        parallelFor(
+            kZeroSize, size.x,
+            kZeroSize, size.y,
+            kZeroSize, size.z,
+            [&](size_t i, size_t j, size_t k) {
+                output(i, j, k) = input(i, j, k);
+            });
+    }
 
-    valid0.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        valid0(i, j, k) = valid(i, j, k);
-        output(i, j, k) = input(i, j, k);
-    });
+    if (numberOfIterations == 0) {
+        return;
+    }
+
+    const size_t numberOfRows = size.y * size.z;
+    const size_t n = valid.wordsPerRow();
+    const size_t carry = BitArray3::kBitsPerWord - 1;
+    const size_t lastBits = size.x % BitArray3::kBitsPerWord;
+    const Word lastWordMask
+        = (lastBits == 0) ? ~Word(0) : (Word(1) << lastBits) - 1;
+
+    valid.dilate(&front);
+    front.andNot(valid);
+    // The next front and the flags are left cleared by the last call
+    if (nextFront.size() != size) {
+        nextFront.resize(size);
+    }
+    if (rowFlags.size() != numberOfRows) {
+        rowFlags.assign(numberOfRows, 0);
+    }
+
+    // Collects the rows of the given candidates that have a front point
+    auto collectRows = [&](const BitArray3& mask) {
+        parallelFor(kZeroSize, candidates.size(), [&](size_t c) {
+            size_t r = candidates[c];
+            const Word* words = mask.row(r % size.y, r / size.y);
+            rowFlags[r] = static_cast<char>(
+                std::any_of(words, words + n, [](Word w) { return w != 0; }));
+        });
+        rows.clear();
+        for (size_t r : candidates) {
+            if (rowFlags[r]) {
+                rows.push_back(r);
+            }
+            rowFlags[r] = 0;
+        }
+    };
+
+    candidates.resize(numberOfRows);
+    for (size_t r = 0; r < numberOfRows; ++r) {
+        candidates[r] = r;
+    }
+    collectRows(front);
 
     for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
-        valid0.forEachIndex([&](size_t i, size_t j, size_t k) {
-            T sum = zero<T>();
-            unsigned int count = 0;
+        if (rows.empty()) {
+            break;
+        }
 
-            if (!valid0(i, j, k)) {
-                if (i + 1 < size.x && valid0(i + 1, j, k)) {
-                    sum += output(i + 1, j, k);
-                    ++count;
+        parallelFor(kZeroSize, rows.size(), [&](size_t a) {
+            size_t j = rows[a] % size.y;
+            size_t k = rows[a] / size.y;
+            const Word* words = front.row(j, k);
+            for (size_t w = 0; w < n; ++w) {
+                for (Word word = words[w]; word != 0; word &= word - 1) {
+                    size_t i = w * BitArray3::kBitsPerWord
+                        + internal::countTrailingZeros(word);
+
+                    T sum = zero<T>();
+                    unsigned int count = 0;
+                    if (i + 1 < size.x && valid(i + 1, j, k)) {
+                        sum += output(i + 1, j, k);
+                        ++count;
+                    }
+                    if (i > 0 && valid(i - 1, j, k)) {
+                        sum += output(i - 1, j, k);
+                        ++count;
+                    }
+                    if (j + 1 < size.y && valid(i, j + 1, k)) {
+                        sum += output(i, j + 1, k);
+                        ++count;
+                    }
+                    if (j > 0 && valid(i, j - 1, k)) {
+                        sum += output(i, j - 1, k);
+                        ++count;
+                    }
+                    if (k + 1 < size.z && valid(i, j, k + 1)) {
+                        sum += output(i, j, k + 1);
+                        ++count;
+                    }
+                    if (k > 0 && valid(i, j, k - 1)) {
+                        sum += output(i, j, k - 1);
+                        ++count;
+                    }
+
+                    output(i, j, k) = sum
+                        / static_cast<typename ScalarType<T>::value>(count);
                 }
+            }
+        });
 
-                if (i > 0 && valid0(i - 1, j, k)) {
-                    sum += output(i - 1, j, k);
-                    ++count;
-                }
+        parallelFor(kZeroSize, rows.size(), [&](size_t a) {
+            size_t j = rows[a] % size.y;
+            size_t k = rows[a] / size.y;
+            Word* validWords = valid.row(j, k);
+            const Word* frontWords = front.row(j, k);
+            for (size_t w = 0; w < n; ++w) {
+                validWords[w] |= frontWords[w];
+            }
+        });
 
-                if (j + 1 < size.y && valid0(i, j + 1, k)) {
-                    sum += output(i, j + 1, k);
-                    ++count;
-                }
+        if (iter + 1 == numberOfIterations) {
+            break;
+        }
 
-                if (j > 0 && valid0(i, j - 1, k)) {
-                    sum += output(i, j - 1, k);
-                    ++count;
-                }
+        // The front rows and their neighbors can hold the next front
+        candidates.clear();
+        auto addCandidate = [&](size_t r) {
+            if (!rowFlags[r]) {
+                rowFlags[r] = 1;
+                candidates.push_back(r);
+            }
+        };
+        for (size_t r : rows) {
+            size_t j = r % size.y;
+            size_t k = r / size.y;
+            addCandidate(r);
+            if (j > 0) {
+                addCandidate(r - 1);
+            }
+            if (j + 1 < size.y) {
+                addCandidate(r + 1);
+            }
+            if (k > 0) {
+                addCandidate(r - size.y);
+            }
+            if (k + 1 < size.z) {
+                addCandidate(r + size.y);
+            }
+        }
 
-                if (k + 1 < size.z && valid0(i, j, k + 1)) {
-                    sum += output(i, j, k + 1);
-                    ++count;
+        parallelFor(kZeroSize, candidates.size(), [&](size_t c) {
+            size_t j = candidates[c] % size.y;
+            size_t k = candidates[c] / size.y;
+            const Word* center = front.row(j, k);
+            const Word* neighbors[4] = {
+                (j > 0) ? front.row(j - 1, k) : nullptr,
+                (j + 1 < size.y) ? front.row(j + 1, k) : nullptr,
+                (k > 0) ? front.row(j, k - 1) : nullptr,
+                (k + 1 < size.z) ? front.row(j, k + 1) : nullptr
+            };
+            const Word* validWords = valid.row(j, k);
+            Word* out = nextFront.row(j, k);
+
+            for (size_t w = 0; w < n; ++w) {
+                Word c0 = center[w];
+                Word word = c0 | (c0 << 1) | (c0 >> 1);
+                if (w > 0) {
+                    word |= center[w - 1] >> carry;
                 }
-
-                if (k > 0 && valid0(i, j, k - 1)) {
-                    sum += output(i, j, k - 1);
-                    ++count;
+                if (w + 1 < n) {
+                    word |= center[w + 1] << carry;
                 }
-
-                if (count > 0) {
-                    output(i, j, k)
-                        = sum
-                        / static_cast<typename ScalarType<T>::value>(count);
-                    valid1(i, j, k) = 1;
+                for (const Word* neighbor : neighbors) {
+                    if (neighbor != nullptr) {
+                        word |= neighbor[w];
+                    }
                 }
-            } else {
-                valid1(i, j, k) = 1;
+                out[w] = word & ~validWords[w];
+            }
+            if (n > 0) {
+                out[n - 1] &= lastWordMask;
             }
         });
 
-        valid0.swap(valid1);
+        // Clears the old front so that only the next front is left set
+        parallelFor(kZeroSize, rows.size(), [&](size_t a) {
+            Word* words = front.row(rows[a] % size.y, rows[a] / size.y);
+            std::fill(words, words + n, Word(0));
+        });
+        front.swap(nextFront);
+
+        collectRows(front);
+    }
+}
+
+}  // namespace internal
+
+template <typename T>
+void extrapolateToRegion(
+    const ConstArrayAccessor3<T>& input,
+    const ConstArrayAccessor3<char>& valid,
+    unsigned int numberOfIterations,
+    ArrayAccessor3<T> output,
+    ExtrapolationBuffers3* buffers) {
+    JET_ASSERT(input.size() == valid.size());
+
+    buffers->valid.set(valid);
+    internal::extrapolateFromValidMask(
+        input, numberOfIterations, output, buffers);
+}
+
+template <typename T>
+void extrapolateToRegion(
+    const ConstArrayAccessor3<T>& input,
+    const BitArray3& valid,
+    unsigned int numberOfIterations,
+    ArrayAccessor3<T> output,
+    ExtrapolationBuffers3* buffers) {
+    JET_ASSERT(input.size() == valid.size());
+
+    buffers->valid = valid;
+    internal::extrapolateFromValidMask(
+        input, numberOfIterations, output, buffers);
+}
+
+template <typename T>
+void copyShiftedRange3(
+    const ConstArrayAccessor3<T>& input,
+    const Point3I& offset,
+    ArrayAccessor3<T> output) {
+    const Size3 inputSize = input.size();
+    if (inputSize.x * inputSize.y * inputSize.z == 0) {
+        return;
+    }
+
+    auto source = [](size_t i, ssize_t offset, size_t size) {
+        return static_cast<size_t>(clamp(
+            static_cast<ssize_t>(i) + offset,
+            ssize_t(0),
+            static_cast<ssize_t>(size) - 1));
+    };
+    output.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        output(i, j, k) = input(
+            source(i, offset.x, inputSize.x),
+            source(j, offset.y, inputSize.y),
+            source(k, offset.z, inputSize.z));
+    });
+}
+
+template <typename T>
+void shiftRange3(const Point3I& offset, ArrayAccessor3<T> output) {
+    const Size3 size = output.size();
+    if (offset == Point3I() || size.x * size.y * size.z == 0) {
+        return;
     }
+
+    Array3<T> input(size);
+    copyRange3(output, size.x, size.y, size.z, &input);
+    copyShiftedRange3(input.constAccessor(), offset, output);
 }
 
 template <typename ArrayType>
@@ -0,0 +1,127 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_BIT_ARRAY3_INL_H_
+#define INCLUDE_JET_DETAIL_BIT_ARRAY3_INL_H_
+
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/parallel.h>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace jet {
+
+namespace internal {
+
+// Returns the index of the lowest set bit of a non-zero word.
+inline size_t countTrailingZeros(BitArray3::Word word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<size_t>(index);
+#else
+    size_t index = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Returns the number of the set bits of a word.
+inline size_t countSetBits(BitArray3::Word word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_popcountll(word));
+#elif defined(_MSC_VER) && defined(_WIN64)
+    return static_cast<size_t>(__popcnt64(word));
+#else
+    size_t count = 0;
+    for (; word != 0; word &= word - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+}  // namespace internal
+
+inline void BitArray3::set(size_t i, size_t j, size_t k, bool value) {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    Word& word = row(j, k)[i / kBitsPerWord];
+    Word bit = Word(1) << (i % kBitsPerWord);
+    if (value) {
+        word |= bit;
+    } else {
+        word &= ~bit;
+    }
+}
+
+inline bool BitArray3::operator()(size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    return (row(j, k)[i / kBitsPerWord] >> (i % kBitsPerWord)) & 1;
+}
+
+inline BitArray3::Word* BitArray3::row(size_t j, size_t k) {
+    return _data.data() + _wordsPerRow * (j + _size.y * k);
+}
+
+inline const BitArray3::Word* BitArray3::row(size_t j, size_t k) const {
+    return _data.data() + _wordsPerRow * (j + _size.y * k);
+}
+
+template <typename Callback>
+void BitArray3::parallelSet(const Callback& func) {
+    parallelFor(kZeroSize, _size.y * _size.z, [&](size_t r) {
+        size_t j = r % _size.y;
+        size_t k = r / _size.y;
+        Word* words = row(j, k);
+        for (size_t w = 0; w < _wordsPerRow; ++w) {
+            size_t iBegin = w * kBitsPerWord;
+            size_t iEnd = std::min(iBegin + kBitsPerWord, _size.x);
+            Word word = 0;
+            for (size_t i = iBegin; i < iEnd; ++i) {
+                if (func(i, j, k)) {
+                    word |= Word(1) << (i - iBegin);
+                }
+            }
+            words[w] = word;
+        }
+    });
+}
+
+template <typename Callback>
+void BitArray3::forEachSetIndex(const Callback& func) const {
+    for (size_t k = 0; k < _size.z; ++k) {
+        for (size_t j = 0; j < _size.y; ++j) {
+            forEachSetIndexInRow(j, k, func);
+        }
+    }
+}
+
+template <typename Callback>
+void BitArray3::parallelForEachSetIndex(const Callback& func) const {
+    parallelFor(kZeroSize, _size.y * _size.z, [&](size_t r) {
+        forEachSetIndexInRow(r % _size.y, r / _size.y, func);
+    });
+}
+
+template <typename Callback>
+void BitArray3::forEachSetIndexInRow(
+    size_t j, size_t k, const Callback& func) const {
+    const Word* words = row(j, k);
+    for (size_t w = 0; w < _wordsPerRow; ++w) {
+        for (Word word = words[w]; word != 0; word &= word - 1) {
+            func(w * kBitsPerWord + internal::countTrailingZeros(word), j, k);
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_BIT_ARRAY3_INL_H_
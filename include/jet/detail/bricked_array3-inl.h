@@ -0,0 +1,214 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_BRICKED_ARRAY3_INL_H_
+#define INCLUDE_JET_DETAIL_BRICKED_ARRAY3_INL_H_
+
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/parallel.h>
+#include <algorithm>
+#include <utility>  // just make cpplint happy..
+#include <vector>
+
+namespace jet {
+
+template <typename T, size_t BrickSize>
+const size_t BrickedArray3<T, BrickSize>::kBrickVolume;
+
+template <typename T, size_t BrickSize>
+BrickedArray3<T, BrickSize>::BrickedArray3() {
+}
+
+template <typename T, size_t BrickSize>
+BrickedArray3<T, BrickSize>::BrickedArray3(
+    const Size3& size, const T& initVal) {
+    resize(size, initVal);
+}
+
+template <typename T, size_t BrickSize>
+BrickedArray3<T, BrickSize>::BrickedArray3(
+    size_t width, size_t height, size_t depth, const T& initVal) {
+    resize(width, height, depth, initVal);
+}
+
+template <typename T, size_t BrickSize>
+BrickedArray3<T, BrickSize>::BrickedArray3(
+    const ConstArrayAccessor3<T>& dense) {
+    set(dense);
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::set(const T& value) {
+    for (auto& v : _data) {
+        v = value;
+    }
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::set(const ConstArrayAccessor3<T>& dense) {
+    clear();
+    resize(dense.size());
+    parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*this)(i, j, k) = dense(i, j, k);
+    });
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::copyTo(Array3<T>* dense) const {
+    dense->resize(_size);
+    parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*dense)(i, j, k) = (*this)(i, j, k);
+    });
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::clear() {
+    _data.clear();
+    _size = Size3();
+    _numberOfBricks = Size3();
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::resize(
+    const Size3& size, const T& initVal) {
+    BrickedArray3 grid;
+    grid._size = size;
+    grid._numberOfBricks = Size3(
+        (size.x + BrickSize - 1) / BrickSize,
+        (size.y + BrickSize - 1) / BrickSize,
+        (size.z + BrickSize - 1) / BrickSize);
+    grid._data.resize(
+        grid._numberOfBricks.x * grid._numberOfBricks.y
+        * grid._numberOfBricks.z * kBrickVolume,
+        initVal);
+
+    size_t iMin = std::min(size.x, _size.x);
+    size_t jMin = std::min(size.y, _size.y);
+    size_t kMin = std::min(size.z, _size.z);
+    for (size_t k = 0; k < kMin; ++k) {
+        for (size_t j = 0; j < jMin; ++j) {
+            for (size_t i = 0; i < iMin; ++i) {
+                grid(i, j, k) = (*this)(i, j, k);
+            }
+        }
+    }
+
+    swap(grid);
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::resize(
+    size_t width, size_t height, size_t depth, const T& initVal) {
+    resize(Size3(width, height, depth), initVal);
+}
+
+template <typename T, size_t BrickSize>
+Size3 BrickedArray3<T, BrickSize>::size() const {
+    return _size;
+}
+
+template <typename T, size_t BrickSize>
+size_t BrickedArray3<T, BrickSize>::width() const {
+    return _size.x;
+}
+
+template <typename T, size_t BrickSize>
+size_t BrickedArray3<T, BrickSize>::height() const {
+    return _size.y;
+}
+
+template <typename T, size_t BrickSize>
+size_t BrickedArray3<T, BrickSize>::depth() const {
+    return _size.z;
+}
+
+template <typename T, size_t BrickSize>
+T& BrickedArray3<T, BrickSize>::operator()(const Point3UI& pt) {
+    return (*this)(pt.x, pt.y, pt.z);
+}
+
+template <typename T, size_t BrickSize>
+const T& BrickedArray3<T, BrickSize>::operator()(const Point3UI& pt) const {
+    return (*this)(pt.x, pt.y, pt.z);
+}
+
+template <typename T, size_t BrickSize>
+T& BrickedArray3<T, BrickSize>::operator()(size_t i, size_t j, size_t k) {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    return _data[index(i, j, k)];
+}
+
+template <typename T, size_t BrickSize>
+const T& BrickedArray3<T, BrickSize>::operator()(
+    size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    return _data[index(i, j, k)];
+}
+
+template <typename T, size_t BrickSize>
+void BrickedArray3<T, BrickSize>::swap(BrickedArray3& other) {
+    std::swap(other._data, _data);
+    std::swap(other._size, _size);
+    std::swap(other._numberOfBricks, _numberOfBricks);
+}
+
+template <typename T, size_t BrickSize>
+template <typename Callback>
+void BrickedArray3<T, BrickSize>::forEachIndex(Callback func) const {
+    for (size_t bk = 0; bk < _numberOfBricks.z; ++bk) {
+        for (size_t bj = 0; bj < _numberOfBricks.y; ++bj) {
+            for (size_t bi = 0; bi < _numberOfBricks.x; ++bi) {
+                forEachIndexInBrick(bi, bj, bk, func);
+            }
+        }
+    }
+}
+
+template <typename T, size_t BrickSize>
+template <typename Callback>
+void BrickedArray3<T, BrickSize>::parallelForEachIndex(Callback func) const {
+    parallelFor(
+        kZeroSize, _numberOfBricks.x,
+        kZeroSize, _numberOfBricks.y,
+        kZeroSize, _numberOfBricks.z,
+        [&](size_t bi, size_t bj, size_t bk) {
+            forEachIndexInBrick(bi, bj, bk, func);
+        });
+}
+
+template <typename T, size_t BrickSize>
+template <typename Callback>
+void BrickedArray3<T, BrickSize>::forEachIndexInBrick(
+    size_t bi, size_t bj, size_t bk, Callback func) const {
+    size_t iBegin = bi * BrickSize;
+    size_t jBegin = bj * BrickSize;
+    size_t kBegin = bk * BrickSize;
+    size_t iEnd = std::min(iBegin + BrickSize, _size.x);
+    size_t jEnd = std::min(jBegin + BrickSize, _size.y);
+    size_t kEnd = std::min(kBegin + BrickSize, _size.z);
+
+    for (size_t k = kBegin; k < kEnd; ++k) {
+        for (size_t j = jBegin; j < jEnd; ++j) {
+            for (size_t i = iBegin; i < iEnd; ++i) {
+                func(i, j, k);
+            }
+        }
+    }
+}
+
+template <typename T, size_t BrickSize>
+size_t BrickedArray3<T, BrickSize>::index(
+    size_t i, size_t j, size_t k) const {
+    size_t brick
+        = i / BrickSize
+        + _numberOfBricks.x
+        * (j / BrickSize + _numberOfBricks.y * (k / BrickSize));
+    size_t local
+        = i % BrickSize
+        + BrickSize * (j % BrickSize + BrickSize * (k % BrickSize));
+    return brick * kBrickVolume + local;
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_BRICKED_ARRAY3_INL_H_
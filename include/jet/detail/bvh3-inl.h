@@ -0,0 +1,432 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_BVH3_INL_H_
+#define INCLUDE_JET_DETAIL_BVH3_INL_H_
+
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace jet {
+
+namespace internal {
+
+inline double distanceSquaredToBox(
+    const BoundingBox3D& box, const Vector3D& pt) {
+    double distSquared = 0.0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double d = std::max(
+            {box.lowerCorner[axis] - pt[axis],
+             pt[axis] - box.upperCorner[axis],
+             0.0});
+        distSquared += d * d;
+    }
+    return distSquared;
+}
+
+// Slab test which reports the entry distance, or zero if the ray starts
+// inside of the box
+inline bool intersectsBox(
+    const BoundingBox3D& box, const Ray3D& ray, double* tEntry) {
+    double tMin = 0.0;
+    double tMax = std::numeric_limits<double>::max();
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double origin = ray.origin[axis];
+        double direction = ray.direction[axis];
+
+        if (direction == 0.0) {
+            if (origin < box.lowerCorner[axis]
+                || origin > box.upperCorner[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        double tNear = (box.lowerCorner[axis] - origin) / direction;
+        double tFar = (box.upperCorner[axis] - origin) / direction;
+        if (tNear > tFar) {
+            std::swap(tNear, tFar);
+        }
+
+        tMin = std::max(tMin, tNear);
+        tMax = std::min(tMax, tFar);
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+
+    *tEntry = tMin;
+    return true;
+}
+
+// Mask of the first count bits
+inline uint64_t packetMask(size_t count) {
+    return (count >= 64) ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+}
+
+}  // namespace internal
+
+template <typename DistanceSquaredFunc>
+size_t Bvh3::nearest(
+    const Vector3D& pt,
+    const DistanceSquaredFunc& distanceSquaredFunc) const {
+    return nearestInLeaves(
+        pt, [&](size_t position, size_t count, double* distancesSquared) {
+            for (size_t n = 0; n < count; ++n) {
+                distancesSquared[n] = distanceSquaredFunc(_items[position + n]);
+            }
+        });
+}
+
+template <typename LeafDistanceSquaredFunc>
+size_t Bvh3::nearestInLeaves(
+    const Vector3D& pt,
+    const LeafDistanceSquaredFunc& leafDistanceSquaredFunc) const {
+    size_t closest = kMaxSize;
+    double minDistSquared = std::numeric_limits<double>::max();
+
+    auto visit = [&](size_t start, size_t end) {
+        double distancesSquared[kLeafChunkSize];
+        for (size_t position = start; position < end;
+             position += kLeafChunkSize) {
+            size_t count = std::min(kLeafChunkSize, end - position);
+            leafDistanceSquaredFunc(position, count, distancesSquared);
+
+            for (size_t n = 0; n < count; ++n) {
+                size_t i = _items[position + n];
+                double distSquared = distancesSquared[n];
+                if (distSquared < minDistSquared
+                    || (distSquared == minDistSquared && i < closest)) {
+                    minDistSquared = distSquared;
+                    closest = i;
+                }
+            }
+        }
+    };
+
+    visit(_items.size() - _unboundedItems.size(), _items.size());
+
+    if (_nodes.empty()) {
+        return closest;
+    }
+
+    std::vector<size_t> stack(1, 0);
+    while (!stack.empty()) {
+        size_t nodeIndex = stack.back();
+        const Node& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        if (internal::distanceSquaredToBox(node.bound, pt) > minDistSquared) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            visit(node.start, node.start + node.count);
+        } else {
+            // Visit the nearer child first
+            size_t first = nodeIndex + 1;
+            size_t second = node.secondChild;
+            if (internal::distanceSquaredToBox(_nodes[first].bound, pt)
+                > internal::distanceSquaredToBox(_nodes[second].bound, pt)) {
+                std::swap(first, second);
+            }
+            stack.push_back(second);
+            stack.push_back(first);
+        }
+    }
+
+    return closest;
+}
+
+template <typename SignedDistanceFunc>
+double Bvh3::minimumSignedDistance(
+    const Vector3D& pt,
+    const SignedDistanceFunc& signedDistanceFunc) const {
+    double minDist = kMaxD;
+    for (size_t i : _unboundedItems) {
+        minDist = std::min(minDist, signedDistanceFunc(i));
+    }
+
+    if (_nodes.empty()) {
+        return minDist;
+    }
+
+    std::vector<size_t> stack(1, 0);
+    while (!stack.empty()) {
+        size_t nodeIndex = stack.back();
+        const Node& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        // Items of the node can only go below the current minimum if the
+        // point is inside of the node or closer than the minimum
+        double boxDistSquared = internal::distanceSquaredToBox(node.bound, pt);
+        if (boxDistSquared > 0.0
+            && (minDist <= 0.0 || boxDistSquared >= minDist * minDist)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (size_t n = node.start; n < node.start + node.count; ++n) {
+                minDist = std::min(minDist, signedDistanceFunc(_items[n]));
+            }
+        } else {
+            stack.push_back(node.secondChild);
+            stack.push_back(nodeIndex + 1);
+        }
+    }
+
+    return minDist;
+}
+
+template <typename IntersectFunc>
+void Bvh3::forEachRayCandidate(
+    const Ray3D& ray,
+    const IntersectFunc& intersectFunc) const {
+    double tMin = std::numeric_limits<double>::max();
+    for (size_t i : _unboundedItems) {
+        tMin = std::min(tMin, intersectFunc(i));
+    }
+
+    if (_nodes.empty()) {
+        return;
+    }
+
+    std::vector<size_t> stack(1, 0);
+    while (!stack.empty()) {
+        size_t nodeIndex = stack.back();
+        const Node& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        double tEntry;
+        if (!internal::intersectsBox(node.bound, ray, &tEntry)
+            || tEntry > tMin) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (size_t n = node.start; n < node.start + node.count; ++n) {
+                tMin = std::min(tMin, intersectFunc(_items[n]));
+            }
+        } else {
+            stack.push_back(node.secondChild);
+            stack.push_back(nodeIndex + 1);
+        }
+    }
+}
+
+template <typename DistanceSquaredFunc>
+void Bvh3::nearestPacket(
+    const Vector3D* pts,
+    size_t count,
+    const DistanceSquaredFunc& distanceSquaredFunc,
+    size_t* results) const {
+    nearestPacketInLeaves(
+        pts,
+        count,
+        [&](size_t position, size_t n, size_t k, double* distancesSquared) {
+            for (size_t m = 0; m < n; ++m) {
+                distancesSquared[m]
+                    = distanceSquaredFunc(_items[position + m], k);
+            }
+        },
+        results);
+}
+
+template <typename LeafDistanceSquaredFunc>
+void Bvh3::nearestPacketInLeaves(
+    const Vector3D* pts,
+    size_t count,
+    const LeafDistanceSquaredFunc& leafDistanceSquaredFunc,
+    size_t* results) const {
+    JET_ASSERT(count <= kPacketSize);
+
+    double minDistSquared[kPacketSize];
+    for (size_t k = 0; k < count; ++k) {
+        minDistSquared[k] = std::numeric_limits<double>::max();
+        results[k] = kMaxSize;
+    }
+
+    auto visit = [&](size_t start, size_t end, uint64_t mask) {
+        double distancesSquared[kLeafChunkSize];
+        for (size_t position = start; position < end;
+             position += kLeafChunkSize) {
+            size_t n = std::min(kLeafChunkSize, end - position);
+            for (size_t k = 0; k < count; ++k) {
+                if (!(mask >> k & 1)) {
+                    continue;
+                }
+
+                leafDistanceSquaredFunc(position, n, k, distancesSquared);
+                for (size_t m = 0; m < n; ++m) {
+                    size_t i = _items[position + m];
+                    double distSquared = distancesSquared[m];
+                    if (distSquared < minDistSquared[k]
+                        || (distSquared == minDistSquared[k]
+                            && i < results[k])) {
+                        minDistSquared[k] = distSquared;
+                        results[k] = i;
+                    }
+                }
+            }
+        }
+    };
+
+    visit(
+        _items.size() - _unboundedItems.size(),
+        _items.size(),
+        internal::packetMask(count));
+
+    if (_nodes.empty() || count == 0) {
+        return;
+    }
+
+    // Each entry has the mask of the points that were active at its parent
+    std::vector<std::pair<size_t, uint64_t>> stack;
+    stack.emplace_back(0, internal::packetMask(count));
+    while (!stack.empty()) {
+        size_t nodeIndex = stack.back().first;
+        uint64_t parentMask = stack.back().second;
+        const Node& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        uint64_t mask = 0;
+        for (size_t k = 0; k < count; ++k) {
+            if ((parentMask >> k & 1)
+                && internal::distanceSquaredToBox(node.bound, pts[k])
+                    <= minDistSquared[k]) {
+                mask |= uint64_t(1) << k;
+            }
+        }
+        if (mask == 0) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            visit(node.start, node.start + node.count, mask);
+        } else {
+            // Visit the child nearer to the active points first
+            size_t first = nodeIndex + 1;
+            size_t second = node.secondChild;
+            double firstDistSquared = 0.0;
+            double secondDistSquared = 0.0;
+            for (size_t k = 0; k < count; ++k) {
+                if (mask >> k & 1) {
+                    firstDistSquared += internal::distanceSquaredToBox(
+                        _nodes[first].bound, pts[k]);
+                    secondDistSquared += internal::distanceSquaredToBox(
+                        _nodes[second].bound, pts[k]);
+                }
+            }
+            if (firstDistSquared > secondDistSquared) {
+                std::swap(first, second);
+            }
+            stack.emplace_back(second, mask);
+            stack.emplace_back(first, mask);
+        }
+    }
+}
+
+template <typename IntersectFunc>
+void Bvh3::forEachRayCandidatePacket(
+    const Ray3D* rays,
+    size_t count,
+    const IntersectFunc& intersectFunc) const {
+    JET_ASSERT(count <= kPacketSize);
+
+    double tMin[kPacketSize];
+    for (size_t k = 0; k < count; ++k) {
+        tMin[k] = std::numeric_limits<double>::max();
+    }
+
+    for (size_t i : _unboundedItems) {
+        for (size_t k = 0; k < count; ++k) {
+            tMin[k] = std::min(tMin[k], intersectFunc(i, k));
+        }
+    }
+
+    if (_nodes.empty() || count == 0) {
+        return;
+    }
+
+    std::vector<std::pair<size_t, uint64_t>> stack;
+    stack.emplace_back(0, internal::packetMask(count));
+    while (!stack.empty()) {
+        size_t nodeIndex = stack.back().first;
+        uint64_t parentMask = stack.back().second;
+        const Node& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        uint64_t mask = 0;
+        for (size_t k = 0; k < count; ++k) {
+            double tEntry;
+            if ((parentMask >> k & 1)
+                && internal::intersectsBox(node.bound, rays[k], &tEntry)
+                && tEntry <= tMin[k]) {
+                mask |= uint64_t(1) << k;
+            }
+        }
+        if (mask == 0) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (size_t n = node.start; n < node.start + node.count; ++n) {
+                for (size_t k = 0; k < count; ++k) {
+                    if (mask >> k & 1) {
+                        tMin[k]
+                            = std::min(tMin[k], intersectFunc(_items[n], k));
+                    }
+                }
+            }
+        } else {
+            stack.emplace_back(node.secondChild, mask);
+            stack.emplace_back(nodeIndex + 1, mask);
+        }
+    }
+}
+
+template <typename HitFunc>
+bool Bvh3::anyRayHit(const Ray3D& ray, const HitFunc& hitFunc) const {
+    for (size_t i : _unboundedItems) {
+        if (hitFunc(i)) {
+            return true;
+        }
+    }
+
+    if (_nodes.empty()) {
+        return false;
+    }
+
+    std::vector<size_t> stack(1, 0);
+    while (!stack.empty()) {
+        size_t nodeIndex = stack.back();
+        const Node& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        double tEntry;
+        if (!internal::intersectsBox(node.bound, ray, &tEntry)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (size_t n = node.start; n < node.start + node.count; ++n) {
+                if (hitFunc(_items[n])) {
+                    return true;
+                }
+            }
+        } else {
+            stack.push_back(node.secondChild);
+            stack.push_back(nodeIndex + 1);
+        }
+    }
+
+    return false;
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_BVH3_INL_H_
@@ -0,0 +1,115 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_CELL_CENTERED_SCALAR_GRID3_INL_H_
+#define INCLUDE_JET_DETAIL_CELL_CENTERED_SCALAR_GRID3_INL_H_
+
+#include <memory>
+
+namespace jet {
+
+template <typename T>
+CellCenteredScalarGrid3T<T>::CellCenteredScalarGrid3T() {
+}
+
+template <typename T>
+CellCenteredScalarGrid3T<T>::CellCenteredScalarGrid3T(
+    size_t resolutionX,
+    size_t resolutionY,
+    size_t resolutionZ,
+    double gridSpacingX,
+    double gridSpacingY,
+    double gridSpacingZ,
+    double originX,
+    double originY,
+    double originZ,
+    T initialValue) {
+    this->resize(
+        resolutionX,
+        resolutionY,
+        resolutionZ,
+        gridSpacingX,
+        gridSpacingY,
+        gridSpacingZ,
+        originX,
+        originY,
+        originZ,
+        initialValue);
+}
+
+template <typename T>
+CellCenteredScalarGrid3T<T>::CellCenteredScalarGrid3T(
+    const Size3& resolution,
+    const Vector3D& gridSpacing,
+    const Vector3D& origin,
+    T initialValue) {
+    this->resize(resolution, gridSpacing, origin, initialValue);
+}
+
+template <typename T>
+CellCenteredScalarGrid3T<T>::CellCenteredScalarGrid3T(
+    const CellCenteredScalarGrid3T& other) {
+    set(other);
+}
+
+template <typename T>
+CellCenteredScalarGrid3T<T>::CellCenteredScalarGrid3T(
+    CellCenteredScalarGrid3T&& other) {
+    this->swapScalarGrid(&other);
+}
+
+template <typename T>
+Size3 CellCenteredScalarGrid3T<T>::dataSize() const {
+    // The size of the data should be the same as the grid resolution.
+    return this->resolution();
+}
+
+template <typename T>
+Vector3D CellCenteredScalarGrid3T<T>::dataOrigin() const {
+    return this->origin() + 0.5 * this->gridSpacing();
+}
+
+template <typename T>
+std::shared_ptr<ScalarGrid3T<T>>
+CellCenteredScalarGrid3T<T>::clone() const {
+    return std::make_shared<CellCenteredScalarGrid3T>(*this);
+}
+
+template <typename T>
+void CellCenteredScalarGrid3T<T>::swap(Grid3* other) {
+    CellCenteredScalarGrid3T* sameType
+        = dynamic_cast<CellCenteredScalarGrid3T*>(other);
+    if (sameType != nullptr) {
+        this->swapScalarGrid(sameType);
+    }
+}
+
+template <typename T>
+void CellCenteredScalarGrid3T<T>::set(
+    const CellCenteredScalarGrid3T& other) {
+    this->setScalarGrid(other);
+}
+
+template <typename T>
+CellCenteredScalarGrid3T<T>&
+CellCenteredScalarGrid3T<T>::operator=(
+    const CellCenteredScalarGrid3T& other) {
+    set(other);
+    return *this;
+}
+
+template <typename T>
+CellCenteredScalarGrid3T<T>&
+CellCenteredScalarGrid3T<T>::operator=(CellCenteredScalarGrid3T&& other) {
+    this->swapScalarGrid(&other);
+    return *this;
+}
+
+template <typename T>
+std::shared_ptr<ScalarGridBuilder3T<T>>
+CellCenteredScalarGrid3T<T>::builder() {
+    return std::make_shared<CellCenteredScalarGridBuilder3T<T>>();
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_CELL_CENTERED_SCALAR_GRID3_INL_H_
@@ -5,9 +5,71 @@
 
 #include <jet/constants.h>
 #include <limits>
+#include <type_traits>
 
 namespace jet {
 
+namespace internal {
+
+// Checks if the BLAS type provides the optional fused CG kernels.
+template <typename BlasType>
+class HasFusedCgKernels {
+    template <typename T>
+    static auto test(int)
+        -> decltype(&T::mvmAndDot, &T::axpyAndDot, std::true_type());
+
+    template <typename>
+    static std::false_type test(...);
+
+ public:
+    static const bool value = decltype(test<BlasType>(0))::value;
+};
+
+// Fused CG kernels that fall back to the separate BLAS calls.
+template <
+    typename BlasType,
+    bool IsFused = HasFusedCgKernels<BlasType>::value>
+struct CgKernels {
+    // result = A * v, returns v . result
+    static double mvmAndDot(
+        const typename BlasType::MatrixType& A,
+        const typename BlasType::VectorType& v,
+        typename BlasType::VectorType* result) {
+        BlasType::mvm(A, v, result);
+        return BlasType::dot(v, *result);
+    }
+
+    // result = a * x + y, returns result . result
+    static double axpyAndDot(
+        double a,
+        const typename BlasType::VectorType& x,
+        const typename BlasType::VectorType& y,
+        typename BlasType::VectorType* result) {
+        BlasType::axpy(a, x, y, result);
+        return BlasType::dot(*result, *result);
+    }
+};
+
+template <typename BlasType>
+struct CgKernels<BlasType, true> {
+    static double mvmAndDot(
+        const typename BlasType::MatrixType& A,
+        const typename BlasType::VectorType& v,
+        typename BlasType::VectorType* result) {
+        return BlasType::mvmAndDot(A, v, result);
+    }
+
+    static double axpyAndDot(
+        double a,
+        const typename BlasType::VectorType& x,
+        const typename BlasType::VectorType& y,
+        typename BlasType::VectorType* result) {
+        return BlasType::axpyAndDot(a, x, y, result);
+    }
+};
+
+}  // namespace internal
+
 template <
     typename BlasType,
     typename PrecondType>
@@ -24,6 +86,8 @@ void pcg(
     typename BlasType::VectorType* s,
     unsigned int* lastNumberOfIterations,
     double* lastResidualNorm) {
+    typedef internal::CgKernels<BlasType> Kernels;
+
     // Clear
     BlasType::set(0, r);
     BlasType::set(0, d);
@@ -44,11 +108,8 @@ void pcg(
     unsigned int iter = 0;
     bool trigger = false;
     while (sigmaNew > square(tolerance) && iter < maxNumberOfIterations) {
-        // q = Ad
-        BlasType::mvm(A, *d, q);
-
-        // alpha = sigmaNew/d.q
-        double alpha = sigmaNew / BlasType::dot(*d, *q);
+        // q = Ad, alpha = sigmaNew/d.q
+        double alpha = sigmaNew / Kernels::mvmAndDot(A, *d, q);
 
         // x = x + alpha*d
         BlasType::axpy(alpha, *d, *x, x);
@@ -102,21 +163,63 @@ void cg(
     typename BlasType::VectorType* s,
     unsigned int* lastNumberOfIterations,
     double* lastResidualNorm) {
-    typedef NullCgPreconditioner<BlasType> PrecondType;
-    PrecondType precond;
-    pcg<BlasType, PrecondType>(
-        A,
-        b,
-        maxNumberOfIterations,
-        tolerance,
-        &precond,
-        x,
-        r,
-        d,
-        q,
-        s,
-        lastNumberOfIterations,
-        lastResidualNorm);
+    typedef internal::CgKernels<BlasType> Kernels;
+
+    // Same as pcg with the identity preconditioner, but the residual is used
+    // directly as the preconditioned residual, and r.r is computed while
+    // updating r. s is not used.
+    BlasType::set(0, r);
+    BlasType::set(0, d);
+    BlasType::set(0, q);
+    BlasType::set(0, s);
+
+    // r = b - Ax
+    BlasType::residual(A, *x, b, r);
+
+    // d = r
+    BlasType::set(*r, d);
+
+    // sigmaNew = r.r
+    double sigmaNew = BlasType::dot(*r, *r);
+
+    unsigned int iter = 0;
+    bool trigger = false;
+    while (sigmaNew > square(tolerance) && iter < maxNumberOfIterations) {
+        // q = Ad, alpha = sigmaNew/d.q
+        double alpha = sigmaNew / Kernels::mvmAndDot(A, *d, q);
+
+        // x = x + alpha*d
+        BlasType::axpy(alpha, *d, *x, x);
+
+        // sigmaOld = sigmaNew
+        double sigmaOld = sigmaNew;
+
+        // if i is divisible by 50...
+        if (trigger || (iter % 50 == 0 && iter > 0)) {
+            // r = b - Ax, sigmaNew = r.r
+            BlasType::residual(A, *x, b, r);
+            sigmaNew = BlasType::dot(*r, *r);
+            trigger = false;
+        } else {
+            // r = r - alpha*q, sigmaNew = r.r
+            sigmaNew = Kernels::axpyAndDot(-alpha, *q, *r, r);
+        }
+
+        if (sigmaNew > sigmaOld) {
+            trigger = true;
+        }
+
+        // beta = sigmaNew/sigmaOld
+        double beta = sigmaNew / sigmaOld;
+
+        // d = r + beta*d
+        BlasType::axpy(beta, *d, *r, d);
+
+        ++iter;
+    }
+
+    *lastNumberOfIterations = iter;
+    *lastResidualNorm = std::sqrt(sigmaNew);
 }
 
 }  // namespace jet
@@ -0,0 +1,92 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_COPY_ON_WRITE_ARRAY3_INL_H_
+#define INCLUDE_JET_DETAIL_COPY_ON_WRITE_ARRAY3_INL_H_
+
+#include <utility>
+
+namespace jet {
+
+template <typename T>
+CopyOnWriteArray3<T>::CopyOnWriteArray3()
+    : _array(std::make_shared<Array3<T>>()) {
+}
+
+template <typename T>
+CopyOnWriteArray3<T>::CopyOnWriteArray3(const CopyOnWriteArray3& other)
+    : _array(other._array) {
+    _isShared = true;
+    other._isShared = true;
+}
+
+template <typename T>
+CopyOnWriteArray3<T>& CopyOnWriteArray3<T>::operator=(
+    const CopyOnWriteArray3& other) {
+    if (_array != other._array) {
+        _array = other._array;
+        _isShared = true;
+        other._isShared = true;
+    }
+    return *this;
+}
+
+template <typename T>
+const Array3<T>& CopyOnWriteArray3<T>::get() const {
+    return *_array;
+}
+
+template <typename T>
+const T& CopyOnWriteArray3<T>::operator()(
+    size_t i, size_t j, size_t k) const {
+    return (*_array)(i, j, k);
+}
+
+template <typename T>
+Size3 CopyOnWriteArray3<T>::size() const {
+    return _array->size();
+}
+
+template <typename T>
+ConstArrayAccessor3<T> CopyOnWriteArray3<T>::constAccessor() const {
+    return _array->constAccessor();
+}
+
+template <typename T>
+bool CopyOnWriteArray3<T>::isShared() const {
+    return _isShared.load(std::memory_order_acquire);
+}
+
+template <typename T>
+template <typename Callback>
+Array3<T>& CopyOnWriteArray3<T>::mutate(const Callback& onCopy) {
+    if (_isShared.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_isShared.load(std::memory_order_relaxed)) {
+            // The other sharers may have been copied or destroyed already
+            if (_array.use_count() > 1) {
+                _array = std::make_shared<Array3<T>>(*_array);
+                onCopy();
+            }
+            _isShared.store(false, std::memory_order_release);
+        }
+    }
+
+    return *_array;
+}
+
+template <typename T>
+Array3<T>& CopyOnWriteArray3<T>::mutate() {
+    return mutate([] {});
+}
+
+template <typename T>
+void CopyOnWriteArray3<T>::swap(CopyOnWriteArray3& other) {
+    _array.swap(other._array);
+    bool isShared = _isShared;
+    _isShared = other._isShared.load();
+    other._isShared = isShared;
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_COPY_ON_WRITE_ARRAY3_INL_H_
@@ -0,0 +1,208 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_FDM_LINEAR_SYSTEM2_INL_H_
+#define INCLUDE_JET_DETAIL_FDM_LINEAR_SYSTEM2_INL_H_
+
+#include <jet/macros.h>
+#include <jet/math_utils.h>
+#include <jet/parallel.h>
+
+#include <cmath>
+#include <functional>
+
+namespace jet {
+
+template <typename T>
+void FdmBlas2T<T>::set(T s, VectorType* result) {
+    result->set(s);
+}
+
+template <typename T>
+void FdmBlas2T<T>::set(const VectorType& v, VectorType* result) {
+    result->set(v);
+}
+
+template <typename T>
+void FdmBlas2T<T>::set(T s, MatrixType* result) {
+    FdmMatrixRow2T<T> row;
+    row.center = row.right = row.up = s;
+    result->set(row);
+}
+
+template <typename T>
+void FdmBlas2T<T>::set(const MatrixType& m, MatrixType* result) {
+    result->set(m);
+}
+
+template <typename T>
+double FdmBlas2T<T>::dot(const VectorType& a, const VectorType& b) {
+    Size2 size = a.size();
+
+    JET_THROW_INVALID_ARG_IF(size != b.size());
+
+    const T* aData = a.data();
+    const T* bData = b.data();
+
+    return parallelReduce(
+        kZeroSize,
+        size.x * size.y,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial += aData[i] * bData[i];
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+template <typename T>
+void FdmBlas2T<T>::axpy(
+    double a,
+    const VectorType& x,
+    const VectorType& y,
+    VectorType* result) {
+    Size2 size = x.size();
+
+    JET_THROW_INVALID_ARG_IF(size != y.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    x.parallelForEachIndex([&](size_t i, size_t j) {
+        (*result)(i, j) = static_cast<T>(a * x(i, j) + y(i, j));
+    });
+}
+
+template <typename T>
+void FdmBlas2T<T>::mvm(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    Size2 size = m.size();
+
+    JET_THROW_INVALID_ARG_IF(size != v.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    m.parallelForEachIndex([&](size_t i, size_t j) {
+        (*result)(i, j) = static_cast<T>(
+            m(i, j).center * v(i, j)
+            + ((i > 0) ? m(i - 1, j).right * v(i - 1, j) : 0.0)
+            + ((i + 1 < size.x) ? m(i, j).right * v(i + 1, j) : 0.0)
+            + ((j > 0) ? m(i, j - 1).up * v(i, j - 1) : 0.0)
+            + ((j + 1 < size.y) ? m(i, j).up * v(i, j + 1) : 0.0));
+    });
+}
+
+template <typename T>
+double FdmBlas2T<T>::mvmAndDot(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    Size2 size = m.size();
+
+    JET_THROW_INVALID_ARG_IF(size != v.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    return parallelReduce(
+        kZeroSize,
+        size.y,
+        0.0,
+        [&](size_t jBegin, size_t jEnd, double partial) {
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                for (size_t i = 0; i < size.x; ++i) {
+                    double mv
+                        = m(i, j).center * v(i, j)
+                        + ((i > 0) ? m(i - 1, j).right * v(i - 1, j) : 0.0)
+                        + ((i + 1 < size.x) ? m(i, j).right * v(i + 1, j) : 0.0)
+                        + ((j > 0) ? m(i, j - 1).up * v(i, j - 1) : 0.0)
+                        + ((j + 1 < size.y) ? m(i, j).up * v(i, j + 1) : 0.0);
+                    (*result)(i, j) = static_cast<T>(mv);
+                    partial += v(i, j) * mv;
+                }
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+template <typename T>
+double FdmBlas2T<T>::axpyAndDot(
+    double a,
+    const VectorType& x,
+    const VectorType& y,
+    VectorType* result) {
+    Size2 size = x.size();
+
+    JET_THROW_INVALID_ARG_IF(size != y.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    const T* xData = x.data();
+    const T* yData = y.data();
+    T* resultData = result->data();
+
+    return parallelReduce(
+        kZeroSize,
+        size.x * size.y,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                double value = a * xData[i] + yData[i];
+                resultData[i] = static_cast<T>(value);
+                partial += value * value;
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+template <typename T>
+void FdmBlas2T<T>::residual(
+    const MatrixType& a,
+    const VectorType& x,
+    const VectorType& b,
+    VectorType* result) {
+    Size2 size = a.size();
+
+    JET_THROW_INVALID_ARG_IF(size != x.size());
+    JET_THROW_INVALID_ARG_IF(size != b.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    a.parallelForEachIndex([&](size_t i, size_t j) {
+        (*result)(i, j) = static_cast<T>(
+            b(i, j)
+            - a(i, j).center * x(i, j)
+            - ((i > 0) ? a(i - 1, j).right * x(i - 1, j) : 0.0)
+            - ((i + 1 < size.x) ? a(i, j).right * x(i + 1, j) : 0.0)
+            - ((j > 0) ? a(i, j - 1).up * x(i, j - 1) : 0.0)
+            - ((j + 1 < size.y) ? a(i, j).up * x(i, j + 1) : 0.0));
+    });
+}
+
+template <typename T>
+double FdmBlas2T<T>::l2Norm(const VectorType& v) {
+    return std::sqrt(dot(v, v));
+}
+
+template <typename T>
+double FdmBlas2T<T>::lInfNorm(const VectorType& v) {
+    Size2 size = v.size();
+
+    const T* data = v.data();
+
+    double result = parallelReduce(
+        kZeroSize,
+        size.x * size.y,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial = absmax(partial, static_cast<double>(data[i]));
+            }
+            return partial;
+        },
+        absmax<double>);
+
+    return std::fabs(result);
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_FDM_LINEAR_SYSTEM2_INL_H_
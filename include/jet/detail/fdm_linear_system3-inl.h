@@ -0,0 +1,376 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_FDM_LINEAR_SYSTEM3_INL_H_
+#define INCLUDE_JET_DETAIL_FDM_LINEAR_SYSTEM3_INL_H_
+
+#include <jet/macros.h>
+#include <jet/math_utils.h>
+#include <jet/parallel.h>
+#include <jet/parallel_tuner.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace jet {
+
+namespace internal {
+
+// Pointers to the data of the stencil at row (j, k) of a linear system. The
+// neighbor rows out of the grid are null.
+template <typename T>
+struct FdmStencilRow3T {
+    size_t size = 0;
+    const FdmMatrixRow3T<T>* a = nullptr;
+    const FdmMatrixRow3T<T>* aDown = nullptr;
+    const FdmMatrixRow3T<T>* aBack = nullptr;
+    const T* x = nullptr;
+    const T* xDown = nullptr;
+    const T* xUp = nullptr;
+    const T* xBack = nullptr;
+    const T* xFront = nullptr;
+};
+
+template <typename T>
+FdmStencilRow3T<T> fdmStencilRow3(
+    const Array3<FdmMatrixRow3T<T>>& a,
+    const Array3<T>& x,
+    size_t j,
+    size_t k) {
+    Size3 size = a.size();
+    size_t offset = size.x * (j + size.y * k);
+    size_t slice = size.x * size.y;
+
+    FdmStencilRow3T<T> row;
+    row.size = size.x;
+    row.a = a.data() + offset;
+    row.x = x.data() + offset;
+    if (j > 0) {
+        row.aDown = row.a - size.x;
+        row.xDown = row.x - size.x;
+    }
+    if (j + 1 < size.y) {
+        row.xUp = row.x + size.x;
+    }
+    if (k > 0) {
+        row.aBack = row.a - slice;
+        row.xBack = row.x - slice;
+    }
+    if (k + 1 < size.z) {
+        row.xFront = row.x + slice;
+    }
+    return row;
+}
+
+// Returns (Ax)_i of the row, summed in the same order as the vectorized
+// kernels of the double-precision overloads below.
+template <typename T>
+double fdmStencilProduct3(const FdmStencilRow3T<T>& row, size_t i) {
+    double value = row.a[i].center * row.x[i];
+    if (i > 0) {
+        value += row.a[i - 1].right * row.x[i - 1];
+    }
+    if (i + 1 < row.size) {
+        value += row.a[i].right * row.x[i + 1];
+    }
+    if (row.xDown != nullptr) {
+        value += row.aDown[i].up * row.xDown[i];
+    }
+    if (row.xUp != nullptr) {
+        value += row.a[i].up * row.xUp[i];
+    }
+    if (row.xBack != nullptr) {
+        value += row.aBack[i].front * row.xBack[i];
+    }
+    if (row.xFront != nullptr) {
+        value += row.a[i].front * row.xFront[i];
+    }
+    return value;
+}
+
+// Same as above, but returns b_i - (Ax)_i.
+template <typename T>
+double fdmStencilResidual3(const FdmStencilRow3T<T>& row, T b, size_t i) {
+    double value = b - row.a[i].center * row.x[i];
+    if (i > 0) {
+        value -= row.a[i - 1].right * row.x[i - 1];
+    }
+    if (i + 1 < row.size) {
+        value -= row.a[i].right * row.x[i + 1];
+    }
+    if (row.xDown != nullptr) {
+        value -= row.aDown[i].up * row.xDown[i];
+    }
+    if (row.xUp != nullptr) {
+        value -= row.a[i].up * row.xUp[i];
+    }
+    if (row.xBack != nullptr) {
+        value -= row.aBack[i].front * row.xBack[i];
+    }
+    if (row.xFront != nullptr) {
+        value -= row.a[i].front * row.xFront[i];
+    }
+    return value;
+}
+
+template <typename T>
+void fdmAxpyRow(size_t n, double a, const T* x, const T* y, T* result) {
+    for (size_t i = 0; i < n; ++i) {
+        result[i] = static_cast<T>(a * x[i] + y[i]);
+    }
+}
+
+template <typename T>
+void fdmMvmRow3(const FdmStencilRow3T<T>& row, T* result) {
+    for (size_t i = 0; i < row.size; ++i) {
+        result[i] = static_cast<T>(fdmStencilProduct3(row, i));
+    }
+}
+
+template <typename T>
+void fdmResidualRow3(const FdmStencilRow3T<T>& row, const T* b, T* result) {
+    for (size_t i = 0; i < row.size; ++i) {
+        result[i] = static_cast<T>(fdmStencilResidual3(row, b[i], i));
+    }
+}
+
+// Vectorized double-precision kernels, dispatched by simdInstructionSet()
+void fdmAxpyRow(
+    size_t n, double a, const double* x, const double* y, double* result);
+
+void fdmMvmRow3(const FdmStencilRow3T<double>& row, double* result);
+
+void fdmResidualRow3(
+    const FdmStencilRow3T<double>& row, const double* b, double* result);
+
+}  // namespace internal
+
+template <typename T>
+void FdmBlas3T<T>::set(T s, VectorType* result) {
+    parallelFill(result->begin(), result->end(), s);
+}
+
+template <typename T>
+void FdmBlas3T<T>::set(const VectorType& v, VectorType* result) {
+    result->set(v);
+}
+
+template <typename T>
+void FdmBlas3T<T>::set(T s, MatrixType* result) {
+    FdmMatrixRow3T<T> row;
+    row.center = row.right = row.up = row.front = s;
+    parallelFill(result->begin(), result->end(), row);
+}
+
+template <typename T>
+void FdmBlas3T<T>::set(const MatrixType& m, MatrixType* result) {
+    result->set(m);
+}
+
+template <typename T>
+double FdmBlas3T<T>::dot(const VectorType& a, const VectorType& b) {
+    Size3 size = a.size();
+
+    JET_THROW_INVALID_ARG_IF(size != b.size());
+
+    const T* aData = a.data();
+    const T* bData = b.data();
+
+    return parallelReduce(
+        kZeroSize,
+        size.x * size.y * size.z,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial += aData[i] * bData[i];
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+template <typename T>
+void FdmBlas3T<T>::axpy(
+    double a,
+    const VectorType& x,
+    const VectorType& y,
+    VectorType* result) {
+    Size3 size = x.size();
+
+    JET_THROW_INVALID_ARG_IF(size != y.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    // Same bricks as parallelForEachIndex, whose rows are contiguous, one
+    // per chunk unless ParallelTuner picks a coarser partitioning
+    static ParallelRegion region("FdmBlas3::axpy");
+
+    const size_t tileSize = internal::kTileSize;
+    size_t numTilesY = (size.y + tileSize - 1) / tileSize;
+    size_t numTilesZ = (size.z + tileSize - 1) / tileSize;
+
+    region.parallelRangeFor(
+        kZeroSize,
+        numTilesY * numTilesZ,
+        kOneSize,
+        [&](size_t tileBegin, size_t tileEnd) {
+            for (size_t tile = tileBegin; tile < tileEnd; ++tile) {
+                size_t jBegin = (tile % numTilesY) * tileSize;
+                size_t jEnd = std::min(jBegin + tileSize, size.y);
+                size_t kBegin = (tile / numTilesY) * tileSize;
+                size_t kEnd = std::min(kBegin + tileSize, size.z);
+                for (size_t k = kBegin; k < kEnd; ++k) {
+                    size_t offset = size.x * (jBegin + size.y * k);
+                    internal::fdmAxpyRow(
+                        size.x * (jEnd - jBegin),
+                        a,
+                        x.data() + offset,
+                        y.data() + offset,
+                        result->data() + offset);
+                }
+            }
+        });
+}
+
+template <typename T>
+void FdmBlas3T<T>::mvm(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    Size3 size = m.size();
+
+    JET_THROW_INVALID_ARG_IF(size != v.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    parallelRangeFor(
+        kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+        [&](size_t, size_t, size_t jBegin, size_t jEnd,
+            size_t kBegin, size_t kEnd) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    internal::fdmMvmRow3(
+                        internal::fdmStencilRow3(m, v, j, k),
+                        result->data() + size.x * (j + size.y * k));
+                }
+            }
+        });
+}
+
+template <typename T>
+double FdmBlas3T<T>::mvmAndDot(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    Size3 size = m.size();
+
+    JET_THROW_INVALID_ARG_IF(size != v.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    return parallelReduce(
+        kZeroSize,
+        size.z,
+        0.0,
+        [&](size_t kBegin, size_t kEnd, double partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    size_t offset = size.x * (j + size.y * k);
+                    const T* vRow = v.data() + offset;
+                    T* resultRow = result->data() + offset;
+                    internal::fdmMvmRow3(
+                        internal::fdmStencilRow3(m, v, j, k), resultRow);
+                    for (size_t i = 0; i < size.x; ++i) {
+                        partial += vRow[i] * static_cast<double>(resultRow[i]);
+                    }
+                }
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+template <typename T>
+double FdmBlas3T<T>::axpyAndDot(
+    double a,
+    const VectorType& x,
+    const VectorType& y,
+    VectorType* result) {
+    Size3 size = x.size();
+
+    JET_THROW_INVALID_ARG_IF(size != y.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    const T* xData = x.data();
+    const T* yData = y.data();
+    T* resultData = result->data();
+
+    return parallelReduce(
+        kZeroSize,
+        size.x * size.y * size.z,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                double value = a * xData[i] + yData[i];
+                resultData[i] = static_cast<T>(value);
+                partial += value * value;
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+template <typename T>
+void FdmBlas3T<T>::residual(
+    const MatrixType& a,
+    const VectorType& x,
+    const VectorType& b,
+    VectorType* result) {
+    Size3 size = a.size();
+
+    JET_THROW_INVALID_ARG_IF(size != x.size());
+    JET_THROW_INVALID_ARG_IF(size != b.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    parallelRangeFor(
+        kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+        [&](size_t, size_t, size_t jBegin, size_t jEnd,
+            size_t kBegin, size_t kEnd) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    size_t offset = size.x * (j + size.y * k);
+                    internal::fdmResidualRow3(
+                        internal::fdmStencilRow3(a, x, j, k),
+                        b.data() + offset,
+                        result->data() + offset);
+                }
+            }
+        });
+}
+
+template <typename T>
+double FdmBlas3T<T>::l2Norm(const VectorType& v) {
+    return std::sqrt(dot(v, v));
+}
+
+template <typename T>
+double FdmBlas3T<T>::lInfNorm(const VectorType& v) {
+    Size3 size = v.size();
+
+    const T* data = v.data();
+
+    double result = parallelReduce(
+        kZeroSize,
+        size.x * size.y * size.z,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial = absmax(partial, static_cast<double>(data[i]));
+            }
+            return partial;
+        },
+        absmax<double>);
+
+    return std::fabs(result);
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_FDM_LINEAR_SYSTEM3_INL_H_
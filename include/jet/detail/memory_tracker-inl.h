@@ -0,0 +1,64 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_MEMORY_TRACKER_INL_H_
+#define INCLUDE_JET_DETAIL_MEMORY_TRACKER_INL_H_
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace jet {
+
+namespace internal {
+
+// Keeps the memory after the header aligned as operator new does
+const size_t kMemoryTrackingHeaderSize = alignof(std::max_align_t);
+
+}  // namespace internal
+
+template <typename T>
+T* MemoryTrackingAllocator<T>::allocate(size_t n) {
+    static_assert(
+        alignof(T) <= internal::kMemoryTrackingHeaderSize,
+        "Over-aligned types are not supported.");
+
+    if (n > (std::numeric_limits<size_t>::max()
+             - internal::kMemoryTrackingHeaderSize) / sizeof(T)) {
+        throw std::bad_alloc();
+    }
+
+    size_t bytes = n * sizeof(T);
+    MemoryTag tag = MemoryTracker::currentTag();
+    char* block = static_cast<char*>(
+        ::operator new(internal::kMemoryTrackingHeaderSize + bytes));
+    *reinterpret_cast<MemoryTag*>(block) = tag;
+    MemoryTracker::onAllocate(tag, bytes);
+
+    return reinterpret_cast<T*>(
+        block + internal::kMemoryTrackingHeaderSize);
+}
+
+template <typename T>
+void MemoryTrackingAllocator<T>::deallocate(T* p, size_t n) {
+    char* block
+        = reinterpret_cast<char*>(p) - internal::kMemoryTrackingHeaderSize;
+    MemoryTracker::onDeallocate(
+        *reinterpret_cast<MemoryTag*>(block), n * sizeof(T));
+    ::operator delete(block);
+}
+
+template <typename T, typename U>
+bool operator==(
+    const MemoryTrackingAllocator<T>&, const MemoryTrackingAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(
+    const MemoryTrackingAllocator<T>&, const MemoryTrackingAllocator<U>&) {
+    return false;
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_MEMORY_TRACKER_INL_H_
@@ -0,0 +1,218 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_PAGED_ARRAY3_INL_H_
+#define INCLUDE_JET_DETAIL_PAGED_ARRAY3_INL_H_
+
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/parallel.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace jet {
+
+template <typename T>
+const size_t PagedArray3<T>::kBrickSize;
+
+template <typename T>
+const size_t PagedArray3<T>::kDefaultMaxNumberOfResidentBricks;
+
+template <typename T>
+const size_t PagedArray3<T>::kBrickVolume;
+
+template <typename T>
+const size_t PagedArray3<T>::kPrefetchDistance;
+
+template <typename T>
+PagedArray3<T>::PagedArray3() {
+}
+
+template <typename T>
+PagedArray3<T>::PagedArray3(
+    const Size3& size,
+    const T& initVal,
+    size_t maxNumberOfResidentBricks) :
+    _maxNumberOfResidentBricks(maxNumberOfResidentBricks) {
+    resize(size, initVal);
+}
+
+template <typename T>
+void PagedArray3<T>::resize(const Size3& size, const T& initVal) {
+    _size = size;
+    _numberOfBricks = Size3(
+        (size.x + kBrickSize - 1) / kBrickSize,
+        (size.y + kBrickSize - 1) / kBrickSize,
+        (size.z + kBrickSize - 1) / kBrickSize);
+
+    std::vector<char> initialBrick(kBrickVolume * sizeof(T));
+    for (size_t n = 0; n < kBrickVolume; ++n) {
+        std::memcpy(&initialBrick[n * sizeof(T)], &initVal, sizeof(T));
+    }
+
+    _pager.reset(new BrickPager(
+        _numberOfBricks.x * _numberOfBricks.y * _numberOfBricks.z,
+        initialBrick,
+        _maxNumberOfResidentBricks));
+}
+
+template <typename T>
+void PagedArray3<T>::set(const ConstArrayAccessor3<T>& dense) {
+    resize(dense.size());
+    parallelUpdate([&](size_t i, size_t j, size_t k, T& value) {
+        value = dense(i, j, k);
+    });
+}
+
+template <typename T>
+void PagedArray3<T>::copyTo(Array3<T>* dense) const {
+    dense->resize(_size);
+    parallelForEachIndex([&](size_t i, size_t j, size_t k, const T& value) {
+        (*dense)(i, j, k) = value;
+    });
+}
+
+template <typename T>
+Size3 PagedArray3<T>::size() const {
+    return _size;
+}
+
+template <typename T>
+size_t PagedArray3<T>::width() const {
+    return _size.x;
+}
+
+template <typename T>
+size_t PagedArray3<T>::height() const {
+    return _size.y;
+}
+
+template <typename T>
+size_t PagedArray3<T>::depth() const {
+    return _size.z;
+}
+
+template <typename T>
+T PagedArray3<T>::operator()(size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    size_t brick = brickIndex(i, j, k);
+    const T* data = reinterpret_cast<const T*>(
+        _pager->acquire(brick, false));
+    T value = data[localIndex(i, j, k)];
+    _pager->release(brick);
+    return value;
+}
+
+template <typename T>
+void PagedArray3<T>::set(size_t i, size_t j, size_t k, const T& value) {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    size_t brick = brickIndex(i, j, k);
+    T* data = reinterpret_cast<T*>(_pager->acquire(brick, true));
+    data[localIndex(i, j, k)] = value;
+    _pager->release(brick);
+}
+
+template <typename T>
+size_t PagedArray3<T>::maxNumberOfResidentBricks() const {
+    return _maxNumberOfResidentBricks;
+}
+
+template <typename T>
+void PagedArray3<T>::setMaxNumberOfResidentBricks(size_t numberOfBricks) {
+    _maxNumberOfResidentBricks = numberOfBricks;
+    if (_pager != nullptr) {
+        _pager->setMaxNumberOfResidentBricks(numberOfBricks);
+    }
+}
+
+template <typename T>
+size_t PagedArray3<T>::numberOfResidentBricks() const {
+    return (_pager != nullptr) ? _pager->numberOfResidentBricks() : 0;
+}
+
+template <typename T>
+size_t PagedArray3<T>::numberOfBrickReads() const {
+    return (_pager != nullptr) ? _pager->numberOfBrickReads() : 0;
+}
+
+template <typename T>
+size_t PagedArray3<T>::numberOfBrickWrites() const {
+    return (_pager != nullptr) ? _pager->numberOfBrickWrites() : 0;
+}
+
+template <typename T>
+template <typename Callback>
+void PagedArray3<T>::forEachIndex(Callback func) const {
+    size_t n = _numberOfBricks.x * _numberOfBricks.y * _numberOfBricks.z;
+    for (size_t brick = 0; brick < n; ++brick) {
+        const T* data = reinterpret_cast<const T*>(
+            _pager->acquire(brick, false, kPrefetchDistance));
+        forEachIndexInBrick(brick, data, func);
+        _pager->release(brick);
+    }
+}
+
+template <typename T>
+template <typename Callback>
+void PagedArray3<T>::parallelForEachIndex(Callback func) const {
+    size_t n = _numberOfBricks.x * _numberOfBricks.y * _numberOfBricks.z;
+    parallelFor(kZeroSize, n, [&](size_t brick) {
+        const T* data = reinterpret_cast<const T*>(
+            _pager->acquire(brick, false, kPrefetchDistance));
+        forEachIndexInBrick(brick, data, func);
+        _pager->release(brick);
+    });
+}
+
+template <typename T>
+template <typename Callback>
+void PagedArray3<T>::parallelUpdate(Callback func) {
+    size_t n = _numberOfBricks.x * _numberOfBricks.y * _numberOfBricks.z;
+    parallelFor(kZeroSize, n, [&](size_t brick) {
+        T* data = reinterpret_cast<T*>(
+            _pager->acquire(brick, true, kPrefetchDistance));
+        forEachIndexInBrick(brick, data, func);
+        _pager->release(brick);
+    });
+}
+
+template <typename T>
+template <typename Value, typename Callback>
+void PagedArray3<T>::forEachIndexInBrick(
+    size_t brick, Value* data, Callback func) const {
+    size_t bi = brick % _numberOfBricks.x;
+    size_t bj = (brick / _numberOfBricks.x) % _numberOfBricks.y;
+    size_t bk = brick / (_numberOfBricks.x * _numberOfBricks.y);
+
+    size_t iBegin = bi * kBrickSize;
+    size_t jBegin = bj * kBrickSize;
+    size_t kBegin = bk * kBrickSize;
+    size_t iEnd = std::min(iBegin + kBrickSize, _size.x);
+    size_t jEnd = std::min(jBegin + kBrickSize, _size.y);
+    size_t kEnd = std::min(kBegin + kBrickSize, _size.z);
+
+    for (size_t k = kBegin; k < kEnd; ++k) {
+        for (size_t j = jBegin; j < jEnd; ++j) {
+            for (size_t i = iBegin; i < iEnd; ++i) {
+                func(i, j, k, data[localIndex(i, j, k)]);
+            }
+        }
+    }
+}
+
+template <typename T>
+size_t PagedArray3<T>::brickIndex(size_t i, size_t j, size_t k) const {
+    return i / kBrickSize
+        + _numberOfBricks.x
+        * (j / kBrickSize + _numberOfBricks.y * (k / kBrickSize));
+}
+
+template <typename T>
+size_t PagedArray3<T>::localIndex(size_t i, size_t j, size_t k) {
+    return i % kBrickSize
+        + kBrickSize * (j % kBrickSize + kBrickSize * (k % kBrickSize));
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_PAGED_ARRAY3_INL_H_
@@ -8,61 +8,135 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace jet {
 
 namespace internal {
 
-// Adopted from:
-// Radenski, A.
-// Shared Memory, Message Passing, and Hybrid Merge Sorts for Standalone and
-// Clustered SMPs. Proc PDPTA'11, the  2011 International Conference on Parallel
-// and Distributed Processing Techniques and Applications, CSREA Press
-// (H. Arabnia, Ed.), 2011, pp. 367 - 373.
-template <
-    typename RandomIterator,
-    typename RandomIterator2,
-    typename CompareFunction>
-void merge(
+// Edge length (in y and z) of the bricks handed out by 3-D parallelRangeFor.
+const size_t kTileSize = 8;
+
+// Max number of partial results that parallelReduce combines.
+const size_t kMaxReduceChunks = 256;
+
+// Min number of keys per chunk for parallelRadixSort.
+const size_t kRadixSortMinChunkSize = 4096;
+
+// Min number of elements per block for the scan-based functions.
+const size_t kScanMinBlockSize = 4096;
+
+// Number of chunks of parallelRangeFor in the deterministic mode.
+const size_t kDeterministicNumberOfChunks = 64;
+
+// Number of the leaves of the merge tree of parallelSort in the deterministic
+// mode.
+const size_t kDeterministicNumberOfSortLeaves = 16;
+
+// Min number of elements per leaf of parallelSort.
+const size_t kSortMinLeafSize = 4096;
+
+// Runs task(0), ..., task(numberOfTasks - 1) on the shared thread pool and
+// returns once all of them are done. Implemented in parallel.cpp.
+void runTasks(
+    size_t numberOfTasks,
+    const std::function<void(size_t)>& task);
+
+// Number of the elements of a[0, m) among the first d elements of the stable
+// merge of a[0, m) and b[0, n), which takes the equal elements from a first.
+// The binary search along the d-th diagonal of the merge path lets the
+// output of a merge be split into independent parts.
+template <typename RandomIterator, typename CompareFunction>
+size_t mergePath(
     RandomIterator a,
-    size_t size,
-    RandomIterator2 temp,
-    CompareFunction compareFunction) {
-    size_t i1 = 0;
-    size_t i2 = size / 2;
-    size_t tempi = 0;
-
-    while (i1 < size / 2 && i2 < size) {
-        if (compareFunction(a[i1], a[i2])) {
-            temp[tempi] = a[i1];
-            i1++;
+    size_t m,
+    RandomIterator b,
+    size_t n,
+    size_t d,
+    const CompareFunction& compareFunction) {
+    size_t lo = (d > n) ? d - n : 0;
+    size_t hi = std::min(d, m);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (compareFunction(b[d - mid - 1], a[mid])) {
+            hi = mid;
         } else {
-            temp[tempi] = a[i2];
-            i2++;
+            lo = mid + 1;
         }
-        tempi++;
-    }
-
-    while (i1 < size / 2) {
-        temp[tempi] = a[i1];
-        i1++;
-        tempi++;
     }
+    return lo;
+}
 
-    while (i2 < size) {
-        temp[tempi] = a[i2];
-        i2++;
-        tempi++;
-    }
+// Merges the adjacent pairs of the sorted runs of src into dst. The runs are
+// [bounds[i], bounds[i + 1]), and each pair has width runs per side. The
+// output is cut into numberOfTasks equal parts, and the inputs of each part
+// are found with mergePath, so all the parts are merged in parallel.
+template <
+    typename RandomIterator,
+    typename RandomIterator2,
+    typename CompareFunction>
+void mergeRuns(
+    RandomIterator src,
+    RandomIterator2 dst,
+    const std::vector<size_t>& bounds,
+    size_t width,
+    size_t numberOfTasks,
+    const CompareFunction& compareFunction) {
+    size_t numberOfRuns = bounds.size() - 1;
+    size_t size = bounds.back();
+
+    runTasks(numberOfTasks, [&](size_t task) {
+        size_t outBegin = size * task / numberOfTasks;
+        size_t outEnd = size * (task + 1) / numberOfTasks;
+
+        for (size_t run = 0; run < numberOfRuns; run += 2 * width) {
+            size_t pairBegin = bounds[run];
+            size_t pairMid = bounds[std::min(run + width, numberOfRuns)];
+            size_t pairEnd = bounds[std::min(run + 2 * width, numberOfRuns)];
+            if (pairEnd <= outBegin) {
+                continue;
+            }
+            if (pairBegin >= outEnd) {
+                break;
+            }
 
-    // Copy sorted temp array into main array, a
-    parallelFor(kZeroSize, size, [&](size_t i) {
-        a[i] = temp[i];
+            RandomIterator a = src + pairBegin;
+            RandomIterator b = src + pairMid;
+            size_t m = pairMid - pairBegin;
+            size_t n = pairEnd - pairMid;
+            size_t d0 = std::max(outBegin, pairBegin) - pairBegin;
+            size_t d1 = std::min(outEnd, pairEnd) - pairBegin;
+            size_t i = mergePath(a, m, b, n, d0, compareFunction);
+            size_t iEnd = mergePath(a, m, b, n, d1, compareFunction);
+            size_t j = d0 - i;
+            size_t jEnd = d1 - iEnd;
+
+            RandomIterator2 out = dst + (pairBegin + d0);
+            while (i < iEnd && j < jEnd) {
+                if (compareFunction(b[j], a[i])) {
+                    *out = std::move(b[j++]);
+                } else {
+                    *out = std::move(a[i++]);
+                }
+                ++out;
+            }
+            for (; i < iEnd; ++i, ++out) {
+                *out = std::move(a[i]);
+            }
+            for (; j < jEnd; ++j, ++out) {
+                *out = std::move(b[j]);
+            }
+        }
     });
 }
 
+// Sorts the leaves of a[0, size) in parallel, and then merges them pairwise
+// with mergeRuns, alternating between a and temp. The merges are stable, so
+// the sort is stable if the leaves are sorted with std::stable_sort, and the
+// result then does not depend on the number of leaves.
 template <
     typename RandomIterator,
     typename RandomIterator2,
@@ -71,39 +145,138 @@ void parallelMergeSort(
     RandomIterator a,
     size_t size,
     RandomIterator2 temp,
-    unsigned int numThreads,
-    CompareFunction compareFunction) {
-    if (numThreads == 1) {
-        std::sort(a, a + size, compareFunction);
-    } else if (numThreads > 1) {
-        std::vector<std::thread> pool;
-        pool.reserve(2);
-
-        auto launchRange = [compareFunction] (
-            RandomIterator begin,
-            size_t k2,
-            RandomIterator2 temp,
-            unsigned int numThreads) {
-            parallelMergeSort(begin, k2, temp, numThreads, compareFunction);
-        };
-
-        pool.emplace_back(launchRange, a, size / 2, temp, numThreads / 2);
-        pool.emplace_back(
-            launchRange,
-            a + size / 2,
-            size - size / 2,
-            temp + size / 2,
-            numThreads - numThreads / 2);
-
-        // Wait for jobs to finish
-        for (std::thread &t : pool) {
-            if (t.joinable()) {
-                t.join();
+    size_t numberOfLeaves,
+    bool isStable,
+    const CompareFunction& compareFunction) {
+    numberOfLeaves = std::max(kOneSize, std::min(numberOfLeaves, size));
+
+    std::vector<size_t> bounds(numberOfLeaves + 1);
+    for (size_t leaf = 0; leaf <= numberOfLeaves; ++leaf) {
+        bounds[leaf] = size * leaf / numberOfLeaves;
+    }
+
+    runTasks(numberOfLeaves, [&](size_t leaf) {
+        if (isStable) {
+            std::stable_sort(
+                a + bounds[leaf], a + bounds[leaf + 1], compareFunction);
+        } else {
+            std::sort(
+                a + bounds[leaf], a + bounds[leaf + 1], compareFunction);
+        }
+    });
+
+    bool isInTemp = false;
+    for (size_t width = 1; width < numberOfLeaves; width *= 2) {
+        if (isInTemp) {
+            mergeRuns(
+                temp, a, bounds, width, numberOfLeaves, compareFunction);
+        } else {
+            mergeRuns(
+                a, temp, bounds, width, numberOfLeaves, compareFunction);
+        }
+        isInTemp = !isInTemp;
+    }
+
+    if (isInTemp) {
+        runTasks(numberOfLeaves, [&](size_t leaf) {
+            for (size_t i = bounds[leaf]; i < bounds[leaf + 1]; ++i) {
+                a[i] = std::move(temp[i]);
             }
+        });
+    }
+}
+
+template <typename Key, typename Value>
+void parallelRadixSortPass(
+    const Key* keys,
+    const Value* values,
+    size_t size,
+    unsigned int shift,
+    size_t numChunks,
+    Key* sortedKeys,
+    Value* sortedValues) {
+    const size_t kNumBuckets = 256;
+    size_t chunkSize = (size + numChunks - 1) / numChunks;
+
+    // Histogram of the current digit for each chunk
+    std::vector<size_t> offsets(numChunks * kNumBuckets, 0);
+    runTasks(numChunks, [&](size_t chunk) {
+        size_t* histogram = &offsets[chunk * kNumBuckets];
+        size_t end = std::min(size, (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; ++i) {
+            ++histogram[(keys[i] >> shift) & 0xff];
+        }
+    });
+
+    // Exclusive scan in (digit, chunk) order keeps the sort stable
+    size_t sum = 0;
+    for (size_t digit = 0; digit < kNumBuckets; ++digit) {
+        for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+            size_t& offset = offsets[chunk * kNumBuckets + digit];
+            size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+    }
+
+    // Scatter
+    runTasks(numChunks, [&](size_t chunk) {
+        size_t* offset = &offsets[chunk * kNumBuckets];
+        size_t end = std::min(size, (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; ++i) {
+            size_t dst = offset[(keys[i] >> shift) & 0xff]++;
+            sortedKeys[dst] = keys[i];
+            sortedValues[dst] = values[i];
         }
+    });
+}
 
-        merge(a, size, temp, compareFunction);
+// Number of blocks of the scan-based functions, which only depends on the
+// size so that their results do not depend on the number of threads.
+inline size_t numberOfScanBlocks(size_t size) {
+    return std::max(
+        kOneSize,
+        std::min(
+            kMaxReduceChunks,
+            (size + kScanMinBlockSize - 1) / kScanMinBlockSize));
+}
+
+// Two-pass stream compaction of the positions from 0 to size. The flags of
+// the positions are evaluated once, counted per block, and then
+// write(i, destination) is called for each selected position i. Returns the
+// number of the selected positions.
+template <typename Flag, typename Write>
+size_t compact(size_t size, const Flag& flag, const Write& write) {
+    size_t numBlocks = numberOfScanBlocks(size);
+    size_t blockSize = (size + numBlocks - 1) / numBlocks;
+
+    std::vector<char> flags(size);
+    std::vector<size_t> offsets(numBlocks + 1, 0);
+    runTasks(numBlocks, [&](size_t block) {
+        size_t end = std::min(size, (block + 1) * blockSize);
+        size_t count = 0;
+        for (size_t i = block * blockSize; i < end; ++i) {
+            flags[i] = flag(i) ? 1 : 0;
+            count += flags[i];
+        }
+        offsets[block + 1] = count;
+    });
+
+    for (size_t block = 0; block < numBlocks; ++block) {
+        offsets[block + 1] += offsets[block];
     }
+
+    runTasks(numBlocks, [&](size_t block) {
+        size_t end = std::min(size, (block + 1) * blockSize);
+        size_t dst = offsets[block];
+        for (size_t i = block * blockSize; i < end; ++i) {
+            if (flags[i]) {
+                write(i, dst++);
+            }
+        }
+    });
+
+    return offsets[numBlocks];
 }
 
 }  // namespace internal
@@ -123,55 +296,134 @@ void parallelFill(
     });
 }
 
-// Adopted from http://ideone.com/Z7zldb
 template <typename IndexType, typename Function>
-void parallelFor(
-    IndexType start,
-    IndexType end,
-    const Function& func) {
-    if (start > end) {
+void parallelRangeFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    IndexType grainSize,
+    const Function& function) {
+    if (beginIndex >= endIndex) {
         return;
     }
 
-    // Estimate number of threads in the pool
-    static const unsigned int numThreadsHint
-        = std::thread::hardware_concurrency();
-    static const unsigned int numThreads
-        = (numThreadsHint == 0u ? 8u : numThreadsHint);
-
-    // Size of a slice for the range functions
-    IndexType n = end - start + 1;
-    IndexType slice
-        = (IndexType) std::round(n / static_cast<double>(numThreads));
-    slice = std::max(slice, IndexType(1));
+    grainSize = std::max(grainSize, IndexType(1));
+    size_t numChunks = static_cast<size_t>(
+        (endIndex - beginIndex + grainSize - 1) / grainSize);
 
-    // [Helper] Inner loop
-    auto launchRange = [&func] (IndexType k1, IndexType k2) {
-        for (IndexType k = k1; k < k2; k++) {
-            func(k);
-        }
-    };
+    // Dispatch chunks to the thread pool
+    internal::runTasks(numChunks, [&](size_t chunk) {
+        IndexType k1 = beginIndex + static_cast<IndexType>(chunk) * grainSize;
+        IndexType k2 = std::min(k1 + grainSize, endIndex);
+        function(k1, k2);
+    });
+}
 
-    // Create pool and launch jobs
-    std::vector<std::thread> pool;
-    pool.reserve(numThreads);
-    IndexType i1 = start;
-    IndexType i2 = std::min(start + slice, end);
-    for (unsigned int i = 0; i + 1 < numThreads && i1 < end; ++i) {
-        pool.emplace_back(launchRange, i1, i2);
-        i1 = i2;
-        i2 = std::min(i2 + slice, end);
-    }
-    if (i1 < end) {
-        pool.emplace_back(launchRange, i1, end);
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function) {
+    if (beginIndex >= endIndex) {
+        return;
     }
 
-    // Wait for jobs to finish
-    for (std::thread &t : pool) {
-        if (t.joinable()) {
-            t.join();
-        }
+    // One chunk per thread, or a fixed number of chunks in the deterministic
+    // mode so that the chunk boundaries do not depend on the thread count
+    IndexType n = endIndex - beginIndex + 1;
+    size_t numChunks = isDeterministic()
+        ? internal::kDeterministicNumberOfChunks
+        : maxNumberOfThreads();
+    IndexType slice = static_cast<IndexType>(
+        std::round(n / static_cast<double>(numChunks)));
+
+    parallelRangeFor(beginIndex, endIndex, slice, function);
+}
+
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndexX,
+    IndexType endIndexX,
+    IndexType beginIndexY,
+    IndexType endIndexY,
+    const Function& function) {
+    parallelRangeFor(
+        beginIndexY,
+        endIndexY,
+        [&](IndexType jBegin, IndexType jEnd) {
+            function(beginIndexX, endIndexX, jBegin, jEnd);
+        });
+}
+
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndexX,
+    IndexType endIndexX,
+    IndexType beginIndexY,
+    IndexType endIndexY,
+    IndexType beginIndexZ,
+    IndexType endIndexZ,
+    const Function& function) {
+    if (beginIndexX >= endIndexX
+        || beginIndexY >= endIndexY
+        || beginIndexZ >= endIndexZ) {
+        return;
     }
+
+    // Bricks span the whole x-range so that the inner-most loop stays
+    // contiguous in memory, and are tiled in y and z.
+    const IndexType tileSize = static_cast<IndexType>(internal::kTileSize);
+    IndexType numTilesY = (endIndexY - beginIndexY + tileSize - 1) / tileSize;
+    IndexType numTilesZ = (endIndexZ - beginIndexZ + tileSize - 1) / tileSize;
+
+    parallelRangeFor(
+        IndexType(0),
+        numTilesY * numTilesZ,
+        IndexType(1),
+        [&](IndexType tileBegin, IndexType tileEnd) {
+            for (IndexType tile = tileBegin; tile < tileEnd; ++tile) {
+                IndexType jBegin = beginIndexY + (tile % numTilesY) * tileSize;
+                IndexType kBegin = beginIndexZ + (tile / numTilesY) * tileSize;
+                function(
+                    beginIndexX,
+                    endIndexX,
+                    jBegin,
+                    std::min(jBegin + tileSize, endIndexY),
+                    kBegin,
+                    std::min(kBegin + tileSize, endIndexZ));
+            }
+        });
+}
+
+template <typename IndexType, typename Function>
+void parallelFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    IndexType grainSize,
+    const Function& function) {
+    parallelRangeFor(
+        beginIndex,
+        endIndex,
+        grainSize,
+        [&](IndexType k1, IndexType k2) {
+            for (IndexType k = k1; k < k2; ++k) {
+                function(k);
+            }
+        });
+}
+
+template <typename IndexType, typename Function>
+void parallelFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function) {
+    parallelRangeFor(
+        beginIndex,
+        endIndex,
+        [&](IndexType k1, IndexType k2) {
+            for (IndexType k = k1; k < k2; ++k) {
+                function(k);
+            }
+        });
 }
 
 template <typename IndexType, typename Function>
@@ -181,11 +433,17 @@ void parallelFor(
     IndexType beginIndexY,
     IndexType endIndexY,
     const Function& function) {
-    parallelFor(
-        beginIndexY, endIndexY,
-        [&](size_t j) {
-            for (IndexType i = beginIndexX; i < endIndexX; ++i) {
-                function(i, j);
+    parallelRangeFor(
+        beginIndexX,
+        endIndexX,
+        beginIndexY,
+        endIndexY,
+        [&](IndexType iBegin, IndexType iEnd,
+            IndexType jBegin, IndexType jEnd) {
+            for (IndexType j = jBegin; j < jEnd; ++j) {
+                for (IndexType i = iBegin; i < iEnd; ++i) {
+                    function(i, j);
+                }
             }
         });
 }
@@ -199,17 +457,98 @@ void parallelFor(
     IndexType beginIndexZ,
     IndexType endIndexZ,
     const Function& function) {
-    parallelFor(
-        beginIndexZ, endIndexZ,
-        [&](size_t k) {
-            for (IndexType j = beginIndexY; j < endIndexY; ++j) {
-                for (IndexType i = beginIndexX; i < endIndexX; ++i) {
-                    function(i, j, k);
+    parallelRangeFor(
+        beginIndexX,
+        endIndexX,
+        beginIndexY,
+        endIndexY,
+        beginIndexZ,
+        endIndexZ,
+        [&](IndexType iBegin, IndexType iEnd,
+            IndexType jBegin, IndexType jEnd,
+            IndexType kBegin, IndexType kEnd) {
+            for (IndexType k = kBegin; k < kEnd; ++k) {
+                for (IndexType j = jBegin; j < jEnd; ++j) {
+                    for (IndexType i = iBegin; i < iEnd; ++i) {
+                        function(i, j, k);
+                    }
                 }
             }
         });
 }
 
+template <
+    typename IndexType,
+    typename Value,
+    typename Function,
+    typename Reduce>
+Value parallelReduce(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Value& identity,
+    const Function& function,
+    const Reduce& reduce) {
+    if (beginIndex >= endIndex) {
+        return identity;
+    }
+
+    // The chunking depends only on the range (not the number of threads) so
+    // that the reduction order is fixed.
+    IndexType n = endIndex - beginIndex;
+    IndexType maxChunks = static_cast<IndexType>(internal::kMaxReduceChunks);
+    IndexType grainSize = (n + maxChunks - 1) / maxChunks;
+    size_t numChunks = static_cast<size_t>((n + grainSize - 1) / grainSize);
+
+    std::vector<Value> partials(numChunks, identity);
+    internal::runTasks(numChunks, [&](size_t chunk) {
+        IndexType k1 = beginIndex + static_cast<IndexType>(chunk) * grainSize;
+        IndexType k2 = std::min(k1 + grainSize, endIndex);
+        partials[chunk] = function(k1, k2, identity);
+    });
+
+    // Fixed pair-wise tree
+    for (size_t stride = 1; stride < numChunks; stride *= 2) {
+        for (size_t i = 0; i + stride < numChunks; i += 2 * stride) {
+            partials[i] = reduce(partials[i], partials[i + stride]);
+        }
+    }
+
+    return partials[0];
+}
+
+template <typename IndexType, typename Value, typename Function>
+void parallelMinMax(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function,
+    Value* minValue,
+    Value* maxValue) {
+    typedef std::pair<Value, Value> MinMax;
+
+    MinMax result = parallelReduce(
+        beginIndex,
+        endIndex,
+        MinMax(
+            std::numeric_limits<Value>::max(),
+            std::numeric_limits<Value>::lowest()),
+        [&](IndexType k1, IndexType k2, const MinMax& init) {
+            MinMax minMax = init;
+            for (IndexType k = k1; k < k2; ++k) {
+                Value value = function(k);
+                minMax.first = std::min(minMax.first, value);
+                minMax.second = std::max(minMax.second, value);
+            }
+            return minMax;
+        },
+        [](const MinMax& a, const MinMax& b) {
+            return MinMax(
+                std::min(a.first, b.first), std::max(a.second, b.second));
+        });
+
+    *minValue = result.first;
+    *maxValue = result.second;
+}
+
 template<typename RandomIterator, typename CompareFunction>
 void parallelSort(
     RandomIterator begin,
@@ -220,19 +559,264 @@ void parallelSort(
     }
 
     size_t size = static_cast<size_t>(end - begin);
+    bool isStable = isDeterministic();
+
+    if (size < internal::kSortMinLeafSize) {
+        if (isStable) {
+            std::stable_sort(begin, end, compareFunction);
+        } else {
+            std::sort(begin, end, compareFunction);
+        }
+        return;
+    }
 
     typedef typename std::iterator_traits<RandomIterator>::value_type
         value_type;
     std::vector<value_type> temp(size);
 
-    // Estimate number of threads in the pool
-    static const unsigned int numThreadsHint
-        = std::thread::hardware_concurrency();
-    static const unsigned int numThreads
-        = (numThreadsHint == 0u ? 8u : numThreadsHint);
+    // Stable sorts of a fixed number of leaves and stable merges give the
+    // same order of the equal elements as std::stable_sort regardless of the
+    // thread count
+    size_t numberOfLeaves = isStable
+        ? internal::kDeterministicNumberOfSortLeaves
+        : maxNumberOfThreads();
+    numberOfLeaves = std::min(
+        numberOfLeaves, size / internal::kSortMinLeafSize);
 
     internal::parallelMergeSort(
-        begin, size, temp.begin(), numThreads, compareFunction);
+        begin,
+        size,
+        temp.begin(),
+        numberOfLeaves,
+        isStable,
+        compareFunction);
+}
+
+template <typename KeyIterator, typename ValueIterator>
+void parallelRadixSort(
+    KeyIterator keysBegin,
+    KeyIterator keysEnd,
+    ValueIterator valuesBegin,
+    typename std::iterator_traits<KeyIterator>::value_type maxKey) {
+    typedef typename std::iterator_traits<KeyIterator>::value_type Key;
+    typedef typename std::iterator_traits<ValueIterator>::value_type Value;
+
+    if (keysEnd <= keysBegin) {
+        return;
+    }
+
+    size_t size = static_cast<size_t>(keysEnd - keysBegin);
+
+    unsigned int numPasses = 0;
+    for (Key k = maxKey; k > 0; k >>= 8) {
+        ++numPasses;
+    }
+    if (numPasses == 0) {
+        return;
+    }
+
+    // Ping-pong between two pairs of buffers
+    std::vector<Key> keys[2] = {
+        std::vector<Key>(keysBegin, keysEnd), std::vector<Key>(size) };
+    std::vector<Value> values[2] = {
+        std::vector<Value>(valuesBegin, valuesBegin + size),
+        std::vector<Value>(size) };
+
+    size_t numChunks = std::max(
+        kOneSize,
+        std::min(
+            static_cast<size_t>(maxNumberOfThreads()),
+            size / internal::kRadixSortMinChunkSize));
+
+    for (unsigned int pass = 0; pass < numPasses; ++pass) {
+        unsigned int src = pass % 2;
+        internal::parallelRadixSortPass(
+            keys[src].data(),
+            values[src].data(),
+            size,
+            8 * pass,
+            numChunks,
+            keys[1 - src].data(),
+            values[1 - src].data());
+    }
+
+    const std::vector<Key>& sortedKeys = keys[numPasses % 2];
+    const std::vector<Value>& sortedValues = values[numPasses % 2];
+    parallelFor(kZeroSize, size, [&](size_t i) {
+        keysBegin[i] = sortedKeys[i];
+        valuesBegin[i] = sortedValues[i];
+    });
+}
+
+template <
+    typename InputIterator,
+    typename OutputIterator,
+    typename T,
+    typename BinaryOperation>
+T parallelExclusiveScan(
+    InputIterator begin,
+    InputIterator end,
+    OutputIterator output,
+    const T& init,
+    BinaryOperation op) {
+    if (end <= begin) {
+        return init;
+    }
+
+    size_t size = static_cast<size_t>(end - begin);
+    size_t numBlocks = internal::numberOfScanBlocks(size);
+    size_t blockSize = (size + numBlocks - 1) / numBlocks;
+
+    // Sums of the blocks except for the last one, which no block needs
+    std::vector<T> offsets(numBlocks, init);
+    internal::runTasks(numBlocks - 1, [&](size_t block) {
+        size_t i = block * blockSize;
+        size_t blockEnd = i + blockSize;
+        T sum = begin[i];
+        for (++i; i < blockEnd; ++i) {
+            sum = op(sum, begin[i]);
+        }
+        offsets[block + 1] = sum;
+    });
+
+    for (size_t block = 1; block < numBlocks; ++block) {
+        offsets[block] = op(offsets[block - 1], offsets[block]);
+    }
+
+    // Each value is read before its prefix is written, so the scan can be
+    // in place
+    T total = init;
+    internal::runTasks(numBlocks, [&](size_t block) {
+        size_t blockEnd = std::min(size, (block + 1) * blockSize);
+        T sum = offsets[block];
+        for (size_t i = block * blockSize; i < blockEnd; ++i) {
+            T value = begin[i];
+            output[i] = sum;
+            sum = op(sum, value);
+        }
+        if (block + 1 == numBlocks) {
+            total = sum;
+        }
+    });
+
+    return total;
+}
+
+template <typename InputIterator, typename OutputIterator, typename T>
+T parallelExclusiveScan(
+    InputIterator begin,
+    InputIterator end,
+    OutputIterator output,
+    const T& init) {
+    return parallelExclusiveScan(
+        begin, end, output, init, [](const T& a, const T& b) {
+            return a + b;
+        });
+}
+
+template <
+    typename InputIterator,
+    typename OutputIterator,
+    typename Predicate>
+OutputIterator parallelCopyIf(
+    InputIterator begin,
+    InputIterator end,
+    OutputIterator output,
+    Predicate predicate) {
+    if (end <= begin) {
+        return output;
+    }
+
+    size_t count = internal::compact(
+        static_cast<size_t>(end - begin),
+        [&](size_t i) {
+            return predicate(begin[i]);
+        },
+        [&](size_t i, size_t dst) {
+            output[dst] = begin[i];
+        });
+
+    return output + count;
+}
+
+template <typename IndexType, typename OutputIterator, typename Predicate>
+size_t parallelCompact(
+    IndexType beginIndex,
+    IndexType endIndex,
+    OutputIterator output,
+    Predicate predicate) {
+    if (endIndex <= beginIndex) {
+        return 0;
+    }
+
+    return internal::compact(
+        static_cast<size_t>(endIndex - beginIndex),
+        [&](size_t i) {
+            return predicate(beginIndex + static_cast<IndexType>(i));
+        },
+        [&](size_t i, size_t dst) {
+            output[dst] = beginIndex + static_cast<IndexType>(i);
+        });
+}
+
+template <typename RandomIterator, typename Predicate>
+RandomIterator parallelPartition(
+    RandomIterator begin,
+    RandomIterator end,
+    Predicate predicate) {
+    typedef typename std::iterator_traits<RandomIterator>::value_type
+        value_type;
+
+    if (end <= begin) {
+        return begin;
+    }
+
+    size_t size = static_cast<size_t>(end - begin);
+    size_t numBlocks = internal::numberOfScanBlocks(size);
+    size_t blockSize = (size + numBlocks - 1) / numBlocks;
+
+    // Counts of the first group per block
+    std::vector<char> flags(size);
+    std::vector<size_t> offsets(numBlocks + 1, 0);
+    internal::runTasks(numBlocks, [&](size_t block) {
+        size_t blockEnd = std::min(size, (block + 1) * blockSize);
+        size_t count = 0;
+        for (size_t i = block * blockSize; i < blockEnd; ++i) {
+            flags[i] = predicate(begin[i]) ? 1 : 0;
+            count += flags[i];
+        }
+        offsets[block + 1] = count;
+    });
+
+    for (size_t block = 0; block < numBlocks; ++block) {
+        offsets[block + 1] += offsets[block];
+    }
+    size_t numberOfFirsts = offsets[numBlocks];
+
+    // The second group of a block starts after all the first ones and the
+    // second ones of the previous blocks
+    std::vector<value_type> temp(size);
+    internal::runTasks(numBlocks, [&](size_t block) {
+        size_t blockBegin = block * blockSize;
+        size_t blockEnd = std::min(size, blockBegin + blockSize);
+        size_t first = offsets[block];
+        size_t second = numberOfFirsts + blockBegin - offsets[block];
+        for (size_t i = blockBegin; i < blockEnd; ++i) {
+            if (flags[i]) {
+                temp[first++] = std::move(begin[i]);
+            } else {
+                temp[second++] = std::move(begin[i]);
+            }
+        }
+    });
+
+    parallelFor(kZeroSize, size, [&](size_t i) {
+        begin[i] = std::move(temp[i]);
+    });
+
+    return begin + static_cast<
+        typename std::iterator_traits<RandomIterator>::difference_type>(
+            numberOfFirsts);
 }
 
 template<typename RandomIterator>
@@ -0,0 +1,90 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_PARALLEL_TUNER_INL_H_
+#define INCLUDE_JET_DETAIL_PARALLEL_TUNER_INL_H_
+
+#include <jet/constants.h>
+#include <chrono>
+
+namespace jet {
+
+template <typename IndexType, typename Function>
+void ParallelRegion::parallelRangeFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    IndexType defaultGrainSize,
+    const Function& function) {
+    run(beginIndex, endIndex, std::max(defaultGrainSize, IndexType(1)),
+        function);
+}
+
+template <typename IndexType, typename Function>
+void ParallelRegion::parallelRangeFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function) {
+    run(beginIndex, endIndex, IndexType(0), function);
+}
+
+template <typename IndexType, typename Function>
+void ParallelRegion::parallelFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function) {
+    run(
+        beginIndex,
+        endIndex,
+        IndexType(0),
+        [&](IndexType k1, IndexType k2) {
+            for (IndexType k = k1; k < k2; ++k) {
+                function(k);
+            }
+        });
+}
+
+template <typename IndexType, typename Function>
+void ParallelRegion::run(
+    IndexType beginIndex,
+    IndexType endIndex,
+    IndexType defaultGrainSize,
+    const Function& function) {
+    if (beginIndex >= endIndex) {
+        return;
+    }
+
+    JET_PROFILE_SCOPE(_name);
+
+    size_t n = static_cast<size_t>(endIndex - beginIndex);
+    size_t trial = kMaxSize;
+    size_t numberOfChunks = beginCall(n, &trial);
+
+    if (numberOfChunks == 0) {
+        if (defaultGrainSize > 0) {
+            ::jet::parallelRangeFor(
+                beginIndex, endIndex, defaultGrainSize, function);
+        } else {
+            ::jet::parallelRangeFor(beginIndex, endIndex, function);
+        }
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (numberOfChunks == 1) {
+        function(beginIndex, endIndex);
+    } else {
+        IndexType grainSize = static_cast<IndexType>(
+            (n + numberOfChunks - 1) / numberOfChunks);
+        ::jet::parallelRangeFor(beginIndex, endIndex, grainSize, function);
+    }
+
+    if (trial != kMaxSize) {
+        std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - start;
+        endTrial(trial, n, elapsed.count());
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_PARALLEL_TUNER_INL_H_
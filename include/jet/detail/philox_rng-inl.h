@@ -0,0 +1,65 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_PHILOX_RNG_INL_H_
+#define INCLUDE_JET_DETAIL_PHILOX_RNG_INL_H_
+
+#include <array>
+#include <cstdint>
+
+namespace jet {
+
+inline PhiloxRng::PhiloxRng(uint64_t seed) : _seed(seed) {
+}
+
+inline uint64_t PhiloxRng::seed() const {
+    return _seed;
+}
+
+inline PhiloxRng::Block PhiloxRng::operator()(
+    uint64_t counter, uint64_t stream) const {
+    static const uint32_t kMultiplier0 = 0xD2511F53;
+    static const uint32_t kMultiplier1 = 0xCD9E8D57;
+    static const uint32_t kWeyl0 = 0x9E3779B9;
+    static const uint32_t kWeyl1 = 0xBB67AE85;
+
+    Block c = {{
+        static_cast<uint32_t>(counter),
+        static_cast<uint32_t>(counter >> 32),
+        static_cast<uint32_t>(stream),
+        static_cast<uint32_t>(stream >> 32)
+    }};
+    uint32_t k0 = static_cast<uint32_t>(_seed);
+    uint32_t k1 = static_cast<uint32_t>(_seed >> 32);
+
+    for (int round = 0; round < 10; ++round) {
+        uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * c[0];
+        uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * c[2];
+        uint32_t hi0 = static_cast<uint32_t>(product0 >> 32);
+        uint32_t lo0 = static_cast<uint32_t>(product0);
+        uint32_t hi1 = static_cast<uint32_t>(product1 >> 32);
+        uint32_t lo1 = static_cast<uint32_t>(product1);
+
+        c = {{ hi1 ^ c[1] ^ k0, lo1, hi0 ^ c[3] ^ k1, lo0 }};
+
+        k0 += kWeyl0;
+        k1 += kWeyl1;
+    }
+
+    return c;
+}
+
+inline std::array<double, 2> PhiloxRng::uniform2(
+    uint64_t counter, uint64_t stream) const {
+    // 27 + 26 bits of each pair of the words, as genrand_res53 of mt19937
+    static const double kScale = 1.0 / 9007199254740992.0;
+
+    Block words = (*this)(counter, stream);
+    return {{
+        ((words[0] >> 5) * 67108864.0 + (words[1] >> 6)) * kScale,
+        ((words[2] >> 5) * 67108864.0 + (words[3] >> 6)) * kScale
+    }};
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_PHILOX_RNG_INL_H_
@@ -0,0 +1,39 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_POINT_CELL_LIST_SEARCHER3_INL_H_
+#define INCLUDE_JET_DETAIL_POINT_CELL_LIST_SEARCHER3_INL_H_
+
+namespace jet {
+
+template <typename Callback>
+void PointCellListSearcher3::forEachNearbyPoint(
+    const Vector3D& origin,
+    double radius,
+    const Callback& callback) const {
+    Size3 lower, upper;
+    if (!getCellRange(origin, radius, &lower, &upper)) {
+        return;
+    }
+
+    const double queryRadiusSquared = radius * radius;
+
+    for (size_t k = lower.z; k <= upper.z; ++k) {
+        for (size_t j = lower.y; j <= upper.y; ++j) {
+            // The points of the row of cells are contiguous
+            size_t rowKey = (k * _resolution.y + j) * _resolution.x;
+            size_t begin = _cellStarts[rowKey + lower.x];
+            size_t end = _cellStarts[rowKey + upper.x + 1];
+
+            for (size_t p = begin; p < end; ++p) {
+                if (_points[p].distanceSquaredTo(origin)
+                    <= queryRadiusSquared) {
+                    callback(_sortedIndices[p], _points[p]);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_POINT_CELL_LIST_SEARCHER3_INL_H_
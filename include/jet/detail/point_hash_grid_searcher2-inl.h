@@ -0,0 +1,38 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_POINT_HASH_GRID_SEARCHER2_INL_H_
+#define INCLUDE_JET_DETAIL_POINT_HASH_GRID_SEARCHER2_INL_H_
+
+namespace jet {
+
+template <typename Callback>
+void PointHashGridSearcher2::forEachNearbyPoint(
+    const Vector2D& origin,
+    double radius,
+    const Callback& callback) const {
+    if (_buckets.empty()) {
+        return;
+    }
+
+    size_t nearbyKeys[4];
+    getNearbyKeys(origin, nearbyKeys);
+
+    const double queryRadiusSquared = radius * radius;
+
+    for (int i = 0; i < 4; i++) {
+        const auto& bucket = _buckets[nearbyKeys[i]];
+        size_t numberOfPointsInBucket = bucket.size();
+
+        for (size_t j = 0; j < numberOfPointsInBucket; ++j) {
+            size_t pointIndex = bucket[j];
+            double rSquared = (_points[pointIndex] - origin).lengthSquared();
+            if (rSquared <= queryRadiusSquared) {
+                callback(pointIndex, _points[pointIndex]);
+            }
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_POINT_HASH_GRID_SEARCHER2_INL_H_
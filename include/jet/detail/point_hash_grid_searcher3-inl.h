@@ -0,0 +1,60 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_POINT_HASH_GRID_SEARCHER3_INL_H_
+#define INCLUDE_JET_DETAIL_POINT_HASH_GRID_SEARCHER3_INL_H_
+
+#include <jet/constants.h>
+
+namespace jet {
+
+template <typename Callback>
+void PointHashGridSearcher3::forEachNearbyPoint(
+    const Vector3D& origin,
+    double radius,
+    const Callback& callback) const {
+    if (_bucketOffsets.empty()) {
+        return;
+    }
+
+    size_t nearbyKeys[8];
+    const size_t numberOfNearbyKeys = getNearbyKeys(origin, nearbyKeys);
+
+    const double queryRadiusSquared = radius * radius;
+
+    for (size_t i = 0; i < numberOfNearbyKeys; ++i) {
+        forEachPointInBucket(
+            nearbyKeys[i],
+            [&](size_t pointIndex, const Vector3D& point) {
+                double rSquared = (point - origin).lengthSquared();
+                if (rSquared <= queryRadiusSquared) {
+                    callback(pointIndex, point);
+                }
+            });
+    }
+}
+
+template <typename Callback>
+void PointHashGridSearcher3::forEachPointInBucket(
+    size_t key,
+    const Callback& callback) const {
+    if (_bucketOffsets.empty()) {
+        return;
+    }
+
+    const size_t end = _bucketOffsets[key + 1];
+    for (size_t j = _bucketOffsets[key]; j < end; ++j) {
+        callback(_sortedIndices[j], _sortedPoints[j]);
+    }
+
+    if (!_addedHeads.empty()) {
+        const size_t numberOfBuiltPoints = _bucketOffsets.back();
+        for (size_t j = _addedHeads[key]; j != kMaxSize;
+             j = _addedNext[j - numberOfBuiltPoints]) {
+            callback(_sortedIndices[j], _sortedPoints[j]);
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_POINT_HASH_GRID_SEARCHER3_INL_H_
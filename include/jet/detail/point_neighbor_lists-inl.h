@@ -0,0 +1,81 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_POINT_NEIGHBOR_LISTS_INL_H_
+#define INCLUDE_JET_DETAIL_POINT_NEIGHBOR_LISTS_INL_H_
+
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/parallel.h>
+
+#include <limits>
+#include <vector>
+
+namespace jet {
+
+inline PointNeighborLists::PointNeighborLists() : _offsets(1, 0) {
+}
+
+inline size_t PointNeighborLists::size() const {
+    return _offsets.size() - 1;
+}
+
+inline bool PointNeighborLists::empty() const {
+    return size() == 0;
+}
+
+inline ConstArrayAccessor1<uint32_t> PointNeighborLists::operator[](
+    size_t i) const {
+    JET_ASSERT(i < size());
+    return ConstArrayAccessor1<uint32_t>(
+        _offsets[i + 1] - _offsets[i], _neighbors.data() + _offsets[i]);
+}
+
+inline size_t PointNeighborLists::numberOfNeighbors(size_t i) const {
+    JET_ASSERT(i < size());
+    return _offsets[i + 1] - _offsets[i];
+}
+
+inline const TrackedVector<uint32_t>& PointNeighborLists::neighbors() const {
+    return _neighbors;
+}
+
+inline const TrackedVector<size_t>& PointNeighborLists::offsets() const {
+    return _offsets;
+}
+
+inline void PointNeighborLists::clear() {
+    _neighbors.clear();
+    _offsets.resize(1);
+    _offsets[0] = 0;
+}
+
+template <typename CountFunc, typename FillFunc>
+void PointNeighborLists::build(
+    size_t numberOfPoints,
+    const CountFunc& countFunc,
+    const FillFunc& fillFunc) {
+    MemoryTagScope scope(MemoryTag::NeighborList);
+    JET_THROW_INVALID_ARG_IF(
+        numberOfPoints > std::numeric_limits<uint32_t>::max());
+
+    // Pass 1: count
+    _offsets.resize(numberOfPoints + 1);
+    _offsets[0] = 0;
+    parallelFor(kZeroSize, numberOfPoints, [&](size_t i) {
+        _offsets[i + 1] = countFunc(i);
+    });
+
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+        _offsets[i + 1] += _offsets[i];
+    }
+
+    // Pass 2: fill
+    _neighbors.resize(_offsets[numberOfPoints]);
+    parallelFor(kZeroSize, numberOfPoints, [&](size_t i) {
+        fillFunc(i, _neighbors.data() + _offsets[i]);
+    });
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_POINT_NEIGHBOR_LISTS_INL_H_
@@ -0,0 +1,42 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_POINT_PARALLEL_HASH_GRID_SEARCHER3_INL_H_
+#define INCLUDE_JET_DETAIL_POINT_PARALLEL_HASH_GRID_SEARCHER3_INL_H_
+
+#include <jet/constants.h>
+
+namespace jet {
+
+template <typename Callback>
+void PointParallelHashGridSearcher3::forEachNearbyPoint(
+    const Vector3D& origin,
+    double radius,
+    const Callback& callback) const {
+    size_t nearbyKeys[8];
+    getNearbyKeys(origin, nearbyKeys);
+
+    const double queryRadiusSquared = radius * radius;
+
+    for (int i = 0; i < 8; i++) {
+        size_t nearbyKey = nearbyKeys[i];
+        size_t start = _startIndexTable[nearbyKey];
+        size_t end = _endIndexTable[nearbyKey];
+
+        // Empty bucket -- continue to next bucket
+        if (start == kMaxSize) {
+            continue;
+        }
+
+        for (size_t j = start; j < end; ++j) {
+            Vector3D direction = _points[j] - origin;
+            double distanceSquared = direction.lengthSquared();
+            if (distanceSquared <= queryRadiusSquared) {
+                callback(_sortedIndices[j], _points[j]);
+            }
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_POINT_PARALLEL_HASH_GRID_SEARCHER3_INL_H_
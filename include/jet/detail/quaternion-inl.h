@@ -207,8 +207,8 @@ inline Vector3<T> Quaternion<T>::mul(const Vector3<T>& v) const {
 
     return Vector3<T>(
         (1 - _2yy - _2zz)*v.x + (_2xy - _2zw)*v.y + (_2xz + _2yw)*v.z,
-        (_2xy + _2zw)*v.x + (1 - _2zz - _2xx)*v.y + (_2yz + _2xw)*v.z,
-        (_2xz - _2yw)*v.x + (_2yz - _2xw)*v.y + (1 - _2yy - _2xx)*v.z);
+        (_2xy + _2zw)*v.x + (1 - _2zz - _2xx)*v.y + (_2yz - _2xw)*v.z,
+        (_2xz - _2yw)*v.x + (_2yz + _2xw)*v.y + (1 - _2yy - _2xx)*v.z);
 }
 
 template <typename T>
@@ -330,9 +330,9 @@ inline Matrix3x3<T> Quaternion<T>::matrix3() const {
     T _2zw = 2 * z * w;
 
     Matrix3x3<T> m(
-        1 - _2yy - _2zz, _2xy + _2zw, _2xz - _2yw,
-        _2xy - _2zw, 1 - _2zz - _2xx, _2yz - _2xw,
-        _2xz + _2yw, _2yz + _2xw, 1 - _2yy - _2xx);
+        1 - _2yy - _2zz, _2xy - _2zw, _2xz + _2yw,
+        _2xy + _2zw, 1 - _2zz - _2xx, _2yz - _2xw,
+        _2xz - _2yw, _2yz + _2xw, 1 - _2yy - _2xx);
 
     return m;
 }
@@ -350,9 +350,9 @@ inline Matrix4x4<T> Quaternion<T>::matrix4() const {
     T _2zw = 2 * z * w;
 
     Matrix4x4<T> m(
-        1 - _2yy - _2zz, _2xy + _2zw, _2xz - _2yw, 0,
-        _2xy - _2zw, 1 - _2zz - _2xx, _2yz - _2xw, 0,
-        _2xz + _2yw, _2yz + _2xw, 1 - _2yy - _2xx, 0,
+        1 - _2yy - _2zz, _2xy - _2zw, _2xz + _2yw, 0,
+        _2xy + _2zw, 1 - _2zz - _2xx, _2yz - _2xw, 0,
+        _2xz - _2yw, _2yz + _2xw, 1 - _2yy - _2xx, 0,
         0, 0, 0, 1);
 
     return m;
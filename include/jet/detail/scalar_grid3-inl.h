@@ -0,0 +1,343 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_SCALAR_GRID3_INL_H_
+#define INCLUDE_JET_DETAIL_SCALAR_GRID3_INL_H_
+
+#include <jet/fdm_utils.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace jet {
+
+template <typename T>
+ScalarGrid3T<T>::ScalarGrid3T() :
+    _linearSampler(
+        LinearArraySampler3<T, double>(
+            _data.constAccessor(),
+            Vector3D(1, 1, 1),
+            Vector3D())) {
+}
+
+template <typename T>
+ScalarGrid3T<T>::~ScalarGrid3T() {
+}
+
+template <typename T>
+void ScalarGrid3T<T>::clear() {
+    resize(Size3(), gridSpacing(), origin(), 0);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::resize(
+    size_t resolutionX,
+    size_t resolutionY,
+    size_t resolutionZ,
+    double gridSpacingX,
+    double gridSpacingY,
+    double gridSpacingZ,
+    double originX,
+    double originY,
+    double originZ,
+    T initialValue) {
+    resize(
+        Size3(resolutionX, resolutionY, resolutionZ),
+        Vector3D(gridSpacingX, gridSpacingY, gridSpacingZ),
+        Vector3D(originX, originY, originZ),
+        initialValue);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::resize(
+    const Size3& resolution,
+    const Vector3D& gridSpacing,
+    const Vector3D& origin,
+    T initialValue) {
+    setSizeParameters(resolution, gridSpacing, origin);
+
+    _data.mutate().resize(dataSize(), initialValue);
+    resetSampler();
+}
+
+template <typename T>
+void ScalarGrid3T<T>::resize(
+    double gridSpacingX,
+    double gridSpacingY,
+    double gridSpacingZ,
+    double originX,
+    double originY,
+    double originZ) {
+    resize(
+        Vector3D(gridSpacingX, gridSpacingY, gridSpacingZ),
+        Vector3D(originX, originY, originZ));
+}
+
+template <typename T>
+void ScalarGrid3T<T>::resize(
+    const Vector3D& gridSpacing,
+    const Vector3D& origin) {
+    resize(resolution(), gridSpacing, origin);
+}
+
+template <typename T>
+const T& ScalarGrid3T<T>::operator()(size_t i, size_t j, size_t k) const {
+    return _data(i, j, k);
+}
+
+template <typename T>
+T& ScalarGrid3T<T>::operator()(size_t i, size_t j, size_t k) {
+    return mutableData()(i, j, k);
+}
+
+template <typename T>
+Vector3D ScalarGrid3T<T>::gradientAtDataPoint(
+    size_t i, size_t j, size_t k) const {
+    return gradient3(_data.constAccessor(), gridSpacing(), i, j, k);
+}
+
+template <typename T>
+double ScalarGrid3T<T>::laplacianAtDataPoint(
+    size_t i, size_t j, size_t k) const {
+    return laplacian3(_data.constAccessor(), gridSpacing(), i, j, k);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::computeGradient(ArrayAccessor3<Vector3D> output) const {
+    const Size3 ds = dataSize();
+    const Vector3D& h = gridSpacing();
+
+    JET_ASSERT(output.size() == ds);
+
+    if (ds.x == 0) {
+        return;
+    }
+
+    const Array3<T>& data = _data.get();
+    data.parallelForEachRow([&](size_t j, size_t k) {
+        const T* row = data.row(j, k);
+        const T* down = data.row((j > 0) ? j - 1 : j, k);
+        const T* up = data.row((j + 1 < ds.y) ? j + 1 : j, k);
+        const T* back = data.row(j, (k > 0) ? k - 1 : k);
+        const T* front = data.row(j, (k + 1 < ds.z) ? k + 1 : k);
+        Vector3D* out = output.row(j, k);
+
+        for (size_t i = 0; i < ds.x; ++i) {
+            double left = row[(i > 0) ? i - 1 : i];
+            double right = row[(i + 1 < ds.x) ? i + 1 : i];
+            double dy = static_cast<double>(up[i]) - down[i];
+            double dz = static_cast<double>(front[i]) - back[i];
+            out[i] = 0.5 * Vector3D(right - left, dy, dz) / h;
+        }
+    });
+}
+
+template <typename T>
+void ScalarGrid3T<T>::computeLaplacian(ArrayAccessor3<double> output) const {
+    const Size3 ds = dataSize();
+    const Vector3D& h = gridSpacing();
+    const double hxSqr = square(h.x);
+    const double hySqr = square(h.y);
+    const double hzSqr = square(h.z);
+
+    JET_ASSERT(output.size() == ds);
+
+    if (ds.x == 0) {
+        return;
+    }
+
+    // A missing neighbor is the same as a clamped one, whose difference from
+    // the center is zero.
+    const Array3<T>& data = _data.get();
+    data.parallelForEachRow([&](size_t j, size_t k) {
+        const T* row = data.row(j, k);
+        const T* down = data.row((j > 0) ? j - 1 : j, k);
+        const T* up = data.row((j + 1 < ds.y) ? j + 1 : j, k);
+        const T* back = data.row(j, (k > 0) ? k - 1 : k);
+        const T* front = data.row(j, (k + 1 < ds.z) ? k + 1 : k);
+        double* out = output.row(j, k);
+
+        for (size_t i = 0; i < ds.x; ++i) {
+            double center = row[i];
+            double dleft = center - row[(i > 0) ? i - 1 : i];
+            double dright = row[(i + 1 < ds.x) ? i + 1 : i] - center;
+            double ddown = center - down[i];
+            double dup = up[i] - center;
+            double dback = center - back[i];
+            double dfront = front[i] - center;
+            out[i] = (dright - dleft) / hxSqr
+                + (dup - ddown) / hySqr
+                + (dfront - dback) / hzSqr;
+        }
+    });
+}
+
+template <typename T>
+double ScalarGrid3T<T>::sample(const Vector3D& x) const {
+    return _linearSampler(x);
+}
+
+template <typename T>
+std::function<double(const Vector3D&)> ScalarGrid3T<T>::sampler() const {
+    return _linearSampler.functor();
+}
+
+template <typename T>
+const LinearArraySampler3<T, double>& ScalarGrid3T<T>::linearSampler() const {
+    return _linearSampler;
+}
+
+template <typename T>
+Vector3D ScalarGrid3T<T>::gradient(const Vector3D& x) const {
+    std::array<Point3UI, 8> indices;
+    std::array<double, 8> weights;
+    _linearSampler.getCoordinatesAndWeights(x, &indices, &weights);
+
+    Vector3D result;
+
+    for (int i = 0; i < 8; ++i) {
+        result += weights[i] * gradientAtDataPoint(
+            indices[i].x, indices[i].y, indices[i].z);
+    }
+
+    return result;
+}
+
+template <typename T>
+double ScalarGrid3T<T>::laplacian(const Vector3D& x) const {
+    std::array<Point3UI, 8> indices;
+    std::array<double, 8> weights;
+    _linearSampler.getCoordinatesAndWeights(x, &indices, &weights);
+
+    double result = 0.0;
+
+    for (int i = 0; i < 8; ++i) {
+        result += weights[i]
+            * laplacianAtDataPoint(indices[i].x, indices[i].y, indices[i].z);
+    }
+
+    return result;
+}
+
+template <typename T>
+typename ScalarGrid3T<T>::ScalarDataAccessor ScalarGrid3T<T>::dataAccessor() {
+    return mutableData().accessor();
+}
+
+template <typename T>
+typename ScalarGrid3T<T>::ConstScalarDataAccessor
+ScalarGrid3T<T>::constDataAccessor() const {
+    return _data.constAccessor();
+}
+
+template <typename T>
+typename ScalarGrid3T<T>::DataPositionFunc
+ScalarGrid3T<T>::dataPosition() const {
+    Vector3D o = dataOrigin();
+    return [this, o](size_t i, size_t j, size_t k) -> Vector3D {
+        return o + gridSpacing() * Vector3D({i, j, k});
+    };
+}
+
+template <typename T>
+void ScalarGrid3T<T>::fill(T value) {
+    ScalarDataAccessor data = dataAccessor();
+    parallelFor(
+        kZeroSize, data.width(),
+        kZeroSize, data.height(),
+        kZeroSize, data.depth(),
+        [&data, value](size_t i, size_t j, size_t k) {
+            data(i, j, k) = value;
+        });
+}
+
+template <typename T>
+void ScalarGrid3T<T>::fill(const std::function<double(const Vector3D&)>& func) {
+    DataPositionFunc pos = dataPosition();
+    ScalarDataAccessor data = dataAccessor();
+    parallelFor(
+        kZeroSize, data.width(),
+        kZeroSize, data.height(),
+        kZeroSize, data.depth(),
+        [&data, &func, &pos](size_t i, size_t j, size_t k) {
+            data(i, j, k) = static_cast<T>(func(pos(i, j, k)));
+        });
+}
+
+template <typename T>
+void ScalarGrid3T<T>::forEachDataPointIndex(
+    const std::function<void(size_t, size_t, size_t)>& func) const {
+    _data.get().forEachIndex(func);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::parallelForEachDataPointIndex(
+    const std::function<void(size_t, size_t, size_t)>& func) const {
+    _data.get().parallelForEachIndex(func);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::forEachDataPointRow(
+    const std::function<void(size_t, size_t)>& func) const {
+    _data.get().forEachRow(func);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::parallelForEachDataPointRow(
+    const std::function<void(size_t, size_t)>& func) const {
+    _data.get().parallelForEachRow(func);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::serialize(std::ostream* strm) const {
+    serializeGrid(strm);
+    _data.get().serialize(strm);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::deserialize(std::istream* strm) {
+    deserializeGrid(strm);
+    _data.mutate().deserialize(strm);
+
+    resetSampler();
+}
+
+template <typename T>
+void ScalarGrid3T<T>::swapScalarGrid(ScalarGrid3T* other) {
+    swapGrid(other);
+
+    _data.swap(other->_data);
+    std::swap(_linearSampler, other->_linearSampler);
+}
+
+template <typename T>
+void ScalarGrid3T<T>::setScalarGrid(const ScalarGrid3T& other) {
+    setGrid(other);
+
+    _data = other._data;
+    resetSampler();
+}
+
+template <typename T>
+Array3<T>& ScalarGrid3T<T>::mutableData() {
+    return _data.mutate([this] { resetSampler(); });
+}
+
+template <typename T>
+void ScalarGrid3T<T>::resetSampler() {
+    _linearSampler = LinearArraySampler3<T, double>(
+        _data.constAccessor(), gridSpacing(), dataOrigin());
+}
+
+template <typename T>
+ScalarGridBuilder3T<T>::ScalarGridBuilder3T() {
+}
+
+template <typename T>
+ScalarGridBuilder3T<T>::~ScalarGridBuilder3T() {
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_SCALAR_GRID3_INL_H_
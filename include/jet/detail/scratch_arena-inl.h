@@ -0,0 +1,51 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_SCRATCH_ARENA_INL_H_
+#define INCLUDE_JET_DETAIL_SCRATCH_ARENA_INL_H_
+
+#include <jet/macros.h>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace jet {
+
+template <typename T>
+T* ScratchArena::allocateAndFill(size_t n, const T& initVal) {
+    static_assert(
+        std::is_trivially_destructible<T>::value,
+        "Scratch buffers are never destroyed.");
+    static_assert(
+        alignof(T) <= kScratchAlignment,
+        "Over-aligned types are not supported.");
+
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+        throw std::bad_alloc();
+    }
+
+    T* data = static_cast<T*>(allocate(n * sizeof(T)));
+    std::uninitialized_fill_n(data, n, initVal);
+    return data;
+}
+
+template <typename T>
+ArrayAccessor1<T> ScratchArena::array1(size_t size, const T& initVal) {
+    return ArrayAccessor1<T>(size, allocateAndFill(size, initVal));
+}
+
+template <typename T>
+ArrayAccessor2<T> ScratchArena::array2(const Size2& size, const T& initVal) {
+    return ArrayAccessor2<T>(
+        size, allocateAndFill(size.x * size.y, initVal));
+}
+
+template <typename T>
+ArrayAccessor3<T> ScratchArena::array3(const Size3& size, const T& initVal) {
+    return ArrayAccessor3<T>(
+        size, allocateAndFill(size.x * size.y * size.z, initVal));
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_SCRATCH_ARENA_INL_H_
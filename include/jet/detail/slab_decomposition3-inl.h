@@ -0,0 +1,52 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_SLAB_DECOMPOSITION3_INL_H_
+#define INCLUDE_JET_DETAIL_SLAB_DECOMPOSITION3_INL_H_
+
+#include <jet/macros.h>
+#include <type_traits>
+
+namespace jet {
+
+template <typename T>
+void SlabDecomposition3::exchangeGhostLayers(
+    const Array3<T>& local,
+    Array2<T>* backGhost,
+    Array2<T>* frontGhost) const {
+    static_assert(
+        std::is_trivially_copyable<T>::value,
+        "Ghost layers are sent as bytes.");
+
+    const Size3 size = localSize();
+    JET_THROW_INVALID_ARG_IF(local.size() != size);
+
+    backGhost->resize(size.x, size.y);
+    frontGhost->resize(size.x, size.y);
+    backGhost->set(T());
+    frontGhost->set(T());
+
+    const size_t layerSize = size.x * size.y;
+    const size_t layerBytes = layerSize * sizeof(T);
+
+    // First layer goes backward while the front ghost comes from the next rank
+    _communicator->sendReceive(
+        local.data(),
+        layerBytes,
+        previousRank(),
+        frontGhost->data(),
+        layerBytes,
+        nextRank());
+
+    // Last layer goes forward while the back ghost comes from the previous rank
+    _communicator->sendReceive(
+        local.data() + (size.z - 1) * layerSize,
+        layerBytes,
+        nextRank(),
+        backGhost->data(),
+        layerBytes,
+        previousRank());
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_SLAB_DECOMPOSITION3_INL_H_
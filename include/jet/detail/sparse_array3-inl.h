@@ -0,0 +1,239 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_SPARSE_ARRAY3_INL_H_
+#define INCLUDE_JET_DETAIL_SPARSE_ARRAY3_INL_H_
+
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/parallel.h>
+#include <algorithm>
+#include <vector>
+
+namespace jet {
+
+template <typename T>
+const size_t SparseArray3<T>::kBrickSize;
+
+template <typename T>
+const size_t SparseArray3<T>::kBrickVolume;
+
+template <typename T>
+SparseArray3<T>::SparseArray3() {
+}
+
+template <typename T>
+SparseArray3<T>::SparseArray3(const Size3& size, const T& backgroundValue) {
+    resize(size, backgroundValue);
+}
+
+template <typename T>
+SparseArray3<T>::SparseArray3(
+    size_t width,
+    size_t height,
+    size_t depth,
+    const T& backgroundValue) {
+    resize(width, height, depth, backgroundValue);
+}
+
+template <typename T>
+void SparseArray3<T>::resize(const Size3& size, const T& backgroundValue) {
+    _size = size;
+    _backgroundValue = backgroundValue;
+    _brickIndices.resize(
+        (size.x + kBrickSize - 1) / kBrickSize,
+        (size.y + kBrickSize - 1) / kBrickSize,
+        (size.z + kBrickSize - 1) / kBrickSize);
+    clear();
+}
+
+template <typename T>
+void SparseArray3<T>::resize(
+    size_t width,
+    size_t height,
+    size_t depth,
+    const T& backgroundValue) {
+    resize(Size3(width, height, depth), backgroundValue);
+}
+
+template <typename T>
+void SparseArray3<T>::clear() {
+    _brickIndices.set(kMaxSize);
+    _brickOrigins.clear();
+    _data.clear();
+}
+
+template <typename T>
+void SparseArray3<T>::set(
+    const ConstArrayAccessor3<T>& dense,
+    const T& backgroundValue) {
+    resize(dense.size(), backgroundValue);
+
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (dense(i, j, k) != _backgroundValue) {
+            (*this)(i, j, k) = dense(i, j, k);
+        }
+    });
+}
+
+template <typename T>
+void SparseArray3<T>::copyTo(Array3<T>* dense) const {
+    dense->resize(_size);
+    dense->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*dense)(i, j, k) = (*this)(i, j, k);
+    });
+}
+
+template <typename T>
+Size3 SparseArray3<T>::size() const {
+    return _size;
+}
+
+template <typename T>
+size_t SparseArray3<T>::width() const {
+    return _size.x;
+}
+
+template <typename T>
+size_t SparseArray3<T>::height() const {
+    return _size.y;
+}
+
+template <typename T>
+size_t SparseArray3<T>::depth() const {
+    return _size.z;
+}
+
+template <typename T>
+const T& SparseArray3<T>::backgroundValue() const {
+    return _backgroundValue;
+}
+
+template <typename T>
+size_t SparseArray3<T>::numberOfBricks() const {
+    return _brickOrigins.size();
+}
+
+template <typename T>
+bool SparseArray3<T>::isAllocated(size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+
+    return _brickIndices(i / kBrickSize, j / kBrickSize, k / kBrickSize)
+        != kMaxSize;
+}
+
+template <typename T>
+const T& SparseArray3<T>::operator()(size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+
+    size_t brick
+        = _brickIndices(i / kBrickSize, j / kBrickSize, k / kBrickSize);
+    if (brick == kMaxSize) {
+        return _backgroundValue;
+    }
+
+    return _data[brick * kBrickVolume + localIndex(i, j, k)];
+}
+
+template <typename T>
+T& SparseArray3<T>::operator()(size_t i, size_t j, size_t k) {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+
+    size_t bi = i / kBrickSize;
+    size_t bj = j / kBrickSize;
+    size_t bk = k / kBrickSize;
+    size_t brick = _brickIndices(bi, bj, bk);
+    if (brick == kMaxSize) {
+        brick = allocateBrick(bi, bj, bk);
+    }
+
+    return _data[brick * kBrickVolume + localIndex(i, j, k)];
+}
+
+template <typename T>
+template <typename Callback>
+void SparseArray3<T>::forEachAllocatedIndex(Callback func) const {
+    for (size_t brick = 0; brick < _brickOrigins.size(); ++brick) {
+        forEachIndexInBrick(brick, func);
+    }
+}
+
+template <typename T>
+template <typename Callback>
+void SparseArray3<T>::parallelForEachAllocatedIndex(Callback func) const {
+    parallelFor(
+        kZeroSize,
+        _brickOrigins.size(),
+        [&](size_t brick) {
+            forEachIndexInBrick(brick, func);
+        });
+}
+
+template <typename T>
+void SparseArray3<T>::prune() {
+    std::vector<Size3> brickOrigins;
+    std::vector<T> data;
+
+    for (size_t brick = 0; brick < _brickOrigins.size(); ++brick) {
+        auto begin = _data.begin() + brick * kBrickVolume;
+        auto end = begin + kBrickVolume;
+        const Size3& origin = _brickOrigins[brick];
+        size_t& index = _brickIndices(
+            origin.x / kBrickSize,
+            origin.y / kBrickSize,
+            origin.z / kBrickSize);
+
+        bool isBackground = std::all_of(begin, end, [&](const T& value) {
+            return value == _backgroundValue;
+        });
+
+        if (isBackground) {
+            index = kMaxSize;
+        } else {
+            index = brickOrigins.size();
+            brickOrigins.push_back(origin);
+            data.insert(data.end(), begin, end);
+        }
+    }
+
+    _brickOrigins.swap(brickOrigins);
+    _data.swap(data);
+}
+
+template <typename T>
+size_t SparseArray3<T>::allocateBrick(size_t bi, size_t bj, size_t bk) {
+    size_t brick = _brickOrigins.size();
+    _brickIndices(bi, bj, bk) = brick;
+    _brickOrigins.push_back(
+        Size3(bi * kBrickSize, bj * kBrickSize, bk * kBrickSize));
+    _data.resize(_data.size() + kBrickVolume, _backgroundValue);
+    return brick;
+}
+
+template <typename T>
+template <typename Callback>
+void SparseArray3<T>::forEachIndexInBrick(
+    size_t brick,
+    Callback func) const {
+    const Size3& origin = _brickOrigins[brick];
+    size_t iEnd = std::min(origin.x + kBrickSize, _size.x);
+    size_t jEnd = std::min(origin.y + kBrickSize, _size.y);
+    size_t kEnd = std::min(origin.z + kBrickSize, _size.z);
+
+    for (size_t k = origin.z; k < kEnd; ++k) {
+        for (size_t j = origin.y; j < jEnd; ++j) {
+            for (size_t i = origin.x; i < iEnd; ++i) {
+                func(i, j, k);
+            }
+        }
+    }
+}
+
+template <typename T>
+size_t SparseArray3<T>::localIndex(size_t i, size_t j, size_t k) {
+    return i % kBrickSize
+        + kBrickSize * (j % kBrickSize + kBrickSize * (k % kBrickSize));
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_SPARSE_ARRAY3_INL_H_
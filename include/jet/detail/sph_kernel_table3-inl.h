@@ -0,0 +1,82 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_SPH_KERNEL_TABLE3_INL_H_
+#define INCLUDE_JET_DETAIL_SPH_KERNEL_TABLE3_INL_H_
+
+#include <jet/macros.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace jet {
+
+template <typename KernelType>
+const size_t SphKernelTable3<KernelType>::kDefaultResolution;
+
+template <typename KernelType>
+SphKernelTable3<KernelType>::SphKernelTable3() {
+}
+
+template <typename KernelType>
+SphKernelTable3<KernelType>::SphKernelTable3(
+    const KernelType& kernel,
+    size_t resolution) :
+    _kernel(kernel),
+    _h2(kernel.h * kernel.h) {
+    JET_THROW_INVALID_ARG_IF(resolution == 0 || !(kernel.h > 0.0));
+
+    const double intervalSize = _h2 / resolution;
+    _invIntervalSize = 1.0 / intervalSize;
+
+    // One more sample past h^2 keeps the interpolation of the last interval
+    // within the table
+    _values.resize(resolution + 2);
+    _gradientScales.resize(resolution + 2);
+    for (size_t i = 0; i < resolution + 2; ++i) {
+        // The gradient scale at the center is sampled slightly off, where
+        // -W'(r) / r of a smooth kernel has already converged
+        double distanceSquared
+            = ((i > 0) ? i : 1e-6) * intervalSize;
+        double distance = std::sqrt(distanceSquared);
+        _values[i] = kernel((i > 0) ? distance : 0.0);
+        _gradientScales[i] = -kernel.firstDerivative(distance) / distance;
+    }
+}
+
+template <typename KernelType>
+const KernelType& SphKernelTable3<KernelType>::kernel() const {
+    return _kernel;
+}
+
+template <typename KernelType>
+size_t SphKernelTable3<KernelType>::resolution() const {
+    return _values.empty() ? 0 : _values.size() - 2;
+}
+
+template <typename KernelType>
+double SphKernelTable3<KernelType>::operator()(double distanceSquared) const {
+    return lookUp(_values, distanceSquared);
+}
+
+template <typename KernelType>
+double SphKernelTable3<KernelType>::gradientScale(
+    double distanceSquared) const {
+    return lookUp(_gradientScales, distanceSquared);
+}
+
+template <typename KernelType>
+double SphKernelTable3<KernelType>::lookUp(
+    const std::vector<double>& table, double distanceSquared) const {
+    if (!(distanceSquared < _h2)) {
+        return 0.0;
+    }
+
+    double x = std::max(distanceSquared, 0.0) * _invIntervalSize;
+    size_t i = static_cast<size_t>(x);
+    double t = x - static_cast<double>(i);
+    return table[i] + t * (table[i + 1] - table[i]);
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_SPH_KERNEL_TABLE3_INL_H_
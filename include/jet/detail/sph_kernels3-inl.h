@@ -13,20 +13,32 @@
 namespace jet {
 
 inline SphStdKernel3::SphStdKernel3()
-    : h(0), h2(0), h3(0), h5(0) {}
+    : h(0), h2(0), h3(0), h5(0),
+      invH2(0), valueFactor(0), derivativeFactor(0) {}
 
 inline SphStdKernel3::SphStdKernel3(double kernelRadius)
-    : h(kernelRadius), h2(h * h), h3(h2 * h), h5(h2 * h3) {}
+    : h(kernelRadius), h2(h * h), h3(h2 * h), h5(h2 * h3),
+      invH2(1.0 / h2),
+      valueFactor(315.0 / (64.0 * kPiD * h3)),
+      derivativeFactor(945.0 / (32.0 * kPiD * h5)) {}
 
 inline SphStdKernel3::SphStdKernel3(const SphStdKernel3& other)
-    : h(other.h), h2(other.h2), h3(other.h3), h5(other.h5) {}
+    : h(other.h), h2(other.h2), h3(other.h3), h5(other.h5),
+      invH2(other.invH2),
+      valueFactor(other.valueFactor),
+      derivativeFactor(other.derivativeFactor) {}
 
 inline double SphStdKernel3::operator()(double distance) const {
-    if (distance * distance >= h2) {
+    return valueFromSquaredDistance(distance * distance);
+}
+
+inline double SphStdKernel3::valueFromSquaredDistance(
+    double distanceSquared) const {
+    if (distanceSquared >= h2) {
         return 0.0;
     } else {
-        double x = 1.0 - distance * distance / h2;
-        return 315.0 / (64.0 * kPiD * h3) * x * x * x;
+        double x = 1.0 - distanceSquared * invH2;
+        return valueFactor * x * x * x;
     }
 }
 
@@ -34,8 +46,8 @@ inline double SphStdKernel3::firstDerivative(double distance) const {
     if (distance >= h) {
         return 0.0;
     } else {
-        double x = 1.0 - distance * distance / h2;
-        return -945.0 / (32.0 * kPiD * h5) * distance * x * x;
+        double x = 1.0 - distance * distance * invH2;
+        return -derivativeFactor * distance * x * x;
     }
 }
 
@@ -49,26 +61,36 @@ inline double SphStdKernel3::secondDerivative(double distance) const {
     if (distance * distance >= h2) {
         return 0.0;
     } else {
-        double x = distance * distance / h2;
-        return 945.0 / (32.0 * kPiD * h5) * (1 - x) * (3 * x - 1);
+        double x = distance * distance * invH2;
+        return derivativeFactor * (1 - x) * (5 * x - 1);
     }
 }
 
 inline SphSpikyKernel3::SphSpikyKernel3()
-    : h(0), h2(0), h3(0), h4(0), h5(0) {}
+    : h(0), h2(0), h3(0), h4(0), h5(0),
+      invH(0), valueFactor(0), firstDerivativeFactor(0),
+      secondDerivativeFactor(0) {}
 
 inline SphSpikyKernel3::SphSpikyKernel3(double h_)
-    : h(h_), h2(h * h), h3(h2 * h), h4(h2 * h2), h5(h3 * h2) {}
+    : h(h_), h2(h * h), h3(h2 * h), h4(h2 * h2), h5(h3 * h2),
+      invH(1.0 / h),
+      valueFactor(15.0 / (kPiD * h3)),
+      firstDerivativeFactor(45.0 / (kPiD * h4)),
+      secondDerivativeFactor(90.0 / (kPiD * h5)) {}
 
 inline SphSpikyKernel3::SphSpikyKernel3(const SphSpikyKernel3& other)
-    : h(other.h), h2(other.h2), h3(other.h3), h4(other.h4), h5(other.h5) {}
+    : h(other.h), h2(other.h2), h3(other.h3), h4(other.h4), h5(other.h5),
+      invH(other.invH),
+      valueFactor(other.valueFactor),
+      firstDerivativeFactor(other.firstDerivativeFactor),
+      secondDerivativeFactor(other.secondDerivativeFactor) {}
 
 inline double SphSpikyKernel3::operator()(double distance) const {
     if (distance >= h) {
         return 0.0;
     } else {
-        double x = 1.0 - distance / h;
-        return 15.0 / (kPiD * h3) * x * x * x;
+        double x = 1.0 - distance * invH;
+        return valueFactor * x * x * x;
     }
 }
 
@@ -76,8 +98,8 @@ inline double SphSpikyKernel3::firstDerivative(double distance) const {
     if (distance >= h) {
         return 0.0;
     } else {
-        double x = 1.0 - distance / h;
-        return -45.0 / (kPiD * h4) * x * x;
+        double x = 1.0 - distance * invH;
+        return -firstDerivativeFactor * x * x;
     }
 }
 
@@ -91,8 +113,99 @@ inline double SphSpikyKernel3::secondDerivative(double distance) const {
     if (distance >= h) {
         return 0.0;
     } else {
-        double x = 1.0 - distance / h;
-        return 90.0 / (kPiD * h5) * x;
+        double x = 1.0 - distance * invH;
+        return secondDerivativeFactor * x;
+    }
+}
+
+inline SphCubicSplineKernel3::SphCubicSplineKernel3()
+    : h(0), invH(0), valueFactor(0) {}
+
+inline SphCubicSplineKernel3::SphCubicSplineKernel3(double kernelRadius)
+    : h(kernelRadius), invH(1.0 / h), valueFactor(8.0 / (kPiD * h * h * h)) {}
+
+inline double SphCubicSplineKernel3::operator()(double distance) const {
+    double q = distance * invH;
+    if (q >= 1.0) {
+        return 0.0;
+    } else if (q <= 0.5) {
+        return valueFactor * (6.0 * q * q * (q - 1.0) + 1.0);
+    } else {
+        double x = 1.0 - q;
+        return valueFactor * 2.0 * x * x * x;
+    }
+}
+
+inline double SphCubicSplineKernel3::firstDerivative(double distance) const {
+    double q = distance * invH;
+    if (q >= 1.0) {
+        return 0.0;
+    } else if (q <= 0.5) {
+        return valueFactor * invH * 6.0 * q * (3.0 * q - 2.0);
+    } else {
+        double x = 1.0 - q;
+        return -valueFactor * invH * 6.0 * x * x;
+    }
+}
+
+inline Vector3D SphCubicSplineKernel3::gradient(
+    double distance,
+    const Vector3D& directionToCenter) const {
+    return -firstDerivative(distance) * directionToCenter;
+}
+
+inline double SphCubicSplineKernel3::secondDerivative(double distance) const {
+    double q = distance * invH;
+    if (q >= 1.0) {
+        return 0.0;
+    } else if (q <= 0.5) {
+        return valueFactor * invH * invH * 12.0 * (3.0 * q - 1.0);
+    } else {
+        return valueFactor * invH * invH * 12.0 * (1.0 - q);
+    }
+}
+
+inline SphWendlandKernel3::SphWendlandKernel3()
+    : h(0), invH(0), valueFactor(0) {}
+
+inline SphWendlandKernel3::SphWendlandKernel3(double kernelRadius)
+    : h(kernelRadius), invH(1.0 / h),
+      valueFactor(21.0 / (2.0 * kPiD * h * h * h)) {}
+
+inline double SphWendlandKernel3::operator()(double distance) const {
+    double q = distance * invH;
+    if (q >= 1.0) {
+        return 0.0;
+    } else {
+        double x = 1.0 - q;
+        double x2 = x * x;
+        return valueFactor * x2 * x2 * (1.0 + 4.0 * q);
+    }
+}
+
+inline double SphWendlandKernel3::firstDerivative(double distance) const {
+    double q = distance * invH;
+    if (q >= 1.0) {
+        return 0.0;
+    } else {
+        double x = 1.0 - q;
+        return -valueFactor * invH * 20.0 * q * x * x * x;
+    }
+}
+
+inline Vector3D SphWendlandKernel3::gradient(
+    double distance,
+    const Vector3D& directionToCenter) const {
+    return -firstDerivative(distance) * directionToCenter;
+}
+
+inline double SphWendlandKernel3::secondDerivative(double distance) const {
+    double q = distance * invH;
+    if (q >= 1.0) {
+        return 0.0;
+    } else {
+        double x = 1.0 - q;
+        return -valueFactor * invH * invH * 20.0 * x * x * (1.0 - 4.0 * q);
     }
 }
 
@@ -0,0 +1,118 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_DETAIL_VERTEX_CENTERED_SCALAR_GRID3_INL_H_
+#define INCLUDE_JET_DETAIL_VERTEX_CENTERED_SCALAR_GRID3_INL_H_
+
+#include <memory>
+
+namespace jet {
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>::VertexCenteredScalarGrid3T() {
+}
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>::VertexCenteredScalarGrid3T(
+    size_t resolutionX,
+    size_t resolutionY,
+    size_t resolutionZ,
+    double gridSpacingX,
+    double gridSpacingY,
+    double gridSpacingZ,
+    double originX,
+    double originY,
+    double originZ,
+    T initialValue) {
+    this->resize(
+        resolutionX,
+        resolutionY,
+        resolutionZ,
+        gridSpacingX,
+        gridSpacingY,
+        gridSpacingZ,
+        originX,
+        originY,
+        originZ,
+        initialValue);
+}
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>::VertexCenteredScalarGrid3T(
+    const Size3& resolution,
+    const Vector3D& gridSpacing,
+    const Vector3D& origin,
+    T initialValue) {
+    this->resize(resolution, gridSpacing, origin, initialValue);
+}
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>::VertexCenteredScalarGrid3T(
+    const VertexCenteredScalarGrid3T& other) {
+    set(other);
+}
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>::VertexCenteredScalarGrid3T(
+    VertexCenteredScalarGrid3T&& other) {
+    this->swapScalarGrid(&other);
+}
+
+template <typename T>
+Size3 VertexCenteredScalarGrid3T<T>::dataSize() const {
+    if (this->resolution() != Size3(0, 0, 0)) {
+        return this->resolution() + Size3(1, 1, 1);
+    } else {
+        return Size3(0, 0, 0);
+    }
+}
+
+template <typename T>
+Vector3D VertexCenteredScalarGrid3T<T>::dataOrigin() const {
+    return this->origin();
+}
+
+template <typename T>
+std::shared_ptr<ScalarGrid3T<T>>
+VertexCenteredScalarGrid3T<T>::clone() const {
+    return std::make_shared<VertexCenteredScalarGrid3T>(*this);
+}
+
+template <typename T>
+void VertexCenteredScalarGrid3T<T>::swap(Grid3* other) {
+    VertexCenteredScalarGrid3T* sameType
+        = dynamic_cast<VertexCenteredScalarGrid3T*>(other);
+    if (sameType != nullptr) {
+        this->swapScalarGrid(sameType);
+    }
+}
+
+template <typename T>
+void VertexCenteredScalarGrid3T<T>::set(
+    const VertexCenteredScalarGrid3T& other) {
+    this->setScalarGrid(other);
+}
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>&
+VertexCenteredScalarGrid3T<T>::operator=(
+    const VertexCenteredScalarGrid3T& other) {
+    set(other);
+    return *this;
+}
+
+template <typename T>
+VertexCenteredScalarGrid3T<T>&
+VertexCenteredScalarGrid3T<T>::operator=(VertexCenteredScalarGrid3T&& other) {
+    this->swapScalarGrid(&other);
+    return *this;
+}
+
+template <typename T>
+std::shared_ptr<ScalarGridBuilder3T<T>>
+VertexCenteredScalarGrid3T<T>::builder() {
+    return std::make_shared<VertexCenteredScalarGridBuilder3T<T>>();
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_VERTEX_CENTERED_SCALAR_GRID3_INL_H_
@@ -0,0 +1,136 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_ERROR_CORRECTED_SEMI_LAGRANGIAN3_H_
+#define INCLUDE_JET_ERROR_CORRECTED_SEMI_LAGRANGIAN3_H_
+
+#include <jet/scratch_arena.h>
+#include <jet/semi_lagrangian3.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Abstract base class for 3-D semi-Lagrangian advection solvers with
+//! error correction.
+//!
+//! This class runs the linear semi-Lagrangian advection forward and backward
+//! in time to estimate the error of the scheme and to correct it, as
+//! MacCormackAdvection3 and BfeccAdvection3 do. The points traced backward
+//! and forward in time from the data points are computed once per data
+//! layout and call, and shared by all grids of that layout, including the
+//! channels of the batched advection. The traced points and the intermediate
+//! fields are taken from a scratch arena, so the buffers are reused between
+//! the time-steps. Each call takes its own arena from a pool, so independent
+//! grids can be advected by the same solver from multiple threads. The
+//! optional limiter (on by default) clamps each result to the range of the
+//! input values around its source point, which removes the overshoots of the
+//! correction.
+//!
+//! The grids whose input and output data layouts differ are advected by the
+//! plain semi-Lagrangian method.
+//!
+//! \see Selle, Andrew, et al. "An unconditionally stable MacCormack method."
+//!     Journal of Scientific Computing 35.2 (2008): 350-371.
+//!
+class ErrorCorrectedSemiLagrangian3 : public AdvectionSolver3 {
+ public:
+    virtual ~ErrorCorrectedSemiLagrangian3();
+
+    //! Computes the corrected advection of the given scalar grid.
+    void advect(
+        const ScalarGrid3& input,
+        const VectorField3& flow,
+        double dt,
+        ScalarGrid3* output,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(std::numeric_limits<double>::max())) final;
+
+    //! Computes the corrected advection of the given collocated vector grid.
+    void advect(
+        const CollocatedVectorGrid3& input,
+        const VectorField3& flow,
+        double dt,
+        CollocatedVectorGrid3* output,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(std::numeric_limits<double>::max())) final;
+
+    //!
+    //! \brief Computes the corrected advection of the given face-centered
+    //! vector grid.
+    //!
+    //! The u, v, and w data are advected one after another, each with the
+    //! points traced from its own data positions.
+    //!
+    void advect(
+        const FaceCenteredGrid3& input,
+        const VectorField3& flow,
+        double dt,
+        FaceCenteredGrid3* output,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(std::numeric_limits<double>::max())) final;
+
+    //!
+    //! \brief Computes the corrected advection of multiple collocated grids.
+    //!
+    //! The grids are grouped by their data layout, and the points are traced
+    //! once per group. The result is the same as advecting each grid
+    //! separately.
+    //!
+    void advect(
+        const std::vector<const ScalarGrid3*>& scalarInputs,
+        const std::vector<const CollocatedVectorGrid3*>& vectorInputs,
+        const VectorField3& flow,
+        double dt,
+        const std::vector<ScalarGrid3*>& scalarOutputs,
+        const std::vector<CollocatedVectorGrid3*>& vectorOutputs,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(std::numeric_limits<double>::max())) final;
+
+    //! Returns true if the results are clamped to the local input range.
+    bool isUsingLimiter() const;
+
+    //! Sets true to clamp the results to the local input range.
+    void setIsUsingLimiter(bool isUsing);
+
+ protected:
+    //! Error correction schemes.
+    enum class Scheme {
+        //! Corrects the forward result by half the round-trip error.
+        MacCormack,
+
+        //! Advects the input corrected by half the round-trip error.
+        Bfecc
+    };
+
+    //! Constructs a solver with given error correction scheme.
+    explicit ErrorCorrectedSemiLagrangian3(Scheme scheme);
+
+ private:
+    Scheme _scheme;
+    bool _isUsingLimiter = true;
+    SemiLagrangian3 _semiLagrangian;
+    std::vector<std::unique_ptr<ScratchArena>> _scratches;
+    std::mutex _scratchMutex;
+
+    std::unique_ptr<ScratchArena> acquireScratch();
+
+    void releaseScratch(std::unique_ptr<ScratchArena> scratch);
+
+    void advectGroup(
+        const std::vector<ConstArrayAccessor3<double>>& scalarInputs,
+        const std::vector<ConstArrayAccessor3<Vector3D>>& vectorInputs,
+        const std::vector<ArrayAccessor3<double>>& scalarOutputs,
+        const std::vector<ArrayAccessor3<Vector3D>>& vectorOutputs,
+        const Size3& dataSize,
+        const Vector3D& dataOrigin,
+        const Vector3D& gridSpacing,
+        const VectorField3& flow,
+        double dt,
+        const ScalarField3& boundarySdf);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_ERROR_CORRECTED_SEMI_LAGRANGIAN3_H_
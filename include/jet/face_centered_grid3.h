@@ -5,6 +5,7 @@
 
 #include <jet/array3.h>
 #include <jet/array_samplers3.h>
+#include <jet/copy_on_write_array3.h>
 #include <jet/vector_grid3.h>
 #include <memory>
 #include <utility>  // just make cpplint happy..
@@ -18,6 +19,11 @@ namespace jet {
 //! marker-and-cell (MAC) or staggered grid. This vector grid stores each vector
 //! component at face center. Thus, u, v, and w components are not collocated.
 //!
+//! Copies and clones of a grid share each component until it is written
+//! through the non-const accessors, fill(), or resize(), so only the
+//! components that change get duplicated. An accessor from uAccessor(),
+//! vAccessor(), or wAccessor() should not be kept across such a copy.
+//!
 class FaceCenteredGrid3 final : public VectorGrid3 {
  public:
     //! Read-write scalar data accessor type.
@@ -95,6 +101,24 @@ class FaceCenteredGrid3 final : public VectorGrid3 {
     //! Returns curl at cell-center location.
     Vector3D curlAtCellCenter(size_t i, size_t j, size_t k) const;
 
+    //!
+    //! \brief Computes the divergence at every cell center into \p output.
+    //!
+    //! The result is the same as divergenceAtCellCenter. The rows along x are
+    //! processed in parallel, reading the face rows through pointers. The
+    //! size of \p output should be the resolution.
+    //!
+    void computeDivergence(ArrayAccessor3<double> output) const;
+
+    //!
+    //! \brief Computes the curl at every cell center into \p output.
+    //!
+    //! The result is the same as curlAtCellCenter. The neighboring rows are
+    //! resolved once per row, and the boundary clamping is only applied at
+    //! the ends of the row. The size of \p output should be the resolution.
+    //!
+    void computeCurl(ArrayAccessor3<Vector3D> output) const;
+
     //! Returns u data accessor.
     ScalarDataAccessor uAccessor();
 
@@ -241,6 +265,11 @@ class FaceCenteredGrid3 final : public VectorGrid3 {
     //! Returns sampled value at given position \p x.
     Vector3D sample(const Vector3D& x) const override;
 
+    //! Samples the positions \p x with the inlined linear sampler.
+    void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<Vector3D> result) const override;
+
     //! Returns divergence at given position \p x.
     double divergence(const Vector3D& x) const override;
 
@@ -255,6 +284,21 @@ class FaceCenteredGrid3 final : public VectorGrid3 {
     //!
     std::function<Vector3D(const Vector3D&)> sampler() const override;
 
+    //!
+    //! \brief Returns the linear sampler of the u-data.
+    //!
+    //! Unlike sampler(), the returned object can be inlined into the caller's
+    //! loop. It refers to the data of this grid, so it is invalidated when the
+    //! grid is resized.
+    //!
+    const LinearArraySampler3<double, double>& uLinearSampler() const;
+
+    //! Returns the linear sampler of the v-data.
+    const LinearArraySampler3<double, double>& vLinearSampler() const;
+
+    //! Returns the linear sampler of the w-data.
+    const LinearArraySampler3<double, double>& wLinearSampler() const;
+
     //! Returns the grid builder instance.
     static VectorGridBuilder3Ptr builder();
 
@@ -267,16 +311,17 @@ class FaceCenteredGrid3 final : public VectorGrid3 {
         const Vector3D& initialValue) final;
 
  private:
-    Array3<double> _dataU;
-    Array3<double> _dataV;
-    Array3<double> _dataW;
+    CopyOnWriteArray3<double> _dataU;
+    CopyOnWriteArray3<double> _dataV;
+    CopyOnWriteArray3<double> _dataW;
     Vector3D _dataOriginU;
     Vector3D _dataOriginV;
     Vector3D _dataOriginW;
     LinearArraySampler3<double, double> _uLinearSampler;
     LinearArraySampler3<double, double> _vLinearSampler;
     LinearArraySampler3<double, double> _wLinearSampler;
-    std::function<Vector3D(const Vector3D&)> _sampler;
+
+    Array3<double>& mutableData(CopyOnWriteArray3<double>* data);
 
     void resetSampler();
 };
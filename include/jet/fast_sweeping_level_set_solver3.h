@@ -0,0 +1,113 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FAST_SWEEPING_LEVEL_SET_SOLVER3_H_
+#define INCLUDE_JET_FAST_SWEEPING_LEVEL_SET_SOLVER3_H_
+
+#include <jet/array3.h>
+#include <jet/level_set_solver3.h>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Three-dimensional fast sweeping method (FSM) implementation.
+//!
+//! This class solves the same first-order upwind discretization as
+//! FmmLevelSetSolver3, but instead of marching the front with a priority
+//! queue, it runs Gauss-Seidel sweeps in the 8 alternating orderings of the
+//! grid until the values stop changing. Within a sweep, the cells on the same
+//! i + j + k plane do not depend on each other, so each plane is updated in
+//! parallel. The scratch buffers are kept between the calls.
+//!
+//! \see Zhao, Hongkai. "A fast sweeping method for eikonal equations."
+//!     Mathematics of computation 74.250 (2005): 603-627.
+//! \see Detrixhe, Miles, Frederic Gibou, and Chohong Min. "A parallel fast
+//!     sweeping method for the Eikonal equation." Journal of Computational
+//!     Physics 237 (2013): 46-55.
+//!
+class FastSweepingLevelSetSolver3 final : public LevelSetSolver3 {
+ public:
+    //! Default constructor.
+    FastSweepingLevelSetSolver3();
+
+    //!
+    //! Reinitializes given scalar field to signed-distance field.
+    //!
+    //! \param inputSdf Input signed-distance field which can be distorted.
+    //! \param maxDistance Max range of reinitialization.
+    //! \param outputSdf Output signed-distance field.
+    //!
+    void reinitialize(
+        const ScalarGrid3& inputSdf,
+        double maxDistance,
+        ScalarGrid3* outputSdf) override;
+
+    //!
+    //! Extrapolates given scalar field from negative to positive SDF region.
+    //!
+    //! \param input Input scalar field to be extrapolated.
+    //! \param sdf Reference signed-distance field.
+    //! \param maxDistance Max range of extrapolation.
+    //! \param output Output scalar field.
+    //!
+    void extrapolate(
+        const ScalarGrid3& input,
+        const ScalarField3& sdf,
+        double maxDistance,
+        ScalarGrid3* output) override;
+
+    //!
+    //! Extrapolates given collocated vector field from negative to positive SDF
+    //! region.
+    //!
+    //! \param input Input collocated vector field to be extrapolated.
+    //! \param sdf Reference signed-distance field.
+    //! \param maxDistance Max range of extrapolation.
+    //! \param output Output collocated vector field.
+    //!
+    void extrapolate(
+        const CollocatedVectorGrid3& input,
+        const ScalarField3& sdf,
+        double maxDistance,
+        CollocatedVectorGrid3* output) override;
+
+    //!
+    //! Extrapolates given face-centered vector field from negative to positive
+    //! SDF region.
+    //!
+    //! \param input Input face-centered field to be extrapolated.
+    //! \param sdf Reference signed-distance field.
+    //! \param maxDistance Max range of extrapolation.
+    //! \param output Output face-centered vector field.
+    //!
+    void extrapolate(
+        const FaceCenteredGrid3& input,
+        const ScalarField3& sdf,
+        double maxDistance,
+        FaceCenteredGrid3* output) override;
+
+    //! Returns the max number of sweep rounds, each of which has 8 sweeps.
+    unsigned int maxNumberOfRounds() const;
+
+    //! Sets the max number of sweep rounds, each of which has 8 sweeps.
+    void setMaxNumberOfRounds(unsigned int rounds);
+
+ private:
+    unsigned int _maxNumberOfRounds = 4;
+    Array3<char> _markers;
+    Array3<double> _sdf;
+
+    void extrapolate(
+        const ConstArrayAccessor3<double>& input,
+        const ConstArrayAccessor3<double>& sdf,
+        const Vector3D& gridSpacing,
+        double maxDistance,
+        ArrayAccessor3<double> output);
+};
+
+typedef std::shared_ptr<FastSweepingLevelSetSolver3>
+    FastSweepingLevelSetSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FAST_SWEEPING_LEVEL_SET_SOLVER3_H_
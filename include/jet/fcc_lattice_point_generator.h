@@ -26,6 +26,26 @@ class FccLatticePointGenerator final : public PointGenerator3 {
         const BoundingBox3D& boundingBox,
         double spacing,
         const std::function<bool(const Vector3D&)>& callback) const override;
+
+    //! Returns the number of the layers of the lattice along the z-axis.
+    size_t numberOfSlices(
+        const BoundingBox3D& boundingBox,
+        double spacing) const override;
+
+    //! Returns the number of points in the given layers.
+    size_t countPointsInSlices(
+        const BoundingBox3D& boundingBox,
+        double spacing,
+        size_t sliceBegin,
+        size_t sliceEnd) const override;
+
+    //! Writes the points in the given layers to \p points.
+    void generateRange(
+        const BoundingBox3D& boundingBox,
+        double spacing,
+        size_t sliceBegin,
+        size_t sliceEnd,
+        ArrayAccessor1<Vector3D> points) const override;
 };
 
 typedef std::shared_ptr<FccLatticePointGenerator> FccLatticePointGeneratorPtr;
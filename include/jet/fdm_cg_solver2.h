@@ -16,11 +16,17 @@ class FdmCgSolver2 final : public FdmLinearSystemSolver2 {
     //! Solves the given linear system.
     bool solve(FdmLinearSystem2* system) override;
 
+    //! Solves the given compressed linear system.
+    bool solveCompressed(FdmCompressedLinearSystem* system) override;
+
+    //! Returns true since compressed systems are supported.
+    bool isCompressedSystemSupported() const override;
+
     //! Returns the max number of Jacobi iterations.
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Jacobi iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Jacobi method.
     double tolerance() const;
@@ -28,6 +34,22 @@ class FdmCgSolver2 final : public FdmLinearSystemSolver2 {
     //! Returns the last residual after the Jacobi iterations.
     double lastResidual() const;
 
+    //! Returns true if mixed-precision iterative refinement is used.
+    bool isUsingMixedPrecision() const;
+
+    //!
+    //! \brief Sets true to use mixed-precision iterative refinement.
+    //!
+    //! When enabled, the CG iterations run on a single-precision copy of the
+    //! matrix with single-precision temporaries, which halves their memory
+    //! traffic. The residual and the solution are kept in double precision,
+    //! and the solution is corrected until the residual falls below the
+    //! tolerance. In this mode, lastResidual() returns the L2-norm of the
+    //! double-precision residual and lastNumberOfIterations() the total
+    //! number of CG iterations.
+    //!
+    void setIsUsingMixedPrecision(bool isUsing);
+
  private:
     unsigned int _maxNumberOfIterations;
     unsigned int _lastNumberOfIterations;
@@ -38,6 +60,20 @@ class FdmCgSolver2 final : public FdmLinearSystemSolver2 {
     FdmVector2 _d;
     FdmVector2 _q;
     FdmVector2 _s;
+
+    bool _isUsingMixedPrecision = false;
+    FdmMatrix2F _matrixF;
+    FdmVector2F _bF;
+    FdmVector2F _xF;
+    FdmVector2F _rF;
+    FdmVector2F _dF;
+    FdmVector2F _qF;
+    FdmVector2F _sF;
+
+    FdmCompressedVector _rComp;
+    FdmCompressedVector _dComp;
+    FdmCompressedVector _qComp;
+    FdmCompressedVector _sComp;
 };
 
 typedef std::shared_ptr<FdmCgSolver2> FdmCgSolver2Ptr;
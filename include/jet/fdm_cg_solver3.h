@@ -16,17 +16,39 @@ class FdmCgSolver3 final : public FdmLinearSystemSolver3 {
     //! Solves the given linear system.
     bool solve(FdmLinearSystem3* system) override;
 
+    //! Solves the given compressed linear system.
+    bool solveCompressed(FdmCompressedLinearSystem* system) override;
+
+    //! Returns true since compressed systems are supported.
+    bool isCompressedSystemSupported() const override;
+
     //! Returns the max number of Jacobi iterations.
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Jacobi iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Jacobi method.
     double tolerance() const;
 
     //! Returns the last residual after the Jacobi iterations.
-    double lastResidual() const;
+    double lastResidual() const override;
+
+    //! Returns true if mixed-precision iterative refinement is used.
+    bool isUsingMixedPrecision() const;
+
+    //!
+    //! \brief Sets true to use mixed-precision iterative refinement.
+    //!
+    //! When enabled, the CG iterations run on a single-precision copy of the
+    //! matrix with single-precision temporaries, which halves their memory
+    //! traffic. The residual and the solution are kept in double precision,
+    //! and the solution is corrected until the residual falls below the
+    //! tolerance. In this mode, lastResidual() returns the L2-norm of the
+    //! double-precision residual and lastNumberOfIterations() the total
+    //! number of CG iterations.
+    //!
+    void setIsUsingMixedPrecision(bool isUsing);
 
  private:
     unsigned int _maxNumberOfIterations;
@@ -38,6 +60,20 @@ class FdmCgSolver3 final : public FdmLinearSystemSolver3 {
     FdmVector3 _d;
     FdmVector3 _q;
     FdmVector3 _s;
+
+    bool _isUsingMixedPrecision = false;
+    FdmMatrix3F _matrixF;
+    FdmVector3F _bF;
+    FdmVector3F _xF;
+    FdmVector3F _rF;
+    FdmVector3F _dF;
+    FdmVector3F _qF;
+    FdmVector3F _sF;
+
+    FdmCompressedVector _rComp;
+    FdmCompressedVector _dComp;
+    FdmCompressedVector _qComp;
+    FdmCompressedVector _sComp;
 };
 
 typedef std::shared_ptr<FdmCgSolver3> FdmCgSolver3Ptr;
@@ -0,0 +1,73 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_CHEBYSHEV_SOLVER3_H_
+#define INCLUDE_JET_FDM_CHEBYSHEV_SOLVER3_H_
+
+#include <jet/fdm_linear_system_solver3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D finite difference-type linear system solver using Chebyshev
+//! accelerated Jacobi method.
+//!
+//! This solver runs the Chebyshev semi-iteration on the Jacobi (diagonally)
+//! preconditioned system. Like the Jacobi method, every step only consists of
+//! element-wise operations and a matrix-vector multiplication, which makes it
+//! fully parallel, but it converges much faster. The eigenvalue bounds of the
+//! preconditioned matrix are estimated with the Gershgorin circle theorem, so
+//! the system should be symmetric and strictly diagonally dominant, such as
+//! the ones from the backward Euler diffusion.
+//!
+class FdmChebyshevSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    //! Constructs the solver with given parameters.
+    FdmChebyshevSolver3(
+        unsigned int maxNumberOfIterations,
+        unsigned int residualCheckInterval,
+        double tolerance);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem3* system) override;
+
+    //! Solves the given linear system with the eigenvalue bounds estimated by
+    //! the last solve call.
+    bool solveWithSameMatrix(FdmLinearSystem3* system) override;
+
+    //! Returns the max number of Chebyshev iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of Chebyshev iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the Chebyshev method.
+    double tolerance() const;
+
+    //! Returns the last residual after the Chebyshev iterations.
+    double lastResidual() const override;
+
+ private:
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    unsigned int _residualCheckInterval;
+    double _tolerance;
+    double _lastResidual;
+
+    // Bounds of the eigenvalues of the Jacobi preconditioned matrix
+    double _minEigenvalue = 1.0;
+    double _maxEigenvalue = 1.0;
+
+    FdmVector3 _residual;
+    FdmVector3 _direction;
+    FdmVector3 _temp;
+
+    void estimateEigenvalueBounds(const FdmMatrix3& A);
+
+    bool iterate(FdmLinearSystem3* system);
+};
+
+typedef std::shared_ptr<FdmChebyshevSolver3> FdmChebyshevSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_CHEBYSHEV_SOLVER3_H_
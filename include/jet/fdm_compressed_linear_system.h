@@ -0,0 +1,94 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_COMPRESSED_LINEAR_SYSTEM_H_
+#define INCLUDE_JET_FDM_COMPRESSED_LINEAR_SYSTEM_H_
+
+#include <jet/array1.h>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Sparse matrix in compressed sparse row (CSR) format for finite
+//!        differencing.
+//!
+//! Unlike FdmMatrix2 and FdmMatrix3, which have a row for every grid point,
+//! this matrix only has the rows of the selected (active) grid points, such
+//! as the fluid cells of a pressure solve. Thus, it does not depend on the
+//! dimension of the grid. The columns of each row are stored in ascending
+//! order, and the diagonal element is always stored.
+//!
+struct FdmCompressedMatrix {
+    //! Non-zero elements of the rows, stored row by row.
+    std::vector<double> nonZeros;
+
+    //! Column index of each element in nonZeros.
+    std::vector<size_t> columnIndices;
+
+    //! Offset to the first element of each row, followed by the total
+    //! number of the elements.
+    std::vector<size_t> rowPointers = std::vector<size_t>(1, 0);
+
+    //! Returns the number of rows.
+    size_t rows() const;
+
+    //! Removes all the rows.
+    void clear();
+
+    //! Appends an element to the last row.
+    void addElement(size_t column, double value);
+
+    //! Closes the last row so that the following elements go to a new row.
+    void finishRow();
+};
+
+//! Vector type for compressed finite differencing.
+typedef Array1<double> FdmCompressedVector;
+
+//! Linear system (Ax=b) for compressed finite differencing.
+struct FdmCompressedLinearSystem {
+    FdmCompressedMatrix A;
+    FdmCompressedVector x, b;
+};
+
+//! BLAS operator wrapper for compressed finite differencing.
+struct FdmCompressedBlas {
+    typedef double ScalarType;
+    typedef FdmCompressedVector VectorType;
+    typedef FdmCompressedMatrix MatrixType;
+
+    //! Sets entire element of given vector \p result with scalar \p s.
+    static void set(double s, VectorType* result);
+
+    //! Copies entire element of given vector \p result with other vector \p v.
+    static void set(const VectorType& v, VectorType* result);
+
+    //! Performs dot product with vector \p a and \p b.
+    static double dot(const VectorType& a, const VectorType& b);
+
+    //! Performs ax + y operation where \p a is a matrix and \p x and \p y are
+    //! vectors.
+    static void axpy(
+        double a, const VectorType& x, const VectorType& y, VectorType* result);
+
+    //! Performs matrix-vector multiplication.
+    static void mvm(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //! Computes residual vector (b - ax).
+    static void residual(
+        const MatrixType& a,
+        const VectorType& x,
+        const VectorType& b,
+        VectorType* result);
+
+    //! Returns L2-norm of the given vector \p v.
+    static double l2Norm(const VectorType& v);
+
+    //! Returns Linf-norm of the given vector \p v.
+    static double lInfNorm(const VectorType& v);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_COMPRESSED_LINEAR_SYSTEM_H_
@@ -0,0 +1,98 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_CUDA_PCG_SOLVER3_H_
+#define INCLUDE_JET_FDM_CUDA_PCG_SOLVER3_H_
+
+#include <jet/fdm_linear_system_solver3.h>
+#include <memory>
+
+namespace jet {
+
+namespace internal {
+
+class CudaPcgState;
+
+struct CudaPcgStateDeleter final {
+    void operator()(CudaPcgState* state) const;
+};
+
+}  // namespace internal
+
+//!
+//! \brief 3-D finite difference-type linear system solver using Jacobi
+//!        preconditioned conjugate gradient on a CUDA device.
+//!
+//! When the library is built with JET_USE_CUDA and a CUDA device is present,
+//! the matrix, the right-hand side, the solution, and the CG temporaries are
+//! kept in the device memory across the solves, and only the solution is
+//! copied back to the host. Otherwise, the same iterations run on the CPU, so
+//! the solver can be selected regardless of the build.
+//!
+class FdmCudaPcgSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    //! Constructs the solver with given parameters.
+    FdmCudaPcgSolver3(unsigned int maxNumberOfIterations, double tolerance);
+
+    //! Destructor.
+    ~FdmCudaPcgSolver3();
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem3* system) override;
+
+    //!
+    //! \brief Solves the given linear system without uploading the matrix
+    //! again if it is the one of the last solve call.
+    //!
+    bool solveWithSameMatrix(FdmLinearSystem3* system) override;
+
+    //! Returns the max number of PCG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of PCG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the PCG method.
+    double tolerance() const;
+
+    //! Returns the last residual after the PCG iterations.
+    double lastResidual() const override;
+
+    //! Returns true if the solver runs on a CUDA device.
+    bool isUsingDevice() const;
+
+    //! Returns true if the library is built with CUDA and a device is found.
+    static bool isDeviceAvailable();
+
+ private:
+    struct Preconditioner final {
+        FdmVector3 inverseDiagonal;
+
+        void build(const FdmMatrix3& matrix);
+
+        void solve(const FdmVector3& b, FdmVector3* x);
+    };
+
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidual;
+
+    std::unique_ptr<internal::CudaPcgState, internal::CudaPcgStateDeleter>
+        _device;
+    const FdmMatrixRow3* _uploadedMatrix = nullptr;
+    Size3 _uploadedSize;
+
+    FdmVector3 _r;
+    FdmVector3 _d;
+    FdmVector3 _q;
+    FdmVector3 _s;
+    Preconditioner _precond;
+
+    bool solve(FdmLinearSystem3* system, bool isReusingMatrix);
+};
+
+typedef std::shared_ptr<FdmCudaPcgSolver3> FdmCudaPcgSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_CUDA_PCG_SOLVER3_H_
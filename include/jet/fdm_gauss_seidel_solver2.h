@@ -23,7 +23,7 @@ class FdmGaussSeidelSolver2 final : public FdmLinearSystemSolver2 {
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Gauss-Seidel iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Gauss-Seidel method.
     double tolerance() const;
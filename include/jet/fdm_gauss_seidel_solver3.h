@@ -7,14 +7,35 @@
 
 namespace jet {
 
-//! 3-D finite difference-type linear system solver using Gauss-Seidel method.
+//!
+//! \brief 3-D finite difference-type linear system solver using Gauss-Seidel
+//! method.
+//!
+//! The cells are swept in lexicographic order by default, which runs on a
+//! single thread. With red-black ordering, the cells are split into two colors
+//! ((i + j + k) % 2) that do not couple with each other in the 7-point
+//! stencil, and each color is swept in parallel. The updates can also be
+//! weighted by a successive over-relaxation (SOR) factor.
+//!
 class FdmGaussSeidelSolver3 final : public FdmLinearSystemSolver3 {
  public:
-    //! Constructs the solver with given parameters.
+    //!
+    //! \brief Constructs the solver with given parameters.
+    //!
+    //! \param[in]  maxNumberOfIterations  Max number of iterations.
+    //! \param[in]  residualCheckInterval  Number of iterations between the
+    //!                                    residual checks.
+    //! \param[in]  tolerance              Max residual tolerance.
+    //! \param[in]  sorFactor              SOR factor, between 0 and 2.
+    //! \param[in]  useRedBlackOrdering    True to sweep the cells in parallel
+    //!                                    with red-black ordering.
+    //!
     FdmGaussSeidelSolver3(
         unsigned int maxNumberOfIterations,
         unsigned int residualCheckInterval,
-        double tolerance);
+        double tolerance,
+        double sorFactor = 1.0,
+        bool useRedBlackOrdering = false);
 
     //! Solves the given linear system.
     bool solve(FdmLinearSystem3* system) override;
@@ -23,13 +44,34 @@ class FdmGaussSeidelSolver3 final : public FdmLinearSystemSolver3 {
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Gauss-Seidel iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Gauss-Seidel method.
     double tolerance() const;
 
     //! Returns the last residual after the Gauss-Seidel iterations.
-    double lastResidual() const;
+    double lastResidual() const override;
+
+    //! Returns the SOR factor.
+    double sorFactor() const;
+
+    //! Returns true if the red-black ordering is used.
+    bool useRedBlackOrdering() const;
+
+    //! Performs a single Gauss-Seidel sweep in lexicographic order.
+    static void relax(
+        const FdmMatrix3& A,
+        const FdmVector3& b,
+        double sorFactor,
+        FdmVector3* x);
+
+    //! Performs a single Gauss-Seidel sweep in red-black order, where each
+    //! color is swept in parallel.
+    static void relaxRedBlack(
+        const FdmMatrix3& A,
+        const FdmVector3& b,
+        double sorFactor,
+        FdmVector3* x);
 
  private:
     unsigned int _maxNumberOfIterations;
@@ -37,10 +79,10 @@ class FdmGaussSeidelSolver3 final : public FdmLinearSystemSolver3 {
     unsigned int _residualCheckInterval;
     double _tolerance;
     double _lastResidual;
+    double _sorFactor;
+    bool _useRedBlackOrdering;
 
     FdmVector3 _residual;
-
-    void relax(FdmLinearSystem3* system);
 };
 
 typedef std::shared_ptr<FdmGaussSeidelSolver3> FdmGaussSeidelSolver3Ptr;
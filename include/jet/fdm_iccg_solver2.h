@@ -11,17 +11,50 @@ namespace jet {
 //! conjugate gradient.
 class FdmIccgSolver2 final : public FdmLinearSystemSolver2 {
  public:
+    //! Types of the incomplete Cholesky preconditioner.
+    enum PreconditionerType {
+        //! IC(0) in the natural (i, j) order with sequential sweeps.
+        IncompleteCholesky,
+
+        //! Same factorization as IncompleteCholesky, but the cells on each
+        //! i + j wavefront are processed in parallel.
+        WavefrontIncompleteCholesky,
+
+        //! IC(0) in the red-black order. Each color is processed fully in
+        //! parallel, at the cost of more CG iterations.
+        RedBlackIncompleteCholesky,
+
+        //! Modified IC(0) in the natural order with wavefront sweeps. Usually
+        //! takes the fewest CG iterations for Poisson-type systems.
+        ModifiedIncompleteCholesky
+    };
+
     //! Constructs the solver with given parameters.
-    FdmIccgSolver2(unsigned int maxNumberOfIterations, double tolerance);
+    FdmIccgSolver2(
+        unsigned int maxNumberOfIterations,
+        double tolerance,
+        PreconditionerType preconditionerType = IncompleteCholesky);
 
     //! Solves the given linear system.
     bool solve(FdmLinearSystem2* system) override;
 
+    //!
+    //! \brief Solves the given compressed linear system.
+    //!
+    //! Compressed systems are always preconditioned with the sequential
+    //! incomplete Cholesky in the order of the rows, and the mixed-precision
+    //! mode does not apply to them.
+    //!
+    bool solveCompressed(FdmCompressedLinearSystem* system) override;
+
+    //! Returns true since compressed systems are supported.
+    bool isCompressedSystemSupported() const override;
+
     //! Returns the max number of Jacobi iterations.
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Jacobi iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Jacobi method.
     double tolerance() const;
@@ -29,17 +62,51 @@ class FdmIccgSolver2 final : public FdmLinearSystemSolver2 {
     //! Returns the last residual after the Jacobi iterations.
     double lastResidual() const;
 
+    //! Returns the preconditioner type.
+    PreconditionerType preconditionerType() const;
+
+    //! Sets the preconditioner type.
+    void setPreconditionerType(PreconditionerType type);
+
+    //! Returns true if mixed-precision iterative refinement is used.
+    bool isUsingMixedPrecision() const;
+
+    //!
+    //! \brief Sets true to use mixed-precision iterative refinement.
+    //!
+    //! When enabled, the ICCG iterations run on a single-precision copy of the
+    //! matrix with single-precision temporaries, which halves their memory
+    //! traffic. The residual and the solution are kept in double precision,
+    //! and the solution is corrected until the residual falls below the
+    //! tolerance. In this mode, lastResidual() returns the L2-norm of the
+    //! double-precision residual and lastNumberOfIterations() the total
+    //! number of ICCG iterations.
+    //!
+    void setIsUsingMixedPrecision(bool isUsing);
+
  private:
+    template <typename T>
     struct Preconditioner final {
-        ConstArrayAccessor2<FdmMatrixRow2> A;
-        FdmVector2 d;
-        FdmVector2 y;
+        PreconditionerType type = IncompleteCholesky;
+        ConstArrayAccessor2<FdmMatrixRow2T<T>> A;
+        Array2<T> d;
+        Array2<T> y;
 
-        void build(const FdmMatrix2& matrix);
+        void build(const Array2<FdmMatrixRow2T<T>>& matrix);
 
         void solve(
-            const FdmVector2& b,
-            FdmVector2* x);
+            const Array2<T>& b,
+            Array2<T>* x);
+    };
+
+    struct CompressedPreconditioner final {
+        const FdmCompressedMatrix* A = nullptr;
+        FdmCompressedVector d;
+        FdmCompressedVector y;
+
+        void build(const FdmCompressedMatrix& matrix);
+
+        void solve(const FdmCompressedVector& b, FdmCompressedVector* x);
     };
 
     unsigned int _maxNumberOfIterations;
@@ -51,7 +118,23 @@ class FdmIccgSolver2 final : public FdmLinearSystemSolver2 {
     FdmVector2 _d;
     FdmVector2 _q;
     FdmVector2 _s;
-    Preconditioner _precond;
+    Preconditioner<double> _precond;
+
+    bool _isUsingMixedPrecision = false;
+    FdmMatrix2F _matrixF;
+    FdmVector2F _bF;
+    FdmVector2F _xF;
+    FdmVector2F _rF;
+    FdmVector2F _dF;
+    FdmVector2F _qF;
+    FdmVector2F _sF;
+    Preconditioner<float> _precondF;
+
+    FdmCompressedVector _rComp;
+    FdmCompressedVector _dComp;
+    FdmCompressedVector _qComp;
+    FdmCompressedVector _sComp;
+    CompressedPreconditioner _precondComp;
 };
 
 typedef std::shared_ptr<FdmIccgSolver2> FdmIccgSolver2Ptr;
@@ -23,13 +23,31 @@ class FdmJacobiSolver3 final : public FdmLinearSystemSolver3 {
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Jacobi iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Jacobi method.
     double tolerance() const;
 
     //! Returns the last residual after the Jacobi iterations.
-    double lastResidual() const;
+    double lastResidual() const override;
+
+    //! Returns the max number of Jacobi iterations applied per tile at once.
+    unsigned int temporalBlockingDepth() const;
+
+    //!
+    //! \brief Sets the max number of Jacobi iterations applied per tile at
+    //!        once.
+    //!
+    //! With a depth of n > 1, the grid is split into 32x32x32 tiles, and each
+    //! tile runs up to n iterations on a local copy that it extends by n
+    //! cells on each side, so the grid streams through memory once per n
+    //! iterations instead of once per iteration. The cells near the tiles
+    //! are computed more than once, which trades arithmetic for memory
+    //! traffic, and the result is the same as with the plain iterations.
+    //! The iterations stop at each residual check. Default is 1, which runs
+    //! one full-grid sweep per iteration. Zero is taken as one.
+    //!
+    void setTemporalBlockingDepth(unsigned int depth);
 
  private:
     unsigned int _maxNumberOfIterations;
@@ -37,11 +55,17 @@ class FdmJacobiSolver3 final : public FdmLinearSystemSolver3 {
     unsigned int _residualCheckInterval;
     double _tolerance;
     double _lastResidual;
+    unsigned int _temporalBlockingDepth = 1;
 
     FdmVector3 _xTemp;
     FdmVector3 _residual;
 
     void relax(FdmLinearSystem3* system, FdmVector3* xTemp);
+
+    void relaxBlocked(
+        FdmLinearSystem3* system,
+        unsigned int numberOfIterations,
+        FdmVector3* xTemp);
 };
 
 typedef std::shared_ptr<FdmJacobiSolver3> FdmJacobiSolver3Ptr;
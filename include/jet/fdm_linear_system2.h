@@ -7,74 +7,135 @@
 
 namespace jet {
 
-//! The row of FdmMatrix2 where row corresponds to (i, j, k) grid point.
-struct FdmMatrixRow2 {
+//!
+//! \brief The row of FdmMatrix2 where row corresponds to (i, j) grid point.
+//!
+//! \tparam T Type of the matrix elements.
+//!
+template <typename T>
+struct FdmMatrixRow2T {
     //! Diagonal component of the matrix (row, row).
-    double center = 0.0;
+    T center = 0;
 
     //! Off-diagonal element where colum refers to (i+1, j, k) grid point.
-    double right = 0.0;
+    T right = 0;
 
     //! Off-diagonal element where column refers to (i, j+1, k) grid point.
-    double up = 0.0;
+    T up = 0;
 };
 
+//! Double-precision row of FdmMatrix2.
+typedef FdmMatrixRow2T<double> FdmMatrixRow2;
+
+//! Single-precision row of FdmMatrix2F.
+typedef FdmMatrixRow2T<float> FdmMatrixRow2F;
+
 //! Vector type for 2-D finite differencing.
 typedef Array2<double> FdmVector2;
 
+//! Single-precision vector type for 2-D finite differencing.
+typedef Array2<float> FdmVector2F;
+
 //! Matrix type for 2-D finite differencing.
 typedef Array2<FdmMatrixRow2> FdmMatrix2;
 
+//! Single-precision matrix type for 2-D finite differencing.
+typedef Array2<FdmMatrixRow2F> FdmMatrix2F;
+
 //! Linear system (Ax=b) for 2-D finite differencing.
-struct FdmLinearSystem2 {
-    FdmMatrix2 A;
-    FdmVector2 x, b;
+template <typename T>
+struct FdmLinearSystem2T {
+    Array2<FdmMatrixRow2T<T>> A;
+    Array2<T> x, b;
 };
 
-//! BLAS operator wrapper for 2-D finite differencing.
-struct FdmBlas2 {
-    typedef double ScalarType;
-    typedef FdmVector2 VectorType;
-    typedef FdmMatrix2 MatrixType;
+//! Double-precision linear system for 2-D finite differencing.
+typedef FdmLinearSystem2T<double> FdmLinearSystem2;
+
+//! Single-precision linear system for 2-D finite differencing.
+typedef FdmLinearSystem2T<float> FdmLinearSystem2F;
+
+//!
+//! \brief BLAS operator wrapper for 2-D finite differencing.
+//!
+//! The elements are stored as \p T, but the reductions (dot products and
+//! norms) are always accumulated in double precision.
+//!
+//! \tparam T Type of the vector and matrix elements.
+//!
+template <typename T>
+struct FdmBlas2T {
+    typedef T ScalarType;
+    typedef Array2<T> VectorType;
+    typedef Array2<FdmMatrixRow2T<T>> MatrixType;
 
     //! Sets entire element of given vector \p result with scalar \p s.
-    static void set(double s, FdmVector2* result);
+    static void set(T s, VectorType* result);
 
     //! Copies entire element of given vector \p result with other vector \p v.
-    static void set(const FdmVector2& v, FdmVector2* result);
+    static void set(const VectorType& v, VectorType* result);
 
     //! Sets entire element of given matrix \p result with scalar \p s.
-    static void set(double s, FdmMatrix2* result);
+    static void set(T s, MatrixType* result);
 
     //! Copies entire element of given matrix \p result with other matrix \p v.
-    static void set(const FdmMatrix2& m, FdmMatrix2* result);
+    static void set(const MatrixType& m, MatrixType* result);
 
     //! Performs dot product with vector \p a and \p b.
-    static double dot(const FdmVector2& a, const FdmVector2& b);
+    static double dot(const VectorType& a, const VectorType& b);
 
     //! Performs ax + y operation where \p a is a matrix and \p x and \p y are
     //! vectors.
     static void axpy(
-        double a, const FdmVector2& x, const FdmVector2& y, FdmVector2* result);
+        double a, const VectorType& x, const VectorType& y, VectorType* result);
 
     //! Performs matrix-vector multiplication.
     static void mvm(
-        const FdmMatrix2& m, const FdmVector2& v, FdmVector2* result);
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //!
+    //! \brief Performs matrix-vector multiplication and returns the dot
+    //!        product of \p v and \p result.
+    //!
+    //! This function is equivalent to mvm followed by dot, but only takes a
+    //! single pass over the vectors. Used as a fused kernel by cg and pcg.
+    //!
+    static double mvmAndDot(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //!
+    //! \brief Performs ax + y operation and returns the squared L2-norm of
+    //!        \p result.
+    //!
+    //! This function is equivalent to axpy followed by dot, but only takes a
+    //! single pass over the vectors. Used as a fused kernel by cg.
+    //!
+    static double axpyAndDot(
+        double a, const VectorType& x, const VectorType& y,
+        VectorType* result);
 
     //! Computes residual vector (b - ax).
     static void residual(
-        const FdmMatrix2& a,
-        const FdmVector2& x,
-        const FdmVector2& b,
-        FdmVector2* result);
+        const MatrixType& a,
+        const VectorType& x,
+        const VectorType& b,
+        VectorType* result);
 
     //! Returns L2-norm of the given vector \p v.
-    static double l2Norm(const FdmVector2& v);
+    static double l2Norm(const VectorType& v);
 
     //! Returns Linf-norm of the given vector \p v.
-    static double lInfNorm(const FdmVector2& v);
+    static double lInfNorm(const VectorType& v);
 };
 
+//! Double-precision BLAS operator wrapper for 2-D finite differencing.
+typedef FdmBlas2T<double> FdmBlas2;
+
+//! Single-precision BLAS operator wrapper for 2-D finite differencing.
+typedef FdmBlas2T<float> FdmBlas2F;
+
 }  // namespace jet
 
+#include "detail/fdm_linear_system2-inl.h"
+
 #endif  // INCLUDE_JET_FDM_LINEAR_SYSTEM2_H_
@@ -7,77 +7,140 @@
 
 namespace jet {
 
-//! The row of FdmMatrix3 where row corresponds to (i, j, k) grid point.
-struct FdmMatrixRow3 {
+//!
+//! \brief The row of FdmMatrix3 where row corresponds to (i, j, k) grid point.
+//!
+//! \tparam T Type of the matrix elements.
+//!
+template <typename T>
+struct FdmMatrixRow3T {
     //! Diagonal component of the matrix (row, row).
-    double center = 0.0;
+    T center = 0;
 
     //! Off-diagonal element where colum refers to (i+1, j, k) grid point.
-    double right = 0.0;
+    T right = 0;
 
     //! Off-diagonal element where column refers to (i, j+1, k) grid point.
-    double up = 0.0;
+    T up = 0;
 
     //! OFf-diagonal element where column refers to (i, j, k+1) grid point.
-    double front = 0.0;
+    T front = 0;
 };
 
+//! Double-precision row of FdmMatrix3.
+typedef FdmMatrixRow3T<double> FdmMatrixRow3;
+
+//! Single-precision row of FdmMatrix3F.
+typedef FdmMatrixRow3T<float> FdmMatrixRow3F;
+
 //! Vector type for 3-D finite differencing.
 typedef Array3<double> FdmVector3;
 
+//! Single-precision vector type for 3-D finite differencing.
+typedef Array3<float> FdmVector3F;
+
 //! Matrix type for 3-D finite differencing.
 typedef Array3<FdmMatrixRow3> FdmMatrix3;
 
+//! Single-precision matrix type for 3-D finite differencing.
+typedef Array3<FdmMatrixRow3F> FdmMatrix3F;
+
 //! Linear system (Ax=b) for 3-D finite differencing.
-struct FdmLinearSystem3 {
-    FdmMatrix3 A;
-    FdmVector3 x, b;
+template <typename T>
+struct FdmLinearSystem3T {
+    Array3<FdmMatrixRow3T<T>> A;
+    Array3<T> x, b;
 };
 
-//! BLAS operator wrapper for 3-D finite differencing.
-struct FdmBlas3 {
-    typedef double ScalarType;
-    typedef FdmVector3 VectorType;
-    typedef FdmMatrix3 MatrixType;
+//! Double-precision linear system for 3-D finite differencing.
+typedef FdmLinearSystem3T<double> FdmLinearSystem3;
+
+//! Single-precision linear system for 3-D finite differencing.
+typedef FdmLinearSystem3T<float> FdmLinearSystem3F;
+
+//!
+//! \brief BLAS operator wrapper for 3-D finite differencing.
+//!
+//! The elements are stored as \p T, but the reductions (dot products and
+//! norms) are always accumulated in double precision. For the double-precision
+//! systems, mvm, residual and axpy run row by row along x with the SIMD
+//! kernels of simdInstructionSet().
+//!
+//! \tparam T Type of the vector and matrix elements.
+//!
+template <typename T>
+struct FdmBlas3T {
+    typedef T ScalarType;
+    typedef Array3<T> VectorType;
+    typedef Array3<FdmMatrixRow3T<T>> MatrixType;
 
     //! Sets entire element of given vector \p result with scalar \p s.
-    static void set(double s, FdmVector3* result);
+    static void set(T s, VectorType* result);
 
     //! Copies entire element of given vector \p result with other vector \p v.
-    static void set(const FdmVector3& v, FdmVector3* result);
+    static void set(const VectorType& v, VectorType* result);
 
     //! Sets entire element of given matrix \p result with scalar \p s.
-    static void set(double s, FdmMatrix3* result);
+    static void set(T s, MatrixType* result);
 
     //! Copies entire element of given matrix \p result with other matrix \p v.
-    static void set(const FdmMatrix3& m, FdmMatrix3* result);
+    static void set(const MatrixType& m, MatrixType* result);
 
     //! Performs dot product with vector \p a and \p b.
-    static double dot(const FdmVector3& a, const FdmVector3& b);
+    static double dot(const VectorType& a, const VectorType& b);
 
     //! Performs ax + y operation where \p a is a matrix and \p x and \p y are
     //! vectors.
     static void axpy(
-        double a, const FdmVector3& x, const FdmVector3& y, FdmVector3* result);
+        double a, const VectorType& x, const VectorType& y, VectorType* result);
 
     //! Performs matrix-vector multiplication.
     static void mvm(
-        const FdmMatrix3& m, const FdmVector3& v, FdmVector3* result);
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //!
+    //! \brief Performs matrix-vector multiplication and returns the dot
+    //!        product of \p v and \p result.
+    //!
+    //! This function is equivalent to mvm followed by dot, but only takes a
+    //! single pass over the vectors. Used as a fused kernel by cg and pcg.
+    //!
+    static double mvmAndDot(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //!
+    //! \brief Performs ax + y operation and returns the squared L2-norm of
+    //!        \p result.
+    //!
+    //! This function is equivalent to axpy followed by dot, but only takes a
+    //! single pass over the vectors. Used as a fused kernel by cg.
+    //!
+    static double axpyAndDot(
+        double a, const VectorType& x, const VectorType& y,
+        VectorType* result);
 
     //! Computes residual vector (b - ax).
     static void residual(
-        const FdmMatrix3& a,
-        const FdmVector3& x,
-        const FdmVector3& b,
-        FdmVector3* result);
+        const MatrixType& a,
+        const VectorType& x,
+        const VectorType& b,
+        VectorType* result);
 
     //! Returns L2-norm of the given vector \p v.
-    static double l2Norm(const FdmVector3& v);
+    static double l2Norm(const VectorType& v);
 
     //! Returns Linf-norm of the given vector \p v.
-    static double lInfNorm(const FdmVector3& v);
+    static double lInfNorm(const VectorType& v);
 };
 
+//! Double-precision BLAS operator wrapper for 3-D finite differencing.
+typedef FdmBlas3T<double> FdmBlas3;
+
+//! Single-precision BLAS operator wrapper for 3-D finite differencing.
+typedef FdmBlas3T<float> FdmBlas3F;
+
 }  // namespace jet
 
+#include "detail/fdm_linear_system3-inl.h"
+
 #endif  // INCLUDE_JET_FDM_LINEAR_SYSTEM3_H_
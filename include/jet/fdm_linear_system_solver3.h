@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_FDM_LINEAR_SYSTEM_SOLVER3_H_
 #define INCLUDE_JET_FDM_LINEAR_SYSTEM_SOLVER3_H_
 
+#include <jet/fdm_compressed_linear_system.h>
 #include <jet/fdm_linear_system3.h>
 #include <memory>
 
@@ -13,6 +14,44 @@ class FdmLinearSystemSolver3 {
  public:
     //! Solves the given linear system.
     virtual bool solve(FdmLinearSystem3* system) = 0;
+
+    //!
+    //! \brief Solves the given linear system whose matrix is the same as the
+    //! one of the last solve call.
+    //!
+    //! Solvers that build data from the matrix, such as a preconditioner, can
+    //! reuse it when only the right-hand side has changed. \p system should be
+    //! the same object as the last call with the matrix left untouched. The
+    //! default implementation calls solve().
+    //!
+    virtual bool solveWithSameMatrix(FdmLinearSystem3* system);
+
+    //!
+    //! \brief Solves the given compressed linear system.
+    //!
+    //! Solvers that depend on the grid structure of the system, such as the
+    //! multigrid solvers, do not support compressed systems. For those, the
+    //! default implementation returns false without solving the system.
+    //! Otherwise, it returns false if the solver did not converge.
+    //!
+    virtual bool solveCompressed(FdmCompressedLinearSystem* system);
+
+    //!
+    //! \brief Returns true if the solver supports compressed systems.
+    //!
+    //! The grid solvers check this before they assemble a compressed system,
+    //! and solve the full system instead if it is false, since the return
+    //! value of solveCompressed() does not tell an unsupported system from a
+    //! solve that did not converge. The default implementation returns false.
+    //!
+    virtual bool isCompressedSystemSupported() const;
+
+    //! Returns the last number of iterations the solver made.
+    virtual unsigned int lastNumberOfIterations() const = 0;
+
+    //! Returns the last residual the solver reached, or zero if the solver
+    //! does not track it.
+    virtual double lastResidual() const;
 };
 
 typedef std::shared_ptr<FdmLinearSystemSolver3> FdmLinearSystemSolver3Ptr;
@@ -0,0 +1,78 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MATRIX_FREE_CG_SOLVER2_H_
+#define INCLUDE_JET_FDM_MATRIX_FREE_CG_SOLVER2_H_
+
+#include <jet/fdm_linear_system_solver2.h>
+#include <jet/fdm_matrix_free_operator2.h>
+
+namespace jet {
+
+//!
+//! \brief 2-D finite difference-type linear system solver using Jacobi
+//!        preconditioned conjugate gradient, which does not require an
+//!        assembled matrix.
+//!
+//! Besides the usual FdmLinearSystem2, this solver can solve a system whose
+//! matrix is given as an FdmMatrixFreeOperator2. Since the preconditioner
+//! only needs the diagonal, the solver itself stores nothing but vectors,
+//! and the pressure solvers skip assembling FdmMatrix2 when this solver is
+//! set as their linear system solver.
+//!
+class FdmMatrixFreeCgSolver2 final : public FdmLinearSystemSolver2 {
+ public:
+    //! Constructs the solver with given parameters.
+    FdmMatrixFreeCgSolver2(
+        unsigned int maxNumberOfIterations, double tolerance);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem2* system) override;
+
+    //! Solves Ax = b where A is the given matrix-free operator.
+    bool solve(
+        const FdmMatrixFreeOperator2& A,
+        const FdmVector2& b,
+        FdmVector2* x);
+
+    //! Returns the max number of CG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of CG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the CG method.
+    double tolerance() const;
+
+    //! Returns the last residual after the CG iterations.
+    double lastResidual() const;
+
+ private:
+    struct Preconditioner final {
+        FdmVector2 invDiagonal;
+
+        void build(const FdmMatrix2& matrix);
+
+        void build(const FdmMatrixFreeOperator2& A);
+
+        void solve(const FdmVector2& b, FdmVector2* x);
+    };
+
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidual;
+
+    Preconditioner _precond;
+    FdmVector2 _r;
+    FdmVector2 _d;
+    FdmVector2 _q;
+    FdmVector2 _s;
+
+    void resizeTemporaries(const Size2& size);
+};
+
+typedef std::shared_ptr<FdmMatrixFreeCgSolver2> FdmMatrixFreeCgSolver2Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MATRIX_FREE_CG_SOLVER2_H_
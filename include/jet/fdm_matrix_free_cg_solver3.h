@@ -0,0 +1,78 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MATRIX_FREE_CG_SOLVER3_H_
+#define INCLUDE_JET_FDM_MATRIX_FREE_CG_SOLVER3_H_
+
+#include <jet/fdm_linear_system_solver3.h>
+#include <jet/fdm_matrix_free_operator3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D finite difference-type linear system solver using Jacobi
+//!        preconditioned conjugate gradient, which does not require an
+//!        assembled matrix.
+//!
+//! Besides the usual FdmLinearSystem3, this solver can solve a system whose
+//! matrix is given as an FdmMatrixFreeOperator3. Since the preconditioner
+//! only needs the diagonal, the solver itself stores nothing but vectors,
+//! and the pressure solvers skip assembling FdmMatrix3 when this solver is
+//! set as their linear system solver.
+//!
+class FdmMatrixFreeCgSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    //! Constructs the solver with given parameters.
+    FdmMatrixFreeCgSolver3(
+        unsigned int maxNumberOfIterations, double tolerance);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem3* system) override;
+
+    //! Solves Ax = b where A is the given matrix-free operator.
+    bool solve(
+        const FdmMatrixFreeOperator3& A,
+        const FdmVector3& b,
+        FdmVector3* x);
+
+    //! Returns the max number of CG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of CG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the CG method.
+    double tolerance() const;
+
+    //! Returns the last residual after the CG iterations.
+    double lastResidual() const override;
+
+ private:
+    struct Preconditioner final {
+        FdmVector3 invDiagonal;
+
+        void build(const FdmMatrix3& matrix);
+
+        void build(const FdmMatrixFreeOperator3& A);
+
+        void solve(const FdmVector3& b, FdmVector3* x);
+    };
+
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidual;
+
+    Preconditioner _precond;
+    FdmVector3 _r;
+    FdmVector3 _d;
+    FdmVector3 _q;
+    FdmVector3 _s;
+
+    void resizeTemporaries(const Size3& size);
+};
+
+typedef std::shared_ptr<FdmMatrixFreeCgSolver3> FdmMatrixFreeCgSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MATRIX_FREE_CG_SOLVER3_H_
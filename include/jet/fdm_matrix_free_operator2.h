@@ -0,0 +1,65 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MATRIX_FREE_OPERATOR2_H_
+#define INCLUDE_JET_FDM_MATRIX_FREE_OPERATOR2_H_
+
+#include <jet/fdm_linear_system2.h>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Abstract base class for 2-D matrix-free finite difference operator.
+//!
+//! This class represents a symmetric 5-point stencil operator A without
+//! storing its FdmMatrix2. Instead, the implementations compute the stencil
+//! on the fly from their own (usually much more compact) data, such as cell
+//! markers or face weights, whenever the operator is applied.
+//!
+class FdmMatrixFreeOperator2 {
+ public:
+    //! Default destructor.
+    virtual ~FdmMatrixFreeOperator2();
+
+    //! Returns the size of the grid the operator is defined on.
+    virtual Size2 size() const = 0;
+
+    //! Computes \p result = A \p v.
+    virtual void mvm(const FdmVector2& v, FdmVector2* result) const = 0;
+
+    //! Stores the diagonal of A to \p result.
+    virtual void diagonal(FdmVector2* result) const = 0;
+};
+
+//! Shared pointer type for the FdmMatrixFreeOperator2.
+typedef std::shared_ptr<FdmMatrixFreeOperator2> FdmMatrixFreeOperator2Ptr;
+
+//!
+//! \brief BLAS operator wrapper for 2-D matrix-free finite differencing.
+//!
+//! This class is FdmBlas2 with FdmMatrixFreeOperator2 as the matrix type, so
+//! that cg and pcg can run without an assembled matrix.
+//!
+struct FdmMatrixFreeBlas2 : public FdmBlas2 {
+    typedef FdmMatrixFreeOperator2 MatrixType;
+
+    //! Performs matrix-vector multiplication.
+    static void mvm(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //! Performs matrix-vector multiplication and returns the dot product of
+    //! \p v and \p result.
+    static double mvmAndDot(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //! Computes residual vector (b - ax).
+    static void residual(
+        const MatrixType& a,
+        const VectorType& x,
+        const VectorType& b,
+        VectorType* result);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MATRIX_FREE_OPERATOR2_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MATRIX_FREE_OPERATOR3_H_
+#define INCLUDE_JET_FDM_MATRIX_FREE_OPERATOR3_H_
+
+#include <jet/fdm_linear_system3.h>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Abstract base class for 3-D matrix-free finite difference operator.
+//!
+//! This class represents a symmetric 7-point stencil operator A without
+//! storing its FdmMatrix3. Instead, the implementations compute the stencil
+//! on the fly from their own (usually much more compact) data, such as cell
+//! markers or face weights, whenever the operator is applied.
+//!
+class FdmMatrixFreeOperator3 {
+ public:
+    //! Default destructor.
+    virtual ~FdmMatrixFreeOperator3();
+
+    //! Returns the size of the grid the operator is defined on.
+    virtual Size3 size() const = 0;
+
+    //! Computes \p result = A \p v.
+    virtual void mvm(const FdmVector3& v, FdmVector3* result) const = 0;
+
+    //! Stores the diagonal of A to \p result.
+    virtual void diagonal(FdmVector3* result) const = 0;
+};
+
+//! Shared pointer type for the FdmMatrixFreeOperator3.
+typedef std::shared_ptr<FdmMatrixFreeOperator3> FdmMatrixFreeOperator3Ptr;
+
+//!
+//! \brief BLAS operator wrapper for 3-D matrix-free finite differencing.
+//!
+//! This class is FdmBlas3 with FdmMatrixFreeOperator3 as the matrix type, so
+//! that cg and pcg can run without an assembled matrix.
+//!
+struct FdmMatrixFreeBlas3 : public FdmBlas3 {
+    typedef FdmMatrixFreeOperator3 MatrixType;
+
+    //! Performs matrix-vector multiplication.
+    static void mvm(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //! Performs matrix-vector multiplication and returns the dot product of
+    //! \p v and \p result.
+    static double mvmAndDot(
+        const MatrixType& m, const VectorType& v, VectorType* result);
+
+    //! Computes residual vector (b - ax).
+    static void residual(
+        const MatrixType& a,
+        const VectorType& x,
+        const VectorType& b,
+        VectorType* result);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MATRIX_FREE_OPERATOR3_H_
@@ -0,0 +1,117 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MG_SOLVER2_H_
+#define INCLUDE_JET_FDM_MG_SOLVER2_H_
+
+#include <jet/fdm_linear_system_solver2.h>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 2-D finite difference-type linear system solver using geometric
+//!        multigrid.
+//!
+//! This class implements a V-cycle multigrid solver with red-black
+//! Gauss-Seidel smoothing. The coarse level matrices are computed from the
+//! fine level FdmMatrix2 by aggregating 2x2 blocks of cells (Galerkin
+//! coarsening with piecewise-constant prolongation), so that every level
+//! keeps the same 5-point stencil and no grid geometry is needed. Since the
+//! aggregated coarse operator is stiffer than a rediscretized one, the
+//! coarse correction is rescaled on every level. Besides being a standalone
+//! solver, this class also satisfies the preconditioner interface of pcg
+//! (see FdmMgpcgSolver2).
+//!
+class FdmMgSolver2 final : public FdmLinearSystemSolver2 {
+ public:
+    //!
+    //! Constructs the solver with given parameters.
+    //!
+    //! \param[in]  maxNumberOfLevels           Max number of multigrid levels
+    //!                                         including the finest level.
+    //! \param[in]  maxNumberOfIterations       Max number of V-cycles.
+    //! \param[in]  tolerance                   Residual tolerance.
+    //! \param[in]  numberOfSmoothingIterations Number of pre- and
+    //!                                         post-smoothing sweeps.
+    //! \param[in]  numberOfCoarsestIterations  Number of relaxation sweeps
+    //!                                         at the coarsest level.
+    //!
+    FdmMgSolver2(
+        unsigned int maxNumberOfLevels,
+        unsigned int maxNumberOfIterations,
+        double tolerance,
+        unsigned int numberOfSmoothingIterations = 2,
+        unsigned int numberOfCoarsestIterations = 10);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem2* system) override;
+
+    //!
+    //! \brief Builds the multigrid hierarchy for the given matrix.
+    //!
+    //! The matrix is referenced, not copied, so it must outlive the
+    //! subsequent calls to FdmMgSolver2::solve(const FdmVector2&,
+    //! FdmVector2*).
+    //!
+    void build(const FdmMatrix2& matrix);
+
+    //!
+    //! \brief Applies a single V-cycle with zero initial guess.
+    //!
+    //! This function approximately solves Ax = b with the matrix given to
+    //! FdmMgSolver2::build. Since the smoothing order is reversed on the way
+    //! up and the coarse correction uses a fixed scale, the operator is
+    //! linear and symmetric, and can be used as a preconditioner.
+    //!
+    void solve(const FdmVector2& b, FdmVector2* x);
+
+    //! Returns the max number of multigrid levels.
+    unsigned int maxNumberOfLevels() const;
+
+    //! Returns the number of levels of the last built hierarchy.
+    unsigned int numberOfLevels() const;
+
+    //! Returns the max number of V-cycles.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of V-cycles the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the multigrid method.
+    double tolerance() const;
+
+    //! Returns the last residual after the V-cycles.
+    double lastResidual() const;
+
+ private:
+    struct Level {
+        FdmMatrix2 A;
+        FdmVector2 x;
+        FdmVector2 b;
+    };
+
+    unsigned int _maxNumberOfLevels;
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    unsigned int _numberOfSmoothingIterations;
+    unsigned int _numberOfCoarsestIterations;
+    double _tolerance;
+    double _lastResidual;
+
+    const FdmMatrix2* _matrix = nullptr;
+    std::vector<Level> _coarseLevels;
+    std::vector<FdmVector2> _residuals;
+
+    void vCycle(
+        size_t level,
+        const FdmMatrix2& A,
+        const FdmVector2& b,
+        FdmVector2* x,
+        bool isPreconditioning);
+};
+
+typedef std::shared_ptr<FdmMgSolver2> FdmMgSolver2Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MG_SOLVER2_H_
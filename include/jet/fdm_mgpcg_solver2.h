@@ -0,0 +1,61 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MGPCG_SOLVER2_H_
+#define INCLUDE_JET_FDM_MGPCG_SOLVER2_H_
+
+#include <jet/fdm_mg_solver2.h>
+
+namespace jet {
+
+//!
+//! \brief 2-D finite difference-type linear system solver using conjugate
+//!        gradient preconditioned with a multigrid V-cycle (MGPCG).
+//!
+class FdmMgpcgSolver2 final : public FdmLinearSystemSolver2 {
+ public:
+    //!
+    //! Constructs the solver with given parameters.
+    //!
+    //! \param[in]  maxNumberOfLevels     Max number of multigrid levels of
+    //!                                   the preconditioner.
+    //! \param[in]  maxNumberOfIterations Max number of CG iterations.
+    //! \param[in]  tolerance             Residual tolerance.
+    //!
+    FdmMgpcgSolver2(
+        unsigned int maxNumberOfLevels,
+        unsigned int maxNumberOfIterations,
+        double tolerance);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem2* system) override;
+
+    //! Returns the max number of CG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of CG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the CG method.
+    double tolerance() const;
+
+    //! Returns the last residual after the CG iterations.
+    double lastResidual() const;
+
+ private:
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidualNorm;
+
+    FdmVector2 _r;
+    FdmVector2 _d;
+    FdmVector2 _q;
+    FdmVector2 _s;
+    FdmMgSolver2 _precond;
+};
+
+typedef std::shared_ptr<FdmMgpcgSolver2> FdmMgpcgSolver2Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MGPCG_SOLVER2_H_
@@ -0,0 +1,61 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_MGPCG_SOLVER3_H_
+#define INCLUDE_JET_FDM_MGPCG_SOLVER3_H_
+
+#include <jet/fdm_mg_solver3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D finite difference-type linear system solver using conjugate
+//!        gradient preconditioned with a multigrid V-cycle (MGPCG).
+//!
+class FdmMgpcgSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    //!
+    //! Constructs the solver with given parameters.
+    //!
+    //! \param[in]  maxNumberOfLevels     Max number of multigrid levels of
+    //!                                   the preconditioner.
+    //! \param[in]  maxNumberOfIterations Max number of CG iterations.
+    //! \param[in]  tolerance             Residual tolerance.
+    //!
+    FdmMgpcgSolver3(
+        unsigned int maxNumberOfLevels,
+        unsigned int maxNumberOfIterations,
+        double tolerance);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem3* system) override;
+
+    //! Returns the max number of CG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of CG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the CG method.
+    double tolerance() const;
+
+    //! Returns the last residual after the CG iterations.
+    double lastResidual() const override;
+
+ private:
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidualNorm;
+
+    FdmVector3 _r;
+    FdmVector3 _d;
+    FdmVector3 _q;
+    FdmVector3 _s;
+    FdmMgSolver3 _precond;
+};
+
+typedef std::shared_ptr<FdmMgpcgSolver3> FdmMgpcgSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MGPCG_SOLVER3_H_
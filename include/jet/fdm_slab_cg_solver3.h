@@ -0,0 +1,82 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FDM_SLAB_CG_SOLVER3_H_
+#define INCLUDE_JET_FDM_SLAB_CG_SOLVER3_H_
+
+#include <jet/fdm_linear_system_solver3.h>
+#include <jet/slab_decomposition3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D finite difference-type linear system solver using conjugate
+//!        gradient over a slab decomposition.
+//!
+//! Each rank calls solve() with the system of its own slab, whose arrays have
+//! the local size of the decomposition. The matrix rows keep the coupling to
+//! the next z-layer in FdmMatrixRow3::front, including the one of the last
+//! layer which couples to the slab of the next rank. The matrix-vector
+//! products exchange one ghost layer with each neighbor rank, and the dot
+//! products are summed over all the ranks, so every rank runs the same number
+//! of iterations and gets the same residual as the global solve.
+//!
+class FdmSlabCgSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    //! Constructs the solver with given parameters and decomposition.
+    FdmSlabCgSolver3(
+        unsigned int maxNumberOfIterations,
+        double tolerance,
+        const SlabDecomposition3Ptr& decomposition);
+
+    //! Solves the given linear system of this rank's slab.
+    bool solve(FdmLinearSystem3* system) override;
+
+    //! Returns the max number of CG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of CG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the CG method.
+    double tolerance() const;
+
+    //! Returns the last residual of the whole system after the CG iterations.
+    double lastResidual() const override;
+
+    //! Returns the decomposition.
+    const SlabDecomposition3Ptr& decomposition() const;
+
+ private:
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidual;
+    SlabDecomposition3Ptr _decomposition;
+
+    FdmVector3 _r;
+    FdmVector3 _d;
+    FdmVector3 _q;
+
+    Array2<FdmMatrixRow3> _backMatrixGhost;
+    Array2<FdmMatrixRow3> _frontMatrixGhost;
+    Array2<double> _backGhost;
+    Array2<double> _frontGhost;
+
+    void mvm(
+        const FdmMatrix3& a, const FdmVector3& x, FdmVector3* result);
+
+    void residual(
+        const FdmMatrix3& a,
+        const FdmVector3& x,
+        const FdmVector3& b,
+        FdmVector3* result);
+
+    double dot(const FdmVector3& a, const FdmVector3& b);
+};
+
+//! Shared pointer type for the FdmSlabCgSolver3.
+typedef std::shared_ptr<FdmSlabCgSolver3> FdmSlabCgSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_SLAB_CG_SOLVER3_H_
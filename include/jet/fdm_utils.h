@@ -37,6 +37,16 @@ Vector3D gradient3(
     size_t j,
     size_t k);
 
+//! Returns 3-D gradient vector from given single-precision 3-D scalar
+//! grid-like array \p data, \p gridSpacing, and array index (\p i, \p j,
+//! \p k).
+Vector3D gradient3(
+    const ConstArrayAccessor3<float>& data,
+    const Vector3D& gridSpacing,
+    size_t i,
+    size_t j,
+    size_t k);
+
 //! Returns 3-D gradient vectors from given 3-D vector grid-like array \p data,
 //! \p gridSpacing, and array index (\p i, \p j, \p k).
 std::array<Vector3D, 3> gradient3(
@@ -71,6 +81,15 @@ double laplacian3(
     size_t j,
     size_t k);
 
+//! Returns Laplacian value from given single-precision 3-D scalar grid-like
+//! array \p data, \p gridSpacing, and array index (\p i, \p j, \p k).
+double laplacian3(
+    const ConstArrayAccessor3<float>& data,
+    const Vector3D& gridSpacing,
+    size_t i,
+    size_t j,
+    size_t k);
+
 //! Returns 3-D Laplacian vectors from given 3-D vector grid-like array \p data,
 //! \p gridSpacing, and array index (\p i, \p j, \p k).
 Vector3D laplacian3(
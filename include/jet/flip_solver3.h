@@ -26,15 +26,39 @@ class FlipSolver3 : public PicSolver3 {
     //! Default destructor.
     virtual ~FlipSolver3();
 
+    //! Returns the PIC blending factor.
+    double picBlendingFactor() const;
+
+    //!
+    //! \brief Sets the PIC blending factor.
+    //!
+    //! This function sets the PIC blending factor which mixes FLIP and PIC
+    //! results when transferring velocity from grids to particles in order to
+    //! reduce the noise. The factor can be a value between 0 and 1, where 0
+    //! means no blending and 1 means full PIC. Default is 0.
+    //!
+    //! \param factor The blending factor.
+    //!
+    void setPicBlendingFactor(double factor);
+
  protected:
     //! Transfers velocity field from particles to grids.
     void transferFromParticlesToGrids() override;
 
-    //! Transfers velocity field from grids to particles.
+    //!
+    //! \brief Transfers velocity field from grids to particles.
+    //!
+    //! The new velocity and the snapshot taken after the particle-to-grid
+    //! transfer are sampled in a single pass with the same interpolation
+    //! weights, and the FLIP and PIC velocities are blended per particle.
+    //!
     void transferFromGridsToParticles() override;
 
  private:
-    FaceCenteredGrid3 _delta;
+    double _picBlendingFactor = 0.0;
+
+    //! Snapshot of the velocity right after the particle-to-grid transfer.
+    FaceCenteredGrid3 _oldVelocity;
 };
 
 }  // namespace jet
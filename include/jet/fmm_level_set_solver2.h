@@ -3,7 +3,9 @@
 #ifndef INCLUDE_JET_FMM_LEVEL_SET_SOLVER2_H_
 #define INCLUDE_JET_FMM_LEVEL_SET_SOLVER2_H_
 
+#include <jet/array2.h>
 #include <jet/level_set_solver2.h>
+#include <jet/scratch_arena.h>
 #include <memory>
 
 namespace jet {
@@ -12,7 +14,7 @@ namespace jet {
 //! \brief Two-dimensional fast marching method (FMM) implementation.
 //!
 //! This class implements 2-D FMM. First-order upwind-style differencing is used
-//! to solve the PDE.
+//! to solve the PDE. The marker buffer is kept between the calls.
 //!
 //! \see https://math.berkeley.edu/~sethian/2006/Explanations/fast_marching_explain.html
 //! \see Sethian, James A. "A fast marching level set method for monotonically
@@ -81,6 +83,9 @@ class FmmLevelSetSolver2 final : public LevelSetSolver2 {
         FaceCenteredGrid2* output) override;
 
  private:
+    Array2<char> _markers;
+    ScratchArena _scratch;
+
     void extrapolate(
         const ConstArrayAccessor2<double>& input,
         const ConstArrayAccessor2<double>& sdf,
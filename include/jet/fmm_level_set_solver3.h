@@ -3,16 +3,26 @@
 #ifndef INCLUDE_JET_FMM_LEVEL_SET_SOLVER3_H_
 #define INCLUDE_JET_FMM_LEVEL_SET_SOLVER3_H_
 
+#include <jet/array3.h>
 #include <jet/level_set_solver3.h>
+#include <jet/scratch_arena.h>
 #include <memory>
 
 namespace jet {
 
+class FmmBucketTrialQueue;
+
 //!
 //! \brief Three-dimensional fast marching method (FMM) implementation.
 //!
 //! This class implements 3-D FMM. First-order upwind-style differencing is used
-//! to solve the PDE.
+//! to solve the PDE. The marker buffers are kept between the calls. A vector
+//! field is extrapolated with a single march for all of its components, and
+//! the components of a face-centered field are extrapolated in parallel.
+//!
+//! The trial cells are ordered by a binary heap by default. The bucketed
+//! queue of setIsUsingBucketedQueue takes O(1) per cell instead, at the cost
+//! of accepting the cells within a bucket width in any order.
 //!
 //! \see https://math.berkeley.edu/~sethian/2006/Explanations/fast_marching_explain.html
 //! \see Sethian, James A. "A fast marching level set method for monotonically
@@ -24,6 +34,9 @@ class FmmLevelSetSolver3 final : public LevelSetSolver3 {
     //! Default constructor.
     FmmLevelSetSolver3();
 
+    //! Default destructor.
+    ~FmmLevelSetSolver3();
+
     //!
     //! Reinitializes given scalar field to signed-distance field.
     //!
@@ -80,13 +93,42 @@ class FmmLevelSetSolver3 final : public LevelSetSolver3 {
         double maxDistance,
         FaceCenteredGrid3* output) override;
 
+    //! Returns true if the bucketed trial queue is used.
+    bool isUsingBucketedQueue() const;
+
+    //!
+    //! \brief Sets true to use the bucketed ("untidy") trial queue.
+    //!
+    //! The trial cells are sorted into buckets of the quantized distance, so
+    //! the march takes O(1) per cell instead of the O(log n) heap operations.
+    //! The cells of a bucket are accepted in any order, which adds an error
+    //! of about the bucket width. The nodes of the queue are pooled and kept
+    //! between the calls. Disabled by default.
+    //!
+    void setIsUsingBucketedQueue(bool isUsing);
+
+    //! Returns the bucket width relative to the smallest grid spacing.
+    double bucketWidth() const;
+
+    //!
+    //! \brief Sets the bucket width relative to the smallest grid spacing.
+    //!
+    //! The width should be positive. The default is 0.1.
+    //!
+    void setBucketWidth(double width);
+
  private:
-    void extrapolate(
-        const ConstArrayAccessor3<double>& input,
-        const ConstArrayAccessor3<double>& sdf,
-        const Vector3D& gridSpacing,
-        double maxDistance,
-        ArrayAccessor3<double> output);
+    // One per face-centered component, which are extrapolated in parallel
+    Array3<char> _markers[3];
+    std::unique_ptr<FmmBucketTrialQueue> _bucketQueues[3];
+    ScratchArena _scratch;
+    bool _isUsingBucketedQueue = false;
+    double _bucketWidth = 0.1;
+
+    // Returns the bucketed queue of the component, or nullptr for the heap
+    FmmBucketTrialQueue* bucketQueue(size_t component);
+
+    double bucketWidth(const Vector3D& gridSpacing) const;
 };
 
 typedef std::shared_ptr<FmmLevelSetSolver3> FmmLevelSetSolver3Ptr;
@@ -0,0 +1,30 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_FRAME_FILENAME_H_
+#define INCLUDE_JET_FRAME_FILENAME_H_
+
+#include <string>
+
+namespace jet {
+
+//!
+//! \brief Returns true if the pattern has exactly one frame number field.
+//!
+//! The field is a printf-style "%d" with an optional zero-padded width, such
+//! as "%06d" in "frame_%06d.pos". Any other '%' in the pattern, including
+//! "%%", makes it invalid, so the pattern is never used as a printf format.
+//!
+bool isFrameFilenamePattern(const std::string& pattern);
+
+//!
+//! \brief Returns the filename of the given frame from the pattern.
+//!
+//! The frame number field of the pattern is replaced with the frame number,
+//! formatted the same way printf does. Throws std::invalid_argument if
+//! isFrameFilenamePattern() is false for the pattern.
+//!
+std::string frameFilename(const std::string& pattern, int frame);
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FRAME_FILENAME_H_
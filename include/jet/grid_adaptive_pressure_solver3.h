@@ -0,0 +1,166 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_GRID_ADAPTIVE_PRESSURE_SOLVER3_H_
+#define INCLUDE_JET_GRID_ADAPTIVE_PRESSURE_SOLVER3_H_
+
+#include <jet/array3.h>
+#include <jet/fdm_compressed_linear_system.h>
+#include <jet/fdm_linear_system_solver3.h>
+#include <jet/grid_boundary_condition_solver3.h>
+#include <jet/grid_pressure_solver3.h>
+#include <jet/point3.h>
+#include <memory>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D single-phase pressure solver on an octree of the fluid cells.
+//!
+//! The pressure of a deep liquid varies smoothly away from the free surface,
+//! so this solver only keeps the grid resolution in a band around it. The
+//! fluid cells are grouped into the leaves of an octree over the grid:
+//! a leaf of level l is an aligned block of 2^l x 2^l x 2^l fluid cells
+//! whose depth below the surface, measured by the fluid SDF, is at least
+//! the surface band width times the leaf size. Each leaf has a single
+//! pressure unknown, and two leaves are coupled through each grid face
+//! between them with the finite volume flux of the distance between their
+//! centers. The cells, boundaries and atmosphere are marked like
+//! GridSinglePhasePressureSolver3 does, which this solver matches exactly
+//! when the maximum level is zero.
+//!
+//! After the pressure gradient is applied to the faces between the leaves,
+//! the faces inside each coarse leaf are corrected by a local Poisson solve
+//! with the leaf faces fixed, so the velocity is divergence-free in every
+//! fluid cell and not only in the average over a leaf.
+//!
+class GridAdaptivePressureSolver3 : public GridPressureSolver3 {
+ public:
+    //! Default constructor.
+    GridAdaptivePressureSolver3();
+
+    //! Default destructor.
+    virtual ~GridAdaptivePressureSolver3();
+
+    //!
+    //! \brief Solves the pressure term and apply it to the velocity field.
+    //!
+    //! The arguments are the same as GridSinglePhasePressureSolver3::solve.
+    //! The negative region of \p fluidSdf is the fluid, and its distance to
+    //! the surface decides the size of the leaves.
+    //!
+    //! \param[in]    input                 The input velocity field.
+    //! \param[in]    timeIntervalInSeconds The time interval for the sim.
+    //! \param[inout] output                The output velocity field.
+    //! \param[in]    boundarySdf           The SDF of the boundary.
+    //! \param[in]    fluidSdf              The SDF of the fluid/atmosphere.
+    //!
+    void solve(
+        const FaceCenteredGrid3& input,
+        double timeIntervalInSeconds,
+        FaceCenteredGrid3* output,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(kMaxD),
+        const ScalarField3& fluidSdf
+            = ConstantScalarField3(-kMaxD)) override;
+
+    //!
+    //! \brief Returns the best boundary condition solver for this solver.
+    //!
+    //! Like GridSinglePhasePressureSolver3, this solver encodes the boundaries
+    //! like blocks, so GridBlockedBoundaryConditionSolver3 is returned.
+    //!
+    GridBoundaryConditionSolver3Ptr
+        suggestedBoundaryConditionSolver() const override;
+
+    //!
+    //! \brief Sets the linear system solver.
+    //!
+    //! The system over the leaves is solved as an FdmCompressedLinearSystem,
+    //! so the solver must support compressed systems, such as FdmCgSolver3
+    //! and FdmIccgSolver3. There is no grid system to fall back to, so this
+    //! function throws std::invalid_argument for the other solvers.
+    //!
+    void setLinearSystemSolver(const FdmLinearSystemSolver3Ptr& solver);
+
+    //! Returns the maximum level of the leaves.
+    unsigned int maxLevel() const;
+
+    //!
+    //! \brief Sets the maximum level of the leaves.
+    //!
+    //! The largest leaves have 2^level cells along each axis. Zero turns the
+    //! adaptivity off. The level should be at most 8.
+    //!
+    void setMaxLevel(unsigned int level);
+
+    //! Returns the surface band width in the number of leaf sizes.
+    double surfaceBandWidth() const;
+
+    //!
+    //! \brief Sets the surface band width in the number of leaf sizes.
+    //!
+    //! A leaf of n cells along each axis is used only if all of its cells are
+    //! at least width x n cells deep below the surface. The width should be
+    //! at least one.
+    //!
+    void setSurfaceBandWidth(double width);
+
+    //! Returns the pressure field, which is constant over each leaf.
+    const FdmVector3& pressure() const;
+
+    //! Returns the number of the pressure unknowns of the last solve.
+    size_t numberOfUnknowns() const;
+
+    //! Returns the number of the fluid cells of the last solve.
+    size_t numberOfFluidCells() const;
+
+    //! Returns the last number of iterations of the linear system solver.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the last residual of the linear system solver.
+    double lastResidual() const override;
+
+    //! Returns the largest absolute velocity component of the last output.
+    double lastMaxVelocity() const override;
+
+ private:
+    FdmLinearSystemSolver3Ptr _systemSolver;
+    unsigned int _maxLevel = 3;
+    double _surfaceBandWidth = 2.0;
+    FdmCompressedLinearSystem _system;
+    FdmVector3 _pressure;
+    FdmVector3 _divergence;
+    Array3<char> _markers;
+    Array3<double> _depths;
+    Array3<char> _levels;
+    Array3<size_t> _leafIndices;
+    std::vector<Point3UI> _leafOrigins;
+    std::vector<size_t> _coarseLeaves;
+    size_t _numberOfFluidCells = 0;
+    double _lastMaxVelocity = -1.0;
+
+    void buildMarkers(
+        const FaceCenteredGrid3& input,
+        const ScalarField3& boundarySdf,
+        const ScalarField3& fluidSdf);
+
+    void buildLeaves();
+
+    void buildSystem(const FaceCenteredGrid3& input);
+
+    void applyPressureGradient(
+        const FaceCenteredGrid3& input,
+        FaceCenteredGrid3* output);
+
+    void correctCoarseLeaves(
+        const FaceCenteredGrid3& input,
+        FaceCenteredGrid3* output);
+};
+
+typedef std::shared_ptr<GridAdaptivePressureSolver3>
+    GridAdaptivePressureSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_ADAPTIVE_PRESSURE_SOLVER3_H_
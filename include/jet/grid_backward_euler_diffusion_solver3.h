@@ -4,6 +4,7 @@
 #define INCLUDE_JET_GRID_BACKWARD_EULER_DIFFUSION_SOLVER3_H_
 
 #include <jet/constant_scalar_field3.h>
+#include <jet/fdm_compressed_linear_system.h>
 #include <jet/fdm_linear_system_solver3.h>
 #include <jet/grid_diffusion_solver3.h>
 #include <limits>
@@ -21,6 +22,11 @@ namespace jet {
 //! values for those parameters will still impact the accuracy of the result.
 //! To solve the backward Euler method, a linear system solver is used and
 //! incomplete Cholesky conjugate gradient method is used by default.
+//! The matrix is kept between the solve calls and only rebuilt when the grid
+//! size, the diffusion coefficient times the time interval, or the boundary
+//! markers change. When the matrix is reused, such as for the components of a
+//! collocated vector grid, the linear system solver is asked to reuse its
+//! preconditioner as well.
 //!
 class GridBackwardEulerDiffusionSolver3 final : public GridDiffusionSolver3 {
  public:
@@ -96,13 +102,47 @@ class GridBackwardEulerDiffusionSolver3 final : public GridDiffusionSolver3 {
     //! Sets the linear system solver for this diffusion solver.
     void setLinearSystemSolver(const FdmLinearSystemSolver3Ptr& solver);
 
+    //! Returns true if the linear system is built over the fluid cells only.
+    bool isUsingCompressedSystem() const;
+
+    //!
+    //! \brief Sets true to build the linear system over the fluid cells only.
+    //!
+    //! The air and solid cells only have identity rows that keep their input
+    //! values, which is most of the grid for a liquid. When enabled, those
+    //! rows are dropped and the system is solved as an
+    //! FdmCompressedLinearSystem over the fluid cells, as the pressure
+    //! solvers do, so the cost of a viscosity solve scales with the fluid
+    //! volume. The compressed matrix is cached in the same way as the full
+    //! one. It needs a linear system solver that supports compressed
+    //! systems, such as FdmCgSolver3 and the default FdmIccgSolver3. With the
+    //! other solvers, the full system is solved instead.
+    //!
+    void setIsUsingCompressedSystem(bool isUsing);
+
  private:
     BoundaryType _boundaryType;
     FdmLinearSystem3 _system;
     FdmLinearSystemSolver3Ptr _systemSolver;
     Array3<char> _markers;
+    Array3<char> _newMarkers;
+    Vector3D _matrixCoefficient;
+    bool _isMatrixValid = false;
+    bool _isUsingCompressedSystem = false;
+    bool _isMatrixCompressed = false;
+    FdmCompressedLinearSystem _compressedSystem;
+    Array3<size_t> _compressedIndices;
+
+    bool buildSystemMatrix(
+        const Size3& size,
+        const std::function<Vector3D(size_t, size_t, size_t)>& pos,
+        const ScalarField3& boundarySdf,
+        const ScalarField3& fluidSdf,
+        const Vector3D& c);
 
-    void buildMarkers(
+    void solveSystem(bool isMatrixReused);
+
+    bool buildMarkers(
         const Size3& size,
         const std::function<Vector3D(size_t, size_t, size_t)>& pos,
         const ScalarField3& boundarySdf,
@@ -112,6 +152,10 @@ class GridBackwardEulerDiffusionSolver3 final : public GridDiffusionSolver3 {
         const Size3& size,
         const Vector3D& c);
 
+    void buildCompressedMatrix(const Vector3D& c);
+
+    void solveCompressedSystem();
+
     void buildVectors(
         const ConstArrayAccessor3<double>& f,
         const Vector3D& c);
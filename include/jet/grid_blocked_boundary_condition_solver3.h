@@ -3,9 +3,11 @@
 #ifndef INCLUDE_JET_GRID_BLOCKED_BOUNDARY_CONDITION_SOLVER3_H_
 #define INCLUDE_JET_GRID_BLOCKED_BOUNDARY_CONDITION_SOLVER3_H_
 
+#include <jet/bit_array3.h>
 #include <jet/grid_fractional_boundary_condition_solver3.h>
 
 #include <memory>
+#include <vector>
 
 namespace jet {
 
@@ -35,8 +37,8 @@ class GridBlockedBoundaryConditionSolver3 final
         FaceCenteredGrid3* velocity,
         unsigned int extrapolationDepth = 5) override;
 
-    //! Returns the marker which is 1 if occupied by the collider.
-    const Array3<char>& marker() const;
+    //! Returns the marker whose bits are set if occupied by the collider.
+    const BitArray3& marker() const;
 
  protected:
     //! Invoked when a new collider is set.
@@ -46,7 +48,10 @@ class GridBlockedBoundaryConditionSolver3 final
         const Vector3D& gridOrigin) override;
 
  private:
-    Array3<char> _marker;
+    BitArray3 _marker;
+
+    // The u-, v-, and w-faces between the collider cells and the others
+    std::vector<size_t> _interfaceFaces[3];
 };
 
 typedef std::shared_ptr<GridBlockedBoundaryConditionSolver3>
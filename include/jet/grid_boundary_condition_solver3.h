@@ -85,6 +85,8 @@ class GridBoundaryConditionSolver3 {
     Size3 _gridSize;
     Vector3D _gridSpacing;
     Vector3D _gridOrigin;
+    uint64_t _colliderVersion = 0;
+    bool _isColliderUpdated = false;
     int _closedDomainBoundaryFlag = kDirectionAll;
 };
 
@@ -0,0 +1,203 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_GRID_CACHE3_H_
+#define INCLUDE_JET_GRID_CACHE3_H_
+
+#include <jet/array_accessor3.h>
+#include <jet/collocated_vector_grid3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/scalar_grid3.h>
+#include <jet/size3.h>
+#include <jet/vector3.h>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jet {
+
+class MappedFile;
+
+//!
+//! \brief Writes grids to a cache that can be memory-mapped and used in place.
+//!
+//! The cache starts with a header that holds the tag "JETGCACH", the format
+//! version, and the number of channels. Each channel follows with its own
+//! header (name, type, resolution, grid spacing, origin, and the size, data
+//! origin, and offset of each data array), and the data arrays are stored as
+//! is, starting at 64-byte aligned offsets. A scalar or collocated vector
+//! grid has a single array, and a face-centered grid has the u, v, and w
+//! arrays. All values are stored in the byte order of the host.
+//!
+//! The writer does not copy the grids; it keeps the references and writes
+//! the data straight from them, so they must stay alive until write is
+//! called.
+//!
+class GridCacheWriter3 {
+ public:
+    //! Adds a scalar grid channel. \p name should be shorter than 48
+    //! characters.
+    void addScalarGrid(const std::string& name, const ScalarGrid3& grid);
+
+    //! Adds a collocated vector grid channel. \p name should be shorter than
+    //! 48 characters.
+    void addVectorGrid(
+        const std::string& name,
+        const CollocatedVectorGrid3& grid);
+
+    //! Adds a face-centered grid channel. \p name should be shorter than 48
+    //! characters.
+    void addFaceCenteredGrid(
+        const std::string& name,
+        const FaceCenteredGrid3& grid);
+
+    //! Writes the cache to \p strm.
+    void write(std::ostream* strm) const;
+
+ private:
+    struct DataArray {
+        Size3 size;
+        Vector3D dataOrigin;
+        const char* data;
+        size_t bytes;
+    };
+
+    struct Channel {
+        std::string name;
+        uint32_t type;
+        Size3 resolution;
+        Vector3D gridSpacing;
+        Vector3D origin;
+        std::vector<DataArray> arrays;
+    };
+
+    std::vector<Channel> _channels;
+
+    Channel* addChannel(
+        const std::string& name,
+        uint32_t type,
+        const Grid3& grid);
+};
+
+//!
+//! \brief Reads the grid cache written by GridCacheWriter3.
+//!
+//! The file is memory-mapped, and the channels are returned as read-only
+//! views into the mapped file without copying, so the pages are loaded only
+//! when the data is accessed. The views are valid until the reader is closed
+//! or destroyed.
+//!
+class GridCacheReader3 {
+ public:
+    JET_NON_COPYABLE(GridCacheReader3)
+
+    //! Constructs an empty reader.
+    GridCacheReader3();
+
+    //! Destructor.
+    ~GridCacheReader3();
+
+    //! Opens the cache at \p filename. Returns false if the file cannot be
+    //! opened or is not a valid cache, in which case the reader is empty.
+    bool open(const std::string& filename);
+
+    //! Closes the file and invalidates the views.
+    void close();
+
+    //! Returns the number of channels.
+    size_t numberOfChannels() const;
+
+    //! Returns the name of the i-th channel.
+    const std::string& channelName(size_t i) const;
+
+    //! Returns true if the cache has the scalar grid channel of \p name.
+    bool hasScalarGrid(const std::string& name) const;
+
+    //! Returns true if the cache has the collocated vector grid channel of
+    //! \p name.
+    bool hasVectorGrid(const std::string& name) const;
+
+    //! Returns true if the cache has the face-centered grid channel of
+    //! \p name.
+    bool hasFaceCenteredGrid(const std::string& name) const;
+
+    //! Returns the grid resolution of the channel of \p name.
+    Size3 resolution(const std::string& name) const;
+
+    //! Returns the grid spacing of the channel of \p name.
+    Vector3D gridSpacing(const std::string& name) const;
+
+    //! Returns the grid origin of the channel of \p name.
+    Vector3D origin(const std::string& name) const;
+
+    //!
+    //! \brief Returns the data origin of the channel of \p name.
+    //!
+    //! For a face-centered grid, \p axis selects the u (0), v (1), or w (2)
+    //! data. It should be 0 for the other grids.
+    //!
+    Vector3D dataOrigin(const std::string& name, size_t axis = 0) const;
+
+    //! Returns the data of the scalar grid of \p name, or an empty view if not
+    //! found.
+    ConstArrayAccessor3<double> scalarData(const std::string& name) const;
+
+    //! Returns the data of the collocated vector grid of \p name, or an empty
+    //! view if not found.
+    ConstArrayAccessor3<Vector3D> vectorData(const std::string& name) const;
+
+    //! Returns the u (0), v (1), or w (2) data of the face-centered grid of
+    //! \p name, or an empty view if not found.
+    ConstArrayAccessor3<double> faceCenteredData(
+        const std::string& name,
+        size_t axis) const;
+
+    //!
+    //! \brief Copies the scalar grid of \p name to \p grid.
+    //!
+    //! The grid is resized to the cached resolution, grid spacing, and origin.
+    //! Returns false if the channel is not found or the data size does not
+    //! match the grid type.
+    //!
+    bool readScalarGrid(const std::string& name, ScalarGrid3* grid) const;
+
+    //! Copies the collocated vector grid of \p name to \p grid. Returns false
+    //! if the channel is not found or the data size does not match.
+    bool readVectorGrid(
+        const std::string& name,
+        CollocatedVectorGrid3* grid) const;
+
+    //! Copies the face-centered grid of \p name to \p grid. Returns false if
+    //! the channel is not found.
+    bool readFaceCenteredGrid(
+        const std::string& name,
+        FaceCenteredGrid3* grid) const;
+
+ private:
+    struct DataArray {
+        Size3 size;
+        Vector3D dataOrigin;
+        const char* data;
+    };
+
+    struct Channel {
+        std::string name;
+        uint32_t type;
+        Size3 resolution;
+        Vector3D gridSpacing;
+        Vector3D origin;
+        std::vector<DataArray> arrays;
+    };
+
+    std::unique_ptr<MappedFile> _file;
+    std::vector<Channel> _channels;
+
+    const Channel* findChannel(const std::string& name) const;
+
+    const Channel* findChannel(const std::string& name, uint32_t type) const;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_CACHE3_H_
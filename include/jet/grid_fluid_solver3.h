@@ -4,6 +4,8 @@
 #define INCLUDE_JET_GRID_FLUID_SOLVER3_H_
 
 #include <jet/advection_solver3.h>
+#include <jet/array_utils.h>
+#include <jet/bit_array3.h>
 #include <jet/cell_centered_scalar_grid3.h>
 #include <jet/collider3.h>
 #include <jet/face_centered_grid3.h>
@@ -12,6 +14,8 @@
 #include <jet/grid_pressure_solver3.h>
 #include <jet/grid_system_data3.h>
 #include <jet/physics_animation.h>
+#include <functional>
+#include <vector>
 
 namespace jet {
 
@@ -146,6 +150,89 @@ class GridFluidSolver3 : public PhysicsAnimation {
     //!
     Vector3D gridOrigin() const;
 
+    //! Returns the preview scale of the grid.
+    double previewScale() const;
+
+    //!
+    //! \brief Coarsens the grid by \p factor for a quick preview.
+    //!
+    //! This function resizes the grid to the resolution of the full grid
+    //! divided by \p factor, rounded and at least one cell per axis, and
+    //! stretches the grid spacing so that the grid keeps the bounding box of
+    //! the full grid. The full grid is the one at the preview scale of 1, or
+    //! the max domain while the auto bounds are enabled, so setting the scale
+    //! back to 1 restores it. The max CFL number and the extrapolation depths
+    //! are in cells, so they keep their meaning on the coarse grid. The
+    //! parameters in world units that are tied to the resolution, such as the
+    //! spacing of the emitted particles, should be taken from gridSpacing()
+    //! or scaled with ParticleEmitter3::setPreviewScale.
+    //!
+    //! Like resizeGrid(), this function does not resample the fields, so it
+    //! should be called before the fields are initialized. resizeGrid() sets
+    //! a new full grid and resets the scale to 1. The factor should be equal
+    //! to or greater than 1.
+    //!
+    void setPreviewScale(double factor);
+
+    //!
+    //! \brief Moves the simulation domain by \p offset cells.
+    //!
+    //! This is a shortcut for gridSystemData()->scroll(). The fields keep
+    //! their world positions, and the cells that enter the domain take the
+    //! values at the boundary they enter through. It should be called between
+    //! the frames, and the collider is rasterized again at the next step.
+    //!
+    //! \see GridSystemData3::scroll
+    //!
+    void scrollGrid(const Point3I& offset);
+
+    //!
+    //! \brief Moves the simulation domain by whole cells so that its center
+    //! is the closest to \p center, and returns the offset in cells.
+    //!
+    //! A solver following a moving object, such as a smoke trail of a
+    //! vehicle, can call this at each frame to keep the object within a
+    //! domain of a fixed resolution.
+    //!
+    Point3I scrollGridToward(const Vector3D& center);
+
+    //! Returns true if the grid is cropped to the active region.
+    bool isUsingAutoBounds() const;
+
+    //!
+    //! \brief Sets whether the grid is cropped to the active region.
+    //!
+    //! When enabled, the current grid becomes the max domain, and at the
+    //! beginning of each sub-time-step the grids are cropped to the cells of
+    //! the max domain around activeRegion(), so that every stage including
+    //! the pressure solve only runs over the region with the fluid. The
+    //! cropped grid is aligned with the cells of the max domain, and the
+    //! cells that enter it are extended from its old boundary. Its sides
+    //! inside the max domain are open. resizeGrid() resets the max domain
+    //! while enabled, and disabling grows the grid back to the max domain.
+    //! Passes that keep their own grids, such as the up-res pass of
+    //! GridSmokeSolver3, restart when the grid changes.
+    //!
+    void setIsUsingAutoBounds(bool isUsing);
+
+    //! Returns the padding of the auto bounds in cells.
+    size_t autoBoundsPadding() const;
+
+    //!
+    //! \brief Sets the padding of the auto bounds in cells.
+    //!
+    //! The active region is grown by the padding plus the max CFL number in
+    //! cells, so the fluid cannot leave the grid within a sub-time-step.
+    //! Default is 2.
+    //!
+    void setAutoBoundsPadding(size_t padding);
+
+    //! Returns the resolution of the max domain of the auto bounds.
+    Size3 maxDomainResolution() const;
+
+    //! Returns the origin of the max domain of the auto bounds.
+    Vector3D maxDomainOrigin() const;
+
     //!
     //! \brief Returns the velocity field.
     //!
@@ -160,6 +247,17 @@ class GridFluidSolver3 : public PhysicsAnimation {
     //! Sets the collider.
     void setCollider(const Collider3Ptr& newCollider);
 
+    //! Writes a checkpoint of the parameters and the grids to \p strm.
+    void serialize(std::ostream* strm) const override;
+
+    //!
+    //! \brief Restores the parameters and the grids from \p strm.
+    //!
+    //! The grid system data should have the same data grids as the solver
+    //! that wrote the checkpoint, which is the case for the same solver type.
+    //!
+    void deserialize(std::istream* strm) override;
+
  protected:
     //! Called when advancing a single time-step.
     void onAdvanceTimeStep(double timeIntervalInSeconds) override;
@@ -177,6 +275,20 @@ class GridFluidSolver3 : public PhysicsAnimation {
     unsigned int numberOfSubTimeSteps(
         double timeIntervalInSeconds) const override;
 
+    //!
+    //! \brief Called after all the sub-time-steps of a frame.
+    //!
+    //! This function advects the data whose update interval has not been
+    //! reached by the end of the frame, using the time accumulated since
+    //! their last update.
+    //!
+    //! \see GridSystemData3::advectableScalarDataUpdateIntervalAt
+    //!
+    void onEndAdvanceFrame(double timeIntervalInSeconds) override;
+
+    //! Fills in the CFL number, the pressure solve, and the grid memory.
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
     //! Called at the beginning of a time-step.
     virtual void onBeginAdvanceTimeStep(double timeIntervalInSeconds);
 
@@ -199,7 +311,18 @@ class GridFluidSolver3 : public PhysicsAnimation {
     //! Computes the pressure term using the pressure solver.
     virtual void computePressure(double timeIntervalInSeconds);
 
-    //! Computes the advection term using the advection solver.
+    //!
+    //! \brief Computes the advection term using the advection solver.
+    //!
+    //! The velocity and the groups of the advectable data that are due are
+    //! advected at the same time by parallelInvoke, since none of them reads
+    //! the output of another: the data are carried by the velocity back
+    //! buffer, which holds the velocity before the advection. Each group is
+    //! extrapolated into the collider by the same task that advects it. The
+    //! advection solver is therefore called from multiple threads for
+    //! different outputs. The boundary condition is applied once all the
+    //! tasks are done.
+    //!
     virtual void computeAdvection(double timeIntervalInSeconds);
 
     //!
@@ -215,6 +338,19 @@ class GridFluidSolver3 : public PhysicsAnimation {
     //! Computes the gravity term.
     void computeGravity(double timeIntervalInSeconds);
 
+    //!
+    //! \brief Returns an upper bound of the CFL number for given time
+    //!     interval.
+    //!
+    //! Within a frame, this function uses the largest velocity that the
+    //! pressure solver found while applying the pressure gradient of the last
+    //! sub-time-step, so it does not scan the velocity field. Otherwise, such
+    //! as for the first sub-time-step of a frame, when the pressure solver
+    //! does not track the velocity, or when a collider may impose its own
+    //! velocity, it falls back to GridFluidSolver3::cfl.
+    //!
+    double estimatedCfl(double timeIntervalInSeconds) const;
+
     //!
     //! \brief Applies the boundary condition to the velocity field.
     //!
@@ -235,21 +371,94 @@ class GridFluidSolver3 : public PhysicsAnimation {
     //! Returns the signed-distance field representation of the collider.
     const CellCenteredScalarGrid3& colliderSdf() const;
 
+    //!
+    //! \brief Returns the bounding box of the region that needs simulation.
+    //!
+    //! The auto bounds crop the grid around this region. The default
+    //! implementation returns the bounds of the cell centers inside
+    //! fluidSdf(). An empty box keeps the current grid.
+    //!
+    virtual BoundingBox3D activeRegion() const;
+
+    //!
+    //! \brief Returns the closed domain boundary flag of the current grid.
+    //!
+    //! This is closedDomainBoundaryFlag() without the sides of a cropped grid
+    //! that are inside the max domain, which are open.
+    //!
+    int gridClosedDomainBoundaryFlag() const;
+
  private:
     Vector3D _gravity = Vector3D(0.0, -9.8, 0.0);
     double _viscosityCoefficient = 0.0;
     double _maxCfl = 5.0;
+    double _maxVelocity = -1.0;
     int _closedDomainBoundaryFlag = kDirectionAll;
+    bool _isUsingAutoBounds = false;
+    size_t _autoBoundsPadding = 2;
+    Size3 _maxDomainResolution;
+    Vector3D _maxDomainOrigin;
+    double _previewScale = 1.0;
+    Size3 _fullResolution;
+    Vector3D _fullGridSpacing;
+    Vector3D _fullGridOrigin;
 
     GridSystemData3Ptr _grids;
     Collider3Ptr _collider;
     CellCenteredScalarGrid3 _colliderSdf;
+    uint64_t _colliderSdfVersion = 0;
+    bool _isColliderSdfValid = false;
 
     AdvectionSolver3Ptr _advectionSolver;
     GridDiffusionSolver3Ptr _diffusionSolver;
     GridPressureSolver3Ptr _pressureSolver;
     GridBoundaryConditionSolver3Ptr _boundaryConditionSolver;
 
+    // Buffers to extrapolate a grid into the collider, one per component of
+    // a face-centered grid so that the components run at the same time
+    struct ColliderExtrapolation {
+        BitArray3 markers[3];
+        ExtrapolationBuffers3 buffers[3];
+    };
+
+    ColliderExtrapolation _colliderExtrapolation;
+
+    // One per advection task, so that the tasks can extrapolate their grids
+    // at the same time
+    std::vector<ColliderExtrapolation> _taskExtrapolations;
+
+    // Sub-time-steps and time accumulated since the last advection of each
+    // advectable data
+    struct PendingAdvection {
+        unsigned int numberOfSteps = 0;
+        double timeIntervalInSeconds = 0.0;
+    };
+
+    std::vector<PendingAdvection> _pendingScalarAdvections;
+    std::vector<PendingAdvection> _pendingVectorAdvections;
+
+    void addDataAdvectionTasks(
+        const FaceCenteredGrid3& flow,
+        double timeIntervalInSeconds,
+        bool isEndOfFrame,
+        std::vector<std::function<void()>>* tasks);
+
+    void extrapolateIntoCollider(
+        ScalarGrid3* grid, ColliderExtrapolation* extrapolation);
+
+    void extrapolateIntoCollider(
+        ScalarGrid3F* grid, ColliderExtrapolation* extrapolation);
+
+    void extrapolateIntoCollider(
+        CollocatedVectorGrid3* grid, ColliderExtrapolation* extrapolation);
+
+    void extrapolateIntoCollider(
+        FaceCenteredGrid3* grid, ColliderExtrapolation* extrapolation);
+
+    Point3I gridOffsetInMaxDomain() const;
+
+    void updateAutoBounds();
+
     void beginAdvanceTimeStep(double timeIntervalInSeconds);
 
     void endAdvanceTimeStep(double timeIntervalInSeconds);
@@ -3,10 +3,13 @@
 #ifndef INCLUDE_JET_GRID_FRACTIONAL_BOUNDARY_CONDITION_SOLVER3_H_
 #define INCLUDE_JET_GRID_FRACTIONAL_BOUNDARY_CONDITION_SOLVER3_H_
 
+#include <jet/array_utils.h>
+#include <jet/bit_array3.h>
 #include <jet/cell_centered_scalar_grid3.h>
 #include <jet/grid_boundary_condition_solver3.h>
 
 #include <memory>
+#include <vector>
 
 namespace jet {
 
@@ -16,7 +19,9 @@ namespace jet {
 //! This class constrains the velocity field by projecting the flow to the
 //! signed-distance field representation of the collider. This implementation
 //! should pair up with GridFractionalSinglePhasePressureSolver3 to provide
-//! sub-grid resolutional velocity projection.
+//! sub-grid resolutional velocity projection. The faces near the collider
+//! are listed when the collider is updated, so the constraint only visits
+//! those faces besides the extrapolation band.
 //!
 class GridFractionalBoundaryConditionSolver3
     : public GridBoundaryConditionSolver3 {
@@ -50,6 +55,14 @@ class GridFractionalBoundaryConditionSolver3
 
  private:
     CellCenteredScalarGrid3 _colliderSdf;
+    ExtrapolationBuffers3 _extrapolationBuffers[3];
+
+    // Per u, v, and w: the faces with fluid, the faces inside the collider,
+    // the faces to project to the collider's surface, and their new values
+    BitArray3 _faceMarkers[3];
+    std::vector<size_t> _colliderFaces[3];
+    std::vector<size_t> _projectedFaces[3];
+    std::vector<double> _projectedValues[3];
 };
 
 typedef std::shared_ptr<GridFractionalBoundaryConditionSolver3>
@@ -4,6 +4,7 @@
 #define INCLUDE_JET_GRID_FRACTIONAL_SINGLE_PHASE_PRESSURE_SOLVER3_H_
 
 #include <jet/cell_centered_scalar_grid3.h>
+#include <jet/fdm_compressed_linear_system.h>
 #include <jet/fdm_linear_system_solver3.h>
 #include <jet/grid_boundary_condition_solver3.h>
 #include <jet/grid_pressure_solver3.h>
@@ -56,6 +57,13 @@ class GridFractionalSinglePhasePressureSolver3 : public GridPressureSolver3 {
     //! field with -kMaxD will be used for \p fluidSdf which means it's fully
     //! occupied with fluid without any atmosphere.
     //!
+    //! The assembled matrix is kept between the calls, and it is rebuilt only
+    //! when the face weights, the sampled fluid SDF, or the grid spacing
+    //! change, so FdmIccgSolver3 keeps its preconditioner for static domains.
+    //! The SDFs that are scalar grids with the same cell centers as \p input,
+    //! such as the collider SDF and the level set of the liquid solvers, are
+    //! read directly instead of being sampled.
+    //!
     //! \param[in]    input                 The input velocity field.
     //! \param[in]    timeIntervalInSeconds The time interval for the sim.
     //! \param[inout] output                The output velocity field.
@@ -83,26 +91,90 @@ class GridFractionalSinglePhasePressureSolver3 : public GridPressureSolver3 {
     GridBoundaryConditionSolver3Ptr
         suggestedBoundaryConditionSolver() const override;
 
-    //! Sets the linear system solver.
+    //!
+    //! \brief Sets the linear system solver.
+    //!
+    //! If the solver is an FdmMatrixFreeCgSolver3, the pressure equation is
+    //! solved matrix-free: the Poisson operator is computed on the fly from
+    //! the face weights and the fluid SDF, and FdmMatrix3 is never assembled.
+    //!
     void setLinearSystemSolver(const FdmLinearSystemSolver3Ptr& solver);
 
     //! Returns the pressure field.
     const FdmVector3& pressure() const;
 
+    //! Returns true if the last pressure is used as the initial guess.
+    bool isUsingWarmStart() const;
+
+    //!
+    //! \brief Sets true to use the last pressure as the initial guess.
+    //!
+    //! When enabled, the linear system is solved for the correction to the
+    //! pressure from the previous call instead of the pressure itself, so
+    //! any linear system solver benefits from it. The last pressure is set
+    //! to zero outside of the current fluid region, and it is discarded when
+    //! the grid resolution changes. For scenes that change slowly, this
+    //! reduces the number of iterations considerably.
+    //!
+    void setIsUsingWarmStart(bool isUsing);
+
+    //! Returns the last number of iterations of the linear system solver.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the last residual of the linear system solver.
+    double lastResidual() const override;
+
+    //! Returns the largest absolute velocity component of the last output.
+    double lastMaxVelocity() const override;
+
+    //! Returns true if the linear system is built over the fluid cells only.
+    bool isUsingCompressedSystem() const;
+
+    //!
+    //! \brief Sets true to build the linear system over the fluid cells only.
+    //!
+    //! When enabled, the rows of the cells outside of the fluid SDF are dropped
+    //! and the system is solved as an FdmCompressedLinearSystem, whose pressure
+    //! is scattered back to the grid with zero outside of the fluid. This saves
+    //! most of the work when the fluid fills a small part of the domain. It
+    //! needs a linear system solver that supports compressed systems, such as
+    //! FdmCgSolver3 and FdmIccgSolver3. With the other solvers, the full system
+    //! is solved instead, and it is ignored for FdmMatrixFreeCgSolver3.
+    //!
+    void setIsUsingCompressedSystem(bool isUsing);
+
  private:
     FdmLinearSystem3 _system;
     FdmLinearSystemSolver3Ptr _systemSolver;
+    bool _isUsingWarmStart = false;
+    FdmVector3 _lastPressure;
+    bool _isUsingCompressedSystem = false;
+    FdmCompressedLinearSystem _compressedSystem;
+    Array3<size_t> _compressedIndices;
+    FdmCompressedVector _lastCompressedPressure;
+    double _lastMaxVelocity = -1.0;
     Array3<double> _uWeights;
     Array3<double> _vWeights;
     Array3<double> _wWeights;
     CellCenteredScalarGrid3 _fluidSdf;
+    Array3<double> _boundarySdf;
+    bool _isMatrixValid = false;
+    Vector3D _matrixGridSpacing;
 
-    void buildWeights(
+    bool buildWeights(
         const FaceCenteredGrid3& input,
         const ScalarField3& boundarySdf,
         const ScalarField3& fluidSdf);
 
-    virtual void buildSystem(const FaceCenteredGrid3& input);
+    const ScalarGrid3* sameDataPointGrid(const ScalarField3& field) const;
+
+    virtual void buildSystem(
+        const FaceCenteredGrid3& input,
+        bool isAssemblingMatrix);
+
+    void solveCompressedSystem(
+        const FaceCenteredGrid3& input,
+        bool isWarmStarting);
 
     virtual void applyPressureGradient(
         const FaceCenteredGrid3& input,
@@ -67,6 +67,24 @@ class GridPressureSolver3 {
     //!
     virtual GridBoundaryConditionSolver3Ptr
         suggestedBoundaryConditionSolver() const = 0;
+
+    //! Returns the number of iterations the last solve took, or zero if the
+    //! solver is not iterative.
+    virtual unsigned int lastNumberOfIterations() const;
+
+    //! Returns the residual after the last solve, or zero if the solver does
+    //! not track it.
+    virtual double lastResidual() const;
+
+    //!
+    //! \brief Returns the largest absolute velocity component of the last
+    //!     output, or a negative value if the solver does not track it.
+    //!
+    //! The solvers that track it find the value while applying the pressure
+    //! gradient, which visits all the faces anyway, so the fluid solver can
+    //! pick the next sub-time-step without scanning the velocity again.
+    //!
+    virtual double lastMaxVelocity() const;
 };
 
 typedef std::shared_ptr<GridPressureSolver3> GridPressureSolver3Ptr;
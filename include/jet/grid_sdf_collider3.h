@@ -0,0 +1,56 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_GRID_SDF_COLLIDER3_H_
+#define INCLUDE_JET_GRID_SDF_COLLIDER3_H_
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/collider3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D collider that answers queries from a precomputed SDF grid.
+//!
+//! This class bakes the surface of another collider into a signed-distance
+//! grid once, and then answers the closest point, normal, and distance
+//! queries of Collider3::resolveCollision by trilinear lookup. The query cost
+//! no longer depends on the complexity of the surface, which makes it
+//! suitable for particle solvers colliding against surface sets or triangle
+//! meshes. Points outside the grid fall back to the original surface.
+//! The velocity of the collider is taken from the original collider.
+//!
+class GridSdfCollider3 final : public Collider3 {
+ public:
+    //!
+    //! Constructs a collider by baking the surface of \p collider into a grid
+    //! with given resolution, grid spacing, and origin. The friction
+    //! coefficient is copied from \p collider.
+    //!
+    GridSdfCollider3(
+        const Collider3Ptr& collider,
+        const Size3& resolution,
+        const Vector3D& gridSpacing,
+        const Vector3D& gridOrigin = Vector3D());
+
+    //! Returns the velocity of the collider at given \p point.
+    Vector3D velocityAt(const Vector3D& point) const override;
+
+    //! Returns the original collider.
+    const Collider3Ptr& collider() const;
+
+    //! Returns the baked signed-distance grid.
+    const CellCenteredScalarGrid3& sdf() const;
+
+    //! Bakes the surface of the original collider again.
+    void rebuild();
+
+ private:
+    Collider3Ptr _collider;
+    std::shared_ptr<CellCenteredScalarGrid3> _sdf;
+};
+
+typedef std::shared_ptr<GridSdfCollider3> GridSdfCollider3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_SDF_COLLIDER3_H_
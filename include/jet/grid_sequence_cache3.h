@@ -0,0 +1,193 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_GRID_SEQUENCE_CACHE3_H_
+#define INCLUDE_JET_GRID_SEQUENCE_CACHE3_H_
+
+#include <jet/scalar_grid3.h>
+#include <jet/size3.h>
+#include <jet/vector3.h>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jet {
+
+class MappedFile;
+
+//!
+//! \brief Writes a sequence of scalar grids to a temporally compressed cache.
+//!
+//! The values are quantized to multiples of twice the tolerance, so every
+//! cached value is within the tolerance of the original one. Every
+//! keyframeInterval-th frame is a keyframe that stores the whole grid, and
+//! the frames in between store only the tiles of 8x8x8 data points whose
+//! quantized values changed since the previous frame, as the differences from
+//! it. The differences are taken against the quantized values that the
+//! reader reconstructs, so the error does not accumulate over the frames.
+//! The stored values are split into byte planes and entropy-coded like the
+//! compressed ParticleCacheWriter3.
+//!
+//! The cache starts with a header that holds the tag "JETGSEQC", the format
+//! version, and the grid layout, and ends with the index of the frames and a
+//! footer that locates it. All frames must have the same resolution, grid
+//! spacing, origin, and data layout.
+//!
+class GridSequenceCacheWriter3 {
+ public:
+    JET_NON_COPYABLE(GridSequenceCacheWriter3)
+
+    //! Constructs a writer that writes the cache to \p strm.
+    explicit GridSequenceCacheWriter3(std::ostream* strm);
+
+    //! Destructor. Closes the cache if not closed yet.
+    ~GridSequenceCacheWriter3();
+
+    //! Returns the maximum error of the cached values.
+    double tolerance() const;
+
+    //!
+    //! \brief Sets the maximum error of the cached values.
+    //!
+    //! \p tolerance should be positive, and it should be set before the first
+    //! frame is added. The default is 1e-5.
+    //!
+    void setTolerance(double tolerance);
+
+    //! Returns the number of frames from a keyframe to the next.
+    size_t keyframeInterval() const;
+
+    //! Sets the number of frames from a keyframe to the next. \p interval
+    //! should be positive, and it should be set before the first frame is
+    //! added. The default is 24.
+    void setKeyframeInterval(size_t interval);
+
+    //! Returns the number of frames added so far.
+    size_t numberOfFrames() const;
+
+    //! Encodes \p grid and writes it as the next frame.
+    void addFrame(const ScalarGrid3& grid);
+
+    //! Writes the index and the footer. No frame can be added after.
+    void close();
+
+ private:
+    struct FrameEntry {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t isKeyframe;
+        uint32_t numberOfChangedTiles;
+    };
+
+    std::ostream* _strm;
+    double _tolerance = 1e-5;
+    size_t _keyframeInterval = 24;
+    bool _isClosed = false;
+    size_t _offset = 0;
+
+    Size3 _resolution;
+    Vector3D _gridSpacing;
+    Vector3D _origin;
+    Size3 _dataSize;
+    Vector3D _dataOrigin;
+
+    std::vector<int64_t> _quantized;
+    std::vector<FrameEntry> _frames;
+
+    void writeHeader();
+
+    void write(const void* data, size_t size);
+};
+
+//!
+//! \brief Reads the cache written by GridSequenceCacheWriter3.
+//!
+//! The file is memory-mapped, and any frame can be read in any order. A frame
+//! is decoded from the closest keyframe before it, or from the last frame
+//! read if it is in between, so reading the frames one after another decodes
+//! each frame only once.
+//!
+class GridSequenceCacheReader3 {
+ public:
+    JET_NON_COPYABLE(GridSequenceCacheReader3)
+
+    //! Constructs an empty reader.
+    GridSequenceCacheReader3();
+
+    //! Destructor.
+    ~GridSequenceCacheReader3();
+
+    //! Opens the cache at \p filename. Returns false if the file cannot be
+    //! opened or is not a valid cache, in which case the reader is empty.
+    bool open(const std::string& filename);
+
+    //! Closes the file.
+    void close();
+
+    //! Returns the number of frames.
+    size_t numberOfFrames() const;
+
+    //! Returns true if the i-th frame is a keyframe.
+    bool isKeyframe(size_t i) const;
+
+    //! Returns the number of the tiles stored in the i-th frame that is not a
+    //! keyframe, or the total number of the tiles for a keyframe.
+    size_t numberOfStoredTiles(size_t i) const;
+
+    //! Returns the number of the encoded bytes of the i-th frame.
+    size_t frameSize(size_t i) const;
+
+    //! Returns the maximum error of the cached values.
+    double tolerance() const;
+
+    //! Returns the grid resolution.
+    Size3 resolution() const;
+
+    //! Returns the grid spacing.
+    Vector3D gridSpacing() const;
+
+    //! Returns the grid origin.
+    Vector3D origin() const;
+
+    //! Returns the size of the grid data.
+    Size3 dataSize() const;
+
+    //! Returns the data origin.
+    Vector3D dataOrigin() const;
+
+    //!
+    //! \brief Decodes the i-th frame to \p grid.
+    //!
+    //! The grid is resized to the cached resolution, grid spacing, and origin.
+    //! Returns false if \p i is out of range, the data size does not match
+    //! the grid type, or the frame is corrupted.
+    //!
+    bool readFrame(size_t i, ScalarGrid3* grid);
+
+ private:
+    struct FrameEntry {
+        size_t offset;
+        size_t size;
+        bool isKeyframe;
+        size_t numberOfChangedTiles;
+    };
+
+    std::unique_ptr<MappedFile> _file;
+    std::vector<FrameEntry> _frames;
+    double _tolerance = 0.0;
+    Size3 _resolution;
+    Vector3D _gridSpacing;
+    Vector3D _origin;
+    Size3 _dataSize;
+    Vector3D _dataOrigin;
+
+    std::vector<int64_t> _quantized;
+    size_t _decodedFrame;
+
+    bool decodeFrame(size_t i);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_SEQUENCE_CACHE3_H_
@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_GRID_SINGLE_PHASE_PRESSURE_SOLVER2_H_
 #define INCLUDE_JET_GRID_SINGLE_PHASE_PRESSURE_SOLVER2_H_
 
+#include <jet/fdm_compressed_linear_system.h>
 #include <jet/fdm_linear_system_solver2.h>
 #include <jet/grid_boundary_condition_solver2.h>
 #include <jet/grid_pressure_solver2.h>
@@ -74,15 +75,61 @@ class GridSinglePhasePressureSolver2 : public GridPressureSolver2 {
     GridBoundaryConditionSolver2Ptr
         suggestedBoundaryConditionSolver() const override;
 
-    //! Sets the linear system solver.
+    //!
+    //! \brief Sets the linear system solver.
+    //!
+    //! If the solver is an FdmMatrixFreeCgSolver2, the pressure equation is
+    //! solved matrix-free: the Poisson operator is computed on the fly from
+    //! the cell markers and FdmMatrix2 is never assembled.
+    //!
     void setLinearSystemSolver(const FdmLinearSystemSolver2Ptr& solver);
 
     //! Returns the pressure field.
     const FdmVector2& pressure() const;
 
+    //! Returns true if the last pressure is used as the initial guess.
+    bool isUsingWarmStart() const;
+
+    //!
+    //! \brief Sets true to use the last pressure as the initial guess.
+    //!
+    //! When enabled, the linear system is solved for the correction to the
+    //! pressure from the previous call instead of the pressure itself, so
+    //! any linear system solver benefits from it. The last pressure is set
+    //! to zero outside of the current fluid region, and it is discarded when
+    //! the grid resolution changes. For scenes that change slowly, this
+    //! reduces the number of iterations considerably.
+    //!
+    void setIsUsingWarmStart(bool isUsing);
+
+    //! Returns the last number of iterations of the linear system solver.
+    unsigned int lastNumberOfIterations() const;
+
+    //! Returns true if the linear system is built over the fluid cells only.
+    bool isUsingCompressedSystem() const;
+
+    //!
+    //! \brief Sets true to build the linear system over the fluid cells only.
+    //!
+    //! When enabled, the rows of the non-fluid cells are dropped and the system
+    //! is solved as an FdmCompressedLinearSystem, whose pressure is scattered
+    //! back to the grid with zero outside of the fluid. This saves most of the
+    //! work when the fluid fills a small part of the domain. It needs a linear
+    //! system solver that supports compressed systems, such as FdmCgSolver2 and
+    //! FdmIccgSolver2. With the other solvers, the full system is solved
+    //! instead, and it is ignored for FdmMatrixFreeCgSolver2.
+    //!
+    void setIsUsingCompressedSystem(bool isUsing);
+
  private:
     FdmLinearSystem2 _system;
     FdmLinearSystemSolver2Ptr _systemSolver;
+    bool _isUsingWarmStart = false;
+    FdmVector2 _lastPressure;
+    bool _isUsingCompressedSystem = false;
+    FdmCompressedLinearSystem _compressedSystem;
+    Array2<size_t> _compressedIndices;
+    FdmCompressedVector _lastCompressedPressure;
     Array2<char> _markers;
 
     void buildMarkers(
@@ -91,7 +138,13 @@ class GridSinglePhasePressureSolver2 : public GridPressureSolver2 {
         const ScalarField2& boundarySdf,
         const ScalarField2& fluidSdf);
 
-    virtual void buildSystem(const FaceCenteredGrid2& input);
+    virtual void buildSystem(
+        const FaceCenteredGrid2& input,
+        bool isAssemblingMatrix);
+
+    void solveCompressedSystem(
+        const FaceCenteredGrid2& input,
+        bool isWarmStarting);
 
     virtual void applyPressureGradient(
         const FaceCenteredGrid2& input,
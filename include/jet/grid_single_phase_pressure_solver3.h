@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_GRID_SINGLE_PHASE_PRESSURE_SOLVER3_H_
 #define INCLUDE_JET_GRID_SINGLE_PHASE_PRESSURE_SOLVER3_H_
 
+#include <jet/fdm_compressed_linear_system.h>
 #include <jet/fdm_linear_system_solver3.h>
 #include <jet/grid_boundary_condition_solver3.h>
 #include <jet/grid_pressure_solver3.h>
@@ -46,6 +47,11 @@ class GridSinglePhasePressureSolver3 : public GridPressureSolver3 {
     //! field with -kMaxD will be used for \p fluidSdf which means it's fully
     //! occupied with fluid without any atmosphere.
     //!
+    //! The assembled matrix is kept between the calls, and it is rebuilt only
+    //! when the cell markers or the grid spacing change, so the solvers that
+    //! support FdmLinearSystemSolver3::solveWithSameMatrix, such as
+    //! FdmIccgSolver3, also keep their preconditioner for static domains.
+    //!
     //! \param[in]    input                 The input velocity field.
     //! \param[in]    timeIntervalInSeconds The time interval for the sim.
     //! \param[inout] output                The output velocity field.
@@ -74,24 +80,112 @@ class GridSinglePhasePressureSolver3 : public GridPressureSolver3 {
     GridBoundaryConditionSolver3Ptr
         suggestedBoundaryConditionSolver() const override;
 
-    //! Sets the linear system solver.
+    //!
+    //! \brief Sets the linear system solver.
+    //!
+    //! If the solver is an FdmMatrixFreeCgSolver3, the pressure equation is
+    //! solved matrix-free: the Poisson operator is computed on the fly from
+    //! the cell markers and FdmMatrix3 is never assembled.
+    //!
     void setLinearSystemSolver(const FdmLinearSystemSolver3Ptr& solver);
 
     //! Returns the pressure field.
     const FdmVector3& pressure() const;
 
+    //! Returns true if the last pressure is used as the initial guess.
+    bool isUsingWarmStart() const;
+
+    //!
+    //! \brief Sets true to use the last pressure as the initial guess.
+    //!
+    //! When enabled, the linear system is solved for the correction to the
+    //! pressure from the previous call instead of the pressure itself, so
+    //! any linear system solver benefits from it. The last pressure is set
+    //! to zero outside of the current fluid region, and it is discarded when
+    //! the grid resolution changes. For scenes that change slowly, this
+    //! reduces the number of iterations considerably.
+    //!
+    void setIsUsingWarmStart(bool isUsing);
+
+    //! Returns the last number of iterations of the linear system solver.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the last residual of the linear system solver.
+    double lastResidual() const override;
+
+    //! Returns the largest absolute velocity component of the last output.
+    double lastMaxVelocity() const override;
+
+    //! Returns true if the linear system is built over the fluid cells only.
+    bool isUsingCompressedSystem() const;
+
+    //!
+    //! \brief Sets true to build the linear system over the fluid cells only.
+    //!
+    //! When enabled, the rows of the non-fluid cells are dropped and the system
+    //! is solved as an FdmCompressedLinearSystem, whose pressure is scattered
+    //! back to the grid with zero outside of the fluid. This saves most of the
+    //! work when the fluid fills a small part of the domain. It needs a linear
+    //! system solver that supports compressed systems, such as FdmCgSolver3 and
+    //! FdmIccgSolver3. With the other solvers, the full system is solved
+    //! instead, and it is ignored for FdmMatrixFreeCgSolver3.
+    //!
+    void setIsUsingCompressedSystem(bool isUsing);
+
+    //! Returns true if the pressure is solved on a coarser grid.
+    bool isUsingCoarseProjection() const;
+
+    //!
+    //! \brief Sets true to solve the pressure on a grid coarsened 2x per axis.
+    //!
+    //! When enabled, the divergence is summed onto a grid of half the
+    //! resolution, whose cells are fluid if any of their cells is fluid, and
+    //! the pressure is solved there with an eighth of the unknowns. The
+    //! gradient of the coarse pressure is applied to the faces of the input
+    //! grid, interpolated linearly for the faces inside a coarse cell, and a
+    //! small Poisson solve inside each coarse cell then removes the rest of
+    //! the divergence of its fluid cells. This suits smoke, whose large scale
+    //! motion is what the projection has to get right. The coarse matrix is
+    //! always assembled, the warm start and the compressed system are not
+    //! used in this mode, and pressure() returns the coarse pressure over the
+    //! cells of the input grid.
+    //!
+    void setIsUsingCoarseProjection(bool isUsing);
+
  private:
     FdmLinearSystem3 _system;
     FdmLinearSystemSolver3Ptr _systemSolver;
+    bool _isUsingWarmStart = false;
+    FdmVector3 _lastPressure;
+    bool _isUsingCompressedSystem = false;
+    FdmCompressedLinearSystem _compressedSystem;
+    Array3<size_t> _compressedIndices;
+    FdmCompressedVector _lastCompressedPressure;
+    double _lastMaxVelocity = -1.0;
     Array3<char> _markers;
+    bool _isMatrixValid = false;
+    Vector3D _matrixGridSpacing;
+    bool _isUsingCoarseProjection = false;
+    FdmLinearSystem3 _coarseSystem;
+    Array3<char> _coarseMarkers;
 
-    void buildMarkers(
+    bool buildMarkers(
         const Size3& size,
         const std::function<Vector3D(size_t, size_t, size_t)>& pos,
         const ScalarField3& boundarySdf,
         const ScalarField3& fluidSdf);
 
-    virtual void buildSystem(const FaceCenteredGrid3& input);
+    virtual void buildSystem(
+        const FaceCenteredGrid3& input,
+        bool isAssemblingMatrix);
+
+    void solveCompressedSystem(
+        const FaceCenteredGrid3& input,
+        bool isWarmStarting);
+
+    void solveCoarseProjection(
+        const FaceCenteredGrid3& input,
+        FaceCenteredGrid3* output);
 
     virtual void applyPressureGradient(
         const FaceCenteredGrid3& input,
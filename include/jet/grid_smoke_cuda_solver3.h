@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_GRID_SMOKE_CUDA_SOLVER3_H_
+#define INCLUDE_JET_GRID_SMOKE_CUDA_SOLVER3_H_
+
+#include <jet/grid_smoke_solver3.h>
+#include <memory>
+
+namespace jet {
+
+namespace internal {
+
+class CudaSmokeState;
+
+struct CudaSmokeStateDeleter final {
+    void operator()(CudaSmokeState* state) const;
+};
+
+}  // namespace internal
+
+//!
+//! \brief 3-D smoke solver which runs the whole time-step on a CUDA device.
+//!
+//! When the library is built with JET_USE_CUDA and a CUDA device is present,
+//! the semi-Lagrangian advection of the velocity and all the advectable
+//! scalar channels, the buoyancy, the pressure projection, the diffusion,
+//! the decay, and the closed domain boundary are computed on the device, and
+//! the grids stay there between the sub-time-steps. The pressure and the
+//! diffusion are solved by Jacobi-preconditioned CG on the same systems as
+//! GridFractionalSinglePhasePressureSolver3 and
+//! GridBackwardEulerDiffusionSolver3 build without a collider.
+//!
+//! The device runs the configurations without a collider, the auto bounds,
+//! the up-res pass, the vorticity confinement, the viscosity, or the
+//! per-frame diffusion, with SemiLagrangian3 or CubicSemiLagrangian3
+//! advection, the default solvers (or none) for the pressure and the
+//! diffusion, and advectable channels that are all double cell-centered grids
+//! updated every sub-time-step. Any other
+//! configuration downloads the grids and runs GridSmokeSolver3 on the host,
+//! which is also what the solver does without a device.
+//!
+//! By default, the grids are downloaded at the end of each frame and uploaded
+//! again at the beginning of the next one, so that the host can edit them in
+//! between like with GridSmokeSolver3. When the host does not need the grids
+//! every frame, turn the syncing off to keep them on the device, and read the
+//! frames to export with downloadSmokeDensity().
+//!
+class GridSmokeCudaSolver3 final : public GridSmokeSolver3 {
+ public:
+    //! Constructs a solver with an empty grid.
+    GridSmokeCudaSolver3();
+
+    //! Destructor.
+    virtual ~GridSmokeCudaSolver3();
+
+    //! Returns true if the solver runs on a CUDA device.
+    bool isUsingDevice() const;
+
+    //! Returns true if the library is built with CUDA and a device is found.
+    static bool isDeviceAvailable();
+
+    //! Returns true if the grids are downloaded at the end of each frame.
+    bool isSyncingHostEveryFrame() const;
+
+    //!
+    //! \brief Sets whether the grids are downloaded at the end of each frame.
+    //!
+    //! If false, the grids stay on the device across the frames, and the host
+    //! grids are stale until downloadToHost() is called. The host edits to
+    //! the grids are then not seen by the device until uploadToDevice() is
+    //! called. Default is true.
+    //!
+    void setIsSyncingHostEveryFrame(bool isSyncing);
+
+    //!
+    //! \brief Uploads the host grids to the device.
+    //!
+    //! Does nothing if the device does not run the current configuration, or
+    //! if the host grids are stale, since the device has the latest data then.
+    //!
+    void uploadToDevice();
+
+    //! Downloads the grids from the device, if the host grids are stale.
+    void downloadToHost();
+
+    //!
+    //! \brief Copies the smoke density to \p grid.
+    //!
+    //! If the host grids are stale, only the smoke density is downloaded from
+    //! the device, and the host grids stay stale. The grid is resized to the
+    //! smoke density. This is the way to export the frames when the grids
+    //! stay on the device: the copy can be encoded and handed to
+    //! AsyncFileWriter while the next frames are simulated.
+    //!
+    void downloadSmokeDensity(CellCenteredScalarGrid3* grid) const;
+
+ protected:
+    //! Advances a sub-time-step on the device, or on the host if the device
+    //! does not run the current configuration.
+    void onAdvanceTimeStep(double timeIntervalInSeconds) override;
+
+    //! Returns the sub-time-steps from the velocity on the device, if the
+    //! host grids are stale.
+    unsigned int numberOfSubTimeSteps(
+        double timeIntervalInSeconds) const override;
+
+    //! Downloads the grids if syncing every frame, then ends the frame.
+    void onEndAdvanceFrame(double timeIntervalInSeconds) override;
+
+    //! Collects the statistics of the last sub-time-step.
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
+ private:
+    std::unique_ptr<internal::CudaSmokeState, internal::CudaSmokeStateDeleter>
+        _device;
+    bool _isSyncingHostEveryFrame = true;
+    bool _isDeviceDataValid = false;
+    bool _isHostDataValid = true;
+    bool _isLastStepOnDevice = false;
+
+    bool canAdvanceOnDevice() const;
+
+    double deviceCfl(double timeIntervalInSeconds) const;
+};
+
+//! Shared pointer type for the GridSmokeCudaSolver3.
+typedef std::shared_ptr<GridSmokeCudaSolver3> GridSmokeCudaSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_SMOKE_CUDA_SOLVER3_H_
@@ -4,6 +4,7 @@
 #define INCLUDE_JET_GRID_SMOKE_SOLVER3_H_
 
 #include <jet/grid_fluid_solver3.h>
+#include <jet/grid_smoke_up_res3.h>
 
 namespace jet {
 
@@ -37,15 +38,120 @@ class GridSmokeSolver3 : public GridFluidSolver3 {
 
     void setTemperatureDecayFactor(double newValue);
 
+    //! Returns the vorticity confinement factor.
+    double vorticityConfinementFactor() const;
+
+    //!
+    //! \brief Sets the vorticity confinement factor.
+    //!
+    //! Vorticity confinement adds a force that spins the flow around the
+    //! local maxima of the vorticity magnitude. It recovers the small swirls
+    //! that the numerical dissipation of a coarse grid removes, so a lower
+    //! resolution can keep the look of a finer one. The force is scaled by
+    //! the grid spacing, so the same factor gives similar results across
+    //! resolutions. Default is 0, which disables the force. A negative value
+    //! is clamped to 0.
+    //!
+    //! \see Fedkiw, Ronald, Jos Stam, and Henrik Wann Jensen. "Visual
+    //!     simulation of smoke." Proceedings of SIGGRAPH (2001).
+    //!
+    void setVorticityConfinementFactor(double newValue);
+
     ScalarGrid3Ptr smokeDensity() const;
 
     ScalarGrid3Ptr temperature() const;
 
+    //! Returns true if the diffusion is solved once per frame.
+    bool isDiffusingPerFrame() const;
+
+    //!
+    //! \brief Sets whether the diffusion is solved once per frame.
+    //!
+    //! If true, the smoke density and temperature are diffused once at the end
+    //! of each frame with the frame time interval, instead of at every
+    //! sub-time-step. Use an implicit diffusion solver, such as the default
+    //! backward Euler solver, since the frame time interval can be large.
+    //!
+    void setIsDiffusingPerFrame(bool isDiffusing);
+
+    //! Returns the advection update interval of the smoke density in
+    //! sub-time-steps.
+    unsigned int smokeDensityUpdateInterval() const;
+
+    //! Sets the advection update interval of the smoke density in
+    //! sub-time-steps.
+    //! \see GridSystemData3::setAdvectableScalarDataUpdateInterval
+    void setSmokeDensityUpdateInterval(unsigned int interval);
+
+    //! Returns the advection update interval of the temperature in
+    //! sub-time-steps.
+    unsigned int temperatureUpdateInterval() const;
+
+    //! Sets the advection update interval of the temperature in
+    //! sub-time-steps.
+    //! \see GridSystemData3::setAdvectableScalarDataUpdateInterval
+    void setTemperatureUpdateInterval(unsigned int interval);
+
+    //! Returns the density and temperature threshold of the auto bounds.
+    double autoBoundsThreshold() const;
+
+    //!
+    //! \brief Sets the density and temperature threshold of the auto bounds.
+    //!
+    //! The cells whose smoke density or absolute temperature is above the
+    //! threshold are the active region that the auto bounds keep in the grid.
+    //! Since the buoyancy takes the ambient temperature as the average over
+    //! the grid, the temperature should be relative to the ambient one when
+    //! the auto bounds are used. Default is 0.001.
+    //!
+    //! \see GridFluidSolver3::setIsUsingAutoBounds
+    //!
+    void setAutoBoundsThreshold(double newValue);
+
+    //! Returns true if the velocity is projected on a coarser grid.
+    bool isUsingCoarsePressureProjection() const;
+
+    //!
+    //! \brief Sets true to project the velocity on a grid coarsened 2x per
+    //!        axis.
+    //!
+    //! The pressure projection dominates the cost of a smoke step, while the
+    //! look mostly depends on its large scale motion. When enabled, the
+    //! pressure is solved with an eighth of the unknowns and corrected in the
+    //! cells of the grid, as described in
+    //! GridSinglePhasePressureSolver3::setIsUsingCoarseProjection. If the
+    //! pressure solver is not a GridSinglePhasePressureSolver3, it is
+    //! replaced with one, which also replaces the boundary condition solver.
+    //!
+    void setIsUsingCoarsePressureProjection(bool isUsing);
+
+    //! Returns the up-res pass, or nullptr if there is none.
+    const GridSmokeUpRes3Ptr& upRes() const;
+
+    //!
+    //! \brief Sets the up-res pass.
+    //!
+    //! If set, the fine density of the up-res pass is advected with the
+    //! velocity of the solver at the end of each sub-time-step, and it decays
+    //! with the smoke decay factor. The fine density is not diffused. Pass
+    //! nullptr to remove the pass.
+    //!
+    void setUpRes(const GridSmokeUpRes3Ptr& upRes);
+
+    void serialize(std::ostream* strm) const override;
+
+    void deserialize(std::istream* strm) override;
+
  protected:
+    void onEndAdvanceFrame(double timeIntervalInSeconds) override;
+
     void onEndAdvanceTimeStep(double timeIntervalInSeconds) override;
 
     void computeExternalForces(double timeIntervalInSeconds) override;
 
+    //! Returns the bounds of the cells with the smoke or the heat.
+    BoundingBox3D activeRegion() const override;
+
  private:
     size_t _smokeDensityDataId;
     size_t _temperatureDataId;
@@ -55,10 +161,25 @@ class GridSmokeSolver3 : public GridFluidSolver3 {
     double _buoyancyTemperatureFactor = 5.0;
     double _smokeDecayFactor = 0.001;
     double _temperatureDecayFactor = 0.001;
+    bool _isDiffusingPerFrame = false;
+    double _vorticityConfinementFactor = 0.0;
+    double _autoBoundsThreshold = 0.001;
+    GridSmokeUpRes3Ptr _upRes;
+
+    //! Cell-centered vorticity, reused between the time-steps.
+    Array3<Vector3D> _vorticity;
+
+    //! Cell-centered buoyancy force without the ambient temperature term,
+    //! reused between the time-steps.
+    Array3<double> _buoyancy;
 
     void computeDiffusion(double timeIntervalInSeconds);
 
+    void computeDecay();
+
     void computeBuoyancyForce(double timeIntervalInSeconds);
+
+    void computeVorticityConfinement(double timeIntervalInSeconds);
 };
 
 }  // namespace jet
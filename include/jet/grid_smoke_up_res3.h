@@ -0,0 +1,134 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_GRID_SMOKE_UP_RES3_H_
+#define INCLUDE_JET_GRID_SMOKE_UP_RES3_H_
+
+#include <jet/advection_solver3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
+#include <jet/constant_scalar_field3.h>
+#include <jet/face_centered_grid3.h>
+#include <cstdint>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Procedural up-res pass of 3-D smoke simulations.
+//!
+//! This class carries a smoke density on a grid that is upResFactor() times
+//! finer than the grid of the simulation, so a coarse simulation renders with
+//! the details of a fine one at the cost of the coarse pressure solves. At
+//! each time-step, the coarse velocity is interpolated onto the fine grid,
+//! and the turbulence of the scales that the coarse grid cannot resolve is
+//! added to it before the fine density is advected.
+//!
+//! The turbulence is synthesized as in Kim et al., "Wavelet turbulence for
+//! fluid simulation" (SIGGRAPH 2008): the curl of band-limited noise, which
+//! is divergence-free, is summed over numberOfOctaves() octaves with the
+//! weights 2^(-5/6 i) of the Kolmogorov spectrum. Instead of the wavelet
+//! decomposition of the paper, the local strength of the turbulence is
+//! estimated from the coarse vorticity times the coarse grid spacing, the
+//! velocity of the smallest eddies that the coarse grid resolves. The noise
+//! is the gradient noise of Perlin with the lattice gradients drawn from
+//! PhiloxRng, so the result only depends on the seed. The turbulence fades
+//! within a coarse cell from the boundary.
+//!
+class GridSmokeUpRes3 {
+ public:
+    //! Constructs an up-res pass with the given up-res factor.
+    explicit GridSmokeUpRes3(size_t upResFactor = 2);
+
+    virtual ~GridSmokeUpRes3();
+
+    //! Returns the ratio of the coarse grid spacing to the fine one.
+    size_t upResFactor() const;
+
+    //! Sets the ratio of the coarse grid spacing to the fine one. The fine
+    //! grids are resized on the next advance().
+    void setUpResFactor(size_t newValue);
+
+    //! Returns the amplitude of the turbulence.
+    double turbulenceAmplitude() const;
+
+    //!
+    //! \brief Sets the amplitude of the turbulence.
+    //!
+    //! The amplitude scales the coarse vorticity times the coarse grid
+    //! spacing. Default is 1, and 0 disables the turbulence, which leaves
+    //! the interpolated coarse velocity. A negative value is clamped to 0.
+    //!
+    void setTurbulenceAmplitude(double newValue);
+
+    //! Returns the number of the octaves of the turbulence.
+    size_t numberOfOctaves() const;
+
+    //! Sets the number of the octaves of the turbulence. The first octave has
+    //! the wavelength of a coarse cell, and each next one halves it.
+    void setNumberOfOctaves(size_t newValue);
+
+    //! Returns the seed of the noise.
+    uint64_t seed() const;
+
+    //! Sets the seed of the noise.
+    void setSeed(uint64_t newValue);
+
+    //! Returns the advection solver of the fine density.
+    const AdvectionSolver3Ptr& advectionSolver() const;
+
+    //! Sets the advection solver of the fine density. Default is
+    //! SemiLagrangian3.
+    void setAdvectionSolver(const AdvectionSolver3Ptr& newSolver);
+
+    //! Returns the fine density.
+    ScalarGrid3Ptr density() const;
+
+    //! Returns the fine velocity of the last advance(), which includes the
+    //! turbulence.
+    const CellCenteredVectorGrid3& velocity() const;
+
+    //!
+    //! \brief Sets the fine density to the interpolated \p coarseDensity.
+    //!
+    //! The fine grids are resized to match the coarse grid. This is how the
+    //! fine density is usually initialized, and the density can be edited
+    //! afterwards through density().
+    //!
+    void upsampleDensity(const ScalarGrid3& coarseDensity);
+
+    //!
+    //! \brief Advects the fine density with the coarse velocity.
+    //!
+    //! The fine grids are resized to match \p coarseVelocity if needed, which
+    //! resets the density to zero. The boundary is given by
+    //! \p boundarySdf, which is negative inside the boundary.
+    //!
+    void advance(
+        const FaceCenteredGrid3& coarseVelocity,
+        double timeIntervalInSeconds,
+        const ScalarField3& boundarySdf = ConstantScalarField3(kMaxD));
+
+ private:
+    size_t _upResFactor;
+    double _turbulenceAmplitude = 1.0;
+    size_t _numberOfOctaves = 2;
+    uint64_t _seed = 0;
+    AdvectionSolver3Ptr _advectionSolver;
+
+    std::shared_ptr<CellCenteredScalarGrid3> _density;
+    CellCenteredScalarGrid3 _densityBuffer;
+    CellCenteredVectorGrid3 _velocity;
+    CellCenteredVectorGrid3 _coarseVorticity;
+
+    void resize(const Grid3& coarseGrid);
+
+    void computeVelocity(
+        const FaceCenteredGrid3& coarseVelocity,
+        const ScalarField3& boundarySdf);
+};
+
+typedef std::shared_ptr<GridSmokeUpRes3> GridSmokeUpRes3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_SMOKE_UP_RES3_H_
@@ -5,13 +5,20 @@
 
 #include <jet/scalar_grid3.h>
 #include <jet/face_centered_grid3.h>
+#include <atomic>
+#include <functional>
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace jet {
 
 class GridSystemData3 {
  public:
+    JET_NON_COPYABLE(GridSystemData3)
+
     GridSystemData3();
 
     virtual ~GridSystemData3();
@@ -29,6 +36,32 @@ class GridSystemData3 {
 
     BoundingBox3D boundingBox() const;
 
+    //!
+    //! \brief Moves the domain by \p offset cells, keeping its resolution.
+    //!
+    //! The origins of all the grids are moved by \p offset times the grid
+    //! spacing, and their data are shifted in place so that each value stays
+    //! at the same world position. The cells that enter the domain take the
+    //! values of the nearest cells that were inside, which is the
+    //! zero-gradient inflow. The back buffers only move, since their content
+    //! is only meaningful within a solver step. Throws
+    //! std::invalid_argument if a vector data is neither a collocated nor a
+    //! face-centered grid.
+    //!
+    void scroll(const Point3I& offset);
+
+    //!
+    //! \brief Moves the lower corner of the domain by \p offset cells and
+    //! changes its resolution to \p resolution.
+    //!
+    //! Like scroll(), the values keep their world positions and the cells
+    //! that enter the domain are extended from the nearest old cells, so the
+    //! domain can be cropped to a region and grown back while keeping the
+    //! cells aligned. Throws std::invalid_argument if a vector data is neither
+    //! a collocated nor a face-centered grid.
+    //!
+    void reshape(const Point3I& offset, const Size3& resolution);
+
     size_t addScalarData(
         const ScalarGridBuilder3Ptr& builder,
         double initialVal = 0.0);
@@ -45,6 +78,26 @@ class GridSystemData3 {
         const VectorGridBuilder3Ptr& builder,
         const Vector3D& initialVal = Vector3D());
 
+    //!
+    //! \brief Adds an advectable scalar data that is stored in floats.
+    //!
+    //! Passive scalars, such as the smoke-like user channels, do not need
+    //! double precision, so the grid and its back buffer take half of the
+    //! memory and the bandwidth of addAdvectableScalarData. The data is
+    //! advected at every sub-time-step, with the linear interpolation of
+    //! SemiLagrangian3 sampling the floats directly, while the velocity and
+    //! the pressure stay in double precision. The index is separate from the
+    //! indices of the double-precision data.
+    //!
+    //! \param builder    The builder of the grid.
+    //! \param initialVal The initial value of the grid.
+    //!
+    //! \return     The index of the data.
+    //!
+    size_t addAdvectableScalarDataF(
+        const ScalarGridBuilder3FPtr& builder,
+        float initialVal = 0.0f);
+
     const FaceCenteredGrid3Ptr& velocity() const;
 
     const ScalarGrid3Ptr& scalarDataAt(size_t idx) const;
@@ -55,6 +108,55 @@ class GridSystemData3 {
 
     const VectorGrid3Ptr& advectableVectorDataAt(size_t idx) const;
 
+    //! Returns the single-precision advectable scalar data at given index.
+    const ScalarGrid3FPtr& advectableScalarDataFAt(size_t idx) const;
+
+    //!
+    //! \brief Returns the back buffer of the velocity.
+    //!
+    //! The back buffer has the same shape as the velocity, and it is kept
+    //! across the time-steps so that a solver can store the previous velocity
+    //! without allocating a new grid. Its content is only meaningful within
+    //! the solver step that writes it.
+    //!
+    const FaceCenteredGrid3Ptr& velocityBackBuffer() const;
+
+    //! Returns the back buffer of the advectable scalar data at given index.
+    const ScalarGrid3Ptr& advectableScalarDataBackBufferAt(size_t idx) const;
+
+    //! Returns the back buffer of the advectable vector data at given index.
+    const VectorGrid3Ptr& advectableVectorDataBackBufferAt(size_t idx) const;
+
+    //! Returns the back buffer of the single-precision advectable scalar data
+    //! at given index.
+    const ScalarGrid3FPtr& advectableScalarDataFBackBufferAt(
+        size_t idx) const;
+
+    //!
+    //! \brief Returns the update interval of the advectable scalar data at
+    //! given index in sub-time-steps.
+    //!
+    //! A data with an interval of N is advected every N-th sub-time-step with
+    //! the time accumulated since its last update, and at the end of each
+    //! frame so that it is in sync when the frame is written. The default
+    //! interval is 1, which advects the data at every sub-time-step.
+    //!
+    unsigned int advectableScalarDataUpdateIntervalAt(size_t idx) const;
+
+    //! Returns the update interval of the advectable vector data at given
+    //! index in sub-time-steps.
+    unsigned int advectableVectorDataUpdateIntervalAt(size_t idx) const;
+
+    //! Sets the update interval of the advectable scalar data at given index
+    //! in sub-time-steps. Throws std::invalid_argument if \p interval is 0.
+    void setAdvectableScalarDataUpdateInterval(
+        size_t idx, unsigned int interval);
+
+    //! Sets the update interval of the advectable vector data at given index
+    //! in sub-time-steps. Throws std::invalid_argument if \p interval is 0.
+    void setAdvectableVectorDataUpdateInterval(
+        size_t idx, unsigned int interval);
+
     size_t numberOfScalarData() const;
 
     size_t numberOfVectorData() const;
@@ -63,12 +165,78 @@ class GridSystemData3 {
 
     size_t numberOfAdvectableVectorData() const;
 
+    //! Returns the number of the single-precision advectable scalar data.
+    size_t numberOfAdvectableScalarDataF() const;
+
+    //! Returns true if the data grids are allocated on first access.
+    bool isUsingLazyAllocation() const;
+
+    //!
+    //! \brief Sets true to allocate the data grids on first access.
+    //!
+    //! When enabled, which is the default, a data grid or back buffer that
+    //! is added has no data and only keeps its initial value until its
+    //! accessor, such as scalarDataAt() or advectableScalarDataBackBufferAt(),
+    //! is called, and resize() and reshape() skip it. So the channels that
+    //! are used later or never cost neither memory nor the time to fill
+    //! them, which is most of the start-up of a large scene. The accessor
+    //! fills the grid with the values it would have had, and the accessors
+    //! can be called from several threads at once. The velocity is always
+    //! allocated, and only the grids added afterwards are affected.
+    //!
+    void setIsUsingLazyAllocation(bool isUsing);
+
+    //! Returns the estimated memory of the grid data including the back
+    //! buffers of the advected grids. The grids that are not allocated yet
+    //! are not included.
+    size_t memoryInBytes() const;
+
+    //! Serializes the velocity and all the data grids to \p strm.
+    void serialize(std::ostream* strm) const;
+
+    //!
+    //! \brief Deserializes the grids from \p strm.
+    //!
+    //! The data grids are created by the builders when they are added, so the
+    //! grids are read into the existing ones. Throws std::invalid_argument if
+    //! the numbers of the data grids do not match the stream.
+    //!
+    void deserialize(std::istream* strm);
+
  private:
     FaceCenteredGrid3Ptr _velocity;
     std::vector<ScalarGrid3Ptr> _scalarDataList;
     std::vector<VectorGrid3Ptr> _vectorDataList;
     std::vector<ScalarGrid3Ptr> _advectableScalarDataList;
     std::vector<VectorGrid3Ptr> _advectableVectorDataList;
+    FaceCenteredGrid3Ptr _velocityBackBuffer;
+    std::vector<ScalarGrid3Ptr> _advectableScalarDataBackBuffers;
+    std::vector<VectorGrid3Ptr> _advectableVectorDataBackBuffers;
+    std::vector<unsigned int> _advectableScalarDataUpdateIntervals;
+    std::vector<unsigned int> _advectableVectorDataUpdateIntervals;
+    std::vector<ScalarGrid3FPtr> _advectableScalarDataFList;
+    std::vector<ScalarGrid3FPtr> _advectableScalarDataFBackBuffers;
+
+    // Grid that is not allocated yet, with the function that allocates it
+    // at the current size filled with its initial value
+    struct PendingGrid {
+        std::function<void()> allocate;
+        bool isZero = false;
+    };
+
+    bool _isUsingLazyAllocation = true;
+    mutable std::mutex _pendingGridsMutex;
+    mutable std::unordered_map<const void*, PendingGrid> _pendingGrids;
+    mutable std::atomic<size_t> _numberOfPendingGrids{0};
+
+    template <typename GridPtr, typename Builder, typename T>
+    GridPtr buildGrid(const Builder& builder, const T& initialVal);
+
+    bool isPendingGrid(const void* grid) const;
+
+    void allocateGrid(const void* grid) const;
+
+    void allocatePendingGrids(bool isIncludingZeroGrids) const;
 };
 
 typedef std::shared_ptr<GridSystemData3> GridSystemData3Ptr;
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_IISPH_SOLVER3_H_
+#define INCLUDE_JET_IISPH_SOLVER3_H_
+
+#include <jet/sph_solver3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D IISPH solver.
+//!
+//! This class implements 3-D implicit incompressible SPH solver. Instead of
+//! using the equation-of-state, the pressure is solved from the pressure
+//! Poisson equation with relaxed Jacobi iterations, warm-started from the
+//! pressure of the previous time-step. Since the stiffness of the fluid does
+//! not limit the time-step, the sub-time-step size is bounded only by the
+//! particle speed and the forces, which allows much larger time-steps than
+//! SphSolver3 and PciSphSolver3 for the same density error. The boundary
+//! particles of setBoundaryParticles and the collider are part of the
+//! pressure solve. The density prediction is linear in the time-step, so the
+//! peak density can overshoot the error bounds when the fluid hits a wall at
+//! the default time-step; a lower timeStepLimitScale tightens it.
+//!
+//! \see Ihmsen et al., Implicit incompressible SPH, IEEE transactions on
+//!      visualization and computer graphics 20.3 (2014): 426-435.
+//!
+class IisphSolver3 : public SphSolver3 {
+ public:
+    //! Constructs a solver with empty particle set.
+    IisphSolver3();
+
+    virtual ~IisphSolver3();
+
+    //! Returns max allowed average density error ratio.
+    double maxDensityErrorRatio() const;
+
+    //!
+    //! \brief Sets max allowed average density error ratio.
+    //!
+    //! This function sets the max allowed average density error ratio of the
+    //! compressed particles during the IISPH iterations. Default is 0.001
+    //! (0.1%). The input value should be positive.
+    //!
+    void setMaxDensityErrorRatio(double ratio);
+
+    //! Returns max allowed peak density error ratio.
+    double maxPeakDensityErrorRatio() const;
+
+    //!
+    //! \brief Sets max allowed peak density error ratio.
+    //!
+    //! The IISPH iterations also continue until the density error ratio of
+    //! every particle is below this value. Default is 0.01 (1%), which is
+    //! the default bound of PciSphSolver3. The input value should be
+    //! positive.
+    //!
+    void setMaxPeakDensityErrorRatio(double ratio);
+
+    //! Returns max number of iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //!
+    //! \brief Sets max number of IISPH iterations.
+    //!
+    //! This function sets the max number of IISPH iterations. Default is 100.
+    //!
+    void setMaxNumberOfIterations(unsigned int n);
+
+    //! Returns the number of iterations of the last time-step.
+    unsigned int lastNumberOfIterations() const;
+
+    //! Returns the average density error ratio of the last time-step.
+    double lastDensityErrorRatio() const;
+
+    //! Returns the peak density error ratio of the last time-step.
+    double lastPeakDensityErrorRatio() const;
+
+    //! Writes a checkpoint of the IISPH parameters and particles to \p strm.
+    void serialize(std::ostream* strm) const override;
+
+    //! Restores the IISPH parameters and particles from \p strm.
+    void deserialize(std::istream* strm) override;
+
+ protected:
+    //! Returns the number of sub-time-steps, which is bounded by the max
+    //! particle speed and the max force but not by the speed of sound.
+    unsigned int numberOfSubTimeSteps(
+        double timeIntervalInSeconds) const override;
+
+    //! Accumulates the pressure force to the forces array in the particle
+    //! system.
+    void accumulatePressureForce(double timeIntervalInSeconds) override;
+
+    //! Performs pre-processing step before the simulation.
+    void onBeginAdvanceTimeStep(double timeStepInSeconds) override;
+
+    //! Adds the pressure iterations and the density error ratio to the
+    //! particle statistics.
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
+ private:
+    double _maxDensityErrorRatio = 0.001;
+    double _maxPeakDensityErrorRatio = 0.01;
+    unsigned int _maxNumberOfIterations = 100;
+    unsigned int _lastNumberOfIterations = 0;
+    double _lastDensityErrorRatio = 0.0;
+    double _lastPeakDensityErrorRatio = 0.0;
+
+    ParticleSystemData3::VectorData _advectedPositions;
+    ParticleSystemData3::VectorData _advectedVelocities;
+    ParticleSystemData3::VectorData _collisionNormals;
+    ParticleSystemData3::VectorData _dii;
+    ParticleSystemData3::VectorData _boundaryGradients;
+    ParticleSystemData3::VectorData _sumDijPj;
+    ParticleSystemData3::ScalarData _aii;
+    ParticleSystemData3::ScalarData _advectedDensities;
+    ParticleSystemData3::ScalarData _newPressures;
+    ParticleSystemData3::ScalarData _densityErrors;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_IISPH_SOLVER3_H_
@@ -22,6 +22,17 @@ class ImplicitSurface3 : public Surface3 {
     //! Returns signed distance from the given point \p otherPoint.
     virtual double signedDistance(const Vector3D& otherPoint) const = 0;
 
+    //!
+    //! \brief Computes the signed distances from \p otherPoints into
+    //!        \p result.
+    //!
+    //! The default implementation calls signedDistance() in parallel.
+    //! \see Surface3::batchClosestPoint
+    //!
+    virtual void batchSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const;
+
     //! Returns closest distance from the given point \p otherPoint.
     double closestDistance(const Vector3D& otherPoint) const override;
 };
@@ -3,7 +3,10 @@
 #ifndef INCLUDE_JET_IMPLICIT_SURFACE_SET3_H_
 #define INCLUDE_JET_IMPLICIT_SURFACE_SET3_H_
 
+#include <jet/bvh3.h>
 #include <jet/implicit_surface3.h>
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 namespace jet {
@@ -15,6 +18,10 @@ namespace jet {
 //! ImplicitSurface3 by overriding implicit surface-related quries. This is
 //! class can hold a collection of other implicit surface instances.
 //!
+//! The queries are accelerated by a bounding volume hierarchy over the bounding
+//! boxes of the surfaces, which is built at the first query after a surface is
+//! added. If a surface is moved after being added, call invalidateBvh().
+//!
 class ImplicitSurfaceSet3 final : public ImplicitSurface3 {
  public:
     //! Constructs an empty implicit surface set.
@@ -35,6 +42,9 @@ class ImplicitSurfaceSet3 final : public ImplicitSurface3 {
     //! Adds an implicit surface instance.
     void addSurface(const ImplicitSurface3Ptr& surface);
 
+    //! Marks the BVH to be rebuilt at the next query.
+    void invalidateBvh();
+
     // Surface3 implementations
 
     //! Returns the closest point from the given point \p otherPoint to the
@@ -56,6 +66,20 @@ class ImplicitSurfaceSet3 final : public ImplicitSurface3 {
     //! Returns signed distance from the given point \p otherPoint.
     double signedDistance(const Vector3D& otherPoint) const override;
 
+    //!
+    //! \brief Computes the signed distances from \p otherPoints into
+    //!        \p result.
+    //!
+    //! The points are split into chunks of consecutive points, and each
+    //! surface is evaluated with its own batch query for the chunks that it
+    //! can be the closest surface of, so the analytic surfaces run their
+    //! vectorized kernels. The results are the minimum signed distances like
+    //! signedDistance().
+    //!
+    void batchSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
+
  protected:
     Vector3D actualClosestNormal(const Vector3D& otherPoint) const override;
 
@@ -64,6 +88,13 @@ class ImplicitSurfaceSet3 final : public ImplicitSurface3 {
 
  private:
     std::vector<ImplicitSurface3Ptr> _surfaces;
+
+    mutable Bvh3 _bvh;
+    mutable std::vector<BoundingBox3D> _bounds;
+    mutable std::atomic<bool> _isBvhValid{false};
+    mutable std::mutex _bvhMutex;
+
+    void buildBvh() const;
 };
 
 typedef std::shared_ptr<ImplicitSurfaceSet3> ImplicitSurfaceSet3Ptr;
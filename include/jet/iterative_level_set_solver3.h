@@ -93,6 +93,20 @@ class IterativeLevelSetSolver3 : public LevelSetSolver3 {
     //!
     void setMaxCfl(double newMaxCfl);
 
+    //! Returns the tolerance of the early stop of the reinitialization.
+    double reinitializationTolerance() const;
+
+    //!
+    //! \brief Sets the tolerance of the early stop of the reinitialization.
+    //!
+    //! The reinitialization stops before reaching the max distance once the
+    //! largest change over the solved cells in a pseudo-time step is at or
+    //! below the tolerance times the step length, which is the Eikonal
+    //! residual ||grad phi| - 1| scaled by the sign function. Zero disables
+    //! the early stop, and the negative input will be clamped to 0.
+    //!
+    void setReinitializationTolerance(double newTolerance);
+
  protected:
     //! Computes the derivatives for given grid point.
     virtual void getDerivatives(
@@ -105,8 +119,29 @@ class IterativeLevelSetSolver3 : public LevelSetSolver3 {
         std::array<double, 2>* dy,
         std::array<double, 2>* dz) const = 0;
 
+    //!
+    //! \brief Computes the derivatives for the grid points from
+    //! (iBegin, j, k) to (iEnd - 1, j, k).
+    //!
+    //! The reinitialization calls this function once per x-line of the solved
+    //! cells, and \p dx, \p dy, and \p dz hold iEnd - iBegin entries. The
+    //! default implementation calls getDerivatives for each point, and the
+    //! inheriting classes can override it with a line kernel.
+    //!
+    virtual void getDerivativesAlongX(
+        ConstArrayAccessor3<double> grid,
+        const Vector3D& gridSpacing,
+        size_t iBegin,
+        size_t iEnd,
+        size_t j,
+        size_t k,
+        std::array<double, 2>* dx,
+        std::array<double, 2>* dy,
+        std::array<double, 2>* dz) const;
+
  private:
     double _maxCfl = 0.5;
+    double _reinitializationTolerance = 1e-4;
 
     void extrapolate(
         const ConstArrayAccessor3<double>& input,
@@ -1,9 +1,12 @@
 // Copyright (c) 2016 Doyub Kim
 #ifndef INCLUDE_JET_JET_H_
 #define INCLUDE_JET_JET_H_
+#include <jet/adaptive_particle_resolution3.h>
 #include <jet/advection_solver2.h>
 #include <jet/advection_solver3.h>
 #include <jet/animation.h>
+#include <jet/apic_solver2.h>
+#include <jet/apic_solver3.h>
 #include <jet/array.h>
 #include <jet/array1.h>
 #include <jet/array2.h>
@@ -12,18 +15,26 @@
 #include <jet/array_accessor1.h>
 #include <jet/array_accessor2.h>
 #include <jet/array_accessor3.h>
+#include <jet/array_allocator.h>
 #include <jet/array_samplers.h>
 #include <jet/array_samplers1.h>
 #include <jet/array_samplers2.h>
 #include <jet/array_samplers3.h>
 #include <jet/array_utils.h>
+#include <jet/async_file_writer.h>
 #include <jet/bcc_lattice_point_generator.h>
+#include <jet/bfecc_advection3.h>
+#include <jet/bit_array3.h>
 #include <jet/blas.h>
 #include <jet/bounding_box.h>
 #include <jet/bounding_box2.h>
 #include <jet/bounding_box3.h>
 #include <jet/box2.h>
 #include <jet/box3.h>
+#include <jet/brick_pager.h>
+#include <jet/bricked_array3.h>
+#include <jet/bvh3.h>
+#include <jet/cached_scalar_field3.h>
 #include <jet/cell_centered_scalar_grid2.h>
 #include <jet/cell_centered_scalar_grid3.h>
 #include <jet/cell_centered_vector_grid2.h>
@@ -35,11 +46,14 @@
 #include <jet/collider_set3.h>
 #include <jet/collocated_vector_grid2.h>
 #include <jet/collocated_vector_grid3.h>
+#include <jet/communicator.h>
+#include <jet/composite_physics_animation.h>
 #include <jet/constant_scalar_field2.h>
 #include <jet/constant_scalar_field3.h>
 #include <jet/constant_vector_field2.h>
 #include <jet/constant_vector_field3.h>
 #include <jet/constants.h>
+#include <jet/copy_on_write_array3.h>
 #include <jet/cubic_semi_lagrangian2.h>
 #include <jet/cubic_semi_lagrangian3.h>
 #include <jet/custom_scalar_field2.h>
@@ -49,11 +63,16 @@
 #include <jet/cylinder3.h>
 #include <jet/eno_level_set_solver2.h>
 #include <jet/eno_level_set_solver3.h>
+#include <jet/error_corrected_semi_lagrangian3.h>
 #include <jet/face_centered_grid2.h>
 #include <jet/face_centered_grid3.h>
+#include <jet/fast_sweeping_level_set_solver3.h>
 #include <jet/fcc_lattice_point_generator.h>
 #include <jet/fdm_cg_solver2.h>
 #include <jet/fdm_cg_solver3.h>
+#include <jet/fdm_chebyshev_solver3.h>
+#include <jet/fdm_compressed_linear_system.h>
+#include <jet/fdm_cuda_pcg_solver3.h>
 #include <jet/fdm_gauss_seidel_solver2.h>
 #include <jet/fdm_gauss_seidel_solver3.h>
 #include <jet/fdm_iccg_solver2.h>
@@ -64,6 +83,15 @@
 #include <jet/fdm_linear_system3.h>
 #include <jet/fdm_linear_system_solver2.h>
 #include <jet/fdm_linear_system_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver2.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
+#include <jet/fdm_matrix_free_operator2.h>
+#include <jet/fdm_matrix_free_operator3.h>
+#include <jet/fdm_mg_solver2.h>
+#include <jet/fdm_mg_solver3.h>
+#include <jet/fdm_mgpcg_solver2.h>
+#include <jet/fdm_mgpcg_solver3.h>
+#include <jet/fdm_slab_cg_solver3.h>
 #include <jet/fdm_utils.h>
 #include <jet/field2.h>
 #include <jet/field3.h>
@@ -71,14 +99,17 @@
 #include <jet/flip_solver3.h>
 #include <jet/fmm_level_set_solver2.h>
 #include <jet/fmm_level_set_solver3.h>
+#include <jet/frame_filename.h>
 #include <jet/grid2.h>
 #include <jet/grid3.h>
+#include <jet/grid_adaptive_pressure_solver3.h>
 #include <jet/grid_backward_euler_diffusion_solver2.h>
 #include <jet/grid_backward_euler_diffusion_solver3.h>
 #include <jet/grid_blocked_boundary_condition_solver2.h>
 #include <jet/grid_blocked_boundary_condition_solver3.h>
 #include <jet/grid_boundary_condition_solver2.h>
 #include <jet/grid_boundary_condition_solver3.h>
+#include <jet/grid_cache3.h>
 #include <jet/grid_diffusion_solver2.h>
 #include <jet/grid_diffusion_solver3.h>
 #include <jet/grid_fluid_solver2.h>
@@ -93,12 +124,17 @@
 #include <jet/grid_point_generator3.h>
 #include <jet/grid_pressure_solver2.h>
 #include <jet/grid_pressure_solver3.h>
+#include <jet/grid_sdf_collider3.h>
+#include <jet/grid_sequence_cache3.h>
 #include <jet/grid_single_phase_pressure_solver2.h>
 #include <jet/grid_single_phase_pressure_solver3.h>
+#include <jet/grid_smoke_cuda_solver3.h>
 #include <jet/grid_smoke_solver2.h>
 #include <jet/grid_smoke_solver3.h>
+#include <jet/grid_smoke_up_res3.h>
 #include <jet/grid_system_data2.h>
 #include <jet/grid_system_data3.h>
+#include <jet/iisph_solver3.h>
 #include <jet/implicit_surface2.h>
 #include <jet/implicit_surface3.h>
 #include <jet/implicit_surface_set2.h>
@@ -112,6 +148,7 @@
 #include <jet/level_set_solver3.h>
 #include <jet/level_set_utils.h>
 #include <jet/logging.h>
+#include <jet/maccormack_advection3.h>
 #include <jet/macros.h>
 #include <jet/marching_cubes.h>
 #include <jet/math_utils.h>
@@ -119,17 +156,28 @@
 #include <jet/matrix2x2.h>
 #include <jet/matrix3x3.h>
 #include <jet/matrix4x4.h>
+#include <jet/memory_tracker.h>
+#include <jet/memory_usage.h>
+#include <jet/metrics_exporter.h>
+#include <jet/paged_array3.h>
 #include <jet/parallel.h>
+#include <jet/parallel_tuner.h>
+#include <jet/particle_cache3.h>
 #include <jet/particle_emitter2.h>
 #include <jet/particle_emitter3.h>
+#include <jet/particle_emitter_set3.h>
+#include <jet/particle_slab_decomposition3.h>
 #include <jet/particle_system_data2.h>
 #include <jet/particle_system_data3.h>
 #include <jet/particle_system_solver2.h>
 #include <jet/particle_system_solver3.h>
+#include <jet/particles_to_sdf3.h>
 #include <jet/pci_sph_solver2.h>
 #include <jet/pci_sph_solver3.h>
 #include <jet/pde.h>
+#include <jet/philox_rng.h>
 #include <jet/physics_animation.h>
+#include <jet/physics_animation_ensemble.h>
 #include <jet/pic_solver2.h>
 #include <jet/pic_solver3.h>
 #include <jet/plane2.h>
@@ -137,10 +185,13 @@
 #include <jet/point.h>
 #include <jet/point2.h>
 #include <jet/point3.h>
+#include <jet/point_cell_list_searcher3.h>
 #include <jet/point_generator2.h>
 #include <jet/point_generator3.h>
 #include <jet/point_hash_grid_searcher2.h>
 #include <jet/point_hash_grid_searcher3.h>
+#include <jet/point_hash_grid_utils.h>
+#include <jet/point_neighbor_lists.h>
 #include <jet/point_neighbor_searcher2.h>
 #include <jet/point_neighbor_searcher3.h>
 #include <jet/point_parallel_hash_grid_searcher2.h>
@@ -149,6 +200,8 @@
 #include <jet/point_particle_emitter3.h>
 #include <jet/point_simple_list_searcher2.h>
 #include <jet/point_simple_list_searcher3.h>
+#include <jet/poisson_disk_point_generator3.h>
+#include <jet/profiler.h>
 #include <jet/quaternion.h>
 #include <jet/ray.h>
 #include <jet/ray2.h>
@@ -160,12 +213,21 @@
 #include <jet/scalar_field3.h>
 #include <jet/scalar_grid2.h>
 #include <jet/scalar_grid3.h>
+#include <jet/scratch_arena.h>
 #include <jet/semi_lagrangian2.h>
 #include <jet/semi_lagrangian3.h>
 #include <jet/serial.h>
+#include <jet/shared_frame_buffer.h>
+#include <jet/simd.h>
 #include <jet/size.h>
 #include <jet/size2.h>
 #include <jet/size3.h>
+#include <jet/slab_decomposition3.h>
+#include <jet/sparse_array3.h>
+#include <jet/sparse_volume3.h>
+#include <jet/sph_boundary_particles3.h>
+#include <jet/sph_cuda_solver3.h>
+#include <jet/sph_kernel_table3.h>
 #include <jet/sph_kernels2.h>
 #include <jet/sph_kernels3.h>
 #include <jet/sph_solver2.h>
@@ -183,6 +245,8 @@
 #include <jet/timer.h>
 #include <jet/triangle3.h>
 #include <jet/triangle_mesh3.h>
+#include <jet/triangle_mesh_sdf_cache3.h>
+#include <jet/triangle_mesh_stream_writer3.h>
 #include <jet/triangle_mesh_to_sdf.h>
 #include <jet/triangle_point_generator.h>
 #include <jet/type_helpers.h>
@@ -191,6 +255,7 @@
 #include <jet/vector.h>
 #include <jet/vector2.h>
 #include <jet/vector3.h>
+#include <jet/vector3_batch.h>
 #include <jet/vector4.h>
 #include <jet/vector_field2.h>
 #include <jet/vector_field3.h>
@@ -3,8 +3,11 @@
 #ifndef INCLUDE_JET_LEVEL_SET_LIQUID_SOLVER3_H_
 #define INCLUDE_JET_LEVEL_SET_LIQUID_SOLVER3_H_
 
+#include <jet/fmm_level_set_solver3.h>
 #include <jet/grid_fluid_solver3.h>
 #include <jet/level_set_solver3.h>
+#include <jet/scratch_arena.h>
+#include <jet/vector2.h>
 
 namespace jet {
 
@@ -44,6 +47,12 @@ class LevelSetLiquidSolver3 : public GridFluidSolver3 {
     //!
     double computeVolume() const;
 
+    //! Writes a checkpoint of the parameters and the grids to \p strm.
+    void serialize(std::ostream* strm) const override;
+
+    //! Restores the parameters and the grids from \p strm.
+    void deserialize(std::istream* strm) override;
+
  protected:
     //! Called at the beginning of the time-step.
     void onBeginAdvanceTimeStep(double timeIntervalInSeconds) override;
@@ -66,12 +75,14 @@ class LevelSetLiquidSolver3 : public GridFluidSolver3 {
     double _minReinitializeDistance = 10.0;
     bool _isGlobalCompensationEnabled = false;
     double _lastKnownVolume = 0.0;
+    FmmLevelSetSolver3 _velocityExtrapolationSolver;
+    ScratchArena _scratch;
 
     void reinitialize(double currentCfl);
 
     void extrapolateVelocityToAir(double currentCfl);
 
-    void addVolume(double volDiff);
+    double addVolume(double volDiff, const Vector2D& volumes);
 };
 
 }  // namespace jet
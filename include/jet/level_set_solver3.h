@@ -74,6 +74,24 @@ class LevelSetSolver3 {
         const ScalarField3& sdf,
         double maxDistance,
         FaceCenteredGrid3* output) = 0;
+
+    //! Returns true if only the narrow band around the interface is solved.
+    bool isUsingNarrowBand() const;
+
+    //!
+    //! \brief Sets true to solve only the narrow band around the interface.
+    //!
+    //! When enabled, reinitialize() only updates the cells within the max
+    //! distance from the zero level set and clamps the others to +/- the max
+    //! distance, and extrapolate() only updates the cells within the max
+    //! distance outside of the interface and leaves the others untouched.
+    //! Since the max distance is only a few cells in a liquid simulation, this
+    //! saves most of the work on large grids.
+    //!
+    void setIsUsingNarrowBand(bool isUsing);
+
+ private:
+    bool _isUsingNarrowBand = false;
 };
 
 typedef std::shared_ptr<LevelSetSolver3> LevelSetSolver3Ptr;
@@ -3,10 +3,22 @@
 #ifndef INCLUDE_JET_LOGGING_H_
 #define INCLUDE_JET_LOGGING_H_
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 
+//!
+//! Minimum logging level that is compiled in: 0 for debug, 1 for info, 2 for
+//! warn, 3 for error, and 4 to compile out all the logs. The messages of the
+//! lower levels are still type-checked, but never formatted or written.
+//!
+#ifndef JET_MIN_LOGGING_LEVEL
+#define JET_MIN_LOGGING_LEVEL 0
+#endif
+
 namespace jet {
 
 enum class LoggingLevel {
@@ -20,7 +32,9 @@ enum class LoggingLevel {
 //! \brief Super simple logger implementation.
 //!
 //! This is a super simple logger implementation that has minimal logging
-//! capability. Currently, the class doesn't support multi-thread logging.
+//! capability. Each logger formats a single message on the calling thread,
+//! so loggers on different threads never interleave, and hands the message
+//! over to Logging when it is destroyed.
 //!
 class Logger final {
  public:
@@ -39,6 +53,17 @@ class Logger final {
     mutable std::stringstream _buffer;
 };
 
+//!
+//! \brief Output streams and the asynchronous writer of the loggers.
+//!
+//! By default, the messages are queued into a lock-free ring buffer and
+//! written by a background thread, which flushes the streams once per batch
+//! instead of once per message. A full ring buffer is drained by the logging
+//! thread itself, so no message is dropped. The error messages are written
+//! right away along with the pending ones before them. Call flush before
+//! destroying a stream that was passed to one of the setters, or before the
+//! program exits abnormally.
+//!
 class Logging {
  public:
     static void setInfoStream(std::ostream* strm);
@@ -51,27 +76,104 @@ class Logging {
 
     static void setAllStream(std::ostream* strm);
 
+    //! Returns the output stream of given level.
+    static std::ostream* stream(LoggingLevel level);
+
+    //! Returns true if the messages are written by the background thread.
+    static bool isAsynchronous();
+
+    //!
+    //! \brief Enables or disables the background writing.
+    //!
+    //! When disabled, each message is written and flushed by the logging
+    //! thread under a lock, which is slower but never loses a message when
+    //! the program crashes. Default is true.
+    //!
+    static void setIsAsynchronous(bool isAsynchronous);
+
+    //! Writes all the pending messages and flushes the streams.
+    static void flush();
+
     static std::string getHeader(LoggingLevel level);
 };
 
+//!
+//! \brief Decides which messages of a call site pass for rate limiting.
+//!
+//! Use JET_LOG_EVERY_N or JET_LOG_EVERY_SECONDS instead of this class, which
+//! keep a limiter per call site. Both functions are thread-safe.
+//!
+class LogRateLimiter final {
+ public:
+    //! Returns true for the first call and every n-th call after that.
+    bool shouldLogEveryN(size_t n);
+
+    //! Returns true if \p seconds have passed since the last true.
+    bool shouldLogEverySeconds(double seconds);
+
+ private:
+    std::atomic<size_t> _count{0};
+    std::atomic<int64_t> _lastTimeInNanoseconds{
+        std::numeric_limits<int64_t>::min()};
+};
+
 extern Logger infoLogger;
 extern Logger warnLogger;
 extern Logger errorLogger;
 extern Logger debugLogger;
 
-#define JET_INFO \
-    (Logger(LoggingLevel::Info) << Logging::getHeader(LoggingLevel::Info) \
-     << "[" << __FILE__ << ":" << __LINE__ << " (" << __func__ << ")] ")
-#define JET_WARN \
-    (Logger(LoggingLevel::Warn) << Logging::getHeader(LoggingLevel::Warn) \
-     << "[" << __FILE__ << ":" << __LINE__ << " (" << __func__ << ")] ")
-#define JET_ERROR \
-    (Logger(LoggingLevel::Error) << Logging::getHeader(LoggingLevel::Error) \
-     << "[" << __FILE__ << ":" << __LINE__ << " (" << __func__ << ")] ")
-#define JET_DEBUG \
-    (Logger(LoggingLevel::Debug) << Logging::getHeader(LoggingLevel::Debug) \
+#define JET_LOG_IMPL(level) \
+    (Logger(level) << Logging::getHeader(level) \
      << "[" << __FILE__ << ":" << __LINE__ << " (" << __func__ << ")] ")
 
+// Discarded logs become dead code, which the compiler removes
+#define JET_LOG_DISCARDED(level) while (false) JET_LOG_IMPL(level)
+
+#if JET_MIN_LOGGING_LEVEL <= 0
+#define JET_DEBUG JET_LOG_IMPL(LoggingLevel::Debug)
+#else
+#define JET_DEBUG JET_LOG_DISCARDED(LoggingLevel::Debug)
+#endif
+
+#if JET_MIN_LOGGING_LEVEL <= 1
+#define JET_INFO JET_LOG_IMPL(LoggingLevel::Info)
+#else
+#define JET_INFO JET_LOG_DISCARDED(LoggingLevel::Info)
+#endif
+
+#if JET_MIN_LOGGING_LEVEL <= 2
+#define JET_WARN JET_LOG_IMPL(LoggingLevel::Warn)
+#else
+#define JET_WARN JET_LOG_DISCARDED(LoggingLevel::Warn)
+#endif
+
+#if JET_MIN_LOGGING_LEVEL <= 3
+#define JET_ERROR JET_LOG_IMPL(LoggingLevel::Error)
+#else
+#define JET_ERROR JET_LOG_DISCARDED(LoggingLevel::Error)
+#endif
+
+//!
+//! Logs with \p log, such as JET_INFO, only at the first and every n-th
+//! pass of the call site. For example, JET_LOG_EVERY_N(JET_WARN, 100) << x;
+//!
+#define JET_LOG_EVERY_N(log, n) \
+    if (![&]() { \
+            static ::jet::LogRateLimiter limiter; \
+            return limiter.shouldLogEveryN(n); \
+        }()) { \
+    } else \
+        log
+
+//! Logs with \p log at most once per given seconds at the call site.
+#define JET_LOG_EVERY_SECONDS(log, seconds) \
+    if (![&]() { \
+            static ::jet::LogRateLimiter limiter; \
+            return limiter.shouldLogEverySeconds(seconds); \
+        }()) { \
+    } else \
+        log
+
 }  // namespace jet
 
 #endif  // INCLUDE_JET_LOGGING_H_
@@ -0,0 +1,25 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_MACCORMACK_ADVECTION3_H_
+#define INCLUDE_JET_MACCORMACK_ADVECTION3_H_
+
+#include <jet/error_corrected_semi_lagrangian3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D MacCormack advection solver.
+//!
+//! This class advects the input forward by the semi-Lagrangian method,
+//! advects the result backward, and adds half of the difference from the
+//! input to the forward result. It costs two semi-Lagrangian samples per
+//! data point and is second-order accurate where the field is smooth.
+//!
+class MacCormackAdvection3 final : public ErrorCorrectedSemiLagrangian3 {
+ public:
+    MacCormackAdvection3();
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_MACCORMACK_ADVECTION3_H_
@@ -4,7 +4,12 @@
 #define INCLUDE_JET_MARCHING_CUBES_H_
 
 #include <jet/array_accessor3.h>
+#include <jet/size3.h>
 #include <jet/triangle_mesh3.h>
+#include <jet/triangle_mesh_stream_writer3.h>
+#include <jet/vector3.h>
+#include <cstdint>
+#include <vector>
 
 namespace jet {
 
@@ -23,6 +28,22 @@ static const int kMarchingCubesBoundaryFlagAll
     | kMarchingCubesBoundaryFlagBack
     | kMarchingCubesBoundaryFlagFront;
 
+//!
+//! \brief Computes the iso-surface of the vertex-centered \p grid and appends
+//!        it to \p mesh.
+//!
+//! The interior cubes are marched in parallel slabs along the z-axis. The
+//! vertices on the grid edges are welded, so each edge crossing becomes a
+//! single point. The boundary of the grid selected by \p bndFlag is closed by
+//! the marching squares on the faces of the grid.
+//!
+//! \param grid      The scalar values at the grid points.
+//! \param gridSize  The grid spacing.
+//! \param origin    The position of the first grid point.
+//! \param mesh      The mesh to append the iso-surface to.
+//! \param isoValue  The iso-value of the surface.
+//! \param bndFlag   The grid boundaries to close.
+//!
 void marchingCubes(
     const ConstArrayAccessor3<double>& grid,
     const Vector3D& gridSize,
@@ -31,6 +52,105 @@ void marchingCubes(
     double isoValue = 0,
     int bndFlag = kMarchingCubesBoundaryFlagAll);
 
+//!
+//! \brief Computes the iso-surface of the vertex-centered \p grid and writes
+//!        it to \p writer.
+//!
+//! This function is identical to the one above, except that the interior
+//! iso-surface is written to \p writer every few slabs, so the whole mesh is
+//! never held in memory. The closed boundary is written as the last chunk.
+//! Reading the stream back with TriangleMesh3::readBinary gives the same mesh
+//! as the function above.
+//!
+void marchingCubes(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    TriangleMeshStreamWriter3* writer,
+    double isoValue = 0,
+    int bndFlag = kMarchingCubesBoundaryFlagAll);
+
+//!
+//! \brief Marching cubes that only remeshes the changed tiles of the grid.
+//!
+//! The cubes are grouped into tiles of tileSize() cubes along each axis, and
+//! the iso-surface of each tile is cached. update() hashes the grid values
+//! that a tile depends on, which are its nodes and their neighbors for the
+//! normals, and marches only the tiles whose hash differs from the previous
+//! call. The tile meshes are then stitched by welding the vertices on the
+//! shared grid edges, so the output has the same points, normals, and
+//! triangles as marchingCubes, only in the tile order. Hashing reads the
+//! grid once, which is much cheaper than marching it, so the cost of a frame
+//! scales with the changed part of the surface. All the tiles are remeshed
+//! when the grid layout or the iso-value changes.
+//!
+//! The cache is not thread-safe; a sequence of frames should be meshed by
+//! one thread at a time.
+//!
+class MarchingCubesTileCache3 final {
+ public:
+    //! Default number of cubes of a tile along each axis.
+    static const size_t kDefaultTileSize = 16;
+
+    //! Constructs an empty cache with tiles of \p tileSize cubes per axis.
+    explicit MarchingCubesTileCache3(size_t tileSize = kDefaultTileSize);
+
+    //!
+    //! \brief Computes the iso-surface of the vertex-centered \p grid and
+    //!        appends it to \p mesh, reusing the unchanged tiles.
+    //!
+    //! The parameters are the same as marchingCubes. The closed boundary of
+    //! the grid is marched every time, since it is only two-dimensional.
+    //!
+    void update(
+        const ConstArrayAccessor3<double>& grid,
+        const Vector3D& gridSize,
+        const Vector3D& origin,
+        TriangleMesh3* mesh,
+        double isoValue = 0,
+        int bndFlag = kMarchingCubesBoundaryFlagAll);
+
+    //! Returns the number of cubes of a tile along each axis.
+    size_t tileSize() const;
+
+    //! Returns the number of tiles of the last grid.
+    size_t numberOfTiles() const;
+
+    //! Returns the number of tiles marched by the last update().
+    size_t numberOfRemeshedTiles() const;
+
+    //! Drops the cached tiles, so the next update() remeshes everything.
+    void clear();
+
+ private:
+    struct Tile {
+        uint64_t hash = 0;
+        bool isValid = false;
+
+        // Global edge key of each point, used to weld the tiles
+        std::vector<size_t> edgeKeys;
+        std::vector<Vector3D> points;
+        std::vector<Vector3D> normals;
+        std::vector<Point3UI> triangles;
+    };
+
+    size_t _tileSize;
+    Size3 _dataSize;
+    Vector3D _gridSize;
+    Vector3D _origin;
+    double _isoValue = 0.0;
+    Size3 _numberOfTiles;
+    std::vector<Tile> _tiles;
+    size_t _numberOfRemeshedTiles = 0;
+
+    void marchTile(
+        const ConstArrayAccessor3<double>& grid,
+        size_t ti,
+        size_t tj,
+        size_t tk,
+        Tile* tile) const;
+};
+
 }  // namespace jet
 
 #endif  // INCLUDE_JET_MARCHING_CUBES_H_
@@ -0,0 +1,151 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_MEMORY_TRACKER_H_
+#define INCLUDE_JET_MEMORY_TRACKER_H_
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+namespace jet {
+
+//! Subsystems that the tracked memory is accounted to.
+enum class MemoryTag : unsigned char {
+    //! Memory allocated outside of any MemoryTagScope.
+    Other = 0,
+
+    //! Data of the grids, such as the channels of GridSystemData3.
+    Grid,
+
+    //! Matrix and vectors of the FDM linear systems.
+    LinearSystem,
+
+    //! Temporary vectors of the linear system solvers.
+    LinearSolver,
+
+    //! Data layers of the particle systems.
+    Particle,
+
+    //! Neighbor lists of the particles.
+    NeighborList,
+
+    //! Hash tables of the point neighbor searchers.
+    NeighborSearch,
+
+    //! Per-step temporaries handed out by ScratchArena.
+    Scratch
+};
+
+//! Number of the memory tags.
+const size_t kNumberOfMemoryTags = 8;
+
+//!
+//! \brief Accounts the memory allocated with MemoryTrackingAllocator.
+//!
+//! The arrays and the tables of the neighbor searchers allocate their memory
+//! through MemoryTrackingAllocator, which accounts each allocation to the
+//! tag of the innermost MemoryTagScope of the allocating thread. The owners,
+//! such as GridSystemData3 and ParticleSystemData3, open the scopes when
+//! they resize their data. The counters are atomic, so all the functions are
+//! thread-safe.
+//!
+class MemoryTracker {
+ public:
+    //! Returns the bytes currently allocated with given tag.
+    static size_t bytes(MemoryTag tag);
+
+    //! Returns the high-water mark of given tag since the last reset.
+    static size_t peakBytes(MemoryTag tag);
+
+    //! Returns the bytes currently allocated with all the tags.
+    static size_t totalBytes();
+
+    //! Returns the high-water mark of all the tags since the last reset.
+    static size_t peakTotalBytes();
+
+    //!
+    //! \brief Resets the high-water marks to the current bytes.
+    //!
+    //! PhysicsAnimation resets the marks before each sub-time-step, so the
+    //! peaks after the step are the ones of the step.
+    //!
+    static void resetPeakBytes();
+
+    //! Returns the tag of the innermost scope of the calling thread.
+    static MemoryTag currentTag();
+
+    //! Returns the name of given tag, such as "grid".
+    static const char* tagName(MemoryTag tag);
+
+    //! Writes the current and the peak bytes of each tag to \p strm.
+    static void printReport(std::ostream* strm);
+
+    //! Accounts \p bytes allocated with given tag.
+    static void onAllocate(MemoryTag tag, size_t bytes);
+
+    //! Accounts \p bytes released with given tag.
+    static void onDeallocate(MemoryTag tag, size_t bytes);
+};
+
+//!
+//! \brief Sets the memory tag of the calling thread for its lifetime.
+//!
+//! The scopes nest, and the previous tag is restored on destruction. The
+//! tag does not follow the work into the threads of parallelFor, whose
+//! allocations are accounted to their own scopes or to MemoryTag::Other.
+//!
+class MemoryTagScope final {
+ public:
+    explicit MemoryTagScope(MemoryTag tag);
+
+    ~MemoryTagScope();
+
+    MemoryTagScope(const MemoryTagScope&) = delete;
+
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+ private:
+    MemoryTag _previousTag;
+};
+
+//!
+//! \brief Standard allocator that accounts its memory to MemoryTracker.
+//!
+//! Each block starts with a small header that remembers the tag it was
+//! allocated with, so the allocator is stateless and the memory can be
+//! released from any thread and any scope.
+//!
+template <typename T>
+class MemoryTrackingAllocator {
+ public:
+    typedef T value_type;
+
+    MemoryTrackingAllocator() = default;
+
+    template <typename U>
+    MemoryTrackingAllocator(const MemoryTrackingAllocator<U>&) {}
+
+    //! Allocates memory for \p n objects.
+    T* allocate(size_t n);
+
+    //! Releases the memory for \p n objects at \p p.
+    void deallocate(T* p, size_t n);
+};
+
+template <typename T, typename U>
+bool operator==(
+    const MemoryTrackingAllocator<T>&, const MemoryTrackingAllocator<U>&);
+
+template <typename T, typename U>
+bool operator!=(
+    const MemoryTrackingAllocator<T>&, const MemoryTrackingAllocator<U>&);
+
+//! std::vector whose memory is accounted to MemoryTracker.
+template <typename T>
+using TrackedVector = std::vector<T, MemoryTrackingAllocator<T>>;
+
+}  // namespace jet
+
+#include "detail/memory_tracker-inl.h"
+
+#endif  // INCLUDE_JET_MEMORY_TRACKER_H_
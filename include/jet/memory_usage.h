@@ -0,0 +1,30 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_MEMORY_USAGE_H_
+#define INCLUDE_JET_MEMORY_USAGE_H_
+
+#include <cstddef>
+
+namespace jet {
+
+//!
+//! \brief Returns the peak resident set size of the process in bytes.
+//!
+//! This is the high-water mark of the physical memory used by the process
+//! since it started, so it never decreases. Returns zero if the platform
+//! does not report it.
+//!
+size_t peakResidentSetSizeInBytes();
+
+//!
+//! \brief Returns the current resident set size of the process in bytes.
+//!
+//! This is the physical memory used by the process at the moment, which
+//! drops when the memory is returned to the system. Returns zero if the
+//! platform does not report it.
+//!
+size_t residentSetSizeInBytes();
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_MEMORY_USAGE_H_
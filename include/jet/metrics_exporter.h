@@ -0,0 +1,138 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_METRICS_EXPORTER_H_
+#define INCLUDE_JET_METRICS_EXPORTER_H_
+
+#include <jet/macros.h>
+#include <jet/physics_animation.h>
+#include <jet/profiler.h>
+#include <jet/timer.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Exports live metrics of a running simulation.
+//!
+//! record() takes the statistics of the last frame of a physics animation,
+//! usually from its frame callback, which only copies a few numbers under a
+//! lock. A background thread started by start() then exports the latest
+//! metrics periodically, so the step loop never waits on the disk or the
+//! network. The metrics are:
+//!
+//! - jet_frame_index, jet_frames_total and jet_frame_duration_seconds,
+//! - jet_sub_time_steps and jet_pressure_iterations of the last frame,
+//! - jet_particles and jet_cfl at the end of the last frame,
+//! - jet_tracked_memory_peak_bytes of MemoryTracker in the last frame,
+//! - jet_resident_set_size_bytes of the process at the export,
+//! - jet_stage_duration_seconds for each scope of the last frame if the
+//!   Profiler is enabled, labeled with the path of the scope, and
+//! - jet_seconds_since_last_frame, which grows when a job stalls.
+//!
+//! The metrics can be written as a Prometheus text file, which is pulled by
+//! the textfile collector of the node exporter, and pushed as StatsD gauges
+//! over UDP. The file is replaced atomically, and a failed export is skipped
+//! until the next period.
+//!
+class MetricsExporter {
+ public:
+    JET_NON_COPYABLE(MetricsExporter)
+
+    //!
+    //! \brief Constructs an exporter for the job named \p jobName.
+    //!
+    //! The name is the "job" label of the Prometheus metrics and the prefix
+    //! of the StatsD metrics, so it should only have letters, digits, and
+    //! underscores.
+    //!
+    explicit MetricsExporter(const std::string& jobName = "jet");
+
+    //! Stops the background thread.
+    ~MetricsExporter();
+
+    //! Returns the name of the job.
+    const std::string& jobName() const;
+
+    //! Records the statistics of the last frame of \p animation.
+    void record(const PhysicsAnimation& animation);
+
+    //! Returns the metrics in the Prometheus text exposition format.
+    std::string prometheusText() const;
+
+    //! Returns the metrics as StatsD gauges, one per line.
+    std::string statsdText() const;
+
+    //!
+    //! \brief Sets the file the Prometheus text is written to.
+    //!
+    //! Pass an empty name, which is the default, to disable the file.
+    //!
+    void setPrometheusFile(const std::string& filename);
+
+    //!
+    //! \brief Sets the StatsD server the gauges are pushed to over UDP.
+    //!
+    //! Pass an empty host, which is the default, to disable the push.
+    //!
+    void setStatsdServer(const std::string& host, uint16_t port = 8125);
+
+    //!
+    //! \brief Starts exporting the metrics every \p intervalInSeconds.
+    //!
+    //! The metrics are exported once right away. Calling it again changes
+    //! the interval.
+    //!
+    void start(double intervalInSeconds = 10.0);
+
+    //! Stops exporting, and exports the metrics once more.
+    void stop();
+
+    //! Returns true if the background thread is running.
+    bool isRunning() const;
+
+    //!
+    //! \brief Exports the metrics once on the calling thread.
+    //!
+    //! \return     True if all the enabled exports succeeded.
+    //!
+    bool exportNow();
+
+ private:
+    struct Snapshot {
+        uint64_t numberOfFrames = 0;
+        unsigned int frameIndex = 0;
+        double frameDurationInSeconds = 0.0;
+        size_t numberOfSubTimeSteps = 0;
+        size_t numberOfPressureIterations = 0;
+        size_t numberOfParticles = 0;
+        double cfl = 0.0;
+        size_t peakTrackedMemoryInBytes = 0;
+        double lastFrameTimeInSeconds = 0.0;
+        std::vector<ProfileReportEntry> stages;
+    };
+
+    std::string _jobName;
+    Timer _timer;
+    Snapshot _snapshot;
+    std::string _prometheusFile;
+    std::string _statsdHost;
+    uint16_t _statsdPort = 8125;
+    double _intervalInSeconds = 10.0;
+    bool _isStopping = false;
+    mutable std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::thread _thread;
+
+    void run();
+
+    Snapshot snapshot(double* secondsSinceLastFrame) const;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_METRICS_EXPORTER_H_
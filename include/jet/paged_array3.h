@@ -0,0 +1,162 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PAGED_ARRAY3_H_
+#define INCLUDE_JET_PAGED_ARRAY3_H_
+
+#include <jet/array3.h>
+#include <jet/brick_pager.h>
+#include <jet/macros.h>
+#include <jet/size3.h>
+#include <memory>
+#include <type_traits>
+
+namespace jet {
+
+//!
+//! \brief 3-D array class whose bricks are paged to a scratch file.
+//!
+//! This class stores a 3-D array that does not need to fit in the memory.
+//! The index space is divided into bricks of 8 x 8 x 8 elements, and only
+//! the recently used bricks are kept in the memory, up to
+//! maxNumberOfResidentBricks(). The others are stored in an anonymous scratch
+//! file by BrickPager. A brick is written to the file only once it has been
+//! modified and evicted, so a new array takes neither memory nor disk space
+//! until it is written.
+//!
+//! The element accessors look up the brick on every call, so the sweeps,
+//! which pin one brick at a time and visit all of its elements, are the fast
+//! way to read and write the array. They visit the bricks in the order of the
+//! file and hint the read-ahead of the next bricks. A typical use is to park
+//! the data that is only touched once in a while, such as an auxiliary
+//! channel with a long update interval: set() moves it out of the memory,
+//! and copyTo() brings it back.
+//!
+//! Since the storage is not linear, this class does not provide the
+//! ArrayAccessor3 views of Array3. The accessors and the sweeps are
+//! thread-safe, but two threads must not write to the same element at the
+//! same time.
+//!
+//! \tparam T - Type to store in the array, which is copied as raw bytes to
+//!             and from the file, such as double or Vector3D.
+//!
+template <typename T>
+class PagedArray3 final {
+ public:
+    static_assert(
+        std::is_trivially_destructible<T>::value,
+        "PagedArray3 only stores plain data types.");
+
+    JET_NON_COPYABLE(PagedArray3)
+
+    //! Number of elements of a brick along each axis.
+    static const size_t kBrickSize = 8;
+
+    //! Default max number of the bricks kept in the memory.
+    static const size_t kDefaultMaxNumberOfResidentBricks = 4096;
+
+    //! Constructs zero-sized 3-D paged array.
+    PagedArray3();
+
+    //! Constructs 3-D paged array with given \p size and \p initVal, keeping
+    //! up to \p maxNumberOfResidentBricks bricks in the memory.
+    explicit PagedArray3(
+        const Size3& size,
+        const T& initVal = T(),
+        size_t maxNumberOfResidentBricks = kDefaultMaxNumberOfResidentBricks);
+
+    //! Resizes the array and sets all the elements to \p initVal.
+    void resize(const Size3& size, const T& initVal = T());
+
+    //! Resizes the array to the size of \p dense and copies its elements.
+    void set(const ConstArrayAccessor3<T>& dense);
+
+    //! Copies the elements to \p dense, which is resized to this array.
+    void copyTo(Array3<T>* dense) const;
+
+    //! Returns the size of the array.
+    Size3 size() const;
+
+    //! Returns the width of the array.
+    size_t width() const;
+
+    //! Returns the height of the array.
+    size_t height() const;
+
+    //! Returns the depth of the array.
+    size_t depth() const;
+
+    //! Returns the (i, j, k) element.
+    T operator()(size_t i, size_t j, size_t k) const;
+
+    //! Sets the (i, j, k) element to \p value.
+    void set(size_t i, size_t j, size_t k, const T& value);
+
+    //! Returns the max number of the bricks kept in the memory.
+    size_t maxNumberOfResidentBricks() const;
+
+    //! Sets the max number of the bricks kept in the memory, evicting the
+    //! least recently used bricks if needed.
+    void setMaxNumberOfResidentBricks(size_t numberOfBricks);
+
+    //! Returns the number of the bricks in the memory.
+    size_t numberOfResidentBricks() const;
+
+    //! Returns the number of the bricks read from the scratch file so far.
+    size_t numberOfBrickReads() const;
+
+    //! Returns the number of the bricks written to the scratch file so far.
+    size_t numberOfBrickWrites() const;
+
+    //!
+    //! \brief Iterates the array brick by brick.
+    //!
+    //! The callback takes (i, j, k) and the const reference to the element.
+    //! The bricks are visited in the order of (i, j, k) of the bricks, and the
+    //! elements within a brick in the order of (i, j, k) as well.
+    //!
+    template <typename Callback>
+    void forEachIndex(Callback func) const;
+
+    //!
+    //! \brief Iterates the array brick by brick in parallel.
+    //!
+    //! Same as forEachIndex, but the bricks are distributed over the threads,
+    //! so the execution order is not guaranteed.
+    //!
+    template <typename Callback>
+    void parallelForEachIndex(Callback func) const;
+
+    //!
+    //! \brief Updates the array brick by brick in parallel.
+    //!
+    //! Same as parallelForEachIndex, but the callback takes the reference to
+    //! the element, which it may modify. Every brick is written to the
+    //! scratch file when it is evicted afterwards.
+    //!
+    template <typename Callback>
+    void parallelUpdate(Callback func);
+
+ private:
+    static const size_t kBrickVolume = kBrickSize * kBrickSize * kBrickSize;
+
+    // Number of the bricks whose read-ahead is hinted by the sweeps
+    static const size_t kPrefetchDistance = 16;
+
+    Size3 _size;
+    Size3 _numberOfBricks;
+    size_t _maxNumberOfResidentBricks = kDefaultMaxNumberOfResidentBricks;
+    std::unique_ptr<BrickPager> _pager;
+
+    template <typename Value, typename Callback>
+    void forEachIndexInBrick(size_t brick, Value* data, Callback func) const;
+
+    size_t brickIndex(size_t i, size_t j, size_t k) const;
+
+    static size_t localIndex(size_t i, size_t j, size_t k);
+};
+
+}  // namespace jet
+
+#include "detail/paged_array3-inl.h"
+
+#endif  // INCLUDE_JET_PAGED_ARRAY3_H_
@@ -3,6 +3,10 @@
 #ifndef INCLUDE_JET_PARALLEL_H_
 #define INCLUDE_JET_PARALLEL_H_
 
+#include <functional>
+#include <iterator>
+#include <vector>
+
 namespace jet {
 
 //!
@@ -30,7 +34,8 @@ void parallelFill(
 //!
 //! This function makes a for-loop specified by begin and end indices in
 //! parallel. The order of the visit is not guaranteed due to the nature of
-//! parallel execution.
+//! parallel execution. With the thread pool backend, an exception thrown by
+//! \p function is rethrown to the caller once the other tasks are done.
 //!
 //! \param[in]  beginIndex The begin index.
 //! \param[in]  endIndex   The end index.
@@ -45,6 +50,30 @@ void parallelFor(
     IndexType endIndex,
     const Function& function);
 
+//!
+//! \brief      Makes a for-loop from \p beginIndex \p to endIndex in parallel
+//!             with given grain size.
+//!
+//! This function is identical to the one above, except that the range is
+//! split into chunks of \p grainSize indices which are load-balanced across
+//! the threads. Smaller grain size gives better balance for irregular work
+//! while larger grain size reduces the scheduling overhead.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  grainSize  The number of indices per chunk.
+//! \param[in]  function   The function to call for each index.
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Function>
+void parallelFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    IndexType grainSize,
+    const Function& function);
+
 //!
 //! \brief      Makes a 2D nested for-loop in parallel.
 //!
@@ -99,10 +128,173 @@ void parallelFor(
     IndexType endIndexZ,
     const Function& function);
 
+//!
+//! \brief      Makes a range-loop from \p beginIndex \p to endIndex in
+//!             parallel.
+//!
+//! This function splits the range into one chunk per thread and calls
+//! \p function once per chunk with its begin and end (exclusive) indices.
+//! Since the inner loop is written by the caller, the compiler can inline
+//! and vectorize it.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  function   The function to call for each chunk (begin, end).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function);
+
+//!
+//! \brief      Makes a range-loop from \p beginIndex \p to endIndex in
+//!             parallel with given grain size.
+//!
+//! This function splits the range into chunks of \p grainSize indices and
+//! calls \p function once per chunk with its begin and end (exclusive)
+//! indices. The chunks are load-balanced across the threads.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  grainSize  The number of indices per chunk.
+//! \param[in]  function   The function to call for each chunk (begin, end).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndex,
+    IndexType endIndex,
+    IndexType grainSize,
+    const Function& function);
+
+//!
+//! \brief      Makes a 2D nested range-loop in parallel.
+//!
+//! This function splits the Y range into slices and calls \p function once
+//! per slice with (beginX, endX, beginY, endY). Each slice spans the whole X
+//! range so that the inner-most loop is contiguous in memory. The end
+//! indices are exclusive.
+//!
+//! \param[in]  beginIndexX The begin index in X dimension.
+//! \param[in]  endIndexX   The end index in X dimension.
+//! \param[in]  beginIndexY The begin index in Y dimension.
+//! \param[in]  endIndexY   The end index in Y dimension.
+//! \param[in]  function    The function to call for each slice.
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndexX,
+    IndexType endIndexX,
+    IndexType beginIndexY,
+    IndexType endIndexY,
+    const Function& function);
+
+//!
+//! \brief      Makes a 3D nested range-loop in parallel.
+//!
+//! This function splits the 3D range into cache-sized bricks and calls
+//! \p function once per brick with (beginX, endX, beginY, endY, beginZ, endZ).
+//! The end indices are exclusive. Each brick spans the whole X range so that
+//! the inner-most loop is contiguous in memory.
+//!
+//! \param[in]  beginIndexX The begin index in X dimension.
+//! \param[in]  endIndexX   The end index in X dimension.
+//! \param[in]  beginIndexY The begin index in Y dimension.
+//! \param[in]  endIndexY   The end index in Y dimension.
+//! \param[in]  beginIndexZ The begin index in Z dimension.
+//! \param[in]  endIndexZ   The end index in Z dimension.
+//! \param[in]  function    The function to call for each brick.
+//!
+//! \tparam     IndexType   Index type.
+//! \tparam     Function    Function type.
+//!
+template <typename IndexType, typename Function>
+void parallelRangeFor(
+    IndexType beginIndexX,
+    IndexType endIndexX,
+    IndexType beginIndexY,
+    IndexType endIndexY,
+    IndexType beginIndexZ,
+    IndexType endIndexZ,
+    const Function& function);
+
+//!
+//! \brief      Reduces the values from \p beginIndex to \p endIndex in
+//!             parallel.
+//!
+//! This function splits the range into chunks and calls \p function for each
+//! chunk with its begin and end (exclusive) indices and \p identity as the
+//! initial value. The partial results are then combined with \p reduce.
+//! The chunk boundaries only depend on the size of the range, and the partial
+//! results are always combined in the same pair-wise order, so the result is
+//! deterministic regardless of the number of threads (bit-wise identical
+//! floating-point sums from run to run).
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  identity   The identity value for the reduction.
+//! \param[in]  function   The function that reduces a chunk, which has the
+//!                        signature Value(IndexType begin, IndexType end,
+//!                        const Value& init).
+//! \param[in]  reduce     The function that combines two partial results.
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Value      Value type.
+//! \tparam     Function   Chunk reduction function type.
+//! \tparam     Reduce     Combine function type.
+//!
+//! \return     The reduced value.
+//!
+template <
+    typename IndexType,
+    typename Value,
+    typename Function,
+    typename Reduce>
+Value parallelReduce(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Value& identity,
+    const Function& function,
+    const Reduce& reduce);
+
+//!
+//! \brief      Finds the min and max of the values from \p beginIndex to
+//!             \p endIndex in parallel.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  function   The function that returns the value at given index.
+//! \param[out] minValue   The min value. Set to the max of Value if the range
+//!                        is empty.
+//! \param[out] maxValue   The max value. Set to the lowest of Value if the
+//!                        range is empty.
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Value      Value type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Value, typename Function>
+void parallelMinMax(
+    IndexType beginIndex,
+    IndexType endIndex,
+    const Function& function,
+    Value* minValue,
+    Value* maxValue);
+
 //!
 //! \brief      Sorts a container in parallel.
 //!
 //! This function sorts a container specified by begin and end iterators.
+//! The sort is stable in the deterministic mode.
 //!
 //! \param[in]  begin          The begin random access iterator.
 //! \param[in]  end            The end random access iterator.
@@ -117,7 +309,13 @@ void parallelSort(RandomIterator begin, RandomIterator end);
 //!
 //! This function sorts a container specified by begin and end iterators. It
 //! takes extra compare function which returns true if the first argument is
-//! less than the second argument.
+//! less than the second argument. The sort is stable in the deterministic
+//! mode.
+//!
+//! The range is cut into one leaf per thread, and the leaves are sorted in
+//! parallel. The sorted runs are then merged pairwise through one temporary
+//! buffer, and each round of the merges is split evenly over the threads
+//! with merge-path partitioning, so no merge runs serially.
 //!
 //! \param[in]  begin           The begin random access iterator.
 //! \param[in]  end             The end random access iterator.
@@ -132,6 +330,306 @@ void parallelSort(
     RandomIterator end,
     CompareFunction compare);
 
+//!
+//! \brief      Sorts unsigned integer keys and their values in parallel.
+//!
+//! This function performs a stable LSD radix sort on the keys from
+//! \p keysBegin to \p keysEnd, and applies the same permutation to the values
+//! starting from \p valuesBegin. Only as many 8-bit digits as needed to
+//! represent \p maxKey are processed, so bounded keys such as hash-grid
+//! bucket indices take only a few passes.
+//!
+//! \param[in]  keysBegin      The begin iterator of the keys.
+//! \param[in]  keysEnd        The end iterator of the keys.
+//! \param[in]  valuesBegin    The begin iterator of the values.
+//! \param[in]  maxKey         The upper bound (inclusive) of the keys.
+//!
+//! \tparam     KeyIterator    Random iterator type of the keys.
+//! \tparam     ValueIterator  Random iterator type of the values.
+//!
+template <typename KeyIterator, typename ValueIterator>
+void parallelRadixSort(
+    KeyIterator keysBegin,
+    KeyIterator keysEnd,
+    ValueIterator valuesBegin,
+    typename std::iterator_traits<KeyIterator>::value_type maxKey);
+
+//!
+//! \brief      Computes the exclusive prefix sums of a range in parallel.
+//!
+//! This function writes init, init + x0, init + x0 + x1, ... from \p output,
+//! and returns the sum of \p init and all the values, such as the total
+//! count when the values are per-bucket counts. The range is split into
+//! blocks whose boundaries only depend on its size. The blocks are summed in
+//! parallel, the block sums are scanned serially, and then the blocks are
+//! scanned in parallel from their offsets, so the result is deterministic
+//! regardless of the number of threads. \p output can be \p begin.
+//!
+//! \param[in]  begin          The begin iterator of the values.
+//! \param[in]  end            The end iterator of the values.
+//! \param[out] output         The begin iterator of the prefix sums.
+//! \param[in]  init           The initial value.
+//!
+//! \tparam     InputIterator  Random iterator type of the values.
+//! \tparam     OutputIterator Random iterator type of the prefix sums.
+//! \tparam     T              Value type.
+//!
+//! \return     The sum of \p init and all the values.
+//!
+template <typename InputIterator, typename OutputIterator, typename T>
+T parallelExclusiveScan(
+    InputIterator begin,
+    InputIterator end,
+    OutputIterator output,
+    const T& init);
+
+//!
+//! \brief      Computes the exclusive prefix scan of a range with a custom
+//!             associative operation in parallel.
+//!
+//! Same as the sum version, but combines the values with \p op, which takes
+//! the partial result first.
+//!
+template <
+    typename InputIterator,
+    typename OutputIterator,
+    typename T,
+    typename BinaryOperation>
+T parallelExclusiveScan(
+    InputIterator begin,
+    InputIterator end,
+    OutputIterator output,
+    const T& init,
+    BinaryOperation op);
+
+//!
+//! \brief      Copies the elements that satisfy a predicate in parallel.
+//!
+//! The elements from \p begin to \p end for which \p predicate returns true
+//! are copied to \p output in their original order, using the same blocked
+//! two-pass scheme as parallelExclusiveScan. The predicate is evaluated once
+//! per element. The output must not overlap with the input.
+//!
+//! \param[in]  begin          The begin iterator of the input.
+//! \param[in]  end            The end iterator of the input.
+//! \param[out] output         The begin iterator of the output.
+//! \param[in]  predicate      The predicate of an element.
+//!
+//! \return     The end iterator of the copied elements.
+//!
+template <
+    typename InputIterator,
+    typename OutputIterator,
+    typename Predicate>
+OutputIterator parallelCopyIf(
+    InputIterator begin,
+    InputIterator end,
+    OutputIterator output,
+    Predicate predicate);
+
+//!
+//! \brief      Writes the indices that satisfy a predicate in parallel.
+//!
+//! The indices from \p beginIndex to \p endIndex for which \p predicate
+//! returns true are written to \p output in increasing order, which builds
+//! lists such as the active cells or the particles to remove.
+//!
+//! \param[in]  beginIndex     The begin index.
+//! \param[in]  endIndex       The end index.
+//! \param[out] output         The begin iterator of the indices.
+//! \param[in]  predicate      The predicate of an index.
+//!
+//! \return     The number of the written indices.
+//!
+template <typename IndexType, typename OutputIterator, typename Predicate>
+size_t parallelCompact(
+    IndexType beginIndex,
+    IndexType endIndex,
+    OutputIterator output,
+    Predicate predicate);
+
+//!
+//! \brief      Partitions a range by a predicate in parallel.
+//!
+//! The elements for which \p predicate returns true are moved before the
+//! others. Like std::stable_partition, the relative order is kept in both
+//! groups. The elements are moved through a temporary buffer.
+//!
+//! \param[in]  begin          The begin random access iterator.
+//! \param[in]  end            The end random access iterator.
+//! \param[in]  predicate      The predicate of an element.
+//!
+//! \return     The iterator to the first element of the second group.
+//!
+template <typename RandomIterator, typename Predicate>
+RandomIterator parallelPartition(
+    RandomIterator begin,
+    RandomIterator end,
+    Predicate predicate);
+
+//!
+//! \brief      Runs independent tasks in parallel.
+//!
+//! This function runs each of \p tasks once on the thread pool and returns
+//! once all of them are done. The tasks must not depend on each other, since
+//! they may run in any order or at the same time. The parallel functions
+//! called from a task share the same pool, so a few large tasks, such as the
+//! independent stages of a solver, still use all the threads.
+//!
+//! \param[in]  tasks The tasks to run.
+//!
+void parallelInvoke(const std::vector<std::function<void()>>& tasks);
+
+//!
+//! \brief      Sets the maximum number of threads to use.
+//!
+//! All the parallel functions above run on a single process-wide thread pool
+//! that is created on first use with as many threads as the hardware
+//! concurrency. This function resizes the pool. The calling thread is counted
+//! as one of the threads, so passing 1 makes every parallel function run
+//! serially. With the other backends (see setParallelBackend), it limits the
+//! TBB arena or the OpenMP team instead. Do not call this function while any
+//! parallel work is in flight.
+//!
+//! \param[in]  numThreads The number of threads (clamped to at least 1).
+//!
+void setMaxNumberOfThreads(unsigned int numThreads);
+
+//!
+//! \brief      Returns the maximum number of threads to use.
+//!
+unsigned int maxNumberOfThreads();
+
+//!
+//! \brief Runs the parallel functions called from the calling thread
+//!     serially for its lifetime.
+//!
+//! Within the scope, the parallel functions called from the thread run all
+//! their tasks on it, and maxNumberOfThreads() returns 1 on it, as if
+//! setMaxNumberOfThreads(1) only applied to this thread. The other threads
+//! are not affected, so jobs too small to gain from the fan-out, such as
+//! the simulations of PhysicsAnimationEnsemble, can run side by side on the
+//! threads of the pool. The scopes nest, and the previous state is restored
+//! on destruction.
+//!
+class SerialExecutionScope final {
+ public:
+    SerialExecutionScope();
+
+    ~SerialExecutionScope();
+
+    SerialExecutionScope(const SerialExecutionScope&) = delete;
+
+    SerialExecutionScope& operator=(const SerialExecutionScope&) = delete;
+
+ private:
+    bool _wasSerial;
+};
+
+//!
+//! \brief      Returns true if the calling thread is in a
+//!             SerialExecutionScope.
+//!
+bool isSerialExecutionScope();
+
+//!
+//! \brief      Enables or disables pinning the threads to the cores.
+//!
+//! With the pinning, the i-th worker of the thread pool is pinned to the
+//! core i + 1, and the calling thread, which runs the first task of each
+//! parallel call, to the core 0. The tasks of a parallel call are dealt to
+//! the threads round-robin, so the same chunk of a range goes to the same
+//! core from call to call unless a thread runs out of work and steals it.
+//! Together with the parallel initialization of Array1, Array2 and Array3
+//! (see ArrayAllocator), the pages of the grid and the particle arrays then
+//! stay on the NUMA node of the threads that sweep them. The pinning is not
+//! supported on macOS, where only the round-robin dealing applies. Disabling
+//! the pinning lets the calling thread run on any core again. Do not call
+//! this function while any parallel work is in flight.
+//!
+//! \param[in]  isEnabled True to pin the threads.
+//!
+void setIsThreadPinningEnabled(bool isEnabled);
+
+//!
+//! \brief      Returns true if the threads are pinned to the cores.
+//!
+bool isThreadPinningEnabled();
+
+//!
+//! \brief      Enables or disables the deterministic mode.
+//!
+//! In the deterministic mode, the results of the parallel functions are
+//! bit-wise identical regardless of the number of threads, so that the
+//! simulation caches can be compared between the runs. parallelReduce,
+//! parallelMinMax and parallelRadixSort are deterministic in both modes, and
+//! so are all the solver reductions built on them. This mode additionally
+//! makes parallelRangeFor (without a grain size) and the nested loops split
+//! the range into a fixed number of chunks instead of one chunk per thread,
+//! and parallelSort a stable sort with a fixed merge tree. The cost is
+//! measured by the "/deterministic" perf tests (see doc/PERF_TESTS.md). The
+//! mode is off by default. Do not call this function while any parallel work
+//! is in flight.
+//!
+//! \param[in]  isDeterministic True to enable the deterministic mode.
+//!
+void setIsDeterministic(bool isDeterministic);
+
+//!
+//! \brief      Returns true if the deterministic mode is enabled.
+//!
+bool isDeterministic();
+
+//!
+//! \brief      Task schedulers that can run the parallel functions.
+//!
+//! ThreadPool is the built-in work-stealing pool and is always available.
+//! Tbb and OpenMp are available when the library is built with JET_USE_TBB
+//! and JET_USE_OPENMP respectively (scons --tbb and --openmp).
+//!
+enum class ParallelBackend {
+    //! The built-in thread pool.
+    ThreadPool,
+
+    //! Intel Threading Building Blocks.
+    Tbb,
+
+    //! OpenMP.
+    OpenMp
+};
+
+//!
+//! \brief      Selects the task scheduler of the parallel functions.
+//!
+//! All the parallel functions, including parallelInvoke, submit their tasks
+//! to the selected backend. With Tbb, the tasks run in the TBB arena of the
+//! calling thread, so an application that already runs a TBB scheduler
+//! shares its workers with the library, and the nested parallel calls
+//! compose without oversubscribing the machine. If setMaxNumberOfThreads is
+//! called, the tasks instead run in a task arena of the library limited to
+//! that concurrency. With OpenMp, the tasks run in a parallel region, and
+//! the calls from inside a region run serially. The built-in pool does not
+//! start its threads until it is selected and used. The thread pinning only
+//! applies to the built-in pool. The default is Tbb if it is available,
+//! then OpenMp, then ThreadPool. Do not call this function while any
+//! parallel work is in flight.
+//!
+//! \param[in]  backend The backend to use.
+//!
+//! \exception  std::invalid_argument if the backend is not available.
+//!
+void setParallelBackend(ParallelBackend backend);
+
+//!
+//! \brief      Returns the task scheduler of the parallel functions.
+//!
+ParallelBackend parallelBackend();
+
+//!
+//! \brief      Returns true if the library is built with given backend.
+//!
+bool isParallelBackendAvailable(ParallelBackend backend);
+
 }  // namespace jet
 
 #include "detail/parallel-inl.h"
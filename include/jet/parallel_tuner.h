@@ -0,0 +1,172 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PARALLEL_TUNER_H_
+#define INCLUDE_JET_PARALLEL_TUNER_H_
+
+#include <jet/macros.h>
+#include <jet/parallel.h>
+#include <jet/profiler.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jet {
+
+class ParallelRegionState;
+
+//! Tuning state of a named parallel region.
+struct ParallelTuningResult {
+    //! Name of the region.
+    std::string name;
+
+    //! True if the configuration is locked in.
+    bool isTuned = false;
+
+    //! Number of the chunks the range is split into, where one means the
+    //! serial fallback. Zero if not tuned.
+    size_t numberOfChunks = 0;
+
+    //! Measured time per index of the locked-in configuration, or zero if it
+    //! was loaded from a profile.
+    double secondsPerIndex = 0.0;
+};
+
+//!
+//! \brief Autotuner of the partitioning of the named parallel regions.
+//!
+//! The parallel functions use one partitioning policy for every loop, which
+//! suits neither a tiny BLAS sweep, where the scheduling overhead dominates,
+//! nor a heavy particle pass with irregular work. A ParallelRegion instead
+//! picks its own: while the tuner is enabled, the first calls of a region
+//! each try one of the candidate configurations, which are the serial
+//! fallback, a quarter or half of the threads, one chunk per thread, and 4
+//! or 16 chunks per thread. Each candidate runs three times, and the one
+//! with the least time per index is locked in for the later calls. Limiting
+//! the number of chunks below the number of threads limits the threads a
+//! region runs on.
+//!
+//! The results depend on the machine and the number of threads, so they can
+//! be saved to a profile and loaded by the later runs on the same machine,
+//! which then skip the tuning. While the tuner is disabled, which is the
+//! default, and in the deterministic mode, the regions run with the default
+//! policy of the parallel functions.
+//!
+class ParallelTuner {
+ public:
+    //! Returns true if the tuner is enabled.
+    static bool isEnabled();
+
+    //! Enables or disables the tuner.
+    static void setIsEnabled(bool isEnabled);
+
+    //! Returns the tuning states of the regions, sorted by name.
+    static std::vector<ParallelTuningResult> results();
+
+    //! Forgets the tuning results, so the regions are tuned again.
+    static void reset();
+
+    //!
+    //! \brief Writes the locked-in configurations to \p strm.
+    //!
+    //! The profile is a text file that starts with the number of threads it
+    //! was tuned with, followed by a line per tuned region.
+    //!
+    static void saveProfile(std::ostream* strm);
+
+    //!
+    //! \brief Loads the configurations from the profile in \p strm.
+    //!
+    //! The regions in the profile are locked in to the loaded configurations,
+    //! including the ones that are not constructed yet. Returns false if the
+    //! stream is not a profile, or the profile was tuned with a different
+    //! number of threads, in which case nothing is loaded.
+    //!
+    static bool loadProfile(std::istream* strm);
+
+    //! Saves the profile to \p filename. Returns false if the file cannot be
+    //! written.
+    static bool saveProfile(const std::string& filename);
+
+    //! Loads the profile from \p filename. Returns false if the file cannot
+    //! be read or is not a valid profile.
+    static bool loadProfile(const std::string& filename);
+};
+
+//!
+//! \brief Named parallel loop whose partitioning is tuned by ParallelTuner.
+//!
+//! A region is usually a static local at the loop it tunes, and the regions
+//! of the same name share the tuning result. Each call is also timed as a
+//! profiler scope of the region name.
+//!
+//! \code{.cpp}
+//! static ParallelRegion region("SphSystemData3::updateDensities");
+//! region.parallelFor(kZeroSize, n, [&](size_t i) { ... });
+//! \endcode
+//!
+class ParallelRegion final {
+ public:
+    JET_NON_COPYABLE(ParallelRegion)
+
+    //! Constructs a region with \p name, which should outlive the region.
+    explicit ParallelRegion(const char* name);
+
+    //! Destructor.
+    ~ParallelRegion();
+
+    //! Returns the name of the region.
+    const char* name() const;
+
+    //!
+    //! \brief Calls \p function for the chunks of the range.
+    //!
+    //! Without the tuning, the range is split with \p defaultGrainSize.
+    //!
+    template <typename IndexType, typename Function>
+    void parallelRangeFor(
+        IndexType beginIndex,
+        IndexType endIndex,
+        IndexType defaultGrainSize,
+        const Function& function);
+
+    //! Calls \p function for the chunks of the range. Without the tuning, the
+    //! range is split like ::jet::parallelRangeFor does.
+    template <typename IndexType, typename Function>
+    void parallelRangeFor(
+        IndexType beginIndex,
+        IndexType endIndex,
+        const Function& function);
+
+    //! Calls \p function for each index of the range. Without the tuning,
+    //! the range is split like ::jet::parallelFor does.
+    template <typename IndexType, typename Function>
+    void parallelFor(
+        IndexType beginIndex,
+        IndexType endIndex,
+        const Function& function);
+
+ private:
+    const char* _name;
+    std::shared_ptr<ParallelRegionState> _state;
+
+    // Returns the number of the chunks to split n indices into, or zero for
+    // the default policy. trial is set to the index of the measurement to
+    // report to endTrial, or kMaxSize if the call is not measured.
+    size_t beginCall(size_t n, size_t* trial);
+
+    void endTrial(size_t trial, size_t n, double seconds);
+
+    template <typename IndexType, typename Function>
+    void run(
+        IndexType beginIndex,
+        IndexType endIndex,
+        IndexType defaultGrainSize,
+        const Function& function);
+};
+
+}  // namespace jet
+
+#include "detail/parallel_tuner-inl.h"
+
+#endif  // INCLUDE_JET_PARALLEL_TUNER_H_
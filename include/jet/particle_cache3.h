@@ -0,0 +1,184 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PARTICLE_CACHE3_H_
+#define INCLUDE_JET_PARTICLE_CACHE3_H_
+
+#include <jet/array1.h>
+#include <jet/array_accessor1.h>
+#include <jet/bounding_box3.h>
+#include <jet/particle_system_data3.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jet {
+
+class MappedFile;
+
+//!
+//! \brief Writes particle data to a versioned, self-describing cache.
+//!
+//! The cache starts with a header that holds the tag "JETPCACH", the format
+//! version, the number of channels and particles, the radius and mass of the
+//! particles, and the bounding box of the positions. Each channel follows with
+//! its own header (name, type, number of elements, and the offset of the
+//! data), and the data itself starts at a 64-byte aligned offset, so the
+//! reader can map the file and use the data in place. All values are stored
+//! in the byte order of the host.
+//!
+//! The writer does not copy the channels; it keeps the accessors and writes
+//! the data straight from them, so they must stay valid until write is
+//! called.
+//!
+//! With the compression enabled, the positions are quantized to 16-bit
+//! offsets within the buckets of the hash grid, the other vector channels are
+//! stored in half precision, and the scalar channels are kept lossless. The
+//! bytes of each channel are then split into planes and entropy-coded. The
+//! position error is at most half of the bucket spacing divided by 65536,
+//! plus the rounding error. A compressed file needs to be decoded when read
+//! back, so it cannot be used in place.
+//!
+class ParticleCacheWriter3 {
+ public:
+    //! Constructs a writer with the "position", "velocity", and "force"
+    //! channels of \p particles.
+    explicit ParticleCacheWriter3(const ParticleSystemData3& particles);
+
+    //! Adds a scalar channel. The size of \p data should be the number of the
+    //! particles, and \p name should be shorter than 48 characters.
+    void addScalarChannel(
+        const std::string& name,
+        const ConstArrayAccessor1<double>& data);
+
+    //! Adds a vector channel. The size of \p data should be the number of the
+    //! particles, and \p name should be shorter than 48 characters.
+    void addVectorChannel(
+        const std::string& name,
+        const ConstArrayAccessor1<Vector3D>& data);
+
+    //! Returns true if the cache is compressed.
+    bool isUsingCompression() const;
+
+    //! Sets true to compress the cache.
+    void setIsUsingCompression(bool isUsing);
+
+    //!
+    //! \brief Returns the spacing of the buckets for quantizing positions.
+    //!
+    //! The default is the grid spacing of the neighbor searcher of the
+    //! particles if it is PointParallelHashGridSearcher3, twice the cell size
+    //! if it is PointCellListSearcher3, or twice the radius otherwise.
+    //!
+    double bucketSpacing() const;
+
+    //! Sets the spacing of the buckets for quantizing positions.
+    void setBucketSpacing(double spacing);
+
+    //! Writes the cache to \p strm.
+    void write(std::ostream* strm) const;
+
+ private:
+    struct Channel {
+        std::string name;
+        uint32_t type;
+        const char* data;
+        size_t bytes;
+    };
+
+    size_t _numberOfParticles;
+    double _radius;
+    double _mass;
+    BoundingBox3D _boundingBox;
+    bool _isUsingCompression = false;
+    double _bucketSpacing;
+    std::vector<Channel> _channels;
+
+    void addChannel(
+        const std::string& name,
+        uint32_t type,
+        const void* data,
+        size_t bytes);
+};
+
+//!
+//! \brief Reads the particle cache written by ParticleCacheWriter3.
+//!
+//! The file is memory-mapped, and the channels are returned as views into the
+//! mapped file without copying. The compressed channels are decoded in
+//! parallel when the file is opened and returned as views into the decoded
+//! data. The views are valid until the reader is closed or destroyed.
+//!
+class ParticleCacheReader3 {
+ public:
+    JET_NON_COPYABLE(ParticleCacheReader3)
+
+    //! Constructs an empty reader.
+    ParticleCacheReader3();
+
+    //! Destructor.
+    ~ParticleCacheReader3();
+
+    //! Opens the cache at \p filename. Returns false if the file cannot be
+    //! opened or is not a valid cache, in which case the reader is empty.
+    bool open(const std::string& filename);
+
+    //! Closes the file and invalidates the views.
+    void close();
+
+    //! Returns the number of particles.
+    size_t numberOfParticles() const;
+
+    //! Returns the radius of the particles.
+    double radius() const;
+
+    //! Returns the mass of the particles.
+    double mass() const;
+
+    //! Returns the bounding box of the positions.
+    const BoundingBox3D& boundingBox() const;
+
+    //! Returns the number of channels.
+    size_t numberOfChannels() const;
+
+    //! Returns the name of the i-th channel.
+    const std::string& channelName(size_t i) const;
+
+    //! Returns true if the cache has the scalar channel of \p name.
+    bool hasScalarChannel(const std::string& name) const;
+
+    //! Returns true if the cache has the vector channel of \p name.
+    bool hasVectorChannel(const std::string& name) const;
+
+    //! Returns the scalar channel of \p name, or an empty view if not found.
+    ConstArrayAccessor1<double> scalarChannel(const std::string& name) const;
+
+    //! Returns the vector channel of \p name, or an empty view if not found.
+    ConstArrayAccessor1<Vector3D> vectorChannel(const std::string& name) const;
+
+ private:
+    struct Channel {
+        std::string name;
+        uint32_t type;
+        uint32_t encoding;
+        const char* data;
+        size_t bytes;
+        Array1<double> decodedScalars;
+        Array1<Vector3D> decodedVectors;
+    };
+
+    std::unique_ptr<MappedFile> _file;
+    size_t _numberOfParticles = 0;
+    double _radius = 0.0;
+    double _mass = 0.0;
+    BoundingBox3D _boundingBox;
+    std::vector<Channel> _channels;
+
+    const Channel* findChannel(const std::string& name, uint32_t type) const;
+
+    bool decodeChannel(Channel* channel);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_PARTICLE_CACHE3_H_
@@ -28,6 +28,60 @@ class ParticleEmitter3 {
     virtual void emit(
         const Frame& frame,
         const ParticleSystemData3Ptr& particles) = 0;
+
+    //!
+    //! \brief      Generates the particles to emit without adding them.
+    //!
+    //! This function computes the positions and velocities of the particles
+    //! that emit() would add for the frame and stores them to the given
+    //! arrays, which are resized to fit. It updates the state of the emitter
+    //! as emit() does, but it only reads the particle system data, so the
+    //! emitters that share the same particle system data can generate their
+    //! particles concurrently. See ParticleEmitterSet3.
+    //!
+    //! The default implementation runs emit() on a scratch copy of the
+    //! positions and velocities of \p particles and takes the added ones, so
+    //! the subclasses should override this function to avoid the copy.
+    //!
+    //! \param[in]  frame         Current animation frame.
+    //! \param[in]  particles     The particle system data.
+    //! \param[out] newPositions  The positions of the new particles.
+    //! \param[out] newVelocities The velocities of the new particles.
+    //!
+    virtual void generate(
+        const Frame& frame,
+        const ParticleSystemData3Ptr& particles,
+        Array1<Vector3D>* newPositions,
+        Array1<Vector3D>* newVelocities);
+
+    //! Returns the preview scale of the particle spacing.
+    double previewScale() const;
+
+    //!
+    //! \brief Scales the particle spacing by \p factor for a quick preview.
+    //!
+    //! The subclasses scale the spacing they had at the scale of 1 by
+    //! \p factor, and their particle counts and rates by the inverse cube of
+    //! \p factor, so that the emitted volume stays the same with fewer
+    //! particles. Setting the scale back to 1 restores the parameters. The
+    //! factor should match the preview scale of the solver, such as
+    //! GridFluidSolver3::setPreviewScale, and should be equal to or greater
+    //! than 1.
+    //!
+    virtual void setPreviewScale(double factor);
+
+ protected:
+    //!
+    //! \brief Returns \p number scaled for the particle spacing scaled by
+    //! \p factor.
+    //!
+    //! The number is divided by the cube of the factor and rounded, but a
+    //! positive number stays positive and the max value stays unlimited.
+    //!
+    static size_t scaledNumberOfParticles(size_t number, double factor);
+
+ private:
+    double _previewScale = 1.0;
 };
 
 typedef std::shared_ptr<ParticleEmitter3> ParticleEmitter3Ptr;
@@ -0,0 +1,96 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PARTICLE_EMITTER_SET3_H_
+#define INCLUDE_JET_PARTICLE_EMITTER_SET3_H_
+
+#include <jet/particle_emitter3.h>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D particle emitter set.
+//!
+//! This class runs a collection of emitters as a single emitter. The emitters
+//! generate their particles concurrently with ParticleEmitter3::generate into
+//! the buffers kept by the set, and the particle system data is then resized
+//! once and the buffers are copied to the new slots in parallel, in the order
+//! the emitters were added. The buffers are kept between the frames, so they
+//! are not reallocated once they have grown to the largest emission.
+//!
+//! Since all the emitters see the particles of the previous frame, an emitter
+//! does not see the particles emitted by the others in the same frame, which
+//! matters for the emitters that test the overlap with the existing
+//! particles.
+//!
+class ParticleEmitterSet3 final : public ParticleEmitter3 {
+ public:
+    //! Constructs an empty emitter set.
+    ParticleEmitterSet3();
+
+    //! Constructs an emitter set with the given emitters.
+    explicit ParticleEmitterSet3(
+        const std::vector<ParticleEmitter3Ptr>& emitters);
+
+    //! Returns the number of emitters.
+    size_t numberOfEmitters() const;
+
+    //! Returns the i-th emitter.
+    const ParticleEmitter3Ptr& emitterAt(size_t i) const;
+
+    //! Adds an emitter.
+    void addEmitter(const ParticleEmitter3Ptr& emitter);
+
+    //!
+    //! \brief Sets the preview scale of all the emitters.
+    //!
+    //! The emitters added afterwards keep their own scale.
+    //!
+    void setPreviewScale(double factor) override;
+
+    //!
+    //! \brief      Emits particles of all the emitters to the particle system
+    //!             data.
+    //!
+    //! \param[in]  frame     Current animation frame.
+    //! \param[in]  particles The particle system data.
+    //!
+    void emit(
+        const Frame& frame,
+        const ParticleSystemData3Ptr& particles) override;
+
+    //!
+    //! \brief      Generates the particles of all the emitters without adding
+    //!             them.
+    //!
+    //! \param[in]  frame         Current animation frame.
+    //! \param[in]  particles     The particle system data.
+    //! \param[out] newPositions  The positions of the new particles.
+    //! \param[out] newVelocities The velocities of the new particles.
+    //!
+    void generate(
+        const Frame& frame,
+        const ParticleSystemData3Ptr& particles,
+        Array1<Vector3D>* newPositions,
+        Array1<Vector3D>* newVelocities) override;
+
+ private:
+    std::vector<ParticleEmitter3Ptr> _emitters;
+    std::vector<Array1<Vector3D>> _newPositions;
+    std::vector<Array1<Vector3D>> _newVelocities;
+    std::vector<size_t> _offsets;
+
+    size_t generateAll(
+        const Frame& frame,
+        const ParticleSystemData3Ptr& particles);
+
+    void copyAll(
+        ArrayAccessor1<Vector3D> positions,
+        ArrayAccessor1<Vector3D> velocities) const;
+};
+
+typedef std::shared_ptr<ParticleEmitterSet3> ParticleEmitterSet3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_PARTICLE_EMITTER_SET3_H_
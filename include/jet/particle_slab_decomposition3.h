@@ -0,0 +1,112 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PARTICLE_SLAB_DECOMPOSITION3_H_
+#define INCLUDE_JET_PARTICLE_SLAB_DECOMPOSITION3_H_
+
+#include <jet/array1.h>
+#include <jet/communicator.h>
+#include <jet/particle_system_data3.h>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Decomposition of a particle system into slabs along the z-axis.
+//!
+//! Each rank of the communicator owns the particles whose z-coordinate is in
+//! its slab, and stores them in its own ParticleSystemData3. The slabs are
+//! ordered by the ranks and cover the whole z-axis: the first rank also owns
+//! the particles below the domain and the last rank the ones above it.
+//!
+//! Every function of this class is collective, so all the ranks must call it
+//! together. The particle systems of the ranks must have the same number of
+//! custom scalar and vector data layers, which are sent along with the
+//! positions, velocities, and forces.
+//!
+class ParticleSlabDecomposition3 {
+ public:
+    //!
+    //! \brief Constructs the decomposition of the z-range [zMin, zMax].
+    //!
+    //! The range is split evenly over the ranks.
+    //!
+    ParticleSlabDecomposition3(
+        double zMin,
+        double zMax,
+        const CommunicatorPtr& communicator);
+
+    //! Returns the lower z-bound of the slab owned by this rank.
+    double zBegin() const;
+
+    //! Returns the upper z-bound of the slab owned by this rank.
+    double zEnd() const;
+
+    //!
+    //! \brief Returns the bounds of all the slabs.
+    //!
+    //! The slab of rank r is [boundaries[r], boundaries[r + 1]), and the
+    //! array has size() + 1 elements from zMin to zMax.
+    //!
+    ConstArrayAccessor1<double> boundaries() const;
+
+    //! Returns the rank owning the given z-coordinate.
+    int ownerRank(double z) const;
+
+    //! Returns the communicator.
+    const CommunicatorPtr& communicator() const;
+
+    //!
+    //! \brief Moves the particles which left the slab to their owner ranks.
+    //!
+    //! Particles are passed to the neighbor rank in the direction of their
+    //! owner, and the passing repeats until every particle is on its owner,
+    //! so a particle can cross several slabs in one call. The received
+    //! particles are appended to \p particles, which invalidates its neighbor
+    //! searcher and lists.
+    //!
+    //! \param[in,out] particles The particles of this rank.
+    //!
+    void migrateParticles(ParticleSystemData3* particles) const;
+
+    //!
+    //! \brief Gathers the particles of the neighbor ranks near the slab.
+    //!
+    //! The particles of the previous and next ranks within \p radius from the
+    //! bounds of this slab are copied into \p halo with all their data layers.
+    //! Searching the neighbors of the local particles over both the local and
+    //! halo particles then finds the same neighbors as the undistributed
+    //! search. \p radius should not exceed the thickness of the slabs.
+    //!
+    //! \param[in]  particles The particles of this rank.
+    //! \param[in]  radius    The halo radius, usually the kernel radius.
+    //! \param[out] halo      The particles near the slab from the neighbors.
+    //!
+    void exchangeHaloParticles(
+        const ParticleSystemData3& particles,
+        double radius,
+        ParticleSystemData3* halo) const;
+
+    //!
+    //! \brief Moves the slab bounds to balance the number of particles.
+    //!
+    //! The particle counts are gathered in a histogram along z over all the
+    //! ranks, and the bounds are placed at its quantiles, so each rank owns
+    //! about the same number of particles. The particles are not moved, so
+    //! call migrateParticles afterwards.
+    //!
+    //! \param[in] particles The particles of this rank.
+    //!
+    void rebalance(const ParticleSystemData3& particles);
+
+ private:
+    CommunicatorPtr _communicator;
+    Array1<double> _boundaries;
+};
+
+//! Shared pointer for the ParticleSlabDecomposition3 type.
+typedef std::shared_ptr<ParticleSlabDecomposition3>
+    ParticleSlabDecomposition3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_PARTICLE_SLAB_DECOMPOSITION3_H_
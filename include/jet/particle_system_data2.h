@@ -4,6 +4,7 @@
 #define INCLUDE_JET_PARTICLE_SYSTEM_DATA2_H_
 
 #include <jet/array1.h>
+#include <jet/point_neighbor_lists.h>
 #include <jet/point_neighbor_searcher2.h>
 
 #include <memory>
@@ -170,11 +171,12 @@ class ParticleSystemData2 {
     //!
     //! This function returns neighbor lists which is available after calling
     //! PointParallelHashGridSearcher2::buildNeighborLists. Each list stores
-    //! indices of the neighbors.
+    //! indices of the neighbors. The lists are stored in a compressed layout
+    //! and neighborLists()[i] returns a light-weight accessor to the i-th list.
     //!
     //! \return     Neighbor lists.
     //!
-    const std::vector<std::vector<size_t>>& neighborLists() const;
+    const PointNeighborLists& neighborLists() const;
 
     //! Builds neighbor searcher with given search radius.
     void buildNeighborSearcher(double maxSearchRadius);
@@ -182,6 +184,33 @@ class ParticleSystemData2 {
     //! Builds neighbor lists with given search radius.
     void buildNeighborLists(double maxSearchRadius);
 
+    //!
+    //! \brief      Reorders the particles along the Z-order (Morton) curve.
+    //!
+    //! After many time steps, the particle order in memory is unrelated to the
+    //! particle positions, so most neighbor accesses are cache misses. This
+    //! function sorts the particles by the Morton code of their positions so
+    //! that nearby particles are stored close to each other. All the data
+    //! layers including the custom scalar and vector data are permuted
+    //! together. The neighbor searcher and the neighbor lists are kept but
+    //! still refer to the old particle indices, so like after resize, it is
+    //! users responsibility to call ParticleSystemData2::buildNeighborSearcher
+    //! and ParticleSystemData2::buildNeighborLists before using them.
+    //!
+    void sortParticles();
+
+    //!
+    //! \brief      Returns the permutation applied by the last sort.
+    //!
+    //! The i-th element is the index that the particle currently at i had
+    //! before ParticleSystemData2::sortParticles was called. Use it to remap
+    //! any per-particle data stored outside this class. The array is empty if
+    //! the particles were never sorted.
+    //!
+    //! \return     The sorted indices.
+    //!
+    ConstArrayAccessor1<size_t> sortedIndices() const;
+
  private:
     double _radius = 1e-3;
     double _mass = 1e-3;
@@ -193,7 +222,8 @@ class ParticleSystemData2 {
     std::vector<VectorData> _vectorDataList;
 
     PointNeighborSearcher2Ptr _neighborSearcher;
-    std::vector<std::vector<size_t>> _neighborLists;
+    PointNeighborLists _neighborLists;
+    Array1<size_t> _sortedIndices;
 };
 
 typedef std::shared_ptr<ParticleSystemData2> ParticleSystemData2Ptr;
@@ -4,9 +4,15 @@
 #define INCLUDE_JET_PARTICLE_SYSTEM_DATA3_H_
 
 #include <jet/array1.h>
+#include <jet/point_neighbor_lists.h>
 #include <jet/point_neighbor_searcher3.h>
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <iostream>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace jet {
@@ -43,6 +49,10 @@ class ParticleSystemData3 {
     //! responsibility to call ParticleSystemData3::buildNeighborSearcher and
     //! ParticleSystemData3::buildNeighborLists to refresh those data.
     //!
+    //! When the new number exceeds the capacity, the capacity of all the
+    //! data layers at least doubles, so adding particles a few at a time
+    //! reallocates the arrays only a logarithmic number of times.
+    //!
     //! \param[in]  newNumberOfParticles    New number of particles.
     //!
     void resize(size_t newNumberOfParticles);
@@ -50,6 +60,31 @@ class ParticleSystemData3 {
     //! Returns the number of particles.
     size_t numberOfParticles() const;
 
+    //! Returns the number of particles that fit without reallocation.
+    size_t capacity() const;
+
+    //!
+    //! \brief      Returns the estimated memory of the particle system.
+    //!
+    //! This function sums up the reserved memory of all the data layers, the
+    //! neighbor lists, and the sort permutation. The memory of the neighbor
+    //! searcher and of the data layers that are not allocated yet is not
+    //! included.
+    //!
+    //! \return     The memory in bytes.
+    //!
+    size_t memoryInBytes() const;
+
+    //!
+    //! \brief      Reserves the memory of all the data layers.
+    //!
+    //! This function does not change the number of particles. The custom
+    //! data layers that are added later are reserved with the same capacity.
+    //!
+    //! \param[in]  numberOfParticles   The number of particles to reserve.
+    //!
+    void reserve(size_t numberOfParticles);
+
     //!
     //! \brief      Adds a scalar data layer and returns its index.
     //!
@@ -70,6 +105,31 @@ class ParticleSystemData3 {
     //!
     size_t addVectorData(const Vector3D& initialVal = Vector3D());
 
+    //! Returns true if the custom data layers are allocated on first access.
+    bool isUsingLazyAllocation() const;
+
+    //!
+    //! \brief      Sets true to allocate the custom data layers on first
+    //!             access.
+    //!
+    //! When enabled, which is the default, a data layer that is added has no
+    //! storage and only keeps its initial value until scalarDataAt() or
+    //! vectorDataAt() is called for it, and resizing, removing or sorting the
+    //! particles skips it, so the layers that are used later or never do not
+    //! cost memory or time before then. The accessors fill the layer with
+    //! the values it would have had, and they can be called from several
+    //! threads at once. Only the layers added afterwards are affected.
+    //!
+    //! \param[in]  isUsing True to allocate the layers on first access.
+    //!
+    void setIsUsingLazyAllocation(bool isUsing);
+
+    //! Returns the number of the custom scalar data layers.
+    size_t numberOfScalarData() const;
+
+    //! Returns the number of the custom vector data layers.
+    size_t numberOfVectorData() const;
+
     //! Returns the radius of the particles.
     double radius() const;
 
@@ -100,6 +160,21 @@ class ParticleSystemData3 {
     //! Returns the force array (mutable).
     ArrayAccessor1<Vector3D> forces();
 
+    //!
+    //! \brief      Swaps the positions and the velocities with given arrays.
+    //!
+    //! This function exchanges the storage of the position and velocity
+    //! arrays with the given ones, which should have as many elements as the
+    //! particles, so a solver can commit its new state without copying it.
+    //! The accessors to the positions and velocities taken before the swap
+    //! refer to the given arrays afterwards.
+    //!
+    //! \param[in,out] newPositions  The new positions, which receive the old.
+    //! \param[in,out] newVelocities The new velocities, which receive the old.
+    //!
+    void swapPositionsAndVelocities(
+        VectorData* newPositions, VectorData* newVelocities);
+
     //! Returns custom scalar data layer at given index (immutable).
     ConstArrayAccessor1<double> scalarDataAt(size_t idx) const;
 
@@ -151,11 +226,94 @@ class ParticleSystemData3 {
         const ConstArrayAccessor1<Vector3D>& newForces
             = ConstArrayAccessor1<Vector3D>());
 
+    //!
+    //! \brief      Adds particles by moving the given arrays.
+    //!
+    //! This function works like the accessor overload, but if there are no
+    //! particles yet, the arrays are taken over as the positions, velocities
+    //! and forces without copying them. The arrays are left empty.
+    //!
+    //! \param[in]  newPositions  The new positions.
+    //! \param[in]  newVelocities The new velocities.
+    //! \param[in]  newForces     The new forces.
+    //!
+    void addParticles(
+        Array1<Vector3D>&& newPositions,
+        Array1<Vector3D>&& newVelocities = Array1<Vector3D>(),
+        Array1<Vector3D>&& newForces = Array1<Vector3D>());
+
+    //!
+    //! \brief      Removes the particles that the predicate returns true for.
+    //!
+    //! The remaining particles are compacted in place, keeping their order,
+    //! and all the data layers including the custom ones are compacted
+    //! together. The predicate is called in parallel with the index of each
+    //! particle. The capacity does not change, so removing and adding the
+    //! particles every frame does not reallocate the arrays. Like resize,
+    //! this will invalidate neighbor searcher and neighbor lists.
+    //!
+    //! \param[in]  shouldRemove    The predicate of the particle index.
+    //!
+    //! \return     The number of removed particles.
+    //!
+    size_t removeParticles(const std::function<bool(size_t)>& shouldRemove);
+
+    //!
+    //! \brief      Starts appending particles from multiple threads.
+    //!
+    //! This function grows all the data layers by \p maxNumberOfNewParticles
+    //! slots that are initialized like resize does. Until endAppend() is
+    //! called, worker threads claim the slots with claimAppendSlots() and
+    //! write all the data layers of the claimed slots in place through the
+    //! accessors, which can be taken before the workers start since the
+    //! arrays are not reallocated. numberOfParticles() includes all the
+    //! slots during the append. Like resize, this will invalidate neighbor
+    //! searcher and neighbor lists.
+    //!
+    //! This is a primitive for user code only; no solver in the library uses
+    //! it. AdaptiveParticleResolution3::split and
+    //! PicSolver3::reseedParticles need the new particles in a deterministic
+    //! order, which the claims do not give, so they count the new particles
+    //! first and write them at the prefix sums of the counts instead.
+    //!
+    //! \param[in]  maxNumberOfNewParticles The max number of new particles.
+    //!
+    void beginAppend(size_t maxNumberOfNewParticles);
+
+    //!
+    //! \brief      Claims the slots of new particles; thread-safe.
+    //!
+    //! This function claims up to \p count consecutive slots of the ones
+    //! reserved by beginAppend() with an atomic counter, without locking.
+    //! Fewer slots are claimed if not enough of them are left. The order of
+    //! the claims depends on the thread scheduling, even in the deterministic
+    //! mode (see setIsDeterministic), so the passes whose particle order
+    //! matters should place the particles at prefix sums of their counts.
+    //!
+    //! \param[in]  count       The number of slots to claim.
+    //! \param[out] firstIndex  The particle index of the first claimed slot.
+    //!
+    //! \return     The number of claimed slots, which can be zero.
+    //!
+    size_t claimAppendSlots(size_t count, size_t* firstIndex);
+
+    //!
+    //! \brief      Finishes the append and publishes the claimed particles.
+    //!
+    //! The slots that were not claimed are dropped, so the number of
+    //! particles becomes the one before beginAppend() plus the number of
+    //! claimed slots. The claimed slots are kept in the order of the claims.
+    //!
+    //! \return     The number of added particles.
+    //!
+    size_t endAppend();
+
     //!
     //! \brief      Returns neighbor searcher.
     //!
     //! This function returns currently set neighbor searcher object. By
-    //! default, PointParallelHashGridSearcher3 is used.
+    //! default, buildNeighborSearcher picks PointCellListSearcher3 or
+    //! PointParallelHashGridSearcher3.
     //!
     //! \return     Current neighbor searcher.
     //!
@@ -170,18 +328,102 @@ class ParticleSystemData3 {
     //!
     //! This function returns neighbor lists which is available after calling
     //! PointParallelHashGridSearcher3::buildNeighborLists. Each list stores
-    //! indices of the neighbors.
+    //! indices of the neighbors. The lists are stored in a compressed layout
+    //! and neighborLists()[i] returns a light-weight accessor to the i-th list.
     //!
     //! \return     Neighbor lists.
     //!
-    const std::vector<std::vector<size_t>>& neighborLists() const;
+    const PointNeighborLists& neighborLists() const;
 
-    //! Builds neighbor searcher with given search radius.
+    //!
+    //! \brief      Builds neighbor searcher with given search radius.
+    //!
+    //! The default searcher is a PointCellListSearcher3 with cells of the
+    //! search radius if its dense grid over the bounds of the particles has
+    //! at most eight cells per particle. Otherwise, the particles are too
+    //! sparse, and it is a PointParallelHashGridSearcher3 whose hash table is
+    //! sized from the bounds by suggestedHashGridResolution3. Either searcher
+    //! is updated in place while its cell size or resolution stays the same.
+    //!
+    //! \param[in]  maxSearchRadius The max search radius.
+    //!
     void buildNeighborSearcher(double maxSearchRadius);
 
     //! Builds neighbor lists with given search radius.
     void buildNeighborLists(double maxSearchRadius);
 
+    //! Returns the skin distance of the neighbor search.
+    double neighborSearchSkin() const;
+
+    //!
+    //! \brief      Sets the skin distance of the neighbor search.
+    //!
+    //! With a positive skin, the neighbor searcher and the neighbor lists are
+    //! built with the search radius extended by the skin, like Verlet lists.
+    //! Until a particle moves more than half of the skin from where it was at
+    //! the last rebuild, buildNeighborSearcher only refreshes the positions
+    //! in the searcher and buildNeighborLists keeps the current lists. Hence
+    //! the lists can have neighbors up to the search radius plus twice the
+    //! skin away, and they should be rebuilt right after the searcher. The
+    //! default is 0, which rebuilds both every time.
+    //!
+    //! \param[in]  skin The skin distance.
+    //!
+    void setNeighborSearchSkin(double skin);
+
+    //!
+    //! \brief      Reorders the particles along the Z-order (Morton) curve.
+    //!
+    //! After many time steps, the particle order in memory is unrelated to the
+    //! particle positions, so most neighbor accesses are cache misses. This
+    //! function sorts the particles by the Morton code of their positions so
+    //! that nearby particles are stored close to each other. All the data
+    //! layers including the custom scalar and vector data are permuted
+    //! together. The neighbor searcher and the neighbor lists are kept but
+    //! still refer to the old particle indices, so like after resize, it is
+    //! users responsibility to call ParticleSystemData3::buildNeighborSearcher
+    //! and ParticleSystemData3::buildNeighborLists before using them. The next
+    //! buildNeighborSearcher rebuilds the searcher even within the skin.
+    //!
+    void sortParticles();
+
+    //!
+    //! \brief      Returns the permutation applied by the last sort.
+    //!
+    //! The i-th element is the index that the particle currently at i had
+    //! before ParticleSystemData3::sortParticles was called. Use it to remap
+    //! any per-particle data stored outside this class. The array is empty if
+    //! the particles were never sorted.
+    //!
+    //! \return     The sorted indices.
+    //!
+    ConstArrayAccessor1<size_t> sortedIndices() const;
+
+    //!
+    //! \brief      Serializes the particle system to \p strm.
+    //!
+    //! This function writes the radius, mass, all the data layers, the last
+    //! sort permutation, and the neighbor searcher settings. The neighbor
+    //! lists are not written since they are rebuilt every time step.
+    //!
+    //! \param[in]  strm The output stream.
+    //!
+    virtual void serialize(std::ostream* strm) const;
+
+    //!
+    //! \brief      Deserializes the particle system from \p strm.
+    //!
+    //! This function replaces the data layers with the ones in the stream, so
+    //! the custom data ids stay valid when the data was added in the same
+    //! order. If the stream has a PointParallelHashGridSearcher3, it is
+    //! created with the same settings and built with the restored positions.
+    //! The neighbor lists should be rebuilt before being used. Throws
+    //! std::invalid_argument if the stream is not a valid particle system.
+    //!
+    //! \param[in]  strm The input stream.
+    //!
+    virtual void deserialize(std::istream* strm);
+
  private:
     double _radius = 1e-3;
     double _mass = 1e-3;
@@ -189,11 +431,35 @@ class ParticleSystemData3 {
     VectorData _velocities;
     VectorData _forces;
 
-    std::vector<ScalarData> _scalarDataList;
-    std::vector<VectorData> _vectorDataList;
+    mutable std::vector<ScalarData> _scalarDataList;
+    mutable std::vector<VectorData> _vectorDataList;
+
+    // Layers that are not allocated yet, whose elements all equal the value
+    bool _isUsingLazyAllocation = true;
+    std::vector<double> _scalarDataValues;
+    std::vector<Vector3D> _vectorDataValues;
+    mutable std::deque<std::atomic<bool>> _isScalarDataPending;
+    mutable std::deque<std::atomic<bool>> _isVectorDataPending;
+    mutable std::mutex _pendingDataMutex;
 
     PointNeighborSearcher3Ptr _neighborSearcher;
-    std::vector<std::vector<size_t>> _neighborLists;
+    PointNeighborLists _neighborLists;
+    Array1<size_t> _sortedIndices;
+
+    double _neighborSearchSkin = 0.0;
+    VectorData _neighborSearchPositions;
+    size_t _appendBegin = 0;
+    size_t _appendEnd = 0;
+    std::atomic<size_t> _appendCount{0};
+    size_t _neighborSearcherRevision = 1;
+    size_t _neighborListsRevision = 0;
+    double _neighborListsRadius = 0.0;
+
+    void allocateScalarData(size_t idx) const;
+
+    void allocateVectorData(size_t idx) const;
+
+    void allocatePendingData() const;
 };
 
 typedef std::shared_ptr<ParticleSystemData3> ParticleSystemData3Ptr;
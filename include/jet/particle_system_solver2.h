@@ -39,6 +39,12 @@ class ParticleSystemSolver2 : public PhysicsAnimation {
 
     void setWind(const VectorField2Ptr& newWind);
 
+    unsigned int particleSortingInterval() const;
+
+    //! Sets how often (in time steps) the particles are sorted in memory by
+    //! their positions. Zero, which is the default, disables the sorting.
+    void setParticleSortingInterval(unsigned int newInterval);
+
  protected:
     void onAdvanceTimeStep(double timeStepInSeconds) override;
 
@@ -66,6 +72,8 @@ class ParticleSystemSolver2 : public PhysicsAnimation {
     ParticleSystemData2::VectorData _newVelocities;
     Collider2Ptr _collider;
     VectorField2Ptr _wind;
+    unsigned int _particleSortingInterval = 0;
+    unsigned int _numberOfStepsSinceLastSort = 0;
 
     void beginAdvanceTimeStep(double timeStepInSeconds);
 
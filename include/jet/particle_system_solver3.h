@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_PARTICLE_SYSTEM_SOLVER3_H_
 #define INCLUDE_JET_PARTICLE_SYSTEM_SOLVER3_H_
 
+#include <jet/array1.h>
 #include <jet/collider3.h>
 #include <jet/constants.h>
 #include <jet/vector_field3.h>
@@ -13,6 +14,18 @@ namespace jet {
 
 class ParticleSystemSolver3 : public PhysicsAnimation {
  public:
+    //! Time integration schemes of the particles.
+    enum class TimeIntegrator {
+        //! Semi-implicit (symplectic) Euler, which moves the particles with
+        //! the new velocities.
+        SemiImplicitEuler,
+
+        //! Second-order leapfrog in the drift-kick-drift form. The particles
+        //! drift for the first half of the step before the forces are
+        //! computed, and for the second half with the new velocities.
+        Leapfrog
+    };
+
     ParticleSystemSolver3();
 
     virtual ~ParticleSystemSolver3();
@@ -39,11 +52,74 @@ class ParticleSystemSolver3 : public PhysicsAnimation {
 
     void setWind(const VectorField3Ptr& newWind);
 
+    unsigned int particleSortingInterval() const;
+
+    //! Sets how often (in time steps) the particles are sorted in memory by
+    //! their positions. Zero, which is the default, disables the sorting.
+    void setParticleSortingInterval(unsigned int newInterval);
+
+    double sleepingSpeedThreshold() const;
+
+    //! Sets the speed below which the particles fall asleep. A particle whose
+    //! speed and change of velocity both stay below the threshold for
+    //! numberOfStepsToSleep() consecutive sub-steps falls asleep, and is
+    //! skipped by the external forces, the time integration, and the
+    //! collision until it wakes up. A sleeping particle next to an awake one
+    //! in the neighbor lists wakes up. Zero, which is the default, keeps all
+    //! the particles awake.
+    void setSleepingSpeedThreshold(double newThreshold);
+
+    unsigned int numberOfStepsToSleep() const;
+
+    //! Sets how many quiet sub-steps a particle needs to fall asleep. The
+    //! default is 10.
+    void setNumberOfStepsToSleep(unsigned int newNumberOfSteps);
+
+    //! Returns the number of awake particles in the last sub-step.
+    size_t numberOfActiveParticles() const;
+
+    //! Returns true if the fused sub-step is used.
+    bool isUsingFusedStep() const;
+
+    //! Enables or disables the fused sub-step. The time integration and the
+    //! collision then run in a single pass over the particles, and the new
+    //! positions and velocities are swapped into the particle system data
+    //! instead of copied, so the accessors of the positions and velocities
+    //! should not be kept over the sub-steps. If the solver has no forces
+    //! other than the gravity and the wind (see hasCustomForces), the forces
+    //! are also computed in the same pass without being stored in forces().
+    //! The sleeping particles need the separate passes, so the fused sub-step
+    //! is only used while the sleeping speed threshold is zero. The default
+    //! is false.
+    void setIsUsingFusedStep(bool isUsing);
+
+    //! Returns the time integration scheme.
+    TimeIntegrator timeIntegrator() const;
+
+    //! Sets the time integration scheme. The leapfrog integrator is second
+    //! order, and stays so when the time-step changes between the sub-steps,
+    //! which the semi-implicit Euler does not. Each step is self-contained,
+    //! so no state is kept across the steps. The sleeping particles need the
+    //! same scheme for every particle of a step, so the leapfrog integrator
+    //! is only used while the sleeping speed threshold is zero. The default
+    //! is TimeIntegrator::SemiImplicitEuler.
+    void setTimeIntegrator(TimeIntegrator integrator);
+
+    void serialize(std::ostream* strm) const override;
+
+    void deserialize(std::istream* strm) override;
+
  protected:
     void onAdvanceTimeStep(double timeStepInSeconds) override;
 
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
     virtual void accumulateForces(double timeStepInSeconds);
 
+    //! Returns true if accumulateForces adds forces other than the gravity
+    //! and the wind, which should be overridden with accumulateForces.
+    virtual bool hasCustomForces() const;
+
     virtual void onBeginAdvanceTimeStep(double timeStepInSeconds);
 
     virtual void onEndAdvanceTimeStep(double timeStepInSeconds);
@@ -56,6 +132,12 @@ class ParticleSystemSolver3 : public PhysicsAnimation {
 
     void setParticleSystemData(const ParticleSystemData3Ptr& newParticles);
 
+    //! Returns the fraction of the time-step for which the time integration
+    //! moves the particles with the new velocities. It is 0.5 with the
+    //! leapfrog integrator and 1.0 otherwise, and the solvers that predict
+    //! the positions of the next step should move them by this fraction.
+    double positionUpdateFraction() const;
+
  private:
     double _dragCoefficient = 1e-4;
     double _restitutionCoefficient = 0.0;
@@ -66,6 +148,15 @@ class ParticleSystemSolver3 : public PhysicsAnimation {
     ParticleSystemData3::VectorData _newVelocities;
     Collider3Ptr _collider;
     VectorField3Ptr _wind;
+    unsigned int _particleSortingInterval = 0;
+    unsigned int _numberOfStepsSinceLastSort = 0;
+    double _sleepingSpeedThreshold = 0.0;
+    unsigned int _numberOfStepsToSleep = 10;
+    Array1<uint32_t> _quietStepCounts;
+    Array1<size_t> _activeIndices;
+    bool _isAllActive = true;
+    bool _isUsingFusedStep = false;
+    TimeIntegrator _timeIntegrator = TimeIntegrator::SemiImplicitEuler;
 
     void beginAdvanceTimeStep(double timeStepInSeconds);
 
@@ -74,6 +165,20 @@ class ParticleSystemSolver3 : public PhysicsAnimation {
     void accumulateExternalForces();
 
     void timeIntegration(double timeStepInSeconds);
+
+    bool isUsingFusedPasses() const;
+
+    bool isUsingLeapfrog() const;
+
+    void fusedTimeIntegration(double timeStepInSeconds);
+
+    void updateActiveParticles(bool isReordered);
+
+    template <typename Callback>
+    void parallelForEachActiveParticle(const Callback& callback) const;
+
+    template <typename Callback>
+    void forEachExternalForce(const Callback& callback) const;
 };
 
 }  // namespace jet
@@ -0,0 +1,135 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PARTICLES_TO_SDF3_H_
+#define INCLUDE_JET_PARTICLES_TO_SDF3_H_
+
+#include <jet/array_accessor1.h>
+#include <jet/scalar_grid3.h>
+#include <jet/vector3.h>
+
+namespace jet {
+
+//!
+//! \brief 3-D particles to signed-distance field converter.
+//!
+//! This class converts a set of particles into an implicit surface field
+//! which is negative inside the fluid. Each particle is splatted with an
+//! anisotropic kernel whose axes follow the principal components of its
+//! weighted neighborhood, so the particles near a flat surface become
+//! flattened disks and the surface looks smooth at a coarser grid resolution
+//! than the isotropic SPH interpolation. The particle centers are also
+//! pulled toward the weighted mean of their neighbors to reduce the bumps.
+//!
+//! The grid is split into tiles and only the tiles that are covered by the
+//! footprint of any particle are evaluated. The other nodes are filled with
+//! the cut-off density directly.
+//!
+//! With the anisotropic kernels disabled, the field is the cut-off density
+//! minus the SPH interpolation of a constant one (see
+//! SphSystemData3::interpolate). It is computed by scattering each particle
+//! into the nodes of its footprint instead of searching the neighbors of each
+//! node, which is much faster for fine grids.
+//!
+//! \see Yu and Turk, Reconstructing surfaces of particle-based fluids using
+//!      anisotropic kernels, ACM Transactions on Graphics 32.1 (2013): 5.
+//!
+class ParticlesToSdf3 {
+ public:
+    //!
+    //! Constructs the converter with given kernel radius and cut-off density.
+    //!
+    //! \param[in]  kernelRadius   The radius of the isotropic kernel.
+    //! \param[in]  cutOffDensity  The iso-value of the normalized density.
+    //!
+    explicit ParticlesToSdf3(
+        double kernelRadius = 1.0, double cutOffDensity = 0.5);
+
+    //! Returns the kernel radius.
+    double kernelRadius() const;
+
+    //! Sets the kernel radius, which should be positive.
+    void setKernelRadius(double kernelRadius);
+
+    //! Returns the cut-off density.
+    double cutOffDensity() const;
+
+    //!
+    //! \brief Sets the cut-off density.
+    //!
+    //! The output field is the cut-off density minus the normalized density,
+    //! which is about 1 inside the fluid. Default is 0.5.
+    //!
+    void setCutOffDensity(double cutOffDensity);
+
+    //! Returns true if the anisotropic kernels are used.
+    bool isUsingAnisotropicKernels() const;
+
+    //!
+    //! \brief Enables or disables the anisotropic kernels.
+    //!
+    //! If disabled, each particle is splatted with the isotropic kernel at
+    //! its own position, which gives the same field as the SPH interpolation
+    //! of a constant one. Default is true.
+    //!
+    void setIsUsingAnisotropicKernels(bool isUsing);
+
+    //! Returns the min number of neighbors for the anisotropic kernel.
+    size_t minNumberOfNeighbors() const;
+
+    //!
+    //! \brief Sets the min number of neighbors for the anisotropic kernel.
+    //!
+    //! A particle with fewer neighbors than this number is splatted with the
+    //! isotropic kernel since its covariance is not reliable. The neighbors
+    //! are counted within the kernel radius. Default is 15, which makes the
+    //! particles on a flat face of a block with kernel radius of twice the
+    //! spacing anisotropic, but not the ones on the edges.
+    //!
+    void setMinNumberOfNeighbors(size_t n);
+
+    //! Returns the max ratio between the longest and the shortest kernel axes.
+    double maxAnisotropyRatio() const;
+
+    //!
+    //! \brief Sets the max ratio between the longest and the shortest axes.
+    //!
+    //! This function sets the max ratio between the longest and the shortest
+    //! axes of a kernel which prevents the kernels from collapsing into
+    //! planes. The input value is clamped to 1 or bigger. Default is 4.
+    //!
+    void setMaxAnisotropyRatio(double ratio);
+
+    //! Returns the position smoothing factor.
+    double positionSmoothingFactor() const;
+
+    //!
+    //! \brief Sets the position smoothing factor.
+    //!
+    //! This function sets the blend factor between the particle position and
+    //! the weighted mean of the neighbors which is used as the kernel center.
+    //! Zero disables the smoothing. The input value is clamped to [0, 1].
+    //! Default is 0.9.
+    //!
+    void setPositionSmoothingFactor(double factor);
+
+    //!
+    //! \brief Converts the particles into the implicit surface field.
+    //!
+    //! \param[in]  points  The particle positions.
+    //! \param      sdf     The output field, evaluated at its data points.
+    //!
+    void convert(
+        const ConstArrayAccessor1<Vector3D>& points, ScalarGrid3* sdf) const;
+
+ private:
+    double _kernelRadius;
+    double _cutOffDensity;
+    bool _isUsingAnisotropicKernels = true;
+    size_t _minNumberOfNeighbors = 15;
+    double _maxAnisotropyRatio = 4.0;
+    double _positionSmoothingFactor = 0.9;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_PARTICLES_TO_SDF3_H_
@@ -4,6 +4,7 @@
 #define INCLUDE_JET_PCI_SPH_SOLVER3_H_
 
 #include <jet/sph_solver3.h>
+#include <vector>
 
 namespace jet {
 
@@ -18,6 +19,20 @@ namespace jet {
 //!
 class PciSphSolver3 : public SphSolver3 {
  public:
+    //! Initial guesses of the pressures of the PCISPH iteration.
+    enum class PressureWarmStart {
+        //! Each time-step starts from zero pressures.
+        None,
+
+        //! Each time-step starts from the pressures of the previous one.
+        Previous,
+
+        //! Each time-step starts from the pressures linearly extrapolated
+        //! from the previous two, which takes an extra scalar data layer of
+        //! the particles.
+        Extrapolated
+    };
+
     //! Constructs a solver with empty particle set.
     PciSphSolver3();
 
@@ -44,6 +59,57 @@ class PciSphSolver3 : public SphSolver3 {
     //!
     void setMaxNumberOfIterations(unsigned int n);
 
+    //! Returns the initial guess of the pressures.
+    PressureWarmStart pressureWarmStart() const;
+
+    //!
+    //! \brief Sets the initial guess of the pressures.
+    //!
+    //! Without warm start, which is the default, the iteration builds the
+    //! pressures from zero at every time-step, while the pressures of a fluid
+    //! near rest barely change between the steps. Starting from the previous
+    //! ones, the first prediction already includes most of the pressure
+    //! force, so the iteration converges in fewer and more uniform steps.
+    //! The pressures move with the particles when they are sorted, and the
+    //! new particles start from zero.
+    //!
+    void setPressureWarmStart(PressureWarmStart warmStart);
+
+    //! Returns true if the later iterations only update an active set.
+    bool isUsingActiveSet() const;
+
+    //!
+    //! \brief Sets true to only update an active set in the later iterations.
+    //!
+    //! Each iteration recomputes the predicted positions, the densities and
+    //! the pressures of all particles, while most of them are already below
+    //! the max density error ratio after the first few. When enabled, only
+    //! the particles above the ratio and their neighbors stay in the active
+    //! set of the next iteration, whose compacted index list is updated with
+    //! the full neighbor lists, and the other particles keep their last
+    //! prediction. The first iteration still updates all particles, and the
+    //! pressure force of all particles is computed once more at the end, so
+    //! the late iterations only touch the particles around the remaining
+    //! errors. Disabled by default.
+    //!
+    void setIsUsingActiveSet(bool isUsing);
+
+    //! Returns the number of the particle updates of the last time-step,
+    //! summed over the iterations.
+    size_t lastNumberOfParticleUpdates() const;
+
+    //! Returns the number of iterations of the last time-step.
+    unsigned int lastNumberOfIterations() const;
+
+    //! Returns the max density error ratio of the last time-step.
+    double lastDensityErrorRatio() const;
+
+    //! Writes a checkpoint of the PCISPH parameters and particles to \p strm.
+    void serialize(std::ostream* strm) const override;
+
+    //! Restores the PCISPH parameters and particles from \p strm.
+    void deserialize(std::istream* strm) override;
+
  protected:
     //! Accumulates the pressure force to the forces array in the particle
     //! system.
@@ -52,16 +118,49 @@ class PciSphSolver3 : public SphSolver3 {
     //! Performs pre-processing step before the simulation.
     void onBeginAdvanceTimeStep(double timeStepInSeconds) override;
 
+    //! Adds the pressure iterations and the density error ratio to the
+    //! particle statistics.
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
  private:
     double _maxDensityErrorRatio = 0.01;
     unsigned int _maxNumberOfIterations = 5;
+    unsigned int _lastNumberOfIterations = 0;
+    double _lastDensityErrorRatio = 0.0;
+    PressureWarmStart _pressureWarmStart = PressureWarmStart::None;
+    bool _isUsingActiveSet = false;
+    size_t _lastNumberOfParticleUpdates = 0;
+
+    // Scalar data layer of the particles with the pressures of the time-step
+    // before the last one, which is added for the extrapolation
+    size_t _previousPressureDataId = kMaxSize;
 
     ParticleSystemData3::VectorData _tempPositions;
     ParticleSystemData3::VectorData _tempVelocities;
     ParticleSystemData3::VectorData _pressureForces;
     ParticleSystemData3::ScalarData _densityErrors;
+    ParticleSystemData3::ScalarData _weightSums;
+
+    // Compacted indices of the active set, and whether each particle is in
+    // the set being built, which is all zero between the builds
+    std::vector<size_t> _activeSet;
+    std::vector<size_t> _nextActiveSet;
+    std::vector<char> _isInNextActiveSet;
+
+    // Kernel gradient sum of the BCC lattice, which only depends on the
+    // kernel radius and the target spacing
+    double _deltaDenominator = 0.0;
+    double _deltaDenominatorSpacing = 0.0;
+    double _deltaDenominatorKernelRadius = 0.0;
+
+    void buildNextActiveSet(bool isFullIteration, double maxDensityError);
+
+    void computeActivePressureForces(
+        const ConstArrayAccessor1<double>& densities,
+        const ConstArrayAccessor1<double>& pressures);
 
     double computeDelta(double timeStepInSeconds);
+    double computeDeltaDenominator();
     double computeBeta(double timeStepInSeconds);
 };
 
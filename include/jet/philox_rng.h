@@ -0,0 +1,50 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PHILOX_RNG_H_
+#define INCLUDE_JET_PHILOX_RNG_H_
+
+#include <array>
+#include <cstdint>
+
+namespace jet {
+
+//!
+//! \brief Counter-based random number generator of Philox4x32-10.
+//!
+//! Unlike std::mt19937, this generator has no state to advance. It maps a
+//! 128-bit counter to four random 32-bit words with ten rounds of multiply
+//! and xor keyed by the seed, as described in Salmon et al., "Parallel random
+//! numbers: as easy as 1, 2, 3" (SC 2011). Any thread can draw the numbers of
+//! any counter, such as the index of a particle, so a parallel loop gets the
+//! same numbers no matter how the work is split. The counter is given as the
+//! 64-bit \p counter and the 64-bit \p stream, which tells apart the
+//! independent uses of the same counter.
+//!
+class PhiloxRng final {
+ public:
+    //! Four random words of a counter.
+    typedef std::array<uint32_t, 4> Block;
+
+    //! Constructs a generator keyed by \p seed.
+    explicit PhiloxRng(uint64_t seed = 0);
+
+    //! Returns the seed.
+    uint64_t seed() const;
+
+    //! Returns the four random words of the counter.
+    Block operator()(uint64_t counter, uint64_t stream = 0) const;
+
+    //! Returns two uniform random numbers in [0, 1) of the counter, each of
+    //! which has 53 random bits.
+    std::array<double, 2> uniform2(
+        uint64_t counter, uint64_t stream = 0) const;
+
+ private:
+    uint64_t _seed;
+};
+
+}  // namespace jet
+
+#include "detail/philox_rng-inl.h"
+
+#endif  // INCLUDE_JET_PHILOX_RNG_H_
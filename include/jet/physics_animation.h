@@ -4,11 +4,67 @@
 #define INCLUDE_JET_PHYSICS_ANIMATION_H_
 
 #include <jet/animation.h>
+#include <functional>
+#include <iostream>
+#include <vector>
 
 namespace jet {
 
+//!
+//! \brief Statistics of a single sub-time-step of a physics animation.
+//!
+//! The time interval and the duration are filled in by PhysicsAnimation, and
+//! the rest by the solvers that have them. The fields a solver does not have
+//! stay zero.
+//!
+struct SubTimeStepStatistics {
+    //! Time interval of the sub-time-step.
+    double timeIntervalInSeconds = 0.0;
+
+    //! Wall-clock time the sub-time-step took.
+    double durationInSeconds = 0.0;
+
+    //! CFL number of the velocity at the end of the sub-time-step.
+    double cfl = 0.0;
+
+    //! Number of iterations of the pressure solve.
+    unsigned int numberOfPressureIterations = 0;
+
+    //! Residual of the pressure solve. For the SPH solvers, this is the
+    //! density error ratio after the pressure iterations.
+    double pressureResidual = 0.0;
+
+    //! Number of particles.
+    size_t numberOfParticles = 0;
+
+    //! Total length of the neighbor lists of the particles.
+    size_t numberOfNeighbors = 0;
+
+    //! Estimated memory of the simulation data.
+    size_t memoryInBytes = 0;
+
+    //! High-water mark of the memory tracked by MemoryTracker during the
+    //! sub-time-step.
+    size_t peakTrackedMemoryInBytes = 0;
+};
+
+//! Statistics of a frame of a physics animation.
+struct FrameStatistics {
+    //! Index of the frame.
+    unsigned int frameIndex = 0;
+
+    //! Wall-clock time the frame took.
+    double durationInSeconds = 0.0;
+
+    //! Statistics of the sub-time-steps of the frame.
+    std::vector<SubTimeStepStatistics> subTimeSteps;
+};
+
 class PhysicsAnimation : public Animation {
  public:
+    //! Function called at the end of each advanced frame.
+    typedef std::function<void(const Frame&)> FrameCallback;
+
     PhysicsAnimation();
 
     virtual ~PhysicsAnimation();
@@ -21,16 +77,64 @@ class PhysicsAnimation : public Animation {
 
     void setNumberOfFixedSubTimeSteps(unsigned int numberOfSteps);
 
+    //! Returns the last frame the animation was updated to.
+    const Frame& currentFrame() const;
+
+    //! Returns the statistics of the last advanced frame.
+    const FrameStatistics& lastFrameStatistics() const;
+
+    //!
+    //! \brief Sets the function called at the end of each advanced frame.
+    //!
+    //! The callback is called with the frame that was just advanced, once
+    //! per frame even when a single update advances multiple frames, after
+    //! currentFrame() and lastFrameStatistics() are updated. It is the place
+    //! to export the frame: the callback can snapshot the simulation data and
+    //! queue the meshing and the writing of the snapshot to AsyncFileWriter,
+    //! so that they run while the next frames are simulated. Pass an empty
+    //! function to remove the callback.
+    //!
+    void setFrameCallback(const FrameCallback& callback);
+
+    //!
+    //! \brief Writes a checkpoint of the animation state to \p strm.
+    //!
+    //! The checkpoint holds the current frame, the time-stepping settings,
+    //! and what the subclasses add, which is the simulation data and the
+    //! scalar parameters. The sub-solvers, colliders, and emitters are not
+    //! included, so a checkpoint is restored to an animation set up the same
+    //! way as the one that wrote it.
+    //!
+    virtual void serialize(std::ostream* strm) const;
+
+    //!
+    //! \brief Restores the animation state from the checkpoint in \p strm.
+    //!
+    //! Throws std::invalid_argument if the stream does not hold a valid
+    //! checkpoint of the same kind of animation.
+    //!
+    virtual void deserialize(std::istream* strm);
+
  protected:
     virtual void onAdvanceTimeStep(double timeIntervalInSeconds) = 0;
 
     virtual unsigned int numberOfSubTimeSteps(
         double timeIntervalInSeconds) const;
 
+    //! Called after all the sub-time-steps of a frame with the time interval
+    //! of the frame. Does nothing by default.
+    virtual void onEndAdvanceFrame(double timeIntervalInSeconds);
+
+    //! Called after each sub-time-step to fill in the solver-specific fields
+    //! of \p stats. Does nothing by default.
+    virtual void collectStatistics(SubTimeStepStatistics* stats) const;
+
  private:
     Frame _currentFrame;
+    FrameStatistics _lastFrameStatistics;
     bool _isUsingFixedSubTimeSteps = true;
     unsigned int _numberOfFixedSubTimeSteps = 1;
+    FrameCallback _frameCallback;
 
     void onUpdate(const Frame& frame) final;
 
@@ -0,0 +1,60 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PHYSICS_ANIMATION_ENSEMBLE_H_
+#define INCLUDE_JET_PHYSICS_ANIMATION_ENSEMBLE_H_
+
+#include <jet/physics_animation.h>
+#include <memory>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Runs many independent physics animations concurrently.
+//!
+//! Small simulations, such as the ones of a parameter sweep, do not have
+//! enough work per parallel call to pay for the fan-out to the threads, and
+//! one of them cannot fill a machine. This class instead runs each of its
+//! animations as a single task on the thread pool, inside a
+//! SerialExecutionScope, so the animations advance side by side, each on
+//! one thread, and the throughput scales with the number of cores. The
+//! results are the same as when the animations run one after another.
+//!
+//! The animations must not share mutable state. They can share colliders,
+//! whose surfaces are only queried during the update, as long as the
+//! colliders are not modified while the ensemble runs.
+//!
+class PhysicsAnimationEnsemble final {
+ public:
+    //! Constructs an empty ensemble.
+    PhysicsAnimationEnsemble();
+
+    //! Adds \p animation to the ensemble.
+    void addAnimation(const PhysicsAnimationPtr& animation);
+
+    //! Returns the number of the animations.
+    size_t numberOfAnimations() const;
+
+    //! Returns the i-th animation.
+    const PhysicsAnimationPtr& animation(size_t i) const;
+
+    //!
+    //! \brief Updates all the animations to \p frame.
+    //!
+    //! Returns once all the animations are updated. The frame callbacks of
+    //! the animations are called from the threads that run them, so they
+    //! may run at the same time. If some of the animations throw, the
+    //! others still finish, and the exception of the first of them in the
+    //! order of the animations is rethrown.
+    //!
+    void update(const Frame& frame);
+
+ private:
+    std::vector<PhysicsAnimationPtr> _animations;
+};
+
+typedef std::shared_ptr<PhysicsAnimationEnsemble> PhysicsAnimationEnsemblePtr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_PHYSICS_ANIMATION_ENSEMBLE_H_
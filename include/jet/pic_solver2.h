@@ -51,13 +51,22 @@ class PicSolver2 : public GridFluidSolver2 {
     //! Moves particles.
     virtual void moveParticles(double timeIntervalInSeconds);
 
+    //! Markers of the u- and v-faces that received particle velocities.
+    Array2<char> _uMarkers;
+    Array2<char> _vMarkers;
+
+    //! Sums of the splatting weights of the u- and v-faces.
+    Array2<double> _uWeights;
+    Array2<double> _vWeights;
+
+    //! Scratch buffers for binning particles during the splat.
+    Array1<size_t> _splatKeys;
+    Array1<size_t> _splatIndices;
+
  private:
     size_t _signedDistanceFieldId;
     ParticleSystemData2Ptr _particles;
 
-    Array2<char> _uMarkers;
-    Array2<char> _vMarkers;
-
     void extrapolateVelocityToAir();
 
     void buildSignedDistanceField();
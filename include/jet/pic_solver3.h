@@ -3,11 +3,17 @@
 #ifndef INCLUDE_JET_PIC_SOLVER3_H_
 #define INCLUDE_JET_PIC_SOLVER3_H_
 
+#include <jet/bit_array3.h>
 #include <jet/grid_fluid_solver3.h>
 #include <jet/particle_system_data3.h>
+#include <memory>
+#include <vector>
 
 namespace jet {
 
+class ParticleCellBins3;
+class ParticleStencils3;
+
 //!
 //! \brief 2-D Particle-in-Cell (PIC) implementation.
 //!
@@ -32,16 +38,56 @@ class PicSolver3 : public GridFluidSolver3 {
     //! Returns the particle system data.
     const ParticleSystemData3Ptr& particleSystemData() const;
 
+    //! Returns the min number of particles that reseeding keeps per cell.
+    size_t minNumberOfParticlesPerCell() const;
+
+    //!
+    //! \brief Sets the min number of particles that reseeding keeps per cell.
+    //!
+    //! After the particles are moved, the interior fluid cells with fewer
+    //! particles are filled up to this number with particles at random
+    //! positions, which take the velocity of the grid. A cell is an interior
+    //! one if it is outside of the collider, and each of its neighbors has a
+    //! particle, is inside of the collider, or is outside of the domain. Zero,
+    //! which is the default, disables the seeding.
+    //!
+    void setMinNumberOfParticlesPerCell(size_t number);
+
+    //! Returns the max number of particles that reseeding keeps per cell.
+    size_t maxNumberOfParticlesPerCell() const;
+
+    //!
+    //! \brief Sets the max number of particles that reseeding keeps per cell.
+    //!
+    //! After the particles are moved, the particles of a cell past this
+    //! number are removed, which keeps the cost of the transfers bounded in
+    //! the splashes. kMaxSize, which is the default, disables the removal.
+    //! The number should not be less than the min number of particles.
+    //!
+    void setMaxNumberOfParticlesPerCell(size_t number);
+
+    //! Writes a checkpoint of the grids and the particles to \p strm.
+    void serialize(std::ostream* strm) const override;
+
+    //! Restores the grids and the particles from \p strm.
+    void deserialize(std::istream* strm) override;
+
  protected:
     //! Invoked before a simulation time-step begins.
     void onBeginAdvanceTimeStep(double timeIntervalInSeconds) override;
 
+    //! Adds the number of particles and their memory to the grid statistics.
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
     //! Computes the advection term of the fluid solver.
     void computeAdvection(double timeIntervalInSeconds) override;
 
     //! Returns the signed-distance field of the fluid.
     ScalarField3Ptr fluidSdf() const override;
 
+    //! Returns the bounding box of the particles.
+    BoundingBox3D activeRegion() const override;
+
     //! Transfers velocity field from particles to grids.
     virtual void transferFromParticlesToGrids();
 
@@ -51,13 +97,57 @@ class PicSolver3 : public GridFluidSolver3 {
     //! Moves particles.
     virtual void moveParticles(double timeIntervalInSeconds);
 
+    //!
+    //! \brief Removes and seeds particles toward the per-cell limits.
+    //!
+    //! The particles are taken from their cells in particleBins(), so both
+    //! the removal and the seeding run in parallel. The seeded particles and
+    //! the removed ones, which are those with the larger indices in a cell,
+    //! do not depend on the number of threads.
+    //!
+    virtual void reseedParticles();
+
+    //! Markers of the u-, v-, and w-faces that received particle velocities.
+    BitArray3 _uMarkers;
+    BitArray3 _vMarkers;
+    BitArray3 _wMarkers;
+
+    //! Sums of the splatting weights of the u-, v-, and w-faces.
+    Array3<double> _uWeights;
+    Array3<double> _vWeights;
+    Array3<double> _wWeights;
+
+    //!
+    //! \brief Returns the stencils of the particles on the velocity grid.
+    //!
+    //! The stencils are computed by the transfer to the grids, and are valid
+    //! until the particles move in the same time-step, so the transfer back
+    //! to the particles can reuse them. Returns nullptr if they are not valid.
+    //!
+    const ParticleStencils3* particleStencils() const;
+
+    //!
+    //! \brief Returns the particles binned by the cells of the velocity grid.
+    //!
+    //! The particles are binned on the first call after the time-step begins
+    //! or the particles move, so the transfer to the grids, the
+    //! signed-distance field, and the reseeding share the bins of the same
+    //! positions instead of sorting the particles on their own.
+    //!
+    const ParticleCellBins3& particleBins();
+
  private:
     size_t _signedDistanceFieldId;
     ParticleSystemData3Ptr _particles;
-
-    Array3<char> _uMarkers;
-    Array3<char> _vMarkers;
-    Array3<char> _wMarkers;
+    ExtrapolationBuffers3 _extrapolationBuffers[3];
+    size_t _minNumberOfParticlesPerCell = 0;
+    size_t _maxNumberOfParticlesPerCell = kMaxSize;
+    uint64_t _numberOfReseedingPasses = 0;
+    std::vector<char> _isRemoved;
+    std::unique_ptr<ParticleStencils3> _particleStencils;
+    bool _areParticleStencilsValid = false;
+    std::unique_ptr<ParticleCellBins3> _particleBins;
+    bool _areParticleBinsValid = false;
 
     void extrapolateVelocityToAir();
 
@@ -56,6 +56,12 @@ class Plane3 final : public Surface3 {
 
     SurfaceRayIntersection3 actualClosestIntersection(
         const Ray3D& ray) const override;
+
+    //! Computes the distances to the plane in closed form with vectorized
+    //! kernels.
+    void actualBatchClosestSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
 };
 
 typedef std::shared_ptr<Plane3> Plane3Ptr;
@@ -24,13 +24,63 @@ class PointGenerator3 {
 
     virtual ~PointGenerator3();
 
-    //! Generates points to output array \p points inside given \p boundingBox
-    //! with target point \p spacing.
+    //!
+    //! \brief Generates points to output array \p points inside given
+    //! \p boundingBox with target point \p spacing.
+    //!
+    //! The points are appended in the order of forEachPoint. The slices are
+    //! counted and generated in parallel, and the array is resized only once.
+    //!
     void generate(
         const BoundingBox3D& boundingBox,
         double spacing,
         Array1<Vector3D>* points) const;
 
+    //! Returns the number of points inside given \p boundingBox with target
+    //! point \p spacing.
+    size_t countPoints(const BoundingBox3D& boundingBox, double spacing) const;
+
+    //!
+    //! \brief Returns the number of slices of the points.
+    //!
+    //! The points of forEachPoint are divided into the slices in order, which
+    //! can be counted and generated independently, such as the layers of a
+    //! lattice along the z-axis. The default implementation returns one slice
+    //! that has all the points.
+    //!
+    virtual size_t numberOfSlices(
+        const BoundingBox3D& boundingBox,
+        double spacing) const;
+
+    //!
+    //! \brief Returns the number of points in the slices from \p sliceBegin
+    //! to \p sliceEnd (exclusive).
+    //!
+    //! The default implementation counts the points with forEachPoint.
+    //!
+    virtual size_t countPointsInSlices(
+        const BoundingBox3D& boundingBox,
+        double spacing,
+        size_t sliceBegin,
+        size_t sliceEnd) const;
+
+    //!
+    //! \brief Writes the points in the slices from \p sliceBegin to
+    //! \p sliceEnd (exclusive) to \p points.
+    //!
+    //! The points are written in the order of forEachPoint, and the size of
+    //! \p points must be countPointsInSlices of the same range. This function
+    //! is thread-safe, so the threads can generate the different ranges into
+    //! the different parts of the same array. The default implementation
+    //! iterates the points with forEachPoint.
+    //!
+    virtual void generateRange(
+        const BoundingBox3D& boundingBox,
+        double spacing,
+        size_t sliceBegin,
+        size_t sliceEnd,
+        ArrayAccessor1<Vector3D> points) const;
+
     //!
     //! \brief Iterates every point within the bounding box with specified
     //! point pattern and invokes the callback function.
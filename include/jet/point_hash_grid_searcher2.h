@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_POINT_HASH_GRID_SEARCHER2_H_
 #define INCLUDE_JET_POINT_HASH_GRID_SEARCHER2_H_
 
+#include <jet/memory_tracker.h>
 #include <jet/point_neighbor_searcher2.h>
 #include <jet/point2.h>
 #include <jet/size2.h>
@@ -63,6 +64,22 @@ class PointHashGridSearcher2 final : public PointNeighborSearcher2 {
         double radius,
         const ForEachNearbyPointFunc& callback) const override;
 
+    //!
+    //! Invokes the callback for each nearby point around the origin within
+    //! given radius. Unlike the virtual overload, this function takes any
+    //! callable object with signature void(size_t, const Vector2D&) so
+    //! that the callback can be inlined into the search loop.
+    //!
+    //! \param[in]  origin   The origin position.
+    //! \param[in]  radius   The search radius.
+    //! \param[in]  callback The callback object.
+    //!
+    template <typename Callback>
+    void forEachNearbyPoint(
+        const Vector2D& origin,
+        double radius,
+        const Callback& callback) const;
+
     //!
     //! Returns true if there are any nearby points for given origin within
     //! radius.
@@ -94,7 +111,7 @@ class PointHashGridSearcher2 final : public PointNeighborSearcher2 {
     //!
     //! \return     List of buckets.
     //!
-    const std::vector<std::vector<size_t>>& buckets() const;
+    const TrackedVector<TrackedVector<size_t>>& buckets() const;
 
     //!
     //! Returns the hash value for given 2-D bucket index.
@@ -117,8 +134,8 @@ class PointHashGridSearcher2 final : public PointNeighborSearcher2 {
  private:
     double _gridSpacing = 1.0;
     Point2I _resolution = Point2I(1, 1);
-    std::vector<Vector2D> _points;
-    std::vector<std::vector<size_t>> _buckets;
+    TrackedVector<Vector2D> _points;
+    TrackedVector<TrackedVector<size_t>> _buckets;
 
     size_t getHashKeyFromPosition(const Vector2D& position) const;
 
@@ -127,4 +144,6 @@ class PointHashGridSearcher2 final : public PointNeighborSearcher2 {
 
 }  // namespace jet
 
+#include "detail/point_hash_grid_searcher2-inl.h"
+
 #endif  // INCLUDE_JET_POINT_HASH_GRID_SEARCHER2_H_
@@ -3,6 +3,8 @@
 #ifndef INCLUDE_JET_POINT_HASH_GRID_SEARCHER3_H_
 #define INCLUDE_JET_POINT_HASH_GRID_SEARCHER3_H_
 
+#include <jet/memory_tracker.h>
+#include <jet/point_hash_grid_utils.h>
 #include <jet/point_neighbor_searcher3.h>
 #include <jet/point3.h>
 #include <jet/size3.h>
@@ -18,6 +20,12 @@ namespace jet {
 //! acceleration data structure. Each point is recorded to its corresponding
 //! bucket where the hashing function is 3-D grid mapping.
 //!
+//! The resolution is rounded up to powers of two so that the bucket indices
+//! wrap with bit masks. The built points are stored flat in the bucket order,
+//! with an offset table of the bucket ranges, and the points added later by
+//! PointHashGridSearcher3::add are chained per bucket after them. A query
+//! visits the 2x2x2 buckets around the origin with integer arithmetic only.
+//!
 class PointHashGridSearcher3 final : public PointNeighborSearcher3 {
  public:
     //!
@@ -25,7 +33,8 @@ class PointHashGridSearcher3 final : public PointNeighborSearcher3 {
     //!
     //! This constructor takes hash grid resolution and its grid spacing as
     //! its input parameters. The grid spacing must be 2x or greater than
-    //! search radius.
+    //! search radius. Each axis of the resolution is rounded up to a power
+    //! of two.
     //!
     //! \param[in]  resolution  The resolution.
     //! \param[in]  gridSpacing The grid spacing.
@@ -37,7 +46,8 @@ class PointHashGridSearcher3 final : public PointNeighborSearcher3 {
     //!
     //! This constructor takes hash grid resolution and its grid spacing as
     //! its input parameters. The grid spacing must be 2x or greater than
-    //! search radius.
+    //! search radius. Each axis of the resolution is rounded up to a power
+    //! of two.
     //!
     //! \param[in]  resolutionX The resolution x.
     //! \param[in]  resolutionY The resolution y.
@@ -66,6 +76,22 @@ class PointHashGridSearcher3 final : public PointNeighborSearcher3 {
         double radius,
         const ForEachNearbyPointFunc& callback) const override;
 
+    //!
+    //! Invokes the callback for each nearby point around the origin within
+    //! given radius. Unlike the virtual overload, this function takes any
+    //! callable object with signature void(size_t, const Vector3D&) so
+    //! that the callback can be inlined into the search loop.
+    //!
+    //! \param[in]  origin   The origin position.
+    //! \param[in]  radius   The search radius.
+    //! \param[in]  callback The callback object.
+    //!
+    template <typename Callback>
+    void forEachNearbyPoint(
+        const Vector3D& origin,
+        double radius,
+        const Callback& callback) const;
+
     //!
     //! Returns true if there are any nearby points for given origin within
     //! radius.
@@ -83,21 +109,41 @@ class PointHashGridSearcher3 final : public PointNeighborSearcher3 {
     //!
     //! This function adds a single point to the hash grid for future queries.
     //! It can be used for a hash grid that is already built by calling function
-    //! PointHashGridSearcher3::build.
+    //! PointHashGridSearcher3::build. The point is chained to its bucket
+    //! without moving the built points, so rebuild the searcher instead when
+    //! adding many points at once.
     //!
     //! \param[in]  point The point to be added.
     //!
     void add(const Vector3D& point);
 
+    //! Returns the resolution, whose axes are powers of two.
+    Size3 resolution() const;
+
     //!
-    //! \brief      Returns the internal bucket.
+    //! \brief      Invokes the callback for each point in a bucket.
     //!
-    //! A bucket is a list of point indices that has same hash value. This
-    //! function returns the (immutable) internal bucket structure.
+    //! A bucket is the list of the points that have the same hash value. The
+    //! callback takes the point index and the position of each point.
     //!
-    //! \return     List of buckets.
+    //! \param[in]  key      The hash key of the bucket.
+    //! \param[in]  callback The callback object.
     //!
-    const std::vector<std::vector<size_t>>& buckets() const;
+    template <typename Callback>
+    void forEachPointInBucket(size_t key, const Callback& callback) const;
+
+    //! Returns the number of points in the bucket of given hash \p key.
+    size_t numberOfPointsInBucket(size_t key) const;
+
+    //!
+    //! \brief      Returns the occupancy statistics of the buckets.
+    //!
+    //! This function walks all the buckets, so it is meant for tuning the
+    //! resolution rather than being called every time step.
+    //!
+    //! \return     The bucket statistics.
+    //!
+    PointHashGridStatistics statistics() const;
 
     //!
     //! Returns the hash value for given 3-D bucket index.
@@ -119,15 +165,28 @@ class PointHashGridSearcher3 final : public PointNeighborSearcher3 {
 
  private:
     double _gridSpacing = 1.0;
+    double _invGridSpacing = 1.0;
     Point3I _resolution = Point3I(1, 1, 1);
-    std::vector<Vector3D> _points;
-    std::vector<std::vector<size_t>> _buckets;
+    Point3I _mask = Point3I(0, 0, 0);
+    size_t _shiftY = 0;
+    size_t _shiftZ = 0;
+
+    // The points in the bucket order, with the bucket key b owning the range
+    // [_bucketOffsets[b], _bucketOffsets[b + 1]) of the built points. The
+    // added points follow them, chained per bucket from _addedHeads.
+    TrackedVector<size_t> _bucketOffsets;
+    TrackedVector<size_t> _sortedIndices;
+    TrackedVector<Vector3D> _sortedPoints;
+    TrackedVector<size_t> _addedHeads;
+    TrackedVector<size_t> _addedNext;
 
     size_t getHashKeyFromPosition(const Vector3D& position) const;
 
-    void getNearbyKeys(const Vector3D& position, size_t* bucketIndices) const;
+    size_t getNearbyKeys(const Vector3D& position, size_t* nearbyKeys) const;
 };
 
 }  // namespace jet
 
+#include "detail/point_hash_grid_searcher3-inl.h"
+
 #endif  // INCLUDE_JET_POINT_HASH_GRID_SEARCHER3_H_
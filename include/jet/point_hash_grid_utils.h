@@ -0,0 +1,56 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_POINT_HASH_GRID_UTILS_H_
+#define INCLUDE_JET_POINT_HASH_GRID_UTILS_H_
+
+#include <jet/array_accessor1.h>
+#include <jet/size3.h>
+#include <jet/vector3.h>
+
+namespace jet {
+
+//! Occupancy statistics of the hash table of a point hash grid searcher.
+struct PointHashGridStatistics {
+    //! Number of points in the table.
+    size_t numberOfPoints = 0;
+
+    //! Number of buckets, which is the product of the resolution.
+    size_t numberOfBuckets = 0;
+
+    //! Number of buckets with at least one point.
+    size_t numberOfNonEmptyBuckets = 0;
+
+    //! Number of points in the fullest bucket.
+    size_t maxNumberOfPointsPerBucket = 0;
+
+    //! Number of points per bucket.
+    double loadFactor = 0.0;
+
+    //! Number of occupied grid cells that wrapped into a bucket already used
+    //! by another cell. Each collision makes the queries around those cells
+    //! test the points of a distant cell.
+    size_t numberOfCollisions = 0;
+};
+
+//!
+//! \brief      Returns the hash grid resolution suggested for the points.
+//!
+//! The resolution covers the bounding box of \p points with one extra cell
+//! on each side at \p gridSpacing, so no two occupied cells wrap into the
+//! same bucket. Each axis is rounded up to a power of two, so the result
+//! only changes when the points spread or shrink by a large factor. If the
+//! points are too sparse, the largest axis is halved until there are at
+//! most eight buckets per point.
+//!
+//! \param[in]  points      The points to search.
+//! \param[in]  gridSpacing The grid spacing of the searcher.
+//!
+//! \return     The suggested resolution.
+//!
+Size3 suggestedHashGridResolution3(
+    const ConstArrayAccessor1<Vector3D>& points,
+    double gridSpacing);
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_POINT_HASH_GRID_UTILS_H_
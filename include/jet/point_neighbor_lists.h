@@ -0,0 +1,76 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_POINT_NEIGHBOR_LISTS_H_
+#define INCLUDE_JET_POINT_NEIGHBOR_LISTS_H_
+
+#include <jet/array_accessor1.h>
+#include <jet/memory_tracker.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief      Compressed (CSR) neighbor lists.
+//!
+//! This class stores the neighbor lists of a point set in compressed sparse
+//! row layout: a single contiguous array of neighbor indices plus an offset
+//! array which tells where each point's list begins. Compared to a vector of
+//! vectors, rebuilding the lists reuses the same two memory chunks instead of
+//! reallocating one heap block per point.
+//!
+class PointNeighborLists {
+ public:
+    //! Constructs empty neighbor lists.
+    PointNeighborLists();
+
+    //! Returns the number of lists (which is the number of points).
+    size_t size() const;
+
+    //! Returns true if there are no lists.
+    bool empty() const;
+
+    //! Returns the neighbor indices of the i-th point.
+    ConstArrayAccessor1<uint32_t> operator[](size_t i) const;
+
+    //! Returns the number of neighbors of the i-th point.
+    size_t numberOfNeighbors(size_t i) const;
+
+    //! Returns the contiguous neighbor index array.
+    const TrackedVector<uint32_t>& neighbors() const;
+
+    //! Returns the offset array whose size is size() + 1.
+    const TrackedVector<size_t>& offsets() const;
+
+    //! Clears the lists while keeping the allocated memory.
+    void clear();
+
+    //!
+    //! \brief      Builds the lists in two parallel passes.
+    //!
+    //! The first pass calls \p countFunc(i) for each point to get the number
+    //! of neighbors, followed by a prefix sum to compute the offsets. The
+    //! second pass calls \p fillFunc(i, dst), which should write exactly the
+    //! same number of neighbor indices to \p dst.
+    //!
+    //! \param[in]  numberOfPoints  The number of points.
+    //! \param[in]  countFunc       The function that counts the neighbors.
+    //! \param[in]  fillFunc        The function that writes the neighbors.
+    //!
+    template <typename CountFunc, typename FillFunc>
+    void build(
+        size_t numberOfPoints,
+        const CountFunc& countFunc,
+        const FillFunc& fillFunc);
+
+ private:
+    TrackedVector<uint32_t> _neighbors;
+    TrackedVector<size_t> _offsets;
+};
+
+}  // namespace jet
+
+#include "detail/point_neighbor_lists-inl.h"
+
+#endif  // INCLUDE_JET_POINT_NEIGHBOR_LISTS_H_
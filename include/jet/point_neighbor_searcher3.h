@@ -7,6 +7,7 @@
 #include <jet/vector3.h>
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace jet {
 
@@ -58,6 +59,76 @@ class PointNeighborSearcher3 {
     //!
     virtual bool hasNearbyPoint(
         const Vector3D& origin, double radius) const = 0;
+
+    //!
+    //! \brief      Returns the index of the nearest point within max radius.
+    //!
+    //! The default implementation scans all the points within \p maxRadius
+    //! with forEachNearbyPoint. Subclasses can override it to visit their
+    //! cells from near to far and stop early.
+    //!
+    //! \param[in]  origin    The origin.
+    //! \param[in]  maxRadius The max search radius.
+    //!
+    //! \return     The index of the nearest point, or kMaxSize if there is no
+    //!             point within \p maxRadius.
+    //!
+    virtual size_t nearest(const Vector3D& origin, double maxRadius) const;
+
+    //!
+    //! \brief      Finds the k nearest points within max radius.
+    //!
+    //! This function stores the indices of up to \p k nearest points within
+    //! \p maxRadius to \p indices, sorted from the nearest to the farthest.
+    //!
+    //! \param[in]  origin    The origin.
+    //! \param[in]  maxRadius The max search radius.
+    //! \param[in]  k         The max number of points to find.
+    //! \param[out] indices   The indices of the found points.
+    //!
+    virtual void kNearest(
+        const Vector3D& origin,
+        double maxRadius,
+        size_t k,
+        std::vector<size_t>* indices) const;
+
+    //!
+    //! \brief      Finds the nearest point for each of the origins.
+    //!
+    //! The queries are sorted along the Z-order curve and run in parallel, so
+    //! consecutive queries in a thread touch the same part of the searcher.
+    //! The i-th element of \p indices is the result of nearest(origins[i],
+    //! maxRadius).
+    //!
+    //! \param[in]  origins   The origins.
+    //! \param[in]  maxRadius The max search radius.
+    //! \param[out] indices   The indices of the nearest points. The size
+    //!                       should be the same as \p origins.
+    //!
+    void batchNearest(
+        const ConstArrayAccessor1<Vector3D>& origins,
+        double maxRadius,
+        ArrayAccessor1<size_t> indices) const;
+
+    //!
+    //! \brief      Finds the k nearest points for each of the origins.
+    //!
+    //! Same as batchNearest, but the indices of the k nearest points of the
+    //! i-th origin are stored from indices[i * k], sorted from the nearest.
+    //! The rest of the k slots are filled with kMaxSize if there are fewer
+    //! points within \p maxRadius.
+    //!
+    //! \param[in]  origins   The origins.
+    //! \param[in]  maxRadius The max search radius.
+    //! \param[in]  k         The max number of points per origin.
+    //! \param[out] indices   The indices of the nearest points. The size
+    //!                       should be k times the size of \p origins.
+    //!
+    void batchKNearest(
+        const ConstArrayAccessor1<Vector3D>& origins,
+        double maxRadius,
+        size_t k,
+        ArrayAccessor1<size_t> indices) const;
 };
 
 typedef std::shared_ptr<PointNeighborSearcher3> PointNeighborSearcher3Ptr;
@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_POINT_PARALLEL_HASH_GRID_SEARCHER2_H_
 #define INCLUDE_JET_POINT_PARALLEL_HASH_GRID_SEARCHER2_H_
 
+#include <jet/memory_tracker.h>
 #include <jet/point_neighbor_searcher2.h>
 #include <jet/point2.h>
 #include <jet/size2.h>
@@ -29,14 +30,20 @@ class PointParallelHashGridSearcher2 final : public PointNeighborSearcher2 {
         double radius,
         const ForEachNearbyPointFunc& callback) const override;
 
+    template <typename Callback>
+    void forEachNearbyPoint(
+        const Vector2D& origin,
+        double radius,
+        const Callback& callback) const;
+
     bool hasNearbyPoint(
         const Vector2D& origin, double radius) const override;
 
-    const std::vector<size_t>& startIndexTable() const;
+    const TrackedVector<size_t>& startIndexTable() const;
 
-    const std::vector<size_t>& endIndexTable() const;
+    const TrackedVector<size_t>& endIndexTable() const;
 
-    const std::vector<size_t>& sortedIndices() const;
+    const TrackedVector<size_t>& sortedIndices() const;
 
     size_t getHashKeyFromBucketIndex(const Point2I& bucketIndex) const;
 
@@ -45,11 +52,11 @@ class PointParallelHashGridSearcher2 final : public PointNeighborSearcher2 {
 
     double _gridSpacing = 1.0;
     Point2I _resolution = Point2I(1, 1);
-    std::vector<Vector2D> _points;
-    std::vector<size_t> _keys;
-    std::vector<size_t> _startIndexTable;
-    std::vector<size_t> _endIndexTable;
-    std::vector<size_t> _sortedIndices;
+    TrackedVector<Vector2D> _points;
+    TrackedVector<size_t> _keys;
+    TrackedVector<size_t> _startIndexTable;
+    TrackedVector<size_t> _endIndexTable;
+    TrackedVector<size_t> _sortedIndices;
 
     Point2I getBucketIndex(const Vector2D& position) const;
 
@@ -60,4 +67,6 @@ class PointParallelHashGridSearcher2 final : public PointNeighborSearcher2 {
 
 }  // namespace jet
 
+#include "detail/point_parallel_hash_grid_searcher2-inl.h"
+
 #endif  // INCLUDE_JET_POINT_PARALLEL_HASH_GRID_SEARCHER2_H_
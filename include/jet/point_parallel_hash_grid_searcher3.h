@@ -3,9 +3,12 @@
 #ifndef INCLUDE_JET_POINT_PARALLEL_HASH_GRID_SEARCHER3_H_
 #define INCLUDE_JET_POINT_PARALLEL_HASH_GRID_SEARCHER3_H_
 
+#include <jet/memory_tracker.h>
+#include <jet/point_hash_grid_utils.h>
 #include <jet/point_neighbor_searcher3.h>
 #include <jet/point3.h>
 #include <jet/size3.h>
+#include <utility>
 #include <vector>
 
 class PointParallelHashGridSearcher3Tests;
@@ -25,40 +28,121 @@ class PointParallelHashGridSearcher3 final : public PointNeighborSearcher3 {
 
     void build(const ConstArrayAccessor1<Vector3D>& points) override;
 
+    //!
+    //! \brief      Rebuilds the searcher after the points have moved.
+    //!
+    //! This function gives the same result as build, but it reuses the
+    //! buffers and only resets the buckets that were occupied. The keys are
+    //! computed in the previous sorted order, so only the points that changed
+    //! bucket are sorted and merged back. If many points changed bucket, or
+    //! the number of points is different, it falls back to the full sort.
+    //!
+    //! \param[in]  points The points to search.
+    //!
+    void update(const ConstArrayAccessor1<Vector3D>& points);
+
+    //!
+    //! \brief      Replaces the positions of the points without re-bucketing.
+    //!
+    //! The points stay in the buckets of the last build or update while the
+    //! distances are measured with the new positions. A query within radius
+    //! r is still exact if the points moved less than half of the grid
+    //! spacing minus r since then.
+    //!
+    //! \param[in]  points The new positions of the same points.
+    //!
+    void updatePointPositions(const ConstArrayAccessor1<Vector3D>& points);
+
     void forEachNearbyPoint(
         const Vector3D& origin,
         double radius,
         const ForEachNearbyPointFunc& callback) const override;
 
+    template <typename Callback>
+    void forEachNearbyPoint(
+        const Vector3D& origin,
+        double radius,
+        const Callback& callback) const;
+
     bool hasNearbyPoint(
         const Vector3D& origin, double radius) const override;
 
-    const std::vector<size_t>& startIndexTable() const;
+    //!
+    //! \brief      Returns the index of the nearest point within max radius.
+    //!
+    //! The nearby buckets are visited from the nearest cell, and the search
+    //! stops at the first cell that is farther than the nearest point found.
+    //! Like forEachNearbyPoint, \p maxRadius should not exceed half of the
+    //! grid spacing.
+    //!
+    size_t nearest(const Vector3D& origin, double maxRadius) const override;
+
+    //!
+    //! \brief      Finds the k nearest points within max radius.
+    //!
+    //! Same as nearest, but the search stops at the first cell that is
+    //! farther than the k-th nearest point found.
+    //!
+    void kNearest(
+        const Vector3D& origin,
+        double maxRadius,
+        size_t k,
+        std::vector<size_t>* indices) const override;
+
+    const TrackedVector<size_t>& startIndexTable() const;
+
+    const TrackedVector<size_t>& endIndexTable() const;
 
-    const std::vector<size_t>& endIndexTable() const;
+    const TrackedVector<size_t>& sortedIndices() const;
 
-    const std::vector<size_t>& sortedIndices() const;
+    //!
+    //! \brief      Returns the occupancy statistics of the buckets.
+    //!
+    //! The statistics are computed from the sorted keys on each call, so
+    //! build and update do not spend time on them.
+    //!
+    //! \return     The bucket statistics.
+    //!
+    PointHashGridStatistics statistics() const;
 
     size_t getHashKeyFromBucketIndex(const Point3I& bucketIndex) const;
 
+    double gridSpacing() const;
+
+    Size3 resolution() const;
+
  private:
     friend class PointParallelHashGridSearcher3Tests;
 
     double _gridSpacing = 1.0;
     Point3I _resolution = Point3I(1, 1, 1);
-    std::vector<Vector3D> _points;
-    std::vector<size_t> _keys;
-    std::vector<size_t> _startIndexTable;
-    std::vector<size_t> _endIndexTable;
-    std::vector<size_t> _sortedIndices;
+    TrackedVector<Vector3D> _points;
+    TrackedVector<size_t> _keys;
+    TrackedVector<size_t> _startIndexTable;
+    TrackedVector<size_t> _endIndexTable;
+    TrackedVector<size_t> _sortedIndices;
+    TrackedVector<size_t> _newKeys;
+    TrackedVector<std::pair<size_t, size_t>> _movedPoints;
+
+    void buildIndexTables();
 
     Point3I getBucketIndex(const Vector3D& position) const;
 
     size_t getHashKeyFromPosition(const Vector3D& position) const;
 
     void getNearbyKeys(const Vector3D& position, size_t* bucketIndices) const;
+
+    void getNearbyBucketIndices(
+        const Vector3D& position, Point3I* bucketIndices) const;
+
+    size_t sortNearbyBuckets(
+        const Vector3D& origin,
+        size_t* keys,
+        double* distancesSquared) const;
 };
 
 }  // namespace jet
 
+#include "detail/point_parallel_hash_grid_searcher3-inl.h"
+
 #endif  // INCLUDE_JET_POINT_PARALLEL_HASH_GRID_SEARCHER3_H_
@@ -4,8 +4,8 @@
 #define INCLUDE_JET_POINT_PARTICLE_EMITTER3_H_
 
 #include <jet/particle_emitter3.h>
+#include <jet/philox_rng.h>
 #include <limits>
-#include <random>
 
 namespace jet {
 
@@ -15,6 +15,11 @@ namespace jet {
 //! This class emits particles from a single point in given direction, speed,
 //! and spreading angle.
 //!
+//! The direction of each particle is drawn by PhiloxRng from the index of the
+//! particle in the emission order, so the particles are generated in parallel
+//! and written directly to the slots reserved in the particle system data,
+//! and the result depends only on the seed and the frames.
+//!
 class PointParticleEmitter3 final : public ParticleEmitter3 {
  public:
     //!
@@ -51,6 +56,30 @@ class PointParticleEmitter3 final : public ParticleEmitter3 {
         const Frame& frame,
         const ParticleSystemData3Ptr& particles) override;
 
+    //!
+    //! \brief      Generates the particles to emit without adding them.
+    //!
+    //! \param[in]  frame         Current animation frame.
+    //! \param[in]  particles     The particle system data.
+    //! \param[out] newPositions  The positions of the new particles.
+    //! \param[out] newVelocities The velocities of the new particles.
+    //!
+    void generate(
+        const Frame& frame,
+        const ParticleSystemData3Ptr& particles,
+        Array1<Vector3D>* newPositions,
+        Array1<Vector3D>* newVelocities) override;
+
+    //!
+    //! \brief Scales the max numbers of the particles for a quick preview.
+    //!
+    //! Both the rate and the total number at the scale of 1 are divided by
+    //! the cube of \p factor.
+    //!
+    //! \see ParticleEmitter3::setPreviewScale
+    //!
+    void setPreviewScale(double factor) override;
+
     //! Returns max number of new particles per second.
     size_t maxNumberOfNewParticlesPerSecond() const;
 
@@ -64,25 +93,27 @@ class PointParticleEmitter3 final : public ParticleEmitter3 {
     void setMaxNumberOfParticles(size_t maxNumberOfParticles);
 
  private:
-    std::mt19937 _rng;
+    PhiloxRng _rng;
 
     double _firstFrameTimeInSeconds = 0.0;
     size_t _numberOfEmittedParticles = 0;
 
     size_t _maxNumberOfNewParticlesPerSecond = 1;
     size_t _maxNumberOfParticles = std::numeric_limits<size_t>::max();
+    size_t _fullMaxNumberOfNewParticlesPerSecond = 0;
+    size_t _fullMaxNumberOfParticles = 0;
 
     Vector3D _origin;
     Vector3D _direction;
     double _speed;
     double _spreadAngleInRadians;
 
-    void emit(
-        Array1<Vector3D>* newPositions,
-        Array1<Vector3D>* newVelocities,
-        size_t maxNewNumberOfParticles);
+    size_t beginEmission(const Frame& frame);
 
-    double random();
+    void sample(
+        size_t numberOfNewParticles,
+        ArrayAccessor1<Vector3D> newPositions,
+        ArrayAccessor1<Vector3D> newVelocities);
 };
 
 typedef std::shared_ptr<PointParticleEmitter3> PointParticleEmitter3Ptr;
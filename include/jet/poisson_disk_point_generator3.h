@@ -0,0 +1,90 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_POISSON_DISK_POINT_GENERATOR3_H_
+#define INCLUDE_JET_POISSON_DISK_POINT_GENERATOR3_H_
+
+#include <jet/point_generator3.h>
+#include <jet/triangle_mesh3.h>
+
+#include <cstdint>
+
+namespace jet {
+
+//!
+//! \brief 3-D Poisson-disk (blue noise) point generator.
+//!
+//! This class generates random points that are at least the given spacing
+//! apart, which cover a region as evenly as a lattice with fewer points and
+//! without its directional artifacts. The points are sampled by parallel
+//! dart throwing: the region is covered by a background grid whose cells
+//! hold at most one point each, and the grid is divided into tiles of 3^3
+//! cells. The tiles are visited in 8 phases by the parity of their
+//! coordinates, so the tiles of a phase are more than the spacing apart and
+//! are sampled in parallel without conflicts. Every tile has its own random
+//! stream, so the points only depend on the seed and not on the number of
+//! threads.
+//!
+//! Used with VolumeParticleEmitter3, the jitter should be zero, as it breaks
+//! the minimum distance. generateOnSurface() samples a triangle mesh the same
+//! way, such as for SphBoundaryParticles3.
+//!
+//! \see Wei, Li-Yi. "Parallel Poisson disk sampling." ACM Transactions on
+//!      Graphics 27.3 (2008): 20.
+//!
+class PoissonDiskPointGenerator3 final : public PointGenerator3 {
+ public:
+    //!
+    //! \brief Invokes \p callback function for each Poisson-disk point inside
+    //! \p boundingBox.
+    //!
+    //! The points are at least \p spacing apart, and are visited in the order
+    //! of the cells of the background grid.
+    //!
+    void forEachPoint(
+        const BoundingBox3D& boundingBox,
+        double spacing,
+        const std::function<bool(const Vector3D&)>& callback) const override;
+
+    //!
+    //! \brief Appends Poisson-disk points on the triangles of \p mesh to
+    //! \p points.
+    //!
+    //! A pool of candidates is sampled uniformly over the area of the mesh,
+    //! and the candidates of each tile are accepted in a random order if they
+    //! are at least \p spacing apart in space from the accepted ones.
+    //!
+    void generateOnSurface(
+        const TriangleMesh3& mesh,
+        double spacing,
+        Array1<Vector3D>* points) const;
+
+    //! Returns the seed of the random streams.
+    uint32_t seed() const;
+
+    //! Sets the seed of the random streams.
+    void setSeed(uint32_t seed);
+
+    //! Returns the number of the attempts.
+    unsigned int numberOfAttempts() const;
+
+    //!
+    //! \brief Sets the number of the attempts.
+    //!
+    //! This is the number of the darts thrown at each tile within a volume,
+    //! and the number of the candidates per squared spacing of area on a
+    //! surface. More attempts leave fewer gaps. The default is 30, and the
+    //! number should be positive.
+    //!
+    void setNumberOfAttempts(unsigned int numberOfAttempts);
+
+ private:
+    uint32_t _seed = 0;
+    unsigned int _numberOfAttempts = 30;
+};
+
+typedef std::shared_ptr<PoissonDiskPointGenerator3>
+    PoissonDiskPointGenerator3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_POISSON_DISK_POINT_GENERATOR3_H_
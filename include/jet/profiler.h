@@ -0,0 +1,122 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_PROFILER_H_
+#define INCLUDE_JET_PROFILER_H_
+
+#include <jet/macros.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace jet {
+
+//! Timing of a single profiled scope.
+struct ProfileEvent {
+    //! Name of the scope.
+    std::string name;
+
+    //! Names of the enclosing scopes and this scope joined by '/'.
+    std::string path;
+
+    //! Number of the enclosing scopes on the same thread.
+    size_t depth = 0;
+
+    //! Index of the thread that ran the scope, starting from 0.
+    size_t threadIndex = 0;
+
+    //! Start time since the profiler was first used.
+    double startTimeInSeconds = 0.0;
+
+    //! Duration of the scope.
+    double durationInSeconds = 0.0;
+};
+
+//! Timings of the scopes with the same path, summed up.
+struct ProfileReportEntry {
+    //! Path of the scopes.
+    std::string path;
+
+    //! Depth of the scopes.
+    size_t depth = 0;
+
+    //! Number of the times the scopes were entered.
+    size_t count = 0;
+
+    //! Sum of the durations of the scopes.
+    double totalDurationInSeconds = 0.0;
+};
+
+//!
+//! \brief Hierarchical scoped-timer profiler.
+//!
+//! Scopes are timed by ProfileScope, usually through JET_PROFILE_SCOPE, and
+//! nested scopes on the same thread form a hierarchy such as
+//! "advanceTimeStep/onAdvanceTimeStep/computePressure". Each thread keeps its
+//! own hierarchy, and finished scopes from all threads are recorded as
+//! ProfileEvent. The profiler is disabled by default, in which case a scope
+//! only costs an atomic load.
+//!
+//! PhysicsAnimation calls endFrame after each frame, which sums up the events
+//! of the frame into lastFrameReport. The recorded events are kept until
+//! clear is called, and can be exported with writeChromeTrace.
+//!
+class Profiler {
+ public:
+    //! Returns true if the profiler is enabled.
+    static bool isEnabled();
+
+    //! Enables or disables the profiler.
+    static void setIsEnabled(bool isEnabled);
+
+    //! Starts timing a scope on the calling thread.
+    static void beginScope(const char* name);
+
+    //! Finishes timing the innermost scope of the calling thread.
+    static void endScope();
+
+    //! Sums up the events recorded since the last call into lastFrameReport.
+    static void endFrame();
+
+    //! Returns the report of the last frame.
+    static std::vector<ProfileReportEntry> lastFrameReport();
+
+    //! Returns the report of all the recorded events, in the order the
+    //! paths first appeared.
+    static std::vector<ProfileReportEntry> report();
+
+    //! Returns all the recorded events.
+    static std::vector<ProfileEvent> events();
+
+    //! Removes all the recorded events and the last frame report.
+    static void clear();
+
+    //! Writes the recorded events in the Chrome trace event format, which
+    //! can be opened by chrome://tracing.
+    static void writeChromeTrace(std::ostream* strm);
+};
+
+//! RAII helper that times the scope it lives in when the profiler is enabled.
+class ProfileScope final {
+ public:
+    JET_NON_COPYABLE(ProfileScope)
+
+    //! Begins the scope with given \p name, which should outlive the scope.
+    explicit ProfileScope(const char* name);
+
+    //! Ends the scope.
+    ~ProfileScope();
+
+ private:
+    bool _isActive;
+};
+
+}  // namespace jet
+
+#define JET_PROFILE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define JET_PROFILE_SCOPE_CONCAT(a, b) JET_PROFILE_SCOPE_CONCAT_IMPL(a, b)
+
+//! Times the rest of the enclosing scope with given name.
+#define JET_PROFILE_SCOPE(name) \
+    ::jet::ProfileScope JET_PROFILE_SCOPE_CONCAT(profileScope, __LINE__)(name)
+
+#endif  // INCLUDE_JET_PROFILER_H_
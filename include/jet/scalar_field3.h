@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_SCALAR_FIELD3_H_
 #define INCLUDE_JET_SCALAR_FIELD3_H_
 
+#include <jet/array_accessor1.h>
 #include <jet/field3.h>
 #include <jet/vector3.h>
 #include <functional>
@@ -22,6 +23,17 @@ class ScalarField3 : public Field3 {
     //! Returns sampled value at given position \p x.
     virtual double sample(const Vector3D& x) const = 0;
 
+    //!
+    //! \brief Samples the field at the positions \p x into \p result.
+    //!
+    //! Same as VectorField3::batchSample, the solvers call this function with
+    //! blocks of points. \p result should be at least as large as \p x. The
+    //! default implementation calls sample() for each position.
+    //!
+    virtual void batchSample(
+        const ConstArrayAccessor1<Vector3D>& x,
+        ArrayAccessor1<double> result) const;
+
     //! Returns gradient vector at given position \p x.
     virtual Vector3D gradient(const Vector3D& x) const;
 
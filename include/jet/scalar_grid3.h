@@ -6,26 +6,41 @@
 #include <jet/array3.h>
 #include <jet/array_accessor3.h>
 #include <jet/array_samplers3.h>
+#include <jet/copy_on_write_array3.h>
 #include <jet/grid3.h>
 #include <jet/scalar_field3.h>
 #include <memory>
 
 namespace jet {
 
-//! Abstract base class for 3-D scalar grid structure.
-class ScalarGrid3 : public ScalarField3, public Grid3 {
+//!
+//! \brief Abstract base class for 3-D scalar grid structure.
+//!
+//! The grid stores its data points as \p T, which is double for ScalarGrid3
+//! and float for ScalarGrid3F. The float grids take half the memory, while
+//! the sampling, gradient, and Laplacian are still evaluated in double.
+//!
+//! Copies and clones of a grid share the data until either of them is
+//! written through operator(), dataAccessor(), fill(), or resize(), so
+//! keeping a read-only snapshot costs nothing until the source changes. An
+//! accessor from dataAccessor() should not be kept across such a copy.
+//!
+//! \tparam T The value type of the data points.
+//!
+template <typename T>
+class ScalarGrid3T : public ScalarField3, public Grid3 {
  public:
     //! Read-write array accessor type.
-    typedef ArrayAccessor3<double> ScalarDataAccessor;
+    typedef ArrayAccessor3<T> ScalarDataAccessor;
 
     //! Read-only array accessor type.
-    typedef ConstArrayAccessor3<double> ConstScalarDataAccessor;
+    typedef ConstArrayAccessor3<T> ConstScalarDataAccessor;
 
     //! Constructs an empty grid.
-    ScalarGrid3();
+    ScalarGrid3T();
 
     //! Default destructor.
-    virtual ~ScalarGrid3();
+    virtual ~ScalarGrid3T();
 
     //!
     //! \brief Returns the size of the grid data.
@@ -45,7 +60,7 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     virtual Vector3D dataOrigin() const = 0;
 
     //! Returns the copy of the grid instance.
-    virtual std::shared_ptr<ScalarGrid3> clone() const = 0;
+    virtual std::shared_ptr<ScalarGrid3T> clone() const = 0;
 
     //! Clears the contents of the grid.
     void clear();
@@ -61,14 +76,14 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
         double originX = 0.0,
         double originY = 0.0,
         double originZ = 0.0,
-        double initialValue = 0.0);
+        T initialValue = 0);
 
     //! Resizes the grid using given parameters.
     void resize(
         const Size3& resolution,
         const Vector3D& gridSpacing = Vector3D(1, 1, 1),
         const Vector3D& origin = Vector3D(),
-        double initialValue = 0.0);
+        T initialValue = 0);
 
     //! Resizes the grid using given parameters.
     void resize(
@@ -83,10 +98,10 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     void resize(const Vector3D& gridSpacing, const Vector3D& origin);
 
     //! Returns the grid data at given data point.
-    const double& operator()(size_t i, size_t j, size_t k) const;
+    const T& operator()(size_t i, size_t j, size_t k) const;
 
     //! Returns the grid data at given data point.
-    double& operator()(size_t i, size_t j, size_t k);
+    T& operator()(size_t i, size_t j, size_t k);
 
     //! Returns the gradient vector at given data point.
     Vector3D gradientAtDataPoint(size_t i, size_t j, size_t k) const;
@@ -94,7 +109,26 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     //! Returns the Laplacian at given data point.
     double laplacianAtDataPoint(size_t i, size_t j, size_t k) const;
 
-    //! Returns the read-write data array accessor.
+    //!
+    //! \brief Computes the gradient at every data point into \p output.
+    //!
+    //! The result is the same as gradientAtDataPoint. The rows along x are
+    //! processed in parallel, with the neighboring rows resolved once per row
+    //! and the boundary clamping only applied at the ends of the row. The
+    //! size of \p output should be the data size.
+    //!
+    void computeGradient(ArrayAccessor3<Vector3D> output) const;
+
+    //!
+    //! \brief Computes the Laplacian at every data point into \p output.
+    //!
+    //! The result is the same as laplacianAtDataPoint, computed the same way
+    //! as computeGradient. The size of \p output should be the data size.
+    //!
+    void computeLaplacian(ArrayAccessor3<double> output) const;
+
+    //! Returns the read-write data array accessor, after copying the data if
+    //! it is shared with another grid.
     ScalarDataAccessor dataAccessor();
 
     //! Returns the read-only data array accessor.
@@ -104,7 +138,7 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     DataPositionFunc dataPosition() const;
 
     //! Fills the grid with given value.
-    void fill(double value);
+    void fill(T value);
 
     //! Fills the grid with given position-to-value mapping function.
     void fill(const std::function<double(const Vector3D&)>& func);
@@ -131,6 +165,27 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     void parallelForEachDataPointIndex(
         const std::function<void(size_t, size_t, size_t)>& func) const;
 
+    //!
+    //! \brief Invokes the given function \p func for each x-row of the data
+    //! points.
+    //!
+    //! The input parameters are the j and k indices of a row, whose data
+    //! points are contiguous in the data accessor. The order of execution is
+    //! j-first, k-last.
+    //!
+    void forEachDataPointRow(
+        const std::function<void(size_t, size_t)>& func) const;
+
+    //!
+    //! \brief Invokes the given function \p func for each x-row of the data
+    //! points parallelly.
+    //!
+    //! The input parameters are the j and k indices of a row. The order of
+    //! execution can be arbitrary since it's multi-threaded.
+    //!
+    void parallelForEachDataPointRow(
+        const std::function<void(size_t, size_t)>& func) const;
+
     //! Serializes the grid instance to the output stream \p strm.
     void serialize(std::ostream* strm) const override;
 
@@ -155,6 +210,15 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     //!
     std::function<double(const Vector3D&)> sampler() const override;
 
+    //!
+    //! \brief Returns the linear sampler of the data.
+    //!
+    //! Unlike sampler(), the returned object can be inlined into the caller's
+    //! loop. It refers to the data of this grid, so it is invalidated when the
+    //! grid is resized.
+    //!
+    const LinearArraySampler3<T, double>& linearSampler() const;
+
     //! Returns the gradient vector at given position \p x.
     Vector3D gradient(const Vector3D& x) const override;
 
@@ -163,40 +227,64 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
 
  protected:
     //! Swaps the data storage and predefined samplers with given grid.
-    void swapScalarGrid(ScalarGrid3* other);
+    void swapScalarGrid(ScalarGrid3T* other);
 
     //! Sets the data storage and predefined samplers with given grid.
-    void setScalarGrid(const ScalarGrid3& other);
+    void setScalarGrid(const ScalarGrid3T& other);
 
  private:
-    Array3<double> _data;
-    LinearArraySampler3<double, double> _linearSampler;
-    std::function<double(const Vector3D&)> _sampler;
+    CopyOnWriteArray3<T> _data;
+    LinearArraySampler3<T, double> _linearSampler;
+
+    Array3<T>& mutableData();
 
     void resetSampler();
 };
 
+//! Double-precision 3-D scalar grid.
+typedef ScalarGrid3T<double> ScalarGrid3;
+
+//! Single-precision 3-D scalar grid.
+typedef ScalarGrid3T<float> ScalarGrid3F;
+
+//! Shared pointer type for the ScalarGrid3.
 typedef std::shared_ptr<ScalarGrid3> ScalarGrid3Ptr;
 
+//! Shared pointer type for the ScalarGrid3F.
+typedef std::shared_ptr<ScalarGrid3F> ScalarGrid3FPtr;
+
 //! Abstract base class for 3-D scalar grid builder.
-class ScalarGridBuilder3 {
+template <typename T>
+class ScalarGridBuilder3T {
  public:
     //! Creates a builder.
-    ScalarGridBuilder3();
+    ScalarGridBuilder3T();
 
     //! Default destructor.
-    virtual ~ScalarGridBuilder3();
+    virtual ~ScalarGridBuilder3T();
 
     //! Returns 3-D scalar grid with given parameters.
-    virtual ScalarGrid3Ptr build(
+    virtual std::shared_ptr<ScalarGrid3T<T>> build(
         const Size3& resolution,
         const Vector3D& gridSpacing,
         const Vector3D& gridOrigin,
         double initialVal) const = 0;
 };
 
+//! Builder type of the ScalarGrid3.
+typedef ScalarGridBuilder3T<double> ScalarGridBuilder3;
+
+//! Builder type of the ScalarGrid3F.
+typedef ScalarGridBuilder3T<float> ScalarGridBuilder3F;
+
+//! Shared pointer type for the ScalarGridBuilder3.
 typedef std::shared_ptr<ScalarGridBuilder3> ScalarGridBuilder3Ptr;
 
+//! Shared pointer type for the ScalarGridBuilder3F.
+typedef std::shared_ptr<ScalarGridBuilder3F> ScalarGridBuilder3FPtr;
+
 }  // namespace jet
 
+#include "detail/scalar_grid3-inl.h"
+
 #endif  // INCLUDE_JET_SCALAR_GRID3_H_
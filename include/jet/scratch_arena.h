@@ -0,0 +1,109 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SCRATCH_ARENA_H_
+#define INCLUDE_JET_SCRATCH_ARENA_H_
+
+#include <jet/array_accessor1.h>
+#include <jet/array_accessor2.h>
+#include <jet/array_accessor3.h>
+#include <jet/memory_tracker.h>
+#include <jet/size2.h>
+#include <jet/size3.h>
+#include <memory>
+#include <vector>
+
+namespace jet {
+
+//! Alignment of the buffers of ScratchArena in bytes.
+const size_t kScratchAlignment = 64;
+
+//!
+//! \brief Pool of reusable buffers for the temporaries of a time-step.
+//!
+//! The solvers that need temporary arrays on every call keep an arena and
+//! take the buffers from it instead of constructing local arrays. The
+//! buffers are aligned to kScratchAlignment bytes and stay valid until
+//! reset(), which returns all of them to the arena without releasing the
+//! memory. The capacities are rounded up to one of four buckets per power of
+//! two, so that buffers of slightly different sizes, such as the u, v and w
+//! data of a face-centered grid, are shared between the calls. Once the
+//! arena has grown, taking a buffer does not allocate. The memory is
+//! accounted to MemoryTag::Scratch.
+//!
+//! The arena is not thread-safe, so each solver owns its own. Copying a
+//! solver gives the copy an empty arena.
+//!
+class ScratchArena final {
+ public:
+    //! Constructs an empty arena.
+    ScratchArena();
+
+    //! Constructs an empty arena; the buffers are not copied.
+    ScratchArena(const ScratchArena& other);
+
+    //! Keeps the buffers of this arena; the buffers are not copied.
+    ScratchArena& operator=(const ScratchArena& other);
+
+    //!
+    //! \brief Returns raw memory of at least \p bytes.
+    //!
+    //! The memory is aligned to kScratchAlignment bytes and is not
+    //! initialized.
+    //!
+    void* allocate(size_t bytes);
+
+    //! Returns a 1-D buffer of \p size elements filled with \p initVal.
+    template <typename T>
+    ArrayAccessor1<T> array1(size_t size, const T& initVal = T());
+
+    //! Returns a 2-D buffer of \p size elements filled with \p initVal.
+    template <typename T>
+    ArrayAccessor2<T> array2(const Size2& size, const T& initVal = T());
+
+    //! Returns a 3-D buffer of \p size elements filled with \p initVal.
+    template <typename T>
+    ArrayAccessor3<T> array3(const Size3& size, const T& initVal = T());
+
+    //!
+    //! \brief Returns all the buffers to the arena.
+    //!
+    //! The memory is kept for the following calls, and the buffers handed
+    //! out so far must not be used anymore.
+    //!
+    void reset();
+
+    //! Releases the memory of all the buffers.
+    void clear();
+
+    //! Returns the number of the buffers owned by the arena.
+    size_t numberOfBuffers() const;
+
+    //! Returns the number of the buffers handed out since the last reset.
+    size_t numberOfBuffersInUse() const;
+
+    //! Returns the bytes owned by the arena.
+    size_t capacityInBytes() const;
+
+    //! Returns the capacity of the bucket that \p bytes falls into.
+    static size_t bucketSize(size_t bytes);
+
+ private:
+    struct Buffer {
+        TrackedVector<unsigned char> storage;
+        void* data = nullptr;
+        size_t capacity = 0;
+        bool isInUse = false;
+    };
+
+    std::vector<std::unique_ptr<Buffer>> _buffers;
+    size_t _numberOfBuffersInUse = 0;
+
+    template <typename T>
+    T* allocateAndFill(size_t n, const T& initVal);
+};
+
+}  // namespace jet
+
+#include "detail/scratch_arena-inl.h"
+
+#endif  // INCLUDE_JET_SCRATCH_ARENA_H_
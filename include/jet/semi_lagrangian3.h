@@ -5,6 +5,7 @@
 
 #include <jet/advection_solver3.h>
 #include <limits>
+#include <vector>
 
 namespace jet {
 
@@ -16,11 +17,15 @@ namespace jet {
 //! For the back-tracing, this class uses 2nd-order mid-point rule with adaptive
 //! time-stepping (CFL <= 1).
 //! To extend the class using higher-order spatial interpolation, the inheriting
-//! classes can override SemiLagrangian2::getScalarSamplerFunc and
-//! SemiLagrangian2::getVectorSamplerFunc. See CubicSemiLagrangian2 for example.
+//! classes can override SemiLagrangian3::getScalarSamplerFunc and
+//! SemiLagrangian3::getVectorSamplerFunc, and construct the base class with
+//! Interpolation::Custom. The built-in linear and cubic interpolations are
+//! dispatched at compile time so that the samplers can be inlined into the
+//! advection loops. See CubicSemiLagrangian3 for example.
 //!
 class SemiLagrangian3 : public AdvectionSolver3 {
  public:
+    //! Constructs a solver with linear interpolation.
     SemiLagrangian3();
 
     virtual ~SemiLagrangian3();
@@ -51,6 +56,28 @@ class SemiLagrangian3 : public AdvectionSolver3 {
         const ScalarField3& boundarySdf
             = ConstantScalarField3(std::numeric_limits<double>::max())) final;
 
+    //!
+    //! \brief Computes semi-Langian for given single-precision scalar grid.
+    //!
+    //! The linear interpolation samples the floats of \p input directly, and
+    //! writes the floats of \p output. The other interpolations stage the
+    //! grids in double precision.
+    //!
+    //! \param input Input scalar grid.
+    //! \param flow Vector field that advects the input field.
+    //! \param dt Time-step for the advection.
+    //! \param output Output scalar grid.
+    //! \param boundarySdf Boundary interface defined by signed-distance
+    //!     field.
+    //!
+    void advect(
+        const ScalarGrid3F& input,
+        const VectorField3& flow,
+        double dt,
+        ScalarGrid3F* output,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(std::numeric_limits<double>::max())) final;
+
     //!
     //! \brief Computes semi-Langian for given collocated vector grid.
     //!
@@ -104,7 +131,51 @@ class SemiLagrangian3 : public AdvectionSolver3 {
         const ScalarField3& boundarySdf
             = ConstantScalarField3(std::numeric_limits<double>::max())) final;
 
+    //!
+    //! \brief Computes semi-Langian for multiple collocated grids.
+    //!
+    //! This function advects the scalar grids \p scalarInputs and the
+    //! collocated vector grids \p vectorInputs together. The grids are grouped
+    //! by their data layout (data size, origin, and grid spacing), and within
+    //! a group each data point is back-traced only once. The traced point is
+    //! then sampled for every grid in the group. The result is the same as
+    //! advecting each grid separately.
+    //!
+    //! \param scalarInputs Input scalar grids.
+    //! \param vectorInputs Input collocated vector grids.
+    //! \param flow Vector field that advects the input fields.
+    //! \param dt Time-step for the advection.
+    //! \param scalarOutputs Output scalar grids.
+    //! \param vectorOutputs Output collocated vector grids.
+    //! \param boundarySdf Boundary interface defined by signed-distance
+    //!     field.
+    //!
+    void advect(
+        const std::vector<const ScalarGrid3*>& scalarInputs,
+        const std::vector<const CollocatedVectorGrid3*>& vectorInputs,
+        const VectorField3& flow,
+        double dt,
+        const std::vector<ScalarGrid3*>& scalarOutputs,
+        const std::vector<CollocatedVectorGrid3*>& vectorOutputs,
+        const ScalarField3& boundarySdf
+            = ConstantScalarField3(std::numeric_limits<double>::max())) final;
+
  protected:
+    //! Spatial interpolation methods for sampling the advected field.
+    enum class Interpolation {
+        //! Trilinear interpolation using LinearArraySampler3.
+        Linear,
+
+        //! Tricubic interpolation using CubicArraySampler3.
+        Cubic,
+
+        //! Interpolation given by the sampler functions.
+        Custom
+    };
+
+    //! Constructs a solver with given spatial interpolation method.
+    explicit SemiLagrangian3(Interpolation interpolation);
+
     //!
     //! \brief Returns spatial interpolation function object for given scalar
     //! grid.
@@ -141,13 +212,20 @@ class SemiLagrangian3 : public AdvectionSolver3 {
     virtual std::function<Vector3D(const Vector3D&)>
     getVectorSamplerFunc(const FaceCenteredGrid3& input) const;
 
+    //! Returns true if the cubic interpolation limits the slopes.
+    bool isCubicMonotonic() const;
+
+    //!
+    //! \brief Sets true to limit the slopes of the cubic interpolation.
+    //!
+    //! The monotonic interpolation (default) has no overshoots. Otherwise,
+    //! the cubic interpolation is evaluated as a separable weighted sum.
+    //!
+    void setIsCubicMonotonic(bool isMonotonic);
+
  private:
-    Vector3D backTrace(
-        const VectorField3& flow,
-        double dt,
-        double h,
-        const Vector3D& pt0,
-        const ScalarField3& boundarySdf);
+    Interpolation _interpolation = Interpolation::Linear;
+    bool _isCubicMonotonic = true;
 };
 
 }  // namespace jet
@@ -0,0 +1,271 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SHARED_FRAME_BUFFER_H_
+#define INCLUDE_JET_SHARED_FRAME_BUFFER_H_
+
+#include <jet/animation.h>
+#include <jet/array1.h>
+#include <jet/array_accessor1.h>
+#include <jet/array_accessor3.h>
+#include <jet/scalar_grid3.h>
+#include <jet/size3.h>
+#include <jet/triangle_mesh3.h>
+#include <jet/vector3.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jet {
+
+class SharedMemory;
+
+//! Kinds of the frames in a shared frame buffer.
+enum class SharedFrameType {
+    //! No frame.
+    None = 0,
+
+    //! Particle positions.
+    Particles = 1,
+
+    //! Scalar grid, such as a signed-distance field.
+    ScalarGrid = 2,
+
+    //! Triangle mesh.
+    TriangleMesh = 3
+};
+
+//!
+//! \brief Read-only view of a frame in a shared frame buffer.
+//!
+//! The data of the view point into the shared memory, and stay valid until
+//! the publisher reuses the slot of the frame, which is after the number of
+//! the slots minus one more frames are published. Check
+//! SharedFrameViewer::isValid() after using the data to know whether it was
+//! overwritten in the meantime.
+//!
+struct SharedFrameView {
+    //! Kind of the frame.
+    SharedFrameType type = SharedFrameType::None;
+
+    //! Sequence number of the frame, which starts from one and increases by
+    //! one for each published frame.
+    uint64_t sequence = 0;
+
+    //! Index of the animation frame.
+    unsigned int frameIndex = 0;
+
+    //! Time of the animation frame.
+    double timeInSeconds = 0.0;
+
+    //! Particle positions, or the points of the triangle mesh.
+    ConstArrayAccessor1<Vector3D> points;
+
+    //! Point indices of the triangles, three per triangle.
+    const uint32_t* triangles = nullptr;
+
+    //! Number of the triangles of the triangle mesh.
+    size_t numberOfTriangles = 0;
+
+    //! Resolution of the scalar grid.
+    Size3 resolution;
+
+    //! Grid spacing of the scalar grid.
+    Vector3D gridSpacing;
+
+    //! Origin of the scalar grid.
+    Vector3D origin;
+
+    //! Data origin of the scalar grid.
+    Vector3D dataOrigin;
+
+    //! Data of the scalar grid.
+    ConstArrayAccessor3<double> gridData;
+
+    //! Slot of the frame in the buffer.
+    size_t slot = 0;
+
+    //! Version of the slot when the view was taken.
+    uint64_t slotVersion = 0;
+};
+
+//!
+//! \brief Publishes the latest frames to a named shared memory for viewers.
+//!
+//! The shared memory holds a ring of slots, each of which holds a frame of
+//! particle positions, a scalar grid, or a triangle mesh. A slot is guarded
+//! by a version that is odd while the slot is being written, so the viewers
+//! in other processes read the frames without any lock (like a seqlock) and
+//! the publisher never waits for them.
+//!
+//! The publish functions take a snapshot of the data like the ones queued to
+//! AsyncFileWriter, which is a copy of the particles or the mesh, and a clone
+//! of the grid that shares the data until the solver writes to it. A
+//! background thread then copies the snapshot into the next slot. If the
+//! previous snapshot is still pending, it is replaced by the new one and
+//! dropped, so the frame callback of PhysicsAnimation never waits for the
+//! copy.
+//!
+//! The layout of the shared memory starts with a header of 64 bytes that
+//! holds the tag "JETSHFRM", the format version, the number of slots, the
+//! capacity of a slot, and the sequence number of the latest frame. Each
+//! slot follows at a 64-byte aligned offset with a header of 192 bytes and
+//! the data: 3 doubles per particle, the grid data in the order of the data
+//! points, or 3 doubles per point followed by 3 uint32 indices per triangle.
+//!
+class SharedFramePublisher {
+ public:
+    JET_NON_COPYABLE(SharedFramePublisher)
+
+    //! Constructs a publisher that is not open.
+    SharedFramePublisher();
+
+    //! Stops the background thread and removes the shared memory.
+    ~SharedFramePublisher();
+
+    //!
+    //! \brief Creates the shared memory of \p name.
+    //!
+    //! A frame larger than \p slotCapacityInBytes cannot be published, and
+    //! \p numberOfSlots should be at least two so the viewers can read a
+    //! frame while the next one is written. Returns false if the shared
+    //! memory cannot be created.
+    //!
+    bool open(
+        const std::string& name,
+        size_t slotCapacityInBytes,
+        size_t numberOfSlots = 3);
+
+    //! Waits for the pending frame, then removes the shared memory.
+    void close();
+
+    //! Returns true if the shared memory is open.
+    bool isOpen() const;
+
+    //! Returns the name of the shared memory.
+    const std::string& name() const;
+
+    //! Publishes the particle positions of \p frame. Returns false if not
+    //! open or the positions do not fit in a slot.
+    bool publishParticles(
+        const Frame& frame,
+        const ConstArrayAccessor1<Vector3D>& positions);
+
+    //! Publishes the scalar grid of \p frame. Returns false if not open or
+    //! the grid does not fit in a slot.
+    bool publishScalarGrid(const Frame& frame, const ScalarGrid3& grid);
+
+    //! Publishes the triangle mesh of \p frame with its rigid transform
+    //! applied to the points. Returns false if not open or the mesh does not
+    //! fit in a slot.
+    bool publishTriangleMesh(const Frame& frame, const TriangleMesh3& mesh);
+
+    //! Waits until the pending frame is copied to the shared memory.
+    void flush();
+
+    //! Returns the number of the frames copied to the shared memory.
+    uint64_t numberOfPublishedFrames() const;
+
+    //! Returns the number of the frames replaced by a newer one before they
+    //! were copied to the shared memory.
+    uint64_t numberOfDroppedFrames() const;
+
+ private:
+    struct Snapshot {
+        SharedFrameType type = SharedFrameType::None;
+        unsigned int frameIndex = 0;
+        double timeInSeconds = 0.0;
+        std::vector<Vector3D> points;
+        std::vector<uint32_t> triangles;
+        ScalarGrid3Ptr grid;
+    };
+
+    std::string _name;
+    std::unique_ptr<SharedMemory> _memory;
+    size_t _slotCapacity = 0;
+    size_t _numberOfSlots = 0;
+    uint64_t _numberOfPublishedFrames = 0;
+    uint64_t _numberOfDroppedFrames = 0;
+
+    std::unique_ptr<Snapshot> _pending;
+    bool _isCopying = false;
+    bool _isStopping = false;
+    mutable std::mutex _mutex;
+    std::condition_variable _snapshotQueued;
+    std::condition_variable _snapshotCopied;
+    std::thread _thread;
+
+    bool queue(std::unique_ptr<Snapshot> snapshot, size_t bytes);
+
+    void run();
+
+    void copyToSlot(const Snapshot& snapshot, uint64_t sequence);
+};
+
+//!
+//! \brief Reads the frames published by SharedFramePublisher.
+//!
+//! The viewer maps the shared memory read-only and never blocks the
+//! publisher. acquireLatest() returns a view into the shared memory without
+//! copying, and the read functions copy the latest frame out of it.
+//!
+class SharedFrameViewer {
+ public:
+    JET_NON_COPYABLE(SharedFrameViewer)
+
+    //! Constructs a viewer that is not open.
+    SharedFrameViewer();
+
+    //! Destructor.
+    ~SharedFrameViewer();
+
+    //! Opens the shared memory of \p name. Returns false if it does not
+    //! exist or is not a shared frame buffer.
+    bool open(const std::string& name);
+
+    //! Unmaps the shared memory and invalidates the views.
+    void close();
+
+    //! Returns true if the shared memory is open.
+    bool isOpen() const;
+
+    //! Returns the sequence number of the latest frame, or zero if none has
+    //! been published. Polling it is cheap.
+    uint64_t latestSequence() const;
+
+    //! Takes a view of the latest frame. Returns false if no frame has been
+    //! published, or the publisher kept overwriting the frame while it was
+    //! read.
+    bool acquireLatest(SharedFrameView* view) const;
+
+    //! Returns true if the slot of \p view has not been overwritten since the
+    //! view was taken, so the data read through the view are consistent.
+    bool isValid(const SharedFrameView& view) const;
+
+    //! Copies the latest frame if it is particles. Returns false otherwise.
+    bool readParticles(Array1<Vector3D>* positions) const;
+
+    //! Copies the latest frame to \p grid, which is resized to the published
+    //! resolution, grid spacing, and origin, if it is a scalar grid with the
+    //! same data layout. Returns false otherwise.
+    bool readScalarGrid(ScalarGrid3* grid) const;
+
+    //! Copies the latest frame to \p mesh if it is a triangle mesh. Returns
+    //! false otherwise.
+    bool readTriangleMesh(TriangleMesh3* mesh) const;
+
+ private:
+    std::unique_ptr<SharedMemory> _memory;
+    size_t _slotCapacity = 0;
+    size_t _numberOfSlots = 0;
+
+    template <typename Callback>
+    bool readLatest(SharedFrameType type, const Callback& func) const;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_SHARED_FRAME_BUFFER_H_
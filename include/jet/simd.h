@@ -0,0 +1,66 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SIMD_H_
+#define INCLUDE_JET_SIMD_H_
+
+namespace jet {
+
+//!
+//! \brief SIMD instruction sets of the vectorized kernels.
+//!
+//! The kernels, such as the FdmBlas3 ones, are compiled for each instruction
+//! set of the target architecture and dispatched at runtime, so the library
+//! does not need to be built with -mavx or /arch:AVX to use the wider
+//! registers.
+//!
+enum class SimdInstructionSet {
+    //! Plain C++ loops.
+    None = 0,
+
+    //! 128-bit SSE2 of x86 and x86-64.
+    Sse2,
+
+    //! 128-bit NEON of ARM64.
+    Neon,
+
+    //! 256-bit AVX of x86-64.
+    Avx,
+
+    //! 512-bit AVX-512F of x86-64.
+    Avx512
+};
+
+//!
+//! \brief      Returns the instruction set the vectorized kernels use.
+//!
+//! The default is the widest instruction set supported by the CPU and the
+//! operating system.
+//!
+SimdInstructionSet simdInstructionSet();
+
+//!
+//! \brief      Sets the instruction set the vectorized kernels use.
+//!
+//! All the instruction sets compute the same operations in the same order,
+//! without fused multiply-adds, so the results are identical regardless of
+//! the instruction set. This function is meant for testing and benchmarking
+//! the kernels. Do not call it while any kernel is running.
+//!
+//! \param[in]  instructionSet The instruction set, which must be supported.
+//!
+void setSimdInstructionSet(SimdInstructionSet instructionSet);
+
+//!
+//! \brief      Returns true if the CPU and the operating system support given
+//!             instruction set.
+//!
+bool isSimdInstructionSetSupported(SimdInstructionSet instructionSet);
+
+//!
+//! \brief      Returns the name of given instruction set, such as "avx".
+//!
+const char* simdInstructionSetName(SimdInstructionSet instructionSet);
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_SIMD_H_
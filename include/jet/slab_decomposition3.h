@@ -0,0 +1,86 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SLAB_DECOMPOSITION3_H_
+#define INCLUDE_JET_SLAB_DECOMPOSITION3_H_
+
+#include <jet/array2.h>
+#include <jet/array3.h>
+#include <jet/communicator.h>
+#include <jet/size3.h>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Decomposition of a 3-D grid into slabs along the z-axis.
+//!
+//! Each rank of the communicator owns a contiguous range of the z-layers,
+//! split as evenly as possible in the order of the ranks. The local arrays of
+//! a rank hold the owned layers only, and the layers next to the slab are
+//! exchanged into separate 2-D ghost layers.
+//!
+class SlabDecomposition3 {
+ public:
+    //!
+    //! \brief Constructs the decomposition of a grid with given size.
+    //!
+    //! The depth of the grid must be at least the number of the ranks.
+    //!
+    SlabDecomposition3(
+        const Size3& globalSize,
+        const CommunicatorPtr& communicator);
+
+    //! Returns the size of the whole grid.
+    const Size3& globalSize() const;
+
+    //! Returns the size of the slab owned by this rank.
+    Size3 localSize() const;
+
+    //! Returns the first z-index of the slab owned by this rank.
+    size_t zBegin() const;
+
+    //! Returns the z-index past the last one of the slab owned by this rank.
+    size_t zEnd() const;
+
+    //! Returns the rank owning the slab below, or kNoRank for the first one.
+    int previousRank() const;
+
+    //! Returns the rank owning the slab above, or kNoRank for the last one.
+    int nextRank() const;
+
+    //! Returns the communicator.
+    const CommunicatorPtr& communicator() const;
+
+    //!
+    //! \brief Exchanges the layers next to the slab with the neighbor ranks.
+    //!
+    //! All the ranks must call this function together. The last layer of the
+    //! previous rank is received into \p backGhost, and the first layer of the
+    //! next rank into \p frontGhost. A ghost layer without a neighbor rank is
+    //! filled with T().
+    //!
+    //! \param[in]  local      The array of the slab owned by this rank.
+    //! \param[out] backGhost  The layer below the slab.
+    //! \param[out] frontGhost The layer above the slab.
+    //!
+    template <typename T>
+    void exchangeGhostLayers(
+        const Array3<T>& local,
+        Array2<T>* backGhost,
+        Array2<T>* frontGhost) const;
+
+ private:
+    Size3 _globalSize;
+    CommunicatorPtr _communicator;
+    size_t _zBegin = 0;
+    size_t _zEnd = 0;
+};
+
+//! Shared pointer for the SlabDecomposition3 type.
+typedef std::shared_ptr<SlabDecomposition3> SlabDecomposition3Ptr;
+
+}  // namespace jet
+
+#include "detail/slab_decomposition3-inl.h"
+
+#endif  // INCLUDE_JET_SLAB_DECOMPOSITION3_H_
@@ -0,0 +1,147 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SPARSE_ARRAY3_H_
+#define INCLUDE_JET_SPARSE_ARRAY3_H_
+
+#include <jet/array3.h>
+#include <jet/size3.h>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D sparse array class.
+//!
+//! This class represents a 3-D array that only stores the regions that are
+//! written. The index space is divided into bricks of 8 x 8 x 8 elements,
+//! and a brick is allocated when one of its elements is accessed for writing.
+//! Reading an element of an unallocated brick returns the background value.
+//! The occupancy of the bricks is kept in a dense table with an entry per
+//! brick, which is 1/512 of the dense array, so thin features such as a
+//! liquid sheet or a smoke plume only take the memory of the bricks they
+//! touch.
+//!
+//! Allocating a brick may move the stored elements, so the references
+//! returned by the non-const accessors are invalidated by the next call that
+//! allocates a brick, similar to std::vector.
+//!
+//! \tparam T - Type to store in the array.
+//!
+template <typename T>
+class SparseArray3 final {
+ public:
+    //! Number of elements of a brick along each axis.
+    static const size_t kBrickSize = 8;
+
+    //! Constructs zero-sized 3-D sparse array.
+    SparseArray3();
+
+    //! Constructs 3-D sparse array with given \p size and \p backgroundValue.
+    explicit SparseArray3(const Size3& size, const T& backgroundValue = T());
+
+    //! Constructs 3-D sparse array with size \p width x \p height x \p depth
+    //! and \p backgroundValue.
+    SparseArray3(
+        size_t width,
+        size_t height,
+        size_t depth,
+        const T& backgroundValue = T());
+
+    //! Resizes the array, which removes all the bricks.
+    void resize(const Size3& size, const T& backgroundValue = T());
+
+    //! Resizes the array, which removes all the bricks.
+    void resize(
+        size_t width,
+        size_t height,
+        size_t depth,
+        const T& backgroundValue = T());
+
+    //! Removes all the bricks so that every element is the background value.
+    void clear();
+
+    //!
+    //! \brief Copies the elements of the dense array.
+    //!
+    //! The array is resized to the size of \p dense, and only the bricks that
+    //! have an element different from the background value are allocated.
+    //!
+    void set(const ConstArrayAccessor3<T>& dense, const T& backgroundValue);
+
+    //! Copies all the elements, including the background, to \p dense.
+    void copyTo(Array3<T>* dense) const;
+
+    //! Returns the size of the array.
+    Size3 size() const;
+
+    //! Returns the width of the array.
+    size_t width() const;
+
+    //! Returns the height of the array.
+    size_t height() const;
+
+    //! Returns the depth of the array.
+    size_t depth() const;
+
+    //! Returns the value of the elements that are not stored.
+    const T& backgroundValue() const;
+
+    //! Returns the number of the allocated bricks.
+    size_t numberOfBricks() const;
+
+    //! Returns true if the brick that contains (i, j, k) is allocated.
+    bool isAllocated(size_t i, size_t j, size_t k) const;
+
+    //! Returns the (i, j, k) element, or the background value if it is not
+    //! stored.
+    const T& operator()(size_t i, size_t j, size_t k) const;
+
+    //! Returns the reference to the (i, j, k) element, allocating the brick
+    //! that contains it if needed. Allocation is not thread-safe.
+    T& operator()(size_t i, size_t j, size_t k);
+
+    //!
+    //! \brief Iterates the indices of the allocated bricks.
+    //!
+    //! The callback takes (i, j, k) of every element within the array that
+    //! belongs to an allocated brick, brick by brick. The order of the bricks
+    //! is the order of allocation.
+    //!
+    template <typename Callback>
+    void forEachAllocatedIndex(Callback func) const;
+
+    //!
+    //! \brief Iterates the indices of the allocated bricks in parallel.
+    //!
+    //! Same as forEachAllocatedIndex, but the bricks are distributed over the
+    //! threads. Writing to the elements of the allocated bricks from the
+    //! callback does not allocate, so it is safe.
+    //!
+    template <typename Callback>
+    void parallelForEachAllocatedIndex(Callback func) const;
+
+    //! Removes the bricks whose elements are all equal to the background.
+    void prune();
+
+ private:
+    static const size_t kBrickVolume = kBrickSize * kBrickSize * kBrickSize;
+
+    Size3 _size;
+    T _backgroundValue = T();
+    Array3<size_t> _brickIndices;
+    std::vector<Size3> _brickOrigins;
+    std::vector<T> _data;
+
+    size_t allocateBrick(size_t bi, size_t bj, size_t bk);
+
+    template <typename Callback>
+    void forEachIndexInBrick(size_t brick, Callback func) const;
+
+    static size_t localIndex(size_t i, size_t j, size_t k);
+};
+
+}  // namespace jet
+
+#include "detail/sparse_array3-inl.h"
+
+#endif  // INCLUDE_JET_SPARSE_ARRAY3_H_
@@ -0,0 +1,111 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SPARSE_VOLUME3_H_
+#define INCLUDE_JET_SPARSE_VOLUME3_H_
+
+#include <jet/scalar_grid3.h>
+#include <jet/size3.h>
+#include <jet/vector3.h>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Writes a scalar grid as a cropped volume of half floats.
+//!
+//! The writer crops the grid data to the bounding box of the values whose
+//! magnitude is above the threshold, quantizes them to half floats, and
+//! writes it in one of two formats:
+//!
+//! - writeSparse splits the cropped box into cubic tiles and stores only the
+//!   tiles with a value above the threshold. The file starts with the tag
+//!   "JETSVOL1", the tile size, the grid resolution, spacing, origin and data
+//!   size, the crop box in data indices, and the number of tiles. Each tile
+//!   follows with its uint32 tile index and its values, clipped to the crop
+//!   box, in i-first order. All values are in the byte order of the host.
+//!   readSparseVolume reads it back.
+//! - writeMitsuba writes the cropped box as a dense float16 gridvolume of
+//!   Mitsuba 0.5, whose bounding box is set to the cropped region.
+//!
+//! Both stream the data from the grid a tile or a z-slice at a time, so no
+//! copy of the whole grid is made. The grid must not change while writing.
+//!
+class SparseVolumeWriter3 {
+ public:
+    //! Function applied to each value at (i, j, k) before the quantization.
+    typedef std::function<double(size_t, size_t, size_t, double)> Filter;
+
+    //! Constructs a writer of the given grid.
+    explicit SparseVolumeWriter3(const ScalarGrid3& grid);
+
+    //! Returns the threshold at or below which a magnitude is empty.
+    double threshold() const;
+
+    //! Sets the threshold at or below which a magnitude is empty.
+    void setThreshold(double newThreshold);
+
+    //! Returns the edge length of the tiles in data points.
+    size_t tileSize() const;
+
+    //! Sets the edge length of the tiles in data points (default is 8).
+    void setTileSize(size_t newTileSize);
+
+    //! Sets the function applied to each value before the quantization.
+    void setFilter(const Filter& newFilter);
+
+    //!
+    //! \brief Finds the crop box and the non-empty tiles.
+    //!
+    //! The write functions call it, and the following accessors return its
+    //! results. Call it again if the grid or the parameters change.
+    //!
+    void update();
+
+    //! Returns the first data index of the crop box.
+    Size3 cropBegin() const;
+
+    //! Returns the data index past the end of the crop box.
+    Size3 cropEnd() const;
+
+    //! Returns the number of the non-empty tiles.
+    size_t numberOfActiveTiles() const;
+
+    //! Writes the grid in the sparse tile format to \p strm.
+    void writeSparse(std::ostream* strm);
+
+    //! Writes the grid as a cropped Mitsuba float16 gridvolume to \p strm.
+    void writeMitsuba(std::ostream* strm);
+
+ private:
+    const ScalarGrid3& _grid;
+    double _threshold = 0.0;
+    size_t _tileSize = 8;
+    Filter _filter;
+    Size3 _cropBegin;
+    Size3 _cropEnd;
+    Size3 _numberOfTiles;
+    std::vector<char> _isTileActive;
+
+    float valueAt(size_t i, size_t j, size_t k) const;
+};
+
+//!
+//! \brief Reads the volume written by SparseVolumeWriter3::writeSparse.
+//!
+//! The grid is resized to the stored resolution, grid spacing, and origin, and
+//! the values outside the stored tiles are set to zero.
+//!
+//! \param[in]  strm The input stream.
+//! \param[out] grid The grid of the same type as the written one.
+//!
+//! \return False if the stream is not a valid volume or the data size does
+//!         not match the grid type.
+//!
+bool readSparseVolume(std::istream* strm, ScalarGrid3* grid);
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_SPARSE_VOLUME3_H_
@@ -0,0 +1,102 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SPH_BOUNDARY_PARTICLES3_H_
+#define INCLUDE_JET_SPH_BOUNDARY_PARTICLES3_H_
+
+#include <jet/array1.h>
+#include <jet/bounding_box3.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
+#include <jet/sph_kernels3.h>
+#include <jet/surface3.h>
+#include <memory>
+
+namespace jet {
+
+//!
+//! \brief Static particles sampled on solid surfaces for SPH solvers.
+//!
+//! This class samples the surfaces of the solids once and lets the fluid
+//! particles near a wall see the wall as the neighbors that they miss, as
+//! described in Akinci et al., "Versatile rigid-fluid coupling for
+//! incompressible SPH" (SIGGRAPH 2012). Each boundary particle b has the
+//! volume V_b = 1 / sum_k W(x_b - x_k) over the boundary particles, which
+//! corrects the non-uniform sampling. A fluid particle i then gets the
+//! density rho0 * sum_b V_b W(x_i - x_b) from the boundary and the pressure
+//! force -m rho0 p_i / rho_i^2 sum_b V_b grad W(x_i - x_b), so it is not
+//! under-dense near the walls and is pushed back before it penetrates.
+//!
+//! The particles and their hash grid are built by build() and never change,
+//! so they are meant for the static solids. The kernel radius must be the
+//! one of the fluid particles.
+//!
+class SphBoundaryParticles3 final {
+ public:
+    //! Constructs an empty set of boundary particles.
+    SphBoundaryParticles3();
+
+    //!
+    //! \brief Samples \p surface within \p domain.
+    //!
+    //! The points of a regular grid of \p spacing within \p spacing from the
+    //! surface are projected onto the surface, and the projected points that
+    //! are closer than half of \p spacing to the previous ones are dropped.
+    //! The spacing is usually the target spacing of the fluid particles.
+    //!
+    void build(
+        const Surface3& surface,
+        const BoundingBox3D& domain,
+        double spacing,
+        double kernelRadius);
+
+    //!
+    //! \brief Sets the boundary particles to the given points.
+    //!
+    //! The volumes of the particles are computed from the points, and the
+    //! hash grid is built.
+    //!
+    void build(
+        const ConstArrayAccessor1<Vector3D>& points,
+        double kernelRadius);
+
+    //! Returns the number of the boundary particles.
+    size_t numberOfParticles() const;
+
+    //! Returns the kernel radius.
+    double kernelRadius() const;
+
+    //! Returns the positions of the boundary particles.
+    ConstArrayAccessor1<Vector3D> positions() const;
+
+    //! Returns the volumes of the boundary particles.
+    ConstArrayAccessor1<double> volumes() const;
+
+    //!
+    //! \brief Returns sum_b V_b W(origin - x_b) with the standard kernel.
+    //!
+    //! The density of a fluid particle from the boundary is the target
+    //! density times this sum.
+    //!
+    double sumOfKernelNearby(const Vector3D& origin) const;
+
+    //!
+    //! \brief Returns sum_b V_b grad W(origin - x_b) with the spiky kernel.
+    //!
+    //! The gradient is taken with respect to \p origin, so it points toward
+    //! the boundary.
+    //!
+    Vector3D sumOfGradientNearby(const Vector3D& origin) const;
+
+ private:
+    double _kernelRadius = 0.0;
+    SphStdKernel3 _stdKernel;
+    SphSpikyKernel3 _spikyKernel;
+    Array1<Vector3D> _positions;
+    Array1<double> _volumes;
+    std::unique_ptr<PointParallelHashGridSearcher3> _searcher;
+};
+
+typedef std::shared_ptr<SphBoundaryParticles3> SphBoundaryParticles3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_SPH_BOUNDARY_PARTICLES3_H_
@@ -0,0 +1,80 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SPH_CUDA_SOLVER3_H_
+#define INCLUDE_JET_SPH_CUDA_SOLVER3_H_
+
+#include <jet/sph_solver3.h>
+#include <memory>
+
+namespace jet {
+
+namespace internal {
+
+class CudaSphState;
+
+struct CudaSphStateDeleter final {
+    void operator()(CudaSphState* state) const;
+};
+
+}  // namespace internal
+
+//!
+//! \brief 3-D SPH solver which runs the particle interactions on a CUDA
+//!        device.
+//!
+//! When the library is built with JET_USE_CUDA and a CUDA device is present,
+//! the neighbor search, the densities, and the pressure, viscosity, and pseudo
+//! viscosity terms are computed on the device. The neighbor search uses a
+//! counting-sort hash grid with the same buckets as
+//! PointParallelHashGridSearcher3. The time integration, the collisions, and
+//! the emitters stay on the host, so the positions and the velocities are
+//! uploaded, and the densities, the pressures, and the forces are downloaded
+//! once per sub-time-step; the device buffers persist across the steps.
+//! Otherwise, the solver behaves exactly like SphSolver3.
+//!
+//! In the device mode, the host neighbor searcher and lists are not built,
+//! and the symmetric pair forces do not apply.
+//!
+class SphCudaSolver3 final : public SphSolver3 {
+ public:
+    //! Constructs a solver with empty particle set.
+    SphCudaSolver3();
+
+    //! Destructor.
+    virtual ~SphCudaSolver3();
+
+    //! Returns true if the solver runs on a CUDA device.
+    bool isUsingDevice() const;
+
+    //! Returns true if the library is built with CUDA and a device is found.
+    static bool isDeviceAvailable();
+
+ protected:
+    //! Collects the statistics of the last sub-time-step.
+    void collectStatistics(SubTimeStepStatistics* stats) const override;
+
+    //! Performs pre-processing step before the simulation.
+    void onBeginAdvanceTimeStep(double timeStepInSeconds) override;
+
+    //! Accumulates the non-pressure forces to the forces array in the particle
+    //! system.
+    void accumulateNonPressureForces(double timeStepInSeconds) override;
+
+    //! Accumulates the pressure force to the forces array in the particle
+    //! system.
+    void accumulatePressureForce(double timeStepInSeconds) override;
+
+    //! Computes pseudo viscosity.
+    void computePseudoViscosity(double timeStepInSeconds) override;
+
+ private:
+    std::unique_ptr<internal::CudaSphState, internal::CudaSphStateDeleter>
+        _device;
+};
+
+//! Shared pointer type for the SphCudaSolver3.
+typedef std::shared_ptr<SphCudaSolver3> SphCudaSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_SPH_CUDA_SOLVER3_H_
@@ -0,0 +1,70 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_SPH_KERNEL_TABLE3_H_
+#define INCLUDE_JET_SPH_KERNEL_TABLE3_H_
+
+#include <jet/sph_kernels3.h>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Lookup table of a 3-D SPH kernel on the squared distance.
+//!
+//! This class samples the value and the gradient scale of a kernel at evenly
+//! spaced squared distances from 0 to h^2 and interpolates them linearly, so
+//! a kernel evaluation takes neither sqrt nor the polynomial of the kernel.
+//! The gradient toward a neighbor at an offset is gradientScale() times the
+//! offset, as the batch kernel helpers of the SPH solvers define it.
+//!
+//! Since the interpolation is linear in the squared distance, the table is
+//! exact for the standard kernel up to the rounding and accurate for the
+//! kernels that are smooth in the squared distance, such as the cubic spline
+//! and the Wendland kernels. The gradient scale of the spiky kernel diverges
+//! at the center, where the table is not accurate.
+//!
+//! \tparam KernelType - Kernel function object such as SphStdKernel3, which
+//!                      provides h, operator() and firstDerivative.
+//!
+template <typename KernelType>
+class SphKernelTable3 final {
+ public:
+    //! Default number of the intervals of the table.
+    static const size_t kDefaultResolution = 1024;
+
+    //! Constructs an empty table, which returns zeros.
+    SphKernelTable3();
+
+    //! Constructs a table of \p kernel with \p resolution intervals.
+    explicit SphKernelTable3(
+        const KernelType& kernel,
+        size_t resolution = kDefaultResolution);
+
+    //! Returns the kernel.
+    const KernelType& kernel() const;
+
+    //! Returns the number of the intervals of the table.
+    size_t resolution() const;
+
+    //! Returns the kernel value of the squared distance.
+    double operator()(double distanceSquared) const;
+
+    //! Returns -firstDerivative(r) / r of the squared distance r^2.
+    double gradientScale(double distanceSquared) const;
+
+ private:
+    KernelType _kernel;
+    double _h2 = 0.0;
+    double _invIntervalSize = 0.0;
+    std::vector<double> _values;
+    std::vector<double> _gradientScales;
+
+    double lookUp(
+        const std::vector<double>& table, double distanceSquared) const;
+};
+
+}  // namespace jet
+
+#include "detail/sph_kernel_table3-inl.h"
+
+#endif  // INCLUDE_JET_SPH_KERNEL_TABLE3_H_
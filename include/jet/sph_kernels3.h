@@ -16,9 +16,21 @@ namespace jet {
 //!
 //! \brief Standard 3-D SPH kernel function object.
 //!
+//! The normalization factors and the reciprocals of the radius are computed
+//! once by the constructor, so evaluating the kernel takes no divisions.
+//!
 struct SphStdKernel3 {
     double h, h2, h3, h5;
 
+    //! 1 / h^2.
+    double invH2;
+
+    //! 315 / (64 pi h^3).
+    double valueFactor;
+
+    //! 945 / (32 pi h^5).
+    double derivativeFactor;
+
     SphStdKernel3();
 
     explicit SphStdKernel3(double kernelRadius);
@@ -27,6 +39,9 @@ struct SphStdKernel3 {
 
     double operator()(double distance) const;
 
+    //! Returns the kernel value of the squared distance without sqrt.
+    double valueFromSquaredDistance(double distanceSquared) const;
+
     double firstDerivative(double distance) const;
 
     Vector3D gradient(double distance, const Vector3D& direction) const;
@@ -37,9 +52,24 @@ struct SphStdKernel3 {
 //!
 //! \brief Spiky 3-D SPH kernel function object.
 //!
+//! The normalization factors and the reciprocal of the radius are computed
+//! once by the constructor, so evaluating the kernel takes no divisions.
+//!
 struct SphSpikyKernel3 {
     double h, h2, h3, h4, h5;
 
+    //! 1 / h.
+    double invH;
+
+    //! 15 / (pi h^3).
+    double valueFactor;
+
+    //! 45 / (pi h^4).
+    double firstDerivativeFactor;
+
+    //! 90 / (pi h^5).
+    double secondDerivativeFactor;
+
     SphSpikyKernel3();
 
     explicit SphSpikyKernel3(double kernelRadius);
@@ -55,6 +85,62 @@ struct SphSpikyKernel3 {
     double secondDerivative(double distance) const;
 };
 
+//!
+//! \brief Cubic spline 3-D SPH kernel function object.
+//!
+//! This is the M4 cubic B-spline kernel of Monaghan scaled to the support
+//! radius h, which is smoother than the spiky kernel near the center.
+//!
+struct SphCubicSplineKernel3 {
+    double h;
+
+    //! 1 / h.
+    double invH;
+
+    //! 8 / (pi h^3).
+    double valueFactor;
+
+    SphCubicSplineKernel3();
+
+    explicit SphCubicSplineKernel3(double kernelRadius);
+
+    double operator()(double distance) const;
+
+    double firstDerivative(double distance) const;
+
+    Vector3D gradient(double distance, const Vector3D& direction) const;
+
+    double secondDerivative(double distance) const;
+};
+
+//!
+//! \brief Wendland C2 3-D SPH kernel function object.
+//!
+//! The Wendland kernel has a positive Fourier transform, which avoids the
+//! pairing instability of the spline kernels with many neighbors.
+//!
+struct SphWendlandKernel3 {
+    double h;
+
+    //! 1 / h.
+    double invH;
+
+    //! 21 / (2 pi h^3).
+    double valueFactor;
+
+    SphWendlandKernel3();
+
+    explicit SphWendlandKernel3(double kernelRadius);
+
+    double operator()(double distance) const;
+
+    double firstDerivative(double distance) const;
+
+    Vector3D gradient(double distance, const Vector3D& direction) const;
+
+    double secondDerivative(double distance) const;
+};
+
 }  // namespace jet
 
 #include "detail/sph_kernels3-inl.h"
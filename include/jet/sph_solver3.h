@@ -5,10 +5,15 @@
 
 #include <jet/constants.h>
 #include <jet/particle_system_solver3.h>
+#include <jet/sph_boundary_particles3.h>
 #include <jet/sph_system_data3.h>
 
+#include <memory>
+
 namespace jet {
 
+class SphHalfNeighborLists3;
+
 //!
 //! \brief 3-D SPH solver.
 //!
@@ -101,9 +106,81 @@ class SphSolver3 : public ParticleSystemSolver3 {
     //!
     void setTimeStepLimitScale(double newScale);
 
+    //! Returns true if the pair forces are evaluated once per pair.
+    bool isUsingSymmetricPairForces() const;
+
+    //!
+    //! \brief Sets true to evaluate the pair forces once per pair.
+    //!
+    //! When enabled, the solver builds half neighbor lists which hold each
+    //! pair of neighbors only once, and the pressure and viscosity forces
+    //! (and the predicted densities of PciSphSolver3) evaluate the kernel
+    //! once per pair and apply the result to both particles. The particles
+    //! are visited in two colors of slabs so that no two threads update the
+    //! same particle. The results are the same up to the summation order.
+    //! The slab traversal works best when the particles are sorted in memory
+    //! (see setParticleSortingInterval). Default is false.
+    //!
+    void setIsUsingSymmetricPairForces(bool isUsing);
+
+    //! Returns true if the kernel values of the pairs are cached.
+    bool isCachingPairKernels() const;
+
+    //!
+    //! \brief Sets true to cache the kernel values of the pairs.
+    //!
+    //! When enabled with the symmetric pair forces, the offsets and the
+    //! kernel values of the pairs are evaluated once after the half neighbor
+    //! lists are built. The densities, and the pressure and viscosity forces
+    //! at the same positions read them instead of gathering the neighbors and
+    //! evaluating the kernels again, which PciSphSolver3 does once per
+    //! iteration for the pressure force. The pairs take 48 bytes each. The
+    //! densities are summed over the pairs, so they are the same as those of
+    //! SphSystemData3::updateDensities up to the summation order. Default is
+    //! false.
+    //!
+    void setIsCachingPairKernels(bool isCaching);
+
+    //! Returns the boundary particles, or nullptr if not set.
+    const SphBoundaryParticles3Ptr& boundaryParticles() const;
+
+    //!
+    //! \brief Sets the boundary particles of the static solids.
+    //!
+    //! The boundary particles are added to the density and the pressure
+    //! force sums of the fluid particles near the solids, in addition to the
+    //! collision handling of the colliders. Their kernel radius should be the
+    //! one of the SPH system data. Default is nullptr.
+    //!
+    void setBoundaryParticles(const SphBoundaryParticles3Ptr& newBoundary);
+
+    //! Returns the preview scale of the particle spacing.
+    double previewScale() const;
+
+    //!
+    //! \brief Scales the particle spacing by \p factor for a quick preview.
+    //!
+    //! This function scales the target spacing of the SPH system data by the
+    //! ratio of \p factor to the current scale, which scales the kernel
+    //! radius and the particle mass with it, and rebuilds the boundary
+    //! particles for the new kernel radius. The time-step limit follows the
+    //! kernel radius, so the preview also takes fewer sub-time-steps. The
+    //! particles already in the system are not resampled, so it should be
+    //! called before the particles are emitted, with the emitters scaled by
+    //! ParticleEmitter3::setPreviewScale. The factor should be equal to or
+    //! greater than 1, and 1 restores the full spacing.
+    //!
+    void setPreviewScale(double factor);
+
     //! Returns the SPH system data.
     SphSystemData3Ptr sphSystemData() const;
 
+    //! Writes a checkpoint of the SPH parameters and particles to \p strm.
+    void serialize(std::ostream* strm) const override;
+
+    //! Restores the SPH parameters and particles from \p strm.
+    void deserialize(std::istream* strm) override;
+
  protected:
     //! Returns the number of sub-time-steps.
     unsigned int numberOfSubTimeSteps(
@@ -112,6 +189,9 @@ class SphSolver3 : public ParticleSystemSolver3 {
     //! Accumulates the force to the forces array in the particle system.
     void accumulateForces(double timeStepInSeconds) override;
 
+    //! Returns true since the SPH forces are added to the external forces.
+    bool hasCustomForces() const override;
+
     //! Performs pre-processing step before the simulation.
     void onBeginAdvanceTimeStep(double timeStepInSeconds) override;
 
@@ -141,9 +221,27 @@ class SphSolver3 : public ParticleSystemSolver3 {
     void accumulateViscosityForce();
 
     //! Computes pseudo viscosity.
-    void computePseudoViscosity(double timeStepInSeconds);
+    virtual void computePseudoViscosity(double timeStepInSeconds);
+
+    //! Adds the densities from the boundary particles, if any.
+    void accumulateBoundaryDensities(
+        const ConstArrayAccessor1<Vector3D>& positions,
+        ArrayAccessor1<double> densities);
+
+    //! Accumulates the pressure forces from the boundary particles, if any.
+    void accumulateBoundaryPressureForce(
+        const ConstArrayAccessor1<Vector3D>& positions,
+        const ConstArrayAccessor1<double>& densities,
+        const ConstArrayAccessor1<double>& pressures,
+        ArrayAccessor1<Vector3D> pressureForces);
+
+    //! Returns the half neighbor lists of the current time-step, or nullptr
+    //! if the symmetric pair forces are not used.
+    const SphHalfNeighborLists3* halfNeighborLists() const;
 
  private:
+    void updateDensitiesFromPairCache();
+
     //! Exponent component of equation-of-state (or Tait's equation).
     double _eosExponent = 7.0;
 
@@ -166,6 +264,14 @@ class SphSolver3 : public ParticleSystemSolver3 {
 
     //! Scales the max allowed time-step.
     double _timeStepLimitScale = 1.0;
+
+    bool _isUsingSymmetricPairForces = false;
+    bool _isCachingPairKernels = false;
+    std::unique_ptr<SphHalfNeighborLists3> _halfNeighborLists;
+
+    SphBoundaryParticles3Ptr _boundaryParticles;
+
+    double _previewScale = 1.0;
 };
 
 }  // namespace jet
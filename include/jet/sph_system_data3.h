@@ -91,6 +91,10 @@ class SphSystemData3 : public ParticleSystemData3 {
 
     void buildNeighborLists();
 
+    void serialize(std::ostream* strm) const override;
+
+    void deserialize(std::istream* strm) override;
+
  private:
     //! Mass of a particle in kilograms (kg).
     //! Mass is determined by the target density and spacing.
@@ -109,6 +113,12 @@ class SphSystemData3 : public ParticleSystemData3 {
     //! SPH kernel radius in meters.
     double _kernelRadius;
 
+    //! Max number density of the particle lattice, cached for the target
+    //! spacing and kernel radius it was computed with.
+    double _maxNumberDensity = 0.0;
+    double _maxNumberDensitySpacing = 0.0;
+    double _maxNumberDensityKernelRadius = 0.0;
+
     size_t _pressureDataId;
 
     size_t _densityDataId;
@@ -55,6 +55,12 @@ class Sphere3 final : public Surface3 {
     //! SurfaceRayIntersection3 instance and modify its contents.
     SurfaceRayIntersection3 actualClosestIntersection(
         const Ray3D& ray) const override;
+
+    //! Computes the distances to the sphere in closed form with vectorized
+    //! kernels.
+    void actualBatchClosestSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
 };
 
 typedef std::shared_ptr<Sphere3> Sphere3Ptr;
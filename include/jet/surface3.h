@@ -3,6 +3,7 @@
 #ifndef INCLUDE_JET_SURFACE3_H_
 #define INCLUDE_JET_SURFACE3_H_
 
+#include <jet/array_accessor1.h>
 #include <jet/bounding_box3.h>
 #include <jet/constants.h>
 #include <jet/ray3.h>
@@ -54,6 +55,56 @@ class Surface3 {
     //! point \p otherPoint.
     Vector3D closestNormal(const Vector3D& otherPoint) const;
 
+    //!
+    //! \brief Computes the closest points on the surface from \p otherPoints
+    //!        into \p result.
+    //!
+    //! The batch queries give the same results as the single queries for each
+    //! element, but they are meant for the callers that have many queries at
+    //! once, such as the rasterization of a collider into a grid. \p result
+    //! should be at least as large as the input. The default implementations
+    //! call the single queries in parallel, and the surfaces with a
+    //! hierarchy, such as TriangleMesh3, traverse it once for a packet of
+    //! neighboring queries. The queries are more coherent, and thus faster,
+    //! if the neighboring elements are close to each other, such as the grid
+    //! points in the order of the grid.
+    //!
+    virtual void batchClosestPoint(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const;
+
+    //! Computes the closest distances from \p otherPoints to the surface into
+    //! \p result. \see Surface3::batchClosestPoint
+    virtual void batchClosestDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const;
+
+    //! Computes the normals to the closest points on the surface from
+    //! \p otherPoints into \p result. \see Surface3::batchClosestPoint
+    void batchClosestNormal(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const;
+
+    //! Computes the closest intersections of \p rays into \p result.
+    //! \see Surface3::batchClosestPoint
+    void batchClosestIntersection(
+        const ConstArrayAccessor1<Ray3D>& rays,
+        ArrayAccessor1<SurfaceRayIntersection3> result) const;
+
+    //!
+    //! \brief Computes the closest distances from \p otherPoints to the
+    //!        surface into \p result, negative for the points behind the
+    //!        closest normals.
+    //!
+    //! This is the signed distance of SurfaceToImplicit3. The analytic
+    //! surfaces, such as Sphere3 and Box3, evaluate it in closed form with
+    //! vectorized kernels, which agree with the closest point and normal
+    //! queries up to round-off. \see Surface3::batchClosestPoint
+    //!
+    void batchClosestSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const;
+
  protected:
     //!
     //! \brief Returns the closest surface normal from the given point
@@ -80,6 +131,26 @@ class Surface3 {
     //!
     virtual SurfaceRayIntersection3 actualClosestIntersection(
         const Ray3D& ray) const = 0;
+
+    //! Computes the "actual" normals of Surface3::batchClosestNormal, which
+    //! are not flipped regardless how Surface3::isNormalFlipped is set.
+    virtual void actualBatchClosestNormal(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const;
+
+    //! Computes the "actual" intersections of
+    //! Surface3::batchClosestIntersection, whose normals are not flipped
+    //! regardless how Surface3::isNormalFlipped is set.
+    virtual void actualBatchClosestIntersection(
+        const ConstArrayAccessor1<Ray3D>& rays,
+        ArrayAccessor1<SurfaceRayIntersection3> result) const;
+
+    //! Computes the "actual" signed distances of
+    //! Surface3::batchClosestSignedDistance, which are signed by the normals
+    //! that are not flipped regardless how Surface3::isNormalFlipped is set.
+    virtual void actualBatchClosestSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const;
 };
 
 typedef std::shared_ptr<Surface3> Surface3Ptr;
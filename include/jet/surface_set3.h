@@ -3,7 +3,10 @@
 #ifndef INCLUDE_JET_SURFACE_SET3_H_
 #define INCLUDE_JET_SURFACE_SET3_H_
 
+#include <jet/bvh3.h>
 #include <jet/surface3.h>
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 namespace jet {
@@ -15,6 +18,10 @@ namespace jet {
 //! surface-related quries. This is class can hold a collection of other surface
 //! instances.
 //!
+//! The queries are accelerated by a bounding volume hierarchy over the bounding
+//! boxes of the surfaces, which is built at the first query after a surface is
+//! added. If a surface is moved after being added, call invalidateBvh().
+//!
 class SurfaceSet3 final : public Surface3 {
  public:
     //! Constructs an empty surface set.
@@ -32,6 +39,18 @@ class SurfaceSet3 final : public Surface3 {
     //! Adds a surface instance.
     void addSurface(const Surface3Ptr& surface);
 
+    //! Marks the BVH to be rebuilt at the next query.
+    void invalidateBvh();
+
+    //!
+    //! \brief Returns the index of the surface closest to \p otherPoint.
+    //!
+    //! Ties go to the lower index, and kMaxSize is returned if there is no
+    //! surface. Only the surfaces whose bounding boxes can be the closest are
+    //! evaluated.
+    //!
+    size_t closestSurfaceIndex(const Vector3D& otherPoint) const;
+
     // Surface3 implementations
 
     //! Returns the closest point from the given point \p otherPoint to the
@@ -56,6 +75,12 @@ class SurfaceSet3 final : public Surface3 {
 
  private:
     std::vector<Surface3Ptr> _surfaces;
+
+    mutable Bvh3 _bvh;
+    mutable std::atomic<bool> _isBvhValid{false};
+    mutable std::mutex _bvhMutex;
+
+    void buildBvh() const;
 };
 
 typedef std::shared_ptr<SurfaceSet3> SurfaceSet3Ptr;
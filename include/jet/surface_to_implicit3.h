@@ -41,17 +41,40 @@ class SurfaceToImplicit3 final : public ImplicitSurface3 {
     //! Returns the bounding box of this box object.
     BoundingBox3D boundingBox() const override;
 
+    //! Computes the closest points with the batch query of the surface.
+    void batchClosestPoint(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const override;
+
+    //! Computes the closest distances with the batch query of the surface.
+    void batchClosestDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
+
     // ImplicitSurface3 implementations
 
     //! Returns signed distance from the given point \p otherPoint.
     double signedDistance(const Vector3D& otherPoint) const override;
 
+    //! Computes the signed distances with the batch query of the surface.
+    void batchSignedDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
+
  protected:
     Vector3D actualClosestNormal(const Vector3D& otherPoint) const override;
 
     SurfaceRayIntersection3 actualClosestIntersection(
         const Ray3D& ray) const override;
 
+    void actualBatchClosestNormal(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const override;
+
+    void actualBatchClosestIntersection(
+        const ConstArrayAccessor1<Ray3D>& rays,
+        ArrayAccessor1<SurfaceRayIntersection3> result) const override;
+
  private:
     Surface3Ptr _surface;
 };
@@ -4,12 +4,18 @@
 #define INCLUDE_JET_TRIANGLE_MESH3_H_
 
 #include <jet/array1.h>
+#include <jet/bvh3.h>
+#include <jet/matrix3x3.h>
 #include <jet/point3.h>
 #include <jet/quaternion.h>
 #include <jet/surface3.h>
 #include <jet/triangle3.h>
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <string>
 #include <utility>  // just make cpplint happy..
+#include <vector>
 
 namespace jet {
 
@@ -20,6 +26,24 @@ namespace jet {
 //! overriding surface-related queries. The mesh structure stores point,
 //! normals, and UV coordinates.
 //!
+//! The closest point, distance, normal, and ray queries are accelerated by a
+//! bounding volume hierarchy (BVH) which is built at the first query after the
+//! triangles change. The functions of this class that modify the mesh keep the
+//! BVH up-to-date, but modifying the points or indices through the non-const
+//! accessors does not. In that case, call refitBvh() if only the points have
+//! moved, or invalidateBvh() if the triangles have changed.
+//!
+//! Along with the BVH, the mesh keeps a copy of the corners and the edges of
+//! the triangles in the order of the BVH leaves, in structure-of-arrays
+//! layout. The closest triangle search evaluates the triangles of a leaf at
+//! once from this copy with the SIMD instruction set of
+//! simdInstructionSet(), instead of building a Triangle3 for every
+//! triangle. The results are the same for all the instruction sets.
+//!
+//! The mesh can also carry a rigid transform, set by setTransform(), which
+//! the queries apply to the query points and rays instead of the mesh. See
+//! setTransform() for the details.
+//!
 class TriangleMesh3 final : public Surface3 {
  public:
     typedef Array1<Vector2D> Vector2DArray;
@@ -32,6 +56,10 @@ class TriangleMesh3 final : public Surface3 {
     //! Copy constructor.
     TriangleMesh3(const TriangleMesh3& other);
 
+    //! Move constructor. Takes over the arrays of \p other, which is left
+    //! empty, and builds the BVH again at the next query.
+    TriangleMesh3(TriangleMesh3&& other) noexcept;
+
     //! Returns the closest point from the given point \p otherPoint to the
     //! surface.
     Vector3D closestPoint(const Vector3D& otherPoint) const override;
@@ -43,6 +71,18 @@ class TriangleMesh3 final : public Surface3 {
     //! Returns true if the given \p ray intersects with this mesh object.
     bool intersects(const Ray3D& ray) const override;
 
+    //! Computes the closest points from \p otherPoints in packets that
+    //! traverse the BVH together. \see Surface3::batchClosestPoint
+    void batchClosestPoint(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const override;
+
+    //! Computes the closest distances from \p otherPoints in packets that
+    //! traverse the BVH together. \see Surface3::batchClosestPoint
+    void batchClosestDistance(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<double> result) const override;
+
     //! Returns the bounding box of this mesh object.
     BoundingBox3D boundingBox() const override;
 
@@ -55,10 +95,10 @@ class TriangleMesh3 final : public Surface3 {
     //! Swaps the contents with \p other mesh.
     void swap(TriangleMesh3& other);
 
-    //! Returns area of this mesh.
+    //! Returns area of this mesh, summed in parallel.
     double area() const;
 
-    //! Returns volume of this mesh.
+    //! Returns volume of this mesh, summed in parallel.
     double volume() const;
 
     //! Returns constant reference to the i-th point.
@@ -155,18 +195,119 @@ class TriangleMesh3 final : public Surface3 {
     //! Sets angle weighted vertex normal.
     void setAngleWeightedVertexNormal();
 
+    //!
+    //! \brief Removes the points whose removal moves the surface by less than
+    //!        \p maxError.
+    //!
+    //! This function simplifies the mesh by collapsing each removable point
+    //! into one of its neighbors. The error of a collapse is measured by the
+    //! quadric error metric of Garland and Heckbert: the sum of the squared
+    //! distances from the remaining point to the planes of the original
+    //! triangles merged into it must stay within the square of \p maxError.
+    //! Collapses that change the topology or turn a triangle by more than 60
+    //! degrees are rejected, and the points on the open boundaries and the
+    //! non-manifold edges are kept, so a closed mesh stays closed.
+    //!
+    //! The collapses are done in rounds. In each round, every point finds its
+    //! cheapest collapse in parallel, and the collapses whose points are the
+    //! cheapest within two rings of neighbors are applied in parallel, since
+    //! they do not touch the same triangles. Since the remaining points do
+    //! not move, the welded meshes of marching cubes keep their vertex
+    //! normals and UVs. Other normals and UVs are removed. For marching
+    //! cubes, a fraction of the grid spacing, such as 0.1 times, removes most
+    //! of the triangles of the flat and smooth regions without a visible
+    //! change.
+    //!
+    void decimate(double maxError);
+
     void scale(double factor);
 
     void translate(const Vector3D& t);
 
     void rotate(const QuaternionD& q);
 
+    //!
+    //! \brief Sets the rigid transform of the mesh without moving the points.
+    //!
+    //! The queries of Surface3 see the points rotated by \p orientation and
+    //! then translated by \p translation. They transform the query points
+    //! and rays into the frame of the points instead, so setting the
+    //! transform costs the same for any mesh size and keeps the BVH valid.
+    //! This suits the rigid colliders which move every frame, which the
+    //! functions above would move by rewriting every point and refitting the
+    //! BVH.
+    //!
+    //! The accessors, triangle(), the writers, and the topology functions,
+    //! such as decimate(), still work on the untransformed points. Call
+    //! bakeTransform() first to give them the transformed points. The area
+    //! and the volume are the same in both frames.
+    //!
+    void setTransform(
+        const Vector3D& translation, const QuaternionD& orientation);
+
+    //! Returns the translation of the rigid transform.
+    const Vector3D& translation() const;
+
+    //! Returns the orientation of the rigid transform.
+    const QuaternionD& orientation() const;
+
+    //! Returns true if the rigid transform is not the identity.
+    bool hasTransform() const;
+
+    //! Applies the rigid transform to the points and the normals, and resets
+    //! it to the identity.
+    void bakeTransform();
+
     void writeObj(std::ostream* strm) const;
 
     bool readObj(std::istream* strm);
 
+    //!
+    //! \brief Reads the OBJ file at \p filename and appends it to this mesh.
+    //!
+    //! This function is a faster alternative to the one above for large files.
+    //! The file is memory-mapped and split into line-aligned chunks, which are
+    //! parsed in parallel. The per-chunk results are then merged into the
+    //! arrays of this mesh at the offsets given by the prefix sums of the
+    //! chunk sizes. Only the vertices, UVs, normals, and faces are read, and
+    //! the polygonal faces are fan-triangulated. Returns false if the file
+    //! cannot be opened or is malformed, in which case this mesh is unchanged.
+    //!
+    bool readObj(const std::string& filename);
+
+    //!
+    //! \brief Writes the mesh in binary PLY format.
+    //!
+    //! The points are written as floats and the triangles as lists of 32-bit
+    //! point indices, in the byte order of the host. The normals are written
+    //! as vertex properties only if they are per-vertex, which means there are
+    //! as many normals as the points and every triangle uses the same normal
+    //! and point indices. UV coordinates are not written.
+    //!
+    void writePly(std::ostream* strm) const;
+
+    //! Writes the mesh in the compact binary format which
+    //! TriangleMeshStreamWriter3 writes.
+    void writeBinary(std::ostream* strm) const;
+
+    //! Reads the mesh written by writeBinary or TriangleMeshStreamWriter3 and
+    //! appends it to this mesh. The chunks are read until the end of the
+    //! stream. Returns false if the stream is not in the format or is
+    //! truncated.
+    bool readBinary(std::istream* strm);
+
     TriangleMesh3& operator=(const TriangleMesh3& other);
 
+    //! Moves the contents from \p other mesh, leaving \p other empty.
+    TriangleMesh3& operator=(TriangleMesh3&& other);
+
+    //! Marks the BVH to be rebuilt at the next query.
+    void invalidateBvh();
+
+    //! Updates the bounding boxes of the BVH to the current points while
+    //! keeping the tree structure.
+    void refitBvh();
+
  protected:
     Vector3D actualClosestNormal(const Vector3D& otherPoint) const override;
 
@@ -178,6 +319,17 @@ class TriangleMesh3 final : public Surface3 {
     SurfaceRayIntersection3 actualClosestIntersection(
         const Ray3D& ray) const override;
 
+    //! Computes the closest normals in packets that traverse the BVH together.
+    void actualBatchClosestNormal(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        ArrayAccessor1<Vector3D> result) const override;
+
+    //! Computes the closest intersections in packets that traverse the BVH
+    //! together.
+    void actualBatchClosestIntersection(
+        const ConstArrayAccessor1<Ray3D>& rays,
+        ArrayAccessor1<SurfaceRayIntersection3> result) const override;
+
  private:
     Vector3DArray _points;
     Vector3DArray _normals;
@@ -185,6 +337,52 @@ class TriangleMesh3 final : public Surface3 {
     IndexArray _pointIndices;
     IndexArray _normalIndices;
     IndexArray _uvIndices;
+
+    Vector3D _translation;
+    QuaternionD _orientation;
+    Matrix3x3D _rotation;
+    Matrix3x3D _inverseRotation;
+    bool _hasTransform = false;
+
+    mutable Bvh3 _bvh;
+    mutable std::atomic<bool> _isBvhValid{false};
+    mutable std::mutex _bvhMutex;
+
+    // Corners, edges, and dot products of the edges of the triangles in the
+    // order of Bvh3::orderedItems(), one stream after another
+    mutable std::vector<double> _triangleCache;
+
+    void buildBvh() const;
+
+    Vector3D toLocal(const Vector3D& pt) const;
+
+    Ray3D toLocal(const Ray3D& ray) const;
+
+    Vector3D toWorld(const Vector3D& pt) const;
+
+    Vector3D toWorldDirection(const Vector3D& dir) const;
+
+    // Returns otherPoints, or their copies in the frame of the points in
+    // buffer if the mesh has a transform
+    ConstArrayAccessor1<Vector3D> toLocal(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        Array1<Vector3D>* buffer) const;
+
+    void refitBvhNodes() const;
+
+    // Fills cache with the triangles in the order of bvh
+    void buildTriangleCache(const Bvh3& bvh, std::vector<double>* cache) const;
+
+    size_t closestTriangle(const Vector3D& otherPoint) const;
+
+    // Calls func(i, triangle) with the closest triangle of each point, which
+    // is kMaxSize if there is none, in parallel packets
+    template <typename Callback>
+    void forEachClosestTriangle(
+        const ConstArrayAccessor1<Vector3D>& otherPoints,
+        const Callback& func) const;
+
+    friend class TriangleMeshStreamWriter3;
 };
 
 typedef std::shared_ptr<TriangleMesh3> TriangleMesh3Ptr;
@@ -0,0 +1,77 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_TRIANGLE_MESH_SDF_CACHE3_H_
+#define INCLUDE_JET_TRIANGLE_MESH_SDF_CACHE3_H_
+
+#include <jet/scalar_grid3.h>
+#include <jet/triangle_mesh3.h>
+#include <cstdint>
+#include <string>
+
+namespace jet {
+
+//!
+//! \brief On-disk cache of the signed-distance fields of triangle meshes.
+//!
+//! Static environment meshes are converted by triangleMeshToSdf again on
+//! every run of a simulation, which can take minutes for large meshes. This
+//! class stores each field generated by bake() in a directory as a grid
+//! cache of GridCacheWriter3, named after a 64-bit key of the points and the
+//! triangles of the mesh, the data layout of the grid, and the parameters of
+//! triangleMeshToSdf. The following runs find the file of the same key,
+//! memory-map it with GridCacheReader3, and copy the field into the grid
+//! instead of generating it. The normals and the UVs of the mesh do not
+//! change the field, so they are not part of the key.
+//!
+//! A file is written under a temporary name and renamed when complete, so
+//! concurrent runs sharing the directory never read a partial file. The
+//! directory is not created, and a cache that cannot be written only costs
+//! the time of the generation.
+//!
+class TriangleMeshSdfCache3 final {
+ public:
+    //! Constructs the cache in the existing directory \p directory.
+    explicit TriangleMeshSdfCache3(const std::string& directory);
+
+    //! Returns the directory of the cache.
+    const std::string& directory() const;
+
+    //!
+    //! \brief Fills \p sdf with the signed-distance field of \p mesh.
+    //!
+    //! Reads the field from the cache if it has the same key, or generates
+    //! it by triangleMeshToSdf with \p exactBand and \p isNarrowBandOnly and
+    //! stores it in the cache otherwise. The grid keeps its resolution,
+    //! grid spacing, and origin.
+    //!
+    //! \return     True if the field was read from the cache.
+    //!
+    bool bake(
+        const TriangleMesh3& mesh,
+        ScalarGrid3* sdf,
+        unsigned int exactBand = 1,
+        bool isNarrowBandOnly = false) const;
+
+    //! Returns the file name of the field of \p key in the cache.
+    std::string filename(uint64_t key) const;
+
+    //!
+    //! \brief Returns the key of the signed-distance field of \p mesh on
+    //!     the grid of the same data layout as \p sdf.
+    //!
+    //! The key hashes the points and the point indices of the triangles
+    //! with FNV-1a, so any change of the mesh produces a different key.
+    //!
+    static uint64_t key(
+        const TriangleMesh3& mesh,
+        const ScalarGrid3& sdf,
+        unsigned int exactBand = 1,
+        bool isNarrowBandOnly = false);
+
+ private:
+    std::string _directory;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_TRIANGLE_MESH_SDF_CACHE3_H_
@@ -0,0 +1,47 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_TRIANGLE_MESH_STREAM_WRITER3_H_
+#define INCLUDE_JET_TRIANGLE_MESH_STREAM_WRITER3_H_
+
+#include <jet/triangle_mesh3.h>
+#include <iostream>
+
+namespace jet {
+
+//!
+//! \brief Writes a triangle mesh chunk by chunk in a compact binary format.
+//!
+//! This class lets a producer such as marchingCubes write a large mesh without
+//! holding all of it in memory. The stream starts with an 8-byte tag
+//! "JETMESH1", which is followed by the chunks. Each chunk starts with a byte
+//! of flags, which is followed by the points, normals, UVs, point indices,
+//! normal indices, and UV indices of a TriangleMesh3, each of which is written
+//! by Array1::serialize. The normal or UV indices are written as an empty
+//! array and flagged if they are the same as the point indices. The indices
+//! of a chunk are relative to the first point (or normal, or UV) of the chunk,
+//! and they may refer to the points of the following chunks. Read the stream
+//! back with TriangleMesh3::readBinary.
+//!
+class TriangleMeshStreamWriter3 {
+ public:
+    //! Writes the tag of the format to \p strm.
+    explicit TriangleMeshStreamWriter3(std::ostream* strm);
+
+    //! Appends \p chunk to the stream.
+    void write(const TriangleMesh3& chunk);
+
+    //! Returns the number of points written so far.
+    size_t numberOfPoints() const;
+
+    //! Returns the number of triangles written so far.
+    size_t numberOfTriangles() const;
+
+ private:
+    std::ostream* _strm;
+    size_t _numberOfPoints = 0;
+    size_t _numberOfTriangles = 0;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_TRIANGLE_MESH_STREAM_WRITER3_H_
@@ -26,15 +26,139 @@
 #ifndef INCLUDE_JET_TRIANGLE_MESH_TO_SDF_H_
 #define INCLUDE_JET_TRIANGLE_MESH_TO_SDF_H_
 
-#include <jet/triangle_mesh3.h>
+#include <jet/array_accessor3.h>
+#include <jet/macros.h>
 #include <jet/scalar_grid3.h>
+#include <jet/size3.h>
+#include <jet/triangle_mesh3.h>
+#include <jet/vector3.h>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
 
 namespace jet {
 
+//!
+//! \brief Generates signed-distance field out of given triangle mesh.
+//!
+//! The distances within \p exactBand cells from the triangles are computed
+//! exactly, and the rest are filled by fast sweeping from the closest
+//! triangles of the neighbors. The signs are determined by the parity of the
+//! ray intersections along the x-axis, so the mesh should be closed. All the
+//! passes run in parallel. The rigid transform of the mesh is applied to a
+//! copy of the mesh first.
+//!
+//! \param mesh The mesh.
+//! \param sdf The output signed-distance field.
+//! \param exactBand The band width in number of cells for the exact distance.
+//! \param isNarrowBandOnly True to skip the sweeping and clamp the output
+//!     to +/- exactBand times the smallest grid spacing. This also avoids
+//!     allocating the closest-triangle buffer for the whole grid.
+//!
 void triangleMeshToSdf(
     const TriangleMesh3& mesh,
     ScalarGrid3* sdf,
-    const unsigned int exactBand = 1);
+    const unsigned int exactBand = 1,
+    bool isNarrowBandOnly = false);
+
+//!
+//! \brief Generates narrow-band signed-distance field of a streamed mesh.
+//!
+//! This class computes the same field as triangleMeshToSdf with
+//! isNarrowBandOnly set, but neither the mesh nor the field has to fit in the
+//! memory. The triangles are added one at a time and binned into the z-slabs
+//! of slabDepth layers that their bands overlap. The bins are spilled to an
+//! anonymous scratch file in chunks, so only the last chunk of each bin stays
+//! in the memory. generate() then loads one slab of triangles at a time,
+//! rasterizes them in parallel, and hands the finished z-layers of the slab
+//! to the callback, which typically appends them to the output file. Since
+//! the signs only depend on the x-rays, which lie in a single z-layer, a slab
+//! needs no data from its neighbors.
+//!
+//! The peak memory is about 12 bytes per grid point of a slab plus the
+//! triangles of that slab. The fast sweeping of the full field is global, so
+//! it is not supported. Throws std::runtime_error if the scratch file cannot
+//! be created, read, or written.
+//!
+class StreamingTriangleMeshToSdf3 final {
+ public:
+    JET_NON_COPYABLE(StreamingTriangleMeshToSdf3)
+
+    //! Callback that receives the z-layers from \p kBegin on, as many as the
+    //! depth of \p slab, of the signed-distance field.
+    typedef std::function<void(
+        size_t kBegin, const ConstArrayAccessor3<double>& slab)> SlabCallback;
+
+    //! Default number of z-layers of a slab.
+    static const size_t kDefaultSlabDepth = 32;
+
+    //!
+    //! \brief Constructs the generator for the grid of given data layout.
+    //!
+    //! \param dataSize The number of the data points, such as
+    //!     ScalarGrid3::dataSize().
+    //! \param gridSpacing The grid spacing.
+    //! \param dataOrigin The position of the first data point, such as
+    //!     ScalarGrid3::dataOrigin().
+    //! \param exactBand The band width in number of cells for the exact
+    //!     distance. The output is clamped to +/- exactBand times the
+    //!     smallest grid spacing.
+    //! \param slabDepth The number of z-layers processed at a time.
+    //!
+    StreamingTriangleMeshToSdf3(
+        const Size3& dataSize,
+        const Vector3D& gridSpacing,
+        const Vector3D& dataOrigin,
+        unsigned int exactBand = 1,
+        size_t slabDepth = kDefaultSlabDepth);
+
+    //! Releases the bins and removes the scratch file.
+    ~StreamingTriangleMeshToSdf3();
+
+    //! Adds the triangle (\p point0, \p point1, \p point2) to the bins.
+    void addTriangle(
+        const Vector3D& point0,
+        const Vector3D& point1,
+        const Vector3D& point2);
+
+    //! Returns the number of the triangles added so far.
+    size_t numberOfTriangles() const;
+
+    //!
+    //! \brief Generates the field slab by slab.
+    //!
+    //! The slabs are passed to \p callback in the order of z, and each of
+    //! them is valid only during the call. The bins are kept, so the field
+    //! can be generated again, with more triangles added in between.
+    //!
+    void generate(const SlabCallback& callback);
+
+ private:
+    // Number of the triangles in a chunk of the scratch file
+    static const size_t kTrianglesPerChunk = 1024;
+
+    struct Bin {
+        // Coordinates of the triangles that are not spilled yet
+        std::vector<double> buffer;
+        std::vector<uint64_t> chunkOffsets;
+    };
+
+    Size3 _dataSize;
+    Vector3D _gridSpacing;
+    Vector3D _dataOrigin;
+    unsigned int _exactBand;
+    size_t _slabDepth;
+
+    std::vector<Bin> _bins;
+    size_t _numberOfTriangles = 0;
+    uint64_t _fileSize = 0;
+    std::FILE* _file = nullptr;
+
+    void spill(Bin* bin);
+
+    void loadBin(const Bin& bin, std::vector<double>* coords);
+};
 
 }  // namespace jet
 
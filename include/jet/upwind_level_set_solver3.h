@@ -24,6 +24,18 @@ class UpwindLevelSetSolver3 final : public IterativeLevelSetSolver3 {
         std::array<double, 2>* dx,
         std::array<double, 2>* dy,
         std::array<double, 2>* dz) const override;
+
+    //! Computes the derivatives for the grid points along an x-line.
+    void getDerivativesAlongX(
+        ConstArrayAccessor3<double> grid,
+        const Vector3D& gridSpacing,
+        size_t iBegin,
+        size_t iEnd,
+        size_t j,
+        size_t k,
+        std::array<double, 2>* dx,
+        std::array<double, 2>* dy,
+        std::array<double, 2>* dz) const override;
 };
 
 }  // namespace jet
@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef INCLUDE_JET_VECTOR3_BATCH_H_
+#define INCLUDE_JET_VECTOR3_BATCH_H_
+
+#include <jet/array1.h>
+#include <jet/array_accessor1.h>
+#include <jet/array_accessor3.h>
+#include <jet/matrix3x3.h>
+#include <jet/vector3.h>
+
+namespace jet {
+
+//!
+//! \brief Batch of 3-D vectors in structure-of-arrays layout.
+//!
+//! The x, y, and z components are stored in three separate arrays, so the
+//! batch operations load four or eight consecutive vectors per instruction
+//! instead of gathering the components of Array1<Vector3D>. The data layers
+//! of ParticleSystemData3 and the data of CollocatedVectorGrid3 can be loaded
+//! into a batch and stored back after the operations.
+//!
+//! The operations are vectorized for the instruction set of
+//! simdInstructionSet() and run in parallel. They compute the same terms in
+//! the same order as the member functions of Vector3D without fused
+//! multiply-adds, so the results are identical to the scalar ones.
+//!
+class Vector3Batch {
+ public:
+    //! Constructs an empty batch.
+    Vector3Batch();
+
+    //! Constructs a batch of \p size zero vectors.
+    explicit Vector3Batch(size_t size);
+
+    //! Constructs a batch with a copy of the given vectors.
+    explicit Vector3Batch(const ConstArrayAccessor1<Vector3D>& vectors);
+
+    //! Returns the number of the vectors.
+    size_t size() const;
+
+    //! Resizes the batch, filling the new vectors with zeros.
+    void resize(size_t size);
+
+    //! Returns the i-th vector.
+    Vector3D at(size_t i) const;
+
+    //! Sets the i-th vector.
+    void setAt(size_t i, const Vector3D& v);
+
+    //! Returns the x components.
+    ArrayAccessor1<double> x();
+
+    //! Returns the x components.
+    ConstArrayAccessor1<double> x() const;
+
+    //! Returns the y components.
+    ArrayAccessor1<double> y();
+
+    //! Returns the y components.
+    ConstArrayAccessor1<double> y() const;
+
+    //! Returns the z components.
+    ArrayAccessor1<double> z();
+
+    //! Returns the z components.
+    ConstArrayAccessor1<double> z() const;
+
+    //! Resizes the batch and copies the given vectors into it.
+    void load(const ConstArrayAccessor1<Vector3D>& vectors);
+
+    //! Resizes the batch and copies the given grid data into it, i-first.
+    void load(const ConstArrayAccessor3<Vector3D>& vectors);
+
+    //! Copies the vectors into the given array of the same size.
+    void store(ArrayAccessor1<Vector3D> vectors) const;
+
+    //! Copies the vectors into the given grid data of the same size, i-first.
+    void store(ArrayAccessor3<Vector3D> vectors) const;
+
+    //! Writes the dot products with the vectors of \p other into \p result.
+    void dot(const Vector3Batch& other, ArrayAccessor1<double> result) const;
+
+    //! Writes the lengths of the vectors into \p result.
+    void length(ArrayAccessor1<double> result) const;
+
+    //!
+    //! \brief Normalizes the vectors.
+    //!
+    //! Like Vector3D::normalize, the zero vectors become NaN.
+    //!
+    void normalize();
+
+    //!
+    //! \brief Transforms the vectors by \p matrix and then \p translation.
+    //!
+    //! Each vector v becomes matrix.mul(v) + translation, such as for moving
+    //! the points of a rigid body or mapping the offsets into the frame of an
+    //! anisotropic kernel. The nine elements of the matrix stay in registers
+    //! while the vectors stream through, so it runs at the speed of the
+    //! memory.
+    //!
+    //! Every product and sum is rounded on its own, in the order of
+    //! Matrix3x3D::mul, and the translation is added last. Hence the results
+    //! are identical to the scalar ones with every instruction set, which
+    //! requires the library to be compiled without FMA contraction.
+    //!
+    void transform(
+        const Matrix3x3D& matrix,
+        const Vector3D& translation = Vector3D());
+
+    //! Computes \p result = \p a * \p x + \p y for the batches of same size.
+    static void axpy(
+        double a,
+        const Vector3Batch& x,
+        const Vector3Batch& y,
+        Vector3Batch* result);
+
+ private:
+    Array1<double> _x;
+    Array1<double> _y;
+    Array1<double> _z;
+
+    void load(const Vector3D* vectors, size_t size);
+
+    void store(Vector3D* vectors) const;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_VECTOR3_BATCH_H_
@@ -17,14 +17,15 @@ namespace jet {
 //! grid vertices (corners). Thus, A x B x C grid resolution will have
 //! (A+1) x (B+1) x (C+1) data points.
 //!
-class VertexCenteredScalarGrid3 final : public ScalarGrid3 {
+template <typename T>
+class VertexCenteredScalarGrid3T final : public ScalarGrid3T<T> {
  public:
     //! Constructs zero-sized grid.
-    VertexCenteredScalarGrid3();
+    VertexCenteredScalarGrid3T();
 
     //! Constructs a grid with given resolution, grid spacing, origin and
     //! initial value.
-    VertexCenteredScalarGrid3(
+    VertexCenteredScalarGrid3T(
          size_t resolutionX,
          size_t resolutionY,
          size_t resolutionZ,
@@ -34,18 +35,22 @@ class VertexCenteredScalarGrid3 final : public ScalarGrid3 {
          double originX = 0.0,
          double originY = 0.0,
          double originZ = 0.0,
-         double initialValue = 0.0);
+         T initialValue = 0);
 
     //! Constructs a grid with given resolution, grid spacing, origin and
     //! initial value.
-    VertexCenteredScalarGrid3(
+    VertexCenteredScalarGrid3T(
         const Size3& resolution,
         const Vector3D& gridSpacing = Vector3D(1.0, 1.0, 1.0),
         const Vector3D& origin = Vector3D(),
-        double initialValue = 0.0);
+        T initialValue = 0);
 
     //! Copy constructor.
-    VertexCenteredScalarGrid3(const VertexCenteredScalarGrid3& other);
+    VertexCenteredScalarGrid3T(const VertexCenteredScalarGrid3T& other);
+
+    //! Move constructor. Takes over the data of \p other, which is left
+    //! with the contents of a default-constructed grid.
+    VertexCenteredScalarGrid3T(VertexCenteredScalarGrid3T&& other);
 
     //! Returns the actual data point size.
     Size3 dataSize() const override;
@@ -56,7 +61,7 @@ class VertexCenteredScalarGrid3 final : public ScalarGrid3 {
     Vector3D dataOrigin() const override;
 
     //! Returns the copy of the grid instance.
-    std::shared_ptr<ScalarGrid3> clone() const override;
+    std::shared_ptr<ScalarGrid3T<T>> clone() const override;
 
     //!
     //! \brief Swaps the contents with the given \p other grid.
@@ -67,33 +72,54 @@ class VertexCenteredScalarGrid3 final : public ScalarGrid3 {
     void swap(Grid3* other) override;
 
     //! Sets the contents with the given \p other grid.
-    void set(const VertexCenteredScalarGrid3& other);
+    void set(const VertexCenteredScalarGrid3T& other);
 
     //! Sets the contents with the given \p other grid.
-    VertexCenteredScalarGrid3& operator=(
-        const VertexCenteredScalarGrid3& other);
+    VertexCenteredScalarGrid3T& operator=(
+        const VertexCenteredScalarGrid3T& other);
+
+    //! Moves the contents of the given \p other grid by swapping them.
+    VertexCenteredScalarGrid3T& operator=(VertexCenteredScalarGrid3T&& other);
 
     //! Returns the grid builder instance.
-    static ScalarGridBuilder3Ptr builder();
+    static std::shared_ptr<ScalarGridBuilder3T<T>> builder();
 };
 
 //! A grid builder class that returns 3-D vertex-centered scalar grid.
-class VertexCenteredScalarGridBuilder3 final : public ScalarGridBuilder3 {
+template <typename T>
+class VertexCenteredScalarGridBuilder3T final
+    : public ScalarGridBuilder3T<T> {
  public:
     //! Returns a vertex-centered grid for given parameters.
-    ScalarGrid3Ptr build(
+    std::shared_ptr<ScalarGrid3T<T>> build(
         const Size3& resolution,
         const Vector3D& gridSpacing,
         const Vector3D& gridOrigin,
         double initialVal) const override {
-        return std::make_shared<VertexCenteredScalarGrid3>(
+        return std::make_shared<VertexCenteredScalarGrid3T<T>>(
             resolution,
             gridSpacing,
             gridOrigin,
-            initialVal);
+            static_cast<T>(initialVal));
     }
 };
 
+//! Double-precision 3-D vertex-centered scalar grid.
+typedef VertexCenteredScalarGrid3T<double> VertexCenteredScalarGrid3;
+
+//! Single-precision 3-D vertex-centered scalar grid.
+typedef VertexCenteredScalarGrid3T<float> VertexCenteredScalarGrid3F;
+
+//! Builder type of the VertexCenteredScalarGrid3.
+typedef VertexCenteredScalarGridBuilder3T<double>
+    VertexCenteredScalarGridBuilder3;
+
+//! Builder type of the VertexCenteredScalarGrid3F.
+typedef VertexCenteredScalarGridBuilder3T<float>
+    VertexCenteredScalarGridBuilder3F;
+
 }  // namespace jet
 
+#include "detail/vertex_centered_scalar_grid3-inl.h"
+
 #endif  // INCLUDE_JET_VERTEX_CENTERED_SCALAR_GRID3_H_
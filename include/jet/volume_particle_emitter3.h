@@ -58,6 +58,20 @@ class VolumeParticleEmitter3 final : public ParticleEmitter3 {
         const Frame& frame,
         const ParticleSystemData3Ptr& particles) override;
 
+    //!
+    //! \brief      Generates the particles to emit without adding them.
+    //!
+    //! \param[in]  frame         Current animation frame.
+    //! \param[in]  particles     The particle system data.
+    //! \param[out] newPositions  The positions of the new particles.
+    //! \param[out] newVelocities The velocities of the new particles.
+    //!
+    void generate(
+        const Frame& frame,
+        const ParticleSystemData3Ptr& particles,
+        Array1<Vector3D>* newPositions,
+        Array1<Vector3D>* newVelocities) override;
+
     //!
     //! \brief      Sets the point generator.
     //!
@@ -108,6 +122,14 @@ class VolumeParticleEmitter3 final : public ParticleEmitter3 {
     //! Sets the max number of particles to be emitted.
     void setMaxNumberOfParticles(size_t newMaxNumberOfParticles);
 
+    //!
+    //! \brief Scales the spacing and the max number of particles for a
+    //! quick preview.
+    //!
+    //! \see ParticleEmitter3::setPreviewScale
+    //!
+    void setPreviewScale(double factor) override;
+
     //! Returns the spacing between particles.
     double spacing() const;
 
@@ -132,16 +154,12 @@ class VolumeParticleEmitter3 final : public ParticleEmitter3 {
     size_t _maxNumberOfParticles = std::numeric_limits<size_t>::max();
     size_t _numberOfEmittedParticles = 0;
 
+    double _fullSpacing = 0.0;
+    size_t _fullMaxNumberOfParticles = 0;
+
     double _jitter = 0.0;
     bool _isOneShot = true;
     bool _allowOverlapping = false;
-
-    void emit(
-        const ParticleSystemData3Ptr& particles,
-        Array1<Vector3D>* newPositions,
-        Array1<Vector3D>* newVelocities);
-
-    double random();
 };
 
 typedef std::shared_ptr<VolumeParticleEmitter3> VolumeParticleEmitter3Ptr;
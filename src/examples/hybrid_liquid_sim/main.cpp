@@ -13,28 +13,44 @@
 
 #include <algorithm>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #define APP_NAME "hybrid_liquid_sim"
 
 using namespace jet;
 
+// Throughput of a simulation run, reported by the benchmark mode
+struct RunStatistics {
+    size_t numberOfParticles = 0;
+    size_t numberOfFrames = 0;
+    size_t numberOfSubTimeSteps = 0;
+    double numberOfParticleSteps = 0.0;
+    double durationInSeconds = 0.0;
+};
+
+// Writes a snapshot of the particles on the background thread.
 void saveParticlePos(
     const ParticleSystemData3Ptr& particles,
     const std::string& rootDir,
-    unsigned int frameCnt) {
-    Array1<Vector3D> positions(particles->numberOfParticles());
-    copyRange1(
-        particles->positions(), particles->numberOfParticles(), &positions);
+    unsigned int frameCnt,
+    AsyncFileWriter* writer) {
+    auto snapshot = std::make_shared<ParticleSystemData3>();
+    snapshot->setRadius(particles->radius());
+    snapshot->setMass(particles->mass());
+    snapshot->addParticles(
+        particles->positions(), particles->velocities(), particles->forces());
+
     char basename[256];
     snprintf(basename, sizeof(basename), "frame_%06d.pos", frameCnt);
     std::string filename = pystring::os::path::join(rootDir, basename);
-    std::ofstream file(filename.c_str());
-    if (file) {
-        printf("Writing %s...\n", filename.c_str());
-        positions.serialize(&file);
-        file.close();
-    }
+    printf("Writing %s...\n", filename.c_str());
+    writer->write(filename, [snapshot](std::ostream* strm) {
+        ParticleCacheWriter3 cacheWriter(*snapshot);
+        cacheWriter.write(strm);
+    });
 }
 
 void printUsage() {
@@ -47,9 +63,34 @@ void printUsage() {
         "   -o, --output: output directory name "
         "(default is " APP_NAME "_output)\n"
         "   -e, --example: example number (between 1 and 4, default is 1)\n"
+        "   -b, --benchmark: runs the example for each of the comma-separated "
+        "resolutions of -r\n"
+        "       and thread counts of -t without writing any output, then "
+        "prints the\n"
+        "       throughput of each run in CSV (peak_rss_mb is the high-water "
+        "mark of the\n"
+        "       process, so the resolutions run from the coarsest)\n"
+        "   -t, --threads: comma-separated thread counts for the benchmark "
+        "mode\n"
+        "       (default is the hardware concurrency)\n"
         "   -h, --help: print this message\n");
 }
 
+// Parses comma-separated numbers such as "32,64,128"
+template <typename T>
+std::vector<T> parseNumbers(const char* str) {
+    std::vector<T> numbers;
+    std::stringstream strm(str);
+    std::string token;
+    while (std::getline(strm, token, ',')) {
+        T number;
+        if (std::stringstream(token) >> number) {
+            numbers.push_back(number);
+        }
+    }
+    return numbers;
+}
+
 void printInfo(
     const Size3& resolution,
     const BoundingBox3D& domain,
@@ -70,7 +111,8 @@ void printInfo(
         numberOfParticles);
 }
 
-void runSimulation(
+// Runs the simulation, and writes the frames unless rootDir is empty
+RunStatistics runSimulation(
     const Size3& resolution,
     const Vector3D& gridSpacing,
     const Vector3D& origin,
@@ -78,21 +120,47 @@ void runSimulation(
     PicSolver3* solver,
     size_t numberOfFrames) {
     auto particles = solver->particleSystemData();
+    bool isWritingOutput = !rootDir.empty();
 
-    saveParticlePos(particles, rootDir, 0);
+    // Writes the frames while the next ones are simulated
+    AsyncFileWriter writer;
+    if (isWritingOutput) {
+        saveParticlePos(particles, rootDir, 0, &writer);
+    }
+
+    RunStatistics stats;
+    stats.numberOfParticles = particles->numberOfParticles();
+
+    solver->setFrameCallback([&](const Frame& frame) {
+        size_t numberOfSubTimeSteps
+            = solver->lastFrameStatistics().subTimeSteps.size();
+        ++stats.numberOfFrames;
+        stats.numberOfSubTimeSteps += numberOfSubTimeSteps;
+        stats.numberOfParticleSteps += static_cast<double>(
+            numberOfSubTimeSteps * particles->numberOfParticles());
+
+        if (isWritingOutput) {
+            saveParticlePos(
+                particles,
+                rootDir,
+                frame.index,
+                &writer);
+        }
+    });
 
-    Frame frame(1, 1.0 / 60.0);
-    for ( ; frame.index < numberOfFrames; frame.advance()) {
-        solver->update(frame);
-        saveParticlePos(
-            particles,
-            rootDir,
-            frame.index);
+    Timer timer;
+    if (numberOfFrames > 1) {
+        solver->update(
+            Frame(static_cast<unsigned int>(numberOfFrames - 1), 1.0 / 60.0));
     }
+    stats.durationInSeconds = timer.durationInSeconds();
+    solver->setFrameCallback(PhysicsAnimation::FrameCallback());
+
+    return stats;
 }
 
 // Water-drop example (FLIP)
-void runExample1(
+RunStatistics runExample1(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -133,12 +201,12 @@ void runExample1(
     printInfo(resolution, domain, gridSpacing, particles->numberOfParticles());
 
     // Run simulation
-    runSimulation(
+    return runSimulation(
         resolution, gridSpacing, origin, rootDir, &solver, numberOfFrames);
 }
 
 // Water-drop example (PIC)
-void runExample2(
+RunStatistics runExample2(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -179,12 +247,12 @@ void runExample2(
     printInfo(resolution, domain, gridSpacing, particles->numberOfParticles());
 
     // Run simulation
-    runSimulation(
+    return runSimulation(
         resolution, gridSpacing, origin, rootDir, &solver, numberOfFrames);
 }
 
 // Dam-breaking example (FLIP)
-void runExample3(
+RunStatistics runExample3(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -243,12 +311,12 @@ void runExample3(
     printInfo(resolution, domain, gridSpacing, particles->numberOfParticles());
 
     // Run simulation
-    runSimulation(
+    return runSimulation(
         resolution, gridSpacing, origin, rootDir, &solver, numberOfFrames);
 }
 
 // Dam-breaking example (PIC)
-void runExample4(
+RunStatistics runExample4(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -307,12 +375,90 @@ void runExample4(
     printInfo(resolution, domain, gridSpacing, particles->numberOfParticles());
 
     // Run simulation
-    runSimulation(
+    return runSimulation(
         resolution, gridSpacing, origin, rootDir, &solver, numberOfFrames);
 }
 
+bool runExample(
+    int exampleNum,
+    const std::string& rootDir,
+    size_t resolutionX,
+    unsigned int numberOfFrames,
+    RunStatistics* stats) {
+    switch (exampleNum) {
+        case 1:
+            *stats = runExample1(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 2:
+            *stats = runExample2(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 3:
+            *stats = runExample3(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 4:
+            *stats = runExample4(rootDir, resolutionX, numberOfFrames);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Runs the example for every pair of resolution and thread count, and prints
+// the throughput of the runs
+bool runBenchmark(
+    int exampleNum,
+    std::vector<size_t> resolutions,
+    const std::vector<unsigned int>& threadCounts,
+    unsigned int numberOfFrames) {
+    // Coarsest first, so that the peak memory usage of each run is its own
+    std::sort(resolutions.begin(), resolutions.end());
+
+    std::vector<std::string> rows;
+    for (size_t resolutionX : resolutions) {
+        for (unsigned int numberOfThreads : threadCounts) {
+            setMaxNumberOfThreads(std::max(numberOfThreads, 1u));
+
+            RunStatistics stats;
+            if (!runExample(
+                    exampleNum, "", resolutionX, numberOfFrames, &stats)) {
+                return false;
+            }
+
+            double seconds = std::max(stats.durationInSeconds, 1e-9);
+            char row[256];
+            snprintf(
+                row,
+                sizeof(row),
+                "%d,%zu,%u,%zu,%zu,%zu,%.3f,%.3f,%.6g,%.1f",
+                exampleNum,
+                resolutionX,
+                numberOfThreads,
+                stats.numberOfParticles,
+                stats.numberOfFrames,
+                stats.numberOfSubTimeSteps,
+                stats.durationInSeconds,
+                stats.numberOfFrames / seconds,
+                stats.numberOfParticleSteps / seconds,
+                peakResidentSetSizeInBytes() / (1024.0 * 1024.0));
+            rows.push_back(row);
+            printf("%s\n", row);
+        }
+    }
+
+    printf(
+        "\nexample,resx,threads,particles,frames,sub_steps,seconds,"
+        "frames_per_sec,particle_steps_per_sec,peak_rss_mb\n");
+    for (const std::string& row : rows) {
+        printf("%s\n", row.c_str());
+    }
+
+    return true;
+}
+
 int main(int argc, char* argv[]) {
-    size_t resolutionX = 50;
+    std::vector<size_t> resolutions(1, 50);
+    std::vector<unsigned int> threadCounts(1, maxNumberOfThreads());
+    bool isBenchmark = false;
     unsigned int numberOfFrames = 100;
     int exampleNum = 1;
     std::string logFilename = APP_NAME ".log";
@@ -325,6 +471,8 @@ int main(int argc, char* argv[]) {
         {"example",   optional_argument, 0, 'e'},
         {"log",       optional_argument, 0, 'l'},
         {"outputDir", optional_argument, 0, 'o'},
+        {"benchmark", no_argument,       0, 'b'},
+        {"threads",   optional_argument, 0, 't'},
         {"help",      optional_argument, 0, 'h'},
         {0,           0,                 0,  0 }
     };
@@ -332,10 +480,10 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "r:f:e:l:o:h", longOptions, &long_index)) != -1) {
+        argc, argv, "r:f:e:l:o:bt:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 'r':
-                resolutionX = static_cast<size_t>(atoi(optarg));
+                resolutions = parseNumbers<size_t>(optarg);
                 break;
             case 'f':
                 numberOfFrames = static_cast<size_t>(atoi(optarg));
@@ -349,6 +497,12 @@ int main(int argc, char* argv[]) {
             case 'o':
                 outputDir = optarg;
                 break;
+            case 'b':
+                isBenchmark = true;
+                break;
+            case 't':
+                threadCounts = parseNumbers<unsigned int>(optarg);
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -358,34 +512,43 @@ int main(int argc, char* argv[]) {
         }
     }
 
-#ifdef JET_WINDOWS
-    _mkdir(outputDir.c_str());
-#else
-    mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
-#endif
+    if (resolutions.empty() || threadCounts.empty()) {
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
 
     std::ofstream logFile(logFilename.c_str());
     if (logFile) {
         Logging::setAllStream(&logFile);
     }
 
-    switch (exampleNum) {
-        case 1:
-            runExample1(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 2:
-            runExample2(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 3:
-            runExample3(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 4:
-            runExample4(outputDir, resolutionX, numberOfFrames);
-            break;
-        default:
+    if (isBenchmark) {
+        if (!runBenchmark(
+                exampleNum, resolutions, threadCounts, numberOfFrames)) {
             printUsage();
             exit(EXIT_FAILURE);
+        }
+    } else {
+#ifdef JET_WINDOWS
+        _mkdir(outputDir.c_str());
+#else
+        mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
+#endif
+
+        RunStatistics stats;
+        if (!runExample(
+                exampleNum,
+                outputDir,
+                resolutions.front(),
+                numberOfFrames,
+                &stats)) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
     }
 
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
     return EXIT_SUCCESS;
 }
@@ -11,42 +11,89 @@
 
 #include <getopt.h>
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #define APP_NAME "level_set_liquid_sim"
 
 using namespace jet;
 
-void saveTriangleMesh(
-    const TriangleMesh3& mesh,
+// Throughput of a simulation run, reported by the benchmark mode
+struct RunStatistics {
+    size_t numberOfCells = 0;
+    size_t numberOfFrames = 0;
+    size_t numberOfSubTimeSteps = 0;
+    double numberOfCellSteps = 0.0;
+    double durationInSeconds = 0.0;
+};
+
+std::string frameFilename(
     const std::string& rootDir,
+    const std::string& format,
     unsigned int frameCnt) {
     char basename[256];
-    snprintf(basename, sizeof(basename), "frame_%06d.obj", frameCnt);
-    std::string filename = pystring::os::path::join(rootDir, basename);
-    std::ofstream file(filename.c_str());
-    if (file) {
-        printf("Writing %s...\n", filename.c_str());
-        mesh.writeObj(&file);
-        file.close();
+    snprintf(
+        basename, sizeof(basename), "frame_%06d.%s", frameCnt, format.c_str());
+    return pystring::os::path::join(rootDir, basename);
+}
+
+void writeTriangleMesh(
+    const TriangleMesh3& mesh,
+    const std::string& format,
+    std::ostream* strm) {
+    if (format == "ply") {
+        mesh.writePly(strm);
+    } else {
+        mesh.writeObj(strm);
     }
 }
 
+// Snapshots the SDF, and then triangulates and writes the snapshot on the
+// background thread. The writes run one at a time in the frame order, so they
+// can share the tile cache, which only remeshes the parts of the surface that
+// moved since the previous frame.
 void triangulateAndSave(
     const ScalarGrid3Ptr& sdf,
     const std::string& rootDir,
-    unsigned int frameCnt) {
-    TriangleMesh3 mesh;
-    int flag = kMarchingCubesBoundaryFlagAll & ~kMarchingCubesBoundaryFlagDown;
-    marchingCubes(
-        sdf->constDataAccessor(),
-        sdf->gridSpacing(),
-        sdf->dataOrigin(),
-        &mesh,
-        0.0,
-        flag);
-    saveTriangleMesh(mesh, rootDir, frameCnt);
+    const std::string& format,
+    unsigned int frameCnt,
+    const std::shared_ptr<MarchingCubesTileCache3>& meshCache,
+    AsyncFileWriter* writer) {
+    std::string filename = frameFilename(rootDir, format, frameCnt);
+    printf("Writing %s...\n", filename.c_str());
+
+    ScalarGrid3Ptr snapshot = sdf->clone();
+    writer->write(filename, [snapshot, format, meshCache](std::ostream* strm) {
+        int flag
+            = kMarchingCubesBoundaryFlagAll & ~kMarchingCubesBoundaryFlagDown;
+
+        // The binary format is streamed while marching the cubes
+        if (format == "bin") {
+            TriangleMeshStreamWriter3 meshWriter(strm);
+            marchingCubes(
+                snapshot->constDataAccessor(),
+                snapshot->gridSpacing(),
+                snapshot->dataOrigin(),
+                &meshWriter,
+                0.0,
+                flag);
+            return;
+        }
+
+        TriangleMesh3 mesh;
+        meshCache->update(
+            snapshot->constDataAccessor(),
+            snapshot->gridSpacing(),
+            snapshot->dataOrigin(),
+            &mesh,
+            0.0,
+            flag);
+        writeTriangleMesh(mesh, format, strm);
+    });
 }
 
 void printUsage() {
@@ -60,9 +107,35 @@ void printUsage() {
         "   -o, --output: output directory name "
         "(default is " APP_NAME "_output)\n"
         "   -e, --example: example number (between 1 and 4, default is 1)\n"
+        "   -m, --format: mesh format (obj, ply, or bin, default is obj)\n"
+        "   -b, --benchmark: runs the example for each of the comma-separated "
+        "resolutions of -r\n"
+        "       and thread counts of -t without writing any output, then "
+        "prints the\n"
+        "       throughput of each run in CSV (peak_rss_mb is the high-water "
+        "mark of the\n"
+        "       process, so the resolutions run from the coarsest)\n"
+        "   -t, --threads: comma-separated thread counts for the benchmark "
+        "mode\n"
+        "       (default is the hardware concurrency)\n"
         "   -h, --help: print this message\n");
 }
 
+// Parses comma-separated numbers such as "32,64,128"
+template <typename T>
+std::vector<T> parseNumbers(const char* str) {
+    std::vector<T> numbers;
+    std::stringstream strm(str);
+    std::string token;
+    while (std::getline(strm, token, ',')) {
+        T number;
+        if (std::stringstream(token) >> number) {
+            numbers.push_back(number);
+        }
+    }
+    return numbers;
+}
+
 void printInfo(
     const Size3& resolution,
     const BoundingBox3D& domain,
@@ -79,24 +152,56 @@ void printInfo(
         gridSpacing.x, gridSpacing.y, gridSpacing.z);
 }
 
-void runSimulation(
+// Runs the simulation, and writes the frames unless rootDir is empty
+RunStatistics runSimulation(
     const std::string& rootDir,
+    const std::string& format,
     LevelSetLiquidSolver3* solver,
     size_t numberOfFrames,
     double fps) {
     auto sdf = solver->signedDistanceField();
-    triangulateAndSave(sdf, rootDir, 0);
+    bool isWritingOutput = !rootDir.empty();
 
-    Frame frame(1, 1.0 / fps);
-    for ( ; frame.index < numberOfFrames; frame.advance()) {
-        solver->update(frame);
-        triangulateAndSave(sdf, rootDir, frame.index);
+    // Writes the frames while the next ones are simulated
+    AsyncFileWriter writer;
+    auto meshCache = std::make_shared<MarchingCubesTileCache3>();
+    if (isWritingOutput) {
+        triangulateAndSave(sdf, rootDir, format, 0, meshCache, &writer);
     }
+
+    RunStatistics stats;
+    Size3 resolution = solver->gridSystemData()->resolution();
+    stats.numberOfCells = resolution.x * resolution.y * resolution.z;
+
+    solver->setFrameCallback([&](const Frame& frame) {
+        size_t numberOfSubTimeSteps
+            = solver->lastFrameStatistics().subTimeSteps.size();
+        ++stats.numberOfFrames;
+        stats.numberOfSubTimeSteps += numberOfSubTimeSteps;
+        stats.numberOfCellSteps += static_cast<double>(
+            numberOfSubTimeSteps * stats.numberOfCells);
+
+        if (isWritingOutput) {
+            triangulateAndSave(
+                sdf, rootDir, format, frame.index, meshCache, &writer);
+        }
+    });
+
+    Timer timer;
+    if (numberOfFrames > 1) {
+        solver->update(
+            Frame(static_cast<unsigned int>(numberOfFrames - 1), 1.0 / fps));
+    }
+    stats.durationInSeconds = timer.durationInSeconds();
+    solver->setFrameCallback(PhysicsAnimation::FrameCallback());
+
+    return stats;
 }
 
 // Water-drop example
-void runExample1(
+RunStatistics runExample1(
     const std::string& rootDir,
+    const std::string& format,
     size_t resolutionX,
     unsigned int numberOfFrames,
     double fps) {
@@ -132,12 +237,13 @@ void runExample1(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames, fps);
+    return runSimulation(rootDir, format, &solver, numberOfFrames, fps);
 }
 
 // Dam-breaking example
-void runExample2(
+RunStatistics runExample2(
     const std::string& rootDir,
+    const std::string& format,
     size_t resolutionX,
     unsigned int numberOfFrames,
     double fps) {
@@ -186,12 +292,13 @@ void runExample2(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames, fps);
+    return runSimulation(rootDir, format, &solver, numberOfFrames, fps);
 }
 
 // High-viscosity example (bunny-drop)
-void runExample3(
+RunStatistics runExample3(
     const std::string& rootDir,
+    const std::string& format,
     size_t resolutionX,
     unsigned int numberOfFrames,
     double fps) {
@@ -235,12 +342,13 @@ void runExample3(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames, fps);
+    return runSimulation(rootDir, format, &solver, numberOfFrames, fps);
 }
 
 // Low-viscosity example (bunny-drop)
-void runExample4(
+RunStatistics runExample4(
     const std::string& rootDir,
+    const std::string& format,
     size_t resolutionX,
     unsigned int numberOfFrames,
     double fps) {
@@ -284,16 +392,108 @@ void runExample4(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames, fps);
+    return runSimulation(rootDir, format, &solver, numberOfFrames, fps);
+}
+
+bool runExample(
+    int exampleNum,
+    const std::string& rootDir,
+    const std::string& format,
+    size_t resolutionX,
+    unsigned int numberOfFrames,
+    double fps,
+    RunStatistics* stats) {
+    switch (exampleNum) {
+        case 1:
+            *stats = runExample1(
+                rootDir, format, resolutionX, numberOfFrames, fps);
+            return true;
+        case 2:
+            *stats = runExample2(
+                rootDir, format, resolutionX, numberOfFrames, fps);
+            return true;
+        case 3:
+            *stats = runExample3(
+                rootDir, format, resolutionX, numberOfFrames, fps);
+            return true;
+        case 4:
+            *stats = runExample4(
+                rootDir, format, resolutionX, numberOfFrames, fps);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Runs the example for every pair of resolution and thread count, and prints
+// the throughput of the runs
+bool runBenchmark(
+    int exampleNum,
+    std::vector<size_t> resolutions,
+    const std::vector<unsigned int>& threadCounts,
+    unsigned int numberOfFrames,
+    double fps) {
+    // Coarsest first, so that the peak memory usage of each run is its own
+    std::sort(resolutions.begin(), resolutions.end());
+
+    std::vector<std::string> rows;
+    for (size_t resolutionX : resolutions) {
+        for (unsigned int numberOfThreads : threadCounts) {
+            setMaxNumberOfThreads(std::max(numberOfThreads, 1u));
+
+            RunStatistics stats;
+            if (!runExample(
+                    exampleNum,
+                    "",
+                    "",
+                    resolutionX,
+                    numberOfFrames,
+                    fps,
+                    &stats)) {
+                return false;
+            }
+
+            double seconds = std::max(stats.durationInSeconds, 1e-9);
+            char row[256];
+            snprintf(
+                row,
+                sizeof(row),
+                "%d,%zu,%u,%zu,%zu,%zu,%.3f,%.3f,%.6g,%.1f",
+                exampleNum,
+                resolutionX,
+                numberOfThreads,
+                stats.numberOfCells,
+                stats.numberOfFrames,
+                stats.numberOfSubTimeSteps,
+                stats.durationInSeconds,
+                stats.numberOfFrames / seconds,
+                stats.numberOfCellSteps / seconds,
+                peakResidentSetSizeInBytes() / (1024.0 * 1024.0));
+            rows.push_back(row);
+            printf("%s\n", row);
+        }
+    }
+
+    printf(
+        "\nexample,resx,threads,cells,frames,sub_steps,seconds,"
+        "frames_per_sec,cell_steps_per_sec,peak_rss_mb\n");
+    for (const std::string& row : rows) {
+        printf("%s\n", row.c_str());
+    }
+
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    size_t resolutionX = 50;
+    std::vector<size_t> resolutions(1, 50);
+    std::vector<unsigned int> threadCounts(1, maxNumberOfThreads());
+    bool isBenchmark = false;
     unsigned int numberOfFrames = 100;
     double fps = 60.0;
     int exampleNum = 1;
     std::string logFilename = APP_NAME ".log";
     std::string outputDir = APP_NAME "_output";
+    std::string format = "obj";
 
     // Parse options
     static struct option longOptions[] = {
@@ -303,6 +503,9 @@ int main(int argc, char* argv[]) {
         {"example",   optional_argument, 0, 'e'},
         {"log",       optional_argument, 0, 'l'},
         {"outputDir", optional_argument, 0, 'o'},
+        {"format",    optional_argument, 0, 'm'},
+        {"benchmark", no_argument,       0, 'b'},
+        {"threads",   optional_argument, 0, 't'},
         {"help",      optional_argument, 0, 'h'},
         {0,           0,                 0,  0 }
     };
@@ -310,10 +513,10 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "r:f:p:e:l:o:h", longOptions, &long_index)) != -1) {
+        argc, argv, "r:f:p:e:l:o:m:bt:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 'r':
-                resolutionX = static_cast<size_t>(atoi(optarg));
+                resolutions = parseNumbers<size_t>(optarg);
                 break;
             case 'f':
                 numberOfFrames = static_cast<size_t>(atoi(optarg));
@@ -330,6 +533,19 @@ int main(int argc, char* argv[]) {
             case 'o':
                 outputDir = optarg;
                 break;
+            case 'm':
+                format = optarg;
+                if (format != "obj" && format != "ply" && format != "bin") {
+                    printUsage();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'b':
+                isBenchmark = true;
+                break;
+            case 't':
+                threadCounts = parseNumbers<unsigned int>(optarg);
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -339,34 +555,45 @@ int main(int argc, char* argv[]) {
         }
     }
 
-#ifdef JET_WINDOWS
-    _mkdir(outputDir.c_str());
-#else
-    mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
-#endif
+    if (resolutions.empty() || threadCounts.empty()) {
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
 
     std::ofstream logFile(logFilename.c_str());
     if (logFile) {
         Logging::setAllStream(&logFile);
     }
 
-    switch (exampleNum) {
-        case 1:
-            runExample1(outputDir, resolutionX, numberOfFrames, fps);
-            break;
-        case 2:
-            runExample2(outputDir, resolutionX, numberOfFrames, fps);
-            break;
-        case 3:
-            runExample3(outputDir, resolutionX, numberOfFrames, fps);
-            break;
-        case 4:
-            runExample4(outputDir, resolutionX, numberOfFrames, fps);
-            break;
-        default:
+    if (isBenchmark) {
+        if (!runBenchmark(
+                exampleNum, resolutions, threadCounts, numberOfFrames, fps)) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
+    } else {
+#ifdef JET_WINDOWS
+        _mkdir(outputDir.c_str());
+#else
+        mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
+#endif
+
+        RunStatistics stats;
+        if (!runExample(
+                exampleNum,
+                outputDir,
+                format,
+                resolutions.front(),
+                numberOfFrames,
+                fps,
+                &stats)) {
             printUsage();
             exit(EXIT_FAILURE);
+        }
     }
 
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
     return EXIT_SUCCESS;
 }
@@ -5,19 +5,34 @@
 #include <getopt.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <future>
+#include <sstream>
 #include <string>
+#include <vector>
 
 using namespace jet;
 
 void printUsage() {
     printf(
         "Usage: obj2sdf "
-        "-i input_obj -o output_sdf -r resolution -m margin_scale\n"
+        "-i input_obj -o output_sdf -r resolution -m margin_scale "
+        "[-f first,last] [-j jobs]\n"
         "   -i, --input: input obj filename\n"
         "   -o, --output: output sdf filename\n"
         "   -r, --resx: grid resolution in x-axis (default: 100)\n"
         "   -m, --margin: margin scale around the sdf (default: 0.2)\n"
+        "   -s, --stream: stream the faces and write the narrow band of the\n"
+        "                 sdf slab by slab as raw doubles (x fastest) for\n"
+        "                 meshes larger than the memory\n"
+        "   -f, --frames: convert the frames from first to last, where the\n"
+        "                 input and output filenames are patterns\n"
+        "                 with one %%d or %%0Nd frame number, such as\n"
+        "                 frame_%%06d.obj\n"
+        "   -j, --jobs: number of frames converted in parallel in the\n"
+        "               frame mode (default: number of threads)\n"
         "   -h, --help: print this message\n");
 }
 
@@ -31,11 +46,288 @@ void saveTriangleMeshData(
     }
 }
 
+// Buffers for converting one mesh. They are kept from frame to frame, and the
+// memory of the grid is reused as long as the resolution does not change.
+struct FrameContext {
+    VertexCenteredScalarGrid3 grid;
+    TriangleMesh3 previewMesh;
+};
+
+// Fits the grid around the mesh with the margin
+void fitGrid(
+    const TriangleMesh3& triMesh,
+    size_t resolutionX,
+    double marginScale,
+    VertexCenteredScalarGrid3* grid) {
+    BoundingBox3D box = triMesh.boundingBox();
+    Vector3D scale(box.width(), box.height(), box.depth());
+    box.lowerCorner -= marginScale * scale;
+    box.upperCorner += marginScale * scale;
+
+    size_t resolutionY = static_cast<size_t>(
+        std::ceil(resolutionX * box.height() / box.width()));
+    size_t resolutionZ = static_cast<size_t>(
+        std::ceil(resolutionX * box.depth() / box.width()));
+    Size3 resolution(resolutionX, resolutionY, resolutionZ);
+
+    double dx = box.width() / resolutionX;
+    Vector3D gridSpacing(dx, dx, dx);
+
+    if (grid->resolution() == resolution) {
+        grid->resize(gridSpacing, box.lowerCorner);
+    } else {
+        grid->resize(resolution, gridSpacing, box.lowerCorner);
+    }
+}
+
+// Writes the sdf and the previsualization mesh of it
+bool saveSdf(
+    const VertexCenteredScalarGrid3& grid,
+    TriangleMesh3* previewMesh,
+    const std::string& outputFilename) {
+    std::ofstream sdfFile(outputFilename.c_str(), std::ofstream::binary);
+    if (sdfFile) {
+        printf("Writing to vertex-centered grid %s\n", outputFilename.c_str());
+
+        grid.serialize(&sdfFile);
+        sdfFile.close();
+    } else {
+        fprintf(stderr, "Failed to write file %s\n", outputFilename.c_str());
+        return false;
+    }
+
+    previewMesh->clear();
+    marchingCubes(
+        grid.constDataAccessor(),
+        grid.gridSpacing(),
+        grid.origin(),
+        previewMesh,
+        0,
+        kMarchingCubesBoundaryFlagAll);
+
+    saveTriangleMeshData(*previewMesh, outputFilename + "_previz.obj");
+    return true;
+}
+
+// Converts the frames in batches of numberOfJobs frames that run in parallel
+// on the thread pool, each with its own context. The meshes of the next batch
+// are read on a separate thread while the current batch is converted.
+bool runFrames(
+    const std::vector<std::string>& inputFilenames,
+    const std::vector<std::string>& outputFilenames,
+    size_t resolutionX,
+    double marginScale,
+    size_t numberOfJobs) {
+    const size_t numberOfFrames = inputFilenames.size();
+    numberOfJobs = std::max(std::min(numberOfJobs, numberOfFrames), kOneSize);
+
+    std::vector<FrameContext> contexts(numberOfJobs);
+    std::vector<TriangleMesh3> meshes(numberOfJobs);
+    std::vector<TriangleMesh3> nextMeshes(numberOfJobs);
+    std::vector<char> isRead(numberOfJobs, 0);
+    std::vector<char> isNextRead(numberOfJobs, 0);
+
+    auto readBatch = [&](size_t first) {
+        for (size_t i = 0; i < numberOfJobs && first + i < numberOfFrames;
+             ++i) {
+            nextMeshes[i].clear();
+            isNextRead[i] = nextMeshes[i].readObj(inputFilenames[first + i]);
+        }
+    };
+
+    bool isSuccessful = true;
+    readBatch(0);
+    for (size_t first = 0; first < numberOfFrames; first += numberOfJobs) {
+        meshes.swap(nextMeshes);
+        isRead.swap(isNextRead);
+
+        std::future<void> prefetch;
+        if (first + numberOfJobs < numberOfFrames) {
+            prefetch = std::async(
+                std::launch::async, readBatch, first + numberOfJobs);
+        }
+
+        const size_t count = std::min(numberOfJobs, numberOfFrames - first);
+        std::vector<char> isConverted(count, 0);
+        parallelFor(kZeroSize, count, kOneSize, [&](size_t i) {
+            if (!isRead[i]) {
+                fprintf(
+                    stderr,
+                    "Failed to read file %s\n",
+                    inputFilenames[first + i].c_str());
+                return;
+            }
+
+            FrameContext& context = contexts[i];
+            fitGrid(meshes[i], resolutionX, marginScale, &context.grid);
+            triangleMeshToSdf(meshes[i], &context.grid);
+            isConverted[i] = saveSdf(
+                context.grid,
+                &context.previewMesh,
+                outputFilenames[first + i]);
+        });
+
+        if (prefetch.valid()) {
+            prefetch.get();
+        }
+
+        for (char converted : isConverted) {
+            isSuccessful &= (converted != 0);
+        }
+    }
+
+    return isSuccessful;
+}
+
+// Reads the positions of the vertices of the obj file, which the faces refer
+// to by index, and computes their bounding box
+bool readObjVertices(
+    const std::string& filename,
+    std::vector<Vector3D>* vertices,
+    BoundingBox3D* box) {
+    std::ifstream file(filename.c_str());
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 2, "v ") == 0) {
+            std::istringstream stream(line.substr(2));
+            Vector3D point;
+            stream >> point.x >> point.y >> point.z;
+            vertices->push_back(point);
+            box->merge(point);
+        }
+    }
+
+    return true;
+}
+
+// Streams the faces of the obj file to the generator, splitting the polygons
+// into fans of triangles
+bool streamObjFaces(
+    const std::string& filename,
+    const std::vector<Vector3D>& vertices,
+    StreamingTriangleMeshToSdf3* generator) {
+    std::ifstream file(filename.c_str());
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    std::vector<size_t> face;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 2, "f ") != 0) {
+            continue;
+        }
+
+        face.clear();
+        std::istringstream stream(line.substr(2));
+        std::string token;
+        while (stream >> token) {
+            // Negative indices are relative to the end of the vertices
+            long index = std::atol(token.c_str());
+            if (index < 0) {
+                index += static_cast<long>(vertices.size());
+            } else {
+                --index;
+            }
+            if (index < 0 || index >= static_cast<long>(vertices.size())) {
+                return false;
+            }
+            face.push_back(static_cast<size_t>(index));
+        }
+
+        for (size_t v = 2; v < face.size(); ++v) {
+            generator->addTriangle(
+                vertices[face[0]], vertices[face[v - 1]], vertices[face[v]]);
+        }
+    }
+
+    return true;
+}
+
+// Converts the obj file without loading its faces or allocating the full
+// grid. Only the vertices and one slab of the sdf are kept in the memory.
+int runStreaming(
+    const std::string& inputFilename,
+    const std::string& outputFilename,
+    size_t resolutionX,
+    double marginScale) {
+    std::vector<Vector3D> vertices;
+    BoundingBox3D box;
+
+    printf("Reading vertices of obj file %s\n", inputFilename.c_str());
+    if (!readObjVertices(inputFilename, &vertices, &box)) {
+        fprintf(stderr, "Failed to read file %s\n", inputFilename.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    Vector3D scale(box.width(), box.height(), box.depth());
+    box.lowerCorner -= marginScale * scale;
+    box.upperCorner += marginScale * scale;
+
+    size_t resolutionY = static_cast<size_t>(
+        std::ceil(resolutionX * box.height() / box.width()));
+    size_t resolutionZ = static_cast<size_t>(
+        std::ceil(resolutionX * box.depth() / box.width()));
+    double dx = box.width() / resolutionX;
+
+    // Same data layout as the vertex-centered grid of the non-streaming mode
+    Size3 dataSize(resolutionX + 1, resolutionY + 1, resolutionZ + 1);
+    printf(
+        "Vertex-centered grid size: %zu x %zu x %zu\n",
+        resolutionX, resolutionY, resolutionZ);
+
+    StreamingTriangleMeshToSdf3 generator(
+        dataSize, Vector3D(dx, dx, dx), box.lowerCorner);
+
+    printf("Binning faces...");
+    if (!streamObjFaces(inputFilename, vertices, &generator)) {
+        fprintf(stderr, "Failed to read faces of %s\n", inputFilename.c_str());
+        exit(EXIT_FAILURE);
+    }
+    printf("done (%zu triangles)\n", generator.numberOfTriangles());
+
+    // The faces are binned, so the vertices are no longer needed
+    std::vector<Vector3D>().swap(vertices);
+
+    std::ofstream sdfFile(outputFilename.c_str(), std::ofstream::binary);
+    if (!sdfFile) {
+        fprintf(stderr, "Failed to write file %s\n", outputFilename.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    printf(
+        "Writing %zu x %zu x %zu raw narrow-band sdf to %s\n",
+        dataSize.x, dataSize.y, dataSize.z, outputFilename.c_str());
+
+    generator.generate(
+        [&](size_t, const ConstArrayAccessor3<double>& slab) {
+            sdfFile.write(
+                reinterpret_cast<const char*>(slab.data()),
+                sizeof(double) * slab.width() * slab.height() * slab.depth());
+        });
+
+    if (!sdfFile) {
+        fprintf(stderr, "Failed to write file %s\n", outputFilename.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     std::string inputFilename;
     std::string outputFilename;
     size_t resolutionX = 100;
     double marginScale = 0.2;
+    bool isStreaming = false;
+    bool isBatch = false;
+    int firstFrame = 0;
+    int lastFrame = 0;
+    size_t numberOfJobs = maxNumberOfThreads();
 
     // Parse options
     static struct option longOptions[] = {
@@ -43,6 +335,9 @@ int main(int argc, char* argv[]) {
         {"output",  required_argument,  0,  'o' },
         {"resx",    optional_argument,  0,  'r' },
         {"margin",  optional_argument,  0,  'm' },
+        {"stream",  no_argument,        0,  's' },
+        {"frames",  required_argument,  0,  'f' },
+        {"jobs",    required_argument,  0,  'j' },
         {"help",    optional_argument,  0,  'h' },
         {0,         0,                  0,   0  }
     };
@@ -50,7 +345,7 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "i:o:r:m:h", longOptions, &long_index)) != -1) {
+        argc, argv, "i:o:r:m:sf:j:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 'i':
                 inputFilename = optarg;
@@ -64,6 +359,22 @@ int main(int argc, char* argv[]) {
             case 'm':
                 marginScale = std::max(atof(optarg), 0.0);
                 break;
+            case 's':
+                isStreaming = true;
+                break;
+            case 'f': {
+                // Either a single frame or a comma-separated range
+                const char* comma = strchr(optarg, ',');
+                firstFrame = lastFrame = atoi(optarg);
+                if (comma != nullptr) {
+                    lastFrame = atoi(comma + 1);
+                }
+                isBatch = true;
+                break;
+            }
+            case 'j':
+                numberOfJobs = static_cast<size_t>(std::max(atoi(optarg), 1));
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -73,38 +384,57 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (isBatch) {
+        if (isStreaming
+            || !isFrameFilenamePattern(inputFilename)
+            || !isFrameFilenamePattern(outputFilename)
+            || firstFrame > lastFrame) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
+
+        std::vector<std::string> inputFilenames;
+        std::vector<std::string> outputFilenames;
+        for (int frame = firstFrame; frame <= lastFrame; ++frame) {
+            inputFilenames.push_back(frameFilename(inputFilename, frame));
+            outputFilenames.push_back(frameFilename(outputFilename, frame));
+        }
+
+        printf(
+            "Converting frames %d to %d, %zu at a time\n",
+            firstFrame, lastFrame, numberOfJobs);
+        if (!runFrames(
+                inputFilenames,
+                outputFilenames,
+                resolutionX,
+                marginScale,
+                numberOfJobs)) {
+            exit(EXIT_FAILURE);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    if (isStreaming) {
+        return runStreaming(
+            inputFilename, outputFilename, resolutionX, marginScale);
+    }
+
     TriangleMesh3 triMesh;
 
-    std::ifstream objFile(inputFilename.c_str());
-    if (objFile) {
-        printf("Reading obj file %s\n", inputFilename.c_str());
-        triMesh.readObj(&objFile);
-        objFile.close();
-    } else {
-        fprintf(stderr, "Failed to open file %s\n", inputFilename.c_str());
+    printf("Reading obj file %s\n", inputFilename.c_str());
+    if (!triMesh.readObj(inputFilename)) {
+        fprintf(stderr, "Failed to read file %s\n", inputFilename.c_str());
         exit(EXIT_FAILURE);
     }
 
-    BoundingBox3D box = triMesh.boundingBox();
-    Vector3D scale(box.width(), box.height(), box.depth());
-    box.lowerCorner -= marginScale * scale;
-    box.upperCorner += marginScale * scale;
-
-    size_t resolutionY = static_cast<size_t>(
-        std::ceil(resolutionX * box.height() / box.width()));
-    size_t resolutionZ = static_cast<size_t>(
-        std::ceil(resolutionX * box.depth() / box.width()));
+    FrameContext context;
+    VertexCenteredScalarGrid3& grid = context.grid;
+    fitGrid(triMesh, resolutionX, marginScale, &grid);
 
     printf(
         "Vertex-centered grid size: %zu x %zu x %zu\n",
-        resolutionX, resolutionY, resolutionZ);
-
-    double dx = box.width() / resolutionX;
-
-    VertexCenteredScalarGrid3 grid(
-        resolutionX, resolutionY, resolutionZ,
-        dx, dx, dx,
-        box.lowerCorner.x, box.lowerCorner.y, box.lowerCorner.z);
+        grid.resolution().x, grid.resolution().y, grid.resolution().z);
 
     BoundingBox3D domain = grid.boundingBox();
     printf(
@@ -117,27 +447,9 @@ int main(int argc, char* argv[]) {
 
     printf("done\n");
 
-    std::ofstream sdfFile(outputFilename.c_str(), std::ofstream::binary);
-    if (sdfFile) {
-        printf("Writing to vertex-centered grid %s\n", outputFilename.c_str());
-
-        grid.serialize(&sdfFile);
-        sdfFile.close();
-    } else {
-        fprintf(stderr, "Failed to write file %s\n", outputFilename.c_str());
+    if (!saveSdf(grid, &context.previewMesh, outputFilename)) {
         exit(EXIT_FAILURE);
     }
 
-    TriangleMesh3 triMesh2;
-    marchingCubes(
-        grid.constDataAccessor(),
-        grid.gridSpacing(),
-        grid.origin(),
-        &triMesh2,
-        0,
-        kMarchingCubesBoundaryFlagAll);
-
-    saveTriangleMeshData(triMesh2, outputFilename + "_previz.obj");
-
     return EXIT_SUCCESS;
 }
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <future>
 #include <string>
 #include <vector>
 
@@ -19,7 +20,10 @@ void printUsage() {
         "-r resx,resy,resz "
         "-g dx,dy,dz "
         "-n ox,oy,oz "
-        "-k kernel_radius\n"
+        "-k kernel_radius "
+        "[-a] "
+        "[-f first,last] "
+        "[-j jobs]\n"
         "   -i, --input: input particle position filename\n"
         "   -o, --output: output obj filename\n"
         "   -r, --resolution: grid resolution in CSV format "
@@ -28,6 +32,14 @@ void printUsage() {
             "(default: 0.01,0.01,0.01)\n"
         "   -n, --origin: domain origin in CSV format (default: 0,0,0)\n"
         "   -k, --kernel: interpolation kernel radius (default: 0.2)\n"
+        "   -a, --anisotropic: use anisotropic kernels for smoother "
+            "surface\n"
+        "   -f, --frames: convert the frames from first to last, where the\n"
+        "                 input and output filenames are patterns\n"
+        "                 with one %%d or %%0Nd frame number, such as\n"
+        "                 frame_%%06d.pos\n"
+        "   -j, --jobs: number of frames converted in parallel in the\n"
+        "               frame mode (default: number of threads)\n"
         "   -h, --help: print this message\n");
 }
 
@@ -49,57 +61,156 @@ void printInfo(
     printf("Number of particles: %zu\n", numberOfParticles);
 }
 
-void triangulateAndSave(
+// Reads the particle positions from the particle cache, or from the raw array
+// written by the older versions of the examples. The positions are copied
+// into the buffer, which also pages in the memory-mapped cache.
+bool readPositions(
+    const std::string& filename,
+    ParticleCacheReader3* cache,
+    Array1<Vector3D>* positions) {
+    if (cache->open(filename)) {
+        ConstArrayAccessor1<Vector3D> channel
+            = cache->vectorChannel("position");
+        positions->resize(channel.size());
+        std::copy(channel.begin(), channel.end(), positions->begin());
+        cache->close();
+        return true;
+    }
+
+    std::ifstream positionFile(filename.c_str(), std::ifstream::binary);
+    if (positionFile) {
+        positions->deserialize(&positionFile);
+        positionFile.close();
+        return true;
+    }
+
+    return false;
+}
+
+struct ConversionOptions {
+    Size3 resolution;
+    Vector3D gridSpacing;
+    Vector3D origin;
+    double kernelRadius;
+    bool isAnisotropic;
+};
+
+// Buffers for converting one frame. They are kept from frame to frame so that
+// the grid and the mesh are only allocated once.
+struct FrameContext {
+    VertexCenteredScalarGrid3 sdf;
+    TriangleMesh3 mesh;
+};
+
+bool triangulateAndSave(
     const ScalarGrid3& sdf,
+    TriangleMesh3* mesh,
     const std::string& objFilename) {
-    TriangleMesh3 mesh;
+    mesh->clear();
     marchingCubes(
         sdf.constDataAccessor(),
         sdf.gridSpacing(),
         sdf.dataOrigin(),
-        &mesh,
+        mesh,
         0.0,
         kMarchingCubesBoundaryFlagAll);
 
     std::ofstream file(objFilename.c_str());
     if (file) {
         printf("Writing %s...\n", objFilename.c_str());
-        mesh.writeObj(&file);
+        mesh->writeObj(&file);
         file.close();
+        return true;
     } else {
         printf("Cannot write file %s.\n", objFilename.c_str());
-        exit(EXIT_FAILURE);
+        return false;
     }
 }
 
-void particlesToObj(
-    const Array1<Vector3D>& positions,
-    const Size3& resolution,
-    const Vector3D& gridSpacing,
-    const Vector3D& origin,
-    double kernelRadius,
+// Runs marching cube and saves it to the disk
+bool particlesToObj(
+    const ConstArrayAccessor1<Vector3D>& positions,
+    const ConversionOptions& options,
+    FrameContext* context,
     const std::string& objFilename) {
-    SphSystemData3 sphParticles;
-    sphParticles.addParticles(positions);
-    sphParticles.setRelativeKernelRadius(2.0);
-    sphParticles.setTargetSpacing(kernelRadius / 2.0);
-    sphParticles.buildNeighborSearcher();
-    sphParticles.updateDensities();
-
-    VertexCenteredScalarGrid3 sdf(resolution, gridSpacing, origin);
-    printInfo(
-        resolution,
-        sdf.boundingBox(),
-        gridSpacing,
-        sphParticles.numberOfParticles());
+    // Without the anisotropic kernels, the field is 0.5 minus the SPH
+    // interpolation of one, splatted particle by particle
+    ParticlesToSdf3 converter(options.kernelRadius);
+    converter.setIsUsingAnisotropicKernels(options.isAnisotropic);
+    converter.convert(positions, &context->sdf);
+
+    return triangulateAndSave(context->sdf, &context->mesh, objFilename);
+}
+
+// Converts the frames in batches of numberOfJobs frames that run in parallel
+// on the thread pool, each with its own context. The positions of the next
+// batch are read on a separate thread while the current batch is converted.
+bool particlesToObjFrames(
+    const std::vector<std::string>& inputFilenames,
+    const std::vector<std::string>& outputFilenames,
+    const ConversionOptions& options,
+    size_t numberOfJobs) {
+    const size_t numberOfFrames = inputFilenames.size();
+    numberOfJobs = std::max(std::min(numberOfJobs, numberOfFrames), kOneSize);
+
+    std::vector<FrameContext> contexts(numberOfJobs);
+    for (FrameContext& context : contexts) {
+        context.sdf.resize(
+            options.resolution, options.gridSpacing, options.origin);
+    }
 
-    Array1<double> constData(sphParticles.numberOfParticles(), 1.0);
-    sdf.fill([&](const Vector3D& pt) {
-        double d = sphParticles.interpolate(pt, constData);
-        return 0.5 - d;
-    });
+    std::vector<Array1<Vector3D>> positions(numberOfJobs);
+    std::vector<Array1<Vector3D>> nextPositions(numberOfJobs);
+    std::vector<char> isRead(numberOfJobs, 0);
+    std::vector<char> isNextRead(numberOfJobs, 0);
 
-    triangulateAndSave(sdf, objFilename);
+    ParticleCacheReader3 cache;
+    auto readBatch = [&](size_t first) {
+        for (size_t i = 0; i < numberOfJobs && first + i < numberOfFrames;
+             ++i) {
+            isNextRead[i] = readPositions(
+                inputFilenames[first + i], &cache, &nextPositions[i]);
+        }
+    };
+
+    bool isSuccessful = true;
+    readBatch(0);
+    for (size_t first = 0; first < numberOfFrames; first += numberOfJobs) {
+        positions.swap(nextPositions);
+        isRead.swap(isNextRead);
+
+        std::future<void> prefetch;
+        if (first + numberOfJobs < numberOfFrames) {
+            prefetch = std::async(
+                std::launch::async, readBatch, first + numberOfJobs);
+        }
+
+        const size_t count = std::min(numberOfJobs, numberOfFrames - first);
+        std::vector<char> isConverted(count, 0);
+        parallelFor(kZeroSize, count, kOneSize, [&](size_t i) {
+            if (!isRead[i]) {
+                printf(
+                    "Cannot read file %s.\n",
+                    inputFilenames[first + i].c_str());
+                return;
+            }
+            isConverted[i] = particlesToObj(
+                positions[i].constAccessor(),
+                options,
+                &contexts[i],
+                outputFilenames[first + i]);
+        });
+
+        if (prefetch.valid()) {
+            prefetch.get();
+        }
+
+        for (char converted : isConverted) {
+            isSuccessful &= (converted != 0);
+        }
+    }
+
+    return isSuccessful;
 }
 
 int main(int argc, char* argv[]) {
@@ -109,6 +220,11 @@ int main(int argc, char* argv[]) {
     Vector3D gridSpacing(0.01, 0.01, 0.01);
     Vector3D origin;
     double kernelRadius = 0.2;
+    bool isAnisotropic = false;
+    bool isBatch = false;
+    int firstFrame = 0;
+    int lastFrame = 0;
+    size_t numberOfJobs = maxNumberOfThreads();
 
     // Parse options
     static struct option longOptions[] = {
@@ -118,6 +234,9 @@ int main(int argc, char* argv[]) {
         {"gridspacing", optional_argument,  0,  'g' },
         {"origin",      optional_argument,  0,  'n' },
         {"kernel",      optional_argument,  0,  'k' },
+        {"anisotropic", no_argument,        0,  'a' },
+        {"frames",      required_argument,  0,  'f' },
+        {"jobs",        required_argument,  0,  'j' },
         {"help",        optional_argument,  0,  'h' },
         {0,             0,                  0,   0  }
     };
@@ -125,7 +244,7 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "i:o:r:g:n:k:h", longOptions, &long_index)) != -1) {
+        argc, argv, "i:o:r:g:n:k:af:j:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 'i':
                 inputFilename = optarg;
@@ -180,6 +299,24 @@ int main(int argc, char* argv[]) {
                 kernelRadius = atof(optarg);
                 break;
             }
+            case 'a':
+                isAnisotropic = true;
+                break;
+            case 'f': {
+                std::vector<std::string> tokens;
+                pystring::split(optarg, tokens, ",");
+                if (tokens.size() == 1) {
+                    firstFrame = lastFrame = atoi(optarg);
+                } else if (tokens.size() == 2) {
+                    firstFrame = atoi(tokens[0].c_str());
+                    lastFrame = atoi(tokens[1].c_str());
+                }
+                isBatch = true;
+                break;
+            }
+            case 'j':
+                numberOfJobs = static_cast<size_t>(std::max(atoi(optarg), 1));
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -194,25 +331,58 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    // Read particle positions
+    ConversionOptions options;
+    options.resolution = resolution;
+    options.gridSpacing = gridSpacing;
+    options.origin = origin;
+    options.kernelRadius = kernelRadius;
+    options.isAnisotropic = isAnisotropic;
+
+    if (isBatch) {
+        if (!isFrameFilenamePattern(inputFilename)
+            || !isFrameFilenamePattern(outputFilename)
+            || firstFrame > lastFrame) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
+
+        std::vector<std::string> inputFilenames;
+        std::vector<std::string> outputFilenames;
+        for (int frame = firstFrame; frame <= lastFrame; ++frame) {
+            inputFilenames.push_back(frameFilename(inputFilename, frame));
+            outputFilenames.push_back(frameFilename(outputFilename, frame));
+        }
+
+        printf(
+            "Converting frames %d to %d, %zu at a time\n",
+            firstFrame, lastFrame, numberOfJobs);
+        if (!particlesToObjFrames(
+                inputFilenames, outputFilenames, options, numberOfJobs)) {
+            exit(EXIT_FAILURE);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    ParticleCacheReader3 cache;
     Array1<Vector3D> positions;
-    std::ifstream positionFile(inputFilename.c_str(), std::ifstream::binary);
-    if (positionFile) {
-        positions.deserialize(&positionFile);
-        positionFile.close();
-    } else {
+    if (!readPositions(inputFilename, &cache, &positions)) {
         printf("Cannot read file %s.\n", inputFilename.c_str());
         exit(EXIT_FAILURE);
     }
 
-    // Run marching cube and save it to the disk
-    particlesToObj(
-        positions,
+    FrameContext context;
+    context.sdf.resize(resolution, gridSpacing, origin);
+    printInfo(
         resolution,
+        context.sdf.boundingBox(),
         gridSpacing,
-        origin,
-        kernelRadius,
-        outputFilename);
+        positions.size());
+
+    if (!particlesToObj(
+            positions.constAccessor(), options, &context, outputFilename)) {
+        exit(EXIT_FAILURE);
+    }
 
     return EXIT_SUCCESS;
 }
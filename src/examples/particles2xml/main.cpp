@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <future>
 #include <string>
 #include <vector>
 
@@ -15,9 +16,17 @@ using namespace jet;
 void printUsage() {
     printf(
         "Usage: particles2xml "
-        "-i input_pos -o output_xml \n"
+        "-i input_pos -o output_xml "
+        "[-f first,last] "
+        "[-j jobs]\n"
         "   -i, --input: input particle position filename\n"
         "   -o, --output: output obj filename\n"
+        "   -f, --frames: convert the frames from first to last, where the\n"
+        "                 input and output filenames are patterns\n"
+        "                 with one %%d or %%0Nd frame number, such as\n"
+        "                 frame_%%06d.pos\n"
+        "   -j, --jobs: number of frames converted in parallel in the\n"
+        "               frame mode (default: number of threads)\n"
         "   -h, --help: print this message\n");
 }
 
@@ -25,53 +34,152 @@ void printInfo(size_t numberOfParticles) {
     printf("Number of particles: %zu\n", numberOfParticles);
 }
 
-void particlesToXml(
-    const Array1<Vector3D>& positions,
+// Reads the particle positions from the particle cache, or from the raw array
+// written by the older versions of the examples. The positions are copied
+// into the buffer, which also pages in the memory-mapped cache.
+bool readPositions(
+    const std::string& filename,
+    ParticleCacheReader3* cache,
+    Array1<Vector3D>* positions) {
+    if (cache->open(filename)) {
+        ConstArrayAccessor1<Vector3D> channel
+            = cache->vectorChannel("position");
+        positions->resize(channel.size());
+        std::copy(channel.begin(), channel.end(), positions->begin());
+        cache->close();
+        return true;
+    }
+
+    std::ifstream positionFile(filename.c_str(), std::ifstream::binary);
+    if (positionFile) {
+        positions->deserialize(&positionFile);
+        positionFile.close();
+        return true;
+    }
+
+    return false;
+}
+
+// Formats the whole scene into \p xml, whose memory is kept from frame to
+// frame, and writes it at once.
+bool particlesToXml(
+    const ConstArrayAccessor1<Vector3D>& positions,
+    std::string* xml,
     const std::string& xmlFilename) {
-    printInfo(positions.size());
+    xml->clear();
+    *xml += "<scene version=\"0.5.0\">";
+
+    for (const auto& pos : positions) {
+        *xml += "<shape type=\"instance\">";
+        *xml += "<ref id=\"spheres\"/>";
+        *xml += "<transform name=\"toWorld\">";
+
+        char buffer[64];
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "<translate x=\"%f\" y=\"%f\" z=\"%f\"/>",
+            pos.x,
+            pos.y,
+            pos.z);
+        *xml += buffer;
+
+        *xml += "</transform>";
+        *xml += "</shape>";
+    }
+
+    *xml += "</scene>";
 
     std::ofstream file(xmlFilename.c_str());
     if (file) {
         printf("Writing %s...\n", xmlFilename.c_str());
+        file.write(xml->data(), static_cast<std::streamsize>(xml->size()));
+        file.close();
+        return true;
+    } else {
+        printf("Cannot write file %s.\n", xmlFilename.c_str());
+        return false;
+    }
+}
 
-        file << "<scene version=\"0.5.0\">";
-
-        for (const auto& pos : positions) {
-            file << "<shape type=\"instance\">";
-            file << "<ref id=\"spheres\"/>";
-            file << "<transform name=\"toWorld\">";
-
-            char buffer[64];
-            snprintf(
-                buffer,
-                sizeof(buffer),
-                "<translate x=\"%f\" y=\"%f\" z=\"%f\"/>",
-                pos.x,
-                pos.y,
-                pos.z);
-            file << buffer;
-
-            file << "</transform>";
-            file << "</shape>";
+// Converts the frames in batches of numberOfJobs frames that run in parallel
+// on the thread pool, each with its own buffer. The positions of the next
+// batch are read on a separate thread while the current batch is converted.
+bool particlesToXmlFrames(
+    const std::vector<std::string>& inputFilenames,
+    const std::vector<std::string>& outputFilenames,
+    size_t numberOfJobs) {
+    const size_t numberOfFrames = inputFilenames.size();
+    numberOfJobs = std::max(std::min(numberOfJobs, numberOfFrames), kOneSize);
+
+    std::vector<std::string> xmls(numberOfJobs);
+    std::vector<Array1<Vector3D>> positions(numberOfJobs);
+    std::vector<Array1<Vector3D>> nextPositions(numberOfJobs);
+    std::vector<char> isRead(numberOfJobs, 0);
+    std::vector<char> isNextRead(numberOfJobs, 0);
+
+    ParticleCacheReader3 cache;
+    auto readBatch = [&](size_t first) {
+        for (size_t i = 0; i < numberOfJobs && first + i < numberOfFrames;
+             ++i) {
+            isNextRead[i] = readPositions(
+                inputFilenames[first + i], &cache, &nextPositions[i]);
         }
+    };
 
-        file << "</scene>";
+    bool isSuccessful = true;
+    readBatch(0);
+    for (size_t first = 0; first < numberOfFrames; first += numberOfJobs) {
+        positions.swap(nextPositions);
+        isRead.swap(isNextRead);
 
-        file.close();
-    } else {
-        printf("Cannot write file %s.\n", xmlFilename.c_str());
-        exit(EXIT_FAILURE);
+        std::future<void> prefetch;
+        if (first + numberOfJobs < numberOfFrames) {
+            prefetch = std::async(
+                std::launch::async, readBatch, first + numberOfJobs);
+        }
+
+        const size_t count = std::min(numberOfJobs, numberOfFrames - first);
+        std::vector<char> isConverted(count, 0);
+        parallelFor(kZeroSize, count, kOneSize, [&](size_t i) {
+            if (!isRead[i]) {
+                printf(
+                    "Cannot read file %s.\n",
+                    inputFilenames[first + i].c_str());
+                return;
+            }
+            isConverted[i] = particlesToXml(
+                positions[i].constAccessor(),
+                &xmls[i],
+                outputFilenames[first + i]);
+        });
+
+        if (prefetch.valid()) {
+            prefetch.get();
+        }
+
+        for (char converted : isConverted) {
+            isSuccessful &= (converted != 0);
+        }
     }
+
+    return isSuccessful;
 }
 
 int main(int argc, char* argv[]) {
     std::string inputFilename;
     std::string outputFilename;
+    bool isBatch = false;
+    int firstFrame = 0;
+    int lastFrame = 0;
+    size_t numberOfJobs = maxNumberOfThreads();
 
     // Parse options
     static struct option longOptions[] = {
         {"input",       required_argument,  0,  'i' },
         {"output",      required_argument,  0,  'o' },
+        {"frames",      required_argument,  0,  'f' },
+        {"jobs",        required_argument,  0,  'j' },
         {"help",        optional_argument,  0,  'h' },
         {0,             0,                  0,   0  }
     };
@@ -79,7 +187,7 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "i:o:h", longOptions, &long_index)) != -1) {
+        argc, argv, "i:o:f:j:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 'i':
                 inputFilename = optarg;
@@ -87,6 +195,21 @@ int main(int argc, char* argv[]) {
             case 'o':
                 outputFilename = optarg;
                 break;
+            case 'f': {
+                std::vector<std::string> tokens;
+                pystring::split(optarg, tokens, ",");
+                if (tokens.size() == 1) {
+                    firstFrame = lastFrame = atoi(optarg);
+                } else if (tokens.size() == 2) {
+                    firstFrame = atoi(tokens[0].c_str());
+                    lastFrame = atoi(tokens[1].c_str());
+                }
+                isBatch = true;
+                break;
+            }
+            case 'j':
+                numberOfJobs = static_cast<size_t>(std::max(atoi(optarg), 1));
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -101,21 +224,45 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    // Read particle positions
+    if (isBatch) {
+        if (!isFrameFilenamePattern(inputFilename)
+            || !isFrameFilenamePattern(outputFilename)
+            || firstFrame > lastFrame) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
+
+        std::vector<std::string> inputFilenames;
+        std::vector<std::string> outputFilenames;
+        for (int frame = firstFrame; frame <= lastFrame; ++frame) {
+            inputFilenames.push_back(frameFilename(inputFilename, frame));
+            outputFilenames.push_back(frameFilename(outputFilename, frame));
+        }
+
+        printf(
+            "Converting frames %d to %d, %zu at a time\n",
+            firstFrame, lastFrame, numberOfJobs);
+        if (!particlesToXmlFrames(
+                inputFilenames, outputFilenames, numberOfJobs)) {
+            exit(EXIT_FAILURE);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    ParticleCacheReader3 cache;
     Array1<Vector3D> positions;
-    std::ifstream positionFile(inputFilename.c_str(), std::ifstream::binary);
-    if (positionFile) {
-        positions.deserialize(&positionFile);
-        positionFile.close();
-    } else {
+    if (!readPositions(inputFilename, &cache, &positions)) {
         printf("Cannot read file %s.\n", inputFilename.c_str());
         exit(EXIT_FAILURE);
     }
 
-    // Run marching cube and save it to the disk
-    particlesToXml(
-        positions,
-        outputFilename);
+    printInfo(positions.size());
+
+    std::string xml;
+    if (!particlesToXml(positions.constAccessor(), &xml, outputFilename)) {
+        exit(EXIT_FAILURE);
+    }
 
     return EXIT_SUCCESS;
 }
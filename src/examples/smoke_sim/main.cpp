@@ -13,12 +13,25 @@
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #define APP_NAME "smoke_sim"
 
 using namespace jet;
 
+// Throughput of a simulation run, reported by the benchmark mode
+struct RunStatistics {
+    size_t numberOfCells = 0;
+    size_t numberOfFrames = 0;
+    size_t numberOfSubTimeSteps = 0;
+    double numberOfCellSteps = 0.0;
+    double durationInSeconds = 0.0;
+};
+
 const size_t kEdgeBlur = 3;
 const float kEdgeBlurF = 3.f;
 
@@ -27,84 +40,63 @@ inline float smoothStep(float edge0, float edge1, float x) {
     return t * t * (3.f - 2.f * t);
 }
 
-// Export density field to Mitsuba volume file.
+// Export density field to Mitsuba volume file. The volume is cropped to the
+// smoke and encoded in half floats here, and written on the background thread.
 void saveVolume(
     const ScalarGrid3Ptr& density,
     const std::string& rootDir,
-    unsigned int frameCnt) {
+    unsigned int frameCnt,
+    AsyncFileWriter* writer) {
     char basename[256];
     snprintf(basename, sizeof(basename), "frame_%06d.vol", frameCnt);
     std::string filename = pystring::os::path::join(rootDir, basename);
-    std::ofstream file(filename.c_str(), std::ofstream::binary);
-    if (file) {
-        printf("Writing %s...\n", filename.c_str());
-
-        // Mitsuba 0.5.0 gridvolume format
-        char header[48];
-        memset(header, 0, sizeof(header));
-
-        header[0] = 'V';
-        header[1] = 'O';
-        header[2] = 'L';
-        header[3] = 3;
-        int32_t* encoding = reinterpret_cast<int32_t*>(header + 4);
-        encoding[0] = 1;  // 32-bit float
-        encoding[1] = static_cast<int32_t>(density->dataSize().x);
-        encoding[2] = static_cast<int32_t>(density->dataSize().y);
-        encoding[3] = static_cast<int32_t>(density->dataSize().z);
-        encoding[4] = 1;  // number of channels
-        BoundingBox3D domain = density->boundingBox();
-        float* bbox = reinterpret_cast<float*>(encoding + 5);
-        bbox[0] = static_cast<float>(domain.lowerCorner.x);
-        bbox[1] = static_cast<float>(domain.lowerCorner.y);
-        bbox[2] = static_cast<float>(domain.lowerCorner.z);
-        bbox[3] = static_cast<float>(domain.upperCorner.x);
-        bbox[4] = static_cast<float>(domain.upperCorner.y);
-        bbox[5] = static_cast<float>(domain.upperCorner.z);
-
-        file.write(header, sizeof(header));
-
-        Array3<float> data(density->dataSize());
-        data.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-            float d = static_cast<float>((*density)(i, j, k));
+    printf("Writing %s...\n", filename.c_str());
+
+    const Size3 size = density->dataSize();
+    SparseVolumeWriter3 volumeWriter(*density);
+    volumeWriter.setFilter(
+        [&](size_t i, size_t j, size_t k, double value) {
+            float d = static_cast<float>(value);
 
             // Blur the edge for less-noisy rendering
             if (i < kEdgeBlur) {
                 d *= smoothStep(0.f, kEdgeBlurF, static_cast<float>(i));
             }
-            if (i > data.size().x - 1 - kEdgeBlur) {
+            if (i > size.x - 1 - kEdgeBlur) {
                 d *= smoothStep(
                     0.f,
                     kEdgeBlurF,
-                    static_cast<float>((data.size().x - 1) - i));
+                    static_cast<float>((size.x - 1) - i));
             }
             if (j < kEdgeBlur) {
                 d *= smoothStep(0.f, kEdgeBlurF, static_cast<float>(j));
             }
-            if (j > data.size().y - 1 - kEdgeBlur) {
+            if (j > size.y - 1 - kEdgeBlur) {
                 d *= smoothStep(
                     0.f,
                     kEdgeBlurF,
-                    static_cast<float>((data.size().y - 1) - j));
+                    static_cast<float>((size.y - 1) - j));
             }
             if (k < kEdgeBlur) {
                 d *= smoothStep(0.f, kEdgeBlurF, static_cast<float>(k));
             }
-            if (k > data.size().z - 1 - kEdgeBlur) {
+            if (k > size.z - 1 - kEdgeBlur) {
                 d *= smoothStep(
                     0.f,
                     kEdgeBlurF,
-                    static_cast<float>((data.size().z - 1) - k));
+                    static_cast<float>((size.z - 1) - k));
             }
 
-            data(i, j, k) = d;
+            return static_cast<double>(d);
         });
-        file.write(
-            reinterpret_cast<const char*>(data.data()),
-            sizeof(float) * data.size().x * data.size().y * data.size().z);
 
-        file.close();
-    }
+    std::ostringstream strm;
+    volumeWriter.writeMitsuba(&strm);
+    auto data = std::make_shared<std::string>(strm.str());
+
+    writer->write(filename, [data](std::ostream* strm) {
+        strm->write(data->data(), data->size());
+    });
 }
 
 void printUsage() {
@@ -117,9 +109,34 @@ void printUsage() {
         "   -o, --output: output directory name "
         "(default is " APP_NAME "_output)\n"
         "   -e, --example: example number (between 1 and 5, default is 1)\n"
+        "   -b, --benchmark: runs the example for each of the comma-separated "
+        "resolutions of -r\n"
+        "       and thread counts of -t without writing any output, then "
+        "prints the\n"
+        "       throughput of each run in CSV (peak_rss_mb is the high-water "
+        "mark of the\n"
+        "       process, so the resolutions run from the coarsest)\n"
+        "   -t, --threads: comma-separated thread counts for the benchmark "
+        "mode\n"
+        "       (default is the hardware concurrency)\n"
         "   -h, --help: print this message\n");
 }
 
+// Parses comma-separated numbers such as "32,64,128"
+template <typename T>
+std::vector<T> parseNumbers(const char* str) {
+    std::vector<T> numbers;
+    std::stringstream strm(str);
+    std::string token;
+    while (std::getline(strm, token, ',')) {
+        T number;
+        if (std::stringstream(token) >> number) {
+            numbers.push_back(number);
+        }
+    }
+    return numbers;
+}
+
 void printInfo(
     const Size3& resolution,
     const BoundingBox3D& domain,
@@ -136,7 +153,8 @@ void printInfo(
         gridSpacing.x, gridSpacing.y, gridSpacing.z);
 }
 
-void runSimulation(
+// Runs the simulation, and writes the frames unless rootDir is empty
+RunStatistics runSimulation(
     const std::string& rootDir,
     std::function<double(const Vector3D&)> sourceFunc,
     std::function<double(double, const Vector3D&)> uFilterFunc,
@@ -149,8 +167,19 @@ void runSimulation(
     auto velocity = solver->velocity();
     auto uPos = velocity->uPosition();
 
-    saveVolume(solver->smokeDensity(), rootDir, 0);
+    bool isWritingOutput = !rootDir.empty();
 
+    // Writes the frames while the next ones are simulated
+    AsyncFileWriter writer;
+    if (isWritingOutput) {
+        saveVolume(solver->smokeDensity(), rootDir, 0, &writer);
+    }
+
+    RunStatistics stats;
+    Size3 resolution = solver->gridSystemData()->resolution();
+    stats.numberOfCells = resolution.x * resolution.y * resolution.z;
+
+    Timer timer;
     Frame frame(1, 1.0 / 60.0);
     for ( ; frame.index < numberOfFrames; frame.advance()) {
         density->parallelForEachDataPointIndex(
@@ -172,16 +201,30 @@ void runSimulation(
             });
 
         solver->update(frame);
-        saveVolume(solver->smokeDensity(), rootDir, frame.index);
+
+        size_t numberOfSubTimeSteps
+            = solver->lastFrameStatistics().subTimeSteps.size();
+        ++stats.numberOfFrames;
+        stats.numberOfSubTimeSteps += numberOfSubTimeSteps;
+        stats.numberOfCellSteps += static_cast<double>(
+            numberOfSubTimeSteps * stats.numberOfCells);
+
+        if (isWritingOutput) {
+            saveVolume(
+                solver->smokeDensity(), rootDir, frame.index, &writer);
+        }
     }
+    stats.durationInSeconds = timer.durationInSeconds();
+
+    return stats;
 }
 
-void runSimulation(
+RunStatistics runSimulation(
     const std::string& rootDir,
     const std::function<double(const Vector3D&)>& sourceFunc,
     GridSmokeSolver3* solver,
     size_t numberOfFrames) {
-    runSimulation(
+    return runSimulation(
         rootDir,
         sourceFunc,
         [] (double u, const Vector3D&) { return u; },
@@ -189,7 +232,7 @@ void runSimulation(
         numberOfFrames);
 }
 
-void runExample1(
+RunStatistics runExample1(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -231,10 +274,10 @@ void runExample1(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, sourceFunc, &solver, numberOfFrames);
+    return runSimulation(rootDir, sourceFunc, &solver, numberOfFrames);
 }
 
-void runExample2(
+RunStatistics runExample2(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -276,10 +319,10 @@ void runExample2(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, sourceFunc, &solver, numberOfFrames);
+    return runSimulation(rootDir, sourceFunc, &solver, numberOfFrames);
 }
 
-void runExample3(
+RunStatistics runExample3(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -324,10 +367,10 @@ void runExample3(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(rootDir, sourceFunc, &solver, numberOfFrames);
+    return runSimulation(rootDir, sourceFunc, &solver, numberOfFrames);
 }
 
-void runExample4(
+RunStatistics runExample4(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -363,7 +406,7 @@ void runExample4(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(
+    return runSimulation(
         rootDir,
         sourceFunc,
         [&] (double u, const Vector3D& uPos) {
@@ -378,7 +421,7 @@ void runExample4(
         numberOfFrames);
 }
 
-void runExample5(
+RunStatistics runExample5(
     const std::string& rootDir,
     size_t resolutionX,
     unsigned int numberOfFrames) {
@@ -415,7 +458,7 @@ void runExample5(
     printInfo(resolution, domain, gridSpacing);
 
     // Run simulation
-    runSimulation(
+    return runSimulation(
         rootDir,
         sourceFunc,
         [&] (double u, const Vector3D& uPos) {
@@ -430,8 +473,89 @@ void runExample5(
         numberOfFrames);
 }
 
+bool runExample(
+    int exampleNum,
+    const std::string& rootDir,
+    size_t resolutionX,
+    unsigned int numberOfFrames,
+    RunStatistics* stats) {
+    switch (exampleNum) {
+        case 1:
+            *stats = runExample1(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 2:
+            *stats = runExample2(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 3:
+            *stats = runExample3(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 4:
+            *stats = runExample4(rootDir, resolutionX, numberOfFrames);
+            return true;
+        case 5:
+            *stats = runExample5(rootDir, resolutionX, numberOfFrames);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Runs the example for every pair of resolution and thread count, and prints
+// the throughput of the runs
+bool runBenchmark(
+    int exampleNum,
+    std::vector<size_t> resolutions,
+    const std::vector<unsigned int>& threadCounts,
+    unsigned int numberOfFrames) {
+    // Coarsest first, so that the peak memory usage of each run is its own
+    std::sort(resolutions.begin(), resolutions.end());
+
+    std::vector<std::string> rows;
+    for (size_t resolutionX : resolutions) {
+        for (unsigned int numberOfThreads : threadCounts) {
+            setMaxNumberOfThreads(std::max(numberOfThreads, 1u));
+
+            RunStatistics stats;
+            if (!runExample(
+                    exampleNum, "", resolutionX, numberOfFrames, &stats)) {
+                return false;
+            }
+
+            double seconds = std::max(stats.durationInSeconds, 1e-9);
+            char row[256];
+            snprintf(
+                row,
+                sizeof(row),
+                "%d,%zu,%u,%zu,%zu,%zu,%.3f,%.3f,%.6g,%.1f",
+                exampleNum,
+                resolutionX,
+                numberOfThreads,
+                stats.numberOfCells,
+                stats.numberOfFrames,
+                stats.numberOfSubTimeSteps,
+                stats.durationInSeconds,
+                stats.numberOfFrames / seconds,
+                stats.numberOfCellSteps / seconds,
+                peakResidentSetSizeInBytes() / (1024.0 * 1024.0));
+            rows.push_back(row);
+            printf("%s\n", row);
+        }
+    }
+
+    printf(
+        "\nexample,resx,threads,cells,frames,sub_steps,seconds,"
+        "frames_per_sec,cell_steps_per_sec,peak_rss_mb\n");
+    for (const std::string& row : rows) {
+        printf("%s\n", row.c_str());
+    }
+
+    return true;
+}
+
 int main(int argc, char* argv[]) {
-    size_t resolutionX = 50;
+    std::vector<size_t> resolutions(1, 50);
+    std::vector<unsigned int> threadCounts(1, maxNumberOfThreads());
+    bool isBenchmark = false;
     unsigned int numberOfFrames = 100;
     int exampleNum = 1;
     std::string logFilename = APP_NAME ".log";
@@ -444,6 +568,8 @@ int main(int argc, char* argv[]) {
         {"example",   optional_argument, 0, 'e'},
         {"log",       optional_argument, 0, 'l'},
         {"outputDir", optional_argument, 0, 'o'},
+        {"benchmark", no_argument,       0, 'b'},
+        {"threads",   optional_argument, 0, 't'},
         {"help",      optional_argument, 0, 'h'},
         {0,           0,                 0,  0 }
     };
@@ -451,10 +577,10 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "r:f:e:l:o:h", longOptions, &long_index)) != -1) {
+        argc, argv, "r:f:e:l:o:bt:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 'r':
-                resolutionX = static_cast<size_t>(atoi(optarg));
+                resolutions = parseNumbers<size_t>(optarg);
                 break;
             case 'f':
                 numberOfFrames = static_cast<size_t>(atoi(optarg));
@@ -468,6 +594,12 @@ int main(int argc, char* argv[]) {
             case 'o':
                 outputDir = optarg;
                 break;
+            case 'b':
+                isBenchmark = true;
+                break;
+            case 't':
+                threadCounts = parseNumbers<unsigned int>(optarg);
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -477,37 +609,43 @@ int main(int argc, char* argv[]) {
         }
     }
 
-#ifdef JET_WINDOWS
-    _mkdir(outputDir.c_str());
-#else
-    mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
-#endif
+    if (resolutions.empty() || threadCounts.empty()) {
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
 
     std::ofstream logFile(logFilename.c_str());
     if (logFile) {
         Logging::setAllStream(&logFile);
     }
 
-    switch (exampleNum) {
-        case 1:
-            runExample1(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 2:
-            runExample2(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 3:
-            runExample3(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 4:
-            runExample4(outputDir, resolutionX, numberOfFrames);
-            break;
-        case 5:
-            runExample5(outputDir, resolutionX, numberOfFrames);
-            break;
-        default:
+    if (isBenchmark) {
+        if (!runBenchmark(
+                exampleNum, resolutions, threadCounts, numberOfFrames)) {
             printUsage();
             exit(EXIT_FAILURE);
+        }
+    } else {
+#ifdef JET_WINDOWS
+        _mkdir(outputDir.c_str());
+#else
+        mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
+#endif
+
+        RunStatistics stats;
+        if (!runExample(
+                exampleNum,
+                outputDir,
+                resolutions.front(),
+                numberOfFrames,
+                &stats)) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
     }
 
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
     return EXIT_SUCCESS;
 }
@@ -13,28 +13,58 @@
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #define APP_NAME "sph_sim"
 
 using namespace jet;
 
+// Throughput of a simulation run, reported by the benchmark mode
+struct RunStatistics {
+    size_t numberOfParticles = 0;
+    size_t numberOfFrames = 0;
+    size_t numberOfSubTimeSteps = 0;
+    double numberOfParticleSteps = 0.0;
+    double durationInSeconds = 0.0;
+};
+
+// Writes a snapshot of the particles on the background thread.
 void saveParticlePos(
     const SphSystemData3Ptr& particles,
     const std::string& rootDir,
-    unsigned int frameCnt) {
-    Array1<Vector3D> positions(particles->numberOfParticles());
-    copyRange1(
-        particles->positions(), particles->numberOfParticles(), &positions);
+    unsigned int frameCnt,
+    AsyncFileWriter* writer) {
+    size_t n = particles->numberOfParticles();
+    auto snapshot = std::make_shared<ParticleSystemData3>();
+    snapshot->setRadius(particles->radius());
+    snapshot->setMass(particles->mass());
+    snapshot->addParticles(
+        particles->positions(), particles->velocities(), particles->forces());
+    size_t densityIdx = snapshot->addScalarData();
+    size_t pressureIdx = snapshot->addScalarData();
+    auto densities = snapshot->scalarDataAt(densityIdx);
+    auto pressures = snapshot->scalarDataAt(pressureIdx);
+    copyRange1(particles->densities(), n, &densities);
+    copyRange1(particles->pressures(), n, &pressures);
+
     char basename[256];
     snprintf(basename, sizeof(basename), "frame_%06d.pos", frameCnt);
     std::string filename = pystring::os::path::join(rootDir, basename);
-    std::ofstream file(filename.c_str());
-    if (file) {
-        printf("Writing %s...\n", filename.c_str());
-        positions.serialize(&file);
-        file.close();
-    }
+    printf("Writing %s...\n", filename.c_str());
+    writer->write(
+        filename,
+        [snapshot, densityIdx, pressureIdx](std::ostream* strm) {
+            ParticleCacheWriter3 cacheWriter(*snapshot);
+            cacheWriter.addScalarChannel(
+                "density", snapshot->scalarDataAt(densityIdx));
+            cacheWriter.addScalarChannel(
+                "pressure", snapshot->scalarDataAt(pressureIdx));
+            cacheWriter.write(strm);
+        });
 }
 
 void printUsage() {
@@ -46,34 +76,83 @@ void printUsage() {
         "   -l, --log: log filename (default is " APP_NAME ".log)\n"
         "   -o, --output: output directory name "
         "(default is " APP_NAME "_output)\n"
-        "   -e, --example: example number (between 1 and 3, default is 1)\n"
+        "   -e, --example: example number (between 1 and 4, default is 1)\n"
+        "   -b, --benchmark: runs the example for each of the comma-separated "
+        "spacings of -s\n"
+        "       and thread counts of -t without writing any output, then "
+        "prints the\n"
+        "       throughput of each run in CSV (peak_rss_mb is the high-water "
+        "mark of the\n"
+        "       process, so the spacings run from the coarsest)\n"
+        "   -t, --threads: comma-separated thread counts for the benchmark "
+        "mode\n"
+        "       (default is the hardware concurrency)\n"
         "   -h, --help: print this message\n");
 }
 
+// Parses comma-separated numbers such as "0.04,0.02"
+template <typename T>
+std::vector<T> parseNumbers(const char* str) {
+    std::vector<T> numbers;
+    std::stringstream strm(str);
+    std::string token;
+    while (std::getline(strm, token, ',')) {
+        T number;
+        if (std::stringstream(token) >> number) {
+            numbers.push_back(number);
+        }
+    }
+    return numbers;
+}
+
 void printInfo(const SphSystemData3Ptr& particles) {
     printf("Number of particles: %zu\n", particles->numberOfParticles());
 }
 
-void runSimulation(
+// Runs the simulation, and writes the frames unless rootDir is empty
+RunStatistics runSimulation(
     const std::string& rootDir,
     SphSolver3* solver,
     size_t numberOfFrames) {
     auto particles = solver->sphSystemData();
+    bool isWritingOutput = !rootDir.empty();
+
+    // Writes the frames while the next ones are simulated
+    AsyncFileWriter writer;
+    if (isWritingOutput) {
+        saveParticlePos(particles, rootDir, 0, &writer);
+    }
 
-    saveParticlePos(particles, rootDir, 0);
+    RunStatistics stats;
+    stats.numberOfParticles = particles->numberOfParticles();
 
+    Timer timer;
     Frame frame(1, 1.0 / 60.0);
     for ( ; frame.index < numberOfFrames; frame.advance()) {
         solver->update(frame);
-        saveParticlePos(
-            particles,
-            rootDir,
-            frame.index);
+
+        size_t numberOfSubTimeSteps
+            = solver->lastFrameStatistics().subTimeSteps.size();
+        ++stats.numberOfFrames;
+        stats.numberOfSubTimeSteps += numberOfSubTimeSteps;
+        stats.numberOfParticleSteps += static_cast<double>(
+            numberOfSubTimeSteps * particles->numberOfParticles());
+
+        if (isWritingOutput) {
+            saveParticlePos(
+                particles,
+                rootDir,
+                frame.index,
+                &writer);
+        }
     }
+    stats.durationInSeconds = timer.durationInSeconds();
+
+    return stats;
 }
 
 // Water-drop example (PCISPH)
-void runExample1(
+RunStatistics runExample1(
     const std::string& rootDir,
     double targetSpacing,
     unsigned int numberOfFrames) {
@@ -117,11 +196,11 @@ void runExample1(
     printInfo(particles);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames);
+    return runSimulation(rootDir, &solver, numberOfFrames);
 }
 
 // Water-drop example (SPH)
-void runExample2(
+RunStatistics runExample2(
     const std::string& rootDir,
     double targetSpacing,
     unsigned int numberOfFrames) {
@@ -165,11 +244,11 @@ void runExample2(
     printInfo(particles);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames);
+    return runSimulation(rootDir, &solver, numberOfFrames);
 }
 
 // Dam-breaking example
-void runExample3(
+RunStatistics runExample3(
     const std::string& rootDir,
     double targetSpacing,
     unsigned int numberOfFrames) {
@@ -233,11 +312,138 @@ void runExample3(
     printInfo(particles);
 
     // Run simulation
-    runSimulation(rootDir, &solver, numberOfFrames);
+    return runSimulation(rootDir, &solver, numberOfFrames);
+}
+
+// Water-drop example (IISPH)
+RunStatistics runExample4(
+    const std::string& rootDir,
+    double targetSpacing,
+    unsigned int numberOfFrames) {
+    BoundingBox3D domain(Vector3D(), Vector3D(1, 2, 1));
+
+    // Initialize solvers
+    IisphSolver3 solver;
+    solver.setPseudoViscosityCoefficient(0.0);
+
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    particles->setTargetDensity(1000.0);
+    particles->setTargetSpacing(targetSpacing);
+
+    // Initialize source
+    ImplicitSurfaceSet3Ptr surfaceSet = std::make_shared<ImplicitSurfaceSet3>();
+    surfaceSet->addExplicitSurface(
+        std::make_shared<Plane3>(
+            Vector3D(0, 1, 0), Vector3D(0, 0.25 * domain.height(), 0)));
+    surfaceSet->addExplicitSurface(
+        std::make_shared<Sphere3>(
+            domain.midPoint(), 0.15 * domain.width()));
+
+    BoundingBox3D sourceBound(domain);
+    sourceBound.expand(-targetSpacing);
+
+    auto emitter = std::make_shared<VolumeParticleEmitter3>(
+        surfaceSet,
+        sourceBound,
+        targetSpacing,
+        Vector3D());
+    emitter->emit(Frame(), particles);
+
+    // Initialize boundary
+    Box3Ptr box = std::make_shared<Box3>(domain);
+    box->isNormalFlipped = true;
+    RigidBodyCollider3Ptr collider = std::make_shared<RigidBodyCollider3>(box);
+    solver.setCollider(collider);
+
+    // Print simulation info
+    printf("Running example 4 (water-drop with IISPH)\n");
+    printInfo(particles);
+
+    // Run simulation
+    return runSimulation(rootDir, &solver, numberOfFrames);
+}
+
+bool runExample(
+    int exampleNum,
+    const std::string& rootDir,
+    double targetSpacing,
+    unsigned int numberOfFrames,
+    RunStatistics* stats) {
+    switch (exampleNum) {
+        case 1:
+            *stats = runExample1(rootDir, targetSpacing, numberOfFrames);
+            return true;
+        case 2:
+            *stats = runExample2(rootDir, targetSpacing, numberOfFrames);
+            return true;
+        case 3:
+            *stats = runExample3(rootDir, targetSpacing, numberOfFrames);
+            return true;
+        case 4:
+            *stats = runExample4(rootDir, targetSpacing, numberOfFrames);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Runs the example for every pair of spacing and thread count, and prints
+// the throughput of the runs
+bool runBenchmark(
+    int exampleNum,
+    std::vector<double> targetSpacings,
+    const std::vector<unsigned int>& threadCounts,
+    unsigned int numberOfFrames) {
+    // Coarsest first, so that the peak memory usage of each run is its own
+    std::sort(
+        targetSpacings.begin(), targetSpacings.end(), std::greater<double>());
+
+    std::vector<std::string> rows;
+    for (double targetSpacing : targetSpacings) {
+        for (unsigned int numberOfThreads : threadCounts) {
+            setMaxNumberOfThreads(std::max(numberOfThreads, 1u));
+
+            RunStatistics stats;
+            if (!runExample(
+                    exampleNum, "", targetSpacing, numberOfFrames, &stats)) {
+                return false;
+            }
+
+            double seconds = std::max(stats.durationInSeconds, 1e-9);
+            char row[256];
+            snprintf(
+                row,
+                sizeof(row),
+                "%d,%g,%u,%zu,%zu,%zu,%.3f,%.3f,%.6g,%.1f",
+                exampleNum,
+                targetSpacing,
+                numberOfThreads,
+                stats.numberOfParticles,
+                stats.numberOfFrames,
+                stats.numberOfSubTimeSteps,
+                stats.durationInSeconds,
+                stats.numberOfFrames / seconds,
+                stats.numberOfParticleSteps / seconds,
+                peakResidentSetSizeInBytes() / (1024.0 * 1024.0));
+            rows.push_back(row);
+            printf("%s\n", row);
+        }
+    }
+
+    printf(
+        "\nexample,spacing,threads,particles,frames,sub_steps,seconds,"
+        "frames_per_sec,particle_steps_per_sec,peak_rss_mb\n");
+    for (const std::string& row : rows) {
+        printf("%s\n", row.c_str());
+    }
+
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    double targetSpacing = 0.02;
+    std::vector<double> targetSpacings(1, 0.02);
+    std::vector<unsigned int> threadCounts(1, maxNumberOfThreads());
+    bool isBenchmark = false;
     unsigned int numberOfFrames = 100;
     int exampleNum = 1;
     std::string logFilename = APP_NAME ".log";
@@ -250,6 +456,8 @@ int main(int argc, char* argv[]) {
         {"example",   optional_argument, 0, 'e'},
         {"log",       optional_argument, 0, 'l'},
         {"outputDir", optional_argument, 0, 'o'},
+        {"benchmark", no_argument,       0, 'b'},
+        {"threads",   optional_argument, 0, 't'},
         {"help",      optional_argument, 0, 'h'},
         {0,           0,                 0,  0 }
     };
@@ -257,10 +465,10 @@ int main(int argc, char* argv[]) {
     int opt = 0;
     int long_index = 0;
     while ((opt = getopt_long(
-        argc, argv, "s:f:e:l:o:h", longOptions, &long_index)) != -1) {
+        argc, argv, "s:f:e:l:o:bt:h", longOptions, &long_index)) != -1) {
         switch (opt) {
             case 's':
-                targetSpacing = atof(optarg);
+                targetSpacings = parseNumbers<double>(optarg);
                 break;
             case 'f':
                 numberOfFrames = static_cast<size_t>(atoi(optarg));
@@ -274,6 +482,12 @@ int main(int argc, char* argv[]) {
             case 'o':
                 outputDir = optarg;
                 break;
+            case 'b':
+                isBenchmark = true;
+                break;
+            case 't':
+                threadCounts = parseNumbers<unsigned int>(optarg);
+                break;
             case 'h':
                 printUsage();
                 exit(EXIT_SUCCESS);
@@ -283,31 +497,43 @@ int main(int argc, char* argv[]) {
         }
     }
 
-#ifdef JET_WINDOWS
-    _mkdir(outputDir.c_str());
-#else
-    mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
-#endif
+    if (targetSpacings.empty() || threadCounts.empty()) {
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
 
     std::ofstream logFile(logFilename.c_str());
     if (logFile) {
         Logging::setAllStream(&logFile);
     }
 
-    switch (exampleNum) {
-        case 1:
-            runExample1(outputDir, targetSpacing, numberOfFrames);
-            break;
-        case 2:
-            runExample2(outputDir, targetSpacing, numberOfFrames);
-            break;
-        case 3:
-            runExample3(outputDir, targetSpacing, numberOfFrames);
-            break;
-        default:
+    if (isBenchmark) {
+        if (!runBenchmark(
+                exampleNum, targetSpacings, threadCounts, numberOfFrames)) {
             printUsage();
             exit(EXIT_FAILURE);
+        }
+    } else {
+#ifdef JET_WINDOWS
+        _mkdir(outputDir.c_str());
+#else
+        mkdir(outputDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
+#endif
+
+        RunStatistics stats;
+        if (!runExample(
+                exampleNum,
+                outputDir,
+                targetSpacings.front(),
+                numberOfFrames,
+                &stats)) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
     }
 
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
     return EXIT_SUCCESS;
 }
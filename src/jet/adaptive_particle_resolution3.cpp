@@ -0,0 +1,312 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/adaptive_particle_resolution3.h>
+#include <jet/constants.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace jet;
+
+// A particle splits when it is larger than its target by this factor, and
+// merges when the merged particle is smaller by this factor, so the halves
+// of a split particle do not merge back right away.
+static const double kResolutionHysteresis = 1.1;
+
+// Relative tolerance of the min and max radii.
+static const double kRadiusTolerance = 1e-6;
+
+// Radius ratio of a parent to its halves, which have half the volume.
+static const double kSplitRadiusRatio = std::cbrt(2.0);
+
+// Number of particles per block of the parallel split.
+static const size_t kSplitBlockSize = 4096;
+
+// Deterministic direction from a particle index, spread over the sphere.
+static Vector3D splitDirection(size_t i) {
+    double u = i * 0.6180339887498949;
+    double v = i * 0.7548776662466927;
+    u -= std::floor(u);
+    v -= std::floor(v);
+
+    double z = 2.0 * u - 1.0;
+    double s = std::sqrt(std::max(1.0 - z * z, 0.0));
+    double phi = 2.0 * kPiD * v;
+    return Vector3D(s * std::cos(phi), s * std::sin(phi), z);
+}
+
+AdaptiveParticleResolution3::AdaptiveParticleResolution3(
+    const ParticleSystemData3Ptr& particles) :
+    _particles(particles) {
+    JET_THROW_INVALID_ARG_IF(_particles == nullptr);
+
+    _massDataId = _particles->addScalarData(_particles->mass());
+    _radiusDataId = _particles->addScalarData(_particles->radius());
+    _minRadius = _particles->radius();
+    _maxRadius = _particles->radius();
+}
+
+size_t AdaptiveParticleResolution3::massDataId() const {
+    return _massDataId;
+}
+
+size_t AdaptiveParticleResolution3::radiusDataId() const {
+    return _radiusDataId;
+}
+
+double AdaptiveParticleResolution3::minRadius() const {
+    return _minRadius;
+}
+
+void AdaptiveParticleResolution3::setMinRadius(double newMinRadius) {
+    _minRadius = std::max(newMinRadius, 0.0);
+}
+
+double AdaptiveParticleResolution3::maxRadius() const {
+    return _maxRadius;
+}
+
+void AdaptiveParticleResolution3::setMaxRadius(double newMaxRadius) {
+    _maxRadius = std::max(newMaxRadius, 0.0);
+}
+
+double AdaptiveParticleResolution3::transitionDistance() const {
+    return _transitionDistance;
+}
+
+void AdaptiveParticleResolution3::setTransitionDistance(double newDistance) {
+    _transitionDistance = std::max(newDistance, kEpsilonD);
+}
+
+const ScalarField3Ptr& AdaptiveParticleResolution3::surface() const {
+    return _surface;
+}
+
+void AdaptiveParticleResolution3::setSurface(
+    const ScalarField3Ptr& newSurface) {
+    _surface = newSurface;
+}
+
+double AdaptiveParticleResolution3::targetRadius(const Vector3D& x) const {
+    if (_surface == nullptr) {
+        return _maxRadius;
+    }
+
+    double t = clamp(
+        std::fabs(_surface->sample(x)) / _transitionDistance, 0.0, 1.0);
+    return lerp(_minRadius, _maxRadius, t);
+}
+
+void AdaptiveParticleResolution3::update() {
+    _lastNumberOfSplits = 0;
+    _lastNumberOfMerges = 0;
+
+    const size_t numberOfParticles = _particles->numberOfParticles();
+    if (_surface == nullptr || numberOfParticles == 0) {
+        return;
+    }
+
+    auto positions = _particles->positions();
+    Array1<double> targetRadii(numberOfParticles);
+    targetRadii.parallelForEachIndex([&](size_t i) {
+        targetRadii[i] = targetRadius(positions[i]);
+    });
+
+    std::vector<char> isChanged(numberOfParticles, 0);
+    split(targetRadii, &isChanged);
+    merge(targetRadii, isChanged);
+}
+
+size_t AdaptiveParticleResolution3::lastNumberOfSplits() const {
+    return _lastNumberOfSplits;
+}
+
+size_t AdaptiveParticleResolution3::lastNumberOfMerges() const {
+    return _lastNumberOfMerges;
+}
+
+void AdaptiveParticleResolution3::split(
+    const Array1<double>& targetRadii, std::vector<char>* isChanged) {
+    const size_t numberOfParticles = targetRadii.size();
+    const double minRadius = _minRadius * (1.0 - kRadiusTolerance);
+
+    // Counts the splitting particles per block, so the children of each
+    // block are appended at the prefix sum of the counts in the order of
+    // their parents
+    const size_t numberOfBlocks
+        = (numberOfParticles + kSplitBlockSize - 1) / kSplitBlockSize;
+    std::vector<size_t> blockOffsets(numberOfBlocks + 1, 0);
+    {
+        auto radii = _particles->scalarDataAt(_radiusDataId);
+        parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+            size_t begin = b * kSplitBlockSize;
+            size_t end = std::min(begin + kSplitBlockSize, numberOfParticles);
+            size_t count = 0;
+            for (size_t i = begin; i < end; ++i) {
+                (*isChanged)[i]
+                    = radii[i] > kResolutionHysteresis * targetRadii[i]
+                    && radii[i] / kSplitRadiusRatio >= minRadius;
+                count += (*isChanged)[i];
+            }
+            blockOffsets[b + 1] = count;
+        });
+    }
+    for (size_t b = 0; b < numberOfBlocks; ++b) {
+        blockOffsets[b + 1] += blockOffsets[b];
+    }
+
+    _lastNumberOfSplits = blockOffsets[numberOfBlocks];
+    if (_lastNumberOfSplits == 0) {
+        return;
+    }
+
+    _particles->resize(numberOfParticles + _lastNumberOfSplits);
+
+    const size_t numberOfScalarData = _particles->numberOfScalarData();
+    const size_t numberOfVectorData = _particles->numberOfVectorData();
+    auto positions = _particles->positions();
+    auto velocities = _particles->velocities();
+    auto forces = _particles->forces();
+    auto masses = _particles->scalarDataAt(_massDataId);
+    auto radii = _particles->scalarDataAt(_radiusDataId);
+
+    // The parent becomes one half, and the other half is appended
+    parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+        size_t begin = b * kSplitBlockSize;
+        size_t end = std::min(begin + kSplitBlockSize, numberOfParticles);
+        size_t child = numberOfParticles + blockOffsets[b];
+        for (size_t p = begin; p < end; ++p) {
+            if (!(*isChanged)[p]) {
+                continue;
+            }
+
+            velocities[child] = velocities[p];
+            for (size_t s = 0; s < numberOfScalarData; ++s) {
+                auto data = _particles->scalarDataAt(s);
+                data[child] = data[p];
+            }
+            for (size_t v = 0; v < numberOfVectorData; ++v) {
+                auto data = _particles->vectorDataAt(v);
+                data[child] = data[p];
+            }
+
+            forces[p] *= 0.5;
+            forces[child] = forces[p];
+            masses[p] *= 0.5;
+            masses[child] = masses[p];
+            radii[p] /= kSplitRadiusRatio;
+            radii[child] = radii[p];
+
+            Vector3D offset = 0.5 * radii[p] * splitDirection(p);
+            positions[child] = positions[p] + offset;
+            positions[p] -= offset;
+            ++child;
+        }
+    });
+}
+
+void AdaptiveParticleResolution3::merge(
+    const Array1<double>& targetRadii, const std::vector<char>& isChanged) {
+    // Only the particles before the split are merged, at most once
+    const size_t numberOfCandidates = targetRadii.size();
+    const double maxRadius = _maxRadius * (1.0 + kRadiusTolerance);
+
+    auto positions = _particles->positions();
+    auto radii = _particles->scalarDataAt(_radiusDataId);
+
+    std::vector<char> isMergeable(numberOfCandidates, 0);
+    parallelFor(kZeroSize, numberOfCandidates, [&](size_t i) {
+        double mergedRadius = radii[i] * kSplitRadiusRatio;
+        isMergeable[i] = !isChanged[i]
+            && mergedRadius * kResolutionHysteresis < targetRadii[i]
+            && mergedRadius <= maxRadius;
+    });
+
+    _particles->buildNeighborSearcher(2.0 * _maxRadius);
+    auto searcher = _particles->neighborSearcher();
+
+    // Greedy pairing with the nearest mergeable neighbor
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t i = 0; i < numberOfCandidates; ++i) {
+        if (!isMergeable[i]) {
+            continue;
+        }
+
+        size_t nearest = kMaxSize;
+        double nearestDistance = std::numeric_limits<double>::max();
+        searcher->forEachNearbyPoint(
+            positions[i],
+            2.0 * radii[i],
+            [&](size_t j, const Vector3D& x) {
+                if (j == i || j >= numberOfCandidates || !isMergeable[j]) {
+                    return;
+                }
+
+                double mergedRadius
+                    = std::cbrt(cubic(radii[i]) + cubic(radii[j]));
+                if (mergedRadius * kResolutionHysteresis
+                        >= std::min(targetRadii[i], targetRadii[j])
+                    || mergedRadius > maxRadius) {
+                    return;
+                }
+
+                double distance = positions[i].distanceTo(x);
+                if (distance < nearestDistance
+                    || (distance == nearestDistance && j < nearest)) {
+                    nearest = j;
+                    nearestDistance = distance;
+                }
+            });
+
+        if (nearest != kMaxSize) {
+            isMergeable[i] = 0;
+            isMergeable[nearest] = 0;
+            pairs.emplace_back(i, nearest);
+        }
+    }
+
+    _lastNumberOfMerges = pairs.size();
+    if (pairs.empty()) {
+        return;
+    }
+
+    const size_t numberOfScalarData = _particles->numberOfScalarData();
+    const size_t numberOfVectorData = _particles->numberOfVectorData();
+    auto velocities = _particles->velocities();
+    auto forces = _particles->forces();
+    auto masses = _particles->scalarDataAt(_massDataId);
+
+    // The first of each pair becomes the mass-weighted average
+    std::vector<char> isRemoved(_particles->numberOfParticles(), 0);
+    parallelFor(kZeroSize, pairs.size(), [&](size_t n) {
+        const size_t i = pairs[n].first;
+        const size_t j = pairs[n].second;
+        const double mass = masses[i] + masses[j];
+        const double radius = std::cbrt(cubic(radii[i]) + cubic(radii[j]));
+        const double wi = masses[i] / mass;
+        const double wj = masses[j] / mass;
+
+        positions[i] = wi * positions[i] + wj * positions[j];
+        velocities[i] = wi * velocities[i] + wj * velocities[j];
+        forces[i] += forces[j];
+        for (size_t s = 0; s < numberOfScalarData; ++s) {
+            auto data = _particles->scalarDataAt(s);
+            data[i] = wi * data[i] + wj * data[j];
+        }
+        for (size_t v = 0; v < numberOfVectorData; ++v) {
+            auto data = _particles->vectorDataAt(v);
+            data[i] = wi * data[i] + wj * data[j];
+        }
+
+        masses[i] = mass;
+        radii[i] = radius;
+        isRemoved[j] = 1;
+    });
+
+    _particles->removeParticles([&](size_t i) {
+        return isRemoved[i] != 0;
+    });
+}
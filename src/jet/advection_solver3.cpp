@@ -2,16 +2,60 @@
 
 #include <pch.h>
 #include <jet/advection_solver3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
 #include <limits>
 
 using namespace jet;
 
+// Returns a double-precision grid with the same data layout as the given
+// single-precision grid, holding its data
+static ScalarGrid3Ptr toDoublePrecision(const ScalarGrid3F& grid) {
+    ScalarGrid3Ptr result;
+    if (dynamic_cast<const CellCenteredScalarGrid3F*>(&grid) != nullptr) {
+        result = std::make_shared<CellCenteredScalarGrid3>(
+            grid.resolution(), grid.gridSpacing(), grid.origin());
+    } else {
+        JET_THROW_INVALID_ARG_IF(
+            dynamic_cast<const VertexCenteredScalarGrid3F*>(&grid)
+                == nullptr);
+        result = std::make_shared<VertexCenteredScalarGrid3>(
+            grid.resolution(), grid.gridSpacing(), grid.origin());
+    }
+
+    auto src = grid.constDataAccessor();
+    auto dst = result->dataAccessor();
+    result->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        dst(i, j, k) = static_cast<double>(src(i, j, k));
+    });
+    return result;
+}
+
 AdvectionSolver3::AdvectionSolver3() {
 }
 
 AdvectionSolver3::~AdvectionSolver3() {
 }
 
+void AdvectionSolver3::advect(
+    const ScalarGrid3F& input,
+    const VectorField3& flow,
+    double dt,
+    ScalarGrid3F* output,
+    const ScalarField3& boundarySdf) {
+    // The output is staged as well, since the advection may leave the data
+    // points inside the boundary as they are
+    ScalarGrid3Ptr input64 = toDoublePrecision(input);
+    ScalarGrid3Ptr output64 = toDoublePrecision(*output);
+    advect(*input64, flow, dt, output64.get(), boundarySdf);
+
+    auto src = output64->constDataAccessor();
+    auto dst = output->dataAccessor();
+    output->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        dst(i, j, k) = static_cast<float>(src(i, j, k));
+    });
+}
+
 void AdvectionSolver3::advect(
     const CollocatedVectorGrid3& source,
     const VectorField3& flow,
@@ -37,3 +81,23 @@ void AdvectionSolver3::advect(
     UNUSED_VARIABLE(target);
     UNUSED_VARIABLE(boundarySdf);
 }
+
+void AdvectionSolver3::advect(
+    const std::vector<const ScalarGrid3*>& scalarInputs,
+    const std::vector<const CollocatedVectorGrid3*>& vectorInputs,
+    const VectorField3& flow,
+    double dt,
+    const std::vector<ScalarGrid3*>& scalarOutputs,
+    const std::vector<CollocatedVectorGrid3*>& vectorOutputs,
+    const ScalarField3& boundarySdf) {
+    JET_THROW_INVALID_ARG_IF(scalarInputs.size() != scalarOutputs.size());
+    JET_THROW_INVALID_ARG_IF(vectorInputs.size() != vectorOutputs.size());
+
+    for (size_t c = 0; c < scalarInputs.size(); ++c) {
+        advect(*scalarInputs[c], flow, dt, scalarOutputs[c], boundarySdf);
+    }
+
+    for (size_t c = 0; c < vectorInputs.size(); ++c) {
+        advect(*vectorInputs[c], flow, dt, vectorOutputs[c], boundarySdf);
+    }
+}
@@ -48,6 +48,8 @@ Animation::~Animation() {
 }
 
 void Animation::update(const Frame& frame) {
+    std::lock_guard<std::recursive_mutex> lock(_stateMutex);
+
     Timer timer;
 
     JET_INFO << "Begin updating frame: " << frame.index
@@ -60,3 +62,23 @@ void Animation::update(const Frame& frame) {
     JET_INFO << "End updating frame (took " << timer.durationInSeconds()
              << " seconds)";
 }
+
+std::shared_future<void> Animation::updateAsync(const Frame& frame) {
+    std::shared_future<void> previousUpdate = _lastAsyncUpdate;
+    _lastAsyncUpdate = std::async(
+        std::launch::async,
+        [this, frame, previousUpdate] {
+            // A failed previous update does not stop this one, and its
+            // exception is only reported by its own future
+            if (previousUpdate.valid()) {
+                previousUpdate.wait();
+            }
+            update(frame);
+        }).share();
+    return _lastAsyncUpdate;
+}
+
+void Animation::readState(const std::function<void()>& reader) const {
+    std::lock_guard<std::recursive_mutex> lock(_stateMutex);
+    reader();
+}
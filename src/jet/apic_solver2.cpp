@@ -0,0 +1,157 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/apic_solver2.h>
+#include <pic_helpers.h>
+
+using namespace jet;
+
+namespace {
+
+// Clamps the position into the box spanned by the sample points of a
+// face-centered data, so that the affine term uses the same stencil as the
+// (clamped) sampler.
+Vector2D clampToSamples(
+    const Vector2D& pt,
+    const Vector2D& origin,
+    const Vector2D& gridSpacing,
+    const Size2& size) {
+    return Vector2D(
+        clamp(pt.x, origin.x, origin.x + gridSpacing.x * (size.x - 1.0)),
+        clamp(pt.y, origin.y, origin.y + gridSpacing.y * (size.y - 1.0)));
+}
+
+Vector2D samplePosition(
+    const Point2UI& index,
+    const Vector2D& origin,
+    const Vector2D& gridSpacing) {
+    return origin + gridSpacing * Vector2D(index.x, index.y);
+}
+
+}  // namespace
+
+ApicSolver2::ApicSolver2() {
+    auto particles = particleSystemData();
+    _cXDataId = particles->addVectorData();
+    _cYDataId = particles->addVectorData();
+}
+
+ApicSolver2::~ApicSolver2() {
+}
+
+void ApicSolver2::transferFromParticlesToGrids() {
+    auto flow = gridSystemData()->velocity();
+    auto particles = particleSystemData();
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    auto cX = particles->vectorDataAt(_cXDataId);
+    auto cY = particles->vectorDataAt(_cYDataId);
+    const Vector2D h = flow->gridSpacing();
+    const Vector2D uOrigin = flow->uOrigin();
+    const Vector2D vOrigin = flow->vOrigin();
+    const Size2 uSize = flow->uSize();
+    const Size2 vSize = flow->vSize();
+
+    // Clear velocity to zero
+    flow->fill(Vector2D());
+
+    // Weighted-average velocity including the affine term
+    auto u = flow->uAccessor();
+    auto v = flow->vAccessor();
+    _uWeights.resize(u.size());
+    _vWeights.resize(v.size());
+    _uWeights.set(0.0);
+    _vWeights.set(0.0);
+    _uMarkers.resize(u.size());
+    _vMarkers.resize(v.size());
+    _uMarkers.set(0);
+    _vMarkers.set(0);
+    LinearArraySampler2<double, double> uSampler(
+        flow->uConstAccessor(), h, uOrigin);
+    LinearArraySampler2<double, double> vSampler(
+        flow->vConstAccessor(), h, vOrigin);
+
+    splatParticles(
+        uSampler,
+        positions,
+        [&](size_t i, const Point2UI& index) {
+            Vector2D x = clampToSamples(positions[i], uOrigin, h, uSize);
+            Vector2D gridPos = samplePosition(index, uOrigin, h);
+            return velocities[i].x + cX[i].dot(gridPos - x);
+        },
+        u,
+        _uWeights.accessor(),
+        _uMarkers.accessor(),
+        &_splatKeys,
+        &_splatIndices);
+    splatParticles(
+        vSampler,
+        positions,
+        [&](size_t i, const Point2UI& index) {
+            Vector2D x = clampToSamples(positions[i], vOrigin, h, vSize);
+            Vector2D gridPos = samplePosition(index, vOrigin, h);
+            return velocities[i].y + cY[i].dot(gridPos - x);
+        },
+        v,
+        _vWeights.accessor(),
+        _vMarkers.accessor(),
+        &_splatKeys,
+        &_splatIndices);
+
+    _uWeights.parallelForEachIndex([&](size_t i, size_t j) {
+        if (_uWeights(i, j) > 0.0) {
+            u(i, j) /= _uWeights(i, j);
+        }
+    });
+    _vWeights.parallelForEachIndex([&](size_t i, size_t j) {
+        if (_vWeights(i, j) > 0.0) {
+            v(i, j) /= _vWeights(i, j);
+        }
+    });
+}
+
+void ApicSolver2::transferFromGridsToParticles() {
+    auto flow = gridSystemData()->velocity();
+    auto particles = particleSystemData();
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    auto cX = particles->vectorDataAt(_cXDataId);
+    auto cY = particles->vectorDataAt(_cYDataId);
+    size_t numberOfParticles = particles->numberOfParticles();
+    const Vector2D h = flow->gridSpacing();
+    const Vector2D uOrigin = flow->uOrigin();
+    const Vector2D vOrigin = flow->vOrigin();
+    const Size2 uSize = flow->uSize();
+    const Size2 vSize = flow->vSize();
+    auto u = flow->uConstAccessor();
+    auto v = flow->vConstAccessor();
+    LinearArraySampler2<double, double> uSampler(u, h, uOrigin);
+    LinearArraySampler2<double, double> vSampler(v, h, vOrigin);
+
+    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+        velocities[i] = flow->sample(positions[i]);
+
+        std::array<Point2UI, 4> indices;
+        std::array<Vector2D, 4> gradWeights;
+
+        // Affine velocity of each component is the gradient of the
+        // interpolated velocity at the particle
+        uSampler.getCoordinatesAndGradientWeights(
+            clampToSamples(positions[i], uOrigin, h, uSize),
+            &indices,
+            &gradWeights);
+        cX[i] = Vector2D();
+        for (int j = 0; j < 4; ++j) {
+            cX[i] += gradWeights[j] * u(indices[j]);
+        }
+
+        vSampler.getCoordinatesAndGradientWeights(
+            clampToSamples(positions[i], vOrigin, h, vSize),
+            &indices,
+            &gradWeights);
+        cY[i] = Vector2D();
+        for (int j = 0; j < 4; ++j) {
+            cY[i] += gradWeights[j] * v(indices[j]);
+        }
+    });
+}
@@ -0,0 +1,211 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/apic_solver3.h>
+#include <pic_helpers.h>
+
+using namespace jet;
+
+namespace {
+
+// Clamps the position into the box spanned by the sample points of a
+// face-centered data, so that the affine term uses the same stencil as the
+// (clamped) sampler.
+Vector3D clampToSamples(
+    const Vector3D& pt,
+    const Vector3D& origin,
+    const Vector3D& gridSpacing,
+    const Size3& size) {
+    return Vector3D(
+        clamp(pt.x, origin.x, origin.x + gridSpacing.x * (size.x - 1.0)),
+        clamp(pt.y, origin.y, origin.y + gridSpacing.y * (size.y - 1.0)),
+        clamp(pt.z, origin.z, origin.z + gridSpacing.z * (size.z - 1.0)));
+}
+
+Vector3D samplePosition(
+    const Point3UI& index,
+    const Vector3D& origin,
+    const Vector3D& gridSpacing) {
+    return origin + gridSpacing * Vector3D(index.x, index.y, index.z);
+}
+
+}  // namespace
+
+ApicSolver3::ApicSolver3() {
+    auto particles = particleSystemData();
+    _cXDataId = particles->addVectorData();
+    _cYDataId = particles->addVectorData();
+    _cZDataId = particles->addVectorData();
+}
+
+ApicSolver3::~ApicSolver3() {
+}
+
+void ApicSolver3::transferFromParticlesToGrids() {
+    auto flow = gridSystemData()->velocity();
+    auto particles = particleSystemData();
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    auto cX = particles->vectorDataAt(_cXDataId);
+    auto cY = particles->vectorDataAt(_cYDataId);
+    auto cZ = particles->vectorDataAt(_cZDataId);
+    const Vector3D h = flow->gridSpacing();
+    const Vector3D uOrigin = flow->uOrigin();
+    const Vector3D vOrigin = flow->vOrigin();
+    const Vector3D wOrigin = flow->wOrigin();
+    const Size3 uSize = flow->uSize();
+    const Size3 vSize = flow->vSize();
+    const Size3 wSize = flow->wSize();
+
+    // Clear velocity to zero
+    flow->fill(Vector3D());
+
+    // Weighted-average velocity including the affine term
+    auto u = flow->uAccessor();
+    auto v = flow->vAccessor();
+    auto w = flow->wAccessor();
+    _uWeights.resize(u.size());
+    _vWeights.resize(v.size());
+    _wWeights.resize(w.size());
+    _uWeights.set(0.0);
+    _vWeights.set(0.0);
+    _wWeights.set(0.0);
+    _uMarkers.resize(u.size());
+    _vMarkers.resize(v.size());
+    _wMarkers.resize(w.size());
+    _uMarkers.set(false);
+    _vMarkers.set(false);
+    _wMarkers.set(false);
+    const ParticleCellBins3& bins = particleBins();
+    LinearArraySampler3<double, double> uSampler(
+        flow->uConstAccessor(), h, uOrigin);
+    LinearArraySampler3<double, double> vSampler(
+        flow->vConstAccessor(), h, vOrigin);
+    LinearArraySampler3<double, double> wSampler(
+        flow->wConstAccessor(), h, wOrigin);
+
+    splatParticles(
+        bins,
+        [&](size_t i,
+            std::array<Point3UI, 8>* indices,
+            std::array<double, 8>* weights) {
+            uSampler.getCoordinatesAndWeights(positions[i], indices, weights);
+        },
+        [&](size_t i, const Point3UI& index) {
+            Vector3D x = clampToSamples(positions[i], uOrigin, h, uSize);
+            Vector3D gridPos = samplePosition(index, uOrigin, h);
+            return velocities[i].x + cX[i].dot(gridPos - x);
+        },
+        u,
+        _uWeights.accessor(),
+        &_uMarkers);
+    splatParticles(
+        bins,
+        [&](size_t i,
+            std::array<Point3UI, 8>* indices,
+            std::array<double, 8>* weights) {
+            vSampler.getCoordinatesAndWeights(positions[i], indices, weights);
+        },
+        [&](size_t i, const Point3UI& index) {
+            Vector3D x = clampToSamples(positions[i], vOrigin, h, vSize);
+            Vector3D gridPos = samplePosition(index, vOrigin, h);
+            return velocities[i].y + cY[i].dot(gridPos - x);
+        },
+        v,
+        _vWeights.accessor(),
+        &_vMarkers);
+    splatParticles(
+        bins,
+        [&](size_t i,
+            std::array<Point3UI, 8>* indices,
+            std::array<double, 8>* weights) {
+            wSampler.getCoordinatesAndWeights(positions[i], indices, weights);
+        },
+        [&](size_t i, const Point3UI& index) {
+            Vector3D x = clampToSamples(positions[i], wOrigin, h, wSize);
+            Vector3D gridPos = samplePosition(index, wOrigin, h);
+            return velocities[i].z + cZ[i].dot(gridPos - x);
+        },
+        w,
+        _wWeights.accessor(),
+        &_wMarkers);
+
+    _uWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_uWeights(i, j, k) > 0.0) {
+            u(i, j, k) /= _uWeights(i, j, k);
+        }
+    });
+    _vWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_vWeights(i, j, k) > 0.0) {
+            v(i, j, k) /= _vWeights(i, j, k);
+        }
+    });
+    _wWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_wWeights(i, j, k) > 0.0) {
+            w(i, j, k) /= _wWeights(i, j, k);
+        }
+    });
+}
+
+void ApicSolver3::transferFromGridsToParticles() {
+    auto flow = gridSystemData()->velocity();
+    auto particles = particleSystemData();
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    auto cX = particles->vectorDataAt(_cXDataId);
+    auto cY = particles->vectorDataAt(_cYDataId);
+    auto cZ = particles->vectorDataAt(_cZDataId);
+    size_t numberOfParticles = particles->numberOfParticles();
+    const Vector3D h = flow->gridSpacing();
+    const Vector3D uOrigin = flow->uOrigin();
+    const Vector3D vOrigin = flow->vOrigin();
+    const Vector3D wOrigin = flow->wOrigin();
+    const Size3 uSize = flow->uSize();
+    const Size3 vSize = flow->vSize();
+    const Size3 wSize = flow->wSize();
+    auto u = flow->uConstAccessor();
+    auto v = flow->vConstAccessor();
+    auto w = flow->wConstAccessor();
+    LinearArraySampler3<double, double> uSampler(u, h, uOrigin);
+    LinearArraySampler3<double, double> vSampler(v, h, vOrigin);
+    LinearArraySampler3<double, double> wSampler(w, h, wOrigin);
+
+    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+        velocities[i] = Vector3D(
+            uSampler(positions[i]),
+            vSampler(positions[i]),
+            wSampler(positions[i]));
+
+        std::array<Point3UI, 8> indices;
+        std::array<Vector3D, 8> gradWeights;
+
+        // Affine velocity of each component is the gradient of the
+        // interpolated velocity at the particle
+        uSampler.getCoordinatesAndGradientWeights(
+            clampToSamples(positions[i], uOrigin, h, uSize),
+            &indices,
+            &gradWeights);
+        cX[i] = Vector3D();
+        for (int j = 0; j < 8; ++j) {
+            cX[i] += gradWeights[j] * u(indices[j]);
+        }
+
+        vSampler.getCoordinatesAndGradientWeights(
+            clampToSamples(positions[i], vOrigin, h, vSize),
+            &indices,
+            &gradWeights);
+        cY[i] = Vector3D();
+        for (int j = 0; j < 8; ++j) {
+            cY[i] += gradWeights[j] * v(indices[j]);
+        }
+
+        wSampler.getCoordinatesAndGradientWeights(
+            clampToSamples(positions[i], wOrigin, h, wSize),
+            &indices,
+            &gradWeights);
+        cZ[i] = Vector3D();
+        for (int j = 0; j < 8; ++j) {
+            cZ[i] += gradWeights[j] * w(indices[j]);
+        }
+    });
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+
+#include <jet/array_allocator.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+using jet::ArrayHugePagePolicy;
+
+const size_t kHugePageSize = 1 << 21;
+
+std::atomic<ArrayHugePagePolicy> sHugePagePolicy(ArrayHugePagePolicy::None);
+
+std::atomic<size_t> sHugePageMinBytes(16 * kHugePageSize);
+
+size_t roundUpToHugePage(size_t bytes) {
+    return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+
+// Maps the bytes with regular pages aligned to the huge page size, and asks
+// the kernel to back them with transparent huge pages
+void* mapTransparentHugePages(size_t bytes) {
+    // Over-maps by a huge page, then trims both ends to the alignment
+    size_t overMappedBytes = bytes + kHugePageSize;
+    void* mapped = mmap(
+        nullptr, overMappedBytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uintptr_t begin = reinterpret_cast<uintptr_t>(mapped);
+    uintptr_t aligned = (begin + kHugePageSize - 1)
+        & ~static_cast<uintptr_t>(kHugePageSize - 1);
+    if (aligned > begin) {
+        munmap(mapped, aligned - begin);
+    }
+    uintptr_t end = begin + overMappedBytes;
+    if (end > aligned + bytes) {
+        munmap(reinterpret_cast<void*>(aligned + bytes),
+               end - (aligned + bytes));
+    }
+
+    // Without THP enabled, madvise fails and the regular pages are kept
+    void* block = reinterpret_cast<void*>(aligned);
+    madvise(block, bytes, MADV_HUGEPAGE);
+    return block;
+}
+
+#endif
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+
+// Maps the bytes from the pool of explicit huge pages, which fails if the
+// pool has fewer free pages
+void* mapExplicitHugePages(size_t bytes) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+    flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+    void* mapped = mmap(
+        nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return (mapped == MAP_FAILED) ? nullptr : mapped;
+}
+
+#endif
+
+}  // namespace
+
+namespace jet {
+
+ArrayHugePagePolicy arrayHugePagePolicy() {
+    return sHugePagePolicy.load(std::memory_order_relaxed);
+}
+
+void setArrayHugePagePolicy(ArrayHugePagePolicy policy) {
+    JET_THROW_INVALID_ARG_IF(!isArrayHugePagePolicySupported(policy));
+
+    sHugePagePolicy = policy;
+}
+
+bool isArrayHugePagePolicySupported(ArrayHugePagePolicy policy) {
+    switch (policy) {
+        case ArrayHugePagePolicy::None:
+            return true;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        case ArrayHugePagePolicy::Transparent:
+            return true;
+#endif
+#if defined(__linux__) && defined(MAP_HUGETLB) && defined(MADV_HUGEPAGE)
+        case ArrayHugePagePolicy::Explicit:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+size_t arrayHugePageMinBytes() {
+    return sHugePageMinBytes.load(std::memory_order_relaxed);
+}
+
+void setArrayHugePageMinBytes(size_t bytes) {
+    sHugePageMinBytes = bytes;
+}
+
+namespace internal {
+
+void* mapHugePageArrayMemory(size_t bytes, size_t* mappedBytes) {
+    if (bytes > std::numeric_limits<size_t>::max() - 2 * kHugePageSize) {
+        return nullptr;
+    }
+
+    size_t roundedBytes = roundUpToHugePage(bytes);
+    void* block = nullptr;
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if (arrayHugePagePolicy() == ArrayHugePagePolicy::Explicit) {
+        block = mapExplicitHugePages(roundedBytes);
+    }
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (block == nullptr) {
+        block = mapTransparentHugePages(roundedBytes);
+    }
+#endif
+
+    *mappedBytes = (block != nullptr) ? roundedBytes : 0;
+    return block;
+}
+
+void unmapHugePageArrayMemory(void* block, size_t mappedBytes) {
+#if defined(__linux__)
+    munmap(block, mappedBytes);
+#else
+    UNUSED_VARIABLE(block);
+    UNUSED_VARIABLE(mappedBytes);
+#endif
+}
+
+}  // namespace internal
+
+}  // namespace jet
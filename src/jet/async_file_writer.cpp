@@ -0,0 +1,107 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/async_file_writer.h>
+#include <jet/logging.h>
+
+#include <fstream>
+#include <string>
+
+using namespace jet;
+
+AsyncFileWriter::AsyncFileWriter(size_t maxNumberOfPendingWrites) :
+    _maxNumberOfPendingWrites(maxNumberOfPendingWrites) {
+    JET_THROW_INVALID_ARG_IF(maxNumberOfPendingWrites == 0);
+    _thread = std::thread([this] { run(); });
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+    _taskQueued.notify_one();
+    _thread.join();
+
+    if (_exception) {
+        JET_ERROR << "An asynchronous write failed after the last flush.";
+    }
+}
+
+void AsyncFileWriter::write(
+    const std::string& filename,
+    const WriteFunction& func) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _taskFinished.wait(lock, [this] {
+        return _tasks.size() < _maxNumberOfPendingWrites;
+    });
+    rethrowException();
+
+    Task task;
+    task.filename = filename;
+    task.func = func;
+    _tasks.push_back(task);
+    lock.unlock();
+
+    _taskQueued.notify_one();
+}
+
+void AsyncFileWriter::flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _taskFinished.wait(lock, [this] { return _tasks.empty(); });
+    rethrowException();
+}
+
+size_t AsyncFileWriter::maxNumberOfPendingWrites() const {
+    return _maxNumberOfPendingWrites;
+}
+
+size_t AsyncFileWriter::numberOfPendingWrites() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _tasks.size();
+}
+
+void AsyncFileWriter::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _taskQueued.wait(lock, [this] {
+            return !_tasks.empty() || _isStopping;
+        });
+        if (_tasks.empty()) {
+            break;
+        }
+
+        // The task stays in the queue while running, so it is counted as
+        // pending until it finishes
+        Task& task = _tasks.front();
+        lock.unlock();
+
+        std::exception_ptr exception;
+        try {
+            std::ofstream file(task.filename.c_str(), std::ofstream::binary);
+            if (file) {
+                task.func(&file);
+                file.close();
+            } else {
+                JET_ERROR << "Cannot write file " << task.filename;
+            }
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        lock.lock();
+        if (exception && !_exception) {
+            _exception = exception;
+        }
+        _tasks.pop_front();
+        _taskFinished.notify_all();
+    }
+}
+
+void AsyncFileWriter::rethrowException() {
+    if (_exception) {
+        std::exception_ptr exception = _exception;
+        _exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
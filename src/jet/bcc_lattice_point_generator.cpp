@@ -2,6 +2,9 @@
 
 #include <pch.h>
 #include <jet/bcc_lattice_point_generator.h>
+#include <point_generator_helpers.h>
+
+#include <algorithm>
 
 namespace jet {
 
@@ -38,4 +41,59 @@ void BccLatticePointGenerator::forEachPoint(
     }
 }
 
+size_t BccLatticePointGenerator::numberOfSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing) const {
+    return numberOfLatticeSteps(spacing / 2.0, 0.0, boundingBox.depth());
+}
+
+size_t BccLatticePointGenerator::countPointsInSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd) const {
+    double halfSpacing = spacing / 2.0;
+    sliceEnd = std::min(sliceEnd, numberOfSlices(boundingBox, spacing));
+
+    size_t count = 0;
+    for (size_t k = sliceBegin; k < sliceEnd; ++k) {
+        double offset = (k % 2 == 1) ? halfSpacing : 0.0;
+        count += numberOfLatticeSteps(spacing, offset, boundingBox.height())
+            * numberOfLatticeSteps(spacing, offset, boundingBox.width());
+    }
+    return count;
+}
+
+void BccLatticePointGenerator::generateRange(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd,
+    ArrayAccessor1<Vector3D> points) const {
+    double halfSpacing = spacing / 2.0;
+    sliceEnd = std::min(sliceEnd, numberOfSlices(boundingBox, spacing));
+
+    Vector3D position;
+    size_t n = 0;
+    for (size_t k = sliceBegin; k < sliceEnd; ++k) {
+        position.z = k * halfSpacing + boundingBox.lowerCorner.z;
+
+        double offset = (k % 2 == 1) ? halfSpacing : 0.0;
+        size_t numberOfRows
+            = numberOfLatticeSteps(spacing, offset, boundingBox.height());
+        size_t numberOfColumns
+            = numberOfLatticeSteps(spacing, offset, boundingBox.width());
+
+        for (size_t j = 0; j < numberOfRows; ++j) {
+            position.y = j * spacing + offset + boundingBox.lowerCorner.y;
+
+            for (size_t i = 0; i < numberOfColumns; ++i) {
+                position.x = i * spacing + offset + boundingBox.lowerCorner.x;
+                points[n++] = position;
+            }
+        }
+    }
+    JET_ASSERT(n == points.size());
+}
+
 }  // namespace jet
@@ -0,0 +1,10 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/bfecc_advection3.h>
+
+using namespace jet;
+
+BfeccAdvection3::BfeccAdvection3() :
+    ErrorCorrectedSemiLagrangian3(Scheme::Bfecc) {
+}
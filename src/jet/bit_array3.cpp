@@ -0,0 +1,151 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/bit_array3.h>
+#include <jet/parallel.h>
+#include <algorithm>
+#include <utility>
+
+using namespace jet;
+
+const size_t BitArray3::kBitsPerWord;
+
+BitArray3::BitArray3() {
+}
+
+BitArray3::BitArray3(const Size3& size, bool initVal) {
+    resize(size, initVal);
+}
+
+void BitArray3::resize(const Size3& size, bool initVal) {
+    _size = size;
+    _wordsPerRow = (size.x + kBitsPerWord - 1) / kBitsPerWord;
+
+    size_t lastBits = size.x % kBitsPerWord;
+    _lastWordMask = (lastBits == 0) ? ~Word(0) : (Word(1) << lastBits) - 1;
+
+    _data.resize(_wordsPerRow * size.y * size.z);
+    set(initVal);
+}
+
+void BitArray3::set(bool value) {
+    if (!value || _wordsPerRow == 0) {
+        std::fill(_data.begin(), _data.end(), Word(0));
+        return;
+    }
+
+    parallelFor(kZeroSize, _size.y * _size.z, [&](size_t r) {
+        Word* words = _data.data() + _wordsPerRow * r;
+        std::fill(words, words + _wordsPerRow, ~Word(0));
+        words[_wordsPerRow - 1] = _lastWordMask;
+    });
+}
+
+void BitArray3::set(const ConstArrayAccessor3<char>& mask) {
+    if (mask.size() != _size) {
+        resize(mask.size());
+    }
+
+    parallelSet([&](size_t i, size_t j, size_t k) {
+        return mask(i, j, k) != 0;
+    });
+}
+
+Size3 BitArray3::size() const {
+    return _size;
+}
+
+size_t BitArray3::wordsPerRow() const {
+    return _wordsPerRow;
+}
+
+size_t BitArray3::count() const {
+    return parallelReduce(
+        kZeroSize,
+        _data.size(),
+        kZeroSize,
+        [&](size_t begin, size_t end, size_t init) {
+            for (size_t w = begin; w < end; ++w) {
+                init += internal::countSetBits(_data[w]);
+            }
+            return init;
+        },
+        [](size_t a, size_t b) { return a + b; });
+}
+
+void BitArray3::dilate(BitArray3* output) const {
+    if (output->_size != _size) {
+        output->resize(_size);
+    }
+
+    const size_t n = _wordsPerRow;
+    const size_t carry = kBitsPerWord - 1;
+
+    parallelFor(kZeroSize, _size.y * _size.z, [&](size_t r) {
+        size_t j = r % _size.y;
+        size_t k = r / _size.y;
+        const Word* center = row(j, k);
+        const Word* neighbors[4] = {
+            (j > 0) ? row(j - 1, k) : nullptr,
+            (j + 1 < _size.y) ? row(j + 1, k) : nullptr,
+            (k > 0) ? row(j, k - 1) : nullptr,
+            (k + 1 < _size.z) ? row(j, k + 1) : nullptr
+        };
+        Word* out = output->row(j, k);
+
+        for (size_t w = 0; w < n; ++w) {
+            Word c = center[w];
+
+            // Shifts along x with the carries from the adjacent words
+            Word word = c | (c << 1) | (c >> 1);
+            if (w > 0) {
+                word |= center[w - 1] >> carry;
+            }
+            if (w + 1 < n) {
+                word |= center[w + 1] << carry;
+            }
+
+            for (const Word* neighbor : neighbors) {
+                if (neighbor != nullptr) {
+                    word |= neighbor[w];
+                }
+            }
+
+            out[w] = word;
+        }
+
+        if (n > 0) {
+            out[n - 1] &= _lastWordMask;
+        }
+    });
+}
+
+BitArray3& BitArray3::operator|=(const BitArray3& other) {
+    JET_ASSERT(_size == other._size);
+    parallelFor(kZeroSize, _data.size(), [&](size_t w) {
+        _data[w] |= other._data[w];
+    });
+    return *this;
+}
+
+BitArray3& BitArray3::operator&=(const BitArray3& other) {
+    JET_ASSERT(_size == other._size);
+    parallelFor(kZeroSize, _data.size(), [&](size_t w) {
+        _data[w] &= other._data[w];
+    });
+    return *this;
+}
+
+void BitArray3::andNot(const BitArray3& other) {
+    JET_ASSERT(_size == other._size);
+    parallelFor(kZeroSize, _data.size(), [&](size_t w) {
+        _data[w] &= ~other._data[w];
+    });
+}
+
+void BitArray3::swap(BitArray3& other) {
+    std::swap(_size, other._size);
+    std::swap(_wordsPerRow, other._wordsPerRow);
+    std::swap(_lastWordMask, other._lastWordMask);
+    _data.swap(other._data);
+}
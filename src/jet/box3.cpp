@@ -3,9 +3,172 @@
 #include <pch.h>
 #include <jet/box3.h>
 #include <jet/plane3.h>
+#include <primitive_distance_helpers.h>
+
+#include <algorithm>
+#include <cmath>
 
 using namespace jet;
 
+namespace {
+
+// Signed distance of a box, which is the distance to the box outside of it
+// and minus the distance to the closest face inside
+void boxDistancesScalar(
+    size_t begin,
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& lower,
+    const Vector3D& upper,
+    double* result) {
+    for (size_t i = begin; i < n; ++i) {
+        double qx = std::max(lower.x - p.x[i], p.x[i] - upper.x);
+        double qy = std::max(lower.y - p.y[i], p.y[i] - upper.y);
+        double qz = std::max(lower.z - p.z[i], p.z[i] - upper.z);
+        double ox = std::max(qx, 0.0);
+        double oy = std::max(qy, 0.0);
+        double oz = std::max(qz, 0.0);
+        result[i] = std::sqrt(ox * ox + oy * oy + oz * oz)
+            + std::min(std::max(std::max(qx, qy), qz), 0.0);
+    }
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 void boxDistancesSse2(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& lower,
+    const Vector3D& upper,
+    double* result) {
+    const __m128d lx = _mm_set1_pd(lower.x);
+    const __m128d ly = _mm_set1_pd(lower.y);
+    const __m128d lz = _mm_set1_pd(lower.z);
+    const __m128d ux = _mm_set1_pd(upper.x);
+    const __m128d uy = _mm_set1_pd(upper.y);
+    const __m128d uz = _mm_set1_pd(upper.z);
+    const __m128d zero = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(p.x + i);
+        __m128d y = _mm_loadu_pd(p.y + i);
+        __m128d z = _mm_loadu_pd(p.z + i);
+        __m128d qx = _mm_max_pd(_mm_sub_pd(lx, x), _mm_sub_pd(x, ux));
+        __m128d qy = _mm_max_pd(_mm_sub_pd(ly, y), _mm_sub_pd(y, uy));
+        __m128d qz = _mm_max_pd(_mm_sub_pd(lz, z), _mm_sub_pd(z, uz));
+        __m128d ox = _mm_max_pd(qx, zero);
+        __m128d oy = _mm_max_pd(qy, zero);
+        __m128d oz = _mm_max_pd(qz, zero);
+        __m128d outside = _mm_sqrt_pd(_mm_add_pd(
+            _mm_add_pd(_mm_mul_pd(ox, ox), _mm_mul_pd(oy, oy)),
+            _mm_mul_pd(oz, oz)));
+        __m128d inside
+            = _mm_min_pd(_mm_max_pd(_mm_max_pd(qx, qy), qz), zero);
+        _mm_storeu_pd(result + i, _mm_add_pd(outside, inside));
+    }
+    boxDistancesScalar(i, n, p, lower, upper, result);
+}
+
+JET_TARGET_AVX void boxDistancesAvx(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& lower,
+    const Vector3D& upper,
+    double* result) {
+    const __m256d lx = _mm256_set1_pd(lower.x);
+    const __m256d ly = _mm256_set1_pd(lower.y);
+    const __m256d lz = _mm256_set1_pd(lower.z);
+    const __m256d ux = _mm256_set1_pd(upper.x);
+    const __m256d uy = _mm256_set1_pd(upper.y);
+    const __m256d uz = _mm256_set1_pd(upper.z);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(p.x + i);
+        __m256d y = _mm256_loadu_pd(p.y + i);
+        __m256d z = _mm256_loadu_pd(p.z + i);
+        __m256d qx = _mm256_max_pd(_mm256_sub_pd(lx, x), _mm256_sub_pd(x, ux));
+        __m256d qy = _mm256_max_pd(_mm256_sub_pd(ly, y), _mm256_sub_pd(y, uy));
+        __m256d qz = _mm256_max_pd(_mm256_sub_pd(lz, z), _mm256_sub_pd(z, uz));
+        __m256d ox = _mm256_max_pd(qx, zero);
+        __m256d oy = _mm256_max_pd(qy, zero);
+        __m256d oz = _mm256_max_pd(qz, zero);
+        __m256d outside = _mm256_sqrt_pd(_mm256_add_pd(
+            _mm256_add_pd(_mm256_mul_pd(ox, ox), _mm256_mul_pd(oy, oy)),
+            _mm256_mul_pd(oz, oz)));
+        __m256d inside
+            = _mm256_min_pd(_mm256_max_pd(_mm256_max_pd(qx, qy), qz), zero);
+        _mm256_storeu_pd(result + i, _mm256_add_pd(outside, inside));
+    }
+    boxDistancesScalar(i, n, p, lower, upper, result);
+}
+
+#elif defined(JET_SIMD_NEON)
+
+void boxDistancesNeon(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& lower,
+    const Vector3D& upper,
+    double* result) {
+    const float64x2_t lx = vdupq_n_f64(lower.x);
+    const float64x2_t ly = vdupq_n_f64(lower.y);
+    const float64x2_t lz = vdupq_n_f64(lower.z);
+    const float64x2_t ux = vdupq_n_f64(upper.x);
+    const float64x2_t uy = vdupq_n_f64(upper.y);
+    const float64x2_t uz = vdupq_n_f64(upper.z);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t x = vld1q_f64(p.x + i);
+        float64x2_t y = vld1q_f64(p.y + i);
+        float64x2_t z = vld1q_f64(p.z + i);
+        float64x2_t qx = vmaxq_f64(vsubq_f64(lx, x), vsubq_f64(x, ux));
+        float64x2_t qy = vmaxq_f64(vsubq_f64(ly, y), vsubq_f64(y, uy));
+        float64x2_t qz = vmaxq_f64(vsubq_f64(lz, z), vsubq_f64(z, uz));
+        float64x2_t ox = vmaxq_f64(qx, zero);
+        float64x2_t oy = vmaxq_f64(qy, zero);
+        float64x2_t oz = vmaxq_f64(qz, zero);
+        float64x2_t outside = vsqrtq_f64(vaddq_f64(
+            vaddq_f64(vmulq_f64(ox, ox), vmulq_f64(oy, oy)),
+            vmulq_f64(oz, oz)));
+        float64x2_t inside
+            = vminq_f64(vmaxq_f64(vmaxq_f64(qx, qy), qz), zero);
+        vst1q_f64(result + i, vaddq_f64(outside, inside));
+    }
+    boxDistancesScalar(i, n, p, lower, upper, result);
+}
+
+#endif
+
+void boxDistances(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& lower,
+    const Vector3D& upper,
+    double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+        case SimdInstructionSet::Avx:
+            boxDistancesAvx(n, p, lower, upper, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            boxDistancesSse2(n, p, lower, upper, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            boxDistancesNeon(n, p, lower, upper, result);
+            return;
+#endif
+        default:
+            boxDistancesScalar(0, n, p, lower, upper, result);
+            return;
+    }
+}
+
+}  // namespace
+
 Box3::Box3() {
 }
 
@@ -131,3 +294,13 @@ SurfaceRayIntersection3 Box3::actualClosestIntersection(
 BoundingBox3D Box3::boundingBox() const {
     return bound;
 }
+
+void Box3::actualBatchClosestSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    primitiveSignedDistances(
+        otherPoints, result,
+        [&](size_t n, const PrimitiveDistanceChunk& p, double* out) {
+            boxDistances(n, p, bound.lowerCorner, bound.upperCorner, out);
+        });
+}
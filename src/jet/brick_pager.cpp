@@ -0,0 +1,214 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/brick_pager.h>
+#include <jet/constants.h>
+
+#ifndef JET_WINDOWS
+#include <fcntl.h>
+#include <sys/types.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace jet;
+
+BrickPager::BrickPager(
+    size_t numberOfBricks,
+    const std::vector<char>& initialBrick,
+    size_t maxNumberOfResidentBricks) :
+    _numberOfBricks(numberOfBricks),
+    _initialBrick(initialBrick),
+    _maxNumberOfResidentBricks(std::max(maxNumberOfResidentBricks, kOneSize)),
+    _brickToSlot(numberOfBricks, kMaxSize),
+    _isStored(numberOfBricks, 0) {
+}
+
+BrickPager::~BrickPager() {
+    if (_file != nullptr) {
+        std::fclose(_file);
+    }
+}
+
+char* BrickPager::acquire(
+    size_t brick, bool isWriting, size_t prefetchDistance) {
+    JET_ASSERT(brick < _numberOfBricks);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t slot = _brickToSlot[brick];
+    if (slot == kMaxSize) {
+        // Reuses the least recently used slot when the cache is full, and
+        // grows it when all the slots are pinned
+        slot = (_slots.size() < _maxNumberOfResidentBricks)
+            ? kMaxSize : leastRecentlyUsedSlot();
+        if (slot == kMaxSize) {
+            slot = _slots.size();
+            _slots.push_back(Slot());
+            _slots.back().data.resize(_initialBrick.size());
+        } else {
+            evict(slot);
+        }
+
+        Slot& s = _slots[slot];
+        s.brick = brick;
+        s.numberOfPins = 0;
+        s.isDirty = false;
+        _brickToSlot[brick] = slot;
+
+        if (_isStored[brick]) {
+            readBrick(brick, s.data.data());
+            if (prefetchDistance > 0) {
+                prefetch(brick + 1, prefetchDistance);
+            }
+        } else {
+            std::copy(
+                _initialBrick.begin(), _initialBrick.end(), s.data.begin());
+        }
+    }
+
+    Slot& s = _slots[slot];
+    ++s.numberOfPins;
+    s.lastUse = ++_clock;
+    s.isDirty |= isWriting;
+    return s.data.data();
+}
+
+void BrickPager::release(size_t brick) {
+    JET_ASSERT(brick < _numberOfBricks);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t slot = _brickToSlot[brick];
+    JET_ASSERT(slot != kMaxSize && _slots[slot].numberOfPins > 0);
+    --_slots[slot].numberOfPins;
+}
+
+size_t BrickPager::numberOfBricks() const {
+    return _numberOfBricks;
+}
+
+size_t BrickPager::bytesPerBrick() const {
+    return _initialBrick.size();
+}
+
+size_t BrickPager::maxNumberOfResidentBricks() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _maxNumberOfResidentBricks;
+}
+
+void BrickPager::setMaxNumberOfResidentBricks(size_t numberOfBricks) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _maxNumberOfResidentBricks = std::max(numberOfBricks, kOneSize);
+    while (_slots.size() > _maxNumberOfResidentBricks) {
+        size_t slot = leastRecentlyUsedSlot();
+        if (slot == kMaxSize) {
+            break;
+        }
+        removeSlot(slot);
+    }
+}
+
+size_t BrickPager::numberOfResidentBricks() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _slots.size();
+}
+
+size_t BrickPager::numberOfBrickReads() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numberOfBrickReads;
+}
+
+size_t BrickPager::numberOfBrickWrites() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numberOfBrickWrites;
+}
+
+size_t BrickPager::leastRecentlyUsedSlot() const {
+    size_t result = kMaxSize;
+    for (size_t slot = 0; slot < _slots.size(); ++slot) {
+        const Slot& s = _slots[slot];
+        if (s.numberOfPins == 0
+            && (result == kMaxSize || s.lastUse < _slots[result].lastUse)) {
+            result = slot;
+        }
+    }
+    return result;
+}
+
+void BrickPager::evict(size_t slot) {
+    Slot& s = _slots[slot];
+    if (s.isDirty) {
+        writeBrick(s.brick, s.data.data());
+    }
+    _brickToSlot[s.brick] = kMaxSize;
+}
+
+void BrickPager::removeSlot(size_t slot) {
+    evict(slot);
+
+    if (slot + 1 < _slots.size()) {
+        _slots[slot] = std::move(_slots.back());
+        _brickToSlot[_slots[slot].brick] = slot;
+    }
+    _slots.pop_back();
+}
+
+void BrickPager::readBrick(size_t brick, char* data) {
+    seek(brick);
+    if (std::fread(data, 1, _initialBrick.size(), _file)
+        != _initialBrick.size()) {
+        throw std::runtime_error("Failed to read the scratch file.");
+    }
+    ++_numberOfBrickReads;
+}
+
+void BrickPager::writeBrick(size_t brick, const char* data) {
+    if (_file == nullptr) {
+        _file = std::tmpfile();
+        if (_file == nullptr) {
+            throw std::runtime_error("Failed to create the scratch file.");
+        }
+    }
+
+    seek(brick);
+    if (std::fwrite(data, 1, _initialBrick.size(), _file)
+        != _initialBrick.size()) {
+        throw std::runtime_error("Failed to write the scratch file.");
+    }
+    _isStored[brick] = 1;
+    ++_numberOfBrickWrites;
+}
+
+void BrickPager::seek(size_t brick) {
+    uint64_t offset = static_cast<uint64_t>(brick) * _initialBrick.size();
+#ifdef JET_WINDOWS
+    int result = _fseeki64(_file, static_cast<__int64>(offset), SEEK_SET);
+#else
+    int result = fseeko(_file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    if (result != 0) {
+        throw std::runtime_error("Failed to seek the scratch file.");
+    }
+}
+
+void BrickPager::prefetch(size_t firstBrick, size_t numberOfBricks) {
+#if defined(__linux__)
+    size_t lastBrick = std::min(firstBrick + numberOfBricks, _numberOfBricks);
+    if (firstBrick < lastBrick) {
+        size_t bytes = _initialBrick.size();
+        posix_fadvise(
+            fileno(_file),
+            static_cast<off_t>(firstBrick * bytes),
+            static_cast<off_t>((lastBrick - firstBrick) * bytes),
+            POSIX_FADV_WILLNEED);
+    }
+#else
+    UNUSED_VARIABLE(firstBrick);
+    UNUSED_VARIABLE(numberOfBricks);
+#endif
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/bvh3.h>
+#include <jet/constants.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace jet;
+
+static const size_t kMaxLeafSize = 4;
+static const size_t kNumberOfBins = 12;
+
+inline double surfaceArea(const BoundingBox3D& box) {
+    Vector3D d = box.upperCorner - box.lowerCorner;
+    if (d.x < 0.0 || d.y < 0.0 || d.z < 0.0) {
+        return 0.0;
+    }
+    return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+const size_t Bvh3::kPacketSize;
+const size_t Bvh3::kLeafChunkSize;
+
+Bvh3::Bvh3() {
+}
+
+void Bvh3::build(const std::vector<BoundingBox3D>& itemBounds) {
+    size_t n = itemBounds.size();
+    std::vector<Vector3D> centroids(n);
+
+    _items.clear();
+    _unboundedItems.clear();
+    _nodes.clear();
+
+    for (size_t i = 0; i < n; ++i) {
+        if (std::isfinite(surfaceArea(itemBounds[i]))) {
+            _items.push_back(i);
+            centroids[i] = itemBounds[i].midPoint();
+        } else {
+            _unboundedItems.push_back(i);
+        }
+    }
+
+    struct BuildItem {
+        size_t start;
+        size_t end;
+        size_t parent;
+    };
+
+    std::vector<BuildItem> stack;
+    if (!_items.empty()) {
+        stack.push_back({0, _items.size(), kMaxSize});
+    }
+
+    while (!stack.empty()) {
+        BuildItem item = stack.back();
+        stack.pop_back();
+
+        size_t nodeIndex = _nodes.size();
+        if (item.parent != kMaxSize) {
+            _nodes[item.parent].secondChild = nodeIndex;
+        }
+        _nodes.push_back(Node());
+
+        BoundingBox3D bound;
+        BoundingBox3D centroidBound;
+        for (size_t i = item.start; i < item.end; ++i) {
+            bound.merge(itemBounds[_items[i]]);
+            centroidBound.merge(centroids[_items[i]]);
+        }
+        _nodes[nodeIndex].bound = bound;
+
+        // Find the binned split with the lowest surface area heuristic
+        // cost
+        size_t count = item.end - item.start;
+        size_t bestAxis = kMaxSize;
+        size_t bestSplit = 0;
+        double bestCost = std::numeric_limits<double>::max();
+
+        for (size_t axis = 0; axis < 3 && count > kMaxLeafSize; ++axis) {
+            double lower = centroidBound.lowerCorner[axis];
+            double extent = centroidBound.upperCorner[axis] - lower;
+            if (extent <= 0.0) {
+                continue;
+            }
+
+            size_t binCounts[kNumberOfBins] = {};
+            BoundingBox3D binBounds[kNumberOfBins];
+            for (size_t i = item.start; i < item.end; ++i) {
+                size_t j = _items[i];
+                size_t bin = std::min(
+                    static_cast<size_t>(
+                        (centroids[j][axis] - lower) / extent
+                        * kNumberOfBins),
+                    kNumberOfBins - 1);
+                ++binCounts[bin];
+                binBounds[bin].merge(itemBounds[j]);
+            }
+
+            double rightAreas[kNumberOfBins];
+            size_t rightCounts[kNumberOfBins];
+            BoundingBox3D rightBound;
+            size_t rightCount = 0;
+            for (size_t bin = kNumberOfBins - 1; bin > 0; --bin) {
+                rightBound.merge(binBounds[bin]);
+                rightCount += binCounts[bin];
+                rightAreas[bin] = surfaceArea(rightBound);
+                rightCounts[bin] = rightCount;
+            }
+
+            BoundingBox3D leftBound;
+            size_t leftCount = 0;
+            for (size_t split = 1; split < kNumberOfBins; ++split) {
+                leftBound.merge(binBounds[split - 1]);
+                leftCount += binCounts[split - 1];
+                if (leftCount == 0 || rightCounts[split] == 0) {
+                    continue;
+                }
+
+                double cost = surfaceArea(leftBound) * leftCount
+                    + rightAreas[split] * rightCounts[split];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        if (bestAxis == kMaxSize) {
+            _nodes[nodeIndex].start = item.start;
+            _nodes[nodeIndex].count = count;
+            continue;
+        }
+
+        double lower = centroidBound.lowerCorner[bestAxis];
+        double extent = centroidBound.upperCorner[bestAxis] - lower;
+        auto begin = _items.begin();
+        auto middle = std::partition(
+            begin + item.start,
+            begin + item.end,
+            [&](size_t j) {
+                size_t bin = std::min(
+                    static_cast<size_t>(
+                        (centroids[j][bestAxis] - lower) / extent
+                        * kNumberOfBins),
+                    kNumberOfBins - 1);
+                return bin < bestSplit;
+            });
+        size_t mid = static_cast<size_t>(middle - begin);
+
+        // Push the second child first so that the first child comes next
+        stack.push_back({mid, item.end, nodeIndex});
+        stack.push_back({item.start, mid, kMaxSize});
+    }
+
+    _items.insert(
+        _items.end(), _unboundedItems.begin(), _unboundedItems.end());
+}
+
+void Bvh3::refit(const std::vector<BoundingBox3D>& itemBounds) {
+    // Children always come after their parent
+    for (size_t i = _nodes.size(); i > 0; --i) {
+        Node& node = _nodes[i - 1];
+        node.bound.reset();
+
+        if (node.count > 0) {
+            for (size_t n = node.start; n < node.start + node.count; ++n) {
+                node.bound.merge(itemBounds[_items[n]]);
+            }
+        } else {
+            node.bound.merge(_nodes[i].bound);
+            node.bound.merge(_nodes[node.secondChild].bound);
+        }
+    }
+}
+
+void Bvh3::clear() {
+    _nodes.clear();
+    _items.clear();
+    _unboundedItems.clear();
+}
+
+bool Bvh3::empty() const {
+    return _items.empty();
+}
+
+const std::vector<size_t>& Bvh3::orderedItems() const {
+    return _items;
+}
@@ -0,0 +1,314 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/array1.h>
+#include <jet/cached_scalar_field3.h>
+#include <jet/custom_scalar_field3.h>
+#include <jet/math_utils.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace jet;
+
+namespace {
+
+// Number of the cells of a tile along each axis.
+const size_t kTileSize = 8;
+
+// Number of the nodes of a tile along each axis, which shares its last
+// nodes with the next tile so that a cell never spans two tiles.
+const size_t kTileNodes = kTileSize + 1;
+
+size_t localNodeIndex(size_t i, size_t j, size_t k) {
+    return i + kTileNodes * (j + kTileNodes * k);
+}
+
+// Copies the values at the eight corners of the cell from the data of its
+// tile, x-first.
+void gatherCorners(
+    const std::vector<double>& data, const Size3& cell, double* corners) {
+    const size_t i = cell.x % kTileSize;
+    const size_t j = cell.y % kTileSize;
+    const size_t k = cell.z % kTileSize;
+    for (size_t n = 0; n < 8; ++n) {
+        corners[n] = data[localNodeIndex(
+            i + (n & 1), j + ((n >> 1) & 1), k + ((n >> 2) & 1))];
+    }
+}
+
+}  // namespace
+
+CachedScalarField3::CachedScalarField3(
+    const ScalarField3Ptr& field,
+    const BoundingBox3D& domain,
+    double spacing,
+    size_t maxNumberOfTiles) :
+    _field(field),
+    _domain(domain),
+    _spacing(spacing) {
+    JET_THROW_INVALID_ARG_IF(field == nullptr);
+    initialize(maxNumberOfTiles);
+}
+
+CachedScalarField3::CachedScalarField3(
+    const ImplicitSurface3Ptr& surface,
+    const BoundingBox3D& domain,
+    double spacing,
+    size_t maxNumberOfTiles) :
+    _domain(domain),
+    _spacing(spacing) {
+    JET_THROW_INVALID_ARG_IF(surface == nullptr);
+    _field = std::make_shared<CustomScalarField3>(
+        [surface](
+            const ConstArrayAccessor1<Vector3D>& x,
+            ArrayAccessor1<double> result) {
+            surface->batchSignedDistance(x, result);
+        });
+    initialize(maxNumberOfTiles);
+}
+
+void CachedScalarField3::initialize(size_t maxNumberOfTiles) {
+    JET_THROW_INVALID_ARG_IF(!(_spacing > 0.0));
+
+    _invSpacing = 1.0 / _spacing;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double extent = _domain.upperCorner[axis] - _domain.lowerCorner[axis];
+        _resolution[axis] = std::max(
+            static_cast<size_t>(std::ceil(extent * _invSpacing)), kOneSize);
+        _numberOfTiles[axis] = (_resolution[axis] + kTileSize - 1) / kTileSize;
+    }
+    _maxNumberOfTiles = std::max(maxNumberOfTiles, kOneSize);
+}
+
+double CachedScalarField3::sample(const Vector3D& x) const {
+    double c[8];
+    Vector3D f;
+    if (!findCorners(x, c, &f)) {
+        return _field->sample(x);
+    }
+
+    return trilerp(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7],
+                   f.x, f.y, f.z);
+}
+
+void CachedScalarField3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<double> result) const {
+    // The consecutive points in the same tile reuse its data
+    size_t lastIndex = kMaxSize;
+    TileData data;
+    for (size_t n = 0; n < x.size(); ++n) {
+        Size3 cell;
+        Vector3D f;
+        if (!findCell(x[n], &cell, &f)) {
+            result[n] = _field->sample(x[n]);
+            continue;
+        }
+
+        size_t index = tileIndex(cell);
+        if (index != lastIndex) {
+            data = tile(index);
+            lastIndex = index;
+        }
+
+        double c[8];
+        gatherCorners(*data, cell, c);
+        result[n] = trilerp(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7],
+                            f.x, f.y, f.z);
+    }
+}
+
+Vector3D CachedScalarField3::gradient(const Vector3D& x) const {
+    double c[8];
+    Vector3D f;
+    if (!findCorners(x, c, &f)) {
+        return _field->gradient(x);
+    }
+
+    double dx = bilerp(c[1] - c[0], c[3] - c[2], c[5] - c[4], c[7] - c[6],
+                       f.y, f.z);
+    double dy = bilerp(c[2] - c[0], c[3] - c[1], c[6] - c[4], c[7] - c[5],
+                       f.x, f.z);
+    double dz = bilerp(c[4] - c[0], c[5] - c[1], c[6] - c[2], c[7] - c[3],
+                       f.x, f.y);
+    return _invSpacing * Vector3D(dx, dy, dz);
+}
+
+double CachedScalarField3::laplacian(const Vector3D& x) const {
+    Size3 cell;
+    Vector3D f;
+    if (!findCell(x, &cell, &f)) {
+        return _field->laplacian(x);
+    }
+
+    const double h = _spacing;
+    double sum = sample(x + Vector3D(h, 0, 0)) + sample(x - Vector3D(h, 0, 0))
+        + sample(x + Vector3D(0, h, 0)) + sample(x - Vector3D(0, h, 0))
+        + sample(x + Vector3D(0, 0, h)) + sample(x - Vector3D(0, 0, h));
+    return (sum - 6.0 * sample(x)) * _invSpacing * _invSpacing;
+}
+
+const ScalarField3Ptr& CachedScalarField3::field() const {
+    return _field;
+}
+
+const BoundingBox3D& CachedScalarField3::domain() const {
+    return _domain;
+}
+
+double CachedScalarField3::spacing() const {
+    return _spacing;
+}
+
+size_t CachedScalarField3::maxNumberOfTiles() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _maxNumberOfTiles;
+}
+
+void CachedScalarField3::setMaxNumberOfTiles(size_t numberOfTiles) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxNumberOfTiles = std::max(numberOfTiles, kOneSize);
+    evict();
+}
+
+size_t CachedScalarField3::numberOfTiles() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _tiles.size();
+}
+
+size_t CachedScalarField3::numberOfTileFills() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numberOfTileFills;
+}
+
+uint64_t CachedScalarField3::version() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _version;
+}
+
+void CachedScalarField3::invalidate() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tiles.clear();
+    _leastRecentlyUsed.clear();
+    ++_version;
+}
+
+void CachedScalarField3::setSourceVersion(uint64_t sourceVersion) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_hasSourceVersion && sourceVersion == _sourceVersion) {
+            return;
+        }
+        _sourceVersion = sourceVersion;
+        _hasSourceVersion = true;
+    }
+
+    invalidate();
+}
+
+bool CachedScalarField3::findCell(
+    const Vector3D& x, Size3* cell, Vector3D* fraction) const {
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double g = (x[axis] - _domain.lowerCorner[axis]) * _invSpacing;
+        if (!(g >= 0.0 && x[axis] <= _domain.upperCorner[axis])) {
+            return false;
+        }
+
+        size_t i = std::min(static_cast<size_t>(g), _resolution[axis] - 1);
+        (*cell)[axis] = i;
+        (*fraction)[axis] = std::min(g - static_cast<double>(i), 1.0);
+    }
+    return true;
+}
+
+size_t CachedScalarField3::tileIndex(const Size3& cell) const {
+    return (cell.x / kTileSize) + _numberOfTiles.x
+        * ((cell.y / kTileSize) + _numberOfTiles.y * (cell.z / kTileSize));
+}
+
+CachedScalarField3::TileData CachedScalarField3::tile(size_t index) const {
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto iter = _tiles.find(index);
+        if (iter != _tiles.end()) {
+            _leastRecentlyUsed.splice(
+                _leastRecentlyUsed.begin(),
+                _leastRecentlyUsed,
+                iter->second.use);
+            return iter->second.data;
+        }
+        version = _version;
+    }
+
+    // Samples the field without the lock, so the other threads keep
+    // interpolating from their tiles
+    TileData data = fillTile(index);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_numberOfTileFills;
+
+    // The cache was invalidated while sampling, or another thread added the
+    // same tile first
+    if (version != _version) {
+        return data;
+    }
+    auto iter = _tiles.find(index);
+    if (iter != _tiles.end()) {
+        return iter->second.data;
+    }
+
+    _leastRecentlyUsed.push_front(index);
+    TileEntry entry;
+    entry.data = data;
+    entry.use = _leastRecentlyUsed.begin();
+    _tiles[index] = entry;
+    evict();
+    return data;
+}
+
+CachedScalarField3::TileData CachedScalarField3::fillTile(
+    size_t index) const {
+    const Size3 t(
+        index % _numberOfTiles.x,
+        (index / _numberOfTiles.x) % _numberOfTiles.y,
+        index / (_numberOfTiles.x * _numberOfTiles.y));
+    const Vector3D origin = _domain.lowerCorner
+        + (_spacing * kTileSize) * Vector3D(t.x, t.y, t.z);
+
+    const size_t numberOfNodes = kTileNodes * kTileNodes * kTileNodes;
+    Array1<Vector3D> positions(numberOfNodes);
+    for (size_t k = 0; k < kTileNodes; ++k) {
+        for (size_t j = 0; j < kTileNodes; ++j) {
+            for (size_t i = 0; i < kTileNodes; ++i) {
+                positions[localNodeIndex(i, j, k)]
+                    = origin + _spacing * Vector3D(i, j, k);
+            }
+        }
+    }
+
+    Array1<double> values(numberOfNodes);
+    _field->batchSample(positions.constAccessor(), values.accessor());
+    return std::make_shared<const std::vector<double>>(
+        values.begin(), values.end());
+}
+
+void CachedScalarField3::evict() const {
+    while (_tiles.size() > _maxNumberOfTiles) {
+        _tiles.erase(_leastRecentlyUsed.back());
+        _leastRecentlyUsed.pop_back();
+    }
+}
+
+bool CachedScalarField3::findCorners(
+    const Vector3D& x, double* corners, Vector3D* fraction) const {
+    Size3 cell;
+    if (!findCell(x, &cell, fraction)) {
+        return false;
+    }
+
+    TileData data = tile(tileIndex(cell));
+    gatherCorners(*data, cell, corners);
+    return true;
+}
@@ -3,10 +3,22 @@
 #include <pch.h>
 #include <jet/collider3.h>
 #include <algorithm>
+#include <atomic>
 
 using namespace jet;
 
-Collider3::Collider3() {
+namespace {
+
+// Zero is never issued, so it can stand for "no collider"
+std::atomic<uint64_t> sLastColliderVersion(0);
+
+uint64_t nextColliderVersion() {
+    return ++sLastColliderVersion;
+}
+
+}  // namespace
+
+Collider3::Collider3() : _version(nextColliderVersion()) {
 }
 
 Collider3::~Collider3() {
@@ -80,8 +92,17 @@ const Surface3Ptr& Collider3::surface() const {
     return _surface;
 }
 
+uint64_t Collider3::version() const {
+    return _version;
+}
+
+void Collider3::markDirty() {
+    _version = nextColliderVersion();
+}
+
 void Collider3::setSurface(const Surface3Ptr& newSurface) {
     _surface = newSurface;
+    markDirty();
 }
 
 void Collider3::getClosestPoint(
@@ -10,15 +10,9 @@ ColliderSet3::ColliderSet3() {
 }
 
 Vector3D ColliderSet3::velocityAt(const Vector3D& point) const {
-    size_t closestCollider = kMaxSize;
-    double closestDist = kMaxD;
-    for (size_t i = 0; i < _colliders.size(); ++i) {
-        double dist = _colliders[i]->surface()->closestDistance(point);
-        if (dist < closestDist) {
-            closestDist = dist;
-            closestCollider = i;
-        }
-    }
+    // The surfaces of the set are in the order of the colliders
+    auto surfaceSet = std::static_pointer_cast<SurfaceSet3>(surface());
+    size_t closestCollider = surfaceSet->closestSurfaceIndex(point);
     if (closestCollider != kMaxSize) {
         return _colliders[closestCollider]->velocityAt(point);
     } else {
@@ -30,4 +24,13 @@ void ColliderSet3::addCollider(const Collider3Ptr& collider) {
     auto surfaceSet = std::dynamic_pointer_cast<SurfaceSet3>(surface());
     _colliders.push_back(collider);
     surfaceSet->addSurface(collider->surface());
+    Collider3::markDirty();
+}
+
+void ColliderSet3::markDirty() {
+    Collider3::markDirty();
+    auto surfaceSet = std::dynamic_pointer_cast<SurfaceSet3>(surface());
+    if (surfaceSet != nullptr) {
+        surfaceSet->invalidateBvh();
+    }
 }
@@ -81,7 +81,15 @@ Vector3D CollocatedVectorGrid3::curlAtDataPoint(
 }
 
 Vector3D CollocatedVectorGrid3::sample(const Vector3D& x) const {
-    return _sampler(x);
+    return _linearSampler(x);
+}
+
+void CollocatedVectorGrid3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<Vector3D> result) const {
+    for (size_t i = 0; i < x.size(); ++i) {
+        result[i] = _linearSampler(x[i]);
+    }
 }
 
 double CollocatedVectorGrid3::divergence(const Vector3D& x) const {
@@ -116,7 +124,12 @@ Vector3D CollocatedVectorGrid3::curl(const Vector3D& x) const {
 
 std::function<Vector3D(const Vector3D&)>
 CollocatedVectorGrid3::sampler() const {
-    return _sampler;
+    return _linearSampler.functor();
+}
+
+const LinearArraySampler3<Vector3D, double>&
+CollocatedVectorGrid3::linearSampler() const {
+    return _linearSampler;
 }
 
 VectorGrid3::VectorDataAccessor CollocatedVectorGrid3::dataAccessor() {
@@ -145,6 +158,16 @@ void CollocatedVectorGrid3::parallelForEachDataPointIndex(
     _data.parallelForEachIndex(func);
 }
 
+void CollocatedVectorGrid3::forEachDataPointRow(
+    const std::function<void(size_t, size_t)>& func) const {
+    _data.forEachRow(func);
+}
+
+void CollocatedVectorGrid3::parallelForEachDataPointRow(
+    const std::function<void(size_t, size_t)>& func) const {
+    _data.parallelForEachRow(func);
+}
+
 void CollocatedVectorGrid3::serialize(std::ostream* strm) const {
     serializeGrid(strm);
     _data.serialize(strm);
@@ -163,7 +186,6 @@ void CollocatedVectorGrid3::swapCollocatedVectorGrid(
 
     _data.swap(other->_data);
     std::swap(_linearSampler, other->_linearSampler);
-    std::swap(_sampler, other->_sampler);
 }
 
 void CollocatedVectorGrid3::setCollocatedVectorGrid(
@@ -190,5 +212,4 @@ void CollocatedVectorGrid3::onResize(
 void CollocatedVectorGrid3::resetSampler() {
     _linearSampler = LinearArraySampler3<Vector3D, double>(
         _data.constAccessor(), gridSpacing(), dataOrigin());
-    _sampler = _linearSampler.functor();
 }
@@ -0,0 +1,173 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/communicator.h>
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef JET_USE_MPI
+#include <mpi.h>
+#endif
+
+using namespace jet;
+
+Communicator::Communicator() {
+}
+
+Communicator::~Communicator() {
+}
+
+void Communicator::sum(ArrayAccessor1<double> values) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = sum(values[i]);
+    }
+}
+
+SerialCommunicator::SerialCommunicator() {
+}
+
+int SerialCommunicator::rank() const {
+    return 0;
+}
+
+int SerialCommunicator::size() const {
+    return 1;
+}
+
+double SerialCommunicator::sum(double value) {
+    return value;
+}
+
+double SerialCommunicator::max(double value) {
+    return value;
+}
+
+void SerialCommunicator::sendReceive(
+    const void* sendData,
+    size_t sendBytes,
+    int destination,
+    void* receiveData,
+    size_t receiveBytes,
+    int source) {
+    JET_THROW_INVALID_ARG_IF(destination != kNoRank && destination != 0);
+    JET_THROW_INVALID_ARG_IF(source != kNoRank && source != 0);
+    JET_THROW_INVALID_ARG_IF((destination == 0) != (source == 0));
+
+    if (destination == 0) {
+        JET_THROW_INVALID_ARG_IF(sendBytes != receiveBytes);
+        std::memmove(receiveData, sendData, sendBytes);
+    }
+}
+
+#ifdef JET_USE_MPI
+
+MpiCommunicator::MpiCommunicator() {
+    if (!isAvailable()) {
+        throw std::runtime_error("MPI is not initialized.");
+    }
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &_size);
+}
+
+int MpiCommunicator::rank() const {
+    return _rank;
+}
+
+int MpiCommunicator::size() const {
+    return _size;
+}
+
+double MpiCommunicator::sum(double value) {
+    double result = 0.0;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    return result;
+}
+
+double MpiCommunicator::max(double value) {
+    double result = 0.0;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return result;
+}
+
+void MpiCommunicator::sum(ArrayAccessor1<double> values) {
+    JET_THROW_INVALID_ARG_IF(
+        values.size() > static_cast<size_t>(std::numeric_limits<int>::max()));
+
+    MPI_Allreduce(
+        MPI_IN_PLACE,
+        values.data(),
+        static_cast<int>(values.size()),
+        MPI_DOUBLE,
+        MPI_SUM,
+        MPI_COMM_WORLD);
+}
+
+void MpiCommunicator::sendReceive(
+    const void* sendData,
+    size_t sendBytes,
+    int destination,
+    void* receiveData,
+    size_t receiveBytes,
+    int source) {
+    JET_THROW_INVALID_ARG_IF(
+        sendBytes > static_cast<size_t>(std::numeric_limits<int>::max())
+        || receiveBytes > static_cast<size_t>(std::numeric_limits<int>::max()));
+
+    MPI_Sendrecv(
+        sendData,
+        static_cast<int>(sendBytes),
+        MPI_BYTE,
+        destination == kNoRank ? MPI_PROC_NULL : destination,
+        0,
+        receiveData,
+        static_cast<int>(receiveBytes),
+        MPI_BYTE,
+        source == kNoRank ? MPI_PROC_NULL : source,
+        0,
+        MPI_COMM_WORLD,
+        MPI_STATUS_IGNORE);
+}
+
+bool MpiCommunicator::isAvailable() {
+    int isInitialized = 0;
+    MPI_Initialized(&isInitialized);
+    return isInitialized != 0;
+}
+
+#else
+
+MpiCommunicator::MpiCommunicator() {
+    throw std::runtime_error("Jet is built without MPI.");
+}
+
+int MpiCommunicator::rank() const {
+    return _rank;
+}
+
+int MpiCommunicator::size() const {
+    return _size;
+}
+
+double MpiCommunicator::sum(double value) {
+    return value;
+}
+
+double MpiCommunicator::max(double value) {
+    return value;
+}
+
+void MpiCommunicator::sum(ArrayAccessor1<double>) {
+}
+
+void MpiCommunicator::sendReceive(
+    const void*, size_t, int, void*, size_t, int) {
+}
+
+bool MpiCommunicator::isAvailable() {
+    return false;
+}
+
+#endif
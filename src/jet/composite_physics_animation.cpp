@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/composite_physics_animation.h>
+#include <jet/parallel.h>
+#include <jet/profiler.h>
+
+using namespace jet;
+
+CompositePhysicsAnimation::CompositePhysicsAnimation() {
+}
+
+CompositePhysicsAnimation::~CompositePhysicsAnimation() {
+}
+
+void CompositePhysicsAnimation::addAnimation(
+    const PhysicsAnimationPtr& animation,
+    size_t stageIndex) {
+    JET_ASSERT(animation != nullptr);
+    stage(stageIndex).animations.push_back(animation);
+}
+
+void CompositePhysicsAnimation::addCoupling(
+    const CouplingCallback& callback,
+    size_t stageIndex) {
+    stage(stageIndex).couplings.push_back(callback);
+}
+
+size_t CompositePhysicsAnimation::numberOfStages() const {
+    return _stages.size();
+}
+
+const std::vector<PhysicsAnimationPtr>&
+CompositePhysicsAnimation::animations(size_t stageIndex) const {
+    return _stages[stageIndex].animations;
+}
+
+const Frame& CompositePhysicsAnimation::currentFrame() const {
+    return _currentFrame;
+}
+
+void CompositePhysicsAnimation::onUpdate(const Frame& frame) {
+    // The frames are advanced one by one so that the couplings run for each
+    // of them
+    while (_currentFrame.index < frame.index) {
+        Frame next(_currentFrame.index + 1, frame.timeIntervalInSeconds);
+        advanceFrame(next);
+        _currentFrame = next;
+    }
+}
+
+void CompositePhysicsAnimation::advanceFrame(const Frame& frame) {
+    JET_PROFILE_SCOPE("CompositePhysicsAnimation::advanceFrame");
+
+    std::vector<std::function<void()>> tasks;
+    for (const Stage& s : _stages) {
+        for (const CouplingCallback& coupling : s.couplings) {
+            coupling(frame);
+        }
+
+        // A single animation runs on this thread and still uses the pool
+        // from its own parallel loops
+        if (s.animations.size() == 1) {
+            s.animations.front()->update(frame);
+            continue;
+        }
+
+        tasks.clear();
+        for (const PhysicsAnimationPtr& animation : s.animations) {
+            tasks.push_back([animation, &frame]() {
+                animation->update(frame);
+            });
+        }
+        parallelInvoke(tasks);
+    }
+}
+
+CompositePhysicsAnimation::Stage& CompositePhysicsAnimation::stage(
+    size_t index) {
+    if (index >= _stages.size()) {
+        _stages.resize(index + 1);
+    }
+    return _stages[index];
+}
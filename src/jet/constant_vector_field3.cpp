@@ -2,6 +2,7 @@
 
 #include <pch.h>
 #include <jet/constant_vector_field3.h>
+#include <algorithm>
 
 using namespace jet;
 
@@ -9,12 +10,22 @@ ConstantVectorField3::ConstantVectorField3(const Vector3D& value) :
     _value(value) {
 }
 
+const Vector3D& ConstantVectorField3::value() const {
+    return _value;
+}
+
 Vector3D ConstantVectorField3::sample(const Vector3D& x) const {
     UNUSED_VARIABLE(x);
 
     return _value;
 }
 
+void ConstantVectorField3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<Vector3D> result) const {
+    std::fill(result.begin(), result.begin() + x.size(), _value);
+}
+
 std::function<Vector3D(const Vector3D&)> ConstantVectorField3::sampler() const {
     return [this](const Vector3D&) -> Vector3D {
         return _value;
@@ -6,7 +6,16 @@
 
 using namespace jet;
 
-CubicSemiLagrangian3::CubicSemiLagrangian3() {
+CubicSemiLagrangian3::CubicSemiLagrangian3() :
+    SemiLagrangian3(Interpolation::Cubic) {
+}
+
+bool CubicSemiLagrangian3::isMonotonic() const {
+    return isCubicMonotonic();
+}
+
+void CubicSemiLagrangian3::setIsMonotonic(bool isMonotonic) {
+    setIsCubicMonotonic(isMonotonic);
 }
 
 std::function<double(const Vector3D&)>
@@ -14,7 +23,8 @@ CubicSemiLagrangian3::getScalarSamplerFunc(const ScalarGrid3& source) const {
     auto sourceSampler = CubicArraySampler3<double, double>(
         source.constDataAccessor(),
         source.gridSpacing(),
-        source.dataOrigin());
+        source.dataOrigin(),
+        isCubicMonotonic());
     return sourceSampler.functor();
 }
 
@@ -24,7 +34,8 @@ CubicSemiLagrangian3::getVectorSamplerFunc(
     auto sourceSampler = CubicArraySampler3<Vector3D, double>(
         source.constDataAccessor(),
         source.gridSpacing(),
-        source.dataOrigin());
+        source.dataOrigin(),
+        isCubicMonotonic());
     return sourceSampler.functor();
 }
 
@@ -34,15 +45,18 @@ CubicSemiLagrangian3::getVectorSamplerFunc(
     auto uSourceSampler = CubicArraySampler3<double, double>(
         source.uConstAccessor(),
         source.gridSpacing(),
-        source.uOrigin());
+        source.uOrigin(),
+        isCubicMonotonic());
     auto vSourceSampler = CubicArraySampler3<double, double>(
         source.vConstAccessor(),
         source.gridSpacing(),
-        source.vOrigin());
+        source.vOrigin(),
+        isCubicMonotonic());
     auto wSourceSampler = CubicArraySampler3<double, double>(
         source.wConstAccessor(),
         source.gridSpacing(),
-        source.wOrigin());
+        source.wOrigin(),
+        isCubicMonotonic());
     return
         [uSourceSampler, vSourceSampler, wSourceSampler](const Vector3D& x) {
             return Vector3D(
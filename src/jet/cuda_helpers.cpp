@@ -0,0 +1,20 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <cuda_helpers.h>
+
+#ifndef JET_USE_CUDA
+
+namespace jet {
+
+namespace internal {
+
+bool isCudaDeviceAvailable() {
+    return false;
+}
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif
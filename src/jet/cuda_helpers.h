@@ -0,0 +1,19 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_CUDA_HELPERS_H_
+#define SRC_JET_CUDA_HELPERS_H_
+
+namespace jet {
+
+namespace internal {
+
+// Returns true if the library is built with JET_USE_CUDA and a CUDA device is
+// found. Implemented in src/jet_cuda, and stubbed out in cuda_helpers.cpp
+// otherwise.
+bool isCudaDeviceAvailable();
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif  // SRC_JET_CUDA_HELPERS_H_
@@ -0,0 +1,54 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_CUDA_PCG_HELPERS_H_
+#define SRC_JET_CUDA_PCG_HELPERS_H_
+
+#include <jet/fdm_cuda_pcg_solver3.h>
+#include <cuda_helpers.h>
+
+// Device side of FdmCudaPcgSolver3. The functions are implemented in
+// src/jet_cuda when the library is built with JET_USE_CUDA, and stubbed out
+// in fdm_cuda_pcg_solver3.cpp otherwise.
+
+namespace jet {
+
+namespace internal {
+
+CudaPcgState* createCudaPcgState();
+
+// Uploads the matrix and resizes the device vectors to its size.
+void uploadCudaPcgMatrix(CudaPcgState* state, const FdmMatrix3& A);
+
+// Solves Ax = b with the uploaded matrix, starting from x = 0.
+void solveCudaPcg(
+    CudaPcgState* state,
+    const FdmVector3& b,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    FdmVector3* x,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm);
+
+// Sets the matrix from the device memory \p deviceA of given size, and
+// resizes the device vectors to its size.
+void setCudaPcgDeviceMatrix(
+    CudaPcgState* state,
+    const Size3& size,
+    const FdmMatrixRow3* deviceA);
+
+// Same as solveCudaPcg, but \p deviceB and \p deviceX are device memory of
+// the size of the matrix, so nothing is copied to or from the host.
+void solveCudaPcgOnDevice(
+    CudaPcgState* state,
+    const double* deviceB,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    double* deviceX,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm);
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif  // SRC_JET_CUDA_PCG_HELPERS_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_CUDA_SMOKE_HELPERS_H_
+#define SRC_JET_CUDA_SMOKE_HELPERS_H_
+
+#include <jet/grid_smoke_cuda_solver3.h>
+#include <jet/size3.h>
+#include <jet/vector3.h>
+#include <cuda_helpers.h>
+
+#include <vector>
+
+// Device side of GridSmokeCudaSolver3. The functions are implemented in
+// src/jet_cuda when the library is built with JET_USE_CUDA, and stubbed out
+// in grid_smoke_cuda_solver3.cpp otherwise.
+
+namespace jet {
+
+namespace internal {
+
+// Interpolation of the advected fields
+enum class CudaSmokeInterpolation {
+    Linear,
+    Cubic,
+    MonotonicCubic
+};
+
+struct CudaSmokeParameters {
+    CudaSmokeInterpolation interpolation = CudaSmokeInterpolation::Linear;
+    Vector3D up = Vector3D(0, 1, 0);
+    double buoyancySmokeDensityFactor = 0.0;
+    double buoyancyTemperatureFactor = 0.0;
+
+    // Zero skips the diffusion of the channel
+    double smokeDiffusionCoefficient = 0.0;
+    double temperatureDiffusionCoefficient = 0.0;
+
+    double smokeDecayFactor = 0.0;
+    double temperatureDecayFactor = 0.0;
+    int closedDomainBoundaryFlag = 0;
+    bool isSolvingPressure = true;
+    unsigned int maxNumberOfIterations = 0;
+    double pressureTolerance = 0.0;
+    double diffusionTolerance = 0.0;
+};
+
+CudaSmokeState* createCudaSmokeState();
+
+// Uploads the velocity and the scalar channels, which are cell-centered grids
+// of the resolution of the velocity. The first two channels are the smoke
+// density and the temperature.
+void uploadCudaSmokeGrids(
+    CudaSmokeState* state,
+    const FaceCenteredGrid3& velocity,
+    const std::vector<const ScalarGrid3*>& scalars);
+
+// Downloads the velocity and the scalar channels of the last upload.
+void downloadCudaSmokeGrids(
+    const CudaSmokeState* state,
+    FaceCenteredGrid3* velocity,
+    const std::vector<ScalarGrid3*>& scalars);
+
+// Downloads the scalar channel of given index only.
+void downloadCudaSmokeScalarGrid(
+    const CudaSmokeState* state,
+    size_t index,
+    ScalarGrid3* scalar);
+
+// Advances the uploaded grids by a sub-time-step: advection, buoyancy,
+// pressure, diffusion and decay, with the boundary condition after each
+// velocity update.
+void advanceCudaSmoke(
+    CudaSmokeState* state,
+    const CudaSmokeParameters& params,
+    double timeIntervalInSeconds);
+
+// Returns the largest face velocity component, in absolute value, of the
+// velocity on the device.
+double cudaSmokeMaxVelocity(const CudaSmokeState* state);
+
+// Returns the number of iterations of the last pressure solve.
+unsigned int cudaSmokeLastNumberOfIterations(const CudaSmokeState* state);
+
+// Returns the residual of the last pressure solve.
+double cudaSmokeLastResidual(const CudaSmokeState* state);
+
+// Returns the device memory of the grids and the solver vectors in bytes.
+size_t cudaSmokeMemoryInBytes(const CudaSmokeState* state);
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif  // SRC_JET_CUDA_SMOKE_HELPERS_H_
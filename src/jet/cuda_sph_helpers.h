@@ -0,0 +1,73 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_CUDA_SPH_HELPERS_H_
+#define SRC_JET_CUDA_SPH_HELPERS_H_
+
+#include <jet/sph_cuda_solver3.h>
+#include <jet/size3.h>
+#include <cuda_helpers.h>
+
+// Device side of SphCudaSolver3. The functions are implemented in
+// src/jet_cuda when the library is built with JET_USE_CUDA, and stubbed out
+// in sph_cuda_solver3.cpp otherwise.
+
+namespace jet {
+
+namespace internal {
+
+struct CudaSphParameters {
+    double kernelRadius = 0.0;
+    double mass = 0.0;
+    double targetDensity = 0.0;
+    double eosScale = 0.0;
+    double eosExponent = 0.0;
+    double negativePressureScale = 0.0;
+    double viscosityCoefficient = 0.0;
+};
+
+CudaSphState* createCudaSphState();
+
+// Uploads the particles and sorts them into the hash grid buckets with the
+// spacing of twice the kernel radius.
+void buildCudaSphNeighborGrid(
+    CudaSphState* state,
+    const ConstArrayAccessor1<Vector3D>& positions,
+    const ConstArrayAccessor1<Vector3D>& velocities,
+    double kernelRadius,
+    const Size3& resolution);
+
+// Computes the densities of the uploaded particles and downloads them.
+void updateCudaSphDensities(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    ArrayAccessor1<double> densities);
+
+// Adds the viscosity force to the forces.
+void accumulateCudaSphViscosityForce(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    ArrayAccessor1<Vector3D> forces);
+
+// Computes the pressures from the EOS, downloads them, and adds the pressure
+// force to the forces.
+void accumulateCudaSphPressureForce(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    ArrayAccessor1<double> pressures,
+    ArrayAccessor1<Vector3D> forces);
+
+// Blends the velocities towards the smoothed velocities by given factor.
+void computeCudaSphPseudoViscosity(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    double factor,
+    ArrayAccessor1<Vector3D> velocities);
+
+// Returns the number of neighbors found by the last density update.
+size_t cudaSphNumberOfNeighbors(const CudaSphState* state);
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif  // SRC_JET_CUDA_SPH_HELPERS_H_
@@ -2,6 +2,7 @@
 
 #include <pch.h>
 #include <jet/custom_scalar_field3.h>
+#include <array>
 
 using namespace jet;
 
@@ -31,30 +32,75 @@ CustomScalarField3::CustomScalarField3(
     _resolution(1e-3) {
 }
 
+CustomScalarField3::CustomScalarField3(
+    const BatchFunction& customBatchFunction,
+    double derivativeResolution) :
+    _customBatchFunction(customBatchFunction),
+    _resolution(derivativeResolution) {
+}
+
+CustomScalarField3::CustomScalarField3(
+    const BatchFunction& customBatchFunction,
+    const std::function<Vector3D(const Vector3D&)>& customGradientFunction,
+    const std::function<double(const Vector3D&)>& customLaplacianFunction) :
+    _customBatchFunction(customBatchFunction),
+    _customGradientFunction(customGradientFunction),
+    _customLaplacianFunction(customLaplacianFunction),
+    _resolution(1e-3) {
+}
+
 double CustomScalarField3::sample(const Vector3D& x) const {
-    return _customFunction(x);
+    if (_customBatchFunction) {
+        double result = 0.0;
+        _customBatchFunction(
+            ConstArrayAccessor1<Vector3D>(1, &x),
+            ArrayAccessor1<double>(1, &result));
+        return result;
+    } else {
+        return _customFunction(x);
+    }
+}
+
+void CustomScalarField3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<double> result) const {
+    if (_customBatchFunction) {
+        _customBatchFunction(x, result);
+    } else {
+        for (size_t i = 0; i < x.size(); ++i) {
+            result[i] = _customFunction(x[i]);
+        }
+    }
 }
 
 std::function<double(const Vector3D&)> CustomScalarField3::sampler() const {
-    return _customFunction;
+    if (_customBatchFunction) {
+        BatchFunction batchFunction = _customBatchFunction;
+        return [batchFunction](const Vector3D& x) -> double {
+            double result = 0.0;
+            batchFunction(
+                ConstArrayAccessor1<Vector3D>(1, &x),
+                ArrayAccessor1<double>(1, &result));
+            return result;
+        };
+    } else {
+        return _customFunction;
+    }
 }
 
 Vector3D CustomScalarField3::gradient(const Vector3D& x) const {
     if (_customGradientFunction) {
         return _customGradientFunction(x);
     } else {
-        double left
-            = _customFunction(x - Vector3D(0.5 * _resolution, 0.0, 0.0));
-        double right
-            = _customFunction(x + Vector3D(0.5 * _resolution, 0.0, 0.0));
-        double bottom
-            = _customFunction(x - Vector3D(0.0, 0.5 * _resolution, 0.0));
-        double top
-            = _customFunction(x + Vector3D(0.0, 0.5 * _resolution, 0.0));
-        double back
-            = _customFunction(x - Vector3D(0.0, 0.0, 0.5 * _resolution));
-        double front
-            = _customFunction(x + Vector3D(0.0, 0.0, 0.5 * _resolution));
+        std::array<double, 6> values;
+        sampleStencil(x, &values);
+
+        double left = values[0];
+        double right = values[1];
+        double bottom = values[2];
+        double top = values[3];
+        double back = values[4];
+        double front = values[5];
 
         return Vector3D(
             (right - left) / _resolution,
@@ -67,21 +113,35 @@ double CustomScalarField3::laplacian(const Vector3D& x) const {
     if (_customLaplacianFunction) {
         return _customLaplacianFunction(x);
     } else {
-        double center = _customFunction(x);
-        double left
-            = _customFunction(x - Vector3D(0.5 * _resolution, 0.0, 0.0));
-        double right
-            = _customFunction(x + Vector3D(0.5 * _resolution, 0.0, 0.0));
-        double bottom
-            = _customFunction(x - Vector3D(0.0, 0.5 * _resolution, 0.0));
-        double top
-            = _customFunction(x + Vector3D(0.0, 0.5 * _resolution, 0.0));
-        double back
-            = _customFunction(x - Vector3D(0.0, 0.0, 0.5 * _resolution));
-        double front
-            = _customFunction(x + Vector3D(0.0, 0.0, 0.5 * _resolution));
+        double center = sample(x);
+        std::array<double, 6> values;
+        sampleStencil(x, &values);
+
+        double left = values[0];
+        double right = values[1];
+        double bottom = values[2];
+        double top = values[3];
+        double back = values[4];
+        double front = values[5];
 
         return (left + right + bottom + top + back + front - 6.0 * center)
             / (_resolution * _resolution);
     }
 }
+
+void CustomScalarField3::sampleStencil(
+    const Vector3D& x, std::array<double, 6>* values) const {
+    const double h = 0.5 * _resolution;
+    const std::array<Vector3D, 6> points = {{
+        x - Vector3D(h, 0.0, 0.0),
+        x + Vector3D(h, 0.0, 0.0),
+        x - Vector3D(0.0, h, 0.0),
+        x + Vector3D(0.0, h, 0.0),
+        x - Vector3D(0.0, 0.0, h),
+        x + Vector3D(0.0, 0.0, h)
+    }};
+
+    batchSample(
+        ConstArrayAccessor1<Vector3D>(points.size(), points.data()),
+        ArrayAccessor1<double>(values->size(), values->data()));
+}
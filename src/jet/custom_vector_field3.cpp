@@ -2,6 +2,7 @@
 
 #include <pch.h>
 #include <jet/custom_vector_field3.h>
+#include <array>
 
 using namespace jet;
 
@@ -30,26 +31,59 @@ CustomVectorField3::CustomVectorField3(
     _customCurlFunction(customCurlFunction) {
 }
 
+CustomVectorField3::CustomVectorField3(
+    const BatchFunction& customBatchFunction,
+    double derivativeResolution) :
+    _customBatchFunction(customBatchFunction),
+    _resolution(derivativeResolution) {
+}
+
+CustomVectorField3::CustomVectorField3(
+    const BatchFunction& customBatchFunction,
+    const std::function<double(const Vector3D&)>& customDivergenceFunction,
+    const std::function<Vector3D(const Vector3D&)>& customCurlFunction) :
+    _customBatchFunction(customBatchFunction),
+    _customDivergenceFunction(customDivergenceFunction),
+    _customCurlFunction(customCurlFunction) {
+}
+
 Vector3D CustomVectorField3::sample(const Vector3D& x) const {
-    return _customFunction(x);
+    if (_customBatchFunction) {
+        Vector3D result;
+        _customBatchFunction(
+            ConstArrayAccessor1<Vector3D>(1, &x),
+            ArrayAccessor1<Vector3D>(1, &result));
+        return result;
+    } else {
+        return _customFunction(x);
+    }
+}
+
+void CustomVectorField3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<Vector3D> result) const {
+    if (_customBatchFunction) {
+        _customBatchFunction(x, result);
+    } else {
+        for (size_t i = 0; i < x.size(); ++i) {
+            result[i] = _customFunction(x[i]);
+        }
+    }
 }
 
 double CustomVectorField3::divergence(const Vector3D& x) const {
     if (_customDivergenceFunction) {
         return _customDivergenceFunction(x);
     } else {
-        double left
-            = _customFunction(x - Vector3D(0.5 * _resolution, 0.0, 0.0)).x;
-        double right
-            = _customFunction(x + Vector3D(0.5 * _resolution, 0.0, 0.0)).x;
-        double bottom
-            = _customFunction(x - Vector3D(0.0, 0.5 * _resolution, 0.0)).y;
-        double top
-            = _customFunction(x + Vector3D(0.0, 0.5 * _resolution, 0.0)).y;
-        double back
-            = _customFunction(x - Vector3D(0.0, 0.0, 0.5 * _resolution)).z;
-        double front
-            = _customFunction(x + Vector3D(0.0, 0.0, 0.5 * _resolution)).z;
+        std::array<Vector3D, 6> values;
+        sampleStencil(x, &values);
+
+        double left = values[0].x;
+        double right = values[1].x;
+        double bottom = values[2].y;
+        double top = values[3].y;
+        double back = values[4].z;
+        double front = values[5].z;
 
         return (right - left + top - bottom + front - back) / _resolution;
     }
@@ -59,18 +93,15 @@ Vector3D CustomVectorField3::curl(const Vector3D& x) const {
     if (_customCurlFunction) {
         return _customCurlFunction(x);
     } else {
-        Vector3D left
-            = _customFunction(x - Vector3D(0.5 * _resolution, 0.0, 0.0));
-        Vector3D right
-            = _customFunction(x + Vector3D(0.5 * _resolution, 0.0, 0.0));
-        Vector3D bottom
-            = _customFunction(x - Vector3D(0.0, 0.5 * _resolution, 0.0));
-        Vector3D top
-            = _customFunction(x + Vector3D(0.0, 0.5 * _resolution, 0.0));
-        Vector3D back
-            = _customFunction(x - Vector3D(0.0, 0.0, 0.5 * _resolution));
-        Vector3D front
-            = _customFunction(x + Vector3D(0.0, 0.0, 0.5 * _resolution));
+        std::array<Vector3D, 6> values;
+        sampleStencil(x, &values);
+
+        const Vector3D& left = values[0];
+        const Vector3D& right = values[1];
+        const Vector3D& bottom = values[2];
+        const Vector3D& top = values[3];
+        const Vector3D& back = values[4];
+        const Vector3D& front = values[5];
 
         double Fx_ym = bottom.x;
         double Fx_yp = top.x;
@@ -95,5 +126,33 @@ Vector3D CustomVectorField3::curl(const Vector3D& x) const {
 }
 
 std::function<Vector3D(const Vector3D&)> CustomVectorField3::sampler() const {
-    return _customFunction;
+    if (_customBatchFunction) {
+        BatchFunction batchFunction = _customBatchFunction;
+        return [batchFunction](const Vector3D& x) -> Vector3D {
+            Vector3D result;
+            batchFunction(
+                ConstArrayAccessor1<Vector3D>(1, &x),
+                ArrayAccessor1<Vector3D>(1, &result));
+            return result;
+        };
+    } else {
+        return _customFunction;
+    }
+}
+
+void CustomVectorField3::sampleStencil(
+    const Vector3D& x, std::array<Vector3D, 6>* values) const {
+    const double h = 0.5 * _resolution;
+    const std::array<Vector3D, 6> points = {{
+        x - Vector3D(h, 0.0, 0.0),
+        x + Vector3D(h, 0.0, 0.0),
+        x - Vector3D(0.0, h, 0.0),
+        x + Vector3D(0.0, h, 0.0),
+        x - Vector3D(0.0, 0.0, h),
+        x + Vector3D(0.0, 0.0, h)
+    }};
+
+    batchSample(
+        ConstArrayAccessor1<Vector3D>(points.size(), points.data()),
+        ArrayAccessor1<Vector3D>(values->size(), values->data()));
 }
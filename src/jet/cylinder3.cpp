@@ -4,9 +4,168 @@
 #include <jet/box2.h>
 #include <jet/cylinder3.h>
 #include <jet/plane3.h>
+#include <primitive_distance_helpers.h>
+
+#include <algorithm>
+#include <cmath>
 
 using namespace jet;
 
+namespace {
+
+// Signed distance of the rectangle that the cylinder sweeps around its axis,
+// in the plane of the radial distance and the height
+void cylinderDistancesScalar(
+    size_t begin,
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double halfHeight,
+    double* result) {
+    for (size_t i = begin; i < n; ++i) {
+        double dx = p.x[i] - c.x;
+        double dz = p.z[i] - c.z;
+        double qr = std::sqrt(dx * dx + dz * dz) - r;
+        double qy = std::fabs(p.y[i] - c.y) - halfHeight;
+        double orad = std::max(qr, 0.0);
+        double oy = std::max(qy, 0.0);
+        result[i] = std::sqrt(orad * orad + oy * oy)
+            + std::min(std::max(qr, qy), 0.0);
+    }
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 void cylinderDistancesSse2(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double halfHeight,
+    double* result) {
+    const __m128d cx = _mm_set1_pd(c.x);
+    const __m128d cy = _mm_set1_pd(c.y);
+    const __m128d cz = _mm_set1_pd(c.z);
+    const __m128d rr = _mm_set1_pd(r);
+    const __m128d hh = _mm_set1_pd(halfHeight);
+    const __m128d zero = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(p.x + i), cx);
+        __m128d dz = _mm_sub_pd(_mm_loadu_pd(p.z + i), cz);
+        __m128d qr = _mm_sub_pd(
+            _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dz, dz))),
+            rr);
+        __m128d qy = _mm_sub_pd(
+            absSse2(_mm_sub_pd(_mm_loadu_pd(p.y + i), cy)), hh);
+        __m128d orad = _mm_max_pd(qr, zero);
+        __m128d oy = _mm_max_pd(qy, zero);
+        __m128d outside = _mm_sqrt_pd(
+            _mm_add_pd(_mm_mul_pd(orad, orad), _mm_mul_pd(oy, oy)));
+        __m128d inside = _mm_min_pd(_mm_max_pd(qr, qy), zero);
+        _mm_storeu_pd(result + i, _mm_add_pd(outside, inside));
+    }
+    cylinderDistancesScalar(i, n, p, c, r, halfHeight, result);
+}
+
+JET_TARGET_AVX void cylinderDistancesAvx(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double halfHeight,
+    double* result) {
+    const __m256d cx = _mm256_set1_pd(c.x);
+    const __m256d cy = _mm256_set1_pd(c.y);
+    const __m256d cz = _mm256_set1_pd(c.z);
+    const __m256d rr = _mm256_set1_pd(r);
+    const __m256d hh = _mm256_set1_pd(halfHeight);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(p.x + i), cx);
+        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(p.z + i), cz);
+        __m256d qr = _mm256_sub_pd(
+            _mm256_sqrt_pd(
+                _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dz, dz))),
+            rr);
+        __m256d qy = _mm256_sub_pd(
+            absAvx(_mm256_sub_pd(_mm256_loadu_pd(p.y + i), cy)), hh);
+        __m256d orad = _mm256_max_pd(qr, zero);
+        __m256d oy = _mm256_max_pd(qy, zero);
+        __m256d outside = _mm256_sqrt_pd(
+            _mm256_add_pd(_mm256_mul_pd(orad, orad), _mm256_mul_pd(oy, oy)));
+        __m256d inside = _mm256_min_pd(_mm256_max_pd(qr, qy), zero);
+        _mm256_storeu_pd(result + i, _mm256_add_pd(outside, inside));
+    }
+    cylinderDistancesScalar(i, n, p, c, r, halfHeight, result);
+}
+
+#elif defined(JET_SIMD_NEON)
+
+void cylinderDistancesNeon(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double halfHeight,
+    double* result) {
+    const float64x2_t cx = vdupq_n_f64(c.x);
+    const float64x2_t cy = vdupq_n_f64(c.y);
+    const float64x2_t cz = vdupq_n_f64(c.z);
+    const float64x2_t rr = vdupq_n_f64(r);
+    const float64x2_t hh = vdupq_n_f64(halfHeight);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t dx = vsubq_f64(vld1q_f64(p.x + i), cx);
+        float64x2_t dz = vsubq_f64(vld1q_f64(p.z + i), cz);
+        float64x2_t qr = vsubq_f64(
+            vsqrtq_f64(vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dz, dz))), rr);
+        float64x2_t qy = vsubq_f64(
+            vabsq_f64(vsubq_f64(vld1q_f64(p.y + i), cy)), hh);
+        float64x2_t orad = vmaxq_f64(qr, zero);
+        float64x2_t oy = vmaxq_f64(qy, zero);
+        float64x2_t outside = vsqrtq_f64(
+            vaddq_f64(vmulq_f64(orad, orad), vmulq_f64(oy, oy)));
+        float64x2_t inside = vminq_f64(vmaxq_f64(qr, qy), zero);
+        vst1q_f64(result + i, vaddq_f64(outside, inside));
+    }
+    cylinderDistancesScalar(i, n, p, c, r, halfHeight, result);
+}
+
+#endif
+
+void cylinderDistances(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double halfHeight,
+    double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+        case SimdInstructionSet::Avx:
+            cylinderDistancesAvx(n, p, c, r, halfHeight, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            cylinderDistancesSse2(n, p, c, r, halfHeight, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            cylinderDistancesNeon(n, p, c, r, halfHeight, result);
+            return;
+#endif
+        default:
+            cylinderDistancesScalar(0, n, p, c, r, halfHeight, result);
+            return;
+    }
+}
+
+}  // namespace
+
 Cylinder3::Cylinder3() {
 }
 
@@ -224,3 +383,14 @@ BoundingBox3D Cylinder3::boundingBox() const {
         center - Vector3D(radius, 0.5 * height, radius),
         center + Vector3D(radius, 0.5 * height, radius));
 }
+
+void Cylinder3::actualBatchClosestSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    const double halfHeight = 0.5 * height;
+    primitiveSignedDistances(
+        otherPoints, result,
+        [&](size_t n, const PrimitiveDistanceChunk& p, double* out) {
+            cylinderDistances(n, p, center, radius, halfHeight, out);
+        });
+}
@@ -3,6 +3,7 @@
 #include <pch.h>
 #include <jet/pde.h>
 #include <jet/eno_level_set_solver3.h>
+#include <level_set_stencil_helpers.h>
 #include <algorithm>
 
 using namespace jet;
@@ -70,3 +71,17 @@ void EnoLevelSetSolver3::getDerivatives(
     D0[6] = grid(i, j, kp3);
     *dz = eno3(D0, gridSpacing.z);
 }
+
+void EnoLevelSetSolver3::getDerivativesAlongX(
+    ConstArrayAccessor3<double> grid,
+    const Vector3D& gridSpacing,
+    size_t iBegin,
+    size_t iEnd,
+    size_t j,
+    size_t k,
+    std::array<double, 2>* dx,
+    std::array<double, 2>* dy,
+    std::array<double, 2>* dz) const {
+    jet::getDerivativesAlongX<Eno3Stencil>(
+        grid, gridSpacing, iBegin, iEnd, j, k, dx, dy, dz);
+}
@@ -0,0 +1,440 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/array_samplers3.h>
+#include <jet/error_corrected_semi_lagrangian3.h>
+#include <jet/parallel.h>
+#include <semi_lagrangian_helpers.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Reverses the flow so that backTrace traces forward in time.
+template <typename FlowSampler>
+class ReversedFlowSampler {
+ public:
+    explicit ReversedFlowSampler(const FlowSampler& flow) : _flow(flow) {
+    }
+
+    Vector3D operator()(const Vector3D& x) const {
+        return -_flow(x);
+    }
+
+ private:
+    const FlowSampler& _flow;
+};
+
+// Traces the data points outside of the boundary backward and forward in
+// time.
+class TraceJob {
+ public:
+    TraceJob(
+        const Size3& dataSize,
+        const Vector3D& dataOrigin,
+        const Vector3D& gridSpacing,
+        double dt,
+        const ArrayAccessor3<Vector3D>& sources,
+        const ArrayAccessor3<Vector3D>& destinations,
+        const ArrayAccessor3<char>& isActive)
+    : _dataSize(dataSize),
+      _dataOrigin(dataOrigin),
+      _gridSpacing(gridSpacing),
+      _dt(dt),
+      _h(min3(gridSpacing.x, gridSpacing.y, gridSpacing.z)),
+      _sources(sources),
+      _destinations(destinations),
+      _isActive(isActive) {
+    }
+
+    template <typename FlowSampler, typename SdfSampler>
+    void operator()(
+        const FlowSampler& flow, const SdfSampler& boundarySdf) const {
+        ReversedFlowSampler<FlowSampler> reversedFlow(flow);
+        ArrayAccessor3<Vector3D> sources = _sources;
+        ArrayAccessor3<Vector3D> destinations = _destinations;
+        ArrayAccessor3<char> isActive = _isActive;
+
+        parallelFor(
+            kZeroSize, _dataSize.x,
+            kZeroSize, _dataSize.y,
+            kZeroSize, _dataSize.z,
+            [&](size_t i, size_t j, size_t k) {
+                Vector3D x = _dataOrigin + _gridSpacing * Vector3D({i, j, k});
+                if (boundarySdf(x) > 0.0) {
+                    isActive(i, j, k) = 1;
+                    sources(i, j, k)
+                        = backTrace(flow, boundarySdf, _dt, _h, x);
+                    destinations(i, j, k)
+                        = backTrace(reversedFlow, boundarySdf, _dt, _h, x);
+                } else {
+                    isActive(i, j, k) = 0;
+                }
+            });
+    }
+
+ private:
+    Size3 _dataSize;
+    Vector3D _dataOrigin;
+    Vector3D _gridSpacing;
+    double _dt;
+    double _h;
+    ArrayAccessor3<Vector3D> _sources;
+    ArrayAccessor3<Vector3D> _destinations;
+    ArrayAccessor3<char> _isActive;
+};
+
+// Clamps the value to the range of the input values that the sampler
+// interpolates at x.
+template <typename T>
+T limit(
+    const LinearArraySampler3<T, double>& sampler,
+    const ConstArrayAccessor3<T>& input,
+    const Vector3D& x,
+    const T& value) {
+    using std::max;
+    using std::min;
+
+    std::array<Point3UI, 8> indices;
+    std::array<double, 8> weights;
+    sampler.getCoordinatesAndWeights(x, &indices, &weights);
+
+    T lower = input(indices[0]);
+    T upper = lower;
+    for (size_t n = 1; n < 8; ++n) {
+        lower = min(lower, input(indices[n]));
+        upper = max(upper, input(indices[n]));
+    }
+
+    return clamp(value, lower, upper);
+}
+
+// Advects a data array with the traced points. The points inside the
+// boundary keep their output values, and take the input values in the
+// intermediate fields.
+template <typename T>
+void advectData(
+    bool isBfecc,
+    bool isUsingLimiter,
+    const ConstArrayAccessor3<T>& input,
+    const Vector3D& dataOrigin,
+    const Vector3D& gridSpacing,
+    const ConstArrayAccessor3<Vector3D>& sources,
+    const ConstArrayAccessor3<Vector3D>& destinations,
+    const ConstArrayAccessor3<char>& isActive,
+    ArrayAccessor3<T> forward,
+    ArrayAccessor3<T> corrected,
+    ArrayAccessor3<T> output) {
+    const Size3 size = input.size();
+    LinearArraySampler3<T, double> inputSampler(
+        input, gridSpacing, dataOrigin);
+
+    // Semi-Lagrangian step forward in time
+    parallelFor(
+        kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+        [&](size_t i, size_t j, size_t k) {
+            forward(i, j, k) = isActive(i, j, k)
+                ? inputSampler(sources(i, j, k)) : input(i, j, k);
+        });
+
+    LinearArraySampler3<T, double> forwardSampler(
+        ConstArrayAccessor3<T>(forward), gridSpacing, dataOrigin);
+
+    if (isBfecc) {
+        // Input corrected by half of the round-trip error
+        parallelFor(
+            kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+            [&](size_t i, size_t j, size_t k) {
+                const T& phi = input(i, j, k);
+                corrected(i, j, k) = isActive(i, j, k)
+                    ? phi + 0.5 * (phi - forwardSampler(destinations(i, j, k)))
+                    : phi;
+            });
+
+        LinearArraySampler3<T, double> correctedSampler(
+            ConstArrayAccessor3<T>(corrected), gridSpacing, dataOrigin);
+
+        parallelFor(
+            kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+            [&](size_t i, size_t j, size_t k) {
+                if (isActive(i, j, k)) {
+                    const Vector3D& x = sources(i, j, k);
+                    T result = correctedSampler(x);
+                    output(i, j, k) = isUsingLimiter
+                        ? limit(inputSampler, input, x, result) : result;
+                }
+            });
+    } else {
+        // Forward result corrected by half of the round-trip error
+        parallelFor(
+            kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+            [&](size_t i, size_t j, size_t k) {
+                if (isActive(i, j, k)) {
+                    const Vector3D& x = sources(i, j, k);
+                    T result = forward(i, j, k) + 0.5 * (input(i, j, k)
+                        - forwardSampler(destinations(i, j, k)));
+                    output(i, j, k) = isUsingLimiter
+                        ? limit(inputSampler, input, x, result) : result;
+                }
+            });
+    }
+}
+
+}  // namespace
+
+ErrorCorrectedSemiLagrangian3::ErrorCorrectedSemiLagrangian3(Scheme scheme) :
+    _scheme(scheme) {
+}
+
+ErrorCorrectedSemiLagrangian3::~ErrorCorrectedSemiLagrangian3() {
+}
+
+void ErrorCorrectedSemiLagrangian3::advect(
+    const ScalarGrid3& input,
+    const VectorField3& flow,
+    double dt,
+    ScalarGrid3* output,
+    const ScalarField3& boundarySdf) {
+    if (!hasSameDataLayout(input, *output)) {
+        _semiLagrangian.advect(input, flow, dt, output, boundarySdf);
+        return;
+    }
+
+    advectGroup(
+        {input.constDataAccessor()}, {}, {output->dataAccessor()}, {},
+        output->dataSize(), output->dataOrigin(), output->gridSpacing(),
+        flow, dt, boundarySdf);
+}
+
+void ErrorCorrectedSemiLagrangian3::advect(
+    const CollocatedVectorGrid3& input,
+    const VectorField3& flow,
+    double dt,
+    CollocatedVectorGrid3* output,
+    const ScalarField3& boundarySdf) {
+    if (!hasSameDataLayout(input, *output)) {
+        _semiLagrangian.advect(input, flow, dt, output, boundarySdf);
+        return;
+    }
+
+    advectGroup(
+        {}, {input.constDataAccessor()}, {}, {output->dataAccessor()},
+        output->dataSize(), output->dataOrigin(), output->gridSpacing(),
+        flow, dt, boundarySdf);
+}
+
+void ErrorCorrectedSemiLagrangian3::advect(
+    const FaceCenteredGrid3& input,
+    const VectorField3& flow,
+    double dt,
+    FaceCenteredGrid3* output,
+    const ScalarField3& boundarySdf) {
+    if (input.resolution() != output->resolution()
+        || !input.origin().isSimilar(output->origin())
+        || !input.gridSpacing().isSimilar(output->gridSpacing())) {
+        _semiLagrangian.advect(input, flow, dt, output, boundarySdf);
+        return;
+    }
+
+    ConstArrayAccessor3<double> inputData[3] = {
+        input.uConstAccessor(),
+        input.vConstAccessor(),
+        input.wConstAccessor()
+    };
+    ArrayAccessor3<double> outputData[3] = {
+        output->uAccessor(),
+        output->vAccessor(),
+        output->wAccessor()
+    };
+    Vector3D origins[3] = {
+        output->uOrigin(),
+        output->vOrigin(),
+        output->wOrigin()
+    };
+
+    for (size_t c = 0; c < 3; ++c) {
+        advectGroup(
+            {inputData[c]}, {}, {outputData[c]}, {},
+            outputData[c].size(), origins[c], output->gridSpacing(),
+            flow, dt, boundarySdf);
+    }
+}
+
+void ErrorCorrectedSemiLagrangian3::advect(
+    const std::vector<const ScalarGrid3*>& scalarInputs,
+    const std::vector<const CollocatedVectorGrid3*>& vectorInputs,
+    const VectorField3& flow,
+    double dt,
+    const std::vector<ScalarGrid3*>& scalarOutputs,
+    const std::vector<CollocatedVectorGrid3*>& vectorOutputs,
+    const ScalarField3& boundarySdf) {
+    JET_THROW_INVALID_ARG_IF(scalarInputs.size() != scalarOutputs.size());
+    JET_THROW_INVALID_ARG_IF(vectorInputs.size() != vectorOutputs.size());
+
+    // Grids whose input and output layouts differ fall back to the plain
+    // semi-Lagrangian method.
+    std::vector<bool> scalarDone(scalarInputs.size(), false);
+    std::vector<bool> vectorDone(vectorInputs.size(), false);
+    for (size_t c = 0; c < scalarInputs.size(); ++c) {
+        if (!hasSameDataLayout(*scalarInputs[c], *scalarOutputs[c])) {
+            _semiLagrangian.advect(
+                *scalarInputs[c], flow, dt, scalarOutputs[c], boundarySdf);
+            scalarDone[c] = true;
+        }
+    }
+    for (size_t c = 0; c < vectorInputs.size(); ++c) {
+        if (!hasSameDataLayout(*vectorInputs[c], *vectorOutputs[c])) {
+            _semiLagrangian.advect(
+                *vectorInputs[c], flow, dt, vectorOutputs[c], boundarySdf);
+            vectorDone[c] = true;
+        }
+    }
+
+    // Each remaining group of grids with the same layout is traced once
+    while (true) {
+        bool hasGroup = false;
+        Size3 dataSize;
+        Vector3D dataOrigin;
+        Vector3D gridSpacing;
+
+        for (size_t c = 0; c < scalarOutputs.size() && !hasGroup; ++c) {
+            if (!scalarDone[c]) {
+                hasGroup = true;
+                dataSize = scalarOutputs[c]->dataSize();
+                dataOrigin = scalarOutputs[c]->dataOrigin();
+                gridSpacing = scalarOutputs[c]->gridSpacing();
+            }
+        }
+        for (size_t c = 0; c < vectorOutputs.size() && !hasGroup; ++c) {
+            if (!vectorDone[c]) {
+                hasGroup = true;
+                dataSize = vectorOutputs[c]->dataSize();
+                dataOrigin = vectorOutputs[c]->dataOrigin();
+                gridSpacing = vectorOutputs[c]->gridSpacing();
+            }
+        }
+        if (!hasGroup) {
+            break;
+        }
+
+        std::vector<ConstArrayAccessor3<double>> scalarInputData;
+        std::vector<ArrayAccessor3<double>> scalarOutputData;
+        for (size_t c = 0; c < scalarOutputs.size(); ++c) {
+            if (!scalarDone[c] && hasDataLayout(
+                    *scalarOutputs[c], dataSize, dataOrigin, gridSpacing)) {
+                scalarInputData.push_back(scalarInputs[c]->constDataAccessor());
+                scalarOutputData.push_back(scalarOutputs[c]->dataAccessor());
+                scalarDone[c] = true;
+            }
+        }
+
+        std::vector<ConstArrayAccessor3<Vector3D>> vectorInputData;
+        std::vector<ArrayAccessor3<Vector3D>> vectorOutputData;
+        for (size_t c = 0; c < vectorOutputs.size(); ++c) {
+            if (!vectorDone[c] && hasDataLayout(
+                    *vectorOutputs[c], dataSize, dataOrigin, gridSpacing)) {
+                vectorInputData.push_back(vectorInputs[c]->constDataAccessor());
+                vectorOutputData.push_back(vectorOutputs[c]->dataAccessor());
+                vectorDone[c] = true;
+            }
+        }
+
+        advectGroup(
+            scalarInputData, vectorInputData,
+            scalarOutputData, vectorOutputData,
+            dataSize, dataOrigin, gridSpacing, flow, dt, boundarySdf);
+    }
+}
+
+bool ErrorCorrectedSemiLagrangian3::isUsingLimiter() const {
+    return _isUsingLimiter;
+}
+
+void ErrorCorrectedSemiLagrangian3::setIsUsingLimiter(bool isUsing) {
+    _isUsingLimiter = isUsing;
+}
+
+void ErrorCorrectedSemiLagrangian3::advectGroup(
+    const std::vector<ConstArrayAccessor3<double>>& scalarInputs,
+    const std::vector<ConstArrayAccessor3<Vector3D>>& vectorInputs,
+    const std::vector<ArrayAccessor3<double>>& scalarOutputs,
+    const std::vector<ArrayAccessor3<Vector3D>>& vectorOutputs,
+    const Size3& dataSize,
+    const Vector3D& dataOrigin,
+    const Vector3D& gridSpacing,
+    const VectorField3& flow,
+    double dt,
+    const ScalarField3& boundarySdf) {
+    // The buffers of the previous group or time-step are reused
+    std::unique_ptr<ScratchArena> scratch = acquireScratch();
+
+    ArrayAccessor3<Vector3D> sources = scratch->array3<Vector3D>(dataSize);
+    ArrayAccessor3<Vector3D> destinations
+        = scratch->array3<Vector3D>(dataSize);
+    ArrayAccessor3<char> isActive = scratch->array3<char>(dataSize);
+
+    runWithFieldSamplers(
+        flow,
+        boundarySdf,
+        TraceJob(
+            dataSize, dataOrigin, gridSpacing, dt,
+            sources, destinations, isActive));
+
+    const bool isBfecc = (_scheme == Scheme::Bfecc);
+
+    if (!scalarInputs.empty()) {
+        ArrayAccessor3<double> forward = scratch->array3<double>(dataSize);
+        ArrayAccessor3<double> corrected;
+        if (isBfecc) {
+            corrected = scratch->array3<double>(dataSize);
+        }
+
+        for (size_t c = 0; c < scalarInputs.size(); ++c) {
+            advectData(
+                isBfecc, _isUsingLimiter, scalarInputs[c],
+                dataOrigin, gridSpacing, sources, destinations, isActive,
+                forward, corrected, scalarOutputs[c]);
+        }
+    }
+
+    if (!vectorInputs.empty()) {
+        ArrayAccessor3<Vector3D> forward
+            = scratch->array3<Vector3D>(dataSize);
+        ArrayAccessor3<Vector3D> corrected;
+        if (isBfecc) {
+            corrected = scratch->array3<Vector3D>(dataSize);
+        }
+
+        for (size_t c = 0; c < vectorInputs.size(); ++c) {
+            advectData(
+                isBfecc, _isUsingLimiter, vectorInputs[c],
+                dataOrigin, gridSpacing, sources, destinations, isActive,
+                forward, corrected, vectorOutputs[c]);
+        }
+    }
+
+    releaseScratch(std::move(scratch));
+}
+
+std::unique_ptr<ScratchArena> ErrorCorrectedSemiLagrangian3::acquireScratch() {
+    std::lock_guard<std::mutex> lock(_scratchMutex);
+    if (_scratches.empty()) {
+        return std::unique_ptr<ScratchArena>(new ScratchArena());
+    }
+
+    std::unique_ptr<ScratchArena> scratch = std::move(_scratches.back());
+    _scratches.pop_back();
+    scratch->reset();
+    return scratch;
+}
+
+void ErrorCorrectedSemiLagrangian3::releaseScratch(
+    std::unique_ptr<ScratchArena> scratch) {
+    std::lock_guard<std::mutex> lock(_scratchMutex);
+    _scratches.push_back(std::move(scratch));
+}
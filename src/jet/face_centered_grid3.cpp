@@ -110,16 +110,15 @@ void FaceCenteredGrid3::swap(Grid3* other) {
         std::swap(_uLinearSampler, sameType->_uLinearSampler);
         std::swap(_vLinearSampler, sameType->_vLinearSampler);
         std::swap(_wLinearSampler, sameType->_wLinearSampler);
-        std::swap(_sampler, sameType->_sampler);
     }
 }
 
 void FaceCenteredGrid3::set(const FaceCenteredGrid3& other) {
     setGrid(other);
 
-    _dataU.set(other._dataU);
-    _dataV.set(other._dataV);
-    _dataW.set(other._dataW);
+    _dataU = other._dataU;
+    _dataV = other._dataV;
+    _dataW = other._dataW;
     _dataOriginU = other._dataOriginU;
     _dataOriginV = other._dataOriginV;
     _dataOriginW = other._dataOriginW;
@@ -134,7 +133,7 @@ FaceCenteredGrid3::operator=(const FaceCenteredGrid3& other) {
 }
 
 double& FaceCenteredGrid3::u(size_t i, size_t j, size_t k) {
-    return _dataU(i, j, k);
+    return mutableData(&_dataU)(i, j, k);
 }
 
 const double& FaceCenteredGrid3::u(size_t i, size_t j, size_t k) const {
@@ -142,7 +141,7 @@ const double& FaceCenteredGrid3::u(size_t i, size_t j, size_t k) const {
 }
 
 double& FaceCenteredGrid3::v(size_t i, size_t j, size_t k) {
-    return _dataV(i, j, k);
+    return mutableData(&_dataV)(i, j, k);
 }
 
 const double& FaceCenteredGrid3::v(size_t i, size_t j, size_t k) const {
@@ -150,7 +149,7 @@ const double& FaceCenteredGrid3::v(size_t i, size_t j, size_t k) const {
 }
 
 double& FaceCenteredGrid3::w(size_t i, size_t j, size_t k) {
-    return _dataW(i, j, k);
+    return mutableData(&_dataW)(i, j, k);
 }
 
 const double& FaceCenteredGrid3::w(size_t i, size_t j, size_t k) const {
@@ -223,8 +222,103 @@ Vector3D FaceCenteredGrid3::curlAtCellCenter(
         0.5 * (Fy_xp - Fy_xm) / gs.x - 0.5 * (Fx_yp - Fx_ym) / gs.y);
 }
 
+void FaceCenteredGrid3::computeDivergence(
+    ArrayAccessor3<double> output) const {
+    const Size3& res = resolution();
+    const Vector3D& gs = gridSpacing();
+
+    JET_ASSERT(output.size() == res);
+
+    if (res.x == 0) {
+        return;
+    }
+
+    const Array3<double>& dataU = _dataU.get();
+    const Array3<double>& dataV = _dataV.get();
+    const Array3<double>& dataW = _dataW.get();
+    output.parallelForEachRow([&](size_t j, size_t k) {
+        const double* u = dataU.row(j, k);
+        const double* bottomV = dataV.row(j, k);
+        const double* topV = dataV.row(j + 1, k);
+        const double* backW = dataW.row(j, k);
+        const double* frontW = dataW.row(j, k + 1);
+        double* out = output.row(j, k);
+
+        for (size_t i = 0; i < res.x; ++i) {
+            out[i] = (u[i + 1] - u[i]) / gs.x
+                + (topV[i] - bottomV[i]) / gs.y
+                + (frontW[i] - backW[i]) / gs.z;
+        }
+    });
+}
+
+void FaceCenteredGrid3::computeCurl(ArrayAccessor3<Vector3D> output) const {
+    const Size3& res = resolution();
+    const Vector3D& gs = gridSpacing();
+
+    JET_ASSERT(output.size() == res);
+
+    if (res.x == 0) {
+        return;
+    }
+
+    const Array3<double>& dataU = _dataU.get();
+    const Array3<double>& dataV = _dataV.get();
+    const Array3<double>& dataW = _dataW.get();
+    output.parallelForEachRow([&](size_t j, size_t k) {
+        size_t jm = (j > 0) ? j - 1 : j;
+        size_t jp = (j + 1 < res.y) ? j + 1 : j;
+        size_t km = (k > 0) ? k - 1 : k;
+        size_t kp = (k + 1 < res.z) ? k + 1 : k;
+
+        // Face rows of the cells at (j, k) and its y and z neighbors
+        const double* uDown = dataU.row(jm, k);
+        const double* uUp = dataU.row(jp, k);
+        const double* uBack = dataU.row(j, km);
+        const double* uFront = dataU.row(j, kp);
+        const double* v0 = dataV.row(j, k);
+        const double* v1 = dataV.row(j + 1, k);
+        const double* vBack0 = dataV.row(j, km);
+        const double* vBack1 = dataV.row(j + 1, km);
+        const double* vFront0 = dataV.row(j, kp);
+        const double* vFront1 = dataV.row(j + 1, kp);
+        const double* w0 = dataW.row(j, k);
+        const double* w1 = dataW.row(j, k + 1);
+        const double* wDown0 = dataW.row(jm, k);
+        const double* wDown1 = dataW.row(jm, k + 1);
+        const double* wUp0 = dataW.row(jp, k);
+        const double* wUp1 = dataW.row(jp, k + 1);
+        Vector3D* out = output.row(j, k);
+
+        for (size_t i = 0; i < res.x; ++i) {
+            size_t im = (i > 0) ? i - 1 : i;
+            size_t ip = (i + 1 < res.x) ? i + 1 : i;
+
+            double Fx_ym = 0.5 * (uDown[i] + uDown[i + 1]);
+            double Fx_yp = 0.5 * (uUp[i] + uUp[i + 1]);
+            double Fx_zm = 0.5 * (uBack[i] + uBack[i + 1]);
+            double Fx_zp = 0.5 * (uFront[i] + uFront[i + 1]);
+
+            double Fy_xm = 0.5 * (v0[im] + v1[im]);
+            double Fy_xp = 0.5 * (v0[ip] + v1[ip]);
+            double Fy_zm = 0.5 * (vBack0[i] + vBack1[i]);
+            double Fy_zp = 0.5 * (vFront0[i] + vFront1[i]);
+
+            double Fz_xm = 0.5 * (w0[im] + w1[im]);
+            double Fz_xp = 0.5 * (w0[ip] + w1[ip]);
+            double Fz_ym = 0.5 * (wDown0[i] + wDown1[i]);
+            double Fz_yp = 0.5 * (wUp0[i] + wUp1[i]);
+
+            out[i] = Vector3D(
+                0.5 * (Fz_yp - Fz_ym) / gs.y - 0.5 * (Fy_zp - Fy_zm) / gs.z,
+                0.5 * (Fx_zp - Fx_zm) / gs.z - 0.5 * (Fz_xp - Fz_xm) / gs.x,
+                0.5 * (Fy_xp - Fy_xm) / gs.x - 0.5 * (Fx_yp - Fx_ym) / gs.y);
+        }
+    });
+}
+
 FaceCenteredGrid3::ScalarDataAccessor FaceCenteredGrid3::uAccessor() {
-    return _dataU.accessor();
+    return mutableData(&_dataU).accessor();
 }
 
 FaceCenteredGrid3::ConstScalarDataAccessor
@@ -233,7 +327,7 @@ FaceCenteredGrid3::uConstAccessor() const {
 }
 
 FaceCenteredGrid3::ScalarDataAccessor FaceCenteredGrid3::vAccessor() {
-    return _dataV.accessor();
+    return mutableData(&_dataV).accessor();
 }
 
 FaceCenteredGrid3::ConstScalarDataAccessor
@@ -242,7 +336,7 @@ FaceCenteredGrid3::vConstAccessor() const {
 }
 
 FaceCenteredGrid3::ScalarDataAccessor FaceCenteredGrid3::wAccessor() {
-    return _dataW.accessor();
+    return mutableData(&_dataW).accessor();
 }
 
 FaceCenteredGrid3::ConstScalarDataAccessor
@@ -299,56 +393,62 @@ Vector3D FaceCenteredGrid3::wOrigin() const {
 }
 
 void FaceCenteredGrid3::fill(const Vector3D& value) {
+    ScalarDataAccessor dataU = uAccessor();
     parallelFor(
-        kZeroSize, _dataU.width(),
-        kZeroSize, _dataU.height(),
-        kZeroSize, _dataU.depth(),
-        [this, value](size_t i, size_t j, size_t k) {
-            _dataU(i, j, k) = value.x;
+        kZeroSize, dataU.width(),
+        kZeroSize, dataU.height(),
+        kZeroSize, dataU.depth(),
+        [&dataU, value](size_t i, size_t j, size_t k) {
+            dataU(i, j, k) = value.x;
         });
 
+    ScalarDataAccessor dataV = vAccessor();
     parallelFor(
-        kZeroSize, _dataV.width(),
-        kZeroSize, _dataV.height(),
-        kZeroSize, _dataV.depth(),
-        [this, value](size_t i, size_t j, size_t k) {
-            _dataV(i, j, k) = value.y;
+        kZeroSize, dataV.width(),
+        kZeroSize, dataV.height(),
+        kZeroSize, dataV.depth(),
+        [&dataV, value](size_t i, size_t j, size_t k) {
+            dataV(i, j, k) = value.y;
         });
 
+    ScalarDataAccessor dataW = wAccessor();
     parallelFor(
-        kZeroSize, _dataW.width(),
-        kZeroSize, _dataW.height(),
-        kZeroSize, _dataW.depth(),
-        [this, value](size_t i, size_t j, size_t k) {
-            _dataW(i, j, k) = value.z;
+        kZeroSize, dataW.width(),
+        kZeroSize, dataW.height(),
+        kZeroSize, dataW.depth(),
+        [&dataW, value](size_t i, size_t j, size_t k) {
+            dataW(i, j, k) = value.z;
         });
 }
 
 void FaceCenteredGrid3::fill(
     const std::function<Vector3D(const Vector3D&)>& func) {
     DataPositionFunc uPos = uPosition();
+    ScalarDataAccessor dataU = uAccessor();
     parallelFor(
-        kZeroSize, _dataU.width(),
-        kZeroSize, _dataU.height(),
-        kZeroSize, _dataU.depth(),
-        [this, &func, &uPos](size_t i, size_t j, size_t k) {
-            _dataU(i, j, k) = func(uPos(i, j, k)).x;
+        kZeroSize, dataU.width(),
+        kZeroSize, dataU.height(),
+        kZeroSize, dataU.depth(),
+        [&dataU, &func, &uPos](size_t i, size_t j, size_t k) {
+            dataU(i, j, k) = func(uPos(i, j, k)).x;
         });
     DataPositionFunc vPos = vPosition();
+    ScalarDataAccessor dataV = vAccessor();
     parallelFor(
-        kZeroSize, _dataV.width(),
-        kZeroSize, _dataV.height(),
-        kZeroSize, _dataV.depth(),
-        [this, &func, &vPos](size_t i, size_t j, size_t k) {
-            _dataV(i, j, k) = func(vPos(i, j, k)).y;
+        kZeroSize, dataV.width(),
+        kZeroSize, dataV.height(),
+        kZeroSize, dataV.depth(),
+        [&dataV, &func, &vPos](size_t i, size_t j, size_t k) {
+            dataV(i, j, k) = func(vPos(i, j, k)).y;
         });
     DataPositionFunc wPos = wPosition();
+    ScalarDataAccessor dataW = wAccessor();
     parallelFor(
-        kZeroSize, _dataW.width(),
-        kZeroSize, _dataW.height(),
-        kZeroSize, _dataW.depth(),
-        [this, &func, &wPos](size_t i, size_t j, size_t k) {
-            _dataW(i, j, k) = func(wPos(i, j, k)).z;
+        kZeroSize, dataW.width(),
+        kZeroSize, dataW.height(),
+        kZeroSize, dataW.depth(),
+        [&dataW, &func, &wPos](size_t i, size_t j, size_t k) {
+            dataW(i, j, k) = func(wPos(i, j, k)).z;
         });
 }
 
@@ -358,32 +458,32 @@ std::shared_ptr<VectorGrid3> FaceCenteredGrid3::clone() const {
 
 void FaceCenteredGrid3::forEachUIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _dataU.forEachIndex(func);
+    _dataU.get().forEachIndex(func);
 }
 
 void FaceCenteredGrid3::parallelForEachUIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _dataU.parallelForEachIndex(func);
+    _dataU.get().parallelForEachIndex(func);
 }
 
 void FaceCenteredGrid3::forEachVIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _dataV.forEachIndex(func);
+    _dataV.get().forEachIndex(func);
 }
 
 void FaceCenteredGrid3::parallelForEachVIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _dataV.parallelForEachIndex(func);
+    _dataV.get().parallelForEachIndex(func);
 }
 
 void FaceCenteredGrid3::forEachWIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _dataW.forEachIndex(func);
+    _dataW.get().forEachIndex(func);
 }
 
 void FaceCenteredGrid3::parallelForEachWIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _dataW.parallelForEachIndex(func);
+    _dataW.get().parallelForEachIndex(func);
 }
 
 void FaceCenteredGrid3::serialize(std::ostream* strm) const {
@@ -397,9 +497,9 @@ void FaceCenteredGrid3::serialize(std::ostream* strm) const {
     strm->write(orgVAsBytes, 3 * sizeof(double));
     strm->write(orgWAsBytes, 3 * sizeof(double));
 
-    _dataU.serialize(strm);
-    _dataV.serialize(strm);
-    _dataW.serialize(strm);
+    _dataU.get().serialize(strm);
+    _dataV.get().serialize(strm);
+    _dataW.get().serialize(strm);
 }
 
 void FaceCenteredGrid3::deserialize(std::istream* strm) {
@@ -413,19 +513,56 @@ void FaceCenteredGrid3::deserialize(std::istream* strm) {
     strm->read(orgVAsBytes, 3 * sizeof(double));
     strm->read(orgWAsBytes, 3 * sizeof(double));
 
-    _dataU.deserialize(strm);
-    _dataV.deserialize(strm);
-    _dataW.deserialize(strm);
+    _dataU.mutate().deserialize(strm);
+    _dataV.mutate().deserialize(strm);
+    _dataW.mutate().deserialize(strm);
 
     resetSampler();
 }
 
 Vector3D FaceCenteredGrid3::sample(const Vector3D& x) const {
-    return _sampler(x);
+    return Vector3D(
+        _uLinearSampler(x),
+        _vLinearSampler(x),
+        _wLinearSampler(x));
 }
 
 std::function<Vector3D(const Vector3D&)> FaceCenteredGrid3::sampler() const {
-    return _sampler;
+    LinearArraySampler3<double, double> uSampler = _uLinearSampler;
+    LinearArraySampler3<double, double> vSampler = _vLinearSampler;
+    LinearArraySampler3<double, double> wSampler = _wLinearSampler;
+    return [uSampler, vSampler, wSampler](const Vector3D& x) -> Vector3D {
+        double u = uSampler(x);
+        double v = vSampler(x);
+        double w = wSampler(x);
+        return Vector3D(u, v, w);
+    };
+}
+
+const LinearArraySampler3<double, double>&
+FaceCenteredGrid3::uLinearSampler() const {
+    return _uLinearSampler;
+}
+
+const LinearArraySampler3<double, double>&
+FaceCenteredGrid3::vLinearSampler() const {
+    return _vLinearSampler;
+}
+
+const LinearArraySampler3<double, double>&
+FaceCenteredGrid3::wLinearSampler() const {
+    return _wLinearSampler;
+}
+
+void FaceCenteredGrid3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<Vector3D> result) const {
+    for (size_t i = 0; i < x.size(); ++i) {
+        result[i] = Vector3D(
+            _uLinearSampler(x[i]),
+            _vLinearSampler(x[i]),
+            _wLinearSampler(x[i]));
+    }
 }
 
 double FaceCenteredGrid3::divergence(const Vector3D& x) const {
@@ -520,13 +657,13 @@ void FaceCenteredGrid3::onResize(
     const Vector3D& origin,
     const Vector3D& initialValue) {
     if (resolution != Size3(0, 0, 0)) {
-        _dataU.resize(resolution + Size3(1, 0, 0), initialValue.x);
-        _dataV.resize(resolution + Size3(0, 1, 0), initialValue.y);
-        _dataW.resize(resolution + Size3(0, 0, 1), initialValue.z);
+        _dataU.mutate().resize(resolution + Size3(1, 0, 0), initialValue.x);
+        _dataV.mutate().resize(resolution + Size3(0, 1, 0), initialValue.y);
+        _dataW.mutate().resize(resolution + Size3(0, 0, 1), initialValue.z);
     } else {
-        _dataU.resize(Size3(0, 0, 0));
-        _dataV.resize(Size3(0, 0, 0));
-        _dataW.resize(Size3(0, 0, 0));
+        _dataU.mutate().resize(Size3(0, 0, 0));
+        _dataV.mutate().resize(Size3(0, 0, 0));
+        _dataW.mutate().resize(Size3(0, 0, 0));
     }
     _dataOriginU = origin + 0.5 * Vector3D(0.0, gridSpacing.y, gridSpacing.z);
     _dataOriginV = origin + 0.5 * Vector3D(gridSpacing.x, 0.0, gridSpacing.z);
@@ -535,24 +672,18 @@ void FaceCenteredGrid3::onResize(
     resetSampler();
 }
 
+Array3<double>& FaceCenteredGrid3::mutableData(
+    CopyOnWriteArray3<double>* data) {
+    return data->mutate([this] { resetSampler(); });
+}
+
 void FaceCenteredGrid3::resetSampler() {
-    LinearArraySampler3<double, double> uSampler(
+    _uLinearSampler = LinearArraySampler3<double, double>(
         _dataU.constAccessor(), gridSpacing(), _dataOriginU);
-    LinearArraySampler3<double, double> vSampler(
+    _vLinearSampler = LinearArraySampler3<double, double>(
         _dataV.constAccessor(), gridSpacing(), _dataOriginV);
-    LinearArraySampler3<double, double> wSampler(
+    _wLinearSampler = LinearArraySampler3<double, double>(
         _dataW.constAccessor(), gridSpacing(), _dataOriginW);
-
-    _uLinearSampler = uSampler;
-    _vLinearSampler = vSampler;
-    _wLinearSampler = wSampler;
-
-    _sampler = [uSampler, vSampler, wSampler](const Vector3D& x) -> Vector3D {
-        double u = uSampler(x);
-        double v = vSampler(x);
-        double w = wSampler(x);
-        return Vector3D(u, v, w);
-    };
 }
 
 VectorGridBuilder3Ptr FaceCenteredGrid3::builder() {
@@ -0,0 +1,405 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/fast_sweeping_level_set_solver3.h>
+#include <jet/fdm_utils.h>
+#include <jet/level_set_utils.h>
+#include <jet/parallel.h>
+#include <parallel_sweep_helpers.h>
+
+#include <algorithm>
+#include <utility>  // just make cpplint happy..
+#include <vector>
+
+using namespace jet;
+
+static const char kUnknown = 0;
+static const char kKnown = 1;
+static const char kTrial = 2;
+
+namespace {
+
+// Runs the Gauss-Seidel sweeps in the 8 orderings and returns true if any of
+// the callbacks returned true
+template <typename Callback>
+bool sweep(const Size3& size, const Callback& func) {
+    std::vector<char> changed(size.z, 0);
+
+    for (int ordering = 0; ordering < 8; ++ordering) {
+        parallelSweep(
+            size,
+            (ordering & 1) != 0,
+            (ordering & 2) != 0,
+            (ordering & 4) != 0,
+            [&](size_t i, size_t j, size_t k) {
+                if (func(i, j, k)) {
+                    changed[k] = 1;
+                }
+            });
+    }
+
+    return std::find(changed.begin(), changed.end(), 1) != changed.end();
+}
+
+// Solves the first-order upwind discretization of |grad(phi)| = 1 where the
+// smaller neighbor along each axis is given by phi with spacing h
+double solveEikonal(Vector3D phi, Vector3D h) {
+    // Sort by the neighbor values
+    for (size_t a = 0; a < 2; ++a) {
+        for (size_t b = 0; b + 1 < 3 - a; ++b) {
+            if (phi[b] > phi[b + 1]) {
+                std::swap(phi[b], phi[b + 1]);
+                std::swap(h[b], h[b + 1]);
+            }
+        }
+    }
+
+    double solution = phi[0] + h[0];
+
+    double a = 0.0;
+    double b = 0.0;
+    double c = -1.0;
+    for (size_t d = 0; d < 3; ++d) {
+        if (d > 0 && solution <= phi[d]) {
+            break;
+        }
+
+        double invHSqr = 1.0 / square(h[d]);
+        a += invHSqr;
+        b -= phi[d] * invHSqr;
+        c += square(phi[d]) * invHSqr;
+
+        if (d > 0) {
+            double det = std::max(b * b - a * c, 0.0);
+            solution = (-b + std::sqrt(det)) / a;
+        }
+    }
+
+    return solution;
+}
+
+}  // namespace
+
+FastSweepingLevelSetSolver3::FastSweepingLevelSetSolver3() {
+}
+
+void FastSweepingLevelSetSolver3::reinitialize(
+    const ScalarGrid3& inputSdf,
+    double maxDistance,
+    ScalarGrid3* outputSdf) {
+    JET_THROW_INVALID_ARG_IF(!inputSdf.hasSameShape(*outputSdf));
+
+    Size3 size = inputSdf.dataSize();
+    Vector3D gridSpacing = inputSdf.gridSpacing();
+
+    if (_sdf.size() != size) {
+        _sdf.resize(size);
+    }
+
+    // Keep the input since the output can be the same grid
+    auto input = _sdf.accessor();
+    auto inputAcc = inputSdf.constDataAccessor();
+    _sdf.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        input(i, j, k) = inputAcc(i, j, k);
+    });
+
+    auto output = outputSdf->dataAccessor();
+
+    // Solve geometrically near the boundary, and work on the unsigned distance
+    // for the rest since the cells next to the other side have their values
+    // already. The sweeps below can still lower the geometric estimates.
+    _sdf.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        double phi = input(i, j, k);
+        bool isInside = isInsideSdf(phi);
+        Vector3D dist(kMaxD, kMaxD, kMaxD);
+
+        auto visit = [&](size_t axis, size_t ni, size_t nj, size_t nk) {
+            double phiN = input(ni, nj, nk);
+            if (isInsideSdf(phiN) != isInside) {
+                dist[axis] = std::min(
+                    dist[axis],
+                    gridSpacing[axis] * std::abs(phi)
+                        / (std::abs(phi) + std::abs(phiN)));
+            }
+        };
+
+        if (i > 0) {
+            visit(0, i - 1, j, k);
+        }
+        if (i + 1 < size.x) {
+            visit(0, i + 1, j, k);
+        }
+        if (j > 0) {
+            visit(1, i, j - 1, k);
+        }
+        if (j + 1 < size.y) {
+            visit(1, i, j + 1, k);
+        }
+        if (k > 0) {
+            visit(2, i, j, k - 1);
+        }
+        if (k + 1 < size.z) {
+            visit(2, i, j, k + 1);
+        }
+
+        double denomSqr = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            if (dist[axis] < kMaxD) {
+                denomSqr += 1.0 / square(dist[axis]);
+            }
+        }
+
+        if (denomSqr > 0.0) {
+            output(i, j, k) = 1.0 / std::sqrt(denomSqr);
+        } else {
+            output(i, j, k) = kMaxD;
+        }
+    });
+
+    auto update = [&](size_t i, size_t j, size_t k) {
+        Vector3D phi(kMaxD, kMaxD, kMaxD);
+        if (i > 0) {
+            phi.x = std::min(phi.x, output(i - 1, j, k));
+        }
+        if (i + 1 < size.x) {
+            phi.x = std::min(phi.x, output(i + 1, j, k));
+        }
+        if (j > 0) {
+            phi.y = std::min(phi.y, output(i, j - 1, k));
+        }
+        if (j + 1 < size.y) {
+            phi.y = std::min(phi.y, output(i, j + 1, k));
+        }
+        if (k > 0) {
+            phi.z = std::min(phi.z, output(i, j, k - 1));
+        }
+        if (k + 1 < size.z) {
+            phi.z = std::min(phi.z, output(i, j, k + 1));
+        }
+
+        // Stop propagating beyond the max distance
+        if (phi.min() > maxDistance) {
+            return false;
+        }
+
+        double solution = solveEikonal(phi, gridSpacing);
+        if (solution < output(i, j, k) - kEpsilonD) {
+            output(i, j, k) = solution;
+            return true;
+        }
+
+        return false;
+    };
+
+    for (unsigned int n = 0; n < _maxNumberOfRounds; ++n) {
+        if (!sweep(size, update)) {
+            break;
+        }
+    }
+
+    // Restore the sign, and keep the input for the unreached cells
+    _sdf.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        double phi = input(i, j, k);
+        if (output(i, j, k) == kMaxD) {
+            output(i, j, k) = phi;
+        } else if (isInsideSdf(phi)) {
+            output(i, j, k) = -output(i, j, k);
+        }
+
+        if (isUsingNarrowBand()) {
+            output(i, j, k) = clamp(output(i, j, k), -maxDistance, maxDistance);
+        }
+    });
+}
+
+void FastSweepingLevelSetSolver3::extrapolate(
+    const ScalarGrid3& input,
+    const ScalarField3& sdf,
+    double maxDistance,
+    ScalarGrid3* output) {
+    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
+
+    Array3<double> sdfGrid(input.dataSize());
+    auto pos = input.dataPosition();
+    sdfGrid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        sdfGrid(i, j, k) = sdf.sample(pos(i, j, k));
+    });
+
+    extrapolate(
+        input.constDataAccessor(),
+        sdfGrid.constAccessor(),
+        input.gridSpacing(),
+        maxDistance,
+        output->dataAccessor());
+}
+
+void FastSweepingLevelSetSolver3::extrapolate(
+    const CollocatedVectorGrid3& input,
+    const ScalarField3& sdf,
+    double maxDistance,
+    CollocatedVectorGrid3* output) {
+    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
+
+    Array3<double> sdfGrid(input.dataSize());
+    auto pos = input.dataPosition();
+    sdfGrid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        sdfGrid(i, j, k) = sdf.sample(pos(i, j, k));
+    });
+
+    const Vector3D gridSpacing = input.gridSpacing();
+
+    Array3<double> u(input.dataSize());
+    Array3<double> u0(input.dataSize());
+    Array3<double> v(input.dataSize());
+    Array3<double> v0(input.dataSize());
+    Array3<double> w(input.dataSize());
+    Array3<double> w0(input.dataSize());
+
+    input.parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        u(i, j, k) = input(i, j, k).x;
+        v(i, j, k) = input(i, j, k).y;
+        w(i, j, k) = input(i, j, k).z;
+    });
+
+    extrapolate(u, sdfGrid.constAccessor(), gridSpacing, maxDistance, u0);
+    extrapolate(v, sdfGrid.constAccessor(), gridSpacing, maxDistance, v0);
+    extrapolate(w, sdfGrid.constAccessor(), gridSpacing, maxDistance, w0);
+
+    output->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        (*output)(i, j, k).x = u0(i, j, k);
+        (*output)(i, j, k).y = v0(i, j, k);
+        (*output)(i, j, k).z = w0(i, j, k);
+    });
+}
+
+void FastSweepingLevelSetSolver3::extrapolate(
+    const FaceCenteredGrid3& input,
+    const ScalarField3& sdf,
+    double maxDistance,
+    FaceCenteredGrid3* output) {
+    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
+
+    const Vector3D gridSpacing = input.gridSpacing();
+
+    auto u = input.uConstAccessor();
+    auto uPos = input.uPosition();
+    Array3<double> sdfAtU(u.size());
+    input.parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
+        sdfAtU(i, j, k) = sdf.sample(uPos(i, j, k));
+    });
+
+    extrapolate(u, sdfAtU, gridSpacing, maxDistance, output->uAccessor());
+
+    auto v = input.vConstAccessor();
+    auto vPos = input.vPosition();
+    Array3<double> sdfAtV(v.size());
+    input.parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
+        sdfAtV(i, j, k) = sdf.sample(vPos(i, j, k));
+    });
+
+    extrapolate(v, sdfAtV, gridSpacing, maxDistance, output->vAccessor());
+
+    auto w = input.wConstAccessor();
+    auto wPos = input.wPosition();
+    Array3<double> sdfAtW(w.size());
+    input.parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
+        sdfAtW(i, j, k) = sdf.sample(wPos(i, j, k));
+    });
+
+    extrapolate(w, sdfAtW, gridSpacing, maxDistance, output->wAccessor());
+}
+
+unsigned int FastSweepingLevelSetSolver3::maxNumberOfRounds() const {
+    return _maxNumberOfRounds;
+}
+
+void FastSweepingLevelSetSolver3::setMaxNumberOfRounds(unsigned int rounds) {
+    _maxNumberOfRounds = std::max(rounds, 1u);
+}
+
+void FastSweepingLevelSetSolver3::extrapolate(
+    const ConstArrayAccessor3<double>& input,
+    const ConstArrayAccessor3<double>& sdf,
+    const Vector3D& gridSpacing,
+    double maxDistance,
+    ArrayAccessor3<double> output) {
+    Size3 size = input.size();
+    Vector3D invGridSpacing = 1.0 / gridSpacing;
+
+    if (_markers.size() != size) {
+        _markers.resize(size);
+    }
+
+    // Build markers
+    _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (isInsideSdf(sdf(i, j, k))) {
+            _markers(i, j, k) = kKnown;
+        } else {
+            _markers(i, j, k) = kUnknown;
+        }
+        output(i, j, k) = input(i, j, k);
+    });
+
+    // Averages the values from the upwind neighbors, weighted by the normal
+    auto update = [&](size_t i, size_t j, size_t k) {
+        double phi = sdf(i, j, k);
+        if (_markers(i, j, k) == kKnown || phi > maxDistance) {
+            return false;
+        }
+
+        Vector3D grad = gradient3(sdf, gridSpacing, i, j, k).normalized();
+
+        double sum = 0.0;
+        double count = 0.0;
+
+        auto visit = [&](size_t ni, size_t nj, size_t nk, double weight) {
+            if (_markers(ni, nj, nk) != kUnknown && sdf(ni, nj, nk) < phi) {
+                // If gradient is zero, then just assign 1 to weight
+                if (weight < kEpsilonD) {
+                    weight = 1.0;
+                }
+
+                sum += weight * output(ni, nj, nk);
+                count += weight;
+            }
+        };
+
+        if (i > 0) {
+            visit(i - 1, j, k, std::abs(grad.x) * invGridSpacing.x);
+        }
+        if (i + 1 < size.x) {
+            visit(i + 1, j, k, std::abs(grad.x) * invGridSpacing.x);
+        }
+        if (j > 0) {
+            visit(i, j - 1, k, std::abs(grad.y) * invGridSpacing.y);
+        }
+        if (j + 1 < size.y) {
+            visit(i, j + 1, k, std::abs(grad.y) * invGridSpacing.y);
+        }
+        if (k > 0) {
+            visit(i, j, k - 1, std::abs(grad.z) * invGridSpacing.z);
+        }
+        if (k + 1 < size.z) {
+            visit(i, j, k + 1, std::abs(grad.z) * invGridSpacing.z);
+        }
+
+        if (count == 0.0) {
+            return false;
+        }
+
+        double value = sum / count;
+        bool isChanged = _markers(i, j, k) == kUnknown
+            || std::abs(value - output(i, j, k)) > kEpsilonD;
+
+        output(i, j, k) = value;
+        _markers(i, j, k) = kTrial;
+
+        return isChanged;
+    };
+
+    for (unsigned int n = 0; n < _maxNumberOfRounds; ++n) {
+        if (!sweep(size, update)) {
+            break;
+        }
+    }
+}
@@ -2,6 +2,9 @@
 
 #include <pch.h>
 #include <jet/fcc_lattice_point_generator.h>
+#include <point_generator_helpers.h>
+
+#include <algorithm>
 
 namespace jet {
 
@@ -39,4 +42,69 @@ void FccLatticePointGenerator::forEachPoint(
     }
 }
 
+size_t FccLatticePointGenerator::numberOfSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing) const {
+    return numberOfLatticeSteps(spacing / 2.0, 0.0, boundingBox.depth());
+}
+
+size_t FccLatticePointGenerator::countPointsInSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd) const {
+    double halfSpacing = spacing / 2.0;
+    sliceEnd = std::min(sliceEnd, numberOfSlices(boundingBox, spacing));
+
+    size_t numberOfRows
+        = numberOfLatticeSteps(halfSpacing, 0.0, boundingBox.height());
+    size_t numberOfColumns[2] = {
+        numberOfLatticeSteps(spacing, 0.0, boundingBox.width()),
+        numberOfLatticeSteps(spacing, halfSpacing, boundingBox.width())
+    };
+
+    size_t count = 0;
+    for (size_t k = sliceBegin; k < sliceEnd; ++k) {
+        // The rows alternate between the columns without and with the
+        // offset, starting with the offset on the odd layers
+        size_t first = k % 2;
+        count += (numberOfRows + 1) / 2 * numberOfColumns[first]
+            + numberOfRows / 2 * numberOfColumns[1 - first];
+    }
+    return count;
+}
+
+void FccLatticePointGenerator::generateRange(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd,
+    ArrayAccessor1<Vector3D> points) const {
+    double halfSpacing = spacing / 2.0;
+    sliceEnd = std::min(sliceEnd, numberOfSlices(boundingBox, spacing));
+
+    size_t numberOfRows
+        = numberOfLatticeSteps(halfSpacing, 0.0, boundingBox.height());
+
+    Vector3D position;
+    size_t n = 0;
+    for (size_t k = sliceBegin; k < sliceEnd; ++k) {
+        position.z = k * halfSpacing + boundingBox.lowerCorner.z;
+
+        for (size_t j = 0; j < numberOfRows; ++j) {
+            position.y = j * halfSpacing + boundingBox.lowerCorner.y;
+
+            double offset = ((k + j) % 2 == 1) ? halfSpacing : 0.0;
+            size_t numberOfColumns
+                = numberOfLatticeSteps(spacing, offset, boundingBox.width());
+
+            for (size_t i = 0; i < numberOfColumns; ++i) {
+                position.x = i * spacing + offset + boundingBox.lowerCorner.x;
+                points[n++] = position;
+            }
+        }
+    }
+    JET_ASSERT(n == points.size());
+}
+
 }  // namespace jet
@@ -4,6 +4,7 @@
 #include <jet/constants.h>
 #include <jet/cg.h>
 #include <jet/fdm_cg_solver2.h>
+#include <fdm_mixed_precision_helpers.h>
 
 using namespace jet;
 
@@ -24,6 +25,55 @@ bool FdmCgSolver2::solve(FdmLinearSystem2* system) {
     JET_ASSERT(matrix.size() == solution.size());
 
     Size2 size = matrix.size();
+
+    if (_isUsingMixedPrecision) {
+        system->x.set(0.0);
+
+        auto innerSolve = [&](
+            const FdmMatrix2F& a,
+            const FdmVector2F& b,
+            double tolerance,
+            unsigned int maxNumberOfIterations,
+            FdmVector2F* x) {
+            _rF.resize(size);
+            _dF.resize(size);
+            _qF.resize(size);
+            _sF.resize(size);
+
+            unsigned int numberOfIterations = 0;
+            double residualNorm = 0.0;
+            cg<FdmBlas2F>(
+                a,
+                b,
+                maxNumberOfIterations,
+                tolerance,
+                x,
+                &_rF,
+                &_dF,
+                &_qF,
+                &_sF,
+                &numberOfIterations,
+                &residualNorm);
+            return numberOfIterations;
+        };
+
+        solveWithMixedPrecision<FdmBlas2, FdmBlas2F>(
+            matrix,
+            rhs,
+            _maxNumberOfIterations,
+            _tolerance,
+            innerSolve,
+            &solution,
+            &_r,
+            &_matrixF,
+            &_bF,
+            &_xF,
+            &_lastNumberOfIterations,
+            &_lastResidual);
+
+        return _lastResidual <= _tolerance;
+    }
+
     _r.resize(size);
     _d.resize(size);
     _q.resize(size);
@@ -52,6 +102,47 @@ bool FdmCgSolver2::solve(FdmLinearSystem2* system) {
         || _lastNumberOfIterations < _maxNumberOfIterations;
 }
 
+bool FdmCgSolver2::solveCompressed(FdmCompressedLinearSystem* system) {
+    FdmCompressedMatrix& matrix = system->A;
+    FdmCompressedVector& solution = system->x;
+    FdmCompressedVector& rhs = system->b;
+
+    JET_ASSERT(matrix.rows() == rhs.size());
+    JET_ASSERT(matrix.rows() == solution.size());
+
+    size_t size = matrix.rows();
+    _rComp.resize(size);
+    _dComp.resize(size);
+    _qComp.resize(size);
+    _sComp.resize(size);
+
+    solution.set(0.0);
+    _rComp.set(0.0);
+    _dComp.set(0.0);
+    _qComp.set(0.0);
+    _sComp.set(0.0);
+
+    cg<FdmCompressedBlas>(
+        matrix,
+        rhs,
+        _maxNumberOfIterations,
+        _tolerance,
+        &solution,
+        &_rComp,
+        &_dComp,
+        &_qComp,
+        &_sComp,
+        &_lastNumberOfIterations,
+        &_lastResidual);
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmCgSolver2::isCompressedSystemSupported() const {
+    return true;
+}
+
 unsigned int FdmCgSolver2::maxNumberOfIterations() const {
     return _maxNumberOfIterations;
 }
@@ -67,3 +158,11 @@ double FdmCgSolver2::tolerance() const {
 double FdmCgSolver2::lastResidual() const {
     return _lastResidual;
 }
+
+bool FdmCgSolver2::isUsingMixedPrecision() const {
+    return _isUsingMixedPrecision;
+}
+
+void FdmCgSolver2::setIsUsingMixedPrecision(bool isUsing) {
+    _isUsingMixedPrecision = isUsing;
+}
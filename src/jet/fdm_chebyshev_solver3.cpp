@@ -0,0 +1,141 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/fdm_chebyshev_solver3.h>
+
+#include <algorithm>
+
+using namespace jet;
+
+namespace {
+
+inline double inverseDiagonal(const FdmMatrixRow3& row) {
+    return (std::fabs(row.center) > 0.0) ? 1.0 / row.center : 0.0;
+}
+
+}  // namespace
+
+FdmChebyshevSolver3::FdmChebyshevSolver3(
+    unsigned int maxNumberOfIterations,
+    unsigned int residualCheckInterval,
+    double tolerance) :
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _residualCheckInterval(residualCheckInterval),
+    _tolerance(tolerance),
+    _lastResidual(kMaxD) {
+}
+
+bool FdmChebyshevSolver3::solve(FdmLinearSystem3* system) {
+    estimateEigenvalueBounds(system->A);
+    return iterate(system);
+}
+
+bool FdmChebyshevSolver3::solveWithSameMatrix(FdmLinearSystem3* system) {
+    return iterate(system);
+}
+
+unsigned int FdmChebyshevSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmChebyshevSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmChebyshevSolver3::tolerance() const {
+    return _tolerance;
+}
+
+double FdmChebyshevSolver3::lastResidual() const {
+    return _lastResidual;
+}
+
+void FdmChebyshevSolver3::estimateEigenvalueBounds(const FdmMatrix3& A) {
+    Size3 size = A.size();
+
+    // Every Gershgorin disc of the Jacobi preconditioned matrix is centered
+    // at 1, so only the largest radius is needed
+    Array3<double> radii(size);
+    A.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        double sum
+            = ((i > 0) ? std::fabs(A(i - 1, j, k).right) : 0.0)
+            + ((i + 1 < size.x) ? std::fabs(A(i, j, k).right) : 0.0)
+            + ((j > 0) ? std::fabs(A(i, j - 1, k).up) : 0.0)
+            + ((j + 1 < size.y) ? std::fabs(A(i, j, k).up) : 0.0)
+            + ((k > 0) ? std::fabs(A(i, j, k - 1).front) : 0.0)
+            + ((k + 1 < size.z) ? std::fabs(A(i, j, k).front) : 0.0);
+        radii(i, j, k) = sum * std::fabs(inverseDiagonal(A(i, j, k)));
+    });
+
+    double maxRadius = 0.0;
+    radii.forEach([&](double radius) {
+        maxRadius = std::max(maxRadius, radius);
+    });
+
+    // Keep the lower bound positive for systems that are only weakly
+    // diagonally dominant, which then converge slowly
+    _minEigenvalue = std::max(1.0 - maxRadius, kEpsilonD);
+    _maxEigenvalue = 1.0 + maxRadius;
+}
+
+bool FdmChebyshevSolver3::iterate(FdmLinearSystem3* system) {
+    FdmMatrix3& A = system->A;
+    FdmVector3& x = system->x;
+    FdmVector3& b = system->b;
+    Size3 size = x.size();
+
+    _residual.resize(size);
+    _direction.resize(size);
+    _temp.resize(size);
+
+    double theta = 0.5 * (_maxEigenvalue + _minEigenvalue);
+    double delta = 0.5 * (_maxEigenvalue - _minEigenvalue);
+    bool isSingleEigenvalue = (delta <= kEpsilonD * theta);
+    double sigma = isSingleEigenvalue ? 0.0 : theta / delta;
+    double rho = isSingleEigenvalue ? 0.0 : 1.0 / sigma;
+
+    FdmBlas3::residual(A, x, b, &_residual);
+    _direction.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        _direction(i, j, k)
+            = inverseDiagonal(A(i, j, k)) * _residual(i, j, k) / theta;
+    });
+
+    _lastNumberOfIterations = _maxNumberOfIterations;
+
+    for (unsigned int iter = 0; iter < _maxNumberOfIterations; ++iter) {
+        FdmBlas3::mvm(A, _direction, &_temp);
+        x.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            x(i, j, k) += _direction(i, j, k);
+            _residual(i, j, k) -= _temp(i, j, k);
+        });
+
+        if (iter != 0 && iter % _residualCheckInterval == 0) {
+            if (FdmBlas3::l2Norm(_residual) < _tolerance) {
+                _lastNumberOfIterations = iter + 1;
+                break;
+            }
+        }
+
+        // With a single eigenvalue, the iteration falls back to the
+        // Richardson iteration which is exact for such a matrix
+        double beta = 0.0;
+        double alpha = 1.0 / theta;
+        if (!isSingleEigenvalue) {
+            double rhoNew = 1.0 / (2.0 * sigma - rho);
+            beta = rhoNew * rho;
+            alpha = 2.0 * rhoNew / delta;
+            rho = rhoNew;
+        }
+        _direction.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            _direction(i, j, k) = beta * _direction(i, j, k)
+                + alpha * inverseDiagonal(A(i, j, k)) * _residual(i, j, k);
+        });
+    }
+
+    FdmBlas3::residual(A, x, b, &_residual);
+    _lastResidual = FdmBlas3::l2Norm(_residual);
+
+    return _lastResidual < _tolerance;
+}
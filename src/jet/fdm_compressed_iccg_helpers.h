@@ -0,0 +1,77 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_FDM_COMPRESSED_ICCG_HELPERS_H_
+#define SRC_JET_FDM_COMPRESSED_ICCG_HELPERS_H_
+
+#include <jet/fdm_compressed_linear_system.h>
+
+#include <cmath>
+
+namespace jet {
+
+// Computes the inverted diagonal of the incomplete Cholesky factorization
+// M = (E + L) E^-1 (E + L^T) of the compressed matrix, where L is its strict
+// lower triangle. Same as the sequential incomplete Cholesky of the grid
+// systems, with the rows in the order they are stored.
+inline void buildCompressedIncompleteCholesky(
+    const FdmCompressedMatrix& A,
+    FdmCompressedVector* d_) {
+    FdmCompressedVector& d = *d_;
+    d.resize(A.rows());
+
+    for (size_t i = 0; i < A.rows(); ++i) {
+        double denom = 0.0;
+        for (size_t n = A.rowPointers[i]; n < A.rowPointers[i + 1]; ++n) {
+            size_t j = A.columnIndices[n];
+            if (j < i) {
+                denom -= A.nonZeros[n] * A.nonZeros[n] * d[j];
+            } else if (j == i) {
+                denom += A.nonZeros[n];
+            }
+        }
+
+        d[i] = (std::fabs(denom) > 0.0) ? 1.0 / denom : 0.0;
+    }
+}
+
+// Solves Mx = b with the factorization from
+// buildCompressedIncompleteCholesky, using y as the temporary vector.
+inline void solveCompressedIncompleteCholesky(
+    const FdmCompressedMatrix& A,
+    const FdmCompressedVector& d,
+    const FdmCompressedVector& b,
+    FdmCompressedVector* y_,
+    FdmCompressedVector* x_) {
+    FdmCompressedVector& y = *y_;
+    FdmCompressedVector& x = *x_;
+    size_t rows = A.rows();
+    y.resize(rows);
+
+    for (size_t i = 0; i < rows; ++i) {
+        double sum = 0.0;
+        for (size_t n = A.rowPointers[i]; n < A.rowPointers[i + 1]; ++n) {
+            size_t j = A.columnIndices[n];
+            if (j < i) {
+                sum += A.nonZeros[n] * y[j];
+            }
+        }
+
+        y[i] = (b[i] - sum) * d[i];
+    }
+
+    for (size_t i = rows; i-- > 0;) {
+        double sum = 0.0;
+        for (size_t n = A.rowPointers[i]; n < A.rowPointers[i + 1]; ++n) {
+            size_t j = A.columnIndices[n];
+            if (j > i) {
+                sum += A.nonZeros[n] * x[j];
+            }
+        }
+
+        x[i] = y[i] - sum * d[i];
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_FDM_COMPRESSED_ICCG_HELPERS_H_
@@ -0,0 +1,130 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/fdm_compressed_linear_system.h>
+#include <jet/math_utils.h>
+#include <jet/parallel.h>
+
+#include <cmath>
+#include <functional>
+
+using namespace jet;
+
+size_t FdmCompressedMatrix::rows() const {
+    return rowPointers.size() - 1;
+}
+
+void FdmCompressedMatrix::clear() {
+    nonZeros.clear();
+    columnIndices.clear();
+    rowPointers.assign(1, 0);
+}
+
+void FdmCompressedMatrix::addElement(size_t column, double value) {
+    nonZeros.push_back(value);
+    columnIndices.push_back(column);
+}
+
+void FdmCompressedMatrix::finishRow() {
+    rowPointers.push_back(nonZeros.size());
+}
+
+void FdmCompressedBlas::set(double s, VectorType* result) {
+    result->set(s);
+}
+
+void FdmCompressedBlas::set(const VectorType& v, VectorType* result) {
+    result->set(v);
+}
+
+double FdmCompressedBlas::dot(const VectorType& a, const VectorType& b) {
+    JET_THROW_INVALID_ARG_IF(a.size() != b.size());
+
+    return parallelReduce(
+        kZeroSize,
+        a.size(),
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial += a[i] * b[i];
+            }
+            return partial;
+        },
+        std::plus<double>());
+}
+
+void FdmCompressedBlas::axpy(
+    double a,
+    const VectorType& x,
+    const VectorType& y,
+    VectorType* result) {
+    JET_THROW_INVALID_ARG_IF(x.size() != y.size());
+    JET_THROW_INVALID_ARG_IF(x.size() != result->size());
+
+    x.parallelForEachIndex([&](size_t i) {
+        (*result)[i] = a * x[i] + y[i];
+    });
+}
+
+void FdmCompressedBlas::mvm(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    JET_THROW_INVALID_ARG_IF(m.rows() != v.size());
+    JET_THROW_INVALID_ARG_IF(m.rows() != result->size());
+
+    const double* nonZeros = m.nonZeros.data();
+    const size_t* columnIndices = m.columnIndices.data();
+    const size_t* rowPointers = m.rowPointers.data();
+
+    result->parallelForEachIndex([&](size_t i) {
+        double sum = 0.0;
+        for (size_t n = rowPointers[i]; n < rowPointers[i + 1]; ++n) {
+            sum += nonZeros[n] * v[columnIndices[n]];
+        }
+        (*result)[i] = sum;
+    });
+}
+
+void FdmCompressedBlas::residual(
+    const MatrixType& a,
+    const VectorType& x,
+    const VectorType& b,
+    VectorType* result) {
+    JET_THROW_INVALID_ARG_IF(a.rows() != x.size());
+    JET_THROW_INVALID_ARG_IF(a.rows() != b.size());
+    JET_THROW_INVALID_ARG_IF(a.rows() != result->size());
+
+    const double* nonZeros = a.nonZeros.data();
+    const size_t* columnIndices = a.columnIndices.data();
+    const size_t* rowPointers = a.rowPointers.data();
+
+    result->parallelForEachIndex([&](size_t i) {
+        double sum = b[i];
+        for (size_t n = rowPointers[i]; n < rowPointers[i + 1]; ++n) {
+            sum -= nonZeros[n] * x[columnIndices[n]];
+        }
+        (*result)[i] = sum;
+    });
+}
+
+double FdmCompressedBlas::l2Norm(const VectorType& v) {
+    return std::sqrt(dot(v, v));
+}
+
+double FdmCompressedBlas::lInfNorm(const VectorType& v) {
+    double result = parallelReduce(
+        kZeroSize,
+        v.size(),
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial = absmax(partial, v[i]);
+            }
+            return partial;
+        },
+        absmax<double>);
+
+    return std::fabs(result);
+}
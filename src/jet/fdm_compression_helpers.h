@@ -0,0 +1,229 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_FDM_COMPRESSION_HELPERS_H_
+#define SRC_JET_FDM_COMPRESSION_HELPERS_H_
+
+#include <jet/constants.h>
+#include <jet/fdm_compressed_linear_system.h>
+#include <jet/fdm_linear_system2.h>
+#include <jet/fdm_linear_system3.h>
+
+namespace jet {
+
+// Assigns consecutive row indices to the cells where isActive(i, j) is true
+// in the order of the linear grid index, and kMaxSize to the other cells.
+// Returns the number of the active cells.
+template <typename IsActive>
+size_t buildCompressedIndices(
+    const Size2& size,
+    const IsActive& isActive,
+    Array2<size_t>* indices) {
+    indices->resize(size);
+
+    size_t numberOfRows = 0;
+    indices->forEachIndex([&](size_t i, size_t j) {
+        (*indices)(i, j) = isActive(i, j) ? numberOfRows++ : kMaxSize;
+    });
+
+    return numberOfRows;
+}
+
+template <typename IsActive>
+size_t buildCompressedIndices(
+    const Size3& size,
+    const IsActive& isActive,
+    Array3<size_t>* indices) {
+    indices->resize(size);
+
+    size_t numberOfRows = 0;
+    indices->forEachIndex([&](size_t i, size_t j, size_t k) {
+        (*indices)(i, j, k) = isActive(i, j, k) ? numberOfRows++ : kMaxSize;
+    });
+
+    return numberOfRows;
+}
+
+// Builds the compressed matrix over the active cells, and resizes the
+// vectors of the system to the number of the rows. buildStencil(i, j)
+// returns the full 5-point stencil (center, left, right, down and up) of an
+// active cell, and only the couplings to the active neighbors are kept.
+// Since the nodes are numbered in the grid order, the columns of a row are
+// ascending when the neighbors are visited from down to up.
+template <typename BuildStencil>
+void buildCompressedMatrix(
+    const Array2<size_t>& indices,
+    size_t numberOfRows,
+    const BuildStencil& buildStencil,
+    FdmCompressedLinearSystem* system) {
+    Size2 size = indices.size();
+    FdmCompressedMatrix& A = system->A;
+    A.clear();
+    system->x.resize(numberOfRows);
+    system->b.resize(numberOfRows);
+
+    auto addNeighbor = [&](size_t index, double value) {
+        if (index != kMaxSize) {
+            A.addElement(index, value);
+        }
+    };
+
+    indices.forEachIndex([&](size_t i, size_t j) {
+        size_t row = indices(i, j);
+        if (row == kMaxSize) {
+            return;
+        }
+
+        auto stencil = buildStencil(i, j);
+
+        if (j > 0) {
+            addNeighbor(indices(i, j - 1), stencil.down);
+        }
+        if (i > 0) {
+            addNeighbor(indices(i - 1, j), stencil.left);
+        }
+        A.addElement(row, stencil.center);
+        if (i + 1 < size.x) {
+            addNeighbor(indices(i + 1, j), stencil.right);
+        }
+        if (j + 1 < size.y) {
+            addNeighbor(indices(i, j + 1), stencil.up);
+        }
+        A.finishRow();
+    });
+}
+
+// Builds the compressed system over the active cells, whose matrix is built
+// as buildCompressedMatrix() and right-hand side is gathered from b.
+template <typename BuildStencil>
+void buildCompressedSystem(
+    const Array2<size_t>& indices,
+    size_t numberOfRows,
+    const BuildStencil& buildStencil,
+    const FdmVector2& b,
+    FdmCompressedLinearSystem* system) {
+    buildCompressedMatrix(indices, numberOfRows, buildStencil, system);
+
+    indices.forEachIndex([&](size_t i, size_t j) {
+        if (indices(i, j) != kMaxSize) {
+            system->b[indices(i, j)] = b(i, j);
+        }
+    });
+}
+
+// Same as above for the full 7-point stencil (center, left, right, down,
+// up, back and front).
+template <typename BuildStencil>
+void buildCompressedMatrix(
+    const Array3<size_t>& indices,
+    size_t numberOfRows,
+    const BuildStencil& buildStencil,
+    FdmCompressedLinearSystem* system) {
+    Size3 size = indices.size();
+    FdmCompressedMatrix& A = system->A;
+    A.clear();
+    system->x.resize(numberOfRows);
+    system->b.resize(numberOfRows);
+
+    auto addNeighbor = [&](size_t index, double value) {
+        if (index != kMaxSize) {
+            A.addElement(index, value);
+        }
+    };
+
+    indices.forEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t row = indices(i, j, k);
+        if (row == kMaxSize) {
+            return;
+        }
+
+        auto stencil = buildStencil(i, j, k);
+
+        if (k > 0) {
+            addNeighbor(indices(i, j, k - 1), stencil.back);
+        }
+        if (j > 0) {
+            addNeighbor(indices(i, j - 1, k), stencil.down);
+        }
+        if (i > 0) {
+            addNeighbor(indices(i - 1, j, k), stencil.left);
+        }
+        A.addElement(row, stencil.center);
+        if (i + 1 < size.x) {
+            addNeighbor(indices(i + 1, j, k), stencil.right);
+        }
+        if (j + 1 < size.y) {
+            addNeighbor(indices(i, j + 1, k), stencil.up);
+        }
+        if (k + 1 < size.z) {
+            addNeighbor(indices(i, j, k + 1), stencil.front);
+        }
+        A.finishRow();
+    });
+}
+
+template <typename BuildStencil>
+void buildCompressedSystem(
+    const Array3<size_t>& indices,
+    size_t numberOfRows,
+    const BuildStencil& buildStencil,
+    const FdmVector3& b,
+    FdmCompressedLinearSystem* system) {
+    buildCompressedMatrix(indices, numberOfRows, buildStencil, system);
+
+    indices.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (indices(i, j, k) != kMaxSize) {
+            system->b[indices(i, j, k)] = b(i, j, k);
+        }
+    });
+}
+
+// Gathers the values of the active cells from the grid.
+inline void gatherCompressed(
+    const Array2<size_t>& indices,
+    const FdmVector2& grid,
+    FdmCompressedVector* result) {
+    indices.parallelForEachIndex([&](size_t i, size_t j) {
+        if (indices(i, j) != kMaxSize) {
+            (*result)[indices(i, j)] = grid(i, j);
+        }
+    });
+}
+
+inline void gatherCompressed(
+    const Array3<size_t>& indices,
+    const FdmVector3& grid,
+    FdmCompressedVector* result) {
+    indices.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (indices(i, j, k) != kMaxSize) {
+            (*result)[indices(i, j, k)] = grid(i, j, k);
+        }
+    });
+}
+
+// Scatters the values of the active cells to the grid, and sets zero to the
+// other cells.
+inline void scatterCompressed(
+    const Array2<size_t>& indices,
+    const FdmCompressedVector& values,
+    FdmVector2* grid) {
+    grid->resize(indices.size());
+    indices.parallelForEachIndex([&](size_t i, size_t j) {
+        size_t index = indices(i, j);
+        (*grid)(i, j) = (index != kMaxSize) ? values[index] : 0.0;
+    });
+}
+
+inline void scatterCompressed(
+    const Array3<size_t>& indices,
+    const FdmCompressedVector& values,
+    FdmVector3* grid) {
+    grid->resize(indices.size());
+    indices.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t index = indices(i, j, k);
+        (*grid)(i, j, k) = (index != kMaxSize) ? values[index] : 0.0;
+    });
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_FDM_COMPRESSION_HELPERS_H_
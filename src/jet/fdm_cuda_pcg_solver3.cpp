@@ -0,0 +1,180 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/cg.h>
+#include <jet/fdm_cuda_pcg_solver3.h>
+#include <cuda_pcg_helpers.h>
+
+#include <stdexcept>
+
+using namespace jet;
+
+#ifndef JET_USE_CUDA
+
+namespace jet {
+
+namespace internal {
+
+void CudaPcgStateDeleter::operator()(CudaPcgState*) const {
+}
+
+CudaPcgState* createCudaPcgState() {
+    return nullptr;
+}
+
+void uploadCudaPcgMatrix(CudaPcgState*, const FdmMatrix3&) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void solveCudaPcg(
+    CudaPcgState*,
+    const FdmVector3&,
+    unsigned int,
+    double,
+    FdmVector3*,
+    unsigned int*,
+    double*) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void setCudaPcgDeviceMatrix(
+    CudaPcgState*,
+    const Size3&,
+    const FdmMatrixRow3*) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void solveCudaPcgOnDevice(
+    CudaPcgState*,
+    const double*,
+    unsigned int,
+    double,
+    double*,
+    unsigned int*,
+    double*) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif
+
+void FdmCudaPcgSolver3::Preconditioner::build(const FdmMatrix3& matrix) {
+    inverseDiagonal.resize(matrix.size());
+    matrix.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        double center = matrix(i, j, k).center;
+        inverseDiagonal(i, j, k) = (center != 0.0) ? 1.0 / center : 0.0;
+    });
+}
+
+void FdmCudaPcgSolver3::Preconditioner::solve(
+    const FdmVector3& b,
+    FdmVector3* x) {
+    x->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*x)(i, j, k) = inverseDiagonal(i, j, k) * b(i, j, k);
+    });
+}
+
+FdmCudaPcgSolver3::FdmCudaPcgSolver3(
+    unsigned int maxNumberOfIterations, double tolerance) :
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _tolerance(tolerance),
+    _lastResidual(kMaxD) {
+    if (internal::isCudaDeviceAvailable()) {
+        _device.reset(internal::createCudaPcgState());
+    }
+}
+
+FdmCudaPcgSolver3::~FdmCudaPcgSolver3() {
+}
+
+bool FdmCudaPcgSolver3::solve(FdmLinearSystem3* system) {
+    return solve(system, false);
+}
+
+bool FdmCudaPcgSolver3::solveWithSameMatrix(FdmLinearSystem3* system) {
+    bool isUploaded = _uploadedMatrix == system->A.data()
+        && _uploadedSize == system->A.size();
+    return solve(system, isUploaded);
+}
+
+bool FdmCudaPcgSolver3::solve(
+    FdmLinearSystem3* system,
+    bool isReusingMatrix) {
+    FdmMatrix3& matrix = system->A;
+    FdmVector3& solution = system->x;
+    FdmVector3& rhs = system->b;
+
+    JET_ASSERT(matrix.size() == rhs.size());
+    JET_ASSERT(matrix.size() == solution.size());
+
+    if (_device) {
+        if (!isReusingMatrix) {
+            internal::uploadCudaPcgMatrix(_device.get(), matrix);
+            _uploadedMatrix = matrix.data();
+            _uploadedSize = matrix.size();
+        }
+
+        internal::solveCudaPcg(
+            _device.get(),
+            rhs,
+            _maxNumberOfIterations,
+            _tolerance,
+            &solution,
+            &_lastNumberOfIterations,
+            &_lastResidual);
+    } else {
+        Size3 size = matrix.size();
+        _r.resize(size);
+        _d.resize(size);
+        _q.resize(size);
+        _s.resize(size);
+
+        system->x.set(0.0);
+
+        pcg<FdmBlas3, Preconditioner>(
+            matrix,
+            rhs,
+            _maxNumberOfIterations,
+            _tolerance,
+            &_precond,
+            &solution,
+            &_r,
+            &_d,
+            &_q,
+            &_s,
+            &_lastNumberOfIterations,
+            &_lastResidual);
+    }
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+unsigned int FdmCudaPcgSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmCudaPcgSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmCudaPcgSolver3::tolerance() const {
+    return _tolerance;
+}
+
+double FdmCudaPcgSolver3::lastResidual() const {
+    return _lastResidual;
+}
+
+bool FdmCudaPcgSolver3::isUsingDevice() const {
+    return static_cast<bool>(_device);
+}
+
+bool FdmCudaPcgSolver3::isDeviceAvailable() {
+    return internal::isCudaDeviceAvailable();
+}
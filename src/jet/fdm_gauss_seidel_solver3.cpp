@@ -3,19 +3,42 @@
 #include <pch.h>
 #include <jet/constants.h>
 #include <jet/fdm_gauss_seidel_solver3.h>
-#include <jet/serial.h>
+#include <jet/parallel.h>
 
 using namespace jet;
 
+namespace {
+
+inline double offDiagonalProduct(
+    const FdmMatrix3& A,
+    const FdmVector3& x,
+    const Size3& size,
+    size_t i,
+    size_t j,
+    size_t k) {
+    return ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k) : 0.0)
+        + ((i + 1 < size.x) ? A(i, j, k).right * x(i + 1, j, k) : 0.0)
+        + ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k) : 0.0)
+        + ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k) : 0.0)
+        + ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1) : 0.0)
+        + ((k + 1 < size.z) ? A(i, j, k).front * x(i, j, k + 1) : 0.0);
+}
+
+}  // namespace
+
 FdmGaussSeidelSolver3::FdmGaussSeidelSolver3(
     unsigned int maxNumberOfIterations,
     unsigned int residualCheckInterval,
-    double tolerance) :
+    double tolerance,
+    double sorFactor,
+    bool useRedBlackOrdering) :
     _maxNumberOfIterations(maxNumberOfIterations),
     _lastNumberOfIterations(0),
     _residualCheckInterval(residualCheckInterval),
     _tolerance(tolerance),
-    _lastResidual(kMaxD) {
+    _lastResidual(kMaxD),
+    _sorFactor(sorFactor),
+    _useRedBlackOrdering(useRedBlackOrdering) {
 }
 
 bool FdmGaussSeidelSolver3::solve(FdmLinearSystem3* system) {
@@ -24,7 +47,11 @@ bool FdmGaussSeidelSolver3::solve(FdmLinearSystem3* system) {
     _lastNumberOfIterations = _maxNumberOfIterations;
 
     for (unsigned int iter = 0; iter < _maxNumberOfIterations; ++iter) {
-        relax(system);
+        if (_useRedBlackOrdering) {
+            relaxRedBlack(system->A, system->b, _sorFactor, &system->x);
+        } else {
+            relax(system->A, system->b, _sorFactor, &system->x);
+        }
 
         if (iter != 0 && iter % _residualCheckInterval == 0) {
             FdmBlas3::residual(system->A, system->x, system->b, &_residual);
@@ -58,21 +85,48 @@ double FdmGaussSeidelSolver3::lastResidual() const {
     return _lastResidual;
 }
 
-void FdmGaussSeidelSolver3::relax(FdmLinearSystem3* system) {
-    Size3 size = system->x.size();
-    FdmMatrix3& A = system->A;
-    FdmVector3& x = system->x;
-    FdmVector3& b = system->b;
+double FdmGaussSeidelSolver3::sorFactor() const {
+    return _sorFactor;
+}
+
+bool FdmGaussSeidelSolver3::useRedBlackOrdering() const {
+    return _useRedBlackOrdering;
+}
+
+void FdmGaussSeidelSolver3::relax(
+    const FdmMatrix3& A,
+    const FdmVector3& b,
+    double sorFactor,
+    FdmVector3* x_) {
+    Size3 size = A.size();
+    FdmVector3& x = *x_;
 
     A.forEachIndex([&](size_t i, size_t j, size_t k) {
-        double r
-            = ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k) : 0.0)
-            + ((i + 1 < size.x) ? A(i, j, k).right * x(i + 1, j, k) : 0.0)
-            + ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k) : 0.0)
-            + ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k) : 0.0)
-            + ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1) : 0.0)
-            + ((k + 1 < size.z) ? A(i, j, k).front * x(i, j, k + 1) : 0.0);
-
-        x(i, j, k) = (b(i, j, k) - r) / A(i, j, k).center;
+        double r = offDiagonalProduct(A, x, size, i, j, k);
+
+        x(i, j, k) = (1.0 - sorFactor) * x(i, j, k)
+            + sorFactor * (b(i, j, k) - r) / A(i, j, k).center;
     });
 }
+
+void FdmGaussSeidelSolver3::relaxRedBlack(
+    const FdmMatrix3& A,
+    const FdmVector3& b,
+    double sorFactor,
+    FdmVector3* x_) {
+    Size3 size = A.size();
+    FdmVector3& x = *x_;
+
+    for (size_t color = 0; color < 2; ++color) {
+        parallelFor(kZeroSize, size.z, [&](size_t k) {
+            for (size_t j = 0; j < size.y; ++j) {
+                for (size_t i = (j + k + color) % 2; i < size.x; i += 2) {
+                    double r = offDiagonalProduct(A, x, size, i, j, k);
+
+                    x(i, j, k) = (1.0 - sorFactor) * x(i, j, k)
+                        + sorFactor * (b(i, j, k) - r) / A(i, j, k).center;
+                }
+            }
+        });
+    }
+}
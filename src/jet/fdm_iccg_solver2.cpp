@@ -4,65 +4,222 @@
 #include <jet/constants.h>
 #include <jet/cg.h>
 #include <jet/fdm_iccg_solver2.h>
+#include <fdm_compressed_iccg_helpers.h>
+#include <fdm_mixed_precision_helpers.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
 
 using namespace jet;
 
-void FdmIccgSolver2::Preconditioner::build(const FdmMatrix2& matrix) {
+namespace {
+
+// Tuning and safety constants of the modified incomplete Cholesky, see
+// Bridson, Fluid Simulation for Computer Graphics.
+const double kMicTuning = 0.97;
+const double kMicSafety = 0.25;
+
+// Calls func(i, j) for every cell of the grid so that the cells (i - 1, j)
+// and (i, j - 1) are visited before (i, j). The cells are visited in
+// sequence, or in parallel along each i + j = const wavefront.
+template <typename Function>
+void forEachCell(
+    const Size2& size,
+    bool isParallel,
+    const Function& func) {
+    if (!isParallel) {
+        for (size_t j = 0; j < size.y; ++j) {
+            for (size_t i = 0; i < size.x; ++i) {
+                func(i, j);
+            }
+        }
+        return;
+    }
+
+    for (size_t w = 0; w + 1 < size.x + size.y; ++w) {
+        size_t jBegin = (w >= size.x) ? w - size.x + 1 : 0;
+        size_t jEnd = std::min(w + 1, size.y);
+        parallelFor(jBegin, jEnd, [&](size_t j) {
+            func(w - j, j);
+        });
+    }
+}
+
+// Same as forEachCell, but in the reverse order.
+template <typename Function>
+void forEachCellReversed(
+    const Size2& size,
+    bool isParallel,
+    const Function& func) {
+    if (!isParallel) {
+        for (size_t j = size.y; j-- > 0;) {
+            for (size_t i = size.x; i-- > 0;) {
+                func(i, j);
+            }
+        }
+        return;
+    }
+
+    for (size_t w = size.x + size.y; w-- > 1;) {
+        size_t jBegin = (w > size.x) ? w - size.x : 0;
+        size_t jEnd = std::min(w, size.y);
+        parallelFor(jBegin, jEnd, [&](size_t j) {
+            func(w - 1 - j, j);
+        });
+    }
+}
+
+// Calls func(i, j) for every cell of the given color, where the color is
+// (i + j) % 2. Cells of the same color do not couple in the 5-point
+// stencil, so they are visited in parallel.
+template <typename Function>
+void forEachCellOfColor(
+    const Size2& size,
+    size_t color,
+    const Function& func) {
+    parallelFor(kZeroSize, size.y, [&](size_t j) {
+        for (size_t i = (j + color) % 2; i < size.x; i += 2) {
+            func(i, j);
+        }
+    });
+}
+
+}  // namespace
+
+template <typename T>
+void FdmIccgSolver2::Preconditioner<T>::build(
+    const Array2<FdmMatrixRow2T<T>>& matrix) {
     Size2 size = matrix.size();
     A = matrix.constAccessor();
 
     d.resize(size, 0.0);
     y.resize(size, 0.0);
 
-    matrix.forEachIndex([&](size_t i, size_t j) {
-        double denom
-            = matrix(i, j).center
-            - ((i > 0) ?
-                square(matrix(i - 1, j).right) * d(i - 1, j) : 0.0)
-            - ((j > 0) ?
-                square(matrix(i, j - 1).up)    * d(i, j - 1) : 0.0);
-
+    auto setDiagonal = [&](size_t i, size_t j, double denom) {
         if (std::fabs(denom) > 0.0) {
-            d(i, j) = 1.0 / denom;
+            d(i, j) = static_cast<T>(1.0 / denom);
         } else {
-            d(i, j) = 0.0;
+            d(i, j) = 0;
+        }
+    };
+
+    if (type == RedBlackIncompleteCholesky) {
+        // Red cells come first and do not couple to each other, and all the
+        // neighbors of a black cell are red.
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j) {
+            setDiagonal(i, j, A(i, j).center);
+        });
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j) {
+            double denom
+                = A(i, j).center
+                - ((i > 0) ? square(A(i - 1, j).right) * d(i - 1, j) : 0.0)
+                - ((i + 1 < size.x) ? square(A(i, j).right) * d(i + 1, j) : 0.0)
+                - ((j > 0) ? square(A(i, j - 1).up) * d(i, j - 1) : 0.0)
+                - ((j + 1 < size.y) ? square(A(i, j).up) * d(i, j + 1) : 0.0);
+            setDiagonal(i, j, denom);
+        });
+        return;
+    }
+
+    double tau = (type == ModifiedIncompleteCholesky) ? kMicTuning : 0.0;
+
+    forEachCell(size, type != IncompleteCholesky, [&](size_t i, size_t j) {
+        double denom = A(i, j).center;
+
+        // The modified variant also subtracts the dropped fill-in (scaled by
+        // tau) from the diagonal to preserve the row sums.
+        if (i > 0) {
+            const FdmMatrixRow2T<T>& n = A(i - 1, j);
+            denom -= n.right * (n.right + tau * n.up) * d(i - 1, j);
         }
+        if (j > 0) {
+            const FdmMatrixRow2T<T>& n = A(i, j - 1);
+            denom -= n.up * (n.up + tau * n.right) * d(i, j - 1);
+        }
+
+        if (tau > 0.0 && denom < kMicSafety * A(i, j).center) {
+            denom = A(i, j).center;
+        }
+
+        setDiagonal(i, j, denom);
     });
 }
 
-void FdmIccgSolver2::Preconditioner::solve(
-    const FdmVector2& b,
-    FdmVector2* x) {
+template <typename T>
+void FdmIccgSolver2::Preconditioner<T>::solve(
+    const Array2<T>& b,
+    Array2<T>* x) {
     Size2 size = b.size();
-    ssize_t sx = static_cast<ssize_t>(size.x);
-    ssize_t sy = static_cast<ssize_t>(size.y);
 
-    b.forEachIndex([&](size_t i, size_t j) {
-        y(i, j)
-            = (b(i, j)
+    // Solves (E + L) E^-1 (E + L^T) x = b where E = diag(1 / d) and L is the
+    // part of A coupling each cell to the ones eliminated before it.
+    if (type == RedBlackIncompleteCholesky) {
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j) {
+            y(i, j) = b(i, j) * d(i, j);
+        });
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j) {
+            y(i, j) = static_cast<T>(
+                (b(i, j)
+                - ((i > 0) ? A(i - 1, j).right * y(i - 1, j) : 0.0)
+                - ((i + 1 < size.x) ? A(i, j).right * y(i + 1, j) : 0.0)
+                - ((j > 0) ? A(i, j - 1).up * y(i, j - 1) : 0.0)
+                - ((j + 1 < size.y) ? A(i, j).up * y(i, j + 1) : 0.0))
+                * d(i, j));
+            (*x)(i, j) = y(i, j);
+        });
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j) {
+            (*x)(i, j) = static_cast<T>(
+                y(i, j)
+                - (((i > 0) ? A(i - 1, j).right * (*x)(i - 1, j) : 0.0)
+                + ((i + 1 < size.x) ? A(i, j).right * (*x)(i + 1, j) : 0.0)
+                + ((j > 0) ? A(i, j - 1).up * (*x)(i, j - 1) : 0.0)
+                + ((j + 1 < size.y) ? A(i, j).up * (*x)(i, j + 1) : 0.0))
+                * d(i, j));
+        });
+        return;
+    }
+
+    bool isParallel = (type != IncompleteCholesky);
+
+    forEachCell(size, isParallel, [&](size_t i, size_t j) {
+        y(i, j) = static_cast<T>(
+            (b(i, j)
             - ((i > 0) ? A(i - 1, j).right * y(i - 1, j) : 0.0)
             - ((j > 0) ? A(i, j - 1).up    * y(i, j - 1) : 0.0))
-            * d(i, j);
+            * d(i, j));
     });
 
-    for (ssize_t j = sy - 1; j >= 0; --j) {
-        for (ssize_t i = sx - 1; i >= 0; --i) {
-            (*x)(i, j)
-                = (y(i, j)
-                - ((i + 1 < sx) ? A(i, j).right * (*x)(i + 1, j) : 0.0)
-                - ((j + 1 < sy) ? A(i, j).up    * (*x)(i, j + 1) : 0.0))
-                * d(i, j);
-        }
-    }
+    forEachCellReversed(size, isParallel, [&](size_t i, size_t j) {
+        (*x)(i, j) = static_cast<T>(
+            y(i, j)
+            - (((i + 1 < size.x) ? A(i, j).right * (*x)(i + 1, j) : 0.0)
+            + ((j + 1 < size.y) ? A(i, j).up    * (*x)(i, j + 1) : 0.0))
+            * d(i, j));
+    });
+}
+
+void FdmIccgSolver2::CompressedPreconditioner::build(
+    const FdmCompressedMatrix& matrix) {
+    A = &matrix;
+    buildCompressedIncompleteCholesky(matrix, &d);
+}
+
+void FdmIccgSolver2::CompressedPreconditioner::solve(
+    const FdmCompressedVector& b,
+    FdmCompressedVector* x) {
+    solveCompressedIncompleteCholesky(*A, d, b, &y, x);
 }
 
 FdmIccgSolver2::FdmIccgSolver2(
     unsigned int maxNumberOfIterations,
-    double tolerance) :
+    double tolerance,
+    PreconditionerType preconditionerType) :
     _maxNumberOfIterations(maxNumberOfIterations),
     _lastNumberOfIterations(0),
     _tolerance(tolerance),
     _lastResidualNorm(kMaxD) {
+    _precond.type = preconditionerType;
+    _precondF.type = preconditionerType;
 }
 
 bool FdmIccgSolver2::solve(FdmLinearSystem2* system) {
@@ -74,6 +231,56 @@ bool FdmIccgSolver2::solve(FdmLinearSystem2* system) {
     JET_ASSERT(matrix.size() == solution.size());
 
     Size2 size = matrix.size();
+
+    if (_isUsingMixedPrecision) {
+        system->x.set(0.0);
+
+        auto innerSolve = [&](
+            const FdmMatrix2F& a,
+            const FdmVector2F& b,
+            double tolerance,
+            unsigned int maxNumberOfIterations,
+            FdmVector2F* x) {
+            _rF.resize(size);
+            _dF.resize(size);
+            _qF.resize(size);
+            _sF.resize(size);
+
+            unsigned int numberOfIterations = 0;
+            double residualNorm = 0.0;
+            pcg<FdmBlas2F, Preconditioner<float>>(
+                a,
+                b,
+                maxNumberOfIterations,
+                tolerance,
+                &_precondF,
+                x,
+                &_rF,
+                &_dF,
+                &_qF,
+                &_sF,
+                &numberOfIterations,
+                &residualNorm);
+            return numberOfIterations;
+        };
+
+        solveWithMixedPrecision<FdmBlas2, FdmBlas2F>(
+            matrix,
+            rhs,
+            _maxNumberOfIterations,
+            _tolerance,
+            innerSolve,
+            &solution,
+            &_r,
+            &_matrixF,
+            &_bF,
+            &_xF,
+            &_lastNumberOfIterations,
+            &_lastResidualNorm);
+
+        return _lastResidualNorm <= _tolerance;
+    }
+
     _r.resize(size);
     _d.resize(size);
     _q.resize(size);
@@ -87,7 +294,7 @@ bool FdmIccgSolver2::solve(FdmLinearSystem2* system) {
 
     _precond.build(matrix);
 
-    pcg<FdmBlas2, Preconditioner>(
+    pcg<FdmBlas2, Preconditioner<double>>(
         matrix,
         rhs,
         _maxNumberOfIterations,
@@ -108,6 +315,53 @@ bool FdmIccgSolver2::solve(FdmLinearSystem2* system) {
         || _lastNumberOfIterations < _maxNumberOfIterations;
 }
 
+bool FdmIccgSolver2::solveCompressed(FdmCompressedLinearSystem* system) {
+    FdmCompressedMatrix& matrix = system->A;
+    FdmCompressedVector& solution = system->x;
+    FdmCompressedVector& rhs = system->b;
+
+    JET_ASSERT(matrix.rows() == rhs.size());
+    JET_ASSERT(matrix.rows() == solution.size());
+
+    size_t size = matrix.rows();
+    _rComp.resize(size);
+    _dComp.resize(size);
+    _qComp.resize(size);
+    _sComp.resize(size);
+
+    solution.set(0.0);
+    _rComp.set(0.0);
+    _dComp.set(0.0);
+    _qComp.set(0.0);
+    _sComp.set(0.0);
+
+    pcg<FdmCompressedBlas, CompressedPreconditioner>(
+        matrix,
+        rhs,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precondComp,
+        &solution,
+        &_rComp,
+        &_dComp,
+        &_qComp,
+        &_sComp,
+        &_lastNumberOfIterations,
+        &_lastResidualNorm);
+
+    JET_INFO << "Residual norm after solving compressed ICCG: "
+             << _lastResidualNorm
+             << " Number of compressed ICCG iterations: "
+             << _lastNumberOfIterations;
+
+    return _lastResidualNorm <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmIccgSolver2::isCompressedSystemSupported() const {
+    return true;
+}
+
 unsigned int FdmIccgSolver2::maxNumberOfIterations() const {
     return _maxNumberOfIterations;
 }
@@ -123,3 +377,21 @@ double FdmIccgSolver2::tolerance() const {
 double FdmIccgSolver2::lastResidual() const {
     return _lastResidualNorm;
 }
+
+FdmIccgSolver2::PreconditionerType
+FdmIccgSolver2::preconditionerType() const {
+    return _precond.type;
+}
+
+void FdmIccgSolver2::setPreconditionerType(PreconditionerType type) {
+    _precond.type = type;
+    _precondF.type = type;
+}
+
+bool FdmIccgSolver2::isUsingMixedPrecision() const {
+    return _isUsingMixedPrecision;
+}
+
+void FdmIccgSolver2::setIsUsingMixedPrecision(bool isUsing) {
+    _isUsingMixedPrecision = isUsing;
+}
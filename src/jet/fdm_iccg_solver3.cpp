@@ -4,78 +4,357 @@
 #include <jet/constants.h>
 #include <jet/cg.h>
 #include <jet/fdm_iccg_solver3.h>
+#include <fdm_compressed_iccg_helpers.h>
+#include <fdm_mixed_precision_helpers.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
 
 using namespace jet;
 
-void FdmIccgSolver3::Preconditioner::build(const FdmMatrix3& matrix) {
+namespace {
+
+// Tuning and safety constants of the modified incomplete Cholesky, see
+// Bridson, Fluid Simulation for Computer Graphics.
+const double kMicTuning = 0.97;
+const double kMicSafety = 0.25;
+
+// Size of the bricks of the block preconditioner along each axis
+const size_t kBrickSize = 16;
+
+// Calls func(j, k) for every i-line of the grid so that the lines (j - 1, k)
+// and (j, k - 1) are visited before (j, k). The lines are visited in
+// sequence, or in parallel along each j + k = const wavefront.
+template <typename Function>
+void forEachLine(
+    const Size3& size,
+    bool isParallel,
+    const Function& func) {
+    if (!isParallel) {
+        for (size_t k = 0; k < size.z; ++k) {
+            for (size_t j = 0; j < size.y; ++j) {
+                func(j, k);
+            }
+        }
+        return;
+    }
+
+    for (size_t w = 0; w + 1 < size.y + size.z; ++w) {
+        size_t kBegin = (w >= size.y) ? w - size.y + 1 : 0;
+        size_t kEnd = std::min(w + 1, size.z);
+        parallelFor(kBegin, kEnd, [&](size_t k) {
+            func(w - k, k);
+        });
+    }
+}
+
+// Same as forEachLine, but in the reverse order.
+template <typename Function>
+void forEachLineReversed(
+    const Size3& size,
+    bool isParallel,
+    const Function& func) {
+    if (!isParallel) {
+        for (size_t k = size.z; k-- > 0;) {
+            for (size_t j = size.y; j-- > 0;) {
+                func(j, k);
+            }
+        }
+        return;
+    }
+
+    for (size_t w = size.y + size.z; w-- > 1;) {
+        size_t kBegin = (w > size.y) ? w - size.y : 0;
+        size_t kEnd = std::min(w, size.z);
+        parallelFor(kBegin, kEnd, [&](size_t k) {
+            func(w - 1 - k, k);
+        });
+    }
+}
+
+// Calls func(i, j, k) for every cell of the given color, where the color is
+// (i + j + k) % 2. Cells of the same color do not couple in the 7-point
+// stencil, so they are visited in parallel.
+template <typename Function>
+void forEachCellOfColor(
+    const Size3& size,
+    size_t color,
+    const Function& func) {
+    parallelFor(kZeroSize, size.z, [&](size_t k) {
+        for (size_t j = 0; j < size.y; ++j) {
+            for (size_t i = (j + k + color) % 2; i < size.x; i += 2) {
+                func(i, j, k);
+            }
+        }
+    });
+}
+
+// Calls func(lower, upper) for each brick of the grid in parallel, where
+// lower and upper are the corners of the brick.
+template <typename Function>
+void forEachBrick(const Size3& size, const Function& func) {
+    Size3 numberOfBricks(
+        (size.x + kBrickSize - 1) / kBrickSize,
+        (size.y + kBrickSize - 1) / kBrickSize,
+        (size.z + kBrickSize - 1) / kBrickSize);
+    size_t n = numberOfBricks.x * numberOfBricks.y * numberOfBricks.z;
+
+    parallelFor(kZeroSize, n, [&](size_t brick) {
+        Size3 lower(
+            kBrickSize * (brick % numberOfBricks.x),
+            kBrickSize * ((brick / numberOfBricks.x) % numberOfBricks.y),
+            kBrickSize * (brick / (numberOfBricks.x * numberOfBricks.y)));
+        Size3 upper(
+            std::min(lower.x + kBrickSize, size.x),
+            std::min(lower.y + kBrickSize, size.y),
+            std::min(lower.z + kBrickSize, size.z));
+        func(lower, upper);
+    });
+}
+
+}  // namespace
+
+template <typename T>
+void FdmIccgSolver3::Preconditioner<T>::build(
+    const Array3<FdmMatrixRow3T<T>>& matrix) {
     Size3 size = matrix.size();
     A = matrix.constAccessor();
 
     d.resize(size, 0.0);
     y.resize(size, 0.0);
 
-    matrix.forEachIndex([&](size_t i, size_t j, size_t k) {
-        double denom
-            = matrix(i, j, k).center
-            - ((i > 0) ?
-                square(matrix(i - 1, j, k).right) * d(i - 1, j, k) : 0.0)
-            - ((j > 0) ?
-                square(matrix(i, j - 1, k).up)    * d(i, j - 1, k) : 0.0)
-            - ((k > 0) ?
-                square(matrix(i, j, k - 1).front) * d(i, j, k - 1) : 0.0);
-
+    auto setDiagonal = [&](size_t i, size_t j, size_t k, double denom) {
         if (std::fabs(denom) > 0.0) {
-            d(i, j, k) = 1.0 / denom;
+            d(i, j, k) = static_cast<T>(1.0 / denom);
         } else {
-            d(i, j, k) = 0.0;
+            d(i, j, k) = 0;
         }
+    };
+
+    if (type == RedBlackIncompleteCholesky) {
+        // Red cells come first and do not couple to each other, and all the
+        // neighbors of a black cell are red.
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j, size_t k) {
+            setDiagonal(i, j, k, A(i, j, k).center);
+        });
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j, size_t k) {
+            double denom
+                = A(i, j, k).center
+                - ((i > 0) ?
+                    square(A(i - 1, j, k).right) * d(i - 1, j, k) : 0.0)
+                - ((i + 1 < size.x) ?
+                    square(A(i, j, k).right) * d(i + 1, j, k) : 0.0)
+                - ((j > 0) ?
+                    square(A(i, j - 1, k).up) * d(i, j - 1, k) : 0.0)
+                - ((j + 1 < size.y) ?
+                    square(A(i, j, k).up) * d(i, j + 1, k) : 0.0)
+                - ((k > 0) ?
+                    square(A(i, j, k - 1).front) * d(i, j, k - 1) : 0.0)
+                - ((k + 1 < size.z) ?
+                    square(A(i, j, k).front) * d(i, j, k + 1) : 0.0);
+            setDiagonal(i, j, k, denom);
+        });
+        return;
+    }
+
+    double tau = (type == ModifiedIncompleteCholesky) ? kMicTuning : 0.0;
+
+    // Factorizes the i-line (j, k) of the block between lower and upper,
+    // ignoring the coupling to the cells outside of it
+    auto factorizeLine = [&](
+        size_t j,
+        size_t k,
+        const Size3& lower,
+        const Size3& upper) {
+        for (size_t i = lower.x; i < upper.x; ++i) {
+            double denom = A(i, j, k).center;
+
+            // The modified variant also subtracts the dropped fill-in
+            // (scaled by tau) from the diagonal to preserve the row sums.
+            if (i > lower.x) {
+                const FdmMatrixRow3T<T>& n = A(i - 1, j, k);
+                denom -= n.right * (n.right + tau * (n.up + n.front))
+                    * d(i - 1, j, k);
+            }
+            if (j > lower.y) {
+                const FdmMatrixRow3T<T>& n = A(i, j - 1, k);
+                denom -= n.up * (n.up + tau * (n.right + n.front))
+                    * d(i, j - 1, k);
+            }
+            if (k > lower.z) {
+                const FdmMatrixRow3T<T>& n = A(i, j, k - 1);
+                denom -= n.front * (n.front + tau * (n.right + n.up))
+                    * d(i, j, k - 1);
+            }
+
+            if (tau > 0.0 && denom < kMicSafety * A(i, j, k).center) {
+                denom = A(i, j, k).center;
+            }
+
+            setDiagonal(i, j, k, denom);
+        }
+    };
+
+    if (type == BlockIncompleteCholesky) {
+        forEachBrick(size, [&](const Size3& lower, const Size3& upper) {
+            for (size_t k = lower.z; k < upper.z; ++k) {
+                for (size_t j = lower.y; j < upper.y; ++j) {
+                    factorizeLine(j, k, lower, upper);
+                }
+            }
+        });
+        return;
+    }
+
+    forEachLine(size, type != IncompleteCholesky, [&](size_t j, size_t k) {
+        factorizeLine(j, k, Size3(), size);
     });
 }
 
-void FdmIccgSolver3::Preconditioner::solve(
-    const FdmVector3& b,
-    FdmVector3* x) {
+template <typename T>
+void FdmIccgSolver3::Preconditioner<T>::solve(
+    const Array3<T>& b,
+    Array3<T>* x) {
     Size3 size = b.size();
-    ssize_t sx = static_cast<ssize_t>(size.x);
-    ssize_t sy = static_cast<ssize_t>(size.y);
-    ssize_t sz = static_cast<ssize_t>(size.z);
-
-    b.forEachIndex([&](size_t i, size_t j, size_t k) {
-        y(i, j, k)
-            = (b(i, j, k)
-            - ((i > 0) ? A(i - 1, j, k).right * y(i - 1, j, k) : 0.0)
-            - ((j > 0) ? A(i, j - 1, k).up    * y(i, j - 1, k) : 0.0)
-            - ((k > 0) ? A(i, j, k - 1).front * y(i, j, k - 1) : 0.0))
-            * d(i, j, k);
-    });
 
-    for (ssize_t k = sz - 1; k >= 0; --k) {
-        for (ssize_t j = sy - 1; j >= 0; --j) {
-            for (ssize_t i = sx - 1; i >= 0; --i) {
-                (*x)(i, j, k)
-                    = (y(i, j, k)
-                    - ((i + 1 < sx) ?
-                        A(i, j, k).right * (*x)(i + 1, j, k) : 0.0)
-                    - ((j + 1 < sy) ?
-                        A(i, j, k).up    * (*x)(i, j + 1, k) : 0.0)
-                    - ((k + 1 < sz) ?
-                        A(i, j, k).front * (*x)(i, j, k + 1) : 0.0))
-                    * d(i, j, k);
-            }
+    // Solves (E + L) E^-1 (E + L^T) x = b where E = diag(1 / d) and L is the
+    // part of A coupling each cell to the ones eliminated before it.
+    if (type == RedBlackIncompleteCholesky) {
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j, size_t k) {
+            y(i, j, k) = b(i, j, k) * d(i, j, k);
+        });
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j, size_t k) {
+            y(i, j, k) = static_cast<T>(
+                (b(i, j, k)
+                - ((i > 0) ? A(i - 1, j, k).right * y(i - 1, j, k) : 0.0)
+                - ((i + 1 < size.x) ? A(i, j, k).right * y(i + 1, j, k) : 0.0)
+                - ((j > 0) ? A(i, j - 1, k).up * y(i, j - 1, k) : 0.0)
+                - ((j + 1 < size.y) ? A(i, j, k).up * y(i, j + 1, k) : 0.0)
+                - ((k > 0) ? A(i, j, k - 1).front * y(i, j, k - 1) : 0.0)
+                - ((k + 1 < size.z) ?
+                    A(i, j, k).front * y(i, j, k + 1) : 0.0))
+                * d(i, j, k));
+            (*x)(i, j, k) = y(i, j, k);
+        });
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j, size_t k) {
+            (*x)(i, j, k) = static_cast<T>(
+                y(i, j, k)
+                - (((i > 0) ? A(i - 1, j, k).right * (*x)(i - 1, j, k) : 0.0)
+                + ((i + 1 < size.x) ?
+                    A(i, j, k).right * (*x)(i + 1, j, k) : 0.0)
+                + ((j > 0) ? A(i, j - 1, k).up * (*x)(i, j - 1, k) : 0.0)
+                + ((j + 1 < size.y) ?
+                    A(i, j, k).up * (*x)(i, j + 1, k) : 0.0)
+                + ((k > 0) ? A(i, j, k - 1).front * (*x)(i, j, k - 1) : 0.0)
+                + ((k + 1 < size.z) ?
+                    A(i, j, k).front * (*x)(i, j, k + 1) : 0.0))
+                * d(i, j, k));
+        });
+        return;
+    }
+
+    // Substitutions on the i-line (j, k) of the block between lower and
+    // upper, ignoring the coupling to the cells outside of it
+    auto forwardLine = [&](
+        size_t j,
+        size_t k,
+        const Size3& lower,
+        const Size3& upper) {
+        for (size_t i = lower.x; i < upper.x; ++i) {
+            y(i, j, k) = static_cast<T>(
+                (b(i, j, k)
+                - ((i > lower.x) ? A(i - 1, j, k).right * y(i - 1, j, k) : 0.0)
+                - ((j > lower.y) ? A(i, j - 1, k).up    * y(i, j - 1, k) : 0.0)
+                - ((k > lower.z) ? A(i, j, k - 1).front * y(i, j, k - 1) : 0.0))
+                * d(i, j, k));
+        }
+    };
+
+    auto backwardLine = [&](
+        size_t j,
+        size_t k,
+        const Size3& lower,
+        const Size3& upper) {
+        for (size_t i = upper.x; i-- > lower.x;) {
+            (*x)(i, j, k) = static_cast<T>(
+                y(i, j, k)
+                - (((i + 1 < upper.x) ?
+                    A(i, j, k).right * (*x)(i + 1, j, k) : 0.0)
+                + ((j + 1 < upper.y) ?
+                    A(i, j, k).up    * (*x)(i, j + 1, k) : 0.0)
+                + ((k + 1 < upper.z) ?
+                    A(i, j, k).front * (*x)(i, j, k + 1) : 0.0))
+                * d(i, j, k));
         }
+    };
+
+    // The bricks do not couple, so each one runs both of its substitutions
+    // while it is in the cache
+    if (type == BlockIncompleteCholesky) {
+        forEachBrick(size, [&](const Size3& lower, const Size3& upper) {
+            for (size_t k = lower.z; k < upper.z; ++k) {
+                for (size_t j = lower.y; j < upper.y; ++j) {
+                    forwardLine(j, k, lower, upper);
+                }
+            }
+            for (size_t k = upper.z; k-- > lower.z;) {
+                for (size_t j = upper.y; j-- > lower.y;) {
+                    backwardLine(j, k, lower, upper);
+                }
+            }
+        });
+        return;
     }
+
+    bool isParallel = (type != IncompleteCholesky);
+
+    forEachLine(size, isParallel, [&](size_t j, size_t k) {
+        forwardLine(j, k, Size3(), size);
+    });
+
+    forEachLineReversed(size, isParallel, [&](size_t j, size_t k) {
+        backwardLine(j, k, Size3(), size);
+    });
+}
+
+void FdmIccgSolver3::CompressedPreconditioner::build(
+    const FdmCompressedMatrix& matrix) {
+    A = &matrix;
+    buildCompressedIncompleteCholesky(matrix, &d);
+}
+
+void FdmIccgSolver3::CompressedPreconditioner::solve(
+    const FdmCompressedVector& b,
+    FdmCompressedVector* x) {
+    solveCompressedIncompleteCholesky(*A, d, b, &y, x);
 }
 
 FdmIccgSolver3::FdmIccgSolver3(
     unsigned int maxNumberOfIterations,
-    double tolerance) :
+    double tolerance,
+    PreconditionerType preconditionerType) :
     _maxNumberOfIterations(maxNumberOfIterations),
     _lastNumberOfIterations(0),
     _tolerance(tolerance),
     _lastResidualNorm(kMaxD) {
+    _precond.type = preconditionerType;
+    _precondF.type = preconditionerType;
 }
 
 bool FdmIccgSolver3::solve(FdmLinearSystem3* system) {
+    return solve(system, false);
+}
+
+bool FdmIccgSolver3::solveWithSameMatrix(FdmLinearSystem3* system) {
+    // The preconditioner refers to the matrix it was built from
+    bool isBuilt = _precond.A.data() == system->A.data()
+        && _precond.d.size() == system->A.size();
+    return solve(system, isBuilt);
+}
+
+bool FdmIccgSolver3::solve(
+    FdmLinearSystem3* system,
+    bool isReusingPreconditioner) {
     FdmMatrix3& matrix = system->A;
     FdmVector3& solution = system->x;
     FdmVector3& rhs = system->b;
@@ -84,6 +363,56 @@ bool FdmIccgSolver3::solve(FdmLinearSystem3* system) {
     JET_ASSERT(matrix.size() == solution.size());
 
     Size3 size = matrix.size();
+
+    if (_isUsingMixedPrecision) {
+        system->x.set(0.0);
+
+        auto innerSolve = [&](
+            const FdmMatrix3F& a,
+            const FdmVector3F& b,
+            double tolerance,
+            unsigned int maxNumberOfIterations,
+            FdmVector3F* x) {
+            _rF.resize(size);
+            _dF.resize(size);
+            _qF.resize(size);
+            _sF.resize(size);
+
+            unsigned int numberOfIterations = 0;
+            double residualNorm = 0.0;
+            pcg<FdmBlas3F, Preconditioner<float>>(
+                a,
+                b,
+                maxNumberOfIterations,
+                tolerance,
+                &_precondF,
+                x,
+                &_rF,
+                &_dF,
+                &_qF,
+                &_sF,
+                &numberOfIterations,
+                &residualNorm);
+            return numberOfIterations;
+        };
+
+        solveWithMixedPrecision<FdmBlas3, FdmBlas3F>(
+            matrix,
+            rhs,
+            _maxNumberOfIterations,
+            _tolerance,
+            innerSolve,
+            &solution,
+            &_r,
+            &_matrixF,
+            &_bF,
+            &_xF,
+            &_lastNumberOfIterations,
+            &_lastResidualNorm);
+
+        return _lastResidualNorm <= _tolerance;
+    }
+
     _r.resize(size);
     _d.resize(size);
     _q.resize(size);
@@ -95,9 +424,11 @@ bool FdmIccgSolver3::solve(FdmLinearSystem3* system) {
     _q.set(0.0);
     _s.set(0.0);
 
-    _precond.build(matrix);
+    if (!isReusingPreconditioner) {
+        _precond.build(matrix);
+    }
 
-    pcg<FdmBlas3, Preconditioner>(
+    pcg<FdmBlas3, Preconditioner<double>>(
         matrix,
         rhs,
         _maxNumberOfIterations,
@@ -118,6 +449,53 @@ bool FdmIccgSolver3::solve(FdmLinearSystem3* system) {
         || _lastNumberOfIterations < _maxNumberOfIterations;
 }
 
+bool FdmIccgSolver3::solveCompressed(FdmCompressedLinearSystem* system) {
+    FdmCompressedMatrix& matrix = system->A;
+    FdmCompressedVector& solution = system->x;
+    FdmCompressedVector& rhs = system->b;
+
+    JET_ASSERT(matrix.rows() == rhs.size());
+    JET_ASSERT(matrix.rows() == solution.size());
+
+    size_t size = matrix.rows();
+    _rComp.resize(size);
+    _dComp.resize(size);
+    _qComp.resize(size);
+    _sComp.resize(size);
+
+    solution.set(0.0);
+    _rComp.set(0.0);
+    _dComp.set(0.0);
+    _qComp.set(0.0);
+    _sComp.set(0.0);
+
+    pcg<FdmCompressedBlas, CompressedPreconditioner>(
+        matrix,
+        rhs,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precondComp,
+        &solution,
+        &_rComp,
+        &_dComp,
+        &_qComp,
+        &_sComp,
+        &_lastNumberOfIterations,
+        &_lastResidualNorm);
+
+    JET_INFO << "Residual norm after solving compressed ICCG: "
+             << _lastResidualNorm
+             << " Number of compressed ICCG iterations: "
+             << _lastNumberOfIterations;
+
+    return _lastResidualNorm <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmIccgSolver3::isCompressedSystemSupported() const {
+    return true;
+}
+
 unsigned int FdmIccgSolver3::maxNumberOfIterations() const {
     return _maxNumberOfIterations;
 }
@@ -133,3 +511,21 @@ double FdmIccgSolver3::tolerance() const {
 double FdmIccgSolver3::lastResidual() const {
     return _lastResidualNorm;
 }
+
+FdmIccgSolver3::PreconditionerType
+FdmIccgSolver3::preconditionerType() const {
+    return _precond.type;
+}
+
+void FdmIccgSolver3::setPreconditionerType(PreconditionerType type) {
+    _precond.type = type;
+    _precondF.type = type;
+}
+
+bool FdmIccgSolver3::isUsingMixedPrecision() const {
+    return _isUsingMixedPrecision;
+}
+
+void FdmIccgSolver3::setIsUsingMixedPrecision(bool isUsing) {
+    _isUsingMixedPrecision = isUsing;
+}
@@ -5,8 +5,41 @@
 #include <jet/fdm_jacobi_solver3.h>
 #include <jet/parallel.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace jet;
 
+namespace {
+
+// Size of the tiles of the blocked iterations along each axis
+const size_t kTileSize = 32;
+
+// Returns the Jacobi update of cell (i, j, k), where x(i, j, k) returns the
+// current value of a cell. Both the plain and the blocked iterations use it,
+// so they give the same result.
+template <typename Accessor>
+double jacobiUpdate(
+    const FdmMatrix3& A,
+    const FdmVector3& b,
+    const Size3& size,
+    const Accessor& x,
+    size_t i,
+    size_t j,
+    size_t k) {
+    double r
+        = ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k) : 0.0)
+        + ((i + 1 < size.x) ? A(i, j, k).right * x(i + 1, j, k) : 0.0)
+        + ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k) : 0.0)
+        + ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k) : 0.0)
+        + ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1) : 0.0)
+        + ((k + 1 < size.z) ? A(i, j, k).front * x(i, j, k + 1) : 0.0);
+
+    return (b(i, j, k) - r) / A(i, j, k).center;
+}
+
+}  // namespace
+
 FdmJacobiSolver3::FdmJacobiSolver3(
     unsigned int maxNumberOfIterations,
     unsigned int residualCheckInterval,
@@ -24,16 +57,37 @@ bool FdmJacobiSolver3::solve(FdmLinearSystem3* system) {
 
     _lastNumberOfIterations = _maxNumberOfIterations;
 
-    for (unsigned int iter = 0; iter < _maxNumberOfIterations; ++iter) {
-        relax(system, &_xTemp);
+    unsigned int iter = 0;
+    while (iter < _maxNumberOfIterations) {
+        // Runs the iterations up to the next residual check at once
+        unsigned int n = std::min(
+            _temporalBlockingDepth, _maxNumberOfIterations - iter);
+        if (_residualCheckInterval > 0) {
+            unsigned int nextCheck
+                = std::max(iter / _residualCheckInterval, 1u)
+                * _residualCheckInterval;
+            if (nextCheck < iter) {
+                nextCheck += _residualCheckInterval;
+            }
+            n = std::min(n, nextCheck - iter + 1);
+        }
+
+        if (n > 1) {
+            relaxBlocked(system, n, &_xTemp);
+        } else {
+            relax(system, &_xTemp);
+        }
 
         _xTemp.swap(system->x);
+        iter += n;
 
-        if (iter != 0 && iter % _residualCheckInterval == 0) {
+        unsigned int lastIter = iter - 1;
+        if (_residualCheckInterval > 0 && lastIter != 0
+            && lastIter % _residualCheckInterval == 0) {
             FdmBlas3::residual(system->A, system->x, system->b, &_residual);
 
             if (FdmBlas3::l2Norm(_residual) < _tolerance) {
-                _lastNumberOfIterations = iter + 1;
+                _lastNumberOfIterations = iter;
                 break;
             }
         }
@@ -61,6 +115,14 @@ double FdmJacobiSolver3::lastResidual() const {
     return _lastResidual;
 }
 
+unsigned int FdmJacobiSolver3::temporalBlockingDepth() const {
+    return _temporalBlockingDepth;
+}
+
+void FdmJacobiSolver3::setTemporalBlockingDepth(unsigned int depth) {
+    _temporalBlockingDepth = std::max(depth, 1u);
+}
+
 void FdmJacobiSolver3::relax(FdmLinearSystem3* system, FdmVector3* xTemp) {
     Size3 size = system->x.size();
     FdmMatrix3& A = system->A;
@@ -68,14 +130,104 @@ void FdmJacobiSolver3::relax(FdmLinearSystem3* system, FdmVector3* xTemp) {
     FdmVector3& b = system->b;
 
     A.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        double r
-            = ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k) : 0.0)
-            + ((i + 1 < size.x) ? A(i, j, k).right * x(i + 1, j, k) : 0.0)
-            + ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k) : 0.0)
-            + ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k) : 0.0)
-            + ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1) : 0.0)
-            + ((k + 1 < size.z) ? A(i, j, k).front * x(i, j, k + 1) : 0.0);
-
-        (*xTemp)(i, j, k) = (b(i, j, k) - r) / A(i, j, k).center;
+        (*xTemp)(i, j, k) = jacobiUpdate(A, b, size, x, i, j, k);
     });
 }
+
+void FdmJacobiSolver3::relaxBlocked(
+    FdmLinearSystem3* system,
+    unsigned int numberOfIterations,
+    FdmVector3* xTemp) {
+    Size3 size = system->x.size();
+    const FdmMatrix3& A = system->A;
+    const FdmVector3& x = system->x;
+    const FdmVector3& b = system->b;
+    const size_t n = numberOfIterations;
+
+    Size3 numberOfTiles(
+        (size.x + kTileSize - 1) / kTileSize,
+        (size.y + kTileSize - 1) / kTileSize,
+        (size.z + kTileSize - 1) / kTileSize);
+    size_t totalNumberOfTiles
+        = numberOfTiles.x * numberOfTiles.y * numberOfTiles.z;
+
+    parallelRangeFor(
+        kZeroSize,
+        totalNumberOfTiles,
+        [&](size_t beginTile, size_t endTile) {
+            // Local copies of the previous and the next iterates of a tile
+            // extended by n cells on each side, reused for the tiles of
+            // this range
+            std::vector<double> src, dst;
+
+            for (size_t tile = beginTile; tile < endTile; ++tile) {
+                Size3 tileIndex(
+                    tile % numberOfTiles.x,
+                    (tile / numberOfTiles.x) % numberOfTiles.y,
+                    tile / (numberOfTiles.x * numberOfTiles.y));
+                Size3 lower, upper, localLower, localUpper;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    lower[axis] = kTileSize * tileIndex[axis];
+                    upper[axis]
+                        = std::min(lower[axis] + kTileSize, size[axis]);
+                    localLower[axis]
+                        = (lower[axis] > n) ? lower[axis] - n : 0;
+                    localUpper[axis] = std::min(upper[axis] + n, size[axis]);
+                }
+                Size3 localSize(
+                    localUpper.x - localLower.x,
+                    localUpper.y - localLower.y,
+                    localUpper.z - localLower.z);
+                auto localIndex = [&](size_t i, size_t j, size_t k) {
+                    return (i - localLower.x) + localSize.x
+                        * ((j - localLower.y) + localSize.y
+                            * (k - localLower.z));
+                };
+
+                src.resize(localSize.x * localSize.y * localSize.z);
+                dst.resize(src.size());
+                for (size_t k = localLower.z; k < localUpper.z; ++k) {
+                    for (size_t j = localLower.y; j < localUpper.y; ++j) {
+                        for (size_t i = localLower.x; i < localUpper.x; ++i) {
+                            src[localIndex(i, j, k)] = x(i, j, k);
+                        }
+                    }
+                }
+
+                // Each iteration shrinks the region of the valid values by
+                // one cell on each side, except at the grid boundary
+                auto local = [&](size_t i, size_t j, size_t k) {
+                    return src[localIndex(i, j, k)];
+                };
+                for (size_t iter = 1; iter <= n; ++iter) {
+                    size_t margin = n - iter;
+                    Size3 begin, end;
+                    for (size_t axis = 0; axis < 3; ++axis) {
+                        begin[axis] = std::max(
+                            localLower[axis],
+                            (lower[axis] > margin) ? lower[axis] - margin : 0);
+                        end[axis] = std::min(
+                            upper[axis] + margin, localUpper[axis]);
+                    }
+
+                    for (size_t k = begin.z; k < end.z; ++k) {
+                        for (size_t j = begin.y; j < end.y; ++j) {
+                            for (size_t i = begin.x; i < end.x; ++i) {
+                                dst[localIndex(i, j, k)] = jacobiUpdate(
+                                    A, b, size, local, i, j, k);
+                            }
+                        }
+                    }
+                    src.swap(dst);
+                }
+
+                for (size_t k = lower.z; k < upper.z; ++k) {
+                    for (size_t j = lower.y; j < upper.y; ++j) {
+                        for (size_t i = lower.x; i < upper.x; ++i) {
+                            (*xTemp)(i, j, k) = src[localIndex(i, j, k)];
+                        }
+                    }
+                }
+            }
+        });
+}
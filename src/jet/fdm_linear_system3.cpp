@@ -1,124 +1,480 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <simd_helpers.h>
 #include <jet/fdm_linear_system3.h>
-#include <jet/math_utils.h>
-#include <jet/parallel.h>
+
+// The avx512f target allows the compiler to fuse a multiply and an add into
+// an FMA, which rounds once and breaks the match with the scalar code
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
 
 using namespace jet;
 
-void FdmBlas3::set(double s, FdmVector3* result) {
-    result->set(s);
+namespace {
+
+typedef internal::FdmStencilRow3T<double> FdmStencilRow3;
+
+static_assert(
+    sizeof(FdmMatrixRow3) == 4 * sizeof(double),
+    "The kernels load a matrix row as four packed doubles.");
+
+inline const double* rowData(const FdmMatrixRow3* row) {
+    return reinterpret_cast<const double*>(row);
 }
 
-void FdmBlas3::set(const FdmVector3& v, FdmVector3* result) {
-    result->set(v);
+template <bool IsResidual>
+inline double stencilValue(
+    const FdmStencilRow3& row, const double* b, size_t i) {
+    return IsResidual
+        ? internal::fdmStencilResidual3(row, b[i], i)
+        : internal::fdmStencilProduct3(row, i);
 }
 
-void FdmBlas3::set(double s, FdmMatrix3* result) {
-    FdmMatrixRow3 row;
-    row.center = row.right = row.up = row.front = s;
-    result->set(row);
+// The stencil kernels below vectorize the interior [1, n - 1) of the row, so
+// both neighbors along x exist, and add the terms in the order of
+// fdmStencilProduct3 without fused multiply-adds.
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 void axpySse2(
+    size_t n, double a, const double* x, const double* y, double* result) {
+    const __m128d va = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(
+            result + i,
+            _mm_add_pd(
+                _mm_mul_pd(va, _mm_loadu_pd(x + i)), _mm_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) {
+        result[i] = a * x[i] + y[i];
+    }
 }
 
-void FdmBlas3::set(const FdmMatrix3& m, FdmMatrix3* result) {
-    result->set(m);
+// Loads rows[0] and rows[1] as (center, right, up, front) pairs.
+JET_TARGET_SSE2 inline void loadRowsSse2(
+    const FdmMatrixRow3* rows, __m128d* fields) {
+    const double* data = rowData(rows);
+    __m128d lo0 = _mm_loadu_pd(data);
+    __m128d hi0 = _mm_loadu_pd(data + 2);
+    __m128d lo1 = _mm_loadu_pd(data + 4);
+    __m128d hi1 = _mm_loadu_pd(data + 6);
+    fields[0] = _mm_unpacklo_pd(lo0, lo1);
+    fields[1] = _mm_unpackhi_pd(lo0, lo1);
+    fields[2] = _mm_unpacklo_pd(hi0, hi1);
+    fields[3] = _mm_unpackhi_pd(hi0, hi1);
 }
 
-double FdmBlas3::dot(const FdmVector3& a, const FdmVector3& b) {
-    Size3 size = a.size();
+template <bool IsResidual>
+JET_TARGET_SSE2 inline __m128d accumulateSse2(__m128d value, __m128d term) {
+    return IsResidual ? _mm_sub_pd(value, term) : _mm_add_pd(value, term);
+}
 
-    JET_THROW_INVALID_ARG_IF(size != b.size());
+template <bool IsResidual>
+JET_TARGET_SSE2 void stencilRowSse2(
+    const FdmStencilRow3& row, const double* b, double* result) {
+    const size_t n = row.size;
+    if (n == 0) {
+        return;
+    }
 
-    double result = 0.0;
+    result[0] = stencilValue<IsResidual>(row, b, 0);
+    size_t i = 1;
+    __m128d prevRight = _mm_set1_pd(row.a[0].right);
+    for (; i + 2 < n; i += 2) {
+        __m128d m[4], neighbor[4];
+        loadRowsSse2(row.a + i, m);
 
-    for (size_t k = 0; k < size.z; ++k) {
-        for (size_t j = 0; j < size.y; ++j) {
-            for (size_t i = 0; i < size.x; ++i) {
-                result += a(i, j, k) * b(i, j, k);
-            }
+        // (right[i - 1], right[i])
+        __m128d leftRight = _mm_shuffle_pd(prevRight, m[1], 1);
+        prevRight = m[1];
+
+        __m128d value = _mm_mul_pd(m[0], _mm_loadu_pd(row.x + i));
+        if (IsResidual) {
+            value = _mm_sub_pd(_mm_loadu_pd(b + i), value);
+        }
+        value = accumulateSse2<IsResidual>(
+            value, _mm_mul_pd(leftRight, _mm_loadu_pd(row.x + i - 1)));
+        value = accumulateSse2<IsResidual>(
+            value, _mm_mul_pd(m[1], _mm_loadu_pd(row.x + i + 1)));
+        if (row.xDown != nullptr) {
+            loadRowsSse2(row.aDown + i, neighbor);
+            value = accumulateSse2<IsResidual>(
+                value, _mm_mul_pd(neighbor[2], _mm_loadu_pd(row.xDown + i)));
+        }
+        if (row.xUp != nullptr) {
+            value = accumulateSse2<IsResidual>(
+                value, _mm_mul_pd(m[2], _mm_loadu_pd(row.xUp + i)));
+        }
+        if (row.xBack != nullptr) {
+            loadRowsSse2(row.aBack + i, neighbor);
+            value = accumulateSse2<IsResidual>(
+                value, _mm_mul_pd(neighbor[3], _mm_loadu_pd(row.xBack + i)));
+        }
+        if (row.xFront != nullptr) {
+            value = accumulateSse2<IsResidual>(
+                value, _mm_mul_pd(m[3], _mm_loadu_pd(row.xFront + i)));
         }
+
+        _mm_storeu_pd(result + i, value);
+    }
+    for (; i < n; ++i) {
+        result[i] = stencilValue<IsResidual>(row, b, i);
     }
+}
 
-    return result;
+JET_TARGET_AVX void axpyAvx(
+    size_t n, double a, const double* x, const double* y, double* result) {
+    const __m256d va = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(
+            result + i,
+            _mm256_add_pd(
+                _mm256_mul_pd(va, _mm256_loadu_pd(x + i)),
+                _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) {
+        result[i] = a * x[i] + y[i];
+    }
 }
 
-void FdmBlas3::axpy(
-    double a,
-    const FdmVector3& x,
-    const FdmVector3& y,
-    FdmVector3* result) {
-    Size3 size = x.size();
+// Loads rows[0..3] and transposes them into (center, right, up, front).
+JET_TARGET_AVX inline void loadRowsAvx(
+    const FdmMatrixRow3* rows, __m256d* fields) {
+    const double* data = rowData(rows);
+    __m256d r0 = _mm256_loadu_pd(data);
+    __m256d r1 = _mm256_loadu_pd(data + 4);
+    __m256d r2 = _mm256_loadu_pd(data + 8);
+    __m256d r3 = _mm256_loadu_pd(data + 12);
 
-    JET_THROW_INVALID_ARG_IF(size != y.size());
-    JET_THROW_INVALID_ARG_IF(size != result->size());
+    // (c0, c1, u0, u1), (r0, r1, f0, f1), ...
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    fields[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+    fields[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+    fields[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+    fields[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
 
-    x.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        (*result)(i, j, k) = a * x(i, j, k) + y(i, j, k);
-    });
+template <bool IsResidual>
+JET_TARGET_AVX inline __m256d accumulateAvx(__m256d value, __m256d term) {
+    return IsResidual
+        ? _mm256_sub_pd(value, term) : _mm256_add_pd(value, term);
 }
 
-void FdmBlas3::mvm(
-    const FdmMatrix3& m,
-    const FdmVector3& v,
-    FdmVector3* result) {
-    Size3 size = m.size();
+template <bool IsResidual>
+JET_TARGET_AVX void stencilRowAvx(
+    const FdmStencilRow3& row, const double* b, double* result) {
+    const size_t n = row.size;
+    if (n == 0) {
+        return;
+    }
+
+    result[0] = stencilValue<IsResidual>(row, b, 0);
+    size_t i = 1;
+    __m256d prevRight = _mm256_set1_pd(row.a[0].right);
+    for (; i + 4 < n; i += 4) {
+        __m256d m[4], neighbor[4];
+        loadRowsAvx(row.a + i, m);
 
-    JET_THROW_INVALID_ARG_IF(size != v.size());
-    JET_THROW_INVALID_ARG_IF(size != result->size());
+        // (right[i - 1], ..., right[i + 2])
+        __m256d leftRight = _mm256_shuffle_pd(
+            _mm256_permute2f128_pd(prevRight, m[1], 0x21), m[1], 0x5);
+        prevRight = m[1];
 
-    m.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        (*result)(i, j, k)
-            = m(i, j, k).center * v(i, j, k)
-            + ((i > 0) ? m(i - 1, j, k).right * v(i - 1, j, k) : 0.0)
-            + ((i + 1 < size.x) ? m(i, j, k).right * v(i + 1, j, k) : 0.0)
-            + ((j > 0) ? m(i, j - 1, k).up * v(i, j - 1, k) : 0.0)
-            + ((j + 1 < size.y) ? m(i, j, k).up * v(i, j + 1, k) : 0.0)
-            + ((k > 0) ? m(i, j, k - 1).front * v(i, j, k - 1) : 0.0)
-            + ((k + 1 < size.z) ? m(i, j, k).front * v(i, j, k + 1) : 0.0);
-    });
+        __m256d value = _mm256_mul_pd(m[0], _mm256_loadu_pd(row.x + i));
+        if (IsResidual) {
+            value = _mm256_sub_pd(_mm256_loadu_pd(b + i), value);
+        }
+        value = accumulateAvx<IsResidual>(
+            value, _mm256_mul_pd(leftRight, _mm256_loadu_pd(row.x + i - 1)));
+        value = accumulateAvx<IsResidual>(
+            value, _mm256_mul_pd(m[1], _mm256_loadu_pd(row.x + i + 1)));
+        if (row.xDown != nullptr) {
+            loadRowsAvx(row.aDown + i, neighbor);
+            value = accumulateAvx<IsResidual>(
+                value,
+                _mm256_mul_pd(neighbor[2], _mm256_loadu_pd(row.xDown + i)));
+        }
+        if (row.xUp != nullptr) {
+            value = accumulateAvx<IsResidual>(
+                value, _mm256_mul_pd(m[2], _mm256_loadu_pd(row.xUp + i)));
+        }
+        if (row.xBack != nullptr) {
+            loadRowsAvx(row.aBack + i, neighbor);
+            value = accumulateAvx<IsResidual>(
+                value,
+                _mm256_mul_pd(neighbor[3], _mm256_loadu_pd(row.xBack + i)));
+        }
+        if (row.xFront != nullptr) {
+            value = accumulateAvx<IsResidual>(
+                value, _mm256_mul_pd(m[3], _mm256_loadu_pd(row.xFront + i)));
+        }
+
+        _mm256_storeu_pd(result + i, value);
+    }
+    for (; i < n; ++i) {
+        result[i] = stencilValue<IsResidual>(row, b, i);
+    }
 }
 
-void FdmBlas3::residual(
-    const FdmMatrix3& a,
-    const FdmVector3& x,
-    const FdmVector3& b,
-    FdmVector3* result) {
-    Size3 size = a.size();
+JET_TARGET_AVX512 void axpyAvx512(
+    size_t n, double a, const double* x, const double* y, double* result) {
+    const __m512d va = _mm512_set1_pd(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(
+            result + i,
+            _mm512_add_pd(
+                _mm512_mul_pd(va, _mm512_loadu_pd(x + i)),
+                _mm512_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) {
+        result[i] = a * x[i] + y[i];
+    }
+}
 
-    JET_THROW_INVALID_ARG_IF(size != x.size());
-    JET_THROW_INVALID_ARG_IF(size != b.size());
-    JET_THROW_INVALID_ARG_IF(size != result->size());
+// Loads rows[0..7] and transposes them into (center, right, up, front).
+JET_TARGET_AVX512 inline void loadRowsAvx512(
+    const FdmMatrixRow3* rows, __m512d* fields) {
+    const double* data = rowData(rows);
+    __m512d r01 = _mm512_loadu_pd(data);
+    __m512d r23 = _mm512_loadu_pd(data + 8);
+    __m512d r45 = _mm512_loadu_pd(data + 16);
+    __m512d r67 = _mm512_loadu_pd(data + 24);
 
-    a.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        (*result)(i, j, k)
-            = b(i, j, k)
-            - a(i, j, k).center * x(i, j, k)
-            - ((i > 0) ? a(i - 1, j, k).right * x(i - 1, j, k) : 0.0)
-            - ((i + 1 < size.x) ? a(i, j, k).right * x(i + 1, j, k) : 0.0)
-            - ((j > 0) ? a(i, j - 1, k).up * x(i, j - 1, k) : 0.0)
-            - ((j + 1 < size.y) ? a(i, j, k).up * x(i, j + 1, k) : 0.0)
-            - ((k > 0) ? a(i, j, k - 1).front * x(i, j, k - 1) : 0.0)
-            - ((k + 1 < size.z) ? a(i, j, k).front * x(i, j, k + 1) : 0.0);
-    });
+    // (c0, c1, c2, c3, u0, u1, u2, u3) and (r0, ..., r3, f0, ..., f3)
+    const __m512i evens = _mm512_set_epi64(14, 10, 6, 2, 12, 8, 4, 0);
+    const __m512i odds = _mm512_set_epi64(15, 11, 7, 3, 13, 9, 5, 1);
+    __m512d cu03 = _mm512_permutex2var_pd(r01, evens, r23);
+    __m512d rf03 = _mm512_permutex2var_pd(r01, odds, r23);
+    __m512d cu47 = _mm512_permutex2var_pd(r45, evens, r67);
+    __m512d rf47 = _mm512_permutex2var_pd(r45, odds, r67);
+
+    const __m512i lows = _mm512_set_epi64(11, 10, 9, 8, 3, 2, 1, 0);
+    const __m512i highs = _mm512_set_epi64(15, 14, 13, 12, 7, 6, 5, 4);
+    fields[0] = _mm512_permutex2var_pd(cu03, lows, cu47);
+    fields[1] = _mm512_permutex2var_pd(rf03, lows, rf47);
+    fields[2] = _mm512_permutex2var_pd(cu03, highs, cu47);
+    fields[3] = _mm512_permutex2var_pd(rf03, highs, rf47);
 }
 
-double FdmBlas3::l2Norm(const FdmVector3& v) {
-    return std::sqrt(dot(v, v));
+template <bool IsResidual>
+JET_TARGET_AVX512 inline __m512d accumulateAvx512(
+    __m512d value, __m512d term) {
+    return IsResidual
+        ? _mm512_sub_pd(value, term) : _mm512_add_pd(value, term);
 }
 
-double FdmBlas3::lInfNorm(const FdmVector3& v) {
-    Size3 size = v.size();
+template <bool IsResidual>
+JET_TARGET_AVX512 void stencilRowAvx512(
+    const FdmStencilRow3& row, const double* b, double* result) {
+    const size_t n = row.size;
+    if (n == 0) {
+        return;
+    }
+
+    result[0] = stencilValue<IsResidual>(row, b, 0);
+    size_t i = 1;
+    const __m512i shiftByOne = _mm512_set_epi64(14, 13, 12, 11, 10, 9, 8, 7);
+    __m512d prevRight = _mm512_set1_pd(row.a[0].right);
+    for (; i + 8 < n; i += 8) {
+        __m512d m[4], neighbor[4];
+        loadRowsAvx512(row.a + i, m);
 
-    double result = 0.0;
+        // (right[i - 1], ..., right[i + 6])
+        __m512d leftRight
+            = _mm512_permutex2var_pd(prevRight, shiftByOne, m[1]);
+        prevRight = m[1];
 
-    for (size_t k = 0; k < size.z; ++k) {
-        for (size_t j = 0; j < size.y; ++j) {
-            for (size_t i = 0; i < size.x; ++i) {
-                result = absmax(result, v(i, j, k));
-            }
+        __m512d value = _mm512_mul_pd(m[0], _mm512_loadu_pd(row.x + i));
+        if (IsResidual) {
+            value = _mm512_sub_pd(_mm512_loadu_pd(b + i), value);
+        }
+        value = accumulateAvx512<IsResidual>(
+            value, _mm512_mul_pd(leftRight, _mm512_loadu_pd(row.x + i - 1)));
+        value = accumulateAvx512<IsResidual>(
+            value, _mm512_mul_pd(m[1], _mm512_loadu_pd(row.x + i + 1)));
+        if (row.xDown != nullptr) {
+            loadRowsAvx512(row.aDown + i, neighbor);
+            value = accumulateAvx512<IsResidual>(
+                value,
+                _mm512_mul_pd(neighbor[2], _mm512_loadu_pd(row.xDown + i)));
+        }
+        if (row.xUp != nullptr) {
+            value = accumulateAvx512<IsResidual>(
+                value, _mm512_mul_pd(m[2], _mm512_loadu_pd(row.xUp + i)));
+        }
+        if (row.xBack != nullptr) {
+            loadRowsAvx512(row.aBack + i, neighbor);
+            value = accumulateAvx512<IsResidual>(
+                value,
+                _mm512_mul_pd(neighbor[3], _mm512_loadu_pd(row.xBack + i)));
         }
+        if (row.xFront != nullptr) {
+            value = accumulateAvx512<IsResidual>(
+                value, _mm512_mul_pd(m[3], _mm512_loadu_pd(row.xFront + i)));
+        }
+
+        _mm512_storeu_pd(result + i, value);
+    }
+    for (; i < n; ++i) {
+        result[i] = stencilValue<IsResidual>(row, b, i);
+    }
+}
+
+#elif defined(JET_SIMD_NEON)
+
+void axpyNeon(
+    size_t n, double a, const double* x, const double* y, double* result) {
+    const float64x2_t va = vdupq_n_f64(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(
+            result + i,
+            vaddq_f64(vmulq_f64(va, vld1q_f64(x + i)), vld1q_f64(y + i)));
+    }
+    for (; i < n; ++i) {
+        result[i] = a * x[i] + y[i];
+    }
+}
+
+// Loads rows[0] and rows[1] as (center, right, up, front) pairs.
+inline float64x2x4_t loadRowsNeon(const FdmMatrixRow3* rows) {
+    return vld4q_f64(rowData(rows));
+}
+
+template <bool IsResidual>
+inline float64x2_t accumulateNeon(float64x2_t value, float64x2_t term) {
+    return IsResidual ? vsubq_f64(value, term) : vaddq_f64(value, term);
+}
+
+template <bool IsResidual>
+void stencilRowNeon(
+    const FdmStencilRow3& row, const double* b, double* result) {
+    const size_t n = row.size;
+    if (n == 0) {
+        return;
+    }
+
+    result[0] = stencilValue<IsResidual>(row, b, 0);
+    size_t i = 1;
+    float64x2_t prevRight = vdupq_n_f64(row.a[0].right);
+    for (; i + 2 < n; i += 2) {
+        float64x2x4_t m = loadRowsNeon(row.a + i);
+
+        // (right[i - 1], right[i])
+        float64x2_t leftRight = vextq_f64(prevRight, m.val[1], 1);
+        prevRight = m.val[1];
+
+        float64x2_t value = vmulq_f64(m.val[0], vld1q_f64(row.x + i));
+        if (IsResidual) {
+            value = vsubq_f64(vld1q_f64(b + i), value);
+        }
+        value = accumulateNeon<IsResidual>(
+            value, vmulq_f64(leftRight, vld1q_f64(row.x + i - 1)));
+        value = accumulateNeon<IsResidual>(
+            value, vmulq_f64(m.val[1], vld1q_f64(row.x + i + 1)));
+        if (row.xDown != nullptr) {
+            float64x2x4_t down = loadRowsNeon(row.aDown + i);
+            value = accumulateNeon<IsResidual>(
+                value, vmulq_f64(down.val[2], vld1q_f64(row.xDown + i)));
+        }
+        if (row.xUp != nullptr) {
+            value = accumulateNeon<IsResidual>(
+                value, vmulq_f64(m.val[2], vld1q_f64(row.xUp + i)));
+        }
+        if (row.xBack != nullptr) {
+            float64x2x4_t back = loadRowsNeon(row.aBack + i);
+            value = accumulateNeon<IsResidual>(
+                value, vmulq_f64(back.val[3], vld1q_f64(row.xBack + i)));
+        }
+        if (row.xFront != nullptr) {
+            value = accumulateNeon<IsResidual>(
+                value, vmulq_f64(m.val[3], vld1q_f64(row.xFront + i)));
+        }
+
+        vst1q_f64(result + i, value);
+    }
+    for (; i < n; ++i) {
+        result[i] = stencilValue<IsResidual>(row, b, i);
     }
+}
 
-    return std::fabs(result);
+#endif
+
+template <bool IsResidual>
+void stencilRow(const FdmStencilRow3& row, const double* b, double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+            stencilRowAvx512<IsResidual>(row, b, result);
+            return;
+        case SimdInstructionSet::Avx:
+            stencilRowAvx<IsResidual>(row, b, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            stencilRowSse2<IsResidual>(row, b, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            stencilRowNeon<IsResidual>(row, b, result);
+            return;
+#endif
+        default:
+            for (size_t i = 0; i < row.size; ++i) {
+                result[i] = stencilValue<IsResidual>(row, b, i);
+            }
+            return;
+    }
 }
+
+}  // namespace
+
+namespace jet {
+
+namespace internal {
+
+void fdmAxpyRow(
+    size_t n, double a, const double* x, const double* y, double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+            axpyAvx512(n, a, x, y, result);
+            return;
+        case SimdInstructionSet::Avx:
+            axpyAvx(n, a, x, y, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            axpySse2(n, a, x, y, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            axpyNeon(n, a, x, y, result);
+            return;
+#endif
+        default:
+            fdmAxpyRow<double>(n, a, x, y, result);
+            return;
+    }
+}
+
+void fdmMvmRow3(const FdmStencilRow3T<double>& row, double* result) {
+    stencilRow<false>(row, nullptr, result);
+}
+
+void fdmResidualRow3(
+    const FdmStencilRow3T<double>& row, const double* b, double* result) {
+    stencilRow<true>(row, b, result);
+}
+
+}  // namespace internal
+
+}  // namespace jet
@@ -0,0 +1,16 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/fdm_linear_system_solver2.h>
+
+using namespace jet;
+
+bool FdmLinearSystemSolver2::solveCompressed(
+    FdmCompressedLinearSystem* system) {
+    UNUSED_VARIABLE(system);
+    return false;
+}
+
+bool FdmLinearSystemSolver2::isCompressedSystemSupported() const {
+    return false;
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/fdm_linear_system_solver3.h>
+
+using namespace jet;
+
+bool FdmLinearSystemSolver3::solveWithSameMatrix(FdmLinearSystem3* system) {
+    return solve(system);
+}
+
+double FdmLinearSystemSolver3::lastResidual() const {
+    return 0.0;
+}
+
+bool FdmLinearSystemSolver3::solveCompressed(
+    FdmCompressedLinearSystem* system) {
+    UNUSED_VARIABLE(system);
+    return false;
+}
+
+bool FdmLinearSystemSolver3::isCompressedSystemSupported() const {
+    return false;
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/cg.h>
+#include <jet/fdm_matrix_free_cg_solver2.h>
+
+using namespace jet;
+
+namespace {
+
+void invert(FdmVector2* diagonal) {
+    diagonal->parallelForEachIndex([&](size_t i, size_t j) {
+        double& d = (*diagonal)(i, j);
+        d = (std::fabs(d) > 0.0) ? 1.0 / d : 0.0;
+    });
+}
+
+}  // namespace
+
+void FdmMatrixFreeCgSolver2::Preconditioner::build(const FdmMatrix2& matrix) {
+    invDiagonal.resize(matrix.size());
+    matrix.parallelForEachIndex([&](size_t i, size_t j) {
+        invDiagonal(i, j) = matrix(i, j).center;
+    });
+    invert(&invDiagonal);
+}
+
+void FdmMatrixFreeCgSolver2::Preconditioner::build(
+    const FdmMatrixFreeOperator2& A) {
+    invDiagonal.resize(A.size());
+    A.diagonal(&invDiagonal);
+    invert(&invDiagonal);
+}
+
+void FdmMatrixFreeCgSolver2::Preconditioner::solve(
+    const FdmVector2& b,
+    FdmVector2* x) {
+    x->parallelForEachIndex([&](size_t i, size_t j) {
+        (*x)(i, j) = invDiagonal(i, j) * b(i, j);
+    });
+}
+
+FdmMatrixFreeCgSolver2::FdmMatrixFreeCgSolver2(
+    unsigned int maxNumberOfIterations, double tolerance) :
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _tolerance(tolerance),
+    _lastResidual(kMaxD) {
+}
+
+bool FdmMatrixFreeCgSolver2::solve(FdmLinearSystem2* system) {
+    FdmMatrix2& matrix = system->A;
+    FdmVector2& solution = system->x;
+    FdmVector2& rhs = system->b;
+
+    JET_ASSERT(matrix.size() == rhs.size());
+    JET_ASSERT(matrix.size() == solution.size());
+
+    resizeTemporaries(matrix.size());
+    solution.set(0.0);
+
+    pcg<FdmBlas2, Preconditioner>(
+        matrix,
+        rhs,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precond,
+        &solution,
+        &_r,
+        &_d,
+        &_q,
+        &_s,
+        &_lastNumberOfIterations,
+        &_lastResidual);
+
+    JET_INFO << "Residual after solving matrix-free CG: " << _lastResidual
+             << " Number of matrix-free CG iterations: "
+             << _lastNumberOfIterations;
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmMatrixFreeCgSolver2::solve(
+    const FdmMatrixFreeOperator2& A,
+    const FdmVector2& b,
+    FdmVector2* x) {
+    JET_ASSERT(A.size() == b.size());
+
+    resizeTemporaries(A.size());
+    x->resize(A.size());
+    x->set(0.0);
+
+    pcg<FdmMatrixFreeBlas2, Preconditioner>(
+        A,
+        b,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precond,
+        x,
+        &_r,
+        &_d,
+        &_q,
+        &_s,
+        &_lastNumberOfIterations,
+        &_lastResidual);
+
+    JET_INFO << "Residual after solving matrix-free CG: " << _lastResidual
+             << " Number of matrix-free CG iterations: "
+             << _lastNumberOfIterations;
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+unsigned int FdmMatrixFreeCgSolver2::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmMatrixFreeCgSolver2::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmMatrixFreeCgSolver2::tolerance() const {
+    return _tolerance;
+}
+
+double FdmMatrixFreeCgSolver2::lastResidual() const {
+    return _lastResidual;
+}
+
+void FdmMatrixFreeCgSolver2::resizeTemporaries(const Size2& size) {
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+    _s.resize(size);
+    _r.set(0.0);
+    _d.set(0.0);
+    _q.set(0.0);
+    _s.set(0.0);
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/cg.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
+
+using namespace jet;
+
+namespace {
+
+void invert(FdmVector3* diagonal) {
+    diagonal->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        double& d = (*diagonal)(i, j, k);
+        d = (std::fabs(d) > 0.0) ? 1.0 / d : 0.0;
+    });
+}
+
+}  // namespace
+
+void FdmMatrixFreeCgSolver3::Preconditioner::build(const FdmMatrix3& matrix) {
+    invDiagonal.resize(matrix.size());
+    matrix.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        invDiagonal(i, j, k) = matrix(i, j, k).center;
+    });
+    invert(&invDiagonal);
+}
+
+void FdmMatrixFreeCgSolver3::Preconditioner::build(
+    const FdmMatrixFreeOperator3& A) {
+    invDiagonal.resize(A.size());
+    A.diagonal(&invDiagonal);
+    invert(&invDiagonal);
+}
+
+void FdmMatrixFreeCgSolver3::Preconditioner::solve(
+    const FdmVector3& b,
+    FdmVector3* x) {
+    x->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*x)(i, j, k) = invDiagonal(i, j, k) * b(i, j, k);
+    });
+}
+
+FdmMatrixFreeCgSolver3::FdmMatrixFreeCgSolver3(
+    unsigned int maxNumberOfIterations, double tolerance) :
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _tolerance(tolerance),
+    _lastResidual(kMaxD) {
+}
+
+bool FdmMatrixFreeCgSolver3::solve(FdmLinearSystem3* system) {
+    FdmMatrix3& matrix = system->A;
+    FdmVector3& solution = system->x;
+    FdmVector3& rhs = system->b;
+
+    JET_ASSERT(matrix.size() == rhs.size());
+    JET_ASSERT(matrix.size() == solution.size());
+
+    resizeTemporaries(matrix.size());
+    solution.set(0.0);
+
+    pcg<FdmBlas3, Preconditioner>(
+        matrix,
+        rhs,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precond,
+        &solution,
+        &_r,
+        &_d,
+        &_q,
+        &_s,
+        &_lastNumberOfIterations,
+        &_lastResidual);
+
+    JET_INFO << "Residual after solving matrix-free CG: " << _lastResidual
+             << " Number of matrix-free CG iterations: "
+             << _lastNumberOfIterations;
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmMatrixFreeCgSolver3::solve(
+    const FdmMatrixFreeOperator3& A,
+    const FdmVector3& b,
+    FdmVector3* x) {
+    JET_ASSERT(A.size() == b.size());
+
+    resizeTemporaries(A.size());
+    x->resize(A.size());
+    x->set(0.0);
+
+    pcg<FdmMatrixFreeBlas3, Preconditioner>(
+        A,
+        b,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precond,
+        x,
+        &_r,
+        &_d,
+        &_q,
+        &_s,
+        &_lastNumberOfIterations,
+        &_lastResidual);
+
+    JET_INFO << "Residual after solving matrix-free CG: " << _lastResidual
+             << " Number of matrix-free CG iterations: "
+             << _lastNumberOfIterations;
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+unsigned int FdmMatrixFreeCgSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmMatrixFreeCgSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmMatrixFreeCgSolver3::tolerance() const {
+    return _tolerance;
+}
+
+double FdmMatrixFreeCgSolver3::lastResidual() const {
+    return _lastResidual;
+}
+
+void FdmMatrixFreeCgSolver3::resizeTemporaries(const Size3& size) {
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+    _s.resize(size);
+    _r.set(0.0);
+    _d.set(0.0);
+    _q.set(0.0);
+    _s.set(0.0);
+}
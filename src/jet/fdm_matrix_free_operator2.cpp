@@ -0,0 +1,39 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/fdm_matrix_free_operator2.h>
+
+using namespace jet;
+
+FdmMatrixFreeOperator2::~FdmMatrixFreeOperator2() {
+}
+
+void FdmMatrixFreeBlas2::mvm(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    JET_THROW_INVALID_ARG_IF(m.size() != v.size());
+    JET_THROW_INVALID_ARG_IF(m.size() != result->size());
+
+    m.mvm(v, result);
+}
+
+double FdmMatrixFreeBlas2::mvmAndDot(
+    const MatrixType& m,
+    const VectorType& v,
+    VectorType* result) {
+    mvm(m, v, result);
+    return dot(v, *result);
+}
+
+void FdmMatrixFreeBlas2::residual(
+    const MatrixType& a,
+    const VectorType& x,
+    const VectorType& b,
+    VectorType* result) {
+    JET_THROW_INVALID_ARG_IF(a.size() != b.size());
+
+    // result = b - Ax
+    mvm(a, x, result);
+    axpy(-1.0, *result, b, result);
+}
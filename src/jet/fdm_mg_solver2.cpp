@@ -0,0 +1,274 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/fdm_mg_solver2.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+
+using namespace jet;
+
+namespace {
+
+// Scale of the coarse correction when used as a preconditioner. Aggregation
+// makes the Galerkin coarse operator about twice as stiff as the
+// rediscretized one, which is compensated by over-correcting. Any value below
+// 2 keeps the V-cycle positive definite.
+const double kOverCorrection = 1.8;
+
+// Updates the cells of the given color ((i + j) % 2 == color). Cells of the
+// same color do not couple with each other in the 5-point stencil, so every
+// row can be relaxed in parallel.
+void relaxColor(
+    const FdmMatrix2& A,
+    const FdmVector2& b,
+    size_t color,
+    FdmVector2* x_) {
+    Size2 size = A.size();
+    FdmVector2& x = *x_;
+
+    parallelFor(kZeroSize, size.y, [&](size_t j) {
+        for (size_t i = (j + color) % 2; i < size.x; i += 2) {
+            double r
+                = ((i > 0) ? A(i - 1, j).right * x(i - 1, j) : 0.0)
+                + ((i + 1 < size.x) ? A(i, j).right * x(i + 1, j) : 0.0)
+                + ((j > 0) ? A(i, j - 1).up * x(i, j - 1) : 0.0)
+                + ((j + 1 < size.y) ? A(i, j).up * x(i, j + 1) : 0.0);
+
+            double center = A(i, j).center;
+            if (std::fabs(center) > 0.0) {
+                x(i, j) = (b(i, j) - r) / center;
+            }
+        }
+    });
+}
+
+// Red-black Gauss-Seidel sweeps. The reversed color order is used for the
+// post-smoothing so that a V-cycle stays symmetric.
+void relax(
+    const FdmMatrix2& A,
+    const FdmVector2& b,
+    unsigned int numberOfIterations,
+    bool reverse,
+    FdmVector2* x) {
+    size_t first = reverse ? 1 : 0;
+    for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
+        relaxColor(A, b, first, x);
+        relaxColor(A, b, 1 - first, x);
+    }
+}
+
+Size2 coarseSize(const Size2& size) {
+    return Size2((size.x + 1) / 2, (size.y + 1) / 2);
+}
+
+// Galerkin coarsening (P^T A P) with piecewise-constant prolongation. The
+// couplings crossing the edges of a 2x2 block become the coarse couplings,
+// and the couplings inside a block add to the coarse diagonal.
+void coarsen(const FdmMatrix2& fine, FdmMatrix2* coarse_) {
+    Size2 size = fine.size();
+    FdmMatrix2& coarse = *coarse_;
+    coarse.resize(coarseSize(size));
+
+    coarse.parallelForEachIndex([&](size_t ci, size_t cj) {
+        FdmMatrixRow2 row;
+        size_t iEnd = std::min(2 * ci + 2, size.x);
+        size_t jEnd = std::min(2 * cj + 2, size.y);
+
+        for (size_t j = 2 * cj; j < jEnd; ++j) {
+            for (size_t i = 2 * ci; i < iEnd; ++i) {
+                const FdmMatrixRow2& f = fine(i, j);
+                row.center += f.center;
+
+                if (i + 1 < iEnd) {
+                    row.center += 2.0 * f.right;
+                } else if (i + 1 < size.x) {
+                    row.right += f.right;
+                }
+
+                if (j + 1 < jEnd) {
+                    row.center += 2.0 * f.up;
+                } else if (j + 1 < size.y) {
+                    row.up += f.up;
+                }
+            }
+        }
+
+        coarse(ci, cj) = row;
+    });
+}
+
+// Sums the fine residual over each 2x2 block (P^T).
+void restrictResidual(const FdmVector2& fine, FdmVector2* coarse_) {
+    Size2 size = fine.size();
+    FdmVector2& coarse = *coarse_;
+
+    coarse.parallelForEachIndex([&](size_t ci, size_t cj) {
+        size_t iEnd = std::min(2 * ci + 2, size.x);
+        size_t jEnd = std::min(2 * cj + 2, size.y);
+
+        double sum = 0.0;
+        for (size_t j = 2 * cj; j < jEnd; ++j) {
+            for (size_t i = 2 * ci; i < iEnd; ++i) {
+                sum += fine(i, j);
+            }
+        }
+
+        coarse(ci, cj) = sum;
+    });
+}
+
+// Adds the scaled coarse correction to every fine cell of its block (P).
+void correct(const FdmVector2& coarse, double scale, FdmVector2* fine) {
+    fine->parallelForEachIndex([&](size_t i, size_t j) {
+        (*fine)(i, j) += scale * coarse(i / 2, j / 2);
+    });
+}
+
+}  // namespace
+
+FdmMgSolver2::FdmMgSolver2(
+    unsigned int maxNumberOfLevels,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    unsigned int numberOfSmoothingIterations,
+    unsigned int numberOfCoarsestIterations) :
+    _maxNumberOfLevels(std::max(maxNumberOfLevels, 1u)),
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _numberOfSmoothingIterations(numberOfSmoothingIterations),
+    _numberOfCoarsestIterations(numberOfCoarsestIterations),
+    _tolerance(tolerance),
+    _lastResidual(kMaxD) {
+}
+
+bool FdmMgSolver2::solve(FdmLinearSystem2* system) {
+    JET_ASSERT(system->A.size() == system->b.size());
+    JET_ASSERT(system->A.size() == system->x.size());
+
+    build(system->A);
+
+    FdmVector2& residual = _residuals.front();
+
+    _lastNumberOfIterations = _maxNumberOfIterations;
+
+    for (unsigned int iter = 0; iter < _maxNumberOfIterations; ++iter) {
+        vCycle(0, system->A, system->b, &system->x, false);
+
+        FdmBlas2::residual(system->A, system->x, system->b, &residual);
+
+        if (FdmBlas2::l2Norm(residual) < _tolerance) {
+            _lastNumberOfIterations = iter + 1;
+            break;
+        }
+    }
+
+    FdmBlas2::residual(system->A, system->x, system->b, &residual);
+    _lastResidual = FdmBlas2::l2Norm(residual);
+
+    JET_INFO << "Residual norm after solving MG: " << _lastResidual
+             << " Number of V-cycles: " << _lastNumberOfIterations;
+
+    return _lastResidual < _tolerance;
+}
+
+void FdmMgSolver2::build(const FdmMatrix2& matrix) {
+    _matrix = &matrix;
+
+    // Level 0 is the given matrix itself, so only the coarse levels are
+    // stored. Coarsening stops when the grid is reduced to a single cell.
+    unsigned int numberOfCoarseLevels = 0;
+    Size2 size = matrix.size();
+    while (numberOfCoarseLevels + 1 < _maxNumberOfLevels
+        && size != Size2(1, 1)) {
+        size = coarseSize(size);
+        ++numberOfCoarseLevels;
+    }
+
+    _coarseLevels.resize(numberOfCoarseLevels);
+    _residuals.resize(numberOfCoarseLevels + 1);
+
+    const FdmMatrix2* fine = &matrix;
+    for (size_t l = 0; l < _coarseLevels.size(); ++l) {
+        Level& level = _coarseLevels[l];
+        coarsen(*fine, &level.A);
+        level.x.resize(level.A.size());
+        level.b.resize(level.A.size());
+        fine = &level.A;
+    }
+
+    _residuals[0].resize(matrix.size());
+    for (size_t l = 0; l < _coarseLevels.size(); ++l) {
+        _residuals[l + 1].resize(_coarseLevels[l].A.size());
+    }
+}
+
+void FdmMgSolver2::solve(const FdmVector2& b, FdmVector2* x) {
+    JET_ASSERT(_matrix != nullptr);
+
+    x->set(0.0);
+    vCycle(0, *_matrix, b, x, true);
+}
+
+unsigned int FdmMgSolver2::maxNumberOfLevels() const {
+    return _maxNumberOfLevels;
+}
+
+unsigned int FdmMgSolver2::numberOfLevels() const {
+    return static_cast<unsigned int>(_coarseLevels.size()) + 1;
+}
+
+unsigned int FdmMgSolver2::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmMgSolver2::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmMgSolver2::tolerance() const {
+    return _tolerance;
+}
+
+double FdmMgSolver2::lastResidual() const {
+    return _lastResidual;
+}
+
+void FdmMgSolver2::vCycle(
+    size_t level,
+    const FdmMatrix2& A,
+    const FdmVector2& b,
+    FdmVector2* x,
+    bool isPreconditioning) {
+    if (level == _coarseLevels.size()) {
+        relax(A, b, _numberOfCoarsestIterations, false, x);
+        relax(A, b, _numberOfCoarsestIterations, true, x);
+        return;
+    }
+
+    relax(A, b, _numberOfSmoothingIterations, false, x);
+
+    FdmVector2& residual = _residuals[level];
+    FdmBlas2::residual(A, *x, b, &residual);
+
+    Level& coarse = _coarseLevels[level];
+    restrictResidual(residual, &coarse.b);
+    coarse.x.set(0.0);
+    vCycle(level + 1, coarse.A, coarse.b, &coarse.x, isPreconditioning);
+
+    // The standalone solver takes the step along the correction that
+    // minimizes the energy norm of the error, which is cheap to compute on
+    // the coarse level since P^T r = b_c and P^T A P = A_c. This makes the
+    // cycle nonlinear, so the preconditioner uses a fixed scale instead.
+    double scale = kOverCorrection;
+    if (!isPreconditioning) {
+        FdmVector2& coarseAx = _residuals[level + 1];
+        FdmBlas2::mvm(coarse.A, coarse.x, &coarseAx);
+        double denom = FdmBlas2::dot(coarse.x, coarseAx);
+        scale = (denom > 0.0) ? FdmBlas2::dot(coarse.x, coarse.b) / denom : 1.0;
+    }
+    correct(coarse.x, scale, x);
+
+    relax(A, b, _numberOfSmoothingIterations, true, x);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/cg.h>
+#include <jet/fdm_mgpcg_solver3.h>
+
+using namespace jet;
+
+FdmMgpcgSolver3::FdmMgpcgSolver3(
+    unsigned int maxNumberOfLevels,
+    unsigned int maxNumberOfIterations,
+    double tolerance) :
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _tolerance(tolerance),
+    _lastResidualNorm(kMaxD),
+    _precond(maxNumberOfLevels, 1, tolerance) {
+}
+
+bool FdmMgpcgSolver3::solve(FdmLinearSystem3* system) {
+    FdmMatrix3& matrix = system->A;
+    FdmVector3& solution = system->x;
+    FdmVector3& rhs = system->b;
+
+    JET_ASSERT(matrix.size() == rhs.size());
+    JET_ASSERT(matrix.size() == solution.size());
+
+    Size3 size = matrix.size();
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+    _s.resize(size);
+
+    system->x.set(0.0);
+    _r.set(0.0);
+    _d.set(0.0);
+    _q.set(0.0);
+    _s.set(0.0);
+
+    pcg<FdmBlas3, FdmMgSolver3>(
+        matrix,
+        rhs,
+        _maxNumberOfIterations,
+        _tolerance,
+        &_precond,
+        &solution,
+        &_r,
+        &_d,
+        &_q,
+        &_s,
+        &_lastNumberOfIterations,
+        &_lastResidualNorm);
+
+    JET_INFO << "Residual norm after solving MGPCG: " << _lastResidualNorm
+             << " Number of MGPCG iterations: " << _lastNumberOfIterations;
+
+    return _lastResidualNorm <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+unsigned int FdmMgpcgSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmMgpcgSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmMgpcgSolver3::tolerance() const {
+    return _tolerance;
+}
+
+double FdmMgpcgSolver3::lastResidual() const {
+    return _lastResidualNorm;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_FDM_MIXED_PRECISION_HELPERS_H_
+#define SRC_JET_FDM_MIXED_PRECISION_HELPERS_H_
+
+#include <jet/fdm_linear_system2.h>
+#include <jet/fdm_linear_system3.h>
+
+namespace jet {
+
+// Relative residual reduction each single-precision correction solve aims
+// for. Well above the float round-off, so that the inner solves converge.
+const double kMixedPrecisionInnerReduction = 1e-3;
+
+inline void convertToSinglePrecision(
+    const FdmMatrix2& input,
+    FdmMatrix2F* output) {
+    output->resize(input.size());
+    input.parallelForEachIndex([&](size_t i, size_t j) {
+        FdmMatrixRow2F& row = (*output)(i, j);
+        row.center = static_cast<float>(input(i, j).center);
+        row.right = static_cast<float>(input(i, j).right);
+        row.up = static_cast<float>(input(i, j).up);
+    });
+}
+
+inline void convertToSinglePrecision(
+    const FdmMatrix3& input,
+    FdmMatrix3F* output) {
+    output->resize(input.size());
+    input.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        FdmMatrixRow3F& row = (*output)(i, j, k);
+        row.center = static_cast<float>(input(i, j, k).center);
+        row.right = static_cast<float>(input(i, j, k).right);
+        row.up = static_cast<float>(input(i, j, k).up);
+        row.front = static_cast<float>(input(i, j, k).front);
+    });
+}
+
+inline void convertToSinglePrecision(
+    const FdmVector2& input,
+    FdmVector2F* output) {
+    output->resize(input.size());
+    input.parallelForEachIndex([&](size_t i, size_t j) {
+        (*output)(i, j) = static_cast<float>(input(i, j));
+    });
+}
+
+inline void convertToSinglePrecision(
+    const FdmVector3& input,
+    FdmVector3F* output) {
+    output->resize(input.size());
+    input.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*output)(i, j, k) = static_cast<float>(input(i, j, k));
+    });
+}
+
+inline void addCorrection(const FdmVector2F& correction, FdmVector2* x) {
+    x->parallelForEachIndex([&](size_t i, size_t j) {
+        (*x)(i, j) += correction(i, j);
+    });
+}
+
+inline void addCorrection(const FdmVector3F& correction, FdmVector3* x) {
+    x->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*x)(i, j, k) += correction(i, j, k);
+    });
+}
+
+// Solves the double-precision system Ax = b with mixed-precision iterative
+// refinement: the residual r = b - Ax and the solution are kept in double
+// precision, while the correction equation Ae = r is solved in single
+// precision by innerSolve(singleA, singleR, tolerance, maxIterations,
+// singleE), which returns the number of iterations it took. The given x is
+// used as the initial guess.
+template <typename BlasType, typename SingleBlasType, typename InnerSolve>
+void solveWithMixedPrecision(
+    const typename BlasType::MatrixType& A,
+    const typename BlasType::VectorType& b,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    const InnerSolve& innerSolve,
+    typename BlasType::VectorType* x,
+    typename BlasType::VectorType* r,
+    typename SingleBlasType::MatrixType* singleA,
+    typename SingleBlasType::VectorType* singleR,
+    typename SingleBlasType::VectorType* singleE,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm) {
+    convertToSinglePrecision(A, singleA);
+    r->resize(b.size());
+    singleE->resize(b.size());
+
+    unsigned int iter = 0;
+    while (true) {
+        BlasType::residual(A, *x, b, r);
+        *lastResidualNorm = BlasType::l2Norm(*r);
+
+        if (*lastResidualNorm <= tolerance || iter >= maxNumberOfIterations) {
+            break;
+        }
+
+        convertToSinglePrecision(*r, singleR);
+        SingleBlasType::set(0, singleE);
+
+        // The inner tolerance is relative only, since the inner solver may
+        // measure the residual in a different (preconditioned) norm
+        unsigned int innerIter = innerSolve(
+            *singleA,
+            *singleR,
+            kMixedPrecisionInnerReduction * *lastResidualNorm,
+            maxNumberOfIterations - iter,
+            singleE);
+
+        if (innerIter == 0) {
+            break;
+        }
+
+        iter += innerIter;
+        addCorrection(*singleE, x);
+    }
+
+    *lastNumberOfIterations = iter;
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_FDM_MIXED_PRECISION_HELPERS_H_
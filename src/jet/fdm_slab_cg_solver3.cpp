@@ -0,0 +1,155 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/fdm_slab_cg_solver3.h>
+#include <jet/parallel.h>
+
+using namespace jet;
+
+FdmSlabCgSolver3::FdmSlabCgSolver3(
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    const SlabDecomposition3Ptr& decomposition) :
+    _maxNumberOfIterations(maxNumberOfIterations),
+    _lastNumberOfIterations(0),
+    _tolerance(tolerance),
+    _lastResidual(kMaxD),
+    _decomposition(decomposition) {
+    JET_THROW_INVALID_ARG_IF(_decomposition == nullptr);
+}
+
+bool FdmSlabCgSolver3::solve(FdmLinearSystem3* system) {
+    const FdmMatrix3& A = system->A;
+    FdmVector3& x = system->x;
+    const FdmVector3& b = system->b;
+
+    Size3 size = _decomposition->localSize();
+    JET_THROW_INVALID_ARG_IF(A.size() != size);
+    JET_THROW_INVALID_ARG_IF(b.size() != size);
+    JET_THROW_INVALID_ARG_IF(x.size() != size);
+
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+
+    // The matrix does not change during the solve, so the coupling from the
+    // previous slab is exchanged only once.
+    _decomposition->exchangeGhostLayers(
+        A, &_backMatrixGhost, &_frontMatrixGhost);
+
+    // Same iterations as cg()
+    x.set(0.0);
+    _d.set(0.0);
+    _q.set(0.0);
+
+    // r = b - Ax
+    residual(A, x, b, &_r);
+
+    // d = r
+    FdmBlas3::set(_r, &_d);
+
+    // sigmaNew = r.r
+    double sigmaNew = dot(_r, _r);
+
+    unsigned int iter = 0;
+    bool trigger = false;
+    while (sigmaNew > square(_tolerance) && iter < _maxNumberOfIterations) {
+        // q = Ad
+        mvm(A, _d, &_q);
+
+        // alpha = sigmaNew/d.q
+        double alpha = sigmaNew / dot(_d, _q);
+
+        // x = x + alpha*d
+        FdmBlas3::axpy(alpha, _d, x, &x);
+
+        // sigmaOld = sigmaNew
+        double sigmaOld = sigmaNew;
+
+        // if i is divisible by 50...
+        if (trigger || (iter % 50 == 0 && iter > 0)) {
+            // r = b - Ax
+            residual(A, x, b, &_r);
+            trigger = false;
+        } else {
+            // r = r - alpha*q
+            FdmBlas3::axpy(-alpha, _q, _r, &_r);
+        }
+
+        // sigmaNew = r.r
+        sigmaNew = dot(_r, _r);
+
+        if (sigmaNew > sigmaOld) {
+            trigger = true;
+        }
+
+        // beta = sigmaNew/sigmaOld
+        double beta = sigmaNew / sigmaOld;
+
+        // d = r + beta*d
+        FdmBlas3::axpy(beta, _d, _r, &_d);
+
+        ++iter;
+    }
+
+    _lastNumberOfIterations = iter;
+    _lastResidual = std::sqrt(sigmaNew);
+
+    return _lastResidual <= _tolerance
+        || _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+unsigned int FdmSlabCgSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmSlabCgSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmSlabCgSolver3::tolerance() const {
+    return _tolerance;
+}
+
+double FdmSlabCgSolver3::lastResidual() const {
+    return _lastResidual;
+}
+
+const SlabDecomposition3Ptr& FdmSlabCgSolver3::decomposition() const {
+    return _decomposition;
+}
+
+void FdmSlabCgSolver3::mvm(
+    const FdmMatrix3& a, const FdmVector3& x, FdmVector3* result) {
+    _decomposition->exchangeGhostLayers(x, &_backGhost, &_frontGhost);
+
+    // Local product, which misses the terms across the slab boundaries
+    FdmBlas3::mvm(a, x, result);
+
+    Size3 size = a.size();
+    size_t last = size.z - 1;
+
+    parallelFor(
+        kZeroSize, size.x,
+        kZeroSize, size.y,
+        [&](size_t i, size_t j) {
+            (*result)(i, j, 0)
+                += _backMatrixGhost(i, j).front * _backGhost(i, j);
+            (*result)(i, j, last)
+                += a(i, j, last).front * _frontGhost(i, j);
+        });
+}
+
+void FdmSlabCgSolver3::residual(
+    const FdmMatrix3& a,
+    const FdmVector3& x,
+    const FdmVector3& b,
+    FdmVector3* result) {
+    mvm(a, x, result);
+    FdmBlas3::axpy(-1.0, *result, b, result);
+}
+
+double FdmSlabCgSolver3::dot(const FdmVector3& a, const FdmVector3& b) {
+    return _decomposition->communicator()->sum(FdmBlas3::dot(a, b));
+}
@@ -42,8 +42,10 @@ std::array<Vector2D, 2> gradient2(
     return result;
 }
 
-Vector3D gradient3(
-    const ConstArrayAccessor3<double>& data,
+// The scalar stencils read the values of either precision into doubles.
+template <typename T>
+static Vector3D scalarGradient3(
+    const ConstArrayAccessor3<T>& data,
     const Vector3D& gridSpacing,
     size_t i,
     size_t j,
@@ -155,8 +157,9 @@ Vector2D laplacian2(
         + (dup - ddown) / square(gridSpacing.y);
 }
 
-double laplacian3(
-    const ConstArrayAccessor3<double>& data,
+template <typename T>
+static double scalarLaplacian3(
+    const ConstArrayAccessor3<T>& data,
     const Vector3D& gridSpacing,
     size_t i,
     size_t j,
@@ -243,4 +246,40 @@ Vector3D laplacian3(
         + (dfront - dback) / square(gridSpacing.z);
 }
 
+Vector3D gradient3(
+    const ConstArrayAccessor3<double>& data,
+    const Vector3D& gridSpacing,
+    size_t i,
+    size_t j,
+    size_t k) {
+    return scalarGradient3(data, gridSpacing, i, j, k);
+}
+
+Vector3D gradient3(
+    const ConstArrayAccessor3<float>& data,
+    const Vector3D& gridSpacing,
+    size_t i,
+    size_t j,
+    size_t k) {
+    return scalarGradient3(data, gridSpacing, i, j, k);
+}
+
+double laplacian3(
+    const ConstArrayAccessor3<double>& data,
+    const Vector3D& gridSpacing,
+    size_t i,
+    size_t j,
+    size_t k) {
+    return scalarLaplacian3(data, gridSpacing, i, j, k);
+}
+
+double laplacian3(
+    const ConstArrayAccessor3<float>& data,
+    const Vector3D& gridSpacing,
+    size_t i,
+    size_t j,
+    size_t k) {
+    return scalarLaplacian3(data, gridSpacing, i, j, k);
+}
+
 }  // namespace jet
@@ -1,7 +1,10 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <grid_sampler_helpers.h>
 #include <jet/flip_solver3.h>
+#include <pic_helpers.h>
+#include <algorithm>
 
 using namespace jet;
 
@@ -11,11 +14,19 @@ FlipSolver3::FlipSolver3() {
 FlipSolver3::~FlipSolver3() {
 }
 
+double FlipSolver3::picBlendingFactor() const {
+    return _picBlendingFactor;
+}
+
+void FlipSolver3::setPicBlendingFactor(double factor) {
+    _picBlendingFactor = clamp(factor, 0.0, 1.0);
+}
+
 void FlipSolver3::transferFromParticlesToGrids() {
     PicSolver3::transferFromParticlesToGrids();
 
-    // Store snapshot
-    _delta.set(*gridSystemData()->velocity());
+    // Store snapshot, which shares the storage until the velocity changes
+    _oldVelocity.set(*gridSystemData()->velocity());
 }
 
 void FlipSolver3::transferFromGridsToParticles() {
@@ -24,21 +35,24 @@ void FlipSolver3::transferFromGridsToParticles() {
     auto velocities = particleSystemData()->velocities();
     size_t numberOfParticles = particleSystemData()->numberOfParticles();
 
-    // Compute delta
-    flow->parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
-        _delta.u(i, j, k) = flow->u(i, j, k) - _delta.u(i, j, k);
-    });
-
-    flow->parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
-        _delta.v(i, j, k) = flow->v(i, j, k) - _delta.v(i, j, k);
-    });
+    JET_ASSERT(flow->resolution() == _oldVelocity.resolution());
 
-    flow->parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
-        _delta.w(i, j, k) = flow->w(i, j, k) - _delta.w(i, j, k);
-    });
+    // The old velocity has the same layout as the new one, so the weights
+    // are computed once for both, or taken from the transfer to the grids.
+    FaceCenteredGridSampler3 newSampler(*flow);
+    FaceCenteredGridSampler3 oldSampler(_oldVelocity);
+    const ParticleStencils3* stencils = particleStencils();
+    const double flipFactor = 1.0 - _picBlendingFactor;
 
-    // Transfer delta to the particles
     parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
-        velocities[i] += _delta.sample(positions[i]);
+        auto weights = (stencils != nullptr)
+            ? (*stencils)[i] : newSampler.getWeights(positions[i]);
+        Vector3D newVelocity = newSampler.sample(weights);
+        Vector3D oldVelocity = oldSampler.sample(weights);
+
+        // FLIP adds the change of the grid velocity, and PIC takes the new
+        // grid velocity.
+        velocities[i] = newVelocity
+            + flipFactor * (velocities[i] - oldVelocity);
     });
 }
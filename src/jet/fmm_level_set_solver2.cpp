@@ -178,7 +178,10 @@ void FmmLevelSetSolver2::reinitialize(
     Vector2D gridSpacing = inputSdf.gridSpacing();
     Vector2D invGridSpacing = 1.0 / gridSpacing;
     Vector2D invGridSpacingSqr = invGridSpacing * invGridSpacing;
-    Array2<char> markers(size);
+    Array2<char>& markers = _markers;
+    if (markers.size() != size) {
+        markers.resize(size);
+    }
 
     auto output = outputSdf->dataAccessor();
 
@@ -311,6 +314,14 @@ void FmmLevelSetSolver2::reinitialize(
             output(i, j) = -output(i, j);
         });
     }
+
+    // The marching already stops at maxDistance, so only the values beyond
+    // it are left to clamp
+    if (isUsingNarrowBand()) {
+        markers.parallelForEachIndex([&](size_t i, size_t j) {
+            output(i, j) = clamp(output(i, j), -maxDistance, maxDistance);
+        });
+    }
 }
 
 void FmmLevelSetSolver2::extrapolate(
@@ -320,7 +331,9 @@ void FmmLevelSetSolver2::extrapolate(
     ScalarGrid2* output) {
     JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
 
-    Array2<double> sdfGrid(input.dataSize());
+    _scratch.reset();
+
+    auto sdfGrid = _scratch.array2<double>(input.dataSize());
     auto pos = input.dataPosition();
     sdfGrid.parallelForEachIndex([&](size_t i, size_t j) {
         sdfGrid(i, j) = sdf.sample(pos(i, j));
@@ -328,7 +341,7 @@ void FmmLevelSetSolver2::extrapolate(
 
     extrapolate(
         input.constDataAccessor(),
-        sdfGrid.constAccessor(),
+        sdfGrid,
         input.gridSpacing(),
         maxDistance,
         output->dataAccessor());
@@ -341,7 +354,9 @@ void FmmLevelSetSolver2::extrapolate(
     CollocatedVectorGrid2* output) {
     JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
 
-    Array2<double> sdfGrid(input.dataSize());
+    _scratch.reset();
+
+    auto sdfGrid = _scratch.array2<double>(input.dataSize());
     auto pos = input.dataPosition();
     sdfGrid.parallelForEachIndex([&](size_t i, size_t j) {
         sdfGrid(i, j) = sdf.sample(pos(i, j));
@@ -349,10 +364,10 @@ void FmmLevelSetSolver2::extrapolate(
 
     const Vector2D gridSpacing = input.gridSpacing();
 
-    Array2<double> u(input.dataSize());
-    Array2<double> u0(input.dataSize());
-    Array2<double> v(input.dataSize());
-    Array2<double> v0(input.dataSize());
+    auto u = _scratch.array2<double>(input.dataSize());
+    auto u0 = _scratch.array2<double>(input.dataSize());
+    auto v = _scratch.array2<double>(input.dataSize());
+    auto v0 = _scratch.array2<double>(input.dataSize());
 
     input.parallelForEachDataPointIndex([&](size_t i, size_t j) {
         u(i, j) = input(i, j).x;
@@ -361,14 +376,14 @@ void FmmLevelSetSolver2::extrapolate(
 
     extrapolate(
         u,
-        sdfGrid.constAccessor(),
+        sdfGrid,
         gridSpacing,
         maxDistance,
         u0);
 
     extrapolate(
         v,
-        sdfGrid.constAccessor(),
+        sdfGrid,
         gridSpacing,
         maxDistance,
         v0);
@@ -386,11 +401,13 @@ void FmmLevelSetSolver2::extrapolate(
     FaceCenteredGrid2* output) {
     JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
 
+    _scratch.reset();
+
     const Vector2D gridSpacing = input.gridSpacing();
 
     auto u = input.uConstAccessor();
     auto uPos = input.uPosition();
-    Array2<double> sdfAtU(u.size());
+    auto sdfAtU = _scratch.array2<double>(u.size());
     input.parallelForEachUIndex([&](size_t i, size_t j) {
         sdfAtU(i, j) = sdf.sample(uPos(i, j));
     });
@@ -404,7 +421,7 @@ void FmmLevelSetSolver2::extrapolate(
 
     auto v = input.vConstAccessor();
     auto vPos = input.vPosition();
-    Array2<double> sdfAtV(v.size());
+    auto sdfAtV = _scratch.array2<double>(v.size());
     input.parallelForEachVIndex([&](size_t i, size_t j) {
         sdfAtV(i, j) = sdf.sample(vPos(i, j));
     });
@@ -427,7 +444,11 @@ void FmmLevelSetSolver2::extrapolate(
     Vector2D invGridSpacing = 1.0 / gridSpacing;
 
     // Build markers
-    Array2<char> markers(size, kUnknown);
+    Array2<char>& markers = _markers;
+    if (markers.size() != size) {
+        markers.resize(size);
+    }
+    markers.set(kUnknown);
     markers.parallelForEachIndex([&](size_t i, size_t j) {
         if (isInsideSdf(sdf(i, j))) {
             markers(i, j) = kKnown;
@@ -4,10 +4,11 @@
 #include <jet/fdm_utils.h>
 #include <jet/fmm_level_set_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
+#include <fmm_trial_queue_helpers.h>
 
 #include <algorithm>
 #include <vector>
-#include <queue>
 
 using namespace jet;
 
@@ -219,335 +220,27 @@ inline double solveQuad(
     return solution;
 }
 
-FmmLevelSetSolver3::FmmLevelSetSolver3() {
-}
-
-void FmmLevelSetSolver3::reinitialize(
-    const ScalarGrid3& inputSdf,
-    double maxDistance,
-    ScalarGrid3* outputSdf) {
-    JET_THROW_INVALID_ARG_IF(!inputSdf.hasSameShape(*outputSdf));
-
-    Size3 size = inputSdf.dataSize();
-    Vector3D gridSpacing = inputSdf.gridSpacing();
-    Vector3D invGridSpacing = 1.0 / gridSpacing;
-    Vector3D invGridSpacingSqr = invGridSpacing * invGridSpacing;
-    Array3<char> markers(size);
-
-    auto output = outputSdf->dataAccessor();
-
-    markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        output(i, j, k) = inputSdf(i, j, k);
-    });
-
-    // Solve geometrically near the boundary
-    markers.forEachIndex([&](size_t i, size_t j, size_t k) {
-        if (!isInsideSdf(output(i, j, k))
-            && ((i > 0 && isInsideSdf(output(i - 1, j, k)))
-             || (i + 1 < size.x && isInsideSdf(output(i + 1, j, k)))
-             || (j > 0 && isInsideSdf(output(i, j - 1, k)))
-             || (j + 1 < size.y && isInsideSdf(output(i, j + 1, k)))
-             || (k > 0 && isInsideSdf(output(i, j, k - 1)))
-             || (k + 1 < size.z && isInsideSdf(output(i, j, k + 1))))) {
-            output(i, j, k) = solveQuadNearBoundary(
-                markers, output, gridSpacing, invGridSpacingSqr, 1.0, i, j, k);
-        } else if (isInsideSdf(output(i, j, k))
-            && ((i > 0 && !isInsideSdf(output(i - 1, j, k)))
-             || (i + 1 < size.x && !isInsideSdf(output(i + 1, j, k)))
-             || (j > 0 && !isInsideSdf(output(i, j - 1, k)))
-             || (j + 1 < size.y && !isInsideSdf(output(i, j + 1, k)))
-             || (k > 0 && !isInsideSdf(output(i, j, k - 1)))
-             || (k + 1 < size.z && !isInsideSdf(output(i, j, k + 1))))) {
-            output(i, j, k) = solveQuadNearBoundary(
-                markers, output, gridSpacing, invGridSpacingSqr, -1.0, i, j, k);
-        }
-    });
-
-    for (int sign = 0; sign < 2; ++sign) {
-        // Build markers
-        markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-            if (isInsideSdf(output(i, j, k))) {
-                markers(i, j, k) = kKnown;
-            } else {
-                markers(i, j, k) = kUnknown;
-            }
-        });
-
-        auto compare = [&](const Point3UI& a, const Point3UI& b) {
-            return output(a.x, a.y, a.z) > output(b.x, b.y, b.z);
-        };
-
-        // Enqueue initial candidates
-        std::priority_queue<
-            Point3UI, std::vector<Point3UI>, decltype(compare)> trial(compare);
-        markers.forEachIndex([&](size_t i, size_t j, size_t k) {
-            if (markers(i, j, k) != kKnown
-                && ((i > 0 && markers(i - 1, j, k) == kKnown)
-                 || (i + 1 < size.x && markers(i + 1, j, k) == kKnown)
-                 || (j > 0 && markers(i, j - 1, k) == kKnown)
-                 || (j + 1 < size.y && markers(i, j + 1, k) == kKnown)
-                 || (k > 0 && markers(i, j, k - 1) == kKnown)
-                 || (k + 1 < size.z && markers(i, j, k + 1) == kKnown))) {
-                trial.push(Point3UI(i, j, k));
-                markers(i, j, k) = kTrial;
-            }
-        });
-
-        // Propagate
-        while (!trial.empty()) {
-            Point3UI idx = trial.top();
-            trial.pop();
-
-            size_t i = idx.x;
-            size_t j = idx.y;
-            size_t k = idx.z;
-
-            markers(i, j, k) = kKnown;
-            output(i, j, k) = solveQuad(
-                markers, output, gridSpacing, invGridSpacingSqr, i, j, k);
-
-            if (output(i, j, k) > maxDistance) {
-                break;
-            }
-
-            if (i > 0) {
-                if (markers(i - 1, j, k) == kUnknown) {
-                    markers(i - 1, j, k) = kTrial;
-                    output(i - 1, j, k) = solveQuad(
-                        markers,
-                        output,
-                        gridSpacing,
-                        invGridSpacingSqr,
-                        i - 1,
-                        j,
-                        k);
-                    trial.push(Point3UI(i - 1, j, k));
-                }
-            }
-
-            if (i + 1 < size.x) {
-                if (markers(i + 1, j, k) == kUnknown) {
-                    markers(i + 1, j, k) = kTrial;
-                    output(i + 1, j, k) = solveQuad(
-                        markers,
-                        output,
-                        gridSpacing,
-                        invGridSpacingSqr,
-                        i + 1,
-                        j,
-                        k);
-                    trial.push(Point3UI(i + 1, j, k));
-                }
-            }
-
-            if (j > 0) {
-                if (markers(i, j - 1, k) == kUnknown) {
-                    markers(i, j - 1, k) = kTrial;
-                    output(i, j - 1, k) = solveQuad(
-                        markers,
-                        output,
-                        gridSpacing,
-                        invGridSpacingSqr,
-                        i,
-                        j - 1,
-                        k);
-                    trial.push(Point3UI(i, j - 1, k));
-                }
-            }
-
-            if (j + 1 < size.y) {
-                if (markers(i, j + 1, k) == kUnknown) {
-                    markers(i, j + 1, k) = kTrial;
-                    output(i, j + 1, k) = solveQuad(
-                        markers,
-                        output,
-                        gridSpacing,
-                        invGridSpacingSqr,
-                        i,
-                        j + 1,
-                        k);
-                    trial.push(Point3UI(i, j + 1, k));
-                }
-            }
-
-            if (k > 0) {
-                if (markers(i, j, k - 1) == kUnknown) {
-                    markers(i, j, k - 1) = kTrial;
-                    output(i, j, k - 1) = solveQuad(
-                        markers,
-                        output,
-                        gridSpacing,
-                        invGridSpacingSqr,
-                        i,
-                        j,
-                        k - 1);
-                    trial.push(Point3UI(i, j, k - 1));
-                }
-            }
-
-            if (k + 1 < size.z) {
-                if (markers(i, j, k + 1) == kUnknown) {
-                    markers(i, j, k + 1) = kTrial;
-                    output(i, j, k + 1) = solveQuad(
-                        markers,
-                        output,
-                        gridSpacing,
-                        invGridSpacingSqr,
-                        i,
-                        j,
-                        k + 1);
-                    trial.push(Point3UI(i, j, k + 1));
-                }
-            }
-        }
-
-        // Flip the sign
-        markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-            output(i, j, k) = -output(i, j, k);
-        });
-    }
-}
-
-void FmmLevelSetSolver3::extrapolate(
-    const ScalarGrid3& input,
-    const ScalarField3& sdf,
-    double maxDistance,
-    ScalarGrid3* output) {
-    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
-
-    Array3<double> sdfGrid(input.dataSize());
-    auto pos = input.dataPosition();
-    sdfGrid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        sdfGrid(i, j, k) = sdf.sample(pos(i, j, k));
-    });
-
-    extrapolate(
-        input.constDataAccessor(),
-        sdfGrid.constAccessor(),
-        input.gridSpacing(),
-        maxDistance,
-        output->dataAccessor());
-}
-
-void FmmLevelSetSolver3::extrapolate(
-    const CollocatedVectorGrid3& input,
-    const ScalarField3& sdf,
-    double maxDistance,
-    CollocatedVectorGrid3* output) {
-    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
-
-    Array3<double> sdfGrid(input.dataSize());
-    auto pos = input.dataPosition();
-    sdfGrid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        sdfGrid(i, j, k) = sdf.sample(pos(i, j, k));
-    });
-
-    const Vector3D gridSpacing = input.gridSpacing();
-
-    Array3<double> u(input.dataSize());
-    Array3<double> u0(input.dataSize());
-    Array3<double> v(input.dataSize());
-    Array3<double> v0(input.dataSize());
-    Array3<double> w(input.dataSize());
-    Array3<double> w0(input.dataSize());
-
-    input.parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-        u(i, j, k) = input(i, j, k).x;
-        v(i, j, k) = input(i, j, k).y;
-        w(i, j, k) = input(i, j, k).z;
-    });
-
-    extrapolate(
-        u,
-        sdfGrid.constAccessor(),
-        gridSpacing,
-        maxDistance,
-        u0);
-
-    extrapolate(
-        v,
-        sdfGrid.constAccessor(),
-        gridSpacing,
-        maxDistance,
-        v0);
-
-    extrapolate(
-        w,
-        sdfGrid.constAccessor(),
-        gridSpacing,
-        maxDistance,
-        w0);
-
-    output->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-        (*output)(i, j, k).x = u(i, j, k);
-        (*output)(i, j, k).y = v(i, j, k);
-        (*output)(i, j, k).z = w(i, j, k);
-    });
-}
-
-void FmmLevelSetSolver3::extrapolate(
-    const FaceCenteredGrid3& input,
-    const ScalarField3& sdf,
-    double maxDistance,
-    FaceCenteredGrid3* output) {
-    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
-
-    const Vector3D gridSpacing = input.gridSpacing();
-
-    auto u = input.uConstAccessor();
-    auto uPos = input.uPosition();
-    Array3<double> sdfAtU(u.size());
-    input.parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
-        sdfAtU(i, j, k) = sdf.sample(uPos(i, j, k));
-    });
-
-    extrapolate(
-        u,
-        sdfAtU,
-        gridSpacing,
-        maxDistance,
-        output->uAccessor());
-
-    auto v = input.vConstAccessor();
-    auto vPos = input.vPosition();
-    Array3<double> sdfAtV(v.size());
-    input.parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
-        sdfAtV(i, j, k) = sdf.sample(vPos(i, j, k));
-    });
-
-    extrapolate(
-        v,
-        sdfAtV,
-        gridSpacing,
-        maxDistance,
-        output->vAccessor());
-
-    auto w = input.wConstAccessor();
-    auto wPos = input.wPosition();
-    Array3<double> sdfAtW(w.size());
-    input.parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
-        sdfAtW(i, j, k) = sdf.sample(wPos(i, j, k));
-    });
-
-    extrapolate(
-        w,
-        sdfAtW,
-        gridSpacing,
-        maxDistance,
-        output->wAccessor());
-}
-
-void FmmLevelSetSolver3::extrapolate(
-    const ConstArrayAccessor3<double>& input,
+// Extrapolates the values along the normal of the SDF with a single march.
+// The weights only depend on the SDF, so a vector value is extrapolated with
+// the same march for all of its components.
+template <typename T, typename TrialQueue>
+static void marchExtrapolation(
+    const ConstArrayAccessor3<T>& input,
     const ConstArrayAccessor3<double>& sdf,
     const Vector3D& gridSpacing,
     double maxDistance,
-    ArrayAccessor3<double> output) {
+    Array3<char>* markersBuffer,
+    TrialQueue* trialQueue,
+    ArrayAccessor3<T> output) {
     Size3 size = input.size();
     Vector3D invGridSpacing = 1.0 / gridSpacing;
 
     // Build markers
-    Array3<char> markers(size, kUnknown);
+    Array3<char>& markers = *markersBuffer;
+    if (markers.size() != size) {
+        markers.resize(size);
+    }
+    markers.set(kUnknown);
     markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
         if (isInsideSdf(sdf(i, j, k))) {
             markers(i, j, k) = kKnown;
@@ -555,50 +248,45 @@ void FmmLevelSetSolver3::extrapolate(
         output(i, j, k) = input(i, j, k);
     });
 
-    auto compare = [&](const Point3UI& a, const Point3UI& b) {
-        return sdf(a.x, a.y, a.z) > sdf(b.x, b.y, b.z);
-    };
-
     // Enqueue initial candidates
-    std::priority_queue<
-        Point3UI, std::vector<Point3UI>, decltype(compare)> trial(compare);
+    TrialQueue& trial = *trialQueue;
     markers.forEachIndex([&](size_t i, size_t j, size_t k) {
         if (markers(i, j, k) == kKnown) {
             return;
         }
 
         if (i > 0 && markers(i - 1, j, k) == kKnown) {
-            trial.push(Point3UI(i, j, k));
+            trial.push(Point3UI(i, j, k), sdf(i, j, k));
             markers(i, j, k) = kTrial;
             return;
         }
 
         if (i + 1 < size.x && markers(i + 1, j, k) == kKnown) {
-            trial.push(Point3UI(i, j, k));
+            trial.push(Point3UI(i, j, k), sdf(i, j, k));
             markers(i, j, k) = kTrial;
             return;
         }
 
         if (j > 0 && markers(i, j - 1, k) == kKnown) {
-            trial.push(Point3UI(i, j, k));
+            trial.push(Point3UI(i, j, k), sdf(i, j, k));
             markers(i, j, k) = kTrial;
             return;
         }
 
         if (j + 1 < size.y && markers(i, j + 1, k) == kKnown) {
-            trial.push(Point3UI(i, j, k));
+            trial.push(Point3UI(i, j, k), sdf(i, j, k));
             markers(i, j, k) = kTrial;
             return;
         }
 
         if (k > 0 && markers(i, j, k - 1) == kKnown) {
-            trial.push(Point3UI(i, j, k));
+            trial.push(Point3UI(i, j, k), sdf(i, j, k));
             markers(i, j, k) = kTrial;
             return;
         }
 
         if (k + 1 < size.z && markers(i, j, k + 1) == kKnown) {
-            trial.push(Point3UI(i, j, k));
+            trial.push(Point3UI(i, j, k), sdf(i, j, k));
             markers(i, j, k) = kTrial;
             return;
         }
@@ -606,8 +294,7 @@ void FmmLevelSetSolver3::extrapolate(
 
     // Propagate
     while (!trial.empty()) {
-        Point3UI idx = trial.top();
-        trial.pop();
+        Point3UI idx = trial.pop();
 
         size_t i = idx.x;
         size_t j = idx.y;
@@ -619,7 +306,7 @@ void FmmLevelSetSolver3::extrapolate(
 
         Vector3D grad = gradient3(sdf, gridSpacing, i, j, k).normalized();
 
-        double sum = 0.0;
+        T sum = T();
         double count = 0.0;
 
         if (i > 0) {
@@ -635,7 +322,7 @@ void FmmLevelSetSolver3::extrapolate(
                 count += weight;
             } else if (markers(i - 1, j, k) == kUnknown) {
                 markers(i - 1, j, k) = kTrial;
-                trial.push(Point3UI(i - 1, j, k));
+                trial.push(Point3UI(i - 1, j, k), sdf(i - 1, j, k));
             }
         }
 
@@ -652,7 +339,7 @@ void FmmLevelSetSolver3::extrapolate(
                 count += weight;
             } else if (markers(i + 1, j, k) == kUnknown) {
                 markers(i + 1, j, k) = kTrial;
-                trial.push(Point3UI(i + 1, j, k));
+                trial.push(Point3UI(i + 1, j, k), sdf(i + 1, j, k));
             }
         }
 
@@ -669,7 +356,7 @@ void FmmLevelSetSolver3::extrapolate(
                 count += weight;
             } else if (markers(i, j - 1, k) == kUnknown) {
                 markers(i, j - 1, k) = kTrial;
-                trial.push(Point3UI(i, j - 1, k));
+                trial.push(Point3UI(i, j - 1, k), sdf(i, j - 1, k));
             }
         }
 
@@ -686,7 +373,7 @@ void FmmLevelSetSolver3::extrapolate(
                 count += weight;
             } else if (markers(i, j + 1, k) == kUnknown) {
                 markers(i, j + 1, k) = kTrial;
-                trial.push(Point3UI(i, j + 1, k));
+                trial.push(Point3UI(i, j + 1, k), sdf(i, j + 1, k));
             }
         }
 
@@ -703,7 +390,7 @@ void FmmLevelSetSolver3::extrapolate(
                 count += weight;
             } else if (markers(i, j, k - 1) == kUnknown) {
                 markers(i, j, k - 1) = kTrial;
-                trial.push(Point3UI(i, j, k - 1));
+                trial.push(Point3UI(i, j, k - 1), sdf(i, j, k - 1));
             }
         }
 
@@ -720,7 +407,7 @@ void FmmLevelSetSolver3::extrapolate(
                 count += weight;
             } else if (markers(i, j, k + 1) == kUnknown) {
                 markers(i, j, k + 1) = kTrial;
-                trial.push(Point3UI(i, j, k + 1));
+                trial.push(Point3UI(i, j, k + 1), sdf(i, j, k + 1));
             }
         }
 
@@ -730,3 +417,432 @@ void FmmLevelSetSolver3::extrapolate(
         markers(i, j, k) = kKnown;
     }
 }
+
+// Returns the number of the nodes to reserve for the trial cells, which form
+// a front of about the size of a grid slice.
+static size_t expectedFrontSize(const Size3& size) {
+    return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Runs the extrapolation with the bucketed queue if it is given, or with the
+// heap otherwise.
+template <typename T>
+static void extrapolateAlongSdf(
+    const ConstArrayAccessor3<T>& input,
+    const ConstArrayAccessor3<double>& sdf,
+    const Vector3D& gridSpacing,
+    double maxDistance,
+    Array3<char>* markersBuffer,
+    FmmBucketTrialQueue* bucketQueue,
+    double bucketWidth,
+    ArrayAccessor3<T> output) {
+    if (bucketQueue != nullptr) {
+        bucketQueue->reset(bucketWidth, expectedFrontSize(input.size()));
+        marchExtrapolation(
+            input,
+            sdf,
+            gridSpacing,
+            maxDistance,
+            markersBuffer,
+            bucketQueue,
+            output);
+    } else {
+        FmmHeapTrialQueue trial;
+        marchExtrapolation(
+            input,
+            sdf,
+            gridSpacing,
+            maxDistance,
+            markersBuffer,
+            &trial,
+            output);
+    }
+}
+
+// Marches the distance of the unknown cells from the known ones, which are
+// the negative cells of the output.
+template <typename TrialQueue>
+static void marchDistance(
+    const Vector3D& gridSpacing,
+    const Vector3D& invGridSpacingSqr,
+    double maxDistance,
+    Array3<char>* markersBuffer,
+    TrialQueue* trialQueue,
+    ArrayAccessor3<double> output) {
+    Size3 size = output.size();
+    Array3<char>& markers = *markersBuffer;
+
+    // Enqueue initial candidates
+    TrialQueue& trial = *trialQueue;
+    markers.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (markers(i, j, k) != kKnown
+            && ((i > 0 && markers(i - 1, j, k) == kKnown)
+             || (i + 1 < size.x && markers(i + 1, j, k) == kKnown)
+             || (j > 0 && markers(i, j - 1, k) == kKnown)
+             || (j + 1 < size.y && markers(i, j + 1, k) == kKnown)
+             || (k > 0 && markers(i, j, k - 1) == kKnown)
+             || (k + 1 < size.z && markers(i, j, k + 1) == kKnown))) {
+            trial.push(Point3UI(i, j, k), output(i, j, k));
+            markers(i, j, k) = kTrial;
+        }
+    });
+
+    // Propagate
+    while (!trial.empty()) {
+        Point3UI idx = trial.pop();
+
+        size_t i = idx.x;
+        size_t j = idx.y;
+        size_t k = idx.z;
+
+        markers(i, j, k) = kKnown;
+        output(i, j, k) = solveQuad(
+            markers, output, gridSpacing, invGridSpacingSqr, i, j, k);
+
+        if (output(i, j, k) > maxDistance) {
+            break;
+        }
+
+        if (i > 0) {
+            if (markers(i - 1, j, k) == kUnknown) {
+                markers(i - 1, j, k) = kTrial;
+                output(i - 1, j, k) = solveQuad(
+                    markers,
+                    output,
+                    gridSpacing,
+                    invGridSpacingSqr,
+                    i - 1,
+                    j,
+                    k);
+                trial.push(Point3UI(i - 1, j, k), output(i - 1, j, k));
+            }
+        }
+
+        if (i + 1 < size.x) {
+            if (markers(i + 1, j, k) == kUnknown) {
+                markers(i + 1, j, k) = kTrial;
+                output(i + 1, j, k) = solveQuad(
+                    markers,
+                    output,
+                    gridSpacing,
+                    invGridSpacingSqr,
+                    i + 1,
+                    j,
+                    k);
+                trial.push(Point3UI(i + 1, j, k), output(i + 1, j, k));
+            }
+        }
+
+        if (j > 0) {
+            if (markers(i, j - 1, k) == kUnknown) {
+                markers(i, j - 1, k) = kTrial;
+                output(i, j - 1, k) = solveQuad(
+                    markers,
+                    output,
+                    gridSpacing,
+                    invGridSpacingSqr,
+                    i,
+                    j - 1,
+                    k);
+                trial.push(Point3UI(i, j - 1, k), output(i, j - 1, k));
+            }
+        }
+
+        if (j + 1 < size.y) {
+            if (markers(i, j + 1, k) == kUnknown) {
+                markers(i, j + 1, k) = kTrial;
+                output(i, j + 1, k) = solveQuad(
+                    markers,
+                    output,
+                    gridSpacing,
+                    invGridSpacingSqr,
+                    i,
+                    j + 1,
+                    k);
+                trial.push(Point3UI(i, j + 1, k), output(i, j + 1, k));
+            }
+        }
+
+        if (k > 0) {
+            if (markers(i, j, k - 1) == kUnknown) {
+                markers(i, j, k - 1) = kTrial;
+                output(i, j, k - 1) = solveQuad(
+                    markers,
+                    output,
+                    gridSpacing,
+                    invGridSpacingSqr,
+                    i,
+                    j,
+                    k - 1);
+                trial.push(Point3UI(i, j, k - 1), output(i, j, k - 1));
+            }
+        }
+
+        if (k + 1 < size.z) {
+            if (markers(i, j, k + 1) == kUnknown) {
+                markers(i, j, k + 1) = kTrial;
+                output(i, j, k + 1) = solveQuad(
+                    markers,
+                    output,
+                    gridSpacing,
+                    invGridSpacingSqr,
+                    i,
+                    j,
+                    k + 1);
+                trial.push(Point3UI(i, j, k + 1), output(i, j, k + 1));
+            }
+        }
+    }
+}
+
+FmmLevelSetSolver3::FmmLevelSetSolver3() {
+}
+
+FmmLevelSetSolver3::~FmmLevelSetSolver3() {
+}
+
+void FmmLevelSetSolver3::reinitialize(
+    const ScalarGrid3& inputSdf,
+    double maxDistance,
+    ScalarGrid3* outputSdf) {
+    JET_THROW_INVALID_ARG_IF(!inputSdf.hasSameShape(*outputSdf));
+
+    Size3 size = inputSdf.dataSize();
+    Vector3D gridSpacing = inputSdf.gridSpacing();
+    Vector3D invGridSpacing = 1.0 / gridSpacing;
+    Vector3D invGridSpacingSqr = invGridSpacing * invGridSpacing;
+    Array3<char>& markers = _markers[0];
+    if (markers.size() != size) {
+        markers.resize(size);
+    }
+
+    FmmBucketTrialQueue* bucketQueue = this->bucketQueue(0);
+    const double bucketWidth = this->bucketWidth(gridSpacing);
+
+    auto output = outputSdf->dataAccessor();
+
+    markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        output(i, j, k) = inputSdf(i, j, k);
+    });
+
+    // Solve geometrically near the boundary
+    markers.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (!isInsideSdf(output(i, j, k))
+            && ((i > 0 && isInsideSdf(output(i - 1, j, k)))
+             || (i + 1 < size.x && isInsideSdf(output(i + 1, j, k)))
+             || (j > 0 && isInsideSdf(output(i, j - 1, k)))
+             || (j + 1 < size.y && isInsideSdf(output(i, j + 1, k)))
+             || (k > 0 && isInsideSdf(output(i, j, k - 1)))
+             || (k + 1 < size.z && isInsideSdf(output(i, j, k + 1))))) {
+            output(i, j, k) = solveQuadNearBoundary(
+                markers, output, gridSpacing, invGridSpacingSqr, 1.0, i, j, k);
+        } else if (isInsideSdf(output(i, j, k))
+            && ((i > 0 && !isInsideSdf(output(i - 1, j, k)))
+             || (i + 1 < size.x && !isInsideSdf(output(i + 1, j, k)))
+             || (j > 0 && !isInsideSdf(output(i, j - 1, k)))
+             || (j + 1 < size.y && !isInsideSdf(output(i, j + 1, k)))
+             || (k > 0 && !isInsideSdf(output(i, j, k - 1)))
+             || (k + 1 < size.z && !isInsideSdf(output(i, j, k + 1))))) {
+            output(i, j, k) = solveQuadNearBoundary(
+                markers, output, gridSpacing, invGridSpacingSqr, -1.0, i, j, k);
+        }
+    });
+
+    for (int sign = 0; sign < 2; ++sign) {
+        // Build markers
+        markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            if (isInsideSdf(output(i, j, k))) {
+                markers(i, j, k) = kKnown;
+            } else {
+                markers(i, j, k) = kUnknown;
+            }
+        });
+
+        if (bucketQueue != nullptr) {
+            bucketQueue->reset(bucketWidth, expectedFrontSize(size));
+            marchDistance(
+                gridSpacing,
+                invGridSpacingSqr,
+                maxDistance,
+                &markers,
+                bucketQueue,
+                output);
+        } else {
+            FmmHeapTrialQueue trial;
+            marchDistance(
+                gridSpacing,
+                invGridSpacingSqr,
+                maxDistance,
+                &markers,
+                &trial,
+                output);
+        }
+
+        // Flip the sign
+        markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            output(i, j, k) = -output(i, j, k);
+        });
+    }
+
+    // The marching already stops at maxDistance, so only the values beyond
+    // it are left to clamp
+    if (isUsingNarrowBand()) {
+        markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            output(i, j, k) = clamp(output(i, j, k), -maxDistance, maxDistance);
+        });
+    }
+}
+
+
+void FmmLevelSetSolver3::extrapolate(
+    const ScalarGrid3& input,
+    const ScalarField3& sdf,
+    double maxDistance,
+    ScalarGrid3* output) {
+    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
+
+    _scratch.reset();
+
+    auto sdfGrid = _scratch.array3<double>(input.dataSize());
+    auto pos = input.dataPosition();
+    sdfGrid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        sdfGrid(i, j, k) = sdf.sample(pos(i, j, k));
+    });
+
+    extrapolateAlongSdf(
+        input.constDataAccessor(),
+        ConstArrayAccessor3<double>(sdfGrid),
+        input.gridSpacing(),
+        maxDistance,
+        &_markers[0],
+        bucketQueue(0),
+        bucketWidth(input.gridSpacing()),
+        output->dataAccessor());
+}
+
+void FmmLevelSetSolver3::extrapolate(
+    const CollocatedVectorGrid3& input,
+    const ScalarField3& sdf,
+    double maxDistance,
+    CollocatedVectorGrid3* output) {
+    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
+
+    _scratch.reset();
+
+    auto sdfGrid = _scratch.array3<double>(input.dataSize());
+    auto pos = input.dataPosition();
+    sdfGrid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        sdfGrid(i, j, k) = sdf.sample(pos(i, j, k));
+    });
+
+    // All the components are carried by a single march
+    extrapolateAlongSdf(
+        input.constDataAccessor(),
+        ConstArrayAccessor3<double>(sdfGrid),
+        input.gridSpacing(),
+        maxDistance,
+        &_markers[0],
+        bucketQueue(0),
+        bucketWidth(input.gridSpacing()),
+        output->dataAccessor());
+}
+
+void FmmLevelSetSolver3::extrapolate(
+    const FaceCenteredGrid3& input,
+    const ScalarField3& sdf,
+    double maxDistance,
+    FaceCenteredGrid3* output) {
+    JET_THROW_INVALID_ARG_IF(!input.hasSameShape(*output));
+
+    _scratch.reset();
+
+    const Vector3D gridSpacing = input.gridSpacing();
+
+    auto uPos = input.uPosition();
+    auto vPos = input.vPosition();
+    auto wPos = input.wPosition();
+    auto sdfAtU = _scratch.array3<double>(input.uSize());
+    auto sdfAtV = _scratch.array3<double>(input.vSize());
+    auto sdfAtW = _scratch.array3<double>(input.wSize());
+    input.parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
+        sdfAtU(i, j, k) = sdf.sample(uPos(i, j, k));
+    });
+    input.parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
+        sdfAtV(i, j, k) = sdf.sample(vPos(i, j, k));
+    });
+    input.parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
+        sdfAtW(i, j, k) = sdf.sample(wPos(i, j, k));
+    });
+
+    // The marches are sequential, so the staggered components run together,
+    // each with its own markers
+    auto u = output->uAccessor();
+    auto v = output->vAccessor();
+    auto w = output->wAccessor();
+    parallelInvoke({
+        [&]() {
+            extrapolateAlongSdf(
+                input.uConstAccessor(),
+                ConstArrayAccessor3<double>(sdfAtU),
+                gridSpacing,
+                maxDistance,
+                &_markers[0],
+                bucketQueue(0),
+                bucketWidth(gridSpacing),
+                u);
+        },
+        [&]() {
+            extrapolateAlongSdf(
+                input.vConstAccessor(),
+                ConstArrayAccessor3<double>(sdfAtV),
+                gridSpacing,
+                maxDistance,
+                &_markers[1],
+                bucketQueue(1),
+                bucketWidth(gridSpacing),
+                v);
+        },
+        [&]() {
+            extrapolateAlongSdf(
+                input.wConstAccessor(),
+                ConstArrayAccessor3<double>(sdfAtW),
+                gridSpacing,
+                maxDistance,
+                &_markers[2],
+                bucketQueue(2),
+                bucketWidth(gridSpacing),
+                w);
+        }});
+}
+
+bool FmmLevelSetSolver3::isUsingBucketedQueue() const {
+    return _isUsingBucketedQueue;
+}
+
+void FmmLevelSetSolver3::setIsUsingBucketedQueue(bool isUsing) {
+    _isUsingBucketedQueue = isUsing;
+}
+
+double FmmLevelSetSolver3::bucketWidth() const {
+    return _bucketWidth;
+}
+
+void FmmLevelSetSolver3::setBucketWidth(double width) {
+    JET_THROW_INVALID_ARG_IF(!(width > 0.0));
+    _bucketWidth = width;
+}
+
+FmmBucketTrialQueue* FmmLevelSetSolver3::bucketQueue(size_t component) {
+    if (!_isUsingBucketedQueue) {
+        return nullptr;
+    }
+
+    if (_bucketQueues[component] == nullptr) {
+        _bucketQueues[component].reset(new FmmBucketTrialQueue());
+    }
+    return _bucketQueues[component].get();
+}
+
+double FmmLevelSetSolver3::bucketWidth(const Vector3D& gridSpacing) const {
+    return _bucketWidth * gridSpacing.min();
+}
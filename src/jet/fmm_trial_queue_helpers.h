@@ -0,0 +1,179 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_FMM_TRIAL_QUEUE_HELPERS_H_
+#define SRC_JET_FMM_TRIAL_QUEUE_HELPERS_H_
+
+#include <jet/constants.h>
+#include <jet/point3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace jet {
+
+// Number of the buckets in the window of FmmBucketTrialQueue.
+const size_t kFmmNumberOfBuckets = 256;
+
+// Binary heap of the trial cells, which always pops the smallest key.
+class FmmHeapTrialQueue {
+ public:
+    bool empty() const {
+        return _heap.empty();
+    }
+
+    void push(const Point3UI& index, double key) {
+        _heap.push(Entry(key, index));
+    }
+
+    Point3UI pop() {
+        Point3UI index = _heap.top().second;
+        _heap.pop();
+        return index;
+    }
+
+ private:
+    typedef std::pair<double, Point3UI> Entry;
+
+    struct Greater {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.first > b.first;
+        }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, Greater> _heap;
+};
+
+// Untidy priority queue of the trial cells, which sorts the keys only into
+// buckets of a fixed width, so push and pop take O(1). The cells of a bucket
+// are popped in any order, which lets the march accept a cell up to a bucket
+// width ahead of its turn. See Rasch and Satzger, "Remarks on the O(N)
+// implementation of the fast marching method", IMA J. Numer. Anal. 2009.
+//
+// The buckets cover a window of keys which is rebased to the smallest key
+// whenever it runs empty, and the keys beyond it wait in an overflow list, so
+// any range of keys is accepted. The cells are linked through a node pool
+// which is kept, with its capacity, between the marches.
+class FmmBucketTrialQueue {
+ public:
+    FmmBucketTrialQueue() : _heads(kFmmNumberOfBuckets, kMaxSize) {}
+
+    // Empties the queue and sets the bucket width. The pool keeps its
+    // capacity, and at least the given number of nodes is reserved.
+    void reset(double bucketWidth, size_t expectedNumberOfCells) {
+        _width = bucketWidth;
+        _invWidth = 1.0 / bucketWidth;
+        _base = 0.0;
+        _current = kFmmNumberOfBuckets;
+        _size = 0;
+        _freeHead = kMaxSize;
+        _nodes.clear();
+        _nodes.reserve(expectedNumberOfCells);
+        _overflow.clear();
+        std::fill(_heads.begin(), _heads.end(), kMaxSize);
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    void push(const Point3UI& index, double key) {
+        ++_size;
+
+        // No window until the first pop
+        if (_current == kFmmNumberOfBuckets) {
+            _overflow.emplace_back(key, index);
+            return;
+        }
+
+        // The keys behind the current bucket join it
+        double offset = (key - _base) * _invWidth;
+        if (!(offset < static_cast<double>(kFmmNumberOfBuckets))) {
+            _overflow.emplace_back(key, index);
+        } else if (offset < static_cast<double>(_current)) {
+            link(_current, index);
+        } else {
+            link(static_cast<size_t>(offset), index);
+        }
+    }
+
+    Point3UI pop() {
+        for (;;) {
+            if (_current == kFmmNumberOfBuckets) {
+                rebase();
+            } else if (_heads[_current] == kMaxSize) {
+                ++_current;
+            } else {
+                break;
+            }
+        }
+
+        size_t node = _heads[_current];
+        _heads[_current] = _nodes[node].next;
+        _nodes[node].next = _freeHead;
+        _freeHead = node;
+        --_size;
+        return _nodes[node].index;
+    }
+
+ private:
+    struct Node {
+        Point3UI index;
+        size_t next;
+    };
+
+    std::vector<Node> _nodes;
+    std::vector<size_t> _heads;
+    std::vector<std::pair<double, Point3UI>> _overflow;
+    double _width = 1.0;
+    double _invWidth = 1.0;
+    double _base = 0.0;
+    size_t _current = kFmmNumberOfBuckets;
+    size_t _size = 0;
+    size_t _freeHead = kMaxSize;
+
+    void link(size_t bucket, const Point3UI& index) {
+        size_t node;
+        if (_freeHead != kMaxSize) {
+            node = _freeHead;
+            _freeHead = _nodes[node].next;
+        } else {
+            node = _nodes.size();
+            _nodes.push_back(Node());
+        }
+        _nodes[node].index = index;
+        _nodes[node].next = _heads[bucket];
+        _heads[bucket] = node;
+    }
+
+    // Moves the window to the smallest overflow key, which only happens once
+    // the window is empty.
+    void rebase() {
+        double minKey = kMaxD;
+        for (const auto& entry : _overflow) {
+            minKey = std::min(minKey, entry.first);
+        }
+        _base = std::floor(minKey * _invWidth) * _width;
+        _current = 0;
+
+        size_t remaining = 0;
+        for (size_t n = 0; n < _overflow.size(); ++n) {
+            const auto& entry = _overflow[n];
+            double offset = (entry.first - _base) * _invWidth;
+            if (entry.first <= minKey) {
+                link(0, entry.second);
+            } else if (offset < static_cast<double>(kFmmNumberOfBuckets)) {
+                link(static_cast<size_t>(std::max(offset, 0.0)), entry.second);
+            } else {
+                _overflow[remaining++] = entry;
+            }
+        }
+        _overflow.resize(remaining);
+    }
+};
+
+}  // namespace jet
+
+#endif  // SRC_JET_FMM_TRIAL_QUEUE_HELPERS_H_
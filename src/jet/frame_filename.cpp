@@ -0,0 +1,60 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/frame_filename.h>
+
+#include <cctype>
+#include <cstdio>
+#include <vector>
+
+namespace jet {
+
+namespace {
+
+// Finds the "%[0-9]*d" field of the pattern and returns false unless it is
+// the only '%' in the pattern.
+bool findFrameField(const std::string& pattern, size_t* begin, size_t* end) {
+    size_t percent = pattern.find('%');
+    if (percent == std::string::npos) {
+        return false;
+    }
+
+    size_t i = percent + 1;
+    while (i < pattern.size()
+           && std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+        ++i;
+    }
+    if (i == pattern.size() || pattern[i] != 'd') {
+        return false;
+    }
+    if (pattern.find('%', i + 1) != std::string::npos) {
+        return false;
+    }
+
+    *begin = percent;
+    *end = i + 1;
+    return true;
+}
+
+}  // namespace
+
+bool isFrameFilenamePattern(const std::string& pattern) {
+    size_t begin, end;
+    return findFrameField(pattern, &begin, &end);
+}
+
+std::string frameFilename(const std::string& pattern, int frame) {
+    size_t begin = 0, end = 0;
+    JET_THROW_INVALID_ARG_IF(!findFrameField(pattern, &begin, &end));
+
+    // Only the validated field is used as the format
+    const std::string field = pattern.substr(begin, end - begin);
+    int length = snprintf(nullptr, 0, field.c_str(), frame);
+    JET_THROW_INVALID_ARG_IF(length < 0);
+    std::vector<char> number(static_cast<size_t>(length) + 1);
+    snprintf(number.data(), number.size(), field.c_str(), frame);
+
+    return pattern.substr(0, begin) + number.data() + pattern.substr(end);
+}
+
+}  // namespace jet
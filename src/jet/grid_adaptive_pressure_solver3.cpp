@@ -0,0 +1,572 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/grid_adaptive_pressure_solver3.h>
+#include <jet/grid_blocked_boundary_condition_solver3.h>
+#include <jet/level_set_utils.h>
+#include <jet/memory_tracker.h>
+#include <jet/parallel.h>
+#include <fdm_compression_helpers.h>
+#include <grid_pressure_solver_helpers.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const char kFluid = 0;
+const char kAir = 1;
+const char kBoundary = 2;
+
+const double kDefaultTolerance = 1e-6;
+
+// Relative tolerance of the local solves inside the coarse leaves.
+const double kLocalTolerance = 1e-10;
+
+const unsigned int kMaxLevelLimit = 8;
+
+// Appends value to the element of the column in the row, whose columns are
+// kept in ascending order. A coarse leaf meets the same neighbor through
+// many faces, so the row stays much shorter than the number of the faces.
+void addCoupling(
+    size_t column,
+    double value,
+    size_t* columns,
+    double* values,
+    size_t* length) {
+    size_t* last = columns + *length;
+    size_t* pos = std::lower_bound(columns, last, column);
+    size_t offset = static_cast<size_t>(pos - columns);
+    if (pos != last && *pos == column) {
+        values[offset] += value;
+        return;
+    }
+
+    for (size_t m = *length; m > offset; --m) {
+        columns[m] = columns[m - 1];
+        values[m] = values[m - 1];
+    }
+    columns[offset] = column;
+    values[offset] = value;
+    ++(*length);
+}
+
+}  // namespace
+
+GridAdaptivePressureSolver3::GridAdaptivePressureSolver3() {
+    _systemSolver = std::make_shared<FdmIccgSolver3>(100, kDefaultTolerance);
+}
+
+GridAdaptivePressureSolver3::~GridAdaptivePressureSolver3() {
+}
+
+void GridAdaptivePressureSolver3::solve(
+    const FaceCenteredGrid3& input,
+    double timeIntervalInSeconds,
+    FaceCenteredGrid3* output,
+    const ScalarField3& boundarySdf,
+    const ScalarField3& fluidSdf) {
+    UNUSED_VARIABLE(timeIntervalInSeconds);
+    MemoryTagScope scope(MemoryTag::LinearSystem);
+    _lastMaxVelocity = -1.0;
+
+    buildMarkers(input, boundarySdf, fluidSdf);
+    buildLeaves();
+    buildSystem(input);
+
+    if (_systemSolver == nullptr) {
+        return;
+    }
+
+    {
+        MemoryTagScope solverScope(MemoryTag::LinearSolver);
+        _systemSolver->solveCompressed(&_system);
+    }
+
+    _pressure.resize(input.resolution());
+    _pressure.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t leaf = _leafIndices(i, j, k);
+        _pressure(i, j, k) = (leaf != kMaxSize) ? _system.x[leaf] : 0.0;
+    });
+
+    applyPressureGradient(input, output);
+    correctCoarseLeaves(input, output);
+
+    Size3 size = input.resolution();
+    auto u0 = output->uAccessor();
+    auto v0 = output->vAccessor();
+    auto w0 = output->wAccessor();
+    _lastMaxVelocity = parallelReduce(
+        kZeroSize,
+        size.z,
+        0.0,
+        [&](size_t kBegin, size_t kEnd, double partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    for (size_t i = 0; i < size.x; ++i) {
+                        partial = std::max(
+                            partial, maxAbsFaceVelocity(u0, v0, w0, i, j, k));
+                    }
+                }
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
+}
+
+GridBoundaryConditionSolver3Ptr
+GridAdaptivePressureSolver3::suggestedBoundaryConditionSolver() const {
+    return std::make_shared<GridBlockedBoundaryConditionSolver3>();
+}
+
+void GridAdaptivePressureSolver3::setLinearSystemSolver(
+    const FdmLinearSystemSolver3Ptr& solver) {
+    JET_THROW_INVALID_ARG_IF(
+        solver != nullptr && !solver->isCompressedSystemSupported());
+    _systemSolver = solver;
+}
+
+unsigned int GridAdaptivePressureSolver3::maxLevel() const {
+    return _maxLevel;
+}
+
+void GridAdaptivePressureSolver3::setMaxLevel(unsigned int level) {
+    JET_THROW_INVALID_ARG_IF(level > kMaxLevelLimit);
+    _maxLevel = level;
+}
+
+double GridAdaptivePressureSolver3::surfaceBandWidth() const {
+    return _surfaceBandWidth;
+}
+
+void GridAdaptivePressureSolver3::setSurfaceBandWidth(double width) {
+    JET_THROW_INVALID_ARG_IF(!(width >= 1.0));
+    _surfaceBandWidth = width;
+}
+
+const FdmVector3& GridAdaptivePressureSolver3::pressure() const {
+    return _pressure;
+}
+
+size_t GridAdaptivePressureSolver3::numberOfUnknowns() const {
+    return _leafOrigins.size();
+}
+
+size_t GridAdaptivePressureSolver3::numberOfFluidCells() const {
+    return _numberOfFluidCells;
+}
+
+unsigned int GridAdaptivePressureSolver3::lastNumberOfIterations() const {
+    return (_systemSolver != nullptr)
+        ? _systemSolver->lastNumberOfIterations() : 0;
+}
+
+double GridAdaptivePressureSolver3::lastResidual() const {
+    return (_systemSolver != nullptr) ? _systemSolver->lastResidual() : 0.0;
+}
+
+double GridAdaptivePressureSolver3::lastMaxVelocity() const {
+    return _lastMaxVelocity;
+}
+
+void GridAdaptivePressureSolver3::buildMarkers(
+    const FaceCenteredGrid3& input,
+    const ScalarField3& boundarySdf,
+    const ScalarField3& fluidSdf) {
+    Size3 size = input.resolution();
+    auto pos = input.cellCenterPosition();
+
+    // The depth is measured in the largest spacing so that it is never
+    // overestimated for non-cubic cells
+    const Vector3D& h = input.gridSpacing();
+    double invHMax = 1.0 / max3(h.x, h.y, h.z);
+
+    _markers.resize(size);
+    _depths.resize(size);
+    _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = pos(i, j, k);
+        _depths(i, j, k) = 0.0;
+        if (isInsideSdf(boundarySdf.sample(pt))) {
+            _markers(i, j, k) = kBoundary;
+            return;
+        }
+
+        double phi = fluidSdf.sample(pt);
+        if (isInsideSdf(phi)) {
+            _markers(i, j, k) = kFluid;
+            _depths(i, j, k) = -phi * invHMax;
+        } else {
+            _markers(i, j, k) = kAir;
+        }
+    });
+}
+
+void GridAdaptivePressureSolver3::buildLeaves() {
+    Size3 size = _markers.size();
+    _levels.resize(size);
+    _levels.set(0);
+
+    // Coarsest first, so that a block only takes the cells that no larger
+    // block has taken. The blocks of a level are disjoint.
+    for (unsigned int level = _maxLevel; level > 0; --level) {
+        size_t s = size_t(1) << level;
+        Size3 blocks(size.x / s, size.y / s, size.z / s);
+        double minDepth = _surfaceBandWidth * static_cast<double>(s);
+        char levelMarker = static_cast<char>(level);
+
+        parallelFor(
+            kZeroSize,
+            blocks.x * blocks.y * blocks.z,
+            [&](size_t block) {
+                size_t i0 = s * (block % blocks.x);
+                size_t j0 = s * ((block / blocks.x) % blocks.y);
+                size_t k0 = s * (block / (blocks.x * blocks.y));
+
+                for (size_t k = k0; k < k0 + s; ++k) {
+                    for (size_t j = j0; j < j0 + s; ++j) {
+                        for (size_t i = i0; i < i0 + s; ++i) {
+                            if (_markers(i, j, k) != kFluid
+                                || _levels(i, j, k) != 0
+                                || !(_depths(i, j, k) >= minDepth)) {
+                                return;
+                            }
+                        }
+                    }
+                }
+
+                for (size_t k = k0; k < k0 + s; ++k) {
+                    for (size_t j = j0; j < j0 + s; ++j) {
+                        for (size_t i = i0; i < i0 + s; ++i) {
+                            _levels(i, j, k) = levelMarker;
+                        }
+                    }
+                }
+            });
+    }
+
+    // A leaf is numbered at its lowest cell, which is the only cell of the
+    // leaf that is aligned to the leaf size
+    _numberOfFluidCells = 0;
+    size_t numberOfLeaves = buildCompressedIndices(
+        size,
+        [&](size_t i, size_t j, size_t k) {
+            if (_markers(i, j, k) != kFluid) {
+                return false;
+            }
+            ++_numberOfFluidCells;
+            size_t mask = (size_t(1) << _levels(i, j, k)) - 1;
+            return ((i | j | k) & mask) == 0;
+        },
+        &_leafIndices);
+
+    _leafOrigins.resize(numberOfLeaves);
+    _leafIndices.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t leaf = _leafIndices(i, j, k);
+        if (leaf != kMaxSize) {
+            _leafOrigins[leaf] = Point3UI(i, j, k);
+        }
+    });
+
+    _coarseLeaves.clear();
+    for (size_t leaf = 0; leaf < numberOfLeaves; ++leaf) {
+        const Point3UI& o = _leafOrigins[leaf];
+        if (_levels(o.x, o.y, o.z) > 0) {
+            _coarseLeaves.push_back(leaf);
+        }
+    }
+
+    // Spread the index of each coarse leaf over its cells
+    parallelFor(kZeroSize, _coarseLeaves.size(), [&](size_t c) {
+        size_t leaf = _coarseLeaves[c];
+        const Point3UI& o = _leafOrigins[leaf];
+        size_t s = size_t(1) << _levels(o.x, o.y, o.z);
+        for (size_t k = o.z; k < o.z + s; ++k) {
+            for (size_t j = o.y; j < o.y + s; ++j) {
+                for (size_t i = o.x; i < o.x + s; ++i) {
+                    _leafIndices(i, j, k) = leaf;
+                }
+            }
+        }
+    });
+}
+
+void GridAdaptivePressureSolver3::buildSystem(
+    const FaceCenteredGrid3& input) {
+    Size3 size = input.resolution();
+    const Vector3D& h = input.gridSpacing();
+    Vector3D invHSqr = 1.0 / (h * h);
+    size_t numberOfLeaves = _leafOrigins.size();
+
+    _divergence.resize(size);
+    input.computeDivergence(_divergence.accessor());
+
+    // Each row gets the room for a coupling per face of its leaf plus the
+    // diagonal, and is compacted once all rows are built
+    std::vector<size_t> offsets(numberOfLeaves + 1, 0);
+    for (size_t leaf = 0; leaf < numberOfLeaves; ++leaf) {
+        const Point3UI& o = _leafOrigins[leaf];
+        size_t s = size_t(1) << _levels(o.x, o.y, o.z);
+        offsets[leaf + 1] = offsets[leaf] + 6 * s * s + 1;
+    }
+
+    std::vector<size_t> columns(offsets.back());
+    std::vector<double> values(offsets.back());
+    std::vector<size_t> lengths(numberOfLeaves);
+
+    _system.x.resize(numberOfLeaves);
+    _system.b.resize(numberOfLeaves);
+
+    parallelFor(kZeroSize, numberOfLeaves, [&](size_t leaf) {
+        const Point3UI& o = _leafOrigins[leaf];
+        size_t s = size_t(1) << _levels(o.x, o.y, o.z);
+        double sizeA = static_cast<double>(s);
+
+        size_t* rowColumns = columns.data() + offsets[leaf];
+        double* rowValues = values.data() + offsets[leaf];
+        size_t length = 0;
+        double diagonal = 0.0;
+
+        double sum = 0.0;
+        for (size_t k = o.z; k < o.z + s; ++k) {
+            for (size_t j = o.y; j < o.y + s; ++j) {
+                for (size_t i = o.x; i < o.x + s; ++i) {
+                    sum += _divergence(i, j, k);
+                }
+            }
+        }
+        _system.b[leaf] = sum;
+
+        // Flux through a face between the leaf and the cell (i, j, k) over
+        // the distance between the centers of the leaf and the neighbor,
+        // which is the cell itself for the atmosphere
+        auto addFace = [&](size_t i, size_t j, size_t k, double invHSqrAxis) {
+            char marker = _markers(i, j, k);
+            if (marker == kBoundary) {
+                return;
+            }
+
+            double sizeB = (marker == kFluid)
+                ? static_cast<double>(size_t(1) << _levels(i, j, k)) : 1.0;
+            double coef = 2.0 * invHSqrAxis / (sizeA + sizeB);
+            diagonal += coef;
+            if (marker == kFluid) {
+                addCoupling(
+                    _leafIndices(i, j, k),
+                    -coef,
+                    rowColumns,
+                    rowValues,
+                    &length);
+            }
+        };
+
+        for (size_t a = 0; a < s; ++a) {
+            for (size_t b = 0; b < s; ++b) {
+                if (o.x > 0) {
+                    addFace(o.x - 1, o.y + a, o.z + b, invHSqr.x);
+                }
+                if (o.x + s < size.x) {
+                    addFace(o.x + s, o.y + a, o.z + b, invHSqr.x);
+                }
+                if (o.y > 0) {
+                    addFace(o.x + a, o.y - 1, o.z + b, invHSqr.y);
+                }
+                if (o.y + s < size.y) {
+                    addFace(o.x + a, o.y + s, o.z + b, invHSqr.y);
+                }
+                if (o.z > 0) {
+                    addFace(o.x + a, o.y + b, o.z - 1, invHSqr.z);
+                }
+                if (o.z + s < size.z) {
+                    addFace(o.x + a, o.y + b, o.z + s, invHSqr.z);
+                }
+            }
+        }
+
+        addCoupling(leaf, diagonal, rowColumns, rowValues, &length);
+        lengths[leaf] = length;
+    });
+
+    FdmCompressedMatrix& A = _system.A;
+    A.rowPointers.resize(numberOfLeaves + 1);
+    A.rowPointers[0] = 0;
+    for (size_t leaf = 0; leaf < numberOfLeaves; ++leaf) {
+        A.rowPointers[leaf + 1] = A.rowPointers[leaf] + lengths[leaf];
+    }
+
+    A.nonZeros.resize(A.rowPointers.back());
+    A.columnIndices.resize(A.rowPointers.back());
+    parallelFor(kZeroSize, numberOfLeaves, [&](size_t leaf) {
+        std::copy(
+            columns.begin() + offsets[leaf],
+            columns.begin() + offsets[leaf] + lengths[leaf],
+            A.columnIndices.begin() + A.rowPointers[leaf]);
+        std::copy(
+            values.begin() + offsets[leaf],
+            values.begin() + offsets[leaf] + lengths[leaf],
+            A.nonZeros.begin() + A.rowPointers[leaf]);
+    });
+
+    _system.x.set(0.0);
+}
+
+void GridAdaptivePressureSolver3::applyPressureGradient(
+    const FaceCenteredGrid3& input,
+    FaceCenteredGrid3* output) {
+    Size3 size = input.resolution();
+    auto u = input.uConstAccessor();
+    auto v = input.vConstAccessor();
+    auto w = input.wConstAccessor();
+    auto u0 = output->uAccessor();
+    auto v0 = output->vAccessor();
+    auto w0 = output->wAccessor();
+
+    Vector3D invH = 1.0 / input.gridSpacing();
+
+    // Same as GridSinglePhasePressureSolver3 except that the faces inside a
+    // leaf are skipped, and the gradient is taken over the distance between
+    // the centers of the leaves
+    auto gradient = [&](
+        size_t leaf, double sizeC, double pC, size_t i, size_t j, size_t k) {
+        char marker = _markers(i, j, k);
+        if (marker == kFluid && _leafIndices(i, j, k) == leaf) {
+            return 0.0;
+        }
+
+        double sizeN = (marker == kFluid)
+            ? static_cast<double>(size_t(1) << _levels(i, j, k)) : 1.0;
+        return 2.0 / (sizeC + sizeN) * (_pressure(i, j, k) - pC);
+    };
+
+    _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_markers(i, j, k) != kFluid) {
+            return;
+        }
+
+        size_t leaf = _leafIndices(i, j, k);
+        double sizeC = static_cast<double>(size_t(1) << _levels(i, j, k));
+        double pC = _pressure(i, j, k);
+
+        if (i + 1 < size.x && _markers(i + 1, j, k) != kBoundary) {
+            u0(i + 1, j, k)
+                = u(i + 1, j, k)
+                + invH.x * gradient(leaf, sizeC, pC, i + 1, j, k);
+        }
+        if (j + 1 < size.y && _markers(i, j + 1, k) != kBoundary) {
+            v0(i, j + 1, k)
+                = v(i, j + 1, k)
+                + invH.y * gradient(leaf, sizeC, pC, i, j + 1, k);
+        }
+        if (k + 1 < size.z && _markers(i, j, k + 1) != kBoundary) {
+            w0(i, j, k + 1)
+                = w(i, j, k + 1)
+                + invH.z * gradient(leaf, sizeC, pC, i, j, k + 1);
+        }
+    });
+}
+
+void GridAdaptivePressureSolver3::correctCoarseLeaves(
+    const FaceCenteredGrid3& input,
+    FaceCenteredGrid3* output) {
+    auto u = input.uConstAccessor();
+    auto v = input.vConstAccessor();
+    auto w = input.wConstAccessor();
+    auto u0 = output->uAccessor();
+    auto v0 = output->vAccessor();
+    auto w0 = output->wAccessor();
+
+    Vector3D invH = 1.0 / input.gridSpacing();
+    Vector3D invHSqr = invH * invH;
+
+    // The leaves do not share the inner faces, so each chunk corrects its
+    // leaves independently with its own scratch vectors
+    parallelRangeFor(
+        kZeroSize,
+        _coarseLeaves.size(),
+        [&](size_t begin, size_t end) {
+            std::vector<double> rhs, q, r, p, ap;
+
+            for (size_t c = begin; c < end; ++c) {
+                const Point3UI& o = _leafOrigins[_coarseLeaves[c]];
+                size_t s = size_t(1) << _levels(o.x, o.y, o.z);
+                size_t count = s * s * s;
+
+                // The faces on the leaf boundary are final, and the inner
+                // faces start from the input
+                for (size_t k = o.z; k < o.z + s; ++k) {
+                    for (size_t j = o.y; j < o.y + s; ++j) {
+                        for (size_t i = o.x; i < o.x + s; ++i) {
+                            if (i > o.x) {
+                                u0(i, j, k) = u(i, j, k);
+                            }
+                            if (j > o.y) {
+                                v0(i, j, k) = v(i, j, k);
+                            }
+                            if (k > o.z) {
+                                w0(i, j, k) = w(i, j, k);
+                            }
+                        }
+                    }
+                }
+
+                rhs.resize(count);
+                double mean = 0.0;
+                for (size_t z = 0; z < s; ++z) {
+                    for (size_t y = 0; y < s; ++y) {
+                        for (size_t x = 0; x < s; ++x) {
+                            size_t i = o.x + x, j = o.y + y, k = o.z + z;
+                            double div
+                                = (u0(i + 1, j, k) - u0(i, j, k)) * invH.x
+                                + (v0(i, j + 1, k) - v0(i, j, k)) * invH.y
+                                + (w0(i, j, k + 1) - w0(i, j, k)) * invH.z;
+                            rhs[x + s * (y + s * z)] = div;
+                            mean += div;
+                        }
+                    }
+                }
+
+                // The leaf faces already balance the total divergence up to
+                // the tolerance of the global solve, which is left as is
+                mean /= static_cast<double>(count);
+                for (double& value : rhs) {
+                    value -= mean;
+                }
+
+                solveBlockPoisson(
+                    Size3(s, s, s),
+                    invHSqr,
+                    std::vector<char>(),
+                    rhs,
+                    kLocalTolerance,
+                    &q,
+                    &r,
+                    &p,
+                    &ap);
+
+                for (size_t z = 0; z < s; ++z) {
+                    for (size_t y = 0; y < s; ++y) {
+                        for (size_t x = 0; x < s; ++x) {
+                            size_t l = x + s * (y + s * z);
+                            size_t i = o.x + x, j = o.y + y, k = o.z + z;
+                            if (x + 1 < s) {
+                                u0(i + 1, j, k) += invH.x * (q[l + 1] - q[l]);
+                            }
+                            if (y + 1 < s) {
+                                v0(i, j + 1, k) += invH.y * (q[l + s] - q[l]);
+                            }
+                            if (z + 1 < s) {
+                                w0(i, j, k + 1)
+                                    += invH.z * (q[l + s * s] - q[l]);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+}
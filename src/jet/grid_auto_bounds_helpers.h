@@ -0,0 +1,47 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_GRID_AUTO_BOUNDS_HELPERS_H_
+#define SRC_JET_GRID_AUTO_BOUNDS_HELPERS_H_
+
+#include <jet/bounding_box3.h>
+#include <jet/constants.h>
+#include <jet/parallel.h>
+#include <jet/size3.h>
+
+namespace jet {
+
+// Bounding box of the centers of the cells for which isActive(i, j, k) is
+// true. The box is empty (reset) if there is no such cell. The z-slices are
+// reduced in parallel, and the result does not depend on their order.
+template <typename Function>
+BoundingBox3D activeCellBounds(
+    const Size3& resolution,
+    const Vector3D& gridSpacing,
+    const Vector3D& origin,
+    const Function& isActive) {
+    return parallelReduce(
+        kZeroSize,
+        resolution.z,
+        BoundingBox3D(),
+        [&](size_t kBegin, size_t kEnd, BoundingBox3D box) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < resolution.y; ++j) {
+                    for (size_t i = 0; i < resolution.x; ++i) {
+                        if (isActive(i, j, k)) {
+                            box.merge(origin + gridSpacing * Vector3D(
+                                i + 0.5, j + 0.5, k + 0.5));
+                        }
+                    }
+                }
+            }
+            return box;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_GRID_AUTO_BOUNDS_HELPERS_H_
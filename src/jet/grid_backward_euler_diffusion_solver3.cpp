@@ -6,6 +6,10 @@
 #include <jet/fdm_iccg_solver3.h>
 #include <jet/fdm_utils.h>
 #include <jet/level_set_utils.h>
+#include <jet/memory_tracker.h>
+#include <fdm_compression_helpers.h>
+
+#include <algorithm>
 
 using namespace jet;
 
@@ -13,6 +17,69 @@ const char kFluid = 0;
 const char kAir = 1;
 const char kBoundary = 2;
 
+namespace {
+
+// Row of the matrix of a cell with the couplings to all six neighbors, so
+// that both the full and the compressed matrices are built from it.
+struct Stencil {
+    double center = 1.0;
+    double left = 0.0;
+    double right = 0.0;
+    double down = 0.0;
+    double up = 0.0;
+    double back = 0.0;
+    double front = 0.0;
+};
+
+Stencil buildStencil(
+    const Array3<char>& markers,
+    bool isDirichlet,
+    const Vector3D& c,
+    size_t i,
+    size_t j,
+    size_t k) {
+    Size3 size = markers.size();
+    Stencil stencil;
+
+    if (markers(i, j, k) != kFluid) {
+        return stencil;
+    }
+
+    // The fluid neighbors are coupled, and the solid neighbors hold their
+    // values for the Dirichlet boundary
+    auto addNeighbor = [&](char marker, double coefficient, double* offDiag) {
+        if ((isDirichlet && marker != kAir) || marker == kFluid) {
+            stencil.center += coefficient;
+        }
+        if (marker == kFluid) {
+            *offDiag -= coefficient;
+        }
+    };
+
+    if (i + 1 < size.x) {
+        addNeighbor(markers(i + 1, j, k), c.x, &stencil.right);
+    }
+    if (i > 0) {
+        addNeighbor(markers(i - 1, j, k), c.x, &stencil.left);
+    }
+    if (j + 1 < size.y) {
+        addNeighbor(markers(i, j + 1, k), c.y, &stencil.up);
+    }
+    if (j > 0) {
+        addNeighbor(markers(i, j - 1, k), c.y, &stencil.down);
+    }
+    if (k + 1 < size.z) {
+        addNeighbor(markers(i, j, k + 1), c.z, &stencil.front);
+    }
+    if (k > 0) {
+        addNeighbor(markers(i, j, k - 1), c.z, &stencil.back);
+    }
+
+    return stencil;
+}
+
+}  // namespace
+
 GridBackwardEulerDiffusionSolver3::GridBackwardEulerDiffusionSolver3(
     BoundaryType boundaryType) : _boundaryType(boundaryType) {
     _systemSolver = std::make_shared<FdmIccgSolver3>(100, kEpsilonD);
@@ -25,17 +92,18 @@ void GridBackwardEulerDiffusionSolver3::solve(
     ScalarGrid3* dest,
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
+    MemoryTagScope scope(MemoryTag::LinearSystem);
     auto pos = source.dataPosition();
     Vector3D h = source.gridSpacing();
     Vector3D c = timeIntervalInSeconds * diffusionCoefficient / (h * h);
 
-    buildMarkers(source.dataSize(), pos, boundarySdf, fluidSdf);
-    buildMatrix(source.dataSize(), c);
+    bool isMatrixReused = buildSystemMatrix(
+        source.dataSize(), pos, boundarySdf, fluidSdf, c);
     buildVectors(source.constDataAccessor(), c);
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(isMatrixReused);
 
         // Assign the solution
         source.parallelForEachDataPointIndex(
@@ -52,19 +120,20 @@ void GridBackwardEulerDiffusionSolver3::solve(
     CollocatedVectorGrid3* dest,
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
+    MemoryTagScope scope(MemoryTag::LinearSystem);
     auto pos = source.dataPosition();
     Vector3D h = source.gridSpacing();
     Vector3D c = timeIntervalInSeconds * diffusionCoefficient / (h * h);
 
-    buildMarkers(source.dataSize(), pos, boundarySdf, fluidSdf);
-    buildMatrix(source.dataSize(), c);
+    bool isMatrixReused = buildSystemMatrix(
+        source.dataSize(), pos, boundarySdf, fluidSdf, c);
 
     // u
     buildVectors(source.constDataAccessor(), c, 0);
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(isMatrixReused);
 
         // Assign the solution
         source.parallelForEachDataPointIndex(
@@ -78,7 +147,7 @@ void GridBackwardEulerDiffusionSolver3::solve(
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(true);
 
         // Assign the solution
         source.parallelForEachDataPointIndex(
@@ -92,7 +161,7 @@ void GridBackwardEulerDiffusionSolver3::solve(
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(true);
 
         // Assign the solution
         source.parallelForEachDataPointIndex(
@@ -109,18 +178,19 @@ void GridBackwardEulerDiffusionSolver3::solve(
     FaceCenteredGrid3* dest,
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
+    MemoryTagScope scope(MemoryTag::LinearSystem);
     Vector3D h = source.gridSpacing();
     Vector3D c = timeIntervalInSeconds * diffusionCoefficient / (h * h);
 
     // u
     auto uPos = source.uPosition();
-    buildMarkers(source.uSize(), uPos, boundarySdf, fluidSdf);
-    buildMatrix(source.uSize(), c);
+    bool isMatrixReused = buildSystemMatrix(
+        source.uSize(), uPos, boundarySdf, fluidSdf, c);
     buildVectors(source.uConstAccessor(), c);
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(isMatrixReused);
 
         // Assign the solution
         source.parallelForEachUIndex(
@@ -131,13 +201,13 @@ void GridBackwardEulerDiffusionSolver3::solve(
 
     // v
     auto vPos = source.vPosition();
-    buildMarkers(source.vSize(), vPos, boundarySdf, fluidSdf);
-    buildMatrix(source.vSize(), c);
+    isMatrixReused = buildSystemMatrix(
+        source.vSize(), vPos, boundarySdf, fluidSdf, c);
     buildVectors(source.vConstAccessor(), c);
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(isMatrixReused);
 
         // Assign the solution
         source.parallelForEachVIndex(
@@ -148,13 +218,13 @@ void GridBackwardEulerDiffusionSolver3::solve(
 
     // w
     auto wPos = source.wPosition();
-    buildMarkers(source.wSize(), wPos, boundarySdf, fluidSdf);
-    buildMatrix(source.wSize(), c);
+    isMatrixReused = buildSystemMatrix(
+        source.wSize(), wPos, boundarySdf, fluidSdf, c);
     buildVectors(source.wConstAccessor(), c);
 
     if (_systemSolver != nullptr) {
         // Solve the system
-        _systemSolver->solve(&_system);
+        solveSystem(isMatrixReused);
 
         // Assign the solution
         source.parallelForEachWIndex(
@@ -167,24 +237,93 @@ void GridBackwardEulerDiffusionSolver3::solve(
 void GridBackwardEulerDiffusionSolver3::setLinearSystemSolver(
     const FdmLinearSystemSolver3Ptr& solver) {
     _systemSolver = solver;
+
+    // Let the new solver see the matrix before it is reused
+    _isMatrixValid = false;
+}
+
+bool GridBackwardEulerDiffusionSolver3::isUsingCompressedSystem() const {
+    return _isUsingCompressedSystem;
+}
+
+void GridBackwardEulerDiffusionSolver3::setIsUsingCompressedSystem(
+    bool isUsing) {
+    if (isUsing != _isUsingCompressedSystem) {
+        _isUsingCompressedSystem = isUsing;
+        _isMatrixValid = false;
+    }
+}
+
+bool GridBackwardEulerDiffusionSolver3::buildSystemMatrix(
+    const Size3& size,
+    const std::function<Vector3D(size_t, size_t, size_t)>& pos,
+    const ScalarField3& boundarySdf,
+    const ScalarField3& fluidSdf,
+    const Vector3D& c) {
+    bool isMarkersChanged = buildMarkers(size, pos, boundarySdf, fluidSdf);
+
+    // Solvers without compressed systems, such as the multigrid solvers,
+    // solve the full system instead
+    bool isCompressed = _isUsingCompressedSystem
+        && _systemSolver != nullptr
+        && _systemSolver->isCompressedSystemSupported();
+
+    if (_isMatrixValid
+        && !isMarkersChanged
+        && c == _matrixCoefficient
+        && isCompressed == _isMatrixCompressed) {
+        return true;
+    }
+
+    if (isCompressed) {
+        _system.A.clear();
+        buildCompressedMatrix(c);
+    } else {
+        buildMatrix(size, c);
+    }
+    _isMatrixCompressed = isCompressed;
+    _matrixCoefficient = c;
+    _isMatrixValid = true;
+    return false;
+}
+
+void GridBackwardEulerDiffusionSolver3::solveSystem(bool isMatrixReused) {
+    MemoryTagScope scope(MemoryTag::LinearSolver);
+    if (_isMatrixCompressed) {
+        solveCompressedSystem();
+    } else if (isMatrixReused) {
+        _systemSolver->solveWithSameMatrix(&_system);
+    } else {
+        _systemSolver->solve(&_system);
+    }
 }
 
-void GridBackwardEulerDiffusionSolver3::buildMarkers(
+bool GridBackwardEulerDiffusionSolver3::buildMarkers(
     const Size3& size,
     const std::function<Vector3D(size_t, size_t, size_t)>& pos,
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
-    _markers.resize(size);
+    _newMarkers.resize(size);
 
-    _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    _newMarkers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
         if (isInsideSdf(boundarySdf.sample(pos(i, j, k)))) {
-            _markers(i, j, k) = kBoundary;
+            _newMarkers(i, j, k) = kBoundary;
         } else if (isInsideSdf(fluidSdf.sample(pos(i, j, k)))) {
-            _markers(i, j, k) = kFluid;
+            _newMarkers(i, j, k) = kFluid;
         } else {
-            _markers(i, j, k) = kAir;
+            _newMarkers(i, j, k) = kAir;
         }
     });
+
+    bool isChanged = (_newMarkers.size() != _markers.size())
+        || !std::equal(
+            _newMarkers.data(),
+            _newMarkers.data() + _newMarkers.width() * _newMarkers.height()
+                * _newMarkers.depth(),
+            _markers.data());
+
+    _markers.swap(_newMarkers);
+    return isChanged;
 }
 
 void GridBackwardEulerDiffusionSolver3::buildMatrix(
@@ -197,63 +336,51 @@ void GridBackwardEulerDiffusionSolver3::buildMatrix(
     // Build linear system
     _system.A.parallelForEachIndex(
         [&](size_t i, size_t j, size_t k) {
+            Stencil stencil = buildStencil(_markers, isDirichlet, c, i, j, k);
             auto& row = _system.A(i, j, k);
+            row.center = stencil.center;
+            row.right = stencil.right;
+            row.up = stencil.up;
+            row.front = stencil.front;
+        });
+}
 
-            // Initialize
-            row.center = 1.0;
-            row.right = row.up = row.front = 0.0;
-
-            if (_markers(i, j, k) == kFluid) {
-                if (i + 1 < size.x) {
-                    if ((isDirichlet && _markers(i + 1, j, k) != kAir)
-                         || _markers(i + 1, j, k) == kFluid) {
-                        row.center += c.x;
-                    }
-
-                    if (_markers(i + 1, j, k) == kFluid) {
-                        row.right -=  c.x;
-                    }
-                }
-
-                if (i > 0
-                    && ((isDirichlet && _markers(i - 1, j, k) != kAir)
-                        || _markers(i - 1, j, k) == kFluid)) {
-                    row.center += c.x;
-                }
-
-                if (j + 1 < size.y) {
-                    if ((isDirichlet && _markers(i, j + 1, k) != kAir)
-                         || _markers(i, j + 1, k) == kFluid) {
-                        row.center += c.y;
-                    }
+void GridBackwardEulerDiffusionSolver3::buildCompressedMatrix(
+    const Vector3D& c) {
+    bool isDirichlet = (_boundaryType == Dirichlet);
 
-                    if (_markers(i, j + 1, k) == kFluid) {
-                        row.up -=  c.y;
-                    }
-                }
+    // The rows of the other cells are the identity, which keeps their input
+    // values, so only the fluid cells are solved for
+    size_t numberOfRows = buildCompressedIndices(
+        _markers.size(),
+        [&](size_t i, size_t j, size_t k) {
+            return _markers(i, j, k) == kFluid;
+        },
+        &_compressedIndices);
 
-                if (j > 0
-                    && ((isDirichlet && _markers(i, j - 1, k) != kAir)
-                        || _markers(i, j - 1, k) == kFluid)) {
-                    row.center += c.y;
-                }
+    jet::buildCompressedMatrix(
+        _compressedIndices,
+        numberOfRows,
+        [&](size_t i, size_t j, size_t k) {
+            return buildStencil(_markers, isDirichlet, c, i, j, k);
+        },
+        &_compressedSystem);
+}
 
-                if (k + 1 < size.z) {
-                    if ((isDirichlet && _markers(i, j, k + 1) != kAir)
-                         || _markers(i, j, k + 1) == kFluid) {
-                        row.center += c.z;
-                    }
+void GridBackwardEulerDiffusionSolver3::solveCompressedSystem() {
+    if (_compressedSystem.A.rows() == 0) {
+        return;
+    }
 
-                    if (_markers(i, j, k + 1) == kFluid) {
-                        row.front -=  c.z;
-                    }
-                }
+    gatherCompressed(_compressedIndices, _system.b, &_compressedSystem.b);
+    _systemSolver->solveCompressed(&_compressedSystem);
 
-                if (k > 0
-                    && ((isDirichlet && _markers(i, j, k - 1) != kAir)
-                        || _markers(i, j, k - 1) == kFluid)) {
-                    row.center += c.z;
-                }
+    // The other cells keep the input values that buildVectors() put into x
+    _compressedIndices.parallelForEachIndex(
+        [&](size_t i, size_t j, size_t k) {
+            size_t index = _compressedIndices(i, j, k);
+            if (index != kMaxSize) {
+                _system.x(i, j, k) = _compressedSystem.x[index];
             }
         });
 }
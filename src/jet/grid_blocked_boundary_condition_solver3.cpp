@@ -1,6 +1,7 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <grid_boundary_condition_helpers.h>
 #include <physics_helpers.h>
 #include <jet/array_utils.h>
 #include <jet/grid_blocked_boundary_condition_solver3.h>
@@ -10,9 +11,6 @@
 
 using namespace jet;
 
-static const char kFluid = 1;
-static const char kCollider = 0;
-
 GridBlockedBoundaryConditionSolver3::GridBlockedBoundaryConditionSolver3() {
 }
 
@@ -22,8 +20,8 @@ void GridBlockedBoundaryConditionSolver3::constrainVelocity(
     GridFractionalBoundaryConditionSolver3::constrainVelocity(
         velocity, extrapolationDepth);
 
-    // No-flux: project the velocity at the marker interface
-    Size3 size = velocity->resolution();
+    // No-flux: project the velocity at the marker interface, which is
+    // listed when the collider is updated
     auto u = velocity->uAccessor();
     auto v = velocity->vAccessor();
     auto w = velocity->wAccessor();
@@ -31,40 +29,24 @@ void GridBlockedBoundaryConditionSolver3::constrainVelocity(
     auto vPos = velocity->vPosition();
     auto wPos = velocity->wPosition();
 
-    _marker.forEachIndex([&](size_t i, size_t j, size_t k) {
-        if (_marker(i, j, k) == kCollider) {
-            if (i > 0 && _marker(i - 1, j, k) == kFluid) {
-                Vector3D colliderVel = collider()->velocityAt(uPos(i, j, k));
-                u(i, j, k) = colliderVel.x;
-            }
-            if (i < size.x - 1 && _marker(i + 1, j, k) == kFluid) {
-                Vector3D colliderVel
-                    = collider()->velocityAt(uPos(i + 1, j, k));
-                u(i + 1, j, k) = colliderVel.x;
-            }
-            if (j > 0 && _marker(i, j - 1, k) == kFluid) {
-                Vector3D colliderVel = collider()->velocityAt(vPos(i, j, k));
-                v(i, j, k) = colliderVel.y;
-            }
-            if (j < size.y - 1 && _marker(i, j + 1, k) == kFluid) {
-                Vector3D colliderVel
-                    = collider()->velocityAt(vPos(i, j + 1, k));
-                v(i, j + 1, k) = colliderVel.y;
-            }
-            if (k > 0 && _marker(i, j, k - 1) == kFluid) {
-                Vector3D colliderVel = collider()->velocityAt(wPos(i, j, k));
-                w(i, j, k) = colliderVel.z;
-            }
-            if (k < size.z - 1 && _marker(i, j, k + 1) == kFluid) {
-                Vector3D colliderVel
-                    = collider()->velocityAt(wPos(i, j, k + 1));
-                w(i, j, k + 1) = colliderVel.z;
-            }
-        }
-    });
+    parallelForEachGridIndex(
+        u.size(), _interfaceFaces[0],
+        [&](size_t, size_t i, size_t j, size_t k) {
+            u(i, j, k) = collider()->velocityAt(uPos(i, j, k)).x;
+        });
+    parallelForEachGridIndex(
+        v.size(), _interfaceFaces[1],
+        [&](size_t, size_t i, size_t j, size_t k) {
+            v(i, j, k) = collider()->velocityAt(vPos(i, j, k)).y;
+        });
+    parallelForEachGridIndex(
+        w.size(), _interfaceFaces[2],
+        [&](size_t, size_t i, size_t j, size_t k) {
+            w(i, j, k) = collider()->velocityAt(wPos(i, j, k)).z;
+        });
 }
 
-const Array3<char>& GridBlockedBoundaryConditionSolver3::marker() const {
+const BitArray3& GridBlockedBoundaryConditionSolver3::marker() const {
     return _marker;
 }
 
@@ -78,11 +60,27 @@ void GridBlockedBoundaryConditionSolver3::onColliderUpdated(
     const CellCenteredScalarGrid3& sdf = colliderSdf();
 
     _marker.resize(gridSize);
-    _marker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        if (isInsideSdf(sdf(i, j, k))) {
-            _marker(i, j, k) = kCollider;
-        } else {
-            _marker(i, j, k) = kFluid;
-        }
+    _marker.parallelSet([&](size_t i, size_t j, size_t k) {
+        return isInsideSdf(sdf(i, j, k));
     });
+
+    // An interior face is on the interface if one of its cells is inside
+    // the collider and the other one is not
+    for (size_t c = 0; c < 3; ++c) {
+        Size3 faceSize = gridSize;
+        ++faceSize[c];
+
+        collectGridIndices(
+            faceSize,
+            [&](size_t i, size_t j, size_t k) {
+                size_t index[3] = { i, j, k };
+                if (index[c] == 0 || index[c] == gridSize[c]) {
+                    return false;
+                }
+                --index[c];
+                return _marker(i, j, k)
+                    != _marker(index[0], index[1], index[2]);
+            },
+            &_interfaceFaces[c]);
+    }
 }
@@ -0,0 +1,53 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_GRID_BOUNDARY_CONDITION_HELPERS_H_
+#define SRC_JET_GRID_BOUNDARY_CONDITION_HELPERS_H_
+
+#include <jet/constants.h>
+#include <jet/parallel.h>
+#include <jet/size3.h>
+
+#include <vector>
+
+namespace jet {
+
+// Stores the linear indices, i + size.x * (j + size.y * k), of the points of
+// a grid of given size for which func(i, j, k) is true, in increasing order.
+// The boundary condition solvers list the faces near the collider once per
+// collider update, so that each constraint only visits those faces.
+template <typename Function>
+void collectGridIndices(
+    const Size3& size,
+    const Function& func,
+    std::vector<size_t>* indices) {
+    size_t numberOfPoints = size.x * size.y * size.z;
+    indices->resize(numberOfPoints);
+    size_t count = parallelCompact(
+        kZeroSize,
+        numberOfPoints,
+        indices->begin(),
+        [&](size_t n) {
+            return func(n % size.x, (n / size.x) % size.y,
+                        n / (size.x * size.y));
+        });
+    indices->resize(count);
+    indices->shrink_to_fit();
+}
+
+// Calls func(n, i, j, k) in parallel for the n-th of the linear indices
+// stored by collectGridIndices.
+template <typename Function>
+void parallelForEachGridIndex(
+    const Size3& size,
+    const std::vector<size_t>& indices,
+    const Function& func) {
+    parallelFor(kZeroSize, indices.size(), [&](size_t n) {
+        size_t index = indices[n];
+        func(n, index % size.x, (index / size.x) % size.y,
+             index / (size.x * size.y));
+    });
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_GRID_BOUNDARY_CONDITION_HELPERS_H_
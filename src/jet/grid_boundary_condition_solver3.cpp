@@ -20,7 +20,22 @@ void GridBoundaryConditionSolver3::updateCollider(
     const Size3& gridSize,
     const Vector3D& gridSpacing,
     const Vector3D& gridOrigin) {
+    // Boundary markers of a static collider on an unchanged grid are still
+    // valid from the last update.
+    uint64_t colliderVersion
+        = (newCollider != nullptr) ? newCollider->version() : 0;
+    if (_isColliderUpdated
+        && _collider == newCollider
+        && _colliderVersion == colliderVersion
+        && _gridSize == gridSize
+        && _gridSpacing == gridSpacing
+        && _gridOrigin == gridOrigin) {
+        return;
+    }
+
     _collider = newCollider;
+    _colliderVersion = colliderVersion;
+    _isColliderUpdated = true;
     _gridSize = gridSize;
     _gridSpacing = gridSpacing;
     _gridOrigin = gridOrigin;
@@ -0,0 +1,482 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/grid_cache3.h>
+#include <jet/parallel.h>
+#include <mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const char kGridCacheTag[] = "JETGCACH";
+const size_t kGridCacheTagLength = 8;
+const uint32_t kGridCacheVersion = 1;
+const size_t kGridCacheNameLength = 48;
+const size_t kGridCacheDataAlignment = 64;
+const size_t kGridCacheMaxNumberOfArrays = 3;
+
+const uint32_t kGridCacheScalarGrid = 1;
+const uint32_t kGridCacheVectorGrid = 2;
+const uint32_t kGridCacheFaceCenteredGrid = 3;
+
+struct GridCacheHeader {
+    char tag[kGridCacheTagLength];
+    uint32_t version;
+    uint32_t numberOfChannels;
+};
+
+struct GridCacheArrayHeader {
+    uint64_t size[3];
+    double dataOrigin[3];
+    uint64_t dataOffset;
+};
+
+struct GridCacheChannelHeader {
+    char name[kGridCacheNameLength];
+    uint32_t type;
+    uint32_t numberOfArrays;
+    uint64_t resolution[3];
+    double gridSpacing[3];
+    double origin[3];
+    GridCacheArrayHeader arrays[kGridCacheMaxNumberOfArrays];
+};
+
+static_assert(
+    sizeof(GridCacheHeader) == 16,
+    "Unexpected grid cache header size");
+static_assert(
+    sizeof(GridCacheArrayHeader) == 56,
+    "Unexpected grid cache array header size");
+static_assert(
+    sizeof(GridCacheChannelHeader) == 296,
+    "Unexpected grid cache channel header size");
+
+size_t alignOffset(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+size_t elementSize(uint32_t type) {
+    return (type == kGridCacheVectorGrid) ? sizeof(Vector3D) : sizeof(double);
+}
+
+size_t numberOfArrays(uint32_t type) {
+    return (type == kGridCacheFaceCenteredGrid) ? 3 : 1;
+}
+
+void writePadding(std::ostream* strm, size_t from, size_t to) {
+    static const char kZeros[kGridCacheDataAlignment] = {};
+    if (to > from) {
+        strm->write(kZeros, static_cast<std::streamsize>(to - from));
+    }
+}
+
+// Copies the cached array to the grid data slice by slice in parallel
+template <typename T>
+void copyArray(const ConstArrayAccessor3<T>& src, ArrayAccessor3<T> dst) {
+    Size3 size = src.size();
+    size_t sliceSize = size.x * size.y;
+    parallelFor(kZeroSize, size.z, [&](size_t k) {
+        const T* begin = src.data() + k * sliceSize;
+        std::copy(begin, begin + sliceSize, dst.data() + k * sliceSize);
+    });
+}
+
+}  // namespace
+
+void GridCacheWriter3::addScalarGrid(
+    const std::string& name,
+    const ScalarGrid3& grid) {
+    Channel* channel = addChannel(name, kGridCacheScalarGrid, grid);
+    auto data = grid.constDataAccessor();
+    DataArray array;
+    array.size = data.size();
+    array.dataOrigin = grid.dataOrigin();
+    array.data = reinterpret_cast<const char*>(data.data());
+    array.bytes = sizeof(double) * data.size().x * data.size().y
+        * data.size().z;
+    channel->arrays.push_back(array);
+}
+
+void GridCacheWriter3::addVectorGrid(
+    const std::string& name,
+    const CollocatedVectorGrid3& grid) {
+    Channel* channel = addChannel(name, kGridCacheVectorGrid, grid);
+    auto data = grid.constDataAccessor();
+    DataArray array;
+    array.size = data.size();
+    array.dataOrigin = grid.dataOrigin();
+    array.data = reinterpret_cast<const char*>(data.data());
+    array.bytes = sizeof(Vector3D) * data.size().x * data.size().y
+        * data.size().z;
+    channel->arrays.push_back(array);
+}
+
+void GridCacheWriter3::addFaceCenteredGrid(
+    const std::string& name,
+    const FaceCenteredGrid3& grid) {
+    Channel* channel = addChannel(name, kGridCacheFaceCenteredGrid, grid);
+    const FaceCenteredGrid3::ConstScalarDataAccessor data[3] = {
+        grid.uConstAccessor(), grid.vConstAccessor(), grid.wConstAccessor()
+    };
+    const Vector3D dataOrigins[3] = {
+        grid.uOrigin(), grid.vOrigin(), grid.wOrigin()
+    };
+    for (size_t axis = 0; axis < 3; ++axis) {
+        DataArray array;
+        array.size = data[axis].size();
+        array.dataOrigin = dataOrigins[axis];
+        array.data = reinterpret_cast<const char*>(data[axis].data());
+        array.bytes = sizeof(double) * array.size.x * array.size.y
+            * array.size.z;
+        channel->arrays.push_back(array);
+    }
+}
+
+void GridCacheWriter3::write(std::ostream* strm) const {
+    GridCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.tag, kGridCacheTag, kGridCacheTagLength);
+    header.version = kGridCacheVersion;
+    header.numberOfChannels = static_cast<uint32_t>(_channels.size());
+    strm->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // All the channel headers come first, so the data offsets are known
+    // before any data is written
+    size_t offset = sizeof(header)
+        + _channels.size() * sizeof(GridCacheChannelHeader);
+    for (const Channel& channel : _channels) {
+        GridCacheChannelHeader channelHeader;
+        std::memset(&channelHeader, 0, sizeof(channelHeader));
+        std::memcpy(
+            channelHeader.name, channel.name.c_str(), channel.name.size());
+        channelHeader.type = channel.type;
+        channelHeader.numberOfArrays
+            = static_cast<uint32_t>(channel.arrays.size());
+        for (size_t axis = 0; axis < 3; ++axis) {
+            channelHeader.resolution[axis] = channel.resolution[axis];
+            channelHeader.gridSpacing[axis] = channel.gridSpacing[axis];
+            channelHeader.origin[axis] = channel.origin[axis];
+        }
+
+        for (size_t i = 0; i < channel.arrays.size(); ++i) {
+            const DataArray& array = channel.arrays[i];
+            GridCacheArrayHeader& arrayHeader = channelHeader.arrays[i];
+            for (size_t axis = 0; axis < 3; ++axis) {
+                arrayHeader.size[axis] = array.size[axis];
+                arrayHeader.dataOrigin[axis] = array.dataOrigin[axis];
+            }
+
+            offset = alignOffset(offset, kGridCacheDataAlignment);
+            arrayHeader.dataOffset = offset;
+            offset += array.bytes;
+        }
+
+        strm->write(
+            reinterpret_cast<const char*>(&channelHeader),
+            sizeof(channelHeader));
+    }
+
+    offset = sizeof(header)
+        + _channels.size() * sizeof(GridCacheChannelHeader);
+    for (const Channel& channel : _channels) {
+        for (const DataArray& array : channel.arrays) {
+            size_t dataOffset = alignOffset(offset, kGridCacheDataAlignment);
+            writePadding(strm, offset, dataOffset);
+            if (array.bytes > 0) {
+                strm->write(
+                    array.data, static_cast<std::streamsize>(array.bytes));
+            }
+            offset = dataOffset + array.bytes;
+        }
+    }
+}
+
+GridCacheWriter3::Channel* GridCacheWriter3::addChannel(
+    const std::string& name,
+    uint32_t type,
+    const Grid3& grid) {
+    JET_THROW_INVALID_ARG_IF(name.size() >= kGridCacheNameLength);
+
+    Channel channel;
+    channel.name = name;
+    channel.type = type;
+    channel.resolution = grid.resolution();
+    channel.gridSpacing = grid.gridSpacing();
+    channel.origin = grid.origin();
+    _channels.push_back(channel);
+    return &_channels.back();
+}
+
+GridCacheReader3::GridCacheReader3() {
+}
+
+GridCacheReader3::~GridCacheReader3() {
+}
+
+bool GridCacheReader3::open(const std::string& filename) {
+    close();
+
+    std::unique_ptr<MappedFile> file(new MappedFile(filename));
+    if (!file->isValid() || file->size() < sizeof(GridCacheHeader)) {
+        return false;
+    }
+
+    const char* data = file->data();
+    size_t size = file->size();
+
+    GridCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.tag, kGridCacheTag, kGridCacheTagLength) != 0
+        || header.version != kGridCacheVersion) {
+        return false;
+    }
+
+    if (header.numberOfChannels
+        > (size - sizeof(header)) / sizeof(GridCacheChannelHeader)) {
+        return false;
+    }
+    size_t headersEnd = sizeof(header)
+        + header.numberOfChannels * sizeof(GridCacheChannelHeader);
+
+    std::vector<Channel> channels(header.numberOfChannels);
+    for (size_t c = 0; c < channels.size(); ++c) {
+        GridCacheChannelHeader channelHeader;
+        std::memcpy(
+            &channelHeader,
+            data + sizeof(header) + c * sizeof(channelHeader),
+            sizeof(channelHeader));
+
+        uint32_t type = channelHeader.type;
+        if ((type != kGridCacheScalarGrid && type != kGridCacheVectorGrid
+             && type != kGridCacheFaceCenteredGrid)
+            || channelHeader.numberOfArrays != numberOfArrays(type)) {
+            return false;
+        }
+
+        Channel& channel = channels[c];
+        channel.name = std::string(
+            channelHeader.name,
+            strnlen(channelHeader.name, kGridCacheNameLength));
+        channel.type = type;
+        channel.resolution = Size3(
+            static_cast<size_t>(channelHeader.resolution[0]),
+            static_cast<size_t>(channelHeader.resolution[1]),
+            static_cast<size_t>(channelHeader.resolution[2]));
+        channel.gridSpacing = Vector3D(
+            channelHeader.gridSpacing[0],
+            channelHeader.gridSpacing[1],
+            channelHeader.gridSpacing[2]);
+        channel.origin = Vector3D(
+            channelHeader.origin[0],
+            channelHeader.origin[1],
+            channelHeader.origin[2]);
+
+        for (size_t i = 0; i < channelHeader.numberOfArrays; ++i) {
+            const GridCacheArrayHeader& arrayHeader = channelHeader.arrays[i];
+            size_t dataOffset = static_cast<size_t>(arrayHeader.dataOffset);
+            if (arrayHeader.dataOffset < headersEnd
+                || arrayHeader.dataOffset > size
+                || dataOffset % kGridCacheDataAlignment != 0) {
+                return false;
+            }
+
+            // Check the number of elements against the remaining bytes one
+            // axis at a time to avoid overflows
+            size_t maxElements = (size - dataOffset) / elementSize(type);
+            size_t numberOfElements = 1;
+            for (size_t axis = 0; axis < 3; ++axis) {
+                uint64_t n = arrayHeader.size[axis];
+                if (n != 0 && numberOfElements > maxElements / n) {
+                    return false;
+                }
+                numberOfElements *= static_cast<size_t>(n);
+            }
+
+            DataArray array;
+            array.size = Size3(
+                static_cast<size_t>(arrayHeader.size[0]),
+                static_cast<size_t>(arrayHeader.size[1]),
+                static_cast<size_t>(arrayHeader.size[2]));
+            array.dataOrigin = Vector3D(
+                arrayHeader.dataOrigin[0],
+                arrayHeader.dataOrigin[1],
+                arrayHeader.dataOrigin[2]);
+            array.data = data + dataOffset;
+            channel.arrays.push_back(array);
+        }
+    }
+
+    _file = std::move(file);
+    _channels = std::move(channels);
+    return true;
+}
+
+void GridCacheReader3::close() {
+    _file.reset();
+    _channels.clear();
+}
+
+size_t GridCacheReader3::numberOfChannels() const {
+    return _channels.size();
+}
+
+const std::string& GridCacheReader3::channelName(size_t i) const {
+    return _channels[i].name;
+}
+
+bool GridCacheReader3::hasScalarGrid(const std::string& name) const {
+    return findChannel(name, kGridCacheScalarGrid) != nullptr;
+}
+
+bool GridCacheReader3::hasVectorGrid(const std::string& name) const {
+    return findChannel(name, kGridCacheVectorGrid) != nullptr;
+}
+
+bool GridCacheReader3::hasFaceCenteredGrid(const std::string& name) const {
+    return findChannel(name, kGridCacheFaceCenteredGrid) != nullptr;
+}
+
+Size3 GridCacheReader3::resolution(const std::string& name) const {
+    const Channel* channel = findChannel(name);
+    return (channel != nullptr) ? channel->resolution : Size3();
+}
+
+Vector3D GridCacheReader3::gridSpacing(const std::string& name) const {
+    const Channel* channel = findChannel(name);
+    return (channel != nullptr) ? channel->gridSpacing : Vector3D();
+}
+
+Vector3D GridCacheReader3::origin(const std::string& name) const {
+    const Channel* channel = findChannel(name);
+    return (channel != nullptr) ? channel->origin : Vector3D();
+}
+
+Vector3D GridCacheReader3::dataOrigin(
+    const std::string& name,
+    size_t axis) const {
+    const Channel* channel = findChannel(name);
+    if (channel == nullptr || axis >= channel->arrays.size()) {
+        return Vector3D();
+    }
+    return channel->arrays[axis].dataOrigin;
+}
+
+ConstArrayAccessor3<double> GridCacheReader3::scalarData(
+    const std::string& name) const {
+    const Channel* channel = findChannel(name, kGridCacheScalarGrid);
+    if (channel == nullptr) {
+        return ConstArrayAccessor3<double>();
+    }
+    const DataArray& array = channel->arrays[0];
+    return ConstArrayAccessor3<double>(
+        array.size, reinterpret_cast<const double*>(array.data));
+}
+
+ConstArrayAccessor3<Vector3D> GridCacheReader3::vectorData(
+    const std::string& name) const {
+    const Channel* channel = findChannel(name, kGridCacheVectorGrid);
+    if (channel == nullptr) {
+        return ConstArrayAccessor3<Vector3D>();
+    }
+    const DataArray& array = channel->arrays[0];
+    return ConstArrayAccessor3<Vector3D>(
+        array.size, reinterpret_cast<const Vector3D*>(array.data));
+}
+
+ConstArrayAccessor3<double> GridCacheReader3::faceCenteredData(
+    const std::string& name,
+    size_t axis) const {
+    const Channel* channel = findChannel(name, kGridCacheFaceCenteredGrid);
+    if (channel == nullptr || axis >= 3) {
+        return ConstArrayAccessor3<double>();
+    }
+    const DataArray& array = channel->arrays[axis];
+    return ConstArrayAccessor3<double>(
+        array.size, reinterpret_cast<const double*>(array.data));
+}
+
+bool GridCacheReader3::readScalarGrid(
+    const std::string& name,
+    ScalarGrid3* grid) const {
+    const Channel* channel = findChannel(name, kGridCacheScalarGrid);
+    if (channel == nullptr) {
+        return false;
+    }
+
+    grid->resize(channel->resolution, channel->gridSpacing, channel->origin);
+    ConstArrayAccessor3<double> src = scalarData(name);
+    if (grid->dataSize() != src.size()) {
+        return false;
+    }
+    copyArray(src, grid->dataAccessor());
+    return true;
+}
+
+bool GridCacheReader3::readVectorGrid(
+    const std::string& name,
+    CollocatedVectorGrid3* grid) const {
+    const Channel* channel = findChannel(name, kGridCacheVectorGrid);
+    if (channel == nullptr) {
+        return false;
+    }
+
+    grid->resize(channel->resolution, channel->gridSpacing, channel->origin);
+    ConstArrayAccessor3<Vector3D> src = vectorData(name);
+    if (grid->dataSize() != src.size()) {
+        return false;
+    }
+    copyArray(src, grid->dataAccessor());
+    return true;
+}
+
+bool GridCacheReader3::readFaceCenteredGrid(
+    const std::string& name,
+    FaceCenteredGrid3* grid) const {
+    const Channel* channel = findChannel(name, kGridCacheFaceCenteredGrid);
+    if (channel == nullptr) {
+        return false;
+    }
+
+    grid->resize(channel->resolution, channel->gridSpacing, channel->origin);
+    const FaceCenteredGrid3::ScalarDataAccessor dst[3] = {
+        grid->uAccessor(), grid->vAccessor(), grid->wAccessor()
+    };
+    for (size_t axis = 0; axis < 3; ++axis) {
+        ConstArrayAccessor3<double> src = faceCenteredData(name, axis);
+        if (dst[axis].size() != src.size()) {
+            return false;
+        }
+    }
+    for (size_t axis = 0; axis < 3; ++axis) {
+        copyArray(faceCenteredData(name, axis), dst[axis]);
+    }
+    return true;
+}
+
+const GridCacheReader3::Channel* GridCacheReader3::findChannel(
+    const std::string& name) const {
+    for (const Channel& channel : _channels) {
+        if (channel.name == name) {
+            return &channel;
+        }
+    }
+    return nullptr;
+}
+
+const GridCacheReader3::Channel* GridCacheReader3::findChannel(
+    const std::string& name,
+    uint32_t type) const {
+    for (const Channel& channel : _channels) {
+        if (channel.type == type && channel.name == name) {
+            return &channel;
+        }
+    }
+    return nullptr;
+}
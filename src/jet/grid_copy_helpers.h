@@ -0,0 +1,49 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_GRID_COPY_HELPERS_H_
+#define SRC_JET_GRID_COPY_HELPERS_H_
+
+#include <jet/collocated_vector_grid3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/scalar_grid3.h>
+
+namespace jet {
+
+// Copies the data of a grid into a persistent buffer of the same type, such
+// as the back buffers of GridSystemData3. Unlike clone, the buffer memory is
+// reused, and it is only resized when the shape of the grid has changed.
+template <typename T>
+void copyGrid(const ScalarGrid3T<T>& grid, ScalarGrid3T<T>* buffer) {
+    if (!buffer->hasSameShape(grid)) {
+        buffer->resize(grid.resolution(), grid.gridSpacing(), grid.origin());
+    }
+
+    auto src = grid.constDataAccessor();
+    auto dst = buffer->dataAccessor();
+    buffer->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        dst(i, j, k) = src(i, j, k);
+    });
+}
+
+inline void copyGrid(
+    const CollocatedVectorGrid3& grid, CollocatedVectorGrid3* buffer) {
+    if (!buffer->hasSameShape(grid)) {
+        buffer->resize(grid.resolution(), grid.gridSpacing(), grid.origin());
+    }
+
+    auto src = grid.constDataAccessor();
+    auto dst = buffer->dataAccessor();
+    buffer->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        dst(i, j, k) = src(i, j, k);
+    });
+}
+
+inline void copyGrid(
+    const FaceCenteredGrid3& grid, FaceCenteredGrid3* buffer) {
+    // The data arrays keep their memory when the sizes are the same
+    buffer->set(grid);
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_GRID_COPY_HELPERS_H_
@@ -10,6 +10,7 @@
 #include <jet/grid_fluid_solver2.h>
 #include <jet/grid_fractional_single_phase_pressure_solver2.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
 #include <jet/surface_to_implicit2.h>
 #include <jet/timer.h>
 #include <algorithm>
@@ -46,13 +47,24 @@ void GridFluidSolver2::setViscosityCoefficient(double newValue) {
 
 double GridFluidSolver2::cfl(double timeIntervalInSeconds) const {
     auto vel = _grids->velocity();
-    double maxVel = 0.0;
-    vel->forEachCellIndex([&](size_t i, size_t j) {
-        Vector2D v = vel->valueAtCellCenter(i, j)
-            + timeIntervalInSeconds * _gravity;
-        maxVel = std::max(maxVel, v.x);
-        maxVel = std::max(maxVel, v.y);
-    });
+    Size2 res = vel->resolution();
+    double maxVel = parallelReduce(
+        kZeroSize,
+        res.y,
+        0.0,
+        [&](size_t jBegin, size_t jEnd, double partial) {
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                for (size_t i = 0; i < res.x; ++i) {
+                    Vector2D v = vel->valueAtCellCenter(i, j)
+                        + timeIntervalInSeconds * _gravity;
+                    partial = std::max(partial, std::max(v.x, v.y));
+                }
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 
     Vector2D gridSpacing = _grids->gridSpacing();
     double minGridSize = std::min(gridSpacing.x, gridSpacing.y);
@@ -10,12 +10,40 @@
 #include <jet/grid_fluid_solver3.h>
 #include <jet/grid_fractional_single_phase_pressure_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
 #include <jet/surface_to_implicit3.h>
-#include <jet/timer.h>
+#include <jet/profiler.h>
+#include <grid_auto_bounds_helpers.h>
+#include <grid_copy_helpers.h>
+#include <serialization_helpers.h>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
 
 using namespace jet;
 
+namespace {
+
+// Marks the data points that are outside of the collider.
+template <typename PositionFunc>
+void markOutsideOfCollider(
+    const CellCenteredScalarGrid3& colliderSdf,
+    const Size3& size,
+    const PositionFunc& pos,
+    BitArray3* marker) {
+    if (marker->size() != size) {
+        marker->resize(size);
+    }
+
+    marker->parallelSet([&](size_t i, size_t j, size_t k) {
+        return !isInsideSdf(colliderSdf.sample(pos(i, j, k)));
+    });
+}
+
+}  // namespace
+
 GridFluidSolver3::GridFluidSolver3() {
     _grids = std::make_shared<GridSystemData3>();
     setAdvectionSolver(std::make_shared<CubicSemiLagrangian3>());
@@ -46,14 +74,26 @@ void GridFluidSolver3::setViscosityCoefficient(double newValue) {
 
 double GridFluidSolver3::cfl(double timeIntervalInSeconds) const {
     auto vel = _grids->velocity();
-    double maxVel = 0.0;
-    vel->forEachCellIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D v = vel->valueAtCellCenter(i, j, k)
-            + timeIntervalInSeconds * _gravity;
-        maxVel = std::max(maxVel, v.x);
-        maxVel = std::max(maxVel, v.y);
-        maxVel = std::max(maxVel, v.z);
-    });
+    Size3 res = vel->resolution();
+    double maxVel = parallelReduce(
+        kZeroSize,
+        res.z,
+        0.0,
+        [&](size_t kBegin, size_t kEnd, double partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < res.y; ++j) {
+                    for (size_t i = 0; i < res.x; ++i) {
+                        Vector3D v = vel->valueAtCellCenter(i, j, k)
+                            + timeIntervalInSeconds * _gravity;
+                        partial = std::max(partial, max3(v.x, v.y, v.z));
+                    }
+                }
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 
     Vector3D gridSpacing = _grids->gridSpacing();
     double minGridSize = min3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
@@ -100,7 +140,7 @@ void GridFluidSolver3::setPressureSolver(
 
         // Apply domain boundary flag
         _boundaryConditionSolver->setClosedDomainBoundaryFlag(
-            _closedDomainBoundaryFlag);
+            gridClosedDomainBoundaryFlag());
     }
 }
 
@@ -111,7 +151,7 @@ int GridFluidSolver3::closedDomainBoundaryFlag() const {
 void GridFluidSolver3::setClosedDomainBoundaryFlag(int flag) {
     _closedDomainBoundaryFlag = flag;
     _boundaryConditionSolver->setClosedDomainBoundaryFlag(
-        _closedDomainBoundaryFlag);
+        gridClosedDomainBoundaryFlag());
 }
 
 const GridSystemData3Ptr& GridFluidSolver3::gridSystemData() const {
@@ -123,6 +163,13 @@ void GridFluidSolver3::resizeGrid(
     const Vector3D& newGridSpacing,
     const Vector3D& newGridOrigin) {
     _grids->resize(newSize, newGridSpacing, newGridOrigin);
+    _previewScale = 1.0;
+    if (_isUsingAutoBounds) {
+        _maxDomainResolution = newSize;
+        _maxDomainOrigin = newGridOrigin;
+        _boundaryConditionSolver->setClosedDomainBoundaryFlag(
+            gridClosedDomainBoundaryFlag());
+    }
 }
 
 Size3 GridFluidSolver3::gridResolution() const {
@@ -137,6 +184,92 @@ Vector3D GridFluidSolver3::gridOrigin() const {
     return _grids->origin();
 }
 
+double GridFluidSolver3::previewScale() const {
+    return _previewScale;
+}
+
+void GridFluidSolver3::setPreviewScale(double factor) {
+    JET_THROW_INVALID_ARG_IF(factor < 1.0);
+    if (factor == _previewScale) {
+        return;
+    }
+
+    if (_previewScale == 1.0) {
+        _fullResolution
+            = _isUsingAutoBounds ? _maxDomainResolution : gridResolution();
+        _fullGridSpacing = gridSpacing();
+        _fullGridOrigin = _isUsingAutoBounds ? _maxDomainOrigin : gridOrigin();
+    }
+
+    Size3 newSize;
+    Vector3D newGridSpacing;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        newSize[axis] = std::max(
+            static_cast<size_t>(std::round(_fullResolution[axis] / factor)),
+            kOneSize);
+        newGridSpacing[axis] = _fullResolution[axis] * _fullGridSpacing[axis]
+            / newSize[axis];
+    }
+
+    resizeGrid(newSize, newGridSpacing, _fullGridOrigin);
+    _previewScale = factor;
+}
+
+void GridFluidSolver3::scrollGrid(const Point3I& offset) {
+    _grids->scroll(offset);
+}
+
+Point3I GridFluidSolver3::scrollGridToward(const Vector3D& center) {
+    Vector3D h = _grids->gridSpacing();
+    Vector3D delta = center - _grids->boundingBox().midPoint();
+    Point3I offset(
+        static_cast<ssize_t>(std::round(delta.x / h.x)),
+        static_cast<ssize_t>(std::round(delta.y / h.y)),
+        static_cast<ssize_t>(std::round(delta.z / h.z)));
+    _grids->scroll(offset);
+    return offset;
+}
+
+bool GridFluidSolver3::isUsingAutoBounds() const {
+    return _isUsingAutoBounds;
+}
+
+void GridFluidSolver3::setIsUsingAutoBounds(bool isUsing) {
+    if (isUsing == _isUsingAutoBounds) {
+        return;
+    }
+
+    if (isUsing) {
+        _maxDomainResolution = _grids->resolution();
+        _maxDomainOrigin = _grids->origin();
+    } else {
+        // Grows the grid back to the max domain
+        Point3I lower = gridOffsetInMaxDomain();
+        _grids->reshape(
+            Point3I(-lower.x, -lower.y, -lower.z), _maxDomainResolution);
+    }
+
+    _isUsingAutoBounds = isUsing;
+    _boundaryConditionSolver->setClosedDomainBoundaryFlag(
+        gridClosedDomainBoundaryFlag());
+}
+
+size_t GridFluidSolver3::autoBoundsPadding() const {
+    return _autoBoundsPadding;
+}
+
+void GridFluidSolver3::setAutoBoundsPadding(size_t padding) {
+    _autoBoundsPadding = padding;
+}
+
+Size3 GridFluidSolver3::maxDomainResolution() const {
+    return _isUsingAutoBounds ? _maxDomainResolution : _grids->resolution();
+}
+
+Vector3D GridFluidSolver3::maxDomainOrigin() const {
+    return _isUsingAutoBounds ? _maxDomainOrigin : _grids->origin();
+}
+
 const FaceCenteredGrid3Ptr& GridFluidSolver3::velocity() const {
     return _grids->velocity();
 }
@@ -149,6 +282,45 @@ void GridFluidSolver3::setCollider(const Collider3Ptr& newCollider) {
     _collider = newCollider;
 }
 
+void GridFluidSolver3::serialize(std::ostream* strm) const {
+    PhysicsAnimation::serialize(strm);
+
+    serializeSectionTag(strm, "GridFluidSolver3");
+    int32_t closedDomainBoundaryFlag = _closedDomainBoundaryFlag;
+    serializeValue(strm, _gravity);
+    serializeValue(strm, _viscosityCoefficient);
+    serializeValue(strm, _maxCfl);
+    serializeValue(strm, closedDomainBoundaryFlag);
+    serializeValue(strm, static_cast<uint8_t>(_isUsingAutoBounds));
+    serializeValue(strm, static_cast<uint64_t>(_autoBoundsPadding));
+    serializeValue(strm, _maxDomainResolution);
+    serializeValue(strm, _maxDomainOrigin);
+    _grids->serialize(strm);
+}
+
+void GridFluidSolver3::deserialize(std::istream* strm) {
+    PhysicsAnimation::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(
+        !deserializeSectionTag(strm, "GridFluidSolver3"));
+    int32_t closedDomainBoundaryFlag = 0;
+    deserializeValue(strm, &_gravity);
+    deserializeValue(strm, &_viscosityCoefficient);
+    deserializeValue(strm, &_maxCfl);
+    deserializeValue(strm, &closedDomainBoundaryFlag);
+    uint8_t isUsingAutoBounds = 0;
+    uint64_t autoBoundsPadding = 0;
+    deserializeValue(strm, &isUsingAutoBounds);
+    deserializeValue(strm, &autoBoundsPadding);
+    deserializeValue(strm, &_maxDomainResolution);
+    deserializeValue(strm, &_maxDomainOrigin);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    _isUsingAutoBounds = isUsingAutoBounds != 0;
+    _autoBoundsPadding = static_cast<size_t>(autoBoundsPadding);
+    _grids->deserialize(strm);
+    setClosedDomainBoundaryFlag(closedDomainBoundaryFlag);
+}
+
 void GridFluidSolver3::onAdvanceTimeStep(double timeIntervalInSeconds) {
     // The minimum grid resolution is 1x1.
     if (_grids->resolution().x == 0
@@ -158,34 +330,42 @@ void GridFluidSolver3::onAdvanceTimeStep(double timeIntervalInSeconds) {
         return;
     }
 
-    beginAdvanceTimeStep(timeIntervalInSeconds);
+    _maxVelocity = -1.0;
 
-    Timer timer;
-    computeAdvection(timeIntervalInSeconds);
-    JET_INFO << "Computing advection force took "
-        << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("beginAdvanceTimeStep");
+        beginAdvanceTimeStep(timeIntervalInSeconds);
+    }
 
-    timer.reset();
-    computeExternalForces(timeIntervalInSeconds);
-    JET_INFO << "Computing external force took "
-             << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("computeAdvection");
+        computeAdvection(timeIntervalInSeconds);
+    }
 
-    timer.reset();
-    computeViscosity(timeIntervalInSeconds);
-    JET_INFO << "Computing viscosity force took "
-             << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("computeExternalForces");
+        computeExternalForces(timeIntervalInSeconds);
+    }
 
-    timer.reset();
-    computePressure(timeIntervalInSeconds);
-    JET_INFO << "Computing pressure force took "
-             << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("computeViscosity");
+        computeViscosity(timeIntervalInSeconds);
+    }
 
-    endAdvanceTimeStep(timeIntervalInSeconds);
+    {
+        JET_PROFILE_SCOPE("computePressure");
+        computePressure(timeIntervalInSeconds);
+    }
+
+    {
+        JET_PROFILE_SCOPE("endAdvanceTimeStep");
+        endAdvanceTimeStep(timeIntervalInSeconds);
+    }
 }
 
 unsigned int GridFluidSolver3::numberOfSubTimeSteps(
     double timeIntervalInSeconds) const {
-    double currentCfl = cfl(timeIntervalInSeconds);
+    double currentCfl = estimatedCfl(timeIntervalInSeconds);
     return static_cast<unsigned int>(
         std::max(std::ceil(currentCfl / _maxCfl), 1.0));
 }
@@ -205,7 +385,8 @@ void GridFluidSolver3::computeExternalForces(double timeIntervalInSeconds) {
 void GridFluidSolver3::computeViscosity(double timeIntervalInSeconds) {
     if (_diffusionSolver != nullptr && _viscosityCoefficient > kEpsilonD) {
         auto vel = velocity();
-        auto vel0 = std::dynamic_pointer_cast<FaceCenteredGrid3>(vel->clone());
+        auto vel0 = _grids->velocityBackBuffer();
+        copyGrid(*vel, vel0.get());
 
         _diffusionSolver->solve(
             *vel0,
@@ -221,7 +402,8 @@ void GridFluidSolver3::computeViscosity(double timeIntervalInSeconds) {
 void GridFluidSolver3::computePressure(double timeIntervalInSeconds) {
     if (_pressureSolver != nullptr) {
         auto vel = velocity();
-        auto vel0 = std::dynamic_pointer_cast<FaceCenteredGrid3>(vel->clone());
+        auto vel0 = _grids->velocityBackBuffer();
+        copyGrid(*vel, vel0.get());
 
         _pressureSolver->solve(
             *vel0,
@@ -230,75 +412,66 @@ void GridFluidSolver3::computePressure(double timeIntervalInSeconds) {
             _colliderSdf,
             *fluidSdf());
         applyBoundaryCondition();
+
+        // Without a collider, the boundary condition only extrapolates and
+        // clears the velocity, which keeps it under the tracked maximum
+        if (_collider == nullptr) {
+            _maxVelocity = _pressureSolver->lastMaxVelocity();
+        }
     }
 }
 
 void GridFluidSolver3::computeAdvection(double timeIntervalInSeconds) {
-    auto vel = velocity();
     if (_advectionSolver != nullptr) {
-        // Solve advections for custom scalar fields
-        size_t n = _grids->numberOfAdvectableScalarData();
-        for (size_t i = 0; i < n; ++i) {
-            auto grid = _grids->advectableScalarDataAt(i);
-            auto grid0 = grid->clone();
+        auto vel = velocity();
+        auto vel0 = _grids->velocityBackBuffer();
+        copyGrid(*vel, vel0.get());
+
+        // The velocity advection reads only the back buffer, so it runs
+        // together with the advection of the custom scalar and vector fields
+        // that are due
+        std::vector<std::function<void()>> tasks;
+        tasks.push_back([&]() {
             _advectionSolver->advect(
-                *grid0,
-                *vel,
+                *vel0,
+                *vel0,
                 timeIntervalInSeconds,
-                grid.get(),
+                vel.get(),
                 _colliderSdf);
-            extrapolateIntoCollider(grid.get());
-        }
+        });
+        addDataAdvectionTasks(*vel0, timeIntervalInSeconds, false, &tasks);
+        parallelInvoke(tasks);
 
-        // Solve advections for custom vector fields
-        n = _grids->numberOfAdvectableVectorData();
-        for (size_t i = 0; i < n; ++i) {
-            auto grid = _grids->advectableVectorDataAt(i);
-            auto grid0 = grid->clone();
-
-            auto collocated
-                = std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid);
-            auto collocated0
-                = std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid0);
-            if (collocated != nullptr) {
-                _advectionSolver->advect(
-                    *collocated0,
-                    *vel,
-                    timeIntervalInSeconds,
-                    collocated.get(),
-                    _colliderSdf);
-                extrapolateIntoCollider(collocated.get());
-                continue;
-            }
+        applyBoundaryCondition();
+    }
+}
 
-            auto faceCentered
-                = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid);
-            auto faceCentered0
-                = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid0);
-            if (faceCentered != nullptr && faceCentered0 != nullptr) {
-                _advectionSolver->advect(
-                    *faceCentered0,
-                    *vel,
-                    timeIntervalInSeconds,
-                    faceCentered.get(),
-                    _colliderSdf);
-                extrapolateIntoCollider(faceCentered.get());
-                continue;
-            }
-        }
+void GridFluidSolver3::onEndAdvanceFrame(double timeIntervalInSeconds) {
+    UNUSED_VARIABLE(timeIntervalInSeconds);
 
-        // Solve velocity advection
-        auto vel0 = std::dynamic_pointer_cast<FaceCenteredGrid3>(vel->clone());
-        _advectionSolver->advect(
-            *vel0,
-            *vel0,
-            timeIntervalInSeconds,
-            vel.get(),
-            _colliderSdf);
-        applyBoundaryCondition();
+    // The velocity can be edited between the frames
+    _maxVelocity = -1.0;
+
+    // Catch up the data with longer update intervals so that all the data is
+    // in sync at the frame boundary
+    if (_advectionSolver != nullptr) {
+        std::vector<std::function<void()>> tasks;
+        addDataAdvectionTasks(*velocity(), 0.0, true, &tasks);
+        parallelInvoke(tasks);
     }
 }
 
+void GridFluidSolver3::collectStatistics(
+    SubTimeStepStatistics* stats) const {
+    stats->cfl = estimatedCfl(stats->timeIntervalInSeconds);
+    if (_pressureSolver != nullptr) {
+        stats->numberOfPressureIterations
+            = _pressureSolver->lastNumberOfIterations();
+        stats->pressureResidual = _pressureSolver->lastResidual();
+    }
+    stats->memoryInBytes = _grids->memoryInBytes();
+}
+
 ScalarField3Ptr GridFluidSolver3::fluidSdf() const {
     return std::make_shared<ConstantScalarField3>(-kMaxD);
 }
@@ -332,6 +505,22 @@ void GridFluidSolver3::computeGravity(double timeIntervalInSeconds) {
     }
 }
 
+double GridFluidSolver3::estimatedCfl(double timeIntervalInSeconds) const {
+    if (_maxVelocity < 0.0) {
+        return cfl(timeIntervalInSeconds);
+    }
+
+    double maxGravity
+        = max3(std::fabs(_gravity.x), std::fabs(_gravity.y),
+               std::fabs(_gravity.z));
+    double maxVel = _maxVelocity + timeIntervalInSeconds * maxGravity;
+
+    Vector3D gridSpacing = _grids->gridSpacing();
+    double minGridSize = min3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
+
+    return maxVel * timeIntervalInSeconds / minGridSize;
+}
+
 void GridFluidSolver3::applyBoundaryCondition() {
     auto vel = _grids->velocity();
 
@@ -342,106 +531,431 @@ void GridFluidSolver3::applyBoundaryCondition() {
 }
 
 void GridFluidSolver3::extrapolateIntoCollider(ScalarGrid3* grid) {
-    Array3<char> marker(grid->dataSize());
-    auto pos = grid->dataPosition();
-    marker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        if (isInsideSdf(_colliderSdf.sample(pos(i, j, k)))) {
-            marker(i, j, k) = 0;
-        } else {
-            marker(i, j, k) = 1;
-        }
-    });
+    extrapolateIntoCollider(grid, &_colliderExtrapolation);
+}
+
+void GridFluidSolver3::extrapolateIntoCollider(CollocatedVectorGrid3* grid) {
+    extrapolateIntoCollider(grid, &_colliderExtrapolation);
+}
+
+void GridFluidSolver3::extrapolateIntoCollider(FaceCenteredGrid3* grid) {
+    extrapolateIntoCollider(grid, &_colliderExtrapolation);
+}
+
+void GridFluidSolver3::extrapolateIntoCollider(
+    ScalarGrid3* grid, ColliderExtrapolation* extrapolation) {
+    markOutsideOfCollider(
+        _colliderSdf,
+        grid->dataSize(),
+        grid->dataPosition(),
+        &extrapolation->markers[0]);
 
     unsigned int depth = static_cast<unsigned int>(std::ceil(_maxCfl));
     extrapolateToRegion(
-        grid->constDataAccessor(), marker, depth, grid->dataAccessor());
+        grid->constDataAccessor(),
+        extrapolation->markers[0],
+        depth,
+        grid->dataAccessor(),
+        &extrapolation->buffers[0]);
 }
 
-void GridFluidSolver3::extrapolateIntoCollider(CollocatedVectorGrid3* grid) {
-    Array3<char> marker(grid->dataSize());
-    auto pos = grid->dataPosition();
-    marker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        if (isInsideSdf(_colliderSdf.sample(pos(i, j, k)))) {
-            marker(i, j, k) = 0;
-        } else {
-            marker(i, j, k) = 1;
-        }
-    });
+void GridFluidSolver3::extrapolateIntoCollider(
+    ScalarGrid3F* grid, ColliderExtrapolation* extrapolation) {
+    markOutsideOfCollider(
+        _colliderSdf,
+        grid->dataSize(),
+        grid->dataPosition(),
+        &extrapolation->markers[0]);
 
     unsigned int depth = static_cast<unsigned int>(std::ceil(_maxCfl));
     extrapolateToRegion(
-        grid->constDataAccessor(), marker, depth, grid->dataAccessor());
+        grid->constDataAccessor(),
+        extrapolation->markers[0],
+        depth,
+        grid->dataAccessor(),
+        &extrapolation->buffers[0]);
 }
 
-void GridFluidSolver3::extrapolateIntoCollider(FaceCenteredGrid3* grid) {
+void GridFluidSolver3::extrapolateIntoCollider(
+    CollocatedVectorGrid3* grid, ColliderExtrapolation* extrapolation) {
+    markOutsideOfCollider(
+        _colliderSdf,
+        grid->dataSize(),
+        grid->dataPosition(),
+        &extrapolation->markers[0]);
+
+    unsigned int depth = static_cast<unsigned int>(std::ceil(_maxCfl));
+    extrapolateToRegion(
+        grid->constDataAccessor(),
+        extrapolation->markers[0],
+        depth,
+        grid->dataAccessor(),
+        &extrapolation->buffers[0]);
+}
+
+void GridFluidSolver3::extrapolateIntoCollider(
+    FaceCenteredGrid3* grid, ColliderExtrapolation* extrapolation) {
     auto u = grid->uAccessor();
     auto v = grid->vAccessor();
     auto w = grid->wAccessor();
-    auto uPos = grid->uPosition();
-    auto vPos = grid->vPosition();
-    auto wPos = grid->wPosition();
 
-    Array3<char> uMarker(u.size());
-    Array3<char> vMarker(v.size());
-    Array3<char> wMarker(w.size());
+    unsigned int depth = static_cast<unsigned int>(std::ceil(_maxCfl));
 
-    uMarker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        if (isInsideSdf(_colliderSdf.sample(uPos(i, j, k)))) {
-            uMarker(i, j, k) = 0;
-        } else {
-            uMarker(i, j, k) = 1;
+    // The components are independent, so they are extrapolated together
+    BitArray3* markers = extrapolation->markers;
+    ExtrapolationBuffers3* buffers = extrapolation->buffers;
+    parallelInvoke({
+        [&]() {
+            markOutsideOfCollider(
+                _colliderSdf, u.size(), grid->uPosition(), &markers[0]);
+            extrapolateToRegion(
+                grid->uConstAccessor(), markers[0], depth, u, &buffers[0]);
+        },
+        [&]() {
+            markOutsideOfCollider(
+                _colliderSdf, v.size(), grid->vPosition(), &markers[1]);
+            extrapolateToRegion(
+                grid->vConstAccessor(), markers[1], depth, v, &buffers[1]);
+        },
+        [&]() {
+            markOutsideOfCollider(
+                _colliderSdf, w.size(), grid->wPosition(), &markers[2]);
+            extrapolateToRegion(
+                grid->wConstAccessor(), markers[2], depth, w, &buffers[2]);
         }
     });
+}
 
-    vMarker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        if (isInsideSdf(_colliderSdf.sample(vPos(i, j, k)))) {
-            vMarker(i, j, k) = 0;
-        } else {
-            vMarker(i, j, k) = 1;
+const CellCenteredScalarGrid3& GridFluidSolver3::colliderSdf() const {
+    return _colliderSdf;
+}
+
+void GridFluidSolver3::addDataAdvectionTasks(
+    const FaceCenteredGrid3& flow,
+    double timeIntervalInSeconds,
+    bool isEndOfFrame,
+    std::vector<std::function<void()>>* tasks) {
+    // Accumulates the time of each data, and returns true if the data is due
+    // for advection at this step
+    auto isDue = [&](PendingAdvection* pending, unsigned int interval) {
+        if (!isEndOfFrame) {
+            ++pending->numberOfSteps;
+            pending->timeIntervalInSeconds += timeIntervalInSeconds;
         }
-    });
 
-    wMarker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        if (isInsideSdf(_colliderSdf.sample(wPos(i, j, k)))) {
-            wMarker(i, j, k) = 0;
-        } else {
-            wMarker(i, j, k) = 1;
+        return isEndOfFrame
+            ? pending->numberOfSteps > 0
+            : pending->numberOfSteps >= interval;
+    };
+
+    // Data with the same accumulated time are advected together so that the
+    // back-traces are shared between them
+    struct AdvectionGroup {
+        double timeIntervalInSeconds;
+        std::vector<const ScalarGrid3*> scalarInputs;
+        std::vector<ScalarGrid3*> scalarOutputs;
+        std::vector<const CollocatedVectorGrid3*> vectorInputs;
+        std::vector<CollocatedVectorGrid3*> vectorOutputs;
+    };
+    std::vector<AdvectionGroup> groups;
+    auto groupOf = [&](double dt) -> AdvectionGroup& {
+        for (auto& group : groups) {
+            if (group.timeIntervalInSeconds == dt) {
+                return group;
+            }
+        }
+        groups.push_back(AdvectionGroup());
+        groups.back().timeIntervalInSeconds = dt;
+        return groups.back();
+    };
+
+    // Each group and each face-centered grid is advected and extrapolated
+    // by its own task with its own extrapolation buffers
+    size_t numberOfTasks = 0;
+
+    size_t n = _grids->numberOfAdvectableScalarData();
+    _pendingScalarAdvections.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        PendingAdvection& pending = _pendingScalarAdvections[i];
+        if (!isDue(
+                &pending, _grids->advectableScalarDataUpdateIntervalAt(i))) {
+            continue;
         }
-    });
 
-    unsigned int depth = static_cast<unsigned int>(std::ceil(_maxCfl));
-    extrapolateToRegion(grid->uConstAccessor(), uMarker, depth, u);
-    extrapolateToRegion(grid->vConstAccessor(), vMarker, depth, v);
-    extrapolateToRegion(grid->wConstAccessor(), wMarker, depth, w);
+        auto grid = _grids->advectableScalarDataAt(i);
+        auto grid0 = _grids->advectableScalarDataBackBufferAt(i);
+        copyGrid(*grid, grid0.get());
+
+        AdvectionGroup& group = groupOf(pending.timeIntervalInSeconds);
+        group.scalarInputs.push_back(grid0.get());
+        group.scalarOutputs.push_back(grid.get());
+        pending = PendingAdvection();
+    }
+
+    n = _grids->numberOfAdvectableVectorData();
+    _pendingVectorAdvections.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        PendingAdvection& pending = _pendingVectorAdvections[i];
+        if (!isDue(
+                &pending, _grids->advectableVectorDataUpdateIntervalAt(i))) {
+            continue;
+        }
+
+        double dt = pending.timeIntervalInSeconds;
+        pending = PendingAdvection();
+
+        auto grid = _grids->advectableVectorDataAt(i);
+        auto grid0 = _grids->advectableVectorDataBackBufferAt(i);
+
+        auto collocated
+            = std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid);
+        auto collocated0
+            = std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid0);
+        if (collocated != nullptr && collocated0 != nullptr) {
+            copyGrid(*collocated, collocated0.get());
+
+            AdvectionGroup& group = groupOf(dt);
+            group.vectorInputs.push_back(collocated0.get());
+            group.vectorOutputs.push_back(collocated.get());
+            continue;
+        }
+
+        auto faceCentered
+            = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid);
+        auto faceCentered0
+            = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid0);
+        if (faceCentered != nullptr && faceCentered0 != nullptr) {
+            copyGrid(*faceCentered, faceCentered0.get());
+
+            size_t taskIndex = numberOfTasks++;
+            tasks->push_back([=, &flow]() {
+                _advectionSolver->advect(
+                    *faceCentered0,
+                    flow,
+                    dt,
+                    faceCentered.get(),
+                    _colliderSdf);
+                extrapolateIntoCollider(
+                    faceCentered.get(), &_taskExtrapolations[taskIndex]);
+            });
+            continue;
+        }
+    }
+
+    // The single-precision scalar data are advected at every sub-time-step,
+    // so none of them is pending at the end of a frame
+    n = isEndOfFrame ? 0 : _grids->numberOfAdvectableScalarDataF();
+    for (size_t i = 0; i < n; ++i) {
+        auto grid = _grids->advectableScalarDataFAt(i);
+        auto grid0 = _grids->advectableScalarDataFBackBufferAt(i);
+        copyGrid(*grid, grid0.get());
+
+        size_t taskIndex = numberOfTasks++;
+        tasks->push_back([=, &flow]() {
+            _advectionSolver->advect(
+                *grid0,
+                flow,
+                timeIntervalInSeconds,
+                grid.get(),
+                _colliderSdf);
+            extrapolateIntoCollider(
+                grid.get(), &_taskExtrapolations[taskIndex]);
+        });
+    }
+
+    for (const auto& group : groups) {
+        size_t taskIndex = numberOfTasks++;
+        tasks->push_back([=, &flow]() {
+            _advectionSolver->advect(
+                group.scalarInputs,
+                group.vectorInputs,
+                flow,
+                group.timeIntervalInSeconds,
+                group.scalarOutputs,
+                group.vectorOutputs,
+                _colliderSdf);
+
+            ColliderExtrapolation* extrapolation
+                = &_taskExtrapolations[taskIndex];
+            for (auto grid : group.scalarOutputs) {
+                extrapolateIntoCollider(grid, extrapolation);
+            }
+            for (auto grid : group.vectorOutputs) {
+                extrapolateIntoCollider(grid, extrapolation);
+            }
+        });
+    }
+
+    if (_taskExtrapolations.size() < numberOfTasks) {
+        _taskExtrapolations.resize(numberOfTasks);
+    }
 }
 
-const CellCenteredScalarGrid3& GridFluidSolver3::colliderSdf() const {
-    return _colliderSdf;
+BoundingBox3D GridFluidSolver3::activeRegion() const {
+    ScalarField3Ptr sdf = fluidSdf();
+    Vector3D h = _grids->gridSpacing();
+    Vector3D o = _grids->origin();
+    return activeCellBounds(
+        _grids->resolution(), h, o,
+        [&](size_t i, size_t j, size_t k) {
+            return sdf->sample(
+                o + h * Vector3D(i + 0.5, j + 0.5, k + 0.5)) < 0.0;
+        });
+}
+
+int GridFluidSolver3::gridClosedDomainBoundaryFlag() const {
+    int flag = _closedDomainBoundaryFlag;
+    if (!_isUsingAutoBounds) {
+        return flag;
+    }
+
+    Point3I lower = gridOffsetInMaxDomain();
+    Size3 res = _grids->resolution();
+    if (lower.x > 0) {
+        flag &= ~kDirectionLeft;
+    }
+    if (lower.x + static_cast<ssize_t>(res.x)
+        < static_cast<ssize_t>(_maxDomainResolution.x)) {
+        flag &= ~kDirectionRight;
+    }
+    if (lower.y > 0) {
+        flag &= ~kDirectionDown;
+    }
+    if (lower.y + static_cast<ssize_t>(res.y)
+        < static_cast<ssize_t>(_maxDomainResolution.y)) {
+        flag &= ~kDirectionUp;
+    }
+    if (lower.z > 0) {
+        flag &= ~kDirectionBack;
+    }
+    if (lower.z + static_cast<ssize_t>(res.z)
+        < static_cast<ssize_t>(_maxDomainResolution.z)) {
+        flag &= ~kDirectionFront;
+    }
+    return flag;
+}
+
+Point3I GridFluidSolver3::gridOffsetInMaxDomain() const {
+    // The grid is aligned with the cells of the max domain, so rounding only
+    // removes the round-off error of the origins
+    Vector3D h = _grids->gridSpacing();
+    Vector3D delta = _grids->origin() - _maxDomainOrigin;
+    return Point3I(
+        static_cast<ssize_t>(std::round(delta.x / h.x)),
+        static_cast<ssize_t>(std::round(delta.y / h.y)),
+        static_cast<ssize_t>(std::round(delta.z / h.z)));
+}
+
+void GridFluidSolver3::updateAutoBounds() {
+    BoundingBox3D region = activeRegion();
+    if (region.lowerCorner.x > region.upperCorner.x
+        || region.lowerCorner.y > region.upperCorner.y
+        || region.lowerCorner.z > region.upperCorner.z) {
+        return;
+    }
+
+    // Cells of the max domain that cover the region with the padding
+    Vector3D h = _grids->gridSpacing();
+    double padding = static_cast<double>(_autoBoundsPadding)
+        + std::ceil(_maxCfl);
+    auto cellRange = [&](
+        double lower, double upper, double origin, double spacing,
+        size_t size, ssize_t* begin, ssize_t* end) {
+        double n = static_cast<double>(size);
+        *begin = static_cast<ssize_t>(clamp(
+            std::floor((lower - origin) / spacing) - padding, 0.0, n));
+        *end = static_cast<ssize_t>(clamp(
+            std::floor((upper - origin) / spacing) + 1.0 + padding, 0.0, n));
+        return *begin < *end;
+    };
+    Point3I begin, end;
+    if (!cellRange(
+            region.lowerCorner.x, region.upperCorner.x, _maxDomainOrigin.x,
+            h.x, _maxDomainResolution.x, &begin.x, &end.x)
+        || !cellRange(
+            region.lowerCorner.y, region.upperCorner.y, _maxDomainOrigin.y,
+            h.y, _maxDomainResolution.y, &begin.y, &end.y)
+        || !cellRange(
+            region.lowerCorner.z, region.upperCorner.z, _maxDomainOrigin.z,
+            h.z, _maxDomainResolution.z, &begin.z, &end.z)) {
+        return;
+    }
+
+    Point3I offset = begin - gridOffsetInMaxDomain();
+    Size3 res(
+        static_cast<size_t>(end.x - begin.x),
+        static_cast<size_t>(end.y - begin.y),
+        static_cast<size_t>(end.z - begin.z));
+    if (offset != Point3I() || res != _grids->resolution()) {
+        _grids->reshape(offset, res);
+        _boundaryConditionSolver->setClosedDomainBoundaryFlag(
+            gridClosedDomainBoundaryFlag());
+    }
 }
 
 void GridFluidSolver3::beginAdvanceTimeStep(double timeIntervalInSeconds) {
+    if (_isUsingAutoBounds) {
+        JET_PROFILE_SCOPE("updateAutoBounds");
+        updateAutoBounds();
+    }
+
     Size3 res = _grids->resolution();
     Vector3D h = _grids->gridSpacing();
     Vector3D o = _grids->origin();
 
     // Reserve memory
-    _colliderSdf.resize(res, h, o);
-
-    // Rasterize collider into SDF
-    if (_collider != nullptr) {
-        auto pos = _colliderSdf.dataPosition();
-        Surface3Ptr surface = _collider->surface();
-        ImplicitSurface3Ptr implicitSurface
-            = std::dynamic_pointer_cast<ImplicitSurface3>(surface);
-        if (implicitSurface == nullptr) {
-            implicitSurface = std::make_shared<SurfaceToImplicit3>(surface);
+    bool isSameShape = _colliderSdf.resolution() == res
+        && _colliderSdf.gridSpacing() == h
+        && _colliderSdf.origin() == o;
+    if (!isSameShape) {
+        _colliderSdf.resize(res, h, o);
+    }
+
+    // Rasterize collider into SDF only if the collider or the grid has changed
+    // since the last step, so static colliders are rasterized once.
+    uint64_t colliderVersion
+        = (_collider != nullptr) ? _collider->version() : 0;
+    if (!_isColliderSdfValid
+        || !isSameShape
+        || _colliderSdfVersion != colliderVersion) {
+        if (_collider != nullptr) {
+            Surface3Ptr surface = _collider->surface();
+            ImplicitSurface3Ptr implicitSurface
+                = std::dynamic_pointer_cast<ImplicitSurface3>(surface);
+            if (implicitSurface == nullptr) {
+                implicitSurface
+                    = std::make_shared<SurfaceToImplicit3>(surface);
+            }
+
+            // Queries a z-slice at a time in the order of the grid, so the
+            // batch queries get coherent packets of neighboring points
+            auto sdf = _colliderSdf.dataAccessor();
+            auto pos = _colliderSdf.dataPosition();
+            Size3 size = _colliderSdf.dataSize();
+            Array1<Vector3D> slicePoints(size.x * size.y);
+            Array1<double> sliceDistances(size.x * size.y);
+            for (size_t k = 0; k < size.z; ++k) {
+                parallelFor(
+                    kZeroSize, size.x,
+                    kZeroSize, size.y,
+                    [&](size_t i, size_t j) {
+                        slicePoints[i + size.x * j] = pos(i, j, k);
+                    });
+                implicitSurface->batchSignedDistance(
+                    slicePoints.constAccessor(), sliceDistances.accessor());
+                parallelFor(
+                    kZeroSize, size.x,
+                    kZeroSize, size.y,
+                    [&](size_t i, size_t j) {
+                        sdf(i, j, k) = sliceDistances[i + size.x * j];
+                    });
+            }
+        } else {
+            _colliderSdf.fill(kMaxD);
         }
 
-        _colliderSdf.fill([&](const Vector3D& pt) {
-            return implicitSurface->signedDistance(pt);
-        });
-    } else {
-        _colliderSdf.fill(kMaxD);
+        _colliderSdfVersion = colliderVersion;
+        _isColliderSdfValid = true;
     }
 
     // Update boundary condition solver
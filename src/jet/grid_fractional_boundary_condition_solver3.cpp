@@ -1,6 +1,7 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <grid_boundary_condition_helpers.h>
 #include <physics_helpers.h>
 #include <jet/array_utils.h>
 #include <jet/grid_fractional_boundary_condition_solver3.h>
@@ -37,150 +38,97 @@ void GridFractionalBoundaryConditionSolver3::constrainVelocity(
     auto vPos = velocity->vPosition();
     auto wPos = velocity->wPosition();
 
-    Array3<double> uTemp(u.size());
-    Array3<double> vTemp(v.size());
-    Array3<double> wTemp(w.size());
-    Array3<char> uMarker(u.size(), 1);
-    Array3<char> vMarker(v.size(), 1);
-    Array3<char> wMarker(w.size(), 1);
-
-    Vector3D h = velocity->gridSpacing();
-
-    // Assign collider's velocity first and initialize markers
-    velocity->parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = uPos(i, j, k);
-        double phi0 = _colliderSdf.sample(pt - Vector3D(0.5 * h.x, 0.0, 0.0));
-        double phi1 = _colliderSdf.sample(pt + Vector3D(0.5 * h.x, 0.0, 0.0));
-        double frac = fractionInsideSdf(phi0, phi1);
-        frac = 1.0 - clamp(frac, 0.0, 1.0);
-
-        if (frac > 0.0) {
-            uMarker(i, j, k) = 1;
-        } else {
-            Vector3D colliderVel = collider()->velocityAt(pt);
-            u(i, j, k) = colliderVel.x;
-            uMarker(i, j, k) = 0;
-        }
-    });
-
-    velocity->parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = vPos(i, j, k);
-        double phi0 = _colliderSdf.sample(pt - Vector3D(0.0, 0.5 * h.y, 0.0));
-        double phi1 = _colliderSdf.sample(pt + Vector3D(0.0, 0.5 * h.y, 0.0));
-        double frac = fractionInsideSdf(phi0, phi1);
-        frac = 1.0 - clamp(frac, 0.0, 1.0);
-
-        if (frac > 0.0) {
-            vMarker(i, j, k) = 1;
-        } else {
-            Vector3D colliderVel = collider()->velocityAt(pt);
-            v(i, j, k) = colliderVel.y;
-            vMarker(i, j, k) = 0;
-        }
-    });
-
-    velocity->parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = wPos(i, j, k);
-        double phi0 = _colliderSdf.sample(pt - Vector3D(0.0, 0.0, 0.5 * h.z));
-        double phi1 = _colliderSdf.sample(pt + Vector3D(0.0, 0.0, 0.5 * h.z));
-        double frac = fractionInsideSdf(phi0, phi1);
-        frac = 1.0 - clamp(frac, 0.0, 1.0);
+    // Assign collider's velocity to the faces inside the collider, which are
+    // listed with the markers when the collider is updated
+    parallelForEachGridIndex(
+        u.size(), _colliderFaces[0],
+        [&](size_t, size_t i, size_t j, size_t k) {
+            u(i, j, k) = collider()->velocityAt(uPos(i, j, k)).x;
+        });
+    parallelForEachGridIndex(
+        v.size(), _colliderFaces[1],
+        [&](size_t, size_t i, size_t j, size_t k) {
+            v(i, j, k) = collider()->velocityAt(vPos(i, j, k)).y;
+        });
+    parallelForEachGridIndex(
+        w.size(), _colliderFaces[2],
+        [&](size_t, size_t i, size_t j, size_t k) {
+            w(i, j, k) = collider()->velocityAt(wPos(i, j, k)).z;
+        });
 
-        if (frac > 0.0) {
-            wMarker(i, j, k) = 1;
-        } else {
-            Vector3D colliderVel = collider()->velocityAt(pt);
-            w(i, j, k) = colliderVel.z;
-            wMarker(i, j, k) = 0;
+    // Free-slip: Extrapolate fluid velocity into the collider, all the
+    // components at the same time
+    parallelInvoke({
+        [&]() {
+            extrapolateToRegion(
+                velocity->uConstAccessor(), _faceMarkers[0],
+                extrapolationDepth, u, &_extrapolationBuffers[0]);
+        },
+        [&]() {
+            extrapolateToRegion(
+                velocity->vConstAccessor(), _faceMarkers[1],
+                extrapolationDepth, v, &_extrapolationBuffers[1]);
+        },
+        [&]() {
+            extrapolateToRegion(
+                velocity->wConstAccessor(), _faceMarkers[2],
+                extrapolationDepth, w, &_extrapolationBuffers[2]);
         }
     });
 
-    // Free-slip: Extrapolate fluid velocity into the collider
-    extrapolateToRegion(
-        velocity->uConstAccessor(), uMarker, extrapolationDepth, u);
-    extrapolateToRegion(
-        velocity->vConstAccessor(), vMarker, extrapolationDepth, v);
-    extrapolateToRegion(
-        velocity->wConstAccessor(), wMarker, extrapolationDepth, w);
-
     // No-flux: project the extrapolated velocity to the collider's surface
-    // normal
-    velocity->parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = uPos(i, j, k);
-        if (isInsideSdf(_colliderSdf.sample(pt))) {
-            Vector3D colliderVel = collider()->velocityAt(pt);
-            Vector3D vel = velocity->sample(pt);
-            Vector3D g = _colliderSdf.gradient(pt);
-            if (g.lengthSquared() > 0.0) {
-                Vector3D n = g.normalized();
-                Vector3D velr = vel - colliderVel;
-                Vector3D velt = projectAndApplyFriction(
-                    velr, n, collider()->frictionCoefficient());
-
-                Vector3D velp = velt + colliderVel;
-                uTemp(i, j, k) = velp.x;
-            } else {
-                uTemp(i, j, k) = colliderVel.x;
-            }
+    // normal. The velocity is sampled from all the components, so every
+    // projected face is computed before any of them is written back.
+    auto projectedVelocity = [&](const Vector3D& pt) {
+        Vector3D colliderVel = collider()->velocityAt(pt);
+        Vector3D g = _colliderSdf.gradient(pt);
+        if (g.lengthSquared() > 0.0) {
+            Vector3D n = g.normalized();
+            Vector3D velr = velocity->sample(pt) - colliderVel;
+            Vector3D velt = projectAndApplyFriction(
+                velr, n, collider()->frictionCoefficient());
+            return velt + colliderVel;
         } else {
-            uTemp(i, j, k) = u(i, j, k);
+            return colliderVel;
         }
-    });
+    };
 
-    velocity->parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = vPos(i, j, k);
-        if (isInsideSdf(_colliderSdf.sample(pt))) {
-            Vector3D colliderVel = collider()->velocityAt(pt);
-            Vector3D vel = velocity->sample(pt);
-            Vector3D g = _colliderSdf.gradient(pt);
-            if (g.lengthSquared() > 0.0) {
-                Vector3D n = g.normalized();
-                Vector3D velr = vel - colliderVel;
-                Vector3D velt = projectAndApplyFriction(
-                    velr, n, collider()->frictionCoefficient());
-
-                Vector3D velp = velt + colliderVel;
-                vTemp(i, j, k) = velp.y;
-            } else {
-                vTemp(i, j, k) = colliderVel.y;
-            }
-        } else {
-            vTemp(i, j, k) = v(i, j, k);
-        }
-    });
+    for (size_t c = 0; c < 3; ++c) {
+        _projectedValues[c].resize(_projectedFaces[c].size());
+    }
 
-    velocity->parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = wPos(i, j, k);
-        if (isInsideSdf(_colliderSdf.sample(pt))) {
-            Vector3D colliderVel = collider()->velocityAt(pt);
-            Vector3D vel = velocity->sample(pt);
-            Vector3D g = _colliderSdf.gradient(pt);
-            if (g.lengthSquared() > 0.0) {
-                Vector3D n = g.normalized();
-                Vector3D velr = vel - colliderVel;
-                Vector3D velt = projectAndApplyFriction(
-                    velr, n, collider()->frictionCoefficient());
-
-                Vector3D velp = velt + colliderVel;
-                wTemp(i, j, k) = velp.z;
-            } else {
-                wTemp(i, j, k) = colliderVel.z;
-            }
-        } else {
-            wTemp(i, j, k) = w(i, j, k);
-        }
-    });
+    parallelForEachGridIndex(
+        u.size(), _projectedFaces[0],
+        [&](size_t n, size_t i, size_t j, size_t k) {
+            _projectedValues[0][n] = projectedVelocity(uPos(i, j, k)).x;
+        });
+    parallelForEachGridIndex(
+        v.size(), _projectedFaces[1],
+        [&](size_t n, size_t i, size_t j, size_t k) {
+            _projectedValues[1][n] = projectedVelocity(vPos(i, j, k)).y;
+        });
+    parallelForEachGridIndex(
+        w.size(), _projectedFaces[2],
+        [&](size_t n, size_t i, size_t j, size_t k) {
+            _projectedValues[2][n] = projectedVelocity(wPos(i, j, k)).z;
+        });
 
     // Transfer results
-    u.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        u(i, j, k) = uTemp(i, j, k);
-    });
-    v.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        v(i, j, k) = vTemp(i, j, k);
-    });
-    w.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        w(i, j, k) = wTemp(i, j, k);
-    });
+    parallelForEachGridIndex(
+        u.size(), _projectedFaces[0],
+        [&](size_t n, size_t i, size_t j, size_t k) {
+            u(i, j, k) = _projectedValues[0][n];
+        });
+    parallelForEachGridIndex(
+        v.size(), _projectedFaces[1],
+        [&](size_t n, size_t i, size_t j, size_t k) {
+            v(i, j, k) = _projectedValues[1][n];
+        });
+    parallelForEachGridIndex(
+        w.size(), _projectedFaces[2],
+        [&](size_t n, size_t i, size_t j, size_t k) {
+            w(i, j, k) = _projectedValues[2][n];
+        });
 
     // No-flux: Project velocity on the domain boundary if closed
     if (closedDomainBoundaryFlag() & kDirectionLeft) {
@@ -252,4 +200,47 @@ void GridFractionalBoundaryConditionSolver3::onColliderUpdated(
     } else {
         _colliderSdf.fill(kMaxD);
     }
+
+    // The faces whose fluid fraction is zero are inside the collider, and
+    // the faces whose centers are inside the collider get projected. Both
+    // only change with the collider, so they are listed here once.
+    for (size_t c = 0; c < 3; ++c) {
+        Size3 faceSize = gridSize;
+        ++faceSize[c];
+
+        Vector3D faceOrigin = gridOrigin + 0.5 * gridSpacing;
+        faceOrigin[c] = gridOrigin[c];
+        Vector3D halfSpacing;
+        halfSpacing[c] = 0.5 * gridSpacing[c];
+
+        auto facePosition = [&](size_t i, size_t j, size_t k) {
+            return faceOrigin + Vector3D(
+                gridSpacing.x * i, gridSpacing.y * j, gridSpacing.z * k);
+        };
+
+        _faceMarkers[c].resize(faceSize);
+        _faceMarkers[c].parallelSet([&](size_t i, size_t j, size_t k) {
+            Vector3D pt = facePosition(i, j, k);
+            double phi0 = _colliderSdf.sample(pt - halfSpacing);
+            double phi1 = _colliderSdf.sample(pt + halfSpacing);
+            double frac = fractionInsideSdf(phi0, phi1);
+            frac = 1.0 - clamp(frac, 0.0, 1.0);
+            return frac > 0.0;
+        });
+
+        collectGridIndices(
+            faceSize,
+            [&](size_t i, size_t j, size_t k) {
+                return !_faceMarkers[c](i, j, k);
+            },
+            &_colliderFaces[c]);
+
+        collectGridIndices(
+            faceSize,
+            [&](size_t i, size_t j, size_t k) {
+                return isInsideSdf(
+                    _colliderSdf.sample(facePosition(i, j, k)));
+            },
+            &_projectedFaces[c]);
+    }
 }
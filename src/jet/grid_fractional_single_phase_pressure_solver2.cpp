@@ -5,9 +5,11 @@
 #include <pch.h>
 #include <jet/constants.h>
 #include <jet/fdm_iccg_solver2.h>
+#include <jet/fdm_matrix_free_cg_solver2.h>
 #include <jet/grid_fractional_boundary_condition_solver2.h>
 #include <jet/grid_fractional_single_phase_pressure_solver2.h>
 #include <jet/level_set_utils.h>
+#include <fdm_compression_helpers.h>
 #include <algorithm>
 
 using namespace jet;
@@ -15,6 +17,147 @@ using namespace jet;
 const double kDefaultTolerance = 1e-6;
 const double kMinWeight = 0.01;
 
+namespace {
+
+// Full 5-point stencil of a cell. Unlike FdmMatrixRow2, which only holds the
+// couplings to the right and up neighbors, this also has the couplings to the
+// left and down neighbors, so that a row can be applied without visiting the
+// rows of the neighbors.
+struct Stencil {
+    double center = 0.0;
+    double left = 0.0;
+    double right = 0.0;
+    double down = 0.0;
+    double up = 0.0;
+};
+
+// Adds the coupling of a fluid cell to one of its neighbors. A fluid
+// neighbor gets the off-diagonal term, while an air neighbor only adds the
+// ghost fluid term to the diagonal.
+void addNeighbor(
+    double term,
+    double centerPhi,
+    double neighborPhi,
+    double* center,
+    double* neighbor) {
+    if (isInsideSdf(neighborPhi)) {
+        *center += term;
+        *neighbor -= term;
+    } else {
+        double theta = fractionInsideSdf(centerPhi, neighborPhi);
+        theta = std::max(theta, 0.01);
+        *center += term / theta;
+    }
+}
+
+Stencil buildStencil(
+    const Array2<double>& uWeights,
+    const Array2<double>& vWeights,
+    const CellCenteredScalarGrid2& fluidSdf,
+    const Vector2D& invHSqr,
+    size_t i,
+    size_t j) {
+    Size2 size = fluidSdf.resolution();
+    Stencil stencil;
+
+    double centerPhi = fluidSdf(i, j);
+
+    if (!isInsideSdf(centerPhi)) {
+        stencil.center = 1.0;
+        return stencil;
+    }
+
+    if (i + 1 < size.x) {
+        addNeighbor(
+            uWeights(i + 1, j) * invHSqr.x,
+            centerPhi,
+            fluidSdf(i + 1, j),
+            &stencil.center,
+            &stencil.right);
+    }
+
+    if (i > 0) {
+        addNeighbor(
+            uWeights(i, j) * invHSqr.x,
+            centerPhi,
+            fluidSdf(i - 1, j),
+            &stencil.center,
+            &stencil.left);
+    }
+
+    if (j + 1 < size.y) {
+        addNeighbor(
+            vWeights(i, j + 1) * invHSqr.y,
+            centerPhi,
+            fluidSdf(i, j + 1),
+            &stencil.center,
+            &stencil.up);
+    }
+
+    if (j > 0) {
+        addNeighbor(
+            vWeights(i, j) * invHSqr.y,
+            centerPhi,
+            fluidSdf(i, j - 1),
+            &stencil.center,
+            &stencil.down);
+    }
+
+    return stencil;
+}
+
+// Pressure Poisson operator computed on the fly from the face weights and
+// the fluid SDF that the solver keeps anyway, instead of an FdmMatrix2.
+class FractionalOperator final : public FdmMatrixFreeOperator2 {
+ public:
+    FractionalOperator(
+        const Array2<double>& uWeights,
+        const Array2<double>& vWeights,
+        const CellCenteredScalarGrid2& fluidSdf,
+        const Vector2D& invHSqr) :
+        _uWeights(uWeights),
+        _vWeights(vWeights),
+        _fluidSdf(fluidSdf),
+        _invHSqr(invHSqr) {
+    }
+
+    Size2 size() const override {
+        return _fluidSdf.resolution();
+    }
+
+    void mvm(const FdmVector2& v, FdmVector2* result) const override {
+        Size2 size = _fluidSdf.resolution();
+
+        result->parallelForEachIndex([&](size_t i, size_t j) {
+            Stencil s = stencil(i, j);
+            (*result)(i, j)
+                = s.center * v(i, j)
+                + ((i > 0) ? s.left * v(i - 1, j) : 0.0)
+                + ((i + 1 < size.x) ? s.right * v(i + 1, j) : 0.0)
+                + ((j > 0) ? s.down * v(i, j - 1) : 0.0)
+                + ((j + 1 < size.y) ? s.up * v(i, j + 1) : 0.0);
+        });
+    }
+
+    void diagonal(FdmVector2* result) const override {
+        result->parallelForEachIndex([&](size_t i, size_t j) {
+            (*result)(i, j) = stencil(i, j).center;
+        });
+    }
+
+ private:
+    const Array2<double>& _uWeights;
+    const Array2<double>& _vWeights;
+    const CellCenteredScalarGrid2& _fluidSdf;
+    Vector2D _invHSqr;
+
+    Stencil stencil(size_t i, size_t j) const {
+        return buildStencil(_uWeights, _vWeights, _fluidSdf, _invHSqr, i, j);
+    }
+};
+
+}  // namespace
+
 GridFractionalSinglePhasePressureSolver2
 ::GridFractionalSinglePhasePressureSolver2() {
     _systemSolver = std::make_shared<FdmIccgSolver2>(100, kDefaultTolerance);
@@ -36,15 +179,71 @@ void GridFractionalSinglePhasePressureSolver2::solve(
         input,
         boundarySdf,
         fluidSdf);
-    buildSystem(input);
 
-    if (_systemSolver != nullptr) {
-        // Solve the system
-        _systemSolver->solve(&_system);
+    // The last pressure can be reused only if the grid is unchanged
+    bool isWarmStarting
+        = _isUsingWarmStart && _system.x.size() == input.resolution();
+
+    // Matrix-free solvers apply the operator straight from the weights, and
+    // compressed systems are assembled over the fluid cells only, so the
+    // grid matrix is not assembled for them
+    auto matrixFreeSolver
+        = std::dynamic_pointer_cast<FdmMatrixFreeCgSolver2>(_systemSolver);
+    // Solvers without compressed systems, such as the multigrid solvers,
+    // solve the full system instead
+    bool isCompressed = _isUsingCompressedSystem
+        && matrixFreeSolver == nullptr
+        && _systemSolver != nullptr
+        && _systemSolver->isCompressedSystemSupported();
+    buildSystem(input, matrixFreeSolver == nullptr && !isCompressed);
+
+    if (_systemSolver == nullptr) {
+        return;
+    }
 
-        // Apply pressure gradient
+    if (isCompressed) {
+        solveCompressedSystem(input, isWarmStarting);
         applyPressureGradient(input, output);
+        return;
+    }
+
+    Vector2D invH = 1.0 / input.gridSpacing();
+    FractionalOperator op(_uWeights, _vWeights, _fluidSdf, invH * invH);
+
+    if (isWarmStarting) {
+        // Solve for the correction to the last pressure instead, which is
+        // zero outside of the current fluid region
+        _lastPressure.swap(_system.x);
+        _system.x.resize(_lastPressure.size());
+        _lastPressure.parallelForEachIndex([&](size_t i, size_t j) {
+            if (!isInsideSdf(_fluidSdf(i, j))) {
+                _lastPressure(i, j) = 0.0;
+            }
+        });
+
+        if (matrixFreeSolver != nullptr) {
+            FdmMatrixFreeBlas2::residual(
+                op, _lastPressure, _system.b, &_system.x);
+        } else {
+            FdmBlas2::residual(
+                _system.A, _lastPressure, _system.b, &_system.x);
+        }
+        _system.b.swap(_system.x);
+    }
+
+    // Solve the system
+    if (matrixFreeSolver != nullptr) {
+        matrixFreeSolver->solve(op, _system.b, &_system.x);
+    } else {
+        _systemSolver->solve(&_system);
+    }
+
+    if (isWarmStarting) {
+        FdmBlas2::axpy(1.0, _lastPressure, _system.x, &_system.x);
     }
+
+    // Apply pressure gradient
+    applyPressureGradient(input, output);
 }
 
 GridBoundaryConditionSolver2Ptr
@@ -62,6 +261,31 @@ const FdmVector2& GridFractionalSinglePhasePressureSolver2::pressure() const {
     return _system.x;
 }
 
+bool GridFractionalSinglePhasePressureSolver2::isUsingWarmStart() const {
+    return _isUsingWarmStart;
+}
+
+void GridFractionalSinglePhasePressureSolver2::setIsUsingWarmStart(
+    bool isUsing) {
+    _isUsingWarmStart = isUsing;
+}
+
+unsigned int
+GridFractionalSinglePhasePressureSolver2::lastNumberOfIterations() const {
+    return (_systemSolver != nullptr)
+        ? _systemSolver->lastNumberOfIterations() : 0;
+}
+
+bool
+GridFractionalSinglePhasePressureSolver2::isUsingCompressedSystem() const {
+    return _isUsingCompressedSystem;
+}
+
+void GridFractionalSinglePhasePressureSolver2::setIsUsingCompressedSystem(
+    bool isUsing) {
+    _isUsingCompressedSystem = isUsing;
+}
+
 void GridFractionalSinglePhasePressureSolver2::buildWeights(
     const FaceCenteredGrid2& input,
     const ScalarField2& boundarySdf,
@@ -114,99 +338,115 @@ void GridFractionalSinglePhasePressureSolver2::buildWeights(
 }
 
 void GridFractionalSinglePhasePressureSolver2::buildSystem(
-    const FaceCenteredGrid2& input) {
+    const FaceCenteredGrid2& input,
+    bool isAssemblingMatrix) {
     Size2 size = input.resolution();
-    _system.A.resize(size);
     _system.x.resize(size);
     _system.b.resize(size);
 
+    if (isAssemblingMatrix) {
+        _system.A.resize(size);
+    } else {
+        _system.A.clear();
+    }
+
     Vector2D invH = 1.0 / input.gridSpacing();
     Vector2D invHSqr = invH * invH;
 
     // Build linear system
-    _system.A.parallelForEachIndex([&](size_t i, size_t j) {
-        auto& row = _system.A(i, j);
-
-        // initialize
-        row.center = row.right = row.up = 0.0;
-        _system.b(i, j) = 0.0;
+    _system.b.parallelForEachIndex([&](size_t i, size_t j) {
+        double& b = _system.b(i, j);
+        b = 0.0;
+
+        if (isAssemblingMatrix) {
+            Stencil stencil = buildStencil(
+                _uWeights, _vWeights, _fluidSdf, invHSqr, i, j);
+            auto& row = _system.A(i, j);
+            row.center = stencil.center;
+            row.right = stencil.right;
+            row.up = stencil.up;
+        }
 
-        double centerPhi = _fluidSdf(i, j);
+        if (!isInsideSdf(_fluidSdf(i, j))) {
+            return;
+        }
 
-        if (isInsideSdf(centerPhi)) {
-            double term;
-
-            if (i + 1 < size.x) {
-                term = _uWeights(i + 1, j) * invHSqr.x;
-                double rightPhi = _fluidSdf(i + 1, j);
-                if (isInsideSdf(rightPhi)) {
-                    row.center += term;
-                    row.right -= term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, rightPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j)
-                    += _uWeights(i + 1, j) * input.u(i + 1, j) * invH.x;
-            } else {
-                _system.b(i, j) += input.u(i + 1, j) * invH.x;
-            }
+        if (i + 1 < size.x) {
+            b += _uWeights(i + 1, j) * input.u(i + 1, j) * invH.x;
+        } else {
+            b += input.u(i + 1, j) * invH.x;
+        }
 
-            if (i > 0) {
-                term = _uWeights(i, j) * invHSqr.x;
-                double leftPhi = _fluidSdf(i - 1, j);
-                if (isInsideSdf(leftPhi)) {
-                    row.center += term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, leftPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j)
-                    -= _uWeights(i, j) * input.u(i, j) * invH.x;
-            } else {
-                _system.b(i, j) -= input.u(i, j) * invH.x;
-            }
+        if (i > 0) {
+            b -= _uWeights(i, j) * input.u(i, j) * invH.x;
+        } else {
+            b -= input.u(i, j) * invH.x;
+        }
 
-            if (j + 1 < size.y) {
-                term = _vWeights(i, j + 1) * invHSqr.y;
-                double upPhi = _fluidSdf(i, j + 1);
-                if (isInsideSdf(upPhi)) {
-                    row.center += term;
-                    row.up -= term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, upPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j)
-                    += _vWeights(i, j + 1) * input.v(i, j + 1) * invH.y;
-            } else {
-                _system.b(i, j) += input.v(i, j + 1) * invH.y;
-            }
+        if (j + 1 < size.y) {
+            b += _vWeights(i, j + 1) * input.v(i, j + 1) * invH.y;
+        } else {
+            b += input.v(i, j + 1) * invH.y;
+        }
 
-            if (j > 0) {
-                term = _vWeights(i, j) * invHSqr.y;
-                double downPhi = _fluidSdf(i, j - 1);
-                if (isInsideSdf(downPhi)) {
-                    row.center += term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, downPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j)
-                    -= _vWeights(i, j) * input.v(i, j) * invH.y;
-            } else {
-                _system.b(i, j) -= input.v(i, j) * invH.y;
-            }
+        if (j > 0) {
+            b -= _vWeights(i, j) * input.v(i, j) * invH.y;
         } else {
-            row.center = 1.0;
+            b -= input.v(i, j) * invH.y;
         }
     });
 }
 
+void GridFractionalSinglePhasePressureSolver2::solveCompressedSystem(
+    const FaceCenteredGrid2& input,
+    bool isWarmStarting) {
+    Vector2D invH = 1.0 / input.gridSpacing();
+    Vector2D invHSqr = invH * invH;
+
+    size_t numberOfRows = buildCompressedIndices(
+        input.resolution(),
+        [&](size_t i, size_t j) {
+            return isInsideSdf(_fluidSdf(i, j));
+        },
+        &_compressedIndices);
+
+    buildCompressedSystem(
+        _compressedIndices,
+        numberOfRows,
+        [&](size_t i, size_t j) {
+            return buildStencil(
+                _uWeights, _vWeights, _fluidSdf, invHSqr, i, j);
+        },
+        _system.b,
+        &_compressedSystem);
+
+    if (isWarmStarting) {
+        // Only the fluid cells are gathered, so the last pressure is zero
+        // outside of the current fluid region as in the full system
+        _lastCompressedPressure.resize(numberOfRows);
+        gatherCompressed(
+            _compressedIndices, _system.x, &_lastCompressedPressure);
+        FdmCompressedBlas::residual(
+            _compressedSystem.A,
+            _lastCompressedPressure,
+            _compressedSystem.b,
+            &_compressedSystem.x);
+        _compressedSystem.b.swap(_compressedSystem.x);
+    }
+
+    _systemSolver->solveCompressed(&_compressedSystem);
+
+    if (isWarmStarting) {
+        FdmCompressedBlas::axpy(
+            1.0,
+            _lastCompressedPressure,
+            _compressedSystem.x,
+            &_compressedSystem.x);
+    }
+
+    scatterCompressed(_compressedIndices, _compressedSystem.x, &_system.x);
+}
+
 void GridFractionalSinglePhasePressureSolver2::applyPressureGradient(
     const FaceCenteredGrid2& input,
     FaceCenteredGrid2* output) {
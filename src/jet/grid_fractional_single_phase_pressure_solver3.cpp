@@ -5,10 +5,14 @@
 #include <pch.h>
 #include <jet/constants.h>
 #include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
 #include <jet/grid_blocked_boundary_condition_solver3.h>
 #include <jet/grid_fractional_boundary_condition_solver3.h>
 #include <jet/grid_fractional_single_phase_pressure_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/memory_tracker.h>
+#include <fdm_compression_helpers.h>
+#include <grid_pressure_solver_helpers.h>
 #include <algorithm>
 
 using namespace jet;
@@ -16,6 +20,175 @@ using namespace jet;
 const double kDefaultTolerance = 1e-6;
 const double kMinWeight = 0.01;
 
+namespace {
+
+// Full 7-point stencil of a cell. Unlike FdmMatrixRow3, which only holds the
+// couplings to the right, up and front neighbors, this also has the couplings
+// to the left, down and back neighbors, so that a row can be applied without
+// visiting the rows of the neighbors.
+struct Stencil {
+    double center = 0.0;
+    double left = 0.0;
+    double right = 0.0;
+    double down = 0.0;
+    double up = 0.0;
+    double back = 0.0;
+    double front = 0.0;
+};
+
+// Adds the coupling of a fluid cell to one of its neighbors. A fluid
+// neighbor gets the off-diagonal term, while an air neighbor only adds the
+// ghost fluid term to the diagonal.
+void addNeighbor(
+    double term,
+    double centerPhi,
+    double neighborPhi,
+    double* center,
+    double* neighbor) {
+    if (isInsideSdf(neighborPhi)) {
+        *center += term;
+        *neighbor -= term;
+    } else {
+        double theta = fractionInsideSdf(centerPhi, neighborPhi);
+        theta = std::max(theta, 0.01);
+        *center += term / theta;
+    }
+}
+
+Stencil buildStencil(
+    const Array3<double>& uWeights,
+    const Array3<double>& vWeights,
+    const Array3<double>& wWeights,
+    const CellCenteredScalarGrid3& fluidSdf,
+    const Vector3D& invHSqr,
+    size_t i,
+    size_t j,
+    size_t k) {
+    Size3 size = fluidSdf.resolution();
+    Stencil stencil;
+
+    double centerPhi = fluidSdf(i, j, k);
+
+    if (!isInsideSdf(centerPhi)) {
+        stencil.center = 1.0;
+        return stencil;
+    }
+
+    if (i + 1 < size.x) {
+        addNeighbor(
+            uWeights(i + 1, j, k) * invHSqr.x,
+            centerPhi,
+            fluidSdf(i + 1, j, k),
+            &stencil.center,
+            &stencil.right);
+    }
+
+    if (i > 0) {
+        addNeighbor(
+            uWeights(i, j, k) * invHSqr.x,
+            centerPhi,
+            fluidSdf(i - 1, j, k),
+            &stencil.center,
+            &stencil.left);
+    }
+
+    if (j + 1 < size.y) {
+        addNeighbor(
+            vWeights(i, j + 1, k) * invHSqr.y,
+            centerPhi,
+            fluidSdf(i, j + 1, k),
+            &stencil.center,
+            &stencil.up);
+    }
+
+    if (j > 0) {
+        addNeighbor(
+            vWeights(i, j, k) * invHSqr.y,
+            centerPhi,
+            fluidSdf(i, j - 1, k),
+            &stencil.center,
+            &stencil.down);
+    }
+
+    if (k + 1 < size.z) {
+        addNeighbor(
+            wWeights(i, j, k + 1) * invHSqr.z,
+            centerPhi,
+            fluidSdf(i, j, k + 1),
+            &stencil.center,
+            &stencil.front);
+    }
+
+    if (k > 0) {
+        addNeighbor(
+            wWeights(i, j, k) * invHSqr.z,
+            centerPhi,
+            fluidSdf(i, j, k - 1),
+            &stencil.center,
+            &stencil.back);
+    }
+
+    return stencil;
+}
+
+// Pressure Poisson operator computed on the fly from the face weights and
+// the fluid SDF that the solver keeps anyway, instead of an FdmMatrix3.
+class FractionalOperator final : public FdmMatrixFreeOperator3 {
+ public:
+    FractionalOperator(
+        const Array3<double>& uWeights,
+        const Array3<double>& vWeights,
+        const Array3<double>& wWeights,
+        const CellCenteredScalarGrid3& fluidSdf,
+        const Vector3D& invHSqr) :
+        _uWeights(uWeights),
+        _vWeights(vWeights),
+        _wWeights(wWeights),
+        _fluidSdf(fluidSdf),
+        _invHSqr(invHSqr) {
+    }
+
+    Size3 size() const override {
+        return _fluidSdf.resolution();
+    }
+
+    void mvm(const FdmVector3& v, FdmVector3* result) const override {
+        Size3 size = _fluidSdf.resolution();
+
+        result->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            Stencil s = stencil(i, j, k);
+            (*result)(i, j, k)
+                = s.center * v(i, j, k)
+                + ((i > 0) ? s.left * v(i - 1, j, k) : 0.0)
+                + ((i + 1 < size.x) ? s.right * v(i + 1, j, k) : 0.0)
+                + ((j > 0) ? s.down * v(i, j - 1, k) : 0.0)
+                + ((j + 1 < size.y) ? s.up * v(i, j + 1, k) : 0.0)
+                + ((k > 0) ? s.back * v(i, j, k - 1) : 0.0)
+                + ((k + 1 < size.z) ? s.front * v(i, j, k + 1) : 0.0);
+        });
+    }
+
+    void diagonal(FdmVector3* result) const override {
+        result->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            (*result)(i, j, k) = stencil(i, j, k).center;
+        });
+    }
+
+ private:
+    const Array3<double>& _uWeights;
+    const Array3<double>& _vWeights;
+    const Array3<double>& _wWeights;
+    const CellCenteredScalarGrid3& _fluidSdf;
+    Vector3D _invHSqr;
+
+    Stencil stencil(size_t i, size_t j, size_t k) const {
+        return buildStencil(
+            _uWeights, _vWeights, _wWeights, _fluidSdf, _invHSqr, i, j, k);
+    }
+};
+
+}  // namespace
+
 GridFractionalSinglePhasePressureSolver3
 ::GridFractionalSinglePhasePressureSolver3() {
     _systemSolver = std::make_shared<FdmIccgSolver3>(100, kDefaultTolerance);
@@ -32,20 +205,97 @@ void GridFractionalSinglePhasePressureSolver3::solve(
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
     UNUSED_VARIABLE(timeIntervalInSeconds);
+    MemoryTagScope scope(MemoryTag::LinearSystem);
+    _lastMaxVelocity = -1.0;
 
-    buildWeights(
+    bool isWeightsChanged = buildWeights(
         input,
         boundarySdf,
         fluidSdf);
-    buildSystem(input);
 
-    if (_systemSolver != nullptr) {
-        // Solve the system
-        _systemSolver->solve(&_system);
+    // The last pressure can be reused only if the grid is unchanged
+    bool isWarmStarting
+        = _isUsingWarmStart && _system.x.size() == input.resolution();
+
+    // Matrix-free solvers apply the operator straight from the weights, and
+    // compressed systems are assembled over the fluid cells only, so the
+    // grid matrix is not assembled for them
+    auto matrixFreeSolver
+        = std::dynamic_pointer_cast<FdmMatrixFreeCgSolver3>(_systemSolver);
+    // Solvers without compressed systems, such as the multigrid solvers,
+    // solve the full system instead
+    bool isCompressed = _isUsingCompressedSystem
+        && matrixFreeSolver == nullptr
+        && _systemSolver != nullptr
+        && _systemSolver->isCompressedSystemSupported();
+    bool isUsingMatrix = matrixFreeSolver == nullptr && !isCompressed;
+
+    // The matrix only depends on the weights, the fluid SDF, and the grid
+    // spacing, so it is kept as long as none of them has changed
+    bool isMatrixChanged
+        = isWeightsChanged
+        || !_isMatrixValid
+        || _matrixGridSpacing != input.gridSpacing();
+    if (!isUsingMatrix) {
+        _system.A.clear();
+    }
+    buildSystem(input, isUsingMatrix && isMatrixChanged);
+    _isMatrixValid = isUsingMatrix && _systemSolver != nullptr;
+    _matrixGridSpacing = input.gridSpacing();
+
+    if (_systemSolver == nullptr) {
+        return;
+    }
 
-        // Apply pressure gradient
+    if (isCompressed) {
+        solveCompressedSystem(input, isWarmStarting);
         applyPressureGradient(input, output);
+        return;
     }
+
+    Vector3D invH = 1.0 / input.gridSpacing();
+    FractionalOperator op(
+        _uWeights, _vWeights, _wWeights, _fluidSdf, invH * invH);
+
+    if (isWarmStarting) {
+        // Solve for the correction to the last pressure instead, which is
+        // zero outside of the current fluid region
+        _lastPressure.swap(_system.x);
+        _system.x.resize(_lastPressure.size());
+        _lastPressure.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            if (!isInsideSdf(_fluidSdf(i, j, k))) {
+                _lastPressure(i, j, k) = 0.0;
+            }
+        });
+
+        if (matrixFreeSolver != nullptr) {
+            FdmMatrixFreeBlas3::residual(
+                op, _lastPressure, _system.b, &_system.x);
+        } else {
+            FdmBlas3::residual(
+                _system.A, _lastPressure, _system.b, &_system.x);
+        }
+        _system.b.swap(_system.x);
+    }
+
+    // Solve the system
+    {
+        MemoryTagScope solverScope(MemoryTag::LinearSolver);
+        if (matrixFreeSolver != nullptr) {
+            matrixFreeSolver->solve(op, _system.b, &_system.x);
+        } else if (isMatrixChanged) {
+            _systemSolver->solve(&_system);
+        } else {
+            _systemSolver->solveWithSameMatrix(&_system);
+        }
+    }
+
+    if (isWarmStarting) {
+        FdmBlas3::axpy(1.0, _lastPressure, _system.x, &_system.x);
+    }
+
+    // Apply pressure gradient
+    applyPressureGradient(input, output);
 }
 
 GridBoundaryConditionSolver3Ptr
@@ -58,212 +308,290 @@ GridFractionalSinglePhasePressureSolver3
 void GridFractionalSinglePhasePressureSolver3::setLinearSystemSolver(
     const FdmLinearSystemSolver3Ptr& solver) {
     _systemSolver = solver;
+
+    // Let the new solver see the matrix before it is reused
+    _isMatrixValid = false;
 }
 
 const FdmVector3& GridFractionalSinglePhasePressureSolver3::pressure() const {
     return _system.x;
 }
 
-void GridFractionalSinglePhasePressureSolver3::buildWeights(
-    const FaceCenteredGrid3& input,
-    const ScalarField3& boundarySdf,
-    const ScalarField3& fluidSdf) {
-    Size3 uSize = input.uSize();
-    Size3 vSize = input.vSize();
-    Size3 wSize = input.wSize();
-    auto uPos = input.uPosition();
-    auto vPos = input.vPosition();
-    auto wPos = input.wPosition();
-    _uWeights.resize(uSize);
-    _vWeights.resize(vSize);
-    _wWeights.resize(wSize);
-    _fluidSdf.resize(input.resolution(), input.gridSpacing(), input.origin());
-
-    _fluidSdf.fill([&](const Vector3D& x) {
-        return fluidSdf.sample(x);
-    });
-
-    Vector3D h = input.gridSpacing();
+bool GridFractionalSinglePhasePressureSolver3::isUsingWarmStart() const {
+    return _isUsingWarmStart;
+}
 
-    _uWeights.forEachIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = uPos(i, j, k);
-        double phi0 = boundarySdf.sample(pt - Vector3D(0.5 * h.x, 0.0, 0.0));
-        double phi1 = boundarySdf.sample(pt + Vector3D(0.5 * h.x, 0.0, 0.0));
-        double frac = fractionInsideSdf(phi0, phi1);
-        double weight = clamp(1.0 - frac, 0.0, 1.0);
+void GridFractionalSinglePhasePressureSolver3::setIsUsingWarmStart(
+    bool isUsing) {
+    _isUsingWarmStart = isUsing;
+}
 
-        // Clamp non-zero weight to kMinWeight. Having nearly-zero element
-        // in the matrix can be an issue.
-        if (weight < kMinWeight && weight > 0.0) {
-            weight = kMinWeight;
-        }
+unsigned int
+GridFractionalSinglePhasePressureSolver3::lastNumberOfIterations() const {
+    return (_systemSolver != nullptr)
+        ? _systemSolver->lastNumberOfIterations() : 0;
+}
 
-        _uWeights(i, j, k) = weight;
-    });
+double GridFractionalSinglePhasePressureSolver3::lastResidual() const {
+    return (_systemSolver != nullptr) ? _systemSolver->lastResidual() : 0.0;
+}
 
-    _vWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = vPos(i, j, k);
-        double phi0 = boundarySdf.sample(pt - Vector3D(0.0, 0.5 * h.y, 0.0));
-        double phi1 = boundarySdf.sample(pt + Vector3D(0.0, 0.5 * h.y, 0.0));
-        double frac = fractionInsideSdf(phi0, phi1);
-        double weight = clamp(1.0 - frac, 0.0, 1.0);
+double GridFractionalSinglePhasePressureSolver3::lastMaxVelocity() const {
+    return _lastMaxVelocity;
+}
 
-        // Clamp non-zero weight to kMinWeight. Having nearly-zero element
-        // in the matrix can be an issue.
-        if (weight < kMinWeight && weight > 0.0) {
-            weight = kMinWeight;
-        }
+bool
+GridFractionalSinglePhasePressureSolver3::isUsingCompressedSystem() const {
+    return _isUsingCompressedSystem;
+}
 
-        _vWeights(i, j, k) = weight;
-    });
+void GridFractionalSinglePhasePressureSolver3::setIsUsingCompressedSystem(
+    bool isUsing) {
+    _isUsingCompressedSystem = isUsing;
+}
 
-    _wWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = wPos(i, j, k);
-        double phi0 = boundarySdf.sample(pt - Vector3D(0.0, 0.0, 0.5 * h.z));
-        double phi1 = boundarySdf.sample(pt + Vector3D(0.0, 0.0, 0.5 * h.z));
+bool GridFractionalSinglePhasePressureSolver3::buildWeights(
+    const FaceCenteredGrid3& input,
+    const ScalarField3& boundarySdf,
+    const ScalarField3& fluidSdf) {
+    Size3 size = input.resolution();
+    Vector3D h = input.gridSpacing();
+    Size3 paddedSize(size.x + 2, size.y + 2, size.z + 2);
+    bool isResized = _fluidSdf.resolution() != size;
+    _uWeights.resize(input.uSize());
+    _vWeights.resize(input.vSize());
+    _wWeights.resize(input.wSize());
+    _fluidSdf.resize(size, h, input.origin());
+    _boundarySdf.resize(paddedSize);
+
+    // The face weights only need the boundary SDF at the centers of the two
+    // cells next to each face, so it is evaluated once per cell, including a
+    // layer of cells around the grid for the faces on the domain boundary.
+    // The grids that share the cell centers, such as the collider SDF and
+    // the level set of the liquid solvers, are read directly.
+    const ScalarGrid3* boundaryGrid = sameDataPointGrid(boundarySdf);
+    const ScalarGrid3* fluidGrid = sameDataPointGrid(fluidSdf);
+    Vector3D paddedOrigin = _fluidSdf.dataOrigin() - h;
+    auto fluidSdfData = _fluidSdf.dataAccessor();
+
+    bool isSdfChanged = parallelReduce(
+        kZeroSize,
+        paddedSize.z,
+        false,
+        [&](size_t kBegin, size_t kEnd, bool isChanged) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < paddedSize.y; ++j) {
+                    for (size_t i = 0; i < paddedSize.x; ++i) {
+                        bool isInside = i > 0 && i <= size.x
+                            && j > 0 && j <= size.y
+                            && k > 0 && k <= size.z;
+                        Vector3D pt(
+                            paddedOrigin.x + h.x * i,
+                            paddedOrigin.y + h.y * j,
+                            paddedOrigin.z + h.z * k);
+
+                        double phi = (isInside && boundaryGrid != nullptr)
+                            ? (*boundaryGrid)(i - 1, j - 1, k - 1)
+                            : boundarySdf.sample(pt);
+                        isChanged |= phi != _boundarySdf(i, j, k);
+                        _boundarySdf(i, j, k) = phi;
+
+                        if (isInside) {
+                            phi = (fluidGrid != nullptr)
+                                ? (*fluidGrid)(i - 1, j - 1, k - 1)
+                                : fluidSdf.sample(pt);
+                            double& fluidPhi
+                                = fluidSdfData(i - 1, j - 1, k - 1);
+                            isChanged |= phi != fluidPhi;
+                            fluidPhi = phi;
+                        }
+                    }
+                }
+            }
+            return isChanged;
+        },
+        [](bool a, bool b) {
+            return a || b;
+        });
+
+    // Open fraction of the face between the cells with given boundary SDF
+    auto weight = [](double phi0, double phi1) {
         double frac = fractionInsideSdf(phi0, phi1);
-        double weight = clamp(1.0 - frac, 0.0, 1.0);
+        double result = clamp(1.0 - frac, 0.0, 1.0);
 
         // Clamp non-zero weight to kMinWeight. Having nearly-zero element
         // in the matrix can be an issue.
-        if (weight < kMinWeight && weight > 0.0) {
-            weight = kMinWeight;
+        if (result < kMinWeight && result > 0.0) {
+            result = kMinWeight;
         }
 
-        _wWeights(i, j, k) = weight;
-    });
+        return result;
+    };
+
+    // The weights only depend on the boundary SDF, whose changes are already
+    // detected, so all three face grids are filled in one sweep
+    parallelFor(
+        kZeroSize,
+        size.z + 1,
+        [&](size_t k) {
+            for (size_t j = 0; j <= size.y; ++j) {
+                for (size_t i = 0; i <= size.x; ++i) {
+                    double phi = _boundarySdf(i + 1, j + 1, k + 1);
+                    if (j < size.y && k < size.z) {
+                        _uWeights(i, j, k)
+                            = weight(_boundarySdf(i, j + 1, k + 1), phi);
+                    }
+                    if (i < size.x && k < size.z) {
+                        _vWeights(i, j, k)
+                            = weight(_boundarySdf(i + 1, j, k + 1), phi);
+                    }
+                    if (i < size.x && j < size.y) {
+                        _wWeights(i, j, k)
+                            = weight(_boundarySdf(i + 1, j + 1, k), phi);
+                    }
+                }
+            }
+        });
+
+    return isResized || isSdfChanged;
+}
+
+const ScalarGrid3* GridFractionalSinglePhasePressureSolver3::sameDataPointGrid(
+    const ScalarField3& field) const {
+    auto grid = dynamic_cast<const ScalarGrid3*>(&field);
+    if (grid != nullptr
+        && grid->dataSize() == _fluidSdf.dataSize()
+        && grid->dataOrigin() == _fluidSdf.dataOrigin()
+        && grid->gridSpacing() == _fluidSdf.gridSpacing()) {
+        return grid;
+    }
+    return nullptr;
 }
 
 void GridFractionalSinglePhasePressureSolver3::buildSystem(
-    const FaceCenteredGrid3& input) {
+    const FaceCenteredGrid3& input,
+    bool isAssemblingMatrix) {
     Size3 size = input.resolution();
-    _system.A.resize(size);
     _system.x.resize(size);
     _system.b.resize(size);
 
+    if (isAssemblingMatrix) {
+        _system.A.resize(size);
+    }
+
     Vector3D invH = 1.0 / input.gridSpacing();
     Vector3D invHSqr = invH * invH;
 
     // Build linear system
-    _system.A.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        auto& row = _system.A(i, j, k);
-
-        // initialize
-        row.center = row.right = row.up = row.front = 0.0;
-        _system.b(i, j, k) = 0.0;
+    _system.b.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        double& b = _system.b(i, j, k);
+        b = 0.0;
+
+        if (isAssemblingMatrix) {
+            Stencil stencil = buildStencil(
+                _uWeights, _vWeights, _wWeights, _fluidSdf, invHSqr, i, j, k);
+            auto& row = _system.A(i, j, k);
+            row.center = stencil.center;
+            row.right = stencil.right;
+            row.up = stencil.up;
+            row.front = stencil.front;
+        }
 
-        double centerPhi = _fluidSdf(i, j, k);
+        if (!isInsideSdf(_fluidSdf(i, j, k))) {
+            return;
+        }
 
-        if (isInsideSdf(centerPhi)) {
-            double term;
-
-            if (i + 1 < size.x) {
-                term = _uWeights(i + 1, j, k) * invHSqr.x;
-                double rightPhi = _fluidSdf(i + 1, j, k);
-                if (isInsideSdf(rightPhi)) {
-                    row.center += term;
-                    row.right -= term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, rightPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j, k)
-                    += _uWeights(i + 1, j, k)
-                    * input.u(i + 1, j, k) * invH.x;
-            } else {
-                _system.b(i, j, k) += input.u(i + 1, j, k) * invH.x;
-            }
+        if (i + 1 < size.x) {
+            b += _uWeights(i + 1, j, k) * input.u(i + 1, j, k) * invH.x;
+        } else {
+            b += input.u(i + 1, j, k) * invH.x;
+        }
 
-            if (i > 0) {
-                term = _uWeights(i, j, k) * invHSqr.x;
-                double leftPhi = _fluidSdf(i - 1, j, k);
-                if (isInsideSdf(leftPhi)) {
-                    row.center += term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, leftPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j, k)
-                    -= _uWeights(i, j, k) * input.u(i, j, k) * invH.x;
-            } else {
-                _system.b(i, j, k) -= input.u(i, j, k) * invH.x;
-            }
+        if (i > 0) {
+            b -= _uWeights(i, j, k) * input.u(i, j, k) * invH.x;
+        } else {
+            b -= input.u(i, j, k) * invH.x;
+        }
 
-            if (j + 1 < size.y) {
-                term = _vWeights(i, j + 1, k) * invHSqr.y;
-                double upPhi = _fluidSdf(i, j + 1, k);
-                if (isInsideSdf(upPhi)) {
-                    row.center += term;
-                    row.up -= term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, upPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j, k)
-                    += _vWeights(i, j + 1, k)
-                    * input.v(i, j + 1, k) * invH.y;
-            } else {
-                _system.b(i, j, k) += input.v(i, j + 1, k) * invH.y;
-            }
+        if (j + 1 < size.y) {
+            b += _vWeights(i, j + 1, k) * input.v(i, j + 1, k) * invH.y;
+        } else {
+            b += input.v(i, j + 1, k) * invH.y;
+        }
 
-            if (j > 0) {
-                term = _vWeights(i, j, k) * invHSqr.y;
-                double downPhi = _fluidSdf(i, j - 1, k);
-                if (isInsideSdf(downPhi)) {
-                    row.center += term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, downPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j, k)
-                    -= _vWeights(i, j, k) * input.v(i, j, k) * invH.y;
-            } else {
-                _system.b(i, j, k) -= input.v(i, j, k) * invH.y;
-            }
+        if (j > 0) {
+            b -= _vWeights(i, j, k) * input.v(i, j, k) * invH.y;
+        } else {
+            b -= input.v(i, j, k) * invH.y;
+        }
 
-            if (k + 1 < size.z) {
-                term = _wWeights(i, j, k + 1) * invHSqr.z;
-                double frontPhi = _fluidSdf(i, j, k + 1);
-                if (isInsideSdf(frontPhi)) {
-                    row.center += term;
-                    row.front -= term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, frontPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j, k)
-                    += _wWeights(i, j, k + 1)
-                    * input.w(i, j, k + 1) * invH.z;
-            } else {
-                _system.b(i, j, k) += input.w(i, j, k + 1) * invH.z;
-            }
+        if (k + 1 < size.z) {
+            b += _wWeights(i, j, k + 1) * input.w(i, j, k + 1) * invH.z;
+        } else {
+            b += input.w(i, j, k + 1) * invH.z;
+        }
 
-            if (k > 0) {
-                term = _wWeights(i, j, k) * invHSqr.z;
-                double backPhi = _fluidSdf(i, j, k - 1);
-                if (isInsideSdf(backPhi)) {
-                    row.center += term;
-                } else {
-                    double theta = fractionInsideSdf(centerPhi, backPhi);
-                    theta = std::max(theta, 0.01);
-                    row.center += term / theta;
-                }
-                _system.b(i, j, k)
-                    -= _wWeights(i, j, k) * input.w(i, j, k) * invH.z;
-            } else {
-                _system.b(i, j, k) -= input.w(i, j, k) * invH.z;
-            }
+        if (k > 0) {
+            b -= _wWeights(i, j, k) * input.w(i, j, k) * invH.z;
         } else {
-            row.center = 1.0;
+            b -= input.w(i, j, k) * invH.z;
         }
     });
 }
 
+void GridFractionalSinglePhasePressureSolver3::solveCompressedSystem(
+    const FaceCenteredGrid3& input,
+    bool isWarmStarting) {
+    Vector3D invH = 1.0 / input.gridSpacing();
+    Vector3D invHSqr = invH * invH;
+
+    size_t numberOfRows = buildCompressedIndices(
+        input.resolution(),
+        [&](size_t i, size_t j, size_t k) {
+            return isInsideSdf(_fluidSdf(i, j, k));
+        },
+        &_compressedIndices);
+
+    buildCompressedSystem(
+        _compressedIndices,
+        numberOfRows,
+        [&](size_t i, size_t j, size_t k) {
+            return buildStencil(
+                _uWeights, _vWeights, _wWeights, _fluidSdf, invHSqr, i, j, k);
+        },
+        _system.b,
+        &_compressedSystem);
+
+    if (isWarmStarting) {
+        // Only the fluid cells are gathered, so the last pressure is zero
+        // outside of the current fluid region as in the full system
+        _lastCompressedPressure.resize(numberOfRows);
+        gatherCompressed(
+            _compressedIndices, _system.x, &_lastCompressedPressure);
+        FdmCompressedBlas::residual(
+            _compressedSystem.A,
+            _lastCompressedPressure,
+            _compressedSystem.b,
+            &_compressedSystem.x);
+        _compressedSystem.b.swap(_compressedSystem.x);
+    }
+
+    {
+        MemoryTagScope solverScope(MemoryTag::LinearSolver);
+        _systemSolver->solveCompressed(&_compressedSystem);
+    }
+
+    if (isWarmStarting) {
+        FdmCompressedBlas::axpy(
+            1.0,
+            _lastCompressedPressure,
+            _compressedSystem.x,
+            &_compressedSystem.x);
+    }
+
+    scatterCompressed(_compressedIndices, _compressedSystem.x, &_system.x);
+}
+
 void GridFractionalSinglePhasePressureSolver3::applyPressureGradient(
     const FaceCenteredGrid3& input,
     FaceCenteredGrid3* output) {
@@ -277,7 +605,9 @@ void GridFractionalSinglePhasePressureSolver3::applyPressureGradient(
 
     Vector3D invH = 1.0 / input.gridSpacing();
 
-    _system.x.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    // Each cell updates the faces on its upper side, which are then final,
+    // so the largest velocity is found in the same pass
+    auto applyToCell = [&](size_t i, size_t j, size_t k) {
         double centerPhi = _fluidSdf(i, j, k);
 
         if (i + 1 < size.x
@@ -321,5 +651,25 @@ void GridFractionalSinglePhasePressureSolver3::applyPressureGradient(
                 + invH.z / theta
                 * (_system.x(i, j, k + 1) - _system.x(i, j, k));
         }
-    });
+
+        return maxAbsFaceVelocity(u0, v0, w0, i, j, k);
+    };
+
+    _lastMaxVelocity = parallelReduce(
+        kZeroSize,
+        size.z,
+        0.0,
+        [&](size_t kBegin, size_t kEnd, double partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    for (size_t i = 0; i < size.x; ++i) {
+                        partial = std::max(partial, applyToCell(i, j, k));
+                    }
+                }
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 }
@@ -2,6 +2,9 @@
 
 #include <pch.h>
 #include <jet/grid_point_generator3.h>
+#include <point_generator_helpers.h>
+
+#include <algorithm>
 
 namespace jet {
 
@@ -32,4 +35,55 @@ void GridPointGenerator3::forEachPoint(
     }
 }
 
+size_t GridPointGenerator3::numberOfSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing) const {
+    return numberOfLatticeSteps(spacing, 0.0, boundingBox.depth());
+}
+
+size_t GridPointGenerator3::countPointsInSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd) const {
+    sliceEnd = std::min(sliceEnd, numberOfSlices(boundingBox, spacing));
+    if (sliceBegin >= sliceEnd) {
+        return 0;
+    }
+
+    return (sliceEnd - sliceBegin)
+        * numberOfLatticeSteps(spacing, 0.0, boundingBox.height())
+        * numberOfLatticeSteps(spacing, 0.0, boundingBox.width());
+}
+
+void GridPointGenerator3::generateRange(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd,
+    ArrayAccessor1<Vector3D> points) const {
+    sliceEnd = std::min(sliceEnd, numberOfSlices(boundingBox, spacing));
+
+    size_t numberOfRows
+        = numberOfLatticeSteps(spacing, 0.0, boundingBox.height());
+    size_t numberOfColumns
+        = numberOfLatticeSteps(spacing, 0.0, boundingBox.width());
+
+    Vector3D position;
+    size_t n = 0;
+    for (size_t k = sliceBegin; k < sliceEnd; ++k) {
+        position.z = k * spacing + boundingBox.lowerCorner.z;
+
+        for (size_t j = 0; j < numberOfRows; ++j) {
+            position.y = j * spacing + boundingBox.lowerCorner.y;
+
+            for (size_t i = 0; i < numberOfColumns; ++i) {
+                position.x = i * spacing + boundingBox.lowerCorner.x;
+                points[n++] = position;
+            }
+        }
+    }
+    JET_ASSERT(n == points.size());
+}
+
 }  // namespace jet
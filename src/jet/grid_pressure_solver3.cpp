@@ -10,3 +10,15 @@ GridPressureSolver3::GridPressureSolver3() {
 
 GridPressureSolver3::~GridPressureSolver3() {
 }
+
+unsigned int GridPressureSolver3::lastNumberOfIterations() const {
+    return 0;
+}
+
+double GridPressureSolver3::lastResidual() const {
+    return 0.0;
+}
+
+double GridPressureSolver3::lastMaxVelocity() const {
+    return -1.0;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_GRID_PRESSURE_SOLVER_HELPERS_H_
+#define SRC_JET_GRID_PRESSURE_SOLVER_HELPERS_H_
+
+#include <jet/array_accessor3.h>
+#include <jet/constants.h>
+#include <jet/math_utils.h>
+#include <jet/parallel.h>
+#include <jet/size3.h>
+#include <jet/vector3.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace jet {
+
+// Sets each element of the array to func(i, j, k) in parallel, and returns
+// true if any of them has changed. The pressure solvers use it to rebuild
+// the inputs of the matrix and to find out whether the matrix has changed
+// in the same pass.
+template <typename T, typename Function>
+bool updateArray(ArrayAccessor3<T> array, const Function& func) {
+    Size3 size = array.size();
+    return parallelReduce(
+        kZeroSize,
+        size.z,
+        false,
+        [&](size_t kBegin, size_t kEnd, bool isChanged) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    for (size_t i = 0; i < size.x; ++i) {
+                        T value = func(i, j, k);
+                        isChanged |= !(value == array(i, j, k));
+                        array(i, j, k) = value;
+                    }
+                }
+            }
+            return isChanged;
+        },
+        [](bool a, bool b) {
+            return a || b;
+        });
+}
+
+// Largest absolute velocity of the faces on the upper side of the cell, and
+// also of those on the lower side at the lower end of the grid, so that each
+// face is visited by exactly one cell
+inline double maxAbsFaceVelocity(
+    const ArrayAccessor3<double>& u,
+    const ArrayAccessor3<double>& v,
+    const ArrayAccessor3<double>& w,
+    size_t i,
+    size_t j,
+    size_t k) {
+    double result = max3(
+        std::fabs(u(i + 1, j, k)),
+        std::fabs(v(i, j + 1, k)),
+        std::fabs(w(i, j, k + 1)));
+    if (i == 0) {
+        result = std::max(result, std::fabs(u(i, j, k)));
+    }
+    if (j == 0) {
+        result = std::max(result, std::fabs(v(i, j, k)));
+    }
+    if (k == 0) {
+        result = std::max(result, std::fabs(w(i, j, k)));
+    }
+    return result;
+}
+
+// Solves the Poisson equation of a block of cells whose boundary faces are
+// fixed, which is a pure Neumann problem, with CG. Only the cells whose
+// isActive is nonzero take part, or all of them if isActive is empty, and
+// rhs should be mean-free over them. The cells are ordered like the linear
+// index of the block. Adding the gradient of q to the inner faces between
+// the active cells removes the divergence rhs. r, p and ap are scratch.
+inline void solveBlockPoisson(
+    const Size3& n,
+    const Vector3D& invHSqr,
+    const std::vector<char>& isActive,
+    const std::vector<double>& rhs,
+    double tolerance,
+    std::vector<double>* q,
+    std::vector<double>* r,
+    std::vector<double>* p,
+    std::vector<double>* ap) {
+    size_t count = n.x * n.y * n.z;
+    size_t strideY = n.x;
+    size_t strideZ = n.x * n.y;
+    q->assign(count, 0.0);
+    *r = rhs;
+    *p = rhs;
+    ap->assign(count, 0.0);
+
+    auto active = [&](size_t l) {
+        return isActive.empty() || isActive[l] != 0;
+    };
+
+    auto apply = [&](const std::vector<double>& x, std::vector<double>* y) {
+        for (size_t c = 0; c < n.z; ++c) {
+            for (size_t b = 0; b < n.y; ++b) {
+                for (size_t a = 0; a < n.x; ++a) {
+                    size_t l = a + strideY * b + strideZ * c;
+                    if (!active(l)) {
+                        continue;
+                    }
+
+                    double sum = 0.0;
+                    auto couple = [&](size_t m, double coef) {
+                        if (active(m)) {
+                            sum += coef * (x[l] - x[m]);
+                        }
+                    };
+                    if (a > 0) {
+                        couple(l - 1, invHSqr.x);
+                    }
+                    if (a + 1 < n.x) {
+                        couple(l + 1, invHSqr.x);
+                    }
+                    if (b > 0) {
+                        couple(l - strideY, invHSqr.y);
+                    }
+                    if (b + 1 < n.y) {
+                        couple(l + strideY, invHSqr.y);
+                    }
+                    if (c > 0) {
+                        couple(l - strideZ, invHSqr.z);
+                    }
+                    if (c + 1 < n.z) {
+                        couple(l + strideZ, invHSqr.z);
+                    }
+                    (*y)[l] = sum;
+                }
+            }
+        }
+    };
+
+    double rr = 0.0;
+    for (size_t l = 0; l < count; ++l) {
+        rr += (*r)[l] * (*r)[l];
+    }
+    double threshold = tolerance * tolerance * rr;
+
+    for (size_t iter = 0; iter < count && rr > threshold; ++iter) {
+        apply(*p, ap);
+
+        double pAp = 0.0;
+        for (size_t l = 0; l < count; ++l) {
+            pAp += (*p)[l] * (*ap)[l];
+        }
+        if (pAp <= 0.0) {
+            break;
+        }
+
+        double alpha = rr / pAp;
+        double rrNew = 0.0;
+        for (size_t l = 0; l < count; ++l) {
+            (*q)[l] += alpha * (*p)[l];
+            (*r)[l] -= alpha * (*ap)[l];
+            rrNew += (*r)[l] * (*r)[l];
+        }
+
+        double beta = rrNew / rr;
+        for (size_t l = 0; l < count; ++l) {
+            (*p)[l] = (*r)[l] + beta * (*p)[l];
+        }
+        rr = rrNew;
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_GRID_PRESSURE_SOLVER_HELPERS_H_
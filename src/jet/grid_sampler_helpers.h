@@ -0,0 +1,140 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_GRID_SAMPLER_HELPERS_H_
+#define SRC_JET_GRID_SAMPLER_HELPERS_H_
+
+#include <jet/array_samplers3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/scalar_field3.h>
+#include <jet/vector_field3.h>
+#include <algorithm>
+
+namespace jet {
+
+// Samplers that take the place of VectorField3::sample and
+// ScalarField3::sample in templated loops. The grid samplers hold the typed
+// array samplers of the grid, so the calls can be inlined. The field samplers
+// fall back to the virtual call for fields of unknown type.
+
+// Samples the three components with the interpolation weights shared
+// between them. Along each axis, one component lives on the faces and the
+// other two on the cell centers, so only two sets of weights are needed per
+// axis instead of three. The results are the same as the linear samplers.
+class FaceCenteredGridSampler3 {
+ public:
+    explicit FaceCenteredGridSampler3(const FaceCenteredGrid3& grid)
+    : _u(grid.uConstAccessor()),
+      _v(grid.vConstAccessor()),
+      _w(grid.wConstAccessor()),
+      _faceOrigin(grid.origin()),
+      _centerOrigin(grid.origin() + 0.5 * grid.gridSpacing()),
+      _gridSpacing(grid.gridSpacing()) {
+    }
+
+    // Interpolation indices and weights of a point, which can be shared by
+    // the samplers of the grids with the same layout.
+    struct Weights {
+        ssize_t fi, fj, fk, ci, cj, ck;
+        double ffx, ffy, ffz, cfx, cfy, cfz;
+    };
+
+    Vector3D operator()(const Vector3D& x) const {
+        return sample(getWeights(x));
+    }
+
+    Weights getWeights(const Vector3D& x) const {
+        Vector3D faceX = (x - _faceOrigin) / _gridSpacing;
+        Vector3D centerX = (x - _centerOrigin) / _gridSpacing;
+
+        // Face weights along each axis, then the cell-center weights
+        Weights w;
+        Size3 uSize = _u.size();
+        Size3 vSize = _v.size();
+        Size3 wSize = _w.size();
+        getBarycentric(
+            faceX.x, 0, static_cast<ssize_t>(uSize.x), &w.fi, &w.ffx);
+        getBarycentric(
+            faceX.y, 0, static_cast<ssize_t>(vSize.y), &w.fj, &w.ffy);
+        getBarycentric(
+            faceX.z, 0, static_cast<ssize_t>(wSize.z), &w.fk, &w.ffz);
+        getBarycentric(
+            centerX.x, 0, static_cast<ssize_t>(vSize.x), &w.ci, &w.cfx);
+        getBarycentric(
+            centerX.y, 0, static_cast<ssize_t>(uSize.y), &w.cj, &w.cfy);
+        getBarycentric(
+            centerX.z, 0, static_cast<ssize_t>(uSize.z), &w.ck, &w.cfz);
+        return w;
+    }
+
+    Vector3D sample(const Weights& w) const {
+        return Vector3D(
+            interpolate(_u, w.fi, w.cj, w.ck, w.ffx, w.cfy, w.cfz),
+            interpolate(_v, w.ci, w.fj, w.ck, w.cfx, w.ffy, w.cfz),
+            interpolate(_w, w.ci, w.cj, w.fk, w.cfx, w.cfy, w.ffz));
+    }
+
+ private:
+    ConstArrayAccessor3<double> _u;
+    ConstArrayAccessor3<double> _v;
+    ConstArrayAccessor3<double> _w;
+    Vector3D _faceOrigin;
+    Vector3D _centerOrigin;
+    Vector3D _gridSpacing;
+
+    static double interpolate(
+        const ConstArrayAccessor3<double>& data,
+        ssize_t i,
+        ssize_t j,
+        ssize_t k,
+        double fx,
+        double fy,
+        double fz) {
+        Size3 size = data.size();
+        ssize_t ip1 = std::min(i + 1, static_cast<ssize_t>(size.x) - 1);
+        ssize_t jp1 = std::min(j + 1, static_cast<ssize_t>(size.y) - 1);
+        ssize_t kp1 = std::min(k + 1, static_cast<ssize_t>(size.z) - 1);
+
+        return trilerp(
+            data(i, j, k),
+            data(ip1, j, k),
+            data(i, jp1, k),
+            data(ip1, jp1, k),
+            data(i, j, kp1),
+            data(ip1, j, kp1),
+            data(i, jp1, kp1),
+            data(ip1, jp1, kp1),
+            fx,
+            fy,
+            fz);
+    }
+};
+
+class ScalarFieldSampler3 {
+ public:
+    explicit ScalarFieldSampler3(const ScalarField3& field) : _field(field) {
+    }
+
+    double operator()(const Vector3D& x) const {
+        return _field.sample(x);
+    }
+
+ private:
+    const ScalarField3& _field;
+};
+
+class VectorFieldSampler3 {
+ public:
+    explicit VectorFieldSampler3(const VectorField3& field) : _field(field) {
+    }
+
+    Vector3D operator()(const Vector3D& x) const {
+        return _field.sample(x);
+    }
+
+ private:
+    const VectorField3& _field;
+};
+
+}  // namespace jet
+
+#endif  // SRC_JET_GRID_SAMPLER_HELPERS_H_
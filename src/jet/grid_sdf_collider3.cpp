@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/grid_sdf_collider3.h>
+#include <jet/implicit_surface3.h>
+#include <jet/surface_to_implicit3.h>
+
+using namespace jet;
+
+namespace {
+
+// Implicit surface backed by the baked grid. Queries inside the span of the
+// grid data points are answered by the grid, and the rest go to the original
+// surface.
+class GridSdfSurface3 final : public ImplicitSurface3 {
+ public:
+    GridSdfSurface3(
+        const std::shared_ptr<CellCenteredScalarGrid3>& sdf,
+        const Surface3Ptr& surface)
+    : _sdf(sdf),
+      _surface(std::make_shared<SurfaceToImplicit3>(surface)) {
+        Vector3D halfSpacing = 0.5 * _sdf->gridSpacing();
+        _domain = BoundingBox3D(
+            _sdf->boundingBox().lowerCorner + halfSpacing,
+            _sdf->boundingBox().upperCorner - halfSpacing);
+    }
+
+    Vector3D closestPoint(const Vector3D& otherPoint) const override {
+        if (_domain.contains(otherPoint)) {
+            double phi = _sdf->sample(otherPoint);
+            Vector3D n = gradientDirection(otherPoint);
+            if (n.lengthSquared() > 0.0) {
+                return otherPoint - phi * n;
+            }
+        }
+
+        return _surface->closestPoint(otherPoint);
+    }
+
+    BoundingBox3D boundingBox() const override {
+        return _surface->boundingBox();
+    }
+
+    bool intersects(const Ray3D& ray) const override {
+        return _surface->intersects(ray);
+    }
+
+    double signedDistance(const Vector3D& otherPoint) const override {
+        if (_domain.contains(otherPoint)) {
+            return _sdf->sample(otherPoint);
+        }
+
+        return _surface->signedDistance(otherPoint);
+    }
+
+ protected:
+    Vector3D actualClosestNormal(const Vector3D& otherPoint) const override {
+        if (_domain.contains(otherPoint)) {
+            Vector3D n = gradientDirection(otherPoint);
+            if (n.lengthSquared() > 0.0) {
+                return n;
+            }
+        }
+
+        return _surface->closestNormal(otherPoint);
+    }
+
+    SurfaceRayIntersection3 actualClosestIntersection(
+        const Ray3D& ray) const override {
+        return _surface->closestIntersection(ray);
+    }
+
+ private:
+    std::shared_ptr<CellCenteredScalarGrid3> _sdf;
+    SurfaceToImplicit3Ptr _surface;
+    BoundingBox3D _domain;
+
+    Vector3D gradientDirection(const Vector3D& x) const {
+        Vector3D g = _sdf->gradient(x);
+        double length = g.length();
+        return (length > 0.0) ? g / length : Vector3D();
+    }
+};
+
+}  // namespace
+
+GridSdfCollider3::GridSdfCollider3(
+    const Collider3Ptr& collider,
+    const Size3& resolution,
+    const Vector3D& gridSpacing,
+    const Vector3D& gridOrigin) :
+    _collider(collider),
+    _sdf(std::make_shared<CellCenteredScalarGrid3>(
+        resolution, gridSpacing, gridOrigin)) {
+    setFrictionCoefficient(collider->frictionCoefficient());
+    rebuild();
+}
+
+Vector3D GridSdfCollider3::velocityAt(const Vector3D& point) const {
+    return _collider->velocityAt(point);
+}
+
+const Collider3Ptr& GridSdfCollider3::collider() const {
+    return _collider;
+}
+
+const CellCenteredScalarGrid3& GridSdfCollider3::sdf() const {
+    return *_sdf;
+}
+
+void GridSdfCollider3::rebuild() {
+    Surface3Ptr surface = _collider->surface();
+    ImplicitSurface3Ptr implicitSurface
+        = std::dynamic_pointer_cast<ImplicitSurface3>(surface);
+    if (implicitSurface == nullptr) {
+        implicitSurface = std::make_shared<SurfaceToImplicit3>(surface);
+    }
+
+    _sdf->fill([&](const Vector3D& pt) {
+        return implicitSurface->signedDistance(pt);
+    });
+
+    setSurface(std::make_shared<GridSdfSurface3>(_sdf, surface));
+}
@@ -0,0 +1,628 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/grid_sequence_cache3.h>
+#include <jet/parallel.h>
+#include <mapped_file.h>
+#include <particle_cache_codec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const char kGridSequenceCacheTag[] = "JETGSEQC";
+const size_t kGridSequenceCacheTagLength = 8;
+const uint32_t kGridSequenceCacheVersion = 1;
+
+// Number of data points per axis of a tile
+const size_t kGridSequenceCacheTileSize = 8;
+
+// Every value is stored as a zigzag-coded 64-bit integer split into 8 planes
+const size_t kGridSequenceCacheNumberOfPlanes = 8;
+
+// Bound of the quantized values, so the differences of two of them fit in
+// 63 bits
+const double kMaxQuantizedValue = 2305843009213693952.0;  // 2^61
+
+struct GridSequenceCacheHeader {
+    char tag[kGridSequenceCacheTagLength];
+    uint32_t version;
+    uint32_t tileSize;
+    uint64_t resolution[3];
+    double gridSpacing[3];
+    double origin[3];
+    uint64_t dataSize[3];
+    double dataOrigin[3];
+    double tolerance;
+    uint64_t keyframeInterval;
+};
+
+// Header of each frame, followed by the tile mask (one bit per tile, only for
+// the frames that are not keyframes), the block table, and the blocks
+struct GridSequenceCacheFrameHeader {
+    uint64_t numberOfValues;
+    uint32_t blocksPerPlane;
+    uint32_t maskSize;
+    uint64_t payloadSize;
+};
+
+struct GridSequenceCacheIndexEntry {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t isKeyframe;
+    uint32_t numberOfChangedTiles;
+};
+
+struct GridSequenceCacheFooter {
+    uint64_t indexOffset;
+    uint64_t numberOfFrames;
+    char tag[kGridSequenceCacheTagLength];
+};
+
+static_assert(
+    sizeof(GridSequenceCacheHeader) == 152,
+    "Unexpected grid sequence cache header size");
+static_assert(
+    sizeof(GridSequenceCacheFrameHeader) == 24,
+    "Unexpected grid sequence cache frame header size");
+static_assert(
+    sizeof(GridSequenceCacheIndexEntry) == 24,
+    "Unexpected grid sequence cache index entry size");
+static_assert(
+    sizeof(GridSequenceCacheFooter) == 24,
+    "Unexpected grid sequence cache footer size");
+
+// Splits the data points into tiles of kGridSequenceCacheTileSize^3 points.
+// The tiles on the upper boundaries can be smaller.
+class TileLayout {
+ public:
+    explicit TileLayout(const Size3& dataSize) : _dataSize(dataSize) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            _tiles[axis] = (dataSize[axis] + kGridSequenceCacheTileSize - 1)
+                / kGridSequenceCacheTileSize;
+        }
+    }
+
+    size_t numberOfTiles() const {
+        return _tiles.x * _tiles.y * _tiles.z;
+    }
+
+    // Calls func(index) for the linear data index of each point of tile t
+    template <typename Callback>
+    void forEachIndex(size_t t, const Callback& func) const {
+        size_t ti = t % _tiles.x;
+        size_t tj = (t / _tiles.x) % _tiles.y;
+        size_t tk = t / (_tiles.x * _tiles.y);
+        size_t iBegin = ti * kGridSequenceCacheTileSize;
+        size_t jBegin = tj * kGridSequenceCacheTileSize;
+        size_t kBegin = tk * kGridSequenceCacheTileSize;
+        size_t iEnd
+            = std::min(iBegin + kGridSequenceCacheTileSize, _dataSize.x);
+        size_t jEnd
+            = std::min(jBegin + kGridSequenceCacheTileSize, _dataSize.y);
+        size_t kEnd
+            = std::min(kBegin + kGridSequenceCacheTileSize, _dataSize.z);
+        for (size_t k = kBegin; k < kEnd; ++k) {
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                size_t row = (k * _dataSize.y + j) * _dataSize.x;
+                for (size_t i = iBegin; i < iEnd; ++i) {
+                    func(row + i);
+                }
+            }
+        }
+    }
+
+    size_t numberOfValues(size_t t) const {
+        size_t n = 1;
+        size_t tileIndex[3] = {
+            t % _tiles.x,
+            (t / _tiles.x) % _tiles.y,
+            t / (_tiles.x * _tiles.y)
+        };
+        for (size_t axis = 0; axis < 3; ++axis) {
+            size_t begin = tileIndex[axis] * kGridSequenceCacheTileSize;
+            n *= std::min(kGridSequenceCacheTileSize, _dataSize[axis] - begin);
+        }
+        return n;
+    }
+
+ private:
+    Size3 _dataSize;
+    Size3 _tiles;
+};
+
+int64_t quantize(double value, double step) {
+    double s = value / step;
+    if (!(s == s)) {
+        return 0;
+    }
+    s = std::min(std::max(s, -kMaxQuantizedValue), kMaxQuantizedValue);
+    return std::llround(s);
+}
+
+void storeValue(uint64_t value, size_t n, size_t i, uint8_t* planes) {
+    for (size_t b = 0; b < kGridSequenceCacheNumberOfPlanes; ++b) {
+        planes[b * n + i] = static_cast<uint8_t>(value >> (8 * b));
+    }
+}
+
+uint64_t loadValue(const uint8_t* planes, size_t n, size_t i) {
+    uint64_t value = 0;
+    for (size_t b = 0; b < kGridSequenceCacheNumberOfPlanes; ++b) {
+        value |= static_cast<uint64_t>(planes[b * n + i]) << (8 * b);
+    }
+    return value;
+}
+
+}  // namespace
+
+GridSequenceCacheWriter3::GridSequenceCacheWriter3(std::ostream* strm) :
+    _strm(strm) {
+}
+
+GridSequenceCacheWriter3::~GridSequenceCacheWriter3() {
+    close();
+}
+
+double GridSequenceCacheWriter3::tolerance() const {
+    return _tolerance;
+}
+
+void GridSequenceCacheWriter3::setTolerance(double tolerance) {
+    JET_THROW_INVALID_ARG_IF(!(tolerance > 0.0) || !_frames.empty());
+
+    _tolerance = tolerance;
+}
+
+size_t GridSequenceCacheWriter3::keyframeInterval() const {
+    return _keyframeInterval;
+}
+
+void GridSequenceCacheWriter3::setKeyframeInterval(size_t interval) {
+    JET_THROW_INVALID_ARG_IF(interval == 0 || !_frames.empty());
+
+    _keyframeInterval = interval;
+}
+
+size_t GridSequenceCacheWriter3::numberOfFrames() const {
+    return _frames.size();
+}
+
+void GridSequenceCacheWriter3::addFrame(const ScalarGrid3& grid) {
+    JET_THROW_INVALID_ARG_IF(_isClosed);
+
+    if (_frames.empty()) {
+        _resolution = grid.resolution();
+        _gridSpacing = grid.gridSpacing();
+        _origin = grid.origin();
+        _dataSize = grid.dataSize();
+        _dataOrigin = grid.dataOrigin();
+        writeHeader();
+    } else {
+        JET_THROW_INVALID_ARG_IF(
+            grid.resolution() != _resolution
+            || grid.gridSpacing() != _gridSpacing
+            || grid.origin() != _origin
+            || grid.dataSize() != _dataSize);
+    }
+
+    const size_t n = _dataSize.x * _dataSize.y * _dataSize.z;
+    const double step = 2.0 * _tolerance;
+    const double* values = grid.constDataAccessor().data();
+
+    std::vector<int64_t> quantized(n);
+    parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            quantized[i] = quantize(values[i], step);
+        }
+    });
+
+    const bool isKeyframe = (_frames.size() % _keyframeInterval == 0);
+    TileLayout layout(_dataSize);
+    std::vector<uint8_t> mask;
+    std::vector<uint8_t> planes;
+    size_t numberOfValues = 0;
+    size_t numberOfChangedTiles = 0;
+
+    if (isKeyframe) {
+        // Differences along the data order, which are small for smooth fields
+        numberOfValues = n;
+        numberOfChangedTiles = layout.numberOfTiles();
+        planes.resize(n * kGridSequenceCacheNumberOfPlanes);
+        parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int64_t previous = (i > 0) ? quantized[i - 1] : 0;
+                storeValue(
+                    zigzagEncode(quantized[i] - previous), n, i, planes.data());
+            }
+        });
+    } else {
+        // Differences from the previous frame for the changed tiles only
+        const size_t numberOfTiles = layout.numberOfTiles();
+        std::vector<char> isChanged(numberOfTiles, 0);
+        parallelFor(kZeroSize, numberOfTiles, [&](size_t t) {
+            layout.forEachIndex(t, [&](size_t i) {
+                if (quantized[i] != _quantized[i]) {
+                    isChanged[t] = 1;
+                }
+            });
+        });
+
+        mask.assign((numberOfTiles + 7) / 8, 0);
+        std::vector<size_t> tileOffsets(numberOfTiles, 0);
+        for (size_t t = 0; t < numberOfTiles; ++t) {
+            tileOffsets[t] = numberOfValues;
+            if (isChanged[t]) {
+                mask[t / 8] |= static_cast<uint8_t>(1 << (t % 8));
+                numberOfValues += layout.numberOfValues(t);
+                ++numberOfChangedTiles;
+            }
+        }
+
+        planes.resize(numberOfValues * kGridSequenceCacheNumberOfPlanes);
+        parallelFor(kZeroSize, numberOfTiles, [&](size_t t) {
+            if (!isChanged[t]) {
+                return;
+            }
+            size_t j = tileOffsets[t];
+            layout.forEachIndex(t, [&](size_t i) {
+                storeValue(
+                    zigzagEncode(quantized[i] - _quantized[i]),
+                    numberOfValues, j++, planes.data());
+            });
+        });
+    }
+
+    std::vector<uint32_t> table;
+    std::vector<std::vector<uint8_t>> blocks;
+    encodeRansBlocks(
+        planes, numberOfValues, kGridSequenceCacheNumberOfPlanes, &table,
+        &blocks);
+
+    GridSequenceCacheFrameHeader frameHeader;
+    std::memset(&frameHeader, 0, sizeof(frameHeader));
+    frameHeader.numberOfValues = numberOfValues;
+    frameHeader.blocksPerPlane = static_cast<uint32_t>(
+        table.size() / kGridSequenceCacheNumberOfPlanes);
+    frameHeader.maskSize = static_cast<uint32_t>(mask.size());
+    frameHeader.payloadSize = table.size() * sizeof(uint32_t);
+    for (const auto& block : blocks) {
+        frameHeader.payloadSize += block.size();
+    }
+
+    FrameEntry entry;
+    entry.offset = _offset;
+    entry.isKeyframe = isKeyframe ? 1 : 0;
+    entry.numberOfChangedTiles = static_cast<uint32_t>(numberOfChangedTiles);
+
+    write(&frameHeader, sizeof(frameHeader));
+    write(mask.data(), mask.size());
+    write(table.data(), table.size() * sizeof(uint32_t));
+    for (const auto& block : blocks) {
+        write(block.data(), block.size());
+    }
+
+    entry.size = _offset - entry.offset;
+    _frames.push_back(entry);
+    _quantized.swap(quantized);
+}
+
+void GridSequenceCacheWriter3::close() {
+    if (_isClosed) {
+        return;
+    }
+
+    if (_frames.empty()) {
+        writeHeader();
+    }
+
+    GridSequenceCacheFooter footer;
+    std::memset(&footer, 0, sizeof(footer));
+    footer.indexOffset = _offset;
+    footer.numberOfFrames = _frames.size();
+    std::memcpy(footer.tag, kGridSequenceCacheTag, kGridSequenceCacheTagLength);
+
+    for (const FrameEntry& frame : _frames) {
+        GridSequenceCacheIndexEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.offset = frame.offset;
+        entry.size = frame.size;
+        entry.isKeyframe = frame.isKeyframe;
+        entry.numberOfChangedTiles = frame.numberOfChangedTiles;
+        write(&entry, sizeof(entry));
+    }
+    write(&footer, sizeof(footer));
+
+    _quantized.clear();
+    _isClosed = true;
+}
+
+void GridSequenceCacheWriter3::writeHeader() {
+    GridSequenceCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.tag, kGridSequenceCacheTag, kGridSequenceCacheTagLength);
+    header.version = kGridSequenceCacheVersion;
+    header.tileSize = static_cast<uint32_t>(kGridSequenceCacheTileSize);
+    for (size_t axis = 0; axis < 3; ++axis) {
+        header.resolution[axis] = _resolution[axis];
+        header.gridSpacing[axis] = _gridSpacing[axis];
+        header.origin[axis] = _origin[axis];
+        header.dataSize[axis] = _dataSize[axis];
+        header.dataOrigin[axis] = _dataOrigin[axis];
+    }
+    header.tolerance = _tolerance;
+    header.keyframeInterval = _keyframeInterval;
+    write(&header, sizeof(header));
+}
+
+void GridSequenceCacheWriter3::write(const void* data, size_t size) {
+    if (size > 0) {
+        _strm->write(
+            static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        _offset += size;
+    }
+}
+
+GridSequenceCacheReader3::GridSequenceCacheReader3() :
+    _decodedFrame(kMaxSize) {
+}
+
+GridSequenceCacheReader3::~GridSequenceCacheReader3() {
+}
+
+bool GridSequenceCacheReader3::open(const std::string& filename) {
+    close();
+
+    std::unique_ptr<MappedFile> file(new MappedFile(filename));
+    if (!file->isValid()
+        || file->size() < sizeof(GridSequenceCacheHeader)
+            + sizeof(GridSequenceCacheFooter)) {
+        return false;
+    }
+
+    const char* data = file->data();
+    size_t size = file->size();
+
+    GridSequenceCacheHeader header;
+    GridSequenceCacheFooter footer;
+    std::memcpy(&header, data, sizeof(header));
+    std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+    if (std::memcmp(
+            header.tag, kGridSequenceCacheTag, kGridSequenceCacheTagLength) != 0
+        || header.version != kGridSequenceCacheVersion
+        || header.tileSize != kGridSequenceCacheTileSize
+        || !(header.tolerance > 0.0)
+        || std::memcmp(
+            footer.tag, kGridSequenceCacheTag, kGridSequenceCacheTagLength)
+            != 0) {
+        return false;
+    }
+
+    // The index should end right at the footer
+    size_t indexEnd = size - sizeof(footer);
+    if (footer.indexOffset < sizeof(header) || footer.indexOffset > indexEnd
+        || footer.numberOfFrames
+            != (indexEnd - footer.indexOffset)
+                / sizeof(GridSequenceCacheIndexEntry)
+        || (indexEnd - footer.indexOffset)
+            % sizeof(GridSequenceCacheIndexEntry) != 0) {
+        return false;
+    }
+
+    // Bound the number of the data points so the decoded planes fit in
+    // memory addressing
+    size_t maxValues = std::numeric_limits<size_t>::max()
+        / (kGridSequenceCacheNumberOfPlanes * sizeof(int64_t));
+    size_t numberOfValues = 1;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        uint64_t n = header.dataSize[axis];
+        if (n != 0 && numberOfValues > maxValues / n) {
+            return false;
+        }
+        numberOfValues *= static_cast<size_t>(n);
+    }
+
+    size_t indexOffset = static_cast<size_t>(footer.indexOffset);
+    std::vector<FrameEntry> frames(
+        static_cast<size_t>(footer.numberOfFrames));
+    for (size_t f = 0; f < frames.size(); ++f) {
+        GridSequenceCacheIndexEntry entry;
+        std::memcpy(
+            &entry, data + indexOffset + f * sizeof(entry), sizeof(entry));
+        if (entry.offset < sizeof(header) || entry.offset > indexOffset
+            || entry.size > indexOffset - entry.offset
+            || entry.size < sizeof(GridSequenceCacheFrameHeader)
+            || (f == 0 && entry.isKeyframe == 0)) {
+            return false;
+        }
+
+        frames[f].offset = static_cast<size_t>(entry.offset);
+        frames[f].size = static_cast<size_t>(entry.size);
+        frames[f].isKeyframe = (entry.isKeyframe != 0);
+        frames[f].numberOfChangedTiles = entry.numberOfChangedTiles;
+    }
+
+    _resolution = Size3(
+        static_cast<size_t>(header.resolution[0]),
+        static_cast<size_t>(header.resolution[1]),
+        static_cast<size_t>(header.resolution[2]));
+    _gridSpacing = Vector3D(
+        header.gridSpacing[0], header.gridSpacing[1], header.gridSpacing[2]);
+    _origin = Vector3D(header.origin[0], header.origin[1], header.origin[2]);
+    _dataSize = Size3(
+        static_cast<size_t>(header.dataSize[0]),
+        static_cast<size_t>(header.dataSize[1]),
+        static_cast<size_t>(header.dataSize[2]));
+    _dataOrigin = Vector3D(
+        header.dataOrigin[0], header.dataOrigin[1], header.dataOrigin[2]);
+    _tolerance = header.tolerance;
+
+    _file = std::move(file);
+    _frames = std::move(frames);
+    return true;
+}
+
+void GridSequenceCacheReader3::close() {
+    _file.reset();
+    _frames.clear();
+    _quantized.clear();
+    _decodedFrame = kMaxSize;
+}
+
+size_t GridSequenceCacheReader3::numberOfFrames() const {
+    return _frames.size();
+}
+
+bool GridSequenceCacheReader3::isKeyframe(size_t i) const {
+    return _frames[i].isKeyframe;
+}
+
+size_t GridSequenceCacheReader3::numberOfStoredTiles(size_t i) const {
+    return _frames[i].numberOfChangedTiles;
+}
+
+size_t GridSequenceCacheReader3::frameSize(size_t i) const {
+    return _frames[i].size;
+}
+
+double GridSequenceCacheReader3::tolerance() const {
+    return _tolerance;
+}
+
+Size3 GridSequenceCacheReader3::resolution() const {
+    return _resolution;
+}
+
+Vector3D GridSequenceCacheReader3::gridSpacing() const {
+    return _gridSpacing;
+}
+
+Vector3D GridSequenceCacheReader3::origin() const {
+    return _origin;
+}
+
+Size3 GridSequenceCacheReader3::dataSize() const {
+    return _dataSize;
+}
+
+Vector3D GridSequenceCacheReader3::dataOrigin() const {
+    return _dataOrigin;
+}
+
+bool GridSequenceCacheReader3::readFrame(size_t i, ScalarGrid3* grid) {
+    if (i >= _frames.size()) {
+        return false;
+    }
+
+    grid->resize(_resolution, _gridSpacing, _origin);
+    if (grid->dataSize() != _dataSize) {
+        return false;
+    }
+
+    if (_decodedFrame != i) {
+        // Start from the last frame read if it is between the keyframe and
+        // the requested frame
+        size_t first = i;
+        while (!_frames[first].isKeyframe) {
+            --first;
+        }
+        if (_decodedFrame != kMaxSize && _decodedFrame >= first
+            && _decodedFrame < i) {
+            first = _decodedFrame + 1;
+        }
+
+        for (size_t f = first; f <= i; ++f) {
+            if (!decodeFrame(f)) {
+                _decodedFrame = kMaxSize;
+                return false;
+            }
+        }
+        _decodedFrame = i;
+    }
+
+    const double step = 2.0 * _tolerance;
+    double* values = grid->dataAccessor().data();
+    parallelRangeFor(
+        kZeroSize, _quantized.size(), [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                values[j] = step * static_cast<double>(_quantized[j]);
+            }
+        });
+
+    return true;
+}
+
+bool GridSequenceCacheReader3::decodeFrame(size_t i) {
+    const FrameEntry& frame = _frames[i];
+    const char* data = _file->data() + frame.offset;
+
+    GridSequenceCacheFrameHeader frameHeader;
+    std::memcpy(&frameHeader, data, sizeof(frameHeader));
+
+    TileLayout layout(_dataSize);
+    const size_t n = _dataSize.x * _dataSize.y * _dataSize.z;
+    const size_t numberOfTiles = layout.numberOfTiles();
+    size_t maskSize = frame.isKeyframe ? 0 : (numberOfTiles + 7) / 8;
+    size_t remaining = frame.size - sizeof(frameHeader);
+    if (frameHeader.maskSize != maskSize || maskSize > remaining
+        || frameHeader.payloadSize != remaining - maskSize) {
+        return false;
+    }
+
+    const uint8_t* mask
+        = reinterpret_cast<const uint8_t*>(data + sizeof(frameHeader));
+    std::vector<size_t> tileOffsets;
+    size_t numberOfValues = n;
+    if (!frame.isKeyframe) {
+        tileOffsets.resize(numberOfTiles);
+        numberOfValues = 0;
+        for (size_t t = 0; t < numberOfTiles; ++t) {
+            tileOffsets[t] = numberOfValues;
+            if (mask[t / 8] & (1 << (t % 8))) {
+                numberOfValues += layout.numberOfValues(t);
+            }
+        }
+    }
+    if (frameHeader.numberOfValues != numberOfValues) {
+        return false;
+    }
+
+    std::vector<uint8_t> planes;
+    if (!decodeRansBlocks(
+            data + sizeof(frameHeader) + maskSize,
+            static_cast<size_t>(frameHeader.payloadSize), numberOfValues,
+            kGridSequenceCacheNumberOfPlanes, frameHeader.blocksPerPlane,
+            &planes)) {
+        return false;
+    }
+
+    if (frame.isKeyframe) {
+        _quantized.resize(n);
+        int64_t value = 0;
+        for (size_t j = 0; j < n; ++j) {
+            value += zigzagDecode(loadValue(planes.data(), n, j));
+            _quantized[j] = value;
+        }
+    } else {
+        parallelFor(kZeroSize, numberOfTiles, [&](size_t t) {
+            if (!(mask[t / 8] & (1 << (t % 8)))) {
+                return;
+            }
+            size_t j = tileOffsets[t];
+            layout.forEachIndex(t, [&](size_t index) {
+                _quantized[index] += zigzagDecode(
+                    loadValue(planes.data(), numberOfValues, j++));
+            });
+        });
+    }
+
+    return true;
+}
@@ -3,9 +3,11 @@
 #include <pch.h>
 #include <jet/constants.h>
 #include <jet/fdm_iccg_solver2.h>
+#include <jet/fdm_matrix_free_cg_solver2.h>
 #include <jet/grid_blocked_boundary_condition_solver2.h>
 #include <jet/grid_single_phase_pressure_solver2.h>
 #include <jet/level_set_utils.h>
+#include <fdm_compression_helpers.h>
 
 using namespace jet;
 
@@ -15,6 +17,104 @@ const char kBoundary = 2;
 
 const double kDefaultTolerance = 1e-6;
 
+namespace {
+
+// Full 5-point stencil of a cell. Unlike FdmMatrixRow2, which only holds the
+// couplings to the right and up neighbors, this also has the couplings to the
+// left and down neighbors, so that a row can be applied without visiting the
+// rows of the neighbors.
+struct Stencil {
+    double center = 0.0;
+    double left = 0.0;
+    double right = 0.0;
+    double down = 0.0;
+    double up = 0.0;
+};
+
+Stencil buildStencil(
+    const Array2<char>& markers,
+    const Vector2D& invHSqr,
+    size_t i,
+    size_t j) {
+    Size2 size = markers.size();
+    Stencil stencil;
+
+    if (markers(i, j) != kFluid) {
+        stencil.center = 1.0;
+        return stencil;
+    }
+
+    if (i + 1 < size.x && markers(i + 1, j) != kBoundary) {
+        stencil.center += invHSqr.x;
+        if (markers(i + 1, j) == kFluid) {
+            stencil.right -= invHSqr.x;
+        }
+    }
+
+    if (i > 0 && markers(i - 1, j) != kBoundary) {
+        stencil.center += invHSqr.x;
+        if (markers(i - 1, j) == kFluid) {
+            stencil.left -= invHSqr.x;
+        }
+    }
+
+    if (j + 1 < size.y && markers(i, j + 1) != kBoundary) {
+        stencil.center += invHSqr.y;
+        if (markers(i, j + 1) == kFluid) {
+            stencil.up -= invHSqr.y;
+        }
+    }
+
+    if (j > 0 && markers(i, j - 1) != kBoundary) {
+        stencil.center += invHSqr.y;
+        if (markers(i, j - 1) == kFluid) {
+            stencil.down -= invHSqr.y;
+        }
+    }
+
+    return stencil;
+}
+
+// Pressure Poisson operator computed on the fly from the cell markers, which
+// takes a byte per cell instead of the 24 bytes of an FdmMatrixRow2.
+class MarkerOperator final : public FdmMatrixFreeOperator2 {
+ public:
+    MarkerOperator(const Array2<char>& markers, const Vector2D& invHSqr) :
+        _markers(markers),
+        _invHSqr(invHSqr) {
+    }
+
+    Size2 size() const override {
+        return _markers.size();
+    }
+
+    void mvm(const FdmVector2& v, FdmVector2* result) const override {
+        Size2 size = _markers.size();
+
+        _markers.parallelForEachIndex([&](size_t i, size_t j) {
+            Stencil s = buildStencil(_markers, _invHSqr, i, j);
+            (*result)(i, j)
+                = s.center * v(i, j)
+                + ((i > 0) ? s.left * v(i - 1, j) : 0.0)
+                + ((i + 1 < size.x) ? s.right * v(i + 1, j) : 0.0)
+                + ((j > 0) ? s.down * v(i, j - 1) : 0.0)
+                + ((j + 1 < size.y) ? s.up * v(i, j + 1) : 0.0);
+        });
+    }
+
+    void diagonal(FdmVector2* result) const override {
+        _markers.parallelForEachIndex([&](size_t i, size_t j) {
+            (*result)(i, j) = buildStencil(_markers, _invHSqr, i, j).center;
+        });
+    }
+
+ private:
+    const Array2<char>& _markers;
+    Vector2D _invHSqr;
+};
+
+}  // namespace
+
 GridSinglePhasePressureSolver2::GridSinglePhasePressureSolver2() {
     _systemSolver = std::make_shared<FdmIccgSolver2>(100, kDefaultTolerance);
 }
@@ -36,15 +136,71 @@ void GridSinglePhasePressureSolver2::solve(
         pos,
         boundarySdf,
         fluidSdf);
-    buildSystem(input);
 
-    if (_systemSolver != nullptr) {
-        // Solve the system
-        _systemSolver->solve(&_system);
+    // The last pressure can be reused only if the grid is unchanged
+    bool isWarmStarting
+        = _isUsingWarmStart && _system.x.size() == input.resolution();
+
+    // Matrix-free solvers apply the operator straight from the markers, and
+    // compressed systems are assembled over the fluid cells only, so the
+    // grid matrix is not assembled for them
+    auto matrixFreeSolver
+        = std::dynamic_pointer_cast<FdmMatrixFreeCgSolver2>(_systemSolver);
+    // Solvers without compressed systems, such as the multigrid solvers,
+    // solve the full system instead
+    bool isCompressed = _isUsingCompressedSystem
+        && matrixFreeSolver == nullptr
+        && _systemSolver != nullptr
+        && _systemSolver->isCompressedSystemSupported();
+    buildSystem(input, matrixFreeSolver == nullptr && !isCompressed);
+
+    if (_systemSolver == nullptr) {
+        return;
+    }
 
-        // Apply pressure gradient
+    if (isCompressed) {
+        solveCompressedSystem(input, isWarmStarting);
         applyPressureGradient(input, output);
+        return;
     }
+
+    Vector2D invH = 1.0 / input.gridSpacing();
+    MarkerOperator op(_markers, invH * invH);
+
+    if (isWarmStarting) {
+        // Solve for the correction to the last pressure instead, which is
+        // zero outside of the current fluid region
+        _lastPressure.swap(_system.x);
+        _system.x.resize(_lastPressure.size());
+        _lastPressure.parallelForEachIndex([&](size_t i, size_t j) {
+            if (_markers(i, j) != kFluid) {
+                _lastPressure(i, j) = 0.0;
+            }
+        });
+
+        if (matrixFreeSolver != nullptr) {
+            FdmMatrixFreeBlas2::residual(
+                op, _lastPressure, _system.b, &_system.x);
+        } else {
+            FdmBlas2::residual(
+                _system.A, _lastPressure, _system.b, &_system.x);
+        }
+        _system.b.swap(_system.x);
+    }
+
+    // Solve the system
+    if (matrixFreeSolver != nullptr) {
+        matrixFreeSolver->solve(op, _system.b, &_system.x);
+    } else {
+        _systemSolver->solve(&_system);
+    }
+
+    if (isWarmStarting) {
+        FdmBlas2::axpy(1.0, _lastPressure, _system.x, &_system.x);
+    }
+
+    // Apply pressure gradient
+    applyPressureGradient(input, output);
 }
 
 GridBoundaryConditionSolver2Ptr
@@ -61,6 +217,27 @@ const FdmVector2& GridSinglePhasePressureSolver2::pressure() const {
     return _system.x;
 }
 
+bool GridSinglePhasePressureSolver2::isUsingWarmStart() const {
+    return _isUsingWarmStart;
+}
+
+void GridSinglePhasePressureSolver2::setIsUsingWarmStart(bool isUsing) {
+    _isUsingWarmStart = isUsing;
+}
+
+unsigned int GridSinglePhasePressureSolver2::lastNumberOfIterations() const {
+    return (_systemSolver != nullptr)
+        ? _systemSolver->lastNumberOfIterations() : 0;
+}
+
+bool GridSinglePhasePressureSolver2::isUsingCompressedSystem() const {
+    return _isUsingCompressedSystem;
+}
+
+void GridSinglePhasePressureSolver2::setIsUsingCompressedSystem(bool isUsing) {
+    _isUsingCompressedSystem = isUsing;
+}
+
 void GridSinglePhasePressureSolver2::buildMarkers(
     const Size2& size,
     const std::function<Vector2D(size_t, size_t)>& pos,
@@ -80,51 +257,86 @@ void GridSinglePhasePressureSolver2::buildMarkers(
 }
 
 void GridSinglePhasePressureSolver2::buildSystem(
-    const FaceCenteredGrid2& input) {
+    const FaceCenteredGrid2& input,
+    bool isAssemblingMatrix) {
     Size2 size = input.resolution();
-    _system.A.resize(size);
     _system.x.resize(size);
     _system.b.resize(size);
 
+    if (isAssemblingMatrix) {
+        _system.A.resize(size);
+    } else {
+        _system.A.clear();
+    }
+
     Vector2D invH = 1.0 / input.gridSpacing();
     Vector2D invHSqr = invH * invH;
 
     // Build linear system
-    _system.A.parallelForEachIndex([&](size_t i, size_t j) {
-        auto& row = _system.A(i, j);
-
-        // initialize
-        row.center = row.right = row.up = 0.0;
-        _system.b(i, j) = 0.0;
-
+    _system.b.parallelForEachIndex([&](size_t i, size_t j) {
         if (_markers(i, j) == kFluid) {
             _system.b(i, j) = input.divergenceAtCellCenter(i, j);
+        } else {
+            _system.b(i, j) = 0.0;
+        }
 
-            if (i + 1 < size.x && _markers(i + 1, j) != kBoundary) {
-                row.center += invHSqr.x;
-                if (_markers(i + 1, j) == kFluid) {
-                    row.right -= invHSqr.x;
-                }
-            }
+        if (isAssemblingMatrix) {
+            Stencil stencil = buildStencil(_markers, invHSqr, i, j);
+            auto& row = _system.A(i, j);
+            row.center = stencil.center;
+            row.right = stencil.right;
+            row.up = stencil.up;
+        }
+    });
+}
 
-            if (i > 0 && _markers(i - 1, j) != kBoundary) {
-                row.center += invHSqr.x;
-            }
+void GridSinglePhasePressureSolver2::solveCompressedSystem(
+    const FaceCenteredGrid2& input,
+    bool isWarmStarting) {
+    Vector2D invH = 1.0 / input.gridSpacing();
+    Vector2D invHSqr = invH * invH;
 
-            if (j + 1 < size.y && _markers(i, j + 1) != kBoundary) {
-                row.center += invHSqr.y;
-                if (_markers(i, j + 1) == kFluid) {
-                    row.up -= invHSqr.y;
-                }
-            }
+    size_t numberOfRows = buildCompressedIndices(
+        input.resolution(),
+        [&](size_t i, size_t j) {
+            return _markers(i, j) == kFluid;
+        },
+        &_compressedIndices);
 
-            if (j > 0 && _markers(i, j - 1) != kBoundary) {
-                row.center += invHSqr.y;
-            }
-        } else {
-            row.center = 1.0;
-        }
-    });
+    buildCompressedSystem(
+        _compressedIndices,
+        numberOfRows,
+        [&](size_t i, size_t j) {
+            return buildStencil(_markers, invHSqr, i, j);
+        },
+        _system.b,
+        &_compressedSystem);
+
+    if (isWarmStarting) {
+        // Only the fluid cells are gathered, so the last pressure is zero
+        // outside of the current fluid region as in the full system
+        _lastCompressedPressure.resize(numberOfRows);
+        gatherCompressed(
+            _compressedIndices, _system.x, &_lastCompressedPressure);
+        FdmCompressedBlas::residual(
+            _compressedSystem.A,
+            _lastCompressedPressure,
+            _compressedSystem.b,
+            &_compressedSystem.x);
+        _compressedSystem.b.swap(_compressedSystem.x);
+    }
+
+    _systemSolver->solveCompressed(&_compressedSystem);
+
+    if (isWarmStarting) {
+        FdmCompressedBlas::axpy(
+            1.0,
+            _lastCompressedPressure,
+            _compressedSystem.x,
+            &_compressedSystem.x);
+    }
+
+    scatterCompressed(_compressedIndices, _compressedSystem.x, &_system.x);
 }
 
 void GridSinglePhasePressureSolver2::applyPressureGradient(
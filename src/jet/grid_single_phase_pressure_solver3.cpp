@@ -3,9 +3,13 @@
 #include <pch.h>
 #include <jet/constants.h>
 #include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
 #include <jet/grid_blocked_boundary_condition_solver3.h>
 #include <jet/grid_single_phase_pressure_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/memory_tracker.h>
+#include <fdm_compression_helpers.h>
+#include <grid_pressure_solver_helpers.h>
 
 using namespace jet;
 
@@ -15,6 +19,127 @@ const char kBoundary = 2;
 
 const double kDefaultTolerance = 1e-6;
 
+// Relative tolerance of the local solves inside the coarse cells.
+const double kCoarseCellTolerance = 1e-10;
+
+namespace {
+
+// Full 7-point stencil of a cell. Unlike FdmMatrixRow3, which only holds the
+// couplings to the right, up and front neighbors, this also has the couplings
+// to the left, down and back neighbors, so that a row can be applied without
+// visiting the rows of the neighbors.
+struct Stencil {
+    double center = 0.0;
+    double left = 0.0;
+    double right = 0.0;
+    double down = 0.0;
+    double up = 0.0;
+    double back = 0.0;
+    double front = 0.0;
+};
+
+Stencil buildStencil(
+    const Array3<char>& markers,
+    const Vector3D& invHSqr,
+    size_t i,
+    size_t j,
+    size_t k) {
+    Size3 size = markers.size();
+    Stencil stencil;
+
+    if (markers(i, j, k) != kFluid) {
+        stencil.center = 1.0;
+        return stencil;
+    }
+
+    if (i + 1 < size.x && markers(i + 1, j, k) != kBoundary) {
+        stencil.center += invHSqr.x;
+        if (markers(i + 1, j, k) == kFluid) {
+            stencil.right -= invHSqr.x;
+        }
+    }
+
+    if (i > 0 && markers(i - 1, j, k) != kBoundary) {
+        stencil.center += invHSqr.x;
+        if (markers(i - 1, j, k) == kFluid) {
+            stencil.left -= invHSqr.x;
+        }
+    }
+
+    if (j + 1 < size.y && markers(i, j + 1, k) != kBoundary) {
+        stencil.center += invHSqr.y;
+        if (markers(i, j + 1, k) == kFluid) {
+            stencil.up -= invHSqr.y;
+        }
+    }
+
+    if (j > 0 && markers(i, j - 1, k) != kBoundary) {
+        stencil.center += invHSqr.y;
+        if (markers(i, j - 1, k) == kFluid) {
+            stencil.down -= invHSqr.y;
+        }
+    }
+
+    if (k + 1 < size.z && markers(i, j, k + 1) != kBoundary) {
+        stencil.center += invHSqr.z;
+        if (markers(i, j, k + 1) == kFluid) {
+            stencil.front -= invHSqr.z;
+        }
+    }
+
+    if (k > 0 && markers(i, j, k - 1) != kBoundary) {
+        stencil.center += invHSqr.z;
+        if (markers(i, j, k - 1) == kFluid) {
+            stencil.back -= invHSqr.z;
+        }
+    }
+
+    return stencil;
+}
+
+// Pressure Poisson operator computed on the fly from the cell markers, which
+// takes a byte per cell instead of the 32 bytes of an FdmMatrixRow3.
+class MarkerOperator final : public FdmMatrixFreeOperator3 {
+ public:
+    MarkerOperator(const Array3<char>& markers, const Vector3D& invHSqr) :
+        _markers(markers),
+        _invHSqr(invHSqr) {
+    }
+
+    Size3 size() const override {
+        return _markers.size();
+    }
+
+    void mvm(const FdmVector3& v, FdmVector3* result) const override {
+        Size3 size = _markers.size();
+
+        _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            Stencil s = buildStencil(_markers, _invHSqr, i, j, k);
+            (*result)(i, j, k)
+                = s.center * v(i, j, k)
+                + ((i > 0) ? s.left * v(i - 1, j, k) : 0.0)
+                + ((i + 1 < size.x) ? s.right * v(i + 1, j, k) : 0.0)
+                + ((j > 0) ? s.down * v(i, j - 1, k) : 0.0)
+                + ((j + 1 < size.y) ? s.up * v(i, j + 1, k) : 0.0)
+                + ((k > 0) ? s.back * v(i, j, k - 1) : 0.0)
+                + ((k + 1 < size.z) ? s.front * v(i, j, k + 1) : 0.0);
+        });
+    }
+
+    void diagonal(FdmVector3* result) const override {
+        _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            (*result)(i, j, k)
+                = buildStencil(_markers, _invHSqr, i, j, k).center;
+        });
+    }
+
+ private:
+    const Array3<char>& _markers;
+    Vector3D _invHSqr;
+};
+
+}  // namespace
+
 GridSinglePhasePressureSolver3::GridSinglePhasePressureSolver3() {
     _systemSolver = std::make_shared<FdmIccgSolver3>(100, kDefaultTolerance);
 }
@@ -29,22 +154,105 @@ void GridSinglePhasePressureSolver3::solve(
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
     UNUSED_VARIABLE(timeIntervalInSeconds);
+    MemoryTagScope scope(MemoryTag::LinearSystem);
+    _lastMaxVelocity = -1.0;
 
     auto pos = input.cellCenterPosition();
-    buildMarkers(
+    bool isMarkersChanged = buildMarkers(
         input.resolution(),
         pos,
         boundarySdf,
         fluidSdf);
-    buildSystem(input);
 
-    if (_systemSolver != nullptr) {
-        // Solve the system
-        _systemSolver->solve(&_system);
+    if (_isUsingCoarseProjection && _systemSolver != nullptr) {
+        // The matrix of the grid is not assembled in this mode
+        _isMatrixValid = false;
+        solveCoarseProjection(input, output);
+        return;
+    }
+
+    // The last pressure can be reused only if the grid is unchanged
+    bool isWarmStarting
+        = _isUsingWarmStart && _system.x.size() == input.resolution();
+
+    // Matrix-free solvers apply the operator straight from the markers, and
+    // compressed systems are assembled over the fluid cells only, so the
+    // grid matrix is not assembled for them
+    auto matrixFreeSolver
+        = std::dynamic_pointer_cast<FdmMatrixFreeCgSolver3>(_systemSolver);
+    // Solvers without compressed systems, such as the multigrid solvers,
+    // solve the full system instead
+    bool isCompressed = _isUsingCompressedSystem
+        && matrixFreeSolver == nullptr
+        && _systemSolver != nullptr
+        && _systemSolver->isCompressedSystemSupported();
+    bool isUsingMatrix = matrixFreeSolver == nullptr && !isCompressed;
 
-        // Apply pressure gradient
+    // The matrix only depends on the markers and the grid spacing, so it is
+    // kept as long as neither has changed, as for static smoke domains
+    bool isMatrixChanged
+        = isMarkersChanged
+        || !_isMatrixValid
+        || _matrixGridSpacing != input.gridSpacing();
+    if (!isUsingMatrix) {
+        _system.A.clear();
+    }
+    buildSystem(input, isUsingMatrix && isMatrixChanged);
+    _isMatrixValid = isUsingMatrix && _systemSolver != nullptr;
+    _matrixGridSpacing = input.gridSpacing();
+
+    if (_systemSolver == nullptr) {
+        return;
+    }
+
+    if (isCompressed) {
+        solveCompressedSystem(input, isWarmStarting);
         applyPressureGradient(input, output);
+        return;
     }
+
+    Vector3D invH = 1.0 / input.gridSpacing();
+    MarkerOperator op(_markers, invH * invH);
+
+    if (isWarmStarting) {
+        // Solve for the correction to the last pressure instead, which is
+        // zero outside of the current fluid region
+        _lastPressure.swap(_system.x);
+        _system.x.resize(_lastPressure.size());
+        _lastPressure.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            if (_markers(i, j, k) != kFluid) {
+                _lastPressure(i, j, k) = 0.0;
+            }
+        });
+
+        if (matrixFreeSolver != nullptr) {
+            FdmMatrixFreeBlas3::residual(
+                op, _lastPressure, _system.b, &_system.x);
+        } else {
+            FdmBlas3::residual(
+                _system.A, _lastPressure, _system.b, &_system.x);
+        }
+        _system.b.swap(_system.x);
+    }
+
+    // Solve the system
+    {
+        MemoryTagScope solverScope(MemoryTag::LinearSolver);
+        if (matrixFreeSolver != nullptr) {
+            matrixFreeSolver->solve(op, _system.b, &_system.x);
+        } else if (isMatrixChanged) {
+            _systemSolver->solve(&_system);
+        } else {
+            _systemSolver->solveWithSameMatrix(&_system);
+        }
+    }
+
+    if (isWarmStarting) {
+        FdmBlas3::axpy(1.0, _lastPressure, _system.x, &_system.x);
+    }
+
+    // Apply pressure gradient
+    applyPressureGradient(input, output);
 }
 
 GridBoundaryConditionSolver3Ptr
@@ -55,87 +263,469 @@ GridSinglePhasePressureSolver3::suggestedBoundaryConditionSolver() const {
 void GridSinglePhasePressureSolver3::setLinearSystemSolver(
     const FdmLinearSystemSolver3Ptr& solver) {
     _systemSolver = solver;
+
+    // Let the new solver see the matrix before it is reused
+    _isMatrixValid = false;
 }
 
 const FdmVector3& GridSinglePhasePressureSolver3::pressure() const {
     return _system.x;
 }
 
-void GridSinglePhasePressureSolver3::buildMarkers(
+bool GridSinglePhasePressureSolver3::isUsingWarmStart() const {
+    return _isUsingWarmStart;
+}
+
+void GridSinglePhasePressureSolver3::setIsUsingWarmStart(bool isUsing) {
+    _isUsingWarmStart = isUsing;
+}
+
+unsigned int GridSinglePhasePressureSolver3::lastNumberOfIterations() const {
+    return (_systemSolver != nullptr)
+        ? _systemSolver->lastNumberOfIterations() : 0;
+}
+
+double GridSinglePhasePressureSolver3::lastResidual() const {
+    return (_systemSolver != nullptr) ? _systemSolver->lastResidual() : 0.0;
+}
+
+double GridSinglePhasePressureSolver3::lastMaxVelocity() const {
+    return _lastMaxVelocity;
+}
+
+bool GridSinglePhasePressureSolver3::isUsingCompressedSystem() const {
+    return _isUsingCompressedSystem;
+}
+
+void GridSinglePhasePressureSolver3::setIsUsingCompressedSystem(bool isUsing) {
+    _isUsingCompressedSystem = isUsing;
+}
+
+bool GridSinglePhasePressureSolver3::isUsingCoarseProjection() const {
+    return _isUsingCoarseProjection;
+}
+
+void GridSinglePhasePressureSolver3::setIsUsingCoarseProjection(bool isUsing) {
+    _isUsingCoarseProjection = isUsing;
+}
+
+bool GridSinglePhasePressureSolver3::buildMarkers(
     const Size3& size,
     const std::function<Vector3D(size_t, size_t, size_t)>& pos,
     const ScalarField3& boundarySdf,
     const ScalarField3& fluidSdf) {
+    bool isResized = _markers.size() != size;
     _markers.resize(size);
-    _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        Vector3D pt = pos(i, j, k);
-        if (isInsideSdf(boundarySdf.sample(pt))) {
-            _markers(i, j, k) = kBoundary;
-        } else if (isInsideSdf(fluidSdf.sample(pt))) {
-            _markers(i, j, k) = kFluid;
-        } else {
-            _markers(i, j, k) = kAir;
-        }
-    });
+    bool isChanged = updateArray(
+        _markers.accessor(),
+        [&](size_t i, size_t j, size_t k) {
+            Vector3D pt = pos(i, j, k);
+            if (isInsideSdf(boundarySdf.sample(pt))) {
+                return kBoundary;
+            } else if (isInsideSdf(fluidSdf.sample(pt))) {
+                return kFluid;
+            } else {
+                return kAir;
+            }
+        });
+    return isResized || isChanged;
 }
 
 void GridSinglePhasePressureSolver3::buildSystem(
-    const FaceCenteredGrid3& input) {
+    const FaceCenteredGrid3& input,
+    bool isAssemblingMatrix) {
     Size3 size = input.resolution();
-    _system.A.resize(size);
     _system.x.resize(size);
     _system.b.resize(size);
 
+    if (isAssemblingMatrix) {
+        _system.A.resize(size);
+    }
+
     Vector3D invH = 1.0 / input.gridSpacing();
     Vector3D invHSqr = invH * invH;
 
     // Build linear system
-    _system.A.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        auto& row = _system.A(i, j, k);
+    input.computeDivergence(_system.b.accessor());
+    _system.b.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_markers(i, j, k) != kFluid) {
+            _system.b(i, j, k) = 0.0;
+        }
 
-        // initialize
-        row.center = row.right = row.up = row.front = 0.0;
-        _system.b(i, j, k) = 0.0;
+        if (isAssemblingMatrix) {
+            Stencil stencil = buildStencil(_markers, invHSqr, i, j, k);
+            auto& row = _system.A(i, j, k);
+            row.center = stencil.center;
+            row.right = stencil.right;
+            row.up = stencil.up;
+            row.front = stencil.front;
+        }
+    });
+}
 
-        if (_markers(i, j, k) == kFluid) {
-            _system.b(i, j, k) = input.divergenceAtCellCenter(i, j, k);
+void GridSinglePhasePressureSolver3::solveCompressedSystem(
+    const FaceCenteredGrid3& input,
+    bool isWarmStarting) {
+    Vector3D invH = 1.0 / input.gridSpacing();
+    Vector3D invHSqr = invH * invH;
 
-            if (i + 1 < size.x && _markers(i + 1, j, k) != kBoundary) {
-                row.center += invHSqr.x;
-                if (_markers(i + 1, j, k) == kFluid) {
-                    row.right -= invHSqr.x;
+    size_t numberOfRows = buildCompressedIndices(
+        input.resolution(),
+        [&](size_t i, size_t j, size_t k) {
+            return _markers(i, j, k) == kFluid;
+        },
+        &_compressedIndices);
+
+    buildCompressedSystem(
+        _compressedIndices,
+        numberOfRows,
+        [&](size_t i, size_t j, size_t k) {
+            return buildStencil(_markers, invHSqr, i, j, k);
+        },
+        _system.b,
+        &_compressedSystem);
+
+    if (isWarmStarting) {
+        // Only the fluid cells are gathered, so the last pressure is zero
+        // outside of the current fluid region as in the full system
+        _lastCompressedPressure.resize(numberOfRows);
+        gatherCompressed(
+            _compressedIndices, _system.x, &_lastCompressedPressure);
+        FdmCompressedBlas::residual(
+            _compressedSystem.A,
+            _lastCompressedPressure,
+            _compressedSystem.b,
+            &_compressedSystem.x);
+        _compressedSystem.b.swap(_compressedSystem.x);
+    }
+
+    {
+        MemoryTagScope solverScope(MemoryTag::LinearSolver);
+        _systemSolver->solveCompressed(&_compressedSystem);
+    }
+
+    if (isWarmStarting) {
+        FdmCompressedBlas::axpy(
+            1.0,
+            _lastCompressedPressure,
+            _compressedSystem.x,
+            &_compressedSystem.x);
+    }
+
+    scatterCompressed(_compressedIndices, _compressedSystem.x, &_system.x);
+}
+
+void GridSinglePhasePressureSolver3::solveCoarseProjection(
+    const FaceCenteredGrid3& input,
+    FaceCenteredGrid3* output) {
+    Size3 size = input.resolution();
+    Size3 coarseSize((size.x + 1) / 2, (size.y + 1) / 2, (size.z + 1) / 2);
+    Vector3D invH = 1.0 / input.gridSpacing();
+    Vector3D invHSqr = invH * invH;
+    Vector3D invCoarseH = 0.5 * invH;
+
+    // A coarse cell covers up to 2x2x2 cells, and fewer at the upper end of
+    // an odd resolution
+    auto cellsOf = [&](size_t i, size_t j, size_t k) {
+        return Size3(
+            std::min(size.x - 2 * i, kOneSize * 2),
+            std::min(size.y - 2 * j, kOneSize * 2),
+            std::min(size.z - 2 * k, kOneSize * 2));
+    };
+
+    _system.b.resize(size);
+    input.computeDivergence(_system.b.accessor());
+
+    // The coarse divergence is the flux out of the coarse cell per its
+    // volume, which is the sum over the fluid cells divided by eight
+    _coarseMarkers.resize(coarseSize);
+    _coarseSystem.A.resize(coarseSize);
+    _coarseSystem.x.resize(coarseSize);
+    _coarseSystem.b.resize(coarseSize);
+    _coarseMarkers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        Size3 n = cellsOf(i, j, k);
+        bool hasFluid = false;
+        bool hasAir = false;
+        double sum = 0.0;
+        for (size_t c = 0; c < n.z; ++c) {
+            for (size_t b = 0; b < n.y; ++b) {
+                for (size_t a = 0; a < n.x; ++a) {
+                    char marker = _markers(2 * i + a, 2 * j + b, 2 * k + c);
+                    if (marker == kFluid) {
+                        hasFluid = true;
+                        sum += _system.b(2 * i + a, 2 * j + b, 2 * k + c);
+                    } else if (marker == kAir) {
+                        hasAir = true;
+                    }
                 }
             }
+        }
 
-            if (i > 0 && _markers(i - 1, j, k) != kBoundary) {
-                row.center += invHSqr.x;
-            }
+        _coarseMarkers(i, j, k)
+            = hasFluid ? kFluid : (hasAir ? kAir : kBoundary);
+        _coarseSystem.b(i, j, k) = sum / 8.0;
+    });
 
-            if (j + 1 < size.y && _markers(i, j + 1, k) != kBoundary) {
-                row.center += invHSqr.y;
-                if (_markers(i, j + 1, k) == kFluid) {
-                    row.up -= invHSqr.y;
+    // Number of the faces between the non-boundary cells on the coarse face
+    // between the coarse cell (i, j, k) and the one below it along the axis.
+    // The coupling is scaled by it, so that the flux through the coarse face
+    // matches the faces the gradient is applied to, also for the boundaries
+    // and the partial coarse cells of an odd resolution.
+    auto openFaces = [&](size_t axis, size_t i, size_t j, size_t k) {
+        Size3 n = cellsOf(i, j, k);
+        n[axis] = 1;
+        Point3UI upper(2 * i, 2 * j, 2 * k);
+        size_t count = 0;
+        for (size_t c = 0; c < n.z; ++c) {
+            for (size_t b = 0; b < n.y; ++b) {
+                for (size_t a = 0; a < n.x; ++a) {
+                    Point3UI cell(upper.x + a, upper.y + b, upper.z + c);
+                    Point3UI lower = cell;
+                    --lower[axis];
+                    if (_markers(cell) != kBoundary
+                        && _markers(lower) != kBoundary) {
+                        ++count;
+                    }
                 }
             }
+        }
+        return count;
+    };
 
-            if (j > 0 && _markers(i, j - 1, k) != kBoundary) {
-                row.center += invHSqr.y;
-            }
+    Vector3D invCoarseHSqr = invCoarseH * invCoarseH;
+    _coarseMarkers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        auto& row = _coarseSystem.A(i, j, k);
+        row.center = 0.0;
+        row.right = 0.0;
+        row.up = 0.0;
+        row.front = 0.0;
 
-            if (k + 1 < size.z && _markers(i, j, k + 1) != kBoundary) {
-                row.center += invHSqr.z;
-                if (_markers(i, j, k + 1) == kFluid) {
-                    row.front -= invHSqr.z;
+        if (_coarseMarkers(i, j, k) != kFluid) {
+            row.center = 1.0;
+            return;
+        }
+
+        Point3UI cell(i, j, k);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            // Lower and upper neighbors along the axis
+            for (size_t side = 0; side < 2; ++side) {
+                Point3UI neighbor = cell;
+                Point3UI upper = cell;
+                if (side == 0) {
+                    if (cell[axis] == 0) {
+                        continue;
+                    }
+                    --neighbor[axis];
+                } else {
+                    if (cell[axis] + 1 >= coarseSize[axis]) {
+                        continue;
+                    }
+                    ++neighbor[axis];
+                    ++upper[axis];
                 }
-            }
 
-            if (k > 0 && _markers(i, j, k - 1) != kBoundary) {
-                row.center += invHSqr.z;
+                size_t count = openFaces(axis, upper.x, upper.y, upper.z);
+                if (count == 0) {
+                    continue;
+                }
+
+                double coef = 0.25 * count * invCoarseHSqr[axis];
+                row.center += coef;
+                if (side == 1 && _coarseMarkers(neighbor) == kFluid) {
+                    double& offDiagonal
+                        = (axis == 0) ? row.right
+                        : (axis == 1) ? row.up : row.front;
+                    offDiagonal = -coef;
+                }
             }
-        } else {
-            row.center = 1.0;
         }
     });
+
+    {
+        MemoryTagScope solverScope(MemoryTag::LinearSolver);
+        _systemSolver->solve(&_coarseSystem);
+    }
+
+    const FdmVector3& p = _coarseSystem.x;
+    _system.x.resize(size);
+    _system.x.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        _system.x(i, j, k) = p(i / 2, j / 2, k / 2);
+    });
+
+    // Gradient on the coarse face between the coarse cell (i, j, k) and the
+    // one below it along the axis, with zero for the boundaries
+    auto coarseGradient = [&](size_t axis, size_t i, size_t j, size_t k) {
+        Point3UI upper(i, j, k);
+        if (upper[axis] == 0 || upper[axis] >= coarseSize[axis]) {
+            return 0.0;
+        }
+
+        Point3UI lower = upper;
+        --lower[axis];
+        char lowerMarker = _coarseMarkers(lower);
+        char upperMarker = _coarseMarkers(upper);
+        if (lowerMarker == kBoundary
+            || upperMarker == kBoundary
+            || (lowerMarker != kFluid && upperMarker != kFluid)) {
+            return 0.0;
+        }
+        return invCoarseH[axis] * (p(upper) - p(lower));
+    };
+
+    // A face on a coarse face takes its gradient, and a face inside a coarse
+    // cell takes the average of the two coarse faces along the axis
+    auto fineGradient = [&](size_t axis, size_t i, size_t j, size_t k) {
+        Point3UI face(i, j, k);
+        Point3UI cell(i / 2, j / 2, k / 2);
+        if (face[axis] % 2 == 0) {
+            return coarseGradient(axis, cell.x, cell.y, cell.z);
+        }
+
+        Point3UI next = cell;
+        ++next[axis];
+        return 0.5 * (coarseGradient(axis, cell.x, cell.y, cell.z)
+            + coarseGradient(axis, next.x, next.y, next.z));
+    };
+
+    auto u = input.uConstAccessor();
+    auto v = input.vConstAccessor();
+    auto w = input.wConstAccessor();
+    auto u0 = output->uAccessor();
+    auto v0 = output->vAccessor();
+    auto w0 = output->wAccessor();
+
+    // Same faces as applyPressureGradient updates
+    _markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_markers(i, j, k) != kFluid) {
+            return;
+        }
+        if (i + 1 < size.x && _markers(i + 1, j, k) != kBoundary) {
+            u0(i + 1, j, k) = u(i + 1, j, k) + fineGradient(0, i + 1, j, k);
+        }
+        if (j + 1 < size.y && _markers(i, j + 1, k) != kBoundary) {
+            v0(i, j + 1, k) = v(i, j + 1, k) + fineGradient(1, i, j + 1, k);
+        }
+        if (k + 1 < size.z && _markers(i, j, k + 1) != kBoundary) {
+            w0(i, j, k + 1) = w(i, j, k + 1) + fineGradient(2, i, j, k + 1);
+        }
+    });
+
+    // The coarse solve balances the flux through each coarse cell, and the
+    // local solves redistribute it over the faces inside the coarse cells
+    size_t numberOfCoarseCells = coarseSize.x * coarseSize.y * coarseSize.z;
+    parallelRangeFor(
+        kZeroSize,
+        numberOfCoarseCells,
+        [&](size_t begin, size_t end) {
+            std::vector<char> isActive;
+            std::vector<double> rhs, q, r, d, ad;
+
+            for (size_t index = begin; index < end; ++index) {
+                size_t ci = index % coarseSize.x;
+                size_t cj = (index / coarseSize.x) % coarseSize.y;
+                size_t ck = index / (coarseSize.x * coarseSize.y);
+                if (_coarseMarkers(ci, cj, ck) != kFluid) {
+                    continue;
+                }
+
+                Size3 n = cellsOf(ci, cj, ck);
+                size_t count = n.x * n.y * n.z;
+                isActive.assign(count, 0);
+                rhs.assign(count, 0.0);
+
+                size_t numberOfActive = 0;
+                double mean = 0.0;
+                for (size_t c = 0; c < n.z; ++c) {
+                    for (size_t b = 0; b < n.y; ++b) {
+                        for (size_t a = 0; a < n.x; ++a) {
+                            size_t i = 2 * ci + a;
+                            size_t j = 2 * cj + b;
+                            size_t k = 2 * ck + c;
+                            if (_markers(i, j, k) != kFluid) {
+                                continue;
+                            }
+
+                            size_t l = a + n.x * (b + n.y * c);
+                            isActive[l] = 1;
+                            rhs[l]
+                                = (u0(i + 1, j, k) - u0(i, j, k)) * invH.x
+                                + (v0(i, j + 1, k) - v0(i, j, k)) * invH.y
+                                + (w0(i, j, k + 1) - w0(i, j, k)) * invH.z;
+                            mean += rhs[l];
+                            ++numberOfActive;
+                        }
+                    }
+                }
+
+                if (numberOfActive < 2) {
+                    continue;
+                }
+
+                mean /= static_cast<double>(numberOfActive);
+                for (size_t l = 0; l < count; ++l) {
+                    if (isActive[l]) {
+                        rhs[l] -= mean;
+                    }
+                }
+
+                solveBlockPoisson(
+                    n,
+                    invHSqr,
+                    isActive,
+                    rhs,
+                    kCoarseCellTolerance,
+                    &q,
+                    &r,
+                    &d,
+                    &ad);
+
+                for (size_t c = 0; c < n.z; ++c) {
+                    for (size_t b = 0; b < n.y; ++b) {
+                        for (size_t a = 0; a < n.x; ++a) {
+                            size_t l = a + n.x * (b + n.y * c);
+                            if (!isActive[l]) {
+                                continue;
+                            }
+
+                            size_t i = 2 * ci + a;
+                            size_t j = 2 * cj + b;
+                            size_t k = 2 * ck + c;
+                            size_t lx = l + 1;
+                            size_t ly = l + n.x;
+                            size_t lz = l + n.x * n.y;
+                            if (a + 1 < n.x && isActive[lx]) {
+                                u0(i + 1, j, k) += invH.x * (q[lx] - q[l]);
+                            }
+                            if (b + 1 < n.y && isActive[ly]) {
+                                v0(i, j + 1, k) += invH.y * (q[ly] - q[l]);
+                            }
+                            if (c + 1 < n.z && isActive[lz]) {
+                                w0(i, j, k + 1) += invH.z * (q[lz] - q[l]);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+    _lastMaxVelocity = parallelReduce(
+        kZeroSize,
+        size.z,
+        0.0,
+        [&](size_t kBegin, size_t kEnd, double partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    for (size_t i = 0; i < size.x; ++i) {
+                        partial = std::max(
+                            partial, maxAbsFaceVelocity(u0, v0, w0, i, j, k));
+                    }
+                }
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 }
 
 void GridSinglePhasePressureSolver3::applyPressureGradient(
@@ -151,7 +741,9 @@ void GridSinglePhasePressureSolver3::applyPressureGradient(
 
     Vector3D invH = 1.0 / input.gridSpacing();
 
-    _system.x.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    // Each cell updates the faces on its upper side, which are then final,
+    // so the largest velocity is found in the same pass
+    auto applyToCell = [&](size_t i, size_t j, size_t k) {
         if (_markers(i, j, k) == kFluid) {
             if (i + 1 < size.x && _markers(i + 1, j, k) != kBoundary) {
                 u0(i + 1, j, k)
@@ -172,5 +764,24 @@ void GridSinglePhasePressureSolver3::applyPressureGradient(
                     * (_system.x(i, j, k + 1) - _system.x(i, j, k));
             }
         }
-    });
+        return maxAbsFaceVelocity(u0, v0, w0, i, j, k);
+    };
+
+    _lastMaxVelocity = parallelReduce(
+        kZeroSize,
+        size.z,
+        0.0,
+        [&](size_t kBegin, size_t kEnd, double partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    for (size_t i = 0; i < size.x; ++i) {
+                        partial = std::max(partial, applyToCell(i, j, k));
+                    }
+                }
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 }
@@ -0,0 +1,345 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cubic_semi_lagrangian3.h>
+#include <jet/grid_backward_euler_diffusion_solver3.h>
+#include <jet/grid_fractional_single_phase_pressure_solver3.h>
+#include <jet/grid_smoke_cuda_solver3.h>
+#include <jet/profiler.h>
+#include <cuda_smoke_helpers.h>
+#include <grid_copy_helpers.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+using namespace jet;
+
+#ifndef JET_USE_CUDA
+
+namespace jet {
+
+namespace internal {
+
+void CudaSmokeStateDeleter::operator()(CudaSmokeState*) const {
+}
+
+CudaSmokeState* createCudaSmokeState() {
+    return nullptr;
+}
+
+void uploadCudaSmokeGrids(
+    CudaSmokeState*,
+    const FaceCenteredGrid3&,
+    const std::vector<const ScalarGrid3*>&) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void downloadCudaSmokeGrids(
+    const CudaSmokeState*,
+    FaceCenteredGrid3*,
+    const std::vector<ScalarGrid3*>&) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void downloadCudaSmokeScalarGrid(
+    const CudaSmokeState*,
+    size_t,
+    ScalarGrid3*) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void advanceCudaSmoke(
+    CudaSmokeState*,
+    const CudaSmokeParameters&,
+    double) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+double cudaSmokeMaxVelocity(const CudaSmokeState*) {
+    return 0.0;
+}
+
+unsigned int cudaSmokeLastNumberOfIterations(const CudaSmokeState*) {
+    return 0;
+}
+
+double cudaSmokeLastResidual(const CudaSmokeState*) {
+    return 0.0;
+}
+
+size_t cudaSmokeMemoryInBytes(const CudaSmokeState*) {
+    return 0;
+}
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif
+
+namespace {
+
+// Same tolerances as the default host pressure and diffusion solvers
+const double kPressureTolerance = 1e-6;
+
+// Returns the advectable scalar channels with the smoke density and the
+// temperature first, which is the order the device expects.
+std::vector<ScalarGrid3*> scalarChannels(const GridSmokeSolver3& solver) {
+    auto grids = solver.gridSystemData();
+    ScalarGrid3* den = solver.smokeDensity().get();
+    ScalarGrid3* temp = solver.temperature().get();
+
+    std::vector<ScalarGrid3*> channels = { den, temp };
+    for (size_t i = 0; i < grids->numberOfAdvectableScalarData(); ++i) {
+        ScalarGrid3* grid = grids->advectableScalarDataAt(i).get();
+        if (grid != den && grid != temp) {
+            channels.push_back(grid);
+        }
+    }
+    return channels;
+}
+
+}  // namespace
+
+GridSmokeCudaSolver3::GridSmokeCudaSolver3() {
+    if (internal::isCudaDeviceAvailable()) {
+        _device.reset(internal::createCudaSmokeState());
+    }
+}
+
+GridSmokeCudaSolver3::~GridSmokeCudaSolver3() {
+}
+
+bool GridSmokeCudaSolver3::isUsingDevice() const {
+    return static_cast<bool>(_device);
+}
+
+bool GridSmokeCudaSolver3::isDeviceAvailable() {
+    return internal::isCudaDeviceAvailable();
+}
+
+bool GridSmokeCudaSolver3::isSyncingHostEveryFrame() const {
+    return _isSyncingHostEveryFrame;
+}
+
+void GridSmokeCudaSolver3::setIsSyncingHostEveryFrame(bool isSyncing) {
+    _isSyncingHostEveryFrame = isSyncing;
+}
+
+void GridSmokeCudaSolver3::uploadToDevice() {
+    // The device has the latest data if the host grids are stale
+    if (!_isHostDataValid || !canAdvanceOnDevice()) {
+        return;
+    }
+
+    auto channels = scalarChannels(*this);
+    std::vector<const ScalarGrid3*> scalars(channels.begin(), channels.end());
+    internal::uploadCudaSmokeGrids(_device.get(), *velocity(), scalars);
+    _isDeviceDataValid = true;
+}
+
+void GridSmokeCudaSolver3::downloadToHost() {
+    if (_isHostDataValid) {
+        return;
+    }
+
+    internal::downloadCudaSmokeGrids(
+        _device.get(), velocity().get(), scalarChannels(*this));
+    _isHostDataValid = true;
+}
+
+void GridSmokeCudaSolver3::downloadSmokeDensity(
+    CellCenteredScalarGrid3* grid) const {
+    auto den = smokeDensity();
+    if (_isHostDataValid) {
+        copyGrid(*den, grid);
+        return;
+    }
+
+    if (!grid->hasSameShape(*den)) {
+        grid->resize(den->resolution(), den->gridSpacing(), den->origin());
+    }
+    internal::downloadCudaSmokeScalarGrid(_device.get(), 0, grid);
+}
+
+void GridSmokeCudaSolver3::onAdvanceTimeStep(double timeIntervalInSeconds) {
+    if (!canAdvanceOnDevice()) {
+        downloadToHost();
+        _isDeviceDataValid = false;
+        _isLastStepOnDevice = false;
+        GridSmokeSolver3::onAdvanceTimeStep(timeIntervalInSeconds);
+        return;
+    }
+
+    if (!_isDeviceDataValid) {
+        JET_PROFILE_SCOPE("uploadToDevice");
+        uploadToDevice();
+    }
+
+    Size3 res = gridSystemData()->resolution();
+
+    internal::CudaSmokeParameters params;
+    auto cubic = std::dynamic_pointer_cast<CubicSemiLagrangian3>(
+        advectionSolver());
+    if (cubic != nullptr) {
+        params.interpolation = cubic->isMonotonic()
+            ? internal::CudaSmokeInterpolation::MonotonicCubic
+            : internal::CudaSmokeInterpolation::Cubic;
+    }
+    if (gravity().lengthSquared() > kEpsilonD) {
+        params.up = -gravity().normalized();
+    }
+    params.buoyancySmokeDensityFactor = buoyancySmokeDensityFactor();
+    params.buoyancyTemperatureFactor = buoyancyTemperatureFactor();
+    if (diffusionSolver() != nullptr) {
+        params.smokeDiffusionCoefficient = smokeDiffusionCoefficient();
+        params.temperatureDiffusionCoefficient
+            = temperatureDiffusionCoefficient();
+    }
+    params.smokeDecayFactor = smokeDecayFactor();
+    params.temperatureDecayFactor = smokeTemperatureDecayFactor();
+    params.closedDomainBoundaryFlag = closedDomainBoundaryFlag();
+    params.isSolvingPressure = pressureSolver() != nullptr;
+
+    // The Jacobi preconditioner needs more iterations than the incomplete
+    // Cholesky of the host solvers, roughly in proportion to the grid size
+    params.maxNumberOfIterations = static_cast<unsigned int>(
+        std::max<size_t>(100, 2 * (res.x + res.y + res.z)));
+    params.pressureTolerance = kPressureTolerance;
+    params.diffusionTolerance = kEpsilonD;
+
+    {
+        JET_PROFILE_SCOPE("advanceCudaSmoke");
+        internal::advanceCudaSmoke(
+            _device.get(), params, timeIntervalInSeconds);
+    }
+
+    _isHostDataValid = false;
+    _isLastStepOnDevice = true;
+}
+
+unsigned int GridSmokeCudaSolver3::numberOfSubTimeSteps(
+    double timeIntervalInSeconds) const {
+    if (_isHostDataValid) {
+        return GridSmokeSolver3::numberOfSubTimeSteps(timeIntervalInSeconds);
+    }
+
+    double currentCfl = deviceCfl(timeIntervalInSeconds);
+    return static_cast<unsigned int>(
+        std::max(std::ceil(currentCfl / maxCfl()), 1.0));
+}
+
+void GridSmokeCudaSolver3::onEndAdvanceFrame(double timeIntervalInSeconds) {
+    if (_isDeviceDataValid && _isSyncingHostEveryFrame) {
+        JET_PROFILE_SCOPE("downloadToHost");
+        downloadToHost();
+
+        // Uploaded again next frame, with the edits of the host
+        _isDeviceDataValid = false;
+    }
+
+    // The data on the device is updated every sub-time-step, so there is
+    // nothing to catch up
+    if (_isHostDataValid) {
+        GridSmokeSolver3::onEndAdvanceFrame(timeIntervalInSeconds);
+    }
+}
+
+void GridSmokeCudaSolver3::collectStatistics(
+    SubTimeStepStatistics* stats) const {
+    if (!_isLastStepOnDevice) {
+        GridSmokeSolver3::collectStatistics(stats);
+        return;
+    }
+
+    stats->cfl = deviceCfl(stats->timeIntervalInSeconds);
+    stats->numberOfPressureIterations
+        = internal::cudaSmokeLastNumberOfIterations(_device.get());
+    stats->pressureResidual = internal::cudaSmokeLastResidual(_device.get());
+    stats->memoryInBytes = gridSystemData()->memoryInBytes()
+        + internal::cudaSmokeMemoryInBytes(_device.get());
+}
+
+bool GridSmokeCudaSolver3::canAdvanceOnDevice() const {
+    if (!_device) {
+        return false;
+    }
+
+    auto grids = gridSystemData();
+    Size3 res = grids->resolution();
+    if (res.x == 0 || res.y == 0 || res.z == 0) {
+        return false;
+    }
+
+    if (collider() != nullptr
+        || isUsingAutoBounds()
+        || upRes() != nullptr
+        || vorticityConfinementFactor() > kEpsilonD
+        || isDiffusingPerFrame()) {
+        return false;
+    }
+
+    if (diffusionSolver() != nullptr
+        && viscosityCoefficient() > kEpsilonD) {
+        return false;
+    }
+
+    // The other subclasses of SemiLagrangian3 interpolate differently
+    if (advectionSolver() == nullptr) {
+        return false;
+    }
+    const AdvectionSolver3& advection = *advectionSolver();
+    if (typeid(advection) != typeid(SemiLagrangian3)
+        && typeid(advection) != typeid(CubicSemiLagrangian3)) {
+        return false;
+    }
+
+    if (pressureSolver() != nullptr
+        && dynamic_cast<GridFractionalSinglePhasePressureSolver3*>(
+            pressureSolver().get()) == nullptr) {
+        return false;
+    }
+
+    bool isDiffusing = smokeDiffusionCoefficient() > kEpsilonD
+        || temperatureDiffusionCoefficient() > kEpsilonD;
+    if (isDiffusing
+        && diffusionSolver() != nullptr
+        && dynamic_cast<GridBackwardEulerDiffusionSolver3*>(
+            diffusionSolver().get()) == nullptr) {
+        return false;
+    }
+
+    if (grids->numberOfAdvectableVectorData() > 0
+        || grids->numberOfAdvectableScalarDataF() > 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < grids->numberOfAdvectableScalarData(); ++i) {
+        auto grid = std::dynamic_pointer_cast<CellCenteredScalarGrid3>(
+            grids->advectableScalarDataAt(i));
+        if (grid == nullptr
+            || grid->resolution() != res
+            || grids->advectableScalarDataUpdateIntervalAt(i) != 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double GridSmokeCudaSolver3::deviceCfl(double timeIntervalInSeconds) const {
+    // Same estimate as GridFluidSolver3::estimatedCfl
+    const Vector3D& g = gravity();
+    double maxGravity = max3(std::fabs(g.x), std::fabs(g.y), std::fabs(g.z));
+    double maxVel = internal::cudaSmokeMaxVelocity(_device.get())
+        + timeIntervalInSeconds * maxGravity;
+
+    Vector3D gridSpacing = gridSystemData()->gridSpacing();
+    double minGridSize = min3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
+
+    return maxVel * timeIntervalInSeconds / minGridSize;
+}
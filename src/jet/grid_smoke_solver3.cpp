@@ -1,8 +1,15 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/array_samplers3.h>
+#include <jet/grid_single_phase_pressure_solver3.h>
 #include <jet/grid_smoke_solver3.h>
+#include <jet/parallel.h>
+#include <grid_auto_bounds_helpers.h>
+#include <grid_copy_helpers.h>
+#include <serialization_helpers.h>
 #include <algorithm>
+#include <cmath>
 
 using namespace jet;
 
@@ -66,6 +73,14 @@ void GridSmokeSolver3::setTemperatureDecayFactor(double newValue) {
     _temperatureDecayFactor = clamp(newValue, 0.0, 1.0);
 }
 
+double GridSmokeSolver3::vorticityConfinementFactor() const {
+    return _vorticityConfinementFactor;
+}
+
+void GridSmokeSolver3::setVorticityConfinementFactor(double newValue) {
+    _vorticityConfinementFactor = std::max(newValue, 0.0);
+}
+
 ScalarGrid3Ptr GridSmokeSolver3::smokeDensity() const {
     return gridSystemData()->advectableScalarDataAt(_smokeDensityDataId);
 }
@@ -74,34 +89,163 @@ ScalarGrid3Ptr GridSmokeSolver3::temperature() const {
     return gridSystemData()->advectableScalarDataAt(_temperatureDataId);
 }
 
+bool GridSmokeSolver3::isDiffusingPerFrame() const {
+    return _isDiffusingPerFrame;
+}
+
+void GridSmokeSolver3::setIsDiffusingPerFrame(bool isDiffusing) {
+    _isDiffusingPerFrame = isDiffusing;
+}
+
+unsigned int GridSmokeSolver3::smokeDensityUpdateInterval() const {
+    return gridSystemData()->advectableScalarDataUpdateIntervalAt(
+        _smokeDensityDataId);
+}
+
+void GridSmokeSolver3::setSmokeDensityUpdateInterval(unsigned int interval) {
+    gridSystemData()->setAdvectableScalarDataUpdateInterval(
+        _smokeDensityDataId, interval);
+}
+
+unsigned int GridSmokeSolver3::temperatureUpdateInterval() const {
+    return gridSystemData()->advectableScalarDataUpdateIntervalAt(
+        _temperatureDataId);
+}
+
+void GridSmokeSolver3::setTemperatureUpdateInterval(unsigned int interval) {
+    gridSystemData()->setAdvectableScalarDataUpdateInterval(
+        _temperatureDataId, interval);
+}
+
+double GridSmokeSolver3::autoBoundsThreshold() const {
+    return _autoBoundsThreshold;
+}
+
+void GridSmokeSolver3::setAutoBoundsThreshold(double newValue) {
+    _autoBoundsThreshold = std::max(newValue, 0.0);
+}
+
+bool GridSmokeSolver3::isUsingCoarsePressureProjection() const {
+    auto solver = std::dynamic_pointer_cast<GridSinglePhasePressureSolver3>(
+        pressureSolver());
+    return solver != nullptr && solver->isUsingCoarseProjection();
+}
+
+void GridSmokeSolver3::setIsUsingCoarsePressureProjection(bool isUsing) {
+    auto solver = std::dynamic_pointer_cast<GridSinglePhasePressureSolver3>(
+        pressureSolver());
+    if (solver == nullptr) {
+        if (!isUsing) {
+            return;
+        }
+        solver = std::make_shared<GridSinglePhasePressureSolver3>();
+        setPressureSolver(solver);
+    }
+
+    solver->setIsUsingCoarseProjection(isUsing);
+}
+
+const GridSmokeUpRes3Ptr& GridSmokeSolver3::upRes() const {
+    return _upRes;
+}
+
+void GridSmokeSolver3::setUpRes(const GridSmokeUpRes3Ptr& upRes) {
+    _upRes = upRes;
+}
+
+void GridSmokeSolver3::serialize(std::ostream* strm) const {
+    GridFluidSolver3::serialize(strm);
+
+    serializeSectionTag(strm, "GridSmokeSolver3");
+    serializeValue(strm, _smokeDiffusionCoefficient);
+    serializeValue(strm, _temperatureDiffusionCoefficient);
+    serializeValue(strm, _buoyancySmokeDensityFactor);
+    serializeValue(strm, _buoyancyTemperatureFactor);
+    serializeValue(strm, _smokeDecayFactor);
+    serializeValue(strm, _temperatureDecayFactor);
+    serializeValue(strm, _vorticityConfinementFactor);
+    serializeValue(strm, _autoBoundsThreshold);
+}
+
+void GridSmokeSolver3::deserialize(std::istream* strm) {
+    GridFluidSolver3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "GridSmokeSolver3"));
+    deserializeValue(strm, &_smokeDiffusionCoefficient);
+    deserializeValue(strm, &_temperatureDiffusionCoefficient);
+    deserializeValue(strm, &_buoyancySmokeDensityFactor);
+    deserializeValue(strm, &_buoyancyTemperatureFactor);
+    deserializeValue(strm, &_smokeDecayFactor);
+    deserializeValue(strm, &_temperatureDecayFactor);
+    deserializeValue(strm, &_vorticityConfinementFactor);
+    deserializeValue(strm, &_autoBoundsThreshold);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+}
+
+void GridSmokeSolver3::onEndAdvanceFrame(double timeIntervalInSeconds) {
+    GridFluidSolver3::onEndAdvanceFrame(timeIntervalInSeconds);
+
+    if (_isDiffusingPerFrame) {
+        computeDiffusion(timeIntervalInSeconds);
+    }
+}
+
 void GridSmokeSolver3::onEndAdvanceTimeStep(double timeIntervalInSeconds) {
-    computeDiffusion(timeIntervalInSeconds);
+    if (!_isDiffusingPerFrame) {
+        computeDiffusion(timeIntervalInSeconds);
+    }
+
+    if (_upRes != nullptr) {
+        _upRes->advance(
+            *gridSystemData()->velocity(),
+            timeIntervalInSeconds,
+            colliderSdf());
+    }
+
+    computeDecay();
+}
+
+BoundingBox3D GridSmokeSolver3::activeRegion() const {
+    auto den = smokeDensity()->constDataAccessor();
+    auto temp = temperature()->constDataAccessor();
+    auto grids = gridSystemData();
+    return activeCellBounds(
+        grids->resolution(), grids->gridSpacing(), grids->origin(),
+        [&](size_t i, size_t j, size_t k) {
+            return den(i, j, k) > _autoBoundsThreshold
+                || std::fabs(temp(i, j, k)) > _autoBoundsThreshold;
+        });
 }
 
 void GridSmokeSolver3::computeExternalForces(double timeIntervalInSeconds) {
     computeBuoyancyForce(timeIntervalInSeconds);
+    computeVorticityConfinement(timeIntervalInSeconds);
 }
 
 void GridSmokeSolver3::computeDiffusion(double timeIntervalInSeconds) {
     if (diffusionSolver() != nullptr) {
+        auto grids = gridSystemData();
+
         if (_smokeDiffusionCoefficient > kEpsilonD) {
             auto den = smokeDensity();
-            auto den0 = std::dynamic_pointer_cast<CellCenteredScalarGrid3>(
-                den->clone());
+            auto den0 = grids->advectableScalarDataBackBufferAt(
+                _smokeDensityDataId);
+            copyGrid(*den, den0.get());
 
             diffusionSolver()->solve(
                 *den0,
                 _smokeDiffusionCoefficient,
                 timeIntervalInSeconds,
-                den0.get(),
+                den.get(),
                 colliderSdf());
             extrapolateIntoCollider(den.get());
         }
 
         if (_temperatureDiffusionCoefficient > kEpsilonD) {
-            auto temp = smokeDensity();
-            auto temp0 = std::dynamic_pointer_cast<CellCenteredScalarGrid3>(
-                temp->clone());
+            auto temp = temperature();
+            auto temp0 = grids->advectableScalarDataBackBufferAt(
+                _temperatureDataId);
+            copyGrid(*temp, temp0.get());
 
             diffusionSolver()->solve(
                 *temp0,
@@ -112,17 +256,28 @@ void GridSmokeSolver3::computeDiffusion(double timeIntervalInSeconds) {
             extrapolateIntoCollider(temp.get());
         }
     }
+}
 
-    auto den = smokeDensity();
-    den->parallelForEachDataPointIndex(
-        [&](size_t i, size_t j, size_t k) {
-            (*den)(i, j, k) *= 1.0 - _smokeDecayFactor;
-        });
-    auto temp = temperature();
-    temp->parallelForEachDataPointIndex(
-        [&](size_t i, size_t j, size_t k) {
-            (*temp)(i, j, k) *= 1.0 - _temperatureDecayFactor;
+void GridSmokeSolver3::computeDecay() {
+    // Both fields are cell-centered on the same grid, so they decay together
+    // in a single pass
+    auto den = smokeDensity()->dataAccessor();
+    auto temp = temperature()->dataAccessor();
+    const double denDecay = 1.0 - _smokeDecayFactor;
+    const double tempDecay = 1.0 - _temperatureDecayFactor;
+    parallelFor(kZeroSize, den.size().x * den.size().y * den.size().z,
+        [&](size_t n) {
+            den[n] *= denDecay;
+            temp[n] *= tempDecay;
         });
+
+    if (_upRes != nullptr) {
+        auto fineDen = _upRes->density();
+        fineDen->parallelForEachDataPointIndex(
+            [&](size_t i, size_t j, size_t k) {
+                (*fineDen)(i, j, k) *= denDecay;
+            });
+    }
 }
 
 void GridSmokeSolver3::computeBuoyancyForce(double timeIntervalInSeconds) {
@@ -138,13 +293,37 @@ void GridSmokeSolver3::computeBuoyancyForce(double timeIntervalInSeconds) {
         std::abs(_buoyancyTemperatureFactor) > kEpsilonD) {
         auto den = smokeDensity();
         auto temp = temperature();
+        auto denData = den->constDataAccessor();
+        auto tempData = temp->constDataAccessor();
+        const Size3 size = denData.size();
+        const size_t numberOfCells = size.x * size.y * size.z;
+
+        // The force is linear in the density and the temperature, and so is
+        // the interpolation, so the force is combined per cell in the same
+        // pass that sums up the temperature, and each face samples it once
+        if (_buoyancy.size() != size) {
+            _buoyancy.resize(size);
+        }
+        auto buoyancy = _buoyancy.accessor();
+        double tSum = parallelReduce(
+            kZeroSize, numberOfCells, 0.0,
+            [&](size_t begin, size_t end, double partial) {
+                for (size_t n = begin; n < end; ++n) {
+                    buoyancy[n]
+                        = _buoyancySmokeDensityFactor * denData[n]
+                        + _buoyancyTemperatureFactor * tempData[n];
+                    partial += tempData[n];
+                }
+                return partial;
+            },
+            [](double a, double b) {
+                return a + b;
+            });
+        double tAmb = tSum / static_cast<double>(numberOfCells);
+        double fAmb = _buoyancyTemperatureFactor * tAmb;
 
-        double tAmb = 0.0;
-        temp->forEachCellIndex([&](size_t i, size_t j, size_t k) {
-            tAmb += (*temp)(i, j, k);
-        });
-        tAmb /= static_cast<double>(
-            temp->resolution().x * temp->resolution().y * temp->resolution().z);
+        LinearArraySampler3<double, double> sampler(
+            _buoyancy.constAccessor(), den->gridSpacing(), den->dataOrigin());
 
         auto u = vel->uAccessor();
         auto v = vel->vAccessor();
@@ -155,30 +334,21 @@ void GridSmokeSolver3::computeBuoyancyForce(double timeIntervalInSeconds) {
 
         if (std::abs(up.x) > kEpsilonD) {
             vel->parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
-                Vector3D pt = uPos(i, j, k);
-                double fBuoy
-                    = _buoyancySmokeDensityFactor * den->sample(pt)
-                    + _buoyancyTemperatureFactor * (temp->sample(pt) - tAmb);
+                double fBuoy = sampler(uPos(i, j, k)) - fAmb;
                 u(i, j, k) += timeIntervalInSeconds * fBuoy * up.x;
             });
         }
 
         if (std::abs(up.y) > kEpsilonD) {
             vel->parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
-                Vector3D pt = vPos(i, j, k);
-                double fBuoy
-                    = _buoyancySmokeDensityFactor * den->sample(pt)
-                    + _buoyancyTemperatureFactor * (temp->sample(pt) - tAmb);
+                double fBuoy = sampler(vPos(i, j, k)) - fAmb;
                 v(i, j, k) += timeIntervalInSeconds * fBuoy * up.y;
             });
         }
 
         if (std::abs(up.z) > kEpsilonD) {
             vel->parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
-                Vector3D pt = wPos(i, j, k);
-                double fBuoy
-                    = _buoyancySmokeDensityFactor * den->sample(pt)
-                    + _buoyancyTemperatureFactor * (temp->sample(pt) - tAmb);
+                double fBuoy = sampler(wPos(i, j, k)) - fAmb;
                 w(i, j, k) += timeIntervalInSeconds * fBuoy * up.z;
             });
         }
@@ -186,3 +356,78 @@ void GridSmokeSolver3::computeBuoyancyForce(double timeIntervalInSeconds) {
         applyBoundaryCondition();
     }
 }
+
+void GridSmokeSolver3::computeVorticityConfinement(
+    double timeIntervalInSeconds) {
+    if (_vorticityConfinementFactor <= kEpsilonD) {
+        return;
+    }
+
+    auto vel = gridSystemData()->velocity();
+    const Size3 res = vel->resolution();
+    const Vector3D gs = vel->gridSpacing();
+    if (res.x == 0 || res.y == 0 || res.z == 0) {
+        return;
+    }
+
+    if (_vorticity.size() != res) {
+        _vorticity.resize(res);
+    }
+    vel->computeCurl(_vorticity.accessor());
+
+    auto u = vel->uAccessor();
+    auto v = vel->vAccessor();
+    auto w = vel->wAccessor();
+    const double scale = 0.5 * timeIntervalInSeconds
+        * _vorticityConfinementFactor * min3(gs.x, gs.y, gs.z);
+
+    // Each cell adds half of its force to the two faces along each axis. The
+    // rows are processed in four passes by the parity of (j, k), so that the
+    // rows of a pass do not share any v- or w-face, and a u-face is only
+    // shared within a row. The faces get the contributions in a fixed order.
+    for (size_t color = 0; color < 4; ++color) {
+        size_t jBegin = color % 2;
+        size_t kBegin = color / 2;
+        size_t jCount = (res.y + 1 - jBegin) / 2;
+        size_t kCount = (res.z + 1 - kBegin) / 2;
+
+        parallelFor(kZeroSize, jCount * kCount, [&](size_t r) {
+            size_t j = jBegin + 2 * (r % jCount);
+            size_t k = kBegin + 2 * (r / jCount);
+            size_t jm = (j > 0) ? j - 1 : j;
+            size_t jp = (j + 1 < res.y) ? j + 1 : j;
+            size_t km = (k > 0) ? k - 1 : k;
+            size_t kp = (k + 1 < res.z) ? k + 1 : k;
+            const Vector3D* omega = &_vorticity(0, j, k);
+            const Vector3D* down = &_vorticity(0, jm, k);
+            const Vector3D* up = &_vorticity(0, jp, k);
+            const Vector3D* back = &_vorticity(0, j, km);
+            const Vector3D* front = &_vorticity(0, j, kp);
+
+            for (size_t i = 0; i < res.x; ++i) {
+                size_t im = (i > 0) ? i - 1 : i;
+                size_t ip = (i + 1 < res.x) ? i + 1 : i;
+
+                // Gradient of the vorticity magnitude
+                Vector3D n(
+                    (omega[ip].length() - omega[im].length()) / gs.x,
+                    (up[i].length() - down[i].length()) / gs.y,
+                    (front[i].length() - back[i].length()) / gs.z);
+                double nLength = n.length();
+                if (nLength <= kEpsilonD) {
+                    continue;
+                }
+
+                Vector3D f = (scale / nLength) * n.cross(omega[i]);
+                u(i, j, k) += f.x;
+                u(i + 1, j, k) += f.x;
+                v(i, j, k) += f.y;
+                v(i, j + 1, k) += f.y;
+                w(i, j, k) += f.z;
+                w(i, j, k + 1) += f.z;
+            }
+        });
+    }
+
+    applyBoundaryCondition();
+}
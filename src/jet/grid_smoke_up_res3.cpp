@@ -0,0 +1,239 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/grid_smoke_up_res3.h>
+#include <jet/philox_rng.h>
+#include <jet/semi_lagrangian3.h>
+#include <grid_copy_helpers.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace jet;
+
+namespace {
+
+// Gradients of the improved Perlin noise, which point to the midpoints of
+// the edges of a cube
+const double kGradients[12][3] = {
+    {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0},
+    {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+    {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}
+};
+
+// Amplitude ratio of the consecutive octaves, 2^(-5/6)
+const double kOctaveWeight = 0.5612310241546865;
+
+inline double fade(double t) {
+    return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+}
+
+inline double fadeDerivative(double t) {
+    return 30.0 * t * t * (t * (t - 2.0) + 1.0);
+}
+
+// Packs the lattice coordinates into the counter of PhiloxRng. The noise
+// repeats every 2^21 lattice cells.
+inline uint64_t latticeKey(int64_t i, int64_t j, int64_t k) {
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    return (static_cast<uint64_t>(i) & mask)
+        | ((static_cast<uint64_t>(j) & mask) << 21)
+        | ((static_cast<uint64_t>(k) & mask) << 42);
+}
+
+// Returns the curl of three channels of the gradient noise at p. The three
+// channels share the random words of a lattice point, and the noise of each
+// octave is drawn from its own stream.
+Vector3D curlNoise(const PhiloxRng& rng, uint64_t octave, const Vector3D& p) {
+    const double f[3] = {std::floor(p.x), std::floor(p.y), std::floor(p.z)};
+    const double t[3] = {p.x - f[0], p.y - f[1], p.z - f[2]};
+    const double u[3] = {fade(t[0]), fade(t[1]), fade(t[2])};
+    const double du[3] = {
+        fadeDerivative(t[0]), fadeDerivative(t[1]), fadeDerivative(t[2])};
+    const int64_t base[3] = {
+        static_cast<int64_t>(f[0]),
+        static_cast<int64_t>(f[1]),
+        static_cast<int64_t>(f[2])};
+
+    // Jacobian of the channels, jacobian[c][d] = dN_c / dp_d
+    double jacobian[3][3] = {};
+    for (int corner = 0; corner < 8; ++corner) {
+        const int c[3] = {corner & 1, (corner >> 1) & 1, corner >> 2};
+
+        double w[3], dw[3], d[3];
+        for (int a = 0; a < 3; ++a) {
+            w[a] = (c[a] == 1) ? u[a] : 1.0 - u[a];
+            dw[a] = (c[a] == 1) ? du[a] : -du[a];
+            d[a] = t[a] - c[a];
+        }
+        const double weight = w[0] * w[1] * w[2];
+        const double weightGradient[3] = {
+            dw[0] * w[1] * w[2], w[0] * dw[1] * w[2], w[0] * w[1] * dw[2]};
+
+        PhiloxRng::Block block = rng(
+            latticeKey(base[0] + c[0], base[1] + c[1], base[2] + c[2]),
+            octave);
+        for (int channel = 0; channel < 3; ++channel) {
+            const double* g = kGradients[block[channel] % 12];
+            double dot = g[0] * d[0] + g[1] * d[1] + g[2] * d[2];
+            for (int a = 0; a < 3; ++a) {
+                jacobian[channel][a] += weightGradient[a] * dot + weight * g[a];
+            }
+        }
+    }
+
+    return Vector3D(
+        jacobian[2][1] - jacobian[1][2],
+        jacobian[0][2] - jacobian[2][0],
+        jacobian[1][0] - jacobian[0][1]);
+}
+
+}  // namespace
+
+GridSmokeUpRes3::GridSmokeUpRes3(size_t upResFactor)
+: _upResFactor(std::max(upResFactor, kOneSize)),
+  _density(std::make_shared<CellCenteredScalarGrid3>()) {
+    _advectionSolver = std::make_shared<SemiLagrangian3>();
+}
+
+GridSmokeUpRes3::~GridSmokeUpRes3() {
+}
+
+size_t GridSmokeUpRes3::upResFactor() const {
+    return _upResFactor;
+}
+
+void GridSmokeUpRes3::setUpResFactor(size_t newValue) {
+    _upResFactor = std::max(newValue, kOneSize);
+}
+
+double GridSmokeUpRes3::turbulenceAmplitude() const {
+    return _turbulenceAmplitude;
+}
+
+void GridSmokeUpRes3::setTurbulenceAmplitude(double newValue) {
+    _turbulenceAmplitude = std::max(newValue, 0.0);
+}
+
+size_t GridSmokeUpRes3::numberOfOctaves() const {
+    return _numberOfOctaves;
+}
+
+void GridSmokeUpRes3::setNumberOfOctaves(size_t newValue) {
+    _numberOfOctaves = newValue;
+}
+
+uint64_t GridSmokeUpRes3::seed() const {
+    return _seed;
+}
+
+void GridSmokeUpRes3::setSeed(uint64_t newValue) {
+    _seed = newValue;
+}
+
+const AdvectionSolver3Ptr& GridSmokeUpRes3::advectionSolver() const {
+    return _advectionSolver;
+}
+
+void GridSmokeUpRes3::setAdvectionSolver(
+    const AdvectionSolver3Ptr& newSolver) {
+    _advectionSolver = newSolver;
+}
+
+ScalarGrid3Ptr GridSmokeUpRes3::density() const {
+    return _density;
+}
+
+const CellCenteredVectorGrid3& GridSmokeUpRes3::velocity() const {
+    return _velocity;
+}
+
+void GridSmokeUpRes3::upsampleDensity(const ScalarGrid3& coarseDensity) {
+    resize(coarseDensity);
+
+    auto den = _density->dataAccessor();
+    auto pos = _density->dataPosition();
+    _density->parallelForEachDataPointIndex(
+        [&](size_t i, size_t j, size_t k) {
+            den(i, j, k) = coarseDensity.sample(pos(i, j, k));
+        });
+}
+
+void GridSmokeUpRes3::advance(
+    const FaceCenteredGrid3& coarseVelocity,
+    double timeIntervalInSeconds,
+    const ScalarField3& boundarySdf) {
+    resize(coarseVelocity);
+    computeVelocity(coarseVelocity, boundarySdf);
+
+    copyGrid(*_density, &_densityBuffer);
+    _advectionSolver->advect(
+        _densityBuffer,
+        _velocity,
+        timeIntervalInSeconds,
+        _density.get(),
+        boundarySdf);
+}
+
+void GridSmokeUpRes3::resize(const Grid3& coarseGrid) {
+    const Size3 res = coarseGrid.resolution() * _upResFactor;
+    const Vector3D gs
+        = coarseGrid.gridSpacing() / static_cast<double>(_upResFactor);
+    const Vector3D& origin = coarseGrid.origin();
+
+    if (_density->resolution() != res
+        || _density->gridSpacing() != gs
+        || _density->origin() != origin) {
+        _density->resize(res, gs, origin, 0.0);
+        _velocity.resize(res, gs, origin);
+    }
+
+    if (!_coarseVorticity.hasSameShape(coarseGrid)) {
+        _coarseVorticity.resize(
+            coarseGrid.resolution(),
+            coarseGrid.gridSpacing(),
+            coarseGrid.origin());
+    }
+}
+
+void GridSmokeUpRes3::computeVelocity(
+    const FaceCenteredGrid3& coarseVelocity,
+    const ScalarField3& boundarySdf) {
+    const Vector3D coarseGs = coarseVelocity.gridSpacing();
+    const double coarseSpacing = min3(coarseGs.x, coarseGs.y, coarseGs.z);
+    const bool hasTurbulence
+        = _turbulenceAmplitude > 0.0 && _numberOfOctaves > 0;
+
+    if (hasTurbulence) {
+        coarseVelocity.computeCurl(_coarseVorticity.dataAccessor());
+    }
+
+    PhiloxRng rng(_seed);
+    auto vel = _velocity.dataAccessor();
+    auto pos = _velocity.dataPosition();
+    _velocity.parallelForEachDataPointIndex(
+        [&](size_t i, size_t j, size_t k) {
+            Vector3D x = pos(i, j, k);
+            Vector3D u = coarseVelocity.sample(x);
+
+            if (hasTurbulence) {
+                // Velocity of the smallest resolved eddies, which fades out
+                // toward the boundary
+                double strength = _turbulenceAmplitude * coarseSpacing
+                    * _coarseVorticity.sample(x).length()
+                    * clamp(boundarySdf.sample(x) / coarseSpacing, 0.0, 1.0);
+
+                if (strength > 0.0) {
+                    Vector3D p = x / coarseSpacing;
+                    double weight = strength;
+                    for (size_t octave = 0; octave < _numberOfOctaves;
+                         ++octave) {
+                        u += weight * curlNoise(rng, octave, p);
+                        p *= 2.0;
+                        weight *= kOctaveWeight;
+                    }
+                }
+            }
+
+            vel(i, j, k) = u;
+        });
+}
@@ -2,6 +2,7 @@
 
 #include <pch.h>
 #include <jet/grid_system_data2.h>
+#include <jet/memory_tracker.h>
 
 using namespace jet;
 
@@ -16,6 +17,7 @@ void GridSystemData2::resize(
     const Size2& resolution,
     const Vector2D& gridSpacing,
     const Vector2D& origin) {
+    MemoryTagScope scope(MemoryTag::Grid);
     _velocity->resize(resolution, gridSpacing, origin);
     for (auto& data : _scalarDataList) {
         data->resize(resolution, gridSpacing, origin);
@@ -50,6 +52,7 @@ BoundingBox2D GridSystemData2::boundingBox() const {
 size_t GridSystemData2::addScalarData(
     const ScalarGridBuilder2Ptr& builder,
     double initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _scalarDataList.size();
     _scalarDataList.push_back(
         builder->build(resolution(), gridSpacing(), origin(), initialVal));
@@ -59,6 +62,7 @@ size_t GridSystemData2::addScalarData(
 size_t GridSystemData2::addVectorData(
     const VectorGridBuilder2Ptr& builder,
     const Vector2D& initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _scalarDataList.size();
     _vectorDataList.push_back(
         builder->build(resolution(), gridSpacing(), origin(), initialVal));
@@ -68,6 +72,7 @@ size_t GridSystemData2::addVectorData(
 size_t GridSystemData2::addAdvectableScalarData(
     const ScalarGridBuilder2Ptr& builder,
     double initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _advectableScalarDataList.size();
     _advectableScalarDataList.push_back(
         builder->build(resolution(), gridSpacing(), origin(), initialVal));
@@ -77,6 +82,7 @@ size_t GridSystemData2::addAdvectableScalarData(
 size_t GridSystemData2::addAdvectableVectorData(
     const VectorGridBuilder2Ptr& builder,
     const Vector2D& initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _advectableVectorDataList.size();
     _advectableVectorDataList.push_back(
         builder->build(resolution(), gridSpacing(), origin(), initialVal));
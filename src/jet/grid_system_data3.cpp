@@ -1,12 +1,149 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/array_utils.h>
+#include <jet/collocated_vector_grid3.h>
 #include <jet/grid_system_data3.h>
+#include <jet/memory_tracker.h>
+#include <serialization_helpers.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 using namespace jet;
 
+template <typename GridPtr>
+static void serializeGrids(
+    const std::vector<GridPtr>& grids,
+    std::ostream* strm) {
+    serializeValue(strm, static_cast<uint64_t>(grids.size()));
+    for (const auto& grid : grids) {
+        grid->serialize(strm);
+    }
+}
+
+template <typename GridPtr>
+static void deserializeGrids(
+    std::istream* strm,
+    std::vector<GridPtr>* grids) {
+    uint64_t numberOfGrids = 0;
+    deserializeValue(strm, &numberOfGrids);
+    JET_THROW_INVALID_ARG_IF(!(*strm) || numberOfGrids != grids->size());
+    for (auto& grid : *grids) {
+        grid->deserialize(strm);
+    }
+}
+
+static size_t numberOfElements(const Size3& size) {
+    return size.x * size.y * size.z;
+}
+
+template <typename T>
+static size_t gridMemoryInBytes(const std::shared_ptr<ScalarGrid3T<T>>& grid) {
+    return numberOfElements(grid->dataSize()) * sizeof(T);
+}
+
+static size_t gridMemoryInBytes(const VectorGrid3Ptr& grid) {
+    auto faceCentered = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid);
+    if (faceCentered != nullptr) {
+        return (numberOfElements(faceCentered->uSize())
+            + numberOfElements(faceCentered->vSize())
+            + numberOfElements(faceCentered->wSize())) * sizeof(double);
+    }
+
+    auto collocated = std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid);
+    if (collocated != nullptr) {
+        return numberOfElements(collocated->dataSize()) * sizeof(Vector3D);
+    }
+
+    return numberOfElements(grid->resolution()) * sizeof(Vector3D);
+}
+
+template <typename GridPtr>
+static size_t gridsMemoryInBytes(const std::vector<GridPtr>& grids) {
+    size_t memory = 0;
+    for (const auto& grid : grids) {
+        memory += gridMemoryInBytes(grid);
+    }
+    return memory;
+}
+
+static bool isReshapeable(const VectorGrid3Ptr& grid) {
+    return std::dynamic_pointer_cast<FaceCenteredGrid3>(grid) != nullptr
+        || std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid) != nullptr;
+}
+
+// Resizes the grid, and fills it with the old data shifted by the offset
+template <typename T>
+static void reshapeGrid(
+    const Point3I& offset,
+    const Size3& resolution,
+    const Vector3D& origin,
+    const std::shared_ptr<ScalarGrid3T<T>>& grid) {
+    // The clone shares the old data until the grid is written
+    auto old = grid->clone();
+    grid->resize(resolution, grid->gridSpacing(), origin);
+    copyShiftedRange3(old->constDataAccessor(), offset, grid->dataAccessor());
+}
+
+static void reshapeGrid(
+    const Point3I& offset,
+    const Size3& resolution,
+    const Vector3D& origin,
+    const VectorGrid3Ptr& grid) {
+    auto old = grid->clone();
+    grid->resize(resolution, grid->gridSpacing(), origin);
+
+    auto faceCentered = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid);
+    if (faceCentered != nullptr) {
+        auto oldFaceCentered
+            = std::dynamic_pointer_cast<FaceCenteredGrid3>(old);
+        copyShiftedRange3(
+            oldFaceCentered->uConstAccessor(), offset,
+            faceCentered->uAccessor());
+        copyShiftedRange3(
+            oldFaceCentered->vConstAccessor(), offset,
+            faceCentered->vAccessor());
+        copyShiftedRange3(
+            oldFaceCentered->wConstAccessor(), offset,
+            faceCentered->wAccessor());
+        return;
+    }
+
+    auto collocated = std::dynamic_pointer_cast<CollocatedVectorGrid3>(grid);
+    auto oldCollocated = std::dynamic_pointer_cast<CollocatedVectorGrid3>(old);
+    copyShiftedRange3(
+        oldCollocated->constDataAccessor(), offset,
+        collocated->dataAccessor());
+}
+
+template <typename GridPtr, typename Builder, typename T>
+GridPtr GridSystemData3::buildGrid(
+    const Builder& builder,
+    const T& initialVal) {
+    if (!_isUsingLazyAllocation) {
+        return builder->build(
+            resolution(), gridSpacing(), origin(), initialVal);
+    }
+
+    // The grid has no data until it is accessed
+    GridPtr grid = builder->build(Size3(), gridSpacing(), origin(), initialVal);
+    PendingGrid pending;
+    pending.allocate = [this, grid, initialVal]() {
+        grid->resize(resolution(), gridSpacing(), origin(), initialVal);
+    };
+    pending.isZero = (initialVal == T());
+
+    std::lock_guard<std::mutex> lock(_pendingGridsMutex);
+    _pendingGrids[grid.get()] = pending;
+    _numberOfPendingGrids.store(
+        _pendingGrids.size(), std::memory_order_release);
+    return grid;
+}
+
 GridSystemData3::GridSystemData3() {
     _velocity = std::make_shared<FaceCenteredGrid3>();
+    _velocityBackBuffer = std::make_shared<FaceCenteredGrid3>();
 }
 
 GridSystemData3::~GridSystemData3() {
@@ -16,18 +153,55 @@ void GridSystemData3::resize(
     const Size3& resolution,
     const Vector3D& gridSpacing,
     const Vector3D& origin) {
+    MemoryTagScope scope(MemoryTag::Grid);
+
+    // The new cells of a resized grid are zero, so the pending grids with
+    // other values are allocated before the resolution changes
+    if (resolution != this->resolution()) {
+        allocatePendingGrids(false);
+    }
+
     _velocity->resize(resolution, gridSpacing, origin);
+    _velocityBackBuffer->resize(resolution, gridSpacing, origin);
     for (auto& data : _scalarDataList) {
-        data->resize(resolution, gridSpacing, origin);
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
     }
     for (auto& data : _vectorDataList) {
-        data->resize(resolution, gridSpacing, origin);
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
     }
     for (auto& data : _advectableScalarDataList) {
-        data->resize(resolution, gridSpacing, origin);
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
     }
     for (auto& data : _advectableVectorDataList) {
-        data->resize(resolution, gridSpacing, origin);
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
+    }
+    for (auto& data : _advectableScalarDataBackBuffers) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
+    }
+    for (auto& data : _advectableVectorDataBackBuffers) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
+    }
+    for (auto& data : _advectableScalarDataFList) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
+    }
+    for (auto& data : _advectableScalarDataFBackBuffers) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, gridSpacing, origin);
+        }
     }
 }
 
@@ -47,39 +221,134 @@ BoundingBox3D GridSystemData3::boundingBox() const {
     return _velocity->boundingBox();
 }
 
+void GridSystemData3::scroll(const Point3I& offset) {
+    if (offset != Point3I()) {
+        reshape(offset, resolution());
+    }
+}
+
+void GridSystemData3::reshape(const Point3I& offset, const Size3& resolution) {
+    // Checks the vector data first so that a failure leaves them all intact
+    for (const auto& data : _vectorDataList) {
+        JET_THROW_INVALID_ARG_IF(!isReshapeable(data));
+    }
+    for (const auto& data : _advectableVectorDataList) {
+        JET_THROW_INVALID_ARG_IF(!isReshapeable(data));
+    }
+
+    MemoryTagScope scope(MemoryTag::Grid);
+
+    // The pending grids keep a single value under the shift, whose new cells
+    // take the nearest values, but the back buffers are resized with zeros
+    if (resolution != this->resolution()) {
+        allocatePendingGrids(false);
+    }
+
+    Vector3D h = gridSpacing();
+    Vector3D newOrigin = origin() + Vector3D(
+        h.x * static_cast<double>(offset.x),
+        h.y * static_cast<double>(offset.y),
+        h.z * static_cast<double>(offset.z));
+
+    reshapeGrid(offset, resolution, newOrigin, _velocity);
+    _velocityBackBuffer->resize(resolution, h, newOrigin);
+    for (auto& data : _scalarDataList) {
+        if (!isPendingGrid(data.get())) {
+            reshapeGrid(offset, resolution, newOrigin, data);
+        }
+    }
+    for (auto& data : _vectorDataList) {
+        if (!isPendingGrid(data.get())) {
+            reshapeGrid(offset, resolution, newOrigin, data);
+        }
+    }
+    for (auto& data : _advectableScalarDataList) {
+        if (!isPendingGrid(data.get())) {
+            reshapeGrid(offset, resolution, newOrigin, data);
+        }
+    }
+    for (auto& data : _advectableVectorDataList) {
+        if (!isPendingGrid(data.get())) {
+            reshapeGrid(offset, resolution, newOrigin, data);
+        }
+    }
+    for (auto& data : _advectableScalarDataBackBuffers) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, h, newOrigin);
+        }
+    }
+    for (auto& data : _advectableVectorDataBackBuffers) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, h, newOrigin);
+        }
+    }
+    for (auto& data : _advectableScalarDataFList) {
+        if (!isPendingGrid(data.get())) {
+            reshapeGrid(offset, resolution, newOrigin, data);
+        }
+    }
+    for (auto& data : _advectableScalarDataFBackBuffers) {
+        if (!isPendingGrid(data.get())) {
+            data->resize(resolution, h, newOrigin);
+        }
+    }
+}
+
 size_t GridSystemData3::addScalarData(
     const ScalarGridBuilder3Ptr& builder,
     double initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _scalarDataList.size();
     _scalarDataList.push_back(
-        builder->build(resolution(), gridSpacing(), origin(), initialVal));
+        buildGrid<ScalarGrid3Ptr>(builder, initialVal));
     return attrIdx;
 }
 
 size_t GridSystemData3::addVectorData(
     const VectorGridBuilder3Ptr& builder,
     const Vector3D& initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _scalarDataList.size();
     _vectorDataList.push_back(
-        builder->build(resolution(), gridSpacing(), origin(), initialVal));
+        buildGrid<VectorGrid3Ptr>(builder, initialVal));
     return attrIdx;
 }
 
 size_t GridSystemData3::addAdvectableScalarData(
     const ScalarGridBuilder3Ptr& builder,
     double initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _advectableScalarDataList.size();
     _advectableScalarDataList.push_back(
-        builder->build(resolution(), gridSpacing(), origin(), initialVal));
+        buildGrid<ScalarGrid3Ptr>(builder, initialVal));
+    _advectableScalarDataBackBuffers.push_back(
+        buildGrid<ScalarGrid3Ptr>(builder, initialVal));
+    _advectableScalarDataUpdateIntervals.push_back(1);
     return attrIdx;
 }
 
 size_t GridSystemData3::addAdvectableVectorData(
     const VectorGridBuilder3Ptr& builder,
     const Vector3D& initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
     size_t attrIdx = _advectableVectorDataList.size();
     _advectableVectorDataList.push_back(
-        builder->build(resolution(), gridSpacing(), origin(), initialVal));
+        buildGrid<VectorGrid3Ptr>(builder, initialVal));
+    _advectableVectorDataBackBuffers.push_back(
+        buildGrid<VectorGrid3Ptr>(builder, initialVal));
+    _advectableVectorDataUpdateIntervals.push_back(1);
+    return attrIdx;
+}
+
+size_t GridSystemData3::addAdvectableScalarDataF(
+    const ScalarGridBuilder3FPtr& builder,
+    float initialVal) {
+    MemoryTagScope scope(MemoryTag::Grid);
+    size_t attrIdx = _advectableScalarDataFList.size();
+    _advectableScalarDataFList.push_back(
+        buildGrid<ScalarGrid3FPtr>(builder, initialVal));
+    _advectableScalarDataFBackBuffers.push_back(
+        buildGrid<ScalarGrid3FPtr>(builder, initialVal));
     return attrIdx;
 }
 
@@ -88,23 +357,77 @@ const FaceCenteredGrid3Ptr& GridSystemData3::velocity() const {
 }
 
 const ScalarGrid3Ptr& GridSystemData3::scalarDataAt(size_t idx) const {
+    allocateGrid(_scalarDataList[idx].get());
     return _scalarDataList[idx];
 }
 
 const VectorGrid3Ptr& GridSystemData3::vectorDataAt(size_t idx) const {
+    allocateGrid(_vectorDataList[idx].get());
     return _vectorDataList[idx];
 }
 
 const ScalarGrid3Ptr&
 GridSystemData3::advectableScalarDataAt(size_t idx) const {
+    allocateGrid(_advectableScalarDataList[idx].get());
     return _advectableScalarDataList[idx];
 }
 
 const VectorGrid3Ptr&
 GridSystemData3::advectableVectorDataAt(size_t idx) const {
+    allocateGrid(_advectableVectorDataList[idx].get());
     return _advectableVectorDataList[idx];
 }
 
+const ScalarGrid3FPtr&
+GridSystemData3::advectableScalarDataFAt(size_t idx) const {
+    allocateGrid(_advectableScalarDataFList[idx].get());
+    return _advectableScalarDataFList[idx];
+}
+
+const FaceCenteredGrid3Ptr& GridSystemData3::velocityBackBuffer() const {
+    return _velocityBackBuffer;
+}
+
+const ScalarGrid3Ptr&
+GridSystemData3::advectableScalarDataBackBufferAt(size_t idx) const {
+    allocateGrid(_advectableScalarDataBackBuffers[idx].get());
+    return _advectableScalarDataBackBuffers[idx];
+}
+
+const VectorGrid3Ptr&
+GridSystemData3::advectableVectorDataBackBufferAt(size_t idx) const {
+    allocateGrid(_advectableVectorDataBackBuffers[idx].get());
+    return _advectableVectorDataBackBuffers[idx];
+}
+
+const ScalarGrid3FPtr&
+GridSystemData3::advectableScalarDataFBackBufferAt(size_t idx) const {
+    allocateGrid(_advectableScalarDataFBackBuffers[idx].get());
+    return _advectableScalarDataFBackBuffers[idx];
+}
+
+unsigned int GridSystemData3::advectableScalarDataUpdateIntervalAt(
+    size_t idx) const {
+    return _advectableScalarDataUpdateIntervals[idx];
+}
+
+unsigned int GridSystemData3::advectableVectorDataUpdateIntervalAt(
+    size_t idx) const {
+    return _advectableVectorDataUpdateIntervals[idx];
+}
+
+void GridSystemData3::setAdvectableScalarDataUpdateInterval(
+    size_t idx, unsigned int interval) {
+    JET_THROW_INVALID_ARG_IF(interval == 0);
+    _advectableScalarDataUpdateIntervals[idx] = interval;
+}
+
+void GridSystemData3::setAdvectableVectorDataUpdateInterval(
+    size_t idx, unsigned int interval) {
+    JET_THROW_INVALID_ARG_IF(interval == 0);
+    _advectableVectorDataUpdateIntervals[idx] = interval;
+}
+
 size_t GridSystemData3::numberOfScalarData() const {
     return _scalarDataList.size();
 }
@@ -120,3 +443,96 @@ size_t GridSystemData3::numberOfAdvectableScalarData() const {
 size_t GridSystemData3::numberOfAdvectableVectorData() const {
     return _advectableVectorDataList.size();
 }
+
+size_t GridSystemData3::numberOfAdvectableScalarDataF() const {
+    return _advectableScalarDataFList.size();
+}
+
+bool GridSystemData3::isUsingLazyAllocation() const {
+    return _isUsingLazyAllocation;
+}
+
+void GridSystemData3::setIsUsingLazyAllocation(bool isUsing) {
+    _isUsingLazyAllocation = isUsing;
+}
+
+size_t GridSystemData3::memoryInBytes() const {
+    return gridMemoryInBytes(_velocity)
+        + gridMemoryInBytes(_velocityBackBuffer)
+        + gridsMemoryInBytes(_scalarDataList)
+        + gridsMemoryInBytes(_vectorDataList)
+        + gridsMemoryInBytes(_advectableScalarDataList)
+        + gridsMemoryInBytes(_advectableVectorDataList)
+        + gridsMemoryInBytes(_advectableScalarDataBackBuffers)
+        + gridsMemoryInBytes(_advectableVectorDataBackBuffers)
+        + gridsMemoryInBytes(_advectableScalarDataFList)
+        + gridsMemoryInBytes(_advectableScalarDataFBackBuffers);
+}
+
+bool GridSystemData3::isPendingGrid(const void* grid) const {
+    std::lock_guard<std::mutex> lock(_pendingGridsMutex);
+    return _pendingGrids.count(grid) > 0;
+}
+
+void GridSystemData3::allocateGrid(const void* grid) const {
+    // Only loads the count once all the grids are allocated
+    if (_numberOfPendingGrids.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_pendingGridsMutex);
+    auto iter = _pendingGrids.find(grid);
+    if (iter != _pendingGrids.end()) {
+        MemoryTagScope scope(MemoryTag::Grid);
+        iter->second.allocate();
+        _pendingGrids.erase(iter);
+        _numberOfPendingGrids.store(
+            _pendingGrids.size(), std::memory_order_release);
+    }
+}
+
+void GridSystemData3::allocatePendingGrids(bool isIncludingZeroGrids) const {
+    std::lock_guard<std::mutex> lock(_pendingGridsMutex);
+    MemoryTagScope scope(MemoryTag::Grid);
+    for (auto iter = _pendingGrids.begin(); iter != _pendingGrids.end();) {
+        if (isIncludingZeroGrids || !iter->second.isZero) {
+            iter->second.allocate();
+            iter = _pendingGrids.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    _numberOfPendingGrids.store(
+        _pendingGrids.size(), std::memory_order_release);
+}
+
+void GridSystemData3::serialize(std::ostream* strm) const {
+    allocatePendingGrids(true);
+    serializeSectionTag(strm, "GridSystemData3");
+    _velocity->serialize(strm);
+    serializeGrids(_scalarDataList, strm);
+    serializeGrids(_vectorDataList, strm);
+    serializeGrids(_advectableScalarDataList, strm);
+    serializeGrids(_advectableVectorDataList, strm);
+    serializeGrids(_advectableScalarDataFList, strm);
+}
+
+void GridSystemData3::deserialize(std::istream* strm) {
+    MemoryTagScope scope(MemoryTag::Grid);
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "GridSystemData3"));
+
+    // The grids take their sizes and values from the stream
+    {
+        std::lock_guard<std::mutex> lock(_pendingGridsMutex);
+        _pendingGrids.clear();
+        _numberOfPendingGrids.store(0, std::memory_order_release);
+    }
+
+    _velocity->deserialize(strm);
+    deserializeGrids(strm, &_scalarDataList);
+    deserializeGrids(strm, &_vectorDataList);
+    deserializeGrids(strm, &_advectableScalarDataList);
+    deserializeGrids(strm, &_advectableVectorDataList);
+    deserializeGrids(strm, &_advectableScalarDataFList);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+}
@@ -0,0 +1,418 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/iisph_solver3.h>
+#include <jet/parallel.h>
+#include <jet/sph_kernels3.h>
+#include <serialization_helpers.h>
+#include <sph_kernel_helpers.h>
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace jet;
+
+// Relaxation factor of the Jacobi iterations, suggested by Ihmsen et al.
+static const double kRelaxation = 0.5;
+
+static const double kTimeStepLimitBySpeedFactor = 0.4;
+static const double kTimeStepLimitByForceFactor = 0.25;
+
+IisphSolver3::IisphSolver3() {
+}
+
+IisphSolver3::~IisphSolver3() {
+}
+
+double IisphSolver3::maxDensityErrorRatio() const {
+    return _maxDensityErrorRatio;
+}
+
+void IisphSolver3::setMaxDensityErrorRatio(double ratio) {
+    _maxDensityErrorRatio = std::max(ratio, 0.0);
+}
+
+double IisphSolver3::maxPeakDensityErrorRatio() const {
+    return _maxPeakDensityErrorRatio;
+}
+
+void IisphSolver3::setMaxPeakDensityErrorRatio(double ratio) {
+    _maxPeakDensityErrorRatio = std::max(ratio, 0.0);
+}
+
+unsigned int IisphSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+void IisphSolver3::setMaxNumberOfIterations(unsigned int n) {
+    _maxNumberOfIterations = n;
+}
+
+unsigned int IisphSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double IisphSolver3::lastDensityErrorRatio() const {
+    return _lastDensityErrorRatio;
+}
+
+double IisphSolver3::lastPeakDensityErrorRatio() const {
+    return _lastPeakDensityErrorRatio;
+}
+
+void IisphSolver3::serialize(std::ostream* strm) const {
+    SphSolver3::serialize(strm);
+
+    serializeSectionTag(strm, "IisphSolver3");
+    uint32_t maxNumberOfIterations = _maxNumberOfIterations;
+    serializeValue(strm, _maxDensityErrorRatio);
+    serializeValue(strm, _maxPeakDensityErrorRatio);
+    serializeValue(strm, maxNumberOfIterations);
+}
+
+void IisphSolver3::deserialize(std::istream* strm) {
+    SphSolver3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "IisphSolver3"));
+    uint32_t maxNumberOfIterations = 0;
+    deserializeValue(strm, &_maxDensityErrorRatio);
+    deserializeValue(strm, &_maxPeakDensityErrorRatio);
+    deserializeValue(strm, &maxNumberOfIterations);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    _maxNumberOfIterations = maxNumberOfIterations;
+}
+
+unsigned int IisphSolver3::numberOfSubTimeSteps(
+    double timeIntervalInSeconds) const {
+    auto particles = sphSystemData();
+    size_t numberOfParticles = particles->numberOfParticles();
+    auto v = particles->velocities();
+    auto f = particles->forces();
+
+    const double kernelRadius = particles->kernelRadius();
+    const double mass = particles->mass();
+
+    auto maxLength = [](
+        const ConstArrayAccessor1<Vector3D>& vectors, size_t n) {
+        return parallelReduce(
+            kZeroSize,
+            n,
+            0.0,
+            [&](size_t begin, size_t end, double partial) {
+                for (size_t i = begin; i < end; ++i) {
+                    partial = std::max(partial, vectors[i].length());
+                }
+                return partial;
+            },
+            [](double a, double b) {
+                return std::max(a, b);
+            });
+    };
+    double maxSpeed = maxLength(v, numberOfParticles);
+    double maxForceMagnitude = maxLength(f, numberOfParticles);
+
+    // Courant condition on the particle spacing, and the force limit of
+    // SphSolver3
+    double timeStepLimitBySpeed
+        = kTimeStepLimitBySpeedFactor * particles->targetSpacing() / maxSpeed;
+    double timeStepLimitByForce
+        = kTimeStepLimitByForceFactor
+        * std::sqrt(kernelRadius * mass / maxForceMagnitude);
+
+    double desiredTimeStep
+        = timeStepLimitScale()
+        * std::min(timeStepLimitBySpeed, timeStepLimitByForce);
+
+    return std::max(
+        static_cast<unsigned int>(
+            std::ceil(timeIntervalInSeconds / desiredTimeStep)),
+        1u);
+}
+
+void IisphSolver3::accumulatePressureForce(double timeIntervalInSeconds) {
+    auto particles = sphSystemData();
+    const size_t numberOfParticles = particles->numberOfParticles();
+    const double dt = timeIntervalInSeconds;
+
+    // The particles move with the new velocities for a fraction of the step
+    const double positionDt = positionUpdateFraction() * dt;
+    const double dt2 = dt * positionDt;
+    const double targetDensity = particles->targetDensity();
+    const double mass = particles->mass();
+
+    auto x = particles->positions();
+    auto v = particles->velocities();
+    auto d = particles->densities();
+    auto p = particles->pressures();
+    auto f = particles->forces();
+    const auto& neighborLists = particles->neighborLists();
+
+    const SphSpikyKernel3 kernel(particles->kernelRadius());
+    const SphBoundaryParticles3Ptr& boundary = boundaryParticles();
+
+    // Moves the particles with the non-pressure forces and lets the collider
+    // resolve them as the time integration will. The density prediction
+    // then uses the resolved motion, and the pressure cannot move a
+    // particle along the normal of the collider that stopped it, as
+    // PciSphSolver3 sees by resolving its predicted positions.
+    parallelFor(
+        kZeroSize,
+        numberOfParticles,
+        [&](size_t i) {
+            _advectedVelocities[i] = v[i] + dt / mass * f[i];
+            _advectedPositions[i] = x[i] + positionDt * _advectedVelocities[i];
+            _collisionNormals[i] = _advectedPositions[i];
+        });
+    resolveCollision(
+        _advectedPositions.accessor(),
+        _advectedVelocities.accessor());
+    parallelFor(
+        kZeroSize,
+        numberOfParticles,
+        [&](size_t i) {
+            Vector3D correction = _advectedPositions[i] - _collisionNormals[i];
+            double length = correction.length();
+            _collisionNormals[i]
+                = (length > kEpsilonD) ? correction / length : Vector3D();
+            _advectedVelocities[i]
+                = (_advectedPositions[i] - x[i]) / positionDt;
+        });
+
+    // Removes the part of the displacement of the particle i along its
+    // collision normal
+    auto constrain = [&](size_t i, const Vector3D& displacement) {
+        const Vector3D& n = _collisionNormals[i];
+        return displacement - displacement.dot(n) * n;
+    };
+
+    // Computes the displacement coefficient d_ii, the diagonal a_ii, and the
+    // density advected by the non-pressure forces, and warm-starts the
+    // pressure. The gradient of the kernel toward the neighbor j is
+    // scale * (x_j - x_i). The static boundary particles b add the mass
+    // rho0 V_b to these sums with zero velocity and no pressure of their
+    // own, as in Akinci et al. (SIGGRAPH 2012).
+    parallelFor(
+        kZeroSize,
+        numberOfParticles,
+        [&](size_t i) {
+            const Vector3D& vi = _advectedVelocities[i];
+            Vector3D gradientSum;
+            double gradientLengthSquaredSum = 0.0;
+            double divergence = 0.0;
+            forEachNeighborBatch(
+                x,
+                x[i],
+                neighborLists[i],
+                [&] (SphNeighborBatch3& batch) {
+                    sphSpikyGradientScales(
+                        kernel,
+                        batch.distanceSquared,
+                        batch.size,
+                        batch.weight);
+                    for (size_t k = 0; k < batch.size; ++k) {
+                        size_t j = batch.index[k];
+                        Vector3D gradient = batch.weight[k]
+                            * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+                        const Vector3D& vj = _advectedVelocities[j];
+                        gradientSum += gradient;
+                        gradientLengthSquaredSum
+                            += gradient.dot(constrain(j, gradient));
+                        divergence += (vi - vj).dot(gradient);
+                    }
+                });
+
+            Vector3D boundaryGradient;
+            if (boundary != nullptr) {
+                boundaryGradient = boundary->sumOfGradientNearby(x[i]);
+            }
+            _boundaryGradients[i] = boundaryGradient;
+
+            const double scale = dt2 / square(d[i]);
+            _dii[i] = constrain(
+                i,
+                -scale
+                * (mass * gradientSum + targetDensity * boundaryGradient));
+            _aii[i] = mass * _dii[i].dot(gradientSum)
+                - scale * mass * mass * gradientLengthSquaredSum
+                + targetDensity * _dii[i].dot(boundaryGradient);
+            _advectedDensities[i] = d[i] + positionDt
+                * (mass * divergence
+                   + targetDensity * vi.dot(boundaryGradient));
+            p[i] *= 0.5;
+        });
+
+    unsigned int numberOfIterations = 0;
+    double densityErrorRatio = 0.0;
+    double peakDensityErrorRatio = 0.0;
+
+    for (unsigned int l = 0; l < _maxNumberOfIterations; ++l) {
+        // Sum of d_ij p_j
+        parallelFor(
+            kZeroSize,
+            numberOfParticles,
+            [&](size_t i) {
+                Vector3D sum;
+                forEachNeighborBatch(
+                    x,
+                    x[i],
+                    neighborLists[i],
+                    [&] (SphNeighborBatch3& batch) {
+                        sphSpikyGradientScales(
+                            kernel,
+                            batch.distanceSquared,
+                            batch.size,
+                            batch.weight);
+                        for (size_t k = 0; k < batch.size; ++k) {
+                            size_t j = batch.index[k];
+                            double coefficient = batch.weight[k]
+                                * p[j] / square(d[j]);
+                            sum += coefficient
+                                * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+                        }
+                    });
+                _sumDijPj[i] = constrain(i, -dt2 * mass * sum);
+            });
+
+        // Relaxed Jacobi update of the pressure
+        parallelFor(
+            kZeroSize,
+            numberOfParticles,
+            [&](size_t i) {
+                const double dji = dt2 * mass / square(d[i]);
+                double sum = 0.0;
+                forEachNeighborBatch(
+                    x,
+                    x[i],
+                    neighborLists[i],
+                    [&] (SphNeighborBatch3& batch) {
+                        sphSpikyGradientScales(
+                            kernel,
+                            batch.distanceSquared,
+                            batch.size,
+                            batch.weight);
+                        for (size_t k = 0; k < batch.size; ++k) {
+                            size_t j = batch.index[k];
+                            Vector3D gradient = batch.weight[k]
+                                * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+                            Vector3D displacement = _sumDijPj[i]
+                                - _dii[j] * p[j]
+                                - (_sumDijPj[j]
+                                   - constrain(j, dji * p[i] * gradient));
+                            sum += displacement.dot(gradient);
+                        }
+                    });
+                sum *= mass;
+                sum += targetDensity * _sumDijPj[i].dot(_boundaryGradients[i]);
+
+                double density = _advectedDensities[i] + _aii[i] * p[i] + sum;
+                _densityErrors[i] = std::max(density - targetDensity, 0.0);
+
+                double pressure = 0.0;
+                if (std::fabs(_aii[i]) > kEpsilonD) {
+                    pressure = (1.0 - kRelaxation) * p[i]
+                        + kRelaxation / _aii[i]
+                        * (targetDensity - _advectedDensities[i] - sum);
+                }
+                if (pressure < 0.0) {
+                    pressure *= negativePressureScale();
+                }
+                _newPressures[i] = pressure;
+            });
+
+        parallelFor(
+            kZeroSize,
+            numberOfParticles,
+            [&](size_t i) {
+                p[i] = _newPressures[i];
+            });
+
+        double densityErrorSum = parallelReduce(
+            kZeroSize,
+            numberOfParticles,
+            0.0,
+            [&](size_t begin, size_t end, double partial) {
+                for (size_t i = begin; i < end; ++i) {
+                    partial += _densityErrors[i];
+                }
+                return partial;
+            },
+            [](double a, double b) {
+                return a + b;
+            });
+
+        double maxDensityError = parallelReduce(
+            kZeroSize,
+            numberOfParticles,
+            0.0,
+            [&](size_t begin, size_t end, double partial) {
+                for (size_t i = begin; i < end; ++i) {
+                    partial = std::max(partial, _densityErrors[i]);
+                }
+                return partial;
+            },
+            [](double a, double b) {
+                return std::max(a, b);
+            });
+
+        numberOfIterations = l + 1;
+        densityErrorRatio = (numberOfParticles > 0)
+            ? densityErrorSum / (numberOfParticles * targetDensity) : 0.0;
+        peakDensityErrorRatio = maxDensityError / targetDensity;
+
+        // The average alone lets a few particles, such as the ones pushed
+        // against a collider, stay compressed
+        if (numberOfIterations >= 2
+            && densityErrorRatio < _maxDensityErrorRatio
+            && peakDensityErrorRatio < _maxPeakDensityErrorRatio) {
+            break;
+        }
+    }
+
+    _lastNumberOfIterations = numberOfIterations;
+    _lastDensityErrorRatio = densityErrorRatio;
+    _lastPeakDensityErrorRatio = peakDensityErrorRatio;
+
+    JET_INFO << "Number of IISPH iterations: " << numberOfIterations;
+    JET_INFO << "Average density error ratio after IISPH iteration: "
+             << densityErrorRatio;
+    JET_INFO << "Peak density error ratio after IISPH iteration: "
+             << peakDensityErrorRatio;
+    if (densityErrorRatio > _maxDensityErrorRatio) {
+        JET_WARN << "Average density error ratio is greater than the "
+                 << "threshold!";
+        JET_WARN << "Ratio: " << densityErrorRatio
+                 << " Threshold: " << _maxDensityErrorRatio;
+    }
+    if (peakDensityErrorRatio > _maxPeakDensityErrorRatio) {
+        JET_WARN << "Peak density error ratio is greater than the "
+                 << "threshold!";
+        JET_WARN << "Ratio: " << peakDensityErrorRatio
+                 << " Threshold: " << _maxPeakDensityErrorRatio;
+    }
+
+    SphSolver3::accumulatePressureForce(x, d, p, f);
+}
+
+void IisphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
+    SphSolver3::onBeginAdvanceTimeStep(timeStepInSeconds);
+
+    // Allocate temp buffers
+    size_t numberOfParticles = particleSystemData()->numberOfParticles();
+    _advectedPositions.resize(numberOfParticles);
+    _advectedVelocities.resize(numberOfParticles);
+    _collisionNormals.resize(numberOfParticles);
+    _dii.resize(numberOfParticles);
+    _boundaryGradients.resize(numberOfParticles);
+    _sumDijPj.resize(numberOfParticles);
+    _aii.resize(numberOfParticles);
+    _advectedDensities.resize(numberOfParticles);
+    _newPressures.resize(numberOfParticles);
+    _densityErrors.resize(numberOfParticles);
+}
+
+void IisphSolver3::collectStatistics(SubTimeStepStatistics* stats) const {
+    SphSolver3::collectStatistics(stats);
+
+    stats->numberOfPressureIterations = _lastNumberOfIterations;
+    stats->pressureResidual = _lastDensityErrorRatio;
+}
@@ -2,6 +2,7 @@
 
 #include <pch.h>
 #include <jet/implicit_surface3.h>
+#include <jet/parallel.h>
 
 using namespace jet;
 
@@ -18,3 +19,11 @@ ImplicitSurface3::~ImplicitSurface3() {
 double ImplicitSurface3::closestDistance(const Vector3D& otherPoint) const {
     return std::fabs(signedDistance(otherPoint));
 }
+
+void ImplicitSurface3::batchSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+        result[i] = signedDistance(otherPoints[i]);
+    });
+}
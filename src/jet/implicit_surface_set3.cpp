@@ -1,14 +1,40 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/array1.h>
 #include <jet/implicit_surface_set3.h>
+#include <jet/math_utils.h>
+#include <jet/parallel.h>
 #include <jet/surface_to_implicit3.h>
 
 #include <algorithm>
 #include <limits>
+#include <vector>
 
 using namespace jet;
 
+namespace {
+
+// Number of consecutive points that ImplicitSurfaceSet3::batchSignedDistance
+// culls the surfaces for at once
+const size_t kBatchChunkSize = 256;
+
+double distanceSquaredBetweenBoxes(
+    const BoundingBox3D& a, const BoundingBox3D& b) {
+    double dx = std::max(
+        0.0, std::max(a.lowerCorner.x - b.upperCorner.x,
+                      b.lowerCorner.x - a.upperCorner.x));
+    double dy = std::max(
+        0.0, std::max(a.lowerCorner.y - b.upperCorner.y,
+                      b.lowerCorner.y - a.upperCorner.y));
+    double dz = std::max(
+        0.0, std::max(a.lowerCorner.z - b.upperCorner.z,
+                      b.lowerCorner.z - a.upperCorner.z));
+    return dx * dx + dy * dy + dz * dz;
+}
+
+}  // namespace
+
 ImplicitSurfaceSet3::ImplicitSurfaceSet3() {
 }
 
@@ -26,88 +52,93 @@ const ImplicitSurface3Ptr& ImplicitSurfaceSet3::surfaceAt(size_t i) const {
 }
 
 void ImplicitSurfaceSet3::addExplicitSurface(const Surface3Ptr& surface) {
-    _surfaces.push_back(std::make_shared<SurfaceToImplicit3>(surface));
+    addSurface(std::make_shared<SurfaceToImplicit3>(surface));
 }
 
 void ImplicitSurfaceSet3::addSurface(const ImplicitSurface3Ptr& surface) {
     _surfaces.push_back(surface);
+    invalidateBvh();
 }
 
-Vector3D ImplicitSurfaceSet3::closestPoint(const Vector3D& otherPoint) const {
-    Vector3D result(
-        kMaxD,
-        kMaxD,
-        kMaxD);
+void ImplicitSurfaceSet3::invalidateBvh() {
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    _isBvhValid = false;
+}
 
-    double minimumDistance = kMaxD;
+Vector3D ImplicitSurfaceSet3::closestPoint(const Vector3D& otherPoint) const {
+    buildBvh();
 
-    for (const auto& surface : _surfaces) {
-        Vector3D localClosestPoint = surface->closestPoint(otherPoint);
-        double localDistance = surface->closestDistance(otherPoint);
+    size_t i = _bvh.nearest(otherPoint, [&](size_t j) {
+        return square(_surfaces[j]->closestDistance(otherPoint));
+    });
 
-        if (localDistance < minimumDistance) {
-            result = localClosestPoint;
-            minimumDistance = localDistance;
-        }
+    if (i == kMaxSize) {
+        return Vector3D(kMaxD, kMaxD, kMaxD);
     }
 
-    return result;
+    return _surfaces[i]->closestPoint(otherPoint);
 }
 
 double ImplicitSurfaceSet3::closestDistance(const Vector3D& otherPoint) const {
-    double minimumDistance = kMaxD;
+    buildBvh();
 
-    for (const auto& surface : _surfaces) {
-        double localDistance = surface->closestDistance(otherPoint);
+    double minimumDistance = kMaxD;
+    _bvh.nearest(otherPoint, [&](size_t j) {
+        double localDistance = _surfaces[j]->closestDistance(otherPoint);
         minimumDistance = std::min(localDistance, minimumDistance);
-    }
+        return square(localDistance);
+    });
 
     return minimumDistance;
 }
 
 Vector3D ImplicitSurfaceSet3::actualClosestNormal(
     const Vector3D& otherPoint) const {
-    Vector3D result(1, 0, 0);
-
-    double minimumDistance = kMaxD;
+    buildBvh();
 
-    for (const auto& surface : _surfaces) {
-        Vector3D localClosestNormal = surface->closestNormal(otherPoint);
-        double localDistance = surface->closestDistance(otherPoint);
+    size_t i = _bvh.nearest(otherPoint, [&](size_t j) {
+        return square(_surfaces[j]->closestDistance(otherPoint));
+    });
 
-        if (localDistance < minimumDistance) {
-            result = localClosestNormal;
-            minimumDistance = localDistance;
-        }
+    if (i == kMaxSize) {
+        return Vector3D(1, 0, 0);
     }
 
-    return result;
+    return _surfaces[i]->closestNormal(otherPoint);
 }
 
 bool ImplicitSurfaceSet3::intersects(const Ray3D& ray) const {
-    for (const auto& surface : _surfaces) {
-        if (surface->intersects(ray)) {
-            return true;
-        }
-    }
+    buildBvh();
 
-    return false;
+    return _bvh.anyRayHit(ray, [&](size_t j) {
+        return _surfaces[j]->intersects(ray);
+    });
 }
 
 SurfaceRayIntersection3 ImplicitSurfaceSet3::actualClosestIntersection(
     const Ray3D& ray) const {
+    buildBvh();
+
     SurfaceRayIntersection3 intersection;
     double tMin = kMaxD;
+    size_t closest = kMaxSize;
 
-    for (const auto& surface : _surfaces) {
+    _bvh.forEachRayCandidate(ray, [&](size_t j) {
         SurfaceRayIntersection3 localResult =
-            surface->closestIntersection(ray);
+            _surfaces[j]->closestIntersection(ray);
 
-        if (localResult.isIntersecting && localResult.t < tMin) {
+        if (!localResult.isIntersecting) {
+            return kMaxD;
+        }
+
+        if (localResult.t < tMin || (localResult.t == tMin && j < closest)) {
             intersection = localResult;
             tMin = localResult.t;
+            closest = j;
         }
-    }
+
+        return localResult.t;
+    });
 
     return intersection;
 }
@@ -122,10 +153,117 @@ BoundingBox3D ImplicitSurfaceSet3::boundingBox() const {
 }
 
 double ImplicitSurfaceSet3::signedDistance(const Vector3D& otherPoint) const {
-    double sdf = kMaxD;
-    for (const auto& surface : _surfaces) {
-        sdf = std::min(sdf, surface->signedDistance(otherPoint));
+    buildBvh();
+
+    return _bvh.minimumSignedDistance(otherPoint, [&](size_t j) {
+        return _surfaces[j]->signedDistance(otherPoint);
+    });
+}
+
+void ImplicitSurfaceSet3::batchSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    buildBvh();
+
+    const size_t n = otherPoints.size();
+    const size_t numberOfChunks = (n + kBatchChunkSize - 1) / kBatchChunkSize;
+    auto chunkEnd = [&](size_t c) {
+        return std::min(n, (c + 1) * kBatchChunkSize);
+    };
+
+    // Bounds of the chunks and the largest minimum distance in each chunk
+    std::vector<BoundingBox3D> chunkBounds(numberOfChunks);
+    std::vector<double> chunkMaxDistances(numberOfChunks, kMaxD);
+    parallelFor(kZeroSize, numberOfChunks, [&](size_t c) {
+        BoundingBox3D box;
+        for (size_t i = c * kBatchChunkSize; i < chunkEnd(c); ++i) {
+            box.merge(otherPoints[i]);
+            result[i] = kMaxD;
+        }
+        chunkBounds[c] = box;
+    });
+
+    std::vector<size_t> activeChunks;
+    std::vector<size_t> activeOffsets;
+    Array1<Vector3D> activePoints;
+    Array1<double> activeDistances;
+    for (size_t j = 0; j < _surfaces.size(); ++j) {
+        // Same culling as Bvh3::minimumSignedDistance, for all the points of
+        // a chunk at once
+        activeChunks.clear();
+        activeOffsets.assign(1, 0);
+        for (size_t c = 0; c < numberOfChunks; ++c) {
+            double boxDistSquared
+                = distanceSquaredBetweenBoxes(chunkBounds[c], _bounds[j]);
+            double maxDist = chunkMaxDistances[c];
+            if (boxDistSquared > 0.0
+                && (maxDist <= 0.0 || boxDistSquared >= maxDist * maxDist)) {
+                continue;
+            }
+            activeChunks.push_back(c);
+            activeOffsets.push_back(
+                activeOffsets.back() + chunkEnd(c) - c * kBatchChunkSize);
+        }
+
+        if (activeChunks.empty()) {
+            continue;
+        }
+
+        activePoints.resize(activeOffsets.back());
+        activeDistances.resize(activeOffsets.back());
+        parallelFor(kZeroSize, activeChunks.size(), [&](size_t a) {
+            size_t first = activeChunks[a] * kBatchChunkSize;
+            for (size_t i = first; i < chunkEnd(activeChunks[a]); ++i) {
+                activePoints[activeOffsets[a] + i - first] = otherPoints[i];
+            }
+        });
+
+        _surfaces[j]->batchSignedDistance(
+            activePoints.constAccessor(), activeDistances.accessor());
+
+        parallelFor(kZeroSize, activeChunks.size(), [&](size_t a) {
+            size_t c = activeChunks[a];
+            size_t first = c * kBatchChunkSize;
+            double maxDist = -kMaxD;
+            for (size_t i = first; i < chunkEnd(c); ++i) {
+                result[i] = std::min(
+                    result[i], activeDistances[activeOffsets[a] + i - first]);
+                maxDist = std::max(maxDist, result[i]);
+            }
+            chunkMaxDistances[c] = maxDist;
+        });
+    }
+}
+
+void ImplicitSurfaceSet3::buildBvh() const {
+    if (_isBvhValid) {
+        return;
     }
 
-    return sdf;
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    if (_isBvhValid) {
+        return;
+    }
+
+    // A surface is inside-out if a point outside of its bounding box is
+    // inside of it, such as a box with flipped normals used as a container.
+    // Such surfaces can have negative signed distance anywhere, so they go to
+    // the BVH with an unbounded box and are visited by every query.
+    std::vector<BoundingBox3D> bounds(_surfaces.size());
+    for (size_t i = 0; i < _surfaces.size(); ++i) {
+        BoundingBox3D box = _surfaces[i]->boundingBox();
+        Vector3D outsidePoint
+            = 2.0 * box.upperCorner - box.lowerCorner + Vector3D(1, 1, 1);
+        if (_surfaces[i]->signedDistance(outsidePoint) < 0.0) {
+            box = BoundingBox3D(
+                Vector3D(-kMaxD, -kMaxD, -kMaxD),
+                Vector3D(kMaxD, kMaxD, kMaxD));
+        }
+        bounds[i] = box;
+    }
+
+    _bvh.build(bounds);
+    _bounds = bounds;
+
+    _isBvhValid = true;
 }
@@ -7,11 +7,31 @@
 #include <jet/parallel.h>
 
 #include <algorithm>
+#include <functional>
 #include <limits>
 #include <utility>  // just make cpplint happy..
+#include <vector>
 
 using namespace jet;
 
+namespace {
+
+std::vector<Point2UI> collectNarrowBand(
+    const Size2& size,
+    const std::function<bool(size_t, size_t)>& isInBand) {
+    std::vector<Point2UI> band;
+    for (size_t j = 0; j < size.y; ++j) {
+        for (size_t i = 0; i < size.x; ++i) {
+            if (isInBand(i, j)) {
+                band.push_back(Point2UI(i, j));
+            }
+        }
+    }
+    return band;
+}
+
+}  // namespace
+
 IterativeLevelSetSolver2::IterativeLevelSetSolver2() {
 }
 
@@ -39,32 +59,55 @@ void IterativeLevelSetSolver2::reinitialize(
     Array2<double> temp(size);
     ArrayAccessor2<double> tempAcc = temp.accessor();
 
+    // Only the cells within maxDistance are updated in the narrow band mode,
+    // and the others are clamped. Both buffers start with the same values so
+    // that the cells outside of the band stay the same after the swaps.
+    std::vector<Point2UI> band;
+    if (isUsingNarrowBand()) {
+        outputSdf->parallelForEachDataPointIndex([&](size_t i, size_t j) {
+            outputAcc(i, j) = clamp(outputAcc(i, j), -maxDistance, maxDistance);
+        });
+        copyRange2(outputAcc, size.x, size.y, &tempAcc);
+
+        band = collectNarrowBand(size, [&](size_t i, size_t j) {
+            return std::fabs(outputAcc(i, j)) < maxDistance;
+        });
+    }
+
     JET_INFO << "Reinitializing with pseudoTimeStep: " << dtau
              << " numberOfIterations: " << numberOfIterations;
 
+    auto update = [&](size_t i, size_t j) {
+        double s = sign(outputAcc, gridSpacing, i, j);
+
+        std::array<double, 2> dx, dy;
+
+        getDerivatives(outputAcc, gridSpacing, i, j, &dx, &dy);
+
+        // Explicit Euler step
+        double val = outputAcc(i, j)
+            - dtau * std::max(s, 0.0)
+                * (std::sqrt(square(std::max(dx[0], 0.0))
+                           + square(std::min(dx[1], 0.0))
+                           + square(std::max(dy[0], 0.0))
+                           + square(std::min(dy[1], 0.0))) - 1.0)
+            - dtau * std::min(s, 0.0)
+                * (std::sqrt(square(std::min(dx[0], 0.0))
+                           + square(std::max(dx[1], 0.0))
+                           + square(std::min(dy[0], 0.0))
+                           + square(std::max(dy[1], 0.0))) - 1.0);
+        tempAcc(i, j) = val;
+    };
+
     for (unsigned int n = 0; n < numberOfIterations; ++n) {
-        inputSdf.parallelForEachDataPointIndex(
-            [&](size_t i, size_t j) {
-                double s = sign(outputAcc, gridSpacing, i, j);
-
-                std::array<double, 2> dx, dy;
-
-                getDerivatives(outputAcc, gridSpacing, i, j, &dx, &dy);
-
-                // Explicit Euler step
-                double val = outputAcc(i, j)
-                    - dtau * std::max(s, 0.0)
-                        * (std::sqrt(square(std::max(dx[0], 0.0))
-                                   + square(std::min(dx[1], 0.0))
-                                   + square(std::max(dy[0], 0.0))
-                                   + square(std::min(dy[1], 0.0))) - 1.0)
-                    - dtau * std::min(s, 0.0)
-                        * (std::sqrt(square(std::min(dx[0], 0.0))
-                                   + square(std::max(dx[1], 0.0))
-                                   + square(std::min(dy[0], 0.0))
-                                   + square(std::max(dy[1], 0.0))) - 1.0);
-                tempAcc(i, j) = val;
+        if (isUsingNarrowBand()) {
+            parallelFor(kZeroSize, band.size(), [&](size_t index) {
+                const Point2UI& pt = band[index];
+                update(pt.x, pt.y);
             });
+        } else {
+            inputSdf.parallelForEachDataPointIndex(update);
+        }
 
         std::swap(tempAcc, outputAcc);
     }
@@ -196,25 +239,43 @@ void IterativeLevelSetSolver2::extrapolate(
     Array2<double> temp(size);
     ArrayAccessor2<double> tempAcc = temp.accessor();
 
+    // Only the cells within maxDistance outside of the interface are updated
+    // in the narrow band mode, and the others keep the input values
+    std::vector<Point2UI> band;
+    if (isUsingNarrowBand()) {
+        copyRange2(input, size.x, size.y, &tempAcc);
+
+        band = collectNarrowBand(size, [&](size_t i, size_t j) {
+            return sdf(i, j) >= 0 && sdf(i, j) < maxDistance;
+        });
+    }
+
+    auto update = [&](size_t i, size_t j) {
+        if (sdf(i, j) >= 0) {
+            std::array<double, 2> dx, dy;
+            Vector2D grad = gradient2(sdf, gridSpacing, i, j);
+
+            getDerivatives(outputAcc, gridSpacing, i, j, &dx, &dy);
+
+            tempAcc(i, j) = outputAcc(i, j)
+                - dtau * (std::max(grad.x, 0.0) * dx[0]
+                        + std::min(grad.x, 0.0) * dx[1]
+                        + std::max(grad.y, 0.0) * dy[0]
+                        + std::min(grad.y, 0.0) * dy[1]);
+        } else {
+            tempAcc(i, j) = outputAcc(i, j);
+        }
+    };
+
     for (unsigned int n = 0; n < numberOfIterations; ++n) {
-        parallelFor(
-            kZeroSize, size.x, kZeroSize, size.y,
-            [&](size_t i, size_t j) {
-                if (sdf(i, j) >= 0) {
-                    std::array<double, 2> dx, dy;
-                    Vector2D grad = gradient2(sdf, gridSpacing, i, j);
-
-                    getDerivatives(outputAcc, gridSpacing, i, j, &dx, &dy);
-
-                    tempAcc(i, j) = outputAcc(i, j)
-                        - dtau * (std::max(grad.x, 0.0) * dx[0]
-                                + std::min(grad.x, 0.0) * dx[1]
-                                + std::max(grad.y, 0.0) * dy[0]
-                                + std::min(grad.y, 0.0) * dy[1]);
-                } else {
-                    tempAcc(i, j) = outputAcc(i, j);
-                }
-          });
+        if (isUsingNarrowBand()) {
+            parallelFor(kZeroSize, band.size(), [&](size_t index) {
+                const Point2UI& pt = band[index];
+                update(pt.x, pt.y);
+            });
+        } else {
+            parallelFor(kZeroSize, size.x, kZeroSize, size.y, update);
+        }
 
         std::swap(tempAcc, outputAcc);
     }
@@ -7,11 +7,69 @@
 #include <jet/parallel.h>
 
 #include <algorithm>
+#include <functional>
 #include <limits>
 #include <utility>  // just make cpplint happy..
+#include <vector>
 
 using namespace jet;
 
+namespace {
+
+std::vector<Point3UI> collectNarrowBand(
+    const Size3& size,
+    const std::function<bool(size_t, size_t, size_t)>& isInBand) {
+    std::vector<Point3UI> band;
+    for (size_t k = 0; k < size.z; ++k) {
+        for (size_t j = 0; j < size.y; ++j) {
+            for (size_t i = 0; i < size.x; ++i) {
+                if (isInBand(i, j, k)) {
+                    band.push_back(Point3UI(i, j, k));
+                }
+            }
+        }
+    }
+    return band;
+}
+
+// Run of the grid points from (begin, j, k) to (end - 1, j, k)
+struct GridLine {
+    size_t begin;
+    size_t end;
+    size_t j;
+    size_t k;
+};
+
+std::vector<GridLine> collectGridLines(
+    const Size3& size,
+    const std::function<bool(size_t, size_t, size_t)>& isInBand) {
+    std::vector<GridLine> lines;
+    for (size_t k = 0; k < size.z; ++k) {
+        for (size_t j = 0; j < size.y; ++j) {
+            size_t i = 0;
+            while (i < size.x) {
+                if (!isInBand(i, j, k)) {
+                    ++i;
+                    continue;
+                }
+
+                GridLine line;
+                line.begin = i;
+                line.j = j;
+                line.k = k;
+                while (i < size.x && isInBand(i, j, k)) {
+                    ++i;
+                }
+                line.end = i;
+                lines.push_back(line);
+            }
+        }
+    }
+    return lines;
+}
+
+}  // namespace
+
 IterativeLevelSetSolver3::IterativeLevelSetSolver3() {
 }
 
@@ -40,42 +98,95 @@ void IterativeLevelSetSolver3::reinitialize(
     Array3<double> temp(size);
     ArrayAccessor3<double> tempAcc = temp.accessor();
 
+    // Only the cells within maxDistance are updated in the narrow band mode,
+    // and the others are clamped. Both buffers start with the same values so
+    // that the cells outside of the band stay the same after the swaps.
+    std::vector<GridLine> lines;
+    if (isUsingNarrowBand()) {
+        outputSdf->parallelForEachDataPointIndex(
+            [&](size_t i, size_t j, size_t k) {
+                outputAcc(i, j, k)
+                    = clamp(outputAcc(i, j, k), -maxDistance, maxDistance);
+            });
+        copyRange3(outputAcc, size.x, size.y, size.z, &tempAcc);
+
+        lines = collectGridLines(size, [&](size_t i, size_t j, size_t k) {
+            return std::fabs(outputAcc(i, j, k)) < maxDistance;
+        });
+    } else {
+        lines = collectGridLines(size, [](size_t, size_t, size_t) {
+            return true;
+        });
+    }
+
     JET_INFO << "Reinitializing with pseudoTimeStep: " << dtau
              << " numberOfIterations: " << numberOfIterations;
 
-    for (unsigned int n = 0; n < numberOfIterations; ++n) {
-        inputSdf.parallelForEachDataPointIndex(
-            [&](size_t i, size_t j, size_t k) {
-                double s = sign(outputAcc, gridSpacing, i, j, k);
+    // Updates the lines from begin to end - 1 and returns the max change
+    auto update = [&](size_t begin, size_t end, double maxChange) {
+        std::vector<std::array<double, 2>> dx(size.x), dy(size.x), dz(size.x);
+
+        for (size_t l = begin; l < end; ++l) {
+            const GridLine& line = lines[l];
+            const size_t j = line.j;
+            const size_t k = line.k;
 
-                std::array<double, 2> dx, dy, dz;
+            getDerivativesAlongX(
+                outputAcc, gridSpacing, line.begin, line.end, j, k,
+                dx.data(), dy.data(), dz.data());
 
-                getDerivatives(outputAcc, gridSpacing, i, j, k, &dx, &dy, &dz);
+            for (size_t i = line.begin; i < line.end; ++i) {
+                const size_t n = i - line.begin;
+                double s = sign(outputAcc, gridSpacing, i, j, k);
 
                 // Explicit Euler step
                 double val = outputAcc(i, j, k)
                     - dtau * std::max(s, 0.0)
-                        * (std::sqrt(square(std::max(dx[0], 0.0))
-                                   + square(std::min(dx[1], 0.0))
-                                   + square(std::max(dy[0], 0.0))
-                                   + square(std::min(dy[1], 0.0))
-                                   + square(std::max(dz[0], 0.0))
-                                   + square(std::min(dz[1], 0.0))) - 1.0)
+                        * (std::sqrt(square(std::max(dx[n][0], 0.0))
+                                   + square(std::min(dx[n][1], 0.0))
+                                   + square(std::max(dy[n][0], 0.0))
+                                   + square(std::min(dy[n][1], 0.0))
+                                   + square(std::max(dz[n][0], 0.0))
+                                   + square(std::min(dz[n][1], 0.0))) - 1.0)
                     - dtau * std::min(s, 0.0)
-                        * (std::sqrt(square(std::min(dx[0], 0.0))
-                                   + square(std::max(dx[1], 0.0))
-                                   + square(std::min(dy[0], 0.0))
-                                   + square(std::max(dy[1], 0.0))
-                                   + square(std::min(dz[0], 0.0))
-                                   + square(std::max(dz[1], 0.0))) - 1.0);
+                        * (std::sqrt(square(std::min(dx[n][0], 0.0))
+                                   + square(std::max(dx[n][1], 0.0))
+                                   + square(std::min(dy[n][0], 0.0))
+                                   + square(std::max(dy[n][1], 0.0))
+                                   + square(std::min(dz[n][0], 0.0))
+                                   + square(std::max(dz[n][1], 0.0))) - 1.0);
+                maxChange = std::max(
+                    maxChange, std::fabs(val - outputAcc(i, j, k)));
                 tempAcc(i, j, k) = val;
-            });
+            }
+        }
+
+        return maxChange;
+    };
+
+    // The change per step is dtau times the residual of the Eikonal equation
+    // scaled by the sign function, so it is compared against the tolerance
+    // scaled by dtau.
+    const double minChange = _reinitializationTolerance * dtau;
+
+    for (unsigned int n = 0; n < numberOfIterations; ++n) {
+        double maxChange = parallelReduce(
+            kZeroSize, lines.size(), 0.0, update,
+            [](double a, double b) { return std::max(a, b); });
 
         std::swap(tempAcc, outputAcc);
+
+        if (maxChange <= minChange) {
+            JET_INFO << "Reinitialization converged after " << n + 1
+                     << " iterations with max change: " << maxChange;
+            break;
+        }
     }
 
     auto outputSdfAcc = outputSdf->dataAccessor();
-    copyRange3(outputAcc, size.x, size.y, size.z, &outputSdfAcc);
+    if (outputAcc.data() != outputSdfAcc.data()) {
+        copyRange3(outputAcc, size.x, size.y, size.z, &outputSdfAcc);
+    }
 }
 
 void IterativeLevelSetSolver3::extrapolate(
@@ -226,28 +337,48 @@ void IterativeLevelSetSolver3::extrapolate(
     Array3<double> temp(size);
     ArrayAccessor3<double> tempAcc = temp.accessor();
 
+    // Only the cells within maxDistance outside of the interface are updated
+    // in the narrow band mode, and the others keep the input values
+    std::vector<Point3UI> band;
+    if (isUsingNarrowBand()) {
+        copyRange3(input, size.x, size.y, size.z, &tempAcc);
+
+        band = collectNarrowBand(size, [&](size_t i, size_t j, size_t k) {
+            return sdf(i, j, k) >= 0 && sdf(i, j, k) < maxDistance;
+        });
+    }
+
+    auto update = [&](size_t i, size_t j, size_t k) {
+        if (sdf(i, j, k) >= 0) {
+            std::array<double, 2> dx, dy, dz;
+            Vector3D grad = gradient3(sdf, gridSpacing, i, j, k);
+
+            getDerivatives(
+                outputAcc, gridSpacing, i, j, k, &dx, &dy, &dz);
+
+            tempAcc(i, j, k) = outputAcc(i, j, k)
+                - dtau * (std::max(grad.x, 0.0) * dx[0]
+                        + std::min(grad.x, 0.0) * dx[1]
+                        + std::max(grad.y, 0.0) * dy[0]
+                        + std::min(grad.y, 0.0) * dy[1]
+                        + std::max(grad.z, 0.0) * dz[0]
+                        + std::min(grad.z, 0.0) * dz[1]);
+        } else {
+            tempAcc(i, j, k) = outputAcc(i, j, k);
+        }
+    };
+
     for (unsigned int n = 0; n < numberOfIterations; ++n) {
-        parallelFor(
-            kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
-            [&](size_t i, size_t j, size_t k) {
-                if (sdf(i, j, k) >= 0) {
-                    std::array<double, 2> dx, dy, dz;
-                    Vector3D grad = gradient3(sdf, gridSpacing, i, j, k);
-
-                    getDerivatives(
-                        outputAcc, gridSpacing, i, j, k, &dx, &dy, &dz);
-
-                    tempAcc(i, j, k) = outputAcc(i, j, k)
-                        - dtau * (std::max(grad.x, 0.0) * dx[0]
-                                + std::min(grad.x, 0.0) * dx[1]
-                                + std::max(grad.y, 0.0) * dy[0]
-                                + std::min(grad.y, 0.0) * dy[1]
-                                + std::max(grad.z, 0.0) * dz[0]
-                                + std::min(grad.z, 0.0) * dz[1]);
-                } else {
-                    tempAcc(i, j, k) = outputAcc(i, j, k);
-                }
-          });
+        if (isUsingNarrowBand()) {
+            parallelFor(kZeroSize, band.size(), [&](size_t index) {
+                const Point3UI& pt = band[index];
+                update(pt.x, pt.y, pt.z);
+            });
+        } else {
+            parallelFor(
+                kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
+                update);
+        }
 
         std::swap(tempAcc, outputAcc);
     }
@@ -255,6 +386,22 @@ void IterativeLevelSetSolver3::extrapolate(
     copyRange3(outputAcc, size.x, size.y, size.z, &output);
 }
 
+void IterativeLevelSetSolver3::getDerivativesAlongX(
+    ConstArrayAccessor3<double> grid,
+    const Vector3D& gridSpacing,
+    size_t iBegin,
+    size_t iEnd,
+    size_t j,
+    size_t k,
+    std::array<double, 2>* dx,
+    std::array<double, 2>* dy,
+    std::array<double, 2>* dz) const {
+    for (size_t i = iBegin; i < iEnd; ++i) {
+        const size_t n = i - iBegin;
+        getDerivatives(grid, gridSpacing, i, j, k, &dx[n], &dy[n], &dz[n]);
+    }
+}
+
 double IterativeLevelSetSolver3::maxCfl() const {
     return _maxCfl;
 }
@@ -263,6 +410,15 @@ void IterativeLevelSetSolver3::setMaxCfl(double newMaxCfl) {
     _maxCfl = std::max(newMaxCfl, 0.0);
 }
 
+double IterativeLevelSetSolver3::reinitializationTolerance() const {
+    return _reinitializationTolerance;
+}
+
+void IterativeLevelSetSolver3::setReinitializationTolerance(
+    double newTolerance) {
+    _reinitializationTolerance = std::max(newTolerance, 0.0);
+}
+
 unsigned int IterativeLevelSetSolver3::distanceToNumberOfIterations(
     double distance,
     double dtau) {
@@ -6,12 +6,59 @@
 #include <jet/fmm_level_set_solver3.h>
 #include <jet/level_set_liquid_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
 #include <jet/timer.h>
+#include <grid_copy_helpers.h>
+#include <serialization_helpers.h>
 
 #include <algorithm>
+#include <cstdint>
 
 using namespace jet;
 
+namespace {
+
+// Shifts the SDF by shift, if nonzero, and returns the liquid volumes of the
+// result (x) and of the result shifted by a cell (y), whose difference is the
+// derivative of the volume with respect to the front shift. All is done in a
+// single parallel pass over the grid.
+Vector2D integrateVolumes(ScalarGrid3* sdf, double shift) {
+    const Size3 size = sdf->dataSize();
+    const Vector3D gridSpacing = sdf->gridSpacing();
+    const double cellVolume = gridSpacing.x * gridSpacing.y * gridSpacing.z;
+    const double h = max3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
+    auto phi = sdf->dataAccessor();
+
+    Vector2D volumes = parallelReduce(
+        kZeroSize,
+        size.z,
+        Vector2D(),
+        [&](size_t kBegin, size_t kEnd, Vector2D partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    for (size_t i = 0; i < size.x; ++i) {
+                        if (shift != 0.0) {
+                            phi(i, j, k) += shift;
+                        }
+
+                        double phiOverH = phi(i, j, k) / h;
+                        partial.x += 1.0 - smearedHeavisideSdf(phiOverH);
+                        partial.y
+                            += 1.0 - smearedHeavisideSdf(phiOverH + 1.0);
+                    }
+                }
+            }
+            return partial;
+        },
+        [](const Vector2D& a, const Vector2D& b) {
+            return a + b;
+        });
+
+    return cellVolume * volumes;
+}
+
+}  // namespace
+
 LevelSetLiquidSolver3::LevelSetLiquidSolver3() {
     auto grids = gridSystemData();
     _signedDistanceFieldId = grids->addAdvectableScalarData(
@@ -44,18 +91,30 @@ void LevelSetLiquidSolver3::setIsGlobalCompensationEnabled(bool isEnabled) {
 }
 
 double LevelSetLiquidSolver3::computeVolume() const {
-    auto sdf = signedDistanceField();
-    const Vector3D gridSpacing = sdf->gridSpacing();
-    const double cellVolume = gridSpacing.x * gridSpacing.y * gridSpacing.z;
-    const double h = max3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
+    return integrateVolumes(signedDistanceField().get(), 0.0).x;
+}
 
-    double volume = 0.0;
-    sdf->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-        volume += 1.0 - smearedHeavisideSdf((*sdf)(i, j, k) / h);
-    });
-    volume *= cellVolume;
+void LevelSetLiquidSolver3::serialize(std::ostream* strm) const {
+    GridFluidSolver3::serialize(strm);
+
+    serializeSectionTag(strm, "LevelSetLiquidSolver3");
+    uint8_t isGlobalCompensationEnabled = _isGlobalCompensationEnabled ? 1 : 0;
+    serializeValue(strm, _minReinitializeDistance);
+    serializeValue(strm, isGlobalCompensationEnabled);
+    serializeValue(strm, _lastKnownVolume);
+}
 
-    return volume;
+void LevelSetLiquidSolver3::deserialize(std::istream* strm) {
+    GridFluidSolver3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(
+        !deserializeSectionTag(strm, "LevelSetLiquidSolver3"));
+    uint8_t isGlobalCompensationEnabled = 0;
+    deserializeValue(strm, &_minReinitializeDistance);
+    deserializeValue(strm, &isGlobalCompensationEnabled);
+    deserializeValue(strm, &_lastKnownVolume);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    _isGlobalCompensationEnabled = (isGlobalCompensationEnabled != 0);
 }
 
 void LevelSetLiquidSolver3::onBeginAdvanceTimeStep(
@@ -67,7 +126,7 @@ void LevelSetLiquidSolver3::onBeginAdvanceTimeStep(
 }
 
 void LevelSetLiquidSolver3::onEndAdvanceTimeStep(double timeIntervalInSeconds) {
-    double currentCfl = cfl(timeIntervalInSeconds);
+    double currentCfl = estimatedCfl(timeIntervalInSeconds);
 
     Timer timer;
     reinitialize(currentCfl);
@@ -79,17 +138,16 @@ void LevelSetLiquidSolver3::onEndAdvanceTimeStep(double timeIntervalInSeconds) {
     JET_INFO << "velocity extrapolation took "
              << timer.durationInSeconds() << " seconds";
 
-    // Measure current volume
-    double currentVol = computeVolume();
+    // Measure current volume and its derivative in the same pass
+    const Vector2D volumes = integrateVolumes(signedDistanceField().get(), 0.0);
+    double currentVol = volumes.x;
     double volDiff = currentVol - _lastKnownVolume;
 
     JET_INFO << "Current volume: " << currentVol << " "
              << "Volume diff: " << volDiff;
 
     if (_isGlobalCompensationEnabled) {
-        addVolume(-volDiff);
-
-        currentVol = computeVolume();
+        currentVol = addVolume(-volDiff, volumes);
         JET_INFO << "Volume after global compensation: " << currentVol;
     }
 }
@@ -101,7 +159,9 @@ ScalarField3Ptr LevelSetLiquidSolver3::fluidSdf() const {
 void LevelSetLiquidSolver3::reinitialize(double currentCfl) {
     if (_levelSetSolver != nullptr) {
         auto sdf = signedDistanceField();
-        auto sdf0 = sdf->clone();
+        auto sdf0 = gridSystemData()->advectableScalarDataBackBufferAt(
+            _signedDistanceFieldId);
+        copyGrid(*sdf, sdf0.get());
 
         const Vector3D gridSpacing = sdf->gridSpacing();
         const double h = max3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
@@ -125,9 +185,11 @@ void LevelSetLiquidSolver3::extrapolateVelocityToAir(double currentCfl) {
     auto vPos = vel->vPosition();
     auto wPos = vel->wPosition();
 
-    Array3<char> uMarker(u.size());
-    Array3<char> vMarker(v.size());
-    Array3<char> wMarker(w.size());
+    _scratch.reset();
+
+    auto uMarker = _scratch.array3<char>(u.size());
+    auto vMarker = _scratch.array3<char>(v.size());
+    auto wMarker = _scratch.array3<char>(w.size());
 
     uMarker.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
         if (isInsideSdf(sdf->sample(uPos(i, j, k)))) {
@@ -163,34 +225,26 @@ void LevelSetLiquidSolver3::extrapolateVelocityToAir(double currentCfl) {
 
     JET_INFO << "Max velocity extrapolation distance: " << maxDist;
 
-    FmmLevelSetSolver3 fmmSolver;
-    fmmSolver.extrapolate(*vel, *sdf, maxDist, vel.get());
+    _velocityExtrapolationSolver.extrapolate(*vel, *sdf, maxDist, vel.get());
 
     applyBoundaryCondition();
 }
 
-void LevelSetLiquidSolver3::addVolume(double volDiff) {
+double LevelSetLiquidSolver3::addVolume(
+    double volDiff,
+    const Vector2D& volumes) {
     auto sdf = signedDistanceField();
     const Vector3D gridSpacing = sdf->gridSpacing();
-    const double cellVolume = gridSpacing.x * gridSpacing.y * gridSpacing.z;
     const double h = max3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
 
-    double volume0 = 0.0;
-    double volume1 = 0.0;
-    sdf->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-        volume0 += 1.0 - smearedHeavisideSdf((*sdf)(i, j, k) / h);
-        volume1 += 1.0 - smearedHeavisideSdf((*sdf)(i, j, k) / h + 1.0);
-    });
-    volume0 *= cellVolume;
-    volume1 *= cellVolume;
-
-    const double dVdh = (volume1 - volume0) / h;
+    const double dVdh = (volumes.y - volumes.x) / h;
 
     if (std::abs(dVdh) > 0.0) {
         double dist = volDiff / dVdh;
 
-        sdf->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-            (*sdf)(i, j, k) += dist;
-        });
+        // Shifts the front and measures the new volume in the same pass
+        return integrateVolumes(sdf.get(), dist).x;
     }
+
+    return volumes.x;
 }
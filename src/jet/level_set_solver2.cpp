@@ -8,3 +8,11 @@ using namespace jet;
 LevelSetSolver2::LevelSetSolver2() {}
 
 LevelSetSolver2::~LevelSetSolver2() {}
+
+bool LevelSetSolver2::isUsingNarrowBand() const {
+    return _isUsingNarrowBand;
+}
+
+void LevelSetSolver2::setIsUsingNarrowBand(bool isUsing) {
+    _isUsingNarrowBand = isUsing;
+}
@@ -8,3 +8,11 @@ using namespace jet;
 LevelSetSolver3::LevelSetSolver3() {}
 
 LevelSetSolver3::~LevelSetSolver3() {}
+
+bool LevelSetSolver3::isUsingNarrowBand() const {
+    return _isUsingNarrowBand;
+}
+
+void LevelSetSolver3::setIsUsingNarrowBand(bool isUsing) {
+    _isUsingNarrowBand = isUsing;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_LEVEL_SET_STENCIL_HELPERS_H_
+#define SRC_JET_LEVEL_SET_STENCIL_HELPERS_H_
+
+#include <jet/array_accessor3.h>
+#include <jet/pde.h>
+#include <jet/vector3.h>
+#include <algorithm>
+#include <array>
+
+namespace jet {
+
+// Stencil policies for getDerivativesAlongX below. Each one differences
+// 2 * kHalfWidth + 1 samples centered at the point of interest.
+struct Upwind1Stencil {
+    static const size_t kHalfWidth = 1;
+
+    static std::array<double, 2> derivatives(double* D0, double h) {
+        return upwind1(D0, h);
+    }
+};
+
+struct Eno3Stencil {
+    static const size_t kHalfWidth = 3;
+
+    static std::array<double, 2> derivatives(double* D0, double h) {
+        return eno3(D0, h);
+    }
+};
+
+// Computes the one-sided derivatives of the points from (iBegin, j, k) to
+// (iEnd - 1, j, k) into dx, dy, and dz, which hold iEnd - iBegin entries.
+// The samples along x slide through a window with a single new load per
+// point, and the clamped rows along y and z are resolved once per line. The
+// stencil samples are the same as the per-point clamped stencils, so are the
+// results.
+template <typename Stencil>
+void getDerivativesAlongX(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSpacing,
+    size_t iBegin,
+    size_t iEnd,
+    size_t j,
+    size_t k,
+    std::array<double, 2>* dx,
+    std::array<double, 2>* dy,
+    std::array<double, 2>* dz) {
+    const size_t w = Stencil::kHalfWidth;
+    const size_t n = 2 * w + 1;
+    const Size3 size = grid.size();
+
+    auto clampedIndex = [](size_t c, size_t m, size_t last) {
+        return (c + m < w) ? 0 : std::min(c + m - w, last);
+    };
+
+    const double* yRows[n];
+    const double* zRows[n];
+    for (size_t m = 0; m < n; ++m) {
+        yRows[m] = &grid(0, clampedIndex(j, m, size.y - 1), k);
+        zRows[m] = &grid(0, j, clampedIndex(k, m, size.z - 1));
+    }
+
+    const double* row = &grid(0, j, k);
+    double D0[n];
+    for (size_t m = 0; m < n; ++m) {
+        D0[m] = row[clampedIndex(iBegin, m, size.x - 1)];
+    }
+
+    for (size_t i = iBegin; i < iEnd; ++i) {
+        const size_t l = i - iBegin;
+
+        dx[l] = Stencil::derivatives(D0, gridSpacing.x);
+        for (size_t m = 0; m + 1 < n; ++m) {
+            D0[m] = D0[m + 1];
+        }
+        D0[n - 1] = row[std::min(i + 1 + w, size.x - 1)];
+
+        double D1[n];
+        for (size_t m = 0; m < n; ++m) {
+            D1[m] = yRows[m][i];
+        }
+        dy[l] = Stencil::derivatives(D1, gridSpacing.y);
+
+        for (size_t m = 0; m < n; ++m) {
+            D1[m] = zRows[m][i];
+        }
+        dz[l] = Stencil::derivatives(D1, gridSpacing.z);
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_LEVEL_SET_STENCIL_HELPERS_H_
@@ -5,21 +5,109 @@
 #include <jet/macros.h>
 
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 
 namespace jet {
 
-static std::mutex critical;
+namespace {
 
-static std::ostream* infoOutStream = &std::cout;
-static std::ostream* warnOutStream = &std::cout;
-static std::ostream* errorOutStream = &std::cerr;
-static std::ostream* debugOutStream = &std::cout;
+typedef std::chrono::steady_clock Clock;
+
+const size_t kRingBufferCapacity = 1024;
+const std::chrono::milliseconds kFlushInterval(10);
+
+struct LogMessage {
+    LoggingLevel level = LoggingLevel::Info;
+    std::string text;
+};
+
+//
+// Bounded multi-producer ring buffer after Dmitry Vyukov's MPMC queue. Each
+// cell has a sequence number which tells the producers and the consumers
+// whose turn it is, so pushing only takes a compare-and-swap on the enqueue
+// position. The consumers are serialized by the caller.
+//
+class LogRingBuffer {
+ public:
+    LogRingBuffer() : _cells(new Cell[kRingBufferCapacity]) {
+        for (size_t i = 0; i < kRingBufferCapacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(LogMessage* message) {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = _cells[pos & (kRingBufferCapacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == pos) {
+                if (_enqueuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.message = std::move(*message);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < pos) {
+                // The cell still holds a message from the previous round
+                return false;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(LogMessage* message) {
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = _cells[pos & (kRingBufferCapacity - 1)];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != pos + 1) {
+            return false;
+        }
+
+        _dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        *message = std::move(cell.message);
+        cell.sequence.store(
+            pos + kRingBufferCapacity, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return _enqueuePos.load(std::memory_order_relaxed)
+            - _dequeuePos.load(std::memory_order_relaxed);
+    }
+
+ private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogMessage message;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    std::atomic<size_t> _enqueuePos{0};
+    std::atomic<size_t> _dequeuePos{0};
+};
+
+std::ostream* infoOutStream = &std::cout;
+std::ostream* warnOutStream = &std::cout;
+std::ostream* errorOutStream = &std::cerr;
+std::ostream* debugOutStream = &std::cout;
+
+std::atomic<bool> sIsAsynchronous(true);
+
+// Set once the writer is destroyed at exit, after which the messages are
+// written directly
+std::atomic<bool> sIsShutDown(false);
 
 inline std::ostream* levelToStream(LoggingLevel level) {
     switch (level) {
@@ -35,7 +123,7 @@ inline std::ostream* levelToStream(LoggingLevel level) {
     return nullptr;
 }
 
-inline std::string levelToString(LoggingLevel level) {
+inline const char* levelToString(LoggingLevel level) {
     switch (level) {
         case LoggingLevel::Info:
             return "INFO";
@@ -46,45 +134,164 @@ inline std::string levelToString(LoggingLevel level) {
         case LoggingLevel::Debug:
             return "DEBUG";
     }
-    return nullptr;
+    return "";
 }
 
+inline bool isWritten(LoggingLevel level) {
+#ifdef JET_DEBUG_MODE
+    return level != LoggingLevel::Debug;
+#else
+    UNUSED_VARIABLE(level);
+    return true;
+#endif
+}
+
+//
+// Owns the ring buffer and the background thread. The streams are only
+// touched while holding the mutex, by the background thread, by a producer
+// draining a full buffer, or by the functions of Logging.
+//
+class LogWriter {
+ public:
+    static LogWriter& instance() {
+        static LogWriter writer;
+        return writer;
+    }
+
+    ~LogWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            _isStopping = true;
+        }
+        _wakeUp.notify_one();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+
+        sIsShutDown = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        drain();
+    }
+
+    void push(LogMessage* message) {
+        std::call_once(_threadStarted, [this] {
+            _thread = std::thread([this] { run(); });
+        });
+
+        bool isError = message->level == LoggingLevel::Error;
+        while (!_ringBuffer.tryPush(message)) {
+            // Write the pending messages on this thread rather than dropping
+            // the message, which also keeps the order
+            std::lock_guard<std::mutex> lock(mutex);
+            drain();
+        }
+
+        if (isError) {
+            std::lock_guard<std::mutex> lock(mutex);
+            drain();
+        } else if (_ringBuffer.size() > kRingBufferCapacity / 2) {
+            _wakeUp.notify_one();
+        }
+    }
+
+    // Writes all the queued messages, assuming the mutex is locked
+    void drain() {
+        std::ostream* lastStream = nullptr;
+        LogMessage message;
+        while (_ringBuffer.tryPop(&message)) {
+            std::ostream* strm = levelToStream(message.level);
+            if (lastStream != nullptr && lastStream != strm) {
+                lastStream->flush();
+            }
+            (*strm) << message.text << '\n';
+            lastStream = strm;
+        }
+        if (lastStream != nullptr) {
+            lastStream->flush();
+        }
+    }
+
+    std::mutex mutex;
+
+ private:
+    LogRingBuffer _ringBuffer;
+    bool _isStopping = false;
+    std::condition_variable _wakeUp;
+    std::once_flag _threadStarted;
+    std::thread _thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!_isStopping) {
+            _wakeUp.wait_for(lock, kFlushInterval);
+            drain();
+        }
+    }
+};
+
+int64_t nowInNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
 
 Logger::Logger(LoggingLevel level)
     : _level(level) {
 }
 
 Logger::~Logger() {
-    std::lock_guard<std::mutex> lock(critical);
-#ifdef JET_DEBUG_MODE
-    if (_level != LoggingLevel::Debug) {
-#endif
-    auto strm = levelToStream(_level);
-    (*strm) << _buffer.str() << std::endl;
-    strm->flush();
-#ifdef JET_DEBUG_MODE
+    if (!isWritten(_level)) {
+        return;
+    }
+
+    LogMessage message;
+    message.level = _level;
+    message.text = _buffer.str();
+
+    if (sIsShutDown) {
+        (*levelToStream(_level)) << message.text << std::endl;
+        return;
+    }
+
+    LogWriter& writer = LogWriter::instance();
+    if (sIsAsynchronous) {
+        writer.push(&message);
+    } else {
+        std::lock_guard<std::mutex> lock(writer.mutex);
+        writer.drain();
+        auto strm = levelToStream(_level);
+        (*strm) << message.text << std::endl;
     }
-#endif
 }
 
 
 void Logging::setInfoStream(std::ostream* strm) {
-    std::lock_guard<std::mutex> lock(critical);
+    LogWriter& writer = LogWriter::instance();
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    writer.drain();
     infoOutStream = strm;
 }
 
 void Logging::setWarnStream(std::ostream* strm) {
-    std::lock_guard<std::mutex> lock(critical);
+    LogWriter& writer = LogWriter::instance();
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    writer.drain();
     warnOutStream = strm;
 }
 
 void Logging::setErrorStream(std::ostream* strm) {
-    std::lock_guard<std::mutex> lock(critical);
+    LogWriter& writer = LogWriter::instance();
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    writer.drain();
     errorOutStream = strm;
 }
 
 void Logging::setDebugStream(std::ostream* strm) {
-    std::lock_guard<std::mutex> lock(critical);
+    LogWriter& writer = LogWriter::instance();
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    writer.drain();
     debugOutStream = strm;
 }
 
@@ -95,23 +302,77 @@ void Logging::setAllStream(std::ostream* strm) {
     setDebugStream(strm);
 }
 
+std::ostream* Logging::stream(LoggingLevel level) {
+    LogWriter& writer = LogWriter::instance();
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    return levelToStream(level);
+}
+
+bool Logging::isAsynchronous() {
+    return sIsAsynchronous;
+}
+
+void Logging::setIsAsynchronous(bool isAsynchronous) {
+    sIsAsynchronous = isAsynchronous;
+    flush();
+}
+
+void Logging::flush() {
+    LogWriter& writer = LogWriter::instance();
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    writer.drain();
+}
+
 std::string Logging::getHeader(LoggingLevel level) {
+    // Formatting the local time is expensive, so each thread formats it only
+    // when the second changes
+    thread_local std::time_t lastTime = 0;
+    thread_local char timeStr[20] = "";
+
     auto now = std::chrono::system_clock::to_time_t(
         std::chrono::system_clock::now());
-    char timeStr[20];
+    if (now != lastTime) {
+        tm time;
 #ifdef JET_WINDOWS
-    tm time;
-    localtime_s(&time, &now);
-    strftime(timeStr, sizeof(timeStr), "%F %T", &time);
+        localtime_s(&time, &now);
 #else
-    strftime(timeStr, sizeof(timeStr), "%F %T", std::localtime(&now));
+        localtime_r(&now, &time);
 #endif
-    char header[256];
-    snprintf(
-        header, sizeof(header), "[%s] %s ",
-        levelToString(level).c_str(),
-        timeStr);
+        strftime(timeStr, sizeof(timeStr), "%F %T", &time);
+        lastTime = now;
+    }
+
+    const char* levelStr = levelToString(level);
+    std::string header;
+    header.reserve(std::strlen(levelStr) + sizeof(timeStr) + 4);
+    header += '[';
+    header += levelStr;
+    header += "] ";
+    header += timeStr;
+    header += ' ';
     return header;
 }
 
+
+bool LogRateLimiter::shouldLogEveryN(size_t n) {
+    size_t count = _count.fetch_add(1, std::memory_order_relaxed);
+    return n <= 1 || count % n == 0;
+}
+
+bool LogRateLimiter::shouldLogEverySeconds(double seconds) {
+    int64_t now = nowInNanoseconds();
+    int64_t interval = static_cast<int64_t>(seconds * 1e9);
+    int64_t last = _lastTimeInNanoseconds.load(std::memory_order_relaxed);
+
+    // Only one of the threads that see the same expired time wins
+    while (last == std::numeric_limits<int64_t>::min()
+           || now - last >= interval) {
+        if (_lastTimeInNanoseconds.compare_exchange_weak(
+                last, now, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 }  // namespace jet
@@ -0,0 +1,10 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/maccormack_advection3.h>
+
+using namespace jet;
+
+MacCormackAdvection3::MacCormackAdvection3() :
+    ErrorCorrectedSemiLagrangian3(Scheme::MacCormack) {
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_MAPPED_FILE_H_
+#define SRC_JET_MAPPED_FILE_H_
+
+#include <jet/macros.h>
+
+#ifndef JET_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+namespace jet {
+
+// Read-only view of a whole file. The file is memory-mapped, and an empty file
+// is a valid view with no data.
+class MappedFile {
+ public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef JET_WINDOWS
+        _file = CreateFileA(
+            filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(_file, &fileSize)) {
+            return;
+        }
+        _size = static_cast<size_t>(fileSize.QuadPart);
+        if (_size == 0) {
+            _isValid = true;
+            return;
+        }
+
+        _mapping = CreateFileMappingA(
+            _file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr) {
+            return;
+        }
+        _data = static_cast<const char*>(
+            MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        _isValid = (_data != nullptr);
+#else
+        _fd = open(filename.c_str(), O_RDONLY);
+        if (_fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if (fstat(_fd, &st) != 0) {
+            return;
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size == 0) {
+            _isValid = true;
+            return;
+        }
+
+        void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (data == MAP_FAILED) {
+            return;
+        }
+        _data = static_cast<const char*>(data);
+        _isValid = true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef JET_WINDOWS
+        if (_data != nullptr) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping != nullptr) {
+            CloseHandle(_mapping);
+        }
+        if (_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(_file);
+        }
+#else
+        if (_data != nullptr) {
+            munmap(const_cast<char*>(_data), _size);
+        }
+        if (_fd >= 0) {
+            close(_fd);
+        }
+#endif
+    }
+
+    JET_NON_COPYABLE(MappedFile)
+
+    bool isValid() const {
+        return _isValid;
+    }
+
+    const char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+ private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+    bool _isValid = false;
+#ifdef JET_WINDOWS
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+}  // namespace jet
+
+#endif  // SRC_JET_MAPPED_FILE_H_
@@ -22,9 +22,16 @@
 #include <jet/bounding_box3.h>
 #include <jet/level_set_utils.h>
 #include <jet/marching_cubes.h>
+#include <jet/parallel.h>
+#include <jet/triangle_mesh_stream_writer3.h>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <functional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace jet {
 
@@ -250,112 +257,290 @@ static void singleSquare(
     }
 }
 
-static void singleCube(
-    const std::array<double, 8>& data,
-    const std::array<size_t, 12>& edgeIds,
-    const std::array<Vector3D, 8>& normals,
-    const BoundingBox3D& bound,
-    MarchingCubeVertexMap* vertexMap,
-    TriangleMesh3* mesh,
-    double isoValue) {
-    int itrVertex, itrEdge, itrTri;
-    int idxFlagSize = 0, idxEdgeFlags = 0;
-    int idxVertexOfTheEdge[2];
-
-    Vector3D pos, pos0, pos1, normal, normal0, normal1;
-    double phi0, phi1;
-    double alpha;
-    Vector3D e[12], n[12];
-
-    // Which vertices are inside? If i-th vertex is inside, mark '1' at i-th
-    // bit. of 'idxFlagSize'.
-    for (itrVertex = 0; itrVertex < 8; itrVertex++) {
-        if (data[itrVertex] <= isoValue) {
-            idxFlagSize |= 1 << itrVertex;
-        }
-    }
-
-    // If the cube is entirely inside or outside of the surface, there is no job
-    // to be done in t1his marching-cube cell.
-    if (idxFlagSize == 0 || idxFlagSize == 255) {
-        return;
+// Interior cubes are processed in slabs of this many cell layers along z.
+static const size_t kSlabDepth = 8;
+
+// Number of slabs per chunk when streaming the interior iso-surface.
+static const size_t kStreamingSlabsPerChunk = 8;
+
+// Axis-aligned grid edges are owned by their lower node, so each node owns up
+// to three edges (+x, +y, and +z). See edgeConnection in marching_cubes_table.h
+// for the local edge ordering. The z offset of each edge's node tells which of
+// the two node planes of the cube layer the edge belongs to.
+static const int kCubeEdgeNodeOffset[12][3] = {
+    {0, 0, 0}, {1, 0, 0}, {0, 0, 1}, {0, 0, 0},
+    {0, 1, 0}, {1, 1, 0}, {0, 1, 1}, {0, 1, 0},
+    {0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}
+};
+static const int kCubeEdgeAxis[12] = {
+    0, 2, 0, 2, 0, 2, 0, 2, 1, 1, 1, 1
+};
+
+inline bool isCrossingEdge(
+    const ConstArrayAccessor3<double>& grid,
+    double isoValue,
+    size_t i,
+    size_t j,
+    size_t k,
+    int axis) {
+    const Size3 dim = grid.size();
+    size_t ip = i + (axis == 0);
+    size_t jp = j + (axis == 1);
+    size_t kp = k + (axis == 2);
+    if (ip >= dim.x || jp >= dim.y || kp >= dim.z) {
+        return false;
     }
+    return (grid(i, j, k) <= isoValue) != (grid(ip, jp, kp) <= isoValue);
+}
 
-    // If there are vertices which is inside the surface...
-    // Which edges intersect the surface? If i-th edge intersects the surface,
-    // mark '1' at i-th bit of 'itrEdgeFlags'
-    idxEdgeFlags = cubeEdgeFlags[idxFlagSize];
+// Computes the iso-surface vertex on the grid edge from node (i, j, k) along
+// axis, interpolating the position and the normal from the gradient.
+inline void edgeVertex(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    double isoValue,
+    size_t i,
+    size_t j,
+    size_t k,
+    int axis,
+    Vector3D* point,
+    Vector3D* normal) {
+    const Vector3D invGridSize = 1.0 / gridSize;
 
-    // Find the point of intersection of the surface with each edge
-    for (itrEdge = 0; itrEdge < 12; itrEdge++) {
-        // If there is an intersection on this edge
-        if (idxEdgeFlags & (1 << itrEdge)) {
-            idxVertexOfTheEdge[0] = edgeConnection[itrEdge][0];
-            idxVertexOfTheEdge[1] = edgeConnection[itrEdge][1];
+    auto pos = [origin, gridSize](size_t i, size_t j, size_t k) {
+        return origin + gridSize * Vector3D({i, j, k});
+    };
 
-            // cube vertex ordering to x-major ordering
-            static int indexMap[8] = {0, 1, 5, 4, 2, 3, 7, 6};
+    size_t ip = i + (axis == 0);
+    size_t jp = j + (axis == 1);
+    size_t kp = k + (axis == 2);
 
-            // Find the phi = 0 position
-            pos0 = bound.corner(indexMap[idxVertexOfTheEdge[0]]);
-            pos1 = bound.corner(indexMap[idxVertexOfTheEdge[1]]);
+    double phi0 = grid(i, j, k) - isoValue;
+    double phi1 = grid(ip, jp, kp) - isoValue;
+    double alpha = distanceToZeroLevelSet(phi0, phi1);
 
-            normal0 = normals[idxVertexOfTheEdge[0]];
-            normal1 = normals[idxVertexOfTheEdge[1]];
+    if (alpha < 0.000001) {
+        alpha = 0.000001;
+    }
+    if (alpha > 0.999999) {
+        alpha = 0.999999;
+    }
 
-            phi0 = data[idxVertexOfTheEdge[0]] - isoValue;
-            phi1 = data[idxVertexOfTheEdge[1]] - isoValue;
+    *point = (1.0 - alpha) * pos(i, j, k) + alpha * pos(ip, jp, kp);
+    *normal = safeNormalize(
+        (1.0 - alpha) * grad(grid, i, j, k, invGridSize)
+        + alpha * grad(grid, ip, jp, kp, invGridSize));
+}
 
-            alpha = distanceToZeroLevelSet(phi0, phi1);
+// Returns the index of the cube at (i, j, k) into triangleConnectionTable3D.
+// If i-th vertex is inside, '1' is marked at i-th bit.
+inline int cubeIndex(
+    const ConstArrayAccessor3<double>& grid,
+    double isoValue,
+    size_t i,
+    size_t j,
+    size_t k) {
+    std::array<double, 8> data;
+    data[0] = grid(i, j, k);
+    data[1] = grid(i + 1, j, k);
+    data[4] = grid(i, j + 1, k);
+    data[5] = grid(i + 1, j + 1, k);
+    data[3] = grid(i, j, k + 1);
+    data[2] = grid(i + 1, j, k + 1);
+    data[7] = grid(i, j + 1, k + 1);
+    data[6] = grid(i + 1, j + 1, k + 1);
+
+    int idxFlagSize = 0;
+    for (int itrVertex = 0; itrVertex < 8; itrVertex++) {
+        if (data[itrVertex] <= isoValue) {
+            idxFlagSize |= 1 << itrVertex;
+        }
+    }
+    return idxFlagSize;
+}
 
-            if (alpha < 0.000001) {
-                alpha = 0.000001;
-            }
-            if (alpha > 0.999999) {
-                alpha = 0.999999;
+// Marches the slabs from chunkBegin to chunkEnd (exclusive) in parallel. Each
+// slab assigns the ids of its planes into dense per-plane edge index arrays in
+// a fixed order, so the plane shared by two slabs gets the same ids from both
+// sides without any stitching. Only the slab which owns the plane writes the
+// vertices. The triangles are concatenated in the cube order, and their
+// indices are relative to the first vertex of the chunk.
+static void marchInteriorChunk(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    double isoValue,
+    const std::vector<size_t>& planeOffsets,
+    size_t chunkBegin,
+    size_t chunkEnd,
+    TriangleMesh3* chunk) {
+    const Size3 dim = grid.size();
+    const size_t planeSize = 3 * dim.x * dim.y;
+    const size_t numberOfLayers = dim.z - 1;
+
+    // The chunk owns the vertices on the first planes of its slabs, and also
+    // the very last plane if it is the last chunk.
+    const size_t kChunkBegin = chunkBegin * kSlabDepth;
+    const size_t kChunkEnd = std::min(chunkEnd * kSlabDepth, numberOfLayers);
+    const size_t firstId = planeOffsets[kChunkBegin];
+    const size_t endId
+        = planeOffsets[(kChunkEnd < numberOfLayers) ? kChunkEnd : dim.z];
+
+    std::vector<Vector3D> points(endId - firstId);
+    std::vector<Vector3D> normals(endId - firstId);
+    std::vector<std::vector<Point3UI>> slabTriangles(chunkEnd - chunkBegin);
+
+    parallelFor(chunkBegin, chunkEnd, kOneSize, [&](size_t slab) {
+        const size_t kBegin = slab * kSlabDepth;
+        const size_t kEnd = std::min(kBegin + kSlabDepth, numberOfLayers);
+
+        std::vector<size_t> lowerIds(planeSize);
+        std::vector<size_t> upperIds(planeSize);
+        std::vector<Point3UI>& triangles = slabTriangles[slab - chunkBegin];
+
+        // Plane k belongs to the slab that starts there, except for the very
+        // last plane which has no slab above it.
+        auto assignIds = [&](size_t k, std::vector<size_t>* ids) {
+            const bool isOwner = (k < kEnd) || (k == dim.z - 1);
+            size_t id = planeOffsets[k];
+            for (size_t j = 0; j < dim.y; ++j) {
+                for (size_t i = 0; i < dim.x; ++i) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        size_t& edgeId = (*ids)[3 * (i + dim.x * j) + axis];
+                        if (!isCrossingEdge(grid, isoValue, i, j, k, axis)) {
+                            edgeId = kMaxSize;
+                            continue;
+                        }
+
+                        edgeId = id++;
+                        if (!isOwner) {
+                            continue;
+                        }
+
+                        edgeVertex(
+                            grid, gridSize, origin, isoValue, i, j, k, axis,
+                            &points[edgeId - firstId],
+                            &normals[edgeId - firstId]);
+                    }
+                }
             }
+        };
+
+        assignIds(kBegin, &lowerIds);
+
+        for (size_t k = kBegin; k < kEnd; ++k) {
+            assignIds(k + 1, &upperIds);
+
+            for (size_t j = 0; j + 1 < dim.y; ++j) {
+                for (size_t i = 0; i + 1 < dim.x; ++i) {
+                    // Which vertices are inside?
+                    int idxFlagSize = cubeIndex(grid, isoValue, i, j, k);
+
+                    // If the cube is entirely inside or outside of the
+                    // surface, there is no job to be done in this cell.
+                    if (idxFlagSize == 0 || idxFlagSize == 255) {
+                        continue;
+                    }
+
+                    const int* table = triangleConnectionTable3D[idxFlagSize];
+
+                    // Make triangles
+                    for (int itrTri = 0; itrTri < 5; ++itrTri) {
+                        const int* tri = &table[3 * itrTri];
+
+                        // If there isn't any triangle to be made, escape this
+                        // loop.
+                        if (tri[0] < 0) {
+                            break;
+                        }
+
+                        Point3UI face;
+                        for (int v = 0; v < 3; ++v) {
+                            const int* offset = kCubeEdgeNodeOffset[tri[v]];
+                            const std::vector<size_t>& ids
+                                = (offset[2] == 0) ? lowerIds : upperIds;
+                            size_t node
+                                = i + offset[0] + dim.x * (j + offset[1]);
+                            face[v]
+                                = ids[3 * node + kCubeEdgeAxis[tri[v]]]
+                                - firstId;
+                        }
+                        triangles.push_back(face);
+                    }
+                }  // i
+            }  // j
 
-            pos = (1.0 - alpha) * pos0 + alpha * pos1;
-            normal = (1.0 - alpha) * normal0 + alpha * normal1;
+            std::swap(lowerIds, upperIds);
+        }  // k
+    });
 
-            e[itrEdge] = pos;
-            n[itrEdge] = normal;
-        }
+    for (size_t v = 0; v < points.size(); ++v) {
+        chunk->addPoint(points[v]);
+        chunk->addNormal(normals[v]);
+        chunk->addUv(Vector2D());
     }
-
-    // Make triangles
-    for (itrTri = 0; itrTri < 5; ++itrTri) {
-        // If there isn't any triangle to be made, escape this loop.
-        if (triangleConnectionTable3D[idxFlagSize][3 * itrTri] < 0) {
-            break;
+    for (const auto& triangles : slabTriangles) {
+        for (const Point3UI& face : triangles) {
+            chunk->addPointNormalUvTriangle(face, face, face);
         }
+    }
+}
 
-        Point3UI face;
+// Builds the interior iso-surface cube by cube, the same way the classic
+// marching cubes does, but without the shared vertex map. Every edge crossing
+// is first counted per node plane, and an exclusive scan of the counts gives
+// each plane the range of vertex ids it owns. The slabs are then marched in
+// chunks of slabsPerChunk slabs, and each chunk is passed to emit.
+static void marchInteriorCubes(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    double isoValue,
+    size_t slabsPerChunk,
+    const std::function<void(TriangleMesh3*)>& emit) {
+    const Size3 dim = grid.size();
+    if (dim.x < 2 || dim.y < 2 || dim.z < 2) {
+        return;
+    }
 
-        for (int j = 0; j < 3; j++) {
-            int k = 3 * itrTri + j;
-            MarchingCubeVertexHashKey vKey
-                = edgeIds[triangleConnectionTable3D[idxFlagSize][k]];
-            MarchingCubeVertexId vId;
-            if (queryVertexId(*vertexMap, vKey, &vId)) {
-                face[j] = vId;
-            } else {
-                // If vertex does not exist from the map
-                face[j] = mesh->numberOfPoints();
-                mesh->addNormal(
-                    safeNormalize(
-                        n[triangleConnectionTable3D[idxFlagSize][k]]));
-                mesh->addPoint(
-                    e[triangleConnectionTable3D[idxFlagSize][k]]);
-                mesh->addUv(Vector2D());
-                vertexMap->insert(std::make_pair(vKey, face[j]));
+    // Count the crossings per node plane and scan them into the offsets
+    std::vector<size_t> planeOffsets(dim.z + 1, 0);
+    parallelFor(kZeroSize, dim.z, [&](size_t k) {
+        size_t count = 0;
+        for (size_t j = 0; j < dim.y; ++j) {
+            for (size_t i = 0; i < dim.x; ++i) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (isCrossingEdge(grid, isoValue, i, j, k, axis)) {
+                        ++count;
+                    }
+                }
             }
         }
-        mesh->addPointNormalUvTriangle(face, face, face);
+        planeOffsets[k + 1] = count;
+    });
+    for (size_t k = 0; k < dim.z; ++k) {
+        planeOffsets[k + 1] += planeOffsets[k];
+    }
+
+    const size_t numberOfLayers = dim.z - 1;
+    const size_t numberOfSlabs
+        = (numberOfLayers + kSlabDepth - 1) / kSlabDepth;
+
+    for (size_t chunkBegin = 0; chunkBegin < numberOfSlabs;
+         chunkBegin += slabsPerChunk) {
+        size_t chunkEnd
+            = chunkBegin + std::min(slabsPerChunk, numberOfSlabs - chunkBegin);
+
+        TriangleMesh3 chunk;
+        marchInteriorChunk(
+            grid, gridSize, origin, isoValue, planeOffsets,
+            chunkBegin, chunkEnd, &chunk);
+        emit(&chunk);
     }
 }
 
-void marchingCubes(
+static void marchBoundarySquares(
     const ConstArrayAccessor3<double>& grid,
     const Vector3D& gridSize,
     const Vector3D& origin,
@@ -365,7 +550,6 @@ void marchingCubes(
     MarchingCubeVertexMap vertexMap;
 
     const Size3 dim = grid.size();
-    const Vector3D invGridSize = 1.0 / gridSize;
 
     auto pos = [origin, gridSize](ssize_t i, ssize_t j, ssize_t k) {
         return origin + gridSize * Vector3D({i, j, k});
@@ -375,53 +559,7 @@ void marchingCubes(
     ssize_t dimy = static_cast<ssize_t>(dim.y);
     ssize_t dimz = static_cast<ssize_t>(dim.z);
 
-    for (ssize_t k = 0; k < dimz - 1; ++k) {
-        for (ssize_t j = 0; j < dimy - 1; ++j) {
-            for (ssize_t i = 0; i < dimx - 1; ++i) {
-                std::array<double, 8> data;
-                std::array<size_t, 12> edgeIds;
-                std::array<Vector3D, 8>  normals;
-                BoundingBox3D bound;
-
-                data[0] = grid(i, j, k);
-                data[1] = grid(i + 1, j, k);
-                data[4] = grid(i, j + 1, k);
-                data[5] = grid(i + 1, j + 1, k);
-                data[3] = grid(i, j, k + 1);
-                data[2] = grid(i + 1, j, k + 1);
-                data[7] = grid(i, j + 1, k + 1);
-                data[6] = grid(i + 1, j + 1, k + 1);
-
-                normals[0] = grad(grid, i, j, k, invGridSize);
-                normals[1] = grad(grid, i + 1, j, k, invGridSize);
-                normals[4] = grad(grid, i, j + 1, k, invGridSize);
-                normals[5] = grad(grid, i + 1, j + 1, k, invGridSize);
-                normals[3] = grad(grid, i, j, k + 1, invGridSize);
-                normals[2] = grad(grid, i + 1, j, k + 1, invGridSize);
-                normals[7] = grad(grid, i, j + 1, k + 1, invGridSize);
-                normals[6] = grad(grid, i + 1, j + 1, k + 1, invGridSize);
-
-                for (int e = 0; e < 12; e++) {
-                    edgeIds[e] = globalEdgeId(i, j, k, dim, e);
-                }
-
-                bound.lowerCorner = pos(i, j, k);
-                bound.upperCorner = pos(i + 1, j + 1, k + 1);
-
-                singleCube(
-                    data,
-                    edgeIds,
-                    normals,
-                    bound,
-                    &vertexMap,
-                    mesh,
-                    isoValue);
-            }  // i
-        }  // j
-    }  // k
-
     // Construct boundaries parallel to x-y plane
-    vertexMap.clear();
     if (bndFlag
         & (kMarchingCubesBoundaryFlagBack | kMarchingCubesBoundaryFlagFront)) {
         for (ssize_t j = 0; j < dimy-1; ++j) {
@@ -667,4 +805,264 @@ void marchingCubes(
     }
 }
 
+// Appends the points, normals, UVs, and triangles of chunk to mesh. The
+// chunk is moved if mesh is empty.
+static void appendTriangleMesh(TriangleMesh3* chunk, TriangleMesh3* mesh) {
+    if (mesh->numberOfPoints() == 0 && mesh->numberOfNormals() == 0
+        && mesh->numberOfUvs() == 0 && mesh->numberOfTriangles() == 0) {
+        mesh->swap(*chunk);
+        return;
+    }
+
+    const size_t pointOffset = mesh->numberOfPoints();
+    for (size_t i = 0; i < chunk->numberOfPoints(); ++i) {
+        mesh->addPoint(chunk->point(i));
+        mesh->addNormal(chunk->normal(i));
+        mesh->addUv(chunk->uv(i));
+    }
+    for (size_t i = 0; i < chunk->numberOfTriangles(); ++i) {
+        Point3UI face = chunk->pointIndex(i).add(pointOffset);
+        mesh->addPointNormalUvTriangle(face, face, face);
+    }
+}
+
+void marchingCubes(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    TriangleMesh3* mesh,
+    double isoValue,
+    int bndFlag) {
+    marchInteriorCubes(
+        grid, gridSize, origin, isoValue, kMaxSize,
+        [mesh](TriangleMesh3* chunk) {
+            appendTriangleMesh(chunk, mesh);
+        });
+
+    marchBoundarySquares(grid, gridSize, origin, mesh, isoValue, bndFlag);
+}
+
+void marchingCubes(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    TriangleMeshStreamWriter3* writer,
+    double isoValue,
+    int bndFlag) {
+    marchInteriorCubes(
+        grid, gridSize, origin, isoValue, kStreamingSlabsPerChunk,
+        [writer](TriangleMesh3* chunk) {
+            writer->write(*chunk);
+        });
+
+    TriangleMesh3 boundary;
+    marchBoundarySquares(
+        grid, gridSize, origin, &boundary, isoValue, bndFlag);
+    writer->write(boundary);
+}
+
+const size_t MarchingCubesTileCache3::kDefaultTileSize;
+
+MarchingCubesTileCache3::MarchingCubesTileCache3(size_t tileSize) :
+    _tileSize(std::max(tileSize, kOneSize)) {
+}
+
+void MarchingCubesTileCache3::update(
+    const ConstArrayAccessor3<double>& grid,
+    const Vector3D& gridSize,
+    const Vector3D& origin,
+    TriangleMesh3* mesh,
+    double isoValue,
+    int bndFlag) {
+    const Size3 dim = grid.size();
+
+    if (_tiles.empty() || dim != _dataSize || gridSize != _gridSize
+        || origin != _origin || isoValue != _isoValue) {
+        _dataSize = dim;
+        _gridSize = gridSize;
+        _origin = origin;
+        _isoValue = isoValue;
+
+        if (dim.x < 2 || dim.y < 2 || dim.z < 2) {
+            _numberOfTiles = Size3();
+        } else {
+            _numberOfTiles = Size3(
+                (dim.x - 2 + _tileSize) / _tileSize,
+                (dim.y - 2 + _tileSize) / _tileSize,
+                (dim.z - 2 + _tileSize) / _tileSize);
+        }
+
+        _tiles.clear();
+        _tiles.resize(
+            _numberOfTiles.x * _numberOfTiles.y * _numberOfTiles.z);
+    }
+
+    // Remesh the tiles whose input changed
+    std::vector<char> isRemeshed(_tiles.size(), 0);
+    parallelFor(kZeroSize, _tiles.size(), kOneSize, [&](size_t t) {
+        size_t ti = t % _numberOfTiles.x;
+        size_t tj = (t / _numberOfTiles.x) % _numberOfTiles.y;
+        size_t tk = t / (_numberOfTiles.x * _numberOfTiles.y);
+
+        // The nodes of the cubes and their neighbors for the gradients
+        size_t i0 = ti * _tileSize;
+        size_t j0 = tj * _tileSize;
+        size_t k0 = tk * _tileSize;
+        size_t i1 = std::min(i0 + _tileSize + 1, dim.x - 1);
+        size_t j1 = std::min(j0 + _tileSize + 1, dim.y - 1);
+        size_t k1 = std::min(k0 + _tileSize + 1, dim.z - 1);
+        i0 = (i0 > 0) ? i0 - 1 : 0;
+        j0 = (j0 > 0) ? j0 - 1 : 0;
+        k0 = (k0 > 0) ? k0 - 1 : 0;
+
+        // FNV-1a over the bits of the values
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t k = k0; k <= k1; ++k) {
+            for (size_t j = j0; j <= j1; ++j) {
+                for (size_t i = i0; i <= i1; ++i) {
+                    double value = grid(i, j, k);
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    hash = (hash ^ bits) * 1099511628211ULL;
+                }
+            }
+        }
+
+        Tile& tile = _tiles[t];
+        if (tile.isValid && tile.hash == hash) {
+            return;
+        }
+
+        marchTile(grid, ti, tj, tk, &tile);
+        tile.hash = hash;
+        tile.isValid = true;
+        isRemeshed[t] = 1;
+    });
+
+    _numberOfRemeshedTiles = static_cast<size_t>(
+        std::count(isRemeshed.begin(), isRemeshed.end(), 1));
+
+    // Stitch the tiles, welding the points on the same grid edge
+    size_t numberOfPoints = 0;
+    for (const Tile& tile : _tiles) {
+        numberOfPoints += tile.points.size();
+    }
+
+    TriangleMesh3 interior;
+    std::unordered_map<size_t, size_t> pointIds;
+    pointIds.reserve(numberOfPoints);
+    std::vector<size_t> localToGlobal;
+
+    for (const Tile& tile : _tiles) {
+        localToGlobal.resize(tile.points.size());
+        for (size_t p = 0; p < tile.points.size(); ++p) {
+            auto result = pointIds.insert(
+                std::make_pair(tile.edgeKeys[p], interior.numberOfPoints()));
+            if (result.second) {
+                interior.addPoint(tile.points[p]);
+                interior.addNormal(tile.normals[p]);
+                interior.addUv(Vector2D());
+            }
+            localToGlobal[p] = result.first->second;
+        }
+
+        for (const Point3UI& triangle : tile.triangles) {
+            Point3UI face(
+                localToGlobal[triangle.x],
+                localToGlobal[triangle.y],
+                localToGlobal[triangle.z]);
+            interior.addPointNormalUvTriangle(face, face, face);
+        }
+    }
+
+    appendTriangleMesh(&interior, mesh);
+
+    marchBoundarySquares(grid, gridSize, origin, mesh, isoValue, bndFlag);
+}
+
+size_t MarchingCubesTileCache3::tileSize() const {
+    return _tileSize;
+}
+
+size_t MarchingCubesTileCache3::numberOfTiles() const {
+    return _tiles.size();
+}
+
+size_t MarchingCubesTileCache3::numberOfRemeshedTiles() const {
+    return _numberOfRemeshedTiles;
+}
+
+void MarchingCubesTileCache3::clear() {
+    _tiles.clear();
+    _numberOfRemeshedTiles = 0;
+}
+
+void MarchingCubesTileCache3::marchTile(
+    const ConstArrayAccessor3<double>& grid,
+    size_t ti,
+    size_t tj,
+    size_t tk,
+    Tile* tile) const {
+    const Size3 dim = grid.size();
+
+    size_t i0 = ti * _tileSize;
+    size_t j0 = tj * _tileSize;
+    size_t k0 = tk * _tileSize;
+    size_t i1 = std::min(i0 + _tileSize, dim.x - 1);
+    size_t j1 = std::min(j0 + _tileSize, dim.y - 1);
+    size_t k1 = std::min(k0 + _tileSize, dim.z - 1);
+
+    tile->edgeKeys.clear();
+    tile->points.clear();
+    tile->normals.clear();
+    tile->triangles.clear();
+
+    std::unordered_map<size_t, size_t> localIds;
+
+    for (size_t k = k0; k < k1; ++k) {
+        for (size_t j = j0; j < j1; ++j) {
+            for (size_t i = i0; i < i1; ++i) {
+                int idxFlagSize = cubeIndex(grid, _isoValue, i, j, k);
+                if (idxFlagSize == 0 || idxFlagSize == 255) {
+                    continue;
+                }
+
+                const int* table = triangleConnectionTable3D[idxFlagSize];
+
+                for (int itrTri = 0; itrTri < 5; ++itrTri) {
+                    const int* tri = &table[3 * itrTri];
+                    if (tri[0] < 0) {
+                        break;
+                    }
+
+                    Point3UI face;
+                    for (int v = 0; v < 3; ++v) {
+                        const int* offset = kCubeEdgeNodeOffset[tri[v]];
+                        int axis = kCubeEdgeAxis[tri[v]];
+                        size_t ni = i + offset[0];
+                        size_t nj = j + offset[1];
+                        size_t nk = k + offset[2];
+                        size_t key = 3 * (ni + dim.x * (nj + dim.y * nk))
+                            + axis;
+
+                        auto result = localIds.insert(
+                            std::make_pair(key, tile->points.size()));
+                        if (result.second) {
+                            Vector3D point, normal;
+                            edgeVertex(
+                                grid, _gridSize, _origin, _isoValue,
+                                ni, nj, nk, axis, &point, &normal);
+                            tile->edgeKeys.push_back(key);
+                            tile->points.push_back(point);
+                            tile->normals.push_back(normal);
+                        }
+                        face[v] = result.first->second;
+                    }
+                    tile->triangles.push_back(face);
+                }
+            }
+        }
+    }
+}
+
 }  // namespace jet
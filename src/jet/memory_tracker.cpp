@@ -0,0 +1,134 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/memory_tracker.h>
+
+#include <atomic>
+#include <iomanip>
+
+namespace jet {
+
+namespace {
+
+// The last slot is the total of all the tags
+const size_t kTotalSlot = kNumberOfMemoryTags;
+
+std::atomic<size_t> sBytes[kNumberOfMemoryTags + 1];
+std::atomic<size_t> sPeakBytes[kNumberOfMemoryTags + 1];
+
+thread_local MemoryTag sCurrentTag = MemoryTag::Other;
+
+void updatePeak(size_t slot, size_t bytes) {
+    size_t peak = sPeakBytes[slot].load(std::memory_order_relaxed);
+    while (bytes > peak
+           && !sPeakBytes[slot].compare_exchange_weak(
+               peak, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+size_t slotOf(MemoryTag tag) {
+    return static_cast<size_t>(tag);
+}
+
+}  // namespace
+
+size_t MemoryTracker::bytes(MemoryTag tag) {
+    return sBytes[slotOf(tag)].load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peakBytes(MemoryTag tag) {
+    return sPeakBytes[slotOf(tag)].load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::totalBytes() {
+    return sBytes[kTotalSlot].load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peakTotalBytes() {
+    return sPeakBytes[kTotalSlot].load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::resetPeakBytes() {
+    for (size_t slot = 0; slot <= kTotalSlot; ++slot) {
+        sPeakBytes[slot].store(
+            sBytes[slot].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    }
+}
+
+MemoryTag MemoryTracker::currentTag() {
+    return sCurrentTag;
+}
+
+const char* MemoryTracker::tagName(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::Other:
+            return "other";
+        case MemoryTag::Grid:
+            return "grid";
+        case MemoryTag::LinearSystem:
+            return "linear_system";
+        case MemoryTag::LinearSolver:
+            return "linear_solver";
+        case MemoryTag::Particle:
+            return "particle";
+        case MemoryTag::NeighborList:
+            return "neighbor_list";
+        case MemoryTag::NeighborSearch:
+            return "neighbor_search";
+        case MemoryTag::Scratch:
+            return "scratch";
+    }
+    return "";
+}
+
+void MemoryTracker::printReport(std::ostream* strm) {
+    const double kMegabyte = 1024.0 * 1024.0;
+    std::ios::fmtflags flags = strm->flags();
+    std::streamsize precision = strm->precision();
+
+    (*strm) << std::left << std::setw(16) << "tag"
+            << std::right << std::setw(14) << "bytes (MB)"
+            << std::setw(14) << "peak (MB)" << '\n';
+    (*strm) << std::fixed << std::setprecision(3);
+    for (size_t slot = 0; slot <= kTotalSlot; ++slot) {
+        const char* name = (slot == kTotalSlot)
+            ? "total" : tagName(static_cast<MemoryTag>(slot));
+        (*strm) << std::left << std::setw(16) << name
+                << std::right << std::setw(14)
+                << sBytes[slot].load(std::memory_order_relaxed) / kMegabyte
+                << std::setw(14)
+                << sPeakBytes[slot].load(std::memory_order_relaxed)
+                    / kMegabyte
+                << '\n';
+    }
+    strm->flags(flags);
+    strm->precision(precision);
+}
+
+void MemoryTracker::onAllocate(MemoryTag tag, size_t bytes) {
+    size_t slot = slotOf(tag);
+    updatePeak(
+        slot,
+        sBytes[slot].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    updatePeak(
+        kTotalSlot,
+        sBytes[kTotalSlot].fetch_add(bytes, std::memory_order_relaxed)
+            + bytes);
+}
+
+void MemoryTracker::onDeallocate(MemoryTag tag, size_t bytes) {
+    sBytes[slotOf(tag)].fetch_sub(bytes, std::memory_order_relaxed);
+    sBytes[kTotalSlot].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag) : _previousTag(sCurrentTag) {
+    sCurrentTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope() {
+    sCurrentTag = _previousTag;
+}
+
+}  // namespace jet
@@ -0,0 +1,81 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/memory_usage.h>
+
+#ifdef JET_WINDOWS
+#   include <windows.h>
+#   include <psapi.h>
+#   pragma comment(lib, "psapi.lib")
+#else
+#   include <sys/resource.h>
+#   include <unistd.h>
+#endif
+
+#ifdef JET_APPLE
+#   include <mach/mach.h>
+#endif
+
+#include <cstdio>
+
+namespace jet {
+
+size_t peakResidentSetSizeInBytes() {
+#ifdef JET_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(
+            GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<size_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef JET_APPLE
+    // Reported in bytes on macOS
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Reported in kilobytes on Linux
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+size_t residentSetSizeInBytes() {
+#if defined(JET_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(
+            GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<size_t>(counters.WorkingSetSize);
+    }
+    return 0;
+#elif defined(JET_APPLE)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(
+            mach_task_self(), MACH_TASK_BASIC_INFO,
+            reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return static_cast<size_t>(info.resident_size);
+#else
+    // The second field of statm is the number of the resident pages
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int numberOfFields = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    if (numberOfFields != 2) {
+        return 0;
+    }
+    return static_cast<size_t>(resident)
+        * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+}  // namespace jet
@@ -0,0 +1,397 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/memory_usage.h>
+#include <jet/metrics_exporter.h>
+
+#ifdef JET_WINDOWS
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#   pragma comment(lib, "ws2_32.lib")
+#else
+#   include <netdb.h>
+#   include <sys/socket.h>
+#   include <sys/types.h>
+#   include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Keeps a StatsD packet within the MTU of the common networks
+const size_t kMaxStatsdPacketSize = 1400;
+
+std::string formatValue(double value) {
+    std::ostringstream strm;
+    strm.precision(15);
+    strm << value;
+    return strm.str();
+}
+
+std::string escapeLabelValue(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// Replaces the characters that StatsD treats as separators
+std::string toStatsdName(const std::string& name) {
+    std::string converted = name;
+    for (char& c : converted) {
+        if (c == '/') {
+            c = '.';
+        } else if (c == ':' || c == '|' || c == '@' || c == ' ') {
+            c = '_';
+        }
+    }
+    return converted;
+}
+
+bool writeFileAtomically(
+    const std::string& filename,
+    const std::string& contents) {
+    std::string temporaryFilename = filename + ".tmp";
+    {
+        std::ofstream file(temporaryFilename.c_str(), std::ofstream::binary);
+        if (!file) {
+            return false;
+        }
+        file << contents;
+        file.close();
+        if (file.fail()) {
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+
+    // Windows does not replace an existing file by renaming
+    if (std::rename(temporaryFilename.c_str(), filename.c_str()) != 0) {
+        std::remove(filename.c_str());
+        if (std::rename(temporaryFilename.c_str(), filename.c_str()) != 0) {
+            std::remove(temporaryFilename.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef JET_WINDOWS
+typedef SOCKET SocketHandle;
+const SocketHandle kInvalidSocket = INVALID_SOCKET;
+
+void closeSocket(SocketHandle socket) {
+    closesocket(socket);
+}
+
+bool initializeSockets() {
+    static bool isInitialized = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return isInitialized;
+}
+#else
+typedef int SocketHandle;
+const SocketHandle kInvalidSocket = -1;
+
+void closeSocket(SocketHandle socket) {
+    close(socket);
+}
+
+bool initializeSockets() {
+    return true;
+}
+#endif
+
+// Sends the lines in as few datagrams as possible without splitting a line
+bool sendUdpLines(
+    const std::string& host,
+    uint16_t port,
+    const std::vector<std::string>& lines) {
+    if (!initializeSockets()) {
+        return false;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* address = nullptr;
+    if (getaddrinfo(
+            host.c_str(), std::to_string(port).c_str(), &hints, &address)
+        != 0) {
+        return false;
+    }
+
+    SocketHandle sock = socket(
+        address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (sock == kInvalidSocket) {
+        freeaddrinfo(address);
+        return false;
+    }
+
+    bool isSent = true;
+    auto send = [&](const std::string& packet) {
+        if (packet.empty()) {
+            return;
+        }
+        int bytes = static_cast<int>(packet.size());
+        isSent &= sendto(
+            sock, packet.data(), bytes, 0, address->ai_addr,
+            static_cast<int>(address->ai_addrlen)) == bytes;
+    };
+
+    std::string packet;
+    for (const std::string& line : lines) {
+        if (!packet.empty()
+            && packet.size() + 1 + line.size() > kMaxStatsdPacketSize) {
+            send(packet);
+            packet.clear();
+        }
+        if (!packet.empty()) {
+            packet += '\n';
+        }
+        packet += line;
+    }
+    send(packet);
+
+    closeSocket(sock);
+    freeaddrinfo(address);
+    return isSent;
+}
+
+}  // namespace
+
+MetricsExporter::MetricsExporter(const std::string& jobName)
+    : _jobName(jobName) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    if (isRunning()) {
+        stop();
+    }
+}
+
+const std::string& MetricsExporter::jobName() const {
+    return _jobName;
+}
+
+void MetricsExporter::record(const PhysicsAnimation& animation) {
+    const FrameStatistics& stats = animation.lastFrameStatistics();
+
+    Snapshot snapshot;
+    snapshot.frameIndex = animation.currentFrame().index;
+    snapshot.frameDurationInSeconds = stats.durationInSeconds;
+    snapshot.numberOfSubTimeSteps = stats.subTimeSteps.size();
+    for (const SubTimeStepStatistics& step : stats.subTimeSteps) {
+        snapshot.numberOfPressureIterations
+            += step.numberOfPressureIterations;
+        snapshot.peakTrackedMemoryInBytes = std::max(
+            snapshot.peakTrackedMemoryInBytes, step.peakTrackedMemoryInBytes);
+    }
+    if (!stats.subTimeSteps.empty()) {
+        const SubTimeStepStatistics& lastStep = stats.subTimeSteps.back();
+        snapshot.numberOfParticles = lastStep.numberOfParticles;
+        snapshot.cfl = lastStep.cfl;
+    }
+    if (Profiler::isEnabled()) {
+        snapshot.stages = Profiler::lastFrameReport();
+    }
+    snapshot.lastFrameTimeInSeconds = _timer.durationInSeconds();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    snapshot.numberOfFrames = _snapshot.numberOfFrames + 1;
+    _snapshot = std::move(snapshot);
+}
+
+std::string MetricsExporter::prometheusText() const {
+    double secondsSinceLastFrame = 0.0;
+    Snapshot s = snapshot(&secondsSinceLastFrame);
+    std::string job = "job=\"" + escapeLabelValue(_jobName) + "\"";
+
+    std::ostringstream strm;
+    auto write = [&](
+        const char* name, const char* help, const char* type, double value) {
+        strm << "# HELP " << name << ' ' << help << '\n'
+             << "# TYPE " << name << ' ' << type << '\n'
+             << name << '{' << job << "} " << formatValue(value) << '\n';
+    };
+
+    write("jet_frame_index", "Index of the last advanced frame.", "gauge",
+          s.frameIndex);
+    write("jet_frames_total", "Number of the recorded frames.", "counter",
+          static_cast<double>(s.numberOfFrames));
+    write("jet_frame_duration_seconds", "Wall-clock time of the last frame.",
+          "gauge", s.frameDurationInSeconds);
+    write("jet_sub_time_steps", "Number of the sub-time-steps of the last "
+          "frame.", "gauge", static_cast<double>(s.numberOfSubTimeSteps));
+    write("jet_pressure_iterations", "Pressure iterations of the last frame.",
+          "gauge", static_cast<double>(s.numberOfPressureIterations));
+    write("jet_particles", "Number of the particles.", "gauge",
+          static_cast<double>(s.numberOfParticles));
+    write("jet_cfl", "CFL number at the end of the last frame.", "gauge",
+          s.cfl);
+    write("jet_tracked_memory_peak_bytes", "Peak tracked memory of the last "
+          "frame.", "gauge", static_cast<double>(s.peakTrackedMemoryInBytes));
+    write("jet_resident_set_size_bytes", "Resident set size of the process.",
+          "gauge", static_cast<double>(residentSetSizeInBytes()));
+    write("jet_seconds_since_last_frame", "Time since the last recorded "
+          "frame.", "gauge", secondsSinceLastFrame);
+
+    if (!s.stages.empty()) {
+        strm << "# HELP jet_stage_duration_seconds Time of the profiled "
+             << "scopes of the last frame.\n"
+             << "# TYPE jet_stage_duration_seconds gauge\n";
+        for (const ProfileReportEntry& stage : s.stages) {
+            strm << "jet_stage_duration_seconds{" << job << ",stage=\""
+                 << escapeLabelValue(stage.path) << "\"} "
+                 << formatValue(stage.totalDurationInSeconds) << '\n';
+        }
+    }
+
+    return strm.str();
+}
+
+std::string MetricsExporter::statsdText() const {
+    double secondsSinceLastFrame = 0.0;
+    Snapshot s = snapshot(&secondsSinceLastFrame);
+
+    std::ostringstream strm;
+    auto write = [&](const std::string& name, double value) {
+        strm << _jobName << '.' << name << ':' << formatValue(value)
+             << "|g\n";
+    };
+
+    write("frame_index", s.frameIndex);
+    write("frames_total", static_cast<double>(s.numberOfFrames));
+    write("frame_duration_seconds", s.frameDurationInSeconds);
+    write("sub_time_steps", static_cast<double>(s.numberOfSubTimeSteps));
+    write("pressure_iterations",
+          static_cast<double>(s.numberOfPressureIterations));
+    write("particles", static_cast<double>(s.numberOfParticles));
+    write("cfl", s.cfl);
+    write("tracked_memory_peak_bytes",
+          static_cast<double>(s.peakTrackedMemoryInBytes));
+    write("resident_set_size_bytes",
+          static_cast<double>(residentSetSizeInBytes()));
+    write("seconds_since_last_frame", secondsSinceLastFrame);
+    for (const ProfileReportEntry& stage : s.stages) {
+        write("stage_duration_seconds." + toStatsdName(stage.path),
+              stage.totalDurationInSeconds);
+    }
+
+    return strm.str();
+}
+
+void MetricsExporter::setPrometheusFile(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _prometheusFile = filename;
+}
+
+void MetricsExporter::setStatsdServer(const std::string& host, uint16_t port) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statsdHost = host;
+    _statsdPort = port;
+}
+
+void MetricsExporter::start(double intervalInSeconds) {
+    JET_THROW_INVALID_ARG_IF(!(intervalInSeconds > 0.0));
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _intervalInSeconds = intervalInSeconds;
+    }
+
+    if (!_thread.joinable()) {
+        _thread = std::thread([this] { run(); });
+    } else {
+        _wakeUp.notify_one();
+    }
+}
+
+void MetricsExporter::stop() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+        }
+        _wakeUp.notify_one();
+        _thread.join();
+        _isStopping = false;
+    }
+
+    exportNow();
+}
+
+bool MetricsExporter::isRunning() const {
+    return _thread.joinable();
+}
+
+bool MetricsExporter::exportNow() {
+    std::string prometheusFile;
+    std::string statsdHost;
+    uint16_t statsdPort;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        prometheusFile = _prometheusFile;
+        statsdHost = _statsdHost;
+        statsdPort = _statsdPort;
+    }
+
+    bool isExported = true;
+    if (!prometheusFile.empty()) {
+        isExported &= writeFileAtomically(prometheusFile, prometheusText());
+    }
+
+    if (!statsdHost.empty()) {
+        std::vector<std::string> lines;
+        std::istringstream strm(statsdText());
+        std::string line;
+        while (std::getline(strm, line)) {
+            lines.push_back(line);
+        }
+        isExported &= sendUdpLines(statsdHost, statsdPort, lines);
+    }
+
+    return isExported;
+}
+
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_isStopping) {
+        lock.unlock();
+        exportNow();
+        lock.lock();
+
+        _wakeUp.wait_for(
+            lock,
+            std::chrono::duration<double>(_intervalInSeconds),
+            [this] { return _isStopping; });
+    }
+}
+
+MetricsExporter::Snapshot MetricsExporter::snapshot(
+    double* secondsSinceLastFrame) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    *secondsSinceLastFrame
+        = _timer.durationInSeconds() - _snapshot.lastFrameTimeInSeconds;
+    return _snapshot;
+}
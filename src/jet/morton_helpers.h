@@ -0,0 +1,51 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_MORTON_HELPERS_H_
+#define SRC_JET_MORTON_HELPERS_H_
+
+#include <jet/bounding_box3.h>
+#include <jet/math_utils.h>
+#include <jet/vector3.h>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace jet {
+
+// Number of Morton grid cells per axis (10 bits per axis, 30 bits per key).
+const size_t kMortonResolution3 = 1024;
+const size_t kMaxMortonKey3 = (static_cast<size_t>(1) << 30) - 1;
+
+// Inserts two zero bits between each of the lower 10 bits of x.
+inline size_t expandMortonBits3(size_t x) {
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+// Returns the scale that maps the longest axis of bound to the Morton grid.
+inline double mortonScale3(const BoundingBox3D& bound) {
+    double maxExtent = max3(bound.width(), bound.height(), bound.depth());
+    return (maxExtent > 0.0) ? kMortonResolution3 / maxExtent : 0.0;
+}
+
+// Returns the Morton key of position within bound, where scale comes from
+// mortonScale3(bound).
+inline size_t mortonKey3(
+    const BoundingBox3D& bound,
+    double scale,
+    const Vector3D& position) {
+    Vector3D p = (position - bound.lowerCorner) * scale;
+    size_t x = std::min(static_cast<size_t>(p.x), kMortonResolution3 - 1);
+    size_t y = std::min(static_cast<size_t>(p.y), kMortonResolution3 - 1);
+    size_t z = std::min(static_cast<size_t>(p.z), kMortonResolution3 - 1);
+    return expandMortonBits3(x) | (expandMortonBits3(y) << 1)
+        | (expandMortonBits3(z) << 2);
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_MORTON_HELPERS_H_
@@ -0,0 +1,74 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_NEIGHBOR_SEARCH_HELPERS_H_
+#define SRC_JET_NEIGHBOR_SEARCH_HELPERS_H_
+
+#include <jet/point_cell_list_searcher3.h>
+#include <jet/point_hash_grid_searcher2.h>
+#include <jet/point_hash_grid_searcher3.h>
+#include <jet/point_parallel_hash_grid_searcher2.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace jet {
+
+// Dispatches to the templated query of the built-in grid searchers so
+// that the callback is inlined into the search loop instead of going through
+// std::function for every candidate point. Other searchers fall back to the
+// virtual interface.
+template <typename Callback>
+inline void forEachNearbyPoint(
+    const PointNeighborSearcher2& searcher,
+    const Vector2D& origin,
+    double radius,
+    const Callback& callback) {
+    if (const auto parallelHashGrid
+        = dynamic_cast<const PointParallelHashGridSearcher2*>(&searcher)) {
+        parallelHashGrid->forEachNearbyPoint(origin, radius, callback);
+    } else if (const auto hashGrid
+        = dynamic_cast<const PointHashGridSearcher2*>(&searcher)) {
+        hashGrid->forEachNearbyPoint(origin, radius, callback);
+    } else {
+        searcher.forEachNearbyPoint(origin, radius, callback);
+    }
+}
+
+template <typename Callback>
+inline void forEachNearbyPoint(
+    const PointNeighborSearcher3& searcher,
+    const Vector3D& origin,
+    double radius,
+    const Callback& callback) {
+    if (const auto parallelHashGrid
+        = dynamic_cast<const PointParallelHashGridSearcher3*>(&searcher)) {
+        parallelHashGrid->forEachNearbyPoint(origin, radius, callback);
+    } else if (const auto cellList
+        = dynamic_cast<const PointCellListSearcher3*>(&searcher)) {
+        cellList->forEachNearbyPoint(origin, radius, callback);
+    } else if (const auto hashGrid
+        = dynamic_cast<const PointHashGridSearcher3*>(&searcher)) {
+        hashGrid->forEachNearbyPoint(origin, radius, callback);
+    } else {
+        searcher.forEachNearbyPoint(origin, radius, callback);
+    }
+}
+
+// Sorts the grid cells of the points in one hash bucket and returns the
+// number of distinct cells, which is more than one if the cells collided.
+inline size_t countDistinctCells(std::vector<Point3I>* cells) {
+    std::sort(
+        cells->begin(),
+        cells->end(),
+        [](const Point3I& a, const Point3I& b) {
+            return (a.x != b.x) ? a.x < b.x
+                : ((a.y != b.y) ? a.y < b.y : a.z < b.z);
+        });
+    return static_cast<size_t>(
+        std::unique(cells->begin(), cells->end()) - cells->begin());
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_NEIGHBOR_SEARCH_HELPERS_H_
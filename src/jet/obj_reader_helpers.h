@@ -0,0 +1,300 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_OBJ_READER_HELPERS_H_
+#define SRC_JET_OBJ_READER_HELPERS_H_
+
+#include <jet/point3.h>
+#include <jet/vector2.h>
+#include <jet/vector3.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace jet {
+
+// Negative (relative) OBJ indices are stored in ObjChunk as the index into the
+// chunk, offset by this value. The index into the chunk itself can be
+// negative if the relative index refers to an earlier chunk.
+static const int64_t kObjRelativeIndexOffset = INT64_C(1) << 62;
+
+// Parsed contents of a line-aligned range of an OBJ file. The point, UV, and
+// normal indices of the triangles are zero-based and absolute unless they are
+// relative ones (see kObjRelativeIndexOffset).
+struct ObjChunk {
+    std::vector<Vector3D> points;
+    std::vector<Vector3D> normals;
+    std::vector<Vector2D> uvs;
+    std::vector<Point3<int64_t>> pointIndices;
+    std::vector<Point3<int64_t>> normalIndices;
+    std::vector<Point3<int64_t>> uvIndices;
+    bool isValid = true;
+};
+
+inline bool isObjSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void skipObjSpaces(const char** p, const char* end) {
+    while (*p < end && isObjSpace(**p)) {
+        ++(*p);
+    }
+}
+
+// Parses a floating-point number. If the significant digits fit in 53 bits
+// and the exponent is small, the number is converted exactly with a single
+// multiplication or division (Clinger's fast path). The rest falls back to
+// strtod.
+inline bool parseObjDouble(const char** p, const char* end, double* value) {
+    static const double kPowersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    skipObjSpaces(p, end);
+
+    const char* begin = *p;
+    const char* q = begin;
+    bool isNegative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+        isNegative = (*q == '-');
+        ++q;
+    }
+
+    // Leading zeros are not counted as the significant digits
+    uint64_t mantissa = 0;
+    int numberOfDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool isTruncated = false;
+    while (q < end && *q >= '0' && *q <= '9') {
+        if (numberOfDigits < 19) {
+            mantissa = 10 * mantissa + static_cast<uint64_t>(*q - '0');
+            numberOfDigits += (mantissa > 0);
+        } else {
+            isTruncated = true;
+        }
+        hasDigits = true;
+        ++q;
+    }
+    if (q < end && *q == '.') {
+        ++q;
+        while (q < end && *q >= '0' && *q <= '9') {
+            if (numberOfDigits < 19) {
+                mantissa = 10 * mantissa + static_cast<uint64_t>(*q - '0');
+                numberOfDigits += (mantissa > 0);
+                --exponent;
+            } else {
+                isTruncated = true;
+            }
+            hasDigits = true;
+            ++q;
+        }
+    }
+    if (hasDigits && q < end && (*q == 'e' || *q == 'E')) {
+        const char* r = q + 1;
+        bool isExponentNegative = false;
+        if (r < end && (*r == '-' || *r == '+')) {
+            isExponentNegative = (*r == '-');
+            ++r;
+        }
+        if (r < end && *r >= '0' && *r <= '9') {
+            int e = 0;
+            while (r < end && *r >= '0' && *r <= '9') {
+                e = (e < 10000) ? 10 * e + (*r - '0') : e;
+                ++r;
+            }
+            exponent += isExponentNegative ? -e : e;
+            q = r;
+        }
+    }
+
+    bool isDelimited = (q == end || isObjSpace(*q) || *q == '\n');
+    if (hasDigits && isDelimited && !isTruncated
+        && mantissa <= (UINT64_C(1) << 53)
+        && exponent >= -22 && exponent <= 22) {
+        double v = static_cast<double>(mantissa);
+        v = (exponent < 0) ? v / kPowersOf10[-exponent]
+                           : v * kPowersOf10[exponent];
+        *value = isNegative ? -v : v;
+        *p = q;
+        return true;
+    }
+
+    // Fall back to strtod with a null-terminated copy of the token
+    const char* tokenEnd = begin;
+    while (tokenEnd < end && !isObjSpace(*tokenEnd) && *tokenEnd != '\n') {
+        ++tokenEnd;
+    }
+    char buffer[128];
+    size_t length = static_cast<size_t>(tokenEnd - begin);
+    if (length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+
+    char* parsedEnd = nullptr;
+    *value = std::strtod(buffer, &parsedEnd);
+    if (parsedEnd != buffer + length) {
+        return false;
+    }
+    *p = tokenEnd;
+    return true;
+}
+
+inline bool parseObjIndex(const char** p, const char* end, int64_t* value) {
+    const char* q = *p;
+    bool isNegative = false;
+    if (q < end && *q == '-') {
+        isNegative = true;
+        ++q;
+    }
+    if (q == end || *q < '0' || *q > '9') {
+        return false;
+    }
+
+    int64_t v = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        v = 10 * v + (*q - '0');
+        ++q;
+    }
+    *value = isNegative ? -v : v;
+    *p = q;
+    return true;
+}
+
+// Converts a one-based absolute or negative relative OBJ index to the encoding
+// of ObjChunk, given the number of the elements in the chunk so far.
+inline bool toObjChunkIndex(int64_t index, size_t count, int64_t* result) {
+    if (index > 0) {
+        *result = index - 1;
+    } else if (index < 0) {
+        *result = static_cast<int64_t>(count) + index - kObjRelativeIndexOffset;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Parses a face line after the "f" and fan-triangulates the polygon.
+inline bool parseObjFace(const char* p, const char* end, ObjChunk* chunk) {
+    size_t numberOfVertices = 0;
+    bool hasUvs = false;
+    bool hasNormals = false;
+    Point3<int64_t> first, previous;
+
+    while (true) {
+        skipObjSpaces(&p, end);
+        if (p == end || *p == '\n' || *p == '#') {
+            break;
+        }
+
+        // v, v/vt, v//vn, or v/vt/vn
+        int64_t v = 0, vt = 0, vn = 0;
+        bool vertexHasUv = false;
+        bool vertexHasNormal = false;
+        if (!parseObjIndex(&p, end, &v)) {
+            return false;
+        }
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                if (!parseObjIndex(&p, end, &vt)) {
+                    return false;
+                }
+                vertexHasUv = true;
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                if (!parseObjIndex(&p, end, &vn)) {
+                    return false;
+                }
+                vertexHasNormal = true;
+            }
+        }
+
+        if (numberOfVertices == 0) {
+            hasUvs = vertexHasUv;
+            hasNormals = vertexHasNormal;
+        } else if (hasUvs != vertexHasUv || hasNormals != vertexHasNormal) {
+            return false;
+        }
+
+        // x: point, y: UV, z: normal
+        Point3<int64_t> current;
+        if (!toObjChunkIndex(v, chunk->points.size(), &current.x)
+            || (hasUvs && !toObjChunkIndex(vt, chunk->uvs.size(), &current.y))
+            || (hasNormals
+                && !toObjChunkIndex(vn, chunk->normals.size(), &current.z))) {
+            return false;
+        }
+
+        if (numberOfVertices == 0) {
+            first = current;
+        } else if (numberOfVertices >= 2) {
+            chunk->pointIndices.emplace_back(first.x, previous.x, current.x);
+            if (hasUvs) {
+                chunk->uvIndices.emplace_back(first.y, previous.y, current.y);
+            }
+            if (hasNormals) {
+                chunk->normalIndices.emplace_back(
+                    first.z, previous.z, current.z);
+            }
+        }
+        previous = current;
+        ++numberOfVertices;
+    }
+
+    return numberOfVertices >= 3;
+}
+
+// Parses the lines from begin to end, which should be line-aligned. The
+// elements other than the vertices, UVs, normals, and faces are ignored.
+inline void parseObjChunk(const char* begin, const char* end, ObjChunk* chunk) {
+    const char* p = begin;
+    while (p < end && chunk->isValid) {
+        const char* lineEnd = static_cast<const char*>(
+            std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
+
+        skipObjSpaces(&p, lineEnd);
+        if (lineEnd - p >= 2 && p[0] == 'v' && isObjSpace(p[1])) {
+            Vector3D pt;
+            p += 2;
+            chunk->isValid
+                = parseObjDouble(&p, lineEnd, &pt.x)
+                && parseObjDouble(&p, lineEnd, &pt.y)
+                && parseObjDouble(&p, lineEnd, &pt.z);
+            chunk->points.push_back(pt);
+        } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't'
+            && isObjSpace(p[2])) {
+            Vector2D uv;
+            p += 3;
+            chunk->isValid
+                = parseObjDouble(&p, lineEnd, &uv.x)
+                && parseObjDouble(&p, lineEnd, &uv.y);
+            chunk->uvs.push_back(uv);
+        } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n'
+            && isObjSpace(p[2])) {
+            Vector3D n;
+            p += 3;
+            chunk->isValid
+                = parseObjDouble(&p, lineEnd, &n.x)
+                && parseObjDouble(&p, lineEnd, &n.y)
+                && parseObjDouble(&p, lineEnd, &n.z);
+            chunk->normals.push_back(n);
+        } else if (lineEnd - p >= 2 && p[0] == 'f' && isObjSpace(p[1])) {
+            chunk->isValid = parseObjFace(p + 2, lineEnd, chunk);
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_OBJ_READER_HELPERS_H_
@@ -0,0 +1,530 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(JET_WINDOWS)
+#   include <windows.h>
+#elif defined(JET_LINUX)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+#if defined(JET_USE_TBB)
+#   include <tbb/parallel_for.h>
+#   include <tbb/task_arena.h>
+#endif
+
+#if defined(JET_USE_OPENMP)
+#   include <omp.h>
+#endif
+
+using namespace jet;
+
+namespace {
+
+// Pins the calling thread to given core (modulo the number of cores), or
+// lets it run on any core if the core is negative. Not supported on macOS,
+// which has no API for the thread affinity.
+void pinThisThread(int core) {
+    unsigned int numberOfCores = std::max(
+        std::thread::hardware_concurrency(), 1u);
+#if defined(JET_WINDOWS)
+    DWORD_PTR mask = ~static_cast<DWORD_PTR>(0);
+    if (core >= 0) {
+        mask = static_cast<DWORD_PTR>(1)
+            << (static_cast<unsigned int>(core) % numberOfCores
+                % (8 * sizeof(DWORD_PTR)));
+    }
+    SetThreadAffinityMask(GetCurrentThread(), mask);
+#elif defined(JET_LINUX)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (core >= 0) {
+        CPU_SET(static_cast<unsigned int>(core) % numberOfCores, &cpuSet);
+    } else {
+        for (unsigned int i = 0; i < numberOfCores; ++i) {
+            CPU_SET(i, &cpuSet);
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#else
+    UNUSED_VARIABLE(core);
+    UNUSED_VARIABLE(numberOfCores);
+#endif
+}
+
+// Tasks of a single run. The first exception thrown by a task is kept and
+// rethrown by the calling thread once all the tasks are done.
+struct TaskGroup {
+    std::atomic<size_t> numberOfRemainingTasks;
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+};
+
+struct Task {
+    const std::function<void(size_t)>* function;
+    size_t index;
+    TaskGroup* group;
+};
+
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+// Persistent thread pool with one task deque per worker. A worker pops the
+// newest task from its own deque and steals the oldest one from the others'
+// when it runs out of work. The last deque is the submission queue for the
+// threads that do not belong to the pool (such as the main thread). Threads
+// waiting for their tasks to complete keep executing pending tasks, so nested
+// parallel calls from inside a task never dead-lock. With the pinning, each
+// worker is pinned to a core, and the tasks from the outside of the pool are
+// dealt round-robin so that task i runs on the same thread from call to call
+// unless it is stolen.
+class ThreadPool final {
+ public:
+    ThreadPool() {
+        unsigned int numThreadsHint = std::thread::hardware_concurrency();
+        start(numThreadsHint == 0u ? 8u : numThreadsHint);
+    }
+
+    ~ThreadPool() {
+        stop();
+    }
+
+    unsigned int numberOfThreads() const {
+        return _numberOfThreads;
+    }
+
+    void resize(unsigned int numberOfThreads) {
+        numberOfThreads = std::max(numberOfThreads, 1u);
+        if (numberOfThreads != _numberOfThreads) {
+            stop();
+            start(numberOfThreads);
+        }
+    }
+
+    bool isPinningEnabled() const {
+        return _isPinningEnabled;
+    }
+
+    void setIsPinningEnabled(bool isPinningEnabled) {
+        if (isPinningEnabled != _isPinningEnabled) {
+            stop();
+            _isPinningEnabled = isPinningEnabled;
+            start(_numberOfThreads);
+        }
+    }
+
+    void run(
+        size_t numberOfTasks,
+        const std::function<void(size_t)>& function) {
+        if (numberOfTasks == 0) {
+            return;
+        }
+
+        if (_workers.empty() || numberOfTasks == 1) {
+            for (size_t i = 0; i < numberOfTasks; ++i) {
+                function(i);
+            }
+            return;
+        }
+
+        TaskGroup group;
+        group.numberOfRemainingTasks = numberOfTasks;
+
+        // Workers push to their own deque so that nested tasks stay local.
+        // Everyone else goes through the shared submission queue.
+        size_t queueIndex = (sThisThreadPool == this)
+            ? sThisWorkerIndex : _workers.size();
+        if (_isPinningEnabled && queueIndex == _workers.size()) {
+            // Task i goes to the worker i - 1 (modulo the number of threads),
+            // and the calling thread keeps the multiples of the count
+            size_t numberOfThreads = _workers.size() + 1;
+            for (size_t q = 0; q < numberOfThreads; ++q) {
+                size_t first = (q == 0) ? numberOfThreads : q;
+                size_t targetIndex = (q == 0) ? queueIndex : q - 1;
+                TaskQueue& target = *_queues[targetIndex];
+                std::lock_guard<std::mutex> lock(target.mutex);
+                for (size_t i = first; i < numberOfTasks;
+                     i += numberOfThreads) {
+                    target.tasks.push_front({&function, i, &group});
+                }
+            }
+        } else {
+            TaskQueue& queue = *_queues[queueIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            for (size_t i = 1; i < numberOfTasks; ++i) {
+                queue.tasks.push_back({&function, i, &group});
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(_wakeUpMutex);
+            _numberOfPendingTasks.fetch_add(numberOfTasks - 1);
+        }
+        _wakeUpCondition.notify_all();
+
+        // The calling thread takes the first task by itself.
+        execute({&function, 0, &group});
+
+        while (group.numberOfRemainingTasks.load() > 0) {
+            Task task;
+            if (tryPop(queueIndex, &task)) {
+                execute(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        if (group.exception) {
+            std::rethrow_exception(group.exception);
+        }
+    }
+
+ private:
+    unsigned int _numberOfThreads = 1;
+    bool _isPinningEnabled = false;
+    std::vector<std::thread> _workers;
+    std::vector<std::unique_ptr<TaskQueue>> _queues;
+    std::atomic<size_t> _numberOfPendingTasks{0};
+    std::mutex _wakeUpMutex;
+    std::condition_variable _wakeUpCondition;
+    bool _isStopping = false;
+
+    static thread_local ThreadPool* sThisThreadPool;
+    static thread_local size_t sThisWorkerIndex;
+
+    void start(unsigned int numberOfThreads) {
+        _numberOfThreads = numberOfThreads;
+        _isStopping = false;
+
+        // The calling thread always participates, hence one less worker.
+        size_t numberOfWorkers = numberOfThreads - 1;
+        _queues.clear();
+        for (size_t i = 0; i <= numberOfWorkers; ++i) {
+            _queues.emplace_back(new TaskQueue);
+        }
+
+        _workers.reserve(numberOfWorkers);
+        for (size_t i = 0; i < numberOfWorkers; ++i) {
+            _workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(_wakeUpMutex);
+            _isStopping = true;
+        }
+        _wakeUpCondition.notify_all();
+
+        for (std::thread& worker : _workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        _workers.clear();
+    }
+
+    void workerLoop(size_t workerIndex) {
+        sThisThreadPool = this;
+        sThisWorkerIndex = workerIndex;
+
+        // The calling thread takes the core 0
+        if (_isPinningEnabled) {
+            pinThisThread(static_cast<int>(workerIndex + 1));
+        }
+
+        while (true) {
+            Task task;
+            if (tryPop(workerIndex, &task)) {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_wakeUpMutex);
+            _wakeUpCondition.wait(lock, [this] {
+                return _isStopping || _numberOfPendingTasks.load() > 0;
+            });
+
+            if (_isStopping && _numberOfPendingTasks.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    bool tryPop(size_t queueIndex, Task* task) {
+        if (_numberOfPendingTasks.load() == 0) {
+            return false;
+        }
+
+        // Own queue first (newest task for locality)...
+        {
+            TaskQueue& queue = *_queues[queueIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                *task = queue.tasks.back();
+                queue.tasks.pop_back();
+                _numberOfPendingTasks.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // ...then steal the oldest task from the others.
+        size_t numberOfQueues = _queues.size();
+        for (size_t offset = 1; offset < numberOfQueues; ++offset) {
+            size_t victimIndex = (queueIndex + offset) % numberOfQueues;
+            TaskQueue& victim = *_queues[victimIndex];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                *task = victim.tasks.front();
+                victim.tasks.pop_front();
+                _numberOfPendingTasks.fetch_sub(1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Runs the task and counts it as done even if it throws, so the waiting
+    // thread does not dead-lock.
+    static void execute(const Task& task) {
+        try {
+            (*task.function)(task.index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(task.group->exceptionMutex);
+            if (!task.group->exception) {
+                task.group->exception = std::current_exception();
+            }
+        }
+        task.group->numberOfRemainingTasks.fetch_sub(1);
+    }
+};
+
+thread_local ThreadPool* ThreadPool::sThisThreadPool = nullptr;
+thread_local size_t ThreadPool::sThisWorkerIndex = 0;
+
+ThreadPool& threadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+std::atomic<bool> sIsDeterministic(false);
+
+thread_local bool sIsSerialExecutionScope = false;
+
+ParallelBackend defaultParallelBackend() {
+#if defined(JET_USE_TBB)
+    return ParallelBackend::Tbb;
+#elif defined(JET_USE_OPENMP)
+    return ParallelBackend::OpenMp;
+#else
+    return ParallelBackend::ThreadPool;
+#endif
+}
+
+std::atomic<ParallelBackend> sParallelBackend(defaultParallelBackend());
+
+#if defined(JET_USE_TBB)
+// Arena limited by setMaxNumberOfThreads. Without it, the tasks run in the
+// arena of the calling thread, which is the one of the host application.
+std::unique_ptr<tbb::task_arena>& tbbArena() {
+    static std::unique_ptr<tbb::task_arena> arena;
+    return arena;
+}
+
+void runTbbTasks(
+    size_t numberOfTasks,
+    const std::function<void(size_t)>& task) {
+    auto run = [&] {
+        tbb::parallel_for(kZeroSize, numberOfTasks, [&](size_t i) {
+            task(i);
+        });
+    };
+    if (tbbArena()) {
+        tbbArena()->execute(run);
+    } else {
+        run();
+    }
+}
+#endif
+
+#if defined(JET_USE_OPENMP)
+// Calls from inside a parallel region run serially, so that the nested
+// calls do not start nested teams.
+void runOpenMpTasks(
+    size_t numberOfTasks,
+    const std::function<void(size_t)>& task) {
+    if (omp_in_parallel()) {
+        for (size_t i = 0; i < numberOfTasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    ssize_t count = static_cast<ssize_t>(numberOfTasks);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (ssize_t i = 0; i < count; ++i) {
+        task(static_cast<size_t>(i));
+    }
+}
+#endif
+
+}  // namespace
+
+namespace jet {
+
+void parallelInvoke(const std::vector<std::function<void()>>& tasks) {
+    internal::runTasks(tasks.size(), [&](size_t i) {
+        tasks[i]();
+    });
+}
+
+void setMaxNumberOfThreads(unsigned int numThreads) {
+    numThreads = std::max(numThreads, 1u);
+
+    switch (sParallelBackend.load()) {
+#if defined(JET_USE_TBB)
+        case ParallelBackend::Tbb:
+            tbbArena().reset(
+                new tbb::task_arena(static_cast<int>(numThreads)));
+            break;
+#endif
+#if defined(JET_USE_OPENMP)
+        case ParallelBackend::OpenMp:
+            omp_set_num_threads(static_cast<int>(numThreads));
+            break;
+#endif
+        default:
+            threadPool().resize(numThreads);
+            break;
+    }
+}
+
+unsigned int maxNumberOfThreads() {
+    if (sIsSerialExecutionScope) {
+        return 1;
+    }
+
+    switch (sParallelBackend.load()) {
+#if defined(JET_USE_TBB)
+        case ParallelBackend::Tbb:
+            return static_cast<unsigned int>(
+                tbbArena()
+                ? tbbArena()->max_concurrency()
+                : tbb::this_task_arena::max_concurrency());
+#endif
+#if defined(JET_USE_OPENMP)
+        case ParallelBackend::OpenMp:
+            return static_cast<unsigned int>(omp_get_max_threads());
+#endif
+        default:
+            return threadPool().numberOfThreads();
+    }
+}
+
+SerialExecutionScope::SerialExecutionScope()
+    : _wasSerial(sIsSerialExecutionScope) {
+    sIsSerialExecutionScope = true;
+}
+
+SerialExecutionScope::~SerialExecutionScope() {
+    sIsSerialExecutionScope = _wasSerial;
+}
+
+bool isSerialExecutionScope() {
+    return sIsSerialExecutionScope;
+}
+
+void setIsThreadPinningEnabled(bool isEnabled) {
+    threadPool().setIsPinningEnabled(isEnabled);
+    pinThisThread(isEnabled ? 0 : -1);
+}
+
+bool isThreadPinningEnabled() {
+    return threadPool().isPinningEnabled();
+}
+
+void setIsDeterministic(bool isDeterministic) {
+    sIsDeterministic = isDeterministic;
+}
+
+bool isDeterministic() {
+    return sIsDeterministic;
+}
+
+void setParallelBackend(ParallelBackend backend) {
+    JET_THROW_INVALID_ARG_IF(!isParallelBackendAvailable(backend));
+    sParallelBackend = backend;
+}
+
+ParallelBackend parallelBackend() {
+    return sParallelBackend;
+}
+
+bool isParallelBackendAvailable(ParallelBackend backend) {
+    switch (backend) {
+        case ParallelBackend::ThreadPool:
+            return true;
+        case ParallelBackend::Tbb:
+#if defined(JET_USE_TBB)
+            return true;
+#else
+            return false;
+#endif
+        case ParallelBackend::OpenMp:
+#if defined(JET_USE_OPENMP)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+namespace internal {
+
+void runTasks(
+    size_t numberOfTasks,
+    const std::function<void(size_t)>& task) {
+    if (numberOfTasks <= 1 || sIsSerialExecutionScope) {
+        for (size_t i = 0; i < numberOfTasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    switch (sParallelBackend.load()) {
+#if defined(JET_USE_TBB)
+        case ParallelBackend::Tbb:
+            runTbbTasks(numberOfTasks, task);
+            break;
+#endif
+#if defined(JET_USE_OPENMP)
+        case ParallelBackend::OpenMp:
+            runOpenMpTasks(numberOfTasks, task);
+            break;
+#endif
+        default:
+            threadPool().run(numberOfTasks, task);
+            break;
+    }
+}
+
+}  // namespace internal
+
+}  // namespace jet
@@ -0,0 +1,57 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_PARALLEL_SWEEP_HELPERS_H_
+#define SRC_JET_PARALLEL_SWEEP_HELPERS_H_
+
+#include <jet/parallel.h>
+#include <jet/size3.h>
+#include <algorithm>
+
+namespace jet {
+
+// Visits every (i, j, k) in a Gauss-Seidel sweep ordering, which is
+// increasing or decreasing along each axis depending on the flip flags. The
+// planes of constant i + j + k in the ordering are visited one after another,
+// and the cells in a plane are processed in parallel. This is race-free as
+// long as the callback only writes to (i, j, k) and reads the neighbors whose
+// offsets do not sum up to zero, such as the face neighbors or the neighbors
+// behind the cell along the axes. The callbacks with the same k run on the
+// same thread within a plane.
+template <typename Callback>
+void parallelSweep(
+    const Size3& size,
+    bool flipI,
+    bool flipJ,
+    bool flipK,
+    const Callback& func) {
+    if (size.x == 0 || size.y == 0 || size.z == 0) {
+        return;
+    }
+
+    size_t numberOfPlanes = size.x + size.y + size.z - 2;
+
+    for (size_t plane = 0; plane < numberOfPlanes; ++plane) {
+        size_t kBegin = (plane + 2 > size.x + size.y)
+            ? plane + 2 - size.x - size.y : 0;
+        size_t kEnd = std::min(plane + 1, size.z);
+
+        parallelFor(kBegin, kEnd, [&](size_t kk) {
+            size_t rest = plane - kk;
+            size_t jBegin = (rest + 1 > size.x) ? rest + 1 - size.x : 0;
+            size_t jEnd = std::min(rest + 1, size.y);
+
+            for (size_t jj = jBegin; jj < jEnd; ++jj) {
+                size_t ii = rest - jj;
+                size_t i = flipI ? size.x - 1 - ii : ii;
+                size_t j = flipJ ? size.y - 1 - jj : jj;
+                size_t k = flipK ? size.z - 1 - kk : kk;
+
+                func(i, j, k);
+            }
+        });
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_PARALLEL_SWEEP_HELPERS_H_
@@ -0,0 +1,301 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/parallel_tuner.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+using namespace jet;
+
+namespace {
+
+const char kProfileTag[] = "jet_parallel_tuning";
+const int kProfileVersion = 1;
+
+// Number of the measured calls per candidate configuration.
+const size_t kNumberOfTrials = 3;
+
+std::atomic<bool> sIsEnabled(false);
+
+}  // namespace
+
+class jet::ParallelRegionState {
+ public:
+    std::mutex mutex;
+
+    // Locked-in number of the chunks, or zero while tuning.
+    std::atomic<size_t> numberOfChunks;
+
+    // Number of the threads the candidates were made for.
+    unsigned int numberOfThreads = 0;
+    std::vector<size_t> candidates;
+    std::vector<size_t> numberOfReportedTrials;
+    std::vector<double> bestSecondsPerIndex;
+    size_t nextCandidate = 0;
+    double secondsPerIndex = 0.0;
+
+    ParallelRegionState() : numberOfChunks(0) {}
+
+    // Must be called with the mutex locked
+    void clear() {
+        numberOfChunks = 0;
+        numberOfThreads = 0;
+        candidates.clear();
+        numberOfReportedTrials.clear();
+        bestSecondsPerIndex.clear();
+        nextCandidate = 0;
+        secondsPerIndex = 0.0;
+    }
+
+    // Must be called with the mutex locked
+    void makeCandidates(unsigned int threads) {
+        clear();
+        numberOfThreads = threads;
+
+        size_t t = threads;
+        const size_t all[] = { 1, t / 4, t / 2, t, 4 * t, 16 * t };
+        for (size_t c : all) {
+            if (c > 0) {
+                candidates.push_back(c);
+            }
+        }
+
+        // A single thread has nothing to tune
+        if (threads <= 1) {
+            candidates.assign(1, 1);
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(
+            std::unique(candidates.begin(), candidates.end()),
+            candidates.end());
+        numberOfReportedTrials.assign(candidates.size(), 0);
+        bestSecondsPerIndex.assign(
+            candidates.size(), std::numeric_limits<double>::max());
+
+        if (candidates.size() == 1) {
+            numberOfChunks = candidates[0];
+        }
+    }
+};
+
+namespace {
+
+std::mutex sRegistryMutex;
+
+std::map<std::string, std::shared_ptr<ParallelRegionState>>& registry() {
+    static std::map<std::string, std::shared_ptr<ParallelRegionState>>
+        sRegions;
+    return sRegions;
+}
+
+// Must be called with sRegistryMutex locked
+std::shared_ptr<ParallelRegionState> findOrAddState(
+    const std::string& name) {
+    auto& regions = registry();
+    auto iter = regions.find(name);
+    if (iter == regions.end()) {
+        iter = regions.emplace(
+            name, std::make_shared<ParallelRegionState>()).first;
+    }
+    return iter->second;
+}
+
+}  // namespace
+
+bool ParallelTuner::isEnabled() {
+    return sIsEnabled;
+}
+
+void ParallelTuner::setIsEnabled(bool isEnabled) {
+    sIsEnabled = isEnabled;
+}
+
+std::vector<ParallelTuningResult> ParallelTuner::results() {
+    std::lock_guard<std::mutex> registryLock(sRegistryMutex);
+
+    std::vector<ParallelTuningResult> results;
+    for (const auto& region : registry()) {
+        std::lock_guard<std::mutex> lock(region.second->mutex);
+
+        ParallelTuningResult result;
+        result.name = region.first;
+        result.numberOfChunks = region.second->numberOfChunks;
+        result.isTuned = result.numberOfChunks > 0;
+        result.secondsPerIndex = region.second->secondsPerIndex;
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+void ParallelTuner::reset() {
+    std::lock_guard<std::mutex> registryLock(sRegistryMutex);
+
+    for (const auto& region : registry()) {
+        std::lock_guard<std::mutex> lock(region.second->mutex);
+        region.second->clear();
+    }
+}
+
+void ParallelTuner::saveProfile(std::ostream* strm) {
+    (*strm) << kProfileTag << ' ' << kProfileVersion << '\n';
+    (*strm) << "threads " << maxNumberOfThreads() << '\n';
+
+    for (const ParallelTuningResult& result : results()) {
+        if (result.isTuned) {
+            (*strm) << result.numberOfChunks << ' ' << result.name << '\n';
+        }
+    }
+}
+
+bool ParallelTuner::loadProfile(std::istream* strm) {
+    std::string tag;
+    int version = 0;
+    std::string threadsKey;
+    unsigned int threads = 0;
+    if (!((*strm) >> tag >> version >> threadsKey >> threads)
+        || tag != kProfileTag
+        || version != kProfileVersion
+        || threadsKey != "threads") {
+        return false;
+    }
+
+    if (threads != maxNumberOfThreads()) {
+        return false;
+    }
+
+    std::vector<std::pair<std::string, size_t>> entries;
+    std::string line;
+    while (std::getline(*strm, line)) {
+        std::istringstream lineStrm(line);
+        size_t numberOfChunks = 0;
+        std::string name;
+        if (!(lineStrm >> numberOfChunks)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            return false;
+        }
+        std::getline(lineStrm >> std::ws, name);
+        while (!name.empty() && (name.back() == '\r' || name.back() == ' ')) {
+            name.pop_back();
+        }
+        if (numberOfChunks == 0 || name.empty()) {
+            return false;
+        }
+        entries.emplace_back(name, numberOfChunks);
+    }
+
+    std::lock_guard<std::mutex> registryLock(sRegistryMutex);
+
+    for (const auto& entry : entries) {
+        auto state = findOrAddState(entry.first);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->clear();
+        state->numberOfThreads = threads;
+        state->numberOfChunks = entry.second;
+    }
+
+    return true;
+}
+
+bool ParallelTuner::saveProfile(const std::string& filename) {
+    std::ofstream file(filename.c_str());
+    if (!file) {
+        return false;
+    }
+
+    saveProfile(&file);
+    return static_cast<bool>(file);
+}
+
+bool ParallelTuner::loadProfile(const std::string& filename) {
+    std::ifstream file(filename.c_str());
+    if (!file) {
+        return false;
+    }
+
+    return loadProfile(&file);
+}
+
+ParallelRegion::ParallelRegion(const char* name) : _name(name) {
+    std::lock_guard<std::mutex> registryLock(sRegistryMutex);
+    _state = findOrAddState(name);
+}
+
+ParallelRegion::~ParallelRegion() {
+}
+
+const char* ParallelRegion::name() const {
+    return _name;
+}
+
+size_t ParallelRegion::beginCall(size_t n, size_t* trial) {
+    *trial = kMaxSize;
+
+    if (!sIsEnabled || isDeterministic() || isSerialExecutionScope()) {
+        return 0;
+    }
+
+    size_t numberOfChunks = _state->numberOfChunks;
+    if (numberOfChunks > 0) {
+        return numberOfChunks;
+    }
+
+    std::lock_guard<std::mutex> lock(_state->mutex);
+
+    unsigned int threads = maxNumberOfThreads();
+    if (_state->candidates.empty() || _state->numberOfThreads != threads) {
+        _state->makeCandidates(threads);
+    }
+
+    if (_state->numberOfChunks > 0) {
+        return _state->numberOfChunks;
+    }
+
+    // Too few indices to tell the candidates apart
+    if (n < _state->candidates.back()) {
+        return 0;
+    }
+
+    size_t candidate = _state->nextCandidate % _state->candidates.size();
+    ++_state->nextCandidate;
+
+    *trial = candidate;
+    return _state->candidates[candidate];
+}
+
+void ParallelRegion::endTrial(size_t trial, size_t n, double seconds) {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+
+    // Tuned or reset while the trial was running
+    if (_state->numberOfChunks > 0 || trial >= _state->candidates.size()) {
+        return;
+    }
+
+    double secondsPerIndex = seconds / static_cast<double>(n);
+    _state->bestSecondsPerIndex[trial] = std::min(
+        _state->bestSecondsPerIndex[trial], secondsPerIndex);
+    ++_state->numberOfReportedTrials[trial];
+
+    for (size_t count : _state->numberOfReportedTrials) {
+        if (count < kNumberOfTrials) {
+            return;
+        }
+    }
+
+    auto best = std::min_element(
+        _state->bestSecondsPerIndex.begin(),
+        _state->bestSecondsPerIndex.end());
+    size_t bestCandidate = static_cast<size_t>(
+        best - _state->bestSecondsPerIndex.begin());
+    _state->secondsPerIndex = *best;
+    _state->numberOfChunks = _state->candidates[bestCandidate];
+}
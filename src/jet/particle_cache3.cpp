@@ -0,0 +1,655 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/parallel.h>
+#include <jet/particle_cache3.h>
+#include <jet/point_cell_list_searcher3.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
+#include <mapped_file.h>
+#include <particle_cache_codec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const char kParticleCacheTag[] = "JETPCACH";
+const size_t kParticleCacheTagLength = 8;
+const uint32_t kParticleCacheVersion = 1;
+const size_t kParticleCacheNameLength = 48;
+const size_t kParticleCacheDataAlignment = 64;
+
+const uint32_t kParticleCacheScalarChannel = 1;
+const uint32_t kParticleCacheVectorChannel = 2;
+
+// Encodings of the channel data. All but the raw one are split into byte
+// planes, each of which is entropy-coded in blocks.
+const uint32_t kParticleCacheEncodingRaw = 0;
+const uint32_t kParticleCacheEncodingQuantizedPosition = 1;
+const uint32_t kParticleCacheEncodingHalf = 2;
+const uint32_t kParticleCacheEncodingShuffled = 3;
+
+// Quantized offsets within a bucket (per axis)
+const double kParticleCacheQuantizationScale = 65536.0;
+
+// Bytes per element for each encoding: a zigzag-coded bucket delta and a
+// 16-bit offset per axis for the quantized positions, and a half float per
+// axis for the half encoding
+const size_t kQuantizedPositionRecordSize = 3 * (4 + 2);
+const size_t kHalfRecordSize = 3 * 2;
+
+struct ParticleCacheHeader {
+    char tag[kParticleCacheTagLength];
+    uint32_t version;
+    uint32_t numberOfChannels;
+    uint64_t numberOfParticles;
+    double radius;
+    double mass;
+    double bounds[6];
+};
+
+struct ParticleCacheChannelHeader {
+    char name[kParticleCacheNameLength];
+    uint32_t type;
+    uint32_t encoding;
+    uint64_t numberOfElements;
+    uint64_t dataOffset;
+};
+
+// Header of the encoded channel data, followed by the block table (the
+// encoded size of each block as uint32) and the blocks
+struct ParticleCacheEncodedHeader {
+    double bucketSpacing;
+    uint32_t recordSize;
+    uint32_t blocksPerPlane;
+    uint64_t payloadSize;
+};
+
+static_assert(
+    sizeof(ParticleCacheHeader) == 88,
+    "Unexpected particle cache header size");
+static_assert(
+    sizeof(ParticleCacheChannelHeader) == 72,
+    "Unexpected particle cache channel header size");
+static_assert(
+    sizeof(ParticleCacheEncodedHeader) == 24,
+    "Unexpected particle cache encoded header size");
+
+size_t alignOffset(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+size_t elementSize(uint32_t type) {
+    return (type == kParticleCacheScalarChannel)
+        ? sizeof(double) : sizeof(Vector3D);
+}
+
+size_t recordSize(uint32_t encoding, uint32_t type) {
+    switch (encoding) {
+        case kParticleCacheEncodingQuantizedPosition:
+            return kQuantizedPositionRecordSize;
+        case kParticleCacheEncodingHalf:
+            return kHalfRecordSize;
+        default:
+            return elementSize(type);
+    }
+}
+
+void storeBytes(uint32_t value, size_t n, size_t i, uint8_t* planes) {
+    for (size_t b = 0; b < 4; ++b) {
+        planes[b * n + i] = static_cast<uint8_t>(value >> (8 * b));
+    }
+}
+
+uint32_t loadBytes(const uint8_t* planes, size_t n, size_t i) {
+    uint32_t value = 0;
+    for (size_t b = 0; b < 4; ++b) {
+        value |= static_cast<uint32_t>(planes[b * n + i]) << (8 * b);
+    }
+    return value;
+}
+
+// Splits the channel into byte planes. Plane p holds the p-th byte of the
+// encoded record of every element.
+void encodePlanes(
+    const char* data,
+    size_t n,
+    uint32_t type,
+    uint32_t encoding,
+    double bucketSpacing,
+    std::vector<uint8_t>* planes) {
+    planes->resize(n * recordSize(encoding, type));
+    uint8_t* out = planes->data();
+
+    if (encoding == kParticleCacheEncodingQuantizedPosition) {
+        const Vector3D* positions = reinterpret_cast<const Vector3D*>(data);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            uint8_t* axisOut = out + axis * 6 * n;
+            parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    double s = positions[i][axis] / bucketSpacing;
+                    double bucket = std::floor(s);
+                    double previous = (i > 0)
+                        ? std::floor(positions[i - 1][axis] / bucketSpacing)
+                        : 0.0;
+                    int32_t delta = static_cast<int32_t>(bucket - previous);
+                    storeBytes(zigzagEncode(delta), n, i, axisOut);
+
+                    double q = (s - bucket) * kParticleCacheQuantizationScale;
+                    uint16_t offset = static_cast<uint16_t>(
+                        std::min(std::max(q, 0.0), 65535.0));
+                    axisOut[4 * n + i] = static_cast<uint8_t>(offset);
+                    axisOut[5 * n + i] = static_cast<uint8_t>(offset >> 8);
+                }
+            });
+        }
+    } else if (encoding == kParticleCacheEncodingHalf) {
+        const Vector3D* vectors = reinterpret_cast<const Vector3D*>(data);
+        parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    uint16_t h = floatToHalf(
+                        static_cast<float>(vectors[i][axis]));
+                    out[2 * axis * n + i] = static_cast<uint8_t>(h);
+                    out[(2 * axis + 1) * n + i] = static_cast<uint8_t>(h >> 8);
+                }
+            }
+        });
+    } else {
+        size_t size = elementSize(type);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t b = 0; b < size; ++b) {
+                    out[b * n + i] = bytes[i * size + b];
+                }
+            }
+        });
+    }
+}
+
+// Rebuilds the channel from its byte planes.
+void decodePlanes(
+    const uint8_t* planes,
+    size_t n,
+    uint32_t type,
+    uint32_t encoding,
+    double bucketSpacing,
+    char* data) {
+    if (encoding == kParticleCacheEncodingQuantizedPosition) {
+        Vector3D* positions = reinterpret_cast<Vector3D*>(data);
+        parallelFor(kZeroSize, static_cast<size_t>(3), [&](size_t axis) {
+            const uint8_t* axisPlanes = planes + axis * 6 * n;
+            const uint8_t* lo = axisPlanes + 4 * n;
+            const uint8_t* hi = axisPlanes + 5 * n;
+            int64_t bucket = 0;
+            for (size_t i = 0; i < n; ++i) {
+                bucket += zigzagDecode(loadBytes(axisPlanes, n, i));
+                double offset = ((lo[i] | (hi[i] << 8)) + 0.5)
+                    / kParticleCacheQuantizationScale;
+                positions[i][axis]
+                    = (static_cast<double>(bucket) + offset) * bucketSpacing;
+            }
+        });
+    } else if (encoding == kParticleCacheEncodingHalf) {
+        double* vectors = reinterpret_cast<double*>(data);
+        parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            for (size_t axis = 0; axis < 3; ++axis) {
+                decodeHalfPlanes(
+                    planes + 2 * axis * n + begin,
+                    planes + (2 * axis + 1) * n + begin,
+                    end - begin,
+                    vectors + 3 * begin + axis,
+                    3);
+            }
+        });
+    } else {
+        size_t size = elementSize(type);
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(data);
+        parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t b = 0; b < size; ++b) {
+                    bytes[i * size + b] = planes[b * n + i];
+                }
+            }
+        });
+    }
+}
+
+void writePadding(std::ostream* strm, size_t from, size_t to) {
+    static const char kZeros[kParticleCacheDataAlignment] = {};
+    if (to > from) {
+        strm->write(kZeros, static_cast<std::streamsize>(to - from));
+    }
+}
+
+}  // namespace
+
+ParticleCacheWriter3::ParticleCacheWriter3(
+    const ParticleSystemData3& particles) {
+    _numberOfParticles = particles.numberOfParticles();
+    _radius = particles.radius();
+    _mass = particles.mass();
+
+    auto positions = particles.positions();
+    _boundingBox.reset();
+    for (size_t i = 0; i < positions.size(); ++i) {
+        _boundingBox.merge(positions[i]);
+    }
+
+    // The cells of the cell list are half of the hash grid spacing for the
+    // same search radius
+    auto searcher = std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(
+        particles.neighborSearcher());
+    auto cellList = std::dynamic_pointer_cast<PointCellListSearcher3>(
+        particles.neighborSearcher());
+    if (searcher != nullptr) {
+        _bucketSpacing = searcher->gridSpacing();
+    } else if (cellList != nullptr) {
+        _bucketSpacing = 2.0 * cellList->cellSize();
+    } else {
+        _bucketSpacing = 2.0 * _radius;
+    }
+
+    addVectorChannel("position", positions);
+    addVectorChannel("velocity", particles.velocities());
+    addVectorChannel("force", particles.forces());
+}
+
+void ParticleCacheWriter3::addScalarChannel(
+    const std::string& name,
+    const ConstArrayAccessor1<double>& data) {
+    JET_THROW_INVALID_ARG_IF(data.size() != _numberOfParticles);
+    addChannel(
+        name, kParticleCacheScalarChannel, data.data(),
+        data.size() * sizeof(double));
+}
+
+void ParticleCacheWriter3::addVectorChannel(
+    const std::string& name,
+    const ConstArrayAccessor1<Vector3D>& data) {
+    JET_THROW_INVALID_ARG_IF(data.size() != _numberOfParticles);
+    addChannel(
+        name, kParticleCacheVectorChannel, data.data(),
+        data.size() * sizeof(Vector3D));
+}
+
+bool ParticleCacheWriter3::isUsingCompression() const {
+    return _isUsingCompression;
+}
+
+void ParticleCacheWriter3::setIsUsingCompression(bool isUsing) {
+    _isUsingCompression = isUsing;
+}
+
+double ParticleCacheWriter3::bucketSpacing() const {
+    return _bucketSpacing;
+}
+
+void ParticleCacheWriter3::setBucketSpacing(double spacing) {
+    JET_THROW_INVALID_ARG_IF(!(spacing > 0.0));
+    _bucketSpacing = spacing;
+}
+
+void ParticleCacheWriter3::write(std::ostream* strm) const {
+    // The bucket deltas are stored in 32 bits
+    if (_isUsingCompression && _numberOfParticles > 0) {
+        const double kMaxBucket = static_cast<double>(1 << 30);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            JET_THROW_INVALID_ARG_IF(
+                !(std::fabs(_boundingBox.lowerCorner[axis]) / _bucketSpacing
+                  < kMaxBucket)
+                || !(std::fabs(_boundingBox.upperCorner[axis]) / _bucketSpacing
+                     < kMaxBucket));
+        }
+    }
+
+    ParticleCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.tag, kParticleCacheTag, kParticleCacheTagLength);
+    header.version = kParticleCacheVersion;
+    header.numberOfChannels = static_cast<uint32_t>(_channels.size());
+    header.numberOfParticles = _numberOfParticles;
+    header.radius = _radius;
+    header.mass = _mass;
+    if (_numberOfParticles > 0) {
+        header.bounds[0] = _boundingBox.lowerCorner.x;
+        header.bounds[1] = _boundingBox.lowerCorner.y;
+        header.bounds[2] = _boundingBox.lowerCorner.z;
+        header.bounds[3] = _boundingBox.upperCorner.x;
+        header.bounds[4] = _boundingBox.upperCorner.y;
+        header.bounds[5] = _boundingBox.upperCorner.z;
+    }
+
+    strm->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t offset = sizeof(header);
+
+    for (const Channel& channel : _channels) {
+        uint32_t encoding = kParticleCacheEncodingRaw;
+        if (_isUsingCompression) {
+            if (channel.type == kParticleCacheScalarChannel) {
+                encoding = kParticleCacheEncodingShuffled;
+            } else if (channel.name == "position") {
+                encoding = kParticleCacheEncodingQuantizedPosition;
+            } else {
+                encoding = kParticleCacheEncodingHalf;
+            }
+        }
+
+        ParticleCacheChannelHeader channelHeader;
+        std::memset(&channelHeader, 0, sizeof(channelHeader));
+        std::memcpy(
+            channelHeader.name, channel.name.c_str(), channel.name.size());
+        channelHeader.type = channel.type;
+        channelHeader.encoding = encoding;
+        channelHeader.numberOfElements = _numberOfParticles;
+
+        size_t dataOffset = alignOffset(
+            offset + sizeof(channelHeader), kParticleCacheDataAlignment);
+        channelHeader.dataOffset = dataOffset;
+
+        strm->write(
+            reinterpret_cast<const char*>(&channelHeader),
+            sizeof(channelHeader));
+        offset += sizeof(channelHeader);
+        writePadding(strm, offset, dataOffset);
+        offset = dataOffset;
+
+        if (encoding == kParticleCacheEncodingRaw) {
+            if (channel.bytes > 0) {
+                strm->write(
+                    channel.data, static_cast<std::streamsize>(channel.bytes));
+            }
+            offset += channel.bytes;
+        } else {
+            std::vector<uint8_t> planes;
+            encodePlanes(
+                channel.data, _numberOfParticles, channel.type, encoding,
+                _bucketSpacing, &planes);
+
+            size_t numberOfPlanes = recordSize(encoding, channel.type);
+            std::vector<uint32_t> table;
+            std::vector<std::vector<uint8_t>> blocks;
+            encodeRansBlocks(
+                planes, _numberOfParticles, numberOfPlanes, &table, &blocks);
+
+            ParticleCacheEncodedHeader encodedHeader;
+            std::memset(&encodedHeader, 0, sizeof(encodedHeader));
+            if (encoding == kParticleCacheEncodingQuantizedPosition) {
+                encodedHeader.bucketSpacing = _bucketSpacing;
+            }
+            encodedHeader.recordSize = static_cast<uint32_t>(numberOfPlanes);
+            encodedHeader.blocksPerPlane = (numberOfPlanes > 0)
+                ? static_cast<uint32_t>(table.size() / numberOfPlanes) : 0;
+            encodedHeader.payloadSize = table.size() * sizeof(uint32_t);
+            for (const auto& block : blocks) {
+                encodedHeader.payloadSize += block.size();
+            }
+
+            strm->write(
+                reinterpret_cast<const char*>(&encodedHeader),
+                sizeof(encodedHeader));
+            if (!table.empty()) {
+                strm->write(
+                    reinterpret_cast<const char*>(table.data()),
+                    static_cast<std::streamsize>(
+                        table.size() * sizeof(uint32_t)));
+            }
+            for (const auto& block : blocks) {
+                strm->write(
+                    reinterpret_cast<const char*>(block.data()),
+                    static_cast<std::streamsize>(block.size()));
+            }
+            offset += sizeof(encodedHeader)
+                + static_cast<size_t>(encodedHeader.payloadSize);
+        }
+
+        size_t nextOffset = alignOffset(offset, sizeof(uint64_t));
+        writePadding(strm, offset, nextOffset);
+        offset = nextOffset;
+    }
+}
+
+void ParticleCacheWriter3::addChannel(
+    const std::string& name,
+    uint32_t type,
+    const void* data,
+    size_t bytes) {
+    JET_THROW_INVALID_ARG_IF(
+        name.empty() || name.size() >= kParticleCacheNameLength);
+
+    Channel channel;
+    channel.name = name;
+    channel.type = type;
+    channel.data = static_cast<const char*>(data);
+    channel.bytes = bytes;
+    _channels.push_back(channel);
+}
+
+ParticleCacheReader3::ParticleCacheReader3() {
+}
+
+ParticleCacheReader3::~ParticleCacheReader3() {
+}
+
+bool ParticleCacheReader3::open(const std::string& filename) {
+    close();
+
+    std::unique_ptr<MappedFile> file(new MappedFile(filename));
+    if (!file->isValid() || file->size() < sizeof(ParticleCacheHeader)) {
+        return false;
+    }
+
+    const char* data = file->data();
+    size_t size = file->size();
+
+    ParticleCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.tag, kParticleCacheTag, kParticleCacheTagLength)
+        != 0 || header.version != kParticleCacheVersion) {
+        return false;
+    }
+
+    if (header.numberOfChannels
+        > (size - sizeof(header)) / sizeof(ParticleCacheChannelHeader)) {
+        return false;
+    }
+
+    std::vector<Channel> channels(header.numberOfChannels);
+    size_t offset = sizeof(header);
+    for (Channel& channel : channels) {
+        ParticleCacheChannelHeader channelHeader;
+        if (size - offset < sizeof(channelHeader)) {
+            return false;
+        }
+        std::memcpy(&channelHeader, data + offset, sizeof(channelHeader));
+        offset += sizeof(channelHeader);
+
+        uint32_t type = channelHeader.type;
+        uint32_t encoding = channelHeader.encoding;
+        if ((type != kParticleCacheScalarChannel
+             && type != kParticleCacheVectorChannel)
+            || encoding > kParticleCacheEncodingShuffled
+            || (type == kParticleCacheScalarChannel
+                && encoding != kParticleCacheEncodingRaw
+                && encoding != kParticleCacheEncodingShuffled)
+            || channelHeader.numberOfElements != header.numberOfParticles
+            || channelHeader.dataOffset < offset
+            || channelHeader.dataOffset % kParticleCacheDataAlignment != 0
+            || channelHeader.dataOffset > size) {
+            return false;
+        }
+
+        size_t dataOffset = static_cast<size_t>(channelHeader.dataOffset);
+        size_t bytes;
+        if (encoding == kParticleCacheEncodingRaw) {
+            if (header.numberOfParticles > size / elementSize(type)) {
+                return false;
+            }
+            bytes = elementSize(type) * header.numberOfParticles;
+        } else {
+            ParticleCacheEncodedHeader encodedHeader;
+            if (size - dataOffset < sizeof(encodedHeader)) {
+                return false;
+            }
+            std::memcpy(
+                &encodedHeader, data + dataOffset, sizeof(encodedHeader));
+            if (encodedHeader.payloadSize
+                > size - dataOffset - sizeof(encodedHeader)) {
+                return false;
+            }
+            bytes = sizeof(encodedHeader)
+                + static_cast<size_t>(encodedHeader.payloadSize);
+        }
+        if (size - dataOffset < bytes) {
+            return false;
+        }
+
+        channel.name = std::string(
+            channelHeader.name,
+            strnlen(channelHeader.name, kParticleCacheNameLength));
+        channel.type = type;
+        channel.encoding = encoding;
+        channel.data = data + dataOffset;
+        channel.bytes = bytes;
+
+        offset = std::min(
+            alignOffset(dataOffset + bytes, sizeof(uint64_t)), size);
+    }
+
+    _file = std::move(file);
+    _numberOfParticles = static_cast<size_t>(header.numberOfParticles);
+    _radius = header.radius;
+    _mass = header.mass;
+    _boundingBox = BoundingBox3D(
+        Vector3D(header.bounds[0], header.bounds[1], header.bounds[2]),
+        Vector3D(header.bounds[3], header.bounds[4], header.bounds[5]));
+    _channels = std::move(channels);
+
+    for (Channel& channel : _channels) {
+        if (channel.encoding != kParticleCacheEncodingRaw
+            && !decodeChannel(&channel)) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ParticleCacheReader3::close() {
+    _file.reset();
+    _numberOfParticles = 0;
+    _radius = 0.0;
+    _mass = 0.0;
+    _boundingBox = BoundingBox3D();
+    _channels.clear();
+}
+
+size_t ParticleCacheReader3::numberOfParticles() const {
+    return _numberOfParticles;
+}
+
+double ParticleCacheReader3::radius() const {
+    return _radius;
+}
+
+double ParticleCacheReader3::mass() const {
+    return _mass;
+}
+
+const BoundingBox3D& ParticleCacheReader3::boundingBox() const {
+    return _boundingBox;
+}
+
+size_t ParticleCacheReader3::numberOfChannels() const {
+    return _channels.size();
+}
+
+const std::string& ParticleCacheReader3::channelName(size_t i) const {
+    return _channels[i].name;
+}
+
+bool ParticleCacheReader3::hasScalarChannel(const std::string& name) const {
+    return findChannel(name, kParticleCacheScalarChannel) != nullptr;
+}
+
+bool ParticleCacheReader3::hasVectorChannel(const std::string& name) const {
+    return findChannel(name, kParticleCacheVectorChannel) != nullptr;
+}
+
+ConstArrayAccessor1<double> ParticleCacheReader3::scalarChannel(
+    const std::string& name) const {
+    const Channel* channel = findChannel(name, kParticleCacheScalarChannel);
+    if (channel == nullptr) {
+        return ConstArrayAccessor1<double>();
+    }
+    return ConstArrayAccessor1<double>(
+        _numberOfParticles,
+        reinterpret_cast<const double*>(channel->data));
+}
+
+ConstArrayAccessor1<Vector3D> ParticleCacheReader3::vectorChannel(
+    const std::string& name) const {
+    const Channel* channel = findChannel(name, kParticleCacheVectorChannel);
+    if (channel == nullptr) {
+        return ConstArrayAccessor1<Vector3D>();
+    }
+    return ConstArrayAccessor1<Vector3D>(
+        _numberOfParticles,
+        reinterpret_cast<const Vector3D*>(channel->data));
+}
+
+bool ParticleCacheReader3::decodeChannel(Channel* channel) {
+    ParticleCacheEncodedHeader encodedHeader;
+    std::memcpy(&encodedHeader, channel->data, sizeof(encodedHeader));
+    size_t numberOfPlanes = recordSize(channel->encoding, channel->type);
+    if (encodedHeader.recordSize != numberOfPlanes
+        || (channel->encoding == kParticleCacheEncodingQuantizedPosition
+            && !(encodedHeader.bucketSpacing > 0.0))) {
+        return false;
+    }
+
+    std::vector<uint8_t> planes;
+    if (!decodeRansBlocks(
+            channel->data + sizeof(encodedHeader),
+            static_cast<size_t>(encodedHeader.payloadSize),
+            _numberOfParticles,
+            numberOfPlanes,
+            encodedHeader.blocksPerPlane,
+            &planes)) {
+        return false;
+    }
+
+    char* decoded;
+    if (channel->type == kParticleCacheScalarChannel) {
+        channel->decodedScalars.resize(_numberOfParticles);
+        decoded = reinterpret_cast<char*>(channel->decodedScalars.data());
+    } else {
+        channel->decodedVectors.resize(_numberOfParticles);
+        decoded = reinterpret_cast<char*>(channel->decodedVectors.data());
+    }
+    decodePlanes(
+        planes.data(), _numberOfParticles, channel->type, channel->encoding,
+        encodedHeader.bucketSpacing, decoded);
+
+    channel->data = decoded;
+    channel->bytes = _numberOfParticles * elementSize(channel->type);
+    return true;
+}
+
+const ParticleCacheReader3::Channel* ParticleCacheReader3::findChannel(
+    const std::string& name,
+    uint32_t type) const {
+    for (const Channel& channel : _channels) {
+        if (channel.type == type && channel.name == name) {
+            return &channel;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,385 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_PARTICLE_CACHE_CODEC_H_
+#define SRC_JET_PARTICLE_CACHE_CODEC_H_
+
+#include <jet/macros.h>
+#include <jet/parallel.h>
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JET_PARTICLE_CACHE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace jet {
+
+// Order-0 rANS coder with 32-bit state and byte-wise renormalization. Each
+// block has its own frequency table, and blocks are coded independently so
+// they can be encoded and decoded in parallel.
+static const uint32_t kRansScaleBits = 12;
+static const uint32_t kRansScale = 1u << kRansScaleBits;
+static const uint32_t kRansLowerBound = 1u << 23;
+
+// Number of bytes per entropy-coded block within a plane
+static const size_t kRansBlockSize = 1 << 16;
+
+// Encoded blocks with this bit set in the block table are stored as is
+static const uint32_t kRansRawBlockFlag = 1u << 31;
+
+inline uint32_t zigzagEncode(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int32_t zigzagDecode(uint32_t v) {
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+inline uint64_t zigzagEncode(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+// Converts a float to a half-precision float with round-to-nearest-even.
+// Overflows become infinities, and NaNs stay NaNs.
+inline uint16_t floatToHalf(float value) {
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    uint32_t sign = (f >> 16) & 0x8000u;
+    f &= 0x7fffffffu;
+
+    uint16_t h;
+    if (f >= 0x47800000u) {
+        // Infinity, NaN, or too large
+        h = (f > 0x7f800000u) ? 0x7e00u : 0x7c00u;
+    } else if (f < 0x38800000u) {
+        // Subnormal or zero; let the FPU round by adding 0.5
+        float denormMagic;
+        uint32_t denormMagicBits = 126u << 23;
+        std::memcpy(&denormMagic, &denormMagicBits, sizeof(denormMagic));
+        float g;
+        std::memcpy(&g, &f, sizeof(g));
+        g += denormMagic;
+        uint32_t bits;
+        std::memcpy(&bits, &g, sizeof(bits));
+        h = static_cast<uint16_t>(bits - denormMagicBits);
+    } else {
+        uint32_t mantissaOdd = (f >> 13) & 1u;
+        f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + mantissaOdd;
+        h = static_cast<uint16_t>(f >> 13);
+    }
+    return static_cast<uint16_t>(h | sign);
+}
+
+inline float halfToFloat(uint16_t value) {
+    uint32_t expMantissa = value & 0x7fffu;
+    uint32_t bits = expMantissa << 13;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+
+    // Rescale the exponent; subnormals are normalized by the multiplication
+    float magic;
+    uint32_t magicBits = (254u - 15u) << 23;
+    std::memcpy(&magic, &magicBits, sizeof(magic));
+    f *= magic;
+
+    std::memcpy(&bits, &f, sizeof(bits));
+    if (expMantissa >= 0x7c00u) {
+        bits |= 255u << 23;
+    }
+    bits |= static_cast<uint32_t>(value & 0x8000u) << 16;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Decodes n half floats whose low and high bytes are stored in separate
+// planes, writing them to out[0], out[stride], out[2 * stride], ...
+inline void decodeHalfPlanes(
+    const uint8_t* lo,
+    const uint8_t* hi,
+    size_t n,
+    double* out,
+    size_t stride) {
+    size_t i = 0;
+#ifdef JET_PARTICLE_CACHE_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i noSign = _mm_set1_epi32(0x7fff);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128i wasInfNan = _mm_set1_epi32(0x7bff);
+    const __m128i infNanExponent = _mm_set1_epi32(255 << 23);
+    for (; i + 4 <= n; i += 4) {
+        int32_t loBytes, hiBytes;
+        std::memcpy(&loBytes, lo + i, sizeof(loBytes));
+        std::memcpy(&hiBytes, hi + i, sizeof(hiBytes));
+        __m128i h = _mm_unpacklo_epi8(
+            _mm_cvtsi32_si128(loBytes), _mm_cvtsi32_si128(hiBytes));
+        h = _mm_unpacklo_epi16(h, zero);
+
+        __m128i expMantissa = _mm_and_si128(h, noSign);
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMantissa), 16);
+        __m128 scaled = _mm_mul_ps(
+            _mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), magic);
+        __m128i infNan = _mm_and_si128(
+            _mm_cmpgt_epi32(expMantissa, wasInfNan), infNanExponent);
+        __m128 f = _mm_or_ps(
+            scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan)));
+
+        __m128d d0 = _mm_cvtps_pd(f);
+        __m128d d1 = _mm_cvtps_pd(_mm_movehl_ps(f, f));
+        _mm_storel_pd(out + i * stride, d0);
+        _mm_storeh_pd(out + (i + 1) * stride, d0);
+        _mm_storel_pd(out + (i + 2) * stride, d1);
+        _mm_storeh_pd(out + (i + 3) * stride, d1);
+    }
+#endif
+    for (; i < n; ++i) {
+        uint16_t h = static_cast<uint16_t>(lo[i] | (hi[i] << 8));
+        out[i * stride] = halfToFloat(h);
+    }
+}
+
+// Builds a frequency table summing up to kRansScale, keeping every symbol in
+// the data at least at frequency 1.
+inline void buildRansFrequencies(
+    const uint8_t* data,
+    size_t n,
+    uint32_t frequencies[256]) {
+    size_t counts[256] = {};
+    for (size_t i = 0; i < n; ++i) {
+        ++counts[data[i]];
+    }
+
+    uint32_t sum = 0;
+    for (size_t s = 0; s < 256; ++s) {
+        frequencies[s] = 0;
+        if (counts[s] > 0) {
+            uint64_t f = static_cast<uint64_t>(counts[s]) * kRansScale / n;
+            frequencies[s] = (f > 0) ? static_cast<uint32_t>(f) : 1;
+            sum += frequencies[s];
+        }
+    }
+
+    // Fix up the rounding by adjusting the most frequent symbols
+    while (sum != kRansScale) {
+        size_t largest = 0;
+        for (size_t s = 1; s < 256; ++s) {
+            if (frequencies[s] > frequencies[largest]) {
+                largest = s;
+            }
+        }
+        if (sum < kRansScale) {
+            frequencies[largest] += kRansScale - sum;
+            sum = kRansScale;
+        } else {
+            uint32_t d = std::min(sum - kRansScale, frequencies[largest] - 1);
+            frequencies[largest] -= d;
+            sum -= d;
+        }
+    }
+}
+
+// Encodes a block as a symbol table followed by the rANS stream. The symbol
+// table has the number of symbols (uint16) and then the symbol (uint8) and
+// frequency (uint16) pairs.
+inline void encodeRansBlock(
+    const uint8_t* data,
+    size_t n,
+    std::vector<uint8_t>* output) {
+    uint32_t frequencies[256];
+    buildRansFrequencies(data, n, frequencies);
+
+    uint32_t starts[256];
+    uint32_t start = 0;
+    uint16_t numberOfSymbols = 0;
+    for (size_t s = 0; s < 256; ++s) {
+        starts[s] = start;
+        start += frequencies[s];
+        numberOfSymbols += (frequencies[s] > 0);
+    }
+
+    output->clear();
+    output->push_back(static_cast<uint8_t>(numberOfSymbols & 0xff));
+    output->push_back(static_cast<uint8_t>(numberOfSymbols >> 8));
+    for (size_t s = 0; s < 256; ++s) {
+        if (frequencies[s] > 0) {
+            output->push_back(static_cast<uint8_t>(s));
+            output->push_back(static_cast<uint8_t>(frequencies[s] & 0xff));
+            output->push_back(static_cast<uint8_t>(frequencies[s] >> 8));
+        }
+    }
+
+    // The symbols are encoded backward, and each takes at most two bytes
+    std::vector<uint8_t> stream(2 * n + 4);
+    uint8_t* end = stream.data() + stream.size();
+    uint8_t* ptr = end;
+    uint32_t x = kRansLowerBound;
+    for (size_t i = n; i-- > 0; ) {
+        uint32_t freq = frequencies[data[i]];
+        uint32_t xMax = ((kRansLowerBound >> kRansScaleBits) << 8) * freq;
+        while (x >= xMax) {
+            *--ptr = static_cast<uint8_t>(x & 0xff);
+            x >>= 8;
+        }
+        x = ((x / freq) << kRansScaleBits) + (x % freq) + starts[data[i]];
+    }
+    for (int b = 3; b >= 0; --b) {
+        *--ptr = static_cast<uint8_t>(x >> (8 * b));
+    }
+
+    output->insert(output->end(), ptr, end);
+}
+
+// Decodes a block encoded by encodeRansBlock. Returns false if the block is
+// corrupted.
+inline bool decodeRansBlock(
+    const uint8_t* input,
+    size_t inputSize,
+    uint8_t* data,
+    size_t n) {
+    if (inputSize < 2) {
+        return false;
+    }
+    size_t numberOfSymbols = input[0] | (input[1] << 8);
+    const uint8_t* ptr = input + 2;
+    const uint8_t* end = input + inputSize;
+    if (numberOfSymbols == 0 || numberOfSymbols > 256
+        || static_cast<size_t>(end - ptr) < 3 * numberOfSymbols + 4) {
+        return false;
+    }
+
+    uint32_t frequencies[256] = {};
+    for (size_t i = 0; i < numberOfSymbols; ++i, ptr += 3) {
+        frequencies[ptr[0]] = ptr[1] | (ptr[2] << 8);
+    }
+
+    uint32_t starts[256];
+    uint8_t slots[kRansScale];
+    uint32_t start = 0;
+    for (size_t s = 0; s < 256; ++s) {
+        if (start + frequencies[s] > kRansScale) {
+            return false;
+        }
+        starts[s] = start;
+        std::memset(slots + start, static_cast<int>(s), frequencies[s]);
+        start += frequencies[s];
+    }
+    if (start != kRansScale) {
+        return false;
+    }
+
+    uint32_t x = static_cast<uint32_t>(ptr[0])
+        | (static_cast<uint32_t>(ptr[1]) << 8)
+        | (static_cast<uint32_t>(ptr[2]) << 16)
+        | (static_cast<uint32_t>(ptr[3]) << 24);
+    ptr += 4;
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t m = x & (kRansScale - 1);
+        uint8_t s = slots[m];
+        data[i] = s;
+        x = frequencies[s] * (x >> kRansScaleBits) + m - starts[s];
+        while (x < kRansLowerBound) {
+            if (ptr == end) {
+                return false;
+            }
+            x = (x << 8) | *ptr++;
+        }
+    }
+    return true;
+}
+
+// Entropy-codes numberOfPlanes planes of n bytes each in blocks of
+// kRansBlockSize bytes. The encoded size of each block goes to the table, and
+// the blocks that do not shrink are stored as is.
+inline void encodeRansBlocks(
+    const std::vector<uint8_t>& planes,
+    size_t n,
+    size_t numberOfPlanes,
+    std::vector<uint32_t>* table,
+    std::vector<std::vector<uint8_t>>* blocks) {
+    size_t blocksPerPlane = (n + kRansBlockSize - 1) / kRansBlockSize;
+    table->resize(numberOfPlanes * blocksPerPlane);
+    blocks->resize(numberOfPlanes * blocksPerPlane);
+
+    parallelFor(kZeroSize, blocks->size(), [&](size_t b) {
+        size_t plane = b / blocksPerPlane;
+        size_t begin = (b % blocksPerPlane) * kRansBlockSize;
+        size_t size = std::min(kRansBlockSize, n - begin);
+        const uint8_t* data = planes.data() + plane * n + begin;
+
+        std::vector<uint8_t>& block = (*blocks)[b];
+        encodeRansBlock(data, size, &block);
+        if (block.size() >= size) {
+            block.assign(data, data + size);
+            (*table)[b] = static_cast<uint32_t>(size) | kRansRawBlockFlag;
+        } else {
+            (*table)[b] = static_cast<uint32_t>(block.size());
+        }
+    });
+}
+
+// Decodes the blocks written by encodeRansBlocks. Returns false if the blocks
+// are corrupted.
+inline bool decodeRansBlocks(
+    const char* payload,
+    size_t payloadSize,
+    size_t n,
+    size_t numberOfPlanes,
+    size_t blocksPerPlane,
+    std::vector<uint8_t>* planes) {
+    size_t numberOfBlocks = numberOfPlanes * blocksPerPlane;
+    if (blocksPerPlane != (n + kRansBlockSize - 1) / kRansBlockSize
+        || payloadSize / sizeof(uint32_t) < numberOfBlocks) {
+        return false;
+    }
+
+    std::vector<uint32_t> table(numberOfBlocks);
+    std::vector<size_t> offsets(numberOfBlocks);
+    if (numberOfBlocks > 0) {
+        std::memcpy(
+            table.data(), payload, numberOfBlocks * sizeof(uint32_t));
+    }
+    size_t offset = numberOfBlocks * sizeof(uint32_t);
+    for (size_t b = 0; b < numberOfBlocks; ++b) {
+        offsets[b] = offset;
+        offset += table[b] & ~kRansRawBlockFlag;
+        if (offset > payloadSize) {
+            return false;
+        }
+    }
+
+    planes->resize(n * numberOfPlanes);
+    std::vector<char> isValid(numberOfBlocks, 1);
+    parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+        size_t plane = b / blocksPerPlane;
+        size_t begin = (b % blocksPerPlane) * kRansBlockSize;
+        size_t size = std::min(kRansBlockSize, n - begin);
+        uint8_t* data = planes->data() + plane * n + begin;
+        const uint8_t* block
+            = reinterpret_cast<const uint8_t*>(payload + offsets[b]);
+        size_t blockSize = table[b] & ~kRansRawBlockFlag;
+
+        if (table[b] & kRansRawBlockFlag) {
+            isValid[b] = (blockSize == size);
+            if (isValid[b]) {
+                std::memcpy(data, block, size);
+            }
+        } else {
+            isValid[b] = decodeRansBlock(block, blockSize, data, size);
+        }
+    });
+
+    return std::find(isValid.begin(), isValid.end(), 0) == isValid.end();
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_PARTICLE_CACHE_CODEC_H_
@@ -5,6 +5,8 @@
 #include <jet/parallel.h>
 #include <jet/particle_emitter3.h>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 namespace jet {
@@ -15,4 +17,50 @@ ParticleEmitter3::ParticleEmitter3() {
 ParticleEmitter3::~ParticleEmitter3() {
 }
 
+void ParticleEmitter3::generate(
+    const Frame& frame,
+    const ParticleSystemData3Ptr& particles,
+    Array1<Vector3D>* newPositions,
+    Array1<Vector3D>* newVelocities) {
+    const size_t oldNumberOfParticles = particles->numberOfParticles();
+
+    auto scratch = std::make_shared<ParticleSystemData3>();
+    scratch->setRadius(particles->radius());
+    scratch->setMass(particles->mass());
+    scratch->addParticles(particles->positions(), particles->velocities());
+
+    emit(frame, scratch);
+
+    const size_t numberOfNewParticles
+        = scratch->numberOfParticles() - oldNumberOfParticles;
+    auto positions = scratch->positions();
+    auto velocities = scratch->velocities();
+    newPositions->resize(numberOfNewParticles);
+    newVelocities->resize(numberOfNewParticles);
+    parallelFor(kZeroSize, numberOfNewParticles, [&](size_t i) {
+        (*newPositions)[i] = positions[oldNumberOfParticles + i];
+        (*newVelocities)[i] = velocities[oldNumberOfParticles + i];
+    });
+}
+
+double ParticleEmitter3::previewScale() const {
+    return _previewScale;
+}
+
+void ParticleEmitter3::setPreviewScale(double factor) {
+    JET_THROW_INVALID_ARG_IF(factor < 1.0);
+    _previewScale = factor;
+}
+
+size_t ParticleEmitter3::scaledNumberOfParticles(
+    size_t number,
+    double factor) {
+    if (number == 0 || number == std::numeric_limits<size_t>::max()) {
+        return number;
+    }
+
+    double scaled = std::round(number / (factor * factor * factor));
+    return std::max(static_cast<size_t>(scaled), kOneSize);
+}
+
 }  // namespace jet
@@ -0,0 +1,111 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/parallel.h>
+#include <jet/particle_emitter_set3.h>
+
+#include <functional>
+#include <vector>
+
+using namespace jet;
+
+ParticleEmitterSet3::ParticleEmitterSet3() {
+}
+
+ParticleEmitterSet3::ParticleEmitterSet3(
+    const std::vector<ParticleEmitter3Ptr>& emitters) {
+    for (const auto& emitter : emitters) {
+        addEmitter(emitter);
+    }
+}
+
+size_t ParticleEmitterSet3::numberOfEmitters() const {
+    return _emitters.size();
+}
+
+const ParticleEmitter3Ptr& ParticleEmitterSet3::emitterAt(size_t i) const {
+    return _emitters[i];
+}
+
+void ParticleEmitterSet3::addEmitter(const ParticleEmitter3Ptr& emitter) {
+    JET_THROW_INVALID_ARG_IF(emitter == nullptr);
+
+    _emitters.push_back(emitter);
+    _newPositions.emplace_back();
+    _newVelocities.emplace_back();
+    _offsets.push_back(0);
+}
+
+void ParticleEmitterSet3::setPreviewScale(double factor) {
+    ParticleEmitter3::setPreviewScale(factor);
+    for (const auto& emitter : _emitters) {
+        emitter->setPreviewScale(factor);
+    }
+}
+
+void ParticleEmitterSet3::emit(
+    const Frame& frame,
+    const ParticleSystemData3Ptr& particles) {
+    size_t numberOfNewParticles = generateAll(frame, particles);
+    if (numberOfNewParticles == 0) {
+        return;
+    }
+
+    size_t oldNumberOfParticles = particles->numberOfParticles();
+    particles->resize(oldNumberOfParticles + numberOfNewParticles);
+
+    Vector3D* positions = particles->positions().data();
+    Vector3D* velocities = particles->velocities().data();
+    copyAll(
+        ArrayAccessor1<Vector3D>(
+            numberOfNewParticles, positions + oldNumberOfParticles),
+        ArrayAccessor1<Vector3D>(
+            numberOfNewParticles, velocities + oldNumberOfParticles));
+}
+
+void ParticleEmitterSet3::generate(
+    const Frame& frame,
+    const ParticleSystemData3Ptr& particles,
+    Array1<Vector3D>* newPositions,
+    Array1<Vector3D>* newVelocities) {
+    size_t numberOfNewParticles = generateAll(frame, particles);
+
+    newPositions->resize(numberOfNewParticles);
+    newVelocities->resize(numberOfNewParticles);
+    copyAll(newPositions->accessor(), newVelocities->accessor());
+}
+
+size_t ParticleEmitterSet3::generateAll(
+    const Frame& frame,
+    const ParticleSystemData3Ptr& particles) {
+    std::vector<std::function<void()>> tasks;
+    for (size_t e = 0; e < _emitters.size(); ++e) {
+        tasks.push_back([&, e]() {
+            _emitters[e]->generate(
+                frame, particles, &_newPositions[e], &_newVelocities[e]);
+        });
+    }
+    parallelInvoke(tasks);
+
+    size_t numberOfNewParticles = 0;
+    for (size_t e = 0; e < _emitters.size(); ++e) {
+        JET_ASSERT(_newVelocities[e].size() == _newPositions[e].size());
+        _offsets[e] = numberOfNewParticles;
+        numberOfNewParticles += _newPositions[e].size();
+    }
+    return numberOfNewParticles;
+}
+
+void ParticleEmitterSet3::copyAll(
+    ArrayAccessor1<Vector3D> positions,
+    ArrayAccessor1<Vector3D> velocities) const {
+    for (size_t e = 0; e < _emitters.size(); ++e) {
+        const Array1<Vector3D>& newPositions = _newPositions[e];
+        const Array1<Vector3D>& newVelocities = _newVelocities[e];
+        const size_t offset = _offsets[e];
+        parallelFor(kZeroSize, newPositions.size(), [&](size_t i) {
+            positions[offset + i] = newPositions[i];
+            velocities[offset + i] = newVelocities[i];
+        });
+    }
+}
@@ -0,0 +1,326 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/parallel.h>
+#include <jet/particle_slab_decomposition3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace jet;
+
+// Number of the histogram bins along z for the rebalancing
+static const size_t kNumberOfRebalanceBins = 1024;
+
+static size_t numberOfValuesPerParticle(const ParticleSystemData3& particles) {
+    return 9 + particles.numberOfScalarData()
+        + 3 * particles.numberOfVectorData();
+}
+
+// Packs all the data layers of the given particles into a flat buffer.
+static void packParticles(
+    const ParticleSystemData3& particles,
+    const std::vector<size_t>& indices,
+    std::vector<double>* buffer) {
+    const size_t stride = numberOfValuesPerParticle(particles);
+    const size_t numberOfScalarData = particles.numberOfScalarData();
+    const size_t numberOfVectorData = particles.numberOfVectorData();
+    auto positions = particles.positions();
+    auto velocities = particles.velocities();
+    auto forces = particles.forces();
+
+    buffer->resize(indices.size() * stride);
+    parallelFor(kZeroSize, indices.size(), [&](size_t i) {
+        const size_t p = indices[i];
+        double* values = buffer->data() + i * stride;
+
+        for (size_t c = 0; c < 3; ++c) {
+            values[c] = positions[p][c];
+            values[3 + c] = velocities[p][c];
+            values[6 + c] = forces[p][c];
+        }
+        values += 9;
+
+        for (size_t s = 0; s < numberOfScalarData; ++s) {
+            *values++ = particles.scalarDataAt(s)[p];
+        }
+
+        for (size_t v = 0; v < numberOfVectorData; ++v) {
+            const Vector3D& vector = particles.vectorDataAt(v)[p];
+            for (size_t c = 0; c < 3; ++c) {
+                *values++ = vector[c];
+            }
+        }
+    });
+}
+
+// Appends the particles in a buffer made by packParticles.
+static void unpackParticles(
+    const std::vector<double>& buffer,
+    ParticleSystemData3* particles) {
+    const size_t stride = numberOfValuesPerParticle(*particles);
+    JET_THROW_INVALID_ARG_IF(buffer.size() % stride != 0);
+
+    const size_t numberOfScalarData = particles->numberOfScalarData();
+    const size_t numberOfVectorData = particles->numberOfVectorData();
+    const size_t oldNumberOfParticles = particles->numberOfParticles();
+    const size_t numberOfReceived = buffer.size() / stride;
+
+    particles->resize(oldNumberOfParticles + numberOfReceived);
+
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    auto forces = particles->forces();
+
+    parallelFor(kZeroSize, numberOfReceived, [&](size_t i) {
+        const size_t p = oldNumberOfParticles + i;
+        const double* values = buffer.data() + i * stride;
+
+        positions[p] = Vector3D(values[0], values[1], values[2]);
+        velocities[p] = Vector3D(values[3], values[4], values[5]);
+        forces[p] = Vector3D(values[6], values[7], values[8]);
+        values += 9;
+
+        for (size_t s = 0; s < numberOfScalarData; ++s) {
+            particles->scalarDataAt(s)[p] = *values++;
+        }
+
+        for (size_t v = 0; v < numberOfVectorData; ++v) {
+            particles->vectorDataAt(v)[p]
+                = Vector3D(values[0], values[1], values[2]);
+            values += 3;
+        }
+    });
+}
+
+// Sends a buffer of any size while receiving one from another rank.
+static void sendReceiveBuffer(
+    Communicator* communicator,
+    const std::vector<double>& sendBuffer,
+    int destination,
+    std::vector<double>* receiveBuffer,
+    int source) {
+    uint64_t sendSize = sendBuffer.size();
+    uint64_t receiveSize = 0;
+    communicator->sendReceive(
+        &sendSize,
+        sizeof(uint64_t),
+        destination,
+        &receiveSize,
+        sizeof(uint64_t),
+        source);
+
+    receiveBuffer->resize(static_cast<size_t>(receiveSize));
+    communicator->sendReceive(
+        sendBuffer.data(),
+        sendBuffer.size() * sizeof(double),
+        destination,
+        receiveBuffer->data(),
+        receiveBuffer->size() * sizeof(double),
+        source);
+}
+
+ParticleSlabDecomposition3::ParticleSlabDecomposition3(
+    double zMin,
+    double zMax,
+    const CommunicatorPtr& communicator) :
+    _communicator(communicator) {
+    JET_THROW_INVALID_ARG_IF(_communicator == nullptr);
+    JET_THROW_INVALID_ARG_IF(!(zMin < zMax));
+
+    const size_t numberOfRanks = static_cast<size_t>(_communicator->size());
+    _boundaries.resize(numberOfRanks + 1);
+    for (size_t r = 0; r <= numberOfRanks; ++r) {
+        _boundaries[r] = zMin + (zMax - zMin) * r / numberOfRanks;
+    }
+    _boundaries[numberOfRanks] = zMax;
+}
+
+double ParticleSlabDecomposition3::zBegin() const {
+    return _boundaries[static_cast<size_t>(_communicator->rank())];
+}
+
+double ParticleSlabDecomposition3::zEnd() const {
+    return _boundaries[static_cast<size_t>(_communicator->rank()) + 1];
+}
+
+ConstArrayAccessor1<double> ParticleSlabDecomposition3::boundaries() const {
+    return _boundaries.constAccessor();
+}
+
+int ParticleSlabDecomposition3::ownerRank(double z) const {
+    // Only the inner bounds matter since the end slabs are open
+    auto begin = _boundaries.begin() + 1;
+    auto end = _boundaries.end() - 1;
+    return static_cast<int>(std::upper_bound(begin, end, z) - begin);
+}
+
+const CommunicatorPtr& ParticleSlabDecomposition3::communicator() const {
+    return _communicator;
+}
+
+void ParticleSlabDecomposition3::migrateParticles(
+    ParticleSystemData3* particles) const {
+    const int rank = _communicator->rank();
+    const int previousRank = (rank > 0) ? rank - 1 : kNoRank;
+    const int nextRank
+        = (rank + 1 < _communicator->size()) ? rank + 1 : kNoRank;
+
+    std::vector<int> owners;
+    std::vector<size_t> backwardIndices;
+    std::vector<size_t> forwardIndices;
+    std::vector<double> sendBuffer;
+    std::vector<double> receiveBuffer;
+
+    while (true) {
+        const size_t n = particles->numberOfParticles();
+        auto positions = particles->positions();
+
+        owners.resize(n);
+        parallelFor(kZeroSize, n, [&](size_t i) {
+            owners[i] = ownerRank(positions[i].z);
+        });
+
+        backwardIndices.clear();
+        forwardIndices.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (owners[i] < rank) {
+                backwardIndices.push_back(i);
+            } else if (owners[i] > rank) {
+                forwardIndices.push_back(i);
+            }
+        }
+
+        // Particles crossing several slabs take one hop per round
+        double numberOfMisplaced = _communicator->max(static_cast<double>(
+            backwardIndices.size() + forwardIndices.size()));
+        if (numberOfMisplaced == 0.0) {
+            break;
+        }
+
+        std::vector<double> fromNext;
+        packParticles(*particles, backwardIndices, &sendBuffer);
+        sendReceiveBuffer(
+            _communicator.get(), sendBuffer, previousRank, &fromNext, nextRank);
+
+        packParticles(*particles, forwardIndices, &sendBuffer);
+        sendReceiveBuffer(
+            _communicator.get(),
+            sendBuffer,
+            nextRank,
+            &receiveBuffer,
+            previousRank);
+
+        particles->removeParticles([&](size_t i) {
+            return owners[i] != rank;
+        });
+
+        unpackParticles(fromNext, particles);
+        unpackParticles(receiveBuffer, particles);
+    }
+}
+
+void ParticleSlabDecomposition3::exchangeHaloParticles(
+    const ParticleSystemData3& particles,
+    double radius,
+    ParticleSystemData3* halo) const {
+    JET_THROW_INVALID_ARG_IF(
+        halo->numberOfScalarData() > particles.numberOfScalarData()
+        || halo->numberOfVectorData() > particles.numberOfVectorData());
+
+    const int rank = _communicator->rank();
+    const int previousRank = (rank > 0) ? rank - 1 : kNoRank;
+    const int nextRank
+        = (rank + 1 < _communicator->size()) ? rank + 1 : kNoRank;
+
+    halo->resize(0);
+    halo->setRadius(particles.radius());
+    halo->setMass(particles.mass());
+    while (halo->numberOfScalarData() < particles.numberOfScalarData()) {
+        halo->addScalarData();
+    }
+    while (halo->numberOfVectorData() < particles.numberOfVectorData()) {
+        halo->addVectorData();
+    }
+
+    std::vector<size_t> backwardIndices;
+    std::vector<size_t> forwardIndices;
+    auto positions = particles.positions();
+    const double lower = zBegin() + radius;
+    const double upper = zEnd() - radius;
+    for (size_t i = 0; i < particles.numberOfParticles(); ++i) {
+        if (previousRank != kNoRank && positions[i].z < lower) {
+            backwardIndices.push_back(i);
+        }
+        if (nextRank != kNoRank && positions[i].z >= upper) {
+            forwardIndices.push_back(i);
+        }
+    }
+
+    std::vector<double> sendBuffer;
+    std::vector<double> receiveBuffer;
+
+    packParticles(particles, backwardIndices, &sendBuffer);
+    sendReceiveBuffer(
+        _communicator.get(),
+        sendBuffer,
+        previousRank,
+        &receiveBuffer,
+        nextRank);
+    unpackParticles(receiveBuffer, halo);
+
+    packParticles(particles, forwardIndices, &sendBuffer);
+    sendReceiveBuffer(
+        _communicator.get(),
+        sendBuffer,
+        nextRank,
+        &receiveBuffer,
+        previousRank);
+    unpackParticles(receiveBuffer, halo);
+}
+
+void ParticleSlabDecomposition3::rebalance(
+    const ParticleSystemData3& particles) {
+    const size_t numberOfRanks = _boundaries.size() - 1;
+    const double zMin = _boundaries[0];
+    const double zMax = _boundaries[numberOfRanks];
+    const double binWidth = (zMax - zMin) / kNumberOfRebalanceBins;
+
+    Array1<double> histogram(kNumberOfRebalanceBins, 0.0);
+    auto positions = particles.positions();
+    for (size_t i = 0; i < particles.numberOfParticles(); ++i) {
+        double bin = std::floor((positions[i].z - zMin) / binWidth);
+        bin = clamp(bin, 0.0, static_cast<double>(kNumberOfRebalanceBins - 1));
+        histogram[static_cast<size_t>(bin)] += 1.0;
+    }
+
+    _communicator->sum(histogram.accessor());
+
+    double total = 0.0;
+    for (size_t b = 0; b < kNumberOfRebalanceBins; ++b) {
+        total += histogram[b];
+    }
+    if (total == 0.0) {
+        return;
+    }
+
+    // Places the inner bounds at the quantiles, interpolating within the bin
+    size_t bin = 0;
+    double countBelowBin = 0.0;
+    for (size_t r = 1; r < numberOfRanks; ++r) {
+        const double target = total * r / numberOfRanks;
+        while (bin + 1 < kNumberOfRebalanceBins
+            && countBelowBin + histogram[bin] < target) {
+            countBelowBin += histogram[bin];
+            ++bin;
+        }
+
+        double fraction = 0.0;
+        if (histogram[bin] > 0.0) {
+            fraction = clamp(
+                (target - countBelowBin) / histogram[bin], 0.0, 1.0);
+        }
+        _boundaries[r] = zMin + (bin + fraction) * binWidth;
+    }
+}
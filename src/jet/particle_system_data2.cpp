@@ -1,10 +1,13 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/bounding_box2.h>
+#include <jet/memory_tracker.h>
 #include <jet/parallel.h>
 #include <jet/particle_system_data2.h>
 #include <jet/point_parallel_hash_grid_searcher2.h>
 #include <jet/timer.h>
+#include <neighbor_search_helpers.h>
 
 #include <algorithm>
 #include <vector>
@@ -13,6 +16,30 @@ using namespace jet;
 
 static const size_t kDefaultHashGridResolution = 64;
 
+// Number of Morton grid cells per axis (16 bits per axis, 32 bits per key).
+static const size_t kMortonResolution = 65536;
+static const size_t kMaxMortonKey = 0xffffffff;
+
+// Inserts a zero bit between each of the lower 16 bits of x.
+static size_t expandBits(size_t x) {
+    x &= 0xffff;
+    x = (x | (x << 8)) & 0x00ff00ff;
+    x = (x | (x << 4)) & 0x0f0f0f0f;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+template <typename T>
+static void permute(const Array1<size_t>& order, Array1<T>* data) {
+    Array1<T> sorted(data->size());
+    parallelFor(kZeroSize, order.size(),
+        [&](size_t i) {
+            sorted[i] = (*data)[order[i]];
+        });
+    data->swap(sorted);
+}
+
 ParticleSystemData2::ParticleSystemData2() {
 }
 
@@ -20,6 +47,7 @@ ParticleSystemData2::~ParticleSystemData2() {
 }
 
 void ParticleSystemData2::resize(size_t newNumberOfParticles) {
+    MemoryTagScope scope(MemoryTag::Particle);
     _positions.resize(newNumberOfParticles, Vector2D());
     _velocities.resize(newNumberOfParticles, Vector2D());
     _forces.resize(newNumberOfParticles, Vector2D());
@@ -38,12 +66,14 @@ size_t ParticleSystemData2::numberOfParticles() const {
 }
 
 size_t ParticleSystemData2::addScalarData(double initialVal) {
+    MemoryTagScope scope(MemoryTag::Particle);
     size_t attrIdx = _scalarDataList.size();
     _scalarDataList.emplace_back(numberOfParticles(), initialVal);
     return attrIdx;
 }
 
 size_t ParticleSystemData2::addVectorData(const Vector2D& initialVal) {
+    MemoryTagScope scope(MemoryTag::Particle);
     size_t attrIdx = _vectorDataList.size();
     _vectorDataList.emplace_back(numberOfParticles(), initialVal);
     return attrIdx;
@@ -111,6 +141,7 @@ void ParticleSystemData2::addParticle(
     const Vector2D& newPosition,
     const Vector2D& newVelocity,
     const Vector2D& newForce) {
+    MemoryTagScope scope(MemoryTag::Particle);
     Array1<Vector2D> newPositions = {newPosition};
     Array1<Vector2D> newVelocities = {newVelocity};
     Array1<Vector2D> newForces = {newForce};
@@ -125,6 +156,7 @@ void ParticleSystemData2::addParticles(
     const ConstArrayAccessor1<Vector2D>& newPositions,
     const ConstArrayAccessor1<Vector2D>& newVelocities,
     const ConstArrayAccessor1<Vector2D>& newForces) {
+    MemoryTagScope scope(MemoryTag::Particle);
     JET_THROW_INVALID_ARG_IF(
         newVelocities.size() > 0
         && newVelocities.size() != newPositions.size());
@@ -165,8 +197,7 @@ void ParticleSystemData2::setNeighborSearcher(
     _neighborSearcher = newNeighborSearcher;
 }
 
-const std::vector<std::vector<size_t>>&
-ParticleSystemData2::neighborLists() const {
+const PointNeighborLists& ParticleSystemData2::neighborLists() const {
     return _neighborLists;
 }
 
@@ -189,24 +220,93 @@ void ParticleSystemData2::buildNeighborSearcher(double maxSearchRadius) {
 void ParticleSystemData2::buildNeighborLists(double maxSearchRadius) {
     Timer timer;
 
-    _neighborLists.resize(numberOfParticles());
-
     auto points = positions();
-    for (size_t i = 0; i < numberOfParticles(); ++i) {
-        Vector2D origin = points[i];
-        _neighborLists[i].clear();
-
-        _neighborSearcher->forEachNearbyPoint(
-            origin,
-            maxSearchRadius,
-            [&](size_t j, const Vector2D&) {
-                if (i != j) {
-                    _neighborLists[i].push_back(j);
-                }
-            });
-    }
+    _neighborLists.build(
+        numberOfParticles(),
+        [&](size_t i) {
+            size_t count = 0;
+            forEachNearbyPoint(
+                *_neighborSearcher,
+                points[i],
+                maxSearchRadius,
+                [&](size_t j, const Vector2D&) {
+                    if (i != j) {
+                        ++count;
+                    }
+                });
+            return count;
+        },
+        [&](size_t i, uint32_t* neighbors) {
+            forEachNearbyPoint(
+                *_neighborSearcher,
+                points[i],
+                maxSearchRadius,
+                [&](size_t j, const Vector2D&) {
+                    if (i != j) {
+                        *(neighbors++) = static_cast<uint32_t>(j);
+                    }
+                });
+        });
 
     JET_INFO << "Building neighbor list took: "
              << timer.durationInSeconds()
              << " seconds";
 }
+
+void ParticleSystemData2::sortParticles() {
+    MemoryTagScope scope(MemoryTag::Particle);
+    Timer timer;
+
+    size_t n = numberOfParticles();
+    BoundingBox2D bound = parallelReduce(
+        kZeroSize, n, BoundingBox2D(),
+        [&](size_t begin, size_t end, BoundingBox2D partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.merge(_positions[i]);
+            }
+            return partial;
+        },
+        [](BoundingBox2D a, const BoundingBox2D& b) {
+            a.merge(b);
+            return a;
+        });
+
+    double maxExtent = std::max(bound.width(), bound.height());
+    double scale = (maxExtent > 0.0) ? kMortonResolution / maxExtent : 0.0;
+
+    std::vector<size_t> keys(n);
+    _sortedIndices.resize(n);
+    parallelFor(kZeroSize, n,
+        [&](size_t i) {
+            Vector2D p = (_positions[i] - bound.lowerCorner) * scale;
+            size_t x = std::min(
+                static_cast<size_t>(p.x), kMortonResolution - 1);
+            size_t y = std::min(
+                static_cast<size_t>(p.y), kMortonResolution - 1);
+            keys[i] = expandBits(x) | (expandBits(y) << 1);
+            _sortedIndices[i] = i;
+        });
+
+    parallelRadixSort(
+        keys.begin(), keys.end(), _sortedIndices.begin(), kMaxMortonKey);
+
+    permute(_sortedIndices, &_positions);
+    permute(_sortedIndices, &_velocities);
+    permute(_sortedIndices, &_forces);
+
+    for (auto& attr : _scalarDataList) {
+        permute(_sortedIndices, &attr);
+    }
+
+    for (auto& attr : _vectorDataList) {
+        permute(_sortedIndices, &attr);
+    }
+
+    JET_INFO << "Sorting particles took: "
+             << timer.durationInSeconds()
+             << " seconds";
+}
+
+ConstArrayAccessor1<size_t> ParticleSystemData2::sortedIndices() const {
+    return _sortedIndices.constAccessor();
+}
@@ -1,17 +1,146 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/bounding_box3.h>
+#include <jet/memory_tracker.h>
 #include <jet/parallel.h>
 #include <jet/particle_system_data3.h>
+#include <jet/point_cell_list_searcher3.h>
+#include <jet/point_hash_grid_utils.h>
 #include <jet/point_parallel_hash_grid_searcher3.h>
 #include <jet/timer.h>
+#include <morton_helpers.h>
+#include <neighbor_search_helpers.h>
+#include <serialization_helpers.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
 
 using namespace jet;
 
-static const size_t kDefaultHashGridResolution = 64;
+// Kinds of the neighbor searcher stored in the serialized stream.
+static const uint8_t kNoNeighborSearcher = 0;
+static const uint8_t kParallelHashGridSearcher = 1;
+static const uint8_t kCellListSearcher = 2;
+
+// Max number of cells per particle of the cell list searcher. Above it, the
+// particles are too sparse for the dense grid, and the hash grid is used.
+static const size_t kMaxCellListCellsPerParticle = 8;
+
+// Growth factor of the capacity when the particles do not fit.
+static const size_t kCapacityGrowthFactor = 2;
+
+// Number of particles per block of the parallel compaction.
+static const size_t kCompactionBlockSize = 4096;
+
+// Max ratio of the number of buckets of a reused searcher to the suggested.
+static const size_t kMaxHashGridShrinkFactor = 8;
+
+// Keeps a searcher that is at least as fine as suggested along each axis and
+// not much larger, so that small changes of the bounds do not rebuild it.
+static bool isHashGridResolutionReusable(
+    const Size3& resolution,
+    const Size3& suggestedResolution) {
+    return resolution.x >= suggestedResolution.x
+        && resolution.y >= suggestedResolution.y
+        && resolution.z >= suggestedResolution.z
+        && resolution.x * resolution.y * resolution.z
+            <= kMaxHashGridShrinkFactor * suggestedResolution.x
+                * suggestedResolution.y * suggestedResolution.z;
+}
+
+template <typename T>
+static void serializeDataList(
+    const std::vector<Array1<T>>& list,
+    std::ostream* strm) {
+    serializeValue(strm, static_cast<uint64_t>(list.size()));
+    for (const auto& data : list) {
+        data.serialize(strm);
+    }
+}
+
+template <typename T>
+static void deserializeDataList(
+    std::istream* strm,
+    size_t numberOfParticles,
+    std::vector<Array1<T>>* list) {
+    uint64_t numberOfData = 0;
+    deserializeValue(strm, &numberOfData);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+
+    list->resize(static_cast<size_t>(numberOfData));
+    for (auto& data : *list) {
+        data.deserialize(strm);
+        JET_THROW_INVALID_ARG_IF(
+            !(*strm) || data.size() != numberOfParticles);
+    }
+}
+
+template <typename T>
+static void permute(const Array1<size_t>& order, Array1<T>* data) {
+    Array1<T> sorted(data->size());
+    parallelFor(kZeroSize, order.size(),
+        [&](size_t i) {
+            sorted[i] = (*data)[order[i]];
+        });
+    data->swap(sorted);
+}
+
+// Moves the kept elements to the front. Since kept is increasing and
+// kept[i] >= i, each element is read before it is overwritten.
+template <typename T>
+static void compact(const std::vector<size_t>& kept, Array1<T>* data) {
+    for (size_t i = 0; i < kept.size(); ++i) {
+        (*data)[i] = (*data)[kept[i]];
+    }
+    data->resize(kept.size());
+}
+
+// Allocates the pending data layer filled with its value. The flag is
+// checked again under the lock, so the accessors only load it once the
+// layer is allocated.
+template <typename T>
+static void allocateLayer(
+    size_t numberOfParticles,
+    size_t capacity,
+    const T& value,
+    std::atomic<bool>* isPending,
+    std::mutex* mutex,
+    Array1<T>* data) {
+    if (isPending->load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(*mutex);
+        if (isPending->load(std::memory_order_relaxed)) {
+            MemoryTagScope scope(MemoryTag::Particle);
+            data->reserve(capacity);
+            data->resize(numberOfParticles, value);
+            isPending->store(false, std::memory_order_release);
+        }
+    }
+}
+
+// Since the new particles get zero in the data layers, a pending layer with
+// another value is allocated before the particles are added, and a pending
+// layer without particles takes zero.
+template <typename T, typename Allocate>
+static void preparePendingLayers(
+    size_t oldNumberOfParticles,
+    size_t newNumberOfParticles,
+    const std::deque<std::atomic<bool>>& isPending,
+    std::vector<T>* values,
+    const Allocate& allocate) {
+    for (size_t i = 0; i < values->size(); ++i) {
+        if (!isPending[i] || (*values)[i] == T()) {
+            continue;
+        }
+
+        if (newNumberOfParticles == 0) {
+            (*values)[i] = T();
+        } else if (newNumberOfParticles > oldNumberOfParticles) {
+            allocate(i);
+        }
+    }
+}
 
 ParticleSystemData3::ParticleSystemData3() {
 }
@@ -20,35 +149,126 @@ ParticleSystemData3::~ParticleSystemData3() {
 }
 
 void ParticleSystemData3::resize(size_t newNumberOfParticles) {
+    MemoryTagScope scope(MemoryTag::Particle);
+    preparePendingLayers(
+        numberOfParticles(), newNumberOfParticles, _isScalarDataPending,
+        &_scalarDataValues, [&](size_t i) { allocateScalarData(i); });
+    preparePendingLayers(
+        numberOfParticles(), newNumberOfParticles, _isVectorDataPending,
+        &_vectorDataValues, [&](size_t i) { allocateVectorData(i); });
+
+    if (newNumberOfParticles > capacity()) {
+        reserve(std::max(
+            newNumberOfParticles, kCapacityGrowthFactor * capacity()));
+    }
+
     _positions.resize(newNumberOfParticles, Vector3D());
     _velocities.resize(newNumberOfParticles, Vector3D());
     _forces.resize(newNumberOfParticles, Vector3D());
 
-    for (auto& attr : _scalarDataList) {
-        attr.resize(newNumberOfParticles, 0.0);
+    for (size_t i = 0; i < _scalarDataList.size(); ++i) {
+        if (!_isScalarDataPending[i]) {
+            _scalarDataList[i].resize(newNumberOfParticles, 0.0);
+        }
     }
 
-    for (auto& attr : _vectorDataList) {
-        attr.resize(newNumberOfParticles, Vector3D());
+    for (size_t i = 0; i < _vectorDataList.size(); ++i) {
+        if (!_isVectorDataPending[i]) {
+            _vectorDataList[i].resize(newNumberOfParticles, Vector3D());
+        }
     }
+
+    _neighborSearchPositions.clear();
 }
 
 size_t ParticleSystemData3::numberOfParticles() const {
     return _positions.size();
 }
 
+size_t ParticleSystemData3::capacity() const {
+    return _positions.capacity();
+}
+
+size_t ParticleSystemData3::memoryInBytes() const {
+    size_t memory
+        = (_positions.capacity() + _velocities.capacity()
+            + _forces.capacity() + _neighborSearchPositions.capacity())
+        * sizeof(Vector3D);
+
+    for (const auto& data : _scalarDataList) {
+        memory += data.capacity() * sizeof(double);
+    }
+
+    for (const auto& data : _vectorDataList) {
+        memory += data.capacity() * sizeof(Vector3D);
+    }
+
+    memory += _neighborLists.neighbors().capacity() * sizeof(uint32_t);
+    memory += _neighborLists.offsets().capacity() * sizeof(size_t);
+    memory += _sortedIndices.capacity() * sizeof(size_t);
+
+    return memory;
+}
+
+void ParticleSystemData3::reserve(size_t numberOfParticles) {
+    MemoryTagScope scope(MemoryTag::Particle);
+    _positions.reserve(numberOfParticles);
+    _velocities.reserve(numberOfParticles);
+    _forces.reserve(numberOfParticles);
+
+    // The pending layers reserve the capacity when they are allocated
+    for (size_t i = 0; i < _scalarDataList.size(); ++i) {
+        if (!_isScalarDataPending[i]) {
+            _scalarDataList[i].reserve(numberOfParticles);
+        }
+    }
+
+    for (size_t i = 0; i < _vectorDataList.size(); ++i) {
+        if (!_isVectorDataPending[i]) {
+            _vectorDataList[i].reserve(numberOfParticles);
+        }
+    }
+}
+
 size_t ParticleSystemData3::addScalarData(double initialVal) {
     size_t attrIdx = _scalarDataList.size();
-    _scalarDataList.emplace_back(numberOfParticles(), initialVal);
+    _scalarDataList.emplace_back();
+    _scalarDataValues.push_back(numberOfParticles() > 0 ? initialVal : 0.0);
+    _isScalarDataPending.emplace_back(true);
+    if (!_isUsingLazyAllocation) {
+        allocateScalarData(attrIdx);
+    }
     return attrIdx;
 }
 
 size_t ParticleSystemData3::addVectorData(const Vector3D& initialVal) {
     size_t attrIdx = _vectorDataList.size();
-    _vectorDataList.emplace_back(numberOfParticles(), initialVal);
+    _vectorDataList.emplace_back();
+    _vectorDataValues.push_back(
+        numberOfParticles() > 0 ? initialVal : Vector3D());
+    _isVectorDataPending.emplace_back(true);
+    if (!_isUsingLazyAllocation) {
+        allocateVectorData(attrIdx);
+    }
     return attrIdx;
 }
 
+bool ParticleSystemData3::isUsingLazyAllocation() const {
+    return _isUsingLazyAllocation;
+}
+
+void ParticleSystemData3::setIsUsingLazyAllocation(bool isUsing) {
+    _isUsingLazyAllocation = isUsing;
+}
+
+size_t ParticleSystemData3::numberOfScalarData() const {
+    return _scalarDataList.size();
+}
+
+size_t ParticleSystemData3::numberOfVectorData() const {
+    return _vectorDataList.size();
+}
+
 double ParticleSystemData3::radius() const {
     return _radius;
 }
@@ -89,21 +309,34 @@ ArrayAccessor1<Vector3D> ParticleSystemData3::forces() {
     return _forces.accessor();
 }
 
+void ParticleSystemData3::swapPositionsAndVelocities(
+    VectorData* newPositions, VectorData* newVelocities) {
+    JET_ASSERT(newPositions->size() == numberOfParticles());
+    JET_ASSERT(newVelocities->size() == numberOfParticles());
+
+    _positions.swap(*newPositions);
+    _velocities.swap(*newVelocities);
+}
+
 ConstArrayAccessor1<double> ParticleSystemData3::scalarDataAt(
     size_t idx) const {
+    allocateScalarData(idx);
     return _scalarDataList[idx].constAccessor();
 }
 
 ArrayAccessor1<double> ParticleSystemData3::scalarDataAt(size_t idx) {
+    allocateScalarData(idx);
     return _scalarDataList[idx].accessor();
 }
 
 ConstArrayAccessor1<Vector3D> ParticleSystemData3::vectorDataAt(
     size_t idx) const {
+    allocateVectorData(idx);
     return _vectorDataList[idx].constAccessor();
 }
 
 ArrayAccessor1<Vector3D> ParticleSystemData3::vectorDataAt(size_t idx) {
+    allocateVectorData(idx);
     return _vectorDataList[idx].accessor();
 }
 
@@ -111,6 +344,7 @@ void ParticleSystemData3::addParticle(
     const Vector3D& newPosition,
     const Vector3D& newVelocity,
     const Vector3D& newForce) {
+    MemoryTagScope scope(MemoryTag::Particle);
     Array1<Vector3D> newPositions = {newPosition};
     Array1<Vector3D> newVelocities = {newVelocity};
     Array1<Vector3D> newForces = {newForce};
@@ -125,6 +359,7 @@ void ParticleSystemData3::addParticles(
     const ConstArrayAccessor1<Vector3D>& newPositions,
     const ConstArrayAccessor1<Vector3D>& newVelocities,
     const ConstArrayAccessor1<Vector3D>& newForces) {
+    MemoryTagScope scope(MemoryTag::Particle);
     JET_THROW_INVALID_ARG_IF(
         newVelocities.size() > 0
         && newVelocities.size() != newPositions.size());
@@ -156,6 +391,148 @@ void ParticleSystemData3::addParticles(
     }
 }
 
+void ParticleSystemData3::addParticles(
+    Array1<Vector3D>&& newPositions,
+    Array1<Vector3D>&& newVelocities,
+    Array1<Vector3D>&& newForces) {
+    if (numberOfParticles() > 0) {
+        addParticles(
+            newPositions.constAccessor(),
+            newVelocities.constAccessor(),
+            newForces.constAccessor());
+        newPositions.clear();
+        newVelocities.clear();
+        newForces.clear();
+        return;
+    }
+
+    MemoryTagScope scope(MemoryTag::Particle);
+    JET_THROW_INVALID_ARG_IF(
+        newVelocities.size() > 0
+        && newVelocities.size() != newPositions.size());
+    JET_THROW_INVALID_ARG_IF(
+        newForces.size() > 0 && newForces.size() != newPositions.size());
+
+    const size_t newNumberOfParticles = newPositions.size();
+    _positions = std::move(newPositions);
+    _velocities = std::move(newVelocities);
+    _forces = std::move(newForces);
+
+    // Fills the arrays that were not given and the custom data layers
+    resize(newNumberOfParticles);
+}
+
+size_t ParticleSystemData3::removeParticles(
+    const std::function<bool(size_t)>& shouldRemove) {
+    const size_t n = numberOfParticles();
+    const size_t numberOfBlocks
+        = (n + kCompactionBlockSize - 1) / kCompactionBlockSize;
+
+    // Counts the remaining particles per block, and writes their indices at
+    // the prefix sum of the counts
+    std::vector<char> isRemoved(n);
+    std::vector<size_t> blockOffsets(numberOfBlocks + 1, 0);
+    parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+        size_t end = std::min((b + 1) * kCompactionBlockSize, n);
+        size_t count = 0;
+        for (size_t i = b * kCompactionBlockSize; i < end; ++i) {
+            isRemoved[i] = shouldRemove(i);
+            count += !isRemoved[i];
+        }
+        blockOffsets[b + 1] = count;
+    });
+    for (size_t b = 0; b < numberOfBlocks; ++b) {
+        blockOffsets[b + 1] += blockOffsets[b];
+    }
+
+    const size_t numberOfRemaining = blockOffsets[numberOfBlocks];
+    if (numberOfRemaining == n) {
+        return 0;
+    }
+
+    std::vector<size_t> kept(numberOfRemaining);
+    parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+        size_t end = std::min((b + 1) * kCompactionBlockSize, n);
+        size_t dst = blockOffsets[b];
+        for (size_t i = b * kCompactionBlockSize; i < end; ++i) {
+            if (!isRemoved[i]) {
+                kept[dst++] = i;
+            }
+        }
+    });
+
+    // The data layers are compacted in parallel with each other
+    const size_t numberOfScalarData = _scalarDataList.size();
+    const size_t numberOfLayers
+        = 3 + numberOfScalarData + _vectorDataList.size();
+    parallelFor(kZeroSize, numberOfLayers, [&](size_t layer) {
+        if (layer == 0) {
+            compact(kept, &_positions);
+        } else if (layer == 1) {
+            compact(kept, &_velocities);
+        } else if (layer == 2) {
+            compact(kept, &_forces);
+        } else if (layer < 3 + numberOfScalarData) {
+            if (!_isScalarDataPending[layer - 3]) {
+                compact(kept, &_scalarDataList[layer - 3]);
+            }
+        } else {
+            size_t idx = layer - 3 - numberOfScalarData;
+            if (!_isVectorDataPending[idx]) {
+                compact(kept, &_vectorDataList[idx]);
+            }
+        }
+    });
+    preparePendingLayers(
+        n, numberOfRemaining, _isScalarDataPending, &_scalarDataValues,
+        [](size_t) {});
+    preparePendingLayers(
+        n, numberOfRemaining, _isVectorDataPending, &_vectorDataValues,
+        [](size_t) {});
+
+    if (_sortedIndices.size() == n) {
+        compact(kept, &_sortedIndices);
+    } else {
+        _sortedIndices.clear();
+    }
+
+    _neighborSearchPositions.clear();
+
+    return n - numberOfRemaining;
+}
+
+void ParticleSystemData3::beginAppend(size_t maxNumberOfNewParticles) {
+    _appendBegin = numberOfParticles();
+    _appendEnd = _appendBegin + maxNumberOfNewParticles;
+    _appendCount.store(0, std::memory_order_relaxed);
+    resize(_appendEnd);
+}
+
+size_t ParticleSystemData3::claimAppendSlots(
+    size_t count,
+    size_t* firstIndex) {
+    const size_t maxCount = _appendEnd - _appendBegin;
+    size_t oldCount = _appendCount.load(std::memory_order_relaxed);
+    size_t claimed = 0;
+    do {
+        claimed = std::min(count, maxCount - oldCount);
+    } while (claimed > 0
+             && !_appendCount.compare_exchange_weak(
+                 oldCount, oldCount + claimed, std::memory_order_relaxed));
+
+    *firstIndex = _appendBegin + oldCount;
+    return claimed;
+}
+
+size_t ParticleSystemData3::endAppend() {
+    // The workers have joined by now, so the count is final
+    const size_t count = _appendCount.load(std::memory_order_relaxed);
+    resize(_appendBegin + count);
+    _appendBegin = _appendEnd = 0;
+    _appendCount.store(0, std::memory_order_relaxed);
+    return count;
+}
+
 const PointNeighborSearcher3Ptr& ParticleSystemData3::neighborSearcher() const {
     return _neighborSearcher;
 }
@@ -163,24 +540,114 @@ const PointNeighborSearcher3Ptr& ParticleSystemData3::neighborSearcher() const {
 void ParticleSystemData3::setNeighborSearcher(
     const PointNeighborSearcher3Ptr& newNeighborSearcher) {
     _neighborSearcher = newNeighborSearcher;
+    _neighborSearchPositions.clear();
 }
 
-const std::vector<std::vector<size_t>>&
-ParticleSystemData3::neighborLists() const {
+const PointNeighborLists& ParticleSystemData3::neighborLists() const {
     return _neighborLists;
 }
 
 void ParticleSystemData3::buildNeighborSearcher(double maxSearchRadius) {
     Timer timer;
 
-    // Use PointParallelHashGridSearcher3 by default
-    _neighborSearcher = std::make_shared<PointParallelHashGridSearcher3>(
-        kDefaultHashGridResolution,
-        kDefaultHashGridResolution,
-        kDefaultHashGridResolution,
-        2.0 * maxSearchRadius);
+    const size_t n = numberOfParticles();
+    const double searchRadius = maxSearchRadius + _neighborSearchSkin;
+    const double gridSpacing = 2.0 * searchRadius;
+    auto cellListSearcher
+        = std::dynamic_pointer_cast<PointCellListSearcher3>(_neighborSearcher);
+    auto hashGridSearcher
+        = std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(
+            _neighborSearcher);
+
+    // The buckets and the lists stay valid while every particle is within
+    // half of the skin from where it was at the last rebuild. This is tested
+    // before the resolution suggested from the current bounds, which can
+    // change with any move across a cell boundary.
+    const bool isSearchRadiusSame
+        = (cellListSearcher != nullptr
+           && cellListSearcher->cellSize() == searchRadius)
+        || (hashGridSearcher != nullptr
+            && hashGridSearcher->gridSpacing() == gridSpacing);
+    if (isSearchRadiusSame
+        && _neighborSearchSkin > 0.0
+        && _neighborSearchPositions.size() == n) {
+        double maxDisplacementSquared = parallelReduce(
+            kZeroSize, n, 0.0,
+            [&](size_t begin, size_t end, double partial) {
+                for (size_t i = begin; i < end; ++i) {
+                    partial = std::max(
+                        partial,
+                        _positions[i].distanceSquaredTo(
+                            _neighborSearchPositions[i]));
+                }
+                return partial;
+            },
+            [](double a, double b) {
+                return std::max(a, b);
+            });
+
+        if (maxDisplacementSquared < square(0.5 * _neighborSearchSkin)) {
+            if (cellListSearcher != nullptr) {
+                cellListSearcher->updatePointPositions(positions());
+            } else {
+                hashGridSearcher->updatePointPositions(positions());
+            }
+
+            JET_INFO << "Updating neighbor searcher positions took: "
+                     << timer.durationInSeconds()
+                     << " seconds";
+            return;
+        }
+    }
 
-    _neighborSearcher->build(positions());
+    // The cell list has cells of the search radius on a dense grid, which
+    // is used unless the particles are sparse in their bounding box
+    const Size3 cellListResolution
+        = cellListResolution3(positions(), searchRadius);
+    const bool isUsingCellList = n > 0
+        && static_cast<double>(cellListResolution.x)
+            * static_cast<double>(cellListResolution.y)
+            * static_cast<double>(cellListResolution.z)
+            <= static_cast<double>(kMaxCellListCellsPerParticle * n);
+
+    Size3 resolution;
+    bool isReusable = false;
+    if (isUsingCellList) {
+        isReusable = cellListSearcher != nullptr
+            && cellListSearcher->cellSize() == searchRadius;
+    } else {
+        resolution = suggestedHashGridResolution3(positions(), gridSpacing);
+        isReusable = hashGridSearcher != nullptr
+            && hashGridSearcher->gridSpacing() == gridSpacing
+            && isHashGridResolutionReusable(
+                hashGridSearcher->resolution(), resolution);
+    }
+
+    if (isUsingCellList) {
+        // The grid follows the bounds of the particles at each build
+        if (!isReusable) {
+            cellListSearcher
+                = std::make_shared<PointCellListSearcher3>(searchRadius);
+            _neighborSearcher = cellListSearcher;
+        }
+        cellListSearcher->build(positions());
+    } else if (isReusable) {
+        hashGridSearcher->update(positions());
+    } else {
+        _neighborSearcher = std::make_shared<PointParallelHashGridSearcher3>(
+            resolution, gridSpacing);
+
+        _neighborSearcher->build(positions());
+    }
+
+    if (_neighborSearchSkin > 0.0) {
+        _neighborSearchPositions.resize(n);
+        parallelFor(kZeroSize, n,
+            [&](size_t i) {
+                _neighborSearchPositions[i] = _positions[i];
+            });
+    }
+    ++_neighborSearcherRevision;
 
     JET_INFO << "Building neighbor searcher took: "
              << timer.durationInSeconds()
@@ -190,24 +657,229 @@ void ParticleSystemData3::buildNeighborSearcher(double maxSearchRadius) {
 void ParticleSystemData3::buildNeighborLists(double maxSearchRadius) {
     Timer timer;
 
-    _neighborLists.resize(numberOfParticles());
+    if (_neighborSearchSkin > 0.0
+        && _neighborListsRevision == _neighborSearcherRevision
+        && _neighborListsRadius == maxSearchRadius
+        && _neighborLists.size() == numberOfParticles()
+        && _neighborSearchPositions.size() == numberOfParticles()) {
+        JET_INFO << "Neighbor lists are still valid within the skin";
+        return;
+    }
 
+    const double searchRadius = maxSearchRadius + _neighborSearchSkin;
     auto points = positions();
-    for (size_t i = 0; i < numberOfParticles(); ++i) {
-        Vector3D origin = points[i];
-        _neighborLists[i].clear();
-
-        _neighborSearcher->forEachNearbyPoint(
-            origin,
-            maxSearchRadius,
-            [&](size_t j, const Vector3D&) {
-                if (i != j) {
-                    _neighborLists[i].push_back(j);
-                }
-            });
-    }
+    _neighborLists.build(
+        numberOfParticles(),
+        [&](size_t i) {
+            size_t count = 0;
+            forEachNearbyPoint(
+                *_neighborSearcher,
+                points[i],
+                searchRadius,
+                [&](size_t j, const Vector3D&) {
+                    if (i != j) {
+                        ++count;
+                    }
+                });
+            return count;
+        },
+        [&](size_t i, uint32_t* neighbors) {
+            forEachNearbyPoint(
+                *_neighborSearcher,
+                points[i],
+                searchRadius,
+                [&](size_t j, const Vector3D&) {
+                    if (i != j) {
+                        *(neighbors++) = static_cast<uint32_t>(j);
+                    }
+                });
+        });
+    _neighborListsRevision = _neighborSearcherRevision;
+    _neighborListsRadius = maxSearchRadius;
 
     JET_INFO << "Building neighbor list took: "
              << timer.durationInSeconds()
              << " seconds";
 }
+
+double ParticleSystemData3::neighborSearchSkin() const {
+    return _neighborSearchSkin;
+}
+
+void ParticleSystemData3::setNeighborSearchSkin(double skin) {
+    _neighborSearchSkin = std::max(skin, 0.0);
+    _neighborSearchPositions.clear();
+}
+
+void ParticleSystemData3::sortParticles() {
+    MemoryTagScope scope(MemoryTag::Particle);
+    Timer timer;
+
+    size_t n = numberOfParticles();
+    BoundingBox3D bound = parallelReduce(
+        kZeroSize, n, BoundingBox3D(),
+        [&](size_t begin, size_t end, BoundingBox3D partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.merge(_positions[i]);
+            }
+            return partial;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+
+    double scale = mortonScale3(bound);
+
+    std::vector<size_t> keys(n);
+    _sortedIndices.resize(n);
+    parallelFor(kZeroSize, n,
+        [&](size_t i) {
+            keys[i] = mortonKey3(bound, scale, _positions[i]);
+            _sortedIndices[i] = i;
+        });
+
+    parallelRadixSort(
+        keys.begin(), keys.end(), _sortedIndices.begin(), kMaxMortonKey3);
+
+    permute(_sortedIndices, &_positions);
+    permute(_sortedIndices, &_velocities);
+    permute(_sortedIndices, &_forces);
+
+    for (size_t i = 0; i < _scalarDataList.size(); ++i) {
+        if (!_isScalarDataPending[i]) {
+            permute(_sortedIndices, &_scalarDataList[i]);
+        }
+    }
+
+    for (size_t i = 0; i < _vectorDataList.size(); ++i) {
+        if (!_isVectorDataPending[i]) {
+            permute(_sortedIndices, &_vectorDataList[i]);
+        }
+    }
+
+    _neighborSearchPositions.clear();
+
+    JET_INFO << "Sorting particles took: "
+             << timer.durationInSeconds()
+             << " seconds";
+}
+
+ConstArrayAccessor1<size_t> ParticleSystemData3::sortedIndices() const {
+    return _sortedIndices.constAccessor();
+}
+
+void ParticleSystemData3::serialize(std::ostream* strm) const {
+    serializeSectionTag(strm, "ParticleSystemData3");
+    serializeValue(strm, _radius);
+    serializeValue(strm, _mass);
+
+    _positions.serialize(strm);
+    _velocities.serialize(strm);
+    _forces.serialize(strm);
+    allocatePendingData();
+    serializeDataList(_scalarDataList, strm);
+    serializeDataList(_vectorDataList, strm);
+    _sortedIndices.serialize(strm);
+
+    // Other searcher types are not known here, so only the default ones are
+    // written with their settings
+    auto hashGridSearcher
+        = std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(
+            _neighborSearcher);
+    auto cellListSearcher
+        = std::dynamic_pointer_cast<PointCellListSearcher3>(_neighborSearcher);
+    if (cellListSearcher != nullptr) {
+        serializeValue(strm, kCellListSearcher);
+        serializeValue(strm, cellListSearcher->cellSize());
+    } else if (hashGridSearcher != nullptr) {
+        Size3 res = hashGridSearcher->resolution();
+        uint64_t res64[3] = { res.x, res.y, res.z };
+        serializeValue(strm, kParallelHashGridSearcher);
+        serializeValue(strm, res64);
+        serializeValue(strm, hashGridSearcher->gridSpacing());
+    } else {
+        serializeValue(strm, kNoNeighborSearcher);
+    }
+}
+
+void ParticleSystemData3::deserialize(std::istream* strm) {
+    MemoryTagScope scope(MemoryTag::Particle);
+    JET_THROW_INVALID_ARG_IF(
+        !deserializeSectionTag(strm, "ParticleSystemData3"));
+    deserializeValue(strm, &_radius);
+    deserializeValue(strm, &_mass);
+
+    _positions.deserialize(strm);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    size_t n = _positions.size();
+
+    _velocities.deserialize(strm);
+    _forces.deserialize(strm);
+    JET_THROW_INVALID_ARG_IF(
+        !(*strm) || _velocities.size() != n || _forces.size() != n);
+    deserializeDataList(strm, n, &_scalarDataList);
+    deserializeDataList(strm, n, &_vectorDataList);
+    _scalarDataValues.assign(_scalarDataList.size(), 0.0);
+    _vectorDataValues.assign(_vectorDataList.size(), Vector3D());
+    _isScalarDataPending.clear();
+    _isVectorDataPending.clear();
+    for (size_t i = 0; i < _scalarDataList.size(); ++i) {
+        _isScalarDataPending.emplace_back(false);
+    }
+    for (size_t i = 0; i < _vectorDataList.size(); ++i) {
+        _isVectorDataPending.emplace_back(false);
+    }
+    _sortedIndices.deserialize(strm);
+    _neighborSearchPositions.clear();
+
+    uint8_t searcherKind = kNoNeighborSearcher;
+    deserializeValue(strm, &searcherKind);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    if (searcherKind == kParallelHashGridSearcher) {
+        uint64_t res64[3];
+        double gridSpacing = 0.0;
+        deserializeValue(strm, &res64);
+        deserializeValue(strm, &gridSpacing);
+        JET_THROW_INVALID_ARG_IF(!(*strm));
+
+        _neighborSearcher = std::make_shared<PointParallelHashGridSearcher3>(
+            static_cast<size_t>(res64[0]),
+            static_cast<size_t>(res64[1]),
+            static_cast<size_t>(res64[2]),
+            gridSpacing);
+        _neighborSearcher->build(positions());
+    } else if (searcherKind == kCellListSearcher) {
+        double cellSize = 0.0;
+        deserializeValue(strm, &cellSize);
+        JET_THROW_INVALID_ARG_IF(!(*strm));
+
+        _neighborSearcher = std::make_shared<PointCellListSearcher3>(cellSize);
+        _neighborSearcher->build(positions());
+    } else {
+        JET_THROW_INVALID_ARG_IF(searcherKind != kNoNeighborSearcher);
+    }
+}
+
+void ParticleSystemData3::allocateScalarData(size_t idx) const {
+    allocateLayer(
+        numberOfParticles(), capacity(), _scalarDataValues[idx],
+        &_isScalarDataPending[idx], &_pendingDataMutex,
+        &_scalarDataList[idx]);
+}
+
+void ParticleSystemData3::allocateVectorData(size_t idx) const {
+    allocateLayer(
+        numberOfParticles(), capacity(), _vectorDataValues[idx],
+        &_isVectorDataPending[idx], &_pendingDataMutex,
+        &_vectorDataList[idx]);
+}
+
+void ParticleSystemData3::allocatePendingData() const {
+    for (size_t i = 0; i < _scalarDataList.size(); ++i) {
+        allocateScalarData(i);
+    }
+    for (size_t i = 0; i < _vectorDataList.size(); ++i) {
+        allocateVectorData(i);
+    }
+}
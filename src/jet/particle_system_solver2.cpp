@@ -66,6 +66,16 @@ void ParticleSystemSolver2::setWind(const VectorField2Ptr& newWind) {
     _wind = newWind;
 }
 
+unsigned int ParticleSystemSolver2::particleSortingInterval() const {
+    return _particleSortingInterval;
+}
+
+void ParticleSystemSolver2::setParticleSortingInterval(
+    unsigned int newInterval) {
+    _particleSortingInterval = newInterval;
+    _numberOfStepsSinceLastSort = 0;
+}
+
 void ParticleSystemSolver2::onAdvanceTimeStep(double timeStepInSeconds) {
     beginAdvanceTimeStep(timeStepInSeconds);
 
@@ -84,6 +94,13 @@ void ParticleSystemSolver2::accumulateForces(double timeStepInSeconds) {
 }
 
 void ParticleSystemSolver2::beginAdvanceTimeStep(double timeStepInSeconds) {
+    // Restore spatial locality of the particle data
+    if (_particleSortingInterval > 0
+        && ++_numberOfStepsSinceLastSort >= _particleSortingInterval) {
+        _particleSystemData->sortParticles();
+        _numberOfStepsSinceLastSort = 0;
+    }
+
     // Allocate buffers
     size_t n = _particleSystemData->numberOfParticles();
     _newPositions.resize(n);
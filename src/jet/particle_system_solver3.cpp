@@ -6,11 +6,103 @@
 #include <jet/constant_vector_field3.h>
 #include <jet/parallel.h>
 #include <jet/particle_system_solver3.h>
+#include <jet/profiler.h>
+#include <serialization_helpers.h>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
 
 namespace jet {
 
+// Number of particles whose wind is sampled in a single call
+static const size_t kFieldSamplingBlockSize = 128;
+
+template <typename Callback>
+void ParticleSystemSolver3::parallelForEachActiveParticle(
+    const Callback& callback) const {
+    if (_isAllActive) {
+        parallelFor(
+            kZeroSize, _particleSystemData->numberOfParticles(), callback);
+    } else {
+        parallelFor(kZeroSize, _activeIndices.size(), [&] (size_t a) {
+            callback(_activeIndices[a]);
+        });
+    }
+}
+
+// Calls back with the gravity and the drag force of each active particle.
+// The gravity-only and the constant wind cases, including the default wind,
+// skip the wind sampling, and the other fields are sampled in blocks.
+template <typename Callback>
+void ParticleSystemSolver3::forEachExternalForce(
+    const Callback& callback) const {
+    auto velocities = _particleSystemData->velocities();
+    auto positions = _particleSystemData->positions();
+    const double mass = _particleSystemData->mass();
+    const double dragCoefficient = _dragCoefficient;
+    const Vector3D gravityForce = mass * _gravity;
+
+    if (dragCoefficient == 0.0) {
+        parallelForEachActiveParticle([&] (size_t i) {
+            callback(i, gravityForce);
+        });
+        return;
+    }
+
+    auto constantWind = std::dynamic_pointer_cast<ConstantVectorField3>(_wind);
+    if (constantWind != nullptr) {
+        const Vector3D wind = constantWind->value();
+        parallelForEachActiveParticle([&] (size_t i) {
+            Vector3D force = gravityForce;
+            Vector3D relativeVel = velocities[i] - wind;
+            force += -dragCoefficient * relativeVel;
+            callback(i, force);
+        });
+        return;
+    }
+
+    // The wind is sampled in blocks, so a field with a costly per-call
+    // overhead, such as a user function, is called once per block
+    const size_t numberOfActiveParticles = _isAllActive
+        ? _particleSystemData->numberOfParticles() : _activeIndices.size();
+    const size_t numberOfBlocks
+        = (numberOfActiveParticles + kFieldSamplingBlockSize - 1)
+        / kFieldSamplingBlockSize;
+
+    parallelFor(kZeroSize, numberOfBlocks, [&] (size_t block) {
+        size_t begin = block * kFieldSamplingBlockSize;
+        size_t end = std::min(
+            begin + kFieldSamplingBlockSize, numberOfActiveParticles);
+
+        std::array<size_t, kFieldSamplingBlockSize> indices;
+        std::array<Vector3D, kFieldSamplingBlockSize> x;
+        std::array<Vector3D, kFieldSamplingBlockSize> wind;
+        for (size_t a = begin; a < end; ++a) {
+            indices[a - begin] = _isAllActive ? a : _activeIndices[a];
+            x[a - begin] = positions[indices[a - begin]];
+        }
+
+        _wind->batchSample(
+            ConstArrayAccessor1<Vector3D>(end - begin, x.data()),
+            ArrayAccessor1<Vector3D>(end - begin, wind.data()));
+
+        for (size_t b = 0; b < end - begin; ++b) {
+            size_t i = indices[b];
+
+            // Gravity
+            Vector3D force = gravityForce;
+
+            // Wind forces
+            Vector3D relativeVel = velocities[i] - wind[b];
+            force += -dragCoefficient * relativeVel;
+
+            callback(i, force);
+        }
+    });
+}
+
 ParticleSystemSolver3::ParticleSystemSolver3() {
     _particleSystemData = std::make_shared<ParticleSystemData3>();
     _wind = std::make_shared<ConstantVectorField3>(Vector3D());
@@ -66,14 +158,140 @@ void ParticleSystemSolver3::setWind(const VectorField3Ptr& newWind) {
     _wind = newWind;
 }
 
+unsigned int ParticleSystemSolver3::particleSortingInterval() const {
+    return _particleSortingInterval;
+}
+
+void ParticleSystemSolver3::setParticleSortingInterval(
+    unsigned int newInterval) {
+    _particleSortingInterval = newInterval;
+    _numberOfStepsSinceLastSort = 0;
+}
+
+double ParticleSystemSolver3::sleepingSpeedThreshold() const {
+    return _sleepingSpeedThreshold;
+}
+
+void ParticleSystemSolver3::setSleepingSpeedThreshold(double newThreshold) {
+    _sleepingSpeedThreshold = std::max(newThreshold, 0.0);
+}
+
+unsigned int ParticleSystemSolver3::numberOfStepsToSleep() const {
+    return _numberOfStepsToSleep;
+}
+
+void ParticleSystemSolver3::setNumberOfStepsToSleep(
+    unsigned int newNumberOfSteps) {
+    _numberOfStepsToSleep = std::max(newNumberOfSteps, 1u);
+}
+
+size_t ParticleSystemSolver3::numberOfActiveParticles() const {
+    return _isAllActive
+        ? _particleSystemData->numberOfParticles() : _activeIndices.size();
+}
+
+bool ParticleSystemSolver3::isUsingFusedStep() const {
+    return _isUsingFusedStep;
+}
+
+void ParticleSystemSolver3::setIsUsingFusedStep(bool isUsing) {
+    _isUsingFusedStep = isUsing;
+}
+
+ParticleSystemSolver3::TimeIntegrator
+ParticleSystemSolver3::timeIntegrator() const {
+    return _timeIntegrator;
+}
+
+void ParticleSystemSolver3::setTimeIntegrator(TimeIntegrator integrator) {
+    _timeIntegrator = integrator;
+}
+
+void ParticleSystemSolver3::serialize(std::ostream* strm) const {
+    PhysicsAnimation::serialize(strm);
+
+    serializeSectionTag(strm, "ParticleSystemSolver3");
+    uint32_t particleSortingInterval = _particleSortingInterval;
+    uint32_t numberOfStepsSinceLastSort = _numberOfStepsSinceLastSort;
+    serializeValue(strm, _dragCoefficient);
+    serializeValue(strm, _restitutionCoefficient);
+    serializeValue(strm, _gravity);
+    serializeValue(strm, particleSortingInterval);
+    serializeValue(strm, numberOfStepsSinceLastSort);
+    serializeValue(strm, _sleepingSpeedThreshold);
+    serializeValue(strm, static_cast<uint32_t>(_numberOfStepsToSleep));
+    _quietStepCounts.serialize(strm);
+    _particleSystemData->serialize(strm);
+}
+
+void ParticleSystemSolver3::deserialize(std::istream* strm) {
+    PhysicsAnimation::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(
+        !deserializeSectionTag(strm, "ParticleSystemSolver3"));
+    uint32_t particleSortingInterval = 0;
+    uint32_t numberOfStepsSinceLastSort = 0;
+    deserializeValue(strm, &_dragCoefficient);
+    deserializeValue(strm, &_restitutionCoefficient);
+    deserializeValue(strm, &_gravity);
+    deserializeValue(strm, &particleSortingInterval);
+    deserializeValue(strm, &numberOfStepsSinceLastSort);
+    uint32_t numberOfStepsToSleep = 0;
+    deserializeValue(strm, &_sleepingSpeedThreshold);
+    deserializeValue(strm, &numberOfStepsToSleep);
+    _quietStepCounts.deserialize(strm);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    _particleSortingInterval = particleSortingInterval;
+    _numberOfStepsSinceLastSort = numberOfStepsSinceLastSort;
+    _numberOfStepsToSleep = numberOfStepsToSleep;
+    _particleSystemData->deserialize(strm);
+}
+
 void ParticleSystemSolver3::onAdvanceTimeStep(double timeStepInSeconds) {
-    beginAdvanceTimeStep(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("beginAdvanceTimeStep");
+        beginAdvanceTimeStep(timeStepInSeconds);
+    }
 
-    accumulateForces(timeStepInSeconds);
-    timeIntegration(timeStepInSeconds);
-    resolveCollision();
+    if (isUsingFusedPasses()) {
+        if (hasCustomForces()) {
+            JET_PROFILE_SCOPE("accumulateForces");
+            accumulateForces(timeStepInSeconds);
+        }
+
+        {
+            JET_PROFILE_SCOPE("fusedTimeIntegration");
+            fusedTimeIntegration(timeStepInSeconds);
+        }
+    } else {
+        {
+            JET_PROFILE_SCOPE("accumulateForces");
+            accumulateForces(timeStepInSeconds);
+        }
+
+        {
+            JET_PROFILE_SCOPE("timeIntegration");
+            timeIntegration(timeStepInSeconds);
+        }
+
+        {
+            JET_PROFILE_SCOPE("resolveCollision");
+            resolveCollision();
+        }
+    }
 
-    endAdvanceTimeStep(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("endAdvanceTimeStep");
+        endAdvanceTimeStep(timeStepInSeconds);
+    }
+}
+
+void ParticleSystemSolver3::collectStatistics(
+    SubTimeStepStatistics* stats) const {
+    stats->numberOfParticles = _particleSystemData->numberOfParticles();
+    stats->numberOfNeighbors
+        = _particleSystemData->neighborLists().neighbors().size();
+    stats->memoryInBytes = _particleSystemData->memoryInBytes();
 }
 
 void ParticleSystemSolver3::accumulateForces(double timeStepInSeconds) {
@@ -83,31 +301,79 @@ void ParticleSystemSolver3::accumulateForces(double timeStepInSeconds) {
     accumulateExternalForces();
 }
 
+bool ParticleSystemSolver3::hasCustomForces() const {
+    return false;
+}
+
 void ParticleSystemSolver3::beginAdvanceTimeStep(double timeStepInSeconds) {
+    // Restore spatial locality of the particle data
+    bool isReordered = false;
+    if (_particleSortingInterval > 0
+        && ++_numberOfStepsSinceLastSort >= _particleSortingInterval) {
+        _particleSystemData->sortParticles();
+        _numberOfStepsSinceLastSort = 0;
+        isReordered = true;
+    }
+
+    // The first drift of the leapfrog, so the forces are computed at the
+    // middle of the step
+    if (isUsingLeapfrog()) {
+        auto positions = _particleSystemData->positions();
+        auto velocities = _particleSystemData->velocities();
+        const double halfTimeStep = 0.5 * timeStepInSeconds;
+        parallelFor(
+            kZeroSize,
+            _particleSystemData->numberOfParticles(),
+            [&] (size_t i) {
+                positions[i] += halfTimeStep * velocities[i];
+            });
+        resolveCollision(positions, velocities);
+    }
+
     // Allocate buffers
     size_t n = _particleSystemData->numberOfParticles();
     _newPositions.resize(n);
     _newVelocities.resize(n);
 
-    // Clear forces
-    auto forces = _particleSystemData->forces();
-    setRange1(forces.size(), Vector3D(), &forces);
+    // Clear forces, unless the fused pass computes them on the fly
+    if (!isUsingFusedPasses() || hasCustomForces()) {
+        auto forces = _particleSystemData->forces();
+        setRange1(forces.size(), Vector3D(), &forces);
+    }
 
     onBeginAdvanceTimeStep(timeStepInSeconds);
+
+    // After the subclass has built the neighbor lists for this step
+    updateActiveParticles(isReordered);
 }
 
 void ParticleSystemSolver3::endAdvanceTimeStep(double timeStepInSeconds) {
+    // All the particles are awake, so the new state replaces the old one
+    if (isUsingFusedPasses()) {
+        _particleSystemData->swapPositionsAndVelocities(
+            &_newPositions, &_newVelocities);
+        onEndAdvanceTimeStep(timeStepInSeconds);
+        return;
+    }
+
     // Update data
-    size_t n = _particleSystemData->numberOfParticles();
     auto positions = _particleSystemData->positions();
     auto velocities = _particleSystemData->velocities();
-    parallelFor(
-        kZeroSize,
-        n,
-        [&] (size_t i) {
-            positions[i] = _newPositions[i];
-            velocities[i] = _newVelocities[i];
-        });
+    const double threshold = _sleepingSpeedThreshold;
+    parallelForEachActiveParticle([&] (size_t i) {
+        if (threshold > 0.0) {
+            bool isQuiet = _newVelocities[i].length() < threshold
+                && (_newVelocities[i] - velocities[i]).length() < threshold;
+            if (!isQuiet) {
+                _quietStepCounts[i] = 0;
+            } else if (_quietStepCounts[i] < _numberOfStepsToSleep) {
+                ++_quietStepCounts[i];
+            }
+        }
+
+        positions[i] = _newPositions[i];
+        velocities[i] = _newVelocities[i];
+    });
 
     onEndAdvanceTimeStep(timeStepInSeconds);
 }
@@ -130,19 +396,15 @@ void ParticleSystemSolver3::resolveCollision(
     ArrayAccessor1<Vector3D> newPositions,
     ArrayAccessor1<Vector3D> newVelocities) {
     if (_collider != nullptr) {
-        size_t numberOfParticles = _particleSystemData->numberOfParticles();
         const double radius = _particleSystemData->radius();
 
-        parallelFor(
-            kZeroSize,
-            numberOfParticles,
-            [&] (size_t i) {
-                _collider->resolveCollision(
-                    radius,
-                    _restitutionCoefficient,
-                    &newPositions[i],
-                    &newVelocities[i]);
-            });
+        parallelForEachActiveParticle([&] (size_t i) {
+            _collider->resolveCollision(
+                radius,
+                _restitutionCoefficient,
+                &newPositions[i],
+                &newVelocities[i]);
+        });
     }
 }
 
@@ -151,48 +413,128 @@ void ParticleSystemSolver3::setParticleSystemData(
     _particleSystemData = newParticles;
 }
 
+double ParticleSystemSolver3::positionUpdateFraction() const {
+    return isUsingLeapfrog() ? 0.5 : 1.0;
+}
+
 void ParticleSystemSolver3::accumulateExternalForces() {
-    size_t n = _particleSystemData->numberOfParticles();
+    auto forces = _particleSystemData->forces();
+    forEachExternalForce([&] (size_t i, const Vector3D& force) {
+        forces[i] += force;
+    });
+}
+
+void ParticleSystemSolver3::timeIntegration(double timeStepInSeconds) {
     auto forces = _particleSystemData->forces();
     auto velocities = _particleSystemData->velocities();
     auto positions = _particleSystemData->positions();
     const double mass = _particleSystemData->mass();
+    const double positionTimeStep
+        = positionUpdateFraction() * timeStepInSeconds;
+
+    parallelForEachActiveParticle([&] (size_t i) {
+        // Integrate velocity first
+        Vector3D& newVelocity = _newVelocities[i];
+        newVelocity = velocities[i]
+            + timeStepInSeconds * forces[i] / mass;
+
+        // Integrate position.
+        Vector3D& newPosition = _newPositions[i];
+        newPosition = positions[i] + positionTimeStep * newVelocity;
+    });
+}
 
-    parallelFor(
-        kZeroSize,
-        n,
-        [&] (size_t i) {
-            // Gravity
-            Vector3D force = mass * _gravity;
-
-            // Wind forces
-            Vector3D relativeVel = velocities[i] - _wind->sample(positions[i]);
-            force += -_dragCoefficient * relativeVel;
+bool ParticleSystemSolver3::isUsingFusedPasses() const {
+    return _isUsingFusedStep && _sleepingSpeedThreshold <= 0.0;
+}
 
-            forces[i] += force;
-        });
+bool ParticleSystemSolver3::isUsingLeapfrog() const {
+    return _timeIntegrator == TimeIntegrator::Leapfrog
+        && _sleepingSpeedThreshold <= 0.0;
 }
 
-void ParticleSystemSolver3::timeIntegration(double timeStepInSeconds) {
-    size_t n = _particleSystemData->numberOfParticles();
+void ParticleSystemSolver3::fusedTimeIntegration(double timeStepInSeconds) {
     auto forces = _particleSystemData->forces();
     auto velocities = _particleSystemData->velocities();
     auto positions = _particleSystemData->positions();
     const double mass = _particleSystemData->mass();
-
-    parallelFor(
-        kZeroSize,
-        n,
-        [&] (size_t i) {
-            // Integrate velocity first
-            Vector3D& newVelocity = _newVelocities[i];
-            newVelocity = velocities[i]
-                + timeStepInSeconds * forces[i] / mass;
-
-            // Integrate position.
-            Vector3D& newPosition = _newPositions[i];
-            newPosition = positions[i] + timeStepInSeconds * newVelocity;
+    const double radius = _particleSystemData->radius();
+    const double positionTimeStep
+        = positionUpdateFraction() * timeStepInSeconds;
+
+    // Same arithmetic as accumulateExternalForces, timeIntegration, and
+    // resolveCollision, so the results do not change with the fused pass
+    auto integrate = [&] (size_t i, const Vector3D& force) {
+        Vector3D newVelocity
+            = velocities[i] + timeStepInSeconds * force / mass;
+        Vector3D newPosition
+            = positions[i] + positionTimeStep * newVelocity;
+
+        if (_collider != nullptr) {
+            _collider->resolveCollision(
+                radius,
+                _restitutionCoefficient,
+                &newPosition,
+                &newVelocity);
+        }
+
+        _newVelocities[i] = newVelocity;
+        _newPositions[i] = newPosition;
+    };
+
+    if (hasCustomForces()) {
+        parallelForEachActiveParticle([&] (size_t i) {
+            integrate(i, forces[i]);
         });
+    } else {
+        forEachExternalForce(integrate);
+    }
+}
+
+void ParticleSystemSolver3::updateActiveParticles(bool isReordered) {
+    size_t n = _particleSystemData->numberOfParticles();
+    if (_sleepingSpeedThreshold <= 0.0) {
+        _isAllActive = true;
+        _activeIndices.clear();
+        _quietStepCounts.clear();
+        return;
+    }
+
+    // The counts are per index, so they restart when the indices change
+    if (isReordered || _quietStepCounts.size() != n) {
+        _quietStepCounts.resize(n);
+        _quietStepCounts.set(0);
+    }
+
+    auto isSleepy = [&] (size_t i) {
+        return _quietStepCounts[i] >= _numberOfStepsToSleep;
+    };
+
+    // Neighbors of the awake particles stay awake
+    const PointNeighborLists& neighborLists
+        = _particleSystemData->neighborLists();
+    const bool hasNeighborLists = neighborLists.size() == n;
+    std::vector<char> isActive(n);
+    parallelFor(kZeroSize, n, [&] (size_t i) {
+        bool active = !isSleepy(i);
+        if (!active && hasNeighborLists) {
+            for (uint32_t j : neighborLists[i]) {
+                if (!isSleepy(j)) {
+                    active = true;
+                    break;
+                }
+            }
+        }
+        isActive[i] = active;
+    });
+
+    _activeIndices.clear();
+    for (size_t i = 0; i < n; ++i) {
+        if (isActive[i]) {
+            _activeIndices.append(i);
+        }
+    }
+    _isAllActive = _activeIndices.size() == n;
 }
 
 }  // namespace jet
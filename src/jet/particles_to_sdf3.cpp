@@ -0,0 +1,480 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/math_utils.h>
+#include <jet/matrix3x3.h>
+#include <jet/parallel.h>
+#include <jet/particles_to_sdf3.h>
+#include <jet/point_hash_grid_utils.h>
+#include <jet/point_neighbor_lists.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
+#include <jet/sph_kernels3.h>
+#include <jet/timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+using namespace jet;
+
+// Number of nodes along each axis of a tile
+static const size_t kTileSize = 8;
+
+// Max number of Jacobi sweeps, which converges in a few sweeps for 3x3
+static const unsigned int kMaxNumberOfJacobiSweeps = 32;
+
+namespace {
+
+struct AnisotropicKernel3 {
+    Vector3D center;
+    Matrix3x3D transform;
+    Vector3D halfExtent;
+    double weight = 0.0;
+};
+
+}  // namespace
+
+// Computes the eigenvalues and the eigenvectors (the columns of rotation) of
+// the symmetric matrix with cyclic Jacobi rotations.
+static void eigenDecompose(
+    const Matrix3x3D& matrix, Matrix3x3D* rotation, Vector3D* eigenvalues) {
+    double a[3][3];
+    double v[3][3];
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            a[i][j] = matrix(i, j);
+            v[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    const double scale = std::fabs(a[0][0]) + std::fabs(a[1][1])
+        + std::fabs(a[2][2]);
+    for (unsigned int sweep = 0; sweep < kMaxNumberOfJacobiSweeps; ++sweep) {
+        double offDiagonal = std::fabs(a[0][1]) + std::fabs(a[0][2])
+            + std::fabs(a[1][2]);
+        if (offDiagonal <= kEpsilonD * scale) {
+            break;
+        }
+
+        for (size_t p = 0; p < 2; ++p) {
+            for (size_t q = p + 1; q < 3; ++q) {
+                if (a[p][q] == 0.0) {
+                    continue;
+                }
+
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = 1.0 / (std::fabs(theta)
+                    + std::sqrt(theta * theta + 1.0));
+                if (theta < 0.0) {
+                    t = -t;
+                }
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (size_t k = 0; k < 3; ++k) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (size_t k = 0; k < 3; ++k) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (size_t k = 0; k < 3; ++k) {
+                    double vkp = v[k][p];
+                    double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        (*eigenvalues)[i] = a[i][i];
+        for (size_t j = 0; j < 3; ++j) {
+            (*rotation)(i, j) = v[i][j];
+        }
+    }
+}
+
+ParticlesToSdf3::ParticlesToSdf3(double kernelRadius, double cutOffDensity) {
+    setKernelRadius(kernelRadius);
+    setCutOffDensity(cutOffDensity);
+}
+
+double ParticlesToSdf3::kernelRadius() const {
+    return _kernelRadius;
+}
+
+void ParticlesToSdf3::setKernelRadius(double kernelRadius) {
+    JET_THROW_INVALID_ARG_IF(!(kernelRadius > 0.0));
+    _kernelRadius = kernelRadius;
+}
+
+double ParticlesToSdf3::cutOffDensity() const {
+    return _cutOffDensity;
+}
+
+void ParticlesToSdf3::setCutOffDensity(double cutOffDensity) {
+    _cutOffDensity = cutOffDensity;
+}
+
+bool ParticlesToSdf3::isUsingAnisotropicKernels() const {
+    return _isUsingAnisotropicKernels;
+}
+
+void ParticlesToSdf3::setIsUsingAnisotropicKernels(bool isUsing) {
+    _isUsingAnisotropicKernels = isUsing;
+}
+
+size_t ParticlesToSdf3::minNumberOfNeighbors() const {
+    return _minNumberOfNeighbors;
+}
+
+void ParticlesToSdf3::setMinNumberOfNeighbors(size_t n) {
+    _minNumberOfNeighbors = n;
+}
+
+double ParticlesToSdf3::maxAnisotropyRatio() const {
+    return _maxAnisotropyRatio;
+}
+
+void ParticlesToSdf3::setMaxAnisotropyRatio(double ratio) {
+    _maxAnisotropyRatio = std::max(ratio, 1.0);
+}
+
+double ParticlesToSdf3::positionSmoothingFactor() const {
+    return _positionSmoothingFactor;
+}
+
+void ParticlesToSdf3::setPositionSmoothingFactor(double factor) {
+    _positionSmoothingFactor = clamp(factor, 0.0, 1.0);
+}
+
+void ParticlesToSdf3::convert(
+    const ConstArrayAccessor1<Vector3D>& points, ScalarGrid3* sdf) const {
+    JET_THROW_INVALID_ARG_IF(sdf == nullptr);
+
+    Timer timer;
+
+    const size_t numberOfPoints = points.size();
+    const double h = _kernelRadius;
+    const double neighborRadius = h;
+    const bool isAnisotropic = _isUsingAnisotropicKernels;
+
+    // The neighbors within the kernel radius are used for both the covariance
+    // and the densities. Since the kernel radius is the support radius, this
+    // is close to twice the smoothing length in the paper.
+    PointNeighborLists neighborLists;
+    if (numberOfPoints > 0) {
+        const double gridSpacing = 2.0 * neighborRadius;
+        PointParallelHashGridSearcher3 searcher(
+            suggestedHashGridResolution3(points, gridSpacing), gridSpacing);
+        searcher.build(points);
+
+        neighborLists.build(
+            numberOfPoints,
+            [&](size_t i) {
+                size_t count = 0;
+                searcher.forEachNearbyPoint(
+                    points[i],
+                    neighborRadius,
+                    [&](size_t j, const Vector3D&) {
+                        if (i != j) {
+                            ++count;
+                        }
+                    });
+                return count;
+            },
+            [&](size_t i, uint32_t* neighbors) {
+                searcher.forEachNearbyPoint(
+                    points[i],
+                    neighborRadius,
+                    [&](size_t j, const Vector3D&) {
+                        if (i != j) {
+                            *(neighbors++) = static_cast<uint32_t>(j);
+                        }
+                    });
+            });
+    }
+
+    // Kernel centers and shapes from the weighted neighborhoods
+    std::vector<AnisotropicKernel3> kernels(numberOfPoints);
+    parallelFor(kZeroSize, numberOfPoints, [&](size_t i) {
+        AnisotropicKernel3& kernel = kernels[i];
+        const Vector3D& xi = points[i];
+        const auto neighbors = neighborLists[i];
+
+        kernel.center = xi;
+        kernel.transform = Matrix3x3D::makeScaleMatrix(1.0 / h, 1.0 / h,
+                                                       1.0 / h);
+        kernel.halfExtent = Vector3D(h, h, h);
+
+        if (!isAnisotropic) {
+            return;
+        }
+
+        // Weighted mean including the particle itself
+        double weightSum = 1.0;
+        Vector3D mean = xi;
+        for (uint32_t j : neighbors) {
+            double q = points[j].distanceTo(xi) / neighborRadius;
+            double w = std::max(1.0 - q * q * q, 0.0);
+            weightSum += w;
+            mean += w * points[j];
+        }
+        mean /= weightSum;
+
+        kernel.center = (1.0 - _positionSmoothingFactor) * xi
+            + _positionSmoothingFactor * mean;
+
+        if (neighbors.size() < _minNumberOfNeighbors) {
+            return;
+        }
+
+        Matrix3x3D covariance = Matrix3x3D::makeZero();
+        {
+            Vector3D r = xi - mean;
+            for (size_t a = 0; a < 3; ++a) {
+                for (size_t b = 0; b < 3; ++b) {
+                    covariance(a, b) += r[a] * r[b];
+                }
+            }
+        }
+        for (uint32_t j : neighbors) {
+            double q = points[j].distanceTo(xi) / neighborRadius;
+            double w = std::max(1.0 - q * q * q, 0.0);
+            Vector3D r = points[j] - mean;
+            for (size_t a = 0; a < 3; ++a) {
+                for (size_t b = 0; b < 3; ++b) {
+                    covariance(a, b) += w * r[a] * r[b];
+                }
+            }
+        }
+        covariance /= weightSum;
+
+        Matrix3x3D rotation;
+        Vector3D sigma;
+        eigenDecompose(covariance, &rotation, &sigma);
+
+        double maxSigma = std::max(std::max(sigma.x, sigma.y), sigma.z);
+        if (!(maxSigma > 0.0)) {
+            return;
+        }
+
+        // Clamps the short axes and keeps the kernel volume of the
+        // isotropic one, so the determinant of the transform is 1 / h^3
+        const double minSigma = maxSigma / _maxAnisotropyRatio;
+        for (size_t k = 0; k < 3; ++k) {
+            sigma[k] = std::max(sigma[k], minSigma);
+        }
+        sigma /= std::cbrt(sigma.x * sigma.y * sigma.z);
+
+        Matrix3x3D transform = Matrix3x3D::makeZero();
+        for (size_t a = 0; a < 3; ++a) {
+            for (size_t b = 0; b < 3; ++b) {
+                for (size_t k = 0; k < 3; ++k) {
+                    transform(a, b) += rotation(a, k) * rotation(b, k)
+                        / (h * sigma[k]);
+                }
+            }
+        }
+        kernel.transform = transform;
+
+        for (size_t a = 0; a < 3; ++a) {
+            double extentSquared = 0.0;
+            for (size_t k = 0; k < 3; ++k) {
+                extentSquared += square(rotation(a, k) * sigma[k]);
+            }
+            kernel.halfExtent[a] = h * std::sqrt(extentSquared);
+        }
+    });
+
+    // Each kernel is normalized by the isotropic density at its center, so
+    // the field is about 1 inside the fluid. det(G) = 1 / h^3 for all kernels.
+    const SphStdKernel3 densityKernel(h);
+    const double kernelScale = 315.0 / (64.0 * kPiD * h * h * h);
+    parallelFor(kZeroSize, numberOfPoints, [&](size_t i) {
+        const Vector3D& ci = kernels[i].center;
+        double density = densityKernel(0.0);
+        for (uint32_t j : neighborLists[i]) {
+            density += densityKernel(ci.distanceTo(kernels[j].center));
+        }
+        kernels[i].weight = kernelScale / density;
+    });
+
+    // Bins the kernels into the tiles their footprints overlap
+    const Size3 size = sdf->dataSize();
+    const Vector3D origin = sdf->dataOrigin();
+    const Vector3D dx = sdf->gridSpacing();
+    const Size3 numberOfTiles(
+        (size.x + kTileSize - 1) / kTileSize,
+        (size.y + kTileSize - 1) / kTileSize,
+        (size.z + kTileSize - 1) / kTileSize);
+    const size_t totalNumberOfTiles
+        = numberOfTiles.x * numberOfTiles.y * numberOfTiles.z;
+
+    // Returns false if the footprint misses the grid, otherwise the
+    // inclusive node range of the footprint
+    auto getNodeRange = [&](
+        const AnisotropicKernel3& kernel, Size3* lower, Size3* upper) {
+        for (size_t a = 0; a < 3; ++a) {
+            if (size[a] == 0) {
+                return false;
+            }
+            double lo = (kernel.center[a] - kernel.halfExtent[a] - origin[a])
+                / dx[a];
+            double hi = (kernel.center[a] + kernel.halfExtent[a] - origin[a])
+                / dx[a];
+            if (hi < 0.0 || lo > static_cast<double>(size[a] - 1)) {
+                return false;
+            }
+            (*lower)[a] = static_cast<size_t>(std::ceil(std::max(lo, 0.0)));
+            (*upper)[a] = static_cast<size_t>(
+                std::floor(std::min(hi, static_cast<double>(size[a] - 1))));
+            if ((*lower)[a] > (*upper)[a]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto forEachOverlappingTile = [&](
+        const AnisotropicKernel3& kernel,
+        const std::function<void(size_t)>& func) {
+        Size3 lower, upper;
+        if (!getNodeRange(kernel, &lower, &upper)) {
+            return;
+        }
+        for (size_t k = lower.z / kTileSize; k <= upper.z / kTileSize; ++k) {
+            for (size_t j = lower.y / kTileSize; j <= upper.y / kTileSize;
+                 ++j) {
+                for (size_t i = lower.x / kTileSize;
+                     i <= upper.x / kTileSize; ++i) {
+                    func(i + numberOfTiles.x * (j + numberOfTiles.y * k));
+                }
+            }
+        }
+    };
+
+    // Bins the (tile, kernel) pairs with the stable radix sort, so the
+    // kernels of each tile stay in the particle order and the sums do not
+    // depend on the number of threads
+    std::vector<size_t> pairOffsets(numberOfPoints + 1, 0);
+    parallelFor(kZeroSize, numberOfPoints, [&](size_t p) {
+        size_t count = 0;
+        forEachOverlappingTile(kernels[p], [&](size_t) {
+            ++count;
+        });
+        pairOffsets[p + 1] = count;
+    });
+    for (size_t p = 0; p < numberOfPoints; ++p) {
+        pairOffsets[p + 1] += pairOffsets[p];
+    }
+
+    const size_t numberOfPairs = pairOffsets[numberOfPoints];
+    std::vector<size_t> tileKeys(numberOfPairs);
+    std::vector<size_t> tileKernels(numberOfPairs);
+    parallelFor(kZeroSize, numberOfPoints, [&](size_t p) {
+        size_t cursor = pairOffsets[p];
+        forEachOverlappingTile(kernels[p], [&](size_t tile) {
+            tileKeys[cursor] = tile;
+            tileKernels[cursor] = p;
+            ++cursor;
+        });
+    });
+    if (totalNumberOfTiles > 0) {
+        parallelRadixSort(
+            tileKeys.begin(),
+            tileKeys.end(),
+            tileKernels.begin(),
+            totalNumberOfTiles - 1);
+    }
+
+    std::vector<size_t> tileOffsets(totalNumberOfTiles + 1, numberOfPairs);
+    parallelFor(kZeroSize, totalNumberOfTiles, [&](size_t tile) {
+        tileOffsets[tile] = static_cast<size_t>(
+            std::lower_bound(tileKeys.begin(), tileKeys.end(), tile)
+            - tileKeys.begin());
+    });
+
+    // Splats the kernels tile by tile
+    const double cutOff = _cutOffDensity;
+    const size_t tileVolume = kTileSize * kTileSize * kTileSize;
+    parallelFor(kZeroSize, totalNumberOfTiles, [&](size_t tile) {
+        const Size3 tileIndex(
+            tile % numberOfTiles.x,
+            (tile / numberOfTiles.x) % numberOfTiles.y,
+            tile / (numberOfTiles.x * numberOfTiles.y));
+        const Size3 begin = tileIndex * kTileSize;
+        const Size3 end(
+            std::min(begin.x + kTileSize, size.x),
+            std::min(begin.y + kTileSize, size.y),
+            std::min(begin.z + kTileSize, size.z));
+
+        double field[tileVolume];
+        std::fill(field, field + tileVolume, 0.0);
+
+        for (size_t t = tileOffsets[tile]; t < tileOffsets[tile + 1]; ++t) {
+            const AnisotropicKernel3& kernel = kernels[tileKernels[t]];
+            Size3 lower, upper;
+            getNodeRange(kernel, &lower, &upper);
+            lower = Size3(
+                std::max(lower.x, begin.x),
+                std::max(lower.y, begin.y),
+                std::max(lower.z, begin.z));
+            upper = Size3(
+                std::min(upper.x, end.x - 1),
+                std::min(upper.y, end.y - 1),
+                std::min(upper.z, end.z - 1));
+
+            // The transformed offset changes by a constant step along x, so
+            // it is only transformed once per row
+            const Matrix3x3D& transform = kernel.transform;
+            const Vector3D step = dx.x * Vector3D(
+                transform(0, 0), transform(1, 0), transform(2, 0));
+            for (size_t k = lower.z; k <= upper.z; ++k) {
+                for (size_t j = lower.y; j <= upper.y; ++j) {
+                    Vector3D r = origin
+                        + dx * Vector3D(static_cast<double>(lower.x),
+                                        static_cast<double>(j),
+                                        static_cast<double>(k))
+                        - kernel.center;
+                    Vector3D q = transform.mul(r);
+                    double* row = field + (lower.x - begin.x)
+                        + kTileSize * ((j - begin.y)
+                        + kTileSize * (k - begin.z));
+                    for (size_t i = lower.x; i <= upper.x; ++i) {
+                        double q2 = q.lengthSquared();
+                        if (q2 < 1.0) {
+                            *row += kernel.weight * cubic(1.0 - q2);
+                        }
+                        q += step;
+                        ++row;
+                    }
+                }
+            }
+        }
+
+        for (size_t k = begin.z; k < end.z; ++k) {
+            for (size_t j = begin.y; j < end.y; ++j) {
+                for (size_t i = begin.x; i < end.x; ++i) {
+                    size_t local = (i - begin.x)
+                        + kTileSize * ((j - begin.y)
+                        + kTileSize * (k - begin.z));
+                    (*sdf)(i, j, k) = cutOff - field[local];
+                }
+            }
+        }
+    });
+
+    JET_INFO << "Converting " << numberOfPoints << " particles to SDF with "
+             << tileKernels.size() << " tile-kernel pairs took "
+             << timer.durationInSeconds() << " seconds";
+}
@@ -5,8 +5,12 @@
 #include <jet/parallel.h>
 #include <jet/pci_sph_solver3.h>
 #include <jet/sph_kernels3.h>
+#include <serialization_helpers.h>
+#include <sph_kernel_helpers.h>
+#include <sph_pair_helpers.h>
 
 #include <algorithm>
+#include <cstdint>
 
 using namespace jet;
 
@@ -34,6 +38,79 @@ void PciSphSolver3::setMaxNumberOfIterations(unsigned int n) {
     _maxNumberOfIterations = n;
 }
 
+PciSphSolver3::PressureWarmStart PciSphSolver3::pressureWarmStart() const {
+    return _pressureWarmStart;
+}
+
+void PciSphSolver3::setPressureWarmStart(PressureWarmStart warmStart) {
+    _pressureWarmStart = warmStart;
+}
+
+bool PciSphSolver3::isUsingActiveSet() const {
+    return _isUsingActiveSet;
+}
+
+void PciSphSolver3::setIsUsingActiveSet(bool isUsing) {
+    _isUsingActiveSet = isUsing;
+}
+
+size_t PciSphSolver3::lastNumberOfParticleUpdates() const {
+    return _lastNumberOfParticleUpdates;
+}
+
+unsigned int PciSphSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double PciSphSolver3::lastDensityErrorRatio() const {
+    return _lastDensityErrorRatio;
+}
+
+void PciSphSolver3::serialize(std::ostream* strm) const {
+    SphSolver3::serialize(strm);
+
+    serializeSectionTag(strm, "PciSphSolver3");
+    uint32_t maxNumberOfIterations = _maxNumberOfIterations;
+    serializeValue(strm, _maxDensityErrorRatio);
+    serializeValue(strm, maxNumberOfIterations);
+    serializeValue(strm, static_cast<uint32_t>(_pressureWarmStart));
+    serializeValue(strm, static_cast<uint64_t>(_previousPressureDataId));
+    serializeValue(strm, static_cast<uint8_t>(_isUsingActiveSet));
+}
+
+void PciSphSolver3::deserialize(std::istream* strm) {
+    SphSolver3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "PciSphSolver3"));
+    uint32_t maxNumberOfIterations = 0;
+    uint32_t pressureWarmStart = 0;
+    uint64_t storedPreviousPressureDataId = 0;
+    uint8_t isUsingActiveSet = 0;
+    deserializeValue(strm, &_maxDensityErrorRatio);
+    deserializeValue(strm, &maxNumberOfIterations);
+    deserializeValue(strm, &pressureWarmStart);
+    deserializeValue(strm, &storedPreviousPressureDataId);
+    deserializeValue(strm, &isUsingActiveSet);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+    JET_THROW_INVALID_ARG_IF(
+        pressureWarmStart
+        > static_cast<uint32_t>(PressureWarmStart::Extrapolated));
+
+    // The layer of the previous pressures is restored with the particles
+    size_t previousPressureDataId
+        = (storedPreviousPressureDataId == static_cast<uint64_t>(kMaxSize))
+        ? kMaxSize : static_cast<size_t>(storedPreviousPressureDataId);
+    JET_THROW_INVALID_ARG_IF(
+        previousPressureDataId != kMaxSize
+        && previousPressureDataId
+            >= particleSystemData()->numberOfScalarData());
+
+    _maxNumberOfIterations = maxNumberOfIterations;
+    _pressureWarmStart = static_cast<PressureWarmStart>(pressureWarmStart);
+    _previousPressureDataId = previousPressureDataId;
+    _isUsingActiveSet = isUsingActiveSet != 0;
+}
+
 void PciSphSolver3::accumulatePressureForce(
     double timeIntervalInSeconds) {
     auto particles = sphSystemData();
@@ -41,6 +118,7 @@ void PciSphSolver3::accumulatePressureForce(
     const double delta = computeDelta(timeIntervalInSeconds);
     const double targetDensity = particles->targetDensity();
     const double mass = particles->mass();
+    const double negativeScale = negativePressureScale();
 
     auto p = particles->pressures();
     auto d = particles->densities();
@@ -53,78 +131,245 @@ void PciSphSolver3::accumulatePressureForce(
 
     SphStdKernel3 kernel(particles->kernelRadius());
 
+    // The extrapolation starts from the previous pressures, so the first
+    // step after enabling it does not take the missing ones as zero
+    const bool isExtrapolating
+        = _pressureWarmStart == PressureWarmStart::Extrapolated;
+    if (isExtrapolating && _previousPressureDataId == kMaxSize) {
+        _previousPressureDataId = particles->addScalarData();
+        auto pp = particles->scalarDataAt(_previousPressureDataId);
+        parallelFor(kZeroSize, numberOfParticles, [&] (size_t i) {
+            pp[i] = p[i];
+        });
+    }
+
     // Initialize buffers
+    const bool isWarmStarting = _pressureWarmStart != PressureWarmStart::None;
+    ArrayAccessor1<double> pp;
+    if (isExtrapolating) {
+        pp = particles->scalarDataAt(_previousPressureDataId);
+    }
     parallelFor(
         kZeroSize,
         numberOfParticles,
         [&] (size_t i) {
-            p[i] = 0.0;
+            if (isExtrapolating) {
+                double previous = pp[i];
+                pp[i] = p[i];
+                p[i] = 2.0 * p[i] - previous;
+            } else if (!isWarmStarting) {
+                p[i] = 0.0;
+            }
             _pressureForces[i] = Vector3D();
             _densityErrors[i] = 0.0;
             ds[i] = d[i];
         });
 
+    // The first prediction includes the force of the initial pressures
+    if (isWarmStarting) {
+        SphSolver3::accumulatePressureForce(
+            x, d, p, _pressureForces.accessor());
+    }
+
     unsigned int maxNumIter = 0;
-    double maxDensityError;
+    double maxDensityError = 0.0;
     double densityErrorRatio = 0.0;
+    const double positionTimeStep
+        = positionUpdateFraction() * timeIntervalInSeconds;
+
+    // The first iteration updates all particles, and the later ones only
+    // the active set when it is enabled
+    bool isFullIteration = true;
+    size_t numberOfUpdates = 0;
+    const double maxDensityErrorThreshold
+        = _maxDensityErrorRatio * targetDensity;
+    const double particleRadius = particles->radius();
+    const auto& neighborLists = particles->neighborLists();
 
     for (unsigned int k = 0; k < _maxNumberOfIterations; ++k) {
-        // Predict velocity and position
-        parallelFor(
-            kZeroSize,
-            numberOfParticles,
-            [&] (size_t i) {
+        if (isFullIteration) {
+            // Predict velocity and position
+            parallelFor(
+                kZeroSize,
+                numberOfParticles,
+                [&] (size_t i) {
+                    _tempVelocities[i]
+                        = v[i]
+                        + timeIntervalInSeconds / mass
+                        * (f[i] + _pressureForces[i]);
+                    _tempPositions[i]
+                        = x[i] + positionTimeStep * _tempVelocities[i];
+                });
+
+            // Resolve collisions
+            resolveCollision(
+                _tempPositions,
+                _tempVelocities);
+
+            // Compute predicted number density
+            if (const auto halfLists = halfNeighborLists()) {
+                _weightSums.set(kernel(0));
+                halfLists->forEachParticle([&] (size_t i) {
+                    forEachNeighborBatch(
+                        _tempPositions.constAccessor(),
+                        _tempPositions[i],
+                        (*halfLists)[i],
+                        [&] (SphNeighborBatch3& batch) {
+                            sphStdKernelWeights(
+                                kernel,
+                                batch.distanceSquared,
+                                batch.size,
+                                batch.weight);
+                            double weightSum = 0.0;
+                            for (size_t k = 0; k < batch.size; ++k) {
+                                weightSum += batch.weight[k];
+                                _weightSums[batch.index[k]] += batch.weight[k];
+                            }
+                            _weightSums[i] += weightSum;
+                        });
+                });
+            } else {
+                parallelFor(
+                    kZeroSize,
+                    numberOfParticles,
+                    [&] (size_t i) {
+                        double weightSum = 0.0;
+                        forEachNeighborBatch(
+                            _tempPositions.constAccessor(),
+                            _tempPositions[i],
+                            particles->neighborLists()[i],
+                            [&] (SphNeighborBatch3& batch) {
+                                sphStdKernelWeights(
+                                    kernel,
+                                    batch.distanceSquared,
+                                    batch.size,
+                                    batch.weight);
+                                for (size_t k = 0; k < batch.size; ++k) {
+                                    weightSum += batch.weight[k];
+                                }
+                            });
+                        _weightSums[i] = weightSum + kernel(0);
+                    });
+            }
+
+            // Add number density from boundary particles
+            if (boundaryParticles() != nullptr) {
+                const double boundaryScale = targetDensity / mass;
+                parallelFor(
+                    kZeroSize,
+                    numberOfParticles,
+                    [&] (size_t i) {
+                        _weightSums[i] += boundaryScale
+                            * boundaryParticles()->sumOfKernelNearby(
+                                _tempPositions[i]);
+                    });
+            }
+
+            // Compute pressure from density error, and max density error
+            maxDensityError = parallelReduce(
+                kZeroSize,
+                numberOfParticles,
+                0.0,
+                [&] (size_t begin, size_t end, double partial) {
+                    for (size_t i = begin; i < end; ++i) {
+                        double density = mass * _weightSums[i];
+                        double densityError = (density - targetDensity);
+                        double pressure = delta * densityError;
+
+                        if (pressure < 0.0) {
+                            pressure *= negativeScale;
+                            densityError *= negativeScale;
+                        }
+
+                        p[i] += pressure;
+                        ds[i] = density;
+                        _densityErrors[i] = densityError;
+                        partial = absmax(partial, densityError);
+                    }
+                    return partial;
+                },
+                [] (double a, double b) {
+                    return absmax(a, b);
+                });
+
+            // Compute pressure gradient force
+            _pressureForces.set(Vector3D());
+            SphSolver3::accumulatePressureForce(
+                x, ds.constAccessor(), p, _pressureForces.accessor());
+
+            numberOfUpdates += numberOfParticles;
+        } else {
+            // Same as the full iteration over the active set, with the
+            // other particles keeping their last prediction
+            const size_t activeSize = _activeSet.size();
+            parallelFor(kZeroSize, activeSize, [&] (size_t a) {
+                size_t i = _activeSet[a];
                 _tempVelocities[i]
                     = v[i]
                     + timeIntervalInSeconds / mass
                     * (f[i] + _pressureForces[i]);
                 _tempPositions[i]
-                    = x[i] + timeIntervalInSeconds * _tempVelocities[i];
-            });
-
-        // Resolve collisions
-        resolveCollision(
-            _tempPositions,
-            _tempVelocities);
-
-        // Compute pressure from density error
-        parallelFor(
-            kZeroSize,
-            numberOfParticles,
-            [&] (size_t i) {
-                double weightSum = 0.0;
-                const auto& neighbors = particles->neighborLists()[i];
-
-                for (size_t j : neighbors) {
-                    double dist
-                        = _tempPositions[j].distanceTo(_tempPositions[i]);
-                    weightSum += kernel(dist);
+                    = x[i] + positionTimeStep * _tempVelocities[i];
+                if (collider() != nullptr) {
+                    collider()->resolveCollision(
+                        particleRadius,
+                        restitutionCoefficient(),
+                        &_tempPositions[i],
+                        &_tempVelocities[i]);
                 }
-                weightSum += kernel(0);
-
-                double density = mass * weightSum;
-                double densityError = (density - targetDensity);
-                double pressure = delta * densityError;
-
-                if (pressure < 0.0) {
-                    pressure *= negativePressureScale();
-                    densityError *= negativePressureScale();
-                }
-
-                p[i] += pressure;
-                ds[i] = density;
-                _densityErrors[i] = densityError;
             });
 
-        // Compute pressure gradient force
-        _pressureForces.set(Vector3D());
-        SphSolver3::accumulatePressureForce(
-            x, ds.constAccessor(), p, _pressureForces.accessor());
-
-        // Compute max density error
-        maxDensityError = 0.0;
-        for (size_t i = 0; i < numberOfParticles; ++i) {
-            maxDensityError = absmax(maxDensityError, _densityErrors[i]);
+            const double boundaryScale = targetDensity / mass;
+            maxDensityError = parallelReduce(
+                kZeroSize,
+                activeSize,
+                0.0,
+                [&] (size_t begin, size_t end, double partial) {
+                    for (size_t a = begin; a < end; ++a) {
+                        size_t i = _activeSet[a];
+                        double weightSum = kernel(0);
+                        forEachNeighborBatch(
+                            _tempPositions.constAccessor(),
+                            _tempPositions[i],
+                            neighborLists[i],
+                            [&] (SphNeighborBatch3& batch) {
+                                sphStdKernelWeights(
+                                    kernel,
+                                    batch.distanceSquared,
+                                    batch.size,
+                                    batch.weight);
+                                for (size_t n = 0; n < batch.size; ++n) {
+                                    weightSum += batch.weight[n];
+                                }
+                            });
+                        if (boundaryParticles() != nullptr) {
+                            weightSum += boundaryScale
+                                * boundaryParticles()->sumOfKernelNearby(
+                                    _tempPositions[i]);
+                        }
+                        _weightSums[i] = weightSum;
+
+                        double density = mass * weightSum;
+                        double densityError = (density - targetDensity);
+                        double pressure = delta * densityError;
+
+                        if (pressure < 0.0) {
+                            pressure *= negativeScale;
+                            densityError *= negativeScale;
+                        }
+
+                        p[i] += pressure;
+                        ds[i] = density;
+                        _densityErrors[i] = densityError;
+                        partial = absmax(partial, densityError);
+                    }
+                    return partial;
+                },
+                [] (double a, double b) {
+                    return absmax(a, b);
+                });
+
+            numberOfUpdates += activeSize;
         }
 
         densityErrorRatio = maxDensityError / targetDensity;
@@ -133,8 +378,26 @@ void PciSphSolver3::accumulatePressureForce(
         if (std::fabs(densityErrorRatio) < _maxDensityErrorRatio) {
             break;
         }
+
+        if (_isUsingActiveSet && k + 1 < _maxNumberOfIterations) {
+            buildNextActiveSet(isFullIteration, maxDensityErrorThreshold);
+            isFullIteration = false;
+            computeActivePressureForces(ds.constAccessor(), p);
+        }
     }
 
+    // The forces of the particles next to the active set have missed the
+    // last pressure changes of their neighbors
+    if (!isFullIteration) {
+        _pressureForces.set(Vector3D());
+        SphSolver3::accumulatePressureForce(
+            x, ds.constAccessor(), p, _pressureForces.accessor());
+    }
+
+    _lastNumberOfIterations = maxNumIter;
+    _lastDensityErrorRatio = densityErrorRatio;
+    _lastNumberOfParticleUpdates = numberOfUpdates;
+
     JET_INFO << "Number of PCI iterations: " << maxNumIter;
     JET_INFO << "Max density error after PCI iteration: " << maxDensityError;
     if (std::fabs(densityErrorRatio) > _maxDensityErrorRatio) {
@@ -155,17 +418,125 @@ void PciSphSolver3::accumulatePressureForce(
 void PciSphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
     SphSolver3::onBeginAdvanceTimeStep(timeStepInSeconds);
 
-    // Allocate temp buffers
+    // Resize temp buffers, which keep their capacity across the time steps
     size_t numberOfParticles = particleSystemData()->numberOfParticles();
     _tempPositions.resize(numberOfParticles);
     _tempVelocities.resize(numberOfParticles);
     _pressureForces.resize(numberOfParticles);
     _densityErrors.resize(numberOfParticles);
+    _weightSums.resize(numberOfParticles);
+    _isInNextActiveSet.resize(numberOfParticles, 0);
+}
+
+void PciSphSolver3::collectStatistics(SubTimeStepStatistics* stats) const {
+    SphSolver3::collectStatistics(stats);
+
+    stats->numberOfPressureIterations = _lastNumberOfIterations;
+    stats->pressureResidual = _lastDensityErrorRatio;
+}
+
+void PciSphSolver3::buildNextActiveSet(
+    bool isFullIteration,
+    double maxDensityError) {
+    const auto& neighborLists = particleSystemData()->neighborLists();
+
+    // The marking is serial, which only visits the neighbor indices of the
+    // particles above the threshold
+    _nextActiveSet.clear();
+    auto add = [&] (size_t i) {
+        if (!_isInNextActiveSet[i]) {
+            _isInNextActiveSet[i] = 1;
+            _nextActiveSet.push_back(i);
+        }
+    };
+    auto visit = [&] (size_t i) {
+        if (std::fabs(_densityErrors[i]) >= maxDensityError) {
+            add(i);
+            for (size_t j : neighborLists[i]) {
+                add(j);
+            }
+        }
+    };
+
+    if (isFullIteration) {
+        for (size_t i = 0; i < _isInNextActiveSet.size(); ++i) {
+            visit(i);
+        }
+    } else {
+        for (size_t i : _activeSet) {
+            visit(i);
+        }
+    }
+
+    // Sorted for the memory locality of the following passes
+    std::sort(_nextActiveSet.begin(), _nextActiveSet.end());
+    for (size_t i : _nextActiveSet) {
+        _isInNextActiveSet[i] = 0;
+    }
+    _activeSet.swap(_nextActiveSet);
+}
+
+void PciSphSolver3::computeActivePressureForces(
+    const ConstArrayAccessor1<double>& densities,
+    const ConstArrayAccessor1<double>& pressures) {
+    auto particles = sphSystemData();
+    auto x = particles->positions();
+    const auto& neighborLists = particles->neighborLists();
+    const double massSquared = square(particles->mass());
+    const double boundaryScale = particles->mass() * particles->targetDensity();
+    const SphSpikyKernel3 kernel(particles->kernelRadius());
+
+    // Gathers the same force as SphSolver3::accumulatePressureForce over the
+    // full neighbor lists, so that only the active particles are written
+    parallelFor(kZeroSize, _activeSet.size(), [&] (size_t a) {
+        size_t i = _activeSet[a];
+        const double pi = pressures[i] / square(densities[i]);
+        Vector3D force;
+        forEachNeighborBatch(
+            x,
+            x[i],
+            neighborLists[i],
+            [&] (SphNeighborBatch3& batch) {
+                sphSpikyGradientScales(
+                    kernel,
+                    batch.distanceSquared,
+                    batch.size,
+                    batch.weight);
+                for (size_t k = 0; k < batch.size; ++k) {
+                    size_t j = batch.index[k];
+                    double scale = massSquared
+                        * (pi + pressures[j] / square(densities[j]))
+                        * batch.weight[k];
+                    force += scale
+                        * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+                }
+            });
+        _pressureForces[i] = -force;
+
+        if (boundaryParticles() != nullptr && pressures[i] != 0.0) {
+            _pressureForces[i] -= boundaryScale * pi
+                * boundaryParticles()->sumOfGradientNearby(x[i]);
+        }
+    });
 }
 
 double PciSphSolver3::computeDelta(double timeStepInSeconds) {
+    double denom = computeDeltaDenominator();
+
+    return (std::fabs(denom) > 0.0) ?
+        -1 / (positionUpdateFraction() * computeBeta(timeStepInSeconds)
+              * denom) : 0;
+}
+
+double PciSphSolver3::computeDeltaDenominator() {
     auto particles = sphSystemData();
     const double kernelRadius = particles->kernelRadius();
+    const double targetSpacing = particles->targetSpacing();
+
+    if (_deltaDenominatorSpacing == targetSpacing
+        && _deltaDenominatorKernelRadius == kernelRadius) {
+        return _deltaDenominator;
+    }
 
     Array1<Vector3D> points;
     BccLatticePointGenerator pointsGenerator;
@@ -173,7 +544,7 @@ double PciSphSolver3::computeDelta(double timeStepInSeconds) {
     BoundingBox3D sampleBound(origin, origin);
     sampleBound.expand(1.5 * kernelRadius);
 
-    pointsGenerator.generate(sampleBound, particles->targetSpacing(), &points);
+    pointsGenerator.generate(sampleBound, targetSpacing, &points);
 
     SphSpikyKernel3 kernel(kernelRadius);
 
@@ -199,8 +570,11 @@ double PciSphSolver3::computeDelta(double timeStepInSeconds) {
 
     denom += -denom1.dot(denom1) - denom2;
 
-    return (std::fabs(denom) > 0.0) ?
-        -1 / (computeBeta(timeStepInSeconds) * denom) : 0;
+    _deltaDenominator = denom;
+    _deltaDenominatorSpacing = targetSpacing;
+    _deltaDenominatorKernelRadius = kernelRadius;
+
+    return denom;
 }
 
 double PciSphSolver3::computeBeta(double timeStepInSeconds) {
@@ -2,12 +2,21 @@
 
 #include <pch.h>
 #include <jet/constants.h>
+#include <jet/memory_tracker.h>
 #include <jet/physics_animation.h>
+#include <jet/profiler.h>
 #include <jet/timer.h>
+#include <serialization_helpers.h>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 
 using namespace jet;
 
+static const char kCheckpointTag[] = "JETCHKPT";
+static const size_t kCheckpointTagLength = 8;
+static const uint32_t kCheckpointVersion = 1;
+
 PhysicsAnimation::PhysicsAnimation() {
 }
 
@@ -31,6 +40,57 @@ void PhysicsAnimation::setNumberOfFixedSubTimeSteps(
     _numberOfFixedSubTimeSteps = numberOfSteps;
 }
 
+const Frame& PhysicsAnimation::currentFrame() const {
+    return _currentFrame;
+}
+
+const FrameStatistics& PhysicsAnimation::lastFrameStatistics() const {
+    return _lastFrameStatistics;
+}
+
+void PhysicsAnimation::setFrameCallback(const FrameCallback& callback) {
+    _frameCallback = callback;
+}
+
+void PhysicsAnimation::serialize(std::ostream* strm) const {
+    strm->write(kCheckpointTag, kCheckpointTagLength);
+    serializeValue(strm, kCheckpointVersion);
+    serializeSectionTag(strm, "PhysicsAnimation");
+
+    uint32_t frameIndex = _currentFrame.index;
+    uint8_t isUsingFixedSubTimeSteps = _isUsingFixedSubTimeSteps ? 1 : 0;
+    uint32_t numberOfFixedSubTimeSteps = _numberOfFixedSubTimeSteps;
+    serializeValue(strm, frameIndex);
+    serializeValue(strm, _currentFrame.timeIntervalInSeconds);
+    serializeValue(strm, isUsingFixedSubTimeSteps);
+    serializeValue(strm, numberOfFixedSubTimeSteps);
+}
+
+void PhysicsAnimation::deserialize(std::istream* strm) {
+    char tag[kCheckpointTagLength];
+    uint32_t version = 0;
+    strm->read(tag, kCheckpointTagLength);
+    deserializeValue(strm, &version);
+    JET_THROW_INVALID_ARG_IF(
+        !(*strm)
+        || std::memcmp(tag, kCheckpointTag, kCheckpointTagLength) != 0
+        || version != kCheckpointVersion
+        || !deserializeSectionTag(strm, "PhysicsAnimation"));
+
+    uint32_t frameIndex = 0;
+    uint8_t isUsingFixedSubTimeSteps = 0;
+    uint32_t numberOfFixedSubTimeSteps = 0;
+    deserializeValue(strm, &frameIndex);
+    deserializeValue(strm, &_currentFrame.timeIntervalInSeconds);
+    deserializeValue(strm, &isUsingFixedSubTimeSteps);
+    deserializeValue(strm, &numberOfFixedSubTimeSteps);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+
+    _currentFrame.index = frameIndex;
+    _isUsingFixedSubTimeSteps = (isUsingFixedSubTimeSteps != 0);
+    _numberOfFixedSubTimeSteps = numberOfFixedSubTimeSteps;
+}
+
 unsigned int PhysicsAnimation::numberOfSubTimeSteps(
     double timeIntervalInSeconds) const {
     UNUSED_VARIABLE(timeIntervalInSeconds);
@@ -39,19 +99,47 @@ unsigned int PhysicsAnimation::numberOfSubTimeSteps(
     return _numberOfFixedSubTimeSteps;
 }
 
+void PhysicsAnimation::onEndAdvanceFrame(double timeIntervalInSeconds) {
+    UNUSED_VARIABLE(timeIntervalInSeconds);
+}
+
+void PhysicsAnimation::collectStatistics(SubTimeStepStatistics* stats) const {
+    UNUSED_VARIABLE(stats);
+}
+
 void PhysicsAnimation::onUpdate(const Frame& frame) {
     if (frame.index > _currentFrame.index) {
         unsigned int numberOfFrames = frame.index - _currentFrame.index;
 
         for (unsigned int i = 0; i < numberOfFrames; ++i) {
+            _lastFrameStatistics.frameIndex = _currentFrame.index + 1;
             advanceTimeStep(frame.timeIntervalInSeconds);
-        }
+            Profiler::endFrame();
 
-        _currentFrame = frame;
+            _currentFrame.index = _lastFrameStatistics.frameIndex;
+            _currentFrame.timeIntervalInSeconds = frame.timeIntervalInSeconds;
+            if (_frameCallback) {
+                _frameCallback(_currentFrame);
+            }
+        }
     }
 }
 
 void PhysicsAnimation::advanceTimeStep(double timeIntervalInSeconds) {
+    JET_PROFILE_SCOPE("advanceTimeStep");
+
+    Timer frameTimer;
+    _lastFrameStatistics.subTimeSteps.clear();
+
+    auto recordSubTimeStep = [&](double timeInterval, double duration) {
+        SubTimeStepStatistics stats;
+        stats.timeIntervalInSeconds = timeInterval;
+        stats.durationInSeconds = duration;
+        stats.peakTrackedMemoryInBytes = MemoryTracker::peakTotalBytes();
+        collectStatistics(&stats);
+        _lastFrameStatistics.subTimeSteps.push_back(stats);
+    };
+
     if (_isUsingFixedSubTimeSteps) {
         JET_INFO << "Using fixed sub-timesteps: " << _numberOfFixedSubTimeSteps;
 
@@ -65,12 +153,17 @@ void PhysicsAnimation::advanceTimeStep(double timeIntervalInSeconds) {
                      << " (1/" << 1.0 / actualTimeInterval
                      << ") seconds";
 
+            JET_PROFILE_SCOPE("onAdvanceTimeStep");
+            MemoryTracker::resetPeakBytes();
             Timer timer;
             onAdvanceTimeStep(actualTimeInterval);
 
+            double duration = timer.durationInSeconds();
             JET_INFO << "End onAdvanceTimeStep (took "
-                     << timer.durationInSeconds()
+                     << duration
                      << " seconds)";
+
+            recordSubTimeStep(actualTimeInterval, duration);
         }
     } else {
         JET_INFO << "Using adaptive sub-timesteps";
@@ -88,14 +181,26 @@ void PhysicsAnimation::advanceTimeStep(double timeIntervalInSeconds) {
                      << " (1/" << 1.0 / actualTimeInterval
                      << ") seconds";
 
+            JET_PROFILE_SCOPE("onAdvanceTimeStep");
+            MemoryTracker::resetPeakBytes();
             Timer timer;
             onAdvanceTimeStep(actualTimeInterval);
 
+            double duration = timer.durationInSeconds();
             JET_INFO << "End onAdvanceTimeStep (took "
-                     << timer.durationInSeconds()
+                     << duration
                      << " seconds)";
 
+            recordSubTimeStep(actualTimeInterval, duration);
+
             remainingTime -= actualTimeInterval;
         }
     }
+
+    {
+        JET_PROFILE_SCOPE("onEndAdvanceFrame");
+        onEndAdvanceFrame(timeIntervalInSeconds);
+    }
+
+    _lastFrameStatistics.durationInSeconds = frameTimer.durationInSeconds();
 }
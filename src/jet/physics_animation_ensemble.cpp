@@ -0,0 +1,54 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/parallel.h>
+#include <jet/physics_animation_ensemble.h>
+
+#include <exception>
+#include <vector>
+
+using namespace jet;
+
+PhysicsAnimationEnsemble::PhysicsAnimationEnsemble() {
+}
+
+void PhysicsAnimationEnsemble::addAnimation(
+    const PhysicsAnimationPtr& animation) {
+    _animations.push_back(animation);
+}
+
+size_t PhysicsAnimationEnsemble::numberOfAnimations() const {
+    return _animations.size();
+}
+
+const PhysicsAnimationPtr& PhysicsAnimationEnsemble::animation(
+    size_t i) const {
+    return _animations[i];
+}
+
+void PhysicsAnimationEnsemble::update(const Frame& frame) {
+    std::vector<std::exception_ptr> exceptions(_animations.size());
+
+    // One task per animation, so that the threads that finish their
+    // animations early steal the remaining ones
+    parallelRangeFor(
+        kZeroSize,
+        _animations.size(),
+        kOneSize,
+        [&](size_t begin, size_t end) {
+            SerialExecutionScope scope;
+            for (size_t i = begin; i < end; ++i) {
+                try {
+                    _animations[i]->update(frame);
+                } catch (...) {
+                    exceptions[i] = std::current_exception();
+                }
+            }
+        });
+
+    for (const std::exception_ptr& exception : exceptions) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
@@ -0,0 +1,356 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_PIC_HELPERS_H_
+#define SRC_JET_PIC_HELPERS_H_
+
+#include <jet/array1.h>
+#include <jet/array_accessor2.h>
+#include <jet/array_accessor3.h>
+#include <jet/array_samplers2.h>
+#include <jet/array_samplers3.h>
+#include <jet/bit_array3.h>
+#include <jet/parallel.h>
+#include <grid_sampler_helpers.h>
+
+#include <algorithm>
+#include <array>
+
+namespace jet {
+
+// Expands the lower grid point and the fractions of a trilinear stencil into
+// its eight grid points and weights, in the same order and with the same
+// clamping at the upper end as LinearArraySampler3::getCoordinatesAndWeights.
+inline void getTrilinearStencil(
+    ssize_t i,
+    ssize_t j,
+    ssize_t k,
+    double fx,
+    double fy,
+    double fz,
+    const Size3& size,
+    std::array<Point3UI, 8>* indices,
+    std::array<double, 8>* weights) {
+    ssize_t ip1 = std::min(i + 1, static_cast<ssize_t>(size.x) - 1);
+    ssize_t jp1 = std::min(j + 1, static_cast<ssize_t>(size.y) - 1);
+    ssize_t kp1 = std::min(k + 1, static_cast<ssize_t>(size.z) - 1);
+
+    (*indices)[0] = Point3UI(i, j, k);
+    (*indices)[1] = Point3UI(ip1, j, k);
+    (*indices)[2] = Point3UI(i, jp1, k);
+    (*indices)[3] = Point3UI(ip1, jp1, k);
+    (*indices)[4] = Point3UI(i, j, kp1);
+    (*indices)[5] = Point3UI(ip1, j, kp1);
+    (*indices)[6] = Point3UI(i, jp1, kp1);
+    (*indices)[7] = Point3UI(ip1, jp1, kp1);
+
+    (*weights)[0] = (1 - fx) * (1 - fy) * (1 - fz);
+    (*weights)[1] = fx * (1 - fy) * (1 - fz);
+    (*weights)[2] = (1 - fx) * fy * (1 - fz);
+    (*weights)[3] = fx * fy * (1 - fz);
+    (*weights)[4] = (1 - fx) * (1 - fy) * fz;
+    (*weights)[5] = fx * (1 - fy) * fz;
+    (*weights)[6] = (1 - fx) * fy * fz;
+    (*weights)[7] = fx * fy * fz;
+}
+
+// Interpolation stencils of the particles on a face-centered grid. They are
+// computed once for the positions of a time-step, and shared by the splat of
+// each velocity component and the transfer back to the particles, which are
+// done at the same positions. Each stencil is kept in the compact form of
+// FaceCenteredGridSampler3, and is expanded into the eight grid points of a
+// component on demand.
+class ParticleStencils3 {
+ public:
+    void build(
+        const FaceCenteredGridSampler3& sampler,
+        const ConstArrayAccessor1<Vector3D>& positions) {
+        _weights.resize(positions.size());
+        parallelFor(kZeroSize, positions.size(), [&](size_t i) {
+            _weights[i] = sampler.getWeights(positions[i]);
+        });
+    }
+
+    size_t size() const {
+        return _weights.size();
+    }
+
+    const FaceCenteredGridSampler3::Weights& operator[](size_t i) const {
+        return _weights[i];
+    }
+
+    void getUStencil(
+        size_t i,
+        const Size3& uSize,
+        std::array<Point3UI, 8>* indices,
+        std::array<double, 8>* weights) const {
+        const FaceCenteredGridSampler3::Weights& w = _weights[i];
+        getTrilinearStencil(
+            w.fi, w.cj, w.ck, w.ffx, w.cfy, w.cfz, uSize, indices, weights);
+    }
+
+    void getVStencil(
+        size_t i,
+        const Size3& vSize,
+        std::array<Point3UI, 8>* indices,
+        std::array<double, 8>* weights) const {
+        const FaceCenteredGridSampler3::Weights& w = _weights[i];
+        getTrilinearStencil(
+            w.ci, w.fj, w.ck, w.cfx, w.ffy, w.cfz, vSize, indices, weights);
+    }
+
+    void getWStencil(
+        size_t i,
+        const Size3& wSize,
+        std::array<Point3UI, 8>* indices,
+        std::array<double, 8>* weights) const {
+        const FaceCenteredGridSampler3::Weights& w = _weights[i];
+        getTrilinearStencil(
+            w.ci, w.cj, w.fk, w.cfx, w.cfy, w.ffz, wSize, indices, weights);
+    }
+
+ private:
+    Array1<FaceCenteredGridSampler3::Weights> _weights;
+};
+
+// Particles sorted by the cells of a grid, with the offset of the first
+// particle of each cell, so the particles of a cell, or of a run of cells
+// such as a k-slice, are contiguous and in the order of their indices. The
+// particles out of the grid are binned to the nearest cell. PicSolver3 bins
+// the particles once for their positions, and shares the bins between the
+// splat of each velocity component, the signed-distance field, and the
+// reseeding.
+class ParticleCellBins3 {
+ public:
+    void build(
+        const ConstArrayAccessor1<Vector3D>& positions,
+        const Size3& resolution,
+        const Vector3D& gridSpacing,
+        const Vector3D& origin) {
+        const size_t numberOfParticles = positions.size();
+        const size_t numberOfCells = resolution.x * resolution.y * resolution.z;
+        _resolution = resolution;
+        _gridSpacing = gridSpacing;
+        _origin = origin;
+        _keys.resize(numberOfParticles);
+        _particleIndices.resize(numberOfParticles);
+        _offsets.resize(numberOfCells + 1);
+        if (numberOfCells == 0) {
+            _offsets[0] = 0;
+            return;
+        }
+
+        parallelFor(kZeroSize, numberOfParticles, [&](size_t p) {
+            Point3UI cell = cellOf(positions[p]);
+            _keys[p] = cellIndex(cell.x, cell.y, cell.z);
+            _particleIndices[p] = p;
+        });
+        if (numberOfParticles > 0) {
+            parallelRadixSort(
+                _keys.begin(),
+                _keys.end(),
+                _particleIndices.begin(),
+                numberOfCells - 1);
+        }
+
+        // Each cell from the one after the previous key up to the key of
+        // particle p starts at p, so each offset is written once
+        parallelFor(kZeroSize, numberOfParticles + 1, [&](size_t p) {
+            size_t first = (p == 0) ? 0 : _keys[p - 1] + 1;
+            size_t last = (p == numberOfParticles) ? numberOfCells : _keys[p];
+            for (size_t c = first; c <= last; ++c) {
+                _offsets[c] = p;
+            }
+        });
+    }
+
+    const Size3& resolution() const {
+        return _resolution;
+    }
+
+    size_t numberOfParticles() const {
+        return _keys.size();
+    }
+
+    size_t cellIndex(size_t i, size_t j, size_t k) const {
+        return i + _resolution.x * (j + _resolution.y * k);
+    }
+
+    // Returns the cell of the point, clamped to the grid.
+    Point3UI cellOf(const Vector3D& pt) const {
+        Vector3D x = (pt - _origin) / _gridSpacing;
+        return Point3UI(
+            static_cast<size_t>(clamp(
+                std::floor(x.x), 0.0, static_cast<double>(_resolution.x - 1))),
+            static_cast<size_t>(clamp(
+                std::floor(x.y), 0.0, static_cast<double>(_resolution.y - 1))),
+            static_cast<size_t>(clamp(
+                std::floor(x.z), 0.0, static_cast<double>(_resolution.z - 1))));
+    }
+
+    // Returns the sorted position of the first particle of the cell. The
+    // cells of a k-slice start at cellBegin(cellIndex(0, 0, k)).
+    size_t cellBegin(size_t cell) const {
+        return _offsets[cell];
+    }
+
+    size_t cellEnd(size_t cell) const {
+        return _offsets[cell + 1];
+    }
+
+    size_t numberOfParticlesInCell(size_t i, size_t j, size_t k) const {
+        size_t cell = cellIndex(i, j, k);
+        return _offsets[cell + 1] - _offsets[cell];
+    }
+
+    // Returns the index of the particle at the sorted position.
+    size_t particleIndex(size_t sortedIndex) const {
+        return _particleIndices[sortedIndex];
+    }
+
+    // Calls the callback with the index of each particle in the cells that
+    // overlap the sphere, which include the particles within the radius.
+    template <typename Callback>
+    void forEachNearbyParticle(
+        const Vector3D& pt,
+        double radius,
+        const Callback& callback) const {
+        if (_keys.size() == 0) {
+            return;
+        }
+
+        Vector3D r(radius, radius, radius);
+        Point3UI lower = cellOf(pt - r);
+        Point3UI upper = cellOf(pt + r);
+        for (size_t k = lower.z; k <= upper.z; ++k) {
+            for (size_t j = lower.y; j <= upper.y; ++j) {
+                // The cells of a row are contiguous
+                size_t begin = _offsets[cellIndex(lower.x, j, k)];
+                size_t end = _offsets[cellIndex(upper.x, j, k) + 1];
+                for (size_t p = begin; p < end; ++p) {
+                    callback(_particleIndices[p]);
+                }
+            }
+        }
+    }
+
+ private:
+    Size3 _resolution;
+    Vector3D _gridSpacing;
+    Vector3D _origin;
+    Array1<size_t> _keys;
+    Array1<size_t> _particleIndices;
+    Array1<size_t> _offsets;
+};
+
+// Splats a particle attribute onto the grid points with trilinear weights.
+// The stencil function is called with the particle index, and returns the
+// grid points and the weights of the particle. The particles are taken from
+// the k-slices of the bins, whose cells share the spacing and the origin of
+// the grid the stencils are on, which is one of the components of a
+// face-centered grid. A particle of slice k touches the planes k - 1 to
+// k + 1 of each component, plus one for the rounding of the stencil. Hence
+// every fourth slice can be processed in parallel without any race, in four
+// passes. The planes, and so the rows of the marker bits, touched by the
+// slices of the same color are disjoint as well. The value function is
+// called with the particle index and the grid point index, and returns the
+// value to splat.
+template <typename StencilFunc, typename ValueFunc>
+inline void splatParticles(
+    const ParticleCellBins3& bins,
+    const StencilFunc& stencilFunc,
+    const ValueFunc& valueFunc,
+    ArrayAccessor3<double> values,
+    ArrayAccessor3<double> weightSums,
+    BitArray3* markers) {
+    const size_t kNumberOfColors = 4;
+    const Size3& res = bins.resolution();
+    size_t numberOfSlices = res.z;
+    if (bins.numberOfParticles() == 0 || values.size().z == 0) {
+        return;
+    }
+
+    for (size_t color = 0; color < kNumberOfColors; ++color) {
+        size_t numberOfSlicesOfColor
+            = (numberOfSlices + kNumberOfColors - 1 - color) / kNumberOfColors;
+        parallelFor(kZeroSize, numberOfSlicesOfColor, [&](size_t slice) {
+            size_t k = kNumberOfColors * slice + color;
+            size_t first = bins.cellBegin(bins.cellIndex(0, 0, k));
+            size_t last = bins.cellEnd(bins.cellIndex(res.x - 1, res.y - 1, k));
+
+            std::array<Point3UI, 8> indices;
+            std::array<double, 8> weights;
+            for (size_t p = first; p < last; ++p) {
+                size_t i = bins.particleIndex(p);
+                stencilFunc(i, &indices, &weights);
+                for (int j = 0; j < 8; ++j) {
+                    values(indices[j]) += valueFunc(i, indices[j]) * weights[j];
+                    weightSums(indices[j]) += weights[j];
+                    markers->set(
+                        indices[j].x, indices[j].y, indices[j].z, true);
+                }
+            }
+        });
+    }
+}
+
+// Splats a particle attribute onto the grid points of a 2-D grid with
+// bilinear weights. Particles are binned by the j-index of their base grid
+// point, and a particle in bin j only touches the j and j + 1 rows, so even
+// bins are processed in parallel, followed by odd bins.
+template <typename ValueFunc>
+inline void splatParticles(
+    const LinearArraySampler2<double, double>& sampler,
+    const ConstArrayAccessor1<Vector2D>& positions,
+    const ValueFunc& valueFunc,
+    ArrayAccessor2<double> values,
+    ArrayAccessor2<double> weightSums,
+    ArrayAccessor2<char> markers,
+    Array1<size_t>* keys,
+    Array1<size_t>* particleIndices) {
+    size_t numberOfParticles = positions.size();
+    size_t numberOfBins = values.size().y;
+    if (numberOfParticles == 0 || numberOfBins == 0) {
+        return;
+    }
+
+    keys->resize(numberOfParticles);
+    particleIndices->resize(numberOfParticles);
+    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+        std::array<Point2UI, 4> indices;
+        std::array<double, 4> weights;
+        sampler.getCoordinatesAndWeights(positions[i], &indices, &weights);
+        (*keys)[i] = indices[0].y;
+        (*particleIndices)[i] = i;
+    });
+
+    parallelRadixSort(
+        keys->begin(), keys->end(), particleIndices->begin(), numberOfBins - 1);
+
+    for (size_t color = 0; color < 2; ++color) {
+        size_t numberOfBinsOfColor = (numberOfBins + 1 - color) / 2;
+        parallelFor(kZeroSize, numberOfBinsOfColor, [&](size_t bin) {
+            size_t j = 2 * bin + color;
+            auto begin = std::lower_bound(keys->begin(), keys->end(), j);
+            auto end = std::upper_bound(begin, keys->end(), j);
+            size_t first = static_cast<size_t>(begin - keys->begin());
+            size_t last = static_cast<size_t>(end - keys->begin());
+
+            std::array<Point2UI, 4> indices;
+            std::array<double, 4> weights;
+            for (size_t p = first; p < last; ++p) {
+                size_t i = (*particleIndices)[p];
+                sampler.getCoordinatesAndWeights(
+                    positions[i], &indices, &weights);
+                for (int n = 0; n < 4; ++n) {
+                    values(indices[n]) += valueFunc(i, indices[n]) * weights[n];
+                    weightSums(indices[n]) += weights[n];
+                    markers(indices[n]) = 1;
+                }
+            }
+        });
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_PIC_HELPERS_H_
@@ -9,6 +9,8 @@
 #include <jet/level_set_utils.h>
 #include <jet/pic_solver2.h>
 #include <jet/timer.h>
+#include <neighbor_search_helpers.h>
+#include <pic_helpers.h>
 #include <algorithm>
 
 using namespace jet;
@@ -82,7 +84,6 @@ void PicSolver2::transferFromParticlesToGrids() {
     auto flow = gridSystemData()->velocity();
     auto positions = _particles->positions();
     auto velocities = _particles->velocities();
-    size_t numberOfParticles = _particles->numberOfParticles();
 
     // Clear velocity to zero
     flow->fill(Vector2D());
@@ -90,8 +91,10 @@ void PicSolver2::transferFromParticlesToGrids() {
     // Weighted-average velocity
     auto u = flow->uAccessor();
     auto v = flow->vAccessor();
-    Array2<double> uWeight(u.size());
-    Array2<double> vWeight(v.size());
+    _uWeights.resize(u.size());
+    _vWeights.resize(v.size());
+    _uWeights.set(0.0);
+    _vWeights.set(0.0);
     _uMarkers.resize(u.size());
     _vMarkers.resize(v.size());
     _uMarkers.set(0);
@@ -104,33 +107,34 @@ void PicSolver2::transferFromParticlesToGrids() {
         flow->vConstAccessor(),
         flow->gridSpacing(),
         flow->vOrigin());
-    for (size_t i = 0; i < numberOfParticles; ++i) {
-        std::array<Point2UI, 4> indices;
-        std::array<double, 4> weights;
-
-        uSampler.getCoordinatesAndWeights(positions[i], &indices, &weights);
-        for (int j = 0; j < 4; ++j) {
-            u(indices[j]) += velocities[i].x * weights[j];
-            uWeight(indices[j]) += weights[j];
-            _uMarkers(indices[j]) = 1;
-        }
-
-        vSampler.getCoordinatesAndWeights(positions[i], &indices, &weights);
-        for (int j = 0; j < 4; ++j) {
-            v(indices[j]) += velocities[i].y * weights[j];
-            vWeight(indices[j]) += weights[j];
-            _vMarkers(indices[j]) = 1;
-        }
-    }
 
-    uWeight.forEachIndex([&](size_t i, size_t j) {
-        if (uWeight(i, j) > 0.0) {
-            u(i, j) /= uWeight(i, j);
+    splatParticles(
+        uSampler,
+        positions,
+        [&](size_t i, const Point2UI&) { return velocities[i].x; },
+        u,
+        _uWeights.accessor(),
+        _uMarkers.accessor(),
+        &_splatKeys,
+        &_splatIndices);
+    splatParticles(
+        vSampler,
+        positions,
+        [&](size_t i, const Point2UI&) { return velocities[i].y; },
+        v,
+        _vWeights.accessor(),
+        _vMarkers.accessor(),
+        &_splatKeys,
+        &_splatIndices);
+
+    _uWeights.parallelForEachIndex([&](size_t i, size_t j) {
+        if (_uWeights(i, j) > 0.0) {
+            u(i, j) /= _uWeights(i, j);
         }
     });
-    vWeight.forEachIndex([&](size_t i, size_t j) {
-        if (vWeight(i, j) > 0.0) {
-            v(i, j) /= vWeight(i, j);
+    _vWeights.parallelForEachIndex([&](size_t i, size_t j) {
+        if (_vWeights(i, j) > 0.0) {
+            v(i, j) /= _vWeights(i, j);
         }
     });
 }
@@ -235,8 +239,8 @@ void PicSolver2::buildSignedDistanceField() {
     sdf->parallelForEachDataPointIndex([&] (size_t i, size_t j) {
         Vector2D pt = sdfPos(i, j);
         double minDist = 2.0 * radius;
-        searcher->forEachNearbyPoint(
-            pt, 2.0 * radius, [&] (size_t, const Vector2D& x) {
+        forEachNearbyPoint(
+            *searcher, pt, 2.0 * radius, [&] (size_t, const Vector2D& x) {
                 minDist = std::min(minDist, pt.distanceTo(x));
             });
         (*sdf)(i, j) = minDist - radius;
@@ -7,9 +7,14 @@
 #include <pch.h>
 #include <jet/array_utils.h>
 #include <jet/level_set_utils.h>
+#include <jet/philox_rng.h>
 #include <jet/pic_solver3.h>
-#include <jet/timer.h>
+#include <jet/profiler.h>
+#include <grid_sampler_helpers.h>
+#include <pic_helpers.h>
+#include <serialization_helpers.h>
 #include <algorithm>
+#include <array>
 
 using namespace jet;
 
@@ -18,6 +23,8 @@ PicSolver3::PicSolver3() {
     _signedDistanceFieldId = grids->addScalarData(
         CellCenteredScalarGrid3::builder(), kMaxD);
     _particles = std::make_shared<ParticleSystemData3>();
+    _particleStencils.reset(new ParticleStencils3());
+    _particleBins.reset(new ParticleCellBins3());
 }
 
 PicSolver3::~PicSolver3() {
@@ -31,58 +38,133 @@ const ParticleSystemData3Ptr& PicSolver3::particleSystemData() const {
     return _particles;
 }
 
+size_t PicSolver3::minNumberOfParticlesPerCell() const {
+    return _minNumberOfParticlesPerCell;
+}
+
+void PicSolver3::setMinNumberOfParticlesPerCell(size_t number) {
+    _minNumberOfParticlesPerCell = number;
+}
+
+size_t PicSolver3::maxNumberOfParticlesPerCell() const {
+    return _maxNumberOfParticlesPerCell;
+}
+
+void PicSolver3::setMaxNumberOfParticlesPerCell(size_t number) {
+    _maxNumberOfParticlesPerCell = number;
+}
+
+void PicSolver3::serialize(std::ostream* strm) const {
+    GridFluidSolver3::serialize(strm);
+
+    serializeSectionTag(strm, "PicSolver3");
+    _particles->serialize(strm);
+}
+
+void PicSolver3::deserialize(std::istream* strm) {
+    GridFluidSolver3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "PicSolver3"));
+    _particles->deserialize(strm);
+    _areParticleStencilsValid = false;
+    _areParticleBinsValid = false;
+}
+
 void PicSolver3::onBeginAdvanceTimeStep(double timeIntervalInSeconds) {
     UNUSED_VARIABLE(timeIntervalInSeconds);
 
     JET_INFO << "Number of PIC-type particles: "
              << _particles->numberOfParticles();
 
-    Timer timer;
-    transferFromParticlesToGrids();
-    JET_INFO << "transferFromParticlesToGrids took "
-             << timer.durationInSeconds() << " seconds";
+    // The particles may have been emitted or edited since the last bins
+    _areParticleBinsValid = false;
 
-    timer.reset();
-    buildSignedDistanceField();
-    JET_INFO << "buildSignedDistanceField took "
-             << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("transferFromParticlesToGrids");
+        transferFromParticlesToGrids();
+    }
 
-    timer.reset();
-    extrapolateVelocityToAir();
-    JET_INFO << "extrapolateVelocityToAir took "
-             << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("buildSignedDistanceField");
+        buildSignedDistanceField();
+    }
+
+    {
+        JET_PROFILE_SCOPE("extrapolateVelocityToAir");
+        extrapolateVelocityToAir();
+    }
 
-    applyBoundaryCondition();
+    {
+        JET_PROFILE_SCOPE("applyBoundaryCondition");
+        applyBoundaryCondition();
+    }
+}
+
+void PicSolver3::collectStatistics(SubTimeStepStatistics* stats) const {
+    GridFluidSolver3::collectStatistics(stats);
+
+    stats->numberOfParticles = _particles->numberOfParticles();
+    stats->memoryInBytes += _particles->memoryInBytes();
 }
 
 void PicSolver3::computeAdvection(double timeIntervalInSeconds) {
-    Timer timer;
-    extrapolateVelocityToAir();
-    JET_INFO << "extrapolateVelocityToAir took "
-             << timer.durationInSeconds() << " seconds";
-
-    applyBoundaryCondition();
-
-    timer.reset();
-    transferFromGridsToParticles();
-    JET_INFO << "transferFromGridsToParticles took "
-             << timer.durationInSeconds() << " seconds";
-
-    timer.reset();
-    moveParticles(timeIntervalInSeconds);
-    JET_INFO << "moveParticles took "
-             << timer.durationInSeconds() << " seconds";
+    {
+        JET_PROFILE_SCOPE("extrapolateVelocityToAir");
+        extrapolateVelocityToAir();
+    }
+
+    {
+        JET_PROFILE_SCOPE("applyBoundaryCondition");
+        applyBoundaryCondition();
+    }
+
+    {
+        JET_PROFILE_SCOPE("transferFromGridsToParticles");
+        transferFromGridsToParticles();
+    }
+
+    // The stencils and the bins are for the positions before the move
+    _areParticleStencilsValid = false;
+    _areParticleBinsValid = false;
+
+    {
+        JET_PROFILE_SCOPE("moveParticles");
+        moveParticles(timeIntervalInSeconds);
+    }
+
+    if (_minNumberOfParticlesPerCell > 0
+        || _maxNumberOfParticlesPerCell < kMaxSize) {
+        JET_PROFILE_SCOPE("reseedParticles");
+        reseedParticles();
+    }
 }
 
 ScalarField3Ptr PicSolver3::fluidSdf() const {
     return signedDistanceField();
 }
 
+BoundingBox3D PicSolver3::activeRegion() const {
+    auto positions = _particles->positions();
+    return parallelReduce(
+        kZeroSize,
+        _particles->numberOfParticles(),
+        BoundingBox3D(),
+        [&](size_t begin, size_t end, BoundingBox3D box) {
+            for (size_t i = begin; i < end; ++i) {
+                box.merge(positions[i]);
+            }
+            return box;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+}
+
 void PicSolver3::transferFromParticlesToGrids() {
     auto flow = gridSystemData()->velocity();
     auto positions = _particles->positions();
     auto velocities = _particles->velocities();
-    size_t numberOfParticles = _particles->numberOfParticles();
 
     // Clear velocity to zero
     flow->fill(Vector3D());
@@ -91,66 +173,76 @@ void PicSolver3::transferFromParticlesToGrids() {
     auto u = flow->uAccessor();
     auto v = flow->vAccessor();
     auto w = flow->wAccessor();
-    Array3<double> uWeight(u.size());
-    Array3<double> vWeight(v.size());
-    Array3<double> wWeight(w.size());
+    _uWeights.resize(u.size());
+    _vWeights.resize(v.size());
+    _wWeights.resize(w.size());
+    _uWeights.set(0.0);
+    _vWeights.set(0.0);
+    _wWeights.set(0.0);
     _uMarkers.resize(u.size());
     _vMarkers.resize(v.size());
     _wMarkers.resize(w.size());
-    _uMarkers.set(0);
-    _vMarkers.set(0);
-    _wMarkers.set(0);
-    LinearArraySampler3<double, double> uSampler(
-        flow->uConstAccessor(),
-        flow->gridSpacing(),
-        flow->uOrigin());
-    LinearArraySampler3<double, double> vSampler(
-        flow->vConstAccessor(),
-        flow->gridSpacing(),
-        flow->vOrigin());
-    LinearArraySampler3<double, double> wSampler(
-        flow->wConstAccessor(),
-        flow->gridSpacing(),
-        flow->wOrigin());
-    for (size_t i = 0; i < numberOfParticles; ++i) {
-        std::array<Point3UI, 8> indices;
-        std::array<double, 8> weights;
-
-        uSampler.getCoordinatesAndWeights(positions[i], &indices, &weights);
-        for (int j = 0; j < 8; ++j) {
-            u(indices[j]) += velocities[i].x * weights[j];
-            uWeight(indices[j]) += weights[j];
-            _uMarkers(indices[j]) = 1;
-        }
-
-        vSampler.getCoordinatesAndWeights(positions[i], &indices, &weights);
-        for (int j = 0; j < 8; ++j) {
-            v(indices[j]) += velocities[i].y * weights[j];
-            vWeight(indices[j]) += weights[j];
-            _vMarkers(indices[j]) = 1;
-        }
-
-        wSampler.getCoordinatesAndWeights(positions[i], &indices, &weights);
-        for (int j = 0; j < 8; ++j) {
-            w(indices[j]) += velocities[i].z * weights[j];
-            wWeight(indices[j]) += weights[j];
-            _wMarkers(indices[j]) = 1;
-        }
-    }
-
-    uWeight.forEachIndex([&](size_t i, size_t j, size_t k) {
-        if (uWeight(i, j, k) > 0.0) {
-            u(i, j, k) /= uWeight(i, j, k);
+    _uMarkers.set(false);
+    _vMarkers.set(false);
+    _wMarkers.set(false);
+
+    // The stencils are shared by the three components, and by the transfer
+    // back to the particles in this time-step
+    _particleStencils->build(FaceCenteredGridSampler3(*flow), positions);
+    _areParticleStencilsValid = true;
+    const ParticleStencils3& stencils = *_particleStencils;
+    const ParticleCellBins3& bins = particleBins();
+    Size3 uSize = u.size();
+    Size3 vSize = v.size();
+    Size3 wSize = w.size();
+
+    splatParticles(
+        bins,
+        [&](size_t i,
+            std::array<Point3UI, 8>* indices,
+            std::array<double, 8>* weights) {
+            stencils.getUStencil(i, uSize, indices, weights);
+        },
+        [&](size_t i, const Point3UI&) { return velocities[i].x; },
+        u,
+        _uWeights.accessor(),
+        &_uMarkers);
+    splatParticles(
+        bins,
+        [&](size_t i,
+            std::array<Point3UI, 8>* indices,
+            std::array<double, 8>* weights) {
+            stencils.getVStencil(i, vSize, indices, weights);
+        },
+        [&](size_t i, const Point3UI&) { return velocities[i].y; },
+        v,
+        _vWeights.accessor(),
+        &_vMarkers);
+    splatParticles(
+        bins,
+        [&](size_t i,
+            std::array<Point3UI, 8>* indices,
+            std::array<double, 8>* weights) {
+            stencils.getWStencil(i, wSize, indices, weights);
+        },
+        [&](size_t i, const Point3UI&) { return velocities[i].z; },
+        w,
+        _wWeights.accessor(),
+        &_wMarkers);
+
+    _uWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_uWeights(i, j, k) > 0.0) {
+            u(i, j, k) /= _uWeights(i, j, k);
         }
     });
-    vWeight.forEachIndex([&](size_t i, size_t j, size_t k) {
-        if (vWeight(i, j, k) > 0.0) {
-            v(i, j, k) /= vWeight(i, j, k);
+    _vWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_vWeights(i, j, k) > 0.0) {
+            v(i, j, k) /= _vWeights(i, j, k);
         }
     });
-    wWeight.forEachIndex([&](size_t i, size_t j, size_t k) {
-        if (wWeight(i, j, k) > 0.0) {
-            w(i, j, k) /= wWeight(i, j, k);
+    _wWeights.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        if (_wWeights(i, j, k) > 0.0) {
+            w(i, j, k) /= _wWeights(i, j, k);
         }
     });
 }
@@ -160,10 +252,44 @@ void PicSolver3::transferFromGridsToParticles() {
     auto positions = _particles->positions();
     auto velocities = _particles->velocities();
     size_t numberOfParticles = _particles->numberOfParticles();
+    FaceCenteredGridSampler3 flowSampler(*flow);
+    const ParticleStencils3* stencils = particleStencils();
+
+    if (stencils != nullptr) {
+        parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+            velocities[i] = flowSampler.sample((*stencils)[i]);
+        });
+    } else {
+        parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+            velocities[i] = flowSampler(positions[i]);
+        });
+    }
+}
 
-    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
-        velocities[i] = flow->sample(positions[i]);
-    });
+const ParticleStencils3* PicSolver3::particleStencils() const {
+    if (_areParticleStencilsValid
+        && _particleStencils->size() == _particles->numberOfParticles()) {
+        return _particleStencils.get();
+    }
+    return nullptr;
+}
+
+const ParticleCellBins3& PicSolver3::particleBins() {
+    if (!_areParticleBinsValid
+        || _particleBins->numberOfParticles()
+            != _particles->numberOfParticles()) {
+        JET_PROFILE_SCOPE("binParticles");
+
+        auto flow = gridSystemData()->velocity();
+        _particleBins->build(
+            _particles->positions(),
+            flow->resolution(),
+            flow->gridSpacing(),
+            flow->origin());
+        _areParticleBinsValid = true;
+    }
+
+    return *_particleBins;
 }
 
 void PicSolver3::moveParticles(double timeIntervalInSeconds) {
@@ -171,24 +297,45 @@ void PicSolver3::moveParticles(double timeIntervalInSeconds) {
     auto positions = _particles->positions();
     auto velocities = _particles->velocities();
     size_t numberOfParticles = _particles->numberOfParticles();
-    int domainBoundaryFlag = closedDomainBoundaryFlag();
+    int domainBoundaryFlag = gridClosedDomainBoundaryFlag();
     BoundingBox3D boundingBox = flow->boundingBox();
+    FaceCenteredGridSampler3 flowSampler(*flow);
+    Collider3Ptr col = collider();
+
+    // Adaptive time-stepping, where the max CFL number bounds the number of
+    // sub-steps of each particle
+    unsigned int maxNumSubSteps
+        = static_cast<unsigned int>(std::max(maxCfl(), 1.0));
+    Vector3D gridSpacing = flow->gridSpacing();
+    double minGridSize = min3(gridSpacing.x, gridSpacing.y, gridSpacing.z);
+    double cflPerSpeed = timeIntervalInSeconds / minGridSize;
 
+    // Tracing, domain boundary, and collision in a single pass over the
+    // particles, so each particle is loaded and stored once
     parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
         Vector3D pt0 = positions[i];
         Vector3D pt1 = pt0;
         Vector3D vel = velocities[i];
 
-        // Adaptive time-stepping
-        unsigned int numSubSteps
-            = static_cast<unsigned int>(std::max(maxCfl(), 1.0));
+        // The flow velocity at the start, which the first sub-step needs
+        // anyway, sets the number of sub-steps of this particle, so the slow
+        // particles take a single step
+        Vector3D vel0 = flowSampler(pt0);
+        double particleCfl
+            = cflPerSpeed * max3(
+                std::fabs(vel0.x), std::fabs(vel0.y), std::fabs(vel0.z));
+        unsigned int numSubSteps = static_cast<unsigned int>(clamp(
+            std::ceil(particleCfl), 1.0, static_cast<double>(maxNumSubSteps)));
         double dt = timeIntervalInSeconds / numSubSteps;
+
         for (unsigned int t = 0; t < numSubSteps; ++t) {
-            Vector3D vel0 = flow->sample(pt0);
+            if (t > 0) {
+                vel0 = flowSampler(pt0);
+            }
 
             // Mid-point rule
             Vector3D midPt = pt0 + 0.5 * dt * vel0;
-            Vector3D midVel = flow->sample(midPt);
+            Vector3D midVel = flowSampler(midPt);
             pt1 = pt0 + dt * midVel;
 
             pt0 = pt1;
@@ -225,23 +372,139 @@ void PicSolver3::moveParticles(double timeIntervalInSeconds) {
             vel.z = 0.0;
         }
 
+        if (col != nullptr) {
+            col->resolveCollision(0.0, 0.0, &pt1, &vel);
+        }
+
         positions[i] = pt1;
         velocities[i] = vel;
     });
+}
 
-    Collider3Ptr col = collider();
-    if (col != nullptr) {
-        parallelFor(
-            kZeroSize,
-            numberOfParticles,
-            [&](size_t i) {
-                col->resolveCollision(
-                    0.0,
-                    0.0,
-                    &positions[i],
-                    &velocities[i]);
+void PicSolver3::reseedParticles() {
+    auto flow = gridSystemData()->velocity();
+    Size3 res = flow->resolution();
+    Vector3D h = flow->gridSpacing();
+    Vector3D origin = flow->origin();
+    const size_t numberOfCells = res.x * res.y * res.z;
+    const size_t numberOfParticles = _particles->numberOfParticles();
+    if (numberOfCells == 0) {
+        return;
+    }
+
+    // The particles of each cell past the max number, which are the ones
+    // with the larger indices, are removed
+    const ParticleCellBins3& bins = particleBins();
+    _isRemoved.assign(numberOfParticles, 0);
+    size_t numberOfRemoved = parallelReduce(
+        kZeroSize,
+        numberOfCells,
+        kZeroSize,
+        [&](size_t begin, size_t end, size_t removed) {
+            for (size_t c = begin; c < end; ++c) {
+                size_t first = bins.cellBegin(c);
+                size_t last = bins.cellEnd(c);
+                if (last - first <= _maxNumberOfParticlesPerCell) {
+                    continue;
+                }
+                for (size_t q = first + _maxNumberOfParticlesPerCell;
+                     q < last; ++q) {
+                    _isRemoved[bins.particleIndex(q)] = 1;
+                    ++removed;
+                }
+            }
+            return removed;
+        },
+        [](size_t a, size_t b) {
+            return a + b;
+        });
+
+    if (numberOfRemoved > 0) {
+        _particles->removeParticles([&](size_t p) {
+            return _isRemoved[p] != 0;
+        });
+    }
+
+    // Fills the starving interior cells, whose neighbors all have particles
+    // or are out of the fluid domain, so the surface does not grow
+    size_t numberOfSeeded = 0;
+    if (_minNumberOfParticlesPerCell > 0) {
+        // The indices out of the domain include the wrapped-around ones
+        const CellCenteredScalarGrid3& colSdf = colliderSdf();
+        auto isFilled = [&](size_t i, size_t j, size_t k) {
+            return i >= res.x || j >= res.y || k >= res.z
+                || bins.numberOfParticlesInCell(i, j, k) > 0
+                || isInsideSdf(colSdf(i, j, k));
+        };
+        auto deficit = [&](size_t i, size_t j, size_t k) -> size_t {
+            size_t count = bins.numberOfParticlesInCell(i, j, k);
+            if (count >= _minNumberOfParticlesPerCell
+                || isInsideSdf(colSdf(i, j, k))
+                || !isFilled(i - 1, j, k) || !isFilled(i + 1, j, k)
+                || !isFilled(i, j - 1, k) || !isFilled(i, j + 1, k)
+                || !isFilled(i, j, k - 1) || !isFilled(i, j, k + 1)) {
+                return 0;
+            }
+            return _minNumberOfParticlesPerCell - count;
+        };
+
+        // The new particles of each k-slice are placed at the prefix sum of
+        // the slice counts
+        std::vector<size_t> sliceOffsets(res.z + 1, 0);
+        parallelFor(kZeroSize, res.z, [&](size_t k) {
+            size_t count = 0;
+            for (size_t j = 0; j < res.y; ++j) {
+                for (size_t i = 0; i < res.x; ++i) {
+                    count += deficit(i, j, k);
+                }
+            }
+            sliceOffsets[k + 1] = count;
+        });
+        for (size_t k = 0; k < res.z; ++k) {
+            sliceOffsets[k + 1] += sliceOffsets[k];
+        }
+        numberOfSeeded = sliceOffsets[res.z];
+
+        if (numberOfSeeded > 0) {
+            const size_t firstIndex = _particles->numberOfParticles();
+            _particles->resize(firstIndex + numberOfSeeded);
+            auto positions = _particles->positions();
+            auto velocities = _particles->velocities();
+            FaceCenteredGridSampler3 flowSampler(*flow);
+
+            // Random numbers are keyed by the cell and the pass
+            PhiloxRng rng(_numberOfReseedingPasses);
+            parallelFor(kZeroSize, res.z, [&](size_t k) {
+                size_t index = firstIndex + sliceOffsets[k];
+                for (size_t j = 0; j < res.y; ++j) {
+                    for (size_t i = 0; i < res.x; ++i) {
+                        size_t n = deficit(i, j, k);
+                        uint64_t cell = i + res.x * (j + res.y * k);
+                        for (size_t s = 0; s < n; ++s) {
+                            uint64_t counter
+                                = cell * _minNumberOfParticlesPerCell + s;
+                            std::array<double, 2> u = rng.uniform2(counter);
+                            std::array<double, 2> v = rng.uniform2(counter, 1);
+                            Vector3D x = origin + h * Vector3D(
+                                i + u[0], j + u[1], k + v[0]);
+                            positions[index] = x;
+                            velocities[index] = flowSampler(x);
+                            ++index;
+                        }
+                    }
+                }
             });
+        }
     }
+
+    ++_numberOfReseedingPasses;
+
+    if (numberOfRemoved > 0 || numberOfSeeded > 0) {
+        _areParticleBinsValid = false;
+    }
+
+    JET_INFO << "Reseeding removed " << numberOfRemoved
+             << " particles and seeded " << numberOfSeeded << " particles";
 }
 
 void PicSolver3::extrapolateVelocityToAir() {
@@ -250,10 +513,25 @@ void PicSolver3::extrapolateVelocityToAir() {
     auto v = vel->vAccessor();
     auto w = vel->wAccessor();
 
+    // The components are independent, so they are extrapolated together
     unsigned int depth = static_cast<unsigned int>(std::ceil(maxCfl()));
-    extrapolateToRegion(vel->uConstAccessor(), _uMarkers, depth, u);
-    extrapolateToRegion(vel->vConstAccessor(), _vMarkers, depth, v);
-    extrapolateToRegion(vel->wConstAccessor(), _wMarkers, depth, w);
+    parallelInvoke({
+        [&]() {
+            extrapolateToRegion(
+                vel->uConstAccessor(), _uMarkers, depth, u,
+                &_extrapolationBuffers[0]);
+        },
+        [&]() {
+            extrapolateToRegion(
+                vel->vConstAccessor(), _vMarkers, depth, v,
+                &_extrapolationBuffers[1]);
+        },
+        [&]() {
+            extrapolateToRegion(
+                vel->wConstAccessor(), _wMarkers, depth, w,
+                &_extrapolationBuffers[2]);
+        }
+    });
 }
 
 void PicSolver3::buildSignedDistanceField() {
@@ -264,16 +542,18 @@ void PicSolver3::buildSignedDistanceField() {
     double radius = 1.2 * maxH / std::sqrt(2.0);
     double sdfBandRadius = 2.0 * radius;
 
-    _particles->buildNeighborSearcher(2 * radius);
-    auto searcher = _particles->neighborSearcher();
+    // The particles near a point are in the cells around it, so no neighbor
+    // searcher has to be built
+    const ParticleCellBins3& bins = particleBins();
+    auto positions = _particles->positions();
     sdf->parallelForEachDataPointIndex([&] (size_t i, size_t j, size_t k) {
         Vector3D pt = sdfPos(i, j, k);
-        double minDist = sdfBandRadius;
-        searcher->forEachNearbyPoint(
-            pt, sdfBandRadius, [&] (size_t, const Vector3D& x) {
-                minDist = std::min(minDist, pt.distanceTo(x));
-            });
-        (*sdf)(i, j, k) = minDist - radius;
+        double minDistSquared = sdfBandRadius * sdfBandRadius;
+        bins.forEachNearbyParticle(pt, sdfBandRadius, [&](size_t p) {
+            minDistSquared = std::min(
+                minDistSquared, pt.distanceSquaredTo(positions[p]));
+        });
+        (*sdf)(i, j, k) = std::sqrt(minDistSquared) - radius;
     });
 
     extrapolateIntoCollider(sdf.get());
@@ -2,11 +2,135 @@
 
 #include <pch.h>
 #include <jet/plane3.h>
+#include <primitive_distance_helpers.h>
 
 #include <limits>
 
 using namespace jet;
 
+namespace {
+
+void planeDistancesScalar(
+    size_t begin,
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& normal,
+    const Vector3D& point,
+    double* result) {
+    for (size_t i = begin; i < n; ++i) {
+        result[i] = normal.x * (p.x[i] - point.x)
+            + normal.y * (p.y[i] - point.y)
+            + normal.z * (p.z[i] - point.z);
+    }
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 void planeDistancesSse2(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& normal,
+    const Vector3D& point,
+    double* result) {
+    const __m128d nx = _mm_set1_pd(normal.x);
+    const __m128d ny = _mm_set1_pd(normal.y);
+    const __m128d nz = _mm_set1_pd(normal.z);
+    const __m128d px = _mm_set1_pd(point.x);
+    const __m128d py = _mm_set1_pd(point.y);
+    const __m128d pz = _mm_set1_pd(point.z);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_add_pd(
+            _mm_add_pd(
+                _mm_mul_pd(nx, _mm_sub_pd(_mm_loadu_pd(p.x + i), px)),
+                _mm_mul_pd(ny, _mm_sub_pd(_mm_loadu_pd(p.y + i), py))),
+            _mm_mul_pd(nz, _mm_sub_pd(_mm_loadu_pd(p.z + i), pz)));
+        _mm_storeu_pd(result + i, d);
+    }
+    planeDistancesScalar(i, n, p, normal, point, result);
+}
+
+JET_TARGET_AVX void planeDistancesAvx(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& normal,
+    const Vector3D& point,
+    double* result) {
+    const __m256d nx = _mm256_set1_pd(normal.x);
+    const __m256d ny = _mm256_set1_pd(normal.y);
+    const __m256d nz = _mm256_set1_pd(normal.z);
+    const __m256d px = _mm256_set1_pd(point.x);
+    const __m256d py = _mm256_set1_pd(point.y);
+    const __m256d pz = _mm256_set1_pd(point.z);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_add_pd(
+            _mm256_add_pd(
+                _mm256_mul_pd(nx, _mm256_sub_pd(_mm256_loadu_pd(p.x + i), px)),
+                _mm256_mul_pd(
+                    ny, _mm256_sub_pd(_mm256_loadu_pd(p.y + i), py))),
+            _mm256_mul_pd(nz, _mm256_sub_pd(_mm256_loadu_pd(p.z + i), pz)));
+        _mm256_storeu_pd(result + i, d);
+    }
+    planeDistancesScalar(i, n, p, normal, point, result);
+}
+
+#elif defined(JET_SIMD_NEON)
+
+void planeDistancesNeon(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& normal,
+    const Vector3D& point,
+    double* result) {
+    const float64x2_t nx = vdupq_n_f64(normal.x);
+    const float64x2_t ny = vdupq_n_f64(normal.y);
+    const float64x2_t nz = vdupq_n_f64(normal.z);
+    const float64x2_t px = vdupq_n_f64(point.x);
+    const float64x2_t py = vdupq_n_f64(point.y);
+    const float64x2_t pz = vdupq_n_f64(point.z);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t d = vaddq_f64(
+            vaddq_f64(
+                vmulq_f64(nx, vsubq_f64(vld1q_f64(p.x + i), px)),
+                vmulq_f64(ny, vsubq_f64(vld1q_f64(p.y + i), py))),
+            vmulq_f64(nz, vsubq_f64(vld1q_f64(p.z + i), pz)));
+        vst1q_f64(result + i, d);
+    }
+    planeDistancesScalar(i, n, p, normal, point, result);
+}
+
+#endif
+
+void planeDistances(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& normal,
+    const Vector3D& point,
+    double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+        case SimdInstructionSet::Avx:
+            planeDistancesAvx(n, p, normal, point, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            planeDistancesSse2(n, p, normal, point, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            planeDistancesNeon(n, p, normal, point, result);
+            return;
+#endif
+        default:
+            planeDistancesScalar(0, n, p, normal, point, result);
+            return;
+    }
+}
+
+}  // namespace
+
 Plane3::Plane3() {
 }
 
@@ -89,3 +213,13 @@ BoundingBox3D Plane3::boundingBox() const {
             Vector3D(dmax, dmax, dmax));
     }
 }
+
+void Plane3::actualBatchClosestSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    primitiveSignedDistances(
+        otherPoints, result,
+        [&](size_t n, const PrimitiveDistanceChunk& p, double* out) {
+            planeDistances(n, p, normal, point, out);
+        });
+}
@@ -0,0 +1,284 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+
+#include <jet/bounding_box3.h>
+#include <jet/constants.h>
+#include <jet/math_utils.h>
+#include <jet/parallel.h>
+#include <jet/point_cell_list_searcher3.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace jet;
+
+// Max number of cells along an axis, which keeps the cell indices of points
+// far away from the others in range
+static const double kMaxResolution = 1e6;
+
+static BoundingBox3D pointBounds(const ConstArrayAccessor1<Vector3D>& points) {
+    return parallelReduce(
+        kZeroSize, points.size(), BoundingBox3D(),
+        [&](size_t begin, size_t end, BoundingBox3D partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.merge(points[i]);
+            }
+            return partial;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+}
+
+static Size3 cellListResolution(
+    const BoundingBox3D& bound,
+    double cellSize) {
+    Size3 resolution;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double lower = std::floor(bound.lowerCorner[axis] / cellSize);
+        double upper = std::floor(bound.upperCorner[axis] / cellSize);
+        resolution[axis] = static_cast<size_t>(
+            std::min(upper - lower + 1.0, kMaxResolution));
+    }
+    return resolution;
+}
+
+namespace jet {
+
+Size3 cellListResolution3(
+    const ConstArrayAccessor1<Vector3D>& points,
+    double cellSize) {
+    if (points.size() == 0 || !(cellSize > 0.0)) {
+        return Size3(1, 1, 1);
+    }
+
+    return cellListResolution(pointBounds(points), cellSize);
+}
+
+}  // namespace jet
+
+PointCellListSearcher3::PointCellListSearcher3(double cellSize) :
+    _cellSize(cellSize) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
+    _cellStarts.resize(2, 0);
+}
+
+void PointCellListSearcher3::build(
+    const ConstArrayAccessor1<Vector3D>& points) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
+    size_t numberOfPoints = points.size();
+    _maxDistanceFromCell = 0.0;
+
+    if (numberOfPoints == 0) {
+        _origin = Vector3D();
+        _resolution = Size3(1, 1, 1);
+        _points.clear();
+        _keys.clear();
+        _sortedIndices.clear();
+        _cellStarts.assign(2, 0);
+        return;
+    }
+
+    BoundingBox3D bound = pointBounds(points);
+    _resolution = cellListResolution(bound, _cellSize);
+    for (size_t axis = 0; axis < 3; ++axis) {
+        _origin[axis]
+            = std::floor(bound.lowerCorner[axis] / _cellSize) * _cellSize;
+    }
+
+    size_t numberOfCells = _resolution.x * _resolution.y * _resolution.z;
+    _keys.resize(numberOfPoints);
+    _sortedIndices.resize(numberOfPoints);
+    _points.resize(numberOfPoints);
+    _cellStarts.resize(numberOfCells + 1);
+
+    // The cells are clamped since the rounding can put the points on the
+    // upper side just outside of the grid
+    parallelFor(
+        kZeroSize,
+        numberOfPoints,
+        [&](size_t i) {
+            Vector3D cell = (points[i] - _origin) / _cellSize;
+            size_t index[3];
+            for (size_t axis = 0; axis < 3; ++axis) {
+                index[axis] = static_cast<size_t>(clamp(
+                    std::floor(cell[axis]),
+                    0.0,
+                    static_cast<double>(_resolution[axis] - 1)));
+            }
+            _keys[i] = (index[2] * _resolution.y + index[1]) * _resolution.x
+                + index[0];
+            _sortedIndices[i] = i;
+        });
+
+    parallelRadixSort(
+        _keys.begin(), _keys.end(), _sortedIndices.begin(), numberOfCells - 1);
+
+    parallelFor(
+        kZeroSize,
+        numberOfPoints,
+        [&](size_t i) {
+            _points[i] = points[_sortedIndices[i]];
+        });
+
+    // Each sorted point i starts the cells after the one of point i - 1 up
+    // to its own, so every cell, including the empty ones, is written once
+    parallelFor(
+        kZeroSize,
+        numberOfPoints + 1,
+        [&](size_t i) {
+            size_t firstCell = (i == 0) ? 0 : _keys[i - 1] + 1;
+            size_t lastCell = (i == numberOfPoints) ? numberOfCells : _keys[i];
+            for (size_t cell = firstCell; cell <= lastCell; ++cell) {
+                _cellStarts[cell] = i;
+            }
+        });
+}
+
+void PointCellListSearcher3::updatePointPositions(
+    const ConstArrayAccessor1<Vector3D>& points) {
+    if (points.size() != _points.size()) {
+        build(points);
+        return;
+    }
+
+    _maxDistanceFromCell = parallelReduce(
+        kZeroSize,
+        points.size(),
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                _points[i] = points[_sortedIndices[i]];
+
+                size_t key = _keys[i];
+                size_t index[3] = {
+                    key % _resolution.x,
+                    (key / _resolution.x) % _resolution.y,
+                    key / (_resolution.x * _resolution.y)
+                };
+
+                // Squared distance from the point to the box of its cell
+                double distanceSquared = 0.0;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    double lower = _origin[axis] + _cellSize * index[axis];
+                    double upper = lower + _cellSize;
+                    double offset = std::max(
+                        std::max(
+                            lower - _points[i][axis],
+                            _points[i][axis] - upper),
+                        0.0);
+                    distanceSquared += offset * offset;
+                }
+                partial = std::max(partial, distanceSquared);
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
+    _maxDistanceFromCell = std::sqrt(_maxDistanceFromCell);
+}
+
+void PointCellListSearcher3::forEachNearbyPoint(
+    const Vector3D& origin,
+    double radius,
+    const ForEachNearbyPointFunc& callback) const {
+    forEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
+}
+
+bool PointCellListSearcher3::hasNearbyPoint(
+    const Vector3D& origin,
+    double radius) const {
+    Size3 lower, upper;
+    if (!getCellRange(origin, radius, &lower, &upper)) {
+        return false;
+    }
+
+    const double queryRadiusSquared = radius * radius;
+
+    for (size_t k = lower.z; k <= upper.z; ++k) {
+        for (size_t j = lower.y; j <= upper.y; ++j) {
+            size_t rowKey = (k * _resolution.y + j) * _resolution.x;
+            size_t begin = _cellStarts[rowKey + lower.x];
+            size_t end = _cellStarts[rowKey + upper.x + 1];
+
+            for (size_t p = begin; p < end; ++p) {
+                if (_points[p].distanceSquaredTo(origin)
+                    <= queryRadiusSquared) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+size_t PointCellListSearcher3::nearest(
+    const Vector3D& origin,
+    double maxRadius) const {
+    size_t nearestIndex = kMaxSize;
+    double nearestDistanceSquared = maxRadius * maxRadius;
+    forEachNearbyPoint(
+        origin,
+        maxRadius,
+        [&](size_t i, const Vector3D& pt) {
+            // Ties go to the smaller index, so the result does not depend on
+            // the order of the cells
+            double distanceSquared = pt.distanceSquaredTo(origin);
+            if (distanceSquared < nearestDistanceSquared
+                || (distanceSquared == nearestDistanceSquared
+                    && i < nearestIndex)) {
+                nearestDistanceSquared = distanceSquared;
+                nearestIndex = i;
+            }
+        });
+
+    return nearestIndex;
+}
+
+double PointCellListSearcher3::cellSize() const {
+    return _cellSize;
+}
+
+const Vector3D& PointCellListSearcher3::origin() const {
+    return _origin;
+}
+
+const Size3& PointCellListSearcher3::resolution() const {
+    return _resolution;
+}
+
+const TrackedVector<size_t>& PointCellListSearcher3::sortedIndices() const {
+    return _sortedIndices;
+}
+
+bool PointCellListSearcher3::getCellRange(
+    const Vector3D& origin,
+    double radius,
+    Size3* lower,
+    Size3* upper) const {
+    if (_points.empty()) {
+        return false;
+    }
+
+    // The points that moved out of their cells are found by widening the
+    // range by the farthest of them
+    double reach = radius + _maxDistanceFromCell;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double first = std::floor(
+            (origin[axis] - reach - _origin[axis]) / _cellSize);
+        double last = std::floor(
+            (origin[axis] + reach - _origin[axis]) / _cellSize);
+        double maxIndex = static_cast<double>(_resolution[axis] - 1);
+        if (last < 0.0 || first > maxIndex) {
+            return false;
+        }
+        (*lower)[axis] = static_cast<size_t>(std::max(first, 0.0));
+        (*upper)[axis] = static_cast<size_t>(std::min(last, maxIndex));
+    }
+
+    return true;
+}
@@ -1,8 +1,11 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/parallel.h>
 #include <jet/point_generator3.h>
 
+#include <vector>
+
 namespace jet {
 
 PointGenerator3::PointGenerator3() {
@@ -15,13 +18,84 @@ void PointGenerator3::generate(
     const BoundingBox3D& boundingBox,
     double spacing,
     Array1<Vector3D>* points) const {
-    forEachPoint(
+    const size_t n = numberOfSlices(boundingBox, spacing);
+
+    std::vector<size_t> offsets(n + 1, points->size());
+    parallelFor(kZeroSize, n, [&](size_t s) {
+        offsets[s + 1] = countPointsInSlices(boundingBox, spacing, s, s + 1);
+    });
+    for (size_t s = 0; s < n; ++s) {
+        offsets[s + 1] += offsets[s];
+    }
+
+    points->resize(offsets[n]);
+    Vector3D* data = points->data();
+    parallelFor(kZeroSize, n, [&](size_t s) {
+        generateRange(
+            boundingBox,
+            spacing,
+            s,
+            s + 1,
+            ArrayAccessor1<Vector3D>(
+                offsets[s + 1] - offsets[s], data + offsets[s]));
+    });
+}
+
+size_t PointGenerator3::countPoints(
+    const BoundingBox3D& boundingBox,
+    double spacing) const {
+    return countPointsInSlices(
         boundingBox,
         spacing,
-        [&points](const Vector3D& point) {
-            points->append(point);
-            return true;
-        });
+        0,
+        numberOfSlices(boundingBox, spacing));
+}
+
+size_t PointGenerator3::numberOfSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing) const {
+    UNUSED_VARIABLE(boundingBox);
+    UNUSED_VARIABLE(spacing);
+
+    return 1;
+}
+
+size_t PointGenerator3::countPointsInSlices(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd) const {
+    size_t count = 0;
+    if (sliceBegin == 0 && sliceEnd > 0) {
+        forEachPoint(
+            boundingBox,
+            spacing,
+            [&count](const Vector3D&) {
+                ++count;
+                return true;
+            });
+    }
+    return count;
+}
+
+void PointGenerator3::generateRange(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    size_t sliceBegin,
+    size_t sliceEnd,
+    ArrayAccessor1<Vector3D> points) const {
+    size_t count = 0;
+    if (sliceBegin == 0 && sliceEnd > 0) {
+        forEachPoint(
+            boundingBox,
+            spacing,
+            [&](const Vector3D& point) {
+                JET_ASSERT(count < points.size());
+                points[count++] = point;
+                return true;
+            });
+    }
+    JET_ASSERT(count == points.size());
 }
 
 }  // namespace jet
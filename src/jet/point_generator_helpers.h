@@ -0,0 +1,30 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_POINT_GENERATOR_HELPERS_H_
+#define SRC_JET_POINT_GENERATOR_HELPERS_H_
+
+#include <cstddef>
+
+namespace jet {
+
+// Returns the number of i >= 0 that satisfy i * step + offset <= length,
+// evaluated the same way as the loops of the lattice point generators so
+// that the counts match them exactly.
+inline size_t numberOfLatticeSteps(double step, double offset, double length) {
+    if (!(offset <= length)) {
+        return 0;
+    }
+
+    int n = static_cast<int>((length - offset) / step);
+    while (n > 0 && n * step + offset > length) {
+        --n;
+    }
+    while ((n + 1) * step + offset <= length) {
+        ++n;
+    }
+    return static_cast<size_t>(n) + 1;
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_POINT_GENERATOR_HELPERS_H_
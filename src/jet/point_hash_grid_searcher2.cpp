@@ -27,6 +27,7 @@ PointHashGridSearcher2::PointHashGridSearcher2(
 
 void PointHashGridSearcher2::build(
     const ConstArrayAccessor1<Vector2D>& points) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
     _buckets.clear();
     _points.clear();
 
@@ -50,27 +51,7 @@ void PointHashGridSearcher2::forEachNearbyPoint(
     const Vector2D& origin,
     double radius,
     const ForEachNearbyPointFunc& callback) const {
-    if (_buckets.empty()) {
-        return;
-    }
-
-    size_t nearbyKeys[4];
-    getNearbyKeys(origin, nearbyKeys);
-
-    const double queryRadiusSquared = radius * radius;
-
-    for (int i = 0; i < 4; i++) {
-        const auto& bucket = _buckets[nearbyKeys[i]];
-        size_t numberOfPointsInBucket = bucket.size();
-
-        for (size_t j = 0; j < numberOfPointsInBucket; ++j) {
-            size_t pointIndex = bucket[j];
-            double rSquared = (_points[pointIndex] - origin).lengthSquared();
-            if (rSquared <= queryRadiusSquared) {
-                callback(pointIndex, _points[pointIndex]);
-            }
-        }
-    }
+    forEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 }
 
 bool PointHashGridSearcher2::hasNearbyPoint(
@@ -102,6 +83,7 @@ bool PointHashGridSearcher2::hasNearbyPoint(
 }
 
 void PointHashGridSearcher2::add(const Vector2D& point) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
     if (_buckets.empty()) {
         Array1<Vector2D> arr = {point};
         build(arr);
@@ -113,7 +95,7 @@ void PointHashGridSearcher2::add(const Vector2D& point) {
     }
 }
 
-const std::vector<std::vector<size_t>>&
+const TrackedVector<TrackedVector<size_t>>&
 PointHashGridSearcher2::buckets() const {
     return _buckets;
 }
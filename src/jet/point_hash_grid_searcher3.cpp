@@ -4,6 +4,7 @@
 
 #include <jet/array1.h>
 #include <jet/point_hash_grid_searcher3.h>
+#include <neighbor_search_helpers.h>
 
 #include <algorithm>
 #include <vector>
@@ -25,79 +26,97 @@ PointHashGridSearcher3::PointHashGridSearcher3(
     size_t resolutionY,
     size_t resolutionZ,
     double gridSpacing) :
-    _gridSpacing(gridSpacing) {
-    _resolution.x = std::max(static_cast<ssize_t>(resolutionX), kOneSSize);
-    _resolution.y = std::max(static_cast<ssize_t>(resolutionY), kOneSSize);
-    _resolution.z = std::max(static_cast<ssize_t>(resolutionZ), kOneSSize);
+    _gridSpacing(gridSpacing),
+    _invGridSpacing(1.0 / gridSpacing) {
+    size_t log2Resolution[3];
+    size_t resolution[3] = { resolutionX, resolutionY, resolutionZ };
+    for (size_t axis = 0; axis < 3; ++axis) {
+        log2Resolution[axis] = 0;
+        while ((kOneSize << log2Resolution[axis]) < resolution[axis]) {
+            ++log2Resolution[axis];
+        }
+        _resolution[axis]
+            = static_cast<ssize_t>(kOneSize << log2Resolution[axis]);
+        _mask[axis] = _resolution[axis] - 1;
+    }
+
+    _shiftY = log2Resolution[0];
+    _shiftZ = log2Resolution[0] + log2Resolution[1];
 }
 
 void PointHashGridSearcher3::build(
     const ConstArrayAccessor1<Vector3D>& points) {
-    _buckets.clear();
-    _points.clear();
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
+    const size_t numberOfBuckets
+        = static_cast<size_t>(_resolution.x * _resolution.y * _resolution.z);
+    const size_t numberOfPoints = points.size();
+
+    _addedHeads.clear();
+    _addedNext.clear();
+    _bucketOffsets.assign(numberOfBuckets + 1, 0);
+    _sortedIndices.resize(numberOfPoints);
+    _sortedPoints.resize(numberOfPoints);
+
+    // Counting sort: count the points per bucket, turn the counts into the
+    // start offsets, and scatter the points while advancing the offsets,
+    // which leaves each offset at the start of the next bucket.
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+        ++_bucketOffsets[getHashKeyFromPosition(points[i]) + 1];
+    }
 
-    // Allocate memory chuncks
-    _buckets.resize(_resolution.x * _resolution.y * _resolution.z);
-    _points.resize(points.size());
+    for (size_t b = 0; b < numberOfBuckets; ++b) {
+        _bucketOffsets[b + 1] += _bucketOffsets[b];
+    }
 
-    if (points.size() == 0) {
-        return;
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+        size_t j = _bucketOffsets[getHashKeyFromPosition(points[i])]++;
+        _sortedIndices[j] = i;
+        _sortedPoints[j] = points[i];
     }
 
-    // Put points into buckets
-    for (size_t i = 0; i < points.size(); ++i) {
-        _points[i] = points[i];
-        size_t key = getHashKeyFromPosition(points[i]);
-        _buckets[key].push_back(i);
+    for (size_t b = numberOfBuckets; b > 0; --b) {
+        _bucketOffsets[b] = _bucketOffsets[b - 1];
     }
+    _bucketOffsets[0] = 0;
 }
 
 void PointHashGridSearcher3::forEachNearbyPoint(
     const Vector3D& origin,
     double radius,
-    const std::function<void(size_t, const Vector3D&)>& callback) const {
-    if (_buckets.empty()) {
-        return;
-    }
-
-    size_t nearbyKeys[8];
-    getNearbyKeys(origin, nearbyKeys);
-
-    const double queryRadiusSquared = radius * radius;
-
-    for (int i = 0; i < 8; i++) {
-        const auto& bucket = _buckets[nearbyKeys[i]];
-        size_t numberOfPointsInBucket = bucket.size();
-
-        for (size_t j = 0; j < numberOfPointsInBucket; ++j) {
-            size_t pointIndex = bucket[j];
-            double rSquared = (_points[pointIndex] - origin).lengthSquared();
-            if (rSquared <= queryRadiusSquared) {
-                callback(pointIndex, _points[pointIndex]);
-            }
-        }
-    }
+    const ForEachNearbyPointFunc& callback) const {
+    forEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 }
 
 bool PointHashGridSearcher3::hasNearbyPoint(
     const Vector3D& origin,
     double radius) const {
-    if (_buckets.empty()) {
+    if (_bucketOffsets.empty()) {
         return false;
     }
 
     size_t nearbyKeys[8];
-    getNearbyKeys(origin, nearbyKeys);
+    const size_t numberOfNearbyKeys = getNearbyKeys(origin, nearbyKeys);
 
     const double queryRadiusSquared = radius * radius;
+    const size_t numberOfBuiltPoints = _bucketOffsets.back();
 
-    for (int i = 0; i < 8; i++) {
-        const auto& bucket = _buckets[nearbyKeys[i]];
-        size_t numberOfPointsInBucket = bucket.size();
+    for (size_t i = 0; i < numberOfNearbyKeys; ++i) {
+        const size_t key = nearbyKeys[i];
+        const size_t end = _bucketOffsets[key + 1];
+        for (size_t j = _bucketOffsets[key]; j < end; ++j) {
+            double rSquared = (_sortedPoints[j] - origin).lengthSquared();
+            if (rSquared <= queryRadiusSquared) {
+                return true;
+            }
+        }
+
+        if (_addedHeads.empty()) {
+            continue;
+        }
 
-        for (size_t j = 0; j < numberOfPointsInBucket; ++j) {
-            size_t pointIndex = bucket[j];
-            double rSquared = (_points[pointIndex] - origin).lengthSquared();
+        for (size_t j = _addedHeads[key]; j != kMaxSize;
+             j = _addedNext[j - numberOfBuiltPoints]) {
+            double rSquared = (_sortedPoints[j] - origin).lengthSquared();
             if (rSquared <= queryRadiusSquared) {
                 return true;
             }
@@ -108,30 +127,74 @@ bool PointHashGridSearcher3::hasNearbyPoint(
 }
 
 void PointHashGridSearcher3::add(const Vector3D& point) {
-    if (_buckets.empty()) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
+    if (_bucketOffsets.empty()) {
         Array1<Vector3D> arr = {point};
         build(arr);
-    } else {
-        size_t i = _points.size();
-        _points.push_back(point);
-        size_t key = getHashKeyFromPosition(point);
-        _buckets[key].push_back(i);
+        return;
+    }
+
+    if (_addedHeads.empty()) {
+        _addedHeads.assign(_bucketOffsets.size() - 1, kMaxSize);
     }
+
+    size_t i = _sortedPoints.size();
+    size_t key = getHashKeyFromPosition(point);
+    _sortedIndices.push_back(i);
+    _sortedPoints.push_back(point);
+    _addedNext.push_back(_addedHeads[key]);
+    _addedHeads[key] = i;
+}
+
+Size3 PointHashGridSearcher3::resolution() const {
+    return Size3(
+        static_cast<size_t>(_resolution.x),
+        static_cast<size_t>(_resolution.y),
+        static_cast<size_t>(_resolution.z));
 }
 
-const std::vector<std::vector<size_t>>&
-PointHashGridSearcher3::buckets() const {
-    return _buckets;
+size_t PointHashGridSearcher3::numberOfPointsInBucket(size_t key) const {
+    size_t count = 0;
+    forEachPointInBucket(key, [&](size_t, const Vector3D&) { ++count; });
+    return count;
+}
+
+PointHashGridStatistics PointHashGridSearcher3::statistics() const {
+    PointHashGridStatistics stats;
+    stats.numberOfPoints = _sortedPoints.size();
+    stats.numberOfBuckets
+        = static_cast<size_t>(_resolution.x * _resolution.y * _resolution.z);
+    stats.loadFactor = static_cast<double>(stats.numberOfPoints)
+        / static_cast<double>(stats.numberOfBuckets);
+
+    std::vector<Point3I> cells;
+    for (size_t key = 0; key < stats.numberOfBuckets; ++key) {
+        cells.clear();
+        forEachPointInBucket(key, [&](size_t, const Vector3D& point) {
+            cells.push_back(getBucketIndex(point));
+        });
+
+        if (cells.empty()) {
+            continue;
+        }
+
+        ++stats.numberOfNonEmptyBuckets;
+        stats.maxNumberOfPointsPerBucket
+            = std::max(stats.maxNumberOfPointsPerBucket, cells.size());
+        stats.numberOfCollisions += countDistinctCells(&cells) - 1;
+    }
+
+    return stats;
 }
 
 Point3I PointHashGridSearcher3::getBucketIndex(const Vector3D& position) const {
     Point3I bucketIndex;
     bucketIndex.x = static_cast<ssize_t>(
-        std::floor(position.x / _gridSpacing));
+        std::floor(position.x * _invGridSpacing));
     bucketIndex.y = static_cast<ssize_t>(
-        std::floor(position.y / _gridSpacing));
+        std::floor(position.y * _invGridSpacing));
     bucketIndex.z = static_cast<ssize_t>(
-        std::floor(position.z / _gridSpacing));
+        std::floor(position.z * _invGridSpacing));
     return bucketIndex;
 }
 
@@ -143,72 +206,44 @@ size_t PointHashGridSearcher3::getHashKeyFromPosition(
 
 size_t PointHashGridSearcher3::getHashKeyFromBucketIndex(
     const Point3I& bucketIndex) const {
-    Point3I wrappedIndex = bucketIndex;
-    wrappedIndex.x = bucketIndex.x % _resolution.x;
-    wrappedIndex.y = bucketIndex.y % _resolution.y;
-    wrappedIndex.z = bucketIndex.z % _resolution.z;
-    if (wrappedIndex.x < 0) {
-        wrappedIndex.x += _resolution.x;
-    }
-    if (wrappedIndex.y < 0) {
-        wrappedIndex.y += _resolution.y;
-    }
-    if (wrappedIndex.z < 0) {
-        wrappedIndex.z += _resolution.z;
-    }
-    return static_cast<size_t>(
-        (wrappedIndex.z * _resolution.y + wrappedIndex.y) * _resolution.x
-        + wrappedIndex.x);
+    // Masking the two's complement wraps the negative indices as well
+    return (static_cast<size_t>(bucketIndex.z & _mask.z) << _shiftZ)
+        | (static_cast<size_t>(bucketIndex.y & _mask.y) << _shiftY)
+        | static_cast<size_t>(bucketIndex.x & _mask.x);
 }
 
-void PointHashGridSearcher3::getNearbyKeys(
+size_t PointHashGridSearcher3::getNearbyKeys(
     const Vector3D& position,
     size_t* nearbyKeys) const {
-    Point3I originIndex = getBucketIndex(position), nearbyBucketIndices[8];
-
-    for (int i = 0; i < 8; i++) {
-        nearbyBucketIndices[i] = originIndex;
-    }
-
-    if ((originIndex.x + 0.5f) * _gridSpacing <= position.x) {
-        nearbyBucketIndices[4].x += 1;
-        nearbyBucketIndices[5].x += 1;
-        nearbyBucketIndices[6].x += 1;
-        nearbyBucketIndices[7].x += 1;
-    } else {
-        nearbyBucketIndices[4].x -= 1;
-        nearbyBucketIndices[5].x -= 1;
-        nearbyBucketIndices[6].x -= 1;
-        nearbyBucketIndices[7].x -= 1;
+    // The index of the half cell is h = floor(2 * position / spacing), which
+    // is 2c or 2c + 1 in the cell c. The neighborhood spans the cells
+    // (h - 1) / 2 and the next one, i.e. c - 1 and c for the lower half and
+    // c and c + 1 for the upper half. The axes of one bucket have a single
+    // neighbor so that no point is visited twice.
+    size_t wrapped[3][2];
+    size_t numberOfNeighbors[3];
+    const size_t shifts[3] = { 0, _shiftY, _shiftZ };
+    for (size_t axis = 0; axis < 3; ++axis) {
+        ssize_t h = static_cast<ssize_t>(
+            std::floor(2.0 * (position[axis] * _invGridSpacing)));
+        ssize_t lower = (h - 1) >> 1;
+        wrapped[axis][0] = static_cast<size_t>(lower & _mask[axis])
+            << shifts[axis];
+        wrapped[axis][1] = static_cast<size_t>((lower + 1) & _mask[axis])
+            << shifts[axis];
+        numberOfNeighbors[axis] = (_mask[axis] == 0) ? 1 : 2;
     }
 
-    if ((originIndex.y + 0.5f) * _gridSpacing <= position.y) {
-        nearbyBucketIndices[2].y += 1;
-        nearbyBucketIndices[3].y += 1;
-        nearbyBucketIndices[6].y += 1;
-        nearbyBucketIndices[7].y += 1;
-    } else {
-        nearbyBucketIndices[2].y -= 1;
-        nearbyBucketIndices[3].y -= 1;
-        nearbyBucketIndices[6].y -= 1;
-        nearbyBucketIndices[7].y -= 1;
-    }
-
-    if ((originIndex.z + 0.5f) * _gridSpacing <= position.z) {
-        nearbyBucketIndices[1].z += 1;
-        nearbyBucketIndices[3].z += 1;
-        nearbyBucketIndices[5].z += 1;
-        nearbyBucketIndices[7].z += 1;
-    } else {
-        nearbyBucketIndices[1].z -= 1;
-        nearbyBucketIndices[3].z -= 1;
-        nearbyBucketIndices[5].z -= 1;
-        nearbyBucketIndices[7].z -= 1;
+    size_t n = 0;
+    for (size_t k = 0; k < numberOfNeighbors[2]; ++k) {
+        for (size_t j = 0; j < numberOfNeighbors[1]; ++j) {
+            for (size_t i = 0; i < numberOfNeighbors[0]; ++i) {
+                nearbyKeys[n++] = wrapped[2][k] | wrapped[1][j] | wrapped[0][i];
+            }
+        }
     }
 
-    for (int i = 0; i < 8; i++) {
-        nearbyKeys[i] = getHashKeyFromBucketIndex(nearbyBucketIndices[i]);
-    }
+    return n;
 }
 
 }  // namespace jet
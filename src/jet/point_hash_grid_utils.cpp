@@ -0,0 +1,66 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/bounding_box3.h>
+#include <jet/parallel.h>
+#include <jet/point_hash_grid_utils.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace jet {
+
+static const size_t kMaxNumberOfBucketsPerPoint = 8;
+
+static size_t nextPowerOfTwo(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+Size3 suggestedHashGridResolution3(
+    const ConstArrayAccessor1<Vector3D>& points,
+    double gridSpacing) {
+    size_t n = points.size();
+    if (n == 0 || !(gridSpacing > 0.0)) {
+        return Size3(1, 1, 1);
+    }
+
+    BoundingBox3D bound = parallelReduce(
+        kZeroSize, n, BoundingBox3D(),
+        [&](size_t begin, size_t end, BoundingBox3D partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.merge(points[i]);
+            }
+            return partial;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+
+    // Occupied cells plus the neighbors visited by the queries at the border
+    Size3 resolution;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        double lower = std::floor(bound.lowerCorner[axis] / gridSpacing);
+        double upper = std::floor(bound.upperCorner[axis] / gridSpacing);
+        double numberOfCells = upper - lower + 3.0;
+        resolution[axis] = nextPowerOfTwo(
+            static_cast<size_t>(std::min(numberOfCells, 1e6)));
+    }
+
+    const size_t maxNumberOfBuckets
+        = nextPowerOfTwo(kMaxNumberOfBucketsPerPoint * n);
+    while (resolution.x * resolution.y * resolution.z > maxNumberOfBuckets) {
+        size_t axis = (resolution.x >= resolution.y)
+            ? ((resolution.x >= resolution.z) ? 0 : 2)
+            : ((resolution.y >= resolution.z) ? 1 : 2);
+        resolution[axis] /= 2;
+    }
+
+    return resolution;
+}
+
+}  // namespace jet
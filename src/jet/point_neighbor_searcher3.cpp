@@ -1,12 +1,134 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/array1.h>
+#include <jet/bounding_box3.h>
+#include <jet/constants.h>
+#include <jet/parallel.h>
 #include <jet/point_neighbor_searcher3.h>
+#include <morton_helpers.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 using namespace jet;
 
+// Returns the order of the origins along the Z-order curve.
+static void sortOrigins(
+    const ConstArrayAccessor1<Vector3D>& origins,
+    Array1<size_t>* order) {
+    size_t n = origins.size();
+    BoundingBox3D bound = parallelReduce(
+        kZeroSize, n, BoundingBox3D(),
+        [&](size_t begin, size_t end, BoundingBox3D partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.merge(origins[i]);
+            }
+            return partial;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+    double scale = mortonScale3(bound);
+
+    std::vector<size_t> keys(n);
+    order->resize(n);
+    parallelFor(kZeroSize, n,
+        [&](size_t i) {
+            keys[i] = mortonKey3(bound, scale, origins[i]);
+            (*order)[i] = i;
+        });
+
+    parallelRadixSort(keys.begin(), keys.end(), order->begin(), kMaxMortonKey3);
+}
+
 PointNeighborSearcher3::PointNeighborSearcher3() {
 }
 
 PointNeighborSearcher3::~PointNeighborSearcher3() {
 }
+
+size_t PointNeighborSearcher3::nearest(
+    const Vector3D& origin,
+    double maxRadius) const {
+    size_t nearestIndex = kMaxSize;
+    double nearestDistanceSquared = kMaxD;
+    forEachNearbyPoint(
+        origin,
+        maxRadius,
+        [&](size_t i, const Vector3D& point) {
+            double distanceSquared = point.distanceSquaredTo(origin);
+            if (distanceSquared < nearestDistanceSquared) {
+                nearestDistanceSquared = distanceSquared;
+                nearestIndex = i;
+            }
+        });
+    return nearestIndex;
+}
+
+void PointNeighborSearcher3::kNearest(
+    const Vector3D& origin,
+    double maxRadius,
+    size_t k,
+    std::vector<size_t>* indices) const {
+    std::vector<std::pair<double, size_t>> candidates;
+    forEachNearbyPoint(
+        origin,
+        maxRadius,
+        [&](size_t i, const Vector3D& point) {
+            candidates.emplace_back(point.distanceSquaredTo(origin), i);
+        });
+
+    size_t numberOfFound = std::min(k, candidates.size());
+    std::partial_sort(
+        candidates.begin(),
+        candidates.begin() + numberOfFound,
+        candidates.end());
+
+    indices->resize(numberOfFound);
+    for (size_t i = 0; i < numberOfFound; ++i) {
+        (*indices)[i] = candidates[i].second;
+    }
+}
+
+void PointNeighborSearcher3::batchNearest(
+    const ConstArrayAccessor1<Vector3D>& origins,
+    double maxRadius,
+    ArrayAccessor1<size_t> indices) const {
+    JET_THROW_INVALID_ARG_IF(indices.size() != origins.size());
+
+    Array1<size_t> order;
+    sortOrigins(origins, &order);
+
+    parallelFor(kZeroSize, origins.size(),
+        [&](size_t i) {
+            size_t query = order[i];
+            indices[query] = nearest(origins[query], maxRadius);
+        });
+}
+
+void PointNeighborSearcher3::batchKNearest(
+    const ConstArrayAccessor1<Vector3D>& origins,
+    double maxRadius,
+    size_t k,
+    ArrayAccessor1<size_t> indices) const {
+    JET_THROW_INVALID_ARG_IF(indices.size() != k * origins.size());
+
+    Array1<size_t> order;
+    sortOrigins(origins, &order);
+
+    parallelRangeFor(kZeroSize, origins.size(),
+        [&](size_t begin, size_t end) {
+            std::vector<size_t> found;
+            for (size_t i = begin; i < end; ++i) {
+                size_t query = order[i];
+                kNearest(origins[query], maxRadius, k, &found);
+                for (size_t n = 0; n < k; ++n) {
+                    indices[query * k + n]
+                        = (n < found.size()) ? found[n] : kMaxSize;
+                }
+            }
+        });
+}
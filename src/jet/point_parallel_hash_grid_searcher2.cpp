@@ -23,6 +23,7 @@ PointParallelHashGridSearcher2::PointParallelHashGridSearcher2(
     size_t resolutionY,
     double gridSpacing) :
     _gridSpacing(gridSpacing) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
     _resolution.x = std::max(static_cast<ssize_t>(resolutionX), kOneSSize);
     _resolution.y = std::max(static_cast<ssize_t>(resolutionY), kOneSSize);
 
@@ -32,6 +33,7 @@ PointParallelHashGridSearcher2::PointParallelHashGridSearcher2(
 
 void PointParallelHashGridSearcher2::build(
     const ConstArrayAccessor1<Vector2D>& points) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
     _points.clear();
     _keys.clear();
     _startIndexTable.clear();
@@ -40,7 +42,6 @@ void PointParallelHashGridSearcher2::build(
 
     // Allocate memory chuncks
     size_t numberOfPoints = points.size();
-    std::vector<size_t> tempKeys(numberOfPoints);
     _startIndexTable.resize(_resolution.x * _resolution.y);
     _endIndexTable.resize(_resolution.x * _resolution.y);
     parallelFill(_startIndexTable.begin(), _startIndexTable.end(), kMaxSize);
@@ -59,25 +60,22 @@ void PointParallelHashGridSearcher2::build(
         numberOfPoints,
         [&](size_t i) {
             _sortedIndices[i] = i;
-            _points[i] = points[i];
-            tempKeys[i] = getHashKeyFromPosition(points[i]);
+            _keys[i] = getHashKeyFromPosition(points[i]);
         });
 
-    // Sort indices based on hash key
-    parallelSort(
+    // Sort keys and indices together
+    parallelRadixSort(
+        _keys.begin(),
+        _keys.end(),
         _sortedIndices.begin(),
-        _sortedIndices.end(),
-        [&tempKeys](size_t indexA, size_t indexB) {
-            return tempKeys[indexA] < tempKeys[indexB];
-        });
+        _startIndexTable.size() - 1);
 
-    // Re-order point and key arrays
+    // Re-order point array
     parallelFor(
         kZeroSize,
         numberOfPoints,
         [&](size_t i) {
             _points[i] = points[_sortedIndices[i]];
-            _keys[i] = tempKeys[_sortedIndices[i]];
         });
 
     // Now _points and _keys are sorted by points' hash key values.
@@ -130,29 +128,7 @@ void PointParallelHashGridSearcher2::forEachNearbyPoint(
     const Vector2D& origin,
     double radius,
     const ForEachNearbyPointFunc& callback) const {
-    size_t nearbyKeys[4];
-    getNearbyKeys(origin, nearbyKeys);
-
-    const double queryRadiusSquared = radius * radius;
-
-    for (int i = 0; i < 4; i++) {
-        size_t nearbyKey = nearbyKeys[i];
-        size_t start = _startIndexTable[nearbyKey];
-        size_t end = _endIndexTable[nearbyKey];
-
-        // Empty bucket -- continue to next bucket
-        if (start == kMaxSize) {
-            continue;
-        }
-
-        for (size_t j = start; j < end; ++j) {
-            Vector2D direction = _points[j] - origin;
-            double distanceSquared = direction.lengthSquared();
-            if (distanceSquared <= queryRadiusSquared) {
-                callback(_sortedIndices[j], _points[j]);
-            }
-        }
-    }
+    forEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 }
 
 bool PointParallelHashGridSearcher2::hasNearbyPoint(
@@ -185,17 +161,17 @@ bool PointParallelHashGridSearcher2::hasNearbyPoint(
     return false;
 }
 
-const std::vector<size_t>&
+const TrackedVector<size_t>&
 PointParallelHashGridSearcher2::startIndexTable() const {
     return _startIndexTable;
 }
 
-const std::vector<size_t>&
+const TrackedVector<size_t>&
 PointParallelHashGridSearcher2::endIndexTable() const {
     return _endIndexTable;
 }
 
-const std::vector<size_t>&
+const TrackedVector<size_t>&
 PointParallelHashGridSearcher2::sortedIndices() const {
     return _sortedIndices;
 }
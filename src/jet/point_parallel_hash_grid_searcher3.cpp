@@ -5,12 +5,18 @@
 #include <jet/constants.h>
 #include <jet/parallel.h>
 #include <jet/point_parallel_hash_grid_searcher3.h>
+#include <neighbor_search_helpers.h>
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 using namespace jet;
 
+// Fraction of the points that can change bucket before update falls back to
+// the full radix sort.
+static const size_t kMaxMovedPointsFraction = 8;
+
 PointParallelHashGridSearcher3::PointParallelHashGridSearcher3(
     const Size3& resolution,
     double gridSpacing) :
@@ -24,6 +30,7 @@ PointParallelHashGridSearcher3::PointParallelHashGridSearcher3(
     size_t resolutionZ,
     double gridSpacing) :
     _gridSpacing(gridSpacing) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
     _resolution.x = std::max(static_cast<ssize_t>(resolutionX), kOneSSize);
     _resolution.y = std::max(static_cast<ssize_t>(resolutionY), kOneSSize);
     _resolution.z = std::max(static_cast<ssize_t>(resolutionZ), kOneSSize);
@@ -36,6 +43,7 @@ PointParallelHashGridSearcher3::PointParallelHashGridSearcher3(
 
 void PointParallelHashGridSearcher3::build(
     const ConstArrayAccessor1<Vector3D>& points) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
     _points.clear();
     _keys.clear();
     _startIndexTable.clear();
@@ -44,7 +52,6 @@ void PointParallelHashGridSearcher3::build(
 
     // Allocate memory chuncks
     size_t numberOfPoints = points.size();
-    std::vector<size_t> tempKeys(numberOfPoints);
     _startIndexTable.resize(_resolution.x * _resolution.y * _resolution.z);
     _endIndexTable.resize(_resolution.x * _resolution.y * _resolution.z);
     parallelFill(_startIndexTable.begin(), _startIndexTable.end(), kMaxSize);
@@ -63,77 +70,151 @@ void PointParallelHashGridSearcher3::build(
         numberOfPoints,
         [&](size_t i) {
             _sortedIndices[i] = i;
-            _points[i] = points[i];
-            tempKeys[i] = getHashKeyFromPosition(points[i]);
+            _keys[i] = getHashKeyFromPosition(points[i]);
         });
 
-    // Sort indices based on hash key
-    parallelSort(
+    // Sort keys and indices together
+    parallelRadixSort(
+        _keys.begin(),
+        _keys.end(),
         _sortedIndices.begin(),
-        _sortedIndices.end(),
-        [&tempKeys](size_t indexA, size_t indexB) {
-            return tempKeys[indexA] < tempKeys[indexB];
-        });
+        _startIndexTable.size() - 1);
 
-    // Re-order point and key arrays
+    // Re-order point array
     parallelFor(
         kZeroSize,
         numberOfPoints,
         [&](size_t i) {
             _points[i] = points[_sortedIndices[i]];
-            _keys[i] = tempKeys[_sortedIndices[i]];
         });
 
-    // Now _points and _keys are sorted by points' hash key values.
-    // Let's fill in start/end index table with _keys.
+    buildIndexTables();
+}
 
-    // Assume that _keys array looks like:
-    // [5|8|8|10|10|10]
-    // Then _startIndexTable and _endIndexTable should be like:
-    // [.....|0|...|1|..|3|..]
-    // [.....|1|...|3|..|6|..]
-    //       ^5    ^8   ^10
-    // So that _endIndexTable[i] - _startIndexTable[i] is the number points
-    // in i-th table bucket.
+void PointParallelHashGridSearcher3::update(
+    const ConstArrayAccessor1<Vector3D>& points) {
+    MemoryTagScope scope(MemoryTag::NeighborSearch);
+    size_t numberOfPoints = points.size();
+    if (numberOfPoints == 0 || numberOfPoints != _points.size()) {
+        build(points);
+        return;
+    }
 
-    _startIndexTable[_keys[0]] = 0;
-    _endIndexTable[_keys[numberOfPoints - 1]] = numberOfPoints;
+    // Only the buckets of the previous keys are occupied, so resetting them
+    // clears the tables
+    parallelFor(
+        kZeroSize,
+        numberOfPoints,
+        [&](size_t i) {
+            if (i == 0 || _keys[i] != _keys[i - 1]) {
+                _startIndexTable[_keys[i]] = kMaxSize;
+                _endIndexTable[_keys[i]] = kMaxSize;
+            }
+        });
 
+    // Generate hash keys in the previous sorted order
+    _newKeys.resize(numberOfPoints);
     parallelFor(
-        (size_t)1,
+        kZeroSize,
         numberOfPoints,
         [&](size_t i) {
-            if (_keys[i] > _keys[i - 1]) {
-                _startIndexTable[_keys[i]] = i;
-                _endIndexTable[_keys[i - 1]] = i;
+            _newKeys[i] = getHashKeyFromPosition(points[_sortedIndices[i]]);
+        });
+
+    size_t numberOfMovedPoints = parallelReduce(
+        kZeroSize,
+        numberOfPoints,
+        kZeroSize,
+        [&](size_t begin, size_t end, size_t partial) {
+            for (size_t i = begin; i < end; ++i) {
+                if (_newKeys[i] != _keys[i]) {
+                    ++partial;
+                }
             }
+            return partial;
+        },
+        [](size_t a, size_t b) {
+            return a + b;
         });
 
-    size_t sumNumberOfPointsPerBucket = 0;
-    size_t maxNumberOfPointsPerBucket = 0;
-    size_t numberOfNonEmptyBucket = 0;
-    for (size_t i = 0; i < _startIndexTable.size(); ++i) {
-        if (_startIndexTable[i] != kMaxSize) {
-            size_t numberOfPointsInBucket
-                = _endIndexTable[i] - _startIndexTable[i];
-            sumNumberOfPointsPerBucket += numberOfPointsInBucket;
-            maxNumberOfPointsPerBucket =
-                std::max(maxNumberOfPointsPerBucket, numberOfPointsInBucket);
-            ++numberOfNonEmptyBucket;
+    if (numberOfMovedPoints > numberOfPoints / kMaxMovedPointsFraction) {
+        _keys.swap(_newKeys);
+        parallelRadixSort(
+            _keys.begin(),
+            _keys.end(),
+            _sortedIndices.begin(),
+            _startIndexTable.size() - 1);
+    } else if (numberOfMovedPoints > 0) {
+        // The points that stayed in their buckets are still sorted. Move them
+        // to the front, sort the others, and merge both from the back.
+        _movedPoints.clear();
+        size_t numberOfStayedPoints = 0;
+        for (size_t i = 0; i < numberOfPoints; ++i) {
+            if (_newKeys[i] == _keys[i]) {
+                _keys[numberOfStayedPoints] = _keys[i];
+                _sortedIndices[numberOfStayedPoints] = _sortedIndices[i];
+                ++numberOfStayedPoints;
+            } else {
+                _movedPoints.emplace_back(_newKeys[i], _sortedIndices[i]);
+            }
         }
+
+        std::sort(_movedPoints.begin(), _movedPoints.end());
+
+        size_t stayed = numberOfStayedPoints;
+        size_t moved = _movedPoints.size();
+        size_t next = numberOfPoints;
+        while (moved > 0) {
+            --next;
+            if (stayed > 0
+                && _keys[stayed - 1] > _movedPoints[moved - 1].first) {
+                --stayed;
+                _keys[next] = _keys[stayed];
+                _sortedIndices[next] = _sortedIndices[stayed];
+            } else {
+                --moved;
+                _keys[next] = _movedPoints[moved].first;
+                _sortedIndices[next] = _movedPoints[moved].second;
+            }
+        }
+    }
+
+    // Re-order point array
+    parallelFor(
+        kZeroSize,
+        numberOfPoints,
+        [&](size_t i) {
+            _points[i] = points[_sortedIndices[i]];
+        });
+
+    buildIndexTables();
+}
+
+void PointParallelHashGridSearcher3::updatePointPositions(
+    const ConstArrayAccessor1<Vector3D>& points) {
+    if (points.size() != _points.size()) {
+        build(points);
+        return;
     }
 
-    JET_INFO << "Average number of points per non-empty bucket: "
-             << static_cast<float>(sumNumberOfPointsPerBucket)
-                / static_cast<float>(numberOfNonEmptyBucket);
-    JET_INFO << "Max number of points per bucket: "
-             << maxNumberOfPointsPerBucket;
+    parallelFor(
+        kZeroSize,
+        points.size(),
+        [&](size_t i) {
+            _points[i] = points[_sortedIndices[i]];
+        });
 }
 
 void PointParallelHashGridSearcher3::forEachNearbyPoint(
     const Vector3D& origin,
     double radius,
     const ForEachNearbyPointFunc& callback) const {
+    forEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
+}
+
+bool PointParallelHashGridSearcher3::hasNearbyPoint(
+    const Vector3D& origin,
+    double radius) const {
     size_t nearbyKeys[8];
     getNearbyKeys(origin, nearbyKeys);
 
@@ -159,63 +240,191 @@ void PointParallelHashGridSearcher3::forEachNearbyPoint(
                     direction /= distance;
                 }
 
-                callback(_sortedIndices[j], _points[j]);
+                return true;
             }
         }
     }
+
+    return false;
 }
 
-bool PointParallelHashGridSearcher3::hasNearbyPoint(
+size_t PointParallelHashGridSearcher3::nearest(
     const Vector3D& origin,
-    double radius) const {
-    size_t nearbyKeys[8];
-    getNearbyKeys(origin, nearbyKeys);
+    double maxRadius) const {
+    size_t keys[8];
+    double cellDistancesSquared[8];
+    size_t numberOfKeys = sortNearbyBuckets(origin, keys, cellDistancesSquared);
+
+    size_t nearestIndex = kMaxSize;
+    double nearestDistanceSquared = maxRadius * maxRadius;
+    for (size_t i = 0; i < numberOfKeys; ++i) {
+        if (cellDistancesSquared[i] > nearestDistanceSquared) {
+            break;
+        }
 
-    const double queryRadiusSquared = radius * radius;
+        size_t start = _startIndexTable[keys[i]];
+        if (start == kMaxSize) {
+            continue;
+        }
 
-    for (int i = 0; i < 8; i++) {
-        size_t nearbyKey = nearbyKeys[i];
-        size_t start = _startIndexTable[nearbyKey];
-        size_t end = _endIndexTable[nearbyKey];
+        size_t end = _endIndexTable[keys[i]];
+        for (size_t j = start; j < end; ++j) {
+            double distanceSquared = _points[j].distanceSquaredTo(origin);
+            if (distanceSquared < nearestDistanceSquared
+                || (distanceSquared == nearestDistanceSquared
+                    && nearestIndex == kMaxSize)) {
+                nearestDistanceSquared = distanceSquared;
+                nearestIndex = _sortedIndices[j];
+            }
+        }
+    }
 
-        // Empty bucket -- continue to next bucket
+    return nearestIndex;
+}
+
+void PointParallelHashGridSearcher3::kNearest(
+    const Vector3D& origin,
+    double maxRadius,
+    size_t k,
+    std::vector<size_t>* indices) const {
+    indices->clear();
+    if (k == 0) {
+        return;
+    }
+
+    size_t keys[8];
+    double cellDistancesSquared[8];
+    size_t numberOfKeys = sortNearbyBuckets(origin, keys, cellDistancesSquared);
+
+    // Max-heap of the k nearest points found so far
+    std::vector<std::pair<double, size_t>> heap;
+    const double maxRadiusSquared = maxRadius * maxRadius;
+    for (size_t i = 0; i < numberOfKeys; ++i) {
+        double limit = (heap.size() == k) ? heap.front().first
+                                          : maxRadiusSquared;
+        if (cellDistancesSquared[i] > limit) {
+            break;
+        }
+
+        size_t start = _startIndexTable[keys[i]];
         if (start == kMaxSize) {
             continue;
         }
 
+        size_t end = _endIndexTable[keys[i]];
         for (size_t j = start; j < end; ++j) {
-            Vector3D direction = _points[j] - origin;
-            double distanceSquared = direction.lengthSquared();
-            if (distanceSquared <= queryRadiusSquared) {
-                double distance = 0.0;
-                if (distanceSquared > 0) {
-                    distance = std::sqrt(distanceSquared);
-                    direction /= distance;
-                }
+            double distanceSquared = _points[j].distanceSquaredTo(origin);
+            if (distanceSquared > maxRadiusSquared) {
+                continue;
+            }
 
-                return true;
+            if (heap.size() < k) {
+                heap.emplace_back(distanceSquared, _sortedIndices[j]);
+                std::push_heap(heap.begin(), heap.end());
+            } else if (distanceSquared < heap.front().first) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back()
+                    = std::make_pair(distanceSquared, _sortedIndices[j]);
+                std::push_heap(heap.begin(), heap.end());
             }
         }
     }
 
-    return false;
+    std::sort_heap(heap.begin(), heap.end());
+    indices->resize(heap.size());
+    for (size_t i = 0; i < heap.size(); ++i) {
+        (*indices)[i] = heap[i].second;
+    }
 }
 
-const std::vector<size_t>&
+const TrackedVector<size_t>&
 PointParallelHashGridSearcher3::startIndexTable() const {
     return _startIndexTable;
 }
 
-const std::vector<size_t>&
+const TrackedVector<size_t>&
 PointParallelHashGridSearcher3::endIndexTable() const {
     return _endIndexTable;
 }
 
-const std::vector<size_t>&
+const TrackedVector<size_t>&
 PointParallelHashGridSearcher3::sortedIndices() const {
     return _sortedIndices;
 }
 
+PointHashGridStatistics PointParallelHashGridSearcher3::statistics() const {
+    PointHashGridStatistics stats;
+    stats.numberOfPoints = _points.size();
+    stats.numberOfBuckets = _startIndexTable.size();
+    if (stats.numberOfBuckets > 0) {
+        stats.loadFactor = static_cast<double>(stats.numberOfPoints)
+            / static_cast<double>(stats.numberOfBuckets);
+    }
+
+    // Points of the same bucket are contiguous in the sorted order
+    std::vector<Point3I> cells;
+    size_t begin = 0;
+    while (begin < _keys.size()) {
+        size_t end = begin + 1;
+        while (end < _keys.size() && _keys[end] == _keys[begin]) {
+            ++end;
+        }
+
+        cells.clear();
+        for (size_t i = begin; i < end; ++i) {
+            cells.push_back(getBucketIndex(_points[i]));
+        }
+
+        ++stats.numberOfNonEmptyBuckets;
+        stats.maxNumberOfPointsPerBucket
+            = std::max(stats.maxNumberOfPointsPerBucket, end - begin);
+        stats.numberOfCollisions += countDistinctCells(&cells) - 1;
+        begin = end;
+    }
+
+    return stats;
+}
+
+double PointParallelHashGridSearcher3::gridSpacing() const {
+    return _gridSpacing;
+}
+
+Size3 PointParallelHashGridSearcher3::resolution() const {
+    return Size3(
+        static_cast<size_t>(_resolution.x),
+        static_cast<size_t>(_resolution.y),
+        static_cast<size_t>(_resolution.z));
+}
+
+void PointParallelHashGridSearcher3::buildIndexTables() {
+    size_t numberOfPoints = _keys.size();
+
+    // Now _points and _keys are sorted by points' hash key values.
+    // Let's fill in start/end index table with _keys.
+
+    // Assume that _keys array looks like:
+    // [5|8|8|10|10|10]
+    // Then _startIndexTable and _endIndexTable should be like:
+    // [.....|0|...|1|..|3|..]
+    // [.....|1|...|3|..|6|..]
+    //       ^5    ^8   ^10
+    // So that _endIndexTable[i] - _startIndexTable[i] is the number points
+    // in i-th table bucket.
+
+    _startIndexTable[_keys[0]] = 0;
+    _endIndexTable[_keys[numberOfPoints - 1]] = numberOfPoints;
+
+    parallelFor(
+        (size_t)1,
+        numberOfPoints,
+        [&](size_t i) {
+            if (_keys[i] > _keys[i - 1]) {
+                _startIndexTable[_keys[i]] = i;
+                _endIndexTable[_keys[i - 1]] = i;
+            }
+        });
+}
+
 Point3I PointParallelHashGridSearcher3::getBucketIndex(
     const Vector3D& position) const {
     Point3I bucketIndex;
@@ -258,7 +467,18 @@ size_t PointParallelHashGridSearcher3::getHashKeyFromBucketIndex(
 void PointParallelHashGridSearcher3::getNearbyKeys(
     const Vector3D& position,
     size_t* nearbyKeys) const {
-    Point3I originIndex = getBucketIndex(position), nearbyBucketIndices[8];
+    Point3I nearbyBucketIndices[8];
+    getNearbyBucketIndices(position, nearbyBucketIndices);
+
+    for (int i = 0; i < 8; i++) {
+        nearbyKeys[i] = getHashKeyFromBucketIndex(nearbyBucketIndices[i]);
+    }
+}
+
+void PointParallelHashGridSearcher3::getNearbyBucketIndices(
+    const Vector3D& position,
+    Point3I* nearbyBucketIndices) const {
+    Point3I originIndex = getBucketIndex(position);
 
     for (int i = 0; i < 8; i++) {
         nearbyBucketIndices[i] = originIndex;
@@ -299,8 +519,43 @@ void PointParallelHashGridSearcher3::getNearbyKeys(
         nearbyBucketIndices[5].z -= 1;
         nearbyBucketIndices[7].z -= 1;
     }
+}
 
-    for (int i = 0; i < 8; i++) {
-        nearbyKeys[i] = getHashKeyFromBucketIndex(nearbyBucketIndices[i]);
+size_t PointParallelHashGridSearcher3::sortNearbyBuckets(
+    const Vector3D& origin,
+    size_t* keys,
+    double* distancesSquared) const {
+    Point3I nearbyBucketIndices[8];
+    getNearbyBucketIndices(origin, nearbyBucketIndices);
+
+    // Insertion sort of the distinct keys by the distance to their cells,
+    // since small resolutions can wrap two nearby cells into one bucket
+    size_t numberOfKeys = 0;
+    for (int i = 0; i < 8; ++i) {
+        size_t key = getHashKeyFromBucketIndex(nearbyBucketIndices[i]);
+        if (std::find(keys, keys + numberOfKeys, key) != keys + numberOfKeys) {
+            continue;
+        }
+
+        // Squared distance from origin to the box of the cell
+        double distanceSquared = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            double lower = _gridSpacing * nearbyBucketIndices[i][axis];
+            double upper = lower + _gridSpacing;
+            double offset = std::max(
+                std::max(lower - origin[axis], origin[axis] - upper), 0.0);
+            distanceSquared += offset * offset;
+        }
+
+        size_t n = numberOfKeys++;
+        while (n > 0 && distancesSquared[n - 1] > distanceSquared) {
+            keys[n] = keys[n - 1];
+            distancesSquared[n] = distancesSquared[n - 1];
+            --n;
+        }
+        keys[n] = key;
+        distancesSquared[n] = distanceSquared;
     }
+
+    return numberOfKeys;
 }
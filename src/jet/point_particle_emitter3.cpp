@@ -1,9 +1,13 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/parallel.h>
 #include <jet/point_particle_emitter3.h>
 #include <jet/samplers.h>
 
+#include <algorithm>
+#include <array>
+
 namespace jet {
 
 PointParticleEmitter3::PointParticleEmitter3(
@@ -23,6 +27,20 @@ PointParticleEmitter3::PointParticleEmitter3(
     _spreadAngleInRadians(degreesToRadians(spreadAngleInDegrees)) {
 }
 
+void PointParticleEmitter3::setPreviewScale(double factor) {
+    if (previewScale() == 1.0) {
+        _fullMaxNumberOfNewParticlesPerSecond
+            = _maxNumberOfNewParticlesPerSecond;
+        _fullMaxNumberOfParticles = _maxNumberOfParticles;
+    }
+    ParticleEmitter3::setPreviewScale(factor);
+
+    _maxNumberOfNewParticlesPerSecond = scaledNumberOfParticles(
+        _fullMaxNumberOfNewParticlesPerSecond, factor);
+    _maxNumberOfParticles
+        = scaledNumberOfParticles(_fullMaxNumberOfParticles, factor);
+}
+
 size_t PointParticleEmitter3::maxNumberOfNewParticlesPerSecond() const {
     return _maxNumberOfNewParticlesPerSecond;
 }
@@ -43,6 +61,39 @@ void PointParticleEmitter3::setMaxNumberOfParticles(
 void PointParticleEmitter3::emit(
     const Frame& frame,
     const ParticleSystemData3Ptr& particles) {
+    size_t numberOfNewParticles = beginEmission(frame);
+    if (numberOfNewParticles > 0) {
+        size_t oldNumberOfParticles = particles->numberOfParticles();
+        particles->resize(oldNumberOfParticles + numberOfNewParticles);
+
+        Vector3D* positions = particles->positions().data();
+        Vector3D* velocities = particles->velocities().data();
+        sample(
+            numberOfNewParticles,
+            ArrayAccessor1<Vector3D>(
+                numberOfNewParticles, positions + oldNumberOfParticles),
+            ArrayAccessor1<Vector3D>(
+                numberOfNewParticles, velocities + oldNumberOfParticles));
+    }
+}
+
+void PointParticleEmitter3::generate(
+    const Frame& frame,
+    const ParticleSystemData3Ptr& particles,
+    Array1<Vector3D>* newPositions,
+    Array1<Vector3D>* newVelocities) {
+    UNUSED_VARIABLE(particles);
+
+    size_t numberOfNewParticles = beginEmission(frame);
+    newPositions->resize(numberOfNewParticles);
+    newVelocities->resize(numberOfNewParticles);
+    sample(
+        numberOfNewParticles,
+        newPositions->accessor(),
+        newVelocities->accessor());
+}
+
+size_t PointParticleEmitter3::beginEmission(const Frame& frame) {
     if (_numberOfEmittedParticles == 0) {
         _firstFrameTimeInSeconds = frame.timeInSeconds();
     }
@@ -56,48 +107,30 @@ void PointParticleEmitter3::emit(
     newMaxTotalNumberOfEmittedParticles = std::min(
         newMaxTotalNumberOfEmittedParticles,
         _maxNumberOfParticles);
-    size_t maxNumberOfNewParticles = newMaxTotalNumberOfEmittedParticles
-        - _numberOfEmittedParticles;
-
-    if (maxNumberOfNewParticles > 0) {
-        Array1<Vector3D> candidatePositions;
-        Array1<Vector3D> candidateVelocities;
-        Array1<Vector3D> newPositions;
-        Array1<Vector3D> newVelocities;
-
-        emit(
-            &candidatePositions,
-            &candidateVelocities,
-            maxNumberOfNewParticles);
-
-        newPositions.append(candidatePositions);
-        newVelocities.append(candidateVelocities);
-
-        particles->addParticles(newPositions, newVelocities);
 
-        _numberOfEmittedParticles += newPositions.size();
-    }
+    return newMaxTotalNumberOfEmittedParticles - _numberOfEmittedParticles;
 }
 
-void PointParticleEmitter3::emit(
-    Array1<Vector3D>* newPositions,
-    Array1<Vector3D>* newVelocities,
-    size_t maxNewNumberOfParticles) {
-    for (size_t i = 0; i < maxNewNumberOfParticles; ++i) {
+void PointParticleEmitter3::sample(
+    size_t numberOfNewParticles,
+    ArrayAccessor1<Vector3D> newPositions,
+    ArrayAccessor1<Vector3D> newVelocities) {
+    // The random numbers of a particle are keyed by its index in the emission
+    // order, so they do not depend on the frames or the threads.
+    const size_t firstIndex = _numberOfEmittedParticles;
+    parallelFor(kZeroSize, numberOfNewParticles, [&](size_t i) {
+        std::array<double, 2> u = _rng.uniform2(firstIndex + i);
         Vector3D newDirection = uniformSampleCone(
-            random(),
-            random(),
+            u[0],
+            u[1],
             _direction,
             _spreadAngleInRadians);
 
-        newPositions->append(_origin);
-        newVelocities->append(_speed * newDirection);
-    }
-}
+        newPositions[i] = _origin;
+        newVelocities[i] = _speed * newDirection;
+    });
 
-double PointParticleEmitter3::random() {
-    std::uniform_real_distribution<> d(0.0, 1.0);
-    return d(_rng);
+    _numberOfEmittedParticles += numberOfNewParticles;
 }
 
 }  // namespace jet
@@ -0,0 +1,285 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/array3.h>
+#include <jet/parallel.h>
+#include <jet/poisson_disk_point_generator3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace jet {
+
+namespace {
+
+// Number of the cells of a tile along each axis. The cells are spacing /
+// sqrt(3) wide, so a tile is wider than the spacing and the tiles of a phase
+// never see the points of each other.
+const size_t kTileSize = 3;
+
+// Number of the cells within the spacing from a cell along each axis.
+const ssize_t kNeighborRange = 2;
+
+// Mixes the seed with the indices of a random stream (splitmix64).
+uint32_t mixSeed(uint32_t seed, uint64_t a, uint64_t b) {
+    uint64_t x = seed + 0x9e3779b97f4a7c15ULL * (a + 1) + (b << 32);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x = x ^ (x >> 31);
+    return static_cast<uint32_t>(x);
+}
+
+// Background grid of the accepted points, one point per cell at most.
+class PoissonDiskGrid3 {
+ public:
+    PoissonDiskGrid3(const BoundingBox3D& box, double spacing)
+        : _box(box), _spacingSquared(spacing * spacing) {
+        _cellSize = spacing / std::sqrt(3.0);
+        Size3 resolution;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            double extent = box.upperCorner[axis] - box.lowerCorner[axis];
+            resolution[axis] = std::max(
+                static_cast<size_t>(std::ceil(extent / _cellSize)),
+                kOneSize);
+            _numberOfTiles[axis]
+                = (resolution[axis] + kTileSize - 1) / kTileSize;
+        }
+        _cells.resize(resolution, Vector3D(kMaxD, kMaxD, kMaxD));
+    }
+
+    // Returns the part of the tile within the bounding box.
+    BoundingBox3D tileBox(size_t i, size_t j, size_t k) const {
+        Vector3D lower = _box.lowerCorner
+            + (_cellSize * kTileSize) * Vector3D(i, j, k);
+        Vector3D upper = lower + Vector3D(1, 1, 1) * (_cellSize * kTileSize);
+        return BoundingBox3D(lower, Vector3D(
+            std::min(upper.x, _box.upperCorner.x),
+            std::min(upper.y, _box.upperCorner.y),
+            std::min(upper.z, _box.upperCorner.z)));
+    }
+
+    // Returns the linear index of the tile of the point.
+    size_t tileIndex(const Vector3D& point) const {
+        Point3UI cell = cellIndex(point);
+        return (cell.x / kTileSize)
+            + _numberOfTiles.x * ((cell.y / kTileSize)
+            + _numberOfTiles.y * (cell.z / kTileSize));
+    }
+
+    size_t numberOfTiles() const {
+        return _numberOfTiles.x * _numberOfTiles.y * _numberOfTiles.z;
+    }
+
+    // Invokes func(i, j, k, tile) for each tile, where the tiles of each
+    // parity phase run in parallel.
+    template <typename Callback>
+    void forEachTileInPhases(const Callback& func) const {
+        for (size_t phase = 0; phase < 8; ++phase) {
+            size_t pi = phase & 1;
+            size_t pj = (phase >> 1) & 1;
+            size_t pk = (phase >> 2) & 1;
+            Size3 n(
+                (_numberOfTiles.x + 1 - pi) / 2,
+                (_numberOfTiles.y + 1 - pj) / 2,
+                (_numberOfTiles.z + 1 - pk) / 2);
+            parallelFor(kZeroSize, n.x * n.y * n.z, [&](size_t t) {
+                size_t i = 2 * (t % n.x) + pi;
+                size_t j = 2 * ((t / n.x) % n.y) + pj;
+                size_t k = 2 * (t / (n.x * n.y)) + pk;
+                func(i, j, k, i + _numberOfTiles.x
+                    * (j + _numberOfTiles.y * k));
+            });
+        }
+    }
+
+    // Adds the point if it is at least the spacing away from the others.
+    // Only the cells of the tile of the point are written.
+    bool tryAdd(const Vector3D& point) {
+        Point3UI cell = cellIndex(point);
+        if (_cells(cell).x != kMaxD) {
+            return false;
+        }
+
+        const Size3 res = _cells.size();
+        const ssize_t ci = static_cast<ssize_t>(cell.x);
+        const ssize_t cj = static_cast<ssize_t>(cell.y);
+        const ssize_t ck = static_cast<ssize_t>(cell.z);
+        for (ssize_t k = std::max(ck - kNeighborRange, ssize_t(0));
+             k <= std::min(ck + kNeighborRange, ssize_t(res.z) - 1); ++k) {
+            for (ssize_t j = std::max(cj - kNeighborRange, ssize_t(0));
+                 j <= std::min(cj + kNeighborRange, ssize_t(res.y) - 1);
+                 ++j) {
+                for (ssize_t i = std::max(ci - kNeighborRange, ssize_t(0));
+                     i <= std::min(ci + kNeighborRange, ssize_t(res.x) - 1);
+                     ++i) {
+                    const Vector3D& other = _cells(i, j, k);
+                    if (other.x != kMaxD
+                        && point.distanceSquaredTo(other) < _spacingSquared) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        _cells(cell) = point;
+        return true;
+    }
+
+    // Invokes the callback for each point in the cell order until it returns
+    // false.
+    void forEachPoint(
+        const std::function<bool(const Vector3D&)>& callback) const {
+        for (size_t n = 0; n < _cells.size().x * _cells.size().y
+             * _cells.size().z; ++n) {
+            const Vector3D& point = _cells[n];
+            if (point.x != kMaxD && !callback(point)) {
+                return;
+            }
+        }
+    }
+
+ private:
+    BoundingBox3D _box;
+    double _spacingSquared;
+    double _cellSize;
+    Size3 _numberOfTiles;
+    Array3<Vector3D> _cells;
+
+    Point3UI cellIndex(const Vector3D& point) const {
+        const Size3 res = _cells.size();
+        Point3UI cell;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            double x = (point[axis] - _box.lowerCorner[axis]) / _cellSize;
+            cell[axis] = std::min(
+                static_cast<size_t>(std::max(x, 0.0)), res[axis] - 1);
+        }
+        return cell;
+    }
+};
+
+}  // namespace
+
+void PoissonDiskPointGenerator3::forEachPoint(
+    const BoundingBox3D& boundingBox,
+    double spacing,
+    const std::function<bool(const Vector3D&)>& callback) const {
+    PoissonDiskGrid3 grid(boundingBox, spacing);
+
+    grid.forEachTileInPhases([&](size_t i, size_t j, size_t k, size_t tile) {
+        std::mt19937 rng(mixSeed(_seed, tile, 0));
+        std::uniform_real_distribution<> d(0.0, 1.0);
+        BoundingBox3D box = grid.tileBox(i, j, k);
+        Vector3D extent = box.upperCorner - box.lowerCorner;
+        for (unsigned int n = 0; n < _numberOfAttempts; ++n) {
+            double u1 = d(rng);
+            double u2 = d(rng);
+            double u3 = d(rng);
+            Vector3D point = box.lowerCorner + extent * Vector3D(u1, u2, u3);
+
+            // Round-off can put a dart on the cells of the next tile
+            if (grid.tileIndex(point) == tile) {
+                grid.tryAdd(point);
+            }
+        }
+    });
+
+    grid.forEachPoint(callback);
+}
+
+void PoissonDiskPointGenerator3::generateOnSurface(
+    const TriangleMesh3& mesh,
+    double spacing,
+    Array1<Vector3D>* points) const {
+    const size_t numberOfTriangles = mesh.numberOfTriangles();
+    if (numberOfTriangles == 0) {
+        return;
+    }
+
+    PoissonDiskGrid3 grid(mesh.boundingBox(), spacing);
+
+    // Number of the candidates of each triangle, with the fraction rounded
+    // randomly so that the pool is uniform over the area
+    const double candidatesPerArea = _numberOfAttempts / (spacing * spacing);
+    std::vector<size_t> offsets(numberOfTriangles + 1, 0);
+    parallelFor(kZeroSize, numberOfTriangles, [&](size_t t) {
+        std::mt19937 rng(mixSeed(_seed, t, 1));
+        std::uniform_real_distribution<> d(0.0, 1.0);
+        double expected = candidatesPerArea * mesh.triangle(t).area();
+        offsets[t + 1] = static_cast<size_t>(expected + d(rng));
+    });
+    for (size_t t = 0; t < numberOfTriangles; ++t) {
+        offsets[t + 1] += offsets[t];
+    }
+
+    std::vector<Vector3D> candidates(offsets[numberOfTriangles]);
+    parallelFor(kZeroSize, numberOfTriangles, [&](size_t t) {
+        std::mt19937 rng(mixSeed(_seed, t, 2));
+        std::uniform_real_distribution<> d(0.0, 1.0);
+        Triangle3 triangle = mesh.triangle(t);
+        for (size_t n = offsets[t]; n < offsets[t + 1]; ++n) {
+            double r = std::sqrt(d(rng));
+            double u = d(rng);
+            candidates[n] = (1.0 - r) * triangle.points[0]
+                + (r * (1.0 - u)) * triangle.points[1]
+                + (r * u) * triangle.points[2];
+        }
+    });
+
+    // Buckets the candidates by the tiles
+    const size_t numberOfTiles = grid.numberOfTiles();
+    std::vector<size_t> tiles(candidates.size());
+    std::vector<size_t> tileOffsets(numberOfTiles + 1, 0);
+    parallelFor(kZeroSize, candidates.size(), [&](size_t n) {
+        tiles[n] = grid.tileIndex(candidates[n]);
+    });
+    for (size_t tile : tiles) {
+        ++tileOffsets[tile + 1];
+    }
+    for (size_t tile = 0; tile < numberOfTiles; ++tile) {
+        tileOffsets[tile + 1] += tileOffsets[tile];
+    }
+    std::vector<Vector3D> sorted(candidates.size());
+    {
+        std::vector<size_t> next(tileOffsets.begin(), tileOffsets.end() - 1);
+        for (size_t n = 0; n < candidates.size(); ++n) {
+            sorted[next[tiles[n]]++] = candidates[n];
+        }
+    }
+
+    grid.forEachTileInPhases([&](size_t, size_t, size_t, size_t tile) {
+        auto begin = sorted.begin() + tileOffsets[tile];
+        auto end = sorted.begin() + tileOffsets[tile + 1];
+        std::mt19937 rng(mixSeed(_seed, tile, 3));
+        std::shuffle(begin, end, rng);
+        for (auto iter = begin; iter != end; ++iter) {
+            grid.tryAdd(*iter);
+        }
+    });
+
+    grid.forEachPoint([&](const Vector3D& point) {
+        points->append(point);
+        return true;
+    });
+}
+
+uint32_t PoissonDiskPointGenerator3::seed() const {
+    return _seed;
+}
+
+void PoissonDiskPointGenerator3::setSeed(uint32_t seed) {
+    _seed = seed;
+}
+
+unsigned int PoissonDiskPointGenerator3::numberOfAttempts() const {
+    return _numberOfAttempts;
+}
+
+void PoissonDiskPointGenerator3::setNumberOfAttempts(
+    unsigned int numberOfAttempts) {
+    JET_THROW_INVALID_ARG_IF(numberOfAttempts == 0);
+    _numberOfAttempts = numberOfAttempts;
+}
+
+}  // namespace jet
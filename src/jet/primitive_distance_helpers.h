@@ -0,0 +1,71 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_PRIMITIVE_DISTANCE_HELPERS_H_
+#define SRC_JET_PRIMITIVE_DISTANCE_HELPERS_H_
+
+#include <jet/array_accessor1.h>
+#include <jet/parallel.h>
+#include <jet/vector3.h>
+#include <simd_helpers.h>
+
+#include <algorithm>
+
+namespace jet {
+
+// Number of the points that the kernels of the analytic surfaces evaluate at
+// once, which are transposed into structure-of-arrays on the stack first
+const size_t kPrimitiveDistanceChunkSize = 256;
+
+// Number of the points per parallel task, a multiple of the chunk size
+const size_t kPrimitiveDistanceGrainSize = 4096;
+
+// Points of a chunk in structure-of-arrays layout.
+struct PrimitiveDistanceChunk {
+    double x[kPrimitiveDistanceChunkSize];
+    double y[kPrimitiveDistanceChunkSize];
+    double z[kPrimitiveDistanceChunkSize];
+};
+
+// Computes the signed distances from the points into result in parallel.
+// The points are transposed a chunk at a time, and kernel(n, chunk, out)
+// writes the distances of the first n points of the chunk to out, so the
+// kernel runs without a virtual call for every point.
+template <typename Kernel>
+void primitiveSignedDistances(
+    const ConstArrayAccessor1<Vector3D>& points,
+    ArrayAccessor1<double> result,
+    const Kernel& kernel) {
+    parallelRangeFor(
+        kZeroSize, points.size(), kPrimitiveDistanceGrainSize,
+        [&](size_t begin, size_t end) {
+            PrimitiveDistanceChunk chunk;
+            for (size_t first = begin; first < end;
+                 first += kPrimitiveDistanceChunkSize) {
+                const size_t n
+                    = std::min(kPrimitiveDistanceChunkSize, end - first);
+                for (size_t i = 0; i < n; ++i) {
+                    const Vector3D& p = points[first + i];
+                    chunk.x[i] = p.x;
+                    chunk.y[i] = p.y;
+                    chunk.z[i] = p.z;
+                }
+                kernel(n, chunk, result.data() + first);
+            }
+        });
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 inline __m128d absSse2(__m128d v) {
+    return _mm_andnot_pd(_mm_set1_pd(-0.0), v);
+}
+
+JET_TARGET_AVX inline __m256d absAvx(__m256d v) {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v);
+}
+
+#endif
+
+}  // namespace jet
+
+#endif  // SRC_JET_PRIMITIVE_DISTANCE_HELPERS_H_
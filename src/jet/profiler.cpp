@@ -0,0 +1,206 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/constants.h>
+#include <jet/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+using namespace jet;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct OpenScope {
+    const char* name;
+    std::string path;
+    Clock::time_point start;
+};
+
+std::atomic<bool> sIsEnabled(false);
+std::atomic<size_t> sNumberOfThreads(0);
+
+std::mutex sMutex;
+std::vector<ProfileEvent> sEvents;
+size_t sFrameStartIndex = 0;
+std::vector<ProfileReportEntry> sLastFrameReport;
+
+thread_local std::vector<OpenScope> sOpenScopes;
+thread_local size_t sThreadIndex = kMaxSize;
+
+const Clock::time_point& origin() {
+    static const Clock::time_point sOrigin = Clock::now();
+    return sOrigin;
+}
+
+double secondsBetween(
+    const Clock::time_point& begin,
+    const Clock::time_point& end) {
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// Sums up the events by path, in the order the paths first started
+std::vector<ProfileReportEntry> buildReport(
+    std::vector<ProfileEvent>::const_iterator begin,
+    std::vector<ProfileEvent>::const_iterator end) {
+    std::vector<const ProfileEvent*> sorted;
+    for (auto iter = begin; iter != end; ++iter) {
+        sorted.push_back(&(*iter));
+    }
+    std::stable_sort(
+        sorted.begin(),
+        sorted.end(),
+        [](const ProfileEvent* a, const ProfileEvent* b) {
+            return a->startTimeInSeconds < b->startTimeInSeconds;
+        });
+
+    std::vector<ProfileReportEntry> report;
+    std::unordered_map<std::string, size_t> entryIndices;
+    for (const ProfileEvent* event : sorted) {
+        auto iter = entryIndices.find(event->path);
+        if (iter == entryIndices.end()) {
+            iter = entryIndices.emplace(event->path, report.size()).first;
+            report.push_back(ProfileReportEntry());
+            report.back().path = event->path;
+            report.back().depth = event->depth;
+        }
+
+        ProfileReportEntry& entry = report[iter->second];
+        ++entry.count;
+        entry.totalDurationInSeconds += event->durationInSeconds;
+    }
+
+    return report;
+}
+
+void writeEscaped(const std::string& str, std::ostream* strm) {
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            (*strm) << '\\';
+        }
+        (*strm) << c;
+    }
+}
+
+}  // namespace
+
+bool Profiler::isEnabled() {
+    return sIsEnabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setIsEnabled(bool isEnabled) {
+    // Make sure the origin is set before any scope starts
+    origin();
+    sIsEnabled = isEnabled;
+}
+
+void Profiler::beginScope(const char* name) {
+    OpenScope scope;
+    scope.name = name;
+    scope.path = sOpenScopes.empty()
+        ? std::string(name)
+        : sOpenScopes.back().path + "/" + name;
+    scope.start = Clock::now();
+    sOpenScopes.push_back(std::move(scope));
+}
+
+void Profiler::endScope() {
+    Clock::time_point now = Clock::now();
+
+    if (sOpenScopes.empty()) {
+        return;
+    }
+
+    if (sThreadIndex == kMaxSize) {
+        sThreadIndex = sNumberOfThreads++;
+    }
+
+    const OpenScope& scope = sOpenScopes.back();
+
+    ProfileEvent event;
+    event.name = scope.name;
+    event.path = scope.path;
+    event.depth = sOpenScopes.size() - 1;
+    event.threadIndex = sThreadIndex;
+    event.startTimeInSeconds = secondsBetween(origin(), scope.start);
+    event.durationInSeconds = secondsBetween(scope.start, now);
+
+    sOpenScopes.pop_back();
+
+    std::lock_guard<std::mutex> lock(sMutex);
+    sEvents.push_back(std::move(event));
+}
+
+void Profiler::endFrame() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sLastFrameReport = buildReport(
+        sEvents.begin() + sFrameStartIndex, sEvents.end());
+    sFrameStartIndex = sEvents.size();
+}
+
+std::vector<ProfileReportEntry> Profiler::lastFrameReport() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    return sLastFrameReport;
+}
+
+std::vector<ProfileReportEntry> Profiler::report() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    return buildReport(sEvents.begin(), sEvents.end());
+}
+
+std::vector<ProfileEvent> Profiler::events() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    return sEvents;
+}
+
+void Profiler::clear() {
+    std::lock_guard<std::mutex> lock(sMutex);
+    sEvents.clear();
+    sFrameStartIndex = 0;
+    sLastFrameReport.clear();
+}
+
+void Profiler::writeChromeTrace(std::ostream* strm) {
+    std::vector<ProfileEvent> recordedEvents = events();
+
+    (*strm) << "{\"traceEvents\":[";
+    for (size_t i = 0; i < recordedEvents.size(); ++i) {
+        const ProfileEvent& event = recordedEvents[i];
+        if (i > 0) {
+            (*strm) << ",";
+        }
+        (*strm) << "\n{\"name\":\"";
+        writeEscaped(event.name, strm);
+
+        // Timestamps are in microseconds
+        std::ostringstream times;
+        times << std::fixed << std::setprecision(3)
+              << ",\"ts\":" << event.startTimeInSeconds * 1e6
+              << ",\"dur\":" << event.durationInSeconds * 1e6;
+
+        (*strm) << "\",\"cat\":\"jet\",\"ph\":\"X\",\"pid\":0"
+                << ",\"tid\":" << event.threadIndex
+                << times.str() << "}";
+    }
+    (*strm) << "\n]}\n";
+}
+
+ProfileScope::ProfileScope(const char* name)
+: _isActive(Profiler::isEnabled()) {
+    if (_isActive) {
+        Profiler::beginScope(name);
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    if (_isActive) {
+        Profiler::endScope();
+    }
+}
@@ -11,6 +11,14 @@ ScalarField3::ScalarField3() {
 ScalarField3::~ScalarField3() {
 }
 
+void ScalarField3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<double> result) const {
+    for (size_t i = 0; i < x.size(); ++i) {
+        result[i] = sample(x[i]);
+    }
+}
+
 Vector3D ScalarField3::gradient(const Vector3D&) const {
     return Vector3D();
 }
@@ -0,0 +1,99 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/scratch_arena.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace jet {
+
+ScratchArena::ScratchArena() {
+}
+
+ScratchArena::ScratchArena(const ScratchArena& other) {
+    UNUSED_VARIABLE(other);
+}
+
+ScratchArena& ScratchArena::operator=(const ScratchArena& other) {
+    UNUSED_VARIABLE(other);
+    return *this;
+}
+
+void* ScratchArena::allocate(size_t bytes) {
+    size_t capacity = bucketSize(bytes);
+
+    // Take the smallest free buffer that fits
+    Buffer* best = nullptr;
+    for (const auto& buffer : _buffers) {
+        if (!buffer->isInUse
+            && buffer->capacity >= capacity
+            && (best == nullptr || buffer->capacity < best->capacity)) {
+            best = buffer.get();
+        }
+    }
+
+    if (best == nullptr) {
+        MemoryTagScope scope(MemoryTag::Scratch);
+
+        std::unique_ptr<Buffer> buffer(new Buffer);
+        buffer->storage.resize(capacity + kScratchAlignment - 1);
+        uintptr_t address
+            = reinterpret_cast<uintptr_t>(buffer->storage.data());
+        address = (address + kScratchAlignment - 1)
+            & ~static_cast<uintptr_t>(kScratchAlignment - 1);
+        buffer->data = reinterpret_cast<void*>(address);
+        buffer->capacity = capacity;
+
+        best = buffer.get();
+        _buffers.push_back(std::move(buffer));
+    }
+
+    best->isInUse = true;
+    ++_numberOfBuffersInUse;
+    return best->data;
+}
+
+void ScratchArena::reset() {
+    for (const auto& buffer : _buffers) {
+        buffer->isInUse = false;
+    }
+    _numberOfBuffersInUse = 0;
+}
+
+void ScratchArena::clear() {
+    _buffers.clear();
+    _numberOfBuffersInUse = 0;
+}
+
+size_t ScratchArena::numberOfBuffers() const {
+    return _buffers.size();
+}
+
+size_t ScratchArena::numberOfBuffersInUse() const {
+    return _numberOfBuffersInUse;
+}
+
+size_t ScratchArena::capacityInBytes() const {
+    size_t bytes = 0;
+    for (const auto& buffer : _buffers) {
+        bytes += buffer->storage.capacity();
+    }
+    return bytes;
+}
+
+size_t ScratchArena::bucketSize(size_t bytes) {
+    if (bytes <= kScratchAlignment) {
+        return kScratchAlignment;
+    }
+
+    // Four buckets per power of two, so that at most a quarter is wasted
+    size_t powerOfTwo = kScratchAlignment;
+    while (powerOfTwo <= bytes / 2) {
+        powerOfTwo *= 2;
+    }
+    size_t step = std::max(powerOfTwo / 4, kScratchAlignment);
+    return (bytes + step - 1) / step * step;
+}
+
+}  // namespace jet
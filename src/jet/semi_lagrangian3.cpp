@@ -4,13 +4,286 @@
 #include <jet/array_samplers3.h>
 #include <jet/parallel.h>
 #include <jet/semi_lagrangian3.h>
+#include <semi_lagrangian_helpers.h>
 #include <algorithm>
+#include <functional>
+#include <vector>
 
 using namespace jet;
 
+namespace {
+
+// Samples a single component of a vector sampler function.
+class VectorComponentSampler3 {
+ public:
+    VectorComponentSampler3(
+        const std::function<Vector3D(const Vector3D&)>& sampler,
+        size_t component)
+    : _sampler(sampler), _component(component) {
+    }
+
+    double operator()(const Vector3D& x) const {
+        return _sampler(x)[_component];
+    }
+
+ private:
+    std::function<Vector3D(const Vector3D&)> _sampler;
+    size_t _component;
+};
+
+// Advects a single data array with the given input sampler.
+template <typename T, typename InputSampler>
+class AdvectDataJob {
+ public:
+    AdvectDataJob(
+        const InputSampler& input,
+        const Vector3D& inputOrigin,
+        const Vector3D& inputSpacing,
+        const ArrayAccessor3<T>& output,
+        const Size3& outputSize,
+        const Vector3D& outputOrigin,
+        const Vector3D& outputSpacing,
+        double dt)
+    : _input(input),
+      _inputOrigin(inputOrigin),
+      _inputSpacing(inputSpacing),
+      _output(output),
+      _outputSize(outputSize),
+      _outputOrigin(outputOrigin),
+      _outputSpacing(outputSpacing),
+      _dt(dt),
+      _h(min3(outputSpacing.x, outputSpacing.y, outputSpacing.z)) {
+    }
+
+    template <typename FlowSampler, typename SdfSampler>
+    void operator()(
+        const FlowSampler& flow, const SdfSampler& boundarySdf) const {
+        ArrayAccessor3<T> output = _output;
+
+        parallelFor(
+            kZeroSize, _outputSize.x,
+            kZeroSize, _outputSize.y,
+            kZeroSize, _outputSize.z,
+            [&](size_t i, size_t j, size_t k) {
+                Vector3D idx({i, j, k});
+                if (boundarySdf(_inputOrigin + _inputSpacing * idx) > 0.0) {
+                    Vector3D pt = backTrace(
+                        flow,
+                        boundarySdf,
+                        _dt,
+                        _h,
+                        _outputOrigin + _outputSpacing * idx);
+                    output(i, j, k) = _input(pt);
+                }
+            });
+    }
+
+ private:
+    InputSampler _input;
+    Vector3D _inputOrigin;
+    Vector3D _inputSpacing;
+    ArrayAccessor3<T> _output;
+    Size3 _outputSize;
+    Vector3D _outputOrigin;
+    Vector3D _outputSpacing;
+    double _dt;
+    double _h;
+};
+
+template <typename T, typename InputSampler>
+void advectData(
+    const InputSampler& input,
+    const Vector3D& inputOrigin,
+    const Vector3D& inputSpacing,
+    const ArrayAccessor3<T>& output,
+    const Size3& outputSize,
+    const Vector3D& outputOrigin,
+    const Vector3D& outputSpacing,
+    const VectorField3& flow,
+    double dt,
+    const ScalarField3& boundarySdf) {
+    runWithFieldSamplers(
+        flow,
+        boundarySdf,
+        AdvectDataJob<T, InputSampler>(
+            input,
+            inputOrigin,
+            inputSpacing,
+            output,
+            outputSize,
+            outputOrigin,
+            outputSpacing,
+            dt));
+}
+
+// Samples every channel of a batch at the traced point.
+template <typename ScalarSampler, typename VectorSampler>
+void sampleChannels(
+    const std::vector<ScalarSampler>& scalarInputs,
+    const std::vector<VectorSampler>& vectorInputs,
+    const Vector3D& pt,
+    size_t i,
+    size_t j,
+    size_t k,
+    std::vector<ArrayAccessor3<double>>* scalarOutputs,
+    std::vector<ArrayAccessor3<Vector3D>>* vectorOutputs) {
+    for (size_t c = 0; c < scalarInputs.size(); ++c) {
+        (*scalarOutputs)[c](i, j, k) = scalarInputs[c](pt);
+    }
+    for (size_t c = 0; c < vectorInputs.size(); ++c) {
+        (*vectorOutputs)[c](i, j, k) = vectorInputs[c](pt);
+    }
+}
+
+// The cubic channels share the layout, so the taps and weights of the traced
+// point are computed once for all of them.
+void sampleChannels(
+    const std::vector<CubicArraySampler3<double, double>>& scalarInputs,
+    const std::vector<CubicArraySampler3<Vector3D, double>>& vectorInputs,
+    const Vector3D& pt,
+    size_t i,
+    size_t j,
+    size_t k,
+    std::vector<ArrayAccessor3<double>>* scalarOutputs,
+    std::vector<ArrayAccessor3<Vector3D>>* vectorOutputs) {
+    CubicSamplerStencil3<double> stencil;
+    if (!scalarInputs.empty()) {
+        scalarInputs[0].getStencil(pt, &stencil);
+    } else if (!vectorInputs.empty()) {
+        vectorInputs[0].getStencil(pt, &stencil);
+    } else {
+        return;
+    }
+
+    for (size_t c = 0; c < scalarInputs.size(); ++c) {
+        (*scalarOutputs)[c](i, j, k) = scalarInputs[c].sample(stencil);
+    }
+    for (size_t c = 0; c < vectorInputs.size(); ++c) {
+        (*vectorOutputs)[c](i, j, k) = vectorInputs[c].sample(stencil);
+    }
+}
+
+// The linear channels share the layout as well, so the cell of the traced
+// point is located once for all of them.
+void sampleChannels(
+    const std::vector<LinearArraySampler3<double, double>>& scalarInputs,
+    const std::vector<LinearArraySampler3<Vector3D, double>>& vectorInputs,
+    const Vector3D& pt,
+    size_t i,
+    size_t j,
+    size_t k,
+    std::vector<ArrayAccessor3<double>>* scalarOutputs,
+    std::vector<ArrayAccessor3<Vector3D>>* vectorOutputs) {
+    LinearSamplerStencil3<double> stencil;
+    if (!scalarInputs.empty()) {
+        scalarInputs[0].getStencil(pt, &stencil);
+    } else if (!vectorInputs.empty()) {
+        vectorInputs[0].getStencil(pt, &stencil);
+    } else {
+        return;
+    }
+
+    for (size_t c = 0; c < scalarInputs.size(); ++c) {
+        (*scalarOutputs)[c](i, j, k) = scalarInputs[c].sample(stencil);
+    }
+    for (size_t c = 0; c < vectorInputs.size(); ++c) {
+        (*vectorOutputs)[c](i, j, k) = vectorInputs[c].sample(stencil);
+    }
+}
+
+// Advects data arrays that share the same layout, tracing each data point
+// once for all of them.
+template <typename ScalarSampler, typename VectorSampler>
+class AdvectBatchJob {
+ public:
+    AdvectBatchJob(
+        const std::vector<ScalarSampler>& scalarInputs,
+        const std::vector<VectorSampler>& vectorInputs,
+        const std::vector<ArrayAccessor3<double>>& scalarOutputs,
+        const std::vector<ArrayAccessor3<Vector3D>>& vectorOutputs,
+        const Size3& dataSize,
+        const Vector3D& dataOrigin,
+        const Vector3D& gridSpacing,
+        double dt)
+    : _scalarInputs(scalarInputs),
+      _vectorInputs(vectorInputs),
+      _scalarOutputs(scalarOutputs),
+      _vectorOutputs(vectorOutputs),
+      _dataSize(dataSize),
+      _dataOrigin(dataOrigin),
+      _gridSpacing(gridSpacing),
+      _dt(dt),
+      _h(min3(gridSpacing.x, gridSpacing.y, gridSpacing.z)) {
+    }
+
+    template <typename FlowSampler, typename SdfSampler>
+    void operator()(
+        const FlowSampler& flow, const SdfSampler& boundarySdf) const {
+        std::vector<ArrayAccessor3<double>> scalarOutputs = _scalarOutputs;
+        std::vector<ArrayAccessor3<Vector3D>> vectorOutputs = _vectorOutputs;
+
+        parallelFor(
+            kZeroSize, _dataSize.x,
+            kZeroSize, _dataSize.y,
+            kZeroSize, _dataSize.z,
+            [&](size_t i, size_t j, size_t k) {
+                Vector3D x = _dataOrigin + _gridSpacing * Vector3D({i, j, k});
+                if (boundarySdf(x) > 0.0) {
+                    Vector3D pt = backTrace(flow, boundarySdf, _dt, _h, x);
+                    sampleChannels(
+                        _scalarInputs, _vectorInputs, pt, i, j, k,
+                        &scalarOutputs, &vectorOutputs);
+                }
+            });
+    }
+
+ private:
+    const std::vector<ScalarSampler>& _scalarInputs;
+    const std::vector<VectorSampler>& _vectorInputs;
+    const std::vector<ArrayAccessor3<double>>& _scalarOutputs;
+    const std::vector<ArrayAccessor3<Vector3D>>& _vectorOutputs;
+    Size3 _dataSize;
+    Vector3D _dataOrigin;
+    Vector3D _gridSpacing;
+    double _dt;
+    double _h;
+};
+
+template <typename ScalarSampler, typename VectorSampler>
+void advectBatch(
+    const std::vector<ScalarSampler>& scalarInputs,
+    const std::vector<VectorSampler>& vectorInputs,
+    const std::vector<ArrayAccessor3<double>>& scalarOutputs,
+    const std::vector<ArrayAccessor3<Vector3D>>& vectorOutputs,
+    const Size3& dataSize,
+    const Vector3D& dataOrigin,
+    const Vector3D& gridSpacing,
+    const VectorField3& flow,
+    double dt,
+    const ScalarField3& boundarySdf) {
+    runWithFieldSamplers(
+        flow,
+        boundarySdf,
+        AdvectBatchJob<ScalarSampler, VectorSampler>(
+            scalarInputs,
+            vectorInputs,
+            scalarOutputs,
+            vectorOutputs,
+            dataSize,
+            dataOrigin,
+            gridSpacing,
+            dt));
+}
+
+}  // namespace
+
 SemiLagrangian3::SemiLagrangian3() {
 }
 
+SemiLagrangian3::SemiLagrangian3(Interpolation interpolation) :
+    _interpolation(interpolation) {
+}
+
 SemiLagrangian3::~SemiLagrangian3() {
 }
 
@@ -20,23 +293,62 @@ void SemiLagrangian3::advect(
     double dt,
     ScalarGrid3* output,
     const ScalarField3& boundarySdf) {
-    auto outputDataPos = output->dataPosition();
-    auto outputDataAcc = output->dataAccessor();
-    auto inputSamplerFunc = getScalarSamplerFunc(input);
-    auto inputDataPos = input.dataPosition();
-
-    double h = min3(
-        output->gridSpacing().x,
-        output->gridSpacing().y,
-        output->gridSpacing().z);
-
-    output->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-        if (boundarySdf.sample(inputDataPos(i, j, k)) > 0.0) {
-            Vector3D pt = backTrace(
-                flow, dt, h, outputDataPos(i, j, k), boundarySdf);
-            outputDataAcc(i, j, k) = inputSamplerFunc(pt);
-        }
-    });
+    Vector3D inputOrigin = input.dataOrigin();
+    Vector3D inputSpacing = input.gridSpacing();
+    ArrayAccessor3<double> outputData = output->dataAccessor();
+    Size3 outputSize = output->dataSize();
+    Vector3D outputOrigin = output->dataOrigin();
+    Vector3D outputSpacing = output->gridSpacing();
+
+    switch (_interpolation) {
+        case Interpolation::Linear:
+            advectData(
+                input.linearSampler(), inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+        case Interpolation::Cubic:
+            advectData(
+                CubicArraySampler3<double, double>(
+                    input.constDataAccessor(), inputSpacing, inputOrigin,
+                    _isCubicMonotonic),
+                inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+        default:
+            advectData(
+                getScalarSamplerFunc(input), inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+    }
+}
+
+void SemiLagrangian3::advect(
+    const ScalarGrid3F& input,
+    const VectorField3& flow,
+    double dt,
+    ScalarGrid3F* output,
+    const ScalarField3& boundarySdf) {
+    Vector3D inputOrigin = input.dataOrigin();
+    Vector3D inputSpacing = input.gridSpacing();
+    ArrayAccessor3<float> outputData = output->dataAccessor();
+    Size3 outputSize = output->dataSize();
+    Vector3D outputOrigin = output->dataOrigin();
+    Vector3D outputSpacing = output->gridSpacing();
+
+    switch (_interpolation) {
+        case Interpolation::Linear:
+            advectData(
+                input.linearSampler(), inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+        default:
+            AdvectionSolver3::advect(input, flow, dt, output, boundarySdf);
+            break;
+    }
 }
 
 void SemiLagrangian3::advect(
@@ -45,24 +357,36 @@ void SemiLagrangian3::advect(
     double dt,
     CollocatedVectorGrid3* output,
     const ScalarField3& boundarySdf) {
-    auto inputSamplerFunc = getVectorSamplerFunc(input);
-
-    double h = min3(
-        output->gridSpacing().x,
-        output->gridSpacing().y,
-        output->gridSpacing().z);
-
-    auto outputDataPos = output->dataPosition();
-    auto outputDataAcc = output->dataAccessor();
-    auto inputDataPos = input.dataPosition();
-
-    output->parallelForEachDataPointIndex([&](size_t i, size_t j, size_t k) {
-        if (boundarySdf.sample(inputDataPos(i, j, k)) > 0.0) {
-            Vector3D pt = backTrace(
-                flow, dt, h, outputDataPos(i, j, k), boundarySdf);
-            outputDataAcc(i, j, k) = inputSamplerFunc(pt);
-        }
-    });
+    Vector3D inputOrigin = input.dataOrigin();
+    Vector3D inputSpacing = input.gridSpacing();
+    ArrayAccessor3<Vector3D> outputData = output->dataAccessor();
+    Size3 outputSize = output->dataSize();
+    Vector3D outputOrigin = output->dataOrigin();
+    Vector3D outputSpacing = output->gridSpacing();
+
+    switch (_interpolation) {
+        case Interpolation::Linear:
+            advectData(
+                input.linearSampler(), inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+        case Interpolation::Cubic:
+            advectData(
+                CubicArraySampler3<Vector3D, double>(
+                    input.constDataAccessor(), inputSpacing, inputOrigin,
+                    _isCubicMonotonic),
+                inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+        default:
+            advectData(
+                getVectorSamplerFunc(input), inputOrigin, inputSpacing,
+                outputData, outputSize, outputOrigin, outputSpacing,
+                flow, dt, boundarySdf);
+            break;
+    }
 }
 
 void SemiLagrangian3::advect(
@@ -71,88 +395,200 @@ void SemiLagrangian3::advect(
     double dt,
     FaceCenteredGrid3* output,
     const ScalarField3& boundarySdf) {
-    auto inputSamplerFunc = getVectorSamplerFunc(input);
-
-    double h = min3(
-        output->gridSpacing().x,
-        output->gridSpacing().y,
-        output->gridSpacing().z);
-
-    auto uTargetDataPos = output->uPosition();
-    auto uTargetDataAcc = output->uAccessor();
-    auto uSourceDataPos = input.uPosition();
-
-    output->parallelForEachUIndex([&](size_t i, size_t j, size_t k) {
-        if (boundarySdf.sample(uSourceDataPos(i, j, k)) > 0.0) {
-            Vector3D pt = backTrace(
-                flow, dt, h, uTargetDataPos(i, j, k), boundarySdf);
-            uTargetDataAcc(i, j, k) = inputSamplerFunc(pt).x;
-        }
-    });
-
-    auto vTargetDataPos = output->vPosition();
-    auto vTargetDataAcc = output->vAccessor();
-    auto vSourceDataPos = input.vPosition();
-
-    output->parallelForEachVIndex([&](size_t i, size_t j, size_t k) {
-        if (boundarySdf.sample(vSourceDataPos(i, j, k)) > 0.0) {
-            Vector3D pt = backTrace(
-                flow, dt, h, vTargetDataPos(i, j, k), boundarySdf);
-            vTargetDataAcc(i, j, k) = inputSamplerFunc(pt).y;
-        }
-    });
+    const LinearArraySampler3<double, double>* inputLinearSamplers[3] = {
+        &input.uLinearSampler(),
+        &input.vLinearSampler(),
+        &input.wLinearSampler()
+    };
+    ConstArrayAccessor3<double> inputData[3] = {
+        input.uConstAccessor(),
+        input.vConstAccessor(),
+        input.wConstAccessor()
+    };
+    Vector3D inputOrigins[3] = {
+        input.uOrigin(),
+        input.vOrigin(),
+        input.wOrigin()
+    };
+    ArrayAccessor3<double> outputData[3] = {
+        output->uAccessor(),
+        output->vAccessor(),
+        output->wAccessor()
+    };
+    Size3 outputSizes[3] = {
+        output->uSize(),
+        output->vSize(),
+        output->wSize()
+    };
+    Vector3D outputOrigins[3] = {
+        output->uOrigin(),
+        output->vOrigin(),
+        output->wOrigin()
+    };
+    Vector3D inputSpacing = input.gridSpacing();
+    Vector3D outputSpacing = output->gridSpacing();
 
-    auto wTargetDataPos = output->wPosition();
-    auto wTargetDataAcc = output->wAccessor();
-    auto wSourceDataPos = input.wPosition();
+    std::function<Vector3D(const Vector3D&)> customSampler;
+    if (_interpolation == Interpolation::Custom) {
+        customSampler = getVectorSamplerFunc(input);
+    }
 
-    output->parallelForEachWIndex([&](size_t i, size_t j, size_t k) {
-        if (boundarySdf.sample(wSourceDataPos(i, j, k)) > 0.0) {
-            Vector3D pt = backTrace(
-                flow, dt, h, wTargetDataPos(i, j, k), boundarySdf);
-            wTargetDataAcc(i, j, k) = inputSamplerFunc(pt).z;
+    for (size_t c = 0; c < 3; ++c) {
+        switch (_interpolation) {
+            case Interpolation::Linear:
+                advectData(
+                    *inputLinearSamplers[c], inputOrigins[c], inputSpacing,
+                    outputData[c], outputSizes[c], outputOrigins[c],
+                    outputSpacing, flow, dt, boundarySdf);
+                break;
+            case Interpolation::Cubic:
+                advectData(
+                    CubicArraySampler3<double, double>(
+                        inputData[c], inputSpacing, inputOrigins[c],
+                        _isCubicMonotonic),
+                    inputOrigins[c], inputSpacing,
+                    outputData[c], outputSizes[c], outputOrigins[c],
+                    outputSpacing, flow, dt, boundarySdf);
+                break;
+            default:
+                advectData(
+                    VectorComponentSampler3(customSampler, c),
+                    inputOrigins[c], inputSpacing,
+                    outputData[c], outputSizes[c], outputOrigins[c],
+                    outputSpacing, flow, dt, boundarySdf);
+                break;
         }
-    });
+    }
 }
 
-Vector3D SemiLagrangian3::backTrace(
+void SemiLagrangian3::advect(
+    const std::vector<const ScalarGrid3*>& scalarInputs,
+    const std::vector<const CollocatedVectorGrid3*>& vectorInputs,
     const VectorField3& flow,
     double dt,
-    double h,
-    const Vector3D& startPt,
+    const std::vector<ScalarGrid3*>& scalarOutputs,
+    const std::vector<CollocatedVectorGrid3*>& vectorOutputs,
     const ScalarField3& boundarySdf) {
+    JET_THROW_INVALID_ARG_IF(scalarInputs.size() != scalarOutputs.size());
+    JET_THROW_INVALID_ARG_IF(vectorInputs.size() != vectorOutputs.size());
+
+    // Grids whose input and output layouts differ cannot share the traced
+    // points, so they are advected separately.
+    std::vector<bool> scalarDone(scalarInputs.size(), false);
+    std::vector<bool> vectorDone(vectorInputs.size(), false);
+    for (size_t c = 0; c < scalarInputs.size(); ++c) {
+        if (!hasSameDataLayout(*scalarInputs[c], *scalarOutputs[c])) {
+            advect(*scalarInputs[c], flow, dt, scalarOutputs[c], boundarySdf);
+            scalarDone[c] = true;
+        }
+    }
+    for (size_t c = 0; c < vectorInputs.size(); ++c) {
+        if (!hasSameDataLayout(*vectorInputs[c], *vectorOutputs[c])) {
+            advect(*vectorInputs[c], flow, dt, vectorOutputs[c], boundarySdf);
+            vectorDone[c] = true;
+        }
+    }
 
-    double remainingT = dt;
-    Vector3D pt0 = startPt;
-    Vector3D pt1 = startPt;
-
-    while (remainingT > kEpsilonD) {
-        // Adaptive time-stepping
-        Vector3D vel0 = flow.sample(pt0);
-        double numSubSteps
-            = std::max(std::ceil(vel0.length() * remainingT / h), 1.0);
-        dt = remainingT / numSubSteps;
-
-        // Mid-point rule
-        Vector3D midPt = pt0 - 0.5 * dt * vel0;
-        Vector3D midVel = flow.sample(midPt);
-        pt1 = pt0 - dt * midVel;
-
-        // Boundary handling
-        double phi0 = boundarySdf.sample(pt0);
-        double phi1 = boundarySdf.sample(pt1);
-
-        if (phi0 * phi1 < 0.0) {
-            double w = std::fabs(phi1) / (std::fabs(phi0) + std::fabs(phi1));
-            pt1 = w * pt0 + (1.0 - w) * pt1;
+    // Each remaining group of grids with the same layout is traced once
+    while (true) {
+        bool hasGroup = false;
+        Size3 dataSize;
+        Vector3D dataOrigin;
+        Vector3D gridSpacing;
+
+        for (size_t c = 0; c < scalarOutputs.size() && !hasGroup; ++c) {
+            if (!scalarDone[c]) {
+                hasGroup = true;
+                dataSize = scalarOutputs[c]->dataSize();
+                dataOrigin = scalarOutputs[c]->dataOrigin();
+                gridSpacing = scalarOutputs[c]->gridSpacing();
+            }
+        }
+        for (size_t c = 0; c < vectorOutputs.size() && !hasGroup; ++c) {
+            if (!vectorDone[c]) {
+                hasGroup = true;
+                dataSize = vectorOutputs[c]->dataSize();
+                dataOrigin = vectorOutputs[c]->dataOrigin();
+                gridSpacing = vectorOutputs[c]->gridSpacing();
+            }
+        }
+        if (!hasGroup) {
             break;
         }
 
-        remainingT -= dt;
-        pt0 = pt1;
+        std::vector<const ScalarGrid3*> scalarGroup;
+        std::vector<ArrayAccessor3<double>> scalarData;
+        for (size_t c = 0; c < scalarOutputs.size(); ++c) {
+            if (!scalarDone[c] && hasDataLayout(
+                    *scalarOutputs[c], dataSize, dataOrigin, gridSpacing)) {
+                scalarGroup.push_back(scalarInputs[c]);
+                scalarData.push_back(scalarOutputs[c]->dataAccessor());
+                scalarDone[c] = true;
+            }
+        }
+
+        std::vector<const CollocatedVectorGrid3*> vectorGroup;
+        std::vector<ArrayAccessor3<Vector3D>> vectorData;
+        for (size_t c = 0; c < vectorOutputs.size(); ++c) {
+            if (!vectorDone[c] && hasDataLayout(
+                    *vectorOutputs[c], dataSize, dataOrigin, gridSpacing)) {
+                vectorGroup.push_back(vectorInputs[c]);
+                vectorData.push_back(vectorOutputs[c]->dataAccessor());
+                vectorDone[c] = true;
+            }
+        }
+
+        if (_interpolation == Interpolation::Linear) {
+            std::vector<LinearArraySampler3<double, double>> scalarSamplers;
+            for (const ScalarGrid3* grid : scalarGroup) {
+                scalarSamplers.push_back(grid->linearSampler());
+            }
+            std::vector<LinearArraySampler3<Vector3D, double>> vectorSamplers;
+            for (const CollocatedVectorGrid3* grid : vectorGroup) {
+                vectorSamplers.push_back(grid->linearSampler());
+            }
+            advectBatch(
+                scalarSamplers, vectorSamplers, scalarData, vectorData,
+                dataSize, dataOrigin, gridSpacing, flow, dt, boundarySdf);
+        } else if (_interpolation == Interpolation::Cubic) {
+            std::vector<CubicArraySampler3<double, double>> scalarSamplers;
+            for (const ScalarGrid3* grid : scalarGroup) {
+                scalarSamplers.push_back(CubicArraySampler3<double, double>(
+                    grid->constDataAccessor(), gridSpacing, dataOrigin,
+                    _isCubicMonotonic));
+            }
+            std::vector<CubicArraySampler3<Vector3D, double>> vectorSamplers;
+            for (const CollocatedVectorGrid3* grid : vectorGroup) {
+                vectorSamplers.push_back(CubicArraySampler3<Vector3D, double>(
+                    grid->constDataAccessor(), gridSpacing, dataOrigin,
+                    _isCubicMonotonic));
+            }
+            advectBatch(
+                scalarSamplers, vectorSamplers, scalarData, vectorData,
+                dataSize, dataOrigin, gridSpacing, flow, dt, boundarySdf);
+        } else {
+            std::vector<std::function<double(const Vector3D&)>> scalarSamplers;
+            for (const ScalarGrid3* grid : scalarGroup) {
+                scalarSamplers.push_back(getScalarSamplerFunc(*grid));
+            }
+            std::vector<std::function<Vector3D(const Vector3D&)>>
+                vectorSamplers;
+            for (const CollocatedVectorGrid3* grid : vectorGroup) {
+                vectorSamplers.push_back(getVectorSamplerFunc(*grid));
+            }
+            advectBatch(
+                scalarSamplers, vectorSamplers, scalarData, vectorData,
+                dataSize, dataOrigin, gridSpacing, flow, dt, boundarySdf);
+        }
     }
+}
+
+bool SemiLagrangian3::isCubicMonotonic() const {
+    return _isCubicMonotonic;
+}
 
-    return pt1;
+void SemiLagrangian3::setIsCubicMonotonic(bool isMonotonic) {
+    _isCubicMonotonic = isMonotonic;
 }
 
 std::function<double(const Vector3D&)>
@@ -0,0 +1,112 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_SEMI_LAGRANGIAN_HELPERS_H_
+#define SRC_JET_SEMI_LAGRANGIAN_HELPERS_H_
+
+#include <jet/collocated_vector_grid3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/scalar_grid3.h>
+#include <grid_sampler_helpers.h>
+#include <algorithm>
+#include <cmath>
+
+namespace jet {
+
+// Returns true if the grid data has the given size, origin, and spacing.
+template <typename Grid>
+bool hasDataLayout(
+    const Grid& grid,
+    const Size3& dataSize,
+    const Vector3D& dataOrigin,
+    const Vector3D& gridSpacing) {
+    return grid.dataSize() == dataSize
+        && grid.dataOrigin().isSimilar(dataOrigin)
+        && grid.gridSpacing().isSimilar(gridSpacing);
+}
+
+template <typename GridA, typename GridB>
+bool hasSameDataLayout(const GridA& a, const GridB& b) {
+    return hasDataLayout(a, b.dataSize(), b.dataOrigin(), b.gridSpacing());
+}
+
+// Traces startPt back in time by dt with the mid-point rule, stopping at the
+// boundary interface.
+template <typename FlowSampler, typename SdfSampler>
+Vector3D backTrace(
+    const FlowSampler& flow,
+    const SdfSampler& boundarySdf,
+    double dt,
+    double h,
+    const Vector3D& startPt) {
+
+    double remainingT = dt;
+    Vector3D pt0 = startPt;
+    Vector3D pt1 = startPt;
+
+    while (remainingT > kEpsilonD) {
+        // Adaptive time-stepping
+        Vector3D vel0 = flow(pt0);
+        double numSubSteps
+            = std::max(std::ceil(vel0.length() * remainingT / h), 1.0);
+        dt = remainingT / numSubSteps;
+
+        // Mid-point rule
+        Vector3D midPt = pt0 - 0.5 * dt * vel0;
+        Vector3D midVel = flow(midPt);
+        pt1 = pt0 - dt * midVel;
+
+        // Boundary handling
+        double phi0 = boundarySdf(pt0);
+        double phi1 = boundarySdf(pt1);
+
+        if (phi0 * phi1 < 0.0) {
+            double w = std::fabs(phi1) / (std::fabs(phi0) + std::fabs(phi1));
+            pt1 = w * pt0 + (1.0 - w) * pt1;
+            break;
+        }
+
+        remainingT -= dt;
+        pt0 = pt1;
+    }
+
+    return pt1;
+}
+
+// Calls the job with the typed samplers of the flow and boundary fields, so
+// that the back-tracing loop is compiled for each known field type.
+template <typename Job>
+void runWithFieldSamplers(
+    const VectorField3& flow,
+    const ScalarField3& boundarySdf,
+    const Job& job) {
+    auto faceCenteredFlow = dynamic_cast<const FaceCenteredGrid3*>(&flow);
+    auto collocatedFlow = dynamic_cast<const CollocatedVectorGrid3*>(&flow);
+    auto gridSdf = dynamic_cast<const ScalarGrid3*>(&boundarySdf);
+
+    if (faceCenteredFlow != nullptr) {
+        FaceCenteredGridSampler3 flowSampler(*faceCenteredFlow);
+        if (gridSdf != nullptr) {
+            job(flowSampler, gridSdf->linearSampler());
+        } else {
+            job(flowSampler, ScalarFieldSampler3(boundarySdf));
+        }
+    } else if (collocatedFlow != nullptr) {
+        const auto& flowSampler = collocatedFlow->linearSampler();
+        if (gridSdf != nullptr) {
+            job(flowSampler, gridSdf->linearSampler());
+        } else {
+            job(flowSampler, ScalarFieldSampler3(boundarySdf));
+        }
+    } else {
+        VectorFieldSampler3 flowSampler(flow);
+        if (gridSdf != nullptr) {
+            job(flowSampler, gridSdf->linearSampler());
+        } else {
+            job(flowSampler, ScalarFieldSampler3(boundarySdf));
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_SEMI_LAGRANGIAN_HELPERS_H_
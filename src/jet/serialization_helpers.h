@@ -0,0 +1,53 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_SERIALIZATION_HELPERS_H_
+#define SRC_JET_SERIALIZATION_HELPERS_H_
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+namespace jet {
+
+// Writes the bytes of a plain value in host order, the same way the arrays
+// and grids are serialized.
+template <typename T>
+inline void serializeValue(std::ostream* strm, const T& value) {
+    static_assert(
+        std::is_arithmetic<T>::value || std::is_enum<T>::value
+        || std::is_standard_layout<T>::value,
+        "Only plain values can be serialized");
+    strm->write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+inline void deserializeValue(std::istream* strm, T* value) {
+    strm->read(reinterpret_cast<char*>(value), sizeof(T));
+}
+
+// Writes the name of the class whose data follows, so reading a stream of
+// another class can be detected.
+inline void serializeSectionTag(std::ostream* strm, const char* name) {
+    uint32_t length = static_cast<uint32_t>(std::strlen(name));
+    serializeValue(strm, length);
+    strm->write(name, length);
+}
+
+// Returns true if the stream has the section tag of the given name.
+inline bool deserializeSectionTag(std::istream* strm, const char* name) {
+    uint32_t length = 0;
+    deserializeValue(strm, &length);
+    if (!(*strm) || length != std::strlen(name)) {
+        return false;
+    }
+
+    std::string tag(length, '\0');
+    strm->read(&tag[0], length);
+    return static_cast<bool>(*strm) && tag == name;
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_SERIALIZATION_HELPERS_H_
@@ -0,0 +1,567 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/shared_frame_buffer.h>
+#include <shared_memory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const char kSharedFrameTag[] = "JETSHFRM";
+const size_t kSharedFrameTagLength = 8;
+const uint32_t kSharedFrameVersion = 1;
+const size_t kSharedFrameAlignment = 64;
+
+// Number of times a viewer retries when the slot it reads is overwritten
+const size_t kMaxNumberOfReadAttempts = 16;
+
+struct SharedFrameBufferHeader {
+    char tag[kSharedFrameTagLength];
+    uint32_t version;
+    uint32_t numberOfSlots;
+    uint64_t slotCapacity;
+    std::atomic<uint64_t> latestSequence;
+    uint64_t reserved[4];
+};
+
+// Header of each slot, followed by the data of the frame. The version is odd
+// while the publisher writes the slot.
+struct SharedFrameSlotHeader {
+    std::atomic<uint64_t> version;
+    uint64_t sequence;
+    uint32_t type;
+    uint32_t frameIndex;
+    double timeInSeconds;
+    uint64_t numberOfPoints;
+    uint64_t numberOfTriangles;
+    uint64_t resolution[3];
+    double gridSpacing[3];
+    double origin[3];
+    uint64_t dataSize[3];
+    double dataOrigin[3];
+    uint64_t reserved[3];
+};
+
+static_assert(
+    sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+    "Unexpected atomic size");
+static_assert(
+    sizeof(SharedFrameBufferHeader) == kSharedFrameAlignment,
+    "Unexpected shared frame buffer header size");
+static_assert(
+    sizeof(SharedFrameSlotHeader) == 3 * kSharedFrameAlignment,
+    "Unexpected shared frame slot header size");
+static_assert(
+    sizeof(Vector3D) == 3 * sizeof(double),
+    "Unexpected Vector3D layout");
+
+size_t slotStride(size_t slotCapacity) {
+    size_t size = sizeof(SharedFrameSlotHeader) + slotCapacity;
+    return (size + kSharedFrameAlignment - 1) / kSharedFrameAlignment
+        * kSharedFrameAlignment;
+}
+
+SharedFrameBufferHeader* bufferHeader(char* base) {
+    return reinterpret_cast<SharedFrameBufferHeader*>(base);
+}
+
+SharedFrameSlotHeader* slotHeader(
+    char* base,
+    size_t slotCapacity,
+    size_t slot) {
+    return reinterpret_cast<SharedFrameSlotHeader*>(
+        base + sizeof(SharedFrameBufferHeader)
+        + slot * slotStride(slotCapacity));
+}
+
+// Returns the number of bytes of the data, or max if it overflows
+size_t dataBytes(uint64_t count, size_t elementSize) {
+    if (count > std::numeric_limits<size_t>::max() / elementSize) {
+        return std::numeric_limits<size_t>::max();
+    }
+    return static_cast<size_t>(count) * elementSize;
+}
+
+}  // namespace
+
+SharedFramePublisher::SharedFramePublisher() {
+}
+
+SharedFramePublisher::~SharedFramePublisher() {
+    close();
+}
+
+bool SharedFramePublisher::open(
+    const std::string& name,
+    size_t slotCapacityInBytes,
+    size_t numberOfSlots) {
+    JET_THROW_INVALID_ARG_IF(numberOfSlots < 2);
+
+    close();
+
+    size_t stride = slotStride(slotCapacityInBytes);
+    std::unique_ptr<SharedMemory> memory(SharedMemory::create(
+        name, sizeof(SharedFrameBufferHeader) + numberOfSlots * stride));
+    if (!memory->isValid()) {
+        return false;
+    }
+
+    // New shared memory is zero-filled
+    char* base = memory->data();
+    SharedFrameBufferHeader* header = bufferHeader(base);
+    std::memcpy(header->tag, kSharedFrameTag, kSharedFrameTagLength);
+    header->version = kSharedFrameVersion;
+    header->numberOfSlots = static_cast<uint32_t>(numberOfSlots);
+    header->slotCapacity = slotCapacityInBytes;
+    new (&header->latestSequence) std::atomic<uint64_t>(0);
+    for (size_t s = 0; s < numberOfSlots; ++s) {
+        new (&slotHeader(base, slotCapacityInBytes, s)->version)
+            std::atomic<uint64_t>(0);
+    }
+
+    _name = name;
+    _memory = std::move(memory);
+    _slotCapacity = slotCapacityInBytes;
+    _numberOfSlots = numberOfSlots;
+    _numberOfPublishedFrames = 0;
+    _numberOfDroppedFrames = 0;
+    _isStopping = false;
+    _thread = std::thread(&SharedFramePublisher::run, this);
+    return true;
+}
+
+void SharedFramePublisher::close() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+        }
+        _snapshotQueued.notify_all();
+        _thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _memory.reset();
+    _pending.reset();
+}
+
+bool SharedFramePublisher::isOpen() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _memory != nullptr;
+}
+
+const std::string& SharedFramePublisher::name() const {
+    return _name;
+}
+
+bool SharedFramePublisher::publishParticles(
+    const Frame& frame,
+    const ConstArrayAccessor1<Vector3D>& positions) {
+    size_t bytes = dataBytes(positions.size(), sizeof(Vector3D));
+    if (!isOpen() || bytes > _slotCapacity) {
+        return false;
+    }
+
+    std::unique_ptr<Snapshot> snapshot(new Snapshot);
+    snapshot->type = SharedFrameType::Particles;
+    snapshot->frameIndex = frame.index;
+    snapshot->timeInSeconds = frame.timeInSeconds();
+    snapshot->points.assign(
+        positions.data(), positions.data() + positions.size());
+    return queue(std::move(snapshot), bytes);
+}
+
+bool SharedFramePublisher::publishScalarGrid(
+    const Frame& frame,
+    const ScalarGrid3& grid) {
+    Size3 dataSize = grid.dataSize();
+    size_t bytes = dataBytes(
+        static_cast<uint64_t>(dataSize.x) * dataSize.y * dataSize.z,
+        sizeof(double));
+    if (!isOpen() || bytes > _slotCapacity) {
+        return false;
+    }
+
+    // The clone shares the data with the grid until either is written
+    std::unique_ptr<Snapshot> snapshot(new Snapshot);
+    snapshot->type = SharedFrameType::ScalarGrid;
+    snapshot->frameIndex = frame.index;
+    snapshot->timeInSeconds = frame.timeInSeconds();
+    snapshot->grid = grid.clone();
+    return queue(std::move(snapshot), bytes);
+}
+
+bool SharedFramePublisher::publishTriangleMesh(
+    const Frame& frame,
+    const TriangleMesh3& mesh) {
+    size_t pointBytes = dataBytes(mesh.numberOfPoints(), sizeof(Vector3D));
+    size_t triangleBytes
+        = dataBytes(mesh.numberOfTriangles(), 3 * sizeof(uint32_t));
+    if (!isOpen() || pointBytes > _slotCapacity
+        || triangleBytes > _slotCapacity - pointBytes) {
+        return false;
+    }
+
+    std::unique_ptr<Snapshot> snapshot(new Snapshot);
+    snapshot->type = SharedFrameType::TriangleMesh;
+    snapshot->frameIndex = frame.index;
+    snapshot->timeInSeconds = frame.timeInSeconds();
+    snapshot->points.resize(mesh.numberOfPoints());
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        snapshot->points[i] = mesh.hasTransform()
+            ? mesh.orientation().mul(mesh.point(i)) + mesh.translation()
+            : mesh.point(i);
+    }
+    snapshot->triangles.resize(3 * mesh.numberOfTriangles());
+    for (size_t i = 0; i < mesh.numberOfTriangles(); ++i) {
+        const Point3UI& indices = mesh.pointIndex(i);
+        for (size_t j = 0; j < 3; ++j) {
+            snapshot->triangles[3 * i + j]
+                = static_cast<uint32_t>(indices[j]);
+        }
+    }
+    return queue(std::move(snapshot), pointBytes + triangleBytes);
+}
+
+void SharedFramePublisher::flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _snapshotCopied.wait(lock, [&] { return !_pending && !_isCopying; });
+}
+
+uint64_t SharedFramePublisher::numberOfPublishedFrames() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numberOfPublishedFrames;
+}
+
+uint64_t SharedFramePublisher::numberOfDroppedFrames() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numberOfDroppedFrames;
+}
+
+bool SharedFramePublisher::queue(
+    std::unique_ptr<Snapshot> snapshot,
+    size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_memory == nullptr || bytes > _slotCapacity) {
+            return false;
+        }
+        if (_pending) {
+            ++_numberOfDroppedFrames;
+        }
+        _pending = std::move(snapshot);
+    }
+    _snapshotQueued.notify_one();
+    return true;
+}
+
+void SharedFramePublisher::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _snapshotQueued.wait(lock, [&] { return _pending || _isStopping; });
+
+        // The pending snapshot is still published when stopping
+        if (!_pending) {
+            break;
+        }
+
+        std::unique_ptr<Snapshot> snapshot = std::move(_pending);
+        uint64_t sequence = _numberOfPublishedFrames + 1;
+        _isCopying = true;
+        lock.unlock();
+
+        copyToSlot(*snapshot, sequence);
+        snapshot.reset();
+
+        lock.lock();
+        _isCopying = false;
+        _numberOfPublishedFrames = sequence;
+        _snapshotCopied.notify_all();
+    }
+}
+
+void SharedFramePublisher::copyToSlot(
+    const Snapshot& snapshot,
+    uint64_t sequence) {
+    char* base = _memory->data();
+    SharedFrameSlotHeader* slot
+        = slotHeader(base, _slotCapacity, sequence % _numberOfSlots);
+    char* data = reinterpret_cast<char*>(slot + 1);
+
+    uint64_t version = slot->version.load(std::memory_order_relaxed);
+    slot->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->sequence = sequence;
+    slot->type = static_cast<uint32_t>(snapshot.type);
+    slot->frameIndex = snapshot.frameIndex;
+    slot->timeInSeconds = snapshot.timeInSeconds;
+    slot->numberOfPoints = snapshot.points.size();
+    slot->numberOfTriangles = snapshot.triangles.size() / 3;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        slot->resolution[axis] = 0;
+        slot->gridSpacing[axis] = 0.0;
+        slot->origin[axis] = 0.0;
+        slot->dataSize[axis] = 0;
+        slot->dataOrigin[axis] = 0.0;
+    }
+
+    if (!snapshot.points.empty()) {
+        std::memcpy(
+            data, snapshot.points.data(),
+            snapshot.points.size() * sizeof(Vector3D));
+        data += snapshot.points.size() * sizeof(Vector3D);
+    }
+    if (!snapshot.triangles.empty()) {
+        std::memcpy(
+            data, snapshot.triangles.data(),
+            snapshot.triangles.size() * sizeof(uint32_t));
+    }
+
+    if (snapshot.grid) {
+        const ScalarGrid3& grid = *snapshot.grid;
+        Size3 dataSize = grid.dataSize();
+        for (size_t axis = 0; axis < 3; ++axis) {
+            slot->resolution[axis] = grid.resolution()[axis];
+            slot->gridSpacing[axis] = grid.gridSpacing()[axis];
+            slot->origin[axis] = grid.origin()[axis];
+            slot->dataSize[axis] = dataSize[axis];
+            slot->dataOrigin[axis] = grid.dataOrigin()[axis];
+        }
+        size_t n = dataSize.x * dataSize.y * dataSize.z;
+        if (n > 0) {
+            std::memcpy(
+                data, grid.constDataAccessor().data(), n * sizeof(double));
+        }
+    }
+
+    slot->version.store(version + 2, std::memory_order_release);
+    bufferHeader(base)->latestSequence.store(
+        sequence, std::memory_order_release);
+}
+
+SharedFrameViewer::SharedFrameViewer() {
+}
+
+SharedFrameViewer::~SharedFrameViewer() {
+}
+
+bool SharedFrameViewer::open(const std::string& name) {
+    close();
+
+    std::unique_ptr<SharedMemory> memory(SharedMemory::open(name));
+    if (!memory->isValid()
+        || memory->size() < sizeof(SharedFrameBufferHeader)) {
+        return false;
+    }
+
+    const SharedFrameBufferHeader* header = bufferHeader(memory->data());
+    size_t size = memory->size() - sizeof(SharedFrameBufferHeader);
+    if (std::memcmp(header->tag, kSharedFrameTag, kSharedFrameTagLength) != 0
+        || header->version != kSharedFrameVersion
+        || header->numberOfSlots < 2 || header->slotCapacity > size
+        || header->numberOfSlots
+            > size / slotStride(static_cast<size_t>(header->slotCapacity))) {
+        return false;
+    }
+
+    _slotCapacity = static_cast<size_t>(header->slotCapacity);
+    _numberOfSlots = header->numberOfSlots;
+    _memory = std::move(memory);
+    return true;
+}
+
+void SharedFrameViewer::close() {
+    _memory.reset();
+    _slotCapacity = 0;
+    _numberOfSlots = 0;
+}
+
+bool SharedFrameViewer::isOpen() const {
+    return _memory != nullptr;
+}
+
+uint64_t SharedFrameViewer::latestSequence() const {
+    if (!_memory) {
+        return 0;
+    }
+
+    return bufferHeader(_memory->data())->latestSequence.load(
+        std::memory_order_acquire);
+}
+
+bool SharedFrameViewer::acquireLatest(SharedFrameView* view) const {
+    if (!_memory) {
+        return false;
+    }
+
+    char* base = _memory->data();
+    for (size_t attempt = 0; attempt < kMaxNumberOfReadAttempts; ++attempt) {
+        uint64_t sequence = latestSequence();
+        if (sequence == 0) {
+            return false;
+        }
+
+        size_t s = static_cast<size_t>(sequence % _numberOfSlots);
+        const SharedFrameSlotHeader* slot = slotHeader(base, _slotCapacity, s);
+        uint64_t version = slot->version.load(std::memory_order_acquire);
+        if (version % 2 == 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        SharedFrameView result;
+        uint64_t slotSequence = slot->sequence;
+        uint32_t type = slot->type;
+        uint64_t numberOfPoints = slot->numberOfPoints;
+        uint64_t numberOfTriangles = slot->numberOfTriangles;
+        uint64_t dataSize[3];
+        result.frameIndex = slot->frameIndex;
+        result.timeInSeconds = slot->timeInSeconds;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            result.resolution[axis]
+                = static_cast<size_t>(slot->resolution[axis]);
+            result.gridSpacing[axis] = slot->gridSpacing[axis];
+            result.origin[axis] = slot->origin[axis];
+            result.dataOrigin[axis] = slot->dataOrigin[axis];
+            dataSize[axis] = slot->dataSize[axis];
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->version.load(std::memory_order_relaxed) != version
+            || slotSequence != sequence) {
+            continue;
+        }
+
+        // The header is consistent, so the sizes are the ones written by the
+        // publisher, but check them against the slot anyway
+        const char* data = reinterpret_cast<const char*>(slot + 1);
+        size_t pointBytes = dataBytes(numberOfPoints, sizeof(Vector3D));
+        size_t triangleBytes
+            = dataBytes(numberOfTriangles, 3 * sizeof(uint32_t));
+        size_t gridBytes = sizeof(double);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            gridBytes = (gridBytes == 0) ? 0
+                : dataBytes(dataSize[axis], gridBytes);
+        }
+        if (pointBytes > _slotCapacity
+            || triangleBytes > _slotCapacity - pointBytes
+            || gridBytes > _slotCapacity) {
+            return false;
+        }
+
+        result.type = static_cast<SharedFrameType>(type);
+        result.sequence = sequence;
+        result.slot = s;
+        result.slotVersion = version;
+        if (result.type == SharedFrameType::ScalarGrid) {
+            result.gridData = ConstArrayAccessor3<double>(
+                Size3(
+                    static_cast<size_t>(dataSize[0]),
+                    static_cast<size_t>(dataSize[1]),
+                    static_cast<size_t>(dataSize[2])),
+                reinterpret_cast<const double*>(data));
+        } else {
+            result.points = ConstArrayAccessor1<Vector3D>(
+                static_cast<size_t>(numberOfPoints),
+                reinterpret_cast<const Vector3D*>(data));
+            if (result.type == SharedFrameType::TriangleMesh) {
+                result.triangles
+                    = reinterpret_cast<const uint32_t*>(data + pointBytes);
+                result.numberOfTriangles
+                    = static_cast<size_t>(numberOfTriangles);
+            }
+        }
+
+        *view = result;
+        return true;
+    }
+
+    return false;
+}
+
+bool SharedFrameViewer::isValid(const SharedFrameView& view) const {
+    if (!_memory || view.slot >= _numberOfSlots) {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const SharedFrameSlotHeader* slot
+        = slotHeader(_memory->data(), _slotCapacity, view.slot);
+    return slot->version.load(std::memory_order_relaxed) == view.slotVersion;
+}
+
+template <typename Callback>
+bool SharedFrameViewer::readLatest(
+    SharedFrameType type,
+    const Callback& func) const {
+    for (size_t attempt = 0; attempt < kMaxNumberOfReadAttempts; ++attempt) {
+        SharedFrameView view;
+        if (!acquireLatest(&view) || view.type != type) {
+            return false;
+        }
+
+        // The copy is discarded if the publisher overwrote the slot meanwhile
+        if (!func(view)) {
+            return false;
+        }
+        if (isValid(view)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SharedFrameViewer::readParticles(Array1<Vector3D>* positions) const {
+    return readLatest(
+        SharedFrameType::Particles, [&](const SharedFrameView& view) {
+            positions->resize(view.points.size());
+            std::copy(
+                view.points.data(), view.points.data() + view.points.size(),
+                positions->data());
+            return true;
+        });
+}
+
+bool SharedFrameViewer::readScalarGrid(ScalarGrid3* grid) const {
+    return readLatest(
+        SharedFrameType::ScalarGrid, [&](const SharedFrameView& view) {
+            grid->resize(view.resolution, view.gridSpacing, view.origin);
+            if (grid->dataSize() != view.gridData.size()) {
+                return false;
+            }
+
+            Size3 size = view.gridData.size();
+            std::copy(
+                view.gridData.data(),
+                view.gridData.data() + size.x * size.y * size.z,
+                grid->dataAccessor().data());
+            return true;
+        });
+}
+
+bool SharedFrameViewer::readTriangleMesh(TriangleMesh3* mesh) const {
+    return readLatest(
+        SharedFrameType::TriangleMesh, [&](const SharedFrameView& view) {
+            mesh->clear();
+            for (size_t i = 0; i < view.points.size(); ++i) {
+                mesh->addPoint(view.points[i]);
+            }
+            for (size_t i = 0; i < view.numberOfTriangles; ++i) {
+                const uint32_t* t = view.triangles + 3 * i;
+                mesh->addPointTriangle(Point3UI(t[0], t[1], t[2]));
+            }
+            return true;
+        });
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_SHARED_MEMORY_H_
+#define SRC_JET_SHARED_MEMORY_H_
+
+#include <jet/macros.h>
+
+#ifndef JET_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <string>
+
+namespace jet {
+
+// Named shared memory that other processes can map. The creator owns the
+// name and removes it when destroyed, while the processes that opened it keep
+// their mappings until they are destroyed.
+class SharedMemory {
+ public:
+    // Creates the shared memory of \p size bytes, replacing any existing one
+    // of the same name, and maps it for reading and writing.
+    static SharedMemory* create(const std::string& name, size_t size) {
+        SharedMemory* memory = new SharedMemory(sharedMemoryName(name));
+        memory->_isOwner = true;
+#ifdef JET_WINDOWS
+        memory->_mapping = CreateFileMappingA(
+            INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+            static_cast<DWORD>(size & 0xffffffff), memory->_name.c_str());
+        if (memory->_mapping != nullptr) {
+            memory->_data = static_cast<char*>(
+                MapViewOfFile(memory->_mapping, FILE_MAP_WRITE, 0, 0, size));
+        }
+#else
+        shm_unlink(memory->_name.c_str());
+        memory->_fd = shm_open(
+            memory->_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (memory->_fd >= 0
+            && ftruncate(memory->_fd, static_cast<off_t>(size)) == 0) {
+            void* data = mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                memory->_fd, 0);
+            if (data != MAP_FAILED) {
+                memory->_data = static_cast<char*>(data);
+            }
+        }
+#endif
+        memory->_size = (memory->_data != nullptr) ? size : 0;
+        return memory;
+    }
+
+    // Opens the existing shared memory of \p name and maps it read-only.
+    static SharedMemory* open(const std::string& name) {
+        SharedMemory* memory = new SharedMemory(sharedMemoryName(name));
+#ifdef JET_WINDOWS
+        memory->_mapping = OpenFileMappingA(
+            FILE_MAP_READ, FALSE, memory->_name.c_str());
+        if (memory->_mapping != nullptr) {
+            memory->_data = static_cast<char*>(
+                MapViewOfFile(memory->_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        MEMORY_BASIC_INFORMATION info;
+        if (memory->_data != nullptr
+            && VirtualQuery(memory->_data, &info, sizeof(info)) != 0) {
+            memory->_size = info.RegionSize;
+        }
+#else
+        memory->_fd = shm_open(memory->_name.c_str(), O_RDONLY, 0);
+        struct stat st;
+        if (memory->_fd >= 0 && fstat(memory->_fd, &st) == 0
+            && st.st_size > 0) {
+            size_t size = static_cast<size_t>(st.st_size);
+            void* data = mmap(
+                nullptr, size, PROT_READ, MAP_SHARED, memory->_fd, 0);
+            if (data != MAP_FAILED) {
+                memory->_data = static_cast<char*>(data);
+                memory->_size = size;
+            }
+        }
+#endif
+        return memory;
+    }
+
+    ~SharedMemory() {
+#ifdef JET_WINDOWS
+        if (_data != nullptr) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping != nullptr) {
+            CloseHandle(_mapping);
+        }
+#else
+        if (_data != nullptr) {
+            munmap(_data, _size);
+        }
+        if (_fd >= 0) {
+            close(_fd);
+        }
+        if (_isOwner) {
+            shm_unlink(_name.c_str());
+        }
+#endif
+    }
+
+    JET_NON_COPYABLE(SharedMemory)
+
+    bool isValid() const {
+        return _data != nullptr;
+    }
+
+    char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+ private:
+    std::string _name;
+    char* _data = nullptr;
+    size_t _size = 0;
+    bool _isOwner = false;
+#ifdef JET_WINDOWS
+    HANDLE _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+
+    explicit SharedMemory(const std::string& name) : _name(name) {
+    }
+
+    // POSIX names start with a slash, and the Windows names are made local to
+    // the session
+    static std::string sharedMemoryName(const std::string& name) {
+#ifdef JET_WINDOWS
+        return "Local\\" + ((!name.empty() && name[0] == '/')
+            ? name.substr(1) : name);
+#else
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+#endif
+    }
+};
+
+}  // namespace jet
+
+#endif  // SRC_JET_SHARED_MEMORY_H_
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <simd_helpers.h>
+
+#include <atomic>
+
+#if defined(JET_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+using jet::SimdInstructionSet;
+
+#if defined(JET_SIMD_X86) && defined(_MSC_VER)
+
+bool isSupportedByCpu(SimdInstructionSet instructionSet) {
+    int info[4];
+    __cpuid(info, 1);
+    bool hasSse2 = (info[3] & (1 << 26)) != 0;
+    bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+    bool hasAvx = (info[2] & (1 << 28)) != 0;
+
+    // The OS must save the YMM (and ZMM) registers on context switches
+    unsigned long long xcr0 = hasOsxsave ? _xgetbv(0) : 0;
+
+    switch (instructionSet) {
+        case SimdInstructionSet::Sse2:
+            return hasSse2;
+        case SimdInstructionSet::Avx:
+            return hasAvx && (xcr0 & 0x6) == 0x6;
+        case SimdInstructionSet::Avx512:
+            __cpuidex(info, 7, 0);
+            return hasAvx && (info[1] & (1 << 16)) != 0
+                && (xcr0 & 0xe6) == 0xe6;
+        default:
+            return false;
+    }
+}
+
+#elif defined(JET_SIMD_X86)
+
+bool isSupportedByCpu(SimdInstructionSet instructionSet) {
+    __builtin_cpu_init();
+
+    switch (instructionSet) {
+        case SimdInstructionSet::Sse2:
+            return __builtin_cpu_supports("sse2");
+        case SimdInstructionSet::Avx:
+            return __builtin_cpu_supports("avx");
+        case SimdInstructionSet::Avx512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return false;
+    }
+}
+
+#else
+
+bool isSupportedByCpu(SimdInstructionSet instructionSet) {
+#if defined(JET_SIMD_NEON)
+    // NEON is mandatory on ARM64
+    return instructionSet == SimdInstructionSet::Neon;
+#else
+    UNUSED_VARIABLE(instructionSet);
+    return false;
+#endif
+}
+
+#endif
+
+SimdInstructionSet detectInstructionSet() {
+    const SimdInstructionSet widestFirst[] = {
+        SimdInstructionSet::Avx512,
+        SimdInstructionSet::Avx,
+        SimdInstructionSet::Neon,
+        SimdInstructionSet::Sse2
+    };
+    for (SimdInstructionSet instructionSet : widestFirst) {
+        if (isSupportedByCpu(instructionSet)) {
+            return instructionSet;
+        }
+    }
+    return SimdInstructionSet::None;
+}
+
+std::atomic<SimdInstructionSet> sInstructionSet(detectInstructionSet());
+
+}  // namespace
+
+namespace jet {
+
+SimdInstructionSet simdInstructionSet() {
+    return sInstructionSet.load(std::memory_order_relaxed);
+}
+
+void setSimdInstructionSet(SimdInstructionSet instructionSet) {
+    JET_THROW_INVALID_ARG_IF(!isSimdInstructionSetSupported(instructionSet));
+
+    sInstructionSet = instructionSet;
+}
+
+bool isSimdInstructionSetSupported(SimdInstructionSet instructionSet) {
+    return instructionSet == SimdInstructionSet::None
+        || isSupportedByCpu(instructionSet);
+}
+
+const char* simdInstructionSetName(SimdInstructionSet instructionSet) {
+    switch (instructionSet) {
+        case SimdInstructionSet::Sse2:
+            return "sse2";
+        case SimdInstructionSet::Neon:
+            return "neon";
+        case SimdInstructionSet::Avx:
+            return "avx";
+        case SimdInstructionSet::Avx512:
+            return "avx512";
+        default:
+            return "none";
+    }
+}
+
+}  // namespace jet
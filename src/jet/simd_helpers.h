@@ -0,0 +1,30 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_SIMD_HELPERS_H_
+#define SRC_JET_SIMD_HELPERS_H_
+
+#include <jet/simd.h>
+
+#if defined(__x86_64__) || defined(_M_X64) \
+    || defined(__i386__) || defined(_M_IX86)
+#define JET_SIMD_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define JET_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// The kernels of the instruction sets beyond the build flags are compiled with
+// the target attribute, and simdInstructionSet() tells which ones are safe to
+// call. MSVC allows all the intrinsics without the attribute.
+#if defined(JET_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define JET_TARGET_SSE2 __attribute__((target("sse2")))
+#define JET_TARGET_AVX __attribute__((target("avx")))
+#define JET_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define JET_TARGET_SSE2
+#define JET_TARGET_AVX
+#define JET_TARGET_AVX512
+#endif
+
+#endif  // SRC_JET_SIMD_HELPERS_H_
@@ -0,0 +1,51 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/slab_decomposition3.h>
+
+using namespace jet;
+
+SlabDecomposition3::SlabDecomposition3(
+    const Size3& globalSize,
+    const CommunicatorPtr& communicator) :
+    _globalSize(globalSize),
+    _communicator(communicator) {
+    JET_THROW_INVALID_ARG_IF(_communicator == nullptr);
+
+    const size_t numberOfRanks = static_cast<size_t>(_communicator->size());
+    const size_t rank = static_cast<size_t>(_communicator->rank());
+    JET_THROW_INVALID_ARG_IF(_globalSize.z < numberOfRanks);
+
+    _zBegin = rank * _globalSize.z / numberOfRanks;
+    _zEnd = (rank + 1) * _globalSize.z / numberOfRanks;
+}
+
+const Size3& SlabDecomposition3::globalSize() const {
+    return _globalSize;
+}
+
+Size3 SlabDecomposition3::localSize() const {
+    return Size3(_globalSize.x, _globalSize.y, _zEnd - _zBegin);
+}
+
+size_t SlabDecomposition3::zBegin() const {
+    return _zBegin;
+}
+
+size_t SlabDecomposition3::zEnd() const {
+    return _zEnd;
+}
+
+int SlabDecomposition3::previousRank() const {
+    int rank = _communicator->rank();
+    return (rank > 0) ? rank - 1 : kNoRank;
+}
+
+int SlabDecomposition3::nextRank() const {
+    int rank = _communicator->rank();
+    return (rank + 1 < _communicator->size()) ? rank + 1 : kNoRank;
+}
+
+const CommunicatorPtr& SlabDecomposition3::communicator() const {
+    return _communicator;
+}
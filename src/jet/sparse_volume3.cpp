@@ -0,0 +1,403 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <particle_cache_codec.h>
+#include <jet/parallel.h>
+#include <jet/sparse_volume3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const char kSparseVolumeTag[] = "JETSVOL1";
+const size_t kSparseVolumeTagLength = 8;
+const uint32_t kSparseVolumeHalfEncoding = 1;
+
+// Number of the tiles converted in parallel before they are written
+const size_t kSparseVolumeTileBatchSize = 256;
+
+struct SparseVolumeHeader {
+    char tag[kSparseVolumeTagLength];
+    uint32_t tileSize;
+    uint32_t encoding;
+    uint64_t resolution[3];
+    double gridSpacing[3];
+    double origin[3];
+    uint64_t dataSize[3];
+    uint64_t cropBegin[3];
+    uint64_t cropEnd[3];
+    uint64_t numberOfTiles;
+};
+
+static_assert(
+    sizeof(SparseVolumeHeader) == 168,
+    "Unexpected sparse volume header size");
+
+// Mitsuba 0.5 gridvolume header
+const size_t kMitsubaHeaderSize = 48;
+const int32_t kMitsubaFloat16Encoding = 2;
+
+struct IndexBox {
+    Size3 lower;
+    Size3 upper;
+};
+
+size_t ceilDiv(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+}  // namespace
+
+SparseVolumeWriter3::SparseVolumeWriter3(const ScalarGrid3& grid) :
+    _grid(grid) {
+}
+
+double SparseVolumeWriter3::threshold() const {
+    return _threshold;
+}
+
+void SparseVolumeWriter3::setThreshold(double newThreshold) {
+    _threshold = std::max(newThreshold, 0.0);
+}
+
+size_t SparseVolumeWriter3::tileSize() const {
+    return _tileSize;
+}
+
+void SparseVolumeWriter3::setTileSize(size_t newTileSize) {
+    _tileSize = std::max(newTileSize, kOneSize);
+}
+
+void SparseVolumeWriter3::setFilter(const Filter& newFilter) {
+    _filter = newFilter;
+}
+
+void SparseVolumeWriter3::update() {
+    const Size3 ds = _grid.dataSize();
+
+    // Bounding box of the non-empty values, reduced over the z-slices
+    IndexBox empty;
+    empty.lower = Size3(kMaxSize, kMaxSize, kMaxSize);
+    empty.upper = Size3();
+    IndexBox box = parallelReduce(
+        kZeroSize,
+        ds.z,
+        empty,
+        [&](size_t kBegin, size_t kEnd, IndexBox partial) {
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = 0; j < ds.y; ++j) {
+                    for (size_t i = 0; i < ds.x; ++i) {
+                        if (std::fabs(valueAt(i, j, k)) > _threshold) {
+                            partial.lower.x = std::min(partial.lower.x, i);
+                            partial.lower.y = std::min(partial.lower.y, j);
+                            partial.lower.z = std::min(partial.lower.z, k);
+                            partial.upper.x = std::max(partial.upper.x, i + 1);
+                            partial.upper.y = std::max(partial.upper.y, j + 1);
+                            partial.upper.z = std::max(partial.upper.z, k + 1);
+                        }
+                    }
+                }
+            }
+            return partial;
+        },
+        [](const IndexBox& a, const IndexBox& b) {
+            IndexBox c;
+            c.lower = Size3(
+                std::min(a.lower.x, b.lower.x),
+                std::min(a.lower.y, b.lower.y),
+                std::min(a.lower.z, b.lower.z));
+            c.upper = Size3(
+                std::max(a.upper.x, b.upper.x),
+                std::max(a.upper.y, b.upper.y),
+                std::max(a.upper.z, b.upper.z));
+            return c;
+        });
+
+    if (box.upper.x == 0) {
+        _cropBegin = _cropEnd = _numberOfTiles = Size3();
+        _isTileActive.clear();
+        return;
+    }
+
+    _cropBegin = box.lower;
+    _cropEnd = box.upper;
+    _numberOfTiles = Size3(
+        ceilDiv(_cropEnd.x - _cropBegin.x, _tileSize),
+        ceilDiv(_cropEnd.y - _cropBegin.y, _tileSize),
+        ceilDiv(_cropEnd.z - _cropBegin.z, _tileSize));
+
+    const size_t n = _numberOfTiles.x * _numberOfTiles.y * _numberOfTiles.z;
+    _isTileActive.assign(n, 0);
+    parallelFor(kZeroSize, n, [&](size_t t) {
+        const size_t ti = t % _numberOfTiles.x;
+        const size_t tj = (t / _numberOfTiles.x) % _numberOfTiles.y;
+        const size_t tk = t / (_numberOfTiles.x * _numberOfTiles.y);
+        const size_t i0 = _cropBegin.x + ti * _tileSize;
+        const size_t j0 = _cropBegin.y + tj * _tileSize;
+        const size_t k0 = _cropBegin.z + tk * _tileSize;
+        const size_t i1 = std::min(i0 + _tileSize, _cropEnd.x);
+        const size_t j1 = std::min(j0 + _tileSize, _cropEnd.y);
+        const size_t k1 = std::min(k0 + _tileSize, _cropEnd.z);
+
+        for (size_t k = k0; k < k1; ++k) {
+            for (size_t j = j0; j < j1; ++j) {
+                for (size_t i = i0; i < i1; ++i) {
+                    if (std::fabs(valueAt(i, j, k)) > _threshold) {
+                        _isTileActive[t] = 1;
+                        return;
+                    }
+                }
+            }
+        }
+    });
+}
+
+Size3 SparseVolumeWriter3::cropBegin() const {
+    return _cropBegin;
+}
+
+Size3 SparseVolumeWriter3::cropEnd() const {
+    return _cropEnd;
+}
+
+size_t SparseVolumeWriter3::numberOfActiveTiles() const {
+    return static_cast<size_t>(
+        std::count(_isTileActive.begin(), _isTileActive.end(), 1));
+}
+
+void SparseVolumeWriter3::writeSparse(std::ostream* strm) {
+    update();
+
+    std::vector<size_t> activeTiles;
+    for (size_t t = 0; t < _isTileActive.size(); ++t) {
+        if (_isTileActive[t]) {
+            activeTiles.push_back(t);
+        }
+    }
+
+    SparseVolumeHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.tag, kSparseVolumeTag, kSparseVolumeTagLength);
+    header.tileSize = static_cast<uint32_t>(_tileSize);
+    header.encoding = kSparseVolumeHalfEncoding;
+    const Size3 resolution = _grid.resolution();
+    const Size3 ds = _grid.dataSize();
+    for (size_t c = 0; c < 3; ++c) {
+        header.resolution[c] = resolution[c];
+        header.gridSpacing[c] = _grid.gridSpacing()[c];
+        header.origin[c] = _grid.origin()[c];
+        header.dataSize[c] = ds[c];
+        header.cropBegin[c] = _cropBegin[c];
+        header.cropEnd[c] = _cropEnd[c];
+    }
+    header.numberOfTiles = activeTiles.size();
+    strm->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Each record is the tile index followed by a full tile of values, of
+    // which only the part in the crop box is written
+    const size_t tileVolume = _tileSize * _tileSize * _tileSize;
+    const size_t recordSize = 6 + tileVolume;
+    std::vector<uint16_t> records;
+    std::vector<size_t> recordLengths;
+    for (size_t batchBegin = 0; batchBegin < activeTiles.size();
+         batchBegin += kSparseVolumeTileBatchSize) {
+        const size_t batchEnd = std::min(
+            batchBegin + kSparseVolumeTileBatchSize, activeTiles.size());
+        records.resize((batchEnd - batchBegin) * recordSize);
+        recordLengths.resize(batchEnd - batchBegin);
+
+        parallelFor(batchBegin, batchEnd, [&](size_t a) {
+            const size_t t = activeTiles[a];
+            const uint32_t index[3] = {
+                static_cast<uint32_t>(t % _numberOfTiles.x),
+                static_cast<uint32_t>(
+                    (t / _numberOfTiles.x) % _numberOfTiles.y),
+                static_cast<uint32_t>(
+                    t / (_numberOfTiles.x * _numberOfTiles.y))
+            };
+
+            uint16_t* record = records.data() + (a - batchBegin) * recordSize;
+            std::memcpy(record, index, sizeof(index));
+
+            const size_t i0 = _cropBegin.x + index[0] * _tileSize;
+            const size_t j0 = _cropBegin.y + index[1] * _tileSize;
+            const size_t k0 = _cropBegin.z + index[2] * _tileSize;
+            const size_t i1 = std::min(i0 + _tileSize, _cropEnd.x);
+            const size_t j1 = std::min(j0 + _tileSize, _cropEnd.y);
+            const size_t k1 = std::min(k0 + _tileSize, _cropEnd.z);
+
+            uint16_t* values = record + 6;
+            for (size_t k = k0; k < k1; ++k) {
+                for (size_t j = j0; j < j1; ++j) {
+                    for (size_t i = i0; i < i1; ++i) {
+                        *values++ = floatToHalf(valueAt(i, j, k));
+                    }
+                }
+            }
+            recordLengths[a - batchBegin] = values - record;
+        });
+
+        for (size_t r = 0; r < recordLengths.size(); ++r) {
+            strm->write(
+                reinterpret_cast<const char*>(records.data() + r * recordSize),
+                recordLengths[r] * sizeof(uint16_t));
+        }
+    }
+}
+
+void SparseVolumeWriter3::writeMitsuba(std::ostream* strm) {
+    update();
+
+    // Mitsuba places the values on the corners of the bounding box, so the
+    // box should span at least two data points per axis
+    const Size3 ds = _grid.dataSize();
+    Size3 begin = _cropBegin;
+    Size3 end = _cropEnd;
+    for (size_t c = 0; c < 3; ++c) {
+        if (end[c] <= begin[c]) {
+            begin[c] = 0;
+            end[c] = std::min(ds[c], kOneSize);
+        }
+        if (end[c] - begin[c] < 2) {
+            if (end[c] < ds[c]) {
+                ++end[c];
+            } else if (begin[c] > 0) {
+                --begin[c];
+            }
+        }
+    }
+
+    const Size3 size(end.x - begin.x, end.y - begin.y, end.z - begin.z);
+    const Vector3D h = _grid.gridSpacing();
+    const Vector3D lower = _grid.dataOrigin()
+        + h * Vector3D(begin.x, begin.y, begin.z);
+    const Vector3D upper = _grid.dataOrigin()
+        + h * Vector3D(std::max(end.x, kOneSize) - 1,
+                       std::max(end.y, kOneSize) - 1,
+                       std::max(end.z, kOneSize) - 1);
+
+    char header[kMitsubaHeaderSize] = { 'V', 'O', 'L', 3 };
+    int32_t encoding[5] = {
+        kMitsubaFloat16Encoding,
+        static_cast<int32_t>(size.x),
+        static_cast<int32_t>(size.y),
+        static_cast<int32_t>(size.z),
+        1  // number of channels
+    };
+    float bbox[6] = {
+        static_cast<float>(lower.x),
+        static_cast<float>(lower.y),
+        static_cast<float>(lower.z),
+        static_cast<float>(upper.x),
+        static_cast<float>(upper.y),
+        static_cast<float>(upper.z)
+    };
+    std::memcpy(header + 4, encoding, sizeof(encoding));
+    std::memcpy(header + 24, bbox, sizeof(bbox));
+    strm->write(header, kMitsubaHeaderSize);
+
+    std::vector<uint16_t> slice(size.x * size.y);
+    for (size_t k = begin.z; k < end.z; ++k) {
+        parallelFor(begin.y, end.y, [&](size_t j) {
+            uint16_t* row = slice.data() + (j - begin.y) * size.x;
+            for (size_t i = begin.x; i < end.x; ++i) {
+                row[i - begin.x] = floatToHalf(valueAt(i, j, k));
+            }
+        });
+        strm->write(
+            reinterpret_cast<const char*>(slice.data()),
+            slice.size() * sizeof(uint16_t));
+    }
+}
+
+float SparseVolumeWriter3::valueAt(size_t i, size_t j, size_t k) const {
+    double value = _grid(i, j, k);
+    if (_filter) {
+        value = _filter(i, j, k, value);
+    }
+    return static_cast<float>(value);
+}
+
+namespace jet {
+
+bool readSparseVolume(std::istream* strm, ScalarGrid3* grid) {
+    SparseVolumeHeader header;
+    strm->read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!(*strm)
+        || std::memcmp(header.tag, kSparseVolumeTag, kSparseVolumeTagLength)
+        || header.encoding != kSparseVolumeHalfEncoding
+        || header.tileSize == 0) {
+        return false;
+    }
+
+    grid->resize(
+        Size3(
+            static_cast<size_t>(header.resolution[0]),
+            static_cast<size_t>(header.resolution[1]),
+            static_cast<size_t>(header.resolution[2])),
+        Vector3D(
+            header.gridSpacing[0],
+            header.gridSpacing[1],
+            header.gridSpacing[2]),
+        Vector3D(header.origin[0], header.origin[1], header.origin[2]));
+
+    const Size3 ds = grid->dataSize();
+    Size3 cropBegin;
+    Size3 cropEnd;
+    for (size_t c = 0; c < 3; ++c) {
+        cropBegin[c] = static_cast<size_t>(header.cropBegin[c]);
+        cropEnd[c] = static_cast<size_t>(header.cropEnd[c]);
+        if (ds[c] != header.dataSize[c] || cropBegin[c] > cropEnd[c]
+            || cropEnd[c] > ds[c]) {
+            return false;
+        }
+    }
+    grid->fill(0.0);
+
+    const size_t tileSize = header.tileSize;
+    std::vector<uint16_t> values(tileSize * tileSize * tileSize);
+    for (uint64_t t = 0; t < header.numberOfTiles; ++t) {
+        uint32_t index[3];
+        strm->read(reinterpret_cast<char*>(index), sizeof(index));
+        if (!(*strm)) {
+            return false;
+        }
+
+        Size3 tileBegin;
+        Size3 tileEnd;
+        for (size_t c = 0; c < 3; ++c) {
+            tileBegin[c] = cropBegin[c] + index[c] * tileSize;
+            tileEnd[c] = std::min(tileBegin[c] + tileSize, cropEnd[c]);
+            if (tileBegin[c] >= cropEnd[c]) {
+                return false;
+            }
+        }
+
+        const size_t n = (tileEnd.x - tileBegin.x)
+            * (tileEnd.y - tileBegin.y) * (tileEnd.z - tileBegin.z);
+        strm->read(
+            reinterpret_cast<char*>(values.data()), n * sizeof(uint16_t));
+        if (!(*strm)) {
+            return false;
+        }
+
+        const uint16_t* value = values.data();
+        for (size_t k = tileBegin.z; k < tileEnd.z; ++k) {
+            for (size_t j = tileBegin.y; j < tileEnd.y; ++j) {
+                for (size_t i = tileBegin.x; i < tileEnd.x; ++i) {
+                    (*grid)(i, j, k) = halfToFloat(*value++);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+}  // namespace jet
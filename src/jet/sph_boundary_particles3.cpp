@@ -0,0 +1,162 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/grid_point_generator3.h>
+#include <jet/parallel.h>
+#include <jet/point_hash_grid_searcher3.h>
+#include <jet/point_hash_grid_utils.h>
+#include <jet/sph_boundary_particles3.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace jet;
+
+static const size_t kDefaultHashGridResolution = 64;
+
+SphBoundaryParticles3::SphBoundaryParticles3() {
+}
+
+void SphBoundaryParticles3::build(
+    const Surface3& surface,
+    const BoundingBox3D& domain,
+    double spacing,
+    double kernelRadius) {
+    JET_THROW_INVALID_ARG_IF(!(spacing > 0.0));
+
+    // Clips the bounding box of the surface, which can be infinite, to the
+    // domain
+    BoundingBox3D surfaceBox = surface.boundingBox();
+    surfaceBox.expand(spacing);
+    BoundingBox3D box;
+    for (int axis = 0; axis < 3; ++axis) {
+        box.lowerCorner[axis] = std::max(
+            surfaceBox.lowerCorner[axis], domain.lowerCorner[axis]);
+        box.upperCorner[axis] = std::min(
+            surfaceBox.upperCorner[axis], domain.upperCorner[axis]);
+    }
+
+    Array1<Vector3D> candidates;
+    if (box.lowerCorner.x <= box.upperCorner.x
+        && box.lowerCorner.y <= box.upperCorner.y
+        && box.lowerCorner.z <= box.upperCorner.z) {
+        GridPointGenerator3().generate(box, spacing, &candidates);
+    }
+
+    // Projects the grid points near the surface in parallel
+    std::vector<char> isNear(candidates.size());
+    parallelFor(kZeroSize, candidates.size(), [&](size_t i) {
+        isNear[i] = surface.closestDistance(candidates[i]) < spacing;
+        if (isNear[i]) {
+            candidates[i] = surface.closestPoint(candidates[i]);
+        }
+    });
+
+    // Drops the projected points that crowd the previous ones, in order so
+    // that the result does not depend on the threads
+    Array1<Vector3D> points;
+    PointHashGridSearcher3 searcher(
+        Size3(
+            kDefaultHashGridResolution,
+            kDefaultHashGridResolution,
+            kDefaultHashGridResolution),
+        spacing);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (isNear[i]
+            && domain.contains(candidates[i])
+            && !searcher.hasNearbyPoint(candidates[i], 0.5 * spacing)) {
+            points.append(candidates[i]);
+            searcher.add(candidates[i]);
+        }
+    }
+
+    build(points.constAccessor(), kernelRadius);
+}
+
+void SphBoundaryParticles3::build(
+    const ConstArrayAccessor1<Vector3D>& points,
+    double kernelRadius) {
+    JET_THROW_INVALID_ARG_IF(!(kernelRadius > 0.0));
+
+    _kernelRadius = kernelRadius;
+    _stdKernel = SphStdKernel3(kernelRadius);
+    _spikyKernel = SphSpikyKernel3(kernelRadius);
+
+    _positions.resize(points.size());
+    _volumes.resize(points.size());
+    parallelFor(kZeroSize, points.size(), [&](size_t i) {
+        _positions[i] = points[i];
+    });
+
+    if (points.size() == 0) {
+        _searcher.reset();
+        return;
+    }
+
+    _searcher.reset(new PointParallelHashGridSearcher3(
+        suggestedHashGridResolution3(points, 2.0 * kernelRadius),
+        2.0 * kernelRadius));
+    _searcher->build(points);
+
+    parallelFor(kZeroSize, points.size(), [&](size_t b) {
+        double sum = 0.0;
+        _searcher->forEachNearbyPoint(
+            _positions[b],
+            _kernelRadius,
+            [&](size_t, const Vector3D& neighborPosition) {
+                sum += _stdKernel.valueFromSquaredDistance(
+                    neighborPosition.distanceSquaredTo(_positions[b]));
+            });
+        _volumes[b] = 1.0 / sum;
+    });
+}
+
+size_t SphBoundaryParticles3::numberOfParticles() const {
+    return _positions.size();
+}
+
+double SphBoundaryParticles3::kernelRadius() const {
+    return _kernelRadius;
+}
+
+ConstArrayAccessor1<Vector3D> SphBoundaryParticles3::positions() const {
+    return _positions.constAccessor();
+}
+
+ConstArrayAccessor1<double> SphBoundaryParticles3::volumes() const {
+    return _volumes.constAccessor();
+}
+
+double SphBoundaryParticles3::sumOfKernelNearby(
+    const Vector3D& origin) const {
+    double sum = 0.0;
+    if (_searcher != nullptr) {
+        _searcher->forEachNearbyPoint(
+            origin,
+            _kernelRadius,
+            [&](size_t b, const Vector3D& neighborPosition) {
+                sum += _volumes[b] * _stdKernel.valueFromSquaredDistance(
+                    neighborPosition.distanceSquaredTo(origin));
+            });
+    }
+    return sum;
+}
+
+Vector3D SphBoundaryParticles3::sumOfGradientNearby(
+    const Vector3D& origin) const {
+    Vector3D sum;
+    if (_searcher != nullptr) {
+        _searcher->forEachNearbyPoint(
+            origin,
+            _kernelRadius,
+            [&](size_t b, const Vector3D& neighborPosition) {
+                Vector3D offset = origin - neighborPosition;
+                double distance = offset.length();
+                if (distance > 0.0) {
+                    sum += _volumes[b]
+                        * _spikyKernel.gradient(distance, -offset / distance);
+                }
+            });
+    }
+    return sum;
+}
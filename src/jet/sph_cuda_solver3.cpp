@@ -0,0 +1,200 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/point_hash_grid_utils.h>
+#include <jet/profiler.h>
+#include <jet/sph_cuda_solver3.h>
+#include <cuda_sph_helpers.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace jet;
+
+#ifndef JET_USE_CUDA
+
+namespace jet {
+
+namespace internal {
+
+void CudaSphStateDeleter::operator()(CudaSphState*) const {
+}
+
+CudaSphState* createCudaSphState() {
+    return nullptr;
+}
+
+void buildCudaSphNeighborGrid(
+    CudaSphState*,
+    const ConstArrayAccessor1<Vector3D>&,
+    const ConstArrayAccessor1<Vector3D>&,
+    double,
+    const Size3&) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void updateCudaSphDensities(
+    CudaSphState*,
+    const CudaSphParameters&,
+    ArrayAccessor1<double>) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void accumulateCudaSphViscosityForce(
+    CudaSphState*,
+    const CudaSphParameters&,
+    ArrayAccessor1<Vector3D>) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void accumulateCudaSphPressureForce(
+    CudaSphState*,
+    const CudaSphParameters&,
+    ArrayAccessor1<double>,
+    ArrayAccessor1<Vector3D>) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+void computeCudaSphPseudoViscosity(
+    CudaSphState*,
+    const CudaSphParameters&,
+    double,
+    ArrayAccessor1<Vector3D>) {
+    throw std::runtime_error("Jet is built without CUDA.");
+}
+
+size_t cudaSphNumberOfNeighbors(const CudaSphState*) {
+    return 0;
+}
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif
+
+namespace {
+
+internal::CudaSphParameters deviceParameters(const SphCudaSolver3& solver) {
+    auto particles = solver.sphSystemData();
+
+    internal::CudaSphParameters params;
+    params.kernelRadius = particles->kernelRadius();
+    params.mass = particles->mass();
+    params.targetDensity = particles->targetDensity();
+    params.eosScale = particles->targetDensity()
+        * square(solver.speedOfSound()) / solver.eosExponent();
+    params.eosExponent = solver.eosExponent();
+    params.negativePressureScale = solver.negativePressureScale();
+    params.viscosityCoefficient = solver.viscosityCoefficient();
+    return params;
+}
+
+void buildNeighborGrid(
+    internal::CudaSphState* state,
+    const SphSystemData3& particles) {
+    const double kernelRadius = particles.kernelRadius();
+    const Size3 resolution = suggestedHashGridResolution3(
+        particles.positions(), 2.0 * kernelRadius);
+
+    internal::buildCudaSphNeighborGrid(
+        state,
+        particles.positions(),
+        particles.velocities(),
+        kernelRadius,
+        resolution);
+}
+
+}  // namespace
+
+SphCudaSolver3::SphCudaSolver3() {
+    if (internal::isCudaDeviceAvailable()) {
+        _device.reset(internal::createCudaSphState());
+    }
+}
+
+SphCudaSolver3::~SphCudaSolver3() {
+}
+
+bool SphCudaSolver3::isUsingDevice() const {
+    return static_cast<bool>(_device);
+}
+
+bool SphCudaSolver3::isDeviceAvailable() {
+    return internal::isCudaDeviceAvailable();
+}
+
+void SphCudaSolver3::collectStatistics(SubTimeStepStatistics* stats) const {
+    SphSolver3::collectStatistics(stats);
+
+    if (_device) {
+        stats->numberOfNeighbors
+            = internal::cudaSphNumberOfNeighbors(_device.get());
+    }
+}
+
+void SphCudaSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
+    if (!_device) {
+        SphSolver3::onBeginAdvanceTimeStep(timeStepInSeconds);
+        return;
+    }
+
+    auto particles = sphSystemData();
+
+    {
+        JET_PROFILE_SCOPE("buildNeighborSearcher");
+        buildNeighborGrid(_device.get(), *particles);
+    }
+
+    {
+        JET_PROFILE_SCOPE("updateDensities");
+        internal::updateCudaSphDensities(
+            _device.get(), deviceParameters(*this), particles->densities());
+    }
+}
+
+void SphCudaSolver3::accumulateNonPressureForces(double timeStepInSeconds) {
+    if (!_device) {
+        SphSolver3::accumulateNonPressureForces(timeStepInSeconds);
+        return;
+    }
+
+    ParticleSystemSolver3::accumulateForces(timeStepInSeconds);
+    internal::accumulateCudaSphViscosityForce(
+        _device.get(), deviceParameters(*this), sphSystemData()->forces());
+}
+
+void SphCudaSolver3::accumulatePressureForce(double timeStepInSeconds) {
+    if (!_device) {
+        SphSolver3::accumulatePressureForce(timeStepInSeconds);
+        return;
+    }
+
+    auto particles = sphSystemData();
+    internal::accumulateCudaSphPressureForce(
+        _device.get(),
+        deviceParameters(*this),
+        particles->pressures(),
+        particles->forces());
+}
+
+void SphCudaSolver3::computePseudoViscosity(double timeStepInSeconds) {
+    if (!_device) {
+        SphSolver3::computePseudoViscosity(timeStepInSeconds);
+        return;
+    }
+
+    auto particles = sphSystemData();
+
+    // The particles have moved since the beginning of the step
+    buildNeighborGrid(_device.get(), *particles);
+
+    double factor = timeStepInSeconds * pseudoViscosityCoefficient();
+    factor = clamp(factor, 0.0, 1.0);
+
+    internal::computeCudaSphPseudoViscosity(
+        _device.get(),
+        deviceParameters(*this),
+        factor,
+        particles->velocities());
+}
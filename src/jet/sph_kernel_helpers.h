@@ -0,0 +1,270 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_SPH_KERNEL_HELPERS_H_
+#define SRC_JET_SPH_KERNEL_HELPERS_H_
+
+#include <jet/array_accessor1.h>
+#include <jet/constants.h>
+#include <jet/sph_kernels3.h>
+#include <jet/vector3.h>
+#include <neighbor_search_helpers.h>
+
+#if defined(__AVX__)
+#define JET_SPH_KERNEL_USE_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JET_SPH_KERNEL_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace jet {
+
+const size_t kSphNeighborBatchSize = 64;
+
+// Neighbors of a particle gathered into structure-of-arrays buffers. The
+// offsets are measured from the particle to the neighbors, and the kernel
+// functions below fill the weights from the squared distances so that the
+// kernel is evaluated for several neighbors at once instead of one Vector3D
+// at a time.
+struct SphNeighborBatch3 {
+    size_t size = 0;
+    uint32_t index[kSphNeighborBatchSize];
+    double x[kSphNeighborBatchSize];
+    double y[kSphNeighborBatchSize];
+    double z[kSphNeighborBatchSize];
+    double distanceSquared[kSphNeighborBatchSize];
+    double weight[kSphNeighborBatchSize];
+
+    void add(size_t j, const Vector3D& offset) {
+        index[size] = static_cast<uint32_t>(j);
+        x[size] = offset.x;
+        y[size] = offset.y;
+        z[size] = offset.z;
+        distanceSquared[size] = offset.lengthSquared();
+        ++size;
+    }
+};
+
+// Computes SphStdKernel3 for n squared distances.
+inline void sphStdKernelWeights(
+    const SphStdKernel3& kernel,
+    const double* distanceSquared,
+    size_t n,
+    double* weights) {
+    const double factor = kernel.valueFactor;
+    const double invH2 = kernel.invH2;
+    size_t i = 0;
+#if defined(JET_SPH_KERNEL_USE_AVX)
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m256d r2 = _mm256_loadu_pd(distanceSquared + i);
+        __m256d t = _mm256_max_pd(
+            _mm256_sub_pd(one, _mm256_mul_pd(r2, _mm256_set1_pd(invH2))),
+            zero);
+        __m256d w = _mm256_mul_pd(
+            _mm256_mul_pd(_mm256_set1_pd(factor), t), _mm256_mul_pd(t, t));
+        _mm256_storeu_pd(weights + i, w);
+    }
+#elif defined(JET_SPH_KERNEL_USE_SSE2)
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d r2 = _mm_loadu_pd(distanceSquared + i);
+        __m128d t = _mm_max_pd(
+            _mm_sub_pd(one, _mm_mul_pd(r2, _mm_set1_pd(invH2))), zero);
+        __m128d w = _mm_mul_pd(
+            _mm_mul_pd(_mm_set1_pd(factor), t), _mm_mul_pd(t, t));
+        _mm_storeu_pd(weights + i, w);
+    }
+#endif
+    for (; i < n; ++i) {
+        double t = std::max(1.0 - distanceSquared[i] * invH2, 0.0);
+        weights[i] = factor * t * (t * t);
+    }
+}
+
+// Computes SphSpikyKernel3 for n squared distances.
+inline void sphSpikyKernelWeights(
+    const SphSpikyKernel3& kernel,
+    const double* distanceSquared,
+    size_t n,
+    double* weights) {
+    const double factor = kernel.valueFactor;
+    const double invH = kernel.invH;
+    size_t i = 0;
+#if defined(JET_SPH_KERNEL_USE_AVX)
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m256d r = _mm256_sqrt_pd(_mm256_loadu_pd(distanceSquared + i));
+        __m256d t = _mm256_max_pd(
+            _mm256_sub_pd(one, _mm256_mul_pd(r, _mm256_set1_pd(invH))),
+            zero);
+        __m256d w = _mm256_mul_pd(
+            _mm256_mul_pd(_mm256_set1_pd(factor), t), _mm256_mul_pd(t, t));
+        _mm256_storeu_pd(weights + i, w);
+    }
+#elif defined(JET_SPH_KERNEL_USE_SSE2)
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d r = _mm_sqrt_pd(_mm_loadu_pd(distanceSquared + i));
+        __m128d t = _mm_max_pd(
+            _mm_sub_pd(one, _mm_mul_pd(r, _mm_set1_pd(invH))), zero);
+        __m128d w = _mm_mul_pd(
+            _mm_mul_pd(_mm_set1_pd(factor), t), _mm_mul_pd(t, t));
+        _mm_storeu_pd(weights + i, w);
+    }
+#endif
+    for (; i < n; ++i) {
+        double t = std::max(1.0 - std::sqrt(distanceSquared[i]) * invH, 0.0);
+        weights[i] = factor * t * (t * t);
+    }
+}
+
+// Computes the SphSpikyKernel3 gradient scale for n squared distances, such
+// that the gradient toward a neighbor at the offset is scale * offset. The
+// scale is zero for the coincident points.
+inline void sphSpikyGradientScales(
+    const SphSpikyKernel3& kernel,
+    const double* distanceSquared,
+    size_t n,
+    double* scales) {
+    const double factor = kernel.firstDerivativeFactor;
+    const double invH = kernel.invH;
+    size_t i = 0;
+#if defined(JET_SPH_KERNEL_USE_AVX)
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m256d r2 = _mm256_loadu_pd(distanceSquared + i);
+        __m256d r = _mm256_sqrt_pd(r2);
+        __m256d t = _mm256_max_pd(
+            _mm256_sub_pd(one, _mm256_mul_pd(r, _mm256_set1_pd(invH))),
+            zero);
+        __m256d nonZero = _mm256_cmp_pd(r, zero, _CMP_GT_OQ);
+        __m256d s = _mm256_div_pd(
+            _mm256_mul_pd(_mm256_set1_pd(factor), _mm256_mul_pd(t, t)),
+            _mm256_blendv_pd(one, r, nonZero));
+        _mm256_storeu_pd(scales + i, _mm256_and_pd(s, nonZero));
+    }
+#elif defined(JET_SPH_KERNEL_USE_SSE2)
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d r2 = _mm_loadu_pd(distanceSquared + i);
+        __m128d r = _mm_sqrt_pd(r2);
+        __m128d t = _mm_max_pd(
+            _mm_sub_pd(one, _mm_mul_pd(r, _mm_set1_pd(invH))), zero);
+        __m128d nonZero = _mm_cmpgt_pd(r, zero);
+        __m128d safeR = _mm_or_pd(
+            _mm_and_pd(nonZero, r), _mm_andnot_pd(nonZero, one));
+        __m128d s = _mm_div_pd(
+            _mm_mul_pd(_mm_set1_pd(factor), _mm_mul_pd(t, t)), safeR);
+        _mm_storeu_pd(scales + i, _mm_and_pd(s, nonZero));
+    }
+#endif
+    for (; i < n; ++i) {
+        double r = std::sqrt(distanceSquared[i]);
+        double t = std::max(1.0 - r * invH, 0.0);
+        scales[i] = (r > 0.0) ? factor * (t * t) / r : 0.0;
+    }
+}
+
+// Computes the SphSpikyKernel3 second derivative for n squared distances.
+inline void sphSpikySecondDerivatives(
+    const SphSpikyKernel3& kernel,
+    const double* distanceSquared,
+    size_t n,
+    double* secondDerivatives) {
+    const double factor = kernel.secondDerivativeFactor;
+    const double invH = kernel.invH;
+    size_t i = 0;
+#if defined(JET_SPH_KERNEL_USE_AVX)
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m256d r = _mm256_sqrt_pd(_mm256_loadu_pd(distanceSquared + i));
+        __m256d t = _mm256_max_pd(
+            _mm256_sub_pd(one, _mm256_mul_pd(r, _mm256_set1_pd(invH))),
+            zero);
+        _mm256_storeu_pd(
+            secondDerivatives + i,
+            _mm256_mul_pd(_mm256_set1_pd(factor), t));
+    }
+#elif defined(JET_SPH_KERNEL_USE_SSE2)
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d r = _mm_sqrt_pd(_mm_loadu_pd(distanceSquared + i));
+        __m128d t = _mm_max_pd(
+            _mm_sub_pd(one, _mm_mul_pd(r, _mm_set1_pd(invH))), zero);
+        _mm_storeu_pd(
+            secondDerivatives + i, _mm_mul_pd(_mm_set1_pd(factor), t));
+    }
+#endif
+    for (; i < n; ++i) {
+        double t = std::max(1.0 - std::sqrt(distanceSquared[i]) * invH, 0.0);
+        secondDerivatives[i] = factor * t;
+    }
+}
+
+// Gathers the neighbors in the list into batches of offsets from origin and
+// calls callback(batch) for each batch.
+template <typename Callback>
+inline void forEachNeighborBatch(
+    const ConstArrayAccessor1<Vector3D>& positions,
+    const Vector3D& origin,
+    const ConstArrayAccessor1<uint32_t>& neighbors,
+    const Callback& callback) {
+    SphNeighborBatch3 batch;
+    for (size_t begin = 0; begin < neighbors.size();
+         begin += kSphNeighborBatchSize) {
+        size_t end = std::min(begin + kSphNeighborBatchSize, neighbors.size());
+        batch.size = 0;
+        for (size_t k = begin; k < end; ++k) {
+            size_t j = neighbors[k];
+            batch.add(j, positions[j] - origin);
+        }
+        callback(batch);
+    }
+}
+
+// Same as above, but the neighbors are searched within radius from origin.
+// Only the indices and the squared distances are gathered since the search
+// already dominates these loops.
+template <typename Callback>
+inline void forEachNearbyPointBatch(
+    const PointNeighborSearcher3& searcher,
+    const Vector3D& origin,
+    double radius,
+    const Callback& callback) {
+    SphNeighborBatch3 batch;
+    forEachNearbyPoint(
+        searcher,
+        origin,
+        radius,
+        [&] (size_t j, const Vector3D& neighborPosition) {
+            batch.index[batch.size] = static_cast<uint32_t>(j);
+            batch.distanceSquared[batch.size]
+                = neighborPosition.distanceSquaredTo(origin);
+            ++batch.size;
+            if (batch.size == kSphNeighborBatchSize) {
+                callback(batch);
+                batch.size = 0;
+            }
+        });
+    if (batch.size > 0) {
+        callback(batch);
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_SPH_KERNEL_HELPERS_H_
@@ -0,0 +1,243 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_SPH_PAIR_HELPERS_H_
+#define SRC_JET_SPH_PAIR_HELPERS_H_
+
+#include <jet/array1.h>
+#include <jet/array_accessor1.h>
+#include <jet/bounding_box3.h>
+#include <jet/memory_tracker.h>
+#include <jet/parallel.h>
+#include <jet/point_neighbor_lists.h>
+#include <sph_kernel_helpers.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace jet {
+
+// Half neighbor lists in which each pair of neighbors appears only once, so
+// that a pair term is evaluated once and applied to both particles. The
+// particles are binned into slabs along the longest axis of their bounds,
+// and a pair is owned by the particle in the lower slab, or by the lower
+// index within a slab. The slabs are wider than the search radius, so the
+// pairs of a particle only touch its own slab and the next one. Hence
+// forEachParticle can visit the even slabs in parallel followed by the odd
+// ones, and the callback can write to both particles of a pair without any
+// race.
+class SphHalfNeighborLists3 {
+ public:
+    // Offsets and kernel values of the pairs, in the order of the lists. The
+    // offsets are measured from the owner to the neighbor.
+    struct PairCache {
+        TrackedVector<double> x;
+        TrackedVector<double> y;
+        TrackedVector<double> z;
+        TrackedVector<double> stdWeights;
+        TrackedVector<double> spikyGradientScales;
+        TrackedVector<double> spikySecondDerivatives;
+    };
+
+    // Builds the half lists from the full neighbor lists that are searched
+    // within radius. The pair cache is cleared.
+    void build(
+        const ConstArrayAccessor1<Vector3D>& positions,
+        const PointNeighborLists& neighborLists,
+        double radius) {
+        size_t n = positions.size();
+        _hasPairCache = false;
+        BoundingBox3D bound = parallelReduce(
+            kZeroSize, n, BoundingBox3D(),
+            [&](size_t begin, size_t end, BoundingBox3D partial) {
+                for (size_t i = begin; i < end; ++i) {
+                    partial.merge(positions[i]);
+                }
+                return partial;
+            },
+            [](BoundingBox3D a, const BoundingBox3D& b) {
+                a.merge(b);
+                return a;
+            });
+
+        size_t axis = 0;
+        double extent = 0.0;
+        if (n > 0) {
+            Vector3D size = bound.upperCorner - bound.lowerCorner;
+            axis = (size.x >= size.y)
+                ? ((size.x >= size.z) ? 0 : 2)
+                : ((size.y >= size.z) ? 1 : 2);
+            extent = size[axis];
+        }
+
+        const double slabWidth = 1.001 * radius;
+        size_t numberOfSlabs = 1;
+        if (slabWidth > 0.0) {
+            numberOfSlabs += static_cast<size_t>(extent / slabWidth);
+        }
+
+        _slabs.resize(n);
+        _sortedSlabs.resize(n);
+        _particleIndices.resize(n);
+        parallelFor(kZeroSize, n, [&](size_t i) {
+            size_t slab = 0;
+            if (slabWidth > 0.0) {
+                slab = static_cast<size_t>(
+                    (positions[i][axis] - bound.lowerCorner[axis])
+                    / slabWidth);
+            }
+            _slabs[i] = std::min(slab, numberOfSlabs - 1);
+            _sortedSlabs[i] = _slabs[i];
+            _particleIndices[i] = i;
+        });
+
+        if (n > 0) {
+            parallelRadixSort(
+                _sortedSlabs.begin(),
+                _sortedSlabs.end(),
+                _particleIndices.begin(),
+                numberOfSlabs - 1);
+        }
+
+        _slabOffsets.resize(numberOfSlabs + 1);
+        for (size_t s = 0; s <= numberOfSlabs; ++s) {
+            _slabOffsets[s] = static_cast<size_t>(
+                std::lower_bound(_sortedSlabs.begin(), _sortedSlabs.end(), s)
+                - _sortedSlabs.begin());
+        }
+
+        _lists.build(
+            n,
+            [&](size_t i) {
+                size_t count = 0;
+                for (size_t j : neighborLists[i]) {
+                    if (isOwnedBy(i, j)) {
+                        ++count;
+                    }
+                }
+                return count;
+            },
+            [&](size_t i, uint32_t* neighbors) {
+                for (size_t j : neighborLists[i]) {
+                    if (isOwnedBy(i, j)) {
+                        JET_ASSERT(_slabs[j] <= _slabs[i] + 1);
+                        *(neighbors++) = static_cast<uint32_t>(j);
+                    }
+                }
+            });
+    }
+
+    // Returns the number of lists (which is the number of particles).
+    size_t size() const {
+        return _lists.size();
+    }
+
+    // Returns the neighbors of the i-th particle that it owns the pairs with.
+    ConstArrayAccessor1<uint32_t> operator[](size_t i) const {
+        return _lists[i];
+    }
+
+    // Returns the index of the first pair of the i-th particle in the pair
+    // cache. The pairs of the particle end at pairOffset(i + 1).
+    size_t pairOffset(size_t i) const {
+        return _lists.offsets()[i];
+    }
+
+    // Evaluates the offsets and the kernels of the pairs at the positions,
+    // which should be the ones the lists are built with. The passes of a
+    // time-step at the same positions can read them instead of gathering the
+    // neighbors and evaluating the kernels again. The kernels are evaluated
+    // on the whole lists, so they run at the full vector width.
+    void cachePairs(
+        const ConstArrayAccessor1<Vector3D>& positions,
+        double kernelRadius) {
+        size_t numberOfPairs = _lists.neighbors().size();
+        _pairCache.x.resize(numberOfPairs);
+        _pairCache.y.resize(numberOfPairs);
+        _pairCache.z.resize(numberOfPairs);
+        _pairCache.stdWeights.resize(numberOfPairs);
+        _pairCache.spikyGradientScales.resize(numberOfPairs);
+        _pairCache.spikySecondDerivatives.resize(numberOfPairs);
+
+        const SphStdKernel3 stdKernel(kernelRadius);
+        const SphSpikyKernel3 spikyKernel(kernelRadius);
+        parallelFor(kZeroSize, size(), [&](size_t i) {
+            double distanceSquared[kSphNeighborBatchSize];
+            const uint32_t* neighbors = _lists.neighbors().data();
+            size_t end = pairOffset(i + 1);
+            for (size_t begin = pairOffset(i); begin < end;
+                 begin += kSphNeighborBatchSize) {
+                size_t n = std::min(kSphNeighborBatchSize, end - begin);
+                for (size_t k = 0; k < n; ++k) {
+                    Vector3D offset
+                        = positions[neighbors[begin + k]] - positions[i];
+                    _pairCache.x[begin + k] = offset.x;
+                    _pairCache.y[begin + k] = offset.y;
+                    _pairCache.z[begin + k] = offset.z;
+                    distanceSquared[k] = offset.lengthSquared();
+                }
+                sphStdKernelWeights(
+                    stdKernel,
+                    distanceSquared,
+                    n,
+                    &_pairCache.stdWeights[begin]);
+                sphSpikyGradientScales(
+                    spikyKernel,
+                    distanceSquared,
+                    n,
+                    &_pairCache.spikyGradientScales[begin]);
+                sphSpikySecondDerivatives(
+                    spikyKernel,
+                    distanceSquared,
+                    n,
+                    &_pairCache.spikySecondDerivatives[begin]);
+            }
+        });
+        _hasPairCache = true;
+    }
+
+    // Marks the pair cache as stale while keeping its memory, which should
+    // be called when the particles move.
+    void clearPairCache() {
+        _hasPairCache = false;
+    }
+
+    // Returns the pair cache, or nullptr if it is not valid.
+    const PairCache* pairCache() const {
+        return _hasPairCache ? &_pairCache : nullptr;
+    }
+
+    // Calls func(i) for every particle, two colors of slabs one after the
+    // other, so that func can update i and its half neighbors.
+    template <typename Func>
+    void forEachParticle(const Func& func) const {
+        size_t numberOfSlabs = _slabOffsets.size() - 1;
+        for (size_t color = 0; color < 2; ++color) {
+            size_t numberOfSlabsOfColor = (numberOfSlabs + 1 - color) / 2;
+            parallelFor(kZeroSize, numberOfSlabsOfColor, [&](size_t bin) {
+                size_t s = 2 * bin + color;
+                for (size_t p = _slabOffsets[s]; p < _slabOffsets[s + 1];
+                     ++p) {
+                    func(_particleIndices[p]);
+                }
+            });
+        }
+    }
+
+ private:
+    PointNeighborLists _lists;
+    Array1<size_t> _slabs;
+    Array1<size_t> _sortedSlabs;
+    Array1<size_t> _particleIndices;
+    std::vector<size_t> _slabOffsets = std::vector<size_t>(1, 0);
+    PairCache _pairCache;
+    bool _hasPairCache = false;
+
+    bool isOwnedBy(size_t i, size_t j) const {
+        return _slabs[j] > _slabs[i] || (_slabs[j] == _slabs[i] && j > i);
+    }
+};
+
+}  // namespace jet
+
+#endif  // SRC_JET_SPH_PAIR_HELPERS_H_
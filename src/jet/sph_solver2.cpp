@@ -86,11 +86,19 @@ unsigned int SphSolver2::numberOfSubTimeSteps(
     const double kernelRadius = particles->kernelRadius();
     const double mass = particles->mass();
 
-    double maxForceMagnitude = 0.0;
-
-    for (size_t i = 0; i < numberOfParticles; ++i) {
-        maxForceMagnitude = std::max(maxForceMagnitude, f[i].length());
-    }
+    double maxForceMagnitude = parallelReduce(
+        kZeroSize,
+        numberOfParticles,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial = std::max(partial, f[i].length());
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 
     double timeStepLimitBySpeed
         = kTimeStepLimitBySpeedFactor * kernelRadius / _speedOfSound;
@@ -201,7 +209,7 @@ void SphSolver2::accumulatePressureForce(
         kZeroSize,
         numberOfParticles,
         [&](size_t i) {
-            const auto& neighbors = particles->neighborLists()[i];
+            const auto neighbors = particles->neighborLists()[i];
             for (size_t j : neighbors) {
                 double dist = positions[i].distanceTo(positions[j]);
 
@@ -232,7 +240,7 @@ void SphSolver2::accumulateViscosityForce() {
         kZeroSize,
         numberOfParticles,
         [&](size_t i) {
-            const auto& neighbors = particles->neighborLists()[i];
+            const auto neighbors = particles->neighborLists()[i];
             for (size_t j : neighbors) {
                 double dist = x[i].distanceTo(x[j]);
 
@@ -262,7 +270,7 @@ void SphSolver2::computePseudoViscosity(double timeStepInSeconds) {
             double weightSum = 0.0;
             Vector2D smoothedVelocity;
 
-            const auto& neighbors = particles->neighborLists()[i];
+            const auto neighbors = particles->neighborLists()[i];
             for (size_t j : neighbors) {
                 double dist = x[i].distanceTo(x[j]);
                 double wj = mass / d[j] * kernel(dist);
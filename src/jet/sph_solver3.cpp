@@ -5,7 +5,10 @@
 #include <jet/parallel.h>
 #include <jet/sph_kernels3.h>
 #include <jet/sph_solver3.h>
-#include <jet/timer.h>
+#include <jet/profiler.h>
+#include <serialization_helpers.h>
+#include <sph_kernel_helpers.h>
+#include <sph_pair_helpers.h>
 
 #include <algorithm>
 
@@ -73,10 +76,89 @@ void SphSolver3::setTimeStepLimitScale(double newScale) {
     _timeStepLimitScale = std::max(newScale, 0.0);
 }
 
+bool SphSolver3::isUsingSymmetricPairForces() const {
+    return _isUsingSymmetricPairForces;
+}
+
+void SphSolver3::setIsUsingSymmetricPairForces(bool isUsing) {
+    _isUsingSymmetricPairForces = isUsing;
+    if (!isUsing) {
+        _halfNeighborLists.reset();
+    }
+}
+
+bool SphSolver3::isCachingPairKernels() const {
+    return _isCachingPairKernels;
+}
+
+void SphSolver3::setIsCachingPairKernels(bool isCaching) {
+    _isCachingPairKernels = isCaching;
+    if (!isCaching && _halfNeighborLists != nullptr) {
+        _halfNeighborLists->clearPairCache();
+    }
+}
+
+const SphBoundaryParticles3Ptr& SphSolver3::boundaryParticles() const {
+    return _boundaryParticles;
+}
+
+void SphSolver3::setBoundaryParticles(
+    const SphBoundaryParticles3Ptr& newBoundary) {
+    _boundaryParticles = newBoundary;
+}
+
+double SphSolver3::previewScale() const {
+    return _previewScale;
+}
+
+void SphSolver3::setPreviewScale(double factor) {
+    JET_THROW_INVALID_ARG_IF(factor < 1.0);
+
+    auto particles = sphSystemData();
+    particles->setTargetSpacing(
+        particles->targetSpacing() * factor / _previewScale);
+    _previewScale = factor;
+
+    if (_boundaryParticles != nullptr) {
+        auto boundaryPositions = _boundaryParticles->positions();
+        Array1<Vector3D> positions(boundaryPositions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            positions[i] = boundaryPositions[i];
+        }
+        _boundaryParticles->build(
+            positions.constAccessor(), particles->kernelRadius());
+    }
+}
+
 SphSystemData3Ptr SphSolver3::sphSystemData() const {
     return std::dynamic_pointer_cast<SphSystemData3>(particleSystemData());
 }
 
+void SphSolver3::serialize(std::ostream* strm) const {
+    ParticleSystemSolver3::serialize(strm);
+
+    serializeSectionTag(strm, "SphSolver3");
+    serializeValue(strm, _eosExponent);
+    serializeValue(strm, _negativePressureScale);
+    serializeValue(strm, _viscosityCoefficient);
+    serializeValue(strm, _pseudoViscosityCoefficient);
+    serializeValue(strm, _speedOfSound);
+    serializeValue(strm, _timeStepLimitScale);
+}
+
+void SphSolver3::deserialize(std::istream* strm) {
+    ParticleSystemSolver3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "SphSolver3"));
+    deserializeValue(strm, &_eosExponent);
+    deserializeValue(strm, &_negativePressureScale);
+    deserializeValue(strm, &_viscosityCoefficient);
+    deserializeValue(strm, &_pseudoViscosityCoefficient);
+    deserializeValue(strm, &_speedOfSound);
+    deserializeValue(strm, &_timeStepLimitScale);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+}
+
 unsigned int SphSolver3::numberOfSubTimeSteps(
     double timeIntervalInSeconds) const {
     auto particles = sphSystemData();
@@ -86,11 +168,19 @@ unsigned int SphSolver3::numberOfSubTimeSteps(
     const double kernelRadius = particles->kernelRadius();
     const double mass = particles->mass();
 
-    double maxForceMagnitude = 0.0;
-
-    for (size_t i = 0; i < numberOfParticles; ++i) {
-        maxForceMagnitude = std::max(maxForceMagnitude, f[i].length());
-    }
+    double maxForceMagnitude = parallelReduce(
+        kZeroSize,
+        numberOfParticles,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial = std::max(partial, f[i].length());
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 
     double timeStepLimitBySpeed
         = kTimeStepLimitBySpeedFactor * kernelRadius / _speedOfSound;
@@ -107,8 +197,19 @@ unsigned int SphSolver3::numberOfSubTimeSteps(
 }
 
 void SphSolver3::accumulateForces(double timeStepInSeconds) {
-    accumulateNonPressureForces(timeStepInSeconds);
-    accumulatePressureForce(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("accumulateNonPressureForces");
+        accumulateNonPressureForces(timeStepInSeconds);
+    }
+
+    {
+        JET_PROFILE_SCOPE("accumulatePressureForce");
+        accumulatePressureForce(timeStepInSeconds);
+    }
+}
+
+bool SphSolver3::hasCustomForces() const {
+    return true;
 }
 
 void SphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
@@ -116,27 +217,72 @@ void SphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
 
     auto particles = sphSystemData();
 
-    Timer timer;
-    particles->buildNeighborSearcher();
-    particles->buildNeighborLists();
-    particles->updateDensities();
+    {
+        JET_PROFILE_SCOPE("buildNeighborSearcher");
+        particles->buildNeighborSearcher();
+    }
+
+    {
+        JET_PROFILE_SCOPE("buildNeighborLists");
+        particles->buildNeighborLists();
+        if (_isUsingSymmetricPairForces) {
+            if (_halfNeighborLists == nullptr) {
+                _halfNeighborLists.reset(new SphHalfNeighborLists3());
+            }
+            // Kept lists can have neighbors up to twice the skin farther away
+            _halfNeighborLists->build(
+                particles->positions(),
+                particles->neighborLists(),
+                particles->kernelRadius()
+                    + 2.0 * particles->neighborSearchSkin());
+            if (_isCachingPairKernels) {
+                _halfNeighborLists->cachePairs(
+                    particles->positions(), particles->kernelRadius());
+            }
+        }
+    }
 
-    JET_INFO << "Building neighbor lists and updating densities took "
-             << timer.durationInSeconds()
-             << " seconds";
+    {
+        JET_PROFILE_SCOPE("updateDensities");
+        if (halfNeighborLists() != nullptr
+            && halfNeighborLists()->pairCache() != nullptr) {
+            updateDensitiesFromPairCache();
+        } else {
+            particles->updateDensities();
+        }
+        accumulateBoundaryDensities(
+            particles->positions(), particles->densities());
+    }
 }
 
 void SphSolver3::onEndAdvanceTimeStep(double timeStepInSeconds) {
-    computePseudoViscosity(timeStepInSeconds);
+    // The particles have moved
+    if (_halfNeighborLists != nullptr) {
+        _halfNeighborLists->clearPairCache();
+    }
+
+    {
+        JET_PROFILE_SCOPE("computePseudoViscosity");
+        computePseudoViscosity(timeStepInSeconds);
+    }
 
     auto particles = sphSystemData();
     size_t numberOfParticles = particles->numberOfParticles();
     auto densities = particles->densities();
 
-    double maxDensity = 0.0;
-    for (size_t i = 0; i < numberOfParticles; ++i) {
-        maxDensity = std::max(maxDensity, densities[i]);
-    }
+    double maxDensity = parallelReduce(
+        kZeroSize,
+        numberOfParticles,
+        0.0,
+        [&](size_t begin, size_t end, double partial) {
+            for (size_t i = begin; i < end; ++i) {
+                partial = std::max(partial, densities[i]);
+            }
+            return partial;
+        },
+        [](double a, double b) {
+            return std::max(a, b);
+        });
 
     JET_INFO << "Max density: " << maxDensity << " "
              << "Max density / target density ratio: "
@@ -197,22 +343,93 @@ void SphSolver3::accumulatePressureForce(
     const double massSquared = square(particles->mass());
     const SphSpikyKernel3 kernel(particles->kernelRadius());
 
+    accumulateBoundaryPressureForce(
+        positions, densities, pressures, pressureForces);
+
+    const auto halfLists = halfNeighborLists();
+    const auto pairCache
+        = (halfLists != nullptr
+           && positions.data() == particles->positions().data())
+        ? halfLists->pairCache() : nullptr;
+    if (pairCache != nullptr) {
+        halfLists->forEachParticle([&](size_t i) {
+            const double pi = pressures[i] / square(densities[i]);
+            const auto neighbors = (*halfLists)[i];
+            const size_t offset = halfLists->pairOffset(i);
+            Vector3D force;
+            for (size_t k = 0; k < neighbors.size(); ++k) {
+                size_t j = neighbors[k];
+                size_t pair = offset + k;
+                double scale = massSquared
+                    * (pi + pressures[j] / square(densities[j]))
+                    * pairCache->spikyGradientScales[pair];
+                Vector3D pairForce = scale * Vector3D(
+                    pairCache->x[pair], pairCache->y[pair], pairCache->z[pair]);
+                force += pairForce;
+                pressureForces[j] += pairForce;
+            }
+            pressureForces[i] -= force;
+        });
+        return;
+    }
+
+    if (halfLists != nullptr) {
+        halfLists->forEachParticle([&](size_t i) {
+            const double pi = pressures[i] / square(densities[i]);
+            forEachNeighborBatch(
+                positions,
+                positions[i],
+                (*halfLists)[i],
+                [&] (SphNeighborBatch3& batch) {
+                    sphSpikyGradientScales(
+                        kernel,
+                        batch.distanceSquared,
+                        batch.size,
+                        batch.weight);
+                    Vector3D force;
+                    for (size_t k = 0; k < batch.size; ++k) {
+                        size_t j = batch.index[k];
+                        double scale = massSquared
+                            * (pi + pressures[j] / square(densities[j]))
+                            * batch.weight[k];
+                        Vector3D pairForce = scale
+                            * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+                        force += pairForce;
+                        pressureForces[j] += pairForce;
+                    }
+                    pressureForces[i] -= force;
+                });
+        });
+        return;
+    }
+
     parallelFor(
         kZeroSize,
         numberOfParticles,
         [&](size_t i) {
-            const auto& neighbors = particles->neighborLists()[i];
-            for (size_t j : neighbors) {
-                double dist = positions[i].distanceTo(positions[j]);
-
-                if (dist > 0.0) {
-                    Vector3D dir = (positions[j] - positions[i]) / dist;
-                    pressureForces[i] -= massSquared
-                        * (pressures[i] / (densities[i] * densities[i])
-                            + pressures[j] / (densities[j] * densities[j]))
-                        * kernel.gradient(dist, dir);
-                }
-            }
+            const auto neighbors = particles->neighborLists()[i];
+            const double pi = pressures[i] / square(densities[i]);
+            forEachNeighborBatch(
+                positions,
+                positions[i],
+                neighbors,
+                [&] (SphNeighborBatch3& batch) {
+                    sphSpikyGradientScales(
+                        kernel,
+                        batch.distanceSquared,
+                        batch.size,
+                        batch.weight);
+                    Vector3D force;
+                    for (size_t k = 0; k < batch.size; ++k) {
+                        size_t j = batch.index[k];
+                        double scale = massSquared
+                            * (pi + pressures[j] / square(densities[j]))
+                            * batch.weight[k];
+                        force += scale
+                            * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+                    }
+                    pressureForces[i] -= force;
+                });
         });
 }
 
@@ -228,21 +445,153 @@ void SphSolver3::accumulateViscosityForce() {
     const double massSquared = square(particles->mass());
     const SphSpikyKernel3 kernel(particles->kernelRadius());
 
+    const auto halfLists = halfNeighborLists();
+    const auto pairCache
+        = (halfLists != nullptr) ? halfLists->pairCache() : nullptr;
+    if (pairCache != nullptr) {
+        const double scale = viscosityCoefficient() * massSquared;
+        halfLists->forEachParticle([&](size_t i) {
+            const auto neighbors = (*halfLists)[i];
+            const size_t offset = halfLists->pairOffset(i);
+            for (size_t k = 0; k < neighbors.size(); ++k) {
+                size_t j = neighbors[k];
+                Vector3D dv = scale
+                    * pairCache->spikySecondDerivatives[offset + k]
+                    * (v[j] - v[i]);
+                f[i] += dv / d[j];
+                f[j] -= dv / d[i];
+            }
+        });
+        return;
+    }
+
+    if (halfLists != nullptr) {
+        const double scale = viscosityCoefficient() * massSquared;
+        halfLists->forEachParticle([&](size_t i) {
+            forEachNeighborBatch(
+                x,
+                x[i],
+                (*halfLists)[i],
+                [&] (SphNeighborBatch3& batch) {
+                    sphSpikySecondDerivatives(
+                        kernel,
+                        batch.distanceSquared,
+                        batch.size,
+                        batch.weight);
+                    for (size_t k = 0; k < batch.size; ++k) {
+                        size_t j = batch.index[k];
+                        Vector3D dv = scale * batch.weight[k] * (v[j] - v[i]);
+                        f[i] += dv / d[j];
+                        f[j] -= dv / d[i];
+                    }
+                });
+        });
+        return;
+    }
+
     parallelFor(
         kZeroSize,
         numberOfParticles,
         [&](size_t i) {
-            const auto& neighbors = particles->neighborLists()[i];
-            for (size_t j : neighbors) {
-                double dist = x[i].distanceTo(x[j]);
-
-                f[i] += viscosityCoefficient() * massSquared
-                    * (v[j] - v[i]) / d[j]
-                    * kernel.secondDerivative(dist);
-            }
+            const auto neighbors = particles->neighborLists()[i];
+            forEachNeighborBatch(
+                x,
+                x[i],
+                neighbors,
+                [&] (SphNeighborBatch3& batch) {
+                    sphSpikySecondDerivatives(
+                        kernel,
+                        batch.distanceSquared,
+                        batch.size,
+                        batch.weight);
+                    for (size_t k = 0; k < batch.size; ++k) {
+                        size_t j = batch.index[k];
+                        f[i] += viscosityCoefficient() * massSquared
+                            * (v[j] - v[i]) / d[j] * batch.weight[k];
+                    }
+                });
         });
 }
 
+void SphSolver3::accumulateBoundaryDensities(
+    const ConstArrayAccessor1<Vector3D>& positions,
+    ArrayAccessor1<double> densities) {
+    if (_boundaryParticles == nullptr) {
+        return;
+    }
+
+    // See Equation 6 from Akinci et al., Versatile rigid-fluid coupling for
+    // incompressible SPH, SIGGRAPH 2012
+    const double targetDensity = sphSystemData()->targetDensity();
+    parallelFor(kZeroSize, positions.size(), [&](size_t i) {
+        densities[i]
+            += targetDensity * _boundaryParticles->sumOfKernelNearby(
+                positions[i]);
+    });
+}
+
+void SphSolver3::accumulateBoundaryPressureForce(
+    const ConstArrayAccessor1<Vector3D>& positions,
+    const ConstArrayAccessor1<double>& densities,
+    const ConstArrayAccessor1<double>& pressures,
+    ArrayAccessor1<Vector3D> pressureForces) {
+    if (_boundaryParticles == nullptr) {
+        return;
+    }
+
+    // See Equation 10 from Akinci et al., SIGGRAPH 2012
+    auto particles = sphSystemData();
+    const double scale = particles->mass() * particles->targetDensity();
+    parallelFor(kZeroSize, positions.size(), [&](size_t i) {
+        if (pressures[i] != 0.0) {
+            pressureForces[i] -= scale * pressures[i] / square(densities[i])
+                * _boundaryParticles->sumOfGradientNearby(positions[i]);
+        }
+    });
+}
+
+const SphHalfNeighborLists3* SphSolver3::halfNeighborLists() const {
+    if (_isUsingSymmetricPairForces
+        && _halfNeighborLists != nullptr
+        && _halfNeighborLists->size()
+            == sphSystemData()->numberOfParticles()) {
+        return _halfNeighborLists.get();
+    } else {
+        return nullptr;
+    }
+}
+
+void SphSolver3::updateDensitiesFromPairCache() {
+    auto particles = sphSystemData();
+    size_t numberOfParticles = particles->numberOfParticles();
+    auto d = particles->densities();
+    const auto halfLists = halfNeighborLists();
+    const auto pairCache = halfLists->pairCache();
+
+    // Each particle is its own neighbor at the zero distance
+    const double selfWeight = SphStdKernel3(particles->kernelRadius())(0.0);
+    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+        d[i] = selfWeight;
+    });
+
+    halfLists->forEachParticle([&](size_t i) {
+        const auto neighbors = (*halfLists)[i];
+        const size_t offset = halfLists->pairOffset(i);
+        double sum = 0.0;
+        for (size_t k = 0; k < neighbors.size(); ++k) {
+            double w = pairCache->stdWeights[offset + k];
+            sum += w;
+            d[neighbors[k]] += w;
+        }
+        d[i] += sum;
+    });
+
+    const double mass = particles->mass();
+    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+        d[i] *= mass;
+    });
+}
+
 void SphSolver3::computePseudoViscosity(double timeStepInSeconds) {
     auto particles = sphSystemData();
     size_t numberOfParticles = particles->numberOfParticles();
@@ -262,13 +611,24 @@ void SphSolver3::computePseudoViscosity(double timeStepInSeconds) {
             double weightSum = 0.0;
             Vector3D smoothedVelocity;
 
-            const auto& neighbors = particles->neighborLists()[i];
-            for (size_t j : neighbors) {
-                double dist = x[i].distanceTo(x[j]);
-                double wj = mass / d[j] * kernel(dist);
-                weightSum += wj;
-                smoothedVelocity += wj * v[j];
-            }
+            const auto neighbors = particles->neighborLists()[i];
+            forEachNeighborBatch(
+                x,
+                x[i],
+                neighbors,
+                [&] (SphNeighborBatch3& batch) {
+                    sphSpikyKernelWeights(
+                        kernel,
+                        batch.distanceSquared,
+                        batch.size,
+                        batch.weight);
+                    for (size_t k = 0; k < batch.size; ++k) {
+                        size_t j = batch.index[k];
+                        double wj = mass / d[j] * batch.weight[k];
+                        weightSum += wj;
+                        smoothedVelocity += wj * v[j];
+                    }
+                });
 
             double wi = mass / d[i];
             weightSum += wi;
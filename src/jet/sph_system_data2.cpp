@@ -10,6 +10,7 @@
 #include <jet/sph_kernels2.h>
 #include <jet/sph_system_data2.h>
 #include <jet/triangle_point_generator.h>
+#include <neighbor_search_helpers.h>
 #include <algorithm>
 
 namespace jet {
@@ -103,7 +104,8 @@ double SphSystemData2::kernelRadius() const {
 double SphSystemData2::sumOfKernelNearby(const Vector2D& origin) const {
     double sum = 0.0;
     SphStdKernel2 kernel(_kernelRadius);
-    neighborSearcher()->forEachNearbyPoint(
+    forEachNearbyPoint(
+        *neighborSearcher(),
         origin,
         _kernelRadius,
         [&] (size_t, const Vector2D& neighborPosition) {
@@ -120,7 +122,8 @@ double SphSystemData2::interpolate(
     auto d = densities();
     SphStdKernel2 kernel(_kernelRadius);
 
-    neighborSearcher()->forEachNearbyPoint(
+    forEachNearbyPoint(
+        *neighborSearcher(),
         origin,
         _kernelRadius,
         [&] (size_t i, const Vector2D& neighborPosition) {
@@ -139,7 +142,8 @@ Vector2D SphSystemData2::interpolate(
     auto d = densities();
     SphStdKernel2 kernel(_kernelRadius);
 
-    neighborSearcher()->forEachNearbyPoint(
+    forEachNearbyPoint(
+        *neighborSearcher(),
         origin,
         _kernelRadius,
         [&] (size_t i, const Vector2D& neighborPosition) {
@@ -157,7 +161,7 @@ Vector2D SphSystemData2::gradientAt(
     Vector2D sum;
     auto p = positions();
     auto d = densities();
-    const auto& neighbors = neighborLists()[i];
+    const auto neighbors = neighborLists()[i];
     Vector2D origin = p[i];
     SphSpikyKernel2 kernel(_kernelRadius);
 
@@ -182,7 +186,7 @@ double SphSystemData2::laplacianAt(
     double sum = 0.0;
     auto p = positions();
     auto d = densities();
-    const auto& neighbors = neighborLists()[i];
+    const auto neighbors = neighborLists()[i];
     Vector2D origin = p[i];
     SphSpikyKernel2 kernel(_kernelRadius);
 
@@ -202,7 +206,7 @@ Vector2D SphSystemData2::laplacianAt(
     Vector2D sum;
     auto p = positions();
     auto d = densities();
-    const auto& neighbors = neighborLists()[i];
+    const auto neighbors = neighborLists()[i];
     Vector2D origin = p[i];
     SphSpikyKernel2 kernel(_kernelRadius);
 
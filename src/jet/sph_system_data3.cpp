@@ -8,9 +8,14 @@
 #include <pch.h>
 #include <jet/bcc_lattice_point_generator.h>
 #include <jet/parallel.h>
+#include <jet/parallel_tuner.h>
 #include <jet/sph_kernels3.h>
 #include <jet/sph_system_data3.h>
+#include <neighbor_search_helpers.h>
+#include <serialization_helpers.h>
+#include <sph_kernel_helpers.h>
 #include <algorithm>
+#include <vector>
 
 namespace jet {
 
@@ -49,7 +54,9 @@ void SphSystemData3::updateDensities() {
     auto p = positions();
     auto d = densities();
 
-    parallelFor(
+    // The neighbor sums are irregular, so the partitioning is tuned
+    static ParallelRegion region("SphSystemData3::updateDensities");
+    region.parallelFor(
         kZeroSize,
         numberOfParticles(),
         [&](size_t i) {
@@ -103,12 +110,16 @@ double SphSystemData3::kernelRadius() const {
 double SphSystemData3::sumOfKernelNearby(const Vector3D& origin) const {
     double sum = 0.0;
     SphStdKernel3 kernel(_kernelRadius);
-    neighborSearcher()->forEachNearbyPoint(
+    forEachNearbyPointBatch(
+        *neighborSearcher(),
         origin,
         _kernelRadius,
-        [&] (size_t, const Vector3D& neighborPosition) {
-            double dist = origin.distanceTo(neighborPosition);
-            sum += kernel(dist);
+        [&] (SphNeighborBatch3& batch) {
+            sphStdKernelWeights(
+                kernel, batch.distanceSquared, batch.size, batch.weight);
+            for (size_t k = 0; k < batch.size; ++k) {
+                sum += batch.weight[k];
+            }
         });
     return sum;
 }
@@ -120,13 +131,18 @@ double SphSystemData3::interpolate(
     auto d = densities();
     SphStdKernel3 kernel(_kernelRadius);
 
-    neighborSearcher()->forEachNearbyPoint(
+    forEachNearbyPointBatch(
+        *neighborSearcher(),
         origin,
         _kernelRadius,
-        [&] (size_t i, const Vector3D& neighborPosition) {
-            double dist = origin.distanceTo(neighborPosition);
-            double weight = _mass / d[i] * kernel(dist);
-            sum += weight * values[i];
+        [&] (SphNeighborBatch3& batch) {
+            sphStdKernelWeights(
+                kernel, batch.distanceSquared, batch.size, batch.weight);
+            for (size_t k = 0; k < batch.size; ++k) {
+                size_t i = batch.index[k];
+                double weight = _mass / d[i] * batch.weight[k];
+                sum += weight * values[i];
+            }
         });
 
     return sum;
@@ -139,13 +155,18 @@ Vector3D SphSystemData3::interpolate(
     auto d = densities();
     SphStdKernel3 kernel(_kernelRadius);
 
-    neighborSearcher()->forEachNearbyPoint(
+    forEachNearbyPointBatch(
+        *neighborSearcher(),
         origin,
         _kernelRadius,
-        [&] (size_t i, const Vector3D& neighborPosition) {
-            double dist = origin.distanceTo(neighborPosition);
-            double weight = _mass / d[i] * kernel(dist);
-            sum += weight * values[i];
+        [&] (SphNeighborBatch3& batch) {
+            sphStdKernelWeights(
+                kernel, batch.distanceSquared, batch.size, batch.weight);
+            for (size_t k = 0; k < batch.size; ++k) {
+                size_t i = batch.index[k];
+                double weight = _mass / d[i] * batch.weight[k];
+                sum += weight * values[i];
+            }
         });
 
     return sum;
@@ -157,21 +178,25 @@ Vector3D SphSystemData3::gradientAt(
     Vector3D sum;
     auto p = positions();
     auto d = densities();
-    const auto& neighbors = neighborLists()[i];
+    const auto neighbors = neighborLists()[i];
     Vector3D origin = p[i];
     SphSpikyKernel3 kernel(_kernelRadius);
 
-    for (size_t j : neighbors) {
-        Vector3D neighborPosition = p[j];
-        double dist = origin.distanceTo(neighborPosition);
-        if (dist > 0.0) {
-            Vector3D dir = (neighborPosition - origin) / dist;
-            sum
-                += d[i] * _mass
-                * (values[i] / square(d[i]) + values[j] / square(d[j]))
-                * kernel.gradient(dist, dir);
-        }
-    }
+    forEachNeighborBatch(
+        p,
+        origin,
+        neighbors,
+        [&] (SphNeighborBatch3& batch) {
+            sphSpikyGradientScales(
+                kernel, batch.distanceSquared, batch.size, batch.weight);
+            for (size_t k = 0; k < batch.size; ++k) {
+                size_t j = batch.index[k];
+                double scale = d[i] * _mass
+                    * (values[i] / square(d[i]) + values[j] / square(d[j]))
+                    * batch.weight[k];
+                sum += scale * Vector3D(batch.x[k], batch.y[k], batch.z[k]);
+            }
+        });
 
     return sum;
 }
@@ -182,16 +207,23 @@ double SphSystemData3::laplacianAt(
     double sum = 0.0;
     auto p = positions();
     auto d = densities();
-    const auto& neighbors = neighborLists()[i];
+    const auto neighbors = neighborLists()[i];
     Vector3D origin = p[i];
     SphSpikyKernel3 kernel(_kernelRadius);
 
-    for (size_t j : neighbors) {
-        Vector3D neighborPosition = p[j];
-        double dist = origin.distanceTo(neighborPosition);
-        sum += _mass
-            * (values[j] - values[i]) / d[j] * kernel.secondDerivative(dist);
-    }
+    forEachNeighborBatch(
+        p,
+        origin,
+        neighbors,
+        [&] (SphNeighborBatch3& batch) {
+            sphSpikySecondDerivatives(
+                kernel, batch.distanceSquared, batch.size, batch.weight);
+            for (size_t k = 0; k < batch.size; ++k) {
+                size_t j = batch.index[k];
+                sum += _mass
+                    * (values[j] - values[i]) / d[j] * batch.weight[k];
+            }
+        });
 
     return sum;
 }
@@ -202,16 +234,23 @@ Vector3D SphSystemData3::laplacianAt(
     Vector3D sum;
     auto p = positions();
     auto d = densities();
-    const auto& neighbors = neighborLists()[i];
+    const auto neighbors = neighborLists()[i];
     Vector3D origin = p[i];
     SphSpikyKernel3 kernel(_kernelRadius);
 
-    for (size_t j : neighbors) {
-        Vector3D neighborPosition = p[j];
-        double dist = origin.distanceTo(neighborPosition);
-        sum += _mass
-            * (values[j] - values[i]) / d[j] * kernel.secondDerivative(dist);
-    }
+    forEachNeighborBatch(
+        p,
+        origin,
+        neighbors,
+        [&] (SphNeighborBatch3& batch) {
+            sphSpikySecondDerivatives(
+                kernel, batch.distanceSquared, batch.size, batch.weight);
+            for (size_t k = 0; k < batch.size; ++k) {
+                size_t j = batch.index[k];
+                sum += _mass
+                    * (values[j] - values[i]) / d[j] * batch.weight[k];
+            }
+        });
 
     return sum;
 }
@@ -224,38 +263,84 @@ void SphSystemData3::buildNeighborLists() {
     ParticleSystemData3::buildNeighborLists(_kernelRadius);
 }
 
+void SphSystemData3::serialize(std::ostream* strm) const {
+    ParticleSystemData3::serialize(strm);
+
+    serializeSectionTag(strm, "SphSystemData3");
+    serializeValue(strm, _mass);
+    serializeValue(strm, _targetDensity);
+    serializeValue(strm, _targetSpacing);
+    serializeValue(strm, _kernelRadiusOverTargetSpacing);
+    serializeValue(strm, _kernelRadius);
+}
+
+void SphSystemData3::deserialize(std::istream* strm) {
+    ParticleSystemData3::deserialize(strm);
+
+    JET_THROW_INVALID_ARG_IF(!deserializeSectionTag(strm, "SphSystemData3"));
+    deserializeValue(strm, &_mass);
+    deserializeValue(strm, &_targetDensity);
+    deserializeValue(strm, &_targetSpacing);
+    deserializeValue(strm, &_kernelRadiusOverTargetSpacing);
+    deserializeValue(strm, &_kernelRadius);
+    JET_THROW_INVALID_ARG_IF(!(*strm));
+}
+
 void SphSystemData3::setMass(double newMass) {
     // Ignore input
     UNUSED_VARIABLE(newMass);
 }
 
 void SphSystemData3::computeMass() {
-    Array1<Vector3D> points;
-    BccLatticePointGenerator pointsGenerator;
-    BoundingBox3D sampleBound(
-        Vector3D(-1.5*_kernelRadius, -1.5*_kernelRadius, -1.5*_kernelRadius),
-        Vector3D(1.5*_kernelRadius, 1.5*_kernelRadius, 1.5*_kernelRadius));
-
-    pointsGenerator.generate(sampleBound, _targetSpacing, &points);
-
-    double maxNumberDensity = 0.0;
-    SphStdKernel3 kernel(_kernelRadius);
-
-    for (size_t i = 0; i < points.size(); ++i) {
-        const Vector3D& point = points[i];
-        double sum = 0.0;
+    if (_maxNumberDensitySpacing != _targetSpacing
+        || _maxNumberDensityKernelRadius != _kernelRadius) {
+        Array1<Vector3D> points;
+        BccLatticePointGenerator pointsGenerator;
+        BoundingBox3D sampleBound(
+            Vector3D(
+                -1.5*_kernelRadius, -1.5*_kernelRadius, -1.5*_kernelRadius),
+            Vector3D(
+                1.5*_kernelRadius, 1.5*_kernelRadius, 1.5*_kernelRadius));
+
+        pointsGenerator.generate(sampleBound, _targetSpacing, &points);
+
+        // Every lattice point whose kernel support lies inside the sample box
+        // sees the same neighborhood, and that is where the number density
+        // peaks. So only the points around the center need to be summed.
+        std::vector<size_t> centerPoints;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (points[i].length() <= _targetSpacing) {
+                centerPoints.push_back(i);
+            }
+        }
 
-        for (size_t j = 0; j < points.size(); ++j) {
-            const Vector3D& neighborPoint = points[j];
-            sum += kernel(neighborPoint.distanceTo(point));
+        SphStdKernel3 kernel(_kernelRadius);
+        std::vector<double> sums(centerPoints.size(), 0.0);
+        parallelFor(
+            kZeroSize,
+            centerPoints.size(),
+            [&](size_t c) {
+                const Vector3D& point = points[centerPoints[c]];
+                double sum = 0.0;
+                for (size_t j = 0; j < points.size(); ++j) {
+                    sum += kernel(points[j].distanceTo(point));
+                }
+                sums[c] = sum;
+            });
+
+        double maxNumberDensity = 0.0;
+        for (double sum : sums) {
+            maxNumberDensity = std::max(maxNumberDensity, sum);
         }
 
-        maxNumberDensity = std::max(maxNumberDensity, sum);
-    }
+        JET_ASSERT(maxNumberDensity > 0);
 
-    JET_ASSERT(maxNumberDensity > 0);
+        _maxNumberDensity = maxNumberDensity;
+        _maxNumberDensitySpacing = _targetSpacing;
+        _maxNumberDensityKernelRadius = _kernelRadius;
+    }
 
-    _mass = _targetDensity / maxNumberDensity;
+    _mass = _targetDensity / _maxNumberDensity;
 
     ParticleSystemData3::setMass(_mass);
 }
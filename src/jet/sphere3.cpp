@@ -2,11 +2,133 @@
 
 #include <pch.h>
 #include <jet/sphere3.h>
+#include <primitive_distance_helpers.h>
 
+#include <cmath>
 #include <limits>
 
 using namespace jet;
 
+namespace {
+
+void sphereDistancesScalar(
+    size_t begin,
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double* result) {
+    for (size_t i = begin; i < n; ++i) {
+        double dx = p.x[i] - c.x;
+        double dy = p.y[i] - c.y;
+        double dz = p.z[i] - c.z;
+        result[i] = std::sqrt(dx * dx + dy * dy + dz * dz) - r;
+    }
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 void sphereDistancesSse2(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double* result) {
+    const __m128d cx = _mm_set1_pd(c.x);
+    const __m128d cy = _mm_set1_pd(c.y);
+    const __m128d cz = _mm_set1_pd(c.z);
+    const __m128d rr = _mm_set1_pd(r);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(p.x + i), cx);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(p.y + i), cy);
+        __m128d dz = _mm_sub_pd(_mm_loadu_pd(p.z + i), cz);
+        __m128d l = _mm_sqrt_pd(_mm_add_pd(
+            _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+            _mm_mul_pd(dz, dz)));
+        _mm_storeu_pd(result + i, _mm_sub_pd(l, rr));
+    }
+    sphereDistancesScalar(i, n, p, c, r, result);
+}
+
+JET_TARGET_AVX void sphereDistancesAvx(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double* result) {
+    const __m256d cx = _mm256_set1_pd(c.x);
+    const __m256d cy = _mm256_set1_pd(c.y);
+    const __m256d cz = _mm256_set1_pd(c.z);
+    const __m256d rr = _mm256_set1_pd(r);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(p.x + i), cx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(p.y + i), cy);
+        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(p.z + i), cz);
+        __m256d l = _mm256_sqrt_pd(_mm256_add_pd(
+            _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+            _mm256_mul_pd(dz, dz)));
+        _mm256_storeu_pd(result + i, _mm256_sub_pd(l, rr));
+    }
+    sphereDistancesScalar(i, n, p, c, r, result);
+}
+
+#elif defined(JET_SIMD_NEON)
+
+void sphereDistancesNeon(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double* result) {
+    const float64x2_t cx = vdupq_n_f64(c.x);
+    const float64x2_t cy = vdupq_n_f64(c.y);
+    const float64x2_t cz = vdupq_n_f64(c.z);
+    const float64x2_t rr = vdupq_n_f64(r);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t dx = vsubq_f64(vld1q_f64(p.x + i), cx);
+        float64x2_t dy = vsubq_f64(vld1q_f64(p.y + i), cy);
+        float64x2_t dz = vsubq_f64(vld1q_f64(p.z + i), cz);
+        float64x2_t l = vsqrtq_f64(vaddq_f64(
+            vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy)),
+            vmulq_f64(dz, dz)));
+        vst1q_f64(result + i, vsubq_f64(l, rr));
+    }
+    sphereDistancesScalar(i, n, p, c, r, result);
+}
+
+#endif
+
+void sphereDistances(
+    size_t n,
+    const PrimitiveDistanceChunk& p,
+    const Vector3D& c,
+    double r,
+    double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+        case SimdInstructionSet::Avx:
+            sphereDistancesAvx(n, p, c, r, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            sphereDistancesSse2(n, p, c, r, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            sphereDistancesNeon(n, p, c, r, result);
+            return;
+#endif
+        default:
+            sphereDistancesScalar(0, n, p, c, r, result);
+            return;
+    }
+}
+
+}  // namespace
+
 Sphere3::Sphere3() {
 }
 
@@ -22,7 +144,7 @@ Sphere3::Sphere3(const Sphere3& other) :
 }
 
 Vector3D Sphere3::closestPoint(const Vector3D& otherPoint) const {
-    return radius * closestNormal(otherPoint) + center;
+    return radius * actualClosestNormal(otherPoint) + center;
 }
 
 double Sphere3::closestDistance(const Vector3D& otherPoint) const {
@@ -99,3 +221,13 @@ BoundingBox3D Sphere3::boundingBox() const {
     Vector3D r(radius, radius, radius);
     return BoundingBox3D(center - r, center + r);
 }
+
+void Sphere3::actualBatchClosestSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    primitiveSignedDistances(
+        otherPoints, result,
+        [&](size_t n, const PrimitiveDistanceChunk& p, double* out) {
+            sphereDistances(n, p, center, radius, out);
+        });
+}
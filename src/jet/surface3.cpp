@@ -1,6 +1,8 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/array1.h>
+#include <jet/parallel.h>
 #include <jet/surface3.h>
 
 using namespace jet;
@@ -36,3 +38,83 @@ SurfaceRayIntersection3 Surface3::closestIntersection(
         = (isNormalFlipped) ? -intersection.normal : intersection.normal;
     return intersection;
 }
+
+void Surface3::batchClosestPoint(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+        result[i] = closestPoint(otherPoints[i]);
+    });
+}
+
+void Surface3::batchClosestDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+        result[i] = closestDistance(otherPoints[i]);
+    });
+}
+
+void Surface3::batchClosestNormal(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    actualBatchClosestNormal(otherPoints, result);
+    if (isNormalFlipped) {
+        parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+            result[i] = -result[i];
+        });
+    }
+}
+
+void Surface3::batchClosestIntersection(
+    const ConstArrayAccessor1<Ray3D>& rays,
+    ArrayAccessor1<SurfaceRayIntersection3> result) const {
+    actualBatchClosestIntersection(rays, result);
+    if (isNormalFlipped) {
+        parallelFor(kZeroSize, rays.size(), [&](size_t i) {
+            result[i].normal = -result[i].normal;
+        });
+    }
+}
+
+void Surface3::batchClosestSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    actualBatchClosestSignedDistance(otherPoints, result);
+    if (isNormalFlipped) {
+        parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+            result[i] = -result[i];
+        });
+    }
+}
+
+void Surface3::actualBatchClosestNormal(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+        result[i] = actualClosestNormal(otherPoints[i]);
+    });
+}
+
+void Surface3::actualBatchClosestIntersection(
+    const ConstArrayAccessor1<Ray3D>& rays,
+    ArrayAccessor1<SurfaceRayIntersection3> result) const {
+    parallelFor(kZeroSize, rays.size(), [&](size_t i) {
+        result[i] = actualClosestIntersection(rays[i]);
+    });
+}
+
+void Surface3::actualBatchClosestSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    Array1<Vector3D> x(otherPoints.size());
+    Array1<Vector3D> n(otherPoints.size());
+    batchClosestPoint(otherPoints, x.accessor());
+    actualBatchClosestNormal(otherPoints, n.accessor());
+
+    parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+        double distance = x[i].distanceTo(otherPoints[i]);
+        result[i]
+            = (n[i].dot(otherPoints[i] - x[i]) < 0.0) ? -distance : distance;
+    });
+}
@@ -2,9 +2,11 @@
 
 #include <pch.h>
 #include <jet/surface_set3.h>
+#include <jet/math_utils.h>
 
 #include <algorithm>
 #include <limits>
+#include <vector>
 
 using namespace jet;
 
@@ -26,83 +28,98 @@ const Surface3Ptr& SurfaceSet3::surfaceAt(size_t i) const {
 
 void SurfaceSet3::addSurface(const Surface3Ptr& surface) {
     _surfaces.push_back(surface);
+    invalidateBvh();
 }
 
-Vector3D SurfaceSet3::closestPoint(const Vector3D& otherPoint) const {
-    Vector3D result(
-        std::numeric_limits<double>::max(),
-        std::numeric_limits<double>::max(),
-        std::numeric_limits<double>::max());
+void SurfaceSet3::invalidateBvh() {
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    _isBvhValid = false;
+}
 
-    double minimumDistance = std::numeric_limits<double>::max();
+size_t SurfaceSet3::closestSurfaceIndex(const Vector3D& otherPoint) const {
+    buildBvh();
 
-    for (const auto& surface : _surfaces) {
-        Vector3D localClosestPoint = surface->closestPoint(otherPoint);
-        double localDistance = surface->closestDistance(otherPoint);
+    return _bvh.nearest(otherPoint, [&](size_t j) {
+        return square(_surfaces[j]->closestDistance(otherPoint));
+    });
+}
 
-        if (localDistance < minimumDistance) {
-            result = localClosestPoint;
-            minimumDistance = localDistance;
-        }
+Vector3D SurfaceSet3::closestPoint(const Vector3D& otherPoint) const {
+    buildBvh();
+
+    size_t i = _bvh.nearest(otherPoint, [&](size_t j) {
+        return square(_surfaces[j]->closestDistance(otherPoint));
+    });
+
+    if (i == kMaxSize) {
+        return Vector3D(
+            std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::max());
     }
 
-    return result;
+    return _surfaces[i]->closestPoint(otherPoint);
 }
 
 Vector3D SurfaceSet3::actualClosestNormal(const Vector3D& otherPoint) const {
-    Vector3D result(1, 0, 0);
+    buildBvh();
 
-    double minimumDistance = std::numeric_limits<double>::max();
-
-    for (const auto& surface : _surfaces) {
-        Vector3D localClosestNormal = surface->closestNormal(otherPoint);
-        double localDistance = surface->closestDistance(otherPoint);
+    size_t i = _bvh.nearest(otherPoint, [&](size_t j) {
+        return square(_surfaces[j]->closestDistance(otherPoint));
+    });
 
-        if (localDistance < minimumDistance) {
-            result = localClosestNormal;
-            minimumDistance = localDistance;
-        }
+    if (i == kMaxSize) {
+        return Vector3D(1, 0, 0);
     }
 
-    return result;
+    return _surfaces[i]->closestNormal(otherPoint);
 }
 
 double SurfaceSet3::closestDistance(const Vector3D& otherPoint) const {
-    double minimumDistance = std::numeric_limits<double>::max();
-
-    for (const auto& surface : _surfaces) {
-        double localDistance = surface->closestDistance(otherPoint);
+    buildBvh();
 
+    double minimumDistance = std::numeric_limits<double>::max();
+    _bvh.nearest(otherPoint, [&](size_t j) {
+        double localDistance = _surfaces[j]->closestDistance(otherPoint);
         minimumDistance = std::min(minimumDistance, localDistance);
-    }
+        return square(localDistance);
+    });
 
     return minimumDistance;
 }
 
 bool SurfaceSet3::intersects(const Ray3D& ray) const {
-    for (const auto& surface : _surfaces) {
-        if (surface->intersects(ray)) {
-            return true;
-        }
-    }
+    buildBvh();
 
-    return false;
+    return _bvh.anyRayHit(ray, [&](size_t j) {
+        return _surfaces[j]->intersects(ray);
+    });
 }
 
 SurfaceRayIntersection3 SurfaceSet3::actualClosestIntersection(
     const Ray3D& ray) const {
+    buildBvh();
+
     SurfaceRayIntersection3 intersection;
     double tMin = std::numeric_limits<double>::max();
+    size_t closest = kMaxSize;
 
-    for (const auto& surface : _surfaces) {
+    _bvh.forEachRayCandidate(ray, [&](size_t j) {
         SurfaceRayIntersection3 localResult =
-            surface->closestIntersection(ray);
+            _surfaces[j]->closestIntersection(ray);
 
-        if (localResult.isIntersecting && localResult.t < tMin) {
+        if (!localResult.isIntersecting) {
+            return std::numeric_limits<double>::max();
+        }
+
+        if (localResult.t < tMin || (localResult.t == tMin && j < closest)) {
             intersection = localResult;
             tMin = localResult.t;
+            closest = j;
         }
-    }
+
+        return localResult.t;
+    });
 
     return intersection;
 }
@@ -115,3 +132,23 @@ BoundingBox3D SurfaceSet3::boundingBox() const {
 
     return bbox;
 }
+
+void SurfaceSet3::buildBvh() const {
+    if (_isBvhValid) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    if (_isBvhValid) {
+        return;
+    }
+
+    std::vector<BoundingBox3D> bounds(_surfaces.size());
+    for (size_t i = 0; i < _surfaces.size(); ++i) {
+        bounds[i] = _surfaces[i]->boundingBox();
+    }
+
+    _bvh.build(bounds);
+
+    _isBvhValid = true;
+}
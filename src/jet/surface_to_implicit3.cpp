@@ -1,6 +1,7 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <pch.h>
+#include <jet/parallel.h>
 #include <jet/surface_to_implicit3.h>
 
 using namespace jet;
@@ -46,6 +47,30 @@ BoundingBox3D SurfaceToImplicit3::boundingBox() const {
     return _surface->boundingBox();
 }
 
+void SurfaceToImplicit3::batchClosestPoint(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    _surface->batchClosestPoint(otherPoints, result);
+}
+
+void SurfaceToImplicit3::batchClosestDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    _surface->batchClosestDistance(otherPoints, result);
+}
+
+void SurfaceToImplicit3::actualBatchClosestNormal(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    _surface->batchClosestNormal(otherPoints, result);
+}
+
+void SurfaceToImplicit3::actualBatchClosestIntersection(
+    const ConstArrayAccessor1<Ray3D>& rays,
+    ArrayAccessor1<SurfaceRayIntersection3> result) const {
+    _surface->batchClosestIntersection(rays, result);
+}
+
 double SurfaceToImplicit3::signedDistance(
     const Vector3D& otherPoint) const {
     Vector3D x = _surface->closestPoint(otherPoint);
@@ -57,3 +82,14 @@ double SurfaceToImplicit3::signedDistance(
         return x.distanceTo(otherPoint);
     }
 }
+
+void SurfaceToImplicit3::batchSignedDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    _surface->batchClosestSignedDistance(otherPoints, result);
+    if (isNormalFlipped) {
+        parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+            result[i] = -result[i];
+        });
+    }
+}
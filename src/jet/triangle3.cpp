@@ -2,29 +2,12 @@
 
 #include <pch.h>
 #include <jet/triangle3.h>
+#include <triangle_distance_helpers.h>
 
 #include <limits>
 
 using namespace jet;
 
-inline Vector3D closestPointOnLine(
-    const Vector3D& v0, const Vector3D& v1, const Vector3D& pt) {
-
-    const double lenSquared = (v1 - v0).lengthSquared();
-    if (lenSquared < std::numeric_limits<double>::epsilon()) {
-        return v0;
-    }
-
-    const double t = (pt - v0).dot(v1 - v0) / lenSquared;
-    if (t < 0.0) {
-        return v0;
-    } else if (t > 1.0) {
-        return v1;
-    }
-
-    return v0 + t * (v1 - v0);
-}
-
 inline Vector3D closestNormalOnLine(
     const Vector3D& v0,
     const Vector3D& v1,
@@ -67,34 +50,8 @@ Triangle3::Triangle3(const Triangle3& other) :
 }
 
 Vector3D Triangle3::closestPoint(const Vector3D& otherPoint) const {
-    Vector3D n = faceNormal();
-    double nd = n.dot(n);
-    double d = n.dot(points[0]);
-    double t = (d - n.dot(otherPoint)) / nd;
-
-    Vector3D q = t * n + otherPoint;
-
-    Vector3D q01 = (points[1] - points[0]).cross(q - points[0]);
-    if (n.dot(q01) < 0) {
-        return closestPointOnLine(points[0], points[1], q);
-    }
-
-    Vector3D q12 = (points[2] - points[1]).cross(q - points[1]);
-    if (n.dot(q12) < 0) {
-        return closestPointOnLine(points[1], points[2], q);
-    }
-
-    Vector3D q02 = (points[0] - points[2]).cross(q - points[2]);
-    if (n.dot(q02) < 0) {
-        return closestPointOnLine(points[0], points[2], q);
-    }
-
-    double a = area();
-    double b0 = 0.5 * q12.length() / a;
-    double b1 = 0.5 * q02.length() / a;
-    double b2 = 0.5 * q01.length() / a;
-
-    return b0 * points[0] + b1 * points[1] + b2 * points[2];
+    return closestPointOnTriangle(
+        TriangleEdges3(points[0], points[1], points[2]), otherPoint);
 }
 
 Vector3D Triangle3::actualClosestNormal(const Vector3D& otherPoint) const {
@@ -0,0 +1,502 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_TRIANGLE_DISTANCE_HELPERS_H_
+#define SRC_JET_TRIANGLE_DISTANCE_HELPERS_H_
+
+#include <jet/vector3.h>
+#include <simd_helpers.h>
+
+namespace jet {
+
+// Streams of a triangle cache. A cache stores the same value of all the
+// triangles contiguously, one stream after another, so the kernels below
+// load the values of consecutive triangles with one instruction.
+enum TriangleCacheStream {
+    kTriangleAx, kTriangleAy, kTriangleAz,
+    kTriangleAbx, kTriangleAby, kTriangleAbz,
+    kTriangleAcx, kTriangleAcy, kTriangleAcz,
+    kTriangleAbab, kTriangleAbac, kTriangleAcac,
+    kNumberOfTriangleCacheStreams
+};
+
+// Number of the triangles that the kernels evaluate at once, which is also
+// the padding at the end of each stream
+const size_t kTriangleCacheLanes = 4;
+
+// Corner a and the edges ab and ac of a triangle with the dot products of
+// the edges, which are all that the closest point query needs
+struct TriangleEdges3 {
+    Vector3D a;
+    Vector3D ab;
+    Vector3D ac;
+    double abab;
+    double abac;
+    double acac;
+
+    TriangleEdges3(const Vector3D& p0, const Vector3D& p1, const Vector3D& p2)
+    : a(p0), ab(p1 - p0), ac(p2 - p0),
+      abab(ab.dot(ab)), abac(ab.dot(ac)), acac(ac.dot(ac)) {
+    }
+
+    TriangleEdges3(const double* cache, size_t stride, size_t position) {
+        const double* v = cache + position;
+        a.set(v[kTriangleAx * stride], v[kTriangleAy * stride],
+              v[kTriangleAz * stride]);
+        ab.set(v[kTriangleAbx * stride], v[kTriangleAby * stride],
+               v[kTriangleAbz * stride]);
+        ac.set(v[kTriangleAcx * stride], v[kTriangleAcy * stride],
+               v[kTriangleAcz * stride]);
+        abab = v[kTriangleAbab * stride];
+        abac = v[kTriangleAbac * stride];
+        acac = v[kTriangleAcac * stride];
+    }
+
+    void store(double* cache, size_t stride, size_t position) const {
+        double* v = cache + position;
+        v[kTriangleAx * stride] = a.x;
+        v[kTriangleAy * stride] = a.y;
+        v[kTriangleAz * stride] = a.z;
+        v[kTriangleAbx * stride] = ab.x;
+        v[kTriangleAby * stride] = ab.y;
+        v[kTriangleAbz * stride] = ab.z;
+        v[kTriangleAcx * stride] = ac.x;
+        v[kTriangleAcy * stride] = ac.y;
+        v[kTriangleAcz * stride] = ac.z;
+        v[kTriangleAbab * stride] = abab;
+        v[kTriangleAbac * stride] = abac;
+        v[kTriangleAcac * stride] = acac;
+    }
+};
+
+// Finds the closest point a + s ab + t ac of the triangle to p by the
+// Voronoi regions of the corners and the edges, as in Ericson, "Real-Time
+// Collision Detection" (2005), 5.1.5. The dot products with the other
+// corners are derived from the precomputed ones, so only two dot products
+// depend on p. The vectorized kernels evaluate the same expressions for
+// every region and pick the first region that contains p, so their results
+// are identical to this function.
+inline void closestTriangleParameters(
+    const TriangleEdges3& e, const Vector3D& p, double* s, double* t) {
+    const Vector3D ap = p - e.a;
+    const double d1 = e.ab.dot(ap);
+    const double d2 = e.ac.dot(ap);
+    const double d3 = d1 - e.abab;
+    const double d4 = d2 - e.abac;
+    const double d5 = d1 - e.abac;
+    const double d6 = d2 - e.acac;
+
+    if (d1 <= 0.0 && d2 <= 0.0) {
+        *s = 0.0;
+        *t = 0.0;
+        return;
+    }
+
+    if (d3 >= 0.0 && d4 <= d3) {
+        *s = 1.0;
+        *t = 0.0;
+        return;
+    }
+
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+        *s = d1 / (d1 - d3);
+        *t = 0.0;
+        return;
+    }
+
+    if (d6 >= 0.0 && d5 <= d6) {
+        *s = 0.0;
+        *t = 1.0;
+        return;
+    }
+
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+        *s = 0.0;
+        *t = d2 / (d2 - d6);
+        return;
+    }
+
+    const double va = d3 * d6 - d5 * d4;
+    const double d43 = d4 - d3;
+    const double d56 = d5 - d6;
+    if (va <= 0.0 && d43 >= 0.0 && d56 >= 0.0) {
+        const double x = d43 / (d43 + d56);
+        *s = 1.0 - x;
+        *t = x;
+        return;
+    }
+
+    const double denom = 1.0 / (va + vb + vc);
+    *s = vb * denom;
+    *t = vc * denom;
+}
+
+inline Vector3D closestPointOnTriangle(
+    const TriangleEdges3& e, const Vector3D& p) {
+    double s, t;
+    closestTriangleParameters(e, p, &s, &t);
+    return e.a + s * e.ab + t * e.ac;
+}
+
+inline void triangleDistancesSquaredScalar(
+    const double* cache,
+    size_t stride,
+    size_t position,
+    size_t count,
+    const Vector3D& p,
+    double* result) {
+    for (size_t n = 0; n < count; ++n) {
+        TriangleEdges3 e(cache, stride, position + n);
+        result[n] = (p - closestPointOnTriangle(e, p)).lengthSquared();
+    }
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 inline __m128d loadSse2(
+    const double* v, size_t stride, TriangleCacheStream stream) {
+    return _mm_loadu_pd(v + stream * stride);
+}
+
+JET_TARGET_SSE2 inline __m128d selectSse2(
+    __m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+JET_TARGET_SSE2 inline void triangleDistancesSquaredSse2(
+    const double* cache,
+    size_t stride,
+    size_t position,
+    const Vector3D& p,
+    double* result) {
+    const double* v = cache + position;
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+
+    const __m128d ax = loadSse2(v, stride, kTriangleAx);
+    const __m128d ay = loadSse2(v, stride, kTriangleAy);
+    const __m128d az = loadSse2(v, stride, kTriangleAz);
+    const __m128d abx = loadSse2(v, stride, kTriangleAbx);
+    const __m128d aby = loadSse2(v, stride, kTriangleAby);
+    const __m128d abz = loadSse2(v, stride, kTriangleAbz);
+    const __m128d acx = loadSse2(v, stride, kTriangleAcx);
+    const __m128d acy = loadSse2(v, stride, kTriangleAcy);
+    const __m128d acz = loadSse2(v, stride, kTriangleAcz);
+    const __m128d px = _mm_set1_pd(p.x);
+    const __m128d py = _mm_set1_pd(p.y);
+    const __m128d pz = _mm_set1_pd(p.z);
+
+    const __m128d apx = _mm_sub_pd(px, ax);
+    const __m128d apy = _mm_sub_pd(py, ay);
+    const __m128d apz = _mm_sub_pd(pz, az);
+    const __m128d d1 = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(abx, apx), _mm_mul_pd(aby, apy)),
+        _mm_mul_pd(abz, apz));
+    const __m128d d2 = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(acx, apx), _mm_mul_pd(acy, apy)),
+        _mm_mul_pd(acz, apz));
+    const __m128d d3 = _mm_sub_pd(d1, loadSse2(v, stride, kTriangleAbab));
+    const __m128d d4 = _mm_sub_pd(d2, loadSse2(v, stride, kTriangleAbac));
+    const __m128d d5 = _mm_sub_pd(d1, loadSse2(v, stride, kTriangleAbac));
+    const __m128d d6 = _mm_sub_pd(d2, loadSse2(v, stride, kTriangleAcac));
+    const __m128d vc = _mm_sub_pd(_mm_mul_pd(d1, d4), _mm_mul_pd(d3, d2));
+    const __m128d vb = _mm_sub_pd(_mm_mul_pd(d5, d2), _mm_mul_pd(d1, d6));
+    const __m128d va = _mm_sub_pd(_mm_mul_pd(d3, d6), _mm_mul_pd(d5, d4));
+    const __m128d d43 = _mm_sub_pd(d4, d3);
+    const __m128d d56 = _mm_sub_pd(d5, d6);
+
+    // Regions from the last to the first, so the first one wins
+    const __m128d denom = _mm_div_pd(one, _mm_add_pd(_mm_add_pd(va, vb), vc));
+    __m128d s = _mm_mul_pd(vb, denom);
+    __m128d t = _mm_mul_pd(vc, denom);
+
+    __m128d mask = _mm_and_pd(
+        _mm_cmple_pd(va, zero),
+        _mm_and_pd(_mm_cmpge_pd(d43, zero), _mm_cmpge_pd(d56, zero)));
+    const __m128d x = _mm_div_pd(d43, _mm_add_pd(d43, d56));
+    s = selectSse2(mask, _mm_sub_pd(one, x), s);
+    t = selectSse2(mask, x, t);
+
+    mask = _mm_and_pd(
+        _mm_cmple_pd(vb, zero),
+        _mm_and_pd(_mm_cmpge_pd(d2, zero), _mm_cmple_pd(d6, zero)));
+    s = selectSse2(mask, zero, s);
+    t = selectSse2(mask, _mm_div_pd(d2, _mm_sub_pd(d2, d6)), t);
+
+    mask = _mm_and_pd(_mm_cmpge_pd(d6, zero), _mm_cmple_pd(d5, d6));
+    s = selectSse2(mask, zero, s);
+    t = selectSse2(mask, one, t);
+
+    mask = _mm_and_pd(
+        _mm_cmple_pd(vc, zero),
+        _mm_and_pd(_mm_cmpge_pd(d1, zero), _mm_cmple_pd(d3, zero)));
+    s = selectSse2(mask, _mm_div_pd(d1, _mm_sub_pd(d1, d3)), s);
+    t = selectSse2(mask, zero, t);
+
+    mask = _mm_and_pd(_mm_cmpge_pd(d3, zero), _mm_cmple_pd(d4, d3));
+    s = selectSse2(mask, one, s);
+    t = selectSse2(mask, zero, t);
+
+    mask = _mm_and_pd(_mm_cmple_pd(d1, zero), _mm_cmple_pd(d2, zero));
+    s = selectSse2(mask, zero, s);
+    t = selectSse2(mask, zero, t);
+
+    const __m128d dx = _mm_sub_pd(
+        px, _mm_add_pd(_mm_add_pd(ax, _mm_mul_pd(s, abx)), _mm_mul_pd(t, acx)));
+    const __m128d dy = _mm_sub_pd(
+        py, _mm_add_pd(_mm_add_pd(ay, _mm_mul_pd(s, aby)), _mm_mul_pd(t, acy)));
+    const __m128d dz = _mm_sub_pd(
+        pz, _mm_add_pd(_mm_add_pd(az, _mm_mul_pd(s, abz)), _mm_mul_pd(t, acz)));
+    _mm_storeu_pd(result, _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+        _mm_mul_pd(dz, dz)));
+}
+
+JET_TARGET_AVX inline __m256d loadAvx(
+    const double* v, size_t stride, TriangleCacheStream stream) {
+    return _mm256_loadu_pd(v + stream * stride);
+}
+
+JET_TARGET_AVX inline __m256d lessEqualAvx(__m256d a, __m256d b) {
+    return _mm256_cmp_pd(a, b, _CMP_LE_OQ);
+}
+
+JET_TARGET_AVX inline __m256d greaterEqualAvx(__m256d a, __m256d b) {
+    return _mm256_cmp_pd(a, b, _CMP_GE_OQ);
+}
+
+JET_TARGET_AVX inline void triangleDistancesSquaredAvx(
+    const double* cache,
+    size_t stride,
+    size_t position,
+    const Vector3D& p,
+    double* result) {
+    const double* v = cache + position;
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    const __m256d ax = loadAvx(v, stride, kTriangleAx);
+    const __m256d ay = loadAvx(v, stride, kTriangleAy);
+    const __m256d az = loadAvx(v, stride, kTriangleAz);
+    const __m256d abx = loadAvx(v, stride, kTriangleAbx);
+    const __m256d aby = loadAvx(v, stride, kTriangleAby);
+    const __m256d abz = loadAvx(v, stride, kTriangleAbz);
+    const __m256d acx = loadAvx(v, stride, kTriangleAcx);
+    const __m256d acy = loadAvx(v, stride, kTriangleAcy);
+    const __m256d acz = loadAvx(v, stride, kTriangleAcz);
+    const __m256d px = _mm256_set1_pd(p.x);
+    const __m256d py = _mm256_set1_pd(p.y);
+    const __m256d pz = _mm256_set1_pd(p.z);
+
+    const __m256d apx = _mm256_sub_pd(px, ax);
+    const __m256d apy = _mm256_sub_pd(py, ay);
+    const __m256d apz = _mm256_sub_pd(pz, az);
+    const __m256d d1 = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(abx, apx), _mm256_mul_pd(aby, apy)),
+        _mm256_mul_pd(abz, apz));
+    const __m256d d2 = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(acx, apx), _mm256_mul_pd(acy, apy)),
+        _mm256_mul_pd(acz, apz));
+    const __m256d d3 = _mm256_sub_pd(d1, loadAvx(v, stride, kTriangleAbab));
+    const __m256d d4 = _mm256_sub_pd(d2, loadAvx(v, stride, kTriangleAbac));
+    const __m256d d5 = _mm256_sub_pd(d1, loadAvx(v, stride, kTriangleAbac));
+    const __m256d d6 = _mm256_sub_pd(d2, loadAvx(v, stride, kTriangleAcac));
+    const __m256d vc
+        = _mm256_sub_pd(_mm256_mul_pd(d1, d4), _mm256_mul_pd(d3, d2));
+    const __m256d vb
+        = _mm256_sub_pd(_mm256_mul_pd(d5, d2), _mm256_mul_pd(d1, d6));
+    const __m256d va
+        = _mm256_sub_pd(_mm256_mul_pd(d3, d6), _mm256_mul_pd(d5, d4));
+    const __m256d d43 = _mm256_sub_pd(d4, d3);
+    const __m256d d56 = _mm256_sub_pd(d5, d6);
+
+    // Regions from the last to the first, so the first one wins
+    const __m256d denom
+        = _mm256_div_pd(one, _mm256_add_pd(_mm256_add_pd(va, vb), vc));
+    __m256d s = _mm256_mul_pd(vb, denom);
+    __m256d t = _mm256_mul_pd(vc, denom);
+
+    __m256d mask = _mm256_and_pd(
+        lessEqualAvx(va, zero),
+        _mm256_and_pd(greaterEqualAvx(d43, zero), greaterEqualAvx(d56, zero)));
+    const __m256d x = _mm256_div_pd(d43, _mm256_add_pd(d43, d56));
+    s = _mm256_blendv_pd(s, _mm256_sub_pd(one, x), mask);
+    t = _mm256_blendv_pd(t, x, mask);
+
+    mask = _mm256_and_pd(
+        lessEqualAvx(vb, zero),
+        _mm256_and_pd(greaterEqualAvx(d2, zero), lessEqualAvx(d6, zero)));
+    s = _mm256_blendv_pd(s, zero, mask);
+    t = _mm256_blendv_pd(
+        t, _mm256_div_pd(d2, _mm256_sub_pd(d2, d6)), mask);
+
+    mask = _mm256_and_pd(greaterEqualAvx(d6, zero), lessEqualAvx(d5, d6));
+    s = _mm256_blendv_pd(s, zero, mask);
+    t = _mm256_blendv_pd(t, one, mask);
+
+    mask = _mm256_and_pd(
+        lessEqualAvx(vc, zero),
+        _mm256_and_pd(greaterEqualAvx(d1, zero), lessEqualAvx(d3, zero)));
+    s = _mm256_blendv_pd(
+        s, _mm256_div_pd(d1, _mm256_sub_pd(d1, d3)), mask);
+    t = _mm256_blendv_pd(t, zero, mask);
+
+    mask = _mm256_and_pd(greaterEqualAvx(d3, zero), lessEqualAvx(d4, d3));
+    s = _mm256_blendv_pd(s, one, mask);
+    t = _mm256_blendv_pd(t, zero, mask);
+
+    mask = _mm256_and_pd(lessEqualAvx(d1, zero), lessEqualAvx(d2, zero));
+    s = _mm256_blendv_pd(s, zero, mask);
+    t = _mm256_blendv_pd(t, zero, mask);
+
+    const __m256d dx = _mm256_sub_pd(px, _mm256_add_pd(
+        _mm256_add_pd(ax, _mm256_mul_pd(s, abx)), _mm256_mul_pd(t, acx)));
+    const __m256d dy = _mm256_sub_pd(py, _mm256_add_pd(
+        _mm256_add_pd(ay, _mm256_mul_pd(s, aby)), _mm256_mul_pd(t, acy)));
+    const __m256d dz = _mm256_sub_pd(pz, _mm256_add_pd(
+        _mm256_add_pd(az, _mm256_mul_pd(s, abz)), _mm256_mul_pd(t, acz)));
+    _mm256_storeu_pd(result, _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+        _mm256_mul_pd(dz, dz)));
+}
+
+#elif defined(JET_SIMD_NEON)
+
+inline void triangleDistancesSquaredNeon(
+    const double* cache,
+    size_t stride,
+    size_t position,
+    const Vector3D& p,
+    double* result) {
+    const double* v = cache + position;
+    auto load = [&](TriangleCacheStream stream) {
+        return vld1q_f64(v + stream * stride);
+    };
+    auto both = [](uint64x2_t a, uint64x2_t b) {
+        return vandq_u64(a, b);
+    };
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    const float64x2_t one = vdupq_n_f64(1.0);
+
+    const float64x2_t ax = load(kTriangleAx);
+    const float64x2_t ay = load(kTriangleAy);
+    const float64x2_t az = load(kTriangleAz);
+    const float64x2_t abx = load(kTriangleAbx);
+    const float64x2_t aby = load(kTriangleAby);
+    const float64x2_t abz = load(kTriangleAbz);
+    const float64x2_t acx = load(kTriangleAcx);
+    const float64x2_t acy = load(kTriangleAcy);
+    const float64x2_t acz = load(kTriangleAcz);
+    const float64x2_t px = vdupq_n_f64(p.x);
+    const float64x2_t py = vdupq_n_f64(p.y);
+    const float64x2_t pz = vdupq_n_f64(p.z);
+
+    const float64x2_t apx = vsubq_f64(px, ax);
+    const float64x2_t apy = vsubq_f64(py, ay);
+    const float64x2_t apz = vsubq_f64(pz, az);
+    const float64x2_t d1 = vaddq_f64(
+        vaddq_f64(vmulq_f64(abx, apx), vmulq_f64(aby, apy)),
+        vmulq_f64(abz, apz));
+    const float64x2_t d2 = vaddq_f64(
+        vaddq_f64(vmulq_f64(acx, apx), vmulq_f64(acy, apy)),
+        vmulq_f64(acz, apz));
+    const float64x2_t d3 = vsubq_f64(d1, load(kTriangleAbab));
+    const float64x2_t d4 = vsubq_f64(d2, load(kTriangleAbac));
+    const float64x2_t d5 = vsubq_f64(d1, load(kTriangleAbac));
+    const float64x2_t d6 = vsubq_f64(d2, load(kTriangleAcac));
+    const float64x2_t vc = vsubq_f64(vmulq_f64(d1, d4), vmulq_f64(d3, d2));
+    const float64x2_t vb = vsubq_f64(vmulq_f64(d5, d2), vmulq_f64(d1, d6));
+    const float64x2_t va = vsubq_f64(vmulq_f64(d3, d6), vmulq_f64(d5, d4));
+    const float64x2_t d43 = vsubq_f64(d4, d3);
+    const float64x2_t d56 = vsubq_f64(d5, d6);
+
+    // Regions from the last to the first, so the first one wins
+    const float64x2_t denom
+        = vdivq_f64(one, vaddq_f64(vaddq_f64(va, vb), vc));
+    float64x2_t s = vmulq_f64(vb, denom);
+    float64x2_t t = vmulq_f64(vc, denom);
+
+    uint64x2_t mask = both(
+        vcleq_f64(va, zero), both(vcgeq_f64(d43, zero), vcgeq_f64(d56, zero)));
+    const float64x2_t x = vdivq_f64(d43, vaddq_f64(d43, d56));
+    s = vbslq_f64(mask, vsubq_f64(one, x), s);
+    t = vbslq_f64(mask, x, t);
+
+    mask = both(
+        vcleq_f64(vb, zero), both(vcgeq_f64(d2, zero), vcleq_f64(d6, zero)));
+    s = vbslq_f64(mask, zero, s);
+    t = vbslq_f64(mask, vdivq_f64(d2, vsubq_f64(d2, d6)), t);
+
+    mask = both(vcgeq_f64(d6, zero), vcleq_f64(d5, d6));
+    s = vbslq_f64(mask, zero, s);
+    t = vbslq_f64(mask, one, t);
+
+    mask = both(
+        vcleq_f64(vc, zero), both(vcgeq_f64(d1, zero), vcleq_f64(d3, zero)));
+    s = vbslq_f64(mask, vdivq_f64(d1, vsubq_f64(d1, d3)), s);
+    t = vbslq_f64(mask, zero, t);
+
+    mask = both(vcgeq_f64(d3, zero), vcleq_f64(d4, d3));
+    s = vbslq_f64(mask, one, s);
+    t = vbslq_f64(mask, zero, t);
+
+    mask = both(vcleq_f64(d1, zero), vcleq_f64(d2, zero));
+    s = vbslq_f64(mask, zero, s);
+    t = vbslq_f64(mask, zero, t);
+
+    const float64x2_t dx = vsubq_f64(
+        px, vaddq_f64(vaddq_f64(ax, vmulq_f64(s, abx)), vmulq_f64(t, acx)));
+    const float64x2_t dy = vsubq_f64(
+        py, vaddq_f64(vaddq_f64(ay, vmulq_f64(s, aby)), vmulq_f64(t, acy)));
+    const float64x2_t dz = vsubq_f64(
+        pz, vaddq_f64(vaddq_f64(az, vmulq_f64(s, abz)), vmulq_f64(t, acz)));
+    vst1q_f64(result, vaddq_f64(
+        vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy)), vmulq_f64(dz, dz)));
+}
+
+#endif
+
+// Computes the squared distances from p to the count triangles of a cache
+// from the given position, where count is at most kTriangleCacheLanes. The
+// streams are stride apart and padded, so the kernels always evaluate
+// kTriangleCacheLanes triangles and result should have room for them.
+inline void triangleDistancesSquared(
+    const double* cache,
+    size_t stride,
+    size_t position,
+    size_t count,
+    const Vector3D& p,
+    double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+        case SimdInstructionSet::Avx:
+            triangleDistancesSquaredAvx(cache, stride, position, p, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            triangleDistancesSquaredSse2(cache, stride, position, p, result);
+            if (count > 2) {
+                triangleDistancesSquaredSse2(
+                    cache, stride, position + 2, p, result + 2);
+            }
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            triangleDistancesSquaredNeon(cache, stride, position, p, result);
+            if (count > 2) {
+                triangleDistancesSquaredNeon(
+                    cache, stride, position + 2, p, result + 2);
+            }
+            return;
+#endif
+        default:
+            triangleDistancesSquaredScalar(
+                cache, stride, position, count, p, result);
+            return;
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_JET_TRIANGLE_DISTANCE_HELPERS_H_
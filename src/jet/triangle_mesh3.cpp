@@ -2,14 +2,24 @@
 
 #include <pch.h>
 #include <jet/triangle_mesh3.h>
+#include <jet/triangle_mesh_stream_writer3.h>
 #include <jet/parallel.h>
+#include <mapped_file.h>
+#include <obj_reader_helpers.h>
+#include <triangle_distance_helpers.h>
+#include <triangle_mesh_io_helpers.h>
+#include <triangle_mesh_topology_helpers.h>
 
 #include <obj/obj_parser.hpp>
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <limits>
 #include <string>
 #include <utility>  // just make cpplint happy..
+#include <vector>
 
 using namespace jet;
 
@@ -23,6 +33,31 @@ inline std::ostream& operator<<(std::ostream& strm, const Vector3D& v) {
     return strm;
 }
 
+static const size_t kPlyBlockSize = 1 << 16;
+static const size_t kObjChunkSize = 1 << 20;
+
+inline bool isLittleEndian() {
+    const uint16_t one = 1;
+    return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
+
+inline std::vector<BoundingBox3D> triangleBounds(
+    const TriangleMesh3::Vector3DArray& points,
+    const TriangleMesh3::IndexArray& pointIndices) {
+    std::vector<BoundingBox3D> bounds(pointIndices.size());
+    parallelFor(kZeroSize, bounds.size(), [&](size_t i) {
+        const Point3UI& face = pointIndices[i];
+        bounds[i] = BoundingBox3D(points[face[0]], points[face[1]]);
+        bounds[i].merge(points[face[2]]);
+    });
+    return bounds;
+}
+
+inline TriangleEdges3 triangleEdges(
+    const TriangleMesh3::Vector3DArray& points, const Point3UI& face) {
+    return TriangleEdges3(points[face[0]], points[face[1]], points[face[2]]);
+}
+
 TriangleMesh3::TriangleMesh3() {
 }
 
@@ -30,98 +65,201 @@ TriangleMesh3::TriangleMesh3(const TriangleMesh3& other) : Surface3(other) {
     set(other);
 }
 
+TriangleMesh3::TriangleMesh3(TriangleMesh3&& other) noexcept
+    : Surface3(other),
+      _points(std::move(other._points)),
+      _normals(std::move(other._normals)),
+      _uvs(std::move(other._uvs)),
+      _pointIndices(std::move(other._pointIndices)),
+      _normalIndices(std::move(other._normalIndices)),
+      _uvIndices(std::move(other._uvIndices)),
+      _translation(other._translation),
+      _orientation(other._orientation),
+      _rotation(other._rotation),
+      _inverseRotation(other._inverseRotation),
+      _hasTransform(other._hasTransform) {
+    other._isBvhValid = false;
+    other.setTransform(Vector3D(), QuaternionD());
+}
+
 Vector3D TriangleMesh3::closestPoint(const Vector3D& otherPoint) const {
     static const double m = std::numeric_limits<double>::max();
-    Vector3D minDistPt(m, m, m);
-    double minDistSquared = m;
-
-    size_t n = numberOfTriangles();
-    for (size_t i = 0; i < n; ++i) {
-        Triangle3 tri = triangle(i);
-        Vector3D pt = tri.closestPoint(otherPoint);
-        double distSquared = (otherPoint - pt).lengthSquared();
-        if (distSquared < minDistSquared) {
-            minDistSquared = distSquared;
-            minDistPt = pt;
-        }
+
+    Vector3D localPoint = toLocal(otherPoint);
+    size_t i = closestTriangle(localPoint);
+    if (i == kMaxSize) {
+        return Vector3D(m, m, m);
     }
 
-    return minDistPt;
+    return toWorld(closestPointOnTriangle(
+        triangleEdges(_points, _pointIndices[i]), localPoint));
 }
 
 Vector3D TriangleMesh3::actualClosestNormal(const Vector3D& otherPoint) const {
-    static const double m = std::numeric_limits<double>::max();
-    Vector3D minDistPt(m, m, m);
-    Vector3D minDistNormal(1, 0, 0);
-    double minDistSquared = m;
-
-    size_t n = numberOfTriangles();
-    for (size_t i = 0; i < n; ++i) {
-        Triangle3 tri = triangle(i);
-        Vector3D pt = tri.closestPoint(otherPoint);
-        double distSquared = (otherPoint - pt).lengthSquared();
-        if (distSquared < minDistSquared) {
-            minDistSquared = distSquared;
-            minDistPt = pt;
-            minDistNormal = tri.closestNormal(otherPoint);
-        }
+    Vector3D localPoint = toLocal(otherPoint);
+    size_t i = closestTriangle(localPoint);
+    if (i == kMaxSize) {
+        return Vector3D(1, 0, 0);
     }
 
-    return minDistNormal;
+    return toWorldDirection(triangle(i).closestNormal(localPoint));
 }
 
 SurfaceRayIntersection3 TriangleMesh3::actualClosestIntersection(
-    const Ray3D& ray) const {
-    SurfaceRayIntersection3 intersection;
+    const Ray3D& otherRay) const {
+    buildBvh();
 
-    size_t n = numberOfTriangles();
+    // The rotation keeps the length of the direction, so t is the same in
+    // both frames
+    const Ray3D ray = toLocal(otherRay);
+
+    SurfaceRayIntersection3 intersection;
     double t = std::numeric_limits<double>::max();
-    for (size_t i = 0; i < n; ++i) {
-        Triangle3 tri = triangle(i);
+    _bvh.forEachRayCandidate(ray, [&](size_t i) {
         SurfaceRayIntersection3 tmpIntersection
-            = tri.closestIntersection(ray);
+            = triangle(i).closestIntersection(ray);
         if (tmpIntersection.t < t) {
             t = tmpIntersection.t;
             intersection = tmpIntersection;
         }
-    }
+        return tmpIntersection.t;
+    });
 
+    if (intersection.isIntersecting) {
+        intersection.point = toWorld(intersection.point);
+        intersection.normal = toWorldDirection(intersection.normal);
+    }
     return intersection;
 }
 
 BoundingBox3D TriangleMesh3::boundingBox() const {
-    BoundingBox3D box;
-    size_t n = _pointIndices.size();
-    for (size_t i = 0; i < n; ++i) {
-        const Point3UI& face = _pointIndices[i];
-        box.merge(_points[face[0]]);
-        box.merge(_points[face[1]]);
-        box.merge(_points[face[2]]);
-    }
-    return box;
-}
-
-bool TriangleMesh3::intersects(const Ray3D& ray) const {
-    size_t n = numberOfTriangles();
-    for (size_t i = 0; i < n; ++i) {
-        Triangle3 tri = triangle(i);
-        if (tri.intersects(ray)) {
-            return true;
-        }
+    return parallelReduce(
+        kZeroSize,
+        _pointIndices.size(),
+        BoundingBox3D(),
+        [&](size_t begin, size_t end, BoundingBox3D box) {
+            for (size_t i = begin; i < end; ++i) {
+                const Point3UI& face = _pointIndices[i];
+                box.merge(toWorld(_points[face[0]]));
+                box.merge(toWorld(_points[face[1]]));
+                box.merge(toWorld(_points[face[2]]));
+            }
+            return box;
+        },
+        [](BoundingBox3D a, const BoundingBox3D& b) {
+            a.merge(b);
+            return a;
+        });
+}
+
+bool TriangleMesh3::intersects(const Ray3D& otherRay) const {
+    buildBvh();
+
+    const Ray3D ray = toLocal(otherRay);
+    return _bvh.anyRayHit(ray, [&](size_t i) {
+        return triangle(i).intersects(ray);
+    });
+}
+
+void TriangleMesh3::batchClosestPoint(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    static const double m = std::numeric_limits<double>::max();
+
+    Array1<Vector3D> buffer;
+    ConstArrayAccessor1<Vector3D> localPoints = toLocal(otherPoints, &buffer);
+    forEachClosestTriangle(localPoints, [&](size_t i, size_t tri) {
+        result[i] = (tri == kMaxSize)
+            ? Vector3D(m, m, m)
+            : toWorld(closestPointOnTriangle(
+                triangleEdges(_points, _pointIndices[tri]), localPoints[i]));
+    });
+}
+
+void TriangleMesh3::batchClosestDistance(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<double> result) const {
+    Array1<Vector3D> buffer;
+    ConstArrayAccessor1<Vector3D> localPoints = toLocal(otherPoints, &buffer);
+    forEachClosestTriangle(localPoints, [&](size_t i, size_t tri) {
+        result[i] = (tri == kMaxSize)
+            ? std::numeric_limits<double>::max()
+            : localPoints[i].distanceTo(closestPointOnTriangle(
+                triangleEdges(_points, _pointIndices[tri]), localPoints[i]));
+    });
+}
+
+void TriangleMesh3::actualBatchClosestNormal(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    ArrayAccessor1<Vector3D> result) const {
+    Array1<Vector3D> buffer;
+    ConstArrayAccessor1<Vector3D> localPoints = toLocal(otherPoints, &buffer);
+    forEachClosestTriangle(localPoints, [&](size_t i, size_t tri) {
+        result[i] = (tri == kMaxSize)
+            ? Vector3D(1, 0, 0)
+            : toWorldDirection(triangle(tri).closestNormal(localPoints[i]));
+    });
+}
+
+void TriangleMesh3::actualBatchClosestIntersection(
+    const ConstArrayAccessor1<Ray3D>& otherRays,
+    ArrayAccessor1<SurfaceRayIntersection3> result) const {
+    buildBvh();
+
+    Array1<Ray3D> buffer;
+    ConstArrayAccessor1<Ray3D> rays = otherRays;
+    if (_hasTransform) {
+        buffer.resize(otherRays.size());
+        parallelFor(kZeroSize, otherRays.size(), [&](size_t i) {
+            buffer[i] = toLocal(otherRays[i]);
+        });
+        rays = buffer.constAccessor();
     }
-    return false;
+
+    const size_t packetSize = Bvh3::kPacketSize;
+    const size_t numberOfPackets = (rays.size() + packetSize - 1) / packetSize;
+    parallelFor(kZeroSize, numberOfPackets, [&](size_t p) {
+        size_t begin = p * packetSize;
+        size_t count = std::min(packetSize, rays.size() - begin);
+        double t[Bvh3::kPacketSize];
+        for (size_t k = 0; k < count; ++k) {
+            t[k] = std::numeric_limits<double>::max();
+            result[begin + k] = SurfaceRayIntersection3();
+        }
+
+        _bvh.forEachRayCandidatePacket(
+            &rays[begin], count, [&](size_t i, size_t k) {
+                SurfaceRayIntersection3 tmpIntersection
+                    = triangle(i).closestIntersection(rays[begin + k]);
+                if (tmpIntersection.t < t[k]) {
+                    t[k] = tmpIntersection.t;
+                    result[begin + k] = tmpIntersection;
+                }
+                return tmpIntersection.t;
+            });
+
+        if (_hasTransform) {
+            for (size_t k = 0; k < count; ++k) {
+                SurfaceRayIntersection3& intersection = result[begin + k];
+                if (intersection.isIntersecting) {
+                    intersection.point = toWorld(intersection.point);
+                    intersection.normal
+                        = toWorldDirection(intersection.normal);
+                }
+            }
+        }
+    });
 }
 
 double TriangleMesh3::closestDistance(const Vector3D& otherPoint) const {
-    double minDist = std::numeric_limits<double>::max();
-
-    size_t n = numberOfTriangles();
-    for (size_t i = 0; i < n; ++i) {
-        Triangle3 tri = triangle(i);
-        minDist = std::min(minDist, tri.closestDistance(otherPoint));
+    Vector3D localPoint = toLocal(otherPoint);
+    size_t i = closestTriangle(localPoint);
+    if (i == kMaxSize) {
+        return std::numeric_limits<double>::max();
     }
 
-    return minDist;
+    return localPoint.distanceTo(closestPointOnTriangle(
+        triangleEdges(_points, _pointIndices[i]), localPoint));
 }
 
 void TriangleMesh3::clear() {
@@ -131,6 +269,9 @@ void TriangleMesh3::clear() {
     _pointIndices.clear();
     _normalIndices.clear();
     _uvIndices.clear();
+    setTransform(Vector3D(), QuaternionD());
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::set(const TriangleMesh3& other) {
@@ -140,6 +281,9 @@ void TriangleMesh3::set(const TriangleMesh3& other) {
     _pointIndices.set(other._pointIndices);
     _normalIndices.set(other._normalIndices);
     _uvIndices.set(other._uvIndices);
+    setTransform(other._translation, other._orientation);
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::swap(TriangleMesh3& other) {
@@ -149,24 +293,47 @@ void TriangleMesh3::swap(TriangleMesh3& other) {
     _pointIndices.swap(other._pointIndices);
     _normalIndices.swap(other._normalIndices);
     _uvIndices.swap(other._uvIndices);
+    std::swap(_translation, other._translation);
+    std::swap(_orientation, other._orientation);
+    std::swap(_rotation, other._rotation);
+    std::swap(_inverseRotation, other._inverseRotation);
+    std::swap(_hasTransform, other._hasTransform);
+
+    invalidateBvh();
+    other.invalidateBvh();
 }
 
 double TriangleMesh3::area() const {
-    double a = 0;
-    for (size_t i = 0; i < numberOfTriangles(); ++i) {
-        Triangle3 tri = triangle(i);
-        a += tri.area();
-    }
-    return a;
+    return parallelReduce(
+        kZeroSize,
+        numberOfTriangles(),
+        0.0,
+        [&](size_t begin, size_t end, double a) {
+            for (size_t i = begin; i < end; ++i) {
+                const Point3UI& face = _pointIndices[i];
+                const Vector3D& p0 = _points[face[0]];
+                a += 0.5 * (_points[face[1]] - p0).cross(
+                    _points[face[2]] - p0).length();
+            }
+            return a;
+        },
+        std::plus<double>());
 }
 
 double TriangleMesh3::volume() const {
-    double vol = 0;
-    for (size_t i = 0; i < numberOfTriangles(); ++i) {
-        Triangle3 tri = triangle(i);
-        vol += tri.points[0].dot(tri.points[1].cross(tri.points[2])) / 6.f;
-    }
-    return vol;
+    return parallelReduce(
+        kZeroSize,
+        numberOfTriangles(),
+        0.0,
+        [&](size_t begin, size_t end, double vol) {
+            for (size_t i = begin; i < end; ++i) {
+                const Point3UI& face = _pointIndices[i];
+                vol += _points[face[0]].dot(
+                    _points[face[1]].cross(_points[face[2]])) / 6.f;
+            }
+            return vol;
+        },
+        std::plus<double>());
 }
 
 const Vector3D& TriangleMesh3::point(size_t i) const {
@@ -277,6 +444,8 @@ void TriangleMesh3::addUv(const Vector2D& t) {
 
 void TriangleMesh3::addPointTriangle(const Point3UI& newPointIndices) {
     _pointIndices.append(newPointIndices);
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::addPointNormalTriangle(
@@ -288,6 +457,8 @@ void TriangleMesh3::addPointNormalTriangle(
 
     _pointIndices.append(newPointIndices);
     _normalIndices.append(newNormalIndices);
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::addPointNormalUvTriangle(
@@ -301,6 +472,8 @@ void TriangleMesh3::addPointNormalUvTriangle(
     _pointIndices.append(newPointIndices);
     _normalIndices.append(newNormalIndices);
     _uvIndices.append(newUvIndices);
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::addPointUvTriangle(
@@ -311,6 +484,8 @@ void TriangleMesh3::addPointUvTriangle(
     JET_ASSERT(_pointIndices.size() == _uvs.size());
     _pointIndices.append(newPointIndices);
     _uvIndices.append(newUvIndices);
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::addTriangle(const Triangle3& tri) {
@@ -331,91 +506,349 @@ void TriangleMesh3::addTriangle(const Triangle3& tri) {
     _pointIndices.append(newPointIndices);
     _normalIndices.append(newNormalIndices);
     _uvIndices.append(newUvIndices);
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::setFaceNormal() {
     _normals.resize(_points.size());
     _normalIndices.set(_pointIndices);
 
-    for (size_t i = 0; i < numberOfTriangles(); ++i) {
-        Triangle3 tri = triangle(i);
-        Vector3D n = tri.faceNormal();
-        Point3UI f = _pointIndices[i];
-        _normals[f.x] = n;
-        _normals[f.y] = n;
-        _normals[f.z] = n;
-    }
+    // Each point takes the normal of its last triangle, as if the triangles
+    // were written in order
+    std::vector<size_t> offsets;
+    std::vector<size_t> pointTriangles;
+    buildPointToTriangles(
+        _pointIndices, _points.size(), &offsets, &pointTriangles);
+
+    parallelFor(kZeroSize, _points.size(), [&](size_t i) {
+        if (offsets[i] < offsets[i + 1]) {
+            size_t t = pointTriangles[offsets[i + 1] - 1];
+            const Point3UI& face = _pointIndices[t];
+            const Vector3D& p0 = _points[face[0]];
+            _normals[i] = (_points[face[1]] - p0).cross(
+                _points[face[2]] - p0).normalized();
+        }
+    });
 }
 
 void TriangleMesh3::setAngleWeightedVertexNormal() {
-    _normals.clear();
-    _normalIndices.clear();
+    const size_t numberOfTris = numberOfTriangles();
+
+    // Angle-weighted normals of the corners of each triangle
+    Array1<double> angleWeights(3 * numberOfTris);
+    Vector3DArray cornerNormals(3 * numberOfTris);
+    parallelFor(kZeroSize, numberOfTris, [&](size_t i) {
+        Vector3D pts[3];
+        for (int j = 0; j < 3; j++) {
+            pts[j] = _points[_pointIndices[i][j]];
+        }
+
+        for (int j = 0; j < 3; j++) {
+            Vector3D e0 = pts[(j + 1) % 3] - pts[j];
+            Vector3D e1 = pts[(j + 2) % 3] - pts[j];
+            e0.normalize();
+            e1.normalize();
+            Vector3D normal = e0.cross(e1);
+            normal.normalize();
+            double cosangle = clamp(e0.dot(e1), -1.0, 1.0);
+            double angle = std::acos(cosangle);
+            angleWeights[3 * i + j] = angle;
+            cornerNormals[3 * i + j] = angle * normal;
+        }
+    });
+
+    // Gathers the corners around each point in the order of the triangles,
+    // so the sums do not depend on the number of threads
+    std::vector<size_t> offsets;
+    std::vector<size_t> pointTriangles;
+    buildPointToTriangles(
+        _pointIndices, _points.size(), &offsets, &pointTriangles);
 
-    Array1<double> angleWeights(_points.size());
     Vector3DArray pseudoNormals(_points.size());
+    parallelFor(kZeroSize, _points.size(), [&](size_t i) {
+        double angleWeight = 0.0;
+        Vector3D pseudoNormal;
+        for (size_t n = offsets[i]; n < offsets[i + 1]; ++n) {
+            size_t t = pointTriangles[n];
+            for (size_t j = 0; j < 3; j++) {
+                if (_pointIndices[t][j] == i) {
+                    angleWeight += angleWeights[3 * t + j];
+                    pseudoNormal += cornerNormals[3 * t + j];
+                }
+            }
+        }
 
-    for (size_t i = 0; i < _points.size(); ++i) {
-        angleWeights[i] = 0;
-        pseudoNormals[i] = Vector3D();
-    }
+        if (angleWeight > 0) {
+            pseudoNormal /= angleWeight;
+        }
+        pseudoNormals[i] = pseudoNormal;
+    });
 
-    for (size_t i = 0; i < numberOfTriangles(); ++i) {
-        Vector3D pts[3];
-        Vector3D normal, e0, e1;
-        double cosangle, angle;
-        size_t idx[3];
+    _normals.swap(pseudoNormals);
+    _normalIndices.set(_pointIndices);
+}
 
-        // Quick references
-        for (int j = 0; j < 3; j++) {
-            idx[j] = _pointIndices[i][j];
-            pts[j] = _points[idx[j]];
+void TriangleMesh3::decimate(double maxError) {
+    const size_t numberOfPts = _points.size();
+    const double maxCost = maxError * maxError;
+
+    // Normals and UVs indexed like the points survive the collapses
+    const bool keepsNormals = _normals.size() == numberOfPts
+        && _normalIndices.size() == _pointIndices.size()
+        && std::equal(
+            _normalIndices.begin(),
+            _normalIndices.end(),
+            _pointIndices.begin());
+    const bool keepsUvs = _uvs.size() == numberOfPts
+        && _uvIndices.size() == _pointIndices.size()
+        && std::equal(
+            _uvIndices.begin(), _uvIndices.end(), _pointIndices.begin());
+
+    std::vector<size_t> offsets;
+    std::vector<size_t> pointTriangles;
+    buildPointToTriangles(
+        _pointIndices, numberOfPts, &offsets, &pointTriangles);
+
+    // Quadrics of the planes of the original triangles around each point
+    std::vector<TriangleMeshQuadric> quadrics(numberOfPts);
+    parallelFor(kZeroSize, numberOfPts, [&](size_t i) {
+        for (size_t n = offsets[i]; n < offsets[i + 1]; ++n) {
+            const Point3UI& face = _pointIndices[pointTriangles[n]];
+            Vector3D normal = (_points[face[1]] - _points[face[0]]).cross(
+                _points[face[2]] - _points[face[0]]);
+            double length = normal.length();
+            if (length > 0.0) {
+                quadrics[i].addPlane(normal / length, _points[face[0]]);
+            }
         }
+    });
+
+    // The points are processed in blocks that share the scratch buffers
+    const size_t kBlockSize = 1024;
+    const size_t numberOfBlocks = (numberOfPts + kBlockSize - 1) / kBlockSize;
+    auto forEachPointInBlocks = [&](
+        const std::function<void(size_t, std::vector<size_t>*,
+                                 std::vector<size_t>*)>& func) {
+        parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+            std::vector<size_t> neighbors;
+            std::vector<size_t> targetNeighbors;
+            size_t end = std::min((b + 1) * kBlockSize, numberOfPts);
+            for (size_t v = b * kBlockSize; v < end; ++v) {
+                func(v, &neighbors, &targetNeighbors);
+            }
+        });
+    };
+
+    typedef std::pair<double, size_t> CollapseKey;
+    std::vector<size_t> targets(numberOfPts);
+    std::vector<CollapseKey> keys(numberOfPts);
+    std::vector<CollapseKey> ringMinKeys(numberOfPts);
+    std::vector<char> isRemovedTriangle;
+
+    while (true) {
+        // Finds the cheapest valid collapse of each point
+        forEachPointInBlocks([&](
+            size_t v,
+            std::vector<size_t>* neighbors,
+            std::vector<size_t>* targetNeighbors) {
+            targets[v] = kMaxSize;
+            keys[v] = CollapseKey(kMaxD, v);
+
+            collectPointNeighbors(
+                v, _pointIndices, offsets, pointTriangles, neighbors);
+            if (neighbors->size() <= 3) {
+                return;
+            }
+
+            // Keeps the points on the open boundaries and the non-manifold
+            // edges, whose edges are not shared by exactly two triangles
+            for (size_t u : *neighbors) {
+                size_t count = 0;
+                for (size_t n = offsets[v]; n < offsets[v + 1]; ++n) {
+                    const Point3UI& face = _pointIndices[pointTriangles[n]];
+                    if (face[0] == u || face[1] == u || face[2] == u) {
+                        ++count;
+                    }
+                }
+                if (count != 2) {
+                    return;
+                }
+            }
 
-        // Angle for point 0
-        e0 = pts[1] - pts[0];
-        e1 = pts[2] - pts[0];
-        e0.normalize();
-        e1.normalize();
-        normal = e0.cross(e1);
-        normal.normalize();
-        cosangle = clamp(e0.dot(e1), -1.0, 1.0);
-        angle = std::acos(cosangle);
-        angleWeights[idx[0]] += angle;
-        pseudoNormals[idx[0]] += angle*normal;
-
-        // Angle for point 1
-        e0 = pts[2] - pts[1];
-        e1 = pts[0] - pts[1];
-        e0.normalize();
-        e1.normalize();
-        normal = e0.cross(e1);
-        normal.normalize();
-        cosangle = clamp(e0.dot(e1), -1.0, 1.0);
-        angle = std::acos(cosangle);
-        angleWeights[idx[1]] += angle;
-        pseudoNormals[idx[1]] += angle*normal;
-
-        // Angle for point 2
-        e0 = pts[0] - pts[2];
-        e1 = pts[1] - pts[2];
-        e0.normalize();
-        e1.normalize();
-        normal = e0.cross(e1);
-        normal.normalize();
-        cosangle = clamp(e0.dot(e1), -1.0, 1.0);
-        angle = std::acos(cosangle);
-        angleWeights[idx[2]] += angle;
-        pseudoNormals[idx[2]] += angle*normal;
-    }
-
-    for (size_t i = 0; i < _points.size(); ++i) {
-        if (angleWeights[i] > 0) {
-            pseudoNormals[i] /= angleWeights[i];
+            for (size_t w : *neighbors) {
+                const Vector3D& target = _points[w];
+                double cost = quadrics[v].evaluate(target)
+                    + quadrics[w].evaluate(target);
+                if (cost > maxCost || cost >= keys[v].first) {
+                    continue;
+                }
+
+                // The two points must share only the two points opposite to
+                // their edge, or the collapse pinches the surface
+                collectPointNeighbors(
+                    w, _pointIndices, offsets, pointTriangles,
+                    targetNeighbors);
+                size_t numberOfShared = 0;
+                for (size_t u : *neighbors) {
+                    numberOfShared += std::binary_search(
+                        targetNeighbors->begin(), targetNeighbors->end(), u);
+                }
+                if (numberOfShared != 2) {
+                    continue;
+                }
+
+                // The moved triangles must not flip or turn sharply
+                bool isValid = true;
+                for (size_t n = offsets[v]; n < offsets[v + 1] && isValid;
+                     ++n) {
+                    const Point3UI& face = _pointIndices[pointTriangles[n]];
+                    if (face[0] == w || face[1] == w || face[2] == w) {
+                        continue;
+                    }
+
+                    Vector3D pts[3];
+                    for (size_t c = 0; c < 3; ++c) {
+                        pts[c] = _points[face[c]];
+                    }
+                    Vector3D oldNormal
+                        = (pts[1] - pts[0]).cross(pts[2] - pts[0]);
+                    for (size_t c = 0; c < 3; ++c) {
+                        if (face[c] == v) {
+                            pts[c] = target;
+                        }
+                    }
+                    Vector3D newNormal
+                        = (pts[1] - pts[0]).cross(pts[2] - pts[0]);
+
+                    double oldLength = oldNormal.length();
+                    double newLength = newNormal.length();
+                    isValid = newLength > 0.0
+                        && (oldLength == 0.0
+                            || newNormal.dot(oldNormal)
+                                > 0.5 * newLength * oldLength);
+                }
+
+                if (isValid) {
+                    targets[v] = w;
+                    keys[v].first = cost;
+                }
+            }
+        });
+
+        // Applies the collapses that are the cheapest within two rings, so
+        // that no two of them touch the same triangles or neighbors
+        forEachPointInBlocks([&](
+            size_t v,
+            std::vector<size_t>* neighbors,
+            std::vector<size_t>*) {
+            collectPointNeighbors(
+                v, _pointIndices, offsets, pointTriangles, neighbors);
+            ringMinKeys[v] = keys[v];
+            for (size_t u : *neighbors) {
+                ringMinKeys[v] = std::min(ringMinKeys[v], keys[u]);
+            }
+        });
+
+        isRemovedTriangle.assign(_pointIndices.size(), 0);
+        std::vector<char> isCollapsed(numberOfPts, 0);
+        forEachPointInBlocks([&](
+            size_t v,
+            std::vector<size_t>* neighbors,
+            std::vector<size_t>*) {
+            if (targets[v] == kMaxSize || ringMinKeys[v] != keys[v]) {
+                return;
+            }
+
+            collectPointNeighbors(
+                v, _pointIndices, offsets, pointTriangles, neighbors);
+            for (size_t u : *neighbors) {
+                if (ringMinKeys[u] < keys[v]) {
+                    return;
+                }
+            }
+
+            size_t w = targets[v];
+            for (size_t n = offsets[v]; n < offsets[v + 1]; ++n) {
+                size_t t = pointTriangles[n];
+                Point3UI& face = _pointIndices[t];
+                if (face[0] == w || face[1] == w || face[2] == w) {
+                    isRemovedTriangle[t] = 1;
+                } else {
+                    for (size_t c = 0; c < 3; ++c) {
+                        if (face[c] == v) {
+                            face[c] = w;
+                        }
+                    }
+                }
+            }
+            quadrics[w] += quadrics[v];
+            isCollapsed[v] = 1;
+        });
+
+        if (std::find(isCollapsed.begin(), isCollapsed.end(), 1)
+            == isCollapsed.end()) {
+            break;
         }
+
+        size_t numberOfKept = 0;
+        for (size_t t = 0; t < _pointIndices.size(); ++t) {
+            if (!isRemovedTriangle[t]) {
+                _pointIndices[numberOfKept++] = _pointIndices[t];
+            }
+        }
+        _pointIndices.resize(numberOfKept);
+
+        buildPointToTriangles(
+            _pointIndices, numberOfPts, &offsets, &pointTriangles);
     }
 
-    std::swap(pseudoNormals, _normals);
-    _normalIndices.set(_pointIndices);
+    // Removes the points that are no longer used
+    std::vector<size_t> newIndices(numberOfPts, kMaxSize);
+    size_t numberOfUsed = 0;
+    for (size_t i = 0; i < numberOfPts; ++i) {
+        if (offsets[i] < offsets[i + 1]) {
+            newIndices[i] = numberOfUsed++;
+        }
+    }
+
+    Vector3DArray points(numberOfUsed);
+    Vector3DArray normals(keepsNormals ? numberOfUsed : 0);
+    Vector2DArray uvs(keepsUvs ? numberOfUsed : 0);
+    parallelFor(kZeroSize, numberOfPts, [&](size_t i) {
+        size_t j = newIndices[i];
+        if (j != kMaxSize) {
+            points[j] = _points[i];
+            if (keepsNormals) {
+                normals[j] = _normals[i];
+            }
+            if (keepsUvs) {
+                uvs[j] = _uvs[i];
+            }
+        }
+    });
+    parallelFor(kZeroSize, _pointIndices.size(), [&](size_t t) {
+        Point3UI& face = _pointIndices[t];
+        for (size_t c = 0; c < 3; ++c) {
+            face[c] = newIndices[face[c]];
+        }
+    });
+
+    _points.swap(points);
+    _normals.swap(normals);
+    _uvs.swap(uvs);
+    if (keepsNormals) {
+        _normalIndices.set(_pointIndices);
+    } else {
+        _normalIndices.clear();
+    }
+    if (keepsUvs) {
+        _uvIndices.set(_pointIndices);
+    } else {
+        _uvIndices.clear();
+    }
+
+    invalidateBvh();
 }
 
 void TriangleMesh3::scale(double factor) {
@@ -425,6 +858,8 @@ void TriangleMesh3::scale(double factor) {
         [this, factor](size_t i) {
             _points[i] *= factor;
         });
+
+    refitBvh();
 }
 
 void TriangleMesh3::translate(const Vector3D& t) {
@@ -434,6 +869,8 @@ void TriangleMesh3::translate(const Vector3D& t) {
         [this, t](size_t i) {
             _points[i] += t;
         });
+
+    refitBvh();
 }
 
 void TriangleMesh3::rotate(const Quaternion<double>& q) {
@@ -450,6 +887,47 @@ void TriangleMesh3::rotate(const Quaternion<double>& q) {
         [this, q](size_t i) {
             _normals[i] = q * _normals[i];
         });
+
+    refitBvh();
+}
+
+void TriangleMesh3::setTransform(
+    const Vector3D& translation, const QuaternionD& orientation) {
+    _translation = translation;
+    _orientation = orientation.normalized();
+    _rotation = _orientation.matrix3();
+    _inverseRotation = _rotation.transposed();
+    _hasTransform
+        = (_translation != Vector3D() || _orientation != QuaternionD());
+}
+
+const Vector3D& TriangleMesh3::translation() const {
+    return _translation;
+}
+
+const QuaternionD& TriangleMesh3::orientation() const {
+    return _orientation;
+}
+
+bool TriangleMesh3::hasTransform() const {
+    return _hasTransform;
+}
+
+void TriangleMesh3::bakeTransform() {
+    if (!_hasTransform) {
+        return;
+    }
+
+    parallelFor(kZeroSize, numberOfPoints(), [this](size_t i) {
+        _points[i] = toWorld(_points[i]);
+    });
+
+    parallelFor(kZeroSize, numberOfNormals(), [this](size_t i) {
+        _normals[i] = toWorldDirection(_normals[i]);
+    });
+
+    setTransform(Vector3D(), QuaternionD());
+    refitBvh();
 }
 
 void TriangleMesh3::writeObj(std::ostream* strm) const {
@@ -638,7 +1116,420 @@ bool TriangleMesh3::readObj(std::istream* strm) {
     return parser.parse(*strm);
 }
 
+bool TriangleMesh3::readObj(const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.isValid()) {
+        return false;
+    }
+
+    const char* data = file.data();
+    const size_t size = file.size();
+
+    // Split the file into line-aligned chunks
+    std::vector<size_t> chunkBegins(1, 0);
+    while (chunkBegins.back() + kObjChunkSize < size) {
+        size_t pos = chunkBegins.back() + kObjChunkSize;
+        const char* newLine = static_cast<const char*>(
+            std::memchr(data + pos, '\n', size - pos));
+        if (newLine == nullptr || newLine + 1 == data + size) {
+            break;
+        }
+        chunkBegins.push_back(static_cast<size_t>(newLine + 1 - data));
+    }
+    chunkBegins.push_back(size);
+
+    const size_t numberOfChunks = chunkBegins.size() - 1;
+    std::vector<ObjChunk> chunks(numberOfChunks);
+    parallelFor(kZeroSize, numberOfChunks, kOneSize, [&](size_t c) {
+        parseObjChunk(
+            data + chunkBegins[c], data + chunkBegins[c + 1], &chunks[c]);
+    });
+
+    for (const ObjChunk& chunk : chunks) {
+        if (!chunk.isValid) {
+            return false;
+        }
+    }
+
+    // Exclusive scans of the counts give the offsets of the chunks, starting
+    // from the current size of this mesh
+    std::vector<size_t> pointOffsets(numberOfChunks + 1, numberOfPoints());
+    std::vector<size_t> normalOffsets(numberOfChunks + 1, numberOfNormals());
+    std::vector<size_t> uvOffsets(numberOfChunks + 1, numberOfUvs());
+    std::vector<size_t> pointIndexOffsets(
+        numberOfChunks + 1, _pointIndices.size());
+    std::vector<size_t> normalIndexOffsets(
+        numberOfChunks + 1, _normalIndices.size());
+    std::vector<size_t> uvIndexOffsets(numberOfChunks + 1, _uvIndices.size());
+    for (size_t c = 0; c < numberOfChunks; ++c) {
+        pointOffsets[c + 1] = pointOffsets[c] + chunks[c].points.size();
+        normalOffsets[c + 1] = normalOffsets[c] + chunks[c].normals.size();
+        uvOffsets[c + 1] = uvOffsets[c] + chunks[c].uvs.size();
+        pointIndexOffsets[c + 1]
+            = pointIndexOffsets[c] + chunks[c].pointIndices.size();
+        normalIndexOffsets[c + 1]
+            = normalIndexOffsets[c] + chunks[c].normalIndices.size();
+        uvIndexOffsets[c + 1] = uvIndexOffsets[c] + chunks[c].uvIndices.size();
+    }
+
+    _points.resize(pointOffsets.back());
+    _normals.resize(normalOffsets.back());
+    _uvs.resize(uvOffsets.back());
+    _pointIndices.resize(pointIndexOffsets.back());
+    _normalIndices.resize(normalIndexOffsets.back());
+    _uvIndices.resize(uvIndexOffsets.back());
+
+    // Absolute indices are relative to the elements of this mesh before
+    // reading, and relative ones to the chunk.
+    auto resolve = [](
+        const std::vector<Point3<int64_t>>& chunkIndices,
+        const std::vector<size_t>& offsets,
+        size_t c,
+        IndexArray* indices,
+        size_t indexOffset) {
+        const int64_t base = static_cast<int64_t>(offsets.front());
+        const int64_t chunkBase = static_cast<int64_t>(offsets[c]);
+        const int64_t count = static_cast<int64_t>(offsets.back());
+        bool isValid = true;
+        for (size_t i = 0; i < chunkIndices.size(); ++i) {
+            Point3UI& index = (*indices)[indexOffset + i];
+            for (size_t j = 0; j < 3; ++j) {
+                int64_t v = chunkIndices[i][j];
+                v = (v >= 0) ? base + v
+                             : chunkBase + v + kObjRelativeIndexOffset;
+                isValid &= (v >= base && v < count);
+                index[j] = static_cast<size_t>(v);
+            }
+        }
+        return isValid;
+    };
+
+    std::vector<char> isChunkValid(numberOfChunks);
+    parallelFor(kZeroSize, numberOfChunks, kOneSize, [&](size_t c) {
+        const ObjChunk& chunk = chunks[c];
+        std::copy(
+            chunk.points.begin(), chunk.points.end(),
+            _points.begin() + pointOffsets[c]);
+        std::copy(
+            chunk.normals.begin(), chunk.normals.end(),
+            _normals.begin() + normalOffsets[c]);
+        std::copy(
+            chunk.uvs.begin(), chunk.uvs.end(),
+            _uvs.begin() + uvOffsets[c]);
+
+        isChunkValid[c]
+            = resolve(
+                chunk.pointIndices, pointOffsets, c,
+                &_pointIndices, pointIndexOffsets[c])
+            & resolve(
+                chunk.normalIndices, normalOffsets, c,
+                &_normalIndices, normalIndexOffsets[c])
+            & resolve(
+                chunk.uvIndices, uvOffsets, c,
+                &_uvIndices, uvIndexOffsets[c]);
+    });
+
+    invalidateBvh();
+
+    // Roll back if any index is out of range
+    if (std::find(isChunkValid.begin(), isChunkValid.end(), 0)
+        != isChunkValid.end()) {
+        _points.resize(pointOffsets.front());
+        _normals.resize(normalOffsets.front());
+        _uvs.resize(uvOffsets.front());
+        _pointIndices.resize(pointIndexOffsets.front());
+        _normalIndices.resize(normalIndexOffsets.front());
+        _uvIndices.resize(uvIndexOffsets.front());
+        return false;
+    }
+
+    return true;
+}
+
+void TriangleMesh3::writePly(std::ostream* strm) const {
+    const size_t numPoints = numberOfPoints();
+    const size_t numTriangles = numberOfTriangles();
+
+    bool hasVertexNormals
+        = hasNormals()
+        && numberOfNormals() == numPoints
+        && _normalIndices.size() == numTriangles;
+    for (size_t i = 0; hasVertexNormals && i < numTriangles; ++i) {
+        hasVertexNormals = (_normalIndices[i] == _pointIndices[i]);
+    }
+
+    (*strm) << "ply\n";
+    (*strm) << "format "
+        << (isLittleEndian() ? "binary_little_endian" : "binary_big_endian")
+        << " 1.0\n";
+    (*strm) << "element vertex " << numPoints << '\n';
+    (*strm) << "property float x\nproperty float y\nproperty float z\n";
+    if (hasVertexNormals) {
+        (*strm) << "property float nx\nproperty float ny\nproperty float nz\n";
+    }
+    (*strm) << "element face " << numTriangles << '\n';
+    (*strm) << "property list uchar uint vertex_indices\n";
+    (*strm) << "end_header\n";
+
+    // Vertices and faces are packed block by block, so each block is written
+    // with a single call.
+    const size_t floatsPerPoint = hasVertexNormals ? 6 : 3;
+    std::vector<float> pointBuffer;
+    for (size_t begin = 0; begin < numPoints; begin += kPlyBlockSize) {
+        size_t end = std::min(begin + kPlyBlockSize, numPoints);
+        pointBuffer.resize((end - begin) * floatsPerPoint);
+
+        float* v = pointBuffer.data();
+        for (size_t i = begin; i < end; ++i) {
+            *(v++) = static_cast<float>(_points[i].x);
+            *(v++) = static_cast<float>(_points[i].y);
+            *(v++) = static_cast<float>(_points[i].z);
+            if (hasVertexNormals) {
+                *(v++) = static_cast<float>(_normals[i].x);
+                *(v++) = static_cast<float>(_normals[i].y);
+                *(v++) = static_cast<float>(_normals[i].z);
+            }
+        }
+
+        strm->write(
+            reinterpret_cast<const char*>(pointBuffer.data()),
+            sizeof(float) * pointBuffer.size());
+    }
+
+    const size_t bytesPerFace = sizeof(uint8_t) + 3 * sizeof(uint32_t);
+    std::vector<char> faceBuffer;
+    for (size_t begin = 0; begin < numTriangles; begin += kPlyBlockSize) {
+        size_t end = std::min(begin + kPlyBlockSize, numTriangles);
+        faceBuffer.resize((end - begin) * bytesPerFace);
+
+        char* f = faceBuffer.data();
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t count = 3;
+            const uint32_t indices[3] = {
+                static_cast<uint32_t>(_pointIndices[i].x),
+                static_cast<uint32_t>(_pointIndices[i].y),
+                static_cast<uint32_t>(_pointIndices[i].z)
+            };
+            std::memcpy(f, &count, sizeof(uint8_t));
+            std::memcpy(f + sizeof(uint8_t), indices, sizeof(indices));
+            f += bytesPerFace;
+        }
+
+        strm->write(faceBuffer.data(), faceBuffer.size());
+    }
+}
+
+void TriangleMesh3::writeBinary(std::ostream* strm) const {
+    TriangleMeshStreamWriter3 writer(strm);
+    writer.write(*this);
+}
+
+bool TriangleMesh3::readBinary(std::istream* strm) {
+    char tag[kTriangleMeshBinaryTagLength];
+    strm->read(tag, kTriangleMeshBinaryTagLength);
+    if (!(*strm)
+        || std::memcmp(tag, kTriangleMeshBinaryTag, sizeof(tag)) != 0) {
+        return false;
+    }
+
+    bool isSucceeded = true;
+    while (strm->peek() != std::char_traits<char>::eof()) {
+        Vector3DArray points;
+        Vector3DArray normals;
+        Vector2DArray uvs;
+        IndexArray pointIndices;
+        IndexArray normalIndices;
+        IndexArray uvIndices;
+
+        uint8_t flags = 0;
+        strm->read(reinterpret_cast<char*>(&flags), sizeof(uint8_t));
+        points.deserialize(strm);
+        normals.deserialize(strm);
+        uvs.deserialize(strm);
+        pointIndices.deserialize(strm);
+        normalIndices.deserialize(strm);
+        uvIndices.deserialize(strm);
+
+        if (!(*strm)) {
+            isSucceeded = false;
+            break;
+        }
+
+        if (flags & kTriangleMeshBinaryFlagSharedNormalIndices) {
+            normalIndices.set(pointIndices);
+        }
+        if (flags & kTriangleMeshBinaryFlagSharedUvIndices) {
+            uvIndices.set(pointIndices);
+        }
+
+        // Rebase the chunk-relative indices
+        const size_t pointOffset = numberOfPoints();
+        const size_t normalOffset = numberOfNormals();
+        const size_t uvOffset = numberOfUvs();
+        _points.append(points);
+        _normals.append(normals);
+        _uvs.append(uvs);
+        for (const Point3UI& index : pointIndices) {
+            _pointIndices.append(index.add(pointOffset));
+        }
+        for (const Point3UI& index : normalIndices) {
+            _normalIndices.append(index.add(normalOffset));
+        }
+        for (const Point3UI& index : uvIndices) {
+            _uvIndices.append(index.add(uvOffset));
+        }
+    }
+
+    invalidateBvh();
+
+    return isSucceeded;
+}
+
 TriangleMesh3& TriangleMesh3::operator=(const TriangleMesh3& other) {
     set(other);
     return *this;
 }
+
+TriangleMesh3& TriangleMesh3::operator=(TriangleMesh3&& other) {
+    _points = std::move(other._points);
+    _normals = std::move(other._normals);
+    _uvs = std::move(other._uvs);
+    _pointIndices = std::move(other._pointIndices);
+    _normalIndices = std::move(other._normalIndices);
+    _uvIndices = std::move(other._uvIndices);
+    setTransform(other._translation, other._orientation);
+    other.setTransform(Vector3D(), QuaternionD());
+
+    invalidateBvh();
+    other.invalidateBvh();
+    return *this;
+}
+
+void TriangleMesh3::invalidateBvh() {
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    _isBvhValid = false;
+}
+
+void TriangleMesh3::refitBvh() {
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    if (_isBvhValid) {
+        refitBvhNodes();
+    }
+}
+
+void TriangleMesh3::buildBvh() const {
+    if (_isBvhValid) {
+        return;
+    }
+
+    // The parallel loops of the build may run a pending task on this thread,
+    // such as another query of this mesh that calls buildBvh again, so the
+    // BVH is built without the lock and only published under it
+    Bvh3 bvh;
+    bvh.build(triangleBounds(_points, _pointIndices));
+    std::vector<double> triangleCache;
+    buildTriangleCache(bvh, &triangleCache);
+
+    std::lock_guard<std::mutex> lock(_bvhMutex);
+    if (!_isBvhValid) {
+        _bvh = std::move(bvh);
+        _triangleCache = std::move(triangleCache);
+        _isBvhValid = true;
+    }
+}
+
+Vector3D TriangleMesh3::toLocal(const Vector3D& pt) const {
+    return _hasTransform ? _inverseRotation * (pt - _translation) : pt;
+}
+
+Ray3D TriangleMesh3::toLocal(const Ray3D& ray) const {
+    return _hasTransform
+        ? Ray3D(toLocal(ray.origin), _inverseRotation * ray.direction) : ray;
+}
+
+Vector3D TriangleMesh3::toWorld(const Vector3D& pt) const {
+    return _hasTransform ? _rotation * pt + _translation : pt;
+}
+
+Vector3D TriangleMesh3::toWorldDirection(const Vector3D& dir) const {
+    return _hasTransform ? _rotation * dir : dir;
+}
+
+ConstArrayAccessor1<Vector3D> TriangleMesh3::toLocal(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    Array1<Vector3D>* buffer) const {
+    if (!_hasTransform) {
+        return otherPoints;
+    }
+
+    buffer->resize(otherPoints.size());
+    parallelFor(kZeroSize, otherPoints.size(), [&](size_t i) {
+        (*buffer)[i] = toLocal(otherPoints[i]);
+    });
+    return buffer->constAccessor();
+}
+
+void TriangleMesh3::refitBvhNodes() const {
+    _bvh.refit(triangleBounds(_points, _pointIndices));
+    buildTriangleCache(_bvh, &_triangleCache);
+}
+
+void TriangleMesh3::buildTriangleCache(
+    const Bvh3& bvh,
+    std::vector<double>* cache) const {
+    // The streams are padded so the kernels can load the lanes past the
+    // last triangle
+    const std::vector<size_t>& items = bvh.orderedItems();
+    const size_t stride = items.size() + kTriangleCacheLanes;
+    cache->assign(kNumberOfTriangleCacheStreams * stride, 0.0);
+
+    parallelFor(kZeroSize, items.size(), [&](size_t n) {
+        triangleEdges(_points, _pointIndices[items[n]])
+            .store(cache->data(), stride, n);
+    });
+}
+
+template <typename Callback>
+void TriangleMesh3::forEachClosestTriangle(
+    const ConstArrayAccessor1<Vector3D>& otherPoints,
+    const Callback& func) const {
+    buildBvh();
+
+    const size_t packetSize = Bvh3::kPacketSize;
+    const size_t numberOfPackets
+        = (otherPoints.size() + packetSize - 1) / packetSize;
+    parallelFor(kZeroSize, numberOfPackets, [&](size_t p) {
+        size_t begin = p * packetSize;
+        size_t count = std::min(packetSize, otherPoints.size() - begin);
+        size_t triangles[Bvh3::kPacketSize];
+
+        const double* cache = _triangleCache.data();
+        const size_t stride
+            = _triangleCache.size() / kNumberOfTriangleCacheStreams;
+        _bvh.nearestPacketInLeaves(
+            &otherPoints[begin],
+            count,
+            [&](size_t position, size_t n, size_t k, double* distSquared) {
+                triangleDistancesSquared(
+                    cache, stride, position, n, otherPoints[begin + k],
+                    distSquared);
+            },
+            triangles);
+
+        for (size_t k = 0; k < count; ++k) {
+            func(begin + k, triangles[k]);
+        }
+    });
+}
+
+size_t TriangleMesh3::closestTriangle(const Vector3D& otherPoint) const {
+    buildBvh();
+
+    const double* cache = _triangleCache.data();
+    const size_t stride = _triangleCache.size() / kNumberOfTriangleCacheStreams;
+    return _bvh.nearestInLeaves(
+        otherPoint, [&](size_t position, size_t count, double* distSquared) {
+            triangleDistancesSquared(
+                cache, stride, position, count, otherPoint, distSquared);
+        });
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_TRIANGLE_MESH_IO_HELPERS_H_
+#define SRC_JET_TRIANGLE_MESH_IO_HELPERS_H_
+
+#include <cstdint>
+#include <ios>
+
+namespace jet {
+
+// Tag at the beginning of the compact binary mesh stream
+static const char kTriangleMeshBinaryTag[] = "JETMESH1";
+static const std::streamsize kTriangleMeshBinaryTagLength = 8;
+
+// Flags at the beginning of each chunk telling that the normal or UV indices
+// are omitted since they are the same as the point indices
+static const uint8_t kTriangleMeshBinaryFlagSharedNormalIndices = 1 << 0;
+static const uint8_t kTriangleMeshBinaryFlagSharedUvIndices = 1 << 1;
+
+}  // namespace jet
+
+#endif  // SRC_JET_TRIANGLE_MESH_IO_HELPERS_H_
@@ -0,0 +1,179 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/grid_cache3.h>
+#include <jet/triangle_mesh_sdf_cache3.h>
+#include <jet/triangle_mesh_to_sdf.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+const char kSdfChannelName[] = "sdf";
+
+// Changes the keys of the fields of an older triangleMeshToSdf
+const uint64_t kSdfCacheVersion = 1;
+
+class Fnv1aHasher {
+ public:
+    void add(uint64_t bits) {
+        _hash = (_hash ^ bits) * 1099511628211ULL;
+    }
+
+    void add(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        add(bits);
+    }
+
+    void add(const Vector3D& v) {
+        add(v.x);
+        add(v.y);
+        add(v.z);
+    }
+
+    void add(const Size3& size) {
+        add(static_cast<uint64_t>(size.x));
+        add(static_cast<uint64_t>(size.y));
+        add(static_cast<uint64_t>(size.z));
+    }
+
+    uint64_t hash() const {
+        return _hash;
+    }
+
+ private:
+    uint64_t _hash = 14695981039346656037ULL;
+};
+
+bool isSameLayout(const GridCacheReader3& reader, const ScalarGrid3& sdf) {
+    return reader.hasScalarGrid(kSdfChannelName)
+        && reader.resolution(kSdfChannelName) == sdf.resolution()
+        && reader.gridSpacing(kSdfChannelName) == sdf.gridSpacing()
+        && reader.origin(kSdfChannelName) == sdf.origin()
+        && reader.dataOrigin(kSdfChannelName) == sdf.dataOrigin()
+        && reader.scalarData(kSdfChannelName).size() == sdf.dataSize();
+}
+
+}  // namespace
+
+TriangleMeshSdfCache3::TriangleMeshSdfCache3(const std::string& directory) :
+    _directory(directory) {
+}
+
+const std::string& TriangleMeshSdfCache3::directory() const {
+    return _directory;
+}
+
+bool TriangleMeshSdfCache3::bake(
+    const TriangleMesh3& mesh,
+    ScalarGrid3* sdf,
+    unsigned int exactBand,
+    bool isNarrowBandOnly) const {
+    std::string path
+        = filename(key(mesh, *sdf, exactBand, isNarrowBandOnly));
+
+    {
+        GridCacheReader3 reader;
+        if (reader.open(path) && isSameLayout(reader, *sdf)) {
+            ConstArrayAccessor3<double> cached
+                = reader.scalarData(kSdfChannelName);
+            ArrayAccessor3<double> data = sdf->dataAccessor();
+            sdf->parallelForEachDataPointIndex(
+                [&](size_t i, size_t j, size_t k) {
+                    data(i, j, k) = cached(i, j, k);
+                });
+            return true;
+        }
+    }
+
+    triangleMeshToSdf(mesh, sdf, exactBand, isNarrowBandOnly);
+
+    // Another run may write the same file at the same time, so each writes
+    // its own temporary file, and the last rename wins with the same data
+    std::string temporaryPath
+        = path + ".tmp" + std::to_string(std::random_device()());
+    bool isWritten = false;
+    {
+        std::ofstream file(temporaryPath.c_str(), std::ofstream::binary);
+        if (file) {
+            GridCacheWriter3 writer;
+            writer.addScalarGrid(kSdfChannelName, *sdf);
+            writer.write(&file);
+            file.close();
+            isWritten = !file.fail();
+        }
+    }
+
+    if (!isWritten || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+    }
+
+    return false;
+}
+
+std::string TriangleMeshSdfCache3::filename(uint64_t key) const {
+    std::ostringstream strm;
+    strm << std::hex << std::setw(16) << std::setfill('0') << key
+         << ".sdfcache";
+    std::string name = strm.str();
+
+    if (_directory.empty()) {
+        return name;
+    }
+
+    char last = _directory.back();
+    if (last == '/' || last == '\\') {
+        return _directory + name;
+    }
+    return _directory + "/" + name;
+}
+
+uint64_t TriangleMeshSdfCache3::key(
+    const TriangleMesh3& mesh,
+    const ScalarGrid3& sdf,
+    unsigned int exactBand,
+    bool isNarrowBandOnly) {
+    Fnv1aHasher hasher;
+    hasher.add(kSdfCacheVersion);
+
+    hasher.add(sdf.resolution());
+    hasher.add(sdf.gridSpacing());
+    hasher.add(sdf.origin());
+    hasher.add(sdf.dataSize());
+    hasher.add(sdf.dataOrigin());
+    hasher.add(static_cast<uint64_t>(exactBand));
+    hasher.add(static_cast<uint64_t>(isNarrowBandOnly));
+
+    hasher.add(static_cast<uint64_t>(mesh.numberOfPoints()));
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        hasher.add(mesh.point(i));
+    }
+
+    hasher.add(static_cast<uint64_t>(mesh.numberOfTriangles()));
+    for (size_t i = 0; i < mesh.numberOfTriangles(); ++i) {
+        const Point3UI& index = mesh.pointIndex(i);
+        hasher.add(static_cast<uint64_t>(index.x));
+        hasher.add(static_cast<uint64_t>(index.y));
+        hasher.add(static_cast<uint64_t>(index.z));
+    }
+
+    // Keeps the keys of the meshes without a transform as before
+    if (mesh.hasTransform()) {
+        const QuaternionD& q = mesh.orientation();
+        hasher.add(mesh.translation());
+        hasher.add(Vector3D(q.x, q.y, q.z));
+        hasher.add(q.w);
+    }
+
+    return hasher.hash();
+}
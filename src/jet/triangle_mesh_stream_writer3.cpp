@@ -0,0 +1,65 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <jet/triangle_mesh_stream_writer3.h>
+#include <triangle_mesh_io_helpers.h>
+
+#include <cstdint>
+
+using namespace jet;
+
+TriangleMeshStreamWriter3::TriangleMeshStreamWriter3(std::ostream* strm)
+: _strm(strm) {
+    _strm->write(kTriangleMeshBinaryTag, kTriangleMeshBinaryTagLength);
+}
+
+void TriangleMeshStreamWriter3::write(const TriangleMesh3& chunk) {
+    // The normal and UV indices are omitted if they are the point indices
+    auto isSharingPointIndices = [&](const TriangleMesh3::IndexArray& ids) {
+        if (ids.size() != chunk._pointIndices.size() || ids.size() == 0) {
+            return false;
+        }
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (ids[i] != chunk._pointIndices[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    uint8_t flags = 0;
+    if (isSharingPointIndices(chunk._normalIndices)) {
+        flags |= kTriangleMeshBinaryFlagSharedNormalIndices;
+    }
+    if (isSharingPointIndices(chunk._uvIndices)) {
+        flags |= kTriangleMeshBinaryFlagSharedUvIndices;
+    }
+
+    static const TriangleMesh3::IndexArray kEmpty;
+    _strm->write(reinterpret_cast<const char*>(&flags), sizeof(uint8_t));
+    chunk._points.serialize(_strm);
+    chunk._normals.serialize(_strm);
+    chunk._uvs.serialize(_strm);
+    chunk._pointIndices.serialize(_strm);
+    if (flags & kTriangleMeshBinaryFlagSharedNormalIndices) {
+        kEmpty.serialize(_strm);
+    } else {
+        chunk._normalIndices.serialize(_strm);
+    }
+    if (flags & kTriangleMeshBinaryFlagSharedUvIndices) {
+        kEmpty.serialize(_strm);
+    } else {
+        chunk._uvIndices.serialize(_strm);
+    }
+
+    _numberOfPoints += chunk.numberOfPoints();
+    _numberOfTriangles += chunk.numberOfTriangles();
+}
+
+size_t TriangleMeshStreamWriter3::numberOfPoints() const {
+    return _numberOfPoints;
+}
+
+size_t TriangleMeshStreamWriter3::numberOfTriangles() const {
+    return _numberOfTriangles;
+}
@@ -26,14 +26,25 @@
 #include <pch.h>
 #include <jet/array_utils.h>
 #include <jet/array3.h>
+#include <jet/parallel.h>
 #include <jet/triangle_mesh_to_sdf.h>
+#include <parallel_sweep_helpers.h>
+
+#ifndef JET_WINDOWS
+#include <sys/types.h>
+#endif
+
 #include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 using namespace jet;
 
 namespace jet {
 
+// Number of z-layers of a tile that a thread rasterizes the triangles into
+static const size_t kTileDepth = 4;
+
 static void checkNeighbor(
     const TriangleMesh3& mesh,
     const Vector3D& gx,
@@ -45,7 +56,10 @@ static void checkNeighbor(
     ssize_t k1,
     ScalarGrid3* sdf,
     Array3<size_t>* closestTri) {
-    if ((*closestTri)(i1, j1, k1) != kMaxSize) {
+    // Skip if the neighbor has the same closest triangle, which gives the
+    // same distance
+    if ((*closestTri)(i1, j1, k1) != kMaxSize
+        && (*closestTri)(i1, j1, k1) != (*closestTri)(i0, j0, k0)) {
         size_t t = (*closestTri)(i1, j1, k1);
         Triangle3 tri = mesh.triangle(t);
 
@@ -69,61 +83,41 @@ static void sweep(
     Vector3D h = sdf->gridSpacing();
     Vector3D origin = sdf->dataOrigin();
 
-    ssize_t ni = static_cast<ssize_t>(size.x);
-    ssize_t nj = static_cast<ssize_t>(size.y);
-    ssize_t nk = static_cast<ssize_t>(size.z);
-
-    ssize_t i0, i1;
-    if (di > 0) {
-        i0 = 1;
-        i1 = ni;
-    } else {
-        i0 = ni - 2;
-        i1 = -1;
-    }
-
-    ssize_t j0, j1;
-    if (dj > 0) {
-        j0 = 1;
-        j1 = nj;
-    } else {
-        j0 = nj - 2;
-        j1 = -1;
-    }
-
-    ssize_t k0, k1;
-    if (dk > 0) {
-        k0 = 1;
-        k1 = nk;
-    } else {
-        k0 = nk - 2;
-        k1 = -1;
-    }
-
-    for (ssize_t k = k0; k != k1; k += dk) {
-        for (ssize_t j = j0; j != j1; j += dj) {
-            for (ssize_t i = i0; i != i1; i += di) {
-                Vector3D gx({ i, j, k });
-                gx *= h;
-                gx += origin;
+    // The cells on the first layer of each axis have no neighbor behind
+    size_t iSkip = (di > 0) ? 0 : size.x - 1;
+    size_t jSkip = (dj > 0) ? 0 : size.y - 1;
+    size_t kSkip = (dk > 0) ? 0 : size.z - 1;
 
-                checkNeighbor(
-                    mesh, gx, i, j, k, i - di, j, k, sdf, closestTri);
-                checkNeighbor(
-                    mesh, gx, i, j, k, i, j - dj, k, sdf, closestTri);
-                checkNeighbor(
-                    mesh, gx, i, j, k, i - di, j - dj, k, sdf, closestTri);
-                checkNeighbor(
-                    mesh, gx, i, j, k, i, j, k - dk, sdf, closestTri);
-                checkNeighbor(
-                    mesh, gx, i, j, k, i - di, j, k - dk, sdf, closestTri);
-                checkNeighbor(
-                    mesh, gx, i, j, k, i, j - dj, k - dk, sdf, closestTri);
-                checkNeighbor(
-                    mesh, gx, i, j, k, i - di, j - dj, k - dk, sdf, closestTri);
+    parallelSweep(
+        size, di < 0, dj < 0, dk < 0,
+        [&](size_t iU, size_t jU, size_t kU) {
+            if (iU == iSkip || jU == jSkip || kU == kSkip) {
+                return;
             }
-        }
-    }
+
+            ssize_t i = static_cast<ssize_t>(iU);
+            ssize_t j = static_cast<ssize_t>(jU);
+            ssize_t k = static_cast<ssize_t>(kU);
+
+            Vector3D gx({ i, j, k });
+            gx *= h;
+            gx += origin;
+
+            checkNeighbor(
+                mesh, gx, i, j, k, i - di, j, k, sdf, closestTri);
+            checkNeighbor(
+                mesh, gx, i, j, k, i, j - dj, k, sdf, closestTri);
+            checkNeighbor(
+                mesh, gx, i, j, k, i - di, j - dj, k, sdf, closestTri);
+            checkNeighbor(
+                mesh, gx, i, j, k, i, j, k - dk, sdf, closestTri);
+            checkNeighbor(
+                mesh, gx, i, j, k, i - di, j, k - dk, sdf, closestTri);
+            checkNeighbor(
+                mesh, gx, i, j, k, i, j - dj, k - dk, sdf, closestTri);
+            checkNeighbor(
+                mesh, gx, i, j, k, i - di, j - dj, k - dk, sdf, closestTri);
+        });
 }
 
 // calculate twice signed area of triangle (0,0)-(x1,y1)-(x2,y2)
@@ -195,135 +189,421 @@ static bool pointInTriangle2D(
     return true;
 }
 
+// Converts the normalized coordinate to the grid index within [0, n - 1]
+static size_t clampIndex(double value, size_t n) {
+    return static_cast<size_t>(clamp(
+        static_cast<ssize_t>(value),
+        static_cast<ssize_t>(0),
+        static_cast<ssize_t>(n) - 1));
+}
+
+// Clamped range of the grid indices from floor(minValue) - band to
+// floor(maxValue) + band + 1
+static void bandRange(
+    double minValue,
+    double maxValue,
+    unsigned int band,
+    size_t n,
+    size_t* begin,
+    size_t* end) {
+    *begin = clampIndex(std::floor(minValue) - band, n);
+    *end = clampIndex(std::floor(maxValue) + band + 1, n);
+}
+
+// Range of the z-layers [*k0, *k1] that the band around the triangle covers
+static void zBandRange(
+    const Vector3D& pt1,
+    const Vector3D& pt2,
+    const Vector3D& pt3,
+    const Size3& size,
+    const Vector3D& h,
+    const Vector3D& origin,
+    unsigned int exactBand,
+    size_t* k0,
+    size_t* k1) {
+    double fz1 = (pt1.z - origin.z) / h.z;
+    double fz2 = (pt2.z - origin.z) / h.z;
+    double fz3 = (pt3.z - origin.z) / h.z;
+    bandRange(
+        min3(fz1, fz2, fz3), max3(fz1, fz2, fz3), exactBand, size.z, k0, k1);
+}
+
+// Rasterizes the triangle (pt1, pt2, pt3) into the z-layers [kBegin, kEnd] of
+// the grid. The distances within the band are written to sdf, and the
+// crossings of the x-rays to intersectionCount, both of which store the
+// z-layers from kOffset on. The triangle is recorded as t in closestTri, if
+// given, wherever it is the closest.
+static void rasterizeTriangle(
+    const Vector3D& pt1,
+    const Vector3D& pt2,
+    const Vector3D& pt3,
+    size_t t,
+    const Size3& size,
+    const Vector3D& h,
+    const Vector3D& origin,
+    unsigned int exactBand,
+    size_t kBegin,
+    size_t kEnd,
+    size_t kOffset,
+    ArrayAccessor3<double> sdf,
+    ArrayAccessor3<unsigned int> intersectionCount,
+    Array3<size_t>* closestTri) {
+    Triangle3 tri;
+    tri.points = {{ pt1, pt2, pt3 }};
+
+    // Normalize coordinates
+    Vector3D f1 = (pt1 - origin) / h;
+    Vector3D f2 = (pt2 - origin) / h;
+    Vector3D f3 = (pt3 - origin) / h;
+
+    // Do distances nearby
+    size_t i0, i1, j0, j1, k0, k1;
+    bandRange(
+        min3(f1.x, f2.x, f3.x), max3(f1.x, f2.x, f3.x),
+        exactBand, size.x, &i0, &i1);
+    bandRange(
+        min3(f1.y, f2.y, f3.y), max3(f1.y, f2.y, f3.y),
+        exactBand, size.y, &j0, &j1);
+    bandRange(
+        min3(f1.z, f2.z, f3.z), max3(f1.z, f2.z, f3.z),
+        exactBand, size.z, &k0, &k1);
+    k0 = std::max(k0, kBegin);
+    k1 = std::min(k1, kEnd);
+
+    for (size_t k = k0; k <= k1; ++k) {
+        for (size_t j = j0; j <= j1; ++j) {
+            for (size_t i = i0; i <= i1; ++i) {
+                Vector3D gx({ i, j, k });
+                gx *= h;
+                gx += origin;
+                double d = tri.closestDistance(gx);
+                if (d < sdf(i, j, k - kOffset)) {
+                    sdf(i, j, k - kOffset) = d;
+                    if (closestTri != nullptr) {
+                        (*closestTri)(i, j, k) = t;
+                    }
+                }
+            }
+        }
+    }
+
+    // Do intersection counts
+    j0 = clampIndex(std::ceil(min3(f1.y, f2.y, f3.y)), size.y);
+    j1 = clampIndex(std::floor(max3(f1.y, f2.y, f3.y)), size.y);
+    k0 = clampIndex(std::ceil(min3(f1.z, f2.z, f3.z)), size.z);
+    k1 = clampIndex(std::floor(max3(f1.z, f2.z, f3.z)), size.z);
+    k0 = std::max(k0, kBegin);
+    k1 = std::min(k1, kEnd);
+
+    for (size_t k = k0; k <= k1; ++k) {
+        for (size_t j = j0; j <= j1; ++j) {
+            double a, b, c;
+            double jD = static_cast<double>(j);
+            double kD = static_cast<double>(k);
+            if (pointInTriangle2D(
+                jD, kD,
+                f1.y, f1.z, f2.y, f2.z, f3.y, f3.z,
+                &a, &b, &c)) {
+                // intersection i coordinate
+                double fi = a * f1.x + b * f2.x + c * f3.x;
+
+                // intersection is in (iInterval - 1, iInterval]
+                int iInterval = static_cast<int>(std::ceil(fi));
+                if (iInterval < 0) {
+                    // we enlarge the first interval to include
+                    // everything to the -x direction
+                    ++intersectionCount(0, j, k - kOffset);
+                } else if (iInterval < static_cast<int>(size.x)) {
+                    ++intersectionCount(iInterval, j, k - kOffset);
+                }
+                // we ignore intersections that are beyond the +x side
+                // of the grid
+            }
+        }
+    }
+}
+
+// Figures out the signs (inside/outside) from the intersection counts
+static void assignSigns(
+    const ConstArrayAccessor3<unsigned int>& intersectionCount,
+    ArrayAccessor3<double> sdf) {
+    Size3 size = sdf.size();
+    parallelFor(kZeroSize, size.z, [&](size_t k) {
+        for (size_t j = 0; j < size.y; ++j) {
+            unsigned int totalCount = 0U;
+            for (size_t i = 0; i < size.x; ++i) {
+                totalCount += intersectionCount(i, j, k);
+                // if parity of intersections so far is odd,
+                if (totalCount % 2 == 1) {
+                    // we are inside the mesh
+                    sdf(i, j, k) = -sdf(i, j, k);
+                }
+            }
+        }
+    });
+}
+
 void triangleMeshToSdf(
     const TriangleMesh3& mesh,
     ScalarGrid3* sdf,
-    const unsigned int exactBand) {
+    const unsigned int exactBand,
+    bool isNarrowBandOnly) {
     Size3 size = sdf->dataSize();
     if (size.x * size.y * size.z == 0) {
         return;
     }
 
-    // Upper bound on distance
-    sdf->fill(sdf->boundingBox().diagonalLength());
+    // The rasterization reads the points, so it needs them transformed
+    if (mesh.hasTransform()) {
+        TriangleMesh3 bakedMesh(mesh);
+        bakedMesh.bakeTransform();
+        triangleMeshToSdf(bakedMesh, sdf, exactBand, isNarrowBandOnly);
+        return;
+    }
+
     Vector3D h = sdf->gridSpacing();
     Vector3D origin = sdf->dataOrigin();
 
-    Array3<size_t> closestTri(size, kMaxSize);
+    // Upper bound on distance
+    double maxDistance = sdf->boundingBox().diagonalLength();
+    if (isNarrowBandOnly) {
+        maxDistance = exactBand * min3(h.x, h.y, h.z);
+    }
+    sdf->fill(maxDistance);
+
+    // Only needed for the sweeping
+    Array3<size_t> closestTri;
+    if (!isNarrowBandOnly) {
+        closestTri.resize(size, kMaxSize);
+    }
 
     // Intersection_count(i,j,k) is # of tri intersections in (i-1,i]x{j}x{k}
     Array3<unsigned int> intersectionCount(size, 0);
 
-    // We begin by initializing distances near the mesh, and figuring out
-    // intersection counts
-    Vector3D ijkmin, ijkmax;
-
+    // Bin the triangles into the tiles they overlap, so that each tile can be
+    // rasterized independently
     size_t nTri = mesh.numberOfTriangles();
+    size_t numberOfTiles = (size.z + kTileDepth - 1) / kTileDepth;
+    std::vector<std::vector<size_t>> tiles(numberOfTiles);
+
     for (size_t t = 0; t < nTri; ++t) {
         Point3UI indices = mesh.pointIndex(t);
 
-        Triangle3 tri = mesh.triangle(t);
+        size_t k0, k1;
+        zBandRange(
+            mesh.point(indices.x), mesh.point(indices.y),
+            mesh.point(indices.z), size, h, origin, exactBand, &k0, &k1);
+        for (size_t tile = k0 / kTileDepth; tile <= k1 / kTileDepth; ++tile) {
+            tiles[tile].push_back(t);
+        }
+    }
 
-        Vector3D pt1 = mesh.point(indices.x);
-        Vector3D pt2 = mesh.point(indices.y);
-        Vector3D pt3 = mesh.point(indices.z);
-
-        // Normalize coordinates
-        Vector3D f1 = (pt1 - origin) / h;
-        Vector3D f2 = (pt2 - origin) / h;
-        Vector3D f3 = (pt3 - origin) / h;
-
-        // Do distances nearby
-        size_t i0 = clamp(static_cast<size_t>(
-            min3(f1.x, f2.x, f3.x)) - exactBand, kZeroSize, size.x - 1);
-        size_t i1 = clamp(static_cast<size_t>(
-            max3(f1.x, f2.x, f3.x)) + exactBand + 1, kZeroSize, size.x - 1);
-        size_t j0 = clamp(static_cast<size_t>(
-            min3(f1.y, f2.y, f3.y)) - exactBand, kZeroSize, size.y - 1);
-        size_t j1 = clamp(static_cast<size_t>(
-            max3(f1.y, f2.y, f3.y)) + exactBand + 1, kZeroSize, size.y - 1);
-        size_t k0 = clamp(static_cast<size_t>(
-            min3(f1.z, f2.z, f3.z)) - exactBand, kZeroSize, size.z - 1);
-        size_t k1 = clamp(static_cast<size_t>(
-            max3(f1.z, f2.z, f3.z)) + exactBand + 1, kZeroSize, size.z - 1);
-
-        for (size_t k = k0; k <= k1; ++k) {
-            for (size_t j = j0; j <= j1; ++j) {
-                for (size_t i = i0; i <= i1; ++i) {
-                    Vector3D gx({ i, j, k });
-                    gx *= h;
-                    gx += origin;
-                    double d = tri.closestDistance(gx);
-                    if (d < (*sdf)(i, j, k)) {
-                        (*sdf)(i, j, k) = d;
-                        closestTri(i, j, k) = t;
-                    }
-                }
+    // We begin by initializing distances near the mesh, and figuring out
+    // intersection counts
+    ArrayAccessor3<double> sdfAcc = sdf->dataAccessor();
+    parallelFor(kZeroSize, numberOfTiles, kOneSize, [&](size_t tile) {
+        size_t kTileBegin = tile * kTileDepth;
+        size_t kTileEnd = std::min(kTileBegin + kTileDepth, size.z) - 1;
+
+        for (size_t t : tiles[tile]) {
+            Point3UI indices = mesh.pointIndex(t);
+            rasterizeTriangle(
+                mesh.point(indices.x),
+                mesh.point(indices.y),
+                mesh.point(indices.z),
+                t, size, h, origin, exactBand,
+                kTileBegin, kTileEnd, 0,
+                sdfAcc,
+                intersectionCount.accessor(),
+                isNarrowBandOnly ? nullptr : &closestTri);
+        }
+    });
+
+    // and now we fill in the rest of the distances with fast sweeping
+    if (!isNarrowBandOnly) {
+        for (unsigned int pass = 0; pass < 2; ++pass) {
+            sweep(mesh, +1, +1, +1, sdf, &closestTri);
+            sweep(mesh, -1, -1, -1, sdf, &closestTri);
+            sweep(mesh, +1, +1, -1, sdf, &closestTri);
+            sweep(mesh, -1, -1, +1, sdf, &closestTri);
+            sweep(mesh, +1, -1, +1, sdf, &closestTri);
+            sweep(mesh, -1, +1, -1, sdf, &closestTri);
+            sweep(mesh, +1, -1, -1, sdf, &closestTri);
+            sweep(mesh, -1, +1, +1, sdf, &closestTri);
+        }
+    }
+
+    // then figure out signs (inside/outside) from intersection counts
+    assignSigns(intersectionCount.constAccessor(), sdf->dataAccessor());
+}
+
+static void seekScratchFile(std::FILE* file, uint64_t offset) {
+#ifdef JET_WINDOWS
+    int result = _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+    int result = fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    if (result != 0) {
+        throw std::runtime_error("Failed to seek the scratch file.");
+    }
+}
+
+const size_t StreamingTriangleMeshToSdf3::kDefaultSlabDepth;
+
+const size_t StreamingTriangleMeshToSdf3::kTrianglesPerChunk;
+
+StreamingTriangleMeshToSdf3::StreamingTriangleMeshToSdf3(
+    const Size3& dataSize,
+    const Vector3D& gridSpacing,
+    const Vector3D& dataOrigin,
+    unsigned int exactBand,
+    size_t slabDepth) :
+    _dataSize(dataSize),
+    _gridSpacing(gridSpacing),
+    _dataOrigin(dataOrigin),
+    _exactBand(exactBand),
+    _slabDepth(std::max(slabDepth, kOneSize)) {
+    if (dataSize.x * dataSize.y * dataSize.z > 0) {
+        _bins.resize((dataSize.z + _slabDepth - 1) / _slabDepth);
+    }
+}
+
+StreamingTriangleMeshToSdf3::~StreamingTriangleMeshToSdf3() {
+    if (_file != nullptr) {
+        std::fclose(_file);
+    }
+}
+
+void StreamingTriangleMeshToSdf3::addTriangle(
+    const Vector3D& point0, const Vector3D& point1, const Vector3D& point2) {
+    if (_bins.empty()) {
+        return;
+    }
+
+    size_t k0, k1;
+    zBandRange(
+        point0, point1, point2,
+        _dataSize, _gridSpacing, _dataOrigin, _exactBand, &k0, &k1);
+
+    for (size_t slab = k0 / _slabDepth; slab <= k1 / _slabDepth; ++slab) {
+        Bin& bin = _bins[slab];
+        for (const Vector3D& point : { point0, point1, point2 }) {
+            bin.buffer.push_back(point.x);
+            bin.buffer.push_back(point.y);
+            bin.buffer.push_back(point.z);
+        }
+        if (bin.buffer.size() == kTrianglesPerChunk * 9) {
+            spill(&bin);
+        }
+    }
+
+    ++_numberOfTriangles;
+}
+
+size_t StreamingTriangleMeshToSdf3::numberOfTriangles() const {
+    return _numberOfTriangles;
+}
+
+void StreamingTriangleMeshToSdf3::generate(const SlabCallback& callback) {
+    const Size3& size = _dataSize;
+    const Vector3D& h = _gridSpacing;
+    double maxDistance = _exactBand * min3(h.x, h.y, h.z);
+
+    Array3<double> sdf;
+    Array3<unsigned int> intersectionCount;
+    std::vector<double> coords;
+
+    for (size_t slab = 0; slab < _bins.size(); ++slab) {
+        size_t kSlabBegin = slab * _slabDepth;
+        size_t kSlabEnd = std::min(kSlabBegin + _slabDepth, size.z);
+        Size3 slabSize(size.x, size.y, kSlabEnd - kSlabBegin);
+
+        sdf.resize(slabSize);
+        sdf.set(maxDistance);
+        intersectionCount.resize(slabSize);
+        intersectionCount.set(0);
+
+        loadBin(_bins[slab], &coords);
+        size_t nTri = coords.size() / 9;
+        auto point = [&](size_t t, size_t v) {
+            const double* p = &coords[9 * t + 3 * v];
+            return Vector3D(p[0], p[1], p[2]);
+        };
+
+        // Bin the triangles of the slab into the tiles as triangleMeshToSdf
+        // does, so that each tile can be rasterized independently
+        size_t numberOfTiles = (slabSize.z + kTileDepth - 1) / kTileDepth;
+        std::vector<std::vector<size_t>> tiles(numberOfTiles);
+
+        for (size_t t = 0; t < nTri; ++t) {
+            size_t k0, k1;
+            zBandRange(
+                point(t, 0), point(t, 1), point(t, 2),
+                size, h, _dataOrigin, _exactBand, &k0, &k1);
+            k0 = std::max(k0, kSlabBegin) - kSlabBegin;
+            k1 = std::min(k1, kSlabEnd - 1) - kSlabBegin;
+            for (size_t tile = k0 / kTileDepth; tile <= k1 / kTileDepth;
+                 ++tile) {
+                tiles[tile].push_back(t);
             }
         }
 
-        // Do intersection counts
-        j0 = clamp(static_cast<size_t>(
-            std::ceil(min3(f1.y, f2.y, f3.y))), kZeroSize, size.y - 1);
-        j1 = clamp(static_cast<size_t>(
-            std::floor(max3(f1.y, f2.y, f3.y))), kZeroSize, size.y - 1);
-        k0 = clamp(static_cast<size_t>(
-            std::ceil(min3(f1.z, f2.z, f3.z))), kZeroSize, size.z - 1);
-        k1 = clamp(static_cast<size_t>(
-            std::floor(max3(f1.z, f2.z, f3.z))), kZeroSize, size.z - 1);
-
-        for (size_t k = k0; k <= k1; ++k) {
-            for (size_t j = j0; j <= j1; ++j) {
-                double a, b, c;
-                double jD = static_cast<double>(j);
-                double kD = static_cast<double>(k);
-                if (pointInTriangle2D(
-                    jD, kD, f1.y, f1.z, f2.y, f2.z, f3.y, f3.z, &a, &b, &c)) {
-                    // intersection i coordinate
-                    double fi = a * f1.x + b * f2.x + c * f3.x;
-
-                    // intersection is in (iInterval - 1, iInterval]
-                    int iInterval = static_cast<int>(std::ceil(fi));
-                    if (iInterval < 0) {
-                        // we enlarge the first interval to include everything
-                        // to the -x direction
-                        ++intersectionCount(0, j, k);
-                    } else if (iInterval < static_cast<int>(size.x)) {
-                        ++intersectionCount(iInterval, j, k);
-                    }
-                    // we ignore intersections that are beyond the +x side of
-                    // the grid
-                }
+        parallelFor(kZeroSize, numberOfTiles, kOneSize, [&](size_t tile) {
+            size_t kTileBegin = kSlabBegin + tile * kTileDepth;
+            size_t kTileEnd = std::min(kTileBegin + kTileDepth, kSlabEnd) - 1;
+
+            for (size_t t : tiles[tile]) {
+                rasterizeTriangle(
+                    point(t, 0), point(t, 1), point(t, 2),
+                    t, size, h, _dataOrigin, _exactBand,
+                    kTileBegin, kTileEnd, kSlabBegin,
+                    sdf.accessor(),
+                    intersectionCount.accessor(),
+                    nullptr);
             }
+        });
+
+        // The x-rays of the slab only cross the triangles binned to it, so the
+        // signs are complete without the other slabs
+        assignSigns(intersectionCount.constAccessor(), sdf.accessor());
+
+        callback(kSlabBegin, sdf.constAccessor());
+    }
+}
+
+void StreamingTriangleMeshToSdf3::spill(Bin* bin) {
+    if (_file == nullptr) {
+        _file = std::tmpfile();
+        if (_file == nullptr) {
+            throw std::runtime_error("Failed to create the scratch file.");
         }
     }
 
-    // and now we fill in the rest of the distances with fast sweeping
-    for (unsigned int pass = 0; pass < 2; ++pass) {
-        sweep(mesh, +1, +1, +1, sdf, &closestTri);
-        sweep(mesh, -1, -1, -1, sdf, &closestTri);
-        sweep(mesh, +1, +1, -1, sdf, &closestTri);
-        sweep(mesh, -1, -1, +1, sdf, &closestTri);
-        sweep(mesh, +1, -1, +1, sdf, &closestTri);
-        sweep(mesh, -1, +1, -1, sdf, &closestTri);
-        sweep(mesh, +1, -1, -1, sdf, &closestTri);
-        sweep(mesh, -1, +1, +1, sdf, &closestTri);
+    size_t bytes = bin->buffer.size() * sizeof(double);
+    seekScratchFile(_file, _fileSize);
+    if (std::fwrite(bin->buffer.data(), 1, bytes, _file) != bytes) {
+        throw std::runtime_error("Failed to write the scratch file.");
     }
+    bin->chunkOffsets.push_back(_fileSize);
+    _fileSize += bytes;
+    bin->buffer.clear();
+}
 
-    // then figure out signs (inside/outside) from intersection counts
-    for (size_t k = 0; k < size.z; ++k) {
-        for (size_t j = 0; j < size.y; ++j) {
-            unsigned int totalCount = 0U;
-            for (size_t i = 0; i < size.x; ++i) {
-                totalCount += intersectionCount(i, j, k);
-                // if parity of intersections so far is odd,
-                if (totalCount % 2 == 1) {
-                    // we are inside the mesh
-                    (*sdf)(i, j, k) = -(*sdf)(i, j, k);
-                }
-            }
+void StreamingTriangleMeshToSdf3::loadBin(
+    const Bin& bin, std::vector<double>* coords) {
+    size_t chunkLength = kTrianglesPerChunk * 9;
+    coords->resize(bin.chunkOffsets.size() * chunkLength + bin.buffer.size());
+
+    double* dst = coords->data();
+    for (uint64_t offset : bin.chunkOffsets) {
+        seekScratchFile(_file, offset);
+        if (std::fread(dst, sizeof(double), chunkLength, _file)
+            != chunkLength) {
+            throw std::runtime_error("Failed to read the scratch file.");
         }
+        dst += chunkLength;
     }
+    std::copy(bin.buffer.begin(), bin.buffer.end(), dst);
 }
 
 }  // namespace jet
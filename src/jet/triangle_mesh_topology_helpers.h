@@ -0,0 +1,106 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_TRIANGLE_MESH_TOPOLOGY_HELPERS_H_
+#define SRC_JET_TRIANGLE_MESH_TOPOLOGY_HELPERS_H_
+
+#include <jet/array1.h>
+#include <jet/point3.h>
+#include <jet/vector3.h>
+#include <algorithm>
+#include <vector>
+
+namespace jet {
+
+// Lists the triangles around each point. The triangles of point i are
+// (*triangles)[(*offsets)[i]] to (*triangles)[(*offsets)[i + 1] - 1], in the
+// increasing order of the triangle indices.
+inline void buildPointToTriangles(
+    const Array1<Point3UI>& pointIndices,
+    size_t numberOfPoints,
+    std::vector<size_t>* offsets,
+    std::vector<size_t>* triangles) {
+    offsets->assign(numberOfPoints + 1, 0);
+    for (size_t t = 0; t < pointIndices.size(); ++t) {
+        for (size_t c = 0; c < 3; ++c) {
+            ++(*offsets)[pointIndices[t][c] + 1];
+        }
+    }
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+        (*offsets)[i + 1] += (*offsets)[i];
+    }
+
+    std::vector<size_t> cursors(offsets->begin(), offsets->end() - 1);
+    triangles->resize(3 * pointIndices.size());
+    for (size_t t = 0; t < pointIndices.size(); ++t) {
+        for (size_t c = 0; c < 3; ++c) {
+            (*triangles)[cursors[pointIndices[t][c]]++] = t;
+        }
+    }
+}
+
+// Collects the points that share a triangle with \p point, each once.
+inline void collectPointNeighbors(
+    size_t point,
+    const Array1<Point3UI>& pointIndices,
+    const std::vector<size_t>& offsets,
+    const std::vector<size_t>& triangles,
+    std::vector<size_t>* neighbors) {
+    neighbors->clear();
+    for (size_t n = offsets[point]; n < offsets[point + 1]; ++n) {
+        const Point3UI& face = pointIndices[triangles[n]];
+        for (size_t c = 0; c < 3; ++c) {
+            if (face[c] != point) {
+                neighbors->push_back(face[c]);
+            }
+        }
+    }
+    std::sort(neighbors->begin(), neighbors->end());
+    neighbors->erase(
+        std::unique(neighbors->begin(), neighbors->end()), neighbors->end());
+}
+
+// Sum of the squared distances to a set of planes, which is the error metric
+// of Garland and Heckbert, "Surface simplification using quadric error
+// metrics" (SIGGRAPH 1997). The sum is x^T A x + 2 b^T x + c with the
+// symmetric A stored as (xx, xy, xz, yy, yz, zz).
+struct TriangleMeshQuadric {
+    double a[6] = {0, 0, 0, 0, 0, 0};
+    double b[3] = {0, 0, 0};
+    double c = 0.0;
+
+    // Adds the plane of the unit normal n that passes through the point p.
+    void addPlane(const Vector3D& n, const Vector3D& p) {
+        double d = -n.dot(p);
+        a[0] += n.x * n.x;
+        a[1] += n.x * n.y;
+        a[2] += n.x * n.z;
+        a[3] += n.y * n.y;
+        a[4] += n.y * n.z;
+        a[5] += n.z * n.z;
+        b[0] += d * n.x;
+        b[1] += d * n.y;
+        b[2] += d * n.z;
+        c += d * d;
+    }
+
+    TriangleMeshQuadric& operator+=(const TriangleMeshQuadric& other) {
+        for (int i = 0; i < 6; ++i) {
+            a[i] += other.a[i];
+        }
+        for (int i = 0; i < 3; ++i) {
+            b[i] += other.b[i];
+        }
+        c += other.c;
+        return *this;
+    }
+
+    double evaluate(const Vector3D& x) const {
+        return a[0] * x.x * x.x + a[3] * x.y * x.y + a[5] * x.z * x.z
+            + 2.0 * (a[1] * x.x * x.y + a[2] * x.x * x.z + a[4] * x.y * x.z)
+            + 2.0 * (b[0] * x.x + b[1] * x.y + b[2] * x.z) + c;
+    }
+};
+
+}  // namespace jet
+
+#endif  // SRC_JET_TRIANGLE_MESH_TOPOLOGY_HELPERS_H_
@@ -3,6 +3,7 @@
 #include <pch.h>
 #include <jet/pde.h>
 #include <jet/upwind_level_set_solver3.h>
+#include <level_set_stencil_helpers.h>
 
 #include <algorithm>
 
@@ -46,3 +47,17 @@ void UpwindLevelSetSolver3::getDerivatives(
     D0[2] = grid(i, j, kp1);
     *dz = upwind1(D0, gridSpacing.z);
 }
+
+void UpwindLevelSetSolver3::getDerivativesAlongX(
+    ConstArrayAccessor3<double> grid,
+    const Vector3D& gridSpacing,
+    size_t iBegin,
+    size_t iEnd,
+    size_t j,
+    size_t k,
+    std::array<double, 2>* dx,
+    std::array<double, 2>* dy,
+    std::array<double, 2>* dz) const {
+    jet::getDerivativesAlongX<Upwind1Stencil>(
+        grid, gridSpacing, iBegin, iEnd, j, k, dx, dy, dz);
+}
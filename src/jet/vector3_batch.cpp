@@ -0,0 +1,683 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <pch.h>
+#include <simd_helpers.h>
+#include <jet/fdm_linear_system3.h>
+#include <jet/parallel.h>
+#include <jet/vector3_batch.h>
+
+#include <cmath>
+
+// Keep every kernel free of fused multiply-adds so the SIMD paths round each
+// product like the scalar path does
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+using namespace jet;
+
+namespace {
+
+// Number of vectors per parallel task, a multiple of every SIMD width
+const size_t kBatchGrainSize = 4096;
+
+// Pointers to the components of a batch, offset to the begin of a chunk.
+struct Components {
+    double* x;
+    double* y;
+    double* z;
+};
+
+struct ConstComponents {
+    const double* x;
+    const double* y;
+    const double* z;
+};
+
+void dotScalar(
+    size_t begin,
+    size_t end,
+    const ConstComponents& a,
+    const ConstComponents& b,
+    double* result) {
+    for (size_t i = begin; i < end; ++i) {
+        result[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+    }
+}
+
+void lengthScalar(
+    size_t begin, size_t end, const ConstComponents& a, double* result) {
+    for (size_t i = begin; i < end; ++i) {
+        result[i] = std::sqrt(a.x[i] * a.x[i] + a.y[i] * a.y[i]
+            + a.z[i] * a.z[i]);
+    }
+}
+
+void normalizeScalar(size_t begin, size_t end, const Components& a) {
+    for (size_t i = begin; i < end; ++i) {
+        double l = std::sqrt(a.x[i] * a.x[i] + a.y[i] * a.y[i]
+            + a.z[i] * a.z[i]);
+        a.x[i] /= l;
+        a.y[i] /= l;
+        a.z[i] /= l;
+    }
+}
+
+// The matrix elements in the row-major order and the translation.
+struct Transform {
+    double m[9];
+    double t[3];
+};
+
+void transformScalar(
+    size_t begin, size_t end, const Transform& f, const Components& a) {
+    for (size_t i = begin; i < end; ++i) {
+        double x = a.x[i];
+        double y = a.y[i];
+        double z = a.z[i];
+        a.x[i] = (f.m[0] * x + f.m[1] * y + f.m[2] * z) + f.t[0];
+        a.y[i] = (f.m[3] * x + f.m[4] * y + f.m[5] * z) + f.t[1];
+        a.z[i] = (f.m[6] * x + f.m[7] * y + f.m[8] * z) + f.t[2];
+    }
+}
+
+#if defined(JET_SIMD_X86)
+
+JET_TARGET_SSE2 void dotSse2(
+    size_t n,
+    const ConstComponents& a,
+    const ConstComponents& b,
+    double* result) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_add_pd(
+            _mm_add_pd(
+                _mm_mul_pd(_mm_loadu_pd(a.x + i), _mm_loadu_pd(b.x + i)),
+                _mm_mul_pd(_mm_loadu_pd(a.y + i), _mm_loadu_pd(b.y + i))),
+            _mm_mul_pd(_mm_loadu_pd(a.z + i), _mm_loadu_pd(b.z + i)));
+        _mm_storeu_pd(result + i, d);
+    }
+    dotScalar(i, n, a, b, result);
+}
+
+JET_TARGET_SSE2 inline __m128d lengthSse2(
+    const ConstComponents& a, size_t i) {
+    __m128d x = _mm_loadu_pd(a.x + i);
+    __m128d y = _mm_loadu_pd(a.y + i);
+    __m128d z = _mm_loadu_pd(a.z + i);
+    return _mm_sqrt_pd(_mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)), _mm_mul_pd(z, z)));
+}
+
+JET_TARGET_SSE2 void lengthSse2(
+    size_t n, const ConstComponents& a, double* result) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(result + i, lengthSse2(a, i));
+    }
+    lengthScalar(i, n, a, result);
+}
+
+JET_TARGET_SSE2 void normalizeSse2(size_t n, const Components& a) {
+    const ConstComponents c = { a.x, a.y, a.z };
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d l = lengthSse2(c, i);
+        _mm_storeu_pd(a.x + i, _mm_div_pd(_mm_loadu_pd(a.x + i), l));
+        _mm_storeu_pd(a.y + i, _mm_div_pd(_mm_loadu_pd(a.y + i), l));
+        _mm_storeu_pd(a.z + i, _mm_div_pd(_mm_loadu_pd(a.z + i), l));
+    }
+    normalizeScalar(i, n, a);
+}
+
+// Returns m[0] * x + m[1] * y + m[2] * z + t.
+JET_TARGET_SSE2 inline __m128d transformRowSse2(
+    const __m128d* m, __m128d x, __m128d y, __m128d z, __m128d t) {
+    __m128d r = _mm_add_pd(_mm_mul_pd(m[0], x), _mm_mul_pd(m[1], y));
+    r = _mm_add_pd(r, _mm_mul_pd(m[2], z));
+    return _mm_add_pd(r, t);
+}
+
+JET_TARGET_SSE2 void transformSse2(
+    size_t n, const Transform& f, const Components& a) {
+    __m128d m[9];
+    for (size_t k = 0; k < 9; ++k) {
+        m[k] = _mm_set1_pd(f.m[k]);
+    }
+    const __m128d tx = _mm_set1_pd(f.t[0]);
+    const __m128d ty = _mm_set1_pd(f.t[1]);
+    const __m128d tz = _mm_set1_pd(f.t[2]);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(a.x + i);
+        __m128d y = _mm_loadu_pd(a.y + i);
+        __m128d z = _mm_loadu_pd(a.z + i);
+        _mm_storeu_pd(a.x + i, transformRowSse2(m + 0, x, y, z, tx));
+        _mm_storeu_pd(a.y + i, transformRowSse2(m + 3, x, y, z, ty));
+        _mm_storeu_pd(a.z + i, transformRowSse2(m + 6, x, y, z, tz));
+    }
+    transformScalar(i, n, f, a);
+}
+
+JET_TARGET_AVX void dotAvx(
+    size_t n,
+    const ConstComponents& a,
+    const ConstComponents& b,
+    double* result) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_add_pd(
+            _mm256_add_pd(
+                _mm256_mul_pd(
+                    _mm256_loadu_pd(a.x + i), _mm256_loadu_pd(b.x + i)),
+                _mm256_mul_pd(
+                    _mm256_loadu_pd(a.y + i), _mm256_loadu_pd(b.y + i))),
+            _mm256_mul_pd(_mm256_loadu_pd(a.z + i), _mm256_loadu_pd(b.z + i)));
+        _mm256_storeu_pd(result + i, d);
+    }
+    dotScalar(i, n, a, b, result);
+}
+
+JET_TARGET_AVX inline __m256d lengthAvx(const ConstComponents& a, size_t i) {
+    __m256d x = _mm256_loadu_pd(a.x + i);
+    __m256d y = _mm256_loadu_pd(a.y + i);
+    __m256d z = _mm256_loadu_pd(a.z + i);
+    return _mm256_sqrt_pd(_mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)),
+        _mm256_mul_pd(z, z)));
+}
+
+JET_TARGET_AVX void lengthAvx(
+    size_t n, const ConstComponents& a, double* result) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(result + i, lengthAvx(a, i));
+    }
+    lengthScalar(i, n, a, result);
+}
+
+JET_TARGET_AVX void normalizeAvx(size_t n, const Components& a) {
+    const ConstComponents c = { a.x, a.y, a.z };
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d l = lengthAvx(c, i);
+        _mm256_storeu_pd(a.x + i, _mm256_div_pd(_mm256_loadu_pd(a.x + i), l));
+        _mm256_storeu_pd(a.y + i, _mm256_div_pd(_mm256_loadu_pd(a.y + i), l));
+        _mm256_storeu_pd(a.z + i, _mm256_div_pd(_mm256_loadu_pd(a.z + i), l));
+    }
+    normalizeScalar(i, n, a);
+}
+
+// Returns m[0] * x + m[1] * y + m[2] * z + t.
+JET_TARGET_AVX inline __m256d transformRowAvx(
+    const __m256d* m, __m256d x, __m256d y, __m256d z, __m256d t) {
+    __m256d r = _mm256_add_pd(_mm256_mul_pd(m[0], x), _mm256_mul_pd(m[1], y));
+    r = _mm256_add_pd(r, _mm256_mul_pd(m[2], z));
+    return _mm256_add_pd(r, t);
+}
+
+JET_TARGET_AVX void transformAvx(
+    size_t n, const Transform& f, const Components& a) {
+    __m256d m[9];
+    for (size_t k = 0; k < 9; ++k) {
+        m[k] = _mm256_set1_pd(f.m[k]);
+    }
+    const __m256d tx = _mm256_set1_pd(f.t[0]);
+    const __m256d ty = _mm256_set1_pd(f.t[1]);
+    const __m256d tz = _mm256_set1_pd(f.t[2]);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(a.x + i);
+        __m256d y = _mm256_loadu_pd(a.y + i);
+        __m256d z = _mm256_loadu_pd(a.z + i);
+        _mm256_storeu_pd(a.x + i, transformRowAvx(m + 0, x, y, z, tx));
+        _mm256_storeu_pd(a.y + i, transformRowAvx(m + 3, x, y, z, ty));
+        _mm256_storeu_pd(a.z + i, transformRowAvx(m + 6, x, y, z, tz));
+    }
+    transformScalar(i, n, f, a);
+}
+
+JET_TARGET_AVX512 void dotAvx512(
+    size_t n,
+    const ConstComponents& a,
+    const ConstComponents& b,
+    double* result) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_add_pd(
+            _mm512_add_pd(
+                _mm512_mul_pd(
+                    _mm512_loadu_pd(a.x + i), _mm512_loadu_pd(b.x + i)),
+                _mm512_mul_pd(
+                    _mm512_loadu_pd(a.y + i), _mm512_loadu_pd(b.y + i))),
+            _mm512_mul_pd(_mm512_loadu_pd(a.z + i), _mm512_loadu_pd(b.z + i)));
+        _mm512_storeu_pd(result + i, d);
+    }
+    dotScalar(i, n, a, b, result);
+}
+
+JET_TARGET_AVX512 inline __m512d lengthAvx512(
+    const ConstComponents& a, size_t i) {
+    __m512d x = _mm512_loadu_pd(a.x + i);
+    __m512d y = _mm512_loadu_pd(a.y + i);
+    __m512d z = _mm512_loadu_pd(a.z + i);
+
+    // Same as _mm512_sqrt_pd, whose undefined pass-through operand makes GCC
+    // warn about an uninitialized value
+    return _mm512_maskz_sqrt_pd(
+        static_cast<__mmask8>(0xFF),
+        _mm512_add_pd(
+            _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)),
+            _mm512_mul_pd(z, z)));
+}
+
+JET_TARGET_AVX512 void lengthAvx512(
+    size_t n, const ConstComponents& a, double* result) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(result + i, lengthAvx512(a, i));
+    }
+    lengthScalar(i, n, a, result);
+}
+
+JET_TARGET_AVX512 void normalizeAvx512(size_t n, const Components& a) {
+    const ConstComponents c = { a.x, a.y, a.z };
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d l = lengthAvx512(c, i);
+        _mm512_storeu_pd(a.x + i, _mm512_div_pd(_mm512_loadu_pd(a.x + i), l));
+        _mm512_storeu_pd(a.y + i, _mm512_div_pd(_mm512_loadu_pd(a.y + i), l));
+        _mm512_storeu_pd(a.z + i, _mm512_div_pd(_mm512_loadu_pd(a.z + i), l));
+    }
+    normalizeScalar(i, n, a);
+}
+
+// Returns m[0] * x + m[1] * y + m[2] * z + t.
+JET_TARGET_AVX512 inline __m512d transformRowAvx512(
+    const __m512d* m, __m512d x, __m512d y, __m512d z, __m512d t) {
+    __m512d r = _mm512_add_pd(_mm512_mul_pd(m[0], x), _mm512_mul_pd(m[1], y));
+    r = _mm512_add_pd(r, _mm512_mul_pd(m[2], z));
+    return _mm512_add_pd(r, t);
+}
+
+JET_TARGET_AVX512 void transformAvx512(
+    size_t n, const Transform& f, const Components& a) {
+    __m512d m[9];
+    for (size_t k = 0; k < 9; ++k) {
+        m[k] = _mm512_set1_pd(f.m[k]);
+    }
+    const __m512d tx = _mm512_set1_pd(f.t[0]);
+    const __m512d ty = _mm512_set1_pd(f.t[1]);
+    const __m512d tz = _mm512_set1_pd(f.t[2]);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_loadu_pd(a.x + i);
+        __m512d y = _mm512_loadu_pd(a.y + i);
+        __m512d z = _mm512_loadu_pd(a.z + i);
+        _mm512_storeu_pd(a.x + i, transformRowAvx512(m + 0, x, y, z, tx));
+        _mm512_storeu_pd(a.y + i, transformRowAvx512(m + 3, x, y, z, ty));
+        _mm512_storeu_pd(a.z + i, transformRowAvx512(m + 6, x, y, z, tz));
+    }
+    transformScalar(i, n, f, a);
+}
+
+#elif defined(JET_SIMD_NEON)
+
+void dotNeon(
+    size_t n,
+    const ConstComponents& a,
+    const ConstComponents& b,
+    double* result) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t d = vaddq_f64(
+            vaddq_f64(
+                vmulq_f64(vld1q_f64(a.x + i), vld1q_f64(b.x + i)),
+                vmulq_f64(vld1q_f64(a.y + i), vld1q_f64(b.y + i))),
+            vmulq_f64(vld1q_f64(a.z + i), vld1q_f64(b.z + i)));
+        vst1q_f64(result + i, d);
+    }
+    dotScalar(i, n, a, b, result);
+}
+
+inline float64x2_t lengthNeon(const ConstComponents& a, size_t i) {
+    float64x2_t x = vld1q_f64(a.x + i);
+    float64x2_t y = vld1q_f64(a.y + i);
+    float64x2_t z = vld1q_f64(a.z + i);
+    return vsqrtq_f64(vaddq_f64(
+        vaddq_f64(vmulq_f64(x, x), vmulq_f64(y, y)), vmulq_f64(z, z)));
+}
+
+void lengthNeon(size_t n, const ConstComponents& a, double* result) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(result + i, lengthNeon(a, i));
+    }
+    lengthScalar(i, n, a, result);
+}
+
+void normalizeNeon(size_t n, const Components& a) {
+    const ConstComponents c = { a.x, a.y, a.z };
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t l = lengthNeon(c, i);
+        vst1q_f64(a.x + i, vdivq_f64(vld1q_f64(a.x + i), l));
+        vst1q_f64(a.y + i, vdivq_f64(vld1q_f64(a.y + i), l));
+        vst1q_f64(a.z + i, vdivq_f64(vld1q_f64(a.z + i), l));
+    }
+    normalizeScalar(i, n, a);
+}
+
+// Returns m[0] * x + m[1] * y + m[2] * z + t.
+inline float64x2_t transformRowNeon(
+    const float64x2_t* m,
+    float64x2_t x,
+    float64x2_t y,
+    float64x2_t z,
+    float64x2_t t) {
+    float64x2_t r = vaddq_f64(vmulq_f64(m[0], x), vmulq_f64(m[1], y));
+    r = vaddq_f64(r, vmulq_f64(m[2], z));
+    return vaddq_f64(r, t);
+}
+
+void transformNeon(
+    size_t n, const Transform& f, const Components& a) {
+    float64x2_t m[9];
+    for (size_t k = 0; k < 9; ++k) {
+        m[k] = vdupq_n_f64(f.m[k]);
+    }
+    const float64x2_t tx = vdupq_n_f64(f.t[0]);
+    const float64x2_t ty = vdupq_n_f64(f.t[1]);
+    const float64x2_t tz = vdupq_n_f64(f.t[2]);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t x = vld1q_f64(a.x + i);
+        float64x2_t y = vld1q_f64(a.y + i);
+        float64x2_t z = vld1q_f64(a.z + i);
+        vst1q_f64(a.x + i, transformRowNeon(m + 0, x, y, z, tx));
+        vst1q_f64(a.y + i, transformRowNeon(m + 3, x, y, z, ty));
+        vst1q_f64(a.z + i, transformRowNeon(m + 6, x, y, z, tz));
+    }
+    transformScalar(i, n, f, a);
+}
+
+#endif
+
+ConstComponents offset(const ConstComponents& a, size_t begin) {
+    return { a.x + begin, a.y + begin, a.z + begin };
+}
+
+Components offset(const Components& a, size_t begin) {
+    return { a.x + begin, a.y + begin, a.z + begin };
+}
+
+void dotRange(
+    size_t n,
+    const ConstComponents& a,
+    const ConstComponents& b,
+    double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+            dotAvx512(n, a, b, result);
+            return;
+        case SimdInstructionSet::Avx:
+            dotAvx(n, a, b, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            dotSse2(n, a, b, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            dotNeon(n, a, b, result);
+            return;
+#endif
+        default:
+            dotScalar(0, n, a, b, result);
+            return;
+    }
+}
+
+void lengthRange(size_t n, const ConstComponents& a, double* result) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+            lengthAvx512(n, a, result);
+            return;
+        case SimdInstructionSet::Avx:
+            lengthAvx(n, a, result);
+            return;
+        case SimdInstructionSet::Sse2:
+            lengthSse2(n, a, result);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            lengthNeon(n, a, result);
+            return;
+#endif
+        default:
+            lengthScalar(0, n, a, result);
+            return;
+    }
+}
+
+void normalizeRange(size_t n, const Components& a) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+            normalizeAvx512(n, a);
+            return;
+        case SimdInstructionSet::Avx:
+            normalizeAvx(n, a);
+            return;
+        case SimdInstructionSet::Sse2:
+            normalizeSse2(n, a);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            normalizeNeon(n, a);
+            return;
+#endif
+        default:
+            normalizeScalar(0, n, a);
+            return;
+    }
+}
+
+void transformRange(size_t n, const Transform& f, const Components& a) {
+    switch (simdInstructionSet()) {
+#if defined(JET_SIMD_X86)
+        case SimdInstructionSet::Avx512:
+            transformAvx512(n, f, a);
+            return;
+        case SimdInstructionSet::Avx:
+            transformAvx(n, f, a);
+            return;
+        case SimdInstructionSet::Sse2:
+            transformSse2(n, f, a);
+            return;
+#elif defined(JET_SIMD_NEON)
+        case SimdInstructionSet::Neon:
+            transformNeon(n, f, a);
+            return;
+#endif
+        default:
+            transformScalar(0, n, f, a);
+            return;
+    }
+}
+
+}  // namespace
+
+Vector3Batch::Vector3Batch() {
+}
+
+Vector3Batch::Vector3Batch(size_t size) {
+    resize(size);
+}
+
+Vector3Batch::Vector3Batch(const ConstArrayAccessor1<Vector3D>& vectors) {
+    load(vectors);
+}
+
+size_t Vector3Batch::size() const {
+    return _x.size();
+}
+
+void Vector3Batch::resize(size_t size) {
+    _x.resize(size, 0.0);
+    _y.resize(size, 0.0);
+    _z.resize(size, 0.0);
+}
+
+Vector3D Vector3Batch::at(size_t i) const {
+    return Vector3D(_x[i], _y[i], _z[i]);
+}
+
+void Vector3Batch::setAt(size_t i, const Vector3D& v) {
+    _x[i] = v.x;
+    _y[i] = v.y;
+    _z[i] = v.z;
+}
+
+ArrayAccessor1<double> Vector3Batch::x() {
+    return _x.accessor();
+}
+
+ConstArrayAccessor1<double> Vector3Batch::x() const {
+    return _x.constAccessor();
+}
+
+ArrayAccessor1<double> Vector3Batch::y() {
+    return _y.accessor();
+}
+
+ConstArrayAccessor1<double> Vector3Batch::y() const {
+    return _y.constAccessor();
+}
+
+ArrayAccessor1<double> Vector3Batch::z() {
+    return _z.accessor();
+}
+
+ConstArrayAccessor1<double> Vector3Batch::z() const {
+    return _z.constAccessor();
+}
+
+void Vector3Batch::load(const ConstArrayAccessor1<Vector3D>& vectors) {
+    load(vectors.data(), vectors.size());
+}
+
+void Vector3Batch::load(const ConstArrayAccessor3<Vector3D>& vectors) {
+    const Size3 size = vectors.size();
+    load(vectors.data(), size.x * size.y * size.z);
+}
+
+void Vector3Batch::store(ArrayAccessor1<Vector3D> vectors) const {
+    JET_THROW_INVALID_ARG_IF(vectors.size() != size());
+    store(vectors.data());
+}
+
+void Vector3Batch::store(ArrayAccessor3<Vector3D> vectors) const {
+    const Size3 s = vectors.size();
+    JET_THROW_INVALID_ARG_IF(s.x * s.y * s.z != size());
+    store(vectors.data());
+}
+
+void Vector3Batch::dot(
+    const Vector3Batch& other, ArrayAccessor1<double> result) const {
+    JET_THROW_INVALID_ARG_IF(other.size() != size());
+    JET_THROW_INVALID_ARG_IF(result.size() != size());
+
+    const ConstComponents a = { _x.data(), _y.data(), _z.data() };
+    const ConstComponents b = { other._x.data(), other._y.data(),
+                                other._z.data() };
+    double* out = result.data();
+    parallelRangeFor(
+        kZeroSize, size(), kBatchGrainSize, [&](size_t begin, size_t end) {
+            dotRange(
+                end - begin, offset(a, begin), offset(b, begin), out + begin);
+        });
+}
+
+void Vector3Batch::length(ArrayAccessor1<double> result) const {
+    JET_THROW_INVALID_ARG_IF(result.size() != size());
+
+    const ConstComponents a = { _x.data(), _y.data(), _z.data() };
+    double* out = result.data();
+    parallelRangeFor(
+        kZeroSize, size(), kBatchGrainSize, [&](size_t begin, size_t end) {
+            lengthRange(end - begin, offset(a, begin), out + begin);
+        });
+}
+
+void Vector3Batch::normalize() {
+    const Components a = { _x.data(), _y.data(), _z.data() };
+    parallelRangeFor(
+        kZeroSize, size(), kBatchGrainSize, [&](size_t begin, size_t end) {
+            normalizeRange(end - begin, offset(a, begin));
+        });
+}
+
+void Vector3Batch::transform(
+    const Matrix3x3D& matrix,
+    const Vector3D& translation) {
+    Transform f;
+    for (size_t k = 0; k < 9; ++k) {
+        f.m[k] = matrix(k / 3, k % 3);
+    }
+    f.t[0] = translation.x;
+    f.t[1] = translation.y;
+    f.t[2] = translation.z;
+
+    const Components a = { _x.data(), _y.data(), _z.data() };
+    parallelRangeFor(
+        kZeroSize, size(), kBatchGrainSize, [&](size_t begin, size_t end) {
+            transformRange(end - begin, f, offset(a, begin));
+        });
+}
+
+void Vector3Batch::axpy(
+    double a,
+    const Vector3Batch& x,
+    const Vector3Batch& y,
+    Vector3Batch* result) {
+    JET_THROW_INVALID_ARG_IF(x.size() != y.size());
+    JET_THROW_INVALID_ARG_IF(x.size() != result->size());
+
+    // Each component is the axpy of the FDM vectors
+    parallelRangeFor(
+        kZeroSize, x.size(), kBatchGrainSize, [&](size_t begin, size_t end) {
+            const size_t n = end - begin;
+            internal::fdmAxpyRow(
+                n, a, x._x.data() + begin, y._x.data() + begin,
+                result->_x.data() + begin);
+            internal::fdmAxpyRow(
+                n, a, x._y.data() + begin, y._y.data() + begin,
+                result->_y.data() + begin);
+            internal::fdmAxpyRow(
+                n, a, x._z.data() + begin, y._z.data() + begin,
+                result->_z.data() + begin);
+        });
+}
+
+void Vector3Batch::load(const Vector3D* vectors, size_t size) {
+    resize(size);
+    parallelFor(kZeroSize, size, [&](size_t i) {
+        _x[i] = vectors[i].x;
+        _y[i] = vectors[i].y;
+        _z[i] = vectors[i].z;
+    });
+}
+
+void Vector3Batch::store(Vector3D* vectors) const {
+    parallelFor(kZeroSize, size(), [&](size_t i) {
+        vectors[i] = Vector3D(_x[i], _y[i], _z[i]);
+    });
+}
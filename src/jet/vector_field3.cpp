@@ -11,6 +11,14 @@ VectorField3::VectorField3() {
 VectorField3::~VectorField3() {
 }
 
+void VectorField3::batchSample(
+    const ConstArrayAccessor1<Vector3D>& x,
+    ArrayAccessor1<Vector3D> result) const {
+    for (size_t i = 0; i < x.size(); ++i) {
+        result[i] = sample(x[i]);
+    }
+}
+
 double VectorField3::divergence(const Vector3D&) const {
     return 0.0;
 }
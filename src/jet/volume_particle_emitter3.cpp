@@ -2,14 +2,27 @@
 
 #include <pch.h>
 #include <jet/bcc_lattice_point_generator.h>
+#include <jet/parallel.h>
 #include <jet/point_hash_grid_searcher3.h>
+#include <jet/point_hash_grid_utils.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
 #include <jet/samplers.h>
 #include <jet/volume_particle_emitter3.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 using namespace jet;
 
 static const size_t kDefaultHashGridResolution = 64;
 
+// Number of candidate points that are tested together
+static const size_t kEmissionBatchSize = 1 << 20;
+
+// Number of candidate points that share a random stream
+static const size_t kEmissionBlockSize = 1024;
+
 VolumeParticleEmitter3::VolumeParticleEmitter3(
     const ImplicitSurface3Ptr& implicitSurface,
     const BoundingBox3D& bounds,
@@ -35,84 +48,200 @@ VolumeParticleEmitter3::VolumeParticleEmitter3(
 void VolumeParticleEmitter3::emit(
     const Frame& frame,
     const ParticleSystemData3Ptr& particles) {
-    UNUSED_VARIABLE(frame);
-
-    if (_numberOfEmittedParticles > 0 && _isOneShot) {
-        return;
-    }
-
     Array1<Vector3D> newPositions;
     Array1<Vector3D> newVelocities;
 
-    emit(particles, &newPositions, &newVelocities);
+    generate(frame, particles, &newPositions, &newVelocities);
 
-    particles->addParticles(newPositions, newVelocities);
+    particles->addParticles(std::move(newPositions), std::move(newVelocities));
 }
 
-void VolumeParticleEmitter3::emit(
+void VolumeParticleEmitter3::generate(
+    const Frame& frame,
     const ParticleSystemData3Ptr& particles,
     Array1<Vector3D>* newPositions,
     Array1<Vector3D>* newVelocities) {
-    // Reserving more space for jittering
-    const double j = jitter();
-    const double maxJitterDist = 0.5 * j * _spacing;
+    UNUSED_VARIABLE(frame);
 
-    if (_allowOverlapping || _isOneShot) {
-        _pointsGen->forEachPoint(
-            _bounds,
-            _spacing,
-            [&] (const Vector3D& point) {
-                Vector3D randomDir = uniformSampleSphere(
-                    random(),
-                    random());
-                Vector3D offset = maxJitterDist * randomDir;
-                Vector3D candidate = point + offset;
-                if (_implicitSurface->signedDistance(candidate) <= 0.0) {
+    newPositions->clear();
+    newVelocities->clear();
+
+    if (_numberOfEmittedParticles > 0 && _isOneShot) {
+        return;
+    }
+
+    const double maxJitterDist = 0.5 * jitter() * _spacing;
+    const bool isCheckingOverlap = !(_allowOverlapping || _isOneShot);
+
+    // The existing particles are tested in parallel with the parallel
+    // searcher, while the new ones are added to the serial searcher one by
+    // one, so a new particle is also kept away from the previous new ones.
+    auto positions = particles->positions();
+    PointParallelHashGridSearcher3 existingSearcher(
+        isCheckingOverlap
+            ? suggestedHashGridResolution3(positions, 2.0 * _spacing)
+            : Size3(1, 1, 1),
+        2.0 * _spacing);
+    PointHashGridSearcher3 newSearcher(
+        Size3(
+            kDefaultHashGridResolution,
+            kDefaultHashGridResolution,
+            kDefaultHashGridResolution),
+        2.0 * _spacing);
+    if (isCheckingOverlap) {
+        existingSearcher.build(positions);
+    }
+
+    Array1<Vector3D> candidates;
+    std::vector<char> isAccepted;
+    std::vector<uint32_t> blockSeeds;
+    std::vector<size_t> blockOffsets;
+    bool isFull = false;
+
+    // Jitters and tests a batch of candidates in parallel, then appends the
+    // accepted ones in the generation order. Each block of candidates has
+    // its own random stream seeded from the emitter's, so the result does
+    // not depend on the number of threads.
+    auto processCandidates = [&]() {
+        const size_t n = candidates.size();
+        const size_t numberOfBlocks
+            = (n + kEmissionBlockSize - 1) / kEmissionBlockSize;
+        isAccepted.resize(n);
+        blockSeeds.resize(numberOfBlocks);
+        blockOffsets.resize(numberOfBlocks + 1);
+        if (maxJitterDist > 0.0) {
+            for (size_t b = 0; b < numberOfBlocks; ++b) {
+                blockSeeds[b] = static_cast<uint32_t>(_rng());
+            }
+        }
+
+        parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+            std::mt19937 rng(blockSeeds[b]);
+            std::uniform_real_distribution<> d(0.0, 1.0);
+            size_t begin = b * kEmissionBlockSize;
+            size_t end = std::min(begin + kEmissionBlockSize, n);
+            size_t count = 0;
+            for (size_t i = begin; i < end; ++i) {
+                Vector3D& candidate = candidates[i];
+                if (maxJitterDist > 0.0) {
+                    double u1 = d(rng);
+                    double u2 = d(rng);
+                    candidate += maxJitterDist * uniformSampleSphere(u1, u2);
+                }
+                bool accepted
+                    = _implicitSurface->signedDistance(candidate) <= 0.0
+                    && !(isCheckingOverlap
+                         && existingSearcher.hasNearbyPoint(
+                             candidate, _spacing));
+                isAccepted[i] = accepted;
+                count += accepted;
+            }
+            blockOffsets[b + 1] = count;
+        });
+
+        const size_t remaining
+            = _maxNumberOfParticles - _numberOfEmittedParticles;
+
+        if (isCheckingOverlap) {
+            for (size_t i = 0; i < n && !isFull; ++i) {
+                if (isAccepted[i]
+                    && !newSearcher.hasNearbyPoint(candidates[i], _spacing)) {
                     if (_numberOfEmittedParticles < _maxNumberOfParticles) {
-                        newPositions->append(candidate);
+                        newPositions->append(candidates[i]);
+                        newSearcher.add(candidates[i]);
                         ++_numberOfEmittedParticles;
                     } else {
-                        return false;
+                        isFull = true;
                     }
                 }
+            }
+        } else {
+            // Compacts the accepted candidates with the prefix sum of the
+            // block counts
+            blockOffsets[0] = 0;
+            for (size_t b = 0; b < numberOfBlocks; ++b) {
+                blockOffsets[b + 1] += blockOffsets[b];
+            }
+            size_t numberOfAccepted
+                = std::min(blockOffsets[numberOfBlocks], remaining);
+            isFull = blockOffsets[numberOfBlocks] > remaining;
 
-                return true;
+            size_t oldSize = newPositions->size();
+            newPositions->resize(oldSize + numberOfAccepted);
+            parallelFor(kZeroSize, numberOfBlocks, [&](size_t b) {
+                size_t dst = blockOffsets[b];
+                size_t begin = b * kEmissionBlockSize;
+                size_t end = std::min(begin + kEmissionBlockSize, n);
+                for (size_t i = begin; i < end && dst < numberOfAccepted;
+                     ++i) {
+                    if (isAccepted[i]) {
+                        (*newPositions)[oldSize + dst] = candidates[i];
+                        ++dst;
+                    }
+                }
             });
-    } else {
-        // Use serial hash grid searcher for continuous update.
-        PointHashGridSearcher3 neighborSearcher(
-            Size3(
-                kDefaultHashGridResolution,
-                kDefaultHashGridResolution,
-                kDefaultHashGridResolution),
-            2.0 * _spacing);
-        if (!_allowOverlapping) {
-            neighborSearcher.build(particles->positions());
+            _numberOfEmittedParticles += numberOfAccepted;
         }
 
+        candidates.clear();
+    };
+
+    const size_t numberOfSlices
+        = _pointsGen->numberOfSlices(_bounds, _spacing);
+    if (numberOfSlices > 1) {
+        // Generates the candidates of the slices that fit in a batch in
+        // parallel, directly into the array sized by the slice counts
+        std::vector<size_t> sliceOffsets(numberOfSlices + 1, 0);
+        parallelFor(kZeroSize, numberOfSlices, [&](size_t s) {
+            sliceOffsets[s + 1] = _pointsGen->countPointsInSlices(
+                _bounds, _spacing, s, s + 1);
+        });
+        for (size_t s = 0; s < numberOfSlices; ++s) {
+            sliceOffsets[s + 1] += sliceOffsets[s];
+        }
+
+        size_t sliceBegin = 0;
+        while (sliceBegin < numberOfSlices && !isFull) {
+            size_t sliceEnd = sliceBegin + 1;
+            while (sliceEnd < numberOfSlices
+                   && sliceOffsets[sliceEnd + 1] - sliceOffsets[sliceBegin]
+                      <= kEmissionBatchSize) {
+                ++sliceEnd;
+            }
+
+            candidates.resize(
+                sliceOffsets[sliceEnd] - sliceOffsets[sliceBegin]);
+            Vector3D* data = candidates.data();
+            parallelFor(sliceBegin, sliceEnd, [&](size_t s) {
+                _pointsGen->generateRange(
+                    _bounds,
+                    _spacing,
+                    s,
+                    s + 1,
+                    ArrayAccessor1<Vector3D>(
+                        sliceOffsets[s + 1] - sliceOffsets[s],
+                        data + sliceOffsets[s] - sliceOffsets[sliceBegin]));
+            });
+            if (candidates.size() > 0) {
+                processCandidates();
+            }
+
+            sliceBegin = sliceEnd;
+        }
+    } else {
         _pointsGen->forEachPoint(
             _bounds,
             _spacing,
             [&] (const Vector3D& point) {
-                Vector3D randomDir = uniformSampleSphere(
-                    random(),
-                    random());
-                Vector3D offset = maxJitterDist * randomDir;
-                Vector3D candidate = point + offset;
-                if (_implicitSurface->signedDistance(candidate) <= 0.0 &&
-                    (!_allowOverlapping &&
-                     !neighborSearcher.hasNearbyPoint(candidate, _spacing))) {
-                    if (_numberOfEmittedParticles < _maxNumberOfParticles) {
-                        newPositions->append(candidate);
-                        neighborSearcher.add(candidate);
-                        ++_numberOfEmittedParticles;
-                    } else {
-                        return false;
-                    }
+                candidates.append(point);
+                if (candidates.size() == kEmissionBatchSize) {
+                    processCandidates();
                 }
-
-                return true;
+                return !isFull;
             });
+        if (!isFull && candidates.size() > 0) {
+            processCandidates();
+        }
     }
 
     newVelocities->resize(newPositions->size());
@@ -165,6 +294,18 @@ void VolumeParticleEmitter3::setSpacing(double newSpacing) {
     _spacing = newSpacing;
 }
 
+void VolumeParticleEmitter3::setPreviewScale(double factor) {
+    if (previewScale() == 1.0) {
+        _fullSpacing = _spacing;
+        _fullMaxNumberOfParticles = _maxNumberOfParticles;
+    }
+    ParticleEmitter3::setPreviewScale(factor);
+
+    _spacing = _fullSpacing * factor;
+    _maxNumberOfParticles
+        = scaledNumberOfParticles(_fullMaxNumberOfParticles, factor);
+}
+
 Vector3D VolumeParticleEmitter3::initialVelocity() const {
     return _initialVel;
 }
@@ -172,8 +313,3 @@ Vector3D VolumeParticleEmitter3::initialVelocity() const {
 void VolumeParticleEmitter3::setInitialVelocity(const Vector3D& newInitialVel) {
     _initialVel = newInitialVel;
 }
-
-double VolumeParticleEmitter3::random() {
-    std::uniform_real_distribution<> d(0.0, 1.0);
-    return d(_rng);
-}
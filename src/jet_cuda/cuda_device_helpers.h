@@ -0,0 +1,87 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_JET_CUDA_CUDA_DEVICE_HELPERS_H_
+#define SRC_JET_CUDA_CUDA_DEVICE_HELPERS_H_
+
+#include <cuda_runtime.h>
+
+#include <stdexcept>
+
+namespace jet {
+
+namespace internal {
+
+// Number of threads per block of the element-wise kernels
+const unsigned int kCudaBlockSize = 256;
+
+inline void checkCuda(cudaError_t error) {
+    if (error != cudaSuccess) {
+        throw std::runtime_error(cudaGetErrorString(error));
+    }
+}
+
+inline unsigned int cudaNumberOfBlocks(size_t n) {
+    return static_cast<unsigned int>(
+        (n + kCudaBlockSize - 1) / kCudaBlockSize);
+}
+
+// Device memory which is reallocated only when the size changes.
+template <typename T>
+class DeviceArray final {
+ public:
+    DeviceArray() = default;
+
+    DeviceArray(const DeviceArray&) = delete;
+
+    ~DeviceArray() {
+        cudaFree(_data);
+    }
+
+    DeviceArray& operator=(const DeviceArray&) = delete;
+
+    T* data() {
+        return _data;
+    }
+
+    const T* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    void resize(size_t size) {
+        if (size != _size) {
+            checkCuda(cudaFree(_data));
+            _data = nullptr;
+            _size = 0;
+            checkCuda(cudaMalloc(&_data, size * sizeof(T)));
+            _size = size;
+        }
+    }
+
+    void upload(const T* host) {
+        checkCuda(cudaMemcpy(
+            _data, host, _size * sizeof(T), cudaMemcpyHostToDevice));
+    }
+
+    void download(T* host) const {
+        checkCuda(cudaMemcpy(
+            host, _data, _size * sizeof(T), cudaMemcpyDeviceToHost));
+    }
+
+    void setZero() {
+        checkCuda(cudaMemset(_data, 0, _size * sizeof(T)));
+    }
+
+ private:
+    T* _data = nullptr;
+    size_t _size = 0;
+};
+
+}  // namespace internal
+
+}  // namespace jet
+
+#endif  // SRC_JET_CUDA_CUDA_DEVICE_HELPERS_H_
@@ -0,0 +1,18 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <cuda_helpers.h>
+
+#include <cuda_runtime.h>
+
+namespace jet {
+
+namespace internal {
+
+bool isCudaDeviceAvailable() {
+    int count = 0;
+    return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+}
+
+}  // namespace internal
+
+}  // namespace jet
@@ -0,0 +1,368 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <cuda_device_helpers.h>
+#include <cuda_pcg_helpers.h>
+
+#include <cmath>
+#include <vector>
+
+namespace jet {
+
+namespace internal {
+
+namespace {
+
+// The dot products are reduced to this many partial sums on the device and
+// the partial sums are added on the host, both in a fixed order, so the
+// results do not change from run to run.
+const unsigned int kNumberOfDotBlocks = 128;
+
+struct DeviceGrid {
+    size_t width;
+    size_t height;
+    size_t depth;
+};
+
+// Returns (Ax)_idx, adding the terms in the same order as the host kernels.
+__device__ double stencilProduct(
+    const FdmMatrixRow3* a,
+    const double* x,
+    DeviceGrid grid,
+    size_t idx) {
+    size_t slice = grid.width * grid.height;
+    size_t i = idx % grid.width;
+    size_t j = (idx / grid.width) % grid.height;
+    size_t k = idx / slice;
+
+    double value = a[idx].center * x[idx];
+    if (i > 0) {
+        value += a[idx - 1].right * x[idx - 1];
+    }
+    if (i + 1 < grid.width) {
+        value += a[idx].right * x[idx + 1];
+    }
+    if (j > 0) {
+        value += a[idx - grid.width].up * x[idx - grid.width];
+    }
+    if (j + 1 < grid.height) {
+        value += a[idx].up * x[idx + grid.width];
+    }
+    if (k > 0) {
+        value += a[idx - slice].front * x[idx - slice];
+    }
+    if (k + 1 < grid.depth) {
+        value += a[idx].front * x[idx + slice];
+    }
+    return value;
+}
+
+// result = Ax
+__global__ void mvmKernel(
+    const FdmMatrixRow3* a,
+    const double* x,
+    DeviceGrid grid,
+    size_t n,
+    double* result) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < n) {
+        result[idx] = stencilProduct(a, x, grid, idx);
+    }
+}
+
+// result = b - Ax
+__global__ void residualKernel(
+    const FdmMatrixRow3* a,
+    const double* x,
+    const double* b,
+    DeviceGrid grid,
+    size_t n,
+    double* result) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < n) {
+        result[idx] = b[idx] - stencilProduct(a, x, grid, idx);
+    }
+}
+
+// result = alpha * x + y
+__global__ void axpyKernel(
+    double alpha,
+    const double* x,
+    const double* y,
+    size_t n,
+    double* result) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < n) {
+        result[idx] = alpha * x[idx] + y[idx];
+    }
+}
+
+// result = D^-1 b, where D is the diagonal of A
+__global__ void jacobiKernel(
+    const FdmMatrixRow3* a,
+    const double* b,
+    size_t n,
+    double* result) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < n) {
+        double center = a[idx].center;
+        result[idx] = (center != 0.0) ? b[idx] / center : 0.0;
+    }
+}
+
+// partialSums[blockIdx.x] = sum of a_i * b_i over the indices of the block
+__global__ void dotKernel(
+    const double* a,
+    const double* b,
+    size_t n,
+    double* partialSums) {
+    __shared__ double sums[kCudaBlockSize];
+
+    size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+    double sum = 0.0;
+    for (size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x)
+            + threadIdx.x;
+        idx < n;
+        idx += stride) {
+        sum += a[idx] * b[idx];
+    }
+    sums[threadIdx.x] = sum;
+    __syncthreads();
+
+    for (unsigned int half = blockDim.x / 2; half > 0; half /= 2) {
+        if (threadIdx.x < half) {
+            sums[threadIdx.x] += sums[threadIdx.x + half];
+        }
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0) {
+        partialSums[blockIdx.x] = sums[0];
+    }
+}
+
+}  // namespace
+
+class CudaPcgState final {
+ public:
+    DeviceGrid grid = {0, 0, 0};
+    size_t n = 0;
+
+    DeviceArray<FdmMatrixRow3> A;
+    DeviceArray<double> b;
+    DeviceArray<double> x;
+    DeviceArray<double> r;
+    DeviceArray<double> d;
+    DeviceArray<double> q;
+    DeviceArray<double> s;
+    DeviceArray<double> partialSums;
+    std::vector<double> hostPartialSums;
+
+    void mvm(DeviceArray<double>* v, DeviceArray<double>* result) {
+        mvmKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+            A.data(), v->data(), grid, n, result->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    void residual(DeviceArray<double>* result) {
+        residualKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+            A.data(), x.data(), b.data(), grid, n, result->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    void axpy(
+        double alpha,
+        DeviceArray<double>* v,
+        DeviceArray<double>* w,
+        DeviceArray<double>* result) {
+        axpyKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+            alpha, v->data(), w->data(), n, result->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    void precondition(DeviceArray<double>* v, DeviceArray<double>* result) {
+        jacobiKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+            A.data(), v->data(), n, result->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    double dot(DeviceArray<double>* v, DeviceArray<double>* w) {
+        dotKernel<<<kNumberOfDotBlocks, kCudaBlockSize>>>(
+            v->data(), w->data(), n, partialSums.data());
+        checkCuda(cudaGetLastError());
+
+        partialSums.download(hostPartialSums.data());
+        double sum = 0.0;
+        for (double partialSum : hostPartialSums) {
+            sum += partialSum;
+        }
+        return sum;
+    }
+};
+
+void CudaPcgStateDeleter::operator()(CudaPcgState* state) const {
+    delete state;
+}
+
+CudaPcgState* createCudaPcgState() {
+    CudaPcgState* state = new CudaPcgState();
+    state->partialSums.resize(kNumberOfDotBlocks);
+    state->hostPartialSums.resize(kNumberOfDotBlocks);
+    return state;
+}
+
+namespace {
+
+// Resizes the device vectors, which stay on the device until the grid size
+// changes.
+void resizeCudaPcgVectors(CudaPcgState* state, const Size3& size) {
+    state->grid = {size.x, size.y, size.z};
+    state->n = size.x * size.y * size.z;
+
+    state->A.resize(state->n);
+    state->b.resize(state->n);
+    state->x.resize(state->n);
+    state->r.resize(state->n);
+    state->d.resize(state->n);
+    state->q.resize(state->n);
+    state->s.resize(state->n);
+}
+
+// Solves Ax = b with the device vectors of the state, starting from x.
+void runCudaPcg(
+    CudaPcgState* state,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm) {
+    // Same iterations as pcg() in cg.h
+
+    // r = b - Ax
+    state->residual(&state->r);
+
+    // d = M^-1r
+    state->precondition(&state->r, &state->d);
+
+    // sigmaNew = r.d
+    double sigmaNew = state->dot(&state->r, &state->d);
+
+    unsigned int iter = 0;
+    bool trigger = false;
+    while (sigmaNew > tolerance * tolerance && iter < maxNumberOfIterations) {
+        // q = Ad, alpha = sigmaNew/d.q
+        state->mvm(&state->d, &state->q);
+        double alpha = sigmaNew / state->dot(&state->d, &state->q);
+
+        // x = x + alpha*d
+        state->axpy(alpha, &state->d, &state->x, &state->x);
+
+        // if i is divisible by 50...
+        if (trigger || (iter % 50 == 0 && iter > 0)) {
+            // r = b - Ax
+            state->residual(&state->r);
+            trigger = false;
+        } else {
+            // r = r - alpha*q
+            state->axpy(-alpha, &state->q, &state->r, &state->r);
+        }
+
+        // s = M^-1r
+        state->precondition(&state->r, &state->s);
+
+        // sigmaOld = sigmaNew
+        double sigmaOld = sigmaNew;
+
+        // sigmaNew = r.s
+        sigmaNew = state->dot(&state->r, &state->s);
+
+        if (sigmaNew > sigmaOld) {
+            trigger = true;
+        }
+
+        // beta = sigmaNew/sigmaOld
+        double beta = sigmaNew / sigmaOld;
+
+        // d = s + beta*d
+        state->axpy(beta, &state->d, &state->s, &state->d);
+
+        ++iter;
+    }
+
+    *lastNumberOfIterations = iter;
+    *lastResidualNorm = std::sqrt(sigmaNew);
+}
+
+}  // namespace
+
+void uploadCudaPcgMatrix(CudaPcgState* state, const FdmMatrix3& A) {
+    resizeCudaPcgVectors(state, A.size());
+    state->A.upload(A.data());
+}
+
+void solveCudaPcg(
+    CudaPcgState* state,
+    const FdmVector3& b,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    FdmVector3* x,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm) {
+    JET_ASSERT(b.width() * b.height() * b.depth() == state->n);
+
+    state->b.upload(b.data());
+    state->x.setZero();
+
+    runCudaPcg(
+        state,
+        maxNumberOfIterations,
+        tolerance,
+        lastNumberOfIterations,
+        lastResidualNorm);
+
+    // Only the solution goes back to the host
+    state->x.download(x->data());
+}
+
+void setCudaPcgDeviceMatrix(
+    CudaPcgState* state,
+    const Size3& size,
+    const FdmMatrixRow3* deviceA) {
+    resizeCudaPcgVectors(state, size);
+    checkCuda(cudaMemcpy(
+        state->A.data(),
+        deviceA,
+        state->n * sizeof(FdmMatrixRow3),
+        cudaMemcpyDeviceToDevice));
+}
+
+void solveCudaPcgOnDevice(
+    CudaPcgState* state,
+    const double* deviceB,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    double* deviceX,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm) {
+    checkCuda(cudaMemcpy(
+        state->b.data(),
+        deviceB,
+        state->n * sizeof(double),
+        cudaMemcpyDeviceToDevice));
+    state->x.setZero();
+
+    runCudaPcg(
+        state,
+        maxNumberOfIterations,
+        tolerance,
+        lastNumberOfIterations,
+        lastResidualNorm);
+
+    checkCuda(cudaMemcpy(
+        deviceX,
+        state->x.data(),
+        state->n * sizeof(double),
+        cudaMemcpyDeviceToDevice));
+}
+
+}  // namespace internal
+
+}  // namespace jet
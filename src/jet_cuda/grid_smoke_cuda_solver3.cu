@@ -0,0 +1,1107 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <cuda_device_helpers.h>
+#include <cuda_pcg_helpers.h>
+#include <cuda_smoke_helpers.h>
+
+#include <jet/constants.h>
+#include <jet/math_utils.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace jet {
+
+namespace internal {
+
+namespace {
+
+// The sums and the maxima are reduced to this many partial results on the
+// device and finished on the host, both in a fixed order, so the results do
+// not change from run to run.
+const unsigned int kNumberOfReductionBlocks = 128;
+
+// Layout of the data points of a grid. The data point (i, j, k) is at
+// ((i + offset) * spacing) from the grid origin, and is stored at
+// i + size.x * (j + size.y * k).
+struct DeviceLayout {
+    long long sizeX;
+    long long sizeY;
+    long long sizeZ;
+    double offsetX;
+    double offsetY;
+    double offsetZ;
+    double spacingX;
+    double spacingY;
+    double spacingZ;
+};
+
+struct DeviceVelocity {
+    DeviceLayout u;
+    DeviceLayout v;
+    DeviceLayout w;
+};
+
+DeviceLayout makeLayout(
+    const Size3& size,
+    const Vector3D& offset,
+    const Vector3D& spacing) {
+    DeviceLayout layout;
+    layout.sizeX = static_cast<long long>(size.x);
+    layout.sizeY = static_cast<long long>(size.y);
+    layout.sizeZ = static_cast<long long>(size.z);
+    layout.offsetX = offset.x;
+    layout.offsetY = offset.y;
+    layout.offsetZ = offset.z;
+    layout.spacingX = spacing.x;
+    layout.spacingY = spacing.y;
+    layout.spacingZ = spacing.z;
+    return layout;
+}
+
+__device__ size_t numberOfPoints(const DeviceLayout& layout) {
+    return static_cast<size_t>(layout.sizeX * layout.sizeY * layout.sizeZ);
+}
+
+__device__ void pointIndex(
+    const DeviceLayout& layout,
+    size_t idx,
+    long long* i,
+    long long* j,
+    long long* k) {
+    long long n = static_cast<long long>(idx);
+    *i = n % layout.sizeX;
+    *j = (n / layout.sizeX) % layout.sizeY;
+    *k = n / (layout.sizeX * layout.sizeY);
+}
+
+__device__ void pointPosition(
+    const DeviceLayout& layout,
+    long long i,
+    long long j,
+    long long k,
+    double* x,
+    double* y,
+    double* z) {
+    *x = (i + layout.offsetX) * layout.spacingX;
+    *y = (j + layout.offsetY) * layout.spacingY;
+    *z = (k + layout.offsetZ) * layout.spacingZ;
+}
+
+// Same as getBarycentric(x, 0, size, i, f) of the samplers. DBL_EPSILON
+// below is kEpsilonD, which is not available in the device code.
+__device__ void barycentric(
+    double x,
+    long long size,
+    long long* i,
+    double* f) {
+    double s = ::floor(x);
+    *i = static_cast<long long>(s);
+    if (*i < 0) {
+        *i = 0;
+        *f = 0.0;
+    } else if (*i > size - 1) {
+        *i = size - 1;
+        *f = 1.0;
+    } else {
+        *f = x - s;
+    }
+}
+
+// Same as LinearArraySampler3
+__device__ double sampleLinear(
+    const double* data,
+    const DeviceLayout& layout,
+    double x,
+    double y,
+    double z) {
+    long long i, j, k;
+    double fx, fy, fz;
+    barycentric(x / layout.spacingX - layout.offsetX, layout.sizeX, &i, &fx);
+    barycentric(y / layout.spacingY - layout.offsetY, layout.sizeY, &j, &fy);
+    barycentric(z / layout.spacingZ - layout.offsetZ, layout.sizeZ, &k, &fz);
+
+    long long ip = (i + 1 < layout.sizeX) ? i + 1 : i;
+    long long jp = (j + 1 < layout.sizeY) ? j + 1 : j;
+    long long kp = (k + 1 < layout.sizeZ) ? k + 1 : k;
+    long long sx = layout.sizeX;
+    long long sxy = layout.sizeX * layout.sizeY;
+
+    double v000 = data[i + sx * j + sxy * k];
+    double v100 = data[ip + sx * j + sxy * k];
+    double v010 = data[i + sx * jp + sxy * k];
+    double v110 = data[ip + sx * jp + sxy * k];
+    double v001 = data[i + sx * j + sxy * kp];
+    double v101 = data[ip + sx * j + sxy * kp];
+    double v011 = data[i + sx * jp + sxy * kp];
+    double v111 = data[ip + sx * jp + sxy * kp];
+
+    double v00 = v000 * (1.0 - fx) + v100 * fx;
+    double v10 = v010 * (1.0 - fx) + v110 * fx;
+    double v01 = v001 * (1.0 - fx) + v101 * fx;
+    double v11 = v011 * (1.0 - fx) + v111 * fx;
+    double v0 = v00 * (1.0 - fy) + v10 * fy;
+    double v1 = v01 * (1.0 - fy) + v11 * fy;
+    return v0 * (1.0 - fz) + v1 * fz;
+}
+
+__device__ double deviceSign(double x) {
+    return (x >= 0.0) ? 1.0 : -1.0;
+}
+
+// Same as monotonicCatmullRom
+__device__ double monotonicCatmullRom(
+    double f0,
+    double f1,
+    double f2,
+    double f3,
+    double f) {
+    double d1 = (f2 - f0) / 2;
+    double d2 = (f3 - f1) / 2;
+    double D1 = f2 - f1;
+
+    if (::fabs(D1) < DBL_EPSILON) {
+        d1 = d2 = 0;
+    }
+    if (deviceSign(D1) != deviceSign(d1)) {
+        d1 = 0;
+    }
+    if (deviceSign(D1) != deviceSign(d2)) {
+        d2 = 0;
+    }
+
+    double a3 = d1 + d2 - 2 * D1;
+    double a2 = 3 * D1 - 2 * d1 - d2;
+    double a1 = d1;
+    double a0 = f1;
+    return a3 * f * f * f + a2 * f * f + a1 * f + a0;
+}
+
+__device__ double catmullRom(
+    double f0,
+    double f1,
+    double f2,
+    double f3,
+    double t) {
+    double t2 = t * t;
+    double t3 = t2 * t;
+    return f0 * (-t + 2 * t2 - t3) / 2
+        + f1 * (2 - 5 * t2 + 3 * t3) / 2
+        + f2 * (t + 4 * t2 - 3 * t3) / 2
+        + f3 * (t3 - t2) / 2;
+}
+
+// Same as CubicArraySampler3
+__device__ double sampleCubic(
+    const double* data,
+    const DeviceLayout& layout,
+    bool isMonotonic,
+    double x,
+    double y,
+    double z) {
+    long long i, j, k;
+    double fx, fy, fz;
+    barycentric(x / layout.spacingX - layout.offsetX, layout.sizeX, &i, &fx);
+    barycentric(y / layout.spacingY - layout.offsetY, layout.sizeY, &j, &fy);
+    barycentric(z / layout.spacingZ - layout.offsetZ, layout.sizeZ, &k, &fz);
+
+    long long is[4];
+    long long js[4];
+    long long ks[4];
+    for (int n = 0; n < 4; ++n) {
+        is[n] = ::min(::max(i + n - 1, 0LL), layout.sizeX - 1);
+        js[n] = ::min(::max(j + n - 1, 0LL), layout.sizeY - 1);
+        ks[n] = ::min(::max(k + n - 1, 0LL), layout.sizeZ - 1);
+    }
+
+    double kValues[4];
+    for (int kk = 0; kk < 4; ++kk) {
+        double jValues[4];
+        for (int jj = 0; jj < 4; ++jj) {
+            const double* row = data
+                + (js[jj] + layout.sizeY * ks[kk]) * layout.sizeX;
+            jValues[jj] = isMonotonic
+                ? monotonicCatmullRom(
+                    row[is[0]], row[is[1]], row[is[2]], row[is[3]], fx)
+                : catmullRom(
+                    row[is[0]], row[is[1]], row[is[2]], row[is[3]], fx);
+        }
+        kValues[kk] = isMonotonic
+            ? monotonicCatmullRom(
+                jValues[0], jValues[1], jValues[2], jValues[3], fy)
+            : catmullRom(jValues[0], jValues[1], jValues[2], jValues[3], fy);
+    }
+    return isMonotonic
+        ? monotonicCatmullRom(
+            kValues[0], kValues[1], kValues[2], kValues[3], fz)
+        : catmullRom(kValues[0], kValues[1], kValues[2], kValues[3], fz);
+}
+
+// Samples the advected field with the interpolation of the advection solver
+__device__ double sampleAdvected(
+    const double* data,
+    const DeviceLayout& layout,
+    CudaSmokeInterpolation interpolation,
+    double x,
+    double y,
+    double z) {
+    switch (interpolation) {
+        case CudaSmokeInterpolation::Cubic:
+            return sampleCubic(data, layout, false, x, y, z);
+        case CudaSmokeInterpolation::MonotonicCubic:
+            return sampleCubic(data, layout, true, x, y, z);
+        default:
+            return sampleLinear(data, layout, x, y, z);
+    }
+}
+
+__device__ void sampleVelocity(
+    const DeviceVelocity& layout,
+    const double* u,
+    const double* v,
+    const double* w,
+    double x,
+    double y,
+    double z,
+    double* vx,
+    double* vy,
+    double* vz) {
+    *vx = sampleLinear(u, layout.u, x, y, z);
+    *vy = sampleLinear(v, layout.v, x, y, z);
+    *vz = sampleLinear(w, layout.w, x, y, z);
+}
+
+// Same mid-point rule with adaptive sub-steps as backTrace in
+// semi_lagrangian_helpers.h, without a boundary to stop at. The flow is
+// always sampled linearly.
+__device__ void backTrace(
+    const DeviceVelocity& layout,
+    const double* u,
+    const double* v,
+    const double* w,
+    double dt,
+    double h,
+    double* x,
+    double* y,
+    double* z) {
+    double remainingT = dt;
+    while (remainingT > DBL_EPSILON) {
+        double vx, vy, vz;
+        sampleVelocity(layout, u, v, w, *x, *y, *z, &vx, &vy, &vz);
+        double speed = ::sqrt(vx * vx + vy * vy + vz * vz);
+        double numSubSteps = ::fmax(::ceil(speed * remainingT / h), 1.0);
+        double subDt = remainingT / numSubSteps;
+
+        double mx = *x - 0.5 * subDt * vx;
+        double my = *y - 0.5 * subDt * vy;
+        double mz = *z - 0.5 * subDt * vz;
+        sampleVelocity(layout, u, v, w, mx, my, mz, &vx, &vy, &vz);
+        *x -= subDt * vx;
+        *y -= subDt * vy;
+        *z -= subDt * vz;
+
+        remainingT -= subDt;
+    }
+}
+
+// Advects one component of the velocity, which is also the flow
+__global__ void advectVelocityKernel(
+    DeviceVelocity velocity,
+    DeviceLayout layout,
+    const double* u0,
+    const double* v0,
+    const double* w0,
+    const double* input,
+    CudaSmokeInterpolation interpolation,
+    double dt,
+    double h,
+    double* output) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(layout)) {
+        long long i, j, k;
+        double x, y, z;
+        pointIndex(layout, idx, &i, &j, &k);
+        pointPosition(layout, i, j, k, &x, &y, &z);
+        backTrace(velocity, u0, v0, w0, dt, h, &x, &y, &z);
+        output[idx]
+            = sampleAdvected(input, layout, interpolation, x, y, z);
+    }
+}
+
+// Traces each cell center once and samples all the scalar channels there
+__global__ void advectScalarsKernel(
+    DeviceVelocity velocity,
+    DeviceLayout layout,
+    const double* u0,
+    const double* v0,
+    const double* w0,
+    const double* const* inputs,
+    double* const* outputs,
+    size_t numberOfChannels,
+    CudaSmokeInterpolation interpolation,
+    double dt,
+    double h) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(layout)) {
+        long long i, j, k;
+        double x, y, z;
+        pointIndex(layout, idx, &i, &j, &k);
+        pointPosition(layout, i, j, k, &x, &y, &z);
+        backTrace(velocity, u0, v0, w0, dt, h, &x, &y, &z);
+        for (size_t c = 0; c < numberOfChannels; ++c) {
+            outputs[c][idx]
+                = sampleAdvected(inputs[c], layout, interpolation, x, y, z);
+        }
+    }
+}
+
+// Combines the buoyancy force per cell, like GridSmokeSolver3
+__global__ void buoyancyCellKernel(
+    const double* density,
+    const double* temperature,
+    double densityFactor,
+    double temperatureFactor,
+    size_t n,
+    double* buoyancy) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < n) {
+        buoyancy[idx] = densityFactor * density[idx]
+            + temperatureFactor * temperature[idx];
+    }
+}
+
+__global__ void buoyancyFaceKernel(
+    DeviceLayout faceLayout,
+    DeviceLayout cellLayout,
+    const double* buoyancy,
+    double ambientForce,
+    double scale,
+    double* velocity) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(faceLayout)) {
+        long long i, j, k;
+        double x, y, z;
+        pointIndex(faceLayout, idx, &i, &j, &k);
+        pointPosition(faceLayout, i, j, k, &x, &y, &z);
+        double force = sampleLinear(buoyancy, cellLayout, x, y, z)
+            - ambientForce;
+        velocity[idx] += scale * force;
+    }
+}
+
+// Zeros the normal velocity on the closed sides of the domain. The faces of
+// a side are the data points of the first or the last slice along the axis.
+__global__ void closedBoundaryKernel(
+    DeviceLayout layout,
+    int axis,
+    bool isLowerClosed,
+    bool isUpperClosed,
+    double* velocity) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(layout)) {
+        long long ijk[3];
+        pointIndex(layout, idx, &ijk[0], &ijk[1], &ijk[2]);
+        long long size = (axis == 0) ? layout.sizeX
+            : (axis == 1) ? layout.sizeY : layout.sizeZ;
+        if ((isLowerClosed && ijk[axis] == 0)
+            || (isUpperClosed && ijk[axis] == size - 1)) {
+            velocity[idx] = 0.0;
+        }
+    }
+}
+
+// Same system as GridFractionalSinglePhasePressureSolver3 builds for the
+// cells without a collider: the neighbors outside of the grid are left out.
+__global__ void pressureMatrixKernel(
+    DeviceLayout layout,
+    double invHSqrX,
+    double invHSqrY,
+    double invHSqrZ,
+    FdmMatrixRow3* matrix) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(layout)) {
+        long long i, j, k;
+        pointIndex(layout, idx, &i, &j, &k);
+
+        FdmMatrixRow3 row;
+        row.center = 0.0;
+        row.right = 0.0;
+        row.up = 0.0;
+        row.front = 0.0;
+        if (i + 1 < layout.sizeX) {
+            row.center += invHSqrX;
+            row.right -= invHSqrX;
+        }
+        if (i > 0) {
+            row.center += invHSqrX;
+        }
+        if (j + 1 < layout.sizeY) {
+            row.center += invHSqrY;
+            row.up -= invHSqrY;
+        }
+        if (j > 0) {
+            row.center += invHSqrY;
+        }
+        if (k + 1 < layout.sizeZ) {
+            row.center += invHSqrZ;
+            row.front -= invHSqrZ;
+        }
+        if (k > 0) {
+            row.center += invHSqrZ;
+        }
+        matrix[idx] = row;
+    }
+}
+
+// Same system as GridBackwardEulerDiffusionSolver3 builds for the cells
+// without a collider, where c is the coefficient times the time interval
+// over the grid spacing squared.
+__global__ void diffusionMatrixKernel(
+    DeviceLayout layout,
+    double cX,
+    double cY,
+    double cZ,
+    FdmMatrixRow3* matrix) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(layout)) {
+        long long i, j, k;
+        pointIndex(layout, idx, &i, &j, &k);
+
+        FdmMatrixRow3 row;
+        row.center = 1.0;
+        row.right = 0.0;
+        row.up = 0.0;
+        row.front = 0.0;
+        if (i + 1 < layout.sizeX) {
+            row.center += cX;
+            row.right -= cX;
+        }
+        if (i > 0) {
+            row.center += cX;
+        }
+        if (j + 1 < layout.sizeY) {
+            row.center += cY;
+            row.up -= cY;
+        }
+        if (j > 0) {
+            row.center += cY;
+        }
+        if (k + 1 < layout.sizeZ) {
+            row.center += cZ;
+            row.front -= cZ;
+        }
+        if (k > 0) {
+            row.center += cZ;
+        }
+        matrix[idx] = row;
+    }
+}
+
+// Divergence of the velocity per cell, like
+// GridFractionalSinglePhasePressureSolver3::buildSystem with unit weights
+__global__ void divergenceKernel(
+    DeviceLayout layout,
+    const double* u,
+    const double* v,
+    const double* w,
+    double invHX,
+    double invHY,
+    double invHZ,
+    double* divergence) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(layout)) {
+        long long i, j, k;
+        pointIndex(layout, idx, &i, &j, &k);
+        long long nx = layout.sizeX;
+        long long ny = layout.sizeY;
+
+        size_t uIdx = i + (nx + 1) * (j + ny * k);
+        size_t vIdx = i + nx * (j + (ny + 1) * k);
+        size_t wIdx = i + nx * (j + ny * k);
+        size_t vStride = nx;
+        size_t wStride = nx * ny;
+
+        double b = 0.0;
+        b += u[uIdx + 1] * invHX;
+        b -= u[uIdx] * invHX;
+        b += v[vIdx + vStride] * invHY;
+        b -= v[vIdx] * invHY;
+        b += w[wIdx + wStride] * invHZ;
+        b -= w[wIdx] * invHZ;
+        divergence[idx] = b;
+    }
+}
+
+// Adds the pressure gradient to the inner faces along the axis, like
+// GridFractionalSinglePhasePressureSolver3::applyPressureGradient
+__global__ void pressureGradientKernel(
+    DeviceLayout faceLayout,
+    DeviceLayout cellLayout,
+    int axis,
+    const double* pressure,
+    double invH,
+    double* velocity) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < numberOfPoints(faceLayout)) {
+        long long ijk[3];
+        pointIndex(faceLayout, idx, &ijk[0], &ijk[1], &ijk[2]);
+        long long size = (axis == 0) ? cellLayout.sizeX
+            : (axis == 1) ? cellLayout.sizeY : cellLayout.sizeZ;
+        if (ijk[axis] == 0 || ijk[axis] == size) {
+            return;
+        }
+
+        long long sx = cellLayout.sizeX;
+        long long sxy = cellLayout.sizeX * cellLayout.sizeY;
+        long long upper = ijk[0] + sx * ijk[1] + sxy * ijk[2];
+        long long stride = (axis == 0) ? 1 : (axis == 1) ? sx : sxy;
+        velocity[idx] += invH * (pressure[upper] - pressure[upper - stride]);
+    }
+}
+
+__global__ void scaleKernel(double factor, size_t n, double* data) {
+    size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (idx < n) {
+        data[idx] *= factor;
+    }
+}
+
+// partialSums[blockIdx.x] = sum of the data over the indices of the block
+__global__ void sumKernel(
+    const double* data,
+    size_t n,
+    double* partialSums) {
+    __shared__ double sums[kCudaBlockSize];
+
+    size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+    double sum = 0.0;
+    for (size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x)
+            + threadIdx.x;
+        idx < n;
+        idx += stride) {
+        sum += data[idx];
+    }
+    sums[threadIdx.x] = sum;
+    __syncthreads();
+
+    for (unsigned int half = blockDim.x / 2; half > 0; half /= 2) {
+        if (threadIdx.x < half) {
+            sums[threadIdx.x] += sums[threadIdx.x + half];
+        }
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0) {
+        partialSums[blockIdx.x] = sums[0];
+    }
+}
+
+// partialMaxima[blockIdx.x] = max of the absolute data over the indices of
+// the block
+__global__ void maxAbsKernel(
+    const double* data,
+    size_t n,
+    double* partialMaxima) {
+    __shared__ double maxima[kCudaBlockSize];
+
+    size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+    double maximum = 0.0;
+    for (size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x)
+            + threadIdx.x;
+        idx < n;
+        idx += stride) {
+        maximum = ::fmax(maximum, ::fabs(data[idx]));
+    }
+    maxima[threadIdx.x] = maximum;
+    __syncthreads();
+
+    for (unsigned int half = blockDim.x / 2; half > 0; half /= 2) {
+        if (threadIdx.x < half) {
+            maxima[threadIdx.x]
+                = ::fmax(maxima[threadIdx.x], maxima[threadIdx.x + half]);
+        }
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0) {
+        partialMaxima[blockIdx.x] = maxima[0];
+    }
+}
+
+void copyDeviceArray(
+    const DeviceArray<double>& src,
+    DeviceArray<double>* dst) {
+    checkCuda(cudaMemcpy(
+        dst->data(),
+        src.data(),
+        src.size() * sizeof(double),
+        cudaMemcpyDeviceToDevice));
+}
+
+}  // namespace
+
+class CudaSmokeState final {
+ public:
+    Size3 resolution;
+    Vector3D gridSpacing;
+    DeviceVelocity velocityLayout;
+    DeviceLayout cellLayout;
+
+    DeviceArray<double> u;
+    DeviceArray<double> v;
+    DeviceArray<double> w;
+    DeviceArray<double> u0;
+    DeviceArray<double> v0;
+    DeviceArray<double> w0;
+    std::vector<std::unique_ptr<DeviceArray<double>>> scalars;
+    std::vector<std::unique_ptr<DeviceArray<double>>> scalarBuffers;
+    DeviceArray<const double*> scalarInputs;
+    DeviceArray<double*> scalarOutputs;
+
+    // Cell-centered buffers of the buoyancy, the pressure, and the diffusion
+    DeviceArray<double> buoyancy;
+    DeviceArray<double> rhs;
+    DeviceArray<double> pressure;
+    DeviceArray<FdmMatrixRow3> pressureMatrix;
+    DeviceArray<FdmMatrixRow3> diffusionMatrix;
+    std::unique_ptr<CudaPcgState, CudaPcgStateDeleter> pcg;
+    bool isPressureMatrixValid = false;
+
+    DeviceArray<double> partialResults;
+    std::vector<double> hostPartialResults;
+
+    double maxVelocity = 0.0;
+    unsigned int lastNumberOfIterations = 0;
+    double lastResidual = 0.0;
+
+    size_t numberOfCells() const {
+        return resolution.x * resolution.y * resolution.z;
+    }
+
+    double sum(const DeviceArray<double>& data) {
+        sumKernel<<<kNumberOfReductionBlocks, kCudaBlockSize>>>(
+            data.data(), data.size(), partialResults.data());
+        checkCuda(cudaGetLastError());
+
+        partialResults.download(hostPartialResults.data());
+        double result = 0.0;
+        for (double partialResult : hostPartialResults) {
+            result += partialResult;
+        }
+        return result;
+    }
+
+    double maxAbs(const DeviceArray<double>& data) {
+        maxAbsKernel<<<kNumberOfReductionBlocks, kCudaBlockSize>>>(
+            data.data(), data.size(), partialResults.data());
+        checkCuda(cudaGetLastError());
+
+        partialResults.download(hostPartialResults.data());
+        double result = 0.0;
+        for (double partialResult : hostPartialResults) {
+            result = std::max(result, partialResult);
+        }
+        return result;
+    }
+
+    void updateMaxVelocity() {
+        maxVelocity = std::max(maxAbs(u), std::max(maxAbs(v), maxAbs(w)));
+    }
+
+    void updateScalarPointers() {
+        std::vector<const double*> inputs;
+        std::vector<double*> outputs;
+        for (size_t c = 0; c < scalars.size(); ++c) {
+            inputs.push_back(scalarBuffers[c]->data());
+            outputs.push_back(scalars[c]->data());
+        }
+        scalarInputs.resize(inputs.size());
+        scalarOutputs.resize(outputs.size());
+        scalarInputs.upload(inputs.data());
+        scalarOutputs.upload(outputs.data());
+    }
+};
+
+namespace {
+
+DeviceArray<double>* velocityComponent(CudaSmokeState* state, int axis) {
+    return (axis == 0) ? &state->u : (axis == 1) ? &state->v : &state->w;
+}
+
+const DeviceLayout& faceLayout(const CudaSmokeState* state, int axis) {
+    return (axis == 0) ? state->velocityLayout.u
+        : (axis == 1) ? state->velocityLayout.v : state->velocityLayout.w;
+}
+
+void applyClosedBoundary(CudaSmokeState* state, int flag) {
+    const int lowerFlags[3] = {
+        kDirectionLeft, kDirectionDown, kDirectionBack };
+    const int upperFlags[3] = {
+        kDirectionRight, kDirectionUp, kDirectionFront };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        bool isLowerClosed = (flag & lowerFlags[axis]) != 0;
+        bool isUpperClosed = (flag & upperFlags[axis]) != 0;
+        if (!isLowerClosed && !isUpperClosed) {
+            continue;
+        }
+
+        DeviceArray<double>* data = velocityComponent(state, axis);
+        closedBoundaryKernel<<<
+            cudaNumberOfBlocks(data->size()), kCudaBlockSize>>>(
+            faceLayout(state, axis),
+            axis,
+            isLowerClosed,
+            isUpperClosed,
+            data->data());
+        checkCuda(cudaGetLastError());
+    }
+}
+
+void computeAdvection(
+    CudaSmokeState* state,
+    const CudaSmokeParameters& params,
+    double dt) {
+    const Vector3D& h = state->gridSpacing;
+    double minH = min3(h.x, h.y, h.z);
+
+    copyDeviceArray(state->u, &state->u0);
+    copyDeviceArray(state->v, &state->v0);
+    copyDeviceArray(state->w, &state->w0);
+
+    const DeviceArray<double>* inputs[3] = {
+        &state->u0, &state->v0, &state->w0 };
+    for (int axis = 0; axis < 3; ++axis) {
+        DeviceArray<double>* output = velocityComponent(state, axis);
+        advectVelocityKernel<<<
+            cudaNumberOfBlocks(output->size()), kCudaBlockSize>>>(
+            state->velocityLayout,
+            faceLayout(state, axis),
+            state->u0.data(),
+            state->v0.data(),
+            state->w0.data(),
+            inputs[axis]->data(),
+            params.interpolation,
+            dt,
+            minH,
+            output->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    // The channels are advected from the back buffers into the front ones,
+    // with the velocity before the advection
+    std::swap(state->scalars, state->scalarBuffers);
+    state->updateScalarPointers();
+    advectScalarsKernel<<<
+        cudaNumberOfBlocks(state->numberOfCells()), kCudaBlockSize>>>(
+        state->velocityLayout,
+        state->cellLayout,
+        state->u0.data(),
+        state->v0.data(),
+        state->w0.data(),
+        state->scalarInputs.data(),
+        state->scalarOutputs.data(),
+        state->scalars.size(),
+        params.interpolation,
+        dt,
+        minH);
+    checkCuda(cudaGetLastError());
+
+    applyClosedBoundary(state, params.closedDomainBoundaryFlag);
+}
+
+void computeBuoyancyForce(
+    CudaSmokeState* state,
+    const CudaSmokeParameters& params,
+    double dt) {
+    if (std::abs(params.buoyancySmokeDensityFactor) <= kEpsilonD
+        && std::abs(params.buoyancyTemperatureFactor) <= kEpsilonD) {
+        return;
+    }
+
+    size_t n = state->numberOfCells();
+    buoyancyCellKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+        state->scalars[0]->data(),
+        state->scalars[1]->data(),
+        params.buoyancySmokeDensityFactor,
+        params.buoyancyTemperatureFactor,
+        n,
+        state->buoyancy.data());
+    checkCuda(cudaGetLastError());
+
+    // The ambient temperature is the mean over the grid
+    double tAmb = state->sum(*state->scalars[1]) / static_cast<double>(n);
+    double fAmb = params.buoyancyTemperatureFactor * tAmb;
+
+    const double up[3] = { params.up.x, params.up.y, params.up.z };
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::abs(up[axis]) <= kEpsilonD) {
+            continue;
+        }
+
+        DeviceArray<double>* data = velocityComponent(state, axis);
+        buoyancyFaceKernel<<<
+            cudaNumberOfBlocks(data->size()), kCudaBlockSize>>>(
+            faceLayout(state, axis),
+            state->cellLayout,
+            state->buoyancy.data(),
+            fAmb,
+            dt * up[axis],
+            data->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    applyClosedBoundary(state, params.closedDomainBoundaryFlag);
+}
+
+void computePressure(
+    CudaSmokeState* state,
+    const CudaSmokeParameters& params) {
+    if (!params.isSolvingPressure) {
+        return;
+    }
+
+    size_t n = state->numberOfCells();
+    Vector3D invH = 1.0 / state->gridSpacing;
+    Vector3D invHSqr = invH * invH;
+
+    // The matrix only depends on the grid
+    if (!state->isPressureMatrixValid) {
+        pressureMatrixKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+            state->cellLayout,
+            invHSqr.x,
+            invHSqr.y,
+            invHSqr.z,
+            state->pressureMatrix.data());
+        checkCuda(cudaGetLastError());
+        state->isPressureMatrixValid = true;
+    }
+
+    divergenceKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+        state->cellLayout,
+        state->u.data(),
+        state->v.data(),
+        state->w.data(),
+        invH.x,
+        invH.y,
+        invH.z,
+        state->rhs.data());
+    checkCuda(cudaGetLastError());
+
+    setCudaPcgDeviceMatrix(
+        state->pcg.get(), state->resolution, state->pressureMatrix.data());
+    solveCudaPcgOnDevice(
+        state->pcg.get(),
+        state->rhs.data(),
+        params.maxNumberOfIterations,
+        params.pressureTolerance,
+        state->pressure.data(),
+        &state->lastNumberOfIterations,
+        &state->lastResidual);
+
+    const double invHs[3] = { invH.x, invH.y, invH.z };
+    for (int axis = 0; axis < 3; ++axis) {
+        DeviceArray<double>* data = velocityComponent(state, axis);
+        pressureGradientKernel<<<
+            cudaNumberOfBlocks(data->size()), kCudaBlockSize>>>(
+            faceLayout(state, axis),
+            state->cellLayout,
+            axis,
+            state->pressure.data(),
+            invHs[axis],
+            data->data());
+        checkCuda(cudaGetLastError());
+    }
+
+    applyClosedBoundary(state, params.closedDomainBoundaryFlag);
+}
+
+void computeDiffusion(
+    CudaSmokeState* state,
+    const CudaSmokeParameters& params,
+    double dt) {
+    const double coefficients[2] = {
+        params.smokeDiffusionCoefficient,
+        params.temperatureDiffusionCoefficient };
+
+    size_t n = state->numberOfCells();
+    const Vector3D& h = state->gridSpacing;
+    for (size_t c = 0; c < 2; ++c) {
+        if (coefficients[c] <= kEpsilonD) {
+            continue;
+        }
+
+        Vector3D coeff = dt * coefficients[c] / (h * h);
+        diffusionMatrixKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+            state->cellLayout,
+            coeff.x,
+            coeff.y,
+            coeff.z,
+            state->diffusionMatrix.data());
+        checkCuda(cudaGetLastError());
+
+        unsigned int iterations = 0;
+        double residual = 0.0;
+        copyDeviceArray(*state->scalars[c], &state->rhs);
+        setCudaPcgDeviceMatrix(
+            state->pcg.get(),
+            state->resolution,
+            state->diffusionMatrix.data());
+        solveCudaPcgOnDevice(
+            state->pcg.get(),
+            state->rhs.data(),
+            params.maxNumberOfIterations,
+            params.diffusionTolerance,
+            state->scalars[c]->data(),
+            &iterations,
+            &residual);
+    }
+}
+
+void computeDecay(CudaSmokeState* state, const CudaSmokeParameters& params) {
+    size_t n = state->numberOfCells();
+    scaleKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+        1.0 - params.smokeDecayFactor, n, state->scalars[0]->data());
+    checkCuda(cudaGetLastError());
+    scaleKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+        1.0 - params.temperatureDecayFactor, n, state->scalars[1]->data());
+    checkCuda(cudaGetLastError());
+}
+
+}  // namespace
+
+void CudaSmokeStateDeleter::operator()(CudaSmokeState* state) const {
+    delete state;
+}
+
+CudaSmokeState* createCudaSmokeState() {
+    CudaSmokeState* state = new CudaSmokeState();
+    state->pcg.reset(createCudaPcgState());
+    state->partialResults.resize(kNumberOfReductionBlocks);
+    state->hostPartialResults.resize(kNumberOfReductionBlocks);
+    return state;
+}
+
+void uploadCudaSmokeGrids(
+    CudaSmokeState* state,
+    const FaceCenteredGrid3& velocity,
+    const std::vector<const ScalarGrid3*>& scalars) {
+    JET_ASSERT(scalars.size() >= 2);
+
+    Size3 res = velocity.resolution();
+    Vector3D h = velocity.gridSpacing();
+    if (res != state->resolution || h != state->gridSpacing) {
+        state->isPressureMatrixValid = false;
+    }
+    state->resolution = res;
+    state->gridSpacing = h;
+
+    state->velocityLayout.u = makeLayout(
+        velocity.uSize(), Vector3D(0.0, 0.5, 0.5), h);
+    state->velocityLayout.v = makeLayout(
+        velocity.vSize(), Vector3D(0.5, 0.0, 0.5), h);
+    state->velocityLayout.w = makeLayout(
+        velocity.wSize(), Vector3D(0.5, 0.5, 0.0), h);
+    state->cellLayout = makeLayout(res, Vector3D(0.5, 0.5, 0.5), h);
+
+    Size3 uSize = velocity.uSize();
+    Size3 vSize = velocity.vSize();
+    Size3 wSize = velocity.wSize();
+    state->u.resize(uSize.x * uSize.y * uSize.z);
+    state->v.resize(vSize.x * vSize.y * vSize.z);
+    state->w.resize(wSize.x * wSize.y * wSize.z);
+    state->u0.resize(state->u.size());
+    state->v0.resize(state->v.size());
+    state->w0.resize(state->w.size());
+    state->u.upload(velocity.uConstAccessor().data());
+    state->v.upload(velocity.vConstAccessor().data());
+    state->w.upload(velocity.wConstAccessor().data());
+
+    size_t n = state->numberOfCells();
+    state->scalars.resize(scalars.size());
+    state->scalarBuffers.resize(scalars.size());
+    for (size_t c = 0; c < scalars.size(); ++c) {
+        if (state->scalars[c] == nullptr) {
+            state->scalars[c].reset(new DeviceArray<double>());
+            state->scalarBuffers[c].reset(new DeviceArray<double>());
+        }
+        state->scalars[c]->resize(n);
+        state->scalarBuffers[c]->resize(n);
+        state->scalars[c]->upload(scalars[c]->constDataAccessor().data());
+    }
+
+    state->buoyancy.resize(n);
+    state->rhs.resize(n);
+    state->pressure.resize(n);
+    state->pressureMatrix.resize(n);
+    state->diffusionMatrix.resize(n);
+
+    state->updateMaxVelocity();
+}
+
+void downloadCudaSmokeGrids(
+    const CudaSmokeState* state,
+    FaceCenteredGrid3* velocity,
+    const std::vector<ScalarGrid3*>& scalars) {
+    JET_ASSERT(scalars.size() == state->scalars.size());
+
+    state->u.download(velocity->uAccessor().data());
+    state->v.download(velocity->vAccessor().data());
+    state->w.download(velocity->wAccessor().data());
+    for (size_t c = 0; c < scalars.size(); ++c) {
+        state->scalars[c]->download(scalars[c]->dataAccessor().data());
+    }
+}
+
+void downloadCudaSmokeScalarGrid(
+    const CudaSmokeState* state,
+    size_t index,
+    ScalarGrid3* scalar) {
+    state->scalars[index]->download(scalar->dataAccessor().data());
+}
+
+void advanceCudaSmoke(
+    CudaSmokeState* state,
+    const CudaSmokeParameters& params,
+    double timeIntervalInSeconds) {
+    // Same order as GridSmokeSolver3
+    computeAdvection(state, params, timeIntervalInSeconds);
+    computeBuoyancyForce(state, params, timeIntervalInSeconds);
+    computePressure(state, params);
+    computeDiffusion(state, params, timeIntervalInSeconds);
+    computeDecay(state, params);
+
+    state->updateMaxVelocity();
+}
+
+double cudaSmokeMaxVelocity(const CudaSmokeState* state) {
+    return state->maxVelocity;
+}
+
+unsigned int cudaSmokeLastNumberOfIterations(const CudaSmokeState* state) {
+    return state->lastNumberOfIterations;
+}
+
+double cudaSmokeLastResidual(const CudaSmokeState* state) {
+    return state->lastResidual;
+}
+
+size_t cudaSmokeMemoryInBytes(const CudaSmokeState* state) {
+    size_t n = state->numberOfCells();
+    size_t faces = state->u.size() + state->v.size() + state->w.size();
+
+    // The velocity and its back buffer, two buffers per channel, the
+    // buoyancy, the right-hand side, the pressure, the two matrices, and the
+    // seven vectors of the linear solver
+    return 2 * faces * sizeof(double)
+        + (2 * state->scalars.size() + 3 + 7) * n * sizeof(double)
+        + 2 * n * sizeof(FdmMatrixRow3);
+}
+
+}  // namespace internal
+
+}  // namespace jet
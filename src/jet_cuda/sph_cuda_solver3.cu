@@ -0,0 +1,648 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <cuda_device_helpers.h>
+#include <cuda_sph_helpers.h>
+
+#include <cmath>
+#include <vector>
+
+namespace jet {
+
+namespace internal {
+
+namespace {
+
+// Number of threads of the single-block prefix sum over the buckets
+const unsigned int kScanBlockSize = 1024;
+
+struct DeviceVector3 {
+    double x;
+    double y;
+    double z;
+};
+
+static_assert(
+    sizeof(DeviceVector3) == sizeof(Vector3D),
+    "Vector3D must be three packed doubles.");
+
+struct DeviceHashGrid {
+    double gridSpacing;
+    long long resolutionX;
+    long long resolutionY;
+    long long resolutionZ;
+    const unsigned int* startIndexTable;
+    const unsigned int* endIndexTable;
+    const unsigned int* sortedIndices;
+};
+
+__device__ long long bucketIndex(double position, double gridSpacing) {
+    return static_cast<long long>(::floor(position / gridSpacing));
+}
+
+__device__ unsigned int hashKey(
+    const DeviceHashGrid& grid,
+    long long x,
+    long long y,
+    long long z) {
+    x %= grid.resolutionX;
+    y %= grid.resolutionY;
+    z %= grid.resolutionZ;
+    if (x < 0) {
+        x += grid.resolutionX;
+    }
+    if (y < 0) {
+        y += grid.resolutionY;
+    }
+    if (z < 0) {
+        z += grid.resolutionZ;
+    }
+    return static_cast<unsigned int>(
+        (z * grid.resolutionY + y) * grid.resolutionX + x);
+}
+
+// Same eight buckets as PointParallelHashGridSearcher3::getNearbyKeys, but
+// the buckets which wrap to the same key are visited once.
+__device__ int nearbyKeys(
+    const DeviceHashGrid& grid,
+    const DeviceVector3& position,
+    unsigned int* keys) {
+    long long x = bucketIndex(position.x, grid.gridSpacing);
+    long long y = bucketIndex(position.y, grid.gridSpacing);
+    long long z = bucketIndex(position.z, grid.gridSpacing);
+    long long dx = ((x + 0.5) * grid.gridSpacing <= position.x) ? 1 : -1;
+    long long dy = ((y + 0.5) * grid.gridSpacing <= position.y) ? 1 : -1;
+    long long dz = ((z + 0.5) * grid.gridSpacing <= position.z) ? 1 : -1;
+
+    int numberOfKeys = 0;
+    for (int i = 0; i < 8; ++i) {
+        unsigned int key = hashKey(
+            grid,
+            (i & 4) ? x + dx : x,
+            (i & 2) ? y + dy : y,
+            (i & 1) ? z + dz : z);
+
+        bool isDuplicate = false;
+        for (int k = 0; k < numberOfKeys; ++k) {
+            isDuplicate = isDuplicate || keys[k] == key;
+        }
+        if (!isDuplicate) {
+            keys[numberOfKeys++] = key;
+        }
+    }
+    return numberOfKeys;
+}
+
+__device__ double distanceSquared(
+    const DeviceVector3& a,
+    const DeviceVector3& b) {
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double dz = b.z - a.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+__global__ void hashKeyKernel(
+    DeviceHashGrid grid,
+    const DeviceVector3* positions,
+    size_t n,
+    unsigned int* keys,
+    unsigned int* counts) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i < n) {
+        unsigned int key = hashKey(
+            grid,
+            bucketIndex(positions[i].x, grid.gridSpacing),
+            bucketIndex(positions[i].y, grid.gridSpacing),
+            bucketIndex(positions[i].z, grid.gridSpacing));
+        keys[i] = key;
+        atomicAdd(counts + key, 1u);
+    }
+}
+
+// Turns the bucket counts into the start and end index tables. Runs as a
+// single block where each thread scans a contiguous range of buckets.
+__global__ void scanKernel(
+    const unsigned int* counts,
+    size_t numberOfBuckets,
+    unsigned int* startIndexTable,
+    unsigned int* endIndexTable) {
+    __shared__ unsigned int sums[kScanBlockSize];
+
+    size_t rangeSize = (numberOfBuckets + blockDim.x - 1) / blockDim.x;
+    size_t begin = threadIdx.x * rangeSize;
+    size_t end = begin + rangeSize;
+    if (end > numberOfBuckets) {
+        end = numberOfBuckets;
+    }
+
+    unsigned int sum = 0;
+    for (size_t b = begin; b < end; ++b) {
+        sum += counts[b];
+    }
+    sums[threadIdx.x] = sum;
+    __syncthreads();
+
+    for (unsigned int offset = 1; offset < blockDim.x; offset *= 2) {
+        unsigned int value
+            = (threadIdx.x >= offset) ? sums[threadIdx.x - offset] : 0;
+        __syncthreads();
+        sums[threadIdx.x] += value;
+        __syncthreads();
+    }
+
+    unsigned int start = sums[threadIdx.x] - sum;
+    for (size_t b = begin; b < end; ++b) {
+        startIndexTable[b] = start;
+        start += counts[b];
+        endIndexTable[b] = start;
+    }
+}
+
+__global__ void scatterKernel(
+    const unsigned int* keys,
+    size_t n,
+    unsigned int* cursors,
+    unsigned int* sortedIndices) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i < n) {
+        unsigned int slot = atomicAdd(cursors + keys[i], 1u);
+        sortedIndices[slot] = static_cast<unsigned int>(i);
+    }
+}
+
+// The atomics scatter the points of a bucket in any order, so each bucket is
+// sorted by the point index to make the summations deterministic.
+__global__ void sortBucketsKernel(
+    const unsigned int* startIndexTable,
+    const unsigned int* endIndexTable,
+    size_t numberOfBuckets,
+    unsigned int* sortedIndices) {
+    size_t b = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (b < numberOfBuckets) {
+        unsigned int begin = startIndexTable[b];
+        unsigned int end = endIndexTable[b];
+        for (unsigned int s = begin + 1; s < end; ++s) {
+            unsigned int index = sortedIndices[s];
+            unsigned int t = s;
+            while (t > begin && sortedIndices[t - 1] > index) {
+                sortedIndices[t] = sortedIndices[t - 1];
+                --t;
+            }
+            sortedIndices[t] = index;
+        }
+    }
+}
+
+// The loops below visit the neighbors within the kernel radius, including the
+// point itself, in the order of the buckets and then the point indices.
+
+__global__ void densityKernel(
+    DeviceHashGrid grid,
+    const DeviceVector3* positions,
+    size_t n,
+    CudaSphParameters params,
+    double kernelFactor,
+    double* densities,
+    unsigned long long* numberOfNeighbors) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i >= n) {
+        return;
+    }
+
+    const double h2 = params.kernelRadius * params.kernelRadius;
+
+    unsigned int keys[8];
+    int numberOfKeys = nearbyKeys(grid, positions[i], keys);
+
+    double sum = 0.0;
+    unsigned long long count = 0;
+    for (int c = 0; c < numberOfKeys; ++c) {
+        unsigned int end = grid.endIndexTable[keys[c]];
+        for (unsigned int s = grid.startIndexTable[keys[c]]; s < end; ++s) {
+            unsigned int j = grid.sortedIndices[s];
+            double r2 = distanceSquared(positions[i], positions[j]);
+            if (r2 < h2) {
+                double x = 1.0 - r2 / h2;
+                sum += kernelFactor * x * x * x;
+                count += (j != i) ? 1 : 0;
+            }
+        }
+    }
+
+    densities[i] = params.mass * sum;
+    atomicAdd(numberOfNeighbors, count);
+}
+
+__global__ void viscosityForceKernel(
+    DeviceHashGrid grid,
+    const DeviceVector3* positions,
+    const DeviceVector3* velocities,
+    const double* densities,
+    size_t n,
+    CudaSphParameters params,
+    double kernelFactor,
+    DeviceVector3* forces) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i >= n) {
+        return;
+    }
+
+    const double h = params.kernelRadius;
+    const double scale
+        = params.viscosityCoefficient * params.mass * params.mass;
+
+    unsigned int keys[8];
+    int numberOfKeys = nearbyKeys(grid, positions[i], keys);
+
+    DeviceVector3 force = {0.0, 0.0, 0.0};
+    for (int c = 0; c < numberOfKeys; ++c) {
+        unsigned int end = grid.endIndexTable[keys[c]];
+        for (unsigned int s = grid.startIndexTable[keys[c]]; s < end; ++s) {
+            unsigned int j = grid.sortedIndices[s];
+            double r = sqrt(distanceSquared(positions[i], positions[j]));
+            if (j != i && r < h) {
+                double weight
+                    = scale * kernelFactor * (1.0 - r / h) / densities[j];
+                force.x += weight * (velocities[j].x - velocities[i].x);
+                force.y += weight * (velocities[j].y - velocities[i].y);
+                force.z += weight * (velocities[j].z - velocities[i].z);
+            }
+        }
+    }
+
+    forces[i] = force;
+}
+
+__global__ void pressureKernel(
+    const double* densities,
+    size_t n,
+    CudaSphParameters params,
+    double* pressures) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i < n) {
+        // Same as computePressureFromEos
+        double p = params.eosScale / params.eosExponent
+            * (pow(densities[i] / params.targetDensity, params.eosExponent)
+                - 1.0);
+        if (p < 0) {
+            p *= params.negativePressureScale;
+        }
+        pressures[i] = p;
+    }
+}
+
+__global__ void pressureForceKernel(
+    DeviceHashGrid grid,
+    const DeviceVector3* positions,
+    const double* densities,
+    const double* pressures,
+    size_t n,
+    CudaSphParameters params,
+    double kernelFactor,
+    DeviceVector3* forces) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i >= n) {
+        return;
+    }
+
+    const double h = params.kernelRadius;
+    const double massSquared = params.mass * params.mass;
+    const double pi = pressures[i] / (densities[i] * densities[i]);
+
+    unsigned int keys[8];
+    int numberOfKeys = nearbyKeys(grid, positions[i], keys);
+
+    DeviceVector3 force = {0.0, 0.0, 0.0};
+    for (int c = 0; c < numberOfKeys; ++c) {
+        unsigned int end = grid.endIndexTable[keys[c]];
+        for (unsigned int s = grid.startIndexTable[keys[c]]; s < end; ++s) {
+            unsigned int j = grid.sortedIndices[s];
+            double r = sqrt(distanceSquared(positions[i], positions[j]));
+            if (r > 0.0 && r < h) {
+                double t = 1.0 - r / h;
+                double pj = pressures[j] / (densities[j] * densities[j]);
+                double scale
+                    = massSquared * (pi + pj) * kernelFactor * t * t / r;
+                force.x -= scale * (positions[j].x - positions[i].x);
+                force.y -= scale * (positions[j].y - positions[i].y);
+                force.z -= scale * (positions[j].z - positions[i].z);
+            }
+        }
+    }
+
+    forces[i] = force;
+}
+
+__global__ void pseudoViscosityKernel(
+    DeviceHashGrid grid,
+    const DeviceVector3* positions,
+    const DeviceVector3* velocities,
+    const double* densities,
+    size_t n,
+    CudaSphParameters params,
+    double kernelFactor,
+    double factor,
+    DeviceVector3* newVelocities) {
+    size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+    if (i >= n) {
+        return;
+    }
+
+    const double h = params.kernelRadius;
+
+    unsigned int keys[8];
+    int numberOfKeys = nearbyKeys(grid, positions[i], keys);
+
+    double weightSum = 0.0;
+    DeviceVector3 smoothed = {0.0, 0.0, 0.0};
+    for (int c = 0; c < numberOfKeys; ++c) {
+        unsigned int end = grid.endIndexTable[keys[c]];
+        for (unsigned int s = grid.startIndexTable[keys[c]]; s < end; ++s) {
+            unsigned int j = grid.sortedIndices[s];
+            double r = sqrt(distanceSquared(positions[i], positions[j]));
+            if (j != i && r < h) {
+                double t = 1.0 - r / h;
+                double wj = params.mass / densities[j] * kernelFactor
+                    * t * t * t;
+                weightSum += wj;
+                smoothed.x += wj * velocities[j].x;
+                smoothed.y += wj * velocities[j].y;
+                smoothed.z += wj * velocities[j].z;
+            }
+        }
+    }
+
+    double wi = params.mass / densities[i];
+    weightSum += wi;
+    smoothed.x += wi * velocities[i].x;
+    smoothed.y += wi * velocities[i].y;
+    smoothed.z += wi * velocities[i].z;
+
+    if (weightSum > 0.0) {
+        smoothed.x /= weightSum;
+        smoothed.y /= weightSum;
+        smoothed.z /= weightSum;
+    }
+
+    newVelocities[i].x
+        = (1.0 - factor) * velocities[i].x + factor * smoothed.x;
+    newVelocities[i].y
+        = (1.0 - factor) * velocities[i].y + factor * smoothed.y;
+    newVelocities[i].z
+        = (1.0 - factor) * velocities[i].z + factor * smoothed.z;
+}
+
+void addForces(
+    const std::vector<DeviceVector3>& deviceForces,
+    ArrayAccessor1<Vector3D> forces) {
+    for (size_t i = 0; i < forces.size(); ++i) {
+        forces[i] += Vector3D(
+            deviceForces[i].x, deviceForces[i].y, deviceForces[i].z);
+    }
+}
+
+}  // namespace
+
+class CudaSphState final {
+ public:
+    size_t n = 0;
+    double gridSpacing = 0.0;
+    Size3 resolution;
+    size_t numberOfNeighbors = 0;
+
+    DeviceArray<DeviceVector3> positions;
+    DeviceArray<DeviceVector3> velocities;
+    DeviceArray<DeviceVector3> results;
+    DeviceArray<double> densities;
+    DeviceArray<double> pressures;
+
+    DeviceArray<unsigned int> keys;
+    DeviceArray<unsigned int> counts;
+    DeviceArray<unsigned int> startIndexTable;
+    DeviceArray<unsigned int> endIndexTable;
+    DeviceArray<unsigned int> sortedIndices;
+    DeviceArray<unsigned long long> neighborCounter;
+
+    std::vector<DeviceVector3> hostResults;
+
+    DeviceHashGrid hashGrid() const {
+        DeviceHashGrid grid;
+        grid.gridSpacing = gridSpacing;
+        grid.resolutionX = static_cast<long long>(resolution.x);
+        grid.resolutionY = static_cast<long long>(resolution.y);
+        grid.resolutionZ = static_cast<long long>(resolution.z);
+        grid.startIndexTable = startIndexTable.data();
+        grid.endIndexTable = endIndexTable.data();
+        grid.sortedIndices = sortedIndices.data();
+        return grid;
+    }
+};
+
+void CudaSphStateDeleter::operator()(CudaSphState* state) const {
+    delete state;
+}
+
+CudaSphState* createCudaSphState() {
+    CudaSphState* state = new CudaSphState();
+    state->neighborCounter.resize(1);
+    return state;
+}
+
+void buildCudaSphNeighborGrid(
+    CudaSphState* state,
+    const ConstArrayAccessor1<Vector3D>& positions,
+    const ConstArrayAccessor1<Vector3D>& velocities,
+    double kernelRadius,
+    const Size3& resolution) {
+    const size_t n = positions.size();
+    const size_t numberOfBuckets = resolution.x * resolution.y * resolution.z;
+
+    state->n = n;
+    state->gridSpacing = 2.0 * kernelRadius;
+    state->resolution = resolution;
+
+    // The buffers are reallocated only when the sizes change
+    state->positions.resize(n);
+    state->velocities.resize(n);
+    state->results.resize(n);
+    state->densities.resize(n);
+    state->pressures.resize(n);
+    state->keys.resize(n);
+    state->sortedIndices.resize(n);
+    state->counts.resize(numberOfBuckets);
+    state->startIndexTable.resize(numberOfBuckets);
+    state->endIndexTable.resize(numberOfBuckets);
+    state->hostResults.resize(n);
+
+    if (n == 0) {
+        return;
+    }
+
+    state->positions.upload(
+        reinterpret_cast<const DeviceVector3*>(positions.data()));
+    state->velocities.upload(
+        reinterpret_cast<const DeviceVector3*>(velocities.data()));
+
+    DeviceHashGrid grid = state->hashGrid();
+
+    state->counts.setZero();
+    hashKeyKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+        grid,
+        state->positions.data(),
+        n,
+        state->keys.data(),
+        state->counts.data());
+    checkCuda(cudaGetLastError());
+
+    scanKernel<<<1, kScanBlockSize>>>(
+        state->counts.data(),
+        numberOfBuckets,
+        state->startIndexTable.data(),
+        state->endIndexTable.data());
+    checkCuda(cudaGetLastError());
+
+    // Reuse the counts as the insertion cursors of the buckets
+    checkCuda(cudaMemcpy(
+        state->counts.data(),
+        state->startIndexTable.data(),
+        numberOfBuckets * sizeof(unsigned int),
+        cudaMemcpyDeviceToDevice));
+    scatterKernel<<<cudaNumberOfBlocks(n), kCudaBlockSize>>>(
+        state->keys.data(),
+        n,
+        state->counts.data(),
+        state->sortedIndices.data());
+    checkCuda(cudaGetLastError());
+
+    sortBucketsKernel<<<cudaNumberOfBlocks(numberOfBuckets), kCudaBlockSize>>>(
+        state->startIndexTable.data(),
+        state->endIndexTable.data(),
+        numberOfBuckets,
+        state->sortedIndices.data());
+    checkCuda(cudaGetLastError());
+}
+
+void updateCudaSphDensities(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    ArrayAccessor1<double> densities) {
+    JET_ASSERT(densities.size() == state->n);
+
+    state->numberOfNeighbors = 0;
+    if (state->n == 0) {
+        return;
+    }
+
+    state->neighborCounter.setZero();
+    densityKernel<<<cudaNumberOfBlocks(state->n), kCudaBlockSize>>>(
+        state->hashGrid(),
+        state->positions.data(),
+        state->n,
+        params,
+        315.0 / (64.0 * kPiD * cubic(params.kernelRadius)),
+        state->densities.data(),
+        state->neighborCounter.data());
+    checkCuda(cudaGetLastError());
+
+    state->densities.download(densities.data());
+
+    unsigned long long numberOfNeighbors = 0;
+    state->neighborCounter.download(&numberOfNeighbors);
+    state->numberOfNeighbors = static_cast<size_t>(numberOfNeighbors);
+}
+
+void accumulateCudaSphViscosityForce(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    ArrayAccessor1<Vector3D> forces) {
+    JET_ASSERT(forces.size() == state->n);
+
+    if (state->n == 0) {
+        return;
+    }
+
+    viscosityForceKernel<<<cudaNumberOfBlocks(state->n), kCudaBlockSize>>>(
+        state->hashGrid(),
+        state->positions.data(),
+        state->velocities.data(),
+        state->densities.data(),
+        state->n,
+        params,
+        90.0 / (kPiD * std::pow(params.kernelRadius, 5)),
+        state->results.data());
+    checkCuda(cudaGetLastError());
+
+    state->results.download(state->hostResults.data());
+    addForces(state->hostResults, forces);
+}
+
+void accumulateCudaSphPressureForce(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    ArrayAccessor1<double> pressures,
+    ArrayAccessor1<Vector3D> forces) {
+    JET_ASSERT(pressures.size() == state->n);
+    JET_ASSERT(forces.size() == state->n);
+
+    if (state->n == 0) {
+        return;
+    }
+
+    pressureKernel<<<cudaNumberOfBlocks(state->n), kCudaBlockSize>>>(
+        state->densities.data(),
+        state->n,
+        params,
+        state->pressures.data());
+    checkCuda(cudaGetLastError());
+
+    pressureForceKernel<<<cudaNumberOfBlocks(state->n), kCudaBlockSize>>>(
+        state->hashGrid(),
+        state->positions.data(),
+        state->densities.data(),
+        state->pressures.data(),
+        state->n,
+        params,
+        45.0 / (kPiD * std::pow(params.kernelRadius, 4)),
+        state->results.data());
+    checkCuda(cudaGetLastError());
+
+    state->pressures.download(pressures.data());
+    state->results.download(state->hostResults.data());
+    addForces(state->hostResults, forces);
+}
+
+void computeCudaSphPseudoViscosity(
+    CudaSphState* state,
+    const CudaSphParameters& params,
+    double factor,
+    ArrayAccessor1<Vector3D> velocities) {
+    JET_ASSERT(velocities.size() == state->n);
+
+    if (state->n == 0) {
+        return;
+    }
+
+    // The densities of the beginning of the step are used as the host does
+    pseudoViscosityKernel<<<cudaNumberOfBlocks(state->n), kCudaBlockSize>>>(
+        state->hashGrid(),
+        state->positions.data(),
+        state->velocities.data(),
+        state->densities.data(),
+        state->n,
+        params,
+        15.0 / (kPiD * cubic(params.kernelRadius)),
+        factor,
+        state->results.data());
+    checkCuda(cudaGetLastError());
+
+    state->results.download(
+        reinterpret_cast<DeviceVector3*>(velocities.data()));
+}
+
+size_t cudaSphNumberOfNeighbors(const CudaSphState* state) {
+    return state->numberOfNeighbors;
+}
+
+}  // namespace internal
+
+}  // namespace jet
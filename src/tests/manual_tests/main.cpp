@@ -18,5 +18,8 @@ int main(int argc, char** argv) {
 
     int ret = RUN_ALL_TESTS();
 
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
     return ret;
 }
@@ -70,7 +70,7 @@ JET_BEGIN_TEST_F(PointHashGridSearcher3, Build) {
                     static_cast<ssize_t>(i),
                     static_cast<ssize_t>(j),
                     0));
-            size_t value = pointSearcher.buckets()[key].size();
+            size_t value = pointSearcher.numberOfPointsInBucket(key);
             grid(i, j) += static_cast<double>(value);
         }
     }
@@ -0,0 +1,150 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/array3.h>
+#include <jet/array_samplers3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cubic_semi_lagrangian3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/parallel.h>
+#include <jet/semi_lagrangian3.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+void runAdvectionPerf(
+    const std::string& name,
+    AdvectionSolver3* solver,
+    size_t n) {
+    Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+    CellCenteredScalarGrid3 input(Size3(n, n, n), gridSpacing);
+    CellCenteredScalarGrid3 output(Size3(n, n, n), gridSpacing);
+    FaceCenteredGrid3 flow(Size3(n, n, n), gridSpacing);
+
+    input.fill([](const Vector3D& pt) {
+        return pt.distanceTo(Vector3D(0.5, 0.5, 0.5)) - 0.25;
+    });
+    flow.fill([](const Vector3D& pt) {
+        return Vector3D(0.5 - pt.y, pt.x - 0.5, 0.1);
+    });
+
+    runPerf(
+        name + "::advect/" + std::to_string(n),
+        [&] { solver->advect(input, flow, 0.01, &output); });
+}
+
+// Advects four scalar channels together with a single back-trace per point
+void runBatchedAdvectionPerf(
+    const std::string& name,
+    SemiLagrangian3* solver,
+    size_t n) {
+    Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+    std::vector<CellCenteredScalarGrid3> inputs(
+        4, CellCenteredScalarGrid3(Size3(n, n, n), gridSpacing));
+    std::vector<CellCenteredScalarGrid3> outputs(
+        4, CellCenteredScalarGrid3(Size3(n, n, n), gridSpacing));
+    FaceCenteredGrid3 flow(Size3(n, n, n), gridSpacing);
+
+    std::vector<const ScalarGrid3*> inputPtrs;
+    std::vector<ScalarGrid3*> outputPtrs;
+    for (size_t c = 0; c < 4; ++c) {
+        inputs[c].fill([c](const Vector3D& pt) {
+            return pt.distanceTo(Vector3D(0.5, 0.5, 0.5)) - 0.1 * (c + 1);
+        });
+        inputPtrs.push_back(&inputs[c]);
+        outputPtrs.push_back(&outputs[c]);
+    }
+    flow.fill([](const Vector3D& pt) {
+        return Vector3D(0.5 - pt.y, pt.x - 0.5, 0.1);
+    });
+
+    runPerf(
+        name + "::advectBatch/" + std::to_string(n),
+        [&] { solver->advect(inputPtrs, {}, flow, 0.01, outputPtrs, {}); });
+}
+
+}  // namespace
+
+TEST(SemiLagrangian3, Advect) {
+    SemiLagrangian3 solver;
+    for (size_t n : { 32, 64, 128 }) {
+        runAdvectionPerf("SemiLagrangian3", &solver, n);
+    }
+}
+
+TEST(CubicSemiLagrangian3, Advect) {
+    CubicSemiLagrangian3 solver;
+    for (size_t n : { 32, 64, 128 }) {
+        runAdvectionPerf("CubicSemiLagrangian3", &solver, n);
+    }
+}
+
+TEST(CubicSemiLagrangian3, AdvectNonMonotonic) {
+    CubicSemiLagrangian3 solver;
+    solver.setIsMonotonic(false);
+    for (size_t n : { 32, 64, 128 }) {
+        runAdvectionPerf("CubicSemiLagrangian3/nonMonotonic", &solver, n);
+    }
+}
+
+TEST(CubicSemiLagrangian3, AdvectBatch) {
+    CubicSemiLagrangian3 solver;
+    for (bool isMonotonic : { true, false }) {
+        solver.setIsMonotonic(isMonotonic);
+        std::string name = isMonotonic
+            ? "CubicSemiLagrangian3" : "CubicSemiLagrangian3/nonMonotonic";
+        for (size_t n : { 64, 128 }) {
+            runBatchedAdvectionPerf(name, &solver, n);
+        }
+    }
+}
+
+TEST(LinearArraySampler3, RandomSampleHugePages) {
+    const size_t n = 256;
+    const size_t numberOfSamples = 1 << 22;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, static_cast<double>(n - 1));
+    std::vector<Vector3D> points(numberOfSamples);
+    for (Vector3D& pt : points) {
+        pt = Vector3D(d(rng), d(rng), d(rng));
+    }
+    std::vector<double> samples(numberOfSamples);
+
+    // The array is allocated after setting each policy
+    ArrayHugePagePolicy oldPolicy = arrayHugePagePolicy();
+    for (ArrayHugePagePolicy policy : {
+             ArrayHugePagePolicy::None,
+             ArrayHugePagePolicy::Transparent,
+             ArrayHugePagePolicy::Explicit}) {
+        if (!isArrayHugePagePolicySupported(policy)) {
+            continue;
+        }
+        setArrayHugePagePolicy(policy);
+
+        Array3<double> data(n, n, n);
+        data.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+            data(i, j, k) = static_cast<double>(i + j + k);
+        });
+        LinearArraySampler3<double, double> sampler(
+            data.constAccessor(), Vector3D(1, 1, 1), Vector3D());
+
+        std::string suffix = (policy == ArrayHugePagePolicy::None)
+            ? "/none"
+            : (policy == ArrayHugePagePolicy::Transparent)
+                ? "/transparent" : "/explicit";
+        runPerf(
+            "LinearArraySampler3::randomSample" + suffix,
+            [&] {
+                parallelFor(kZeroSize, numberOfSamples, [&](size_t i) {
+                    samples[i] = sampler(points[i]);
+                });
+            });
+    }
+    setArrayHugePagePolicy(oldPolicy);
+}
@@ -2,10 +2,12 @@
 
 #include <perf_tests.h>
 #include <jet/fdm_linear_system2.h>
+#include <jet/fdm_jacobi_solver3.h>
 #include <jet/fdm_linear_system3.h>
-#include <jet/timer.h>
+#include <jet/simd.h>
 #include <gtest/gtest.h>
 #include <random>
+#include <string>
 
 using namespace jet;
 
@@ -23,15 +25,7 @@ TEST(FdmBlas2, Mvm) {
         a(i, j) = d(rng);
     });
 
-    Timer timer;
-
-    for (int i = 0; i < 10; ++i) {
-        FdmBlas2::mvm(m, a, &b);
-    }
-
-    JET_PRINT_INFO(
-        "FdmBlas2::mvm avg. %f sec.\n",
-        timer.durationInSeconds() / 10.0);
+    runPerf("FdmBlas2::mvm", [&] { FdmBlas2::mvm(m, a, &b); });
 }
 
 TEST(FdmBlas3, Mvm) {
@@ -49,13 +43,74 @@ TEST(FdmBlas3, Mvm) {
         a(i, j, k) = d(rng);
     });
 
-    Timer timer;
+    runPerf("FdmBlas3::mvm", [&] { FdmBlas3::mvm(m, a, &b); });
+}
+
+TEST(FdmBlas3, Simd) {
+    FdmMatrix3 m(200, 200, 200);
+    FdmVector3 a(200, 200, 200), b(200, 200, 200), c(200, 200, 200);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    m.forEachIndex([&](size_t i, size_t j, size_t k) {
+        m(i, j, k).center = d(rng);
+        m(i, j, k).right = d(rng);
+        m(i, j, k).up = d(rng);
+        m(i, j, k).front = d(rng);
+        a(i, j, k) = d(rng);
+        b(i, j, k) = d(rng);
+    });
+
+    // Each of the instruction sets of this CPU, from the plain loops
+    SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    for (SimdInstructionSet instructionSet : {
+             SimdInstructionSet::None,
+             SimdInstructionSet::Sse2,
+             SimdInstructionSet::Neon,
+             SimdInstructionSet::Avx,
+             SimdInstructionSet::Avx512}) {
+        if (!isSimdInstructionSetSupported(instructionSet)) {
+            continue;
+        }
+        setSimdInstructionSet(instructionSet);
 
-    for (int i = 0; i < 10; ++i) {
-        FdmBlas3::mvm(m, a, &b);
+        std::string suffix
+            = std::string("/") + simdInstructionSetName(instructionSet);
+        runPerf("FdmBlas3::mvm" + suffix, [&] { FdmBlas3::mvm(m, a, &c); });
+        runPerf(
+            "FdmBlas3::residual" + suffix,
+            [&] { FdmBlas3::residual(m, a, b, &c); });
+        runPerf(
+            "FdmBlas3::axpy" + suffix,
+            [&] { FdmBlas3::axpy(0.5, a, b, &c); });
     }
+    setSimdInstructionSet(oldInstructionSet);
+}
+
+TEST(FdmJacobiSolver3, TemporalBlocking) {
+    FdmLinearSystem3 system;
+    system.A.resize(200, 200, 200);
+    system.x.resize(200, 200, 200);
+    system.b.resize(200, 200, 200);
 
-    JET_PRINT_INFO(
-        "FdmBlas3::mvm avg. %f sec.\n",
-        timer.durationInSeconds() / 10.0);
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    system.A.forEachIndex([&](size_t i, size_t j, size_t k) {
+        system.A(i, j, k).center = 6.0 + d(rng);
+        system.A(i, j, k).right = -d(rng);
+        system.A(i, j, k).up = -d(rng);
+        system.A(i, j, k).front = -d(rng);
+        system.b(i, j, k) = d(rng);
+    });
+
+    // Eight iterations without residual checks in between
+    for (unsigned int depth : { 1u, 4u, 8u }) {
+        FdmJacobiSolver3 solver(8, 8, 0.0);
+        solver.setTemporalBlockingDepth(depth);
+        runPerf(
+            "FdmJacobiSolver3::solve/" + std::to_string(depth),
+            [&] { solver.solve(&system); });
+    }
 }
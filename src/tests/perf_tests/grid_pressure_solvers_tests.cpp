@@ -0,0 +1,81 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/fdm_cg_solver3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
+#include <jet/fdm_mgpcg_solver3.h>
+#include <jet/grid_fractional_single_phase_pressure_solver3.h>
+#include <jet/grid_single_phase_pressure_solver3.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+// Projects a swirl in a closed box with a sphere collider at the center
+void runPressurePerf(
+    const std::string& name,
+    GridPressureSolver3* solver,
+    size_t n) {
+    Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+    FaceCenteredGrid3 input(Size3(n, n, n), gridSpacing);
+    FaceCenteredGrid3 output(Size3(n, n, n), gridSpacing);
+    CellCenteredScalarGrid3 boundarySdf(Size3(n, n, n), gridSpacing);
+
+    input.fill([](const Vector3D& pt) {
+        return Vector3D(0.5 - pt.y, pt.x - 0.5, pt.x * pt.y);
+    });
+    boundarySdf.fill([](const Vector3D& pt) {
+        return 0.2 - pt.distanceTo(Vector3D(0.5, 0.5, 0.5));
+    });
+
+    runPerf(
+        name + "::solve/" + std::to_string(n),
+        [&] { solver->solve(input, 1.0, &output, boundarySdf); });
+}
+
+}  // namespace
+
+TEST(GridSinglePhasePressureSolver3, Solve) {
+    GridSinglePhasePressureSolver3 solver;
+    for (size_t n : { 32, 64 }) {
+        unsigned int maxIter = static_cast<unsigned int>(n * n * n);
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(maxIter, 1e-6));
+        runPressurePerf("GridSinglePhasePressureSolver3/Iccg", &solver, n);
+
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(
+                maxIter, 1e-6, FdmIccgSolver3::BlockIncompleteCholesky));
+        runPressurePerf(
+            "GridSinglePhasePressureSolver3/BlockIccg", &solver, n);
+
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmCgSolver3>(maxIter, 1e-6));
+        runPressurePerf("GridSinglePhasePressureSolver3/Cg", &solver, n);
+
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmMatrixFreeCgSolver3>(maxIter, 1e-6));
+        runPressurePerf(
+            "GridSinglePhasePressureSolver3/MatrixFreeCg", &solver, n);
+
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmMgpcgSolver3>(4, maxIter, 1e-6));
+        runPressurePerf("GridSinglePhasePressureSolver3/Mgpcg", &solver, n);
+    }
+}
+
+TEST(GridFractionalSinglePhasePressureSolver3, Solve) {
+    GridFractionalSinglePhasePressureSolver3 solver;
+    for (size_t n : { 32, 64 }) {
+        unsigned int maxIter = static_cast<unsigned int>(n * n * n);
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(maxIter, 1e-6));
+        runPressurePerf(
+            "GridFractionalSinglePhasePressureSolver3/Iccg", &solver, n);
+    }
+}
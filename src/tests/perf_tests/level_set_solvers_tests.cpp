@@ -0,0 +1,62 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/eno_level_set_solver3.h>
+#include <jet/fast_sweeping_level_set_solver3.h>
+#include <jet/fmm_level_set_solver3.h>
+#include <jet/upwind_level_set_solver3.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+void runReinitializePerf(
+    const std::string& name,
+    LevelSetSolver3* solver,
+    size_t n) {
+    Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+    CellCenteredScalarGrid3 input(Size3(n, n, n), gridSpacing);
+    CellCenteredScalarGrid3 output(Size3(n, n, n), gridSpacing);
+
+    // A scaled sphere SDF whose gradient is not unit length
+    input.fill([](const Vector3D& pt) {
+        return 2.0 * (pt.distanceTo(Vector3D(0.5, 0.5, 0.5)) - 0.25);
+    });
+
+    runPerf(
+        name + "::reinitialize/" + std::to_string(n),
+        [&] { solver->reinitialize(input, 5.0 / n, &output); });
+}
+
+}  // namespace
+
+TEST(FmmLevelSetSolver3, Reinitialize) {
+    FmmLevelSetSolver3 solver;
+    for (size_t n : { 32, 64, 128 }) {
+        runReinitializePerf("FmmLevelSetSolver3", &solver, n);
+    }
+}
+
+TEST(FastSweepingLevelSetSolver3, Reinitialize) {
+    FastSweepingLevelSetSolver3 solver;
+    for (size_t n : { 32, 64, 128 }) {
+        runReinitializePerf("FastSweepingLevelSetSolver3", &solver, n);
+    }
+}
+
+TEST(UpwindLevelSetSolver3, Reinitialize) {
+    UpwindLevelSetSolver3 solver;
+    for (size_t n : { 32, 64 }) {
+        runReinitializePerf("UpwindLevelSetSolver3", &solver, n);
+    }
+}
+
+TEST(EnoLevelSetSolver3, Reinitialize) {
+    EnoLevelSetSolver3 solver;
+    for (size_t n : { 32, 64 }) {
+        runReinitializePerf("EnoLevelSetSolver3", &solver, n);
+    }
+}
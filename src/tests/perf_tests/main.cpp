@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <perf_tests.h>
 #include <jet/jet.h>
 #include <gtest/gtest.h>
 #include <fstream>
@@ -8,6 +9,7 @@ using namespace jet;
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
+    parsePerfOptions(&argc, argv);
 
     std::ofstream logFile("perf_tests.log");
     if (logFile) {
@@ -16,5 +18,10 @@ int main(int argc, char** argv) {
 
     int ret = RUN_ALL_TESTS();
 
+    writePerfResults();
+
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
     return ret;
 }
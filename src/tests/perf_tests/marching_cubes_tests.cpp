@@ -0,0 +1,113 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/marching_cubes.h>
+#include <jet/particles_to_sdf3.h>
+#include <jet/sph_system_data3.h>
+#include <jet/triangle_mesh_to_sdf.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+double sphereSdf(const Vector3D& pt) {
+    return pt.distanceTo(Vector3D(0.5, 0.5, 0.5)) - 0.3;
+}
+
+}  // namespace
+
+TEST(MarchingCubes, Sphere) {
+    for (size_t n : { 32, 64, 128 }) {
+        Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+        VertexCenteredScalarGrid3 sdf(Size3(n, n, n), gridSpacing);
+        sdf.fill(sphereSdf);
+
+        TriangleMesh3 mesh;
+        runPerf(
+            "marchingCubes/" + std::to_string(n),
+            [&] {
+                marchingCubes(
+                    sdf.constDataAccessor(),
+                    sdf.gridSpacing(),
+                    sdf.origin(),
+                    &mesh);
+            },
+            [&] { mesh.clear(); });
+    }
+}
+
+TEST(TriangleMeshToSdf, Sphere) {
+    // The same mesh is converted into the grids of different resolutions
+    VertexCenteredScalarGrid3 meshSdf(
+        Size3(64, 64, 64), Vector3D(1.0 / 64, 1.0 / 64, 1.0 / 64));
+    meshSdf.fill(sphereSdf);
+
+    TriangleMesh3 mesh;
+    marchingCubes(
+        meshSdf.constDataAccessor(),
+        meshSdf.gridSpacing(),
+        meshSdf.origin(),
+        &mesh);
+
+    for (size_t n : { 32, 64 }) {
+        Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+        CellCenteredScalarGrid3 sdf(Size3(n, n, n), gridSpacing);
+
+        runPerf(
+            "triangleMeshToSdf/" + std::to_string(n),
+            [&] { triangleMeshToSdf(mesh, &sdf); });
+    }
+}
+
+TEST(ParticlesToSdf3, Block) {
+    // Block of particles with the spacing of two grid cells
+    const double spacing = 1.0 / 64;
+    Array1<Vector3D> positions;
+    for (size_t k = 0; k < 32; ++k) {
+        for (size_t j = 0; j < 32; ++j) {
+            for (size_t i = 0; i < 32; ++i) {
+                positions.append(
+                    Vector3D(0.25, 0.25, 0.25)
+                    + spacing * Vector3D(static_cast<double>(i),
+                                         static_cast<double>(j),
+                                         static_cast<double>(k)));
+            }
+        }
+    }
+
+    const double kernelRadius = 2.0 * spacing;
+    const size_t n = 128;
+    Vector3D gridSpacing(1.0 / n, 1.0 / n, 1.0 / n);
+    VertexCenteredScalarGrid3 sdf(Size3(n, n, n), gridSpacing);
+
+    // Gathers the SPH interpolation of one at each node as the baseline
+    SphSystemData3 particles;
+    particles.addParticles(positions.constAccessor());
+    particles.setRelativeKernelRadius(2.0);
+    particles.setTargetSpacing(kernelRadius / 2.0);
+    particles.buildNeighborSearcher();
+    particles.updateDensities();
+    Array1<double> ones(positions.size(), 1.0);
+    runPerf(
+        "particlesToSdf/sphInterpolation/" + std::to_string(n),
+        [&] {
+            sdf.fill([&](const Vector3D& pt) {
+                return 0.5 - particles.interpolate(pt, ones);
+            });
+        });
+
+    ParticlesToSdf3 converter(kernelRadius);
+    converter.setIsUsingAnisotropicKernels(false);
+    runPerf(
+        "particlesToSdf/isotropic/" + std::to_string(n),
+        [&] { converter.convert(positions.constAccessor(), &sdf); });
+
+    converter.setIsUsingAnisotropicKernels(true);
+    runPerf(
+        "particlesToSdf/anisotropic/" + std::to_string(n),
+        [&] { converter.convert(positions.constAccessor(), &sdf); });
+}
@@ -1,12 +1,14 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <perf_tests.h>
+#include <jet/grid_smoke_solver3.h>
 #include <jet/parallel.h>
-#include <jet/timer.h>
+#include <jet/physics_animation_ensemble.h>
 #include <gtest/gtest.h>
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <random>
 #include <vector>
 
@@ -24,29 +26,27 @@ TEST(Parallel, For) {
         b[i] = d(rng);
     }
 
-    Timer timer;
-
-    for (int iter = 0; iter < 20; ++iter) {
+    runPerf("Parallel/serialFor", [&] {
         for (size_t i = 0; i < N; ++i) {
             c[i] = 1.0 / std::sqrt(a[i] / b[i] + 1.0);
         }
-    }
-
-    JET_PRINT_INFO(
-        "serial for-loop avg. %f sec.\n",
-        timer.durationInSeconds() / 20.0);
+    });
 
-    timer.reset();
-
-    for (int iter = 0; iter < 20; ++iter) {
+    runPerf("Parallel/parallelFor", [&] {
         parallelFor(kZeroSize, N, [&] (size_t i) {
             c[i] = 1.0 / std::sqrt(a[i] / b[i] + 1.0);
         });
-    }
+    });
 
-    JET_PRINT_INFO(
-        "parallelFor avg. %f sec.\n",
-        timer.durationInSeconds() / 20.0);
+    // Cost of the fixed chunks
+    bool wasDeterministic = isDeterministic();
+    setIsDeterministic(true);
+    runPerf("Parallel/parallelFor/deterministic", [&] {
+        parallelFor(kZeroSize, N, [&] (size_t i) {
+            c[i] = 1.0 / std::sqrt(a[i] / b[i] + 1.0);
+        });
+    });
+    setIsDeterministic(wasDeterministic);
 }
 
 TEST(Parallel, Sort) {
@@ -61,31 +61,215 @@ TEST(Parallel, Sort) {
         b[i] = a[i];
     }
 
-    Timer timer;
+    // The input is restored before each run without being timed
+    auto resetInput = [&] { a = b; };
+
+    runPerf(
+        "Parallel/stdSort",
+        [&] { std::sort(a.begin(), a.end()); },
+        resetInput);
+
+    runPerf(
+        "Parallel/parallelSort",
+        [&] { parallelSort(a.begin(), a.end()); },
+        resetInput);
 
-    for (int iter = 0; iter < 20; ++iter) {
-        std::sort(a.begin(), a.end());
-        a = b;  // This will introduce some noise to the measurement :(
+    // Cost of the stable sort with the fixed merge tree
+    bool wasDeterministic = isDeterministic();
+    setIsDeterministic(true);
+    runPerf(
+        "Parallel/parallelSort/deterministic",
+        [&] { parallelSort(a.begin(), a.end()); },
+        resetInput);
+    setIsDeterministic(wasDeterministic);
+
+    // Check the result
+    for (size_t i = 0; i + 1 < a.size(); ++i) {
+        EXPECT_LE(a[i], a[i + 1]) << i;
     }
+}
 
-    JET_PRINT_INFO(
-        "std::sort avg. %f sec.\n",
-        timer.durationInSeconds() / 20.0);
+TEST(Parallel, RadixSort) {
+    size_t N = (1 << 22) + 7;
+    const size_t maxKey = (1 << 21);
+    std::vector<size_t> keys(N), indices(N);
 
-    timer.reset();
+    std::mt19937 rng;
+    std::uniform_int_distribution<size_t> d(0, maxKey);
 
-    for (int iter = 0; iter < 20; ++iter) {
-        parallelSort(a.begin(), a.end());
-        a = b;  // This will introduce some noise to the measurement :(
+    for (size_t i = 0; i < N; ++i) {
+        keys[i] = d(rng);
     }
 
-    JET_PRINT_INFO(
-        "parallelSort avg. %f sec.\n",
-        timer.durationInSeconds() / 20.0);
+    std::vector<size_t> originalKeys = keys;
 
-    // Check the result
-    parallelSort(a.begin(), a.end());
-    for (size_t i = 0; i + 1 < a.size(); ++i) {
-        EXPECT_LE(a[i], a[i + 1]) << i;
+    auto resetInput = [&] {
+        keys = originalKeys;
+        for (size_t i = 0; i < N; ++i) {
+            indices[i] = i;
+        }
+    };
+
+    runPerf(
+        "Parallel/parallelSortIndirect",
+        [&] {
+            parallelSort(
+                indices.begin(),
+                indices.end(),
+                [&originalKeys](size_t a, size_t b) {
+                    return originalKeys[a] < originalKeys[b];
+                });
+        },
+        resetInput);
+
+    bool wasDeterministic = isDeterministic();
+    setIsDeterministic(true);
+    runPerf(
+        "Parallel/parallelSortIndirect/deterministic",
+        [&] {
+            parallelSort(
+                indices.begin(),
+                indices.end(),
+                [&originalKeys](size_t a, size_t b) {
+                    return originalKeys[a] < originalKeys[b];
+                });
+        },
+        resetInput);
+    setIsDeterministic(wasDeterministic);
+
+    runPerf(
+        "Parallel/parallelRadixSort",
+        [&] {
+            parallelRadixSort(
+                keys.begin(), keys.end(), indices.begin(), maxKey);
+        },
+        resetInput);
+
+    for (size_t i = 0; i + 1 < N; ++i) {
+        EXPECT_LE(keys[i], keys[i + 1]) << i;
+    }
+}
+
+TEST(Parallel, ExclusiveScan) {
+    size_t N = (1 << 24) + 7;
+    std::vector<size_t> a(N), b(N);
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<size_t> d(0, 9);
+
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = d(rng);
+    }
+
+    runPerf("Parallel/serialExclusiveScan", [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < N; ++i) {
+            b[i] = sum;
+            sum += a[i];
+        }
+    });
+
+    runPerf("Parallel/parallelExclusiveScan", [&] {
+        parallelExclusiveScan(a.begin(), a.end(), b.begin(), kZeroSize);
+    });
+}
+
+TEST(Parallel, CopyIf) {
+    size_t N = (1 << 24) + 7;
+    std::vector<double> a(N), b(N);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = d(rng);
     }
+
+    auto isSelected = [](double x) {
+        return x < 0.5;
+    };
+
+    runPerf("Parallel/stdCopyIf", [&] {
+        std::copy_if(a.begin(), a.end(), b.begin(), isSelected);
+    });
+
+    runPerf("Parallel/parallelCopyIf", [&] {
+        parallelCopyIf(a.begin(), a.end(), b.begin(), isSelected);
+    });
+}
+
+TEST(Parallel, Partition) {
+    size_t N = (1 << 22) + 7;
+    std::vector<double> a(N), b(N);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = d(rng);
+        b[i] = a[i];
+    }
+
+    auto resetInput = [&] { a = b; };
+
+    auto isSelected = [](double x) {
+        return x < 0.5;
+    };
+
+    runPerf(
+        "Parallel/stdStablePartition",
+        [&] { std::stable_partition(a.begin(), a.end(), isSelected); },
+        resetInput);
+
+    runPerf(
+        "Parallel/parallelPartition",
+        [&] { parallelPartition(a.begin(), a.end(), isSelected); },
+        resetInput);
+}
+
+TEST(Parallel, Ensemble) {
+    // Many small smoke simulations, each of which is too small to keep all
+    // the threads busy
+    const size_t numberOfSimulations = 8;
+    const size_t n = 24;
+    const double h = 1.0 / n;
+
+    std::vector<PhysicsAnimationPtr> solvers;
+    auto setup = [&] {
+        solvers.clear();
+        for (size_t i = 0; i < numberOfSimulations; ++i) {
+            auto solver = std::make_shared<GridSmokeSolver3>();
+            solver->resizeGrid(Size3(n, n, n), Vector3D(h, h, h), Vector3D());
+            double radius = 0.1 + 0.01 * i;
+            solver->smokeDensity()->fill([&](const Vector3D& pt) {
+                return (pt.distanceTo(Vector3D(0.5, 0.3, 0.5)) < radius)
+                    ? 1.0 : 0.0;
+            });
+            solver->temperature()->fill([&](const Vector3D& pt) {
+                return (pt.distanceTo(Vector3D(0.5, 0.3, 0.5)) < radius)
+                    ? 1.0 : 0.0;
+            });
+            solvers.push_back(solver);
+        }
+    };
+
+    runPerf(
+        "Parallel/sequentialSimulations",
+        [&] {
+            for (const PhysicsAnimationPtr& solver : solvers) {
+                solver->update(Frame(1, 1.0 / 60.0));
+            }
+        },
+        setup);
+
+    runPerf(
+        "Parallel/ensembleSimulations",
+        [&] {
+            PhysicsAnimationEnsemble ensemble;
+            for (const PhysicsAnimationPtr& solver : solvers) {
+                ensemble.addAnimation(solver);
+            }
+            ensemble.update(Frame(1, 1.0 / 60.0));
+        },
+        setup);
 }
@@ -0,0 +1,205 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_counters.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace jet {
+
+namespace {
+
+#if defined(__linux__)
+
+struct NamedEvent {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+const uint64_t kCacheReadMiss
+    = (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+const NamedEvent kNamedEvents[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"l1d-read-misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | kCacheReadMiss},
+    {"dtlb-read-misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | kCacheReadMiss}
+};
+
+// Thread ids of this process, starting from the calling thread
+std::vector<pid_t> threadIds() {
+    const pid_t self = static_cast<pid_t>(syscall(SYS_gettid));
+    std::vector<pid_t> tids(1, self);
+
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return tids;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        pid_t tid = static_cast<pid_t>(std::atoi(entry->d_name));
+        if (tid > 0 && tid != self) {
+            tids.push_back(tid);
+        }
+    }
+    closedir(dir);
+    return tids;
+}
+
+int openCounter(const PerfEvent& event, pid_t tid) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format
+        = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+}
+
+#endif
+
+}  // namespace
+
+bool findPerfEvent(const std::string& name, PerfEvent* event) {
+#if defined(__linux__)
+    for (const NamedEvent& namedEvent : kNamedEvents) {
+        if (name == namedEvent.name) {
+            event->name = name;
+            event->type = namedEvent.type;
+            event->config = namedEvent.config;
+            return true;
+        }
+    }
+
+    if (name.size() > 1 && name[0] == 'r') {
+        char* end = nullptr;
+        uint64_t config = std::strtoull(name.c_str() + 1, &end, 16);
+        if (*end == '\0') {
+            event->name = name;
+            event->type = PERF_TYPE_RAW;
+            event->config = config;
+            return true;
+        }
+    }
+#else
+    UNUSED_VARIABLE(name);
+    UNUSED_VARIABLE(event);
+#endif
+
+    return false;
+}
+
+std::vector<PerfEvent> defaultPerfEvents() {
+    std::vector<PerfEvent> events;
+    for (const char* name : {
+             "cycles", "instructions", "cache-references", "cache-misses",
+             "l1d-read-misses", "branch-misses"}) {
+        PerfEvent event;
+        if (findPerfEvent(name, &event)) {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+PerfCounters::PerfCounters(const std::vector<PerfEvent>& events)
+: _numberOfEvents(events.size()), _totals(events.size(), 0.0) {
+#if defined(__linux__)
+    // The calling thread must have all the counters
+    std::vector<pid_t> tids = threadIds();
+    for (size_t t = 0; t < tids.size(); ++t) {
+        std::vector<int> fds;
+        for (const PerfEvent& event : events) {
+            int fd = openCounter(event, tids[t]);
+            if (fd < 0) {
+                break;
+            }
+            fds.push_back(fd);
+        }
+
+        if (fds.size() == events.size()) {
+            _fds.insert(_fds.end(), fds.begin(), fds.end());
+        } else {
+            for (int fd : fds) {
+                close(fd);
+            }
+            if (t == 0) {
+                return;
+            }
+        }
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for (int fd : _fds) {
+        close(fd);
+    }
+#endif
+}
+
+bool PerfCounters::isAvailable() const {
+    return _numberOfEvents > 0 && !_fds.empty();
+}
+
+void PerfCounters::start() {
+#if defined(__linux__)
+    for (int fd : _fds) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    }
+    for (int fd : _fds) {
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void PerfCounters::stop() {
+#if defined(__linux__)
+    for (int fd : _fds) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (size_t n = 0; n < _fds.size(); ++n) {
+        // Value, time enabled, and time running
+        uint64_t values[3] = {0, 0, 0};
+        if (read(_fds[n], values, sizeof(values))
+            != static_cast<ssize_t>(sizeof(values))) {
+            continue;
+        }
+
+        double count = static_cast<double>(values[0]);
+        if (values[2] > 0 && values[2] < values[1]) {
+            count *= static_cast<double>(values[1]) / values[2];
+        }
+        _totals[n % _numberOfEvents] += count;
+    }
+#endif
+}
+
+const std::vector<double>& PerfCounters::totals() const {
+    return _totals;
+}
+
+}  // namespace jet
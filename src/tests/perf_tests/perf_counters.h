@@ -0,0 +1,74 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_TESTS_PERF_TESTS_PERF_COUNTERS_H_
+#define SRC_TESTS_PERF_TESTS_PERF_COUNTERS_H_
+
+#include <jet/macros.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jet {
+
+//! Hardware event of the Linux perf_event interface.
+struct PerfEvent {
+    std::string name;
+    uint32_t type = 0;
+    uint64_t config = 0;
+};
+
+//!
+//! \brief Finds the event of given name.
+//!
+//! The names are the generic events "cycles", "instructions",
+//! "cache-references", "cache-misses" (of the last level cache),
+//! "branch-misses", "l1d-read-misses", and "dtlb-read-misses", or a raw
+//! event code of the CPU in hexadecimal like "r01c7", as in the perf tool.
+//! The vectorization counters, such as the retired packed floating point
+//! operations, are only available as raw events.
+//!
+bool findPerfEvent(const std::string& name, PerfEvent* event);
+
+//! Returns the events counted when no event is given.
+std::vector<PerfEvent> defaultPerfEvents();
+
+//!
+//! \brief Hardware performance counters of all the threads of the process.
+//!
+//! The counters are opened for each thread that exists at construction,
+//! including the workers of the thread pool, so the benchmarks should run
+//! once before the counters are created. Only the user-space events are
+//! counted, which works with the default perf_event_paranoid level. When the
+//! counters are multiplexed, the counts are scaled by the time they ran.
+//!
+class PerfCounters final {
+ public:
+    JET_NON_COPYABLE(PerfCounters)
+
+    //! Opens the counters of given events.
+    explicit PerfCounters(const std::vector<PerfEvent>& events);
+
+    //! Closes the counters.
+    ~PerfCounters();
+
+    //! Returns true if the counters could be opened on this system.
+    bool isAvailable() const;
+
+    //! Starts counting.
+    void start();
+
+    //! Stops counting and adds the counts to the totals.
+    void stop();
+
+    //! Returns the total counts of the events since the construction.
+    const std::vector<double>& totals() const;
+
+ private:
+    size_t _numberOfEvents;
+    std::vector<int> _fds;
+    std::vector<double> _totals;
+};
+
+}  // namespace jet
+
+#endif  // SRC_TESTS_PERF_TESTS_PERF_COUNTERS_H_
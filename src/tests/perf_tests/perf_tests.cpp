@@ -0,0 +1,303 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <perf_counters.h>
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/parallel.h>
+#include <jet/simd.h>
+#include <jet/timer.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace jet {
+
+namespace {
+
+struct PerfOptions {
+    std::vector<unsigned int> threadCounts;
+    unsigned int numberOfIterations = 5;
+    std::string jsonFilename = "perf_tests.json";
+    std::vector<PerfEvent> events;
+};
+
+// Size of the cache lines for the bandwidth estimate
+const double kCacheLineSize = 64.0;
+
+PerfOptions sOptions;
+std::vector<PerfResult> sResults;
+
+bool parseOption(const char* arg, const char* name, std::string* value) {
+    size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) == 0 && arg[length] == '=') {
+        *value = arg + length + 1;
+        return true;
+    }
+    return false;
+}
+
+std::vector<unsigned int> threadCounts() {
+    if (sOptions.threadCounts.empty()) {
+        return std::vector<unsigned int>(1, maxNumberOfThreads());
+    }
+    return sOptions.threadCounts;
+}
+
+// Returns the count of the event of given name, or a negative value if it
+// was not counted
+double findCounter(const PerfResult& result, const std::string& name) {
+    for (const auto& counter : result.counters) {
+        if (counter.first == name) {
+            return counter.second;
+        }
+    }
+    return -1.0;
+}
+
+void addDerivedCounters(PerfResult* result) {
+    double cycles = findCounter(*result, "cycles");
+    double instructions = findCounter(*result, "instructions");
+    double references = findCounter(*result, "cache-references");
+    double misses = findCounter(*result, "cache-misses");
+
+    if (cycles > 0.0 && instructions >= 0.0) {
+        result->counters.emplace_back("ipc", instructions / cycles);
+    }
+    if (references > 0.0 && misses >= 0.0) {
+        result->counters.emplace_back("cache-miss-rate", misses / references);
+    }
+    if (misses >= 0.0 && result->meanTimeInSeconds > 0.0) {
+        result->counters.emplace_back(
+            "miss-bandwidth",
+            misses * kCacheLineSize / result->meanTimeInSeconds * 1e-9);
+    }
+}
+
+void writeEscaped(const std::string& str, std::ostream* strm) {
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            (*strm) << '\\';
+        }
+        (*strm) << c;
+    }
+}
+
+}  // namespace
+
+void parsePerfOptions(int* argc, char** argv) {
+    int numberOfArgs = 1;
+    for (int i = 1; i < *argc; ++i) {
+        std::string value;
+        if (parseOption(argv[i], "--perf_threads", &value)) {
+            sOptions.threadCounts.clear();
+            std::stringstream values(value);
+            std::string count;
+            while (std::getline(values, count, ',')) {
+                int n = std::atoi(count.c_str());
+                if (n > 0) {
+                    sOptions.threadCounts.push_back(
+                        static_cast<unsigned int>(n));
+                }
+            }
+        } else if (parseOption(argv[i], "--perf_iterations", &value)) {
+            sOptions.numberOfIterations = static_cast<unsigned int>(
+                std::max(std::atoi(value.c_str()), 1));
+        } else if (parseOption(argv[i], "--perf_json", &value)) {
+            sOptions.jsonFilename = value;
+        } else if (std::strcmp(argv[i], "--perf_deterministic") == 0) {
+            setIsDeterministic(true);
+        } else if (std::strcmp(argv[i], "--perf_counters") == 0) {
+            sOptions.events = defaultPerfEvents();
+        } else if (parseOption(argv[i], "--perf_counters", &value)) {
+            sOptions.events.clear();
+            std::stringstream names(value);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                PerfEvent event;
+                if (findPerfEvent(name, &event)) {
+                    sOptions.events.push_back(event);
+                } else {
+                    JET_PRINT_INFO("Unknown perf event %s\n", name.c_str());
+                }
+            }
+        } else if (parseOption(argv[i], "--perf_simd", &value)) {
+            for (SimdInstructionSet instructionSet : {
+                     SimdInstructionSet::None,
+                     SimdInstructionSet::Sse2,
+                     SimdInstructionSet::Neon,
+                     SimdInstructionSet::Avx,
+                     SimdInstructionSet::Avx512}) {
+                if (value == simdInstructionSetName(instructionSet)
+                    && isSimdInstructionSetSupported(instructionSet)) {
+                    setSimdInstructionSet(instructionSet);
+                }
+            }
+        } else {
+            argv[numberOfArgs++] = argv[i];
+        }
+    }
+    *argc = numberOfArgs;
+}
+
+void runPerf(
+    const std::string& name,
+    const std::function<void()>& func,
+    const std::function<void()>& setup) {
+    unsigned int previousNumberOfThreads = maxNumberOfThreads();
+
+    for (unsigned int numberOfThreads : threadCounts()) {
+        setMaxNumberOfThreads(numberOfThreads);
+
+        if (setup) {
+            setup();
+        }
+        func();
+
+        // The counters are opened after the warm-up, which starts the
+        // workers of the thread pool
+        std::unique_ptr<PerfCounters> counters;
+        if (!sOptions.events.empty()) {
+            counters.reset(new PerfCounters(sOptions.events));
+            if (!counters->isAvailable()) {
+                JET_PRINT_INFO(
+                    "%s\n",
+                    "Hardware performance counters are not available");
+                sOptions.events.clear();
+                counters.reset();
+            }
+        }
+
+        PerfResult result;
+        result.name = name;
+        result.numberOfThreads = numberOfThreads;
+        result.numberOfIterations = sOptions.numberOfIterations;
+        result.minTimeInSeconds = kMaxD;
+
+        double totalTime = 0.0;
+        for (unsigned int i = 0; i < sOptions.numberOfIterations; ++i) {
+            if (setup) {
+                setup();
+            }
+
+            if (counters) {
+                counters->start();
+            }
+            Timer timer;
+            func();
+            double time = timer.durationInSeconds();
+            if (counters) {
+                counters->stop();
+            }
+
+            totalTime += time;
+            result.minTimeInSeconds = std::min(result.minTimeInSeconds, time);
+            result.maxTimeInSeconds = std::max(result.maxTimeInSeconds, time);
+        }
+        result.meanTimeInSeconds = totalTime / sOptions.numberOfIterations;
+
+        if (counters) {
+            for (size_t n = 0; n < sOptions.events.size(); ++n) {
+                result.counters.emplace_back(
+                    sOptions.events[n].name,
+                    counters->totals()[n] / sOptions.numberOfIterations);
+            }
+            addDerivedCounters(&result);
+        }
+        sResults.push_back(result);
+
+        JET_PRINT_INFO(
+            "%s (threads: %u) avg. %f sec. min. %f sec.\n",
+            name.c_str(),
+            numberOfThreads,
+            result.meanTimeInSeconds,
+            result.minTimeInSeconds);
+        for (const auto& counter : result.counters) {
+            JET_PRINT_INFO(
+                "    %s: %g\n", counter.first.c_str(), counter.second);
+        }
+    }
+
+    setMaxNumberOfThreads(previousNumberOfThreads);
+}
+
+const std::vector<PerfResult>& perfResults() {
+    return sResults;
+}
+
+void writePerfResults(std::ostream* strm) {
+    std::time_t now = std::time(nullptr);
+    char dateStr[32];
+    std::strftime(
+        dateStr, sizeof(dateStr), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    (*strm) << std::setprecision(9);
+    (*strm) << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << dateStr << "\",\n"
+            << "    \"executable\": \"perf_tests\",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency()
+            << ",\n"
+            << "    \"deterministic\": "
+            << (isDeterministic() ? "true" : "false") << ",\n"
+            << "    \"simd\": \""
+            << simdInstructionSetName(simdInstructionSet()) << "\",\n"
+#ifdef JET_DEBUG_MODE
+            << "    \"library_build_type\": \"debug\"\n"
+#else
+            << "    \"library_build_type\": \"release\"\n"
+#endif
+            << "  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < sResults.size(); ++i) {
+        const PerfResult& result = sResults[i];
+        (*strm) << ((i > 0) ? ",\n" : "\n") << "    {\n";
+
+        (*strm) << "      \"name\": \"";
+        writeEscaped(result.name, strm);
+        (*strm) << "/threads:" << result.numberOfThreads << "\",\n";
+
+        (*strm) << "      \"run_name\": \"";
+        writeEscaped(result.name, strm);
+        (*strm) << "\",\n";
+
+        (*strm) << "      \"run_type\": \"iteration\",\n"
+                << "      \"iterations\": " << result.numberOfIterations
+                << ",\n"
+                << "      \"threads\": " << result.numberOfThreads << ",\n"
+                << "      \"real_time\": "
+                << result.meanTimeInSeconds * 1e3 << ",\n"
+                << "      \"cpu_time\": "
+                << result.meanTimeInSeconds * 1e3 << ",\n"
+                << "      \"min_time\": "
+                << result.minTimeInSeconds * 1e3 << ",\n"
+                << "      \"max_time\": "
+                << result.maxTimeInSeconds * 1e3 << ",\n";
+
+        for (const auto& counter : result.counters) {
+            (*strm) << "      \"";
+            writeEscaped(counter.first, strm);
+            (*strm) << "\": " << counter.second << ",\n";
+        }
+
+        (*strm) << "      \"time_unit\": \"ms\"\n"
+                << "    }";
+    }
+
+    (*strm) << "\n  ]\n}\n";
+}
+
+void writePerfResults() {
+    std::ofstream file(sOptions.jsonFilename.c_str());
+    if (file) {
+        writePerfResults(&file);
+    }
+}
+
+}  // namespace jet
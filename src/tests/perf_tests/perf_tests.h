@@ -4,7 +4,10 @@
 #define SRC_TESTS_PERF_TESTS_PERF_TESTS_H_
 
 #include <chrono>
+#include <functional>
+#include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 // gtest hack
@@ -31,5 +34,74 @@ extern void ColoredPrintf(GTestColor color, const char* fmt, ...);
     testing::internal::ColoredPrintf( \
         testing::internal::COLOR_YELLOW, fmt, __VA_ARGS__); \
 
+namespace jet {
+
+//! Timing of a benchmark with a thread count.
+struct PerfResult {
+    std::string name;
+    unsigned int numberOfThreads = 1;
+    unsigned int numberOfIterations = 0;
+    double meanTimeInSeconds = 0.0;
+    double minTimeInSeconds = 0.0;
+    double maxTimeInSeconds = 0.0;
+
+    //! Hardware event counts per iteration followed by the metrics derived
+    //! from them, which is empty unless --perf_counters is given.
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+//!
+//! \brief Parses and removes the perf options from the command line.
+//!
+//! The options are --perf_threads=1,2,4 for the thread counts to run each
+//! benchmark with (default is the hardware concurrency), --perf_iterations=N
+//! for the number of the timed iterations (default is 5),
+//! --perf_json=FILE for the result file (default is perf_tests.json),
+//! --perf_deterministic to run everything in the deterministic mode, and
+//! --perf_simd=NAME to run the vectorized kernels with the instruction set of
+//! given name, such as "none" or "avx" (default is the widest supported one).
+//!
+//! --perf_counters collects the hardware performance counters of the timed
+//! iterations on Linux, which are the cycles, the instructions, the last
+//! level cache references and misses, the L1 data cache read misses, and the
+//! branch misses by default. --perf_counters=cycles,instructions,r01c7 picks
+//! the events instead, where the names are the ones of findPerfEvent(). The
+//! benchmarks run without the counters if the system does not allow them.
+//!
+void parsePerfOptions(int* argc, char** argv);
+
+//!
+//! \brief Times \p func with each of the thread counts.
+//!
+//! The function runs once untimed to warm up the caches and the thread pool,
+//! then the given number of times. \p setup runs before each call and is not
+//! timed, which is where the input should be reset for benchmarks that
+//! modify it.
+//!
+void runPerf(
+    const std::string& name,
+    const std::function<void()>& func,
+    const std::function<void()>& setup = std::function<void()>());
+
+//! Returns the results of all the benchmarks run so far.
+const std::vector<PerfResult>& perfResults();
+
+//!
+//! \brief Writes the results in the JSON format of Google Benchmark.
+//!
+//! The times are in milliseconds, and the thread count is appended to the
+//! name like "Name/threads:4", so the existing tools that compare Google
+//! Benchmark outputs can gate the regressions. The counters are written as
+//! the user counters of Google Benchmark, along with the instructions per
+//! cycle ("ipc"), the last level cache miss rate ("cache-miss-rate"), and the
+//! memory bandwidth estimated from the last level cache misses of 64-byte
+//! lines in GB/s ("miss-bandwidth") when their events are counted.
+//!
+void writePerfResults(std::ostream* strm);
+
+//! Writes the results to the file given by --perf_json.
+void writePerfResults();
+
+}  // namespace jet
 
 #endif  // SRC_TESTS_PERF_TESTS_PERF_TESTS_H_
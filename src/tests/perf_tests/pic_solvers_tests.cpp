@@ -0,0 +1,70 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/apic_solver3.h>
+#include <jet/flip_solver3.h>
+#include <jet/pic_solver3.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+// Exposes the particle-grid transfers of the solvers
+template <typename Solver>
+class TransferSolver : public Solver {
+ public:
+    using Solver::transferFromParticlesToGrids;
+    using Solver::transferFromGridsToParticles;
+};
+
+template <typename Solver>
+void runTransferPerf(const std::string& name, size_t n) {
+    TransferSolver<Solver> solver;
+    solver.resizeGrid(
+        Size3(n, n, n), Vector3D(1.0 / n, 1.0 / n, 1.0 / n), Vector3D());
+    solver.velocity()->fill([](const Vector3D& pt) {
+        return Vector3D(0.5 - pt.y, pt.x - 0.5, 0.1);
+    });
+
+    // Eight particles per cell in the lower half of the domain
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+    Array1<Vector3D> positions(4 * n * n * n);
+    Array1<Vector3D> velocities(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = Vector3D(d(rng), 0.5 * d(rng), d(rng));
+        velocities[i] = Vector3D(d(rng), d(rng), d(rng));
+    }
+    solver.particleSystemData()->addParticles(positions, velocities);
+
+    std::string suffix = "/" + std::to_string(n);
+    runPerf(
+        name + "::transferFromParticlesToGrids" + suffix,
+        [&] { solver.transferFromParticlesToGrids(); });
+    runPerf(
+        name + "::transferFromGridsToParticles" + suffix,
+        [&] { solver.transferFromGridsToParticles(); });
+}
+
+}  // namespace
+
+TEST(PicSolver3, Transfer) {
+    for (size_t n : { 32, 64 }) {
+        runTransferPerf<PicSolver3>("PicSolver3", n);
+    }
+}
+
+TEST(FlipSolver3, Transfer) {
+    for (size_t n : { 32, 64 }) {
+        runTransferPerf<FlipSolver3>("FlipSolver3", n);
+    }
+}
+
+TEST(ApicSolver3, Transfer) {
+    for (size_t n : { 32, 64 }) {
+        runTransferPerf<ApicSolver3>("ApicSolver3", n);
+    }
+}
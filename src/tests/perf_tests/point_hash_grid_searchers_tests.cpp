@@ -2,9 +2,9 @@
 
 #include <perf_tests.h>
 #include <jet/array1.h>
+#include <jet/point_cell_list_searcher3.h>
 #include <jet/point_hash_grid_searcher3.h>
 #include <jet/point_parallel_hash_grid_searcher3.h>
-#include <jet/timer.h>
 #include <gtest/gtest.h>
 #include <random>
 
@@ -22,19 +22,28 @@ TEST(PointHashGridSearcher3, Build) {
         points.append(Vector3D(d(rng), d(rng), d(rng)));
     }
 
-    Timer timer;
+    runPerf("PointHashGridSearcher3::build", [&] { grid.build(points); });
+}
 
-    for (int i = 0; i < 10; ++i) {
-        grid.build(points);
+TEST(PointParallelHashGridSearcher3, Build) {
+    PointParallelHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
+    int N = 1 << 20;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector3D> points;
+    for (int i = 0; i < N; ++i) {
+        points.append(Vector3D(d(rng), d(rng), d(rng)));
     }
 
-    JET_PRINT_INFO(
-        "PointHashGridSearcher3::build avg. %f sec.\n",
-        timer.durationInSeconds() / 10.0);
+    runPerf("PointParallelHashGridSearcher3::build", [&] {
+        grid.build(points);
+    });
 }
 
-TEST(PointParallelHashGridSearcher3, Build) {
-    PointParallelHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
+TEST(PointHashGridSearcher3, ForEachNearbyPoint) {
+    PointHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
     int N = 1 << 20;
 
     std::mt19937 rng;
@@ -45,13 +54,63 @@ TEST(PointParallelHashGridSearcher3, Build) {
         points.append(Vector3D(d(rng), d(rng), d(rng)));
     }
 
-    Timer timer;
+    grid.build(points);
 
-    for (int i = 0; i < 10; ++i) {
-        grid.build(points);
+    size_t numberOfNeighbors = 0;
+    runPerf("PointHashGridSearcher3::forEachNearbyPoint", [&] {
+        for (int i = 0; i < N; ++i) {
+            grid.forEachNearbyPoint(
+                points[i],
+                0.5 / 64.0,
+                [&](size_t, const Vector3D&) { ++numberOfNeighbors; });
+        }
+    });
+    EXPECT_LT(0u, numberOfNeighbors);
+}
+
+TEST(PointCellListSearcher3, ForEachNearbyPoint) {
+    const double radius = 1.0 / 64.0;
+    int N = 1 << 20;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector3D> points;
+    for (int i = 0; i < N; ++i) {
+        points.append(Vector3D(d(rng), d(rng), d(rng)));
     }
 
-    JET_PRINT_INFO(
-        "PointParallelHashGridSearcher3::build avg. %f sec.\n",
-        timer.durationInSeconds() / 10.0);
+    // Same search radius for both: buckets of 2r, and cells of r
+    PointParallelHashGridSearcher3 hashGrid(64, 64, 64, 2.0 * radius);
+    PointCellListSearcher3 cellList(radius);
+
+    runPerf("PointParallelHashGridSearcher3::build", [&] {
+        hashGrid.build(points);
+    });
+    runPerf("PointCellListSearcher3::build", [&] {
+        cellList.build(points);
+    });
+
+    size_t numberOfNeighbors = 0;
+    runPerf("PointParallelHashGridSearcher3::forEachNearbyPoint", [&] {
+        for (int i = 0; i < N; ++i) {
+            hashGrid.forEachNearbyPoint(
+                points[i],
+                radius,
+                [&](size_t, const Vector3D&) { ++numberOfNeighbors; });
+        }
+    });
+
+    size_t numberOfCellListNeighbors = 0;
+    runPerf("PointCellListSearcher3::forEachNearbyPoint", [&] {
+        for (int i = 0; i < N; ++i) {
+            cellList.forEachNearbyPoint(
+                points[i],
+                radius,
+                [&](size_t, const Vector3D&) {
+                    ++numberOfCellListNeighbors;
+                });
+        }
+    });
+    EXPECT_EQ(numberOfNeighbors, numberOfCellListNeighbors);
 }
@@ -0,0 +1,91 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/marching_cubes.h>
+#include <jet/particle_system_data3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace jet;
+
+// The streams are in memory, so the encoding is timed without the disk
+
+TEST(ScalarGrid3, Serialization) {
+    for (size_t n : { 64, 128 }) {
+        CellCenteredScalarGrid3 grid(Size3(n, n, n));
+        grid.fill([](const Vector3D& pt) { return pt.x * pt.y + pt.z; });
+
+        std::stringstream strm;
+        std::string suffix = "/" + std::to_string(n);
+        runPerf(
+            "ScalarGrid3::serialize" + suffix,
+            [&] { grid.serialize(&strm); },
+            [&] { strm.str(std::string()); });
+
+        std::string data = strm.str();
+        runPerf(
+            "ScalarGrid3::deserialize" + suffix,
+            [&] { grid.deserialize(&strm); },
+            [&] { strm.clear(); strm.str(data); });
+    }
+}
+
+TEST(ParticleSystemData3, Serialization) {
+    for (size_t numberOfParticles : { 1 << 16, 1 << 20 }) {
+        std::mt19937 rng;
+        std::uniform_real_distribution<> d(0.0, 1.0);
+        Array1<Vector3D> positions(numberOfParticles);
+        for (auto& pt : positions) {
+            pt = Vector3D(d(rng), d(rng), d(rng));
+        }
+
+        ParticleSystemData3 particles;
+        particles.addParticles(positions);
+
+        std::stringstream strm;
+        std::string suffix = "/" + std::to_string(numberOfParticles);
+        runPerf(
+            "ParticleSystemData3::serialize" + suffix,
+            [&] { particles.serialize(&strm); },
+            [&] { strm.str(std::string()); });
+
+        std::string data = strm.str();
+        runPerf(
+            "ParticleSystemData3::deserialize" + suffix,
+            [&] { particles.deserialize(&strm); },
+            [&] { strm.clear(); strm.str(data); });
+    }
+}
+
+TEST(TriangleMesh3, Obj) {
+    VertexCenteredScalarGrid3 sdf(
+        Size3(128, 128, 128), Vector3D(1.0 / 128, 1.0 / 128, 1.0 / 128));
+    sdf.fill([](const Vector3D& pt) {
+        return pt.distanceTo(Vector3D(0.5, 0.5, 0.5)) - 0.3;
+    });
+
+    TriangleMesh3 mesh;
+    marchingCubes(
+        sdf.constDataAccessor(), sdf.gridSpacing(), sdf.origin(), &mesh);
+
+    std::stringstream strm;
+    runPerf(
+        "TriangleMesh3::writeObj",
+        [&] { mesh.writeObj(&strm); },
+        [&] { strm.str(std::string()); });
+
+    std::string data = strm.str();
+    TriangleMesh3 readMesh;
+    runPerf(
+        "TriangleMesh3::readObj",
+        [&] { readMesh.readObj(&strm); },
+        [&] {
+            readMesh.clear();
+            strm.clear();
+            strm.str(data);
+        });
+}
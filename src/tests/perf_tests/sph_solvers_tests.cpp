@@ -0,0 +1,118 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/iisph_solver3.h>
+#include <jet/particle_system_solver3.h>
+#include <jet/pci_sph_solver3.h>
+#include <jet/sph_solver3.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+// Exposes the force terms of the solvers
+template <typename Solver>
+class ForceSolver : public Solver {
+ public:
+    using Solver::onBeginAdvanceTimeStep;
+    using Solver::accumulateNonPressureForces;
+    using Solver::accumulatePressureForce;
+};
+
+// Fills a block of n x n x n particles at the target spacing
+void addParticleBlock(const SphSystemData3Ptr& particles, size_t n) {
+    const double targetSpacing = particles->targetSpacing();
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t k = 0; k < n; ++k) {
+                particles->addParticle(
+                    targetSpacing * Vector3D(
+                        static_cast<double>(i),
+                        static_cast<double>(j),
+                        static_cast<double>(k)));
+            }
+        }
+    }
+}
+
+template <typename Solver>
+void runForcePerf(const std::string& name, size_t n) {
+    const double timeStep = 1e-4;
+
+    ForceSolver<Solver> solver;
+    addParticleBlock(solver.sphSystemData(), n);
+    solver.onBeginAdvanceTimeStep(timeStep);
+
+    std::string suffix = "/" + std::to_string(n * n * n);
+    runPerf(
+        name + "::accumulateNonPressureForces" + suffix,
+        [&] { solver.accumulateNonPressureForces(timeStep); });
+    runPerf(
+        name + "::accumulatePressureForce" + suffix,
+        [&] { solver.accumulatePressureForce(timeStep); });
+}
+
+}  // namespace
+
+TEST(SphSystemData3, UpdateDensities) {
+    for (size_t n : { 16, 32 }) {
+        SphSystemData3Ptr particles = std::make_shared<SphSystemData3>();
+        addParticleBlock(particles, n);
+        particles->buildNeighborSearcher();
+        particles->buildNeighborLists();
+
+        std::string suffix = "/" + std::to_string(n * n * n);
+        runPerf(
+            "SphSystemData3::buildNeighborLists" + suffix,
+            [&] {
+                particles->buildNeighborSearcher();
+                particles->buildNeighborLists();
+            });
+        runPerf(
+            "SphSystemData3::updateDensities" + suffix,
+            [&] { particles->updateDensities(); });
+    }
+}
+
+TEST(SphSolver3, Forces) {
+    for (size_t n : { 16, 32 }) {
+        runForcePerf<SphSolver3>("SphSolver3", n);
+    }
+}
+
+TEST(PciSphSolver3, PressureIterations) {
+    for (size_t n : { 16, 32 }) {
+        runForcePerf<PciSphSolver3>("PciSphSolver3", n);
+    }
+}
+
+TEST(IisphSolver3, PressureIterations) {
+    for (size_t n : { 16, 32 }) {
+        runForcePerf<IisphSolver3>("IisphSolver3", n);
+    }
+}
+
+TEST(ParticleSystemSolver3, Step) {
+    const size_t n = 1 << 20;
+    ParticleSystemData3::VectorData positions(n);
+    for (size_t i = 0; i < n; ++i) {
+        positions[i] = Vector3D(1e-6 * i, 1.0, 0.0);
+    }
+
+    for (bool isFused : { false, true }) {
+        ParticleSystemSolver3 solver;
+        solver.setIsUsingFusedStep(isFused);
+        solver.particleSystemData()->addParticles(positions.accessor());
+
+        Frame frame(0, 1.0 / 60.0);
+        runPerf(
+            std::string("ParticleSystemSolver3::update")
+                + (isFused ? "/fused/" : "/") + std::to_string(n),
+            [&] {
+                solver.update(frame);
+                frame.advance();
+            });
+    }
+}
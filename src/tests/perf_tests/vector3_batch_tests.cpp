@@ -0,0 +1,100 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <perf_tests.h>
+#include <jet/array1.h>
+#include <jet/parallel.h>
+#include <jet/simd.h>
+#include <jet/vector3_batch.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+using namespace jet;
+
+TEST(Vector3Batch, Normalize) {
+    const size_t n = 1 << 22;
+    Array1<Vector3D> vectors(n);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+    for (size_t i = 0; i < n; ++i) {
+        vectors[i] = Vector3D(d(rng), d(rng), d(rng));
+    }
+
+    // The array-of-structures loop the solvers use
+    Array1<Vector3D> normalized(n);
+    runPerf("Array1<Vector3D>::normalize", [&] {
+        parallelFor(kZeroSize, n, [&](size_t i) {
+            normalized[i] = vectors[i].normalized();
+        });
+    });
+
+    Vector3Batch batch(n);
+    SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    for (SimdInstructionSet instructionSet : {
+             SimdInstructionSet::None,
+             SimdInstructionSet::Sse2,
+             SimdInstructionSet::Neon,
+             SimdInstructionSet::Avx,
+             SimdInstructionSet::Avx512}) {
+        if (!isSimdInstructionSetSupported(instructionSet)) {
+            continue;
+        }
+        setSimdInstructionSet(instructionSet);
+
+        std::string suffix
+            = std::string("/") + simdInstructionSetName(instructionSet);
+        runPerf(
+            "Vector3Batch::normalize" + suffix,
+            [&] { batch.normalize(); },
+            [&] { batch.load(vectors.constAccessor()); });
+    }
+    setSimdInstructionSet(oldInstructionSet);
+}
+
+TEST(Vector3Batch, Transform) {
+    const size_t n = 1 << 22;
+    Array1<Vector3D> vectors(n);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+    for (size_t i = 0; i < n; ++i) {
+        vectors[i] = Vector3D(d(rng), d(rng), d(rng));
+    }
+
+    const Matrix3x3D matrix(
+        0.3, -1.2, 0.5,
+        2.0, 0.1, -0.7,
+        -0.4, 0.9, 1.5);
+    const Vector3D translation(0.25, -3.0, 1.0);
+
+    // The array-of-structures loop the solvers use
+    Array1<Vector3D> transformed(n);
+    runPerf("Array1<Vector3D>::transform", [&] {
+        parallelFor(kZeroSize, n, [&](size_t i) {
+            transformed[i] = matrix.mul(vectors[i]) + translation;
+        });
+    });
+
+    Vector3Batch batch(n);
+    SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    for (SimdInstructionSet instructionSet : {
+             SimdInstructionSet::None,
+             SimdInstructionSet::Sse2,
+             SimdInstructionSet::Neon,
+             SimdInstructionSet::Avx,
+             SimdInstructionSet::Avx512}) {
+        if (!isSimdInstructionSetSupported(instructionSet)) {
+            continue;
+        }
+        setSimdInstructionSet(instructionSet);
+
+        std::string suffix
+            = std::string("/") + simdInstructionSetName(instructionSet);
+        runPerf(
+            "Vector3Batch::transform" + suffix,
+            [&] { batch.transform(matrix, translation); },
+            [&] { batch.load(vectors.constAccessor()); });
+    }
+    setSimdInstructionSet(oldInstructionSet);
+}
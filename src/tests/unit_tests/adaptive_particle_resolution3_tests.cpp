@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/adaptive_particle_resolution3.h>
+#include <jet/custom_scalar_field3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+namespace {
+
+// A block of particles below the surface at z = 1 with a constant layer.
+ParticleSystemData3Ptr createParticles(double spacing, size_t* layerId) {
+    auto particles = std::make_shared<ParticleSystemData3>();
+    particles->setRadius(0.5 * spacing);
+    particles->setMass(1.0);
+
+    for (double z = 0.5 * spacing; z < 1.0; z += spacing) {
+        for (double y = 0.5 * spacing; y < 0.5; y += spacing) {
+            for (double x = 0.5 * spacing; x < 0.5; x += spacing) {
+                particles->addParticle(
+                    Vector3D(x, y, z), Vector3D(x, 2.0 * y, -z));
+            }
+        }
+    }
+
+    *layerId = particles->addScalarData(5.0);
+    return particles;
+}
+
+void computeTotals(
+    const ParticleSystemData3& particles,
+    size_t massId,
+    double* totalMass,
+    Vector3D* totalMomentum) {
+    auto masses = particles.scalarDataAt(massId);
+    auto velocities = particles.velocities();
+    *totalMass = 0.0;
+    *totalMomentum = Vector3D();
+    for (size_t i = 0; i < particles.numberOfParticles(); ++i) {
+        *totalMass += masses[i];
+        *totalMomentum += masses[i] * velocities[i];
+    }
+}
+
+}  // namespace
+
+TEST(AdaptiveParticleResolution3, Constructors) {
+    size_t layerId;
+    auto particles = createParticles(0.1, &layerId);
+    size_t n = particles->numberOfParticles();
+
+    AdaptiveParticleResolution3 adapter(particles);
+    EXPECT_EQ(layerId + 1, adapter.massDataId());
+    EXPECT_EQ(layerId + 2, adapter.radiusDataId());
+    EXPECT_DOUBLE_EQ(0.05, adapter.minRadius());
+    EXPECT_DOUBLE_EQ(0.05, adapter.maxRadius());
+    EXPECT_EQ(nullptr, adapter.surface());
+
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_DOUBLE_EQ(1.0, particles->scalarDataAt(adapter.massDataId())[i]);
+        EXPECT_DOUBLE_EQ(
+            0.05, particles->scalarDataAt(adapter.radiusDataId())[i]);
+    }
+
+    // Without a surface, nothing changes
+    adapter.setMaxRadius(1.0);
+    adapter.update();
+    EXPECT_EQ(n, particles->numberOfParticles());
+    EXPECT_EQ(0u, adapter.lastNumberOfSplits());
+    EXPECT_EQ(0u, adapter.lastNumberOfMerges());
+}
+
+TEST(AdaptiveParticleResolution3, SplitAndMerge) {
+    size_t layerId;
+    auto particles = createParticles(0.05, &layerId);
+    size_t initialNumberOfParticles = particles->numberOfParticles();
+
+    AdaptiveParticleResolution3 adapter(particles);
+    adapter.setMinRadius(0.5 * 0.025);
+    adapter.setMaxRadius(2.0 * 0.025);
+    adapter.setTransitionDistance(0.3);
+    adapter.setSurface(std::make_shared<CustomScalarField3>(
+        [](const Vector3D& x) { return x.z - 1.0; }));
+
+    EXPECT_DOUBLE_EQ(0.0125, adapter.targetRadius(Vector3D(0, 0, 1)));
+    EXPECT_DOUBLE_EQ(0.05, adapter.targetRadius(Vector3D(0, 0, 0.5)));
+
+    double initialMass;
+    Vector3D initialMomentum;
+    computeTotals(
+        *particles, adapter.massDataId(), &initialMass, &initialMomentum);
+
+    size_t numberOfSplits = 0;
+    size_t numberOfMerges = 0;
+    for (int iter = 0; iter < 8; ++iter) {
+        adapter.update();
+        numberOfSplits += adapter.lastNumberOfSplits();
+        numberOfMerges += adapter.lastNumberOfMerges();
+    }
+    EXPECT_LT(0u, numberOfSplits);
+    EXPECT_LT(0u, numberOfMerges);
+
+    double mass;
+    Vector3D momentum;
+    computeTotals(*particles, adapter.massDataId(), &mass, &momentum);
+    EXPECT_NEAR(initialMass, mass, 1e-9 * initialMass);
+    EXPECT_NEAR(0.0, momentum.distanceTo(initialMomentum), 1e-9 * initialMass);
+
+    // Most of the block is deep, so the coarsening wins
+    EXPECT_GT(initialNumberOfParticles, particles->numberOfParticles());
+
+    auto positions = particles->positions();
+    auto masses = particles->scalarDataAt(adapter.massDataId());
+    auto radii = particles->scalarDataAt(adapter.radiusDataId());
+    auto layer = particles->scalarDataAt(layerId);
+    double maxRadiusNearSurface = 0.0;
+    double minRadiusDeep = kMaxD;
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        EXPECT_DOUBLE_EQ(5.0, layer[i]);
+        EXPECT_NEAR(std::cbrt(masses[i]) * 0.025, radii[i], 1e-12);
+        EXPECT_GE(radii[i], adapter.minRadius() * (1.0 - 1e-9));
+        EXPECT_LE(radii[i], adapter.maxRadius() * (1.0 + 1e-9));
+
+        if (positions[i].z > 0.95) {
+            maxRadiusNearSurface = std::max(maxRadiusNearSurface, radii[i]);
+        } else if (positions[i].z < 0.5) {
+            minRadiusDeep = std::min(minRadiusDeep, radii[i]);
+        }
+    }
+    EXPECT_LT(maxRadiusNearSurface, minRadiusDeep);
+}
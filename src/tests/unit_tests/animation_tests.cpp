@@ -1,7 +1,13 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/animation.h>
+#include <jet/physics_animation.h>
 #include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace jet;
 
@@ -40,3 +46,88 @@ TEST(Frame, Advance) {
 
     EXPECT_EQ(79u, frame.index);
 }
+
+namespace {
+
+class CountingPhysicsAnimation : public PhysicsAnimation {
+ public:
+    unsigned int numberOfSteps = 0;
+
+ protected:
+    void onAdvanceTimeStep(double) override {
+        ++numberOfSteps;
+    }
+};
+
+// Keeps two counters that are equal in between the sub-time-steps
+class SlowPhysicsAnimation : public PhysicsAnimation {
+ public:
+    unsigned int a = 0;
+    unsigned int b = 0;
+    unsigned int failingFrame = 0;
+
+ protected:
+    void onAdvanceTimeStep(double) override {
+        ++a;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++b;
+        if (a == failingFrame) {
+            throw std::runtime_error("failed");
+        }
+    }
+};
+
+}  // namespace
+
+TEST(PhysicsAnimation, UpdateAsync) {
+    SlowPhysicsAnimation anim;
+
+    std::shared_future<void> first = anim.updateAsync(Frame(10, 0.1));
+    std::shared_future<void> second = anim.updateAsync(Frame(20, 0.1));
+
+    // The readers see the state in between the updates
+    unsigned int lastFrameIndex = 0;
+    while (second.wait_for(std::chrono::milliseconds(0))
+           != std::future_status::ready) {
+        anim.readState([&] {
+            EXPECT_EQ(anim.a, anim.b);
+            EXPECT_EQ(anim.a, anim.currentFrame().index);
+            EXPECT_LE(lastFrameIndex, anim.currentFrame().index);
+            lastFrameIndex = anim.currentFrame().index;
+        });
+    }
+
+    first.get();
+    second.get();
+    EXPECT_EQ(20u, anim.currentFrame().index);
+    EXPECT_EQ(20u, anim.a);
+
+    // The exceptions are passed to the future
+    anim.failingFrame = 21;
+    EXPECT_THROW(anim.updateAsync(Frame(21, 0.1)).get(), std::runtime_error);
+}
+
+TEST(PhysicsAnimation, FrameCallback) {
+    CountingPhysicsAnimation anim;
+    anim.setNumberOfFixedSubTimeSteps(2);
+
+    std::vector<unsigned int> frameIndices;
+    anim.setFrameCallback([&](const Frame& frame) {
+        EXPECT_EQ(frame.index, anim.currentFrame().index);
+        EXPECT_EQ(frame.index, anim.lastFrameStatistics().frameIndex);
+        EXPECT_DOUBLE_EQ(0.1, frame.timeIntervalInSeconds);
+        EXPECT_EQ(2 * frame.index, anim.numberOfSteps);
+        frameIndices.push_back(frame.index);
+    });
+
+    // Each of the frames advanced by a single update is reported
+    anim.update(Frame(3, 0.1));
+    anim.update(Frame(3, 0.1));
+    anim.update(Frame(4, 0.1));
+    EXPECT_EQ((std::vector<unsigned int>{1, 2, 3, 4}), frameIndices);
+
+    anim.setFrameCallback(PhysicsAnimation::FrameCallback());
+    anim.update(Frame(5, 0.1));
+    EXPECT_EQ(4u, frameIndices.size());
+    EXPECT_EQ(5u, anim.currentFrame().index);
+}
@@ -0,0 +1,14 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/apic_solver2.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(ApicSolver2, UpdateEmpty) {
+    // Empty solver test
+    ApicSolver2 solver;
+    Frame frame;
+    solver.update(frame);
+    solver.update(frame);
+}
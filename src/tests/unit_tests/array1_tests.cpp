@@ -1,8 +1,12 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/array1.h>
+#include <jet/vector3.h>
 #include <gtest/gtest.h>
 #include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 using namespace jet;
 
@@ -57,6 +61,26 @@ TEST(Array1, SetMethods) {
     EXPECT_EQ(-1.f, arr2[3]);
 }
 
+TEST(Array1, MoveMethods) {
+    static_assert(
+        std::is_nothrow_move_constructible<Array1<float>>::value,
+        "Array1 should be nothrow move constructible.");
+
+    Array1<float> arr1 = { 2.f, 5.f, 9.f, -1.f };
+    const float* data = arr1.data();
+
+    Array1<float> arr2(std::move(arr1));
+    EXPECT_EQ(0u, arr1.size());
+    EXPECT_EQ(4u, arr2.size());
+    EXPECT_EQ(data, arr2.data());
+
+    Array1<float> arr3 = { 1.f };
+    arr3 = std::move(arr2);
+    EXPECT_EQ(0u, arr2.size());
+    EXPECT_EQ(data, arr3.data());
+    EXPECT_EQ(9.f, arr3[2]);
+}
+
 TEST(Array1, Clear) {
     Array1<float> arr1 = { 2.f, 5.f, 9.f, -1.f };
     arr1.clear();
@@ -84,6 +108,19 @@ TEST(Array1, ResizeMethod) {
     }
 }
 
+TEST(Array1, Reserve) {
+    Array1<float> arr(3, 1.f);
+    arr.reserve(100);
+    EXPECT_EQ(3u, arr.size());
+    EXPECT_LE(100u, arr.capacity());
+
+    const float* data = arr.data();
+    arr.resize(100, 2.f);
+    EXPECT_EQ(data, arr.data());
+    EXPECT_FLOAT_EQ(1.f, arr[2]);
+    EXPECT_FLOAT_EQ(2.f, arr[3]);
+}
+
 TEST(Array1, Iterators) {
     Array1<float> arr1 = {6.f,  4.f,  1.f,  -5.f};
 
@@ -171,3 +208,45 @@ TEST(Array1, Serialization) {
     arr2.deserialize(&strm2);
     EXPECT_EQ(0u, arr3.size());
 }
+
+TEST(Array1, ParallelInitialization) {
+    // Large enough to be initialized in parallel
+    const size_t n = 100000;
+    Array1<Vector3D> arr1(n, Vector3D(1, 2, 3));
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(Vector3D(1, 2, 3), arr1[i]);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        arr1[i] = Vector3D(static_cast<double>(i), 0, 0);
+    }
+    size_t capacity = arr1.capacity();
+    arr1.resize(n + 1, Vector3D(-1, 0, 0));
+    EXPECT_LE(2 * n, arr1.capacity());
+    EXPECT_LT(capacity, arr1.capacity());
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(static_cast<double>(i), arr1[i].x);
+    }
+    EXPECT_EQ(-1.0, arr1[n].x);
+
+    // Within the capacity
+    arr1.resize(n + 100, Vector3D(-2, 0, 0));
+    EXPECT_EQ(static_cast<double>(n - 1), arr1[n - 1].x);
+    EXPECT_EQ(-1.0, arr1[n].x);
+    EXPECT_EQ(-2.0, arr1[n + 99].x);
+
+    Array1<Vector3D> arr2(arr1);
+    EXPECT_EQ(arr1.size(), arr2.size());
+    for (size_t i = 0; i < arr1.size(); ++i) {
+        EXPECT_EQ(arr1[i], arr2[i]);
+    }
+
+    // Non-trivial types are constructed as usual
+    Array1<std::string> arr3(n, "a");
+    arr3.resize(n + 1, "b");
+    EXPECT_EQ("a", arr3[n - 1]);
+    EXPECT_EQ("b", arr3[n]);
+    Array1<std::string> arr4(arr3);
+    EXPECT_EQ("a", arr4[0]);
+    EXPECT_EQ("b", arr4[n]);
+}
@@ -3,6 +3,8 @@
 #include <jet/array2.h>
 #include <gtest/gtest.h>
 #include <sstream>
+#include <type_traits>
+#include <utility>
 
 using namespace jet;
 
@@ -80,6 +82,30 @@ TEST(Array2, Clear) {
     EXPECT_EQ(0u, arr.height());
 }
 
+TEST(Array2, MoveMethods) {
+    static_assert(
+        std::is_nothrow_move_constructible<Array2<float>>::value,
+        "Array2 should be nothrow move constructible.");
+
+    Array2<float> arr1(
+        {{1.f,  2.f,  3.f,  4.f},
+         {5.f,  6.f,  7.f,  8.f},
+         {9.f, 10.f, 11.f, 12.f}});
+    const float* data = arr1.data();
+
+    Array2<float> arr2(std::move(arr1));
+    EXPECT_EQ(Size2(0, 0), arr1.size());
+    EXPECT_EQ(Size2(4, 3), arr2.size());
+    EXPECT_EQ(data, arr2.data());
+
+    Array2<float> arr3(2, 2, 1.f);
+    arr3 = std::move(arr2);
+    EXPECT_EQ(Size2(0, 0), arr2.size());
+    EXPECT_EQ(Size2(4, 3), arr3.size());
+    EXPECT_EQ(data, arr3.data());
+    EXPECT_EQ(7.f, arr3(2, 1));
+}
+
 TEST(Array2, ResizeMethod) {
     {
         Array2<float> arr;
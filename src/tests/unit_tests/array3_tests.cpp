@@ -2,7 +2,12 @@
 
 #include <jet/array3.h>
 #include <gtest/gtest.h>
+#include <cstdint>
 #include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using namespace jet;
 
@@ -100,6 +105,34 @@ TEST(Array3, Clear) {
     EXPECT_EQ(0u, arr.depth());
 }
 
+TEST(Array3, MoveMethods) {
+    static_assert(
+        std::is_nothrow_move_constructible<Array3<float>>::value,
+        "Array3 should be nothrow move constructible.");
+
+    Array3<float> arr1(4, 3, 2, 1.5f);
+    arr1(3, 2, 1) = 2.5f;
+    const float* data = arr1.data();
+
+    Array3<float> arr2(std::move(arr1));
+    EXPECT_EQ(Size3(0, 0, 0), arr1.size());
+    EXPECT_EQ(Size3(4, 3, 2), arr2.size());
+    EXPECT_EQ(data, arr2.data());
+
+    Array3<float> arr3(2, 2, 2, 1.f);
+    arr3 = std::move(arr2);
+    EXPECT_EQ(Size3(0, 0, 0), arr2.size());
+    EXPECT_EQ(Size3(4, 3, 2), arr3.size());
+    EXPECT_EQ(data, arr3.data());
+    EXPECT_EQ(2.5f, arr3(3, 2, 1));
+
+    // Relocating a vector of arrays moves the buffers
+    std::vector<Array3<float>> arrays;
+    arrays.push_back(std::move(arr3));
+    arrays.reserve(arrays.capacity() + 1);
+    EXPECT_EQ(data, arrays[0].data());
+}
+
 TEST(Array3, ResizeMethod) {
     {
         Array3<float> arr;
@@ -153,6 +186,16 @@ TEST(Array3, ResizeMethod) {
             }
         }
     }
+    {
+        // Resizing to the same size keeps the buffer and the values
+        Array3<float> arr(Size3(4, 3, 2), 5.f);
+        const float* data = arr.data();
+        arr.resize(Size3(4, 3, 2), 1.f);
+        EXPECT_EQ(data, arr.data());
+        for (size_t i = 0; i < 24; ++i) {
+            EXPECT_FLOAT_EQ(5.f, arr[i]);
+        }
+    }
 }
 
 TEST(Array3, Iterators) {
@@ -243,6 +286,42 @@ TEST(Array3, ParallelForEachIndex) {
     });
 }
 
+TEST(Array3, Rows) {
+    Array3<float> arr1(
+        {{{ 1.f,  2.f,  3.f,  4.f},
+          { 5.f,  6.f,  7.f,  8.f},
+          { 9.f, 10.f, 11.f, 12.f}},
+         {{13.f, 14.f, 15.f, 16.f},
+          {17.f, 18.f, 19.f, 20.f},
+          {21.f, 22.f, 23.f, 24.f}}});
+    const Array3<float>& constArr1 = arr1;
+
+    EXPECT_EQ(4u, arr1.rowStride());
+    EXPECT_EQ(12u, arr1.sliceStride());
+    EXPECT_EQ(&arr1(0, 1, 1), arr1.row(1, 1));
+    EXPECT_EQ(arr1.row(2, 0), constArr1.row(2, 0));
+    EXPECT_EQ(&arr1(0, 0, 1), arr1.slice(1));
+    EXPECT_EQ(arr1.slice(1), constArr1.slice(1));
+
+    size_t numberOfRows = 0;
+    arr1.forEachRow([&](size_t j, size_t k) {
+        EXPECT_EQ(numberOfRows, j + 3 * k);
+        ++numberOfRows;
+    });
+    EXPECT_EQ(6u, numberOfRows);
+
+    arr1.parallelForEachRow([&](size_t j, size_t k) {
+        float* row = arr1.row(j, k);
+        for (size_t i = 0; i < arr1.width(); ++i) {
+            row[i] += 1.f;
+        }
+    });
+    arr1.forEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t idx = i + (4 * (j + 3 * k)) + 2;
+        EXPECT_FLOAT_EQ(static_cast<float>(idx), arr1(i, j, k));
+    });
+}
+
 TEST(Array3, Serialization) {
     Array3<float> arr1(
         {{{ 1.f,  2.f,  3.f,  4.f},
@@ -277,3 +356,86 @@ TEST(Array3, Serialization) {
     EXPECT_EQ(0u, arr2.height());
     EXPECT_EQ(0u, arr2.depth());
 }
+
+TEST(Array3, ParallelInitialization) {
+    // Large enough to be initialized in parallel
+    Array3<double> arr1(Size3(30, 40, 50), 2.0);
+    arr1.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(2.0, arr1(i, j, k));
+        arr1(i, j, k) = static_cast<double>(i + 30 * (j + 40 * k));
+    });
+
+    arr1.resize(Size3(35, 20, 60), -1.0);
+    arr1.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (i < 30 && k < 50) {
+            EXPECT_EQ(
+                static_cast<double>(i + 30 * (j + 40 * k)), arr1(i, j, k));
+        } else {
+            EXPECT_EQ(-1.0, arr1(i, j, k));
+        }
+    });
+
+    Array3<double> arr2(arr1);
+    EXPECT_EQ(arr1.size(), arr2.size());
+    arr1.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(arr1(i, j, k), arr2(i, j, k));
+    });
+}
+
+TEST(Array3, Alignment) {
+    for (size_t n : {1, 3, 17, 100}) {
+        Array3<double> arr(n, 2, 3);
+        EXPECT_EQ(
+            0u, reinterpret_cast<uintptr_t>(arr.data()) % kArrayAlignment);
+
+        Array3<char> chars(n, 1, 1);
+        EXPECT_EQ(
+            0u, reinterpret_cast<uintptr_t>(chars.data()) % kArrayAlignment);
+
+        arr.resize(n + 50, 2, 3);
+        EXPECT_EQ(
+            0u, reinterpret_cast<uintptr_t>(arr.data()) % kArrayAlignment);
+    }
+}
+
+TEST(Array3, HugePagePolicy) {
+    EXPECT_EQ(ArrayHugePagePolicy::None, arrayHugePagePolicy());
+    EXPECT_TRUE(isArrayHugePagePolicySupported(ArrayHugePagePolicy::None));
+
+    size_t minBytes = arrayHugePageMinBytes();
+    setArrayHugePageMinBytes(1 << 20);
+
+    for (ArrayHugePagePolicy policy : {
+             ArrayHugePagePolicy::None,
+             ArrayHugePagePolicy::Transparent,
+             ArrayHugePagePolicy::Explicit}) {
+        if (!isArrayHugePagePolicySupported(policy)) {
+            EXPECT_THROW(
+                setArrayHugePagePolicy(policy), std::invalid_argument);
+            continue;
+        }
+        setArrayHugePagePolicy(policy);
+
+        size_t bytesBefore = MemoryTracker::bytes(MemoryTag::Grid);
+        {
+            MemoryTagScope scope(MemoryTag::Grid);
+            Array3<double> small(4, 4, 4, 1.0);
+            Array3<double> large(64, 64, 64, 2.0);
+            EXPECT_EQ(
+                0u,
+                reinterpret_cast<uintptr_t>(large.data()) % kArrayAlignment);
+            EXPECT_EQ(
+                bytesBefore + (64 + 64 * 64 * 64) * sizeof(double),
+                MemoryTracker::bytes(MemoryTag::Grid));
+
+            large.resize(100, 64, 64, 3.0);
+            EXPECT_EQ(2.0, large(63, 63, 63));
+            EXPECT_EQ(3.0, large(99, 63, 63));
+            EXPECT_EQ(1.0, small(3, 3, 3));
+        }
+        EXPECT_EQ(bytesBefore, MemoryTracker::bytes(MemoryTag::Grid));
+    }
+
+    setArrayHugePagePolicy(ArrayHugePagePolicy::None);
+    setArrayHugePageMinBytes(minBytes);
+}
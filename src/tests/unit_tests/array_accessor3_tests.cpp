@@ -3,6 +3,7 @@
 #include <jet/array_accessor3.h>
 #include <jet/array3.h>
 #include <gtest/gtest.h>
+#include <vector>
 
 using namespace jet;
 
@@ -113,6 +114,54 @@ TEST(ArrayAccessor3, ParallelForEachIndex) {
     });
 }
 
+TEST(ArrayAccessor3, Rows) {
+    Array3<float> arr1(
+        {{{ 1.f,  2.f,  3.f,  4.f},
+          { 5.f,  6.f,  7.f,  8.f},
+          { 9.f, 10.f, 11.f, 12.f}},
+         {{13.f, 14.f, 15.f, 16.f},
+          {17.f, 18.f, 19.f, 20.f},
+          {21.f, 22.f, 23.f, 24.f}}});
+    auto acc = arr1.accessor();
+
+    EXPECT_EQ(4u, acc.rowStride());
+    EXPECT_EQ(12u, acc.sliceStride());
+    EXPECT_EQ(&acc(0, 2, 1), acc.row(2, 1));
+    EXPECT_EQ(&acc(0, 0, 1), acc.slice(1));
+
+    std::vector<size_t> rows;
+    acc.forEachRow([&](size_t j, size_t k) {
+        rows.push_back(j + 3 * k);
+    });
+    ASSERT_EQ(6u, rows.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        EXPECT_EQ(r, rows[r]);
+    }
+
+    acc.parallelForEachRow([&](size_t j, size_t k) {
+        float* row = acc.row(j, k);
+        for (size_t i = 0; i < acc.width(); ++i) {
+            row[i] *= 2.f;
+        }
+    });
+    acc.forEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t idx = i + (4 * (j + 3 * k)) + 1;
+        EXPECT_FLOAT_EQ(2.f * idx, acc(i, j, k));
+    });
+
+    ConstArrayAccessor3<float> cacc(acc);
+    EXPECT_EQ(4u, cacc.rowStride());
+    EXPECT_EQ(12u, cacc.sliceStride());
+    EXPECT_EQ(acc.row(1, 1), cacc.row(1, 1));
+    EXPECT_EQ(acc.slice(1), cacc.slice(1));
+    cacc.parallelForEachRow([&](size_t j, size_t k) {
+        const float* row = cacc.row(j, k);
+        for (size_t i = 0; i < cacc.width(); ++i) {
+            EXPECT_EQ(&cacc(i, j, k), row + i);
+        }
+    });
+}
+
 
 TEST(ConstArrayAccessor3, Constructors) {
     double data[60];
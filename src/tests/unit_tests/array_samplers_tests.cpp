@@ -7,6 +7,8 @@
 #include <jet/array_samplers2.h>
 #include <jet/array_samplers3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace jet;
 
@@ -155,6 +157,31 @@ TEST(LinearArraySampler2, Sample) {
     }
 }
 
+TEST(LinearArraySampler2, GetCoordinatesAndGradientWeights) {
+    Array2<double> grid(
+        {{ 1.0, 2.0, 3.0, 4.0 },
+         { 2.0, 3.0, 4.0, 5.0 },
+         { 3.0, 4.0, 5.0, 6.0 },
+         { 4.0, 5.0, 6.0, 7.0 },
+         { 5.0, 6.0, 7.0, 8.0 }});
+    Vector2D gridSpacing(0.5, 0.25), gridOrigin(-1.0, -0.5);
+    LinearArraySampler2<double, double> sampler(
+        grid.constAccessor(), gridSpacing, gridOrigin);
+
+    std::array<Point2UI, 4> indices;
+    std::array<Vector2D, 4> weights;
+    sampler.getCoordinatesAndGradientWeights(
+        Vector2D(-0.3, 0.1), &indices, &weights);
+
+    Vector2D gradient;
+    for (int i = 0; i < 4; ++i) {
+        gradient += weights[i] * grid(indices[i]);
+    }
+
+    EXPECT_NEAR(2.0, gradient.x, 1e-9);
+    EXPECT_NEAR(4.0, gradient.y, 1e-9);
+}
+
 TEST(CubicArraySampler2, Sample) {
     Array2<double> grid(
         {{ 1.0, 2.0, 3.0, 4.0 },
@@ -189,3 +216,144 @@ TEST(CubicArraySampler3, Sample) {
     EXPECT_LT(3.0, s0);
     EXPECT_GT(6.0, s0);
 }
+
+TEST(CubicArraySampler3, NonMonotonic) {
+    Array3<double> grid(5, 6, 7);
+    for (size_t k = 0; k < 7; ++k) {
+        for (size_t j = 0; j < 6; ++j) {
+            for (size_t i = 0; i < 5; ++i) {
+                grid(i, j, k) = std::sin(1.0 + i + 2.0 * j * j - 0.7 * k);
+            }
+        }
+    }
+
+    Vector3D gridSpacing(1.0, 0.5, 0.25), gridOrigin(0.5, -0.5, 0.0);
+    CubicArraySampler3<double, double> sampler(
+        grid.constAccessor(), gridSpacing, gridOrigin, false);
+    EXPECT_FALSE(sampler.isMonotonic());
+
+    // Nested Catmull-Rom splines with the same clamped taps
+    auto clampIndex = [](ssize_t i, ssize_t n) {
+        return static_cast<size_t>(std::max(std::min(i, n - 1), kZeroSSize));
+    };
+    auto reference = [&](const Vector3D& x) {
+        Vector3D y = (x - gridOrigin) / gridSpacing;
+        ssize_t i, j, k;
+        double fx, fy, fz;
+        getBarycentric(y.x, 0, 5, &i, &fx);
+        getBarycentric(y.y, 0, 6, &j, &fy);
+        getBarycentric(y.z, 0, 7, &k, &fz);
+
+        double kValues[4];
+        for (ssize_t kk = 0; kk < 4; ++kk) {
+            double jValues[4];
+            for (ssize_t jj = 0; jj < 4; ++jj) {
+                size_t jc = clampIndex(j + jj - 1, 6);
+                size_t kc = clampIndex(k + kk - 1, 7);
+                jValues[jj] = catmullRom(
+                    grid(clampIndex(i - 1, 5), jc, kc),
+                    grid(clampIndex(i, 5), jc, kc),
+                    grid(clampIndex(i + 1, 5), jc, kc),
+                    grid(clampIndex(i + 2, 5), jc, kc),
+                    fx);
+            }
+            kValues[kk] = catmullRom(
+                jValues[0], jValues[1], jValues[2], jValues[3], fy);
+        }
+        return catmullRom(kValues[0], kValues[1], kValues[2], kValues[3], fz);
+    };
+
+    for (const Vector3D& x : {
+            Vector3D(1.7, 0.3, 0.9),
+            Vector3D(0.5, -0.5, 0.0),
+            Vector3D(4.9, 2.1, 1.3),
+            Vector3D(-1.0, 9.0, 0.6) }) {
+        EXPECT_NEAR(reference(x), sampler(x), 1e-12);
+    }
+}
+
+TEST(CubicArraySampler3, SharedStencil) {
+    Array3<double> scalars(6, 5, 4);
+    Array3<Vector3D> vectors(6, 5, 4);
+    scalars.forEachIndex([&](size_t i, size_t j, size_t k) {
+        scalars(i, j, k) = std::cos(0.3 * i * j + k);
+        vectors(i, j, k) = Vector3D(i * 0.5, j * k, std::sin(1.0 * i));
+    });
+
+    Vector3D gridSpacing(0.5, 0.5, 1.0), gridOrigin(0.0, 1.0, -1.0);
+    for (bool isMonotonic : { true, false }) {
+        CubicArraySampler3<double, double> scalarSampler(
+            scalars.constAccessor(), gridSpacing, gridOrigin, isMonotonic);
+        CubicArraySampler3<Vector3D, double> vectorSampler(
+            vectors.constAccessor(), gridSpacing, gridOrigin, isMonotonic);
+
+        Vector3D x(1.3, 2.1, 0.4);
+        CubicSamplerStencil3<double> stencil;
+        scalarSampler.getStencil(x, &stencil);
+
+        EXPECT_DOUBLE_EQ(scalarSampler(x), scalarSampler.sample(stencil));
+        Vector3D v = vectorSampler.sample(stencil);
+        EXPECT_DOUBLE_EQ(vectorSampler(x).x, v.x);
+        EXPECT_DOUBLE_EQ(vectorSampler(x).y, v.y);
+        EXPECT_DOUBLE_EQ(vectorSampler(x).z, v.z);
+    }
+}
+
+TEST(LinearArraySampler3, GetCoordinatesAndGradientWeights) {
+    Array3<double> grid(4, 4, 4);
+    for (size_t k = 0; k < 4; ++k) {
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t i = 0; i < 4; ++i) {
+                grid(i, j, k) = static_cast<double>(1 + i + 2 * j + 3 * k);
+            }
+        }
+    }
+
+    Vector3D gridSpacing(1.0, 0.5, 0.25), gridOrigin;
+    LinearArraySampler3<double, double> sampler(
+        grid.constAccessor(), gridSpacing, gridOrigin);
+
+    std::array<Point3UI, 8> indices;
+    std::array<Vector3D, 8> weights;
+    sampler.getCoordinatesAndGradientWeights(
+        Vector3D(1.5, 0.8, 0.3), &indices, &weights);
+
+    Vector3D gradient;
+    for (int i = 0; i < 8; ++i) {
+        gradient += weights[i] * grid(indices[i]);
+    }
+
+    EXPECT_NEAR(1.0, gradient.x, 1e-9);
+    EXPECT_NEAR(4.0, gradient.y, 1e-9);
+    EXPECT_NEAR(12.0, gradient.z, 1e-9);
+}
+
+TEST(LinearArraySampler3, SharedStencil) {
+    Array3<double> scalars(6, 5, 4);
+    Array3<Vector3D> vectors(6, 5, 4);
+    scalars.forEachIndex([&](size_t i, size_t j, size_t k) {
+        scalars(i, j, k) = std::cos(0.3 * i * j + k);
+        vectors(i, j, k) = Vector3D(i * 0.5, j * k, std::sin(1.0 * i));
+    });
+
+    Vector3D gridSpacing(0.5, 0.5, 1.0), gridOrigin(0.0, 1.0, -1.0);
+    LinearArraySampler3<double, double> scalarSampler(
+        scalars.constAccessor(), gridSpacing, gridOrigin);
+    LinearArraySampler3<Vector3D, double> vectorSampler(
+        vectors.constAccessor(), gridSpacing, gridOrigin);
+
+    // Inside, and clamped on the lower and the upper sides
+    for (const Vector3D& x : {
+            Vector3D(1.3, 2.1, 0.4),
+            Vector3D(-1.0, 0.2, -3.0),
+            Vector3D(9.0, 9.0, 9.0) }) {
+        LinearSamplerStencil3<double> stencil;
+        scalarSampler.getStencil(x, &stencil);
+
+        EXPECT_EQ(scalarSampler(x), scalarSampler.sample(stencil));
+        Vector3D v = vectorSampler.sample(stencil);
+        EXPECT_EQ(vectorSampler(x).x, v.x);
+        EXPECT_EQ(vectorSampler(x).y, v.y);
+        EXPECT_EQ(vectorSampler(x).z, v.z);
+    }
+}
@@ -5,6 +5,9 @@
 #include <jet/array3.h>
 #include <jet/array_utils.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
 #include <sstream>
 #include <string>
 
@@ -91,6 +94,27 @@ TEST(ArrayUtils, CopyRange3) {
     }
 }
 
+TEST(ArrayUtils, ShiftRange3) {
+    Array3<double> array(4, 3, 2);
+    array.forEachIndex([&](size_t i, size_t j, size_t k) {
+        array(i, j, k) = static_cast<double>(i + 10 * j + 100 * k);
+    });
+
+    // The fresh cells take the values at the boundary they enter through
+    shiftRange3(Point3I(1, -1, 0), array.accessor());
+    array.forEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t si = std::min(i + 1, size_t(3));
+        size_t sj = (j == 0) ? 0 : j - 1;
+        EXPECT_EQ(static_cast<double>(si + 10 * sj + 100 * k), array(i, j, k));
+    });
+
+    Array3<double> copy(array);
+    shiftRange3(Point3I(), array.accessor());
+    array.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(copy(i, j, k), array(i, j, k));
+    });
+}
+
 TEST(ArrayUtils, ExtrapolateToRegion2) {
     Array2<double> data(10, 12, 0.0);
     Array2<char> valid(10, 12, 0);
@@ -154,6 +178,154 @@ TEST(ArrayUtils, ExtrapolateToRegion3) {
     }
 }
 
+namespace {
+
+// Extrapolates with a sweep over the whole array per iteration
+Array3<double> extrapolateBySweeping(
+    const Array3<double>& data,
+    const Array3<char>& valid,
+    unsigned int iterations) {
+    Array3<double> expected(data);
+    Array3<char> valid0(valid);
+    const Size3 size = data.size();
+    for (unsigned int iter = 0; iter < iterations; ++iter) {
+        Array3<char> valid1(valid0);
+        expected.forEachIndex([&](size_t i, size_t j, size_t k) {
+            if (valid0(i, j, k)) {
+                return;
+            }
+
+            double sum = 0.0;
+            unsigned int count = 0;
+            if (i + 1 < size.x && valid0(i + 1, j, k)) {
+                sum += expected(i + 1, j, k);
+                ++count;
+            }
+            if (i > 0 && valid0(i - 1, j, k)) {
+                sum += expected(i - 1, j, k);
+                ++count;
+            }
+            if (j + 1 < size.y && valid0(i, j + 1, k)) {
+                sum += expected(i, j + 1, k);
+                ++count;
+            }
+            if (j > 0 && valid0(i, j - 1, k)) {
+                sum += expected(i, j - 1, k);
+                ++count;
+            }
+            if (k + 1 < size.z && valid0(i, j, k + 1)) {
+                sum += expected(i, j, k + 1);
+                ++count;
+            }
+            if (k > 0 && valid0(i, j, k - 1)) {
+                sum += expected(i, j, k - 1);
+                ++count;
+            }
+            if (count > 0) {
+                expected(i, j, k) = sum / count;
+                valid1(i, j, k) = 1;
+            }
+        });
+        valid0 = valid1;
+    }
+    return expected;
+}
+
+}  // namespace
+
+TEST(ArrayUtils, ExtrapolateToRegion3WithBuffers) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+    ExtrapolationBuffers3 buffers;
+
+    for (const Size3& size :
+         {Size3(7, 5, 6), Size3(4, 9, 3), Size3(130, 3, 2)}) {
+        Array3<double> data(size);
+        Array3<char> valid(size, 0);
+        data.forEachIndex([&](size_t i, size_t j, size_t k) {
+            data(i, j, k) = d(rng);
+            valid(i, j, k) = d(rng) > 0.8;
+        });
+
+        for (unsigned int iterations : {0u, 1u, 2u, 5u}) {
+            Array3<double> expected
+                = extrapolateBySweeping(data, valid, iterations);
+
+            Array3<double> output(size);
+            extrapolateToRegion(
+                data.constAccessor(),
+                valid.constAccessor(),
+                iterations,
+                output.accessor(),
+                &buffers);
+
+            output.forEachIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_DOUBLE_EQ(expected(i, j, k), output(i, j, k));
+            });
+
+            BitArray3 validBits;
+            validBits.set(valid.constAccessor());
+            output.set(0.0);
+            extrapolateToRegion(
+                data.constAccessor(),
+                validBits,
+                iterations,
+                output.accessor(),
+                &buffers);
+
+            output.forEachIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_DOUBLE_EQ(expected(i, j, k), output(i, j, k));
+            });
+
+            // In place, as the solvers do
+            output.set(data);
+            extrapolateToRegion(
+                output.constAccessor(),
+                validBits,
+                iterations,
+                output.accessor(),
+                &buffers);
+
+            output.forEachIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_DOUBLE_EQ(expected(i, j, k), output(i, j, k));
+            });
+        }
+    }
+}
+
+TEST(ArrayUtils, ExtrapolateToRegion3NarrowBand) {
+    // A few valid points in a large array, so that the front only covers a
+    // few rows, and a band that reaches the array boundary
+    ExtrapolationBuffers3 buffers;
+    Array3<double> data(Size3(70, 21, 17));
+    Array3<char> valid(data.size(), 0);
+    data.forEachIndex([&](size_t i, size_t j, size_t k) {
+        data(i, j, k) = std::sin(0.3 * i + 0.7 * j - 0.2 * k);
+    });
+    valid(63, 10, 8) = 1;
+    valid(2, 1, 15) = 1;
+    valid(30, 20, 0) = 1;
+
+    for (unsigned int iterations : {1u, 3u, 8u, 100u}) {
+        Array3<double> expected
+            = extrapolateBySweeping(data, valid, iterations);
+
+        Array3<double> output(data);
+        BitArray3 validBits;
+        validBits.set(valid.constAccessor());
+        extrapolateToRegion(
+            output.constAccessor(),
+            validBits,
+            iterations,
+            output.accessor(),
+            &buffers);
+
+        output.forEachIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_DOUBLE_EQ(expected(i, j, k), output(i, j, k));
+        });
+    }
+}
+
 TEST(ArrayUtils, converToCsv) {
     Array2<double> array = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
     std::stringstream strm;
@@ -0,0 +1,111 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/async_file_writer.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+std::string readFile(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ifstream::binary);
+    return std::string(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(AsyncFileWriter, Write) {
+    std::vector<std::string> filenames;
+    {
+        AsyncFileWriter writer;
+        EXPECT_EQ(2u, writer.maxNumberOfPendingWrites());
+
+        for (int i = 0; i < 5; ++i) {
+            std::string filename
+                = "async_file_writer_tests_write_" + std::to_string(i);
+            filenames.push_back(filename);
+
+            // The snapshot is owned by the write function
+            auto snapshot = std::make_shared<std::vector<char>>(1000, 'a' + i);
+            writer.write(filename, [snapshot](std::ostream* strm) {
+                strm->write(snapshot->data(), snapshot->size());
+            });
+            EXPECT_GE(2u, writer.numberOfPendingWrites());
+        }
+
+        writer.flush();
+        EXPECT_EQ(0u, writer.numberOfPendingWrites());
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_EQ(std::string(1000, 'a' + i), readFile(filenames[i]));
+        }
+
+        // Pending writes finish before the writer is destroyed
+        writer.write(filenames[0], [](std::ostream* strm) {
+            (*strm) << "last";
+        });
+    }
+    EXPECT_EQ("last", readFile(filenames[0]));
+
+    for (const auto& filename : filenames) {
+        std::remove(filename.c_str());
+    }
+}
+
+TEST(AsyncFileWriter, BoundedQueue) {
+    const std::string filename = "async_file_writer_tests_bounded_queue";
+
+    std::atomic<int> numberOfRunningWrites(0);
+    std::atomic<int> maxNumberOfRunningWrites(0);
+    std::atomic<int> numberOfFinishedWrites(0);
+    AsyncFileWriter writer(1);
+    for (int i = 0; i < 4; ++i) {
+        writer.write(filename, [&, i](std::ostream* strm) {
+            int running = ++numberOfRunningWrites;
+            if (running > maxNumberOfRunningWrites) {
+                maxNumberOfRunningWrites = running;
+            }
+            (*strm) << i;
+            --numberOfRunningWrites;
+            ++numberOfFinishedWrites;
+        });
+
+        // With a single slot, the previous writes have finished by now
+        EXPECT_LE(i, numberOfFinishedWrites.load());
+    }
+    writer.flush();
+    EXPECT_EQ(4, numberOfFinishedWrites.load());
+    EXPECT_EQ(1, maxNumberOfRunningWrites.load());
+
+    EXPECT_THROW(AsyncFileWriter(0), std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
+
+TEST(AsyncFileWriter, Exception) {
+    const std::string filename = "async_file_writer_tests_exception";
+
+    AsyncFileWriter writer;
+    writer.write(filename, [](std::ostream*) {
+        throw std::runtime_error("write failed");
+    });
+    writer.write(filename, [](std::ostream* strm) {
+        (*strm) << "ok";
+    });
+    EXPECT_THROW(writer.flush(), std::runtime_error);
+
+    // The exception is reported once, and the later writes still ran
+    EXPECT_NO_THROW(writer.flush());
+    EXPECT_EQ("ok", readFile(filename));
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array3.h>
+#include <jet/bit_array3.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace jet;
+
+TEST(BitArray3, Constructors) {
+    BitArray3 arr0;
+    EXPECT_EQ(Size3(0, 0, 0), arr0.size());
+    EXPECT_EQ(0u, arr0.wordsPerRow());
+    EXPECT_EQ(0u, arr0.count());
+
+    BitArray3 arr1(Size3(70, 3, 2), true);
+    EXPECT_EQ(Size3(70, 3, 2), arr1.size());
+    EXPECT_EQ(2u, arr1.wordsPerRow());
+    EXPECT_EQ(70u * 3u * 2u, arr1.count());
+    EXPECT_TRUE(arr1(69, 2, 1));
+
+    // The bits past the width are not set
+    EXPECT_EQ((BitArray3::Word(1) << 6) - 1, arr1.row(2, 1)[1]);
+}
+
+TEST(BitArray3, SetAndGet) {
+    BitArray3 arr(Size3(130, 4, 3));
+    arr.set(0, 0, 0, true);
+    arr.set(64, 1, 2, true);
+    arr.set(129, 3, 2, true);
+    arr.set(63, 2, 1, true);
+    arr.set(63, 2, 1, false);
+
+    EXPECT_TRUE(arr(0, 0, 0));
+    EXPECT_TRUE(arr(64, 1, 2));
+    EXPECT_TRUE(arr(129, 3, 2));
+    EXPECT_FALSE(arr(63, 2, 1));
+    EXPECT_FALSE(arr(65, 1, 2));
+    EXPECT_EQ(3u, arr.count());
+
+    std::vector<Size3> indices;
+    arr.forEachSetIndex([&](size_t i, size_t j, size_t k) {
+        indices.push_back(Size3(i, j, k));
+    });
+    ASSERT_EQ(3u, indices.size());
+    EXPECT_EQ(Size3(0, 0, 0), indices[0]);
+    EXPECT_EQ(Size3(64, 1, 2), indices[1]);
+    EXPECT_EQ(Size3(129, 3, 2), indices[2]);
+
+    arr.set(true);
+    EXPECT_EQ(130u * 4u * 3u, arr.count());
+    arr.set(false);
+    EXPECT_EQ(0u, arr.count());
+}
+
+TEST(BitArray3, SetFromMask) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<> d(0, 3);
+
+    Array3<char> mask(Size3(67, 5, 4));
+    mask.forEachIndex([&](size_t i, size_t j, size_t k) {
+        mask(i, j, k) = static_cast<char>(d(rng) == 0 ? 1 : 0);
+    });
+
+    BitArray3 arr;
+    arr.set(mask.constAccessor());
+    EXPECT_EQ(mask.size(), arr.size());
+
+    size_t count = 0;
+    mask.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(mask(i, j, k) != 0, arr(i, j, k));
+        count += mask(i, j, k) != 0;
+    });
+    EXPECT_EQ(count, arr.count());
+
+    BitArray3 arr2(mask.size());
+    arr2.parallelSet([&](size_t i, size_t j, size_t k) {
+        return mask(i, j, k) != 0;
+    });
+
+    std::vector<char> visited(mask.size().x * mask.size().y * mask.size().z);
+    arr2.parallelForEachSetIndex([&](size_t i, size_t j, size_t k) {
+        visited[i + mask.size().x * (j + mask.size().y * k)] = 1;
+    });
+    mask.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(mask(i, j, k), visited[
+            i + mask.size().x * (j + mask.size().y * k)]);
+    });
+}
+
+TEST(BitArray3, Dilate) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<> d(0, 15);
+
+    for (const Size3& size : {Size3(5, 4, 3), Size3(64, 3, 3),
+                              Size3(129, 4, 2)}) {
+        BitArray3 arr(size);
+        for (size_t k = 0; k < size.z; ++k) {
+            for (size_t j = 0; j < size.y; ++j) {
+                for (size_t i = 0; i < size.x; ++i) {
+                    arr.set(i, j, k, d(rng) == 0);
+                }
+            }
+        }
+        arr.set(63 % size.x, 0, 0, true);
+        arr.set(size.x - 1, size.y - 1, size.z - 1, true);
+
+        BitArray3 dilated;
+        arr.dilate(&dilated);
+        EXPECT_EQ(size, dilated.size());
+
+        for (size_t k = 0; k < size.z; ++k) {
+            for (size_t j = 0; j < size.y; ++j) {
+                for (size_t i = 0; i < size.x; ++i) {
+                    bool expected = arr(i, j, k)
+                        || (i > 0 && arr(i - 1, j, k))
+                        || (i + 1 < size.x && arr(i + 1, j, k))
+                        || (j > 0 && arr(i, j - 1, k))
+                        || (j + 1 < size.y && arr(i, j + 1, k))
+                        || (k > 0 && arr(i, j, k - 1))
+                        || (k + 1 < size.z && arr(i, j, k + 1));
+                    EXPECT_EQ(expected, dilated(i, j, k));
+                }
+            }
+        }
+
+        // Bits past the width stay clear
+        size_t lastBits = size.x % BitArray3::kBitsPerWord;
+        if (lastBits != 0) {
+            for (size_t k = 0; k < size.z; ++k) {
+                for (size_t j = 0; j < size.y; ++j) {
+                    BitArray3::Word last
+                        = dilated.row(j, k)[dilated.wordsPerRow() - 1];
+                    EXPECT_EQ(0u, last >> lastBits);
+                }
+            }
+        }
+    }
+}
+
+TEST(BitArray3, SetOperations) {
+    Size3 size(70, 2, 2);
+    BitArray3 a(size);
+    BitArray3 b(size);
+    a.set(1, 0, 0, true);
+    a.set(65, 1, 1, true);
+    b.set(65, 1, 1, true);
+    b.set(3, 1, 0, true);
+
+    BitArray3 c(a);
+    c |= b;
+    EXPECT_EQ(3u, c.count());
+    EXPECT_TRUE(c(3, 1, 0));
+
+    c = a;
+    c &= b;
+    EXPECT_EQ(1u, c.count());
+    EXPECT_TRUE(c(65, 1, 1));
+
+    c = a;
+    c.andNot(b);
+    EXPECT_EQ(1u, c.count());
+    EXPECT_TRUE(c(1, 0, 0));
+
+    c.swap(b);
+    EXPECT_TRUE(c(3, 1, 0));
+    EXPECT_TRUE(b(1, 0, 0));
+}
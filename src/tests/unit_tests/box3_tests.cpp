@@ -1,6 +1,9 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array1.h>
 #include <jet/box3.h>
+#include <jet/simd.h>
+#include <jet/surface_to_implicit3.h>
 #include <gtest/gtest.h>
 
 using namespace jet;
@@ -169,3 +172,54 @@ TEST(Box3, ClosestNormal) {
     Vector3D result5 = box.closestNormal(Vector3D(4, 2, 9));
     EXPECT_EQ(Vector3D(0, 0, -1), result5);
 }
+
+TEST(Box3, BatchClosestSignedDistance) {
+    auto box = std::make_shared<Box3>(
+        Vector3D(-1.1, -0.5, -1.3), Vector3D(0.9, 1.5, 2.1));
+    SurfaceToImplicit3 s2i(box);
+
+    Array1<Vector3D> points;
+    for (int k = -6; k <= 6; ++k) {
+        for (int j = -6; j <= 6; ++j) {
+            for (int i = -6; i <= 6; ++i) {
+                points.append(Vector3D(0.4 * i, 0.45 * j, 0.5 * k));
+            }
+        }
+    }
+
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    const SimdInstructionSet instructionSets[] = {
+        SimdInstructionSet::None,
+        SimdInstructionSet::Sse2,
+        SimdInstructionSet::Neon,
+        SimdInstructionSet::Avx,
+        SimdInstructionSet::Avx512
+    };
+
+    Array1<double> scalarDistances(points.size());
+    Array1<double> distances(points.size());
+    for (bool isFlipped : {false, true}) {
+        box->isNormalFlipped = isFlipped;
+        for (SimdInstructionSet instructionSet : instructionSets) {
+            if (!isSimdInstructionSetSupported(instructionSet)) {
+                continue;
+            }
+            setSimdInstructionSet(instructionSet);
+
+            box->batchClosestSignedDistance(
+                points.constAccessor(), distances.accessor());
+            if (instructionSet == SimdInstructionSet::None) {
+                scalarDistances.set(distances);
+            }
+
+            // The closed form agrees with the closest points and normals up
+            // to round-off
+            for (size_t i = 0; i < points.size(); ++i) {
+                EXPECT_EQ(scalarDistances[i], distances[i]);
+                EXPECT_NEAR(s2i.signedDistance(points[i]), distances[i], 1e-12);
+            }
+        }
+    }
+
+    setSimdInstructionSet(oldInstructionSet);
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/brick_pager.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace jet;
+
+TEST(BrickPager, Constructor) {
+    BrickPager pager(10, std::vector<char>(16, 'a'), 0);
+    EXPECT_EQ(10u, pager.numberOfBricks());
+    EXPECT_EQ(16u, pager.bytesPerBrick());
+    EXPECT_EQ(1u, pager.maxNumberOfResidentBricks());
+    EXPECT_EQ(0u, pager.numberOfResidentBricks());
+
+    char* data = pager.acquire(3, false);
+    EXPECT_EQ('a', data[0]);
+    EXPECT_EQ('a', data[15]);
+    pager.release(3);
+    EXPECT_EQ(1u, pager.numberOfResidentBricks());
+    EXPECT_EQ(0u, pager.numberOfBrickReads());
+    EXPECT_EQ(0u, pager.numberOfBrickWrites());
+}
+
+TEST(BrickPager, LeastRecentlyUsed) {
+    BrickPager pager(4, std::vector<char>(8, 0), 2);
+
+    auto read = [&](size_t brick) {
+        char value = pager.acquire(brick, false)[0];
+        pager.release(brick);
+        return value;
+    };
+
+    for (size_t brick = 0; brick < 4; ++brick) {
+        pager.acquire(brick, true)[0] = static_cast<char>('a' + brick);
+        pager.release(brick);
+    }
+
+    // Bricks 0 and 1 are written back to make room for bricks 2 and 3
+    EXPECT_EQ(2u, pager.numberOfResidentBricks());
+    EXPECT_EQ(2u, pager.numberOfBrickWrites());
+    EXPECT_EQ(0u, pager.numberOfBrickReads());
+
+    // Reading brick 2 leaves brick 3 as the least recently used one
+    EXPECT_EQ('c', read(2));
+    EXPECT_EQ('a', read(0));
+    EXPECT_EQ(3u, pager.numberOfBrickWrites());
+    EXPECT_EQ(1u, pager.numberOfBrickReads());
+
+    EXPECT_EQ('b', read(1));
+    EXPECT_EQ(4u, pager.numberOfBrickWrites());
+    EXPECT_EQ(2u, pager.numberOfBrickReads());
+
+    // Brick 0 was not modified since it was loaded, so it is not written
+    EXPECT_EQ('d', read(3));
+    EXPECT_EQ(4u, pager.numberOfBrickWrites());
+    EXPECT_EQ(3u, pager.numberOfBrickReads());
+}
+
+TEST(BrickPager, Pinning) {
+    BrickPager pager(4, std::vector<char>(8, 'x'), 2);
+
+    // The cache grows past the max while all the bricks are pinned
+    char* data0 = pager.acquire(0, true);
+    char* data1 = pager.acquire(1, true);
+    char* data2 = pager.acquire(2, true);
+    EXPECT_EQ(3u, pager.numberOfResidentBricks());
+    data0[0] = '0';
+    data1[0] = '1';
+    data2[0] = '2';
+
+    // Pinning a resident brick twice keeps it until both are released
+    EXPECT_EQ(data1, pager.acquire(1, false));
+    pager.release(0);
+    pager.release(1);
+    pager.release(2);
+
+    pager.setMaxNumberOfResidentBricks(1);
+    EXPECT_EQ(1u, pager.maxNumberOfResidentBricks());
+    EXPECT_EQ(1u, pager.numberOfResidentBricks());
+    EXPECT_EQ(2u, pager.numberOfBrickWrites());
+
+    pager.release(1);
+    pager.setMaxNumberOfResidentBricks(0);
+    EXPECT_EQ(1u, pager.maxNumberOfResidentBricks());
+
+    for (size_t brick = 0; brick < 3; ++brick) {
+        char expected = static_cast<char>('0' + brick);
+        EXPECT_EQ(expected, pager.acquire(brick, false)[0]);
+        pager.release(brick);
+    }
+    EXPECT_EQ('x', pager.acquire(3, false)[0]);
+    pager.release(3);
+}
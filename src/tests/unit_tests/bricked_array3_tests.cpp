@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bricked_array3.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace jet;
+
+TEST(BrickedArray3, Constructors) {
+    BrickedArray3<float> arr0;
+    EXPECT_EQ(0u, arr0.width());
+    EXPECT_EQ(0u, arr0.height());
+    EXPECT_EQ(0u, arr0.depth());
+
+    BrickedArray3<float, 4> arr1(Size3(10, 3, 5), 7.f);
+    EXPECT_EQ(Size3(10, 3, 5), arr1.size());
+    arr1.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_FLOAT_EQ(7.f, arr1(i, j, k));
+    });
+
+    Array3<float> dense(10, 3, 5);
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        dense(i, j, k) = static_cast<float>(i + 10 * (j + 3 * k));
+    });
+
+    BrickedArray3x4<float> arr2(dense.constAccessor());
+    EXPECT_EQ(dense.size(), arr2.size());
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_FLOAT_EQ(dense(i, j, k), arr2(i, j, k));
+        EXPECT_FLOAT_EQ(dense(i, j, k), arr2(Point3UI(i, j, k)));
+    });
+
+    Array3<float> dense2;
+    arr2.copyTo(&dense2);
+    EXPECT_EQ(dense.size(), dense2.size());
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_FLOAT_EQ(dense(i, j, k), dense2(i, j, k));
+    });
+}
+
+TEST(BrickedArray3, Resize) {
+    BrickedArray3x8<double> arr(5, 6, 7, 1.0);
+    arr(4, 2, 6) = 2.0;
+
+    arr.resize(Size3(20, 3, 9), 3.0);
+    EXPECT_EQ(Size3(20, 3, 9), arr.size());
+    arr.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (i == 4 && j == 2 && k == 6) {
+            EXPECT_DOUBLE_EQ(2.0, arr(i, j, k));
+        } else if (i < 5 && k < 7) {
+            EXPECT_DOUBLE_EQ(1.0, arr(i, j, k));
+        } else {
+            EXPECT_DOUBLE_EQ(3.0, arr(i, j, k));
+        }
+    });
+
+    arr.resize(Size3(5, 6, 7));
+    EXPECT_DOUBLE_EQ(2.0, arr(4, 2, 6));
+    EXPECT_DOUBLE_EQ(0.0, arr(4, 5, 6));
+
+    arr.clear();
+    EXPECT_EQ(Size3(), arr.size());
+}
+
+TEST(BrickedArray3, Iterators) {
+    BrickedArray3<int, 4> arr(9, 5, 6);
+
+    // Each element is visited once, and a brick is finished before the next
+    std::vector<Point3UI> visited;
+    arr.forEachIndex([&](size_t i, size_t j, size_t k) {
+        visited.push_back(Point3UI(i, j, k));
+    });
+    EXPECT_EQ(9u * 5u * 6u, visited.size());
+    EXPECT_EQ(Point3UI(0, 0, 0), visited[0]);
+    EXPECT_EQ(Point3UI(3, 3, 3), visited[63]);
+    EXPECT_EQ(Point3UI(4, 0, 0), visited[64]);
+
+    arr.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        arr(i, j, k) += static_cast<int>(i + 9 * (j + 5 * k)) + 1;
+    });
+    arr.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(static_cast<int>(i + 9 * (j + 5 * k)) + 1, arr(i, j, k));
+    });
+}
@@ -0,0 +1,316 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bvh3.h>
+#include <jet/math_utils.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+std::vector<BoundingBox3D> makeRandomBoxes(size_t n) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<> center(-10.0, 10.0);
+    std::uniform_real_distribution<> extent(0.1, 1.0);
+
+    std::vector<BoundingBox3D> boxes;
+    for (size_t i = 0; i < n; ++i) {
+        Vector3D c(center(rng), center(rng), center(rng));
+        Vector3D e(extent(rng), extent(rng), extent(rng));
+        boxes.push_back(BoundingBox3D(c - e, c + e));
+    }
+    return boxes;
+}
+
+double distanceToBox(const BoundingBox3D& box, const Vector3D& pt) {
+    Vector3D d(
+        std::max({box.lowerCorner.x - pt.x, pt.x - box.upperCorner.x, 0.0}),
+        std::max({box.lowerCorner.y - pt.y, pt.y - box.upperCorner.y, 0.0}),
+        std::max({box.lowerCorner.z - pt.z, pt.z - box.upperCorner.z, 0.0}));
+    return d.length();
+}
+
+}  // namespace
+
+TEST(Bvh3, Empty) {
+    Bvh3 bvh;
+    EXPECT_TRUE(bvh.empty());
+
+    bvh.build({});
+    EXPECT_TRUE(bvh.empty());
+    EXPECT_EQ(kMaxSize, bvh.nearest(Vector3D(), [](size_t) { return 0.0; }));
+    EXPECT_DOUBLE_EQ(
+        kMaxD,
+        bvh.minimumSignedDistance(Vector3D(), [](size_t) { return 0.0; }));
+    EXPECT_FALSE(
+        bvh.anyRayHit(
+            Ray3D(Vector3D(), Vector3D(1, 0, 0)),
+            [](size_t) { return true; }));
+}
+
+TEST(Bvh3, Nearest) {
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(200);
+
+    Bvh3 bvh;
+    bvh.build(boxes);
+    EXPECT_FALSE(bvh.empty());
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<> d(-12.0, 12.0);
+    for (size_t n = 0; n < 100; ++n) {
+        Vector3D pt(d(rng), d(rng), d(rng));
+
+        size_t expected = kMaxSize;
+        double minDist = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            double dist = pt.distanceTo(boxes[i].midPoint());
+            if (dist < minDist) {
+                minDist = dist;
+                expected = i;
+            }
+        }
+
+        size_t visited = 0;
+        size_t actual = bvh.nearest(pt, [&](size_t i) {
+            ++visited;
+            return pt.distanceSquaredTo(boxes[i].midPoint());
+        });
+
+        EXPECT_EQ(expected, actual);
+        EXPECT_LT(visited, boxes.size());
+    }
+}
+
+TEST(Bvh3, MinimumSignedDistance) {
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(100);
+    Bvh3 bvh;
+    bvh.build(boxes);
+
+    // Signed distance of the sphere inscribed in each box
+    auto sdf = [&](size_t i, const Vector3D& pt) {
+        Vector3D e = boxes[i].upperCorner - boxes[i].midPoint();
+        double r = std::min({e.x, e.y, e.z});
+        return pt.distanceTo(boxes[i].midPoint()) - r;
+    };
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<> d(-12.0, 12.0);
+    for (size_t n = 0; n < 100; ++n) {
+        Vector3D pt(d(rng), d(rng), d(rng));
+
+        double expected = kMaxD;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            expected = std::min(expected, sdf(i, pt));
+        }
+
+        double actual = bvh.minimumSignedDistance(pt, [&](size_t i) {
+            EXPECT_LE(distanceToBox(boxes[i], pt), sdf(i, pt) + 1e-12);
+            return sdf(i, pt);
+        });
+
+        EXPECT_DOUBLE_EQ(expected, actual);
+    }
+}
+
+TEST(Bvh3, Rays) {
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(100);
+    Bvh3 bvh;
+    bvh.build(boxes);
+
+    Ray3D ray(Vector3D(-20, 0.5, 0.5), Vector3D(1, 0, 0));
+
+    double expected = std::numeric_limits<double>::max();
+    for (const auto& box : boxes) {
+        if (box.intersects(ray)) {
+            expected = std::min(expected, box.lowerCorner.x - ray.origin.x);
+        }
+    }
+
+    double actual = std::numeric_limits<double>::max();
+    bvh.forEachRayCandidate(ray, [&](size_t i) {
+        if (!boxes[i].intersects(ray)) {
+            return std::numeric_limits<double>::max();
+        }
+        double t = boxes[i].lowerCorner.x - ray.origin.x;
+        actual = std::min(actual, t);
+        return t;
+    });
+
+    EXPECT_DOUBLE_EQ(expected, actual);
+    EXPECT_EQ(
+        expected < std::numeric_limits<double>::max(),
+        bvh.anyRayHit(ray, [&](size_t i) {
+            return boxes[i].intersects(ray);
+        }));
+}
+
+TEST(Bvh3, UnboundedItems) {
+    double m = std::numeric_limits<double>::max();
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(10);
+    boxes.push_back(BoundingBox3D(Vector3D(-m, 0, -m), Vector3D(m, 0, m)));
+
+    Bvh3 bvh;
+    bvh.build(boxes);
+
+    // The unbounded item is always visited
+    size_t i = bvh.nearest(Vector3D(100, 100, 100), [&](size_t j) {
+        return (j == 10) ? 0.0 : 1e6;
+    });
+    EXPECT_EQ(10u, i);
+}
+
+TEST(Bvh3, Refit) {
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(50);
+    Bvh3 bvh;
+    bvh.build(boxes);
+
+    for (auto& box : boxes) {
+        box.lowerCorner += Vector3D(100, 0, 0);
+        box.upperCorner += Vector3D(100, 0, 0);
+    }
+    bvh.refit(boxes);
+
+    Vector3D pt(100, 0, 0);
+    size_t expected = kMaxSize;
+    double minDist = std::numeric_limits<double>::max();
+    for (size_t j = 0; j < boxes.size(); ++j) {
+        double dist = distanceToBox(boxes[j], pt);
+        if (dist < minDist) {
+            minDist = dist;
+            expected = j;
+        }
+    }
+
+    size_t actual = bvh.nearest(pt, [&](size_t j) {
+        return square(distanceToBox(boxes[j], pt));
+    });
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(Bvh3, Packets) {
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(200);
+    Bvh3 bvh;
+    bvh.build(boxes);
+
+    // Queries of a packet are near each other, as in the rows of a grid
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<> d(-12.0, 12.0);
+    std::uniform_real_distribution<> jitter(-0.5, 0.5);
+    for (size_t count : {size_t(1), size_t(17), Bvh3::kPacketSize}) {
+        Vector3D center(d(rng), d(rng), d(rng));
+        std::vector<Vector3D> pts(count);
+        std::vector<Ray3D> rays(count);
+        for (size_t k = 0; k < count; ++k) {
+            pts[k] = center + Vector3D(jitter(rng), jitter(rng), jitter(rng));
+            rays[k] = Ray3D(
+                Vector3D(-20, pts[k].y, pts[k].z), Vector3D(1, 0, 0));
+        }
+
+        std::vector<size_t> results(count);
+        bvh.nearestPacket(pts.data(), count, [&](size_t i, size_t k) {
+            return pts[k].distanceSquaredTo(boxes[i].midPoint());
+        }, results.data());
+
+        std::vector<double> tMin(count, std::numeric_limits<double>::max());
+        bvh.forEachRayCandidatePacket(
+            rays.data(), count, [&](size_t i, size_t k) {
+                if (!boxes[i].intersects(rays[k])) {
+                    return std::numeric_limits<double>::max();
+                }
+                double t = boxes[i].lowerCorner.x - rays[k].origin.x;
+                tMin[k] = std::min(tMin[k], t);
+                return t;
+            });
+
+        for (size_t k = 0; k < count; ++k) {
+            EXPECT_EQ(
+                bvh.nearest(pts[k], [&](size_t i) {
+                    return pts[k].distanceSquaredTo(boxes[i].midPoint());
+                }),
+                results[k]);
+
+            double expected = std::numeric_limits<double>::max();
+            for (const auto& box : boxes) {
+                if (box.intersects(rays[k])) {
+                    expected = std::min(
+                        expected, box.lowerCorner.x - rays[k].origin.x);
+                }
+            }
+            EXPECT_DOUBLE_EQ(expected, tMin[k]);
+        }
+    }
+}
+
+TEST(Bvh3, Leaves) {
+    double m = std::numeric_limits<double>::max();
+    std::vector<BoundingBox3D> boxes = makeRandomBoxes(300);
+    boxes.push_back(BoundingBox3D(Vector3D(-m, 0, -m), Vector3D(m, 0, m)));
+
+    // Coincident boxes end up in a leaf that cannot be split
+    for (size_t i = 0; i < 7; ++i) {
+        boxes.push_back(BoundingBox3D(Vector3D(1, 1, 1), Vector3D(2, 2, 2)));
+    }
+
+    Bvh3 bvh;
+    bvh.build(boxes);
+
+    // Every item once, with the unbounded one last
+    std::vector<size_t> items = bvh.orderedItems();
+    ASSERT_EQ(boxes.size(), items.size());
+    EXPECT_EQ(300u, items.back());
+    std::sort(items.begin(), items.end());
+    for (size_t i = 0; i < items.size(); ++i) {
+        EXPECT_EQ(i, items[i]);
+    }
+
+    const std::vector<size_t>& ordered = bvh.orderedItems();
+    auto distanceSquared = [&](size_t i, const Vector3D& pt) {
+        return (i == 300) ? 400.0 : pt.distanceSquaredTo(boxes[i].midPoint());
+    };
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<> d(-12.0, 12.0);
+    std::vector<Vector3D> pts(Bvh3::kPacketSize);
+    for (auto& pt : pts) {
+        pt = Vector3D(d(rng), d(rng), d(rng));
+    }
+    pts[0] = Vector3D(1.5, 1.5, 1.5);
+
+    std::vector<size_t> results(pts.size());
+    bvh.nearestPacketInLeaves(
+        pts.data(),
+        pts.size(),
+        [&](size_t position, size_t n, size_t k, double* distancesSquared) {
+            EXPECT_LE(n, Bvh3::kLeafChunkSize);
+            for (size_t m = 0; m < n; ++m) {
+                distancesSquared[m]
+                    = distanceSquared(ordered[position + m], pts[k]);
+            }
+        },
+        results.data());
+
+    for (size_t k = 0; k < pts.size(); ++k) {
+        const Vector3D& pt = pts[k];
+        size_t expected = bvh.nearest(pt, [&](size_t i) {
+            return distanceSquared(i, pt);
+        });
+        EXPECT_EQ(expected, results[k]);
+        EXPECT_EQ(
+            expected,
+            bvh.nearestInLeaves(
+                pt, [&](size_t position, size_t n, double* distancesSquared) {
+                    EXPECT_LE(n, Bvh3::kLeafChunkSize);
+                    for (size_t m = 0; m < n; ++m) {
+                        distancesSquared[m]
+                            = distanceSquared(ordered[position + m], pt);
+                    }
+                }));
+    }
+
+    // Ties go to the lower index
+    EXPECT_EQ(301u, results[0]);
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array1.h>
+#include <jet/cached_scalar_field3.h>
+#include <jet/custom_scalar_field3.h>
+#include <jet/parallel.h>
+#include <jet/sphere3.h>
+#include <jet/surface_to_implicit3.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+
+using namespace jet;
+
+namespace {
+
+double plane(const Vector3D& x) {
+    return x.x + 2.0 * x.y - x.z;
+}
+
+}  // namespace
+
+TEST(CachedScalarField3, Sample) {
+    std::atomic<size_t> numberOfSamples(0);
+    auto field = std::make_shared<CustomScalarField3>(
+        [&](const ConstArrayAccessor1<Vector3D>& x,
+            ArrayAccessor1<double> result) {
+            numberOfSamples += x.size();
+            for (size_t i = 0; i < x.size(); ++i) {
+                result[i] = plane(x[i]);
+            }
+        });
+
+    BoundingBox3D domain(Vector3D(-1, -1, -1), Vector3D(1, 2, 1));
+    CachedScalarField3 cached(field, domain, 0.1);
+    EXPECT_EQ(field, cached.field());
+    EXPECT_EQ(0.1, cached.spacing());
+    EXPECT_EQ(4096u, cached.maxNumberOfTiles());
+    EXPECT_EQ(0u, cached.numberOfTiles());
+    EXPECT_THROW(
+        CachedScalarField3(field, domain, 0.0), std::invalid_argument);
+
+    // A linear field is interpolated exactly, and only one tile is sampled
+    Vector3D x(0.03, -0.07, 0.05);
+    EXPECT_NEAR(plane(x), cached.sample(x), 1e-12);
+    EXPECT_EQ(1u, cached.numberOfTiles());
+    EXPECT_EQ(1u, cached.numberOfTileFills());
+    EXPECT_EQ(729u, numberOfSamples.load());
+
+    EXPECT_NEAR(plane(x), cached.sample(x), 1e-12);
+    EXPECT_EQ(1u, cached.numberOfTileFills());
+
+    Vector3D g = cached.gradient(x);
+    EXPECT_NEAR(1.0, g.x, 1e-9);
+    EXPECT_NEAR(2.0, g.y, 1e-9);
+    EXPECT_NEAR(-1.0, g.z, 1e-9);
+    EXPECT_NEAR(0.0, cached.laplacian(x), 1e-9);
+
+    // The points outside the domain are sampled directly
+    Vector3D outside(3.0, 0.0, 0.0);
+    EXPECT_EQ(plane(outside), cached.sample(outside));
+    EXPECT_EQ(1u, cached.numberOfTileFills());
+
+    // The batch over the whole domain matches the single samples
+    Array1<Vector3D> points;
+    for (int k = -10; k <= 11; ++k) {
+        for (int j = -10; j <= 21; ++j) {
+            for (int i = -10; i <= 11; ++i) {
+                points.append(0.0973 * Vector3D(i, j, k));
+            }
+        }
+    }
+    Array1<double> values(points.size());
+    cached.batchSample(points.constAccessor(), values.accessor());
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_NEAR(plane(points[i]), values[i], 1e-12);
+    }
+    EXPECT_EQ(3u * 4u * 3u, cached.numberOfTiles());
+}
+
+TEST(CachedScalarField3, ImplicitSurface) {
+    auto sphere = std::make_shared<SurfaceToImplicit3>(
+        std::make_shared<Sphere3>(Vector3D(0.5, 0.5, 0.5), 0.3));
+    BoundingBox3D domain(Vector3D(), Vector3D(1, 1, 1));
+    CachedScalarField3 cached(sphere, domain, 0.02);
+
+    Array1<Vector3D> points(1000);
+    parallelFor(kZeroSize, points.size(), [&](size_t n) {
+        points[n] = Vector3D(
+            0.5 + 0.45 * std::sin(1.3 * n),
+            0.5 + 0.45 * std::cos(0.7 * n),
+            0.5 + 0.45 * std::sin(2.1 * n + 0.3));
+    });
+
+    // The samples from many threads agree with the signed distance
+    Array1<double> values(points.size());
+    parallelFor(kZeroSize, points.size(), [&](size_t n) {
+        values[n] = cached.sample(points[n]);
+    });
+    for (size_t n = 0; n < points.size(); ++n) {
+        EXPECT_NEAR(sphere->signedDistance(points[n]), values[n], 1e-3);
+    }
+    EXPECT_LT(0u, cached.numberOfTiles());
+    EXPECT_GE(cached.numberOfTileFills(), cached.numberOfTiles());
+}
+
+TEST(CachedScalarField3, Invalidate) {
+    double offset = 0.0;
+    auto field = std::make_shared<CustomScalarField3>(
+        [&](const Vector3D& x) {
+            return plane(x) + offset;
+        });
+    BoundingBox3D domain(Vector3D(), Vector3D(4, 4, 4));
+    CachedScalarField3 cached(field, domain, 0.1, 2);
+
+    // The least recently used tile is dropped
+    cached.sample(Vector3D(0.1, 0.1, 0.1));
+    cached.sample(Vector3D(1.0, 0.1, 0.1));
+    cached.sample(Vector3D(0.1, 0.1, 0.1));
+    cached.sample(Vector3D(2.0, 0.1, 0.1));
+    EXPECT_EQ(2u, cached.numberOfTiles());
+    EXPECT_EQ(3u, cached.numberOfTileFills());
+    cached.sample(Vector3D(0.1, 0.1, 0.1));
+    EXPECT_EQ(3u, cached.numberOfTileFills());
+    cached.sample(Vector3D(1.0, 0.1, 0.1));
+    EXPECT_EQ(4u, cached.numberOfTileFills());
+
+    cached.setMaxNumberOfTiles(0);
+    EXPECT_EQ(1u, cached.maxNumberOfTiles());
+    EXPECT_EQ(1u, cached.numberOfTiles());
+
+    // The cache keeps the old values until it is invalidated
+    Vector3D x(1.0, 0.1, 0.1);
+    offset = 1.0;
+    EXPECT_NEAR(plane(x), cached.sample(x), 1e-12);
+
+    cached.setSourceVersion(7);
+    EXPECT_EQ(1u, cached.version());
+    EXPECT_EQ(0u, cached.numberOfTiles());
+    EXPECT_NEAR(plane(x) + 1.0, cached.sample(x), 1e-12);
+
+    cached.setSourceVersion(7);
+    EXPECT_EQ(1u, cached.version());
+    EXPECT_EQ(1u, cached.numberOfTiles());
+
+    cached.invalidate();
+    EXPECT_EQ(2u, cached.version());
+    EXPECT_EQ(0u, cached.numberOfTiles());
+}
@@ -2,6 +2,7 @@
 
 #include <jet/cell_centered_scalar_grid3.h>
 #include <gtest/gtest.h>
+#include <cmath>
 #include <sstream>
 
 using namespace jet;
@@ -186,6 +187,35 @@ TEST(CellCenteredScalarGrid3, Clone) {
     });
 }
 
+TEST(CellCenteredScalarGrid3, CopyOnWrite) {
+    CellCenteredScalarGrid3 grid1(3, 8, 5, 2.0, 3.0, 1.0, 5.0, 4.0, 7.0, 8.0);
+    auto grid2 = grid1.clone();
+
+    // The clone shares the data until either grid is written
+    EXPECT_EQ(
+        grid1.constDataAccessor().data(),
+        grid2->constDataAccessor().data());
+
+    (*grid2)(1, 2, 3) = 4.0;
+    EXPECT_NE(
+        grid1.constDataAccessor().data(),
+        grid2->constDataAccessor().data());
+    EXPECT_DOUBLE_EQ(8.0, grid1(1, 2, 3));
+    EXPECT_DOUBLE_EQ(4.0, (*grid2)(1, 2, 3));
+
+    // The sampler follows the copied data
+    Vector3D x = grid2->dataPosition()(1, 2, 3);
+    EXPECT_DOUBLE_EQ(4.0, grid2->sample(x));
+    EXPECT_DOUBLE_EQ(8.0, grid1.sample(x));
+
+    CellCenteredScalarGrid3 grid3(grid1);
+    grid1.fill(1.0);
+    grid1.forEachDataPointIndex([&] (size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(1.0, grid1(i, j, k));
+        EXPECT_DOUBLE_EQ(8.0, grid3(i, j, k));
+    });
+}
+
 TEST(CellCenteredScalarGrid3, Builder) {
     auto grid1 = CellCenteredScalarGrid3::builder()->build(
         {3, 8, 5}, {2.0, 3.0, 1.0}, {5.0, 4.0, 7.0}, 8.0);
@@ -344,3 +374,120 @@ TEST(CellCenteredScalarGrid3, Serialization) {
     EXPECT_DOUBLE_EQ(1.0, grid2.gridSpacing().y);
     EXPECT_DOUBLE_EQ(1.0, grid2.gridSpacing().z);
 }
+
+TEST(CellCenteredScalarGrid3F, Basics) {
+    CellCenteredScalarGrid3F grid(5, 8, 6, 2.0, 3.0, 1.5, 0.0, 0.0, 0.0, 1.0f);
+    EXPECT_EQ(5u, grid.dataSize().x);
+    EXPECT_EQ(8u, grid.dataSize().y);
+    EXPECT_EQ(6u, grid.dataSize().z);
+    EXPECT_FLOAT_EQ(1.0f, grid(2, 3, 4));
+
+    grid.fill([](const Vector3D& x) { return x.x + 2.0 * x.y - 3.0 * x.z; });
+
+    // Interior stencils and samples are exact for a linear field
+    for (size_t k = 1; k < grid.resolution().z - 1; ++k) {
+        for (size_t j = 1; j < grid.resolution().y - 1; ++j) {
+            for (size_t i = 1; i < grid.resolution().x - 1; ++i) {
+                Vector3D grad = grid.gradientAtDataPoint(i, j, k);
+                EXPECT_NEAR(1.0, grad.x, 1e-5);
+                EXPECT_NEAR(2.0, grad.y, 1e-5);
+                EXPECT_NEAR(-3.0, grad.z, 1e-5);
+                EXPECT_NEAR(0.0, grid.laplacianAtDataPoint(i, j, k), 1e-5);
+            }
+        }
+    }
+
+    Vector3D x(4.2, 12.3, 4.4);
+    EXPECT_NEAR(x.x + 2.0 * x.y - 3.0 * x.z, grid.sample(x), 1e-4);
+    EXPECT_NEAR(grid.sample(x), grid.sampler()(x), 1e-6);
+}
+
+TEST(CellCenteredScalarGrid3F, BuilderAndSerialization) {
+    auto grid1 = CellCenteredScalarGrid3F::builder()->build(
+        {3, 8, 5}, {2.0, 3.0, 1.0}, {5.0, 4.0, 7.0}, 8.0);
+    EXPECT_TRUE(
+        std::dynamic_pointer_cast<CellCenteredScalarGrid3F>(grid1) != nullptr);
+    grid1->fill([](const Vector3D& x) { return x.sum(); });
+
+    std::stringstream strm;
+    grid1->serialize(&strm);
+
+    CellCenteredScalarGrid3F grid2;
+    grid2.deserialize(&strm);
+    EXPECT_EQ(grid1->resolution(), grid2.resolution());
+    grid1->forEachDataPointIndex([&] (size_t i, size_t j, size_t k) {
+        EXPECT_FLOAT_EQ((*grid1)(i, j, k), grid2(i, j, k));
+    });
+
+    // Half the bytes of the double grid
+    CellCenteredScalarGrid3 grid3(3, 8, 5);
+    std::stringstream strm2;
+    grid3.serialize(&strm2);
+    EXPECT_LT(strm.str().size(), strm2.str().size());
+}
+
+TEST(CellCenteredScalarGrid3, ComputeGradientAndLaplacian) {
+    for (const Size3& res : {Size3(5, 4, 6), Size3(1, 3, 2)}) {
+        CellCenteredScalarGrid3 grid(res, Vector3D(0.5, 0.25, 2.0));
+        grid.fill([](const Vector3D& x) {
+            return std::sin(x.x) * x.y + x.z * x.z;
+        });
+
+        Array3<Vector3D> gradient(res);
+        Array3<double> laplacian(res);
+        grid.computeGradient(gradient.accessor());
+        grid.computeLaplacian(laplacian.accessor());
+
+        // Bit-wise identical to the per-point accessors
+        laplacian.forEachIndex([&](size_t i, size_t j, size_t k) {
+            Vector3D expected = grid.gradientAtDataPoint(i, j, k);
+            EXPECT_EQ(expected.x, gradient(i, j, k).x);
+            EXPECT_EQ(expected.y, gradient(i, j, k).y);
+            EXPECT_EQ(expected.z, gradient(i, j, k).z);
+            EXPECT_EQ(grid.laplacianAtDataPoint(i, j, k), laplacian(i, j, k));
+        });
+    }
+}
+
+TEST(CellCenteredScalarGrid3F, ComputeGradientAndLaplacian) {
+    CellCenteredScalarGrid3F grid(Size3(4, 5, 3), Vector3D(0.5, 0.25, 2.0));
+    grid.fill([](const Vector3D& x) {
+        return std::sin(x.x) * x.y + x.z * x.z;
+    });
+
+    Array3<Vector3D> gradient(grid.dataSize());
+    Array3<double> laplacian(grid.dataSize());
+    grid.computeGradient(gradient.accessor());
+    grid.computeLaplacian(laplacian.accessor());
+
+    laplacian.forEachIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D expected = grid.gradientAtDataPoint(i, j, k);
+        EXPECT_EQ(expected.x, gradient(i, j, k).x);
+        EXPECT_EQ(expected.y, gradient(i, j, k).y);
+        EXPECT_EQ(expected.z, gradient(i, j, k).z);
+        EXPECT_EQ(grid.laplacianAtDataPoint(i, j, k), laplacian(i, j, k));
+    });
+}
+
+TEST(CellCenteredScalarGrid3, ForEachDataPointRow) {
+    CellCenteredScalarGrid3 grid(5, 4, 6);
+    auto data = grid.dataAccessor();
+
+    grid.parallelForEachDataPointRow([&](size_t j, size_t k) {
+        double* row = data.row(j, k);
+        for (size_t i = 0; i < data.width(); ++i) {
+            row[i] = static_cast<double>(i + 10 * j + 100 * k);
+        }
+    });
+    grid.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(static_cast<double>(i + 10 * j + 100 * k),
+                         grid(i, j, k));
+    });
+
+    size_t numberOfRows = 0;
+    grid.forEachDataPointRow([&](size_t j, size_t k) {
+        EXPECT_EQ(numberOfRows, j + 4 * k);
+        ++numberOfRows;
+    });
+    EXPECT_EQ(24u, numberOfRows);
+}
@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array1.h>
 #include <jet/cell_centered_vector_grid3.h>
 #include <gtest/gtest.h>
 
@@ -280,6 +281,22 @@ TEST(CellCenteredVectorGrid3, Fill) {
     }
 }
 
+TEST(CellCenteredVectorGrid3, BatchSample) {
+    CellCenteredVectorGrid3 grid(5, 4, 6, 1.0, 2.0, 0.5);
+    grid.fill([](const Vector3D& x) {
+        return Vector3D(x.y, -x.z, 2.0 * x.x);
+    });
+
+    Array1<Vector3D> points = {
+        Vector3D(1.3, 2.1, 0.2), Vector3D(4.5, 7.0, 2.9), Vector3D(-1, 0, 9)
+    };
+    Array1<Vector3D> values(points.size());
+    grid.batchSample(points.constAccessor(), values.accessor());
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(grid.sample(points[i]), values[i]);
+    }
+}
+
 TEST(CellCenteredVectorGrid3, DivergenceAtDataPoint) {
     CellCenteredVectorGrid3 grid(5, 8, 6);
 
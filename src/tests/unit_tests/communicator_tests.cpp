@@ -0,0 +1,47 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/communicator.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace jet;
+
+TEST(SerialCommunicator, Reductions) {
+    SerialCommunicator comm;
+
+    EXPECT_EQ(0, comm.rank());
+    EXPECT_EQ(1, comm.size());
+    EXPECT_DOUBLE_EQ(3.5, comm.sum(3.5));
+    EXPECT_DOUBLE_EQ(-2.0, comm.max(-2.0));
+}
+
+TEST(SerialCommunicator, SendReceive) {
+    SerialCommunicator comm;
+
+    double send[3] = {1.0, 2.0, 3.0};
+    double receive[3] = {0.0, 0.0, 0.0};
+
+    comm.sendReceive(send, sizeof(send), kNoRank, receive, sizeof(receive),
+                     kNoRank);
+    EXPECT_DOUBLE_EQ(0.0, receive[0]);
+
+    comm.sendReceive(send, sizeof(send), 0, receive, sizeof(receive), 0);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_DOUBLE_EQ(send[i], receive[i]);
+    }
+
+    EXPECT_THROW(
+        comm.sendReceive(send, sizeof(send), 1, receive, sizeof(receive), 0),
+        std::invalid_argument);
+    EXPECT_THROW(
+        comm.sendReceive(
+            send, sizeof(send), 0, receive, sizeof(receive), kNoRank),
+        std::invalid_argument);
+}
+
+#ifndef JET_USE_MPI
+TEST(MpiCommunicator, WithoutMpi) {
+    EXPECT_FALSE(MpiCommunicator::isAvailable());
+    EXPECT_THROW(MpiCommunicator(), std::runtime_error);
+}
+#endif
@@ -0,0 +1,92 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/composite_physics_animation.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Integrates dx/dt = input, and counts its sub-steps
+class IntegratingAnimation : public PhysicsAnimation {
+ public:
+    double input = 0.0;
+    double x = 0.0;
+    unsigned int numberOfSteps = 0;
+
+ protected:
+    void onAdvanceTimeStep(double timeIntervalInSeconds) override {
+        x += input * timeIntervalInSeconds;
+        ++numberOfSteps;
+    }
+};
+
+}  // namespace
+
+TEST(CompositePhysicsAnimation, Stages) {
+    auto a = std::make_shared<IntegratingAnimation>();
+    auto b = std::make_shared<IntegratingAnimation>();
+    auto c = std::make_shared<IntegratingAnimation>();
+
+    CompositePhysicsAnimation composite;
+    EXPECT_EQ(0u, composite.numberOfStages());
+
+    composite.addAnimation(a);
+    composite.addAnimation(b);
+    composite.addAnimation(c, 2);
+    EXPECT_EQ(3u, composite.numberOfStages());
+    EXPECT_EQ(2u, composite.animations(0).size());
+    EXPECT_TRUE(composite.animations(1).empty());
+    EXPECT_EQ(c, composite.animations(2).front());
+}
+
+TEST(CompositePhysicsAnimation, SubTimeSteps) {
+    auto a = std::make_shared<IntegratingAnimation>();
+    a->setNumberOfFixedSubTimeSteps(1);
+    auto b = std::make_shared<IntegratingAnimation>();
+    b->setNumberOfFixedSubTimeSteps(5);
+
+    CompositePhysicsAnimation composite;
+    composite.addAnimation(a);
+    composite.addAnimation(b);
+
+    // Each animation keeps its own sub-steps, and the frames skipped by a
+    // single update are all advanced
+    composite.update(Frame(1, 0.1));
+    composite.update(Frame(3, 0.1));
+    EXPECT_EQ(3u, composite.currentFrame().index);
+    EXPECT_EQ(3u, a->currentFrame().index);
+    EXPECT_EQ(3u, b->currentFrame().index);
+    EXPECT_EQ(3u, a->numberOfSteps);
+    EXPECT_EQ(15u, b->numberOfSteps);
+
+    composite.update(Frame(3, 0.1));
+    EXPECT_EQ(3u, a->numberOfSteps);
+}
+
+TEST(CompositePhysicsAnimation, OneWayCoupling) {
+    // The consumer integrates the position of the producer, which moves with
+    // the unit speed
+    auto producer = std::make_shared<IntegratingAnimation>();
+    producer->input = 1.0;
+    auto consumer = std::make_shared<IntegratingAnimation>();
+
+    CompositePhysicsAnimation composite;
+    composite.addAnimation(producer, 0);
+    composite.addAnimation(consumer, 1);
+
+    std::vector<unsigned int> frameIndices;
+    composite.addCoupling([&](const Frame& frame) {
+        EXPECT_EQ(frame.index, producer->currentFrame().index);
+        EXPECT_EQ(frame.index - 1, consumer->currentFrame().index);
+        consumer->input = producer->x;
+        frameIndices.push_back(frame.index);
+    }, 1);
+
+    composite.update(Frame(4, 0.5));
+    EXPECT_EQ((std::vector<unsigned int>{1, 2, 3, 4}), frameIndices);
+    EXPECT_DOUBLE_EQ(2.0, producer->x);
+    EXPECT_DOUBLE_EQ(0.5 * (0.5 + 1.0 + 1.5 + 2.0), consumer->x);
+}
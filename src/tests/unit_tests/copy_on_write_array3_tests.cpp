@@ -0,0 +1,78 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/copy_on_write_array3.h>
+#include <jet/parallel.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(CopyOnWriteArray3, Constructors) {
+    CopyOnWriteArray3<double> data;
+    EXPECT_EQ(Size3(0, 0, 0), data.size());
+    EXPECT_FALSE(data.isShared());
+}
+
+TEST(CopyOnWriteArray3, CopyOnWrite) {
+    CopyOnWriteArray3<double> data1;
+    data1.mutate().resize(Size3(4, 3, 2), 1.0);
+    EXPECT_FALSE(data1.isShared());
+
+    CopyOnWriteArray3<double> data2(data1);
+    EXPECT_TRUE(data1.isShared());
+    EXPECT_TRUE(data2.isShared());
+    EXPECT_EQ(data1.get().data(), data2.get().data());
+
+    int numberOfCopies = 0;
+    data2.mutate([&] { ++numberOfCopies; })(1, 2, 1) = 5.0;
+    EXPECT_EQ(1, numberOfCopies);
+    EXPECT_FALSE(data2.isShared());
+    EXPECT_NE(data1.get().data(), data2.get().data());
+    EXPECT_EQ(1.0, data1(1, 2, 1));
+    EXPECT_EQ(5.0, data2(1, 2, 1));
+
+    // The last owner takes the array back without copying
+    const double* data = data1.get().data();
+    data1.mutate([&] { ++numberOfCopies; })(0, 0, 0) = 2.0;
+    EXPECT_EQ(1, numberOfCopies);
+    EXPECT_EQ(data, data1.get().data());
+    EXPECT_FALSE(data1.isShared());
+}
+
+TEST(CopyOnWriteArray3, Assignment) {
+    CopyOnWriteArray3<double> data1;
+    data1.mutate().resize(Size3(2, 2, 2), 3.0);
+
+    CopyOnWriteArray3<double> data2;
+    data2 = data1;
+    EXPECT_EQ(data1.get().data(), data2.get().data());
+    EXPECT_EQ(Size3(2, 2, 2), data2.size());
+
+    CopyOnWriteArray3<double> data3;
+    data3.swap(data2);
+    EXPECT_EQ(Size3(0, 0, 0), data2.size());
+    EXPECT_TRUE(data3.isShared());
+    EXPECT_EQ(data1.get().data(), data3.get().data());
+}
+
+TEST(CopyOnWriteArray3, ParallelMutate) {
+    CopyOnWriteArray3<double> data1;
+    data1.mutate().resize(Size3(16, 16, 16), 1.0);
+    CopyOnWriteArray3<double> data2(data1);
+
+    // The threads that find the storage shared wait for the single copy
+    const size_t n = 16;
+    int numberOfCopies = 0;
+    parallelFor(
+        kZeroSize, n, kZeroSize, n, kZeroSize, n,
+        [&](size_t i, size_t j, size_t k) {
+            data2.mutate([&] { ++numberOfCopies; })(i, j, k) = 2.0;
+        });
+
+    EXPECT_EQ(1, numberOfCopies);
+    for (double v : data1.get()) {
+        EXPECT_EQ(1.0, v);
+    }
+    for (double v : data2.get()) {
+        EXPECT_EQ(2.0, v);
+    }
+}
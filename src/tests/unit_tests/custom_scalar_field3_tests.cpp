@@ -0,0 +1,54 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/custom_scalar_field3.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+double bowl(const Vector3D& x) {
+    return x.x * x.x + 2.0 * x.y * x.y + x.x * x.z;
+}
+
+}  // namespace
+
+TEST(CustomScalarField3, BatchSample) {
+    size_t numberOfCalls = 0;
+    CustomScalarField3 batchField(
+        [&](const ConstArrayAccessor1<Vector3D>& x,
+            ArrayAccessor1<double> result) {
+            ++numberOfCalls;
+            for (size_t i = 0; i < x.size(); ++i) {
+                result[i] = bowl(x[i]);
+            }
+        });
+    CustomScalarField3 field(bowl);
+
+    std::vector<Vector3D> points;
+    for (int i = 0; i < 10; ++i) {
+        points.push_back(Vector3D(0.1 * i, 1.0 - 0.05 * i, 0.3 + 0.02 * i));
+    }
+
+    std::vector<double> batchResult(points.size());
+    batchField.batchSample(
+        ConstArrayAccessor1<Vector3D>(points.size(), points.data()),
+        ArrayAccessor1<double>(batchResult.size(), batchResult.data()));
+    EXPECT_EQ(1u, numberOfCalls);
+
+    auto sampler = batchField.sampler();
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(bowl(points[i]), batchResult[i]);
+        EXPECT_EQ(bowl(points[i]), batchField.sample(points[i]));
+        EXPECT_EQ(bowl(points[i]), sampler(points[i]));
+    }
+
+    // The six neighbors of the stencil are sampled in one call
+    numberOfCalls = 0;
+    for (const Vector3D& x : points) {
+        EXPECT_EQ(field.gradient(x), batchField.gradient(x));
+        EXPECT_EQ(field.laplacian(x), batchField.laplacian(x));
+    }
+    EXPECT_EQ(3 * points.size(), numberOfCalls);
+}
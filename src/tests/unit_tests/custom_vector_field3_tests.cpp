@@ -0,0 +1,77 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/custom_vector_field3.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+Vector3D swirl(const Vector3D& x) {
+    return Vector3D(-x.y * x.z, x.x * x.z, x.x * x.y * x.y);
+}
+
+}  // namespace
+
+TEST(CustomVectorField3, BatchSample) {
+    size_t numberOfCalls = 0;
+    CustomVectorField3 batchField(
+        [&](const ConstArrayAccessor1<Vector3D>& x,
+            ArrayAccessor1<Vector3D> result) {
+            ++numberOfCalls;
+            for (size_t i = 0; i < x.size(); ++i) {
+                result[i] = swirl(x[i]);
+            }
+        });
+    CustomVectorField3 field(swirl);
+
+    std::vector<Vector3D> points;
+    for (int i = 0; i < 10; ++i) {
+        points.push_back(Vector3D(0.1 * i, 1.0 - 0.05 * i, 0.3 + 0.02 * i));
+    }
+
+    std::vector<Vector3D> batchResult(points.size());
+    std::vector<Vector3D> result(points.size());
+    batchField.batchSample(
+        ConstArrayAccessor1<Vector3D>(points.size(), points.data()),
+        ArrayAccessor1<Vector3D>(batchResult.size(), batchResult.data()));
+    field.batchSample(
+        ConstArrayAccessor1<Vector3D>(points.size(), points.data()),
+        ArrayAccessor1<Vector3D>(result.size(), result.data()));
+    EXPECT_EQ(1u, numberOfCalls);
+
+    auto sampler = batchField.sampler();
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(swirl(points[i]), batchResult[i]);
+        EXPECT_EQ(swirl(points[i]), result[i]);
+        EXPECT_EQ(swirl(points[i]), batchField.sample(points[i]));
+        EXPECT_EQ(swirl(points[i]), sampler(points[i]));
+    }
+
+    // The finite differencing samples the whole stencil in one call, and
+    // gives the same result as the per-point function
+    numberOfCalls = 0;
+    for (const Vector3D& x : points) {
+        EXPECT_EQ(field.divergence(x), batchField.divergence(x));
+        EXPECT_EQ(field.curl(x), batchField.curl(x));
+    }
+    EXPECT_EQ(2 * points.size(), numberOfCalls);
+}
+
+TEST(CustomVectorField3, BatchSampleWithDerivatives) {
+    CustomVectorField3 field(
+        [](const ConstArrayAccessor1<Vector3D>& x,
+           ArrayAccessor1<Vector3D> result) {
+            for (size_t i = 0; i < x.size(); ++i) {
+                result[i] = swirl(x[i]);
+            }
+        },
+        [](const Vector3D&) { return 3.0; },
+        [](const Vector3D&) { return Vector3D(1, 2, 3); });
+
+    Vector3D x(0.2, 0.4, 0.6);
+    EXPECT_EQ(swirl(x), field.sample(x));
+    EXPECT_EQ(3.0, field.divergence(x));
+    EXPECT_EQ(Vector3D(1, 2, 3), field.curl(x));
+}
@@ -0,0 +1,212 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bfecc_advection3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
+#include <jet/constant_vector_field3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/maccormack_advection3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+class SwirlField3 final : public VectorField3 {
+ public:
+    Vector3D sample(const Vector3D& x) const override {
+        return Vector3D(
+            std::sin(x.y) * std::cos(x.z),
+            std::sin(x.z) * std::cos(x.x),
+            std::sin(x.x) * std::cos(x.y));
+    }
+};
+
+double density(const Vector3D& x) {
+    return std::sin(x.x) + std::cos(2.0 * x.y) * x.z;
+}
+
+Vector3D smoke(const Vector3D& x) {
+    return Vector3D(x.y * x.z, std::cos(x.x), x.x - x.y);
+}
+
+double wave(const Vector3D& x) {
+    return std::sin(x.x) * std::cos(x.y) * std::sin(x.z);
+}
+
+// Returns the max error of advecting the wave by a uniform flow, measured at
+// the data points whose traced points stay inside the grid.
+double uniformAdvectionError(AdvectionSolver3* solver) {
+    Size3 res(16, 16, 16);
+    Vector3D h(0.25, 0.25, 0.25);
+    Vector3D shift(0.3, -0.2, 0.1);
+
+    CellCenteredScalarGrid3 input(res, h);
+    CellCenteredScalarGrid3 output(res, h);
+    input.fill(wave);
+
+    ConstantVectorField3 flow(shift);
+    solver->advect(input, flow, 1.0, &output);
+
+    double maxError = 0.0;
+    auto pos = output.dataPosition();
+    for (size_t k = 3; k + 3 < res.z; ++k) {
+        for (size_t j = 3; j + 3 < res.y; ++j) {
+            for (size_t i = 3; i + 3 < res.x; ++i) {
+                double error = std::fabs(
+                    output(i, j, k) - wave(pos(i, j, k) - shift));
+                maxError = std::max(maxError, error);
+            }
+        }
+    }
+    return maxError;
+}
+
+template <typename Solver>
+void testBatchedAdvect() {
+    Size3 res(10, 12, 8);
+    Vector3D h(0.5, 0.5, 0.5);
+    Vector3D o(-1.0, 0.0, 1.0);
+
+    CellCenteredScalarGrid3 density0(res, h, o);
+    CellCenteredScalarGrid3 temperature0(res, h, o);
+    VertexCenteredScalarGrid3 fuel0(res, h, o);
+    CellCenteredVectorGrid3 smoke0(res, h, o);
+    density0.fill(density);
+    temperature0.fill([](const Vector3D& x) { return 2.0 * density(x); });
+    fuel0.fill(density);
+    smoke0.fill(smoke);
+
+    SwirlField3 flow;
+    Solver solver;
+
+    CellCenteredScalarGrid3 density1(res, h, o);
+    CellCenteredScalarGrid3 temperature1(res, h, o);
+    VertexCenteredScalarGrid3 fuel1(res, h, o);
+    CellCenteredVectorGrid3 smoke1(res, h, o);
+    solver.advect(density0, flow, 0.3, &density1);
+    solver.advect(temperature0, flow, 0.3, &temperature1);
+    solver.advect(fuel0, flow, 0.3, &fuel1);
+    solver.advect(smoke0, flow, 0.3, &smoke1);
+
+    CellCenteredScalarGrid3 density2(res, h, o);
+    CellCenteredScalarGrid3 temperature2(res, h, o);
+    VertexCenteredScalarGrid3 fuel2(res, h, o);
+    CellCenteredVectorGrid3 smoke2(res, h, o);
+    solver.advect(
+        {&density0, &temperature0, &fuel0},
+        {&smoke0},
+        flow,
+        0.3,
+        {&density2, &temperature2, &fuel2},
+        {&smoke2});
+
+    density1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(density1(i, j, k), density2(i, j, k));
+        EXPECT_DOUBLE_EQ(temperature1(i, j, k), temperature2(i, j, k));
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).x, smoke2(i, j, k).x);
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).y, smoke2(i, j, k).y);
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).z, smoke2(i, j, k).z);
+    });
+
+    fuel1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(fuel1(i, j, k), fuel2(i, j, k));
+    });
+}
+
+}  // namespace
+
+TEST(MacCormackAdvection3, BatchedAdvectMatchesSeparateAdvect) {
+    testBatchedAdvect<MacCormackAdvection3>();
+}
+
+TEST(BfeccAdvection3, BatchedAdvectMatchesSeparateAdvect) {
+    testBatchedAdvect<BfeccAdvection3>();
+}
+
+TEST(ErrorCorrectedSemiLagrangian3, ReducesError) {
+    SemiLagrangian3 semiLagrangian;
+    MacCormackAdvection3 macCormack;
+    BfeccAdvection3 bfecc;
+    macCormack.setIsUsingLimiter(false);
+    bfecc.setIsUsingLimiter(false);
+
+    double slError = uniformAdvectionError(&semiLagrangian);
+    EXPECT_LT(uniformAdvectionError(&macCormack), 0.5 * slError);
+    EXPECT_LT(uniformAdvectionError(&bfecc), 0.5 * slError);
+}
+
+TEST(ErrorCorrectedSemiLagrangian3, Limiter) {
+    Size3 res(12, 12, 12);
+    Vector3D h(0.25, 0.25, 0.25);
+
+    // A step makes the unlimited corrections overshoot
+    CellCenteredScalarGrid3 input(res, h);
+    CellCenteredScalarGrid3 output(res, h);
+    input.fill([](const Vector3D& x) { return (x.x < 1.5) ? 1.0 : 0.0; });
+
+    ConstantVectorField3 flow(Vector3D(0.3, 0.1, 0.0));
+    MacCormackAdvection3 macCormack;
+    BfeccAdvection3 bfecc;
+    EXPECT_TRUE(macCormack.isUsingLimiter());
+    EXPECT_TRUE(bfecc.isUsingLimiter());
+
+    std::vector<AdvectionSolver3*> solvers = {&macCormack, &bfecc};
+    for (AdvectionSolver3* solver : solvers) {
+        solver->advect(input, flow, 1.0, &output);
+        output.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_LE(-1e-12, output(i, j, k));
+            EXPECT_GE(1.0 + 1e-12, output(i, j, k));
+        });
+    }
+
+    bfecc.setIsUsingLimiter(false);
+    EXPECT_FALSE(bfecc.isUsingLimiter());
+    bfecc.advect(input, flow, 1.0, &output);
+    double maxValue = 0.0;
+    output.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        maxValue = std::max(maxValue, output(i, j, k));
+    });
+    EXPECT_LT(1.0, maxValue);
+}
+
+TEST(ErrorCorrectedSemiLagrangian3, FaceCentered) {
+    Size3 res(10, 12, 8);
+    Vector3D h(0.5, 0.5, 0.5);
+
+    FaceCenteredGrid3 input(res, h);
+    FaceCenteredGrid3 output(res, h);
+
+    // A linear field is reproduced by a uniform flow
+    ConstantVectorField3 flow(Vector3D(0.2, 0.3, -0.1));
+    input.fill([](const Vector3D& x) {
+        return Vector3D(x.x + x.y, 2.0 * x.z, x.x - x.z);
+    });
+
+    BfeccAdvection3 solver;
+    solver.advect(input, flow, 1.0, &output);
+
+    auto uPos = output.uPosition();
+    for (size_t k = 2; k + 2 < res.z; ++k) {
+        for (size_t j = 2; j + 2 < res.y; ++j) {
+            for (size_t i = 2; i + 2 < res.x; ++i) {
+                Vector3D x = uPos(i, j, k) - Vector3D(0.2, 0.3, -0.1);
+                EXPECT_NEAR(x.x + x.y, output.u(i, j, k), 1e-12);
+            }
+        }
+    }
+
+    auto wPos = output.wPosition();
+    for (size_t k = 2; k + 2 < res.z; ++k) {
+        for (size_t j = 2; j + 2 < res.y; ++j) {
+            for (size_t i = 2; i + 2 < res.x; ++i) {
+                Vector3D x = wPos(i, j, k) - Vector3D(0.2, 0.3, -0.1);
+                EXPECT_NEAR(x.x - x.z, output.w(i, j, k), 1e-12);
+            }
+        }
+    }
+}
@@ -1,7 +1,10 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array1.h>
 #include <jet/face_centered_grid3.h>
 #include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
 
 using namespace jet;
 
@@ -261,6 +264,53 @@ TEST(FaceCenteredGrid3, Sample) {
         EXPECT_NEAR(expected.y, val.y, 1e-6);
         EXPECT_NEAR(expected.z, val.z, 1e-6);
     });
+
+    auto sampler = grid.sampler();
+    Vector3D x(3.3, 7.1, 4.2);
+    Vector3D val = sampler(x);
+    EXPECT_DOUBLE_EQ(grid.uLinearSampler()(x), val.x);
+    EXPECT_DOUBLE_EQ(grid.vLinearSampler()(x), val.y);
+    EXPECT_DOUBLE_EQ(grid.wLinearSampler()(x), val.z);
+    EXPECT_EQ(grid.sample(x), val);
+
+    Array1<Vector3D> points = {
+        Vector3D(3.3, 7.1, 4.2), Vector3D(0.5, 20.0, 1.0), Vector3D()
+    };
+    Array1<Vector3D> values(points.size());
+    grid.batchSample(points.constAccessor(), values.accessor());
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(grid.sample(points[i]), values[i]);
+    }
+}
+
+TEST(FaceCenteredGrid3, CopyOnWrite) {
+    FaceCenteredGrid3 grid1(5, 8, 6, 2.0, 3.0, 1.5);
+    grid1.fill(Vector3D(1.0, 2.0, 3.0));
+    auto grid2 = std::dynamic_pointer_cast<FaceCenteredGrid3>(grid1.clone());
+
+    // Only the written component gets copied
+    grid2->v(2, 3, 4) = 5.0;
+    EXPECT_EQ(
+        grid1.uConstAccessor().data(), grid2->uConstAccessor().data());
+    EXPECT_NE(
+        grid1.vConstAccessor().data(), grid2->vConstAccessor().data());
+    EXPECT_EQ(
+        grid1.wConstAccessor().data(), grid2->wConstAccessor().data());
+
+    const FaceCenteredGrid3& constGrid1 = grid1;
+    EXPECT_DOUBLE_EQ(2.0, constGrid1.v(2, 3, 4));
+    EXPECT_DOUBLE_EQ(5.0, grid2->vConstAccessor()(2, 3, 4));
+
+    // The samplers follow the copied data
+    Vector3D x = grid2->vPosition()(2, 3, 4);
+    EXPECT_DOUBLE_EQ(5.0, grid2->sample(x).y);
+    EXPECT_DOUBLE_EQ(2.0, grid1.sample(x).y);
+
+    FaceCenteredGrid3 grid3;
+    grid3.set(grid1);
+    grid1.fill(Vector3D(-1.0, -2.0, -3.0));
+    EXPECT_EQ(Vector3D(1.0, 2.0, 3.0), grid3.valueAtCellCenter(2, 3, 4));
+    EXPECT_EQ(Vector3D(-1.0, -2.0, -3.0), grid1.valueAtCellCenter(2, 3, 4));
 }
 
 TEST(FaceCenteredGrid3, Builder) {
@@ -349,3 +399,31 @@ TEST(FaceCenteredGrid3, Serialization) {
     EXPECT_DOUBLE_EQ(1.0, grid2.gridSpacing().y);
     EXPECT_DOUBLE_EQ(1.0, grid2.gridSpacing().z);
 }
+
+TEST(FaceCenteredGrid3, ComputeDivergenceAndCurl) {
+    for (const Size3& res : {Size3(5, 4, 6), Size3(1, 3, 2)}) {
+        FaceCenteredGrid3 grid(res, Vector3D(0.5, 0.25, 2.0));
+        grid.fill([](const Vector3D& x) {
+            return Vector3D(
+                std::sin(x.x) * x.y + x.z,
+                std::cos(x.z) * x.x,
+                x.x * x.y - std::sin(x.y));
+        });
+
+        Array3<double> divergence(res);
+        Array3<Vector3D> curl(res);
+        grid.computeDivergence(divergence.accessor());
+        grid.computeCurl(curl.accessor());
+
+        // Bit-wise identical to the per-point accessors
+        divergence.forEachIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_EQ(grid.divergenceAtCellCenter(i, j, k),
+                      divergence(i, j, k));
+
+            Vector3D expected = grid.curlAtCellCenter(i, j, k);
+            EXPECT_EQ(expected.x, curl(i, j, k).x);
+            EXPECT_EQ(expected.y, curl(i, j, k).y);
+            EXPECT_EQ(expected.z, curl(i, j, k).z);
+        });
+    }
+}
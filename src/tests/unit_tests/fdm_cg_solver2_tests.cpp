@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <fdm_test_systems.h>
 #include <jet/fdm_cg_solver2.h>
 #include <gtest/gtest.h>
 
@@ -39,3 +40,67 @@ TEST(FdmCgSolver2, Constructors) {
 
     EXPECT_GT(solver.tolerance(), solver.lastResidual());
 }
+
+TEST(FdmCgSolver2, MixedPrecision) {
+    FdmLinearSystem2 system;
+    buildPoissonSystem(Size2(17, 13), &system);
+
+    FdmCgSolver2 solver(300, 1e-9);
+    EXPECT_FALSE(solver.isUsingMixedPrecision());
+    EXPECT_TRUE(solver.solve(&system));
+
+    FdmVector2 x0(system.x);
+
+    // The refinement reaches the same double-precision tolerance even though
+    // the inner iterations run in single precision
+    solver.setIsUsingMixedPrecision(true);
+    EXPECT_TRUE(solver.isUsingMixedPrecision());
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    system.x.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(x0(i, j), system.x(i, j), 1e-8);
+    });
+}
+
+TEST(FdmCgSolver2, SolveCompressed) {
+    FdmLinearSystem2 system;
+    buildPoissonSystem(Size2(17, 13), &system);
+
+    FdmCgSolver2 solver(300, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    // Same system in the compressed form with the rows in the grid order
+    Size2 size = system.A.size();
+    auto index = [&](size_t i, size_t j) {
+        return i + size.x * j;
+    };
+
+    FdmCompressedLinearSystem compSystem;
+    compSystem.x.resize(size.x * size.y);
+    compSystem.b.resize(size.x * size.y);
+    system.A.forEachIndex([&](size_t i, size_t j) {
+        FdmCompressedMatrix& A = compSystem.A;
+        if (j > 0) {
+            A.addElement(index(i, j - 1), system.A(i, j - 1).up);
+        }
+        if (i > 0) {
+            A.addElement(index(i - 1, j), system.A(i - 1, j).right);
+        }
+        A.addElement(index(i, j), system.A(i, j).center);
+        if (i + 1 < size.x) {
+            A.addElement(index(i + 1, j), system.A(i, j).right);
+        }
+        if (j + 1 < size.y) {
+            A.addElement(index(i, j + 1), system.A(i, j).up);
+        }
+        A.finishRow();
+
+        compSystem.b[index(i, j)] = system.b(i, j);
+    });
+
+    EXPECT_TRUE(solver.solveCompressed(&compSystem));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    system.x.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(system.x(i, j), compSystem.x[index(i, j)], 1e-8);
+    });
+}
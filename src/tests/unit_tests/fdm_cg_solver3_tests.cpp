@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <fdm_test_systems.h>
 #include <jet/fdm_cg_solver3.h>
 #include <gtest/gtest.h>
 
@@ -47,3 +48,73 @@ TEST(FdmCgSolver3, Constructors) {
 
     EXPECT_GT(solver.tolerance(), solver.lastResidual());
 }
+
+TEST(FdmCgSolver3, MixedPrecision) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(9, 8, 7), &system);
+
+    FdmCgSolver3 solver(300, 1e-9);
+    EXPECT_FALSE(solver.isUsingMixedPrecision());
+    EXPECT_TRUE(solver.solve(&system));
+
+    FdmVector3 x0(system.x);
+
+    // The refinement reaches the same double-precision tolerance even though
+    // the inner iterations run in single precision
+    solver.setIsUsingMixedPrecision(true);
+    EXPECT_TRUE(solver.isUsingMixedPrecision());
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(x0(i, j, k), system.x(i, j, k), 1e-8);
+    });
+}
+
+TEST(FdmCgSolver3, SolveCompressed) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(9, 8, 7), &system);
+
+    FdmCgSolver3 solver(300, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    // Same system in the compressed form with the rows in the grid order
+    Size3 size = system.A.size();
+    auto index = [&](size_t i, size_t j, size_t k) {
+        return i + size.x * (j + size.y * k);
+    };
+
+    FdmCompressedLinearSystem compSystem;
+    compSystem.x.resize(size.x * size.y * size.z);
+    compSystem.b.resize(size.x * size.y * size.z);
+    system.A.forEachIndex([&](size_t i, size_t j, size_t k) {
+        FdmCompressedMatrix& A = compSystem.A;
+        if (k > 0) {
+            A.addElement(index(i, j, k - 1), system.A(i, j, k - 1).front);
+        }
+        if (j > 0) {
+            A.addElement(index(i, j - 1, k), system.A(i, j - 1, k).up);
+        }
+        if (i > 0) {
+            A.addElement(index(i - 1, j, k), system.A(i - 1, j, k).right);
+        }
+        A.addElement(index(i, j, k), system.A(i, j, k).center);
+        if (i + 1 < size.x) {
+            A.addElement(index(i + 1, j, k), system.A(i, j, k).right);
+        }
+        if (j + 1 < size.y) {
+            A.addElement(index(i, j + 1, k), system.A(i, j, k).up);
+        }
+        if (k + 1 < size.z) {
+            A.addElement(index(i, j, k + 1), system.A(i, j, k).front);
+        }
+        A.finishRow();
+
+        compSystem.b[index(i, j, k)] = system.b(i, j, k);
+    });
+
+    EXPECT_TRUE(solver.solveCompressed(&compSystem));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(system.x(i, j, k), compSystem.x[index(i, j, k)], 1e-8);
+    });
+}
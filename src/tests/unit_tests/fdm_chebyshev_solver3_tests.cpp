@@ -0,0 +1,55 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_chebyshev_solver3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmChebyshevSolver3, Solve) {
+    FdmLinearSystem3 system;
+    buildDiffusionSystem(Size3(10, 9, 8), 2.0, &system);
+
+    FdmChebyshevSolver3 solver(200, 5, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_LT(solver.lastNumberOfIterations(), 200u);
+
+    FdmLinearSystem3 reference;
+    buildDiffusionSystem(Size3(10, 9, 8), 2.0, &reference);
+    FdmIccgSolver3 referenceSolver(200, 1e-9);
+    EXPECT_TRUE(referenceSolver.solve(&reference));
+
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(reference.x(i, j, k), system.x(i, j, k), 1e-8);
+    });
+}
+
+TEST(FdmChebyshevSolver3, SolveWithSameMatrix) {
+    FdmLinearSystem3 system;
+    buildDiffusionSystem(Size3(6, 6, 6), 1.0, &system);
+
+    FdmChebyshevSolver3 solver(200, 5, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    system.b.forEachIndex([&](size_t i, size_t j, size_t k) {
+        system.b(i, j, k) = static_cast<double>(i + j) - 0.5 * k;
+    });
+    EXPECT_TRUE(solver.solveWithSameMatrix(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+}
+
+TEST(FdmChebyshevSolver3, DiagonalSystem) {
+    FdmLinearSystem3 system;
+    buildDiffusionSystem(Size3(4, 4, 4), 0.0, &system);
+    system.x.set(0.0);
+
+    FdmChebyshevSolver3 solver(10, 1, 1e-12);
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_EQ(2u, solver.lastNumberOfIterations());
+
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(system.b(i, j, k), system.x(i, j, k));
+    });
+}
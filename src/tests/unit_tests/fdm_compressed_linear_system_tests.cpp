@@ -0,0 +1,77 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/fdm_compressed_linear_system.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmCompressedMatrix, Build) {
+    FdmCompressedMatrix m;
+    EXPECT_EQ(0u, m.rows());
+
+    m.addElement(0, 2.0);
+    m.addElement(2, -1.0);
+    m.finishRow();
+    m.addElement(1, 3.0);
+    m.finishRow();
+    m.addElement(0, -1.0);
+    m.addElement(2, 2.0);
+    m.finishRow();
+
+    EXPECT_EQ(3u, m.rows());
+    EXPECT_EQ(5u, m.nonZeros.size());
+    EXPECT_EQ(5u, m.columnIndices.size());
+    EXPECT_EQ(2u, m.rowPointers[1]);
+    EXPECT_EQ(3u, m.rowPointers[2]);
+    EXPECT_EQ(5u, m.rowPointers[3]);
+
+    m.clear();
+    EXPECT_EQ(0u, m.rows());
+    EXPECT_EQ(0u, m.nonZeros.size());
+}
+
+TEST(FdmCompressedBlas, MvmAndResidual) {
+    // 1-D Poisson matrix
+    const size_t n = 10;
+    FdmCompressedMatrix m;
+    for (size_t i = 0; i < n; ++i) {
+        if (i > 0) {
+            m.addElement(i - 1, -1.0);
+        }
+        m.addElement(i, 2.0);
+        if (i + 1 < n) {
+            m.addElement(i + 1, -1.0);
+        }
+        m.finishRow();
+    }
+
+    FdmCompressedVector v(n), b(n);
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = std::sin(1.0 * i);
+        b[i] = std::cos(2.0 * i);
+    }
+
+    FdmCompressedVector result(n);
+    FdmCompressedBlas::mvm(m, v, &result);
+    for (size_t i = 0; i < n; ++i) {
+        double expected = 2.0 * v[i]
+            - ((i > 0) ? v[i - 1] : 0.0)
+            - ((i + 1 < n) ? v[i + 1] : 0.0);
+        EXPECT_DOUBLE_EQ(expected, result[i]);
+    }
+
+    FdmCompressedVector r(n);
+    FdmCompressedBlas::residual(m, v, b, &r);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(b[i] - result[i], r[i], 1e-12);
+    }
+
+    double expectedDot = 0.0;
+    double expectedLInf = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        expectedDot += v[i] * b[i];
+        expectedLInf = std::max(expectedLInf, std::fabs(r[i]));
+    }
+    EXPECT_NEAR(expectedDot, FdmCompressedBlas::dot(v, b), 1e-12);
+    EXPECT_DOUBLE_EQ(expectedLInf, FdmCompressedBlas::lInfNorm(r));
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_cg_solver3.h>
+#include <jet/fdm_cuda_pcg_solver3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmCudaPcgSolver3, Solve) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(9, 8, 7), &system);
+
+    FdmCudaPcgSolver3 solver(200, 1e-9);
+    EXPECT_EQ(FdmCudaPcgSolver3::isDeviceAvailable(), solver.isUsingDevice());
+    EXPECT_EQ(200u, solver.maxNumberOfIterations());
+    EXPECT_DOUBLE_EQ(1e-9, solver.tolerance());
+
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_LT(0u, solver.lastNumberOfIterations());
+
+    FdmLinearSystem3 reference;
+    buildPoissonSystem(Size3(9, 8, 7), &reference);
+    FdmCgSolver3 cgSolver(200, 1e-9);
+    cgSolver.solve(&reference);
+
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(reference.x(i, j, k), system.x(i, j, k), 1e-7);
+    });
+}
+
+TEST(FdmCudaPcgSolver3, SolveWithSameMatrix) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(9, 8, 7), &system);
+
+    FdmCudaPcgSolver3 solver(200, 1e-9);
+    solver.solve(&system);
+    FdmVector3 firstSolution(system.x);
+
+    // The second solve starts over from zero and reaches the same solution
+    system.x.set(1.0);
+    EXPECT_TRUE(solver.solveWithSameMatrix(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(firstSolution(i, j, k), system.x(i, j, k));
+    });
+}
@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <fdm_test_systems.h>
 #include <jet/fdm_gauss_seidel_solver3.h>
 #include <gtest/gtest.h>
 
@@ -46,4 +47,41 @@ TEST(FdmGaussSeidelSolver3, Constructors) {
     solver.solve(&system);
 
     EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_DOUBLE_EQ(1.0, solver.sorFactor());
+    EXPECT_FALSE(solver.useRedBlackOrdering());
+}
+
+TEST(FdmGaussSeidelSolver3, RedBlackOrdering) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(7, 6, 5), &system);
+
+    FdmGaussSeidelSolver3 solver(1000, 10, 1e-9, 1.0, true);
+    EXPECT_TRUE(solver.useRedBlackOrdering());
+    EXPECT_TRUE(solver.solve(&system));
+
+    FdmLinearSystem3 reference;
+    buildPoissonSystem(Size3(7, 6, 5), &reference);
+    FdmGaussSeidelSolver3 referenceSolver(1000, 10, 1e-9);
+    EXPECT_TRUE(referenceSolver.solve(&reference));
+
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(reference.x(i, j, k), system.x(i, j, k), 1e-7);
+    });
+}
+
+TEST(FdmGaussSeidelSolver3, Sor) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(7, 6, 5), &system);
+    FdmGaussSeidelSolver3 solver(1000, 1, 1e-9, 1.0, true);
+    EXPECT_TRUE(solver.solve(&system));
+
+    FdmLinearSystem3 sorSystem;
+    buildPoissonSystem(Size3(7, 6, 5), &sorSystem);
+    FdmGaussSeidelSolver3 sorSolver(1000, 1, 1e-9, 1.5, true);
+    EXPECT_DOUBLE_EQ(1.5, sorSolver.sorFactor());
+    EXPECT_TRUE(sorSolver.solve(&sorSystem));
+
+    // Over-relaxation should converge in fewer iterations
+    EXPECT_LT(
+        sorSolver.lastNumberOfIterations(), solver.lastNumberOfIterations());
 }
@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <fdm_test_systems.h>
 #include <jet/fdm_jacobi_solver3.h>
 #include <gtest/gtest.h>
 
@@ -47,3 +48,30 @@ TEST(FdmJacobiSolver3, Constructors) {
 
     EXPECT_GT(solver.tolerance(), solver.lastResidual());
 }
+
+TEST(FdmJacobiSolver3, TemporalBlocking) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(40, 35, 33), &system);
+
+    FdmJacobiSolver3 solver(25, 10, 1e-9);
+    EXPECT_EQ(1u, solver.temporalBlockingDepth());
+    solver.solve(&system);
+    FdmVector3 x0(system.x);
+    double residual0 = solver.lastResidual();
+
+    // The tiles run the same iterations, so the result does not change
+    for (unsigned int depth : { 3u, 4u, 25u }) {
+        solver.setTemporalBlockingDepth(depth);
+        EXPECT_EQ(depth, solver.temporalBlockingDepth());
+        system.x.set(0.0);
+        solver.solve(&system);
+        EXPECT_EQ(25u, solver.lastNumberOfIterations());
+        EXPECT_DOUBLE_EQ(residual0, solver.lastResidual());
+        system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_EQ(x0(i, j, k), system.x(i, j, k));
+        });
+    }
+
+    solver.setTemporalBlockingDepth(0);
+    EXPECT_EQ(1u, solver.temporalBlockingDepth());
+}
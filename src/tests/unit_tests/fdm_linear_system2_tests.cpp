@@ -0,0 +1,52 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/fdm_linear_system2.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmBlas2, MvmAndDot) {
+    FdmMatrix2 m(5, 4);
+    FdmVector2 v(5, 4);
+
+    m.forEachIndex([&](size_t i, size_t j) {
+        m(i, j).center = 4.0 + 0.1 * i;
+        m(i, j).right = -1.0 - 0.01 * j;
+        m(i, j).up = -0.5 * i;
+        v(i, j) = std::sin(1.0 * i + 2.0 * j);
+    });
+
+    FdmVector2 expected(5, 4);
+    FdmBlas2::mvm(m, v, &expected);
+    double expectedDot = FdmBlas2::dot(v, expected);
+
+    FdmVector2 result(5, 4);
+    double dot = FdmBlas2::mvmAndDot(m, v, &result);
+
+    EXPECT_NEAR(expectedDot, dot, 1e-12);
+    result.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_DOUBLE_EQ(expected(i, j), result(i, j));
+    });
+}
+
+TEST(FdmBlas2, AxpyAndDot) {
+    FdmVector2 x(5, 4);
+    FdmVector2 y(5, 4);
+
+    x.forEachIndex([&](size_t i, size_t j) {
+        x(i, j) = std::sin(1.0 * i + 2.0 * j);
+        y(i, j) = std::cos(3.0 * i + 2.0 * j);
+    });
+
+    FdmVector2 expected(5, 4);
+    FdmBlas2::axpy(-0.7, x, y, &expected);
+    double expectedDot = FdmBlas2::dot(expected, expected);
+
+    // In-place, as used by cg
+    double dot = FdmBlas2::axpyAndDot(-0.7, x, y, &y);
+
+    EXPECT_NEAR(expectedDot, dot, 1e-12);
+    y.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_DOUBLE_EQ(expected(i, j), y(i, j));
+    });
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/fdm_linear_system3.h>
+#include <jet/simd.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmBlas3, MvmAndDot) {
+    FdmMatrix3 m(5, 4, 3);
+    FdmVector3 v(5, 4, 3);
+
+    m.forEachIndex([&](size_t i, size_t j, size_t k) {
+        m(i, j, k).center = 6.0 + 0.1 * i;
+        m(i, j, k).right = -1.0 - 0.01 * j;
+        m(i, j, k).up = -1.0 + 0.02 * k;
+        m(i, j, k).front = -0.5 * i;
+        v(i, j, k) = std::sin(1.0 * i + 2.0 * j + 3.0 * k);
+    });
+
+    FdmVector3 expected(5, 4, 3);
+    FdmBlas3::mvm(m, v, &expected);
+    double expectedDot = FdmBlas3::dot(v, expected);
+
+    FdmVector3 result(5, 4, 3);
+    double dot = FdmBlas3::mvmAndDot(m, v, &result);
+
+    EXPECT_NEAR(expectedDot, dot, 1e-12);
+    result.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(expected(i, j, k), result(i, j, k));
+    });
+}
+
+TEST(FdmBlas3, AxpyAndDot) {
+    FdmVector3 x(5, 4, 3);
+    FdmVector3 y(5, 4, 3);
+
+    x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        x(i, j, k) = std::sin(1.0 * i + 2.0 * j + 3.0 * k);
+        y(i, j, k) = std::cos(3.0 * i + 2.0 * j + 1.0 * k);
+    });
+
+    FdmVector3 expected(5, 4, 3);
+    FdmBlas3::axpy(-0.7, x, y, &expected);
+    double expectedDot = FdmBlas3::dot(expected, expected);
+
+    // In-place, as used by cg
+    double dot = FdmBlas3::axpyAndDot(-0.7, x, y, &y);
+
+    EXPECT_NEAR(expectedDot, dot, 1e-12);
+    y.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(expected(i, j, k), y(i, j, k));
+    });
+}
+
+TEST(FdmBlas3, SimdKernels) {
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    const SimdInstructionSet instructionSets[] = {
+        SimdInstructionSet::None,
+        SimdInstructionSet::Sse2,
+        SimdInstructionSet::Neon,
+        SimdInstructionSet::Avx,
+        SimdInstructionSet::Avx512
+    };
+
+    // The rows are shorter than, equal to and longer than the registers
+    for (const Size3& size : {
+             Size3(1, 1, 1), Size3(2, 3, 1), Size3(9, 1, 2),
+             Size3(17, 5, 4), Size3(34, 3, 3)}) {
+        FdmMatrix3 m(size);
+        FdmVector3 x(size), b(size);
+        m.forEachIndex([&](size_t i, size_t j, size_t k) {
+            m(i, j, k).center = 6.0 + 0.1 * i;
+            m(i, j, k).right = -1.0 - 0.01 * j;
+            m(i, j, k).up = -1.0 + 0.02 * k;
+            m(i, j, k).front = -0.5 * i;
+            x(i, j, k) = std::sin(1.0 * i + 2.0 * j + 3.0 * k);
+            b(i, j, k) = std::cos(3.0 * i + 2.0 * j + 1.0 * k);
+        });
+
+        FdmVector3 expectedMvm(size), expectedResidual(size);
+        FdmVector3 expectedAxpy(size);
+        expectedMvm.forEachIndex([&](size_t i, size_t j, size_t k) {
+            expectedMvm(i, j, k)
+                = m(i, j, k).center * x(i, j, k)
+                + ((i > 0) ? m(i - 1, j, k).right * x(i - 1, j, k) : 0.0)
+                + ((i + 1 < size.x) ? m(i, j, k).right * x(i + 1, j, k) : 0.0)
+                + ((j > 0) ? m(i, j - 1, k).up * x(i, j - 1, k) : 0.0)
+                + ((j + 1 < size.y) ? m(i, j, k).up * x(i, j + 1, k) : 0.0)
+                + ((k > 0) ? m(i, j, k - 1).front * x(i, j, k - 1) : 0.0)
+                + ((k + 1 < size.z) ? m(i, j, k).front * x(i, j, k + 1) : 0.0);
+            expectedResidual(i, j, k) = b(i, j, k) - expectedMvm(i, j, k);
+            expectedAxpy(i, j, k) = -0.7 * x(i, j, k) + b(i, j, k);
+        });
+
+        FdmVector3 scalarMvm(size), scalarResidual(size);
+        for (SimdInstructionSet instructionSet : instructionSets) {
+            if (!isSimdInstructionSetSupported(instructionSet)) {
+                continue;
+            }
+            setSimdInstructionSet(instructionSet);
+
+            FdmVector3 mvm(size), residual(size), axpy(size);
+            FdmBlas3::mvm(m, x, &mvm);
+            FdmBlas3::residual(m, x, b, &residual);
+            FdmBlas3::axpy(-0.7, x, b, &axpy);
+            if (instructionSet == SimdInstructionSet::None) {
+                scalarMvm.set(mvm);
+                scalarResidual.set(residual);
+            }
+
+            // All the instruction sets give the scalar results exactly
+            mvm.forEachIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_EQ(scalarMvm(i, j, k), mvm(i, j, k));
+                EXPECT_EQ(scalarResidual(i, j, k), residual(i, j, k));
+                EXPECT_DOUBLE_EQ(expectedMvm(i, j, k), mvm(i, j, k));
+                EXPECT_NEAR(
+                    expectedResidual(i, j, k), residual(i, j, k), 1e-12);
+                EXPECT_EQ(expectedAxpy(i, j, k), axpy(i, j, k));
+            });
+        }
+    }
+
+    setSimdInstructionSet(oldInstructionSet);
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_matrix_free_cg_solver2.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+namespace {
+
+// Poisson operator with closed walls except the top, which is open to air
+class PoissonOperator final : public FdmMatrixFreeOperator2 {
+ public:
+    explicit PoissonOperator(const Size2& size) : _size(size) {
+    }
+
+    Size2 size() const override {
+        return _size;
+    }
+
+    void mvm(const FdmVector2& v, FdmVector2* result) const override {
+        result->forEachIndex([&](size_t i, size_t j) {
+            double sum = diagonal(i, j) * v(i, j);
+            sum -= (i > 0) ? v(i - 1, j) : 0.0;
+            sum -= (i + 1 < _size.x) ? v(i + 1, j) : 0.0;
+            sum -= (j > 0) ? v(i, j - 1) : 0.0;
+            sum -= (j + 1 < _size.y) ? v(i, j + 1) : 0.0;
+            (*result)(i, j) = sum;
+        });
+    }
+
+    void diagonal(FdmVector2* result) const override {
+        result->forEachIndex([&](size_t i, size_t j) {
+            (*result)(i, j) = diagonal(i, j);
+        });
+    }
+
+ private:
+    Size2 _size;
+
+    double diagonal(size_t i, size_t j) const {
+        return ((i > 0) ? 1.0 : 0.0) + ((i + 1 < _size.x) ? 1.0 : 0.0)
+            + ((j > 0) ? 1.0 : 0.0) + 1.0;
+    }
+};
+
+}  // namespace
+
+TEST(FdmMatrixFreeCgSolver2, Solve) {
+    PoissonOperator op(Size2(17, 13));
+
+    FdmLinearSystem2 system;
+    buildPoissonSystem(Size2(17, 13), &system);
+
+    FdmMatrixFreeCgSolver2 solver(100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+
+    unsigned int numberOfIterations = solver.lastNumberOfIterations();
+
+    FdmVector2 x;
+    EXPECT_TRUE(solver.solve(op, system.b, &x));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_EQ(numberOfIterations, solver.lastNumberOfIterations());
+
+    x.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(system.x(i, j), x(i, j), 1e-12);
+    });
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+namespace {
+
+// Poisson operator with closed walls except the top, which is open to air
+class PoissonOperator final : public FdmMatrixFreeOperator3 {
+ public:
+    explicit PoissonOperator(const Size3& size) : _size(size) {
+    }
+
+    Size3 size() const override {
+        return _size;
+    }
+
+    void mvm(const FdmVector3& v, FdmVector3* result) const override {
+        result->forEachIndex([&](size_t i, size_t j, size_t k) {
+            double sum = diagonal(i, j, k) * v(i, j, k);
+            sum -= (i > 0) ? v(i - 1, j, k) : 0.0;
+            sum -= (i + 1 < _size.x) ? v(i + 1, j, k) : 0.0;
+            sum -= (j > 0) ? v(i, j - 1, k) : 0.0;
+            sum -= (j + 1 < _size.y) ? v(i, j + 1, k) : 0.0;
+            sum -= (k > 0) ? v(i, j, k - 1) : 0.0;
+            sum -= (k + 1 < _size.z) ? v(i, j, k + 1) : 0.0;
+            (*result)(i, j, k) = sum;
+        });
+    }
+
+    void diagonal(FdmVector3* result) const override {
+        result->forEachIndex([&](size_t i, size_t j, size_t k) {
+            (*result)(i, j, k) = diagonal(i, j, k);
+        });
+    }
+
+ private:
+    Size3 _size;
+
+    double diagonal(size_t i, size_t j, size_t k) const {
+        return ((i > 0) ? 1.0 : 0.0) + ((i + 1 < _size.x) ? 1.0 : 0.0)
+            + ((j > 0) ? 1.0 : 0.0) + 1.0
+            + ((k > 0) ? 1.0 : 0.0) + ((k + 1 < _size.z) ? 1.0 : 0.0);
+    }
+};
+
+}  // namespace
+
+TEST(FdmMatrixFreeCgSolver3, Solve) {
+    PoissonOperator op(Size3(9, 8, 7));
+
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(9, 8, 7), &system);
+
+    FdmMatrixFreeCgSolver3 solver(100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+
+    unsigned int numberOfIterations = solver.lastNumberOfIterations();
+
+    FdmVector3 x;
+    EXPECT_TRUE(solver.solve(op, system.b, &x));
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_EQ(numberOfIterations, solver.lastNumberOfIterations());
+
+    x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(system.x(i, j, k), x(i, j, k), 1e-12);
+    });
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_mg_solver2.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmMgSolver2, Constructors) {
+    FdmMgSolver2 solver(5, 100, 1e-9);
+
+    EXPECT_EQ(5u, solver.maxNumberOfLevels());
+    EXPECT_EQ(100u, solver.maxNumberOfIterations());
+    EXPECT_DOUBLE_EQ(1e-9, solver.tolerance());
+}
+
+TEST(FdmMgSolver2, Solve) {
+    FdmLinearSystem2 system;
+    buildPoissonSystem(Size2(32, 23), &system);
+
+    FdmMgSolver2 solver(10, 100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    // 32x23 -> 16x12 -> 8x6 -> 4x3 -> 2x2 -> 1x1
+    EXPECT_EQ(6u, solver.numberOfLevels());
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_GT(solver.maxNumberOfIterations(), solver.lastNumberOfIterations());
+}
+
+TEST(FdmMgSolver2, SolveWithSingleLevel) {
+    FdmLinearSystem2 system;
+    buildPoissonSystem(Size2(4, 4), &system);
+
+    FdmMgSolver2 solver(1, 100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    EXPECT_EQ(1u, solver.numberOfLevels());
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+}
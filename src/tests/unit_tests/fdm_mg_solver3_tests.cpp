@@ -0,0 +1,39 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_mg_solver3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmMgSolver3, Constructors) {
+    FdmMgSolver3 solver(5, 100, 1e-9);
+
+    EXPECT_EQ(5u, solver.maxNumberOfLevels());
+    EXPECT_EQ(100u, solver.maxNumberOfIterations());
+    EXPECT_DOUBLE_EQ(1e-9, solver.tolerance());
+}
+
+TEST(FdmMgSolver3, Solve) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(16, 15, 9), &system);
+
+    FdmMgSolver3 solver(10, 100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    // 16x15x9 -> 8x8x5 -> 4x4x3 -> 2x2x2 -> 1x1x1
+    EXPECT_EQ(5u, solver.numberOfLevels());
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_GT(solver.maxNumberOfIterations(), solver.lastNumberOfIterations());
+}
+
+TEST(FdmMgSolver3, SolveWithSingleLevel) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(4, 4, 4), &system);
+
+    FdmMgSolver3 solver(1, 100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    EXPECT_EQ(1u, solver.numberOfLevels());
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+}
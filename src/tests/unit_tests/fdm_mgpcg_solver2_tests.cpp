@@ -0,0 +1,18 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_mgpcg_solver2.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmMgpcgSolver2, Solve) {
+    FdmLinearSystem2 system;
+    buildPoissonSystem(Size2(32, 23), &system);
+
+    FdmMgpcgSolver2 solver(10, 100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_GT(solver.maxNumberOfIterations(), solver.lastNumberOfIterations());
+}
@@ -0,0 +1,18 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <jet/fdm_mgpcg_solver3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(FdmMgpcgSolver3, Solve) {
+    FdmLinearSystem3 system;
+    buildPoissonSystem(Size3(16, 15, 9), &system);
+
+    FdmMgpcgSolver3 solver(10, 100, 1e-9);
+    EXPECT_TRUE(solver.solve(&system));
+
+    EXPECT_GT(solver.tolerance(), solver.lastResidual());
+    EXPECT_GT(solver.maxNumberOfIterations(), solver.lastNumberOfIterations());
+}
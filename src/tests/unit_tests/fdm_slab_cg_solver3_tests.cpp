@@ -0,0 +1,106 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <fdm_test_systems.h>
+#include <thread_communicator.h>
+#include <jet/fdm_cg_solver3.h>
+#include <jet/fdm_slab_cg_solver3.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Copies the layers of the global system owned by the decomposition.
+void extractSlab(
+    const FdmLinearSystem3& global,
+    const SlabDecomposition3& decomposition,
+    FdmLinearSystem3* local) {
+    Size3 size = decomposition.localSize();
+    local->A.resize(size);
+    local->x.resize(size);
+    local->b.resize(size);
+
+    size_t zBegin = decomposition.zBegin();
+    local->A.forEachIndex([&](size_t i, size_t j, size_t k) {
+        local->A(i, j, k) = global.A(i, j, k + zBegin);
+        local->b(i, j, k) = global.b(i, j, k + zBegin);
+    });
+}
+
+}  // namespace
+
+TEST(FdmSlabCgSolver3, SerialMatchesCg) {
+    Size3 size(6, 5, 7);
+    FdmLinearSystem3 system;
+    buildPoissonSystem(size, &system);
+
+    FdmLinearSystem3 slabSystem;
+    buildPoissonSystem(size, &slabSystem);
+
+    FdmCgSolver3 cgSolver(100, 1e-9);
+    cgSolver.solve(&system);
+
+    auto decomposition = std::make_shared<SlabDecomposition3>(
+        size, std::make_shared<SerialCommunicator>());
+    FdmSlabCgSolver3 solver(100, 1e-9, decomposition);
+    EXPECT_TRUE(solver.solve(&slabSystem));
+
+    EXPECT_EQ(cgSolver.lastNumberOfIterations(),
+              solver.lastNumberOfIterations());
+    EXPECT_NEAR(cgSolver.lastResidual(), solver.lastResidual(), 1e-12);
+    system.x.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(system.x(i, j, k), slabSystem.x(i, j, k), 1e-12);
+    });
+}
+
+TEST(FdmSlabCgSolver3, ThreeRanksMatchCg) {
+    const int numberOfRanks = 3;
+    Size3 size(6, 5, 8);
+
+    FdmLinearSystem3 system;
+    buildPoissonSystem(size, &system);
+
+    FdmCgSolver3 cgSolver(200, 1e-9);
+    cgSolver.solve(&system);
+
+    ThreadGroup group(numberOfRanks);
+    std::vector<FdmLinearSystem3> slabSystems(numberOfRanks);
+    std::vector<SlabDecomposition3Ptr> decompositions(numberOfRanks);
+    std::vector<unsigned int> iterations(numberOfRanks);
+    std::vector<double> residuals(numberOfRanks);
+    std::vector<std::thread> threads;
+
+    for (int rank = 0; rank < numberOfRanks; ++rank) {
+        decompositions[rank] = std::make_shared<SlabDecomposition3>(
+            size, std::make_shared<ThreadCommunicator>(&group, rank));
+        extractSlab(system, *decompositions[rank], &slabSystems[rank]);
+    }
+
+    for (int rank = 0; rank < numberOfRanks; ++rank) {
+        threads.emplace_back([&, rank] {
+            FdmSlabCgSolver3 solver(200, 1e-9, decompositions[rank]);
+            solver.solve(&slabSystems[rank]);
+            iterations[rank] = solver.lastNumberOfIterations();
+            residuals[rank] = solver.lastResidual();
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int rank = 0; rank < numberOfRanks; ++rank) {
+        EXPECT_EQ(iterations[0], iterations[rank]);
+        EXPECT_DOUBLE_EQ(residuals[0], residuals[rank]);
+        EXPECT_GT(1e-9, residuals[rank]);
+
+        size_t zBegin = decompositions[rank]->zBegin();
+        slabSystems[rank].x.forEachIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(
+                system.x(i, j, k + zBegin), slabSystems[rank].x(i, j, k), 1e-7);
+        });
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_TESTS_UNIT_TESTS_FDM_TEST_SYSTEMS_H_
+#define SRC_TESTS_UNIT_TESTS_FDM_TEST_SYSTEMS_H_
+
+#include <jet/fdm_linear_system2.h>
+#include <jet/fdm_linear_system3.h>
+
+#include <cmath>
+
+namespace jet {
+
+// Poisson equation with closed walls except the top, which is open to air.
+inline void buildPoissonSystem(const Size2& size, FdmLinearSystem2* system) {
+    system->A.resize(size);
+    system->x.resize(size);
+    system->b.resize(size);
+
+    system->A.forEachIndex([&](size_t i, size_t j) {
+        if (i > 0) {
+            system->A(i, j).center += 1.0;
+        }
+        if (i < system->A.width() - 1) {
+            system->A(i, j).center += 1.0;
+            system->A(i, j).right -= 1.0;
+        }
+
+        if (j > 0) {
+            system->A(i, j).center += 1.0;
+        }
+        system->A(i, j).center += 1.0;
+        if (j < system->A.height() - 1) {
+            system->A(i, j).up -= 1.0;
+        }
+
+        system->b(i, j) = std::sin(0.5 * i) * std::cos(0.3 * j);
+    });
+}
+
+// Poisson equation with closed walls except the top, which is open to air.
+inline void buildPoissonSystem(const Size3& size, FdmLinearSystem3* system) {
+    system->A.resize(size);
+    system->x.resize(size);
+    system->b.resize(size);
+
+    system->A.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (i > 0) {
+            system->A(i, j, k).center += 1.0;
+        }
+        if (i < system->A.width() - 1) {
+            system->A(i, j, k).center += 1.0;
+            system->A(i, j, k).right -= 1.0;
+        }
+
+        if (j > 0) {
+            system->A(i, j, k).center += 1.0;
+        }
+        system->A(i, j, k).center += 1.0;
+        if (j < system->A.height() - 1) {
+            system->A(i, j, k).up -= 1.0;
+        }
+
+        if (k > 0) {
+            system->A(i, j, k).center += 1.0;
+        }
+        if (k < system->A.depth() - 1) {
+            system->A(i, j, k).center += 1.0;
+            system->A(i, j, k).front -= 1.0;
+        }
+
+        system->b(i, j, k) = std::sin(0.5 * i) * std::cos(0.3 * j + 0.2 * k);
+    });
+}
+
+// Backward Euler diffusion matrix with the Dirichlet boundary, starting from
+// x = b.
+inline void buildDiffusionSystem(
+    const Size3& size, double c, FdmLinearSystem3* system) {
+    system->A.resize(size);
+    system->x.resize(size);
+    system->b.resize(size);
+
+    system->A.forEachIndex([&](size_t i, size_t j, size_t k) {
+        system->A(i, j, k).center = 1.0 + 6.0 * c;
+        if (i + 1 < size.x) {
+            system->A(i, j, k).right = -c;
+        }
+        if (j + 1 < size.y) {
+            system->A(i, j, k).up = -c;
+        }
+        if (k + 1 < size.z) {
+            system->A(i, j, k).front = -c;
+        }
+
+        system->b(i, j, k) = std::sin(0.3 * i) + std::cos(0.5 * j) * k;
+        system->x(i, j, k) = system->b(i, j, k);
+    });
+}
+
+}  // namespace jet
+
+#endif  // SRC_TESTS_UNIT_TESTS_FDM_TEST_SYSTEMS_H_
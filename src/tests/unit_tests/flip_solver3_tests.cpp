@@ -1,7 +1,14 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/flip_solver3.h>
+#include <jet/grid_point_generator3.h>
+#include <jet/implicit_surface_set3.h>
+#include <jet/parallel.h>
+#include <jet/plane3.h>
+#include <jet/sphere3.h>
+#include <jet/volume_particle_emitter3.h>
 #include <gtest/gtest.h>
+#include <vector>
 
 using namespace jet;
 
@@ -12,3 +19,118 @@ TEST(FlipSolver3, UpdateEmpty) {
     solver.update(frame);
     solver.update(frame);
 }
+
+TEST(FlipSolver3, DeterministicAcrossThreadCounts) {
+    unsigned int oldNumThreads = maxNumberOfThreads();
+    setIsDeterministic(true);
+
+    // Water-drop with a small grid
+    auto simulate = [](unsigned int numThreads) {
+        setMaxNumberOfThreads(numThreads);
+
+        FlipSolver3 solver;
+        auto grids = solver.gridSystemData();
+        const double dx = 1.0 / 8.0;
+        grids->resize(Size3(8, 16, 8), Vector3D(dx, dx, dx), Vector3D());
+        BoundingBox3D domain = grids->boundingBox();
+
+        auto surfaceSet = std::make_shared<ImplicitSurfaceSet3>();
+        surfaceSet->addExplicitSurface(
+            std::make_shared<Plane3>(
+                Vector3D(0, 1, 0), Vector3D(0, 0.25 * domain.height(), 0)));
+        surfaceSet->addExplicitSurface(
+            std::make_shared<Sphere3>(
+                domain.midPoint(), 0.15 * domain.width()));
+
+        auto emitter = std::make_shared<VolumeParticleEmitter3>(
+            surfaceSet, domain, 0.5 * dx, Vector3D());
+        emitter->setPointGenerator(std::make_shared<GridPointGenerator3>());
+        emitter->emit(Frame(), solver.particleSystemData());
+
+        for (Frame frame(0, 1.0 / 60.0); frame.index < 5; ++frame) {
+            solver.update(frame);
+        }
+
+        auto positions = solver.particleSystemData()->positions();
+        return std::vector<Vector3D>(positions.begin(), positions.end());
+    };
+
+    std::vector<Vector3D> serial = simulate(1);
+    std::vector<Vector3D> parallel = simulate(4);
+    ASSERT_LT(0u, serial.size());
+    ASSERT_EQ(serial.size(), parallel.size());
+
+    // Bit-wise identical
+    for (size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].x, parallel[i].x) << i;
+        EXPECT_EQ(serial[i].y, parallel[i].y) << i;
+        EXPECT_EQ(serial[i].z, parallel[i].z) << i;
+    }
+
+    setIsDeterministic(false);
+    setMaxNumberOfThreads(oldNumThreads);
+}
+
+namespace {
+
+// Exposes the particle-grid transfers of the solver
+class TransferFlipSolver3 final : public FlipSolver3 {
+ public:
+    using FlipSolver3::transferFromParticlesToGrids;
+    using FlipSolver3::transferFromGridsToParticles;
+};
+
+}  // namespace
+
+TEST(FlipSolver3, PicBlendingFactor) {
+    FlipSolver3 solver;
+    EXPECT_DOUBLE_EQ(0.0, solver.picBlendingFactor());
+
+    solver.setPicBlendingFactor(0.3);
+    EXPECT_DOUBLE_EQ(0.3, solver.picBlendingFactor());
+
+    solver.setPicBlendingFactor(2.0);
+    EXPECT_DOUBLE_EQ(1.0, solver.picBlendingFactor());
+
+    solver.setPicBlendingFactor(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, solver.picBlendingFactor());
+}
+
+TEST(FlipSolver3, TransferFromGridsToParticles) {
+    for (double factor : {0.0, 0.25, 1.0}) {
+        TransferFlipSolver3 solver;
+        solver.setPicBlendingFactor(factor);
+        solver.resizeGrid(
+            Size3(6, 7, 5), Vector3D(0.2, 0.2, 0.2), Vector3D());
+
+        Array1<Vector3D> positions;
+        Array1<Vector3D> velocities;
+        for (size_t i = 0; i < 50; ++i) {
+            double t = static_cast<double>(i) / 50.0;
+            positions.append(Vector3D(
+                0.1 + 1.0 * t, 0.2 + 1.1 * t * t, 0.9 - 0.8 * t));
+            velocities.append(Vector3D(t, 1.0 - t, 0.5 * t));
+        }
+        solver.particleSystemData()->addParticles(positions, velocities);
+
+        solver.transferFromParticlesToGrids();
+        FaceCenteredGrid3 oldVelocity(*solver.velocity());
+
+        // Changes the grid velocity as the projection would
+        solver.velocity()->fill([](const Vector3D& x) {
+            return Vector3D(x.y, -x.x, x.x * x.z);
+        });
+        solver.transferFromGridsToParticles();
+
+        auto newVelocities = solver.particleSystemData()->velocities();
+        for (size_t i = 0; i < positions.size(); ++i) {
+            Vector3D newVel = solver.velocity()->sample(positions[i]);
+            Vector3D flip
+                = velocities[i] + newVel - oldVelocity.sample(positions[i]);
+            Vector3D expected = (1.0 - factor) * flip + factor * newVel;
+            EXPECT_NEAR(expected.x, newVelocities[i].x, 1e-12);
+            EXPECT_NEAR(expected.y, newVelocities[i].y, 1e-12);
+            EXPECT_NEAR(expected.z, newVelocities[i].z, 1e-12);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/frame_filename.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace jet;
+
+TEST(FrameFilename, IsFrameFilenamePattern) {
+    EXPECT_TRUE(isFrameFilenamePattern("frame_%d.pos"));
+    EXPECT_TRUE(isFrameFilenamePattern("frame_%06d.pos"));
+    EXPECT_TRUE(isFrameFilenamePattern("%d"));
+
+    EXPECT_FALSE(isFrameFilenamePattern("frame.pos"));
+    EXPECT_FALSE(isFrameFilenamePattern("frame_%s.pos"));
+    EXPECT_FALSE(isFrameFilenamePattern("frame_%-6d.pos"));
+    EXPECT_FALSE(isFrameFilenamePattern("frame_%06d_%06d.pos"));
+    EXPECT_FALSE(isFrameFilenamePattern("100%%_%06d.pos"));
+    EXPECT_FALSE(isFrameFilenamePattern("frame_%06d.pos%n"));
+    EXPECT_FALSE(isFrameFilenamePattern("frame_%06"));
+}
+
+TEST(FrameFilename, FrameFilename) {
+    EXPECT_EQ("frame_000012.pos", frameFilename("frame_%06d.pos", 12));
+    EXPECT_EQ("frame_12.pos", frameFilename("frame_%d.pos", 12));
+    EXPECT_EQ("frame_-3.pos", frameFilename("frame_%d.pos", -3));
+    EXPECT_EQ("1234567", frameFilename("%3d", 1234567));
+
+    // The text around the field is copied, not formatted
+    std::string longPrefix(2000, 'a');
+    EXPECT_EQ(
+        longPrefix + "7.obj", frameFilename(longPrefix + "%d.obj", 7));
+
+    EXPECT_THROW(frameFilename("frame.pos", 1), std::invalid_argument);
+    EXPECT_THROW(frameFilename("frame_%s.pos", 1), std::invalid_argument);
+    EXPECT_THROW(
+        frameFilename("frame_%d_%n.pos", 1), std::invalid_argument);
+}
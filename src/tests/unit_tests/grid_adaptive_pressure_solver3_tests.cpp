@@ -0,0 +1,146 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/custom_scalar_field3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/fdm_gauss_seidel_solver3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/grid_adaptive_pressure_solver3.h>
+#include <jet/grid_single_phase_pressure_solver3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+using namespace jet;
+
+namespace {
+
+void fillVelocity(FaceCenteredGrid3* vel) {
+    vel->fill([](const Vector3D& pt) {
+        return Vector3D(
+            std::sin(6.0 * pt.y) + pt.z * pt.x,
+            std::cos(5.0 * pt.z) * pt.x,
+            std::sin(4.0 * pt.x + pt.y * pt.z));
+    });
+
+    // Closed walls, as the boundary condition solver would set
+    Size3 res = vel->resolution();
+    vel->forEachUIndex([&](size_t i, size_t j, size_t k) {
+        if (i == 0 || i == res.x) {
+            vel->u(i, j, k) = 0.0;
+        }
+    });
+    vel->forEachVIndex([&](size_t i, size_t j, size_t k) {
+        if (j == 0 || j == res.y) {
+            vel->v(i, j, k) = 0.0;
+        }
+    });
+    vel->forEachWIndex([&](size_t i, size_t j, size_t k) {
+        if (k == 0 || k == res.z) {
+            vel->w(i, j, k) = 0.0;
+        }
+    });
+}
+
+}  // namespace
+
+TEST(GridAdaptivePressureSolver3, MatchesSinglePhaseWithoutLevels) {
+    FaceCenteredGrid3 input(12, 10, 8, 1.0 / 12.0, 1.0 / 12.0, 1.0 / 12.0);
+    fillVelocity(&input);
+
+    CustomScalarField3 fluidSdf([](const Vector3D& pt) {
+        return pt.y - 0.5 - 0.1 * std::sin(8.0 * pt.x);
+    });
+    CustomScalarField3 boundarySdf([](const Vector3D& pt) {
+        return (pt - Vector3D(0.5, 0.2, 0.3)).length() - 0.15;
+    });
+
+    FaceCenteredGrid3 expected(input);
+    GridSinglePhasePressureSolver3 reference;
+    reference.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(200, 1e-12));
+    reference.setIsUsingCompressedSystem(true);
+    reference.solve(input, 1.0, &expected, boundarySdf, fluidSdf);
+
+    FaceCenteredGrid3 output(input);
+    GridAdaptivePressureSolver3 solver;
+    solver.setMaxLevel(0);
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(200, 1e-12));
+    solver.solve(input, 1.0, &output, boundarySdf, fluidSdf);
+
+    EXPECT_EQ(solver.numberOfFluidCells(), solver.numberOfUnknowns());
+    EXPECT_LT(0u, solver.numberOfUnknowns());
+
+    expected.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(expected.u(i, j, k), output.u(i, j, k), 1e-8);
+    });
+    expected.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(expected.v(i, j, k), output.v(i, j, k), 1e-8);
+    });
+    expected.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(expected.w(i, j, k), output.w(i, j, k), 1e-8);
+    });
+    EXPECT_NEAR(reference.lastMaxVelocity(), solver.lastMaxVelocity(), 1e-8);
+}
+
+TEST(GridAdaptivePressureSolver3, DeepTank) {
+    const size_t n = 32;
+    const double h = 1.0 / n;
+    FaceCenteredGrid3 input(n, n, n, h, h, h);
+    fillVelocity(&input);
+
+    CustomScalarField3 fluidSdf([](const Vector3D& pt) {
+        return pt.y - 0.75;
+    });
+
+    FaceCenteredGrid3 output(input);
+    GridAdaptivePressureSolver3 solver;
+    EXPECT_EQ(3u, solver.maxLevel());
+    EXPECT_EQ(2.0, solver.surfaceBandWidth());
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(500, 1e-10));
+    solver.solve(input, 1.0, &output, ConstantScalarField3(kMaxD), fluidSdf);
+
+    // The bottom 8 layers are covered by blocks of 8^3 cells, the next 8 by
+    // 4^3 and the next 4 by 2^3, so only the top 4 layers keep the cells
+    EXPECT_EQ(24u * n * n, solver.numberOfFluidCells());
+    EXPECT_EQ(16u + 128u + 512u + 4u * n * n, solver.numberOfUnknowns());
+
+    // The leaves cover the cells of the same pressure
+    EXPECT_EQ(solver.pressure()(0, 0, 0), solver.pressure()(7, 7, 7));
+    EXPECT_NE(solver.pressure()(0, 0, 0), solver.pressure()(8, 0, 0));
+
+    // Every fluid cell is divergence-free, including the inner ones of the
+    // coarse leaves
+    Array3<double> div(n, n, n);
+    output.computeDivergence(div.accessor());
+    double maxDiv = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t j = 0; j < 24; ++j) {
+            for (size_t i = 0; i < n; ++i) {
+                maxDiv = std::max(maxDiv, std::fabs(div(i, j, k)));
+            }
+        }
+    }
+    EXPECT_LT(maxDiv, 1e-5);
+
+    EXPECT_LT(0.0, solver.lastMaxVelocity());
+    EXPECT_THROW(solver.setMaxLevel(9), std::invalid_argument);
+    EXPECT_THROW(solver.setSurfaceBandWidth(0.5), std::invalid_argument);
+}
+
+TEST(GridAdaptivePressureSolver3, CompressedSystemSolverOnly) {
+    GridAdaptivePressureSolver3 solver;
+
+    // The leaves only form a compressed system, so the other solvers are
+    // rejected instead of leaving the pressure unsolved
+    EXPECT_THROW(
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmGaussSeidelSolver3>(100, 10, 1e-6)),
+        std::invalid_argument);
+    EXPECT_NO_THROW(
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(100, 1e-6)));
+    EXPECT_NO_THROW(solver.setLinearSystemSolver(nullptr));
+}
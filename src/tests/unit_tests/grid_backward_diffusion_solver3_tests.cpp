@@ -1,11 +1,47 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
+#include <jet/constant_scalar_field3.h>
+#include <jet/custom_scalar_field3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/fdm_chebyshev_solver3.h>
+#include <jet/fdm_gauss_seidel_solver3.h>
+#include <jet/fdm_iccg_solver3.h>
 #include <jet/grid_backward_euler_diffusion_solver3.h>
 #include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
 
 using namespace jet;
 
+namespace {
+
+class CountingSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    unsigned int numberOfSolves = 0;
+    unsigned int numberOfSolvesWithSameMatrix = 0;
+
+    bool solve(FdmLinearSystem3* system) override {
+        ++numberOfSolves;
+        return _solver.solve(system);
+    }
+
+    bool solveWithSameMatrix(FdmLinearSystem3* system) override {
+        ++numberOfSolvesWithSameMatrix;
+        return _solver.solveWithSameMatrix(system);
+    }
+
+    unsigned int lastNumberOfIterations() const override {
+        return _solver.lastNumberOfIterations();
+    }
+
+ private:
+    FdmIccgSolver3 _solver{100, 1e-9};
+};
+
+}  // namespace
+
 TEST(GridBackwardEulerDiffusionSolver3, Solve) {
     CellCenteredScalarGrid3 src(3, 3, 3, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
     CellCenteredScalarGrid3 dst(3, 3, 3, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
@@ -37,3 +73,184 @@ TEST(GridBackwardEulerDiffusionSolver3, Solve) {
         EXPECT_NEAR(solution(i, j, k), dst(i, j, k), 1e-6);
     });
 }
+
+TEST(GridBackwardEulerDiffusionSolver3, SolveWithRedBlackGaussSeidel) {
+    CellCenteredScalarGrid3 src(8, 8, 8, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    CellCenteredScalarGrid3 dst(8, 8, 8, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    CellCenteredScalarGrid3 expected(8, 8, 8, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+
+    src.fill([](const Vector3D& pt) {
+        return (pt - Vector3D(4.0, 4.0, 4.0)).lengthSquared() < 4.0 ? 1.0 : 0.0;
+    });
+
+    GridBackwardEulerDiffusionSolver3 referenceSolver;
+    referenceSolver.solve(src, 0.2, 1.0, &expected);
+
+    GridBackwardEulerDiffusionSolver3 diffusionSolver;
+    diffusionSolver.setLinearSystemSolver(
+        std::make_shared<FdmGaussSeidelSolver3>(100, 5, 1e-9, 1.2, true));
+    diffusionSolver.solve(src, 0.2, 1.0, &dst);
+
+    dst.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(expected(i, j, k), dst(i, j, k), 1e-6);
+    });
+}
+
+TEST(GridBackwardEulerDiffusionSolver3, SolveWithChebyshev) {
+    CellCenteredScalarGrid3 src(8, 8, 8, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    CellCenteredScalarGrid3 dst(8, 8, 8, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    CellCenteredScalarGrid3 expected(8, 8, 8, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+
+    src.fill([](const Vector3D& pt) {
+        return std::sin(pt.x) * std::cos(pt.y) + 0.1 * pt.z;
+    });
+
+    GridBackwardEulerDiffusionSolver3 referenceSolver;
+    referenceSolver.solve(src, 0.5, 1.0, &expected);
+
+    GridBackwardEulerDiffusionSolver3 diffusionSolver;
+    diffusionSolver.setLinearSystemSolver(
+        std::make_shared<FdmChebyshevSolver3>(100, 5, 1e-9));
+    diffusionSolver.solve(src, 0.5, 1.0, &dst);
+
+    dst.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(expected(i, j, k), dst(i, j, k), 1e-6);
+    });
+}
+
+TEST(GridBackwardEulerDiffusionSolver3, MatrixCaching) {
+    CellCenteredVectorGrid3 src(6, 6, 6, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    CellCenteredVectorGrid3 dst(6, 6, 6, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    src.fill([](const Vector3D& pt) {
+        return Vector3D(pt.y, std::sin(pt.z), pt.x * pt.x);
+    });
+
+    auto counter = std::make_shared<CountingSolver3>();
+    GridBackwardEulerDiffusionSolver3 diffusionSolver;
+    diffusionSolver.setLinearSystemSolver(counter);
+
+    // The matrix is shared by the three components
+    diffusionSolver.solve(src, 0.1, 0.5, &dst);
+    EXPECT_EQ(1u, counter->numberOfSolves);
+    EXPECT_EQ(2u, counter->numberOfSolvesWithSameMatrix);
+
+    // ...and by the next step with the same coefficient
+    CellCenteredVectorGrid3 cachedDst(6, 6, 6, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    diffusionSolver.solve(src, 0.1, 0.5, &cachedDst);
+    EXPECT_EQ(1u, counter->numberOfSolves);
+    EXPECT_EQ(5u, counter->numberOfSolvesWithSameMatrix);
+
+    dst.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(dst(i, j, k).x, cachedDst(i, j, k).x);
+        EXPECT_DOUBLE_EQ(dst(i, j, k).y, cachedDst(i, j, k).y);
+        EXPECT_DOUBLE_EQ(dst(i, j, k).z, cachedDst(i, j, k).z);
+    });
+
+    // A different time interval or boundary rebuilds the matrix
+    diffusionSolver.solve(src, 0.1, 0.25, &dst);
+    EXPECT_EQ(2u, counter->numberOfSolves);
+
+    ConstantScalarField3 solid(-1.0);
+    diffusionSolver.solve(src, 0.1, 0.25, &dst, solid);
+    EXPECT_EQ(3u, counter->numberOfSolves);
+}
+
+TEST(GridBackwardEulerDiffusionSolver3, CompressedSystem) {
+    FaceCenteredGrid3 src(10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    src.fill([](const Vector3D& pt) {
+        return Vector3D(std::sin(pt.y), pt.x * pt.z, std::cos(pt.x));
+    });
+
+    CustomScalarField3 fluidSdf([](const Vector3D& pt) {
+        return (pt - Vector3D(5.0, 4.0, 5.0)).length() - 3.5;
+    });
+    CustomScalarField3 boundarySdf([](const Vector3D& pt) {
+        return pt.y - 1.5;
+    });
+
+    for (auto boundaryType : {GridBackwardEulerDiffusionSolver3::Neumann,
+                              GridBackwardEulerDiffusionSolver3::Dirichlet}) {
+        GridBackwardEulerDiffusionSolver3 referenceSolver(boundaryType);
+        referenceSolver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(100, 1e-12));
+        FaceCenteredGrid3 expected(
+            10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+        referenceSolver.solve(
+            src, 0.3, 1.0, &expected, boundarySdf, fluidSdf);
+
+        GridBackwardEulerDiffusionSolver3 diffusionSolver(boundaryType);
+        EXPECT_FALSE(diffusionSolver.isUsingCompressedSystem());
+        diffusionSolver.setIsUsingCompressedSystem(true);
+        EXPECT_TRUE(diffusionSolver.isUsingCompressedSystem());
+        diffusionSolver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(100, 1e-12));
+
+        // The second step reuses the compressed matrix
+        for (int step = 0; step < 2; ++step) {
+            FaceCenteredGrid3 dst(10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+            diffusionSolver.solve(src, 0.3, 1.0, &dst, boundarySdf, fluidSdf);
+
+            dst.forEachUIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_NEAR(expected.u(i, j, k), dst.u(i, j, k), 1e-9);
+            });
+            dst.forEachVIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_NEAR(expected.v(i, j, k), dst.v(i, j, k), 1e-9);
+            });
+            dst.forEachWIndex([&](size_t i, size_t j, size_t k) {
+                EXPECT_NEAR(expected.w(i, j, k), dst.w(i, j, k), 1e-9);
+            });
+        }
+    }
+
+    // The cells outside of the fluid keep their values
+    GridBackwardEulerDiffusionSolver3 diffusionSolver;
+    diffusionSolver.setIsUsingCompressedSystem(true);
+    FaceCenteredGrid3 dst(10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    diffusionSolver.solve(
+        src, 0.3, 1.0, &dst, ConstantScalarField3(kMaxD),
+        ConstantScalarField3(1.0));
+    dst.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(src.u(i, j, k), dst.u(i, j, k));
+    });
+}
+
+TEST(GridBackwardEulerDiffusionSolver3, CompressedSystemUnsupported) {
+    FaceCenteredGrid3 src(10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    src.fill([](const Vector3D& pt) {
+        return Vector3D(std::sin(pt.y), pt.x * pt.z, std::cos(pt.x));
+    });
+
+    CustomScalarField3 fluidSdf([](const Vector3D& pt) {
+        return (pt - Vector3D(5.0, 4.0, 5.0)).length() - 3.5;
+    });
+    CustomScalarField3 boundarySdf([](const Vector3D& pt) {
+        return pt.y - 1.5;
+    });
+
+    GridBackwardEulerDiffusionSolver3 referenceSolver;
+    referenceSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-9));
+    FaceCenteredGrid3 expected(10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    referenceSolver.solve(src, 0.3, 1.0, &expected, boundarySdf, fluidSdf);
+
+    // The solver cannot take a compressed system, so the full one is solved
+    auto countingSolver = std::make_shared<CountingSolver3>();
+    EXPECT_FALSE(countingSolver->isCompressedSystemSupported());
+    GridBackwardEulerDiffusionSolver3 diffusionSolver;
+    diffusionSolver.setIsUsingCompressedSystem(true);
+    diffusionSolver.setLinearSystemSolver(countingSolver);
+
+    FaceCenteredGrid3 dst(10, 10, 10, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    diffusionSolver.solve(src, 0.3, 1.0, &dst, boundarySdf, fluidSdf);
+    EXPECT_EQ(3u, countingSolver->numberOfSolves);
+
+    dst.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(expected.u(i, j, k), dst.u(i, j, k));
+    });
+    dst.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(expected.v(i, j, k), dst.v(i, j, k));
+    });
+    dst.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(expected.w(i, j, k), dst.w(i, j, k));
+    });
+}
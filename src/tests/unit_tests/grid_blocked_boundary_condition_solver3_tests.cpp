@@ -85,3 +85,76 @@ TEST(GridBlockedBoundaryConditionSolver3, OpenDomain) {
         }
     });
 }
+
+TEST(GridBlockedBoundaryConditionSolver3, StaticColliderIsCached) {
+    GridBlockedBoundaryConditionSolver3 bndSolver;
+    Size3 gridSize(4, 4, 4);
+    Vector3D gridSpacing(1.0, 1.0, 1.0);
+    Vector3D gridOrigin(-2.0, -2.0, -2.0);
+
+    auto plane = std::make_shared<Plane3>(
+        Vector3D(0, 1, 0), Vector3D(0, -10, 0));
+    auto collider = std::make_shared<RigidBodyCollider3>(plane);
+
+    bndSolver.updateCollider(collider, gridSize, gridSpacing, gridOrigin);
+    EXPECT_LT(0.0, bndSolver.colliderSdf()(0, 0, 0));
+
+    // Moving the surface in place is not visible until markDirty
+    plane->point = Vector3D(0, 10, 0);
+    bndSolver.updateCollider(collider, gridSize, gridSpacing, gridOrigin);
+    EXPECT_LT(0.0, bndSolver.colliderSdf()(0, 0, 0));
+
+    collider->markDirty();
+    bndSolver.updateCollider(collider, gridSize, gridSpacing, gridOrigin);
+    EXPECT_GT(0.0, bndSolver.colliderSdf()(0, 0, 0));
+
+    // Changing the grid always rebuilds the cache
+    plane->point = Vector3D(0, -10, 0);
+    bndSolver.updateCollider(
+        collider, Size3(5, 5, 5), gridSpacing, gridOrigin);
+    EXPECT_EQ(Size3(5, 5, 5), bndSolver.colliderSdf().resolution());
+    EXPECT_LT(0.0, bndSolver.colliderSdf()(0, 0, 0));
+}
+
+TEST(GridBlockedBoundaryConditionSolver3, ColliderInterface) {
+    GridBlockedBoundaryConditionSolver3 bndSolver;
+    Size3 gridSize(4, 4, 4);
+    Vector3D gridSpacing(1.0, 1.0, 1.0);
+    Vector3D gridOrigin(-2.0, -2.0, -2.0);
+
+    // The lower half of the cells is inside the collider
+    auto plane = std::make_shared<Plane3>(
+        Vector3D(0, 1, 0), Vector3D(0, 0, 0));
+    auto collider = std::make_shared<RigidBodyCollider3>(plane);
+
+    bndSolver.setClosedDomainBoundaryFlag(0);
+    bndSolver.updateCollider(collider, gridSize, gridSpacing, gridOrigin);
+
+    FaceCenteredGrid3 velocity(gridSize, gridSpacing, gridOrigin);
+    velocity.fill(Vector3D(1.0, 1.0, 1.0));
+
+    // The listed faces are reused by the second call
+    for (int n = 0; n < 2; ++n) {
+        bndSolver.constrainVelocity(&velocity);
+
+        velocity.forEachUIndex([&](size_t i, size_t j, size_t k) {
+            if (j >= 2) {
+                EXPECT_DOUBLE_EQ(1.0, velocity.u(i, j, k));
+            }
+        });
+
+        velocity.forEachVIndex([&](size_t i, size_t j, size_t k) {
+            if (j == 2) {
+                EXPECT_DOUBLE_EQ(0.0, velocity.v(i, j, k));
+            } else if (j > 2) {
+                EXPECT_DOUBLE_EQ(1.0, velocity.v(i, j, k));
+            }
+        });
+
+        velocity.forEachWIndex([&](size_t i, size_t j, size_t k) {
+            if (j >= 2) {
+                EXPECT_DOUBLE_EQ(1.0, velocity.w(i, j, k));
+            }
+        });
+    }
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
+#include <jet/grid_cache3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace jet;
+
+TEST(GridCache3, WriteAndRead) {
+    const std::string filename = "grid_cache3_tests_write_and_read.gcache";
+
+    const Size3 resolution(5, 4, 3);
+    const Vector3D gridSpacing(0.5, 0.25, 1.0);
+    const Vector3D origin(-1.0, 2.0, 0.5);
+
+    CellCenteredScalarGrid3 density(resolution, gridSpacing, origin);
+    density.fill([](const Vector3D& pt) { return pt.x + 2.0 * pt.y - pt.z; });
+    VertexCenteredScalarGrid3 sdf(resolution, gridSpacing, origin);
+    sdf.fill([](const Vector3D& pt) { return pt.length(); });
+    CellCenteredVectorGrid3 force(resolution, gridSpacing, origin);
+    force.fill([](const Vector3D& pt) { return Vector3D(pt.z, pt.x, pt.y); });
+    FaceCenteredGrid3 velocity(resolution, gridSpacing, origin);
+    velocity.fill([](const Vector3D& pt) { return 3.0 * pt; });
+
+    GridCacheWriter3 writer;
+    writer.addScalarGrid("density", density);
+    writer.addScalarGrid("sdf", sdf);
+    writer.addVectorGrid("force", force);
+    writer.addFaceCenteredGrid("velocity", velocity);
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        writer.write(&file);
+    }
+
+    GridCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    ASSERT_EQ(4u, reader.numberOfChannels());
+    EXPECT_EQ("density", reader.channelName(0));
+    EXPECT_EQ("velocity", reader.channelName(3));
+    EXPECT_TRUE(reader.hasScalarGrid("sdf"));
+    EXPECT_TRUE(reader.hasVectorGrid("force"));
+    EXPECT_TRUE(reader.hasFaceCenteredGrid("velocity"));
+    EXPECT_FALSE(reader.hasScalarGrid("velocity"));
+    EXPECT_FALSE(reader.hasVectorGrid("pressure"));
+
+    EXPECT_EQ(resolution, reader.resolution("force"));
+    EXPECT_EQ(gridSpacing, reader.gridSpacing("force"));
+    EXPECT_EQ(origin, reader.origin("force"));
+    EXPECT_EQ(density.dataOrigin(), reader.dataOrigin("density"));
+    EXPECT_EQ(sdf.dataOrigin(), reader.dataOrigin("sdf"));
+    EXPECT_EQ(velocity.vOrigin(), reader.dataOrigin("velocity", 1));
+
+    // The views point into the mapped file, aligned for vector loads
+    auto densityData = reader.scalarData("density");
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(densityData.data()) % 64);
+    EXPECT_EQ(density.dataSize(), densityData.size());
+    density.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(density(i, j, k), densityData(i, j, k));
+    });
+
+    auto sdfData = reader.scalarData("sdf");
+    EXPECT_EQ(sdf.dataSize(), sdfData.size());
+    sdf.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(sdf(i, j, k), sdfData(i, j, k));
+    });
+
+    auto forceData = reader.vectorData("force");
+    EXPECT_EQ(force.dataSize(), forceData.size());
+    force.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(force(i, j, k), forceData(i, j, k));
+    });
+
+    auto wData = reader.faceCenteredData("velocity", 2);
+    EXPECT_EQ(velocity.wSize(), wData.size());
+    velocity.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(velocity.w(i, j, k), wData(i, j, k));
+    });
+    EXPECT_EQ(0u, reader.scalarData("force").size().x);
+
+    // Copy back to grids
+    CellCenteredScalarGrid3 density2;
+    ASSERT_TRUE(reader.readScalarGrid("density", &density2));
+    EXPECT_EQ(origin, density2.origin());
+    density.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(density(i, j, k), density2(i, j, k));
+    });
+
+    CellCenteredVectorGrid3 force2;
+    ASSERT_TRUE(reader.readVectorGrid("force", &force2));
+    force.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(force(i, j, k), force2(i, j, k));
+    });
+
+    FaceCenteredGrid3 velocity2;
+    ASSERT_TRUE(reader.readFaceCenteredGrid("velocity", &velocity2));
+    velocity.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(velocity.u(i, j, k), velocity2.u(i, j, k));
+    });
+    velocity.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(velocity.v(i, j, k), velocity2.v(i, j, k));
+    });
+    EXPECT_EQ(velocity.sample(Vector3D()), velocity2.sample(Vector3D()));
+
+    // A vertex-centered channel does not fit a cell-centered grid
+    EXPECT_FALSE(reader.readScalarGrid("sdf", &density2));
+    EXPECT_FALSE(reader.readScalarGrid("pressure", &density2));
+
+    reader.close();
+    EXPECT_EQ(0u, reader.numberOfChannels());
+
+    std::remove(filename.c_str());
+}
+
+TEST(GridCache3, InvalidFile) {
+    const std::string filename = "grid_cache3_tests_invalid_file.gcache";
+
+    GridCacheReader3 reader;
+    EXPECT_FALSE(reader.open("grid_cache3_tests_no_such_file.gcache"));
+
+    // Grid written by ScalarGrid3::serialize
+    CellCenteredScalarGrid3 grid(Size3(8, 8, 8), Vector3D(1, 1, 1));
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        grid.serialize(&file);
+    }
+    EXPECT_FALSE(reader.open(filename));
+
+    // Truncated cache
+    GridCacheWriter3 writer;
+    writer.addScalarGrid("density", grid);
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        writer.write(&file);
+    }
+    EXPECT_TRUE(reader.open(filename));
+    reader.close();
+    {
+        std::ifstream file(filename.c_str(), std::ifstream::binary);
+        std::string contents(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+        file.close();
+        std::ofstream truncated(filename.c_str(), std::ofstream::binary);
+        truncated.write(contents.data(), contents.size() - 8);
+    }
+    EXPECT_FALSE(reader.open(filename));
+
+    EXPECT_THROW(
+        writer.addScalarGrid(std::string(48, 'a'), grid),
+        std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
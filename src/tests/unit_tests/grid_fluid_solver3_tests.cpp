@@ -1,7 +1,15 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
 #include <jet/grid_fluid_solver3.h>
+#include <jet/maccormack_advection3.h>
+#include <jet/parallel.h>
+#include <jet/plane3.h>
+#include <jet/rigid_body_collider3.h>
 #include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
 
 using namespace jet;
 
@@ -48,6 +56,49 @@ TEST(GridFluidSolver3, ResizeGridSystemData) {
     EXPECT_EQ(9.0, solver.gridOrigin().z);
 }
 
+TEST(GridFluidSolver3, PreviewScale) {
+    GridFluidSolver3 solver;
+    solver.resizeGrid(
+        Size3(40, 20, 10), Vector3D(0.1, 0.1, 0.1), Vector3D(1, 2, 3));
+    EXPECT_EQ(1.0, solver.previewScale());
+    EXPECT_THROW(solver.setPreviewScale(0.5), std::invalid_argument);
+
+    // The coarse grid keeps the bounding box
+    solver.setPreviewScale(4.0);
+    EXPECT_EQ(4.0, solver.previewScale());
+    EXPECT_EQ(Size3(10, 5, 3), solver.gridResolution());
+    EXPECT_DOUBLE_EQ(0.4, solver.gridSpacing().x);
+    EXPECT_DOUBLE_EQ(0.4, solver.gridSpacing().y);
+    EXPECT_DOUBLE_EQ(1.0 / 3.0, solver.gridSpacing().z);
+    EXPECT_EQ(Vector3D(1, 2, 3), solver.gridOrigin());
+    BoundingBox3D box = solver.gridSystemData()->boundingBox();
+    EXPECT_DOUBLE_EQ(4.0, box.width());
+    EXPECT_DOUBLE_EQ(2.0, box.height());
+    EXPECT_DOUBLE_EQ(1.0, box.depth());
+
+    // The scales are relative to the full grid
+    solver.setPreviewScale(2.0);
+    EXPECT_EQ(Size3(20, 10, 5), solver.gridResolution());
+    solver.setPreviewScale(100.0);
+    EXPECT_EQ(Size3(1, 1, 1), solver.gridResolution());
+    solver.setPreviewScale(1.0);
+    EXPECT_EQ(Size3(40, 20, 10), solver.gridResolution());
+    EXPECT_EQ(Vector3D(0.1, 0.1, 0.1), solver.gridSpacing());
+
+    // The coarse grid runs
+    solver.setPreviewScale(2.0);
+    solver.velocity()->fill(Vector3D(1, 0, 0));
+    Frame frame(1, 1.0 / 60.0);
+    solver.update(frame);
+
+    // Resizing sets a new full grid
+    solver.resizeGrid(Size3(8, 8, 8), Vector3D(0.5, 0.5, 0.5), Vector3D());
+    EXPECT_EQ(1.0, solver.previewScale());
+    solver.setPreviewScale(2.0);
+    EXPECT_EQ(Size3(4, 4, 4), solver.gridResolution());
+    EXPECT_EQ(Vector3D(1, 1, 1), solver.gridSpacing());
+}
+
 TEST(GridFluidSolver3, MinimumResolution) {
     GridFluidSolver3 solver;
 
@@ -92,3 +143,446 @@ TEST(GridFluidSolver3, GravityOnly) {
         EXPECT_NEAR(0.0, solver.velocity()->w(i, j, k), 1e-8);
     });
 }
+
+TEST(GridFluidSolver3, Checkpoint) {
+    GridFluidSolver3 solver;
+    solver.setGravity(Vector3D(0.0, -5.0, 0.0));
+    solver.setViscosityCoefficient(0.01);
+    solver.setClosedDomainBoundaryFlag(kDirectionDown);
+    solver.resizeGrid(Size3(6, 6, 6), Vector3D(0.2, 0.2, 0.2), Vector3D());
+    solver.velocity()->fill([](const Vector3D& pt) {
+        return Vector3D(pt.y, -pt.x, 0.5 * pt.z);
+    });
+
+    Frame frame(1, 1.0 / 60.0);
+    for ( ; frame.index < 3; frame.advance()) {
+        solver.update(frame);
+    }
+
+    std::stringstream strm;
+    solver.serialize(&strm);
+
+    GridFluidSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_EQ(2u, restored.currentFrame().index);
+    EXPECT_EQ(Vector3D(0.0, -5.0, 0.0), restored.gravity());
+    EXPECT_DOUBLE_EQ(0.01, restored.viscosityCoefficient());
+    EXPECT_EQ(kDirectionDown, restored.closedDomainBoundaryFlag());
+    EXPECT_EQ(Size3(6, 6, 6), restored.gridResolution());
+
+    Frame restartFrame = frame;
+    for ( ; frame.index < 5; frame.advance()) {
+        solver.update(frame);
+    }
+    for ( ; restartFrame.index < 5; restartFrame.advance()) {
+        restored.update(restartFrame);
+    }
+
+    auto v = solver.velocity();
+    auto restoredV = restored.velocity();
+    v->forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(v->v(i, j, k), restoredV->v(i, j, k), 1e-12);
+    });
+
+    std::stringstream emptyStrm;
+    EXPECT_THROW(restored.deserialize(&emptyStrm), std::invalid_argument);
+}
+
+TEST(GridFluidSolver3, ScrollGrid) {
+    GridFluidSolver3 solver;
+    solver.resizeGrid(Size3(8, 6, 4), Vector3D(0.5, 0.5, 0.5), Vector3D());
+    auto smoke = solver.gridSystemData()->addAdvectableScalarData(
+        CellCenteredScalarGrid3::builder());
+    auto wind = solver.gridSystemData()->addVectorData(
+        CellCenteredVectorGrid3::builder());
+
+    auto field = [](const Vector3D& pt) {
+        return pt.x + 2.0 * pt.y - pt.z;
+    };
+    solver.velocity()->fill([&](const Vector3D& pt) {
+        return Vector3D(field(pt), 0.0, 0.0);
+    });
+    auto density = solver.gridSystemData()->advectableScalarDataAt(smoke);
+    density->fill(field);
+    auto windGrid = std::dynamic_pointer_cast<CellCenteredVectorGrid3>(
+        solver.gridSystemData()->vectorDataAt(wind));
+    windGrid->fill([&](const Vector3D& pt) {
+        return Vector3D(0.0, field(pt), 0.0);
+    });
+
+    // The domain centered at (2, 1.5, 1) follows a target at (3.1, 0.6, 1)
+    Point3I offset = solver.scrollGridToward(Vector3D(3.1, 0.6, 1.0));
+    EXPECT_EQ(Point3I(2, -2, 0), offset);
+    EXPECT_EQ(Vector3D(1.0, -1.0, 0.0), solver.gridOrigin());
+    EXPECT_EQ(Size3(8, 6, 4), solver.gridResolution());
+    EXPECT_EQ(
+        Vector3D(1.0, -1.0, 0.0),
+        solver.gridSystemData()->velocityBackBuffer()->origin());
+
+    // The values keep their world positions, and the fresh cells are
+    // extended from the old boundary
+    auto clampToOld = [&](const Vector3D& pt, const Vector3D& dataOrigin) {
+        Vector3D lower = dataOrigin - solver.gridOrigin();
+        Vector3D upper = lower + Vector3D(3.5, 2.5, 1.5);
+        return Vector3D(
+            clamp(pt.x, lower.x, upper.x),
+            clamp(pt.y, lower.y, upper.y),
+            clamp(pt.z, lower.z, upper.z));
+    };
+    auto densityPos = density->dataPosition();
+    density->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = densityPos(i, j, k);
+        EXPECT_DOUBLE_EQ(
+            field(clampToOld(pt, density->dataOrigin())), (*density)(i, j, k));
+    });
+    auto windPos = windGrid->dataPosition();
+    windGrid->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = windPos(i, j, k);
+        EXPECT_DOUBLE_EQ(
+            field(clampToOld(pt, windGrid->dataOrigin())),
+            (*windGrid)(i, j, k).y);
+    });
+
+    auto vel = solver.velocity();
+    auto uPos = vel->uPosition();
+    vel->forEachUIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = uPos(i, j, k);
+        Vector3D lower = Vector3D(0.0, 0.25, 0.25);
+        Vector3D upper = lower + Vector3D(4.0, 2.5, 1.5);
+        Vector3D src(
+            clamp(pt.x, lower.x, upper.x),
+            clamp(pt.y, lower.y, upper.y),
+            clamp(pt.z, lower.z, upper.z));
+        EXPECT_DOUBLE_EQ(field(src), vel->u(i, j, k));
+    });
+
+    // The solver keeps running in the moved domain
+    solver.update(Frame(1, 1.0 / 60.0));
+    EXPECT_EQ(Vector3D(1.0, -1.0, 0.0), solver.gridOrigin());
+}
+
+TEST(GridFluidSolver3, UpdateInterval) {
+    auto makeSolver = [](unsigned int interval) {
+        auto solver = std::make_shared<GridFluidSolver3>();
+        solver->setGravity(Vector3D());
+        solver->setDiffusionSolver(nullptr);
+        solver->setPressureSolver(nullptr);
+        solver->setClosedDomainBoundaryFlag(0);
+        solver->setMaxCfl(100.0);
+        solver->resizeGrid(
+            Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125), Vector3D());
+        solver->velocity()->fill(Vector3D(1.0, 0.5, 0.0));
+
+        auto grids = solver->gridSystemData();
+        size_t idx = grids->addAdvectableScalarData(
+            CellCenteredScalarGrid3::builder(), 0.0);
+        grids->advectableScalarDataAt(idx)->fill([](const Vector3D& pt) {
+            return pt.x * pt.x + pt.y;
+        });
+        grids->setAdvectableScalarDataUpdateInterval(idx, interval);
+        EXPECT_EQ(interval, grids->advectableScalarDataUpdateIntervalAt(idx));
+        return solver;
+    };
+
+    auto everyStep = makeSolver(1);
+    auto everyThirdStep = makeSolver(3);
+    EXPECT_THROW(
+        everyStep->gridSystemData()->setAdvectableScalarDataUpdateInterval(
+            0, 0),
+        std::invalid_argument);
+
+    // The data is not due within the single sub-time-step of the frame, so it
+    // should be caught up at the end of the frame
+    Frame frame(1, 0.1);
+    everyStep->update(frame);
+    everyThirdStep->update(frame);
+
+    auto data = everyStep->gridSystemData()->advectableScalarDataAt(0);
+    auto lazyData = everyThirdStep->gridSystemData()->advectableScalarDataAt(0);
+    bool isAdvected = false;
+    data->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = data->dataPosition()(i, j, k);
+        isAdvected |= (*data)(i, j, k) != pt.x * pt.x + pt.y;
+        EXPECT_DOUBLE_EQ((*data)(i, j, k), (*lazyData)(i, j, k));
+    });
+    EXPECT_TRUE(isAdvected);
+}
+
+TEST(GridFluidSolver3, BackBuffer) {
+    GridFluidSolver3 solver;
+    solver.setGravity(Vector3D());
+    solver.setDiffusionSolver(nullptr);
+    solver.setPressureSolver(nullptr);
+    solver.setClosedDomainBoundaryFlag(0);
+    solver.setIsUsingFixedSubTimeSteps(true);
+    solver.setNumberOfFixedSubTimeSteps(1);
+    solver.resizeGrid(
+        Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125), Vector3D());
+
+    auto grids = solver.gridSystemData();
+    size_t idx = grids->addAdvectableScalarData(
+        CellCenteredScalarGrid3::builder(), 0.0);
+
+    // The back buffer should hold the data of the sub-step before it is
+    // advected, at the current size of the grids
+    auto expectBackBuffer = [&](unsigned int frameIndex) {
+        solver.velocity()->fill(Vector3D(1.0, 0.5, 0.0));
+        auto data = grids->advectableScalarDataAt(idx);
+        data->fill([](const Vector3D& pt) {
+            return pt.x * pt.x + pt.y;
+        });
+        auto before = data->clone();
+
+        Frame frame(frameIndex, 0.1);
+        solver.update(frame);
+
+        auto backBuffer = grids->advectableScalarDataBackBufferAt(idx);
+        ASSERT_TRUE(backBuffer->hasSameShape(*data));
+        EXPECT_EQ(
+            grids->resolution(), grids->velocityBackBuffer()->resolution());
+        bool isAdvected = false;
+        data->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_EQ((*before)(i, j, k), (*backBuffer)(i, j, k));
+            isAdvected |= (*data)(i, j, k) != (*before)(i, j, k);
+        });
+        EXPECT_TRUE(isAdvected);
+    };
+
+    expectBackBuffer(1);
+
+    solver.resizeGrid(
+        Size3(12, 10, 6), Vector3D(0.1, 0.1, 0.1), Vector3D(0.05, 0, 0));
+    EXPECT_EQ(
+        Size3(12, 10, 6),
+        grids->advectableScalarDataBackBufferAt(idx)->resolution());
+    expectBackBuffer(2);
+}
+
+TEST(GridFluidSolver3, ConcurrentAdvection) {
+    // The velocity and the groups of the data are advected by concurrent
+    // tasks, which should give the same result as running them one by one
+    auto run = [](unsigned int numberOfThreads) {
+        unsigned int oldNumberOfThreads = maxNumberOfThreads();
+        setMaxNumberOfThreads(numberOfThreads);
+
+        auto solver = std::make_shared<GridFluidSolver3>();
+        solver->setAdvectionSolver(std::make_shared<MacCormackAdvection3>());
+        solver->setDiffusionSolver(nullptr);
+        solver->setPressureSolver(nullptr);
+        solver->resizeGrid(
+            Size3(12, 12, 12), Vector3D(0.1, 0.1, 0.1), Vector3D());
+        solver->velocity()->fill([](const Vector3D& pt) {
+            return Vector3D(1.0 - pt.y, 0.5, -pt.x);
+        });
+        solver->setCollider(std::make_shared<RigidBodyCollider3>(
+            std::make_shared<Plane3>(
+                Vector3D(0, 1, 0), Vector3D(0, 0.3, 0))));
+
+        auto grids = solver->gridSystemData();
+        for (unsigned int interval : {1u, 1u, 2u}) {
+            size_t idx = grids->addAdvectableScalarData(
+                CellCenteredScalarGrid3::builder());
+            grids->advectableScalarDataAt(idx)->fill(
+                [interval](const Vector3D& pt) {
+                    return pt.x * pt.x + pt.y * interval;
+                });
+            grids->setAdvectableScalarDataUpdateInterval(idx, interval);
+        }
+        for (const auto& builder : std::vector<VectorGridBuilder3Ptr>{
+                 CellCenteredVectorGrid3::builder(),
+                 FaceCenteredGrid3::builder()}) {
+            size_t idx = grids->addAdvectableVectorData(builder);
+            grids->advectableVectorDataAt(idx)->fill(
+                [](const Vector3D& pt) {
+                    return Vector3D(pt.z, pt.x * pt.y, 1.0);
+                });
+        }
+
+        Frame frame(0, 1.0 / 60.0);
+        frame.advance(3);
+        solver->update(frame);
+
+        setMaxNumberOfThreads(oldNumberOfThreads);
+        return solver;
+    };
+
+    auto serial = run(1);
+    auto concurrent = run(std::max(4u, maxNumberOfThreads()));
+
+    auto serialGrids = serial->gridSystemData();
+    auto grids = concurrent->gridSystemData();
+    for (size_t n = 0; n < grids->numberOfAdvectableScalarData(); ++n) {
+        auto expected = serialGrids->advectableScalarDataAt(n);
+        auto actual = grids->advectableScalarDataAt(n);
+        actual->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_EQ((*expected)(i, j, k), (*actual)(i, j, k));
+        });
+    }
+
+    auto expectedVel = serial->velocity();
+    auto vel = concurrent->velocity();
+    vel->forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(expectedVel->u(i, j, k), vel->u(i, j, k));
+    });
+    vel->forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(expectedVel->w(i, j, k), vel->w(i, j, k));
+    });
+
+    auto expectedFace = std::dynamic_pointer_cast<FaceCenteredGrid3>(
+        serialGrids->advectableVectorDataAt(1));
+    auto face = std::dynamic_pointer_cast<FaceCenteredGrid3>(
+        grids->advectableVectorDataAt(1));
+    face->forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(expectedFace->v(i, j, k), face->v(i, j, k));
+    });
+
+    auto expectedCell = std::dynamic_pointer_cast<CellCenteredVectorGrid3>(
+        serialGrids->advectableVectorDataAt(0));
+    auto cell = std::dynamic_pointer_cast<CellCenteredVectorGrid3>(
+        grids->advectableVectorDataAt(0));
+    cell->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ((*expectedCell)(i, j, k), (*cell)(i, j, k));
+    });
+}
+
+TEST(GridFluidSolver3, SinglePrecisionData) {
+    auto solver = std::make_shared<GridFluidSolver3>();
+    solver->setDiffusionSolver(nullptr);
+    solver->setPressureSolver(nullptr);
+    solver->resizeGrid(
+        Size3(12, 12, 12), Vector3D(0.1, 0.1, 0.1), Vector3D());
+    solver->velocity()->fill([](const Vector3D& pt) {
+        return Vector3D(1.0 - pt.y, 0.5, -pt.x);
+    });
+
+    auto fill = [](const Vector3D& pt) {
+        return pt.x * pt.x + pt.y;
+    };
+    auto grids = solver->gridSystemData();
+    size_t memory = grids->memoryInBytes();
+    size_t idx = grids->addAdvectableScalarData(
+        CellCenteredScalarGrid3::builder());
+    grids->advectableScalarDataAt(idx)->fill(fill);
+    size_t idxF = grids->addAdvectableScalarDataF(
+        CellCenteredScalarGrid3F::builder());
+    grids->advectableScalarDataFAt(idxF)->fill(fill);
+    grids->advectableScalarDataBackBufferAt(idx);
+    grids->advectableScalarDataFBackBufferAt(idxF);
+
+    // Double and float grids with their back buffers
+    EXPECT_EQ(memory + 2 * 12 * 12 * 12 * (sizeof(double) + sizeof(float)),
+              grids->memoryInBytes());
+    EXPECT_EQ(1u, grids->numberOfAdvectableScalarDataF());
+
+    Frame frame(0, 1.0 / 60.0);
+    frame.advance(3);
+    solver->update(frame);
+
+    auto expected = grids->advectableScalarDataAt(idx);
+    auto actual = grids->advectableScalarDataFAt(idxF);
+    actual->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR((*expected)(i, j, k), (*actual)(i, j, k), 1e-5);
+    });
+
+    // The float data follow the resize and the scroll of the domain
+    float value = (*actual)(4, 4, 5);
+    grids->scroll(Point3I(1, 0, 0));
+    EXPECT_EQ(value, (*actual)(3, 4, 5));
+
+    std::stringstream strm;
+    grids->serialize(&strm);
+
+    GridSystemData3 restored;
+    restored.resize(grids->resolution(), grids->gridSpacing(),
+                    grids->origin());
+    restored.addAdvectableScalarData(CellCenteredScalarGrid3::builder());
+    restored.addAdvectableScalarDataF(CellCenteredScalarGrid3F::builder());
+    restored.deserialize(&strm);
+    auto restoredF = restored.advectableScalarDataFAt(idxF);
+    actual->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ((*actual)(i, j, k), (*restoredF)(i, j, k));
+    });
+}
+
+TEST(GridFluidSolver3, LazyAllocation) {
+    GridSystemData3 grids;
+    EXPECT_TRUE(grids.isUsingLazyAllocation());
+    grids.resize(Size3(8, 8, 8), Vector3D(1, 1, 1), Vector3D());
+    size_t memory = grids.memoryInBytes();
+
+    // The grids take no memory until they are accessed
+    size_t idx = grids.addAdvectableScalarData(
+        CellCenteredScalarGrid3::builder(), 2.0);
+    size_t zeroIdx = grids.addScalarData(CellCenteredScalarGrid3::builder());
+    EXPECT_EQ(memory, grids.memoryInBytes());
+
+    // A grid with a non-zero value is allocated before a resize, so the old
+    // cells keep the value and the new cells get zero as with the eager
+    // allocation
+    grids.resize(Size3(10, 10, 10), Vector3D(1, 1, 1), Vector3D());
+    GridSystemData3 reference;
+    reference.resize(Size3(10, 10, 10), Vector3D(1, 1, 1), Vector3D());
+    EXPECT_EQ(reference.memoryInBytes() + 2 * 10 * 10 * 10 * sizeof(double),
+              grids.memoryInBytes());
+    auto data = grids.advectableScalarDataAt(idx);
+    EXPECT_EQ(Size3(10, 10, 10), data->resolution());
+    EXPECT_EQ(2.0, (*data)(7, 7, 7));
+    EXPECT_EQ(0.0, (*data)(9, 9, 9));
+
+    auto zero = grids.scalarDataAt(zeroIdx);
+    EXPECT_EQ(Size3(10, 10, 10), zero->resolution());
+    EXPECT_EQ(0.0, (*zero)(9, 9, 9));
+
+    // The back buffer is allocated with the initial value too
+    auto backBuffer = grids.advectableScalarDataBackBufferAt(idx);
+    EXPECT_EQ(Size3(10, 10, 10), backBuffer->resolution());
+    EXPECT_EQ(2.0, (*backBuffer)(0, 0, 0));
+
+    // The grids are allocated at once without the lazy allocation
+    GridSystemData3 eager;
+    eager.setIsUsingLazyAllocation(false);
+    EXPECT_FALSE(eager.isUsingLazyAllocation());
+    eager.resize(Size3(8, 8, 8), Vector3D(1, 1, 1), Vector3D());
+    memory = eager.memoryInBytes();
+    eager.addScalarData(CellCenteredScalarGrid3::builder());
+    EXPECT_EQ(memory + 8 * 8 * 8 * sizeof(double), eager.memoryInBytes());
+}
+
+TEST(GridFluidSolver3, Statistics) {
+    GridFluidSolver3 solver;
+    solver.setGravity(Vector3D(0, -10, 0.0));
+    solver.setIsUsingFixedSubTimeSteps(true);
+    solver.setNumberOfFixedSubTimeSteps(2);
+    solver.resizeGrid(
+        Size3(4, 4, 4),
+        Vector3D(0.25, 0.25, 0.25),
+        Vector3D());
+    solver.velocity()->fill(Vector3D());
+
+    Frame frame(1, 0.01);
+    solver.update(frame);
+
+    const FrameStatistics& stats = solver.lastFrameStatistics();
+    EXPECT_EQ(1u, stats.frameIndex);
+    EXPECT_GE(stats.durationInSeconds, 0.0);
+    ASSERT_EQ(2u, stats.subTimeSteps.size());
+
+    for (const auto& subStats : stats.subTimeSteps) {
+        EXPECT_DOUBLE_EQ(0.005, subStats.timeIntervalInSeconds);
+        EXPECT_LE(subStats.durationInSeconds, stats.durationInSeconds);
+        EXPECT_GT(subStats.numberOfPressureIterations, 0u);
+        EXPECT_GE(subStats.pressureResidual, 0.0);
+        EXPECT_EQ(0u, subStats.numberOfParticles);
+        EXPECT_LE(
+            solver.gridSystemData()->memoryInBytes(), subStats.memoryInBytes);
+    }
+
+    // The CFL number comes from the largest velocity of the pressure solve,
+    // which bounds the one scanned from the velocity field
+    EXPECT_LE(solver.cfl(0.005), stats.subTimeSteps[1].cfl);
+    EXPECT_GT(stats.subTimeSteps[1].cfl, 0.0);
+    EXPECT_LT(stats.subTimeSteps[1].cfl, solver.maxCfl());
+    EXPECT_EQ(
+        (5 * 4 * 4 * 3) * 2 * sizeof(double),
+        stats.subTimeSteps[0].memoryInBytes);
+}
@@ -2,6 +2,8 @@
 
 #include <jet/cell_centered_scalar_grid2.h>
 #include <jet/face_centered_grid2.h>
+#include <jet/fdm_iccg_solver2.h>
+#include <jet/fdm_matrix_free_cg_solver2.h>
 #include <jet/grid_fractional_single_phase_pressure_solver2.h>
 #include <gtest/gtest.h>
 
@@ -53,3 +55,143 @@ TEST(GridFractionalSinglePhasePressureSolver2, SolveFreeSurface) {
         EXPECT_NEAR(0.0, pressure(i, 2), 1e-6);
     }
 }
+
+TEST(GridFractionalSinglePhasePressureSolver2, SolveMatrixFree) {
+    FaceCenteredGrid2 vel(17, 13);
+    CellCenteredScalarGrid2 fluidSdf(17, 13);
+    CellCenteredScalarGrid2 boundarySdf(17, 13);
+
+    vel.fill([&](const Vector2D& x) {
+        return Vector2D(std::sin(x.y), std::cos(0.7 * x.x));
+    });
+    boundarySdf.fill([&](const Vector2D& x) {
+        return (x - Vector2D(6.0, 4.0)).length() - 2.5;
+    });
+    fluidSdf.fill([&](const Vector2D& x) {
+        return x.y + 0.2 * x.x - 9.5;
+    });
+
+    FaceCenteredGrid2 vel0(vel), vel1(vel);
+
+    GridFractionalSinglePhasePressureSolver2 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver2>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector2 pressure0(solver.pressure());
+
+    // The on-the-fly operator must match the assembled matrix
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmMatrixFreeCgSolver2>(1000, 1e-10));
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    const FdmVector2& pressure1 = solver.pressure();
+
+    pressure0.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(pressure0(i, j), pressure1(i, j), 1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(vel0.u(i, j), vel1.u(i, j), 1e-8);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(vel0.v(i, j), vel1.v(i, j), 1e-8);
+    });
+}
+
+TEST(GridFractionalSinglePhasePressureSolver2, SolveCompressed) {
+    FaceCenteredGrid2 vel(17, 13);
+    CellCenteredScalarGrid2 fluidSdf(17, 13);
+    CellCenteredScalarGrid2 boundarySdf(17, 13);
+
+    vel.fill([&](const Vector2D& x) {
+        return Vector2D(std::sin(x.x + 0.5 * x.y), std::cos(0.7 * x.y));
+    });
+    boundarySdf.fill([&](const Vector2D& x) {
+        return (x - Vector2D(6.0, 4.0)).length() - 2.5;
+    });
+    fluidSdf.fill([&](const Vector2D& x) {
+        return x.y + 0.2 * x.x - 9.5;
+    });
+
+    FaceCenteredGrid2 vel0(vel), vel1(vel);
+
+    GridFractionalSinglePhasePressureSolver2 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver2>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector2 pressure0(solver.pressure());
+
+    // The system over the fluid cells only must give the same pressure
+    EXPECT_FALSE(solver.isUsingCompressedSystem());
+    solver.setIsUsingCompressedSystem(true);
+    EXPECT_TRUE(solver.isUsingCompressedSystem());
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    FdmVector2 pressure1(solver.pressure());
+
+    pressure0.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(pressure0(i, j), pressure1(i, j), 1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(vel0.u(i, j), vel1.u(i, j), 1e-8);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(vel0.v(i, j), vel1.v(i, j), 1e-8);
+    });
+
+    // Nothing is left to solve when warm started from the same pressure
+    solver.setIsUsingWarmStart(true);
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    EXPECT_EQ(0u, solver.lastNumberOfIterations());
+    pressure0.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(pressure0(i, j), solver.pressure()(i, j), 1e-8);
+    });
+}
+
+TEST(GridFractionalSinglePhasePressureSolver2, WarmStart) {
+    FaceCenteredGrid2 vel(17, 13);
+    CellCenteredScalarGrid2 fluidSdf(17, 13);
+    CellCenteredScalarGrid2 boundarySdf(17, 13);
+
+    vel.fill([&](const Vector2D& x) {
+        return Vector2D(std::sin(x.x + 0.5 * x.y), std::cos(0.7 * x.y));
+    });
+    boundarySdf.fill([&](const Vector2D& x) {
+        return (x - Vector2D(6.0, 4.0)).length() - 2.5;
+    });
+    fluidSdf.fill([&](const Vector2D& x) {
+        return x.y + 0.2 * x.x - 9.5;
+    });
+
+    FaceCenteredGrid2 vel0(vel), vel1(vel);
+
+    GridFractionalSinglePhasePressureSolver2 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver2>(100, 1e-10));
+    EXPECT_FALSE(solver.isUsingWarmStart());
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector2 pressure0(solver.pressure());
+    EXPECT_LT(0u, solver.lastNumberOfIterations());
+
+    // Nothing is left to solve for the same system
+    solver.setIsUsingWarmStart(true);
+    EXPECT_TRUE(solver.isUsingWarmStart());
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    EXPECT_EQ(0u, solver.lastNumberOfIterations());
+    pressure0.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(pressure0(i, j), solver.pressure()(i, j), 1e-8);
+    });
+
+    // When the fluid region changes, the solution is the same as the one
+    // from the cold start
+    fluidSdf.fill([&](const Vector2D& x) {
+        return x.y + 0.2 * x.x - 9.2;
+    });
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+
+    GridFractionalSinglePhasePressureSolver2 coldSolver;
+    coldSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver2>(100, 1e-10));
+    coldSolver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    pressure0.forEachIndex([&](size_t i, size_t j) {
+        EXPECT_NEAR(
+            coldSolver.pressure()(i, j), solver.pressure()(i, j), 1e-8);
+    });
+}
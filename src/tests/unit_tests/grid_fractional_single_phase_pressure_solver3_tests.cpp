@@ -1,12 +1,45 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/cell_centered_scalar_grid3.h>
+#include <jet/custom_scalar_field3.h>
 #include <jet/face_centered_grid3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
 #include <jet/grid_fractional_single_phase_pressure_solver3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 
 using namespace jet;
 
+namespace {
+
+class CountingSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    unsigned int numberOfSolves = 0;
+    unsigned int numberOfSolvesWithSameMatrix = 0;
+
+    bool solve(FdmLinearSystem3* system) override {
+        ++numberOfSolves;
+        return _solver.solve(system);
+    }
+
+    bool solveWithSameMatrix(FdmLinearSystem3* system) override {
+        ++numberOfSolvesWithSameMatrix;
+        return _solver.solveWithSameMatrix(system);
+    }
+
+    unsigned int lastNumberOfIterations() const override {
+        return _solver.lastNumberOfIterations();
+    }
+
+ private:
+    FdmIccgSolver3 _solver{100, 1e-10};
+};
+
+}  // namespace
+
 TEST(GridFractionalSinglePhasePressureSolver3, SolveFreeSurface) {
     FaceCenteredGrid3 vel(3, 3, 3);
     CellCenteredScalarGrid3 fluidSdf(3, 3, 3);
@@ -66,3 +99,299 @@ TEST(GridFractionalSinglePhasePressureSolver3, SolveFreeSurface) {
         }
     }
 }
+
+TEST(GridFractionalSinglePhasePressureSolver3, SolveMatrixFree) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.y + 0.3 * x.z),
+            std::cos(0.7 * x.x),
+            std::sin(x.x * x.y));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    GridFractionalSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+
+    // The on-the-fly operator must match the assembled matrix
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmMatrixFreeCgSolver3>(1000, 1e-10));
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    const FdmVector3& pressure1 = solver.pressure();
+
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), pressure1(i, j, k), 1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.u(i, j, k), vel1.u(i, j, k), 1e-8);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.v(i, j, k), vel1.v(i, j, k), 1e-8);
+    });
+    vel0.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.w(i, j, k), vel1.w(i, j, k), 1e-8);
+    });
+}
+
+TEST(GridFractionalSinglePhasePressureSolver3, SolveCompressed) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.x + 0.3 * x.z),
+            std::cos(0.7 * x.y),
+            std::sin(x.x * x.z));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    GridFractionalSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+
+    // The system over the fluid cells only must give the same pressure
+    EXPECT_FALSE(solver.isUsingCompressedSystem());
+    solver.setIsUsingCompressedSystem(true);
+    EXPECT_TRUE(solver.isUsingCompressedSystem());
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    FdmVector3 pressure1(solver.pressure());
+
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), pressure1(i, j, k), 1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.u(i, j, k), vel1.u(i, j, k), 1e-8);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.v(i, j, k), vel1.v(i, j, k), 1e-8);
+    });
+    vel0.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.w(i, j, k), vel1.w(i, j, k), 1e-8);
+    });
+
+    // Nothing is left to solve when warm started from the same pressure
+    solver.setIsUsingWarmStart(true);
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    EXPECT_EQ(0u, solver.lastNumberOfIterations());
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), solver.pressure()(i, j, k), 1e-8);
+    });
+}
+
+TEST(GridFractionalSinglePhasePressureSolver3, WarmStart) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.x + 0.3 * x.z),
+            std::cos(0.7 * x.y),
+            std::sin(x.x * x.z));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    GridFractionalSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    EXPECT_FALSE(solver.isUsingWarmStart());
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+    EXPECT_LT(0u, solver.lastNumberOfIterations());
+
+    // Nothing is left to solve for the same system
+    solver.setIsUsingWarmStart(true);
+    EXPECT_TRUE(solver.isUsingWarmStart());
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    EXPECT_EQ(0u, solver.lastNumberOfIterations());
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), solver.pressure()(i, j, k), 1e-8);
+    });
+
+    // When the fluid region changes, the solution is the same as the one
+    // from the cold start
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.2;
+    });
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+
+    GridFractionalSinglePhasePressureSolver3 coldSolver;
+    coldSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    coldSolver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(
+            coldSolver.pressure()(i, j, k), solver.pressure()(i, j, k), 1e-8);
+    });
+}
+
+TEST(GridFractionalSinglePhasePressureSolver3, LastMaxVelocity) {
+    FaceCenteredGrid3 input(8, 8, 8, 0.125, 0.125, 0.125);
+    input.fill([](const Vector3D& x) {
+        return Vector3D(std::sin(6.0 * x.y), x.x * x.z, -3.0 * x.z * x.z);
+    });
+    CellCenteredScalarGrid3 fluidSdf(8, 8, 8, 0.125, 0.125, 0.125);
+    fluidSdf.fill([](const Vector3D& x) {
+        return x.y - 0.6;
+    });
+
+    GridFractionalSinglePhasePressureSolver3 solver;
+    EXPECT_GT(0.0, solver.lastMaxVelocity());
+
+    FaceCenteredGrid3 output(input);
+    solver.solve(
+        input, 1.0, &output, ConstantScalarField3(kMaxD), fluidSdf);
+
+    // All the faces count, including those outside of the fluid
+    double maxVelocity = 0.0;
+    output.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        maxVelocity = std::max(maxVelocity, std::fabs(output.u(i, j, k)));
+    });
+    output.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        maxVelocity = std::max(maxVelocity, std::fabs(output.v(i, j, k)));
+    });
+    output.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        maxVelocity = std::max(maxVelocity, std::fabs(output.w(i, j, k)));
+    });
+    EXPECT_DOUBLE_EQ(maxVelocity, solver.lastMaxVelocity());
+}
+
+TEST(GridFractionalSinglePhasePressureSolver3, MatrixReuse) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    auto counter = std::make_shared<CountingSolver3>();
+    GridFractionalSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(counter);
+
+    GridFractionalSinglePhasePressureSolver3 coldSolver;
+    coldSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+
+    auto expectSameAsColdSolve = [&](double phase) {
+        vel.fill([&](const Vector3D& x) {
+            return Vector3D(
+                std::sin(x.x + 0.3 * x.z + phase),
+                std::cos(0.7 * x.y),
+                std::sin(x.x * x.z));
+        });
+        FaceCenteredGrid3 vel0(vel), vel1(vel);
+        solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+        coldSolver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+        solver.pressure().forEachIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(
+                coldSolver.pressure()(i, j, k),
+                solver.pressure()(i, j, k),
+                1e-8);
+        });
+    };
+
+    // Only the right-hand side changes for the same domain
+    expectSameAsColdSolve(0.0);
+    expectSameAsColdSolve(1.0);
+    expectSameAsColdSolve(2.0);
+    EXPECT_EQ(1u, counter->numberOfSolves);
+    EXPECT_EQ(2u, counter->numberOfSolvesWithSameMatrix);
+
+    // The matrix is rebuilt when the fluid region changes
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.2;
+    });
+    expectSameAsColdSolve(3.0);
+    EXPECT_EQ(2u, counter->numberOfSolves);
+    EXPECT_EQ(2u, counter->numberOfSolvesWithSameMatrix);
+
+    // ...and when the solver is replaced
+    solver.setLinearSystemSolver(counter);
+    expectSameAsColdSolve(4.0);
+    EXPECT_EQ(3u, counter->numberOfSolves);
+}
+
+TEST(GridFractionalSinglePhasePressureSolver3, SolveWithGridSdf) {
+    FaceCenteredGrid3 vel(8, 7, 6, 0.5, 0.5, 0.5, 0.2, 0.1, 0.0);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6, 0.5, 0.5, 0.5, 0.2, 0.1, 0.0);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6, 0.5, 0.5, 0.5, 0.2, 0.1, 0.0);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.x + 0.3 * x.z),
+            std::cos(0.7 * x.y),
+            std::sin(x.x * x.z));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(1.0, 1.0, 1.5)).length() - 0.8;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 2.7;
+    });
+
+    // The grids that share the cell centers are read directly, which should
+    // give the same system as sampling them
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+    GridFractionalSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+
+    GridFractionalSinglePhasePressureSolver3 samplingSolver;
+    samplingSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    samplingSolver.solve(
+        vel,
+        1.0,
+        &vel1,
+        CustomScalarField3([&](const Vector3D& x) {
+            return boundarySdf.sample(x);
+        }),
+        CustomScalarField3([&](const Vector3D& x) {
+            return fluidSdf.sample(x);
+        }));
+
+    solver.pressure().forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(
+            samplingSolver.pressure()(i, j, k),
+            solver.pressure()(i, j, k),
+            1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel1.u(i, j, k), vel0.u(i, j, k), 1e-8);
+    });
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/grid_sdf_collider3.h>
+#include <jet/plane3.h>
+#include <jet/rigid_body_collider3.h>
+#include <jet/sphere3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(GridSdfCollider3, Constructors) {
+    auto rigidBody = std::make_shared<RigidBodyCollider3>(
+        std::make_shared<Sphere3>(Vector3D(), 1.0));
+    rigidBody->setFrictionCoefficient(0.3);
+
+    GridSdfCollider3 collider(
+        rigidBody, Size3(8, 8, 8), Vector3D(0.5, 0.5, 0.5),
+        Vector3D(-2, -2, -2));
+
+    EXPECT_EQ(rigidBody, collider.collider());
+    EXPECT_DOUBLE_EQ(0.3, collider.frictionCoefficient());
+    EXPECT_EQ(Size3(8, 8, 8), collider.sdf().resolution());
+    EXPECT_DOUBLE_EQ(
+        std::sqrt(3.0 * 0.25 * 0.25) - 1.0, collider.sdf()(4, 4, 4));
+}
+
+TEST(GridSdfCollider3, ResolveCollision) {
+    auto rigidBody = std::make_shared<RigidBodyCollider3>(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, 0, 0)));
+    rigidBody->linearVelocity = Vector3D(0, 0.5, 0);
+
+    GridSdfCollider3 collider(
+        rigidBody, Size3(8, 8, 8), Vector3D(0.5, 0.5, 0.5),
+        Vector3D(-2, -2, -2));
+
+    // Inside the grid, the linear SDF of a plane is reproduced exactly
+    Vector3D expectedPosition(1, -0.3, 0.2);
+    Vector3D expectedVelocity(1, -1, 0);
+    Vector3D newPosition = expectedPosition;
+    Vector3D newVelocity = expectedVelocity;
+    rigidBody->resolveCollision(
+        0.1, 0.5, &expectedPosition, &expectedVelocity);
+    collider.resolveCollision(0.1, 0.5, &newPosition, &newVelocity);
+
+    EXPECT_NEAR(expectedPosition.x, newPosition.x, 1e-12);
+    EXPECT_NEAR(expectedPosition.y, newPosition.y, 1e-12);
+    EXPECT_NEAR(expectedPosition.z, newPosition.z, 1e-12);
+    EXPECT_NEAR(expectedVelocity.x, newVelocity.x, 1e-12);
+    EXPECT_NEAR(expectedVelocity.y, newVelocity.y, 1e-12);
+    EXPECT_NEAR(expectedVelocity.z, newVelocity.z, 1e-12);
+
+    // Outside the grid, the query falls back to the original surface
+    expectedPosition = Vector3D(10, -0.3, 0);
+    expectedVelocity = Vector3D(1, -1, 0);
+    newPosition = expectedPosition;
+    newVelocity = expectedVelocity;
+    rigidBody->resolveCollision(
+        0.1, 0.5, &expectedPosition, &expectedVelocity);
+    collider.resolveCollision(0.1, 0.5, &newPosition, &newVelocity);
+
+    EXPECT_DOUBLE_EQ(expectedPosition.x, newPosition.x);
+    EXPECT_DOUBLE_EQ(expectedPosition.y, newPosition.y);
+    EXPECT_DOUBLE_EQ(expectedPosition.z, newPosition.z);
+    EXPECT_DOUBLE_EQ(expectedVelocity.x, newVelocity.x);
+    EXPECT_DOUBLE_EQ(expectedVelocity.y, newVelocity.y);
+    EXPECT_DOUBLE_EQ(expectedVelocity.z, newVelocity.z);
+}
+
+TEST(GridSdfCollider3, Sphere) {
+    auto rigidBody = std::make_shared<RigidBodyCollider3>(
+        std::make_shared<Sphere3>(Vector3D(), 1.0));
+
+    GridSdfCollider3 collider(
+        rigidBody, Size3(40, 40, 40), Vector3D(0.1, 0.1, 0.1),
+        Vector3D(-2, -2, -2));
+
+    Vector3D newPosition(0.3, 0.4, 0.5);
+    Vector3D newVelocity(0, 0, 0);
+    collider.resolveCollision(0.0, 0.0, &newPosition, &newVelocity);
+
+    EXPECT_NEAR(1.0, newPosition.length(), 0.02);
+    EXPECT_NEAR(0.0, newPosition.normalized().cross(
+        Vector3D(0.3, 0.4, 0.5).normalized()).length(), 0.02);
+}
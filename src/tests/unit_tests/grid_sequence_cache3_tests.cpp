@@ -0,0 +1,158 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/grid_sequence_cache3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// A blob that moves along x, so only the tiles around it change
+void fillFrame(size_t frame, ScalarGrid3* grid) {
+    grid->fill([&](const Vector3D& pt) {
+        Vector3D r = pt - Vector3D(0.2 + 0.02 * frame, 0.3, 0.3);
+        return std::exp(-r.lengthSquared() / 0.0005);
+    });
+}
+
+}  // namespace
+
+TEST(GridSequenceCache3, WriteAndRead) {
+    const std::string filename = "grid_sequence_cache3_tests_write.gseq";
+    const size_t numberOfFrames = 10;
+    const double tolerance = 1e-4;
+
+    const Size3 resolution(32, 24, 20);
+    const Vector3D gridSpacing(1.0 / 32, 1.0 / 32, 1.0 / 32);
+    const Vector3D origin(0.0, 0.0, 0.0);
+    CellCenteredScalarGrid3 grid(resolution, gridSpacing, origin);
+
+    size_t rawSize = 0;
+    size_t cacheSize = 0;
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        GridSequenceCacheWriter3 writer(&file);
+        writer.setTolerance(tolerance);
+        writer.setKeyframeInterval(4);
+        for (size_t f = 0; f < numberOfFrames; ++f) {
+            fillFrame(f, &grid);
+            writer.addFrame(grid);
+            rawSize += resolution.x * resolution.y * resolution.z
+                * sizeof(double);
+        }
+        EXPECT_EQ(numberOfFrames, writer.numberOfFrames());
+        EXPECT_THROW(writer.setKeyframeInterval(2), std::invalid_argument);
+        EXPECT_THROW(
+            writer.addFrame(CellCenteredScalarGrid3(2, 2, 2)),
+            std::invalid_argument);
+        writer.close();
+        cacheSize = static_cast<size_t>(file.tellp());
+    }
+    EXPECT_LT(cacheSize * 10, rawSize);
+
+    GridSequenceCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    ASSERT_EQ(numberOfFrames, reader.numberOfFrames());
+    EXPECT_EQ(resolution, reader.resolution());
+    EXPECT_EQ(gridSpacing, reader.gridSpacing());
+    EXPECT_EQ(origin, reader.origin());
+    EXPECT_EQ(grid.dataSize(), reader.dataSize());
+    EXPECT_EQ(grid.dataOrigin(), reader.dataOrigin());
+    EXPECT_DOUBLE_EQ(tolerance, reader.tolerance());
+
+    const size_t numberOfTiles = 4 * 3 * 3;
+    for (size_t f = 0; f < numberOfFrames; ++f) {
+        EXPECT_EQ(f % 4 == 0, reader.isKeyframe(f));
+        if (reader.isKeyframe(f)) {
+            EXPECT_EQ(numberOfTiles, reader.numberOfStoredTiles(f));
+        } else {
+            EXPECT_GT(reader.numberOfStoredTiles(f), 0u);
+            EXPECT_LT(reader.numberOfStoredTiles(f), numberOfTiles);
+            EXPECT_LT(reader.frameSize(f), reader.frameSize(f - f % 4));
+        }
+    }
+
+    // Sequential, backward, and random access
+    std::vector<size_t> order = { 0, 1, 2, 3, 4, 5, 9, 7, 6, 2, 8, 8 };
+    CellCenteredScalarGrid3 expected;
+    expected.resize(resolution, gridSpacing, origin);
+    for (size_t f : order) {
+        CellCenteredScalarGrid3 decoded;
+        ASSERT_TRUE(reader.readFrame(f, &decoded));
+        EXPECT_EQ(resolution, decoded.resolution());
+
+        fillFrame(f, &expected);
+        expected.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(expected(i, j, k), decoded(i, j, k), tolerance);
+        });
+    }
+
+    CellCenteredScalarGrid3 decoded;
+    EXPECT_FALSE(reader.readFrame(numberOfFrames, &decoded));
+
+    // The data layout does not match
+    VertexCenteredScalarGrid3 vertexGrid;
+    EXPECT_FALSE(reader.readFrame(0, &vertexGrid));
+
+    reader.close();
+    EXPECT_EQ(0u, reader.numberOfFrames());
+    std::remove(filename.c_str());
+}
+
+TEST(GridSequenceCache3, UnchangedFrames) {
+    const std::string filename = "grid_sequence_cache3_tests_unchanged.gseq";
+
+    CellCenteredScalarGrid3 grid(
+        Size3(9, 9, 9), Vector3D(0.1, 0.1, 0.1), Vector3D());
+    fillFrame(0, &grid);
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        GridSequenceCacheWriter3 writer(&file);
+        for (size_t f = 0; f < 3; ++f) {
+            writer.addFrame(grid);
+        }
+    }
+
+    GridSequenceCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    ASSERT_EQ(3u, reader.numberOfFrames());
+    EXPECT_EQ(8u, reader.numberOfStoredTiles(0));
+    EXPECT_EQ(0u, reader.numberOfStoredTiles(1));
+    EXPECT_EQ(0u, reader.numberOfStoredTiles(2));
+
+    CellCenteredScalarGrid3 decoded;
+    ASSERT_TRUE(reader.readFrame(2, &decoded));
+    grid.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(grid(i, j, k), decoded(i, j, k), 1e-5);
+    });
+
+    reader.close();
+    std::remove(filename.c_str());
+}
+
+TEST(GridSequenceCache3, Empty) {
+    const std::string filename = "grid_sequence_cache3_tests_empty.gseq";
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        GridSequenceCacheWriter3 writer(&file);
+        EXPECT_THROW(writer.setTolerance(0.0), std::invalid_argument);
+        EXPECT_THROW(writer.setKeyframeInterval(0), std::invalid_argument);
+    }
+
+    GridSequenceCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    EXPECT_EQ(0u, reader.numberOfFrames());
+
+    CellCenteredScalarGrid3 grid;
+    EXPECT_FALSE(reader.readFrame(0, &grid));
+
+    EXPECT_FALSE(reader.open("grid_sequence_cache3_tests_missing.gseq"));
+    std::remove(filename.c_str());
+}
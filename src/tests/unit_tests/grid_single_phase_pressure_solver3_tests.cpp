@@ -1,12 +1,46 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/cell_centered_scalar_grid3.h>
+#include <jet/custom_scalar_field3.h>
 #include <jet/face_centered_grid3.h>
+#include <jet/fdm_gauss_seidel_solver3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
 #include <jet/grid_single_phase_pressure_solver3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 
 using namespace jet;
 
+namespace {
+
+class CountingSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    unsigned int numberOfSolves = 0;
+    unsigned int numberOfSolvesWithSameMatrix = 0;
+
+    bool solve(FdmLinearSystem3* system) override {
+        ++numberOfSolves;
+        return _solver.solve(system);
+    }
+
+    bool solveWithSameMatrix(FdmLinearSystem3* system) override {
+        ++numberOfSolvesWithSameMatrix;
+        return _solver.solveWithSameMatrix(system);
+    }
+
+    unsigned int lastNumberOfIterations() const override {
+        return _solver.lastNumberOfIterations();
+    }
+
+ private:
+    FdmIccgSolver3 _solver{100, 1e-10};
+};
+
+}  // namespace
+
 TEST(GridSinglePhasePressureSolver3, SolveSinglePhase) {
     FaceCenteredGrid3 vel(3, 3, 3);
 
@@ -255,3 +289,386 @@ TEST(GridSinglePhasePressureSolver3, SolveFreeSurfaceWithBoundary) {
         }
     }
 }
+
+TEST(GridSinglePhasePressureSolver3, SolveMatrixFree) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.y + 0.3 * x.z),
+            std::cos(0.7 * x.x),
+            std::sin(x.x * x.y));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    GridSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+
+    // The on-the-fly operator must match the assembled matrix
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmMatrixFreeCgSolver3>(1000, 1e-10));
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    const FdmVector3& pressure1 = solver.pressure();
+
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), pressure1(i, j, k), 1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.u(i, j, k), vel1.u(i, j, k), 1e-8);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.v(i, j, k), vel1.v(i, j, k), 1e-8);
+    });
+    vel0.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.w(i, j, k), vel1.w(i, j, k), 1e-8);
+    });
+}
+
+TEST(GridSinglePhasePressureSolver3, SolveCompressed) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.x + 0.3 * x.z),
+            std::cos(0.7 * x.y),
+            std::sin(x.x * x.z));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    GridSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+
+    // The system over the fluid cells only must give the same pressure
+    EXPECT_FALSE(solver.isUsingCompressedSystem());
+    solver.setIsUsingCompressedSystem(true);
+    EXPECT_TRUE(solver.isUsingCompressedSystem());
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    FdmVector3 pressure1(solver.pressure());
+
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), pressure1(i, j, k), 1e-8);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.u(i, j, k), vel1.u(i, j, k), 1e-8);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.v(i, j, k), vel1.v(i, j, k), 1e-8);
+    });
+    vel0.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.w(i, j, k), vel1.w(i, j, k), 1e-8);
+    });
+
+    // Nothing is left to solve when warm started from the same pressure
+    solver.setIsUsingWarmStart(true);
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    EXPECT_EQ(0u, solver.lastNumberOfIterations());
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), solver.pressure()(i, j, k), 1e-8);
+    });
+}
+
+TEST(GridSinglePhasePressureSolver3, SolveCompressedUnsupported) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.x + 0.3 * x.z),
+            std::cos(0.7 * x.y),
+            std::sin(x.x * x.z));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    auto systemSolver
+        = std::make_shared<FdmGaussSeidelSolver3>(1000, 10, 1e-10);
+    EXPECT_FALSE(systemSolver->isCompressedSystemSupported());
+
+    GridSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(systemSolver);
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+    EXPECT_LT(0.0, *std::max_element(pressure0.begin(), pressure0.end()));
+
+    // The solver cannot take a compressed system, so the full one is solved,
+    // starting from the last pressure
+    solver.setIsUsingCompressedSystem(true);
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), solver.pressure()(i, j, k), 1e-6);
+    });
+    vel0.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.u(i, j, k), vel1.u(i, j, k), 1e-6);
+    });
+    vel0.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.v(i, j, k), vel1.v(i, j, k), 1e-6);
+    });
+    vel0.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(vel0.w(i, j, k), vel1.w(i, j, k), 1e-6);
+    });
+}
+
+TEST(GridSinglePhasePressureSolver3, WarmStart) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    vel.fill([&](const Vector3D& x) {
+        return Vector3D(
+            std::sin(x.x + 0.3 * x.z),
+            std::cos(0.7 * x.y),
+            std::sin(x.x * x.z));
+    });
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    FaceCenteredGrid3 vel0(vel), vel1(vel);
+
+    GridSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    EXPECT_FALSE(solver.isUsingWarmStart());
+    solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    FdmVector3 pressure0(solver.pressure());
+    EXPECT_LT(0u, solver.lastNumberOfIterations());
+
+    // Nothing is left to solve for the same system
+    solver.setIsUsingWarmStart(true);
+    EXPECT_TRUE(solver.isUsingWarmStart());
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+    EXPECT_EQ(0u, solver.lastNumberOfIterations());
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(pressure0(i, j, k), solver.pressure()(i, j, k), 1e-8);
+    });
+
+    // When the fluid region changes, the solution is the same as the one
+    // from the cold start
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.2;
+    });
+    solver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+
+    GridSinglePhasePressureSolver3 coldSolver;
+    coldSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+    coldSolver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+    pressure0.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(
+            coldSolver.pressure()(i, j, k), solver.pressure()(i, j, k), 1e-8);
+    });
+}
+
+TEST(GridSinglePhasePressureSolver3, LastMaxVelocity) {
+    FaceCenteredGrid3 input(8, 8, 8, 0.125, 0.125, 0.125);
+    input.fill([](const Vector3D& x) {
+        return Vector3D(std::sin(6.0 * x.y), x.x * x.z, -3.0 * x.z * x.z);
+    });
+    CellCenteredScalarGrid3 fluidSdf(8, 8, 8, 0.125, 0.125, 0.125);
+    fluidSdf.fill([](const Vector3D& x) {
+        return x.y - 0.6;
+    });
+
+    GridSinglePhasePressureSolver3 solver;
+    EXPECT_GT(0.0, solver.lastMaxVelocity());
+
+    FaceCenteredGrid3 output(input);
+    solver.solve(
+        input, 1.0, &output, ConstantScalarField3(kMaxD), fluidSdf);
+
+    // All the faces count, including those outside of the fluid
+    double maxVelocity = 0.0;
+    output.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        maxVelocity = std::max(maxVelocity, std::fabs(output.u(i, j, k)));
+    });
+    output.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        maxVelocity = std::max(maxVelocity, std::fabs(output.v(i, j, k)));
+    });
+    output.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        maxVelocity = std::max(maxVelocity, std::fabs(output.w(i, j, k)));
+    });
+    EXPECT_DOUBLE_EQ(maxVelocity, solver.lastMaxVelocity());
+}
+
+TEST(GridSinglePhasePressureSolver3, MatrixReuse) {
+    FaceCenteredGrid3 vel(8, 7, 6);
+    CellCenteredScalarGrid3 fluidSdf(8, 7, 6);
+    CellCenteredScalarGrid3 boundarySdf(8, 7, 6);
+
+    boundarySdf.fill([&](const Vector3D& x) {
+        return (x - Vector3D(2.0, 2.0, 3.0)).length() - 1.5;
+    });
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.5;
+    });
+
+    auto counter = std::make_shared<CountingSolver3>();
+    GridSinglePhasePressureSolver3 solver;
+    solver.setLinearSystemSolver(counter);
+
+    GridSinglePhasePressureSolver3 coldSolver;
+    coldSolver.setLinearSystemSolver(
+        std::make_shared<FdmIccgSolver3>(100, 1e-10));
+
+    auto expectSameAsColdSolve = [&](double phase) {
+        vel.fill([&](const Vector3D& x) {
+            return Vector3D(
+                std::sin(x.x + 0.3 * x.z + phase),
+                std::cos(0.7 * x.y),
+                std::sin(x.x * x.z));
+        });
+        FaceCenteredGrid3 vel0(vel), vel1(vel);
+        solver.solve(vel, 1.0, &vel0, boundarySdf, fluidSdf);
+        coldSolver.solve(vel, 1.0, &vel1, boundarySdf, fluidSdf);
+        solver.pressure().forEachIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(
+                coldSolver.pressure()(i, j, k),
+                solver.pressure()(i, j, k),
+                1e-8);
+        });
+    };
+
+    // Only the right-hand side changes for the same domain
+    expectSameAsColdSolve(0.0);
+    expectSameAsColdSolve(1.0);
+    expectSameAsColdSolve(2.0);
+    EXPECT_EQ(1u, counter->numberOfSolves);
+    EXPECT_EQ(2u, counter->numberOfSolvesWithSameMatrix);
+
+    // The matrix is rebuilt when the fluid region changes
+    fluidSdf.fill([&](const Vector3D& x) {
+        return x.y + 0.2 * x.x - 5.2;
+    });
+    expectSameAsColdSolve(3.0);
+    EXPECT_EQ(2u, counter->numberOfSolves);
+    EXPECT_EQ(2u, counter->numberOfSolvesWithSameMatrix);
+
+    // ...and when the solver is replaced
+    solver.setLinearSystemSolver(counter);
+    expectSameAsColdSolve(4.0);
+    EXPECT_EQ(3u, counter->numberOfSolves);
+}
+
+TEST(GridSinglePhasePressureSolver3, CoarseProjection) {
+    CustomScalarField3 sphereSdf([](const Vector3D& x) {
+        return (x - Vector3D(0.7, 0.6, 0.5)).length() - 0.3;
+    });
+    ConstantScalarField3 noBoundarySdf(kMaxD);
+
+    for (int pass = 0; pass < 3; ++pass) {
+        Size3 res = (pass == 0) ? Size3(16, 12, 10) : Size3(15, 12, 11);
+        const ScalarField3& boundarySdf = (pass == 2)
+            ? static_cast<const ScalarField3&>(sphereSdf) : noBoundarySdf;
+
+        FaceCenteredGrid3 vel(res, Vector3D(0.1, 0.1, 0.1));
+        vel.fill([](const Vector3D& x) {
+            return Vector3D(
+                std::sin(2.0 * x.y) + x.x * x.z,
+                std::cos(1.5 * x.z) * x.y,
+                std::sin(x.x + x.y * x.z));
+        });
+
+        // Closed walls and a still collider, as the boundary condition solver
+        // would set
+        auto pos = vel.cellCenterPosition();
+        auto isSolid = [&](size_t i, size_t j, size_t k) {
+            return boundarySdf.sample(pos(i, j, k)) < 0.0;
+        };
+        vel.forEachUIndex([&](size_t i, size_t j, size_t k) {
+            if (i == 0 || i == res.x
+                || isSolid(i - 1, j, k) || isSolid(i, j, k)) {
+                vel.u(i, j, k) = 0.0;
+            }
+        });
+        vel.forEachVIndex([&](size_t i, size_t j, size_t k) {
+            if (j == 0 || j == res.y
+                || isSolid(i, j - 1, k) || isSolid(i, j, k)) {
+                vel.v(i, j, k) = 0.0;
+            }
+        });
+        vel.forEachWIndex([&](size_t i, size_t j, size_t k) {
+            if (k == 0 || k == res.z
+                || isSolid(i, j, k - 1) || isSolid(i, j, k)) {
+                vel.w(i, j, k) = 0.0;
+            }
+        });
+
+        GridSinglePhasePressureSolver3 fineSolver;
+        fineSolver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(200, 1e-10));
+        FaceCenteredGrid3 fine(vel);
+        fineSolver.solve(vel, 1.0, &fine, boundarySdf);
+
+        GridSinglePhasePressureSolver3 solver;
+        EXPECT_FALSE(solver.isUsingCoarseProjection());
+        solver.setIsUsingCoarseProjection(true);
+        EXPECT_TRUE(solver.isUsingCoarseProjection());
+        solver.setLinearSystemSolver(
+            std::make_shared<FdmIccgSolver3>(200, 1e-10));
+        FaceCenteredGrid3 coarse(vel);
+        solver.solve(vel, 1.0, &coarse, boundarySdf);
+
+        // Every fluid cell is divergence-free, and not only on average over
+        // the coarse cells
+        Array3<double> div(res);
+        coarse.computeDivergence(div.accessor());
+        div.forEachIndex([&](size_t i, size_t j, size_t k) {
+            if (!isSolid(i, j, k)) {
+                EXPECT_NEAR(0.0, div(i, j, k), 1e-6);
+            }
+        });
+
+        // The large scale motion is close to the full resolution solve
+        double diff = 0.0;
+        double norm = 0.0;
+        fine.forEachUIndex([&](size_t i, size_t j, size_t k) {
+            diff += square(fine.u(i, j, k) - coarse.u(i, j, k));
+            norm += square(fine.u(i, j, k));
+        });
+        fine.forEachVIndex([&](size_t i, size_t j, size_t k) {
+            diff += square(fine.v(i, j, k) - coarse.v(i, j, k));
+            norm += square(fine.v(i, j, k));
+        });
+        fine.forEachWIndex([&](size_t i, size_t j, size_t k) {
+            diff += square(fine.w(i, j, k) - coarse.w(i, j, k));
+            norm += square(fine.w(i, j, k));
+        });
+        EXPECT_LT(std::sqrt(diff / norm), 0.3);
+        EXPECT_LT(0.0, solver.lastMaxVelocity());
+    }
+}
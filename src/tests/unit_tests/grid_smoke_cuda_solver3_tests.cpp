@@ -0,0 +1,96 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/grid_smoke_cuda_solver3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace jet;
+
+namespace {
+
+void setUpPlume(GridSmokeSolver3* solver) {
+    const size_t n = 12;
+    const double h = 1.0 / n;
+    solver->resizeGrid(Size3(n, 2 * n, n), Vector3D(h, h, h), Vector3D());
+    solver->setSmokeDiffusionCoefficient(0.001);
+    solver->setTemperatureDiffusionCoefficient(0.001);
+
+    auto source = [](const Vector3D& pt) {
+        Vector3D r = pt - Vector3D(0.5, 0.25, 0.5);
+        return std::exp(-r.lengthSquared() / 0.01);
+    };
+    solver->smokeDensity()->fill(source);
+    solver->temperature()->fill(source);
+}
+
+}  // namespace
+
+TEST(GridSmokeCudaSolver3, UpdateEmpty) {
+    GridSmokeCudaSolver3 solver;
+    EXPECT_EQ(
+        GridSmokeCudaSolver3::isDeviceAvailable(), solver.isUsingDevice());
+    EXPECT_TRUE(solver.isSyncingHostEveryFrame());
+
+    Frame frame;
+    solver.update(frame);
+    solver.update(frame);
+}
+
+TEST(GridSmokeCudaSolver3, MatchesGridSmokeSolver3) {
+    for (bool isSyncing : { true, false }) {
+        GridSmokeSolver3 solver;
+        GridSmokeCudaSolver3 cudaSolver;
+        cudaSolver.setIsSyncingHostEveryFrame(isSyncing);
+        setUpPlume(&solver);
+        setUpPlume(&cudaSolver);
+
+        for (Frame frame(0, 1.0 / 60.0); frame.index < 3; frame.advance()) {
+            solver.update(frame);
+            cudaSolver.update(frame);
+        }
+
+        // The device solves the pressure and the diffusion with a different
+        // preconditioner
+        CellCenteredScalarGrid3 density;
+        cudaSolver.downloadSmokeDensity(&density);
+        cudaSolver.downloadToHost();
+
+        auto den = solver.smokeDensity();
+        auto cudaDen = cudaSolver.smokeDensity();
+        auto vel = solver.velocity();
+        auto cudaVel = cudaSolver.velocity();
+        ASSERT_EQ(den->resolution(), density.resolution());
+        den->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR((*den)(i, j, k), (*cudaDen)(i, j, k), 1e-4);
+            EXPECT_DOUBLE_EQ((*cudaDen)(i, j, k), density(i, j, k));
+        });
+        vel->forEachVIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(vel->v(i, j, k), cudaVel->v(i, j, k), 1e-4);
+        });
+    }
+}
+
+TEST(GridSmokeCudaSolver3, FallsBackToHost) {
+    GridSmokeSolver3 solver;
+    GridSmokeCudaSolver3 cudaSolver;
+    GridSmokeSolver3* solvers[]
+        = { &solver, static_cast<GridSmokeSolver3*>(&cudaSolver) };
+    for (GridSmokeSolver3* s : solvers) {
+        setUpPlume(s);
+
+        // The device does not run the vorticity confinement
+        s->setVorticityConfinementFactor(1.0);
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 2; frame.advance()) {
+        solver.update(frame);
+        cudaSolver.update(frame);
+    }
+
+    auto den = solver.smokeDensity();
+    auto cudaDen = cudaSolver.smokeDensity();
+    den->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ((*den)(i, j, k), (*cudaDen)(i, j, k));
+    });
+}
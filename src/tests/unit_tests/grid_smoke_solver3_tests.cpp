@@ -0,0 +1,255 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/grid_single_phase_pressure_solver3.h>
+#include <jet/grid_smoke_solver3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+
+using namespace jet;
+
+namespace {
+
+// Exposes the external force stage of the solver
+class ForceGridSmokeSolver3 final : public GridSmokeSolver3 {
+ public:
+    using GridSmokeSolver3::computeExternalForces;
+};
+
+// Returns the angular momentum around the z-axis through the domain center,
+// summed over the faces within the vortex core.
+double coreAngularMomentum(const FaceCenteredGrid3& vel) {
+    double sum = 0.0;
+    auto uPos = vel.uPosition();
+    auto vPos = vel.vPosition();
+    vel.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D r = uPos(i, j, k) - Vector3D(0.5, 0.5, 0.0);
+        if (r.x * r.x + r.y * r.y < 0.01) {
+            sum -= r.y * vel.u(i, j, k);
+        }
+    });
+    vel.forEachVIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D r = vPos(i, j, k) - Vector3D(0.5, 0.5, 0.0);
+        if (r.x * r.x + r.y * r.y < 0.01) {
+            sum += r.x * vel.v(i, j, k);
+        }
+    });
+    return sum;
+}
+
+}  // namespace
+
+TEST(GridSmokeSolver3, VorticityConfinementFactor) {
+    GridSmokeSolver3 solver;
+    EXPECT_DOUBLE_EQ(0.0, solver.vorticityConfinementFactor());
+
+    solver.setVorticityConfinementFactor(2.5);
+    EXPECT_DOUBLE_EQ(2.5, solver.vorticityConfinementFactor());
+
+    solver.setVorticityConfinementFactor(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, solver.vorticityConfinementFactor());
+
+    solver.setVorticityConfinementFactor(1.5);
+    std::stringstream strm;
+    solver.serialize(&strm);
+
+    GridSmokeSolver3 solver2;
+    solver2.deserialize(&strm);
+    EXPECT_DOUBLE_EQ(1.5, solver2.vorticityConfinementFactor());
+}
+
+TEST(GridSmokeSolver3, VorticityConfinement) {
+    const size_t n = 16;
+    const double h = 1.0 / n;
+
+    auto vortex = [](const Vector3D& x) {
+        double rx = x.x - 0.5;
+        double ry = x.y - 0.5;
+        double falloff = std::exp(-(rx * rx + ry * ry) / 0.02);
+        return Vector3D(-ry * falloff, rx * falloff, 0.0);
+    };
+
+    double momenta[2];
+    for (int pass = 0; pass < 2; ++pass) {
+        ForceGridSmokeSolver3 solver;
+        solver.resizeGrid(Size3(n, n, n), Vector3D(h, h, h), Vector3D());
+        solver.setBuoyancySmokeDensityFactor(0.0);
+        solver.setBuoyancyTemperatureFactor(0.0);
+        solver.setVorticityConfinementFactor(pass == 0 ? 0.0 : 5.0);
+        solver.velocity()->fill(vortex);
+
+        double before = coreAngularMomentum(*solver.velocity());
+        solver.computeExternalForces(0.1);
+        momenta[pass] = coreAngularMomentum(*solver.velocity());
+
+        if (pass == 0) {
+            // No force without the confinement
+            EXPECT_DOUBLE_EQ(before, momenta[pass]);
+        }
+    }
+
+    // The confinement spins up the core of the vortex
+    EXPECT_GT(momenta[1], momenta[0]);
+}
+
+TEST(GridSmokeSolver3, AutoBounds) {
+    const size_t n = 32;
+    const double h = 1.0 / n;
+
+    GridSmokeSolver3 solver;
+    solver.resizeGrid(Size3(n, n, n), Vector3D(h, h, h), Vector3D());
+    solver.setMaxCfl(2.0);
+    solver.setIsUsingAutoBounds(true);
+    EXPECT_TRUE(solver.isUsingAutoBounds());
+    EXPECT_EQ(2u, solver.autoBoundsPadding());
+
+    // A puff of smoke in the lower middle of the domain
+    Vector3D center(0.5, 0.3, 0.5);
+    solver.smokeDensity()->fill([&](const Vector3D& pt) {
+        return (pt.distanceTo(center) < 0.1) ? 1.0 : 0.0;
+    });
+
+    solver.update(Frame(1, 1.0 / 60.0));
+
+    // The grid covers the puff with the padding of 2 + 2 cells, aligned with
+    // the cells of the max domain
+    Size3 res = solver.gridResolution();
+    EXPECT_LT(res.x, n);
+    EXPECT_LT(res.y, n);
+    EXPECT_LT(res.z, n);
+    EXPECT_EQ(Size3(n, n, n), solver.maxDomainResolution());
+    EXPECT_EQ(Vector3D(), solver.maxDomainOrigin());
+    Vector3D cells = solver.gridOrigin() / h;
+    EXPECT_NEAR(std::round(cells.x), cells.x, 1e-9);
+    EXPECT_NEAR(std::round(cells.y), cells.y, 1e-9);
+    EXPECT_NEAR(std::round(cells.z), cells.z, 1e-9);
+
+    auto den = solver.smokeDensity();
+    EXPECT_GT((*den)(res.x / 2, res.y / 2, res.z / 2), 0.5);
+    den->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        if (i == 0 || j == 0 || k == 0
+            || i + 1 == res.x || j + 1 == res.y || k + 1 == res.z) {
+            EXPECT_LE((*den)(i, j, k), solver.autoBoundsThreshold());
+        }
+    });
+
+    // Disabling grows the grid back without moving the smoke
+    Vector3D puff = den->dataPosition()(res.x / 2, res.y / 2, res.z / 2);
+    double value = den->sample(puff);
+    solver.setIsUsingAutoBounds(false);
+    EXPECT_EQ(Size3(n, n, n), solver.gridResolution());
+    EXPECT_EQ(Vector3D(), solver.gridOrigin());
+    EXPECT_DOUBLE_EQ(value, solver.smokeDensity()->sample(puff));
+    EXPECT_DOUBLE_EQ(0.0, (*solver.smokeDensity())(0, 0, 0));
+}
+
+TEST(GridSmokeSolver3, CoarsePressureProjection) {
+    const size_t n = 16;
+    const double h = 1.0 / n;
+
+    GridSmokeSolver3 solver;
+    solver.resizeGrid(Size3(n, n, n), Vector3D(h, h, h), Vector3D());
+    EXPECT_FALSE(solver.isUsingCoarsePressureProjection());
+
+    // Disabling keeps the default solver
+    auto defaultSolver = solver.pressureSolver();
+    solver.setIsUsingCoarsePressureProjection(false);
+    EXPECT_EQ(defaultSolver, solver.pressureSolver());
+
+    solver.setIsUsingCoarsePressureProjection(true);
+    EXPECT_TRUE(solver.isUsingCoarsePressureProjection());
+    auto pressureSolver
+        = std::dynamic_pointer_cast<GridSinglePhasePressureSolver3>(
+            solver.pressureSolver());
+    ASSERT_NE(nullptr, pressureSolver);
+    EXPECT_TRUE(pressureSolver->isUsingCoarseProjection());
+
+    auto temperature = solver.temperature();
+    temperature->fill([](const Vector3D& x) {
+        return ((x - Vector3D(0.5, 0.2, 0.5)).length() < 0.2) ? 1.0 : 0.0;
+    });
+
+    Frame frame(0, 1.0 / 60.0);
+    for (; frame.index < 3; ++frame) {
+        solver.update(frame);
+    }
+
+    // The buoyancy drives a divergence-free rising plume
+    auto vel = solver.velocity();
+    Array3<double> div(n, n, n);
+    vel->computeDivergence(div.accessor());
+    div.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(0.0, div(i, j, k), 1e-3);
+    });
+    EXPECT_LT(0.0, vel->sample(Vector3D(0.5, 0.3, 0.5)).y);
+
+    solver.setIsUsingCoarsePressureProjection(false);
+    EXPECT_FALSE(solver.isUsingCoarsePressureProjection());
+    EXPECT_EQ(pressureSolver, solver.pressureSolver());
+}
+
+TEST(GridSmokeSolver3, Diffusion) {
+    const size_t n = 12;
+    const double h = 1.0 / n;
+    const double frameInterval = 0.1;
+
+    // Two puffs with their own diffusion coefficients, and no motion or
+    // decay, so only the diffusion changes the fields
+    auto density = [](const Vector3D& x) {
+        return std::exp(-(x - Vector3D(0.3, 0.4, 0.5)).lengthSquared() / 0.02);
+    };
+    auto temperature = [](const Vector3D& x) {
+        return 2.0
+            * std::exp(-(x - Vector3D(0.6, 0.5, 0.4)).lengthSquared() / 0.05);
+    };
+
+    for (bool isDiffusingPerFrame : {false, true}) {
+        GridSmokeSolver3 solver;
+        solver.resizeGrid(Size3(n, n, n), Vector3D(h, h, h), Vector3D());
+        solver.setBuoyancySmokeDensityFactor(0.0);
+        solver.setBuoyancyTemperatureFactor(0.0);
+        solver.setSmokeDecayFactor(0.0);
+        solver.setTemperatureDecayFactor(0.0);
+        solver.setSmokeDiffusionCoefficient(0.01);
+        solver.setTemperatureDiffusionCoefficient(0.03);
+        solver.setIsDiffusingPerFrame(isDiffusingPerFrame);
+        EXPECT_EQ(isDiffusingPerFrame, solver.isDiffusingPerFrame());
+        solver.setIsUsingFixedSubTimeSteps(true);
+        solver.setNumberOfFixedSubTimeSteps(2);
+        solver.smokeDensity()->fill(density);
+        solver.temperature()->fill(temperature);
+
+        // Diffuses the initial fields directly with the expected intervals
+        auto expectedDensity = solver.smokeDensity()->clone();
+        auto expectedTemperature = solver.temperature()->clone();
+        auto diffuse = [&](double coefficient, ScalarGrid3Ptr* grid) {
+            const unsigned int numberOfSteps = isDiffusingPerFrame ? 1 : 2;
+            for (unsigned int s = 0; s < numberOfSteps; ++s) {
+                auto source = (*grid)->clone();
+                solver.diffusionSolver()->solve(
+                    *source,
+                    coefficient,
+                    frameInterval / numberOfSteps,
+                    grid->get());
+            }
+        };
+        diffuse(0.01, &expectedDensity);
+        diffuse(0.03, &expectedTemperature);
+
+        solver.update(Frame(1, frameInterval));
+
+        auto den = solver.smokeDensity();
+        auto temp = solver.temperature();
+        den->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR((*expectedDensity)(i, j, k), (*den)(i, j, k), 1e-9);
+            EXPECT_NEAR(
+                (*expectedTemperature)(i, j, k), (*temp)(i, j, k), 1e-9);
+        });
+
+        // Each field is diffused with its own coefficient
+        Vector3D peak(0.3 + 0.5 * h, 0.4 + 0.5 * h, 0.5 + 0.5 * h);
+        EXPECT_LT(den->sample(peak), density(peak));
+        EXPECT_GT(den->sample(peak), 0.5 * density(peak));
+        EXPECT_LT((*temp)(7, 6, 4), temperature(temp->dataPosition()(7, 6, 4)));
+    }
+}
@@ -0,0 +1,177 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/grid_smoke_solver3.h>
+#include <jet/grid_smoke_up_res3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+
+using namespace jet;
+
+namespace {
+
+// Rigid rotation around the z-axis through (0.5, 0.5), whose vorticity is
+// (0, 0, 2) everywhere
+void fillRotation(FaceCenteredGrid3* vel) {
+    vel->fill([](const Vector3D& x) {
+        return Vector3D(-(x.y - 0.5), x.x - 0.5, 0.0);
+    });
+}
+
+}  // namespace
+
+TEST(GridSmokeUpRes3, Parameters) {
+    GridSmokeUpRes3 upRes(4);
+    EXPECT_EQ(4u, upRes.upResFactor());
+    EXPECT_DOUBLE_EQ(1.0, upRes.turbulenceAmplitude());
+    EXPECT_EQ(2u, upRes.numberOfOctaves());
+    EXPECT_NE(nullptr, upRes.advectionSolver());
+
+    upRes.setUpResFactor(0);
+    EXPECT_EQ(1u, upRes.upResFactor());
+
+    upRes.setTurbulenceAmplitude(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, upRes.turbulenceAmplitude());
+}
+
+TEST(GridSmokeUpRes3, UpsampleDensity) {
+    CellCenteredScalarGrid3 coarse(
+        Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125), Vector3D(1, 2, 3));
+    coarse.fill([](const Vector3D& x) {
+        return x.x + 2.0 * x.y - x.z;
+    });
+
+    GridSmokeUpRes3 upRes(4);
+    upRes.upsampleDensity(coarse);
+
+    auto den = upRes.density();
+    EXPECT_EQ(Size3(32, 32, 32), den->resolution());
+    EXPECT_EQ(Vector3D(1, 2, 3), den->origin());
+    EXPECT_DOUBLE_EQ(0.03125, den->gridSpacing().x);
+
+    // Linear interpolation is exact away from the border
+    auto pos = den->dataPosition();
+    for (size_t k = 4; k < 28; k += 5) {
+        for (size_t j = 4; j < 28; j += 3) {
+            for (size_t i = 4; i < 28; i += 7) {
+                Vector3D x = pos(i, j, k);
+                EXPECT_NEAR(x.x + 2.0 * x.y - x.z, (*den)(i, j, k), 1e-12);
+            }
+        }
+    }
+}
+
+TEST(GridSmokeUpRes3, AdvanceWithoutTurbulence) {
+    FaceCenteredGrid3 coarseVelocity(
+        Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125));
+    coarseVelocity.fill(Vector3D(1.0, 0.0, 0.0));
+
+    GridSmokeUpRes3 upRes(4);
+    upRes.setTurbulenceAmplitude(0.0);
+    upRes.advance(coarseVelocity, 0.0);
+
+    auto den = upRes.density();
+    EXPECT_EQ(Size3(32, 32, 32), den->resolution());
+    den->fill([](const Vector3D& x) {
+        return (x.distanceTo(Vector3D(0.3, 0.5, 0.5)) < 0.15) ? 1.0 : 0.0;
+    });
+
+    auto centroid = [&]() {
+        double sum = 0.0;
+        double weightedSum = 0.0;
+        auto pos = den->dataPosition();
+        den->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            sum += (*den)(i, j, k);
+            weightedSum += (*den)(i, j, k) * pos(i, j, k).x;
+        });
+        return weightedSum / sum;
+    };
+
+    double x0 = centroid();
+    upRes.advance(coarseVelocity, 0.1);
+    EXPECT_NEAR(x0 + 0.1, centroid(), 1e-6);
+
+    // The fine velocity is the interpolated coarse velocity
+    upRes.velocity().forEachDataPointIndex(
+        [&](size_t i, size_t j, size_t k) {
+            EXPECT_DOUBLE_EQ(1.0, upRes.velocity()(i, j, k).x);
+        });
+}
+
+TEST(GridSmokeUpRes3, Turbulence) {
+    FaceCenteredGrid3 coarseVelocity(
+        Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125));
+    fillRotation(&coarseVelocity);
+
+    GridSmokeUpRes3 upRes(4);
+    upRes.advance(coarseVelocity, 0.0);
+    const auto& vel = upRes.velocity();
+    const double h = vel.gridSpacing().x;
+
+    // The turbulence is added to the coarse velocity, and it is nearly
+    // divergence-free since the vorticity of the coarse flow is uniform
+    double turbulence = 0.0;
+    double divergence = 0.0;
+    double gradient = 0.0;
+    for (size_t k = 1; k < 31; ++k) {
+        for (size_t j = 1; j < 31; ++j) {
+            for (size_t i = 1; i < 31; ++i) {
+                Vector3D x = vel.dataPosition()(i, j, k);
+                turbulence
+                    += (vel(i, j, k) - coarseVelocity.sample(x)).length();
+
+                double dudx = vel(i + 1, j, k).x - vel(i - 1, j, k).x;
+                double dvdy = vel(i, j + 1, k).y - vel(i, j - 1, k).y;
+                double dwdz = vel(i, j, k + 1).z - vel(i, j, k - 1).z;
+                divergence += std::fabs(dudx + dvdy + dwdz) / (2.0 * h);
+                gradient += (std::fabs(dudx) + std::fabs(dvdy)
+                    + std::fabs(dwdz)) / (2.0 * h);
+            }
+        }
+    }
+    EXPECT_GT(turbulence, 0.0);
+    EXPECT_LT(divergence, 0.2 * gradient);
+
+    // The noise only depends on the seed
+    GridSmokeUpRes3 sameSeed(4);
+    sameSeed.advance(coarseVelocity, 0.0);
+    GridSmokeUpRes3 otherSeed(4);
+    otherSeed.setSeed(7);
+    otherSeed.advance(coarseVelocity, 0.0);
+
+    bool isDifferent = false;
+    vel.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(vel(i, j, k), sameSeed.velocity()(i, j, k));
+        isDifferent |= (vel(i, j, k) != otherSeed.velocity()(i, j, k));
+    });
+    EXPECT_TRUE(isDifferent);
+}
+
+TEST(GridSmokeUpRes3, GridSmokeSolver) {
+    GridSmokeSolver3 solver;
+    solver.resizeGrid(
+        Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125), Vector3D());
+    EXPECT_EQ(nullptr, solver.upRes());
+
+    auto upRes = std::make_shared<GridSmokeUpRes3>(2);
+    solver.setUpRes(upRes);
+    EXPECT_EQ(upRes, solver.upRes());
+
+    auto den = solver.smokeDensity();
+    den->fill([](const Vector3D& x) {
+        return (x.distanceTo(Vector3D(0.5, 0.3, 0.5)) < 0.2) ? 1.0 : 0.0;
+    });
+    upRes->upsampleDensity(*den);
+
+    Frame frame(0, 1.0 / 60.0);
+    solver.update(frame);
+
+    auto fineDen = upRes->density();
+    EXPECT_EQ(Size3(16, 16, 16), fineDen->resolution());
+
+    double sum = 0.0;
+    fineDen->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        sum += (*fineDen)(i, j, k);
+    });
+    EXPECT_GT(sum, 0.0);
+}
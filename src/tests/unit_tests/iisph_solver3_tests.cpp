@@ -0,0 +1,169 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/box3.h>
+#include <jet/iisph_solver3.h>
+#include <jet/pci_sph_solver3.h>
+#include <jet/rigid_body_collider3.h>
+#include <jet/sph_boundary_particles3.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace jet;
+
+TEST(IisphSolver3, UpdateEmpty) {
+    // Empty solver test
+    IisphSolver3 solver;
+    Frame frame;
+    solver.update(frame);
+    solver.update(frame);
+}
+
+TEST(IisphSolver3, Parameters) {
+    IisphSolver3 solver;
+
+    solver.setMaxDensityErrorRatio(5.0);
+    EXPECT_DOUBLE_EQ(5.0, solver.maxDensityErrorRatio());
+
+    solver.setMaxDensityErrorRatio(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, solver.maxDensityErrorRatio());
+
+    solver.setMaxPeakDensityErrorRatio(0.02);
+    EXPECT_DOUBLE_EQ(0.02, solver.maxPeakDensityErrorRatio());
+
+    solver.setMaxPeakDensityErrorRatio(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, solver.maxPeakDensityErrorRatio());
+
+    solver.setMaxNumberOfIterations(10);
+    EXPECT_DOUBLE_EQ(10, solver.maxNumberOfIterations());
+}
+
+TEST(IisphSolver3, Checkpoint) {
+    IisphSolver3 solver;
+    solver.setMaxDensityErrorRatio(0.05);
+    solver.setMaxPeakDensityErrorRatio(0.2);
+    solver.setMaxNumberOfIterations(3);
+    solver.sphSystemData()->addParticle(Vector3D(1.0, 2.0, 3.0));
+
+    Frame frame(1, 1.0 / 60.0);
+    solver.update(frame);
+
+    std::stringstream strm;
+    solver.serialize(&strm);
+
+    IisphSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_DOUBLE_EQ(0.05, restored.maxDensityErrorRatio());
+    EXPECT_DOUBLE_EQ(0.2, restored.maxPeakDensityErrorRatio());
+    EXPECT_EQ(3u, restored.maxNumberOfIterations());
+    EXPECT_EQ(1u, restored.currentFrame().index);
+    ASSERT_EQ(1u, restored.sphSystemData()->numberOfParticles());
+    EXPECT_EQ(
+        solver.sphSystemData()->positions()[0],
+        restored.sphSystemData()->positions()[0]);
+
+    // The IISPH section is missing from a plain SPH checkpoint
+    SphSolver3 sphSolver;
+    std::stringstream sphStrm;
+    sphSolver.serialize(&sphStrm);
+    EXPECT_THROW(restored.deserialize(&sphStrm), std::invalid_argument);
+}
+
+TEST(IisphSolver3, Incompressibility) {
+    IisphSolver3 solver;
+    solver.setGravity(Vector3D());
+
+    // A block compressed by about 20% from the target density
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    const double targetSpacing = particles->targetSpacing();
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            for (int k = 0; k < 10; ++k) {
+                particles->addParticle(
+                    0.75 * targetSpacing * Vector3D(i, j, k));
+            }
+        }
+    }
+
+    Frame frame(0, 1.0 / 60.0);
+    solver.update(frame);
+    frame.advance();
+    solver.update(frame);
+
+    EXPECT_GT(solver.lastNumberOfIterations(), 0u);
+    EXPECT_LT(solver.lastNumberOfIterations(), solver.maxNumberOfIterations());
+    EXPECT_LE(solver.lastDensityErrorRatio(), solver.maxDensityErrorRatio());
+
+    frame.advance();
+    solver.update(frame);
+
+    const double targetDensity = particles->targetDensity();
+    auto densities = particles->densities();
+    for (size_t i = 0; i < densities.size(); ++i) {
+        EXPECT_FALSE(std::isnan(densities[i]));
+        EXPECT_LT(densities[i], 1.05 * targetDensity);
+    }
+}
+
+namespace {
+
+// Drops a block of water onto the floor of a box, and returns the peak
+// density over the frames after the impact.
+double dropBlock(SphSolver3* solver, bool isUsingBoundaryParticles) {
+    BoundingBox3D domain(Vector3D(), Vector3D(0.4, 0.6, 0.4));
+    SphSystemData3Ptr particles = solver->sphSystemData();
+    particles->setTargetDensity(1000.0);
+    particles->setTargetSpacing(0.04);
+    const double spacing = particles->targetSpacing();
+    for (int k = 0; k < 8; ++k) {
+        for (int j = 0; j < 6; ++j) {
+            for (int i = 0; i < 8; ++i) {
+                particles->addParticle(
+                    Vector3D(0.06, 0.2, 0.06) + spacing * Vector3D(i, j, k));
+            }
+        }
+    }
+
+    auto box = std::make_shared<Box3>(domain);
+    box->isNormalFlipped = true;
+    solver->setCollider(std::make_shared<RigidBodyCollider3>(box));
+    if (isUsingBoundaryParticles) {
+        auto boundary = std::make_shared<SphBoundaryParticles3>();
+        BoundingBox3D boundaryDomain(domain);
+        boundaryDomain.expand(spacing);
+        boundary->build(
+            *box, boundaryDomain, spacing, particles->kernelRadius());
+        solver->setBoundaryParticles(boundary);
+    }
+
+    double peakDensity = 0.0;
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 30; frame.advance()) {
+        solver->update(frame);
+        if (frame.index >= 10) {
+            auto d = particles->densities();
+            peakDensity = std::max(
+                peakDensity, *std::max_element(d.begin(), d.end()));
+        }
+    }
+    return peakDensity;
+}
+
+}  // namespace
+
+TEST(IisphSolver3, PeakDensity) {
+    for (bool isUsingBoundaryParticles : {false, true}) {
+        PciSphSolver3 pciSphSolver;
+        double pciSphPeak = dropBlock(&pciSphSolver, isUsingBoundaryParticles);
+
+        // A quarter of the default time-step is still several times the
+        // PCISPH one
+        IisphSolver3 solver;
+        solver.setTimeStepLimitScale(0.25);
+        double peak = dropBlock(&solver, isUsingBoundaryParticles);
+        EXPECT_LT(peak, 1.03 * pciSphPeak)
+            << "with boundary particles: " << isUsingBoundaryParticles;
+        EXPECT_LE(solver.lastPeakDensityErrorRatio(),
+                  solver.maxPeakDensityErrorRatio());
+    }
+}
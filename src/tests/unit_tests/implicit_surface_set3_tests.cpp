@@ -1,9 +1,16 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array1.h>
 #include <jet/box3.h>
+#include <jet/cylinder3.h>
 #include <jet/implicit_surface_set3.h>
+#include <jet/plane3.h>
+#include <jet/sphere3.h>
 #include <jet/surface_to_implicit3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace jet;
 
@@ -195,3 +202,118 @@ TEST(ImplicitSurfaceSet3, ClosestNormal) {
     EXPECT_DOUBLE_EQ(boxNormal.y, setNormal.y);
     EXPECT_DOUBLE_EQ(boxNormal.z, setNormal.z);
 }
+
+TEST(ImplicitSurfaceSet3, ManySurfaces) {
+    ImplicitSurfaceSet3 sset;
+    std::vector<ImplicitSurface3Ptr> surfaces;
+
+    // Container box with flipped normals, a floor, and a grid of spheres
+    auto container = std::make_shared<Box3>(
+        BoundingBox3D(Vector3D(-10, -10, -10), Vector3D(10, 10, 10)));
+    container->isNormalFlipped = true;
+    surfaces.push_back(std::make_shared<SurfaceToImplicit3>(container));
+    surfaces.push_back(std::make_shared<SurfaceToImplicit3>(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, -8, 0))));
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            surfaces.push_back(std::make_shared<SurfaceToImplicit3>(
+                std::make_shared<Sphere3>(
+                    Vector3D(3.0 * i - 7.5, 0.5 * j, 3.0 * j - 7.5),
+                    0.5 + 0.1 * i)));
+        }
+    }
+
+    for (const auto& surface : surfaces) {
+        sset.addSurface(surface);
+    }
+
+    for (int n = 0; n < 50; ++n) {
+        Vector3D pt(
+            std::sin(1.3 * n) * 11.0,
+            std::cos(0.7 * n) * 11.0,
+            std::sin(2.1 * n + 1.0) * 11.0);
+
+        double expectedDistance = kMaxD;
+        double expectedSdf = kMaxD;
+        size_t closest = 0;
+        for (size_t i = 0; i < surfaces.size(); ++i) {
+            double dist = surfaces[i]->closestDistance(pt);
+            if (dist < expectedDistance) {
+                expectedDistance = dist;
+                closest = i;
+            }
+            expectedSdf
+                = std::min(expectedSdf, surfaces[i]->signedDistance(pt));
+        }
+
+        EXPECT_DOUBLE_EQ(expectedDistance, sset.closestDistance(pt));
+        EXPECT_DOUBLE_EQ(expectedSdf, sset.signedDistance(pt));
+
+        Vector3D expectedPoint = surfaces[closest]->closestPoint(pt);
+        Vector3D actualPoint = sset.closestPoint(pt);
+        EXPECT_DOUBLE_EQ(expectedPoint.x, actualPoint.x);
+        EXPECT_DOUBLE_EQ(expectedPoint.y, actualPoint.y);
+        EXPECT_DOUBLE_EQ(expectedPoint.z, actualPoint.z);
+
+        Ray3D ray(pt, (Vector3D(0.1, 0.2, 0.3) - pt).normalized());
+        double expectedT = kMaxD;
+        for (const auto& surface : surfaces) {
+            SurfaceRayIntersection3 result
+                = surface->closestIntersection(ray);
+            if (result.isIntersecting) {
+                expectedT = std::min(expectedT, result.t);
+            }
+        }
+
+        SurfaceRayIntersection3 actual = sset.closestIntersection(ray);
+        EXPECT_EQ(expectedT < kMaxD, actual.isIntersecting);
+        if (actual.isIntersecting) {
+            EXPECT_DOUBLE_EQ(expectedT, actual.t);
+        }
+    }
+
+    // Moving a surface in place needs the BVH to be invalidated
+    auto sphere = std::make_shared<Sphere3>(Vector3D(), 0.5);
+    sset.addExplicitSurface(sphere);
+    EXPECT_NEAR(-0.5, sset.signedDistance(Vector3D()), 1e-12);
+
+    sphere->center = Vector3D(0, 0, 5);
+    sset.invalidateBvh();
+    EXPECT_NEAR(-0.5, sset.signedDistance(Vector3D(0, 0, 5)), 1e-12);
+}
+
+TEST(ImplicitSurfaceSet3, BatchSignedDistance) {
+    ImplicitSurfaceSet3 sset;
+
+    // Container box with flipped normals, a floor, and rows of the analytic
+    // primitives
+    auto container = std::make_shared<Box3>(
+        BoundingBox3D(Vector3D(-10, -10, -10), Vector3D(10, 10, 10)));
+    container->isNormalFlipped = true;
+    sset.addExplicitSurface(container);
+    sset.addExplicitSurface(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, -8, 0)));
+    for (int i = 0; i < 6; ++i) {
+        sset.addExplicitSurface(std::make_shared<Sphere3>(
+            Vector3D(3.0 * i - 7.5, 0.5 * i, -4.0), 0.5 + 0.1 * i));
+        sset.addExplicitSurface(std::make_shared<Cylinder3>(
+            Vector3D(3.0 * i - 7.5, -2.0, 0.0), 0.8, 1.0 + 0.2 * i));
+        sset.addExplicitSurface(std::make_shared<Box3>(
+            Vector3D(3.0 * i - 8.0, 1.0, 3.0),
+            Vector3D(3.0 * i - 7.0, 2.0 + 0.3 * i, 4.5)));
+    }
+
+    Array1<Vector3D> points;
+    for (int n = 0; n < 3000; ++n) {
+        points.append(Vector3D(
+            std::sin(1.3 * n) * 11.0,
+            std::cos(0.7 * n) * 11.0,
+            std::sin(2.1 * n + 1.0) * 11.0));
+    }
+
+    Array1<double> distances(points.size());
+    sset.batchSignedDistance(points.constAccessor(), distances.accessor());
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_NEAR(sset.signedDistance(points[i]), distances[i], 1e-12);
+    }
+}
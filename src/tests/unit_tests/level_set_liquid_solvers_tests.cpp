@@ -65,3 +65,28 @@ TEST(LevelSetLiquidSolver3, ComputeVolume) {
 
     EXPECT_NEAR(ans, volume, 0.001);
 }
+
+TEST(LevelSetLiquidSolver3, GlobalCompensation) {
+    LevelSetLiquidSolver3 solver;
+    solver.setIsGlobalCompensationEnabled(true);
+
+    auto data = solver.gridSystemData();
+    double dx = 1.0 / 32.0;
+    data->resize(Size3(32, 32, 32), Vector3D(dx, dx, dx), Vector3D());
+
+    // A falling sphere of liquid
+    auto sdf = solver.signedDistanceField();
+    sdf->fill([&](const Vector3D& x) {
+        return x.distanceTo(Vector3D(0.5, 0.6, 0.5)) - 0.2;
+    });
+
+    const double volume0 = solver.computeVolume();
+
+    Frame frame(0, 1.0 / 60.0);
+    for ( ; frame.index < 3; frame.advance()) {
+        solver.update(frame);
+
+        // The volume is restored at the end of each step
+        EXPECT_NEAR(volume0, solver.computeVolume(), 1e-3 * volume0);
+    }
+}
@@ -3,11 +3,15 @@
 #include <jet/array_utils.h>
 #include <jet/cell_centered_scalar_grid2.h>
 #include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
 #include <jet/eno_level_set_solver2.h>
 #include <jet/eno_level_set_solver3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/fast_sweeping_level_set_solver3.h>
 #include <jet/fdm_utils.h>
 #include <jet/fmm_level_set_solver2.h>
 #include <jet/fmm_level_set_solver3.h>
+#include <jet/pde.h>
 #include <jet/upwind_level_set_solver2.h>
 #include <jet/upwind_level_set_solver3.h>
 #include <gtest/gtest.h>
@@ -110,6 +114,33 @@ TEST(EnoLevelSetSolver2, Reinitialize) {
     }
 }
 
+TEST(EnoLevelSetSolver2, ReinitializeNarrowBand) {
+    CellCenteredScalarGrid2 sdf(40, 30), temp0(40, 30), temp1(40, 30);
+
+    // Distorted SDF whose gradient is not unit-length
+    sdf.fill([](const Vector2D& x) {
+        return 1.5 * ((x - Vector2D(20, 20)).length() - 8.0);
+    });
+
+    EnoLevelSetSolver2 solver;
+    solver.reinitialize(sdf, 5.0, &temp0);
+
+    EXPECT_FALSE(solver.isUsingNarrowBand());
+    solver.setIsUsingNarrowBand(true);
+    EXPECT_TRUE(solver.isUsingNarrowBand());
+    solver.reinitialize(sdf, 5.0, &temp1);
+
+    // Same near the interface, and clamped outside of the band
+    for (size_t j = 0; j < 30; ++j) {
+        for (size_t i = 0; i < 40; ++i) {
+            if (std::fabs(temp0(i, j)) < 3.0) {
+                EXPECT_NEAR(temp0(i, j), temp1(i, j), 0.1) << i << ", " << j;
+            }
+            EXPECT_GE(5.0, std::fabs(temp1(i, j)));
+        }
+    }
+}
+
 TEST(EnoLevelSetSolver2, Extrapolate) {
     CellCenteredScalarGrid2 sdf(40, 30), temp(40, 30);
     CellCenteredScalarGrid2 field(40, 30);
@@ -149,6 +180,143 @@ TEST(EnoLevelSetSolver3, Reinitialize) {
     }
 }
 
+TEST(EnoLevelSetSolver3, ReinitializeNarrowBand) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp0(40, 30, 50);
+    CellCenteredScalarGrid3 temp1(40, 30, 50);
+
+    // Distorted SDF whose gradient is not unit-length
+    sdf.fill([](const Vector3D& x) {
+        return 1.5 * ((x - Vector3D(20, 20, 20)).length() - 8.0);
+    });
+
+    EnoLevelSetSolver3 solver;
+    solver.reinitialize(sdf, 5.0, &temp0);
+
+    EXPECT_FALSE(solver.isUsingNarrowBand());
+    solver.setIsUsingNarrowBand(true);
+    EXPECT_TRUE(solver.isUsingNarrowBand());
+    solver.reinitialize(sdf, 5.0, &temp1);
+
+    // Same near the interface, and clamped outside of the band
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                if (std::fabs(temp0(i, j, k)) < 3.0) {
+                    EXPECT_NEAR(temp0(i, j, k), temp1(i, j, k), 0.1)
+                        << i << ", " << j << ", " << k;
+                }
+                EXPECT_GE(5.0, std::fabs(temp1(i, j, k)));
+            }
+        }
+    }
+}
+
+namespace {
+
+// ENO solver that computes the derivatives one point at a time
+class PointwiseEnoLevelSetSolver3 final : public IterativeLevelSetSolver3 {
+ public:
+    PointwiseEnoLevelSetSolver3() {
+        setMaxCfl(0.25);
+    }
+
+ protected:
+    void getDerivatives(
+        ConstArrayAccessor3<double> grid,
+        const Vector3D& gridSpacing,
+        size_t i,
+        size_t j,
+        size_t k,
+        std::array<double, 2>* dx,
+        std::array<double, 2>* dy,
+        std::array<double, 2>* dz) const override {
+        const Size3 size = grid.size();
+        auto at = [](size_t c, int d, size_t n) {
+            int ic = static_cast<int>(c) + d;
+            return static_cast<size_t>(
+                clamp(ic, 0, static_cast<int>(n) - 1));
+        };
+
+        double D0[7];
+        for (int d = -3; d <= 3; ++d) {
+            D0[d + 3] = grid(at(i, d, size.x), j, k);
+        }
+        *dx = eno3(D0, gridSpacing.x);
+        for (int d = -3; d <= 3; ++d) {
+            D0[d + 3] = grid(i, at(j, d, size.y), k);
+        }
+        *dy = eno3(D0, gridSpacing.y);
+        for (int d = -3; d <= 3; ++d) {
+            D0[d + 3] = grid(i, j, at(k, d, size.z));
+        }
+        *dz = eno3(D0, gridSpacing.z);
+    }
+};
+
+}  // namespace
+
+TEST(EnoLevelSetSolver3, ReinitializeAlongLines) {
+    CellCenteredScalarGrid3 sdf(23, 17, 11), temp0(23, 17, 11);
+    CellCenteredScalarGrid3 temp1(23, 17, 11);
+
+    sdf.fill([](const Vector3D& x) {
+        return 1.5 * ((x - Vector3D(10, 8, 6)).length() - 4.0);
+    });
+
+    for (bool isUsingNarrowBand : { false, true }) {
+        EnoLevelSetSolver3 solver0;
+        solver0.setIsUsingNarrowBand(isUsingNarrowBand);
+        solver0.setReinitializationTolerance(0.0);
+        solver0.reinitialize(sdf, 3.0, &temp0);
+
+        PointwiseEnoLevelSetSolver3 solver1;
+        solver1.setIsUsingNarrowBand(isUsingNarrowBand);
+        solver1.setReinitializationTolerance(0.0);
+        solver1.reinitialize(sdf, 3.0, &temp1);
+
+        for (size_t k = 0; k < 11; ++k) {
+            for (size_t j = 0; j < 17; ++j) {
+                for (size_t i = 0; i < 23; ++i) {
+                    EXPECT_DOUBLE_EQ(temp1(i, j, k), temp0(i, j, k))
+                        << i << ", " << j << ", " << k;
+                }
+            }
+        }
+    }
+}
+
+TEST(EnoLevelSetSolver3, ReinitializationTolerance) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp0(40, 30, 50);
+    CellCenteredScalarGrid3 temp1(40, 30, 50);
+
+    EnoLevelSetSolver3 solver;
+    EXPECT_DOUBLE_EQ(1e-4, solver.reinitializationTolerance());
+    solver.setReinitializationTolerance(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, solver.reinitializationTolerance());
+
+    sdf.fill([](const Vector3D& x) {
+        return 1.5 * ((x - Vector3D(20, 20, 20)).length() - 8.0);
+    });
+
+    solver.setIsUsingNarrowBand(true);
+    solver.reinitialize(sdf, 5.0, &temp0);
+
+    // Stops after the first step, which changes every cell of the band
+    solver.setReinitializationTolerance(1e10);
+    solver.reinitialize(sdf, 5.0, &temp1);
+
+    double maxDiff = 0.0;
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                maxDiff = std::max(
+                    maxDiff, std::fabs(temp0(i, j, k) - temp1(i, j, k)));
+            }
+        }
+    }
+    EXPECT_LT(0.1, maxDiff);
+}
+
 TEST(EnoLevelSetSolver3, Extrapolate) {
     CellCenteredScalarGrid3 sdf(40, 30, 50), temp(40, 30, 50);
     CellCenteredScalarGrid3 field(40, 30, 50);
@@ -171,6 +339,38 @@ TEST(EnoLevelSetSolver3, Extrapolate) {
     }
 }
 
+TEST(EnoLevelSetSolver3, ExtrapolateNarrowBand) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp0(40, 30, 50);
+    CellCenteredScalarGrid3 temp1(40, 30, 50), field(40, 30, 50);
+
+    sdf.fill([](const Vector3D& x) {
+        return (x - Vector3D(20, 20, 20)).length() - 8.0;
+    });
+    field.fill([](const Vector3D& x) {
+        return ((x - Vector3D(20, 20, 20)).length() < 8.0) ? 5.0 : 0.0;
+    });
+
+    EnoLevelSetSolver3 solver;
+    solver.extrapolate(field, sdf, 5.0, &temp0);
+
+    solver.setIsUsingNarrowBand(true);
+    solver.extrapolate(field, sdf, 5.0, &temp1);
+
+    // Same within the band, and untouched outside of it
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                if (sdf(i, j, k) < 3.0) {
+                    EXPECT_NEAR(temp0(i, j, k), temp1(i, j, k), 1e-2)
+                        << i << ", " << j << ", " << k;
+                } else if (sdf(i, j, k) >= 5.0) {
+                    EXPECT_DOUBLE_EQ(field(i, j, k), temp1(i, j, k))
+                        << i << ", " << j << ", " << k;
+                }
+            }
+        }
+    }
+}
 
 TEST(FmmLevelSetSolver2, Reinitialize) {
     CellCenteredScalarGrid2 sdf(40, 30), temp(40, 30);
@@ -228,6 +428,37 @@ TEST(FmmLevelSetSolver3, Reinitialize) {
     }
 }
 
+TEST(FmmLevelSetSolver3, ReinitializeNarrowBand) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp0(40, 30, 50);
+    CellCenteredScalarGrid3 temp1(40, 30, 50);
+
+    // Distorted SDF whose gradient is not unit-length
+    sdf.fill([](const Vector3D& x) {
+        return 1.5 * ((x - Vector3D(20, 20, 20)).length() - 8.0);
+    });
+
+    FmmLevelSetSolver3 solver;
+    solver.reinitialize(sdf, 5.0, &temp0);
+
+    EXPECT_FALSE(solver.isUsingNarrowBand());
+    solver.setIsUsingNarrowBand(true);
+    EXPECT_TRUE(solver.isUsingNarrowBand());
+    solver.reinitialize(sdf, 5.0, &temp1);
+
+    // Same near the interface, and clamped outside of the band
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                if (std::fabs(temp0(i, j, k)) < 3.0) {
+                    EXPECT_NEAR(temp0(i, j, k), temp1(i, j, k), 1e-12)
+                        << i << ", " << j << ", " << k;
+                }
+                EXPECT_GE(5.0, std::fabs(temp1(i, j, k)));
+            }
+        }
+    }
+}
+
 TEST(FmmLevelSetSolver3, Extrapolate) {
     CellCenteredScalarGrid3 sdf(40, 30, 50), temp(40, 30, 50);
     CellCenteredScalarGrid3 field(40, 30, 50);
@@ -249,3 +480,181 @@ TEST(FmmLevelSetSolver3, Extrapolate) {
         }
     }
 }
+
+TEST(FmmLevelSetSolver3, ExtrapolateVector) {
+    CellCenteredScalarGrid3 sdf(20, 15, 25);
+    sdf.fill([](const Vector3D& x) {
+        return (x - Vector3D(10, 10, 10)).length() - 4.0;
+    });
+    auto field = [](const Vector3D& x) {
+        return Vector3D(x.x, 2.0 * x.y - x.z, std::sin(x.z));
+    };
+
+    CellCenteredVectorGrid3 vector(20, 15, 25), vectorOut(20, 15, 25);
+    FaceCenteredGrid3 face(20, 15, 25), faceOut(20, 15, 25);
+    vector.fill(field);
+    face.fill(field);
+
+    FmmLevelSetSolver3 solver;
+    solver.extrapolate(vector, sdf, 3.0, &vectorOut);
+    solver.extrapolate(face, sdf, 3.0, &faceOut);
+
+    // Each component is the same as its own scalar extrapolation
+    CellCenteredScalarGrid3 component(20, 15, 25), componentOut(20, 15, 25);
+    for (int c = 0; c < 3; ++c) {
+        component.fill([&](const Vector3D& x) {
+            return field(x)[c];
+        });
+        solver.extrapolate(component, sdf, 3.0, &componentOut);
+        componentOut.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_DOUBLE_EQ(componentOut(i, j, k), vectorOut(i, j, k)[c])
+                << i << ", " << j << ", " << k;
+        });
+    }
+
+    // The faces outside of the SDF, which start from zero, are extrapolated
+    // from the inside
+    auto uPos = faceOut.uPosition();
+    faceOut.forEachUIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = uPos(i, j, k);
+        double phi = sdf.sample(pt);
+        if (phi < 0.0) {
+            EXPECT_DOUBLE_EQ(field(pt).x, faceOut.u(i, j, k));
+        } else if (phi < 2.0) {
+            // Close to the value at the nearest interface point
+            EXPECT_NEAR(pt.x, faceOut.u(i, j, k), phi + 1.0);
+        }
+    });
+}
+
+TEST(FmmLevelSetSolver3, BucketedQueue) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp0(40, 30, 50);
+    CellCenteredScalarGrid3 temp1(40, 30, 50);
+
+    // Distorted SDF whose gradient is not unit-length
+    sdf.fill([](const Vector3D& x) {
+        return 1.5 * ((x - Vector3D(20, 20, 20)).length() - 8.0);
+    });
+
+    FmmLevelSetSolver3 solver;
+    solver.reinitialize(sdf, 5.0, &temp0);
+
+    EXPECT_FALSE(solver.isUsingBucketedQueue());
+    EXPECT_EQ(0.1, solver.bucketWidth());
+    solver.setIsUsingBucketedQueue(true);
+    EXPECT_TRUE(solver.isUsingBucketedQueue());
+    EXPECT_THROW(solver.setBucketWidth(0.0), std::invalid_argument);
+
+    // Within about a bucket width of the heap inside of the marched band,
+    // also with a window of keys smaller than the band
+    const double widths[2] = { 0.1, 0.01 };
+    for (double width : widths) {
+        solver.setBucketWidth(width);
+        solver.reinitialize(sdf, 5.0, &temp1);
+        temp0.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            if (std::fabs(temp0(i, j, k)) < 4.0) {
+                EXPECT_NEAR(temp0(i, j, k), temp1(i, j, k), 2.0 * width)
+                    << i << ", " << j << ", " << k;
+            }
+        });
+    }
+
+    // Constant fields are extrapolated exactly
+    CellCenteredScalarGrid3 field(40, 30, 50);
+    field.fill(5.0);
+    solver.extrapolate(field, sdf, 5.0, &temp1);
+    temp1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(5.0, temp1(i, j, k)) << i << ", " << j << ", " << k;
+    });
+
+    FaceCenteredGrid3 face(40, 30, 50), faceOut(40, 30, 50);
+    face.fill(Vector3D(1.0, 2.0, 3.0));
+    solver.extrapolate(face, sdf, 5.0, &faceOut);
+    faceOut.forEachWIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(3.0, faceOut.w(i, j, k));
+    });
+}
+
+TEST(FastSweepingLevelSetSolver3, Reinitialize) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp0(40, 30, 50);
+    CellCenteredScalarGrid3 temp1(40, 30, 50);
+
+    // Distorted SDF whose gradient is not unit-length
+    sdf.fill([](const Vector3D& x) {
+        return 1.5 * ((x - Vector3D(20, 20, 20)).length() - 8.0);
+    });
+
+    FmmLevelSetSolver3 fmmSolver;
+    fmmSolver.reinitialize(sdf, 5.0, &temp0);
+
+    FastSweepingLevelSetSolver3 solver;
+    solver.reinitialize(sdf, 5.0, &temp1);
+
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                double answer = sdf(i, j, k) / 1.5;
+                if (std::fabs(answer) < 5.0) {
+                    EXPECT_NEAR(answer, temp1(i, j, k), 0.5)
+                        << i << ", " << j << ", " << k;
+                }
+                if (std::fabs(answer) < 4.0) {
+                    EXPECT_NEAR(temp0(i, j, k), temp1(i, j, k), 0.5)
+                        << i << ", " << j << ", " << k;
+                }
+            }
+        }
+    }
+
+    // Reuse the solver and solve in place
+    solver.reinitialize(sdf, 5.0, &sdf);
+
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                EXPECT_DOUBLE_EQ(temp1(i, j, k), sdf(i, j, k))
+                    << i << ", " << j << ", " << k;
+            }
+        }
+    }
+}
+
+TEST(FastSweepingLevelSetSolver3, Extrapolate) {
+    CellCenteredScalarGrid3 sdf(40, 30, 50), temp(40, 30, 50);
+    CellCenteredScalarGrid3 field(40, 30, 50);
+
+    sdf.fill([](const Vector3D& x) {
+        return (x - Vector3D(20, 20, 20)).length() - 8.0;
+    });
+    field.fill(5.0);
+
+    FastSweepingLevelSetSolver3 solver;
+    solver.extrapolate(field, sdf, 5.0, &temp);
+
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                EXPECT_DOUBLE_EQ(5.0, temp(i, j, k))
+                    << i << ", " << j << ", " << k;
+            }
+        }
+    }
+
+    // Values are carried along the normal direction
+    field.fill([](const Vector3D& x) {
+        return (x.x < 20.0) ? 1.0 : 2.0;
+    });
+    solver.extrapolate(field, sdf, 5.0, &temp);
+
+    for (size_t k = 0; k < 50; ++k) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t i = 0; i < 40; ++i) {
+                if (sdf(i, j, k) > 0.0 && sdf(i, j, k) < 5.0
+                    && std::fabs(sdf.dataPosition()(i, j, k).x - 20.0) > 5.0) {
+                    EXPECT_DOUBLE_EQ(i < 20 ? 1.0 : 2.0, temp(i, j, k))
+                        << i << ", " << j << ", " << k;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/logging.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Redirects all the logs to a string stream and restores the streams when
+// it goes out of scope
+struct LogCapture {
+    std::stringstream strm;
+    std::ostream* infoStream = Logging::stream(LoggingLevel::Info);
+    std::ostream* warnStream = Logging::stream(LoggingLevel::Warn);
+    std::ostream* errorStream = Logging::stream(LoggingLevel::Error);
+    std::ostream* debugStream = Logging::stream(LoggingLevel::Debug);
+
+    LogCapture() {
+        Logging::setAllStream(&strm);
+    }
+
+    ~LogCapture() {
+        Logging::setInfoStream(infoStream);
+        Logging::setWarnStream(warnStream);
+        Logging::setErrorStream(errorStream);
+        Logging::setDebugStream(debugStream);
+    }
+
+    std::vector<std::string> lines() {
+        Logging::flush();
+        std::vector<std::string> result;
+        std::string line;
+        std::stringstream copy(strm.str());
+        while (std::getline(copy, line)) {
+            result.push_back(line);
+        }
+        return result;
+    }
+};
+
+}  // namespace
+
+TEST(Logging, Header) {
+    std::string header = Logging::getHeader(LoggingLevel::Warn);
+    EXPECT_EQ(0u, header.find("[WARN] "));
+
+    // "[WARN] YYYY-MM-DD HH:MM:SS "
+    EXPECT_EQ(27u, header.size());
+}
+
+TEST(Logging, MultiThreaded) {
+    LogCapture capture;
+    EXPECT_TRUE(Logging::isAsynchronous());
+
+    const size_t numberOfThreads = 4;
+    const size_t numberOfMessages = 1000;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numberOfThreads; ++t) {
+        threads.push_back(std::thread([t] {
+            for (size_t i = 0; i < numberOfMessages; ++i) {
+                JET_INFO << "thread " << t << " message " << i << " end";
+            }
+        }));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every message should be written in a line of its own, in order within
+    // each thread
+    std::vector<std::string> lines = capture.lines();
+    ASSERT_EQ(numberOfThreads * numberOfMessages, lines.size());
+
+    std::vector<size_t> nextMessage(numberOfThreads, 0);
+    for (const std::string& line : lines) {
+        size_t pos = line.find("thread ");
+        ASSERT_NE(std::string::npos, pos);
+
+        std::stringstream fields(line.substr(pos));
+        std::string threadStr, messageStr, endStr;
+        size_t t, i;
+        fields >> threadStr >> t >> messageStr >> i >> endStr;
+        ASSERT_LT(t, numberOfThreads);
+        EXPECT_EQ(nextMessage[t], i);
+        EXPECT_EQ("end", endStr);
+        nextMessage[t] = i + 1;
+    }
+}
+
+TEST(Logging, Synchronous) {
+    LogCapture capture;
+    Logging::setIsAsynchronous(false);
+    JET_WARN << "written right away";
+    EXPECT_NE(std::string::npos, capture.strm.str().find("written right"));
+    Logging::setIsAsynchronous(true);
+
+    // Errors are written right away even in the asynchronous mode
+    JET_ERROR << "error";
+    EXPECT_NE(std::string::npos, capture.strm.str().find("[ERROR]"));
+}
+
+TEST(Logging, EveryN) {
+    LogCapture capture;
+    for (int i = 0; i < 10; ++i) {
+        JET_LOG_EVERY_N(JET_INFO, 4) << "every fourth " << i;
+    }
+
+    std::vector<std::string> lines = capture.lines();
+    ASSERT_EQ(3u, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("every fourth 0"));
+    EXPECT_NE(std::string::npos, lines[1].find("every fourth 4"));
+    EXPECT_NE(std::string::npos, lines[2].find("every fourth 8"));
+}
+
+TEST(Logging, EverySeconds) {
+    LogCapture capture;
+    for (int i = 0; i < 10; ++i) {
+        JET_LOG_EVERY_SECONDS(JET_INFO, 1000.0) << "once " << i;
+    }
+
+    std::vector<std::string> lines = capture.lines();
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("once 0"));
+
+    LogRateLimiter limiter;
+    EXPECT_TRUE(limiter.shouldLogEverySeconds(0.0));
+    EXPECT_TRUE(limiter.shouldLogEverySeconds(0.0));
+    EXPECT_TRUE(limiter.shouldLogEveryN(0));
+    EXPECT_TRUE(limiter.shouldLogEveryN(1));
+}
@@ -0,0 +1,196 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array3.h>
+#include <jet/marching_cubes.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Triangles as their corner positions, rotated to start from the smallest
+// corner and sorted, to compare meshes regardless of the vertex order
+std::vector<std::vector<double>> canonicalTriangles(const TriangleMesh3& mesh) {
+    std::vector<std::vector<double>> triangles;
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        Point3UI tri = mesh.pointIndex(t);
+        std::vector<std::vector<double>> corners;
+        for (size_t v = 0; v < 3; ++v) {
+            const Vector3D& p = mesh.point(tri[v]);
+            corners.push_back({ p.x, p.y, p.z });
+        }
+        std::rotate(
+            corners.begin(),
+            std::min_element(corners.begin(), corners.end()),
+            corners.end());
+
+        std::vector<double> triangle;
+        for (const auto& corner : corners) {
+            triangle.insert(triangle.end(), corner.begin(), corner.end());
+        }
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+}  // namespace
+
+TEST(MarchingCubes, Sphere) {
+    // Deep enough along z to span several slabs
+    const size_t n = 30;
+    const Vector3D h(1.0 / n, 1.0 / n, 1.0 / n);
+    const Vector3D center(0.5, 0.5, 0.5);
+    Array3<double> grid(n + 1, n + 1, n + 1);
+    grid.forEachIndex([&](size_t i, size_t j, size_t k) {
+        grid(i, j, k) = (h * Vector3D({i, j, k}) - center).length() - 0.4;
+    });
+
+    TriangleMesh3 mesh;
+    mesh.addPoint(Vector3D());
+    mesh.addNormal(Vector3D());
+    mesh.addUv(Vector2D());
+
+    marchingCubes(grid.constAccessor(), h, Vector3D(), &mesh);
+
+    EXPECT_LT(0u, mesh.numberOfTriangles());
+    EXPECT_EQ(mesh.numberOfPoints(), mesh.numberOfNormals());
+    EXPECT_EQ(mesh.numberOfPoints(), mesh.numberOfUvs());
+
+    for (size_t i = 1; i < mesh.numberOfPoints(); ++i) {
+        EXPECT_NEAR(0.4, (mesh.point(i) - center).length(), 0.01);
+        EXPECT_NEAR(
+            1.0, mesh.normal(i).dot((mesh.point(i) - center).normalized()),
+            0.01);
+    }
+
+    // Every vertex is welded, so the surface is closed with each edge shared
+    // by exactly two triangles. The existing point is never referenced.
+    std::map<std::pair<size_t, size_t>, int> edgeCount;
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        Point3UI tri = mesh.pointIndex(t);
+        for (size_t v = 0; v < 3; ++v) {
+            size_t a = tri[v];
+            size_t b = tri[(v + 1) % 3];
+            EXPECT_LT(0u, a);
+            ++edgeCount[std::make_pair(std::min(a, b), std::max(a, b))];
+        }
+    }
+    for (const auto& e : edgeCount) {
+        EXPECT_EQ(2, e.second);
+    }
+}
+
+TEST(MarchingCubes, Boundaries) {
+    // A half space cut by the domain boundary
+    Array3<double> grid(4, 5, 6);
+    grid.forEachIndex([&](size_t i, size_t j, size_t k) {
+        grid(i, j, k) = static_cast<double>(i) - 1.5;
+    });
+
+    TriangleMesh3 interior;
+    marchingCubes(
+        grid.constAccessor(), Vector3D(1, 1, 1), Vector3D(), &interior, 0.0,
+        kMarchingCubesBoundaryFlagNone);
+
+    // 5 x 6 welded crossings on the x = 1.5 plane, two triangles per cell
+    EXPECT_EQ(30u, interior.numberOfPoints());
+    EXPECT_EQ(2u * 4u * 5u, interior.numberOfTriangles());
+    for (size_t i = 0; i < interior.numberOfPoints(); ++i) {
+        EXPECT_DOUBLE_EQ(1.5, interior.point(i).x);
+        EXPECT_DOUBLE_EQ(1.0, interior.normal(i).x);
+    }
+
+    TriangleMesh3 closed;
+    marchingCubes(
+        grid.constAccessor(), Vector3D(1, 1, 1), Vector3D(), &closed);
+    EXPECT_LT(interior.numberOfTriangles(), closed.numberOfTriangles());
+    EXPECT_NEAR(
+        2.0 * (4.0 * 5.0 + 1.5 * 5.0 + 1.5 * 4.0), closed.area(), 1e-9);
+}
+
+TEST(MarchingCubes, Streaming) {
+    // Deep enough along z to span several streamed chunks
+    const size_t n = 20;
+    Array3<double> grid(n, n, 8 * n);
+    grid.forEachIndex([&](size_t i, size_t j, size_t k) {
+        grid(i, j, k)
+            = std::sin(0.5 * i) + std::cos(0.3 * j) + std::sin(0.2 * k);
+    });
+
+    TriangleMesh3 mesh;
+    marchingCubes(grid.constAccessor(), Vector3D(1, 1, 1), Vector3D(), &mesh);
+
+    std::stringstream strm;
+    TriangleMeshStreamWriter3 writer(&strm);
+    marchingCubes(
+        grid.constAccessor(), Vector3D(1, 1, 1), Vector3D(), &writer);
+    EXPECT_EQ(mesh.numberOfPoints(), writer.numberOfPoints());
+    EXPECT_EQ(mesh.numberOfTriangles(), writer.numberOfTriangles());
+
+    TriangleMesh3 streamed;
+    EXPECT_TRUE(streamed.readBinary(&strm));
+    ASSERT_EQ(mesh.numberOfPoints(), streamed.numberOfPoints());
+    ASSERT_EQ(mesh.numberOfTriangles(), streamed.numberOfTriangles());
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        EXPECT_EQ(mesh.point(i), streamed.point(i));
+        EXPECT_EQ(mesh.normal(i), streamed.normal(i));
+    }
+    for (size_t i = 0; i < mesh.numberOfTriangles(); ++i) {
+        EXPECT_EQ(mesh.pointIndex(i), streamed.pointIndex(i));
+        EXPECT_EQ(mesh.normalIndex(i), streamed.normalIndex(i));
+        EXPECT_EQ(mesh.uvIndex(i), streamed.uvIndex(i));
+    }
+}
+
+TEST(MarchingCubesTileCache3, Update) {
+    const size_t n = 30;
+    const Vector3D h(1.0 / n, 1.0 / n, 1.0 / n);
+    const Vector3D center(0.5, 0.5, 0.5);
+    Array3<double> grid(n + 1, n + 1, n + 1);
+    grid.forEachIndex([&](size_t i, size_t j, size_t k) {
+        grid(i, j, k) = (h * Vector3D({i, j, k}) - center).length() - 0.4;
+    });
+
+    MarchingCubesTileCache3 cache(8);
+    auto check = [&]() {
+        TriangleMesh3 expected;
+        marchingCubes(grid.constAccessor(), h, Vector3D(), &expected);
+
+        TriangleMesh3 actual;
+        cache.update(grid.constAccessor(), h, Vector3D(), &actual);
+
+        EXPECT_EQ(expected.numberOfPoints(), actual.numberOfPoints());
+        EXPECT_EQ(actual.numberOfPoints(), actual.numberOfNormals());
+        EXPECT_EQ(actual.numberOfPoints(), actual.numberOfUvs());
+        EXPECT_EQ(canonicalTriangles(expected), canonicalTriangles(actual));
+    };
+
+    check();
+    EXPECT_EQ(64u, cache.numberOfTiles());
+    EXPECT_EQ(64u, cache.numberOfRemeshedTiles());
+
+    check();
+    EXPECT_EQ(0u, cache.numberOfRemeshedTiles());
+
+    // A bump in the middle of a tile only touches that tile
+    grid(12, 12, 3) = -0.1;
+    check();
+    EXPECT_EQ(1u, cache.numberOfRemeshedTiles());
+
+    // The grid values next to a tile are used for its normals
+    grid(16, 12, 3) = -0.1;
+    check();
+    EXPECT_EQ(2u, cache.numberOfRemeshedTiles());
+
+    // A new iso-value invalidates everything
+    TriangleMesh3 mesh;
+    cache.update(grid.constAccessor(), h, Vector3D(), &mesh, 0.01);
+    EXPECT_EQ(64u, cache.numberOfRemeshedTiles());
+}
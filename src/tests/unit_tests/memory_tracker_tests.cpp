@@ -0,0 +1,148 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array1.h>
+#include <jet/array3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/grid_system_data3.h>
+#include <jet/memory_tracker.h>
+#include <jet/particle_system_data3.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace jet;
+
+TEST(MemoryTracker, Scope) {
+    EXPECT_EQ(MemoryTag::Other, MemoryTracker::currentTag());
+    {
+        MemoryTagScope gridScope(MemoryTag::Grid);
+        EXPECT_EQ(MemoryTag::Grid, MemoryTracker::currentTag());
+        {
+            MemoryTagScope solverScope(MemoryTag::LinearSolver);
+            EXPECT_EQ(MemoryTag::LinearSolver, MemoryTracker::currentTag());
+        }
+        EXPECT_EQ(MemoryTag::Grid, MemoryTracker::currentTag());
+    }
+    EXPECT_EQ(MemoryTag::Other, MemoryTracker::currentTag());
+}
+
+TEST(MemoryTracker, Arrays) {
+    size_t gridBytes = MemoryTracker::bytes(MemoryTag::Grid);
+    size_t totalBytes = MemoryTracker::totalBytes();
+    {
+        Array3<double> array;
+        {
+            MemoryTagScope scope(MemoryTag::Grid);
+            array.resize(10, 20, 30);
+        }
+        EXPECT_LE(
+            gridBytes + 6000 * sizeof(double),
+            MemoryTracker::bytes(MemoryTag::Grid));
+        EXPECT_LE(
+            gridBytes + 6000 * sizeof(double),
+            MemoryTracker::peakBytes(MemoryTag::Grid));
+        EXPECT_LE(
+            totalBytes + 6000 * sizeof(double), MemoryTracker::totalBytes());
+
+        // The memory is released with the tag it was allocated with
+        MemoryTagScope scope(MemoryTag::Particle);
+        Array3<double> other;
+        array.swap(other);
+    }
+    EXPECT_EQ(gridBytes, MemoryTracker::bytes(MemoryTag::Grid));
+    EXPECT_EQ(totalBytes, MemoryTracker::totalBytes());
+}
+
+TEST(MemoryTracker, OtherThread) {
+    size_t particleBytes = MemoryTracker::bytes(MemoryTag::Particle);
+
+    Array1<double>* array = nullptr;
+    std::thread thread([&] {
+        MemoryTagScope scope(MemoryTag::Particle);
+        array = new Array1<double>(1000);
+    });
+    thread.join();
+    EXPECT_LE(
+        particleBytes + 1000 * sizeof(double),
+        MemoryTracker::bytes(MemoryTag::Particle));
+
+    // The scope of the allocating thread does not leak into this thread
+    EXPECT_EQ(MemoryTag::Other, MemoryTracker::currentTag());
+    delete array;
+    EXPECT_EQ(particleBytes, MemoryTracker::bytes(MemoryTag::Particle));
+}
+
+TEST(MemoryTracker, PeakBytes) {
+    MemoryTracker::resetPeakBytes();
+    size_t peak = MemoryTracker::peakBytes(MemoryTag::LinearSolver);
+    EXPECT_EQ(MemoryTracker::bytes(MemoryTag::LinearSolver), peak);
+
+    {
+        MemoryTagScope scope(MemoryTag::LinearSolver);
+        Array1<double> temporary(1000);
+    }
+    EXPECT_LE(
+        peak + 1000 * sizeof(double),
+        MemoryTracker::peakBytes(MemoryTag::LinearSolver));
+    EXPECT_LE(
+        MemoryTracker::peakBytes(MemoryTag::LinearSolver),
+        MemoryTracker::peakTotalBytes());
+
+    MemoryTracker::resetPeakBytes();
+    EXPECT_EQ(
+        MemoryTracker::bytes(MemoryTag::LinearSolver),
+        MemoryTracker::peakBytes(MemoryTag::LinearSolver));
+}
+
+TEST(MemoryTracker, SystemData) {
+    size_t gridBytes = MemoryTracker::bytes(MemoryTag::Grid);
+    size_t particleBytes = MemoryTracker::bytes(MemoryTag::Particle);
+    size_t neighborListBytes = MemoryTracker::bytes(MemoryTag::NeighborList);
+    size_t searchBytes = MemoryTracker::bytes(MemoryTag::NeighborSearch);
+
+    {
+        GridSystemData3 grids;
+        grids.resize(Size3(16, 16, 16), Vector3D(1, 1, 1), Vector3D());
+        grids.addScalarData(
+            CellCenteredScalarGrid3::builder(), 0.0);
+        EXPECT_LE(
+            gridBytes + 4096 * sizeof(double) * 4,
+            MemoryTracker::bytes(MemoryTag::Grid));
+
+        ParticleSystemData3 particles;
+        Array1<Vector3D> positions(1000);
+        positions.forEachIndex([&](size_t i) {
+            positions[i] = Vector3D(i % 10, (i / 10) % 10, i / 100) * 0.1;
+        });
+        particles.addParticles(positions);
+        EXPECT_LE(
+            particleBytes + 1000 * sizeof(Vector3D) * 3,
+            MemoryTracker::bytes(MemoryTag::Particle));
+
+        particles.buildNeighborSearcher(0.15);
+        particles.buildNeighborLists(0.15);
+        EXPECT_LT(searchBytes, MemoryTracker::bytes(MemoryTag::NeighborSearch));
+        EXPECT_LT(
+            neighborListBytes, MemoryTracker::bytes(MemoryTag::NeighborList));
+    }
+
+    EXPECT_EQ(gridBytes, MemoryTracker::bytes(MemoryTag::Grid));
+    EXPECT_EQ(particleBytes, MemoryTracker::bytes(MemoryTag::Particle));
+    EXPECT_EQ(
+        neighborListBytes, MemoryTracker::bytes(MemoryTag::NeighborList));
+    EXPECT_EQ(searchBytes, MemoryTracker::bytes(MemoryTag::NeighborSearch));
+}
+
+TEST(MemoryTracker, Report) {
+    std::stringstream strm;
+    MemoryTracker::printReport(&strm);
+
+    std::string report = strm.str();
+    for (size_t i = 0; i < kNumberOfMemoryTags; ++i) {
+        EXPECT_NE(
+            std::string::npos,
+            report.find(MemoryTracker::tagName(static_cast<MemoryTag>(i))));
+    }
+    EXPECT_NE(std::string::npos, report.find("total"));
+}
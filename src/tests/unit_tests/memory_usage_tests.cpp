@@ -0,0 +1,33 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/memory_usage.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace jet;
+
+TEST(MemoryUsage, PeakResidentSetSize) {
+    size_t before = peakResidentSetSizeInBytes();
+    EXPECT_LT(0u, before);
+
+    // Touch 64 MB so that it has to be resident
+    const size_t size = 64 * 1024 * 1024;
+    std::vector<char> buffer(size, 1);
+
+    size_t after = peakResidentSetSizeInBytes();
+    EXPECT_LE(before, after);
+    EXPECT_LE(size, after);
+    EXPECT_EQ(1, buffer[size / 2]);
+}
+
+TEST(MemoryUsage, ResidentSetSize) {
+    size_t before = residentSetSizeInBytes();
+    EXPECT_LT(0u, before);
+
+    const size_t size = 64 * 1024 * 1024;
+    std::vector<char> buffer(size, 1);
+
+    size_t after = residentSetSizeInBytes();
+    EXPECT_LE(before + size / 2, after);
+    EXPECT_EQ(1, buffer[size / 2]);
+}
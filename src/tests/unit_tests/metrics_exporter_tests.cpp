@@ -0,0 +1,128 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/metrics_exporter.h>
+#include <jet/profiler.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace jet;
+
+namespace {
+
+// Reports fixed statistics for each sub-step
+class FakeSolver final : public PhysicsAnimation {
+ protected:
+    void onAdvanceTimeStep(double) override {
+    }
+
+    void collectStatistics(SubTimeStepStatistics* stats) const override {
+        stats->numberOfPressureIterations = 3;
+        stats->numberOfParticles = 42;
+        stats->cfl = 0.5;
+    }
+};
+
+bool contains(const std::string& text, const std::string& line) {
+    return text.find(line) != std::string::npos;
+}
+
+std::string readFile(const std::string& filename) {
+    std::ifstream file(filename.c_str());
+    std::stringstream strm;
+    strm << file.rdbuf();
+    return strm.str();
+}
+
+}  // namespace
+
+TEST(MetricsExporter, Record) {
+    FakeSolver solver;
+    solver.setNumberOfFixedSubTimeSteps(2);
+
+    MetricsExporter exporter("shot_010");
+    EXPECT_EQ("shot_010", exporter.jobName());
+    EXPECT_TRUE(contains(
+        exporter.prometheusText(), "jet_frames_total{job=\"shot_010\"} 0\n"));
+
+    solver.setFrameCallback([&](const Frame&) { exporter.record(solver); });
+    solver.update(Frame(3, 1.0 / 60.0));
+
+    std::string text = exporter.prometheusText();
+    EXPECT_TRUE(contains(text, "# TYPE jet_frames_total counter\n"));
+    EXPECT_TRUE(contains(text, "jet_frame_index{job=\"shot_010\"} 3\n"));
+    EXPECT_TRUE(contains(text, "jet_frames_total{job=\"shot_010\"} 3\n"));
+    EXPECT_TRUE(contains(text, "jet_sub_time_steps{job=\"shot_010\"} 2\n"));
+    EXPECT_TRUE(
+        contains(text, "jet_pressure_iterations{job=\"shot_010\"} 6\n"));
+    EXPECT_TRUE(contains(text, "jet_particles{job=\"shot_010\"} 42\n"));
+    EXPECT_TRUE(contains(text, "jet_cfl{job=\"shot_010\"} 0.5\n"));
+    EXPECT_TRUE(contains(text, "jet_resident_set_size_bytes{job="));
+    EXPECT_FALSE(contains(text, "jet_stage_duration_seconds"));
+
+    std::string statsd = exporter.statsdText();
+    EXPECT_TRUE(contains(statsd, "shot_010.frame_index:3|g\n"));
+    EXPECT_TRUE(contains(statsd, "shot_010.particles:42|g\n"));
+}
+
+TEST(MetricsExporter, Stages) {
+    FakeSolver solver;
+    MetricsExporter exporter;
+    solver.setFrameCallback([&](const Frame&) { exporter.record(solver); });
+
+    Profiler::clear();
+    Profiler::setIsEnabled(true);
+    solver.update(Frame(1, 1.0 / 60.0));
+    Profiler::setIsEnabled(false);
+    Profiler::clear();
+
+    std::string text = exporter.prometheusText();
+    EXPECT_TRUE(contains(text, "# TYPE jet_stage_duration_seconds gauge\n"));
+    EXPECT_TRUE(contains(
+        text,
+        "jet_stage_duration_seconds{job=\"jet\","
+        "stage=\"advanceTimeStep/onAdvanceTimeStep\"} "));
+    EXPECT_TRUE(contains(
+        exporter.statsdText(),
+        "jet.stage_duration_seconds.advanceTimeStep.onAdvanceTimeStep:"));
+}
+
+TEST(MetricsExporter, Export) {
+    const std::string filename = "metrics_exporter_tests_export.prom";
+    std::remove(filename.c_str());
+
+    FakeSolver solver;
+    MetricsExporter exporter;
+    solver.setFrameCallback([&](const Frame&) { exporter.record(solver); });
+    solver.update(Frame(1, 1.0 / 60.0));
+
+    // Nothing is enabled
+    EXPECT_TRUE(exporter.exportNow());
+
+    exporter.setPrometheusFile(filename);
+    EXPECT_TRUE(exporter.exportNow());
+    EXPECT_TRUE(contains(readFile(filename), "jet_frame_index{job=\"jet\"} 1"));
+
+    exporter.setStatsdServer("127.0.0.1", 8125);
+    EXPECT_TRUE(exporter.exportNow());
+    exporter.setStatsdServer("");
+
+    // The background thread picks up the later frames
+    EXPECT_FALSE(exporter.isRunning());
+    exporter.start(0.01);
+    EXPECT_TRUE(exporter.isRunning());
+    solver.update(Frame(4, 1.0 / 60.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    exporter.stop();
+    EXPECT_FALSE(exporter.isRunning());
+    EXPECT_TRUE(contains(readFile(filename), "jet_frame_index{job=\"jet\"} 4"));
+
+    EXPECT_THROW(exporter.start(0.0), std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/paged_array3.h>
+#include <jet/vector3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(PagedArray3, Constructors) {
+    PagedArray3<double> arr0;
+    EXPECT_EQ(Size3(0, 0, 0), arr0.size());
+    EXPECT_EQ(0u, arr0.numberOfResidentBricks());
+
+    PagedArray3<double> arr1(Size3(10, 17, 3), 4.0, 5);
+    EXPECT_EQ(10u, arr1.width());
+    EXPECT_EQ(17u, arr1.height());
+    EXPECT_EQ(3u, arr1.depth());
+    EXPECT_EQ(5u, arr1.maxNumberOfResidentBricks());
+    EXPECT_EQ(0u, arr1.numberOfResidentBricks());
+
+    arr1.forEachIndex([&](size_t i, size_t j, size_t k, const double& v) {
+        EXPECT_DOUBLE_EQ(4.0, v);
+        EXPECT_DOUBLE_EQ(4.0, arr1(i, j, k));
+    });
+    EXPECT_EQ(0u, arr1.numberOfBrickReads());
+    EXPECT_EQ(0u, arr1.numberOfBrickWrites());
+}
+
+TEST(PagedArray3, SetAndCopyTo) {
+    Array3<double> dense(21, 18, 13);
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        dense(i, j, k) = static_cast<double>(i + 100 * j + 10000 * k);
+    });
+
+    // Keeps 4 of the 3 x 3 x 2 bricks, so most of them go to the file
+    PagedArray3<double> arr(Size3(), 0.0, 4);
+    arr.set(dense.constAccessor());
+    EXPECT_EQ(dense.size(), arr.size());
+    EXPECT_EQ(4u, arr.numberOfResidentBricks());
+    EXPECT_LE(14u, arr.numberOfBrickWrites());
+
+    Array3<double> result;
+    arr.copyTo(&result);
+    EXPECT_EQ(dense.size(), result.size());
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(dense(i, j, k), result(i, j, k));
+        EXPECT_EQ(dense(i, j, k), arr(i, j, k));
+    });
+    EXPECT_LE(14u, arr.numberOfBrickReads());
+    EXPECT_GE(4u + arr.numberOfBrickReads(), arr.numberOfBrickWrites());
+}
+
+TEST(PagedArray3, Update) {
+    PagedArray3<Vector3D> arr(Size3(30, 9, 17), Vector3D(1, 2, 3), 2);
+
+    arr.set(3, 4, 5, Vector3D(7, 8, 9));
+    EXPECT_EQ(Vector3D(7, 8, 9), arr(3, 4, 5));
+
+    arr.parallelUpdate([](size_t i, size_t j, size_t k, Vector3D& v) {
+        v += Vector3D(static_cast<double>(i), static_cast<double>(j), 0.0);
+        v.z *= static_cast<double>(k);
+    });
+
+    size_t count = 0;
+    arr.forEachIndex([&](size_t i, size_t j, size_t k, const Vector3D& v) {
+        Vector3D expected = (i == 3 && j == 4 && k == 5)
+            ? Vector3D(10, 12, 45)
+            : Vector3D(1.0 + i, 2.0 + j, 3.0 * k);
+        EXPECT_EQ(expected, v);
+        ++count;
+    });
+    EXPECT_EQ(30u * 9u * 17u, count);
+
+    arr.setMaxNumberOfResidentBricks(1);
+    EXPECT_EQ(1u, arr.numberOfResidentBricks());
+    EXPECT_EQ(Vector3D(10, 12, 45), arr(3, 4, 5));
+
+    arr.resize(Size3(4, 4, 4), Vector3D(-1, -1, -1));
+    EXPECT_EQ(Size3(4, 4, 4), arr.size());
+    EXPECT_EQ(1u, arr.maxNumberOfResidentBricks());
+    EXPECT_EQ(Vector3D(-1, -1, -1), arr(3, 3, 3));
+}
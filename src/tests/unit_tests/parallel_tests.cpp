@@ -8,7 +8,11 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
 using namespace jet;
@@ -127,3 +131,616 @@ TEST(Parallel, Sort) {
         EXPECT_LE(c[idx[i]], c[idx[i + 1]]);
     }
 }
+
+TEST(Parallel, SortLarge) {
+    // Large enough for the parallel merges, with many equal keys
+    size_t N = 100003;
+    std::vector<size_t> keys(N);
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<size_t> d(0, 1000);
+    for (size_t i = 0; i < N; ++i) {
+        keys[i] = d(rng);
+    }
+
+    std::vector<size_t> expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<size_t> expectedOrder(N);
+    for (size_t i = 0; i < N; ++i) {
+        expectedOrder[i] = i;
+    }
+    auto compare = [&keys](size_t a, size_t b) { return keys[a] < keys[b]; };
+    std::stable_sort(expectedOrder.begin(), expectedOrder.end(), compare);
+
+    unsigned int oldNumThreads = maxNumberOfThreads();
+    bool wasDeterministic = isDeterministic();
+
+    for (unsigned int numThreads : {1u, 3u, 8u}) {
+        setMaxNumberOfThreads(numThreads);
+
+        std::vector<size_t> a = keys;
+        setIsDeterministic(false);
+        parallelSort(a.begin(), a.end());
+        EXPECT_EQ(expected, a);
+
+        std::vector<size_t> order(N);
+        for (size_t i = 0; i < N; ++i) {
+            order[i] = i;
+        }
+        setIsDeterministic(true);
+        parallelSort(order.begin(), order.end(), compare);
+        EXPECT_EQ(expectedOrder, order);
+    }
+
+    setIsDeterministic(wasDeterministic);
+    setMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, NestedFor) {
+    size_t nX = std::max(20u, (3 * sNumCores) / 2);
+    size_t nY = std::max(30u, (3 * sNumCores) / 2);
+    Array2<double> a(nX, nY);
+
+    parallelFor(kZeroSize, nY, [&] (size_t j) {
+        parallelFor(kZeroSize, nX, [&] (size_t i) {
+            a(i, j) = static_cast<double>(i + j * nX);
+        });
+    });
+
+    for (size_t j = 0; j < nY; ++j) {
+        for (size_t i = 0; i < nX; ++i) {
+            EXPECT_DOUBLE_EQ(static_cast<double>(i + j * nX), a(i, j));
+        }
+    }
+}
+
+TEST(Parallel, Invoke) {
+    size_t n = std::max(20u, (3 * sNumCores) / 2);
+    std::vector<std::vector<size_t>> results(5);
+
+    std::vector<std::function<void()>> tasks;
+    for (size_t t = 0; t < results.size(); ++t) {
+        tasks.push_back([&, t] () {
+            results[t].resize(n * (t + 1));
+            parallelFor(kZeroSize, results[t].size(), [&] (size_t i) {
+                results[t][i] = i + t;
+            });
+        });
+    }
+    parallelInvoke(tasks);
+
+    for (size_t t = 0; t < results.size(); ++t) {
+        ASSERT_EQ(n * (t + 1), results[t].size());
+        for (size_t i = 0; i < results[t].size(); ++i) {
+            EXPECT_EQ(i + t, results[t][i]);
+        }
+    }
+
+    parallelInvoke(std::vector<std::function<void()>>());
+}
+
+TEST(Parallel, MaxNumberOfThreads) {
+    unsigned int oldNumThreads = maxNumberOfThreads();
+    EXPECT_LE(1u, oldNumThreads);
+
+    for (unsigned int numThreads : {1u, 3u, 8u}) {
+        setMaxNumberOfThreads(numThreads);
+        EXPECT_EQ(numThreads, maxNumberOfThreads());
+
+        std::vector<size_t> a(1000, 0);
+        parallelFor(kZeroSize, a.size(), [&a] (size_t i) {
+            a[i] = i;
+        });
+        for (size_t i = 0; i < a.size(); ++i) {
+            EXPECT_EQ(i, a[i]);
+        }
+
+        std::vector<int> b(1000);
+        for (size_t i = 0; i < b.size(); ++i) {
+            b[i] = static_cast<int>((i * 7919) % 1000);
+        }
+        parallelSort(b.begin(), b.end());
+        EXPECT_TRUE(std::is_sorted(b.begin(), b.end()));
+    }
+
+    setMaxNumberOfThreads(0);
+    EXPECT_EQ(1u, maxNumberOfThreads());
+
+    setMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, ForException) {
+    unsigned int oldNumThreads = maxNumberOfThreads();
+    setMaxNumberOfThreads(4);
+
+    // The exception of a task is rethrown once the others are done
+    std::vector<int> a(1000, 0);
+    EXPECT_THROW(
+        parallelFor(kZeroSize, a.size(), [&a] (size_t i) {
+            if (i % 300 == 7) {
+                throw std::runtime_error("task failed");
+            }
+            a[i] = 1;
+        }),
+        std::runtime_error);
+    EXPECT_EQ(0, a[7]);
+
+    // The pool keeps working after the exception
+    parallelFor(kZeroSize, a.size(), [&a] (size_t i) {
+        a[i] = 2;
+    });
+    EXPECT_TRUE(std::all_of(a.begin(), a.end(), [](int x) {
+        return x == 2;
+    }));
+
+    setMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, ForWithGrainSize) {
+    std::vector<int> a(1000, 0);
+
+    parallelFor(kZeroSize, a.size(), size_t(7), [&a] (size_t i) {
+        ++a[i];
+    });
+
+    for (int val : a) {
+        EXPECT_EQ(1, val);
+    }
+}
+
+TEST(Parallel, RangeFor) {
+    std::vector<int> a(1003, 0);
+
+    parallelRangeFor(
+        kZeroSize, a.size(), size_t(10),
+        [&a] (size_t begin, size_t end) {
+            EXPECT_LT(begin, end);
+            EXPECT_LE(end - begin, 10u);
+            for (size_t i = begin; i < end; ++i) {
+                ++a[i];
+            }
+        });
+
+    parallelRangeFor(
+        kZeroSize, a.size(),
+        [&a] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ++a[i];
+            }
+        });
+
+    for (int val : a) {
+        EXPECT_EQ(2, val);
+    }
+}
+
+TEST(Parallel, RangeFor2D) {
+    Array2<int> a(23, 37);
+
+    parallelRangeFor(
+        kZeroSize, a.width(), kZeroSize, a.height(),
+        [&a] (size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd) {
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                for (size_t i = iBegin; i < iEnd; ++i) {
+                    ++a(i, j);
+                }
+            }
+        });
+
+    a.forEach([] (int val) {
+        EXPECT_EQ(1, val);
+    });
+}
+
+TEST(Parallel, RangeFor3D) {
+    Array3<int> a(13, 21, 17);
+
+    parallelRangeFor(
+        kZeroSize, a.width(), kZeroSize, a.height(), kZeroSize, a.depth(),
+        [&a] (size_t iBegin, size_t iEnd,
+              size_t jBegin, size_t jEnd,
+              size_t kBegin, size_t kEnd) {
+            EXPECT_EQ(0u, iBegin);
+            EXPECT_EQ(a.width(), iEnd);
+            for (size_t k = kBegin; k < kEnd; ++k) {
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        ++a(i, j, k);
+                    }
+                }
+            }
+        });
+
+    a.forEach([] (int val) {
+        EXPECT_EQ(1, val);
+    });
+}
+
+TEST(Parallel, Reduce) {
+    std::vector<double> a(100003);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = 1.0 / static_cast<double>(i + 1);
+    }
+
+    auto sum = [&a] () {
+        return parallelReduce(
+            kZeroSize,
+            a.size(),
+            0.0,
+            [&a] (size_t begin, size_t end, double partial) {
+                for (size_t i = begin; i < end; ++i) {
+                    partial += a[i];
+                }
+                return partial;
+            },
+            std::plus<double>());
+    };
+
+    double expected = 0.0;
+    for (double val : a) {
+        expected += val;
+    }
+
+    unsigned int oldNumThreads = maxNumberOfThreads();
+
+    setMaxNumberOfThreads(1);
+    double result1 = sum();
+    setMaxNumberOfThreads(5);
+    double result5 = sum();
+
+    setMaxNumberOfThreads(oldNumThreads);
+
+    EXPECT_NEAR(expected, result1, 1e-9);
+    // Summation order must not depend on the number of threads.
+    EXPECT_EQ(result1, result5);
+
+    double empty = parallelReduce(
+        kZeroSize,
+        kZeroSize,
+        7.0,
+        [] (size_t, size_t, double partial) {
+            return partial + 1.0;
+        },
+        std::plus<double>());
+    EXPECT_EQ(7.0, empty);
+}
+
+TEST(Parallel, MinMax) {
+    std::vector<int> a(12345);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<int>((i * 7919) % 10007) - 5000;
+    }
+
+    int minValue, maxValue;
+    parallelMinMax(
+        kZeroSize,
+        a.size(),
+        [&a] (size_t i) {
+            return a[i];
+        },
+        &minValue,
+        &maxValue);
+
+    EXPECT_EQ(*std::min_element(a.begin(), a.end()), minValue);
+    EXPECT_EQ(*std::max_element(a.begin(), a.end()), maxValue);
+}
+
+TEST(Parallel, RadixSort) {
+    const size_t maxKey = 70000;
+    std::vector<size_t> keys(20011);
+    std::vector<size_t> indices(keys.size());
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<size_t> d(0, maxKey);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = d(rng);
+        indices[i] = i;
+    }
+
+    std::vector<size_t> originalKeys = keys;
+
+    parallelRadixSort(keys.begin(), keys.end(), indices.begin(), maxKey);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(originalKeys[indices[i]], keys[i]);
+    }
+
+    for (size_t i = 0; i + 1 < keys.size(); ++i) {
+        EXPECT_LE(keys[i], keys[i + 1]);
+        if (keys[i] == keys[i + 1]) {
+            // Stable
+            EXPECT_LT(indices[i], indices[i + 1]);
+        }
+    }
+}
+
+TEST(Parallel, ExclusiveScan) {
+    std::vector<size_t> values(20011);
+    std::mt19937 rng;
+    std::uniform_int_distribution<size_t> d(0, 9);
+    for (size_t& value : values) {
+        value = d(rng);
+    }
+
+    std::vector<size_t> sums(values.size());
+    size_t total = parallelExclusiveScan(
+        values.begin(), values.end(), sums.begin(), kOneSize);
+
+    size_t expected = 1;
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(expected, sums[i]) << i;
+        expected += values[i];
+    }
+    EXPECT_EQ(expected, total);
+
+    // In place, with a custom operation
+    std::vector<size_t> maxes = values;
+    total = parallelExclusiveScan(
+        maxes.begin(), maxes.end(), maxes.begin(), kZeroSize,
+        [](size_t a, size_t b) {
+            return std::max(a, b);
+        });
+
+    expected = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(expected, maxes[i]) << i;
+        expected = std::max(expected, values[i]);
+    }
+    EXPECT_EQ(expected, total);
+
+    EXPECT_EQ(
+        3u,
+        parallelExclusiveScan(
+            values.begin(), values.begin(), sums.begin(), size_t(3)));
+}
+
+TEST(Parallel, CopyIf) {
+    std::vector<int> values(30011);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> d(0, 100);
+    for (int& value : values) {
+        value = d(rng);
+    }
+
+    auto isOdd = [](int value) {
+        return value % 2 == 1;
+    };
+
+    std::vector<int> expected;
+    std::copy_if(
+        values.begin(), values.end(), std::back_inserter(expected), isOdd);
+
+    std::vector<int> result(values.size());
+    auto resultEnd = parallelCopyIf(
+        values.begin(), values.end(), result.begin(), isOdd);
+    result.erase(resultEnd, result.end());
+    EXPECT_EQ(expected, result);
+
+    std::vector<size_t> indices(values.size());
+    size_t numberOfIndices = parallelCompact(
+        kZeroSize, values.size(), indices.begin(), [&](size_t i) {
+            return isOdd(values[i]);
+        });
+    ASSERT_EQ(expected.size(), numberOfIndices);
+    for (size_t i = 0; i < numberOfIndices; ++i) {
+        EXPECT_EQ(expected[i], values[indices[i]]);
+        if (i > 0) {
+            EXPECT_LT(indices[i - 1], indices[i]);
+        }
+    }
+}
+
+TEST(Parallel, Partition) {
+    std::vector<int> values(30011);
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> d(0, 100);
+    for (int& value : values) {
+        value = d(rng);
+    }
+
+    auto isSmall = [](int value) {
+        return value < 30;
+    };
+
+    std::vector<int> expected = values;
+    auto expectedMiddle = std::stable_partition(
+        expected.begin(), expected.end(), isSmall);
+
+    auto middle = parallelPartition(values.begin(), values.end(), isSmall);
+    EXPECT_EQ(
+        expectedMiddle - expected.begin(), middle - values.begin());
+    EXPECT_EQ(expected, values);
+}
+
+TEST(Parallel, Deterministic) {
+    unsigned int oldNumThreads = maxNumberOfThreads();
+    EXPECT_FALSE(isDeterministic());
+    setIsDeterministic(true);
+    EXPECT_TRUE(isDeterministic());
+
+    // Keys with many duplicates, so that an unstable sort could permute the
+    // indices of the equal keys
+    const size_t n = 10007;
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = static_cast<int>((i * 7919) % 97);
+    }
+    std::vector<size_t> expectedOrder(n);
+    for (size_t i = 0; i < n; ++i) {
+        expectedOrder[i] = i;
+    }
+    auto compare = [&keys](size_t a, size_t b) { return keys[a] < keys[b]; };
+    std::stable_sort(expectedOrder.begin(), expectedOrder.end(), compare);
+
+    std::vector<std::pair<size_t, size_t>> expectedChunks;
+    double expectedSum = 0.0;
+
+    for (unsigned int numThreads : {1u, 3u, 8u}) {
+        setMaxNumberOfThreads(numThreads);
+
+        std::vector<size_t> order(n);
+        for (size_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        parallelSort(order.begin(), order.end(), compare);
+        EXPECT_EQ(expectedOrder, order);
+
+        // The chunks and a sum that is accumulated per chunk do not depend
+        // on the thread count
+        std::vector<std::pair<size_t, size_t>> chunks(n);
+        std::vector<double> partials(n, 0.0);
+        parallelRangeFor(
+            kZeroSize, n,
+            [&](size_t begin, size_t end) {
+                chunks[begin] = std::make_pair(begin, end);
+                for (size_t i = begin; i < end; ++i) {
+                    partials[begin] += 1.0 / (i + 1.0);
+                }
+            });
+        double sum = 0.0;
+        for (double partial : partials) {
+            sum += partial;
+        }
+
+        if (numThreads == 1u) {
+            expectedChunks = chunks;
+            expectedSum = sum;
+        } else {
+            EXPECT_EQ(expectedChunks, chunks);
+            EXPECT_EQ(expectedSum, sum);
+        }
+    }
+
+    setIsDeterministic(false);
+    setMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, SerialExecutionScope) {
+    EXPECT_FALSE(isSerialExecutionScope());
+    unsigned int numThreads = maxNumberOfThreads();
+
+    {
+        SerialExecutionScope scope;
+        EXPECT_TRUE(isSerialExecutionScope());
+        EXPECT_EQ(1u, maxNumberOfThreads());
+
+        // Everything runs on this thread, including the nested calls
+        std::thread::id thisId = std::this_thread::get_id();
+        std::vector<int> a(1003, 0);
+        bool isOnThisThread = true;
+        parallelFor(kZeroSize, a.size(), size_t(10), [&](size_t i) {
+            ++a[i];
+            isOnThisThread &= (std::this_thread::get_id() == thisId);
+        });
+        parallelFor(kZeroSize, size_t(17), [&](size_t j) {
+            parallelFor(j * 59, (j + 1) * 59, [&](size_t i) {
+                ++a[i];
+                isOnThisThread &= (std::this_thread::get_id() == thisId);
+            });
+        });
+        EXPECT_TRUE(isOnThisThread);
+        for (int val : a) {
+            EXPECT_EQ(2, val);
+        }
+
+        {
+            SerialExecutionScope nested;
+            EXPECT_TRUE(isSerialExecutionScope());
+        }
+        EXPECT_TRUE(isSerialExecutionScope());
+
+        // The other threads are not affected
+        bool isOtherSerial = true;
+        std::thread other([&] {
+            isOtherSerial = isSerialExecutionScope();
+        });
+        other.join();
+        EXPECT_FALSE(isOtherSerial);
+    }
+
+    EXPECT_FALSE(isSerialExecutionScope());
+    EXPECT_EQ(numThreads, maxNumberOfThreads());
+}
+
+TEST(Parallel, ThreadPinning) {
+    unsigned int oldNumThreads = maxNumberOfThreads();
+    EXPECT_FALSE(isThreadPinningEnabled());
+
+    setIsThreadPinningEnabled(true);
+    EXPECT_TRUE(isThreadPinningEnabled());
+
+    for (unsigned int numThreads : {1u, 3u, 8u}) {
+        setMaxNumberOfThreads(numThreads);
+        EXPECT_TRUE(isThreadPinningEnabled());
+
+        // All the tasks run once, including the nested ones
+        std::vector<int> a(1003, 0);
+        parallelFor(kZeroSize, a.size(), size_t(10), [&a] (size_t i) {
+            ++a[i];
+        });
+        parallelFor(kZeroSize, size_t(17), [&a] (size_t j) {
+            parallelFor(j * 59, (j + 1) * 59, [&a] (size_t i) {
+                ++a[i];
+            });
+        });
+        for (int val : a) {
+            EXPECT_EQ(2, val);
+        }
+    }
+
+    setIsThreadPinningEnabled(false);
+    EXPECT_FALSE(isThreadPinningEnabled());
+    setMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, Backends) {
+    EXPECT_TRUE(isParallelBackendAvailable(ParallelBackend::ThreadPool));
+
+    ParallelBackend oldBackend = parallelBackend();
+
+    for (ParallelBackend backend : {
+        ParallelBackend::ThreadPool,
+        ParallelBackend::Tbb,
+        ParallelBackend::OpenMp}) {
+        if (!isParallelBackendAvailable(backend)) {
+            EXPECT_THROW(setParallelBackend(backend), std::invalid_argument);
+            continue;
+        }
+
+        setParallelBackend(backend);
+        EXPECT_EQ(backend, parallelBackend());
+        EXPECT_LE(1u, maxNumberOfThreads());
+
+        // Nested calls, and a reduction that does not depend on the backend
+        std::vector<size_t> sums(50, 0);
+        parallelFor(kZeroSize, sums.size(), [&](size_t i) {
+            sums[i] = parallelReduce(
+                kZeroSize, 1000 * (i + 1), kZeroSize,
+                [](size_t begin, size_t end, size_t sum) {
+                    for (size_t j = begin; j < end; ++j) {
+                        sum += j;
+                    }
+                    return sum;
+                },
+                [](size_t a, size_t b) {
+                    return a + b;
+                });
+        });
+        for (size_t i = 0; i < sums.size(); ++i) {
+            size_t n = 1000 * (i + 1);
+            EXPECT_EQ(n * (n - 1) / 2, sums[i]);
+        }
+
+        std::vector<int> values(20011);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<int>((i * 7919) % 1009);
+        }
+        std::vector<int> expected = values;
+        std::sort(expected.begin(), expected.end());
+        parallelSort(values.begin(), values.end());
+        EXPECT_EQ(expected, values);
+    }
+
+    setParallelBackend(oldBackend);
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/constants.h>
+#include <jet/parallel_tuner.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+ParallelTuningResult findResult(const std::string& name) {
+    for (const ParallelTuningResult& result : ParallelTuner::results()) {
+        if (result.name == name) {
+            return result;
+        }
+    }
+    return ParallelTuningResult();
+}
+
+// Runs the region over n indices and returns the number of visited indices
+size_t runRegion(ParallelRegion* region, size_t n) {
+    std::vector<double> values(n, 0.0);
+    region->parallelFor(kZeroSize, n, [&](size_t i) {
+        values[i] = 1.0 + static_cast<double>(i % 7);
+    });
+
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (values[i] == 1.0 + static_cast<double>(i % 7)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+}  // namespace
+
+TEST(ParallelTuner, Disabled) {
+    ParallelRegion region("ParallelTunerTests::Disabled");
+    EXPECT_STREQ("ParallelTunerTests::Disabled", region.name());
+    EXPECT_FALSE(ParallelTuner::isEnabled());
+
+    for (int i = 0; i < 30; ++i) {
+        EXPECT_EQ(10000u, runRegion(&region, 10000));
+    }
+
+    std::atomic<size_t> numberOfChunks(0);
+    region.parallelRangeFor(kZeroSize, size_t(100), size_t(10),
+        [&](size_t begin, size_t end) {
+            EXPECT_EQ(10u, end - begin);
+            ++numberOfChunks;
+        });
+    EXPECT_EQ(10u, numberOfChunks);
+
+    ParallelTuningResult result = findResult(region.name());
+    EXPECT_EQ(region.name(), result.name);
+    EXPECT_FALSE(result.isTuned);
+    EXPECT_EQ(0u, result.numberOfChunks);
+}
+
+TEST(ParallelTuner, Tune) {
+    ParallelTuner::setIsEnabled(true);
+    ParallelTuner::reset();
+
+    ParallelRegion region("ParallelTunerTests::Tune");
+    for (int i = 0; i < 30; ++i) {
+        EXPECT_EQ(100000u, runRegion(&region, 100000));
+    }
+
+    ParallelTuningResult result = findResult(region.name());
+    EXPECT_TRUE(result.isTuned);
+
+    size_t t = maxNumberOfThreads();
+    std::vector<size_t> candidates = { 1, t / 4, t / 2, t, 4 * t, 16 * t };
+    EXPECT_NE(
+        candidates.end(),
+        std::find(candidates.begin(), candidates.end(), result.numberOfChunks));
+
+    // The tuned partitioning is used from now on
+    std::atomic<size_t> numberOfChunks(0);
+    region.parallelRangeFor(kZeroSize, size_t(100000),
+        [&](size_t, size_t) {
+            ++numberOfChunks;
+        });
+    EXPECT_EQ(std::min(result.numberOfChunks, size_t(100000)), numberOfChunks);
+
+    // Regions of the same name share the result
+    ParallelRegion sameRegion("ParallelTunerTests::Tune");
+    EXPECT_EQ(100u, runRegion(&sameRegion, 100));
+    EXPECT_EQ(result.numberOfChunks, findResult(region.name()).numberOfChunks);
+
+    // Serial scopes are not tuned
+    {
+        SerialExecutionScope scope;
+        EXPECT_EQ(1000u, runRegion(&region, 1000));
+    }
+
+    ParallelTuner::reset();
+    EXPECT_FALSE(findResult(region.name()).isTuned);
+
+    ParallelTuner::setIsEnabled(false);
+}
+
+TEST(ParallelTuner, Profile) {
+    ParallelTuner::setIsEnabled(true);
+    ParallelTuner::reset();
+
+    ParallelRegion region("ParallelTunerTests::Profile");
+    for (int i = 0; i < 30; ++i) {
+        runRegion(&region, 100000);
+    }
+    size_t tuned = findResult(region.name()).numberOfChunks;
+    ASSERT_LT(0u, tuned);
+
+    std::stringstream strm;
+    ParallelTuner::saveProfile(&strm);
+
+    ParallelTuner::reset();
+    EXPECT_FALSE(findResult(region.name()).isTuned);
+
+    ASSERT_TRUE(ParallelTuner::loadProfile(&strm));
+    ParallelTuningResult result = findResult(region.name());
+    EXPECT_TRUE(result.isTuned);
+    EXPECT_EQ(tuned, result.numberOfChunks);
+    EXPECT_EQ(0.0, result.secondsPerIndex);
+
+    // Regions that are not constructed yet take the loaded configuration
+    std::stringstream other;
+    other << "jet_parallel_tuning 1\n"
+          << "threads " << maxNumberOfThreads() << "\n"
+          << "3 ParallelTunerTests::NotConstructedYet\n";
+    ASSERT_TRUE(ParallelTuner::loadProfile(&other));
+
+    ParallelRegion later("ParallelTunerTests::NotConstructedYet");
+    std::atomic<size_t> numberOfChunks(0);
+    later.parallelRangeFor(kZeroSize, size_t(300),
+        [&](size_t begin, size_t end) {
+            EXPECT_EQ(100u, end - begin);
+            ++numberOfChunks;
+        });
+    EXPECT_EQ(3u, numberOfChunks);
+
+    // Profiles of another number of threads are ignored
+    std::stringstream mismatch;
+    mismatch << "jet_parallel_tuning 1\n"
+             << "threads " << maxNumberOfThreads() + 1 << "\n"
+             << "5 ParallelTunerTests::NotConstructedYet\n";
+    EXPECT_FALSE(ParallelTuner::loadProfile(&mismatch));
+    EXPECT_EQ(3u, findResult(later.name()).numberOfChunks);
+
+    std::stringstream invalid("not a profile");
+    EXPECT_FALSE(ParallelTuner::loadProfile(&invalid));
+    EXPECT_FALSE(ParallelTuner::loadProfile(std::string("no_such_file")));
+
+    ParallelTuner::reset();
+    ParallelTuner::setIsEnabled(false);
+}
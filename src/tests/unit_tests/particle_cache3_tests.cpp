@@ -0,0 +1,262 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/particle_cache3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+
+using namespace jet;
+
+TEST(ParticleCache3, WriteAndRead) {
+    const std::string filename = "particle_cache3_tests_write_and_read.pcache";
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+
+    ParticleSystemData3 particles;
+    particles.setRadius(0.25);
+    particles.setMass(2.0);
+    Array1<Vector3D> positions(1001);
+    Array1<Vector3D> velocities(1001);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = Vector3D(d(rng), d(rng), d(rng));
+        velocities[i] = Vector3D(d(rng), d(rng), d(rng));
+    }
+    particles.addParticles(
+        positions.constAccessor(), velocities.constAccessor());
+
+    Array1<double> densities(1001);
+    for (size_t i = 0; i < densities.size(); ++i) {
+        densities[i] = d(rng);
+    }
+
+    ParticleCacheWriter3 writer(particles);
+    writer.addScalarChannel("density", densities.constAccessor());
+    EXPECT_THROW(
+        writer.addScalarChannel("density", ConstArrayAccessor1<double>()),
+        std::invalid_argument);
+    EXPECT_THROW(
+        writer.addVectorChannel(
+            std::string(48, 'x'), positions.constAccessor()),
+        std::invalid_argument);
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        writer.write(&file);
+    }
+
+    BoundingBox3D expectedBox;
+    for (const auto& pt : positions) {
+        expectedBox.merge(pt);
+    }
+
+    ParticleCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    EXPECT_EQ(1001u, reader.numberOfParticles());
+    EXPECT_EQ(0.25, reader.radius());
+    EXPECT_EQ(2.0, reader.mass());
+    EXPECT_EQ(expectedBox.lowerCorner, reader.boundingBox().lowerCorner);
+    EXPECT_EQ(expectedBox.upperCorner, reader.boundingBox().upperCorner);
+
+    ASSERT_EQ(4u, reader.numberOfChannels());
+    EXPECT_EQ("position", reader.channelName(0));
+    EXPECT_EQ("velocity", reader.channelName(1));
+    EXPECT_EQ("force", reader.channelName(2));
+    EXPECT_EQ("density", reader.channelName(3));
+    EXPECT_TRUE(reader.hasVectorChannel("position"));
+    EXPECT_TRUE(reader.hasScalarChannel("density"));
+    EXPECT_FALSE(reader.hasScalarChannel("position"));
+    EXPECT_FALSE(reader.hasVectorChannel("pressure"));
+    EXPECT_EQ(0u, reader.vectorChannel("pressure").size());
+
+    auto readPositions = reader.vectorChannel("position");
+    auto readVelocities = reader.vectorChannel("velocity");
+    auto readForces = reader.vectorChannel("force");
+    auto readDensities = reader.scalarChannel("density");
+    ASSERT_EQ(1001u, readPositions.size());
+    ASSERT_EQ(1001u, readVelocities.size());
+    ASSERT_EQ(1001u, readForces.size());
+    ASSERT_EQ(1001u, readDensities.size());
+
+    // The views point into the mapped file, aligned for the element access
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(readPositions.data()) % 64);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(readDensities.data()) % 64);
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_EQ(positions[i], readPositions[i]);
+        EXPECT_EQ(velocities[i], readVelocities[i]);
+        EXPECT_EQ(Vector3D(), readForces[i]);
+        EXPECT_EQ(densities[i], readDensities[i]);
+    }
+
+    reader.close();
+    EXPECT_EQ(0u, reader.numberOfParticles());
+    EXPECT_EQ(0u, reader.numberOfChannels());
+
+    std::remove(filename.c_str());
+}
+
+TEST(ParticleCache3, Empty) {
+    const std::string filename = "particle_cache3_tests_empty.pcache";
+
+    ParticleSystemData3 particles;
+    ParticleCacheWriter3 writer(particles);
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        writer.write(&file);
+    }
+
+    ParticleCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    EXPECT_EQ(0u, reader.numberOfParticles());
+    EXPECT_EQ(3u, reader.numberOfChannels());
+    EXPECT_TRUE(reader.hasVectorChannel("position"));
+    EXPECT_EQ(0u, reader.vectorChannel("position").size());
+
+    std::remove(filename.c_str());
+}
+
+TEST(ParticleCache3, InvalidFile) {
+    const std::string filename = "particle_cache3_tests_invalid_file.pos";
+
+    ParticleCacheReader3 reader;
+    EXPECT_FALSE(reader.open("particle_cache3_tests_no_such_file.pcache"));
+
+    // Raw array written by Array1::serialize
+    Array1<Vector3D> positions(100, Vector3D(1, 2, 3));
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        positions.serialize(&file);
+    }
+    EXPECT_FALSE(reader.open(filename));
+
+    // Truncated cache
+    ParticleSystemData3 particles;
+    particles.addParticles(positions.constAccessor());
+    ParticleCacheWriter3 writer(particles);
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        writer.write(&file);
+    }
+    EXPECT_TRUE(reader.open(filename));
+    reader.close();
+    {
+        std::ifstream file(filename.c_str(), std::ifstream::binary);
+        std::string contents(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+        file.close();
+        std::ofstream truncated(filename.c_str(), std::ofstream::binary);
+        truncated.write(contents.data(), contents.size() - 8);
+    }
+    EXPECT_FALSE(reader.open(filename));
+    EXPECT_EQ(0u, reader.numberOfChannels());
+
+    std::remove(filename.c_str());
+}
+
+TEST(ParticleCache3, Compression) {
+    const std::string filename = "particle_cache3_tests_compression.pcache";
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+
+    // Particles in a block, jittered, in the order they were seeded
+    ParticleSystemData3 particles;
+    Array1<Vector3D> positions;
+    Array1<Vector3D> velocities;
+    for (size_t k = 0; k < 40; ++k) {
+        for (size_t j = 0; j < 40; ++j) {
+            for (size_t i = 0; i < 50; ++i) {
+                positions.append(
+                    0.02 * Vector3D(i + 0.5 * d(rng), j + 0.5 * d(rng),
+                                    k + 0.5 * d(rng)) - Vector3D(0.4, 0, 0));
+                velocities.append(Vector3D(d(rng), 10.0 * d(rng), 0.0));
+            }
+        }
+    }
+    velocities[0] = Vector3D(1e-6, -70000.0, 1.0 / 3.0);
+    particles.addParticles(
+        positions.constAccessor(), velocities.constAccessor());
+
+    Array1<double> densities(positions.size());
+    for (size_t i = 0; i < densities.size(); ++i) {
+        densities[i] = 1000.0 + d(rng);
+    }
+
+    ParticleCacheWriter3 writer(particles);
+    writer.addScalarChannel("density", densities.constAccessor());
+    EXPECT_FALSE(writer.isUsingCompression());
+    EXPECT_EQ(2.0 * particles.radius(), writer.bucketSpacing());
+    writer.setIsUsingCompression(true);
+    writer.setBucketSpacing(0.04);
+    EXPECT_TRUE(writer.isUsingCompression());
+    EXPECT_EQ(0.04, writer.bucketSpacing());
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        writer.write(&file);
+    }
+
+    std::ifstream sizeFile(filename.c_str(), std::ifstream::binary);
+    sizeFile.seekg(0, std::ios::end);
+    size_t compressedSize = static_cast<size_t>(sizeFile.tellg());
+    sizeFile.close();
+    size_t rawSize = positions.size() * (3 * sizeof(Vector3D) + sizeof(double));
+    EXPECT_LT(compressedSize, rawSize / 2);
+
+    ParticleCacheReader3 reader;
+    ASSERT_TRUE(reader.open(filename));
+    ASSERT_EQ(positions.size(), reader.numberOfParticles());
+    ASSERT_EQ(4u, reader.numberOfChannels());
+
+    auto readPositions = reader.vectorChannel("position");
+    auto readVelocities = reader.vectorChannel("velocity");
+    auto readForces = reader.vectorChannel("force");
+    auto readDensities = reader.scalarChannel("density");
+    ASSERT_EQ(positions.size(), readPositions.size());
+    ASSERT_EQ(positions.size(), readVelocities.size());
+    ASSERT_EQ(positions.size(), readForces.size());
+    ASSERT_EQ(positions.size(), readDensities.size());
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            EXPECT_NEAR(
+                positions[i][axis], readPositions[i][axis],
+                0.04 / 131072.0 + 1e-15);
+
+            // Half precision has an 11-bit significand
+            if (i > 0) {
+                EXPECT_NEAR(
+                    velocities[i][axis], readVelocities[i][axis],
+                    std::fabs(velocities[i][axis]) / 2048.0 + 1e-7);
+            }
+            EXPECT_EQ(0.0, readForces[i][axis]);
+        }
+        EXPECT_EQ(densities[i], readDensities[i]);
+    }
+
+    // Subnormal half floats, and overflows to infinity
+    EXPECT_NEAR(1e-6, readVelocities[0].x, 3e-8);
+    EXPECT_EQ(-std::numeric_limits<double>::infinity(), readVelocities[0].y);
+    EXPECT_NEAR(1.0 / 3.0, readVelocities[0].z, 1e-3);
+
+    // Truncated blocks are detected
+    reader.close();
+    {
+        std::ifstream file(filename.c_str(), std::ifstream::binary);
+        std::string contents(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+        file.close();
+        std::ofstream truncated(filename.c_str(), std::ofstream::binary);
+        truncated.write(contents.data(), contents.size() - 4);
+    }
+    EXPECT_FALSE(reader.open(filename));
+
+    std::remove(filename.c_str());
+}
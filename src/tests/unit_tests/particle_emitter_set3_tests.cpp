@@ -0,0 +1,103 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/particle_emitter_set3.h>
+#include <jet/point_particle_emitter3.h>
+#include <jet/sphere3.h>
+#include <jet/surface_to_implicit3.h>
+#include <jet/volume_particle_emitter3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(ParticleEmitterSet3, Constructors) {
+    ParticleEmitterSet3 emitterSet;
+    EXPECT_EQ(0u, emitterSet.numberOfEmitters());
+
+    auto emitter1 = std::make_shared<PointParticleEmitter3>(
+        Vector3D(), Vector3D(0, 1, 0), 1.0, 10.0, 4);
+    auto emitter2 = std::make_shared<PointParticleEmitter3>(
+        Vector3D(), Vector3D(1, 0, 0), 1.0, 10.0, 4);
+
+    ParticleEmitterSet3 emitterSet2({emitter1, emitter2});
+    EXPECT_EQ(2u, emitterSet2.numberOfEmitters());
+    EXPECT_EQ(emitter1, emitterSet2.emitterAt(0));
+    EXPECT_EQ(emitter2, emitterSet2.emitterAt(1));
+}
+
+TEST(ParticleEmitterSet3, PreviewScale) {
+    auto emitter1 = std::make_shared<PointParticleEmitter3>(
+        Vector3D(), Vector3D(0, 1, 0), 1.0, 10.0, 800);
+    auto emitter2 = std::make_shared<VolumeParticleEmitter3>(
+        std::make_shared<SurfaceToImplicit3>(
+            std::make_shared<Sphere3>(Vector3D(0.5, 0.5, 0.5), 0.15)),
+        BoundingBox3D(Vector3D(), Vector3D(1, 1, 1)),
+        0.05);
+
+    ParticleEmitterSet3 emitterSet({emitter1, emitter2});
+    emitterSet.setPreviewScale(2.0);
+    EXPECT_EQ(2.0, emitterSet.previewScale());
+    EXPECT_EQ(2.0, emitter1->previewScale());
+    EXPECT_EQ(100u, emitter1->maxNumberOfNewParticlesPerSecond());
+    EXPECT_DOUBLE_EQ(0.1, emitter2->spacing());
+}
+
+TEST(ParticleEmitterSet3, Emit) {
+    auto sphere = std::make_shared<SurfaceToImplicit3>(
+        std::make_shared<Sphere3>(Vector3D(0.5, 0.5, 0.5), 0.15));
+    BoundingBox3D box(Vector3D(), Vector3D(1, 1, 1));
+
+    Vector3D dir = Vector3D(0.5, 1.0, -2.0).normalized();
+
+    ParticleEmitterSet3 emitterSet;
+    emitterSet.addEmitter(std::make_shared<PointParticleEmitter3>(
+        Vector3D(1, 2, 3), dir, 3.0, 15.0, 4, 18, 1));
+    emitterSet.addEmitter(std::make_shared<VolumeParticleEmitter3>(
+        sphere, box, 0.1, Vector3D(-1, 0.5, 2.5)));
+    emitterSet.addEmitter(std::make_shared<PointParticleEmitter3>(
+        Vector3D(4, 5, 6), dir, 2.0, 15.0, 8, 100, 2));
+
+    // The same emitters run one by one, which give the same particles
+    PointParticleEmitter3 point1(
+        Vector3D(1, 2, 3), dir, 3.0, 15.0, 4, 18, 1);
+    VolumeParticleEmitter3 volume(
+        sphere, box, 0.1, Vector3D(-1, 0.5, 2.5));
+    PointParticleEmitter3 point2(
+        Vector3D(4, 5, 6), dir, 2.0, 15.0, 8, 100, 2);
+
+    auto particles = std::make_shared<ParticleSystemData3>();
+    auto expected = std::make_shared<ParticleSystemData3>();
+
+    Frame frame(0, 1.0);
+    for (int f = 0; f < 3; ++f) {
+        emitterSet.emit(frame, particles);
+
+        point1.emit(frame, expected);
+        volume.emit(frame, expected);
+        point2.emit(frame, expected);
+
+        frame.advance();
+    }
+
+    ASSERT_EQ(expected->numberOfParticles(), particles->numberOfParticles());
+    EXPECT_LT(36u, particles->numberOfParticles());
+
+    auto pos = particles->positions();
+    auto vel = particles->velocities();
+    auto expectedPos = expected->positions();
+    auto expectedVel = expected->velocities();
+
+    // Particles of each frame are grouped by the emitters in the same order
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        EXPECT_EQ(expectedPos[i], pos[i]);
+        EXPECT_EQ(expectedVel[i], vel[i]);
+    }
+
+    // generate() leaves the particle system data as is
+    Array1<Vector3D> newPositions(5);
+    Array1<Vector3D> newVelocities(5);
+    size_t numberOfParticles = particles->numberOfParticles();
+    emitterSet.generate(frame, particles, &newPositions, &newVelocities);
+    EXPECT_EQ(12u, newPositions.size());
+    EXPECT_EQ(12u, newVelocities.size());
+    EXPECT_EQ(numberOfParticles, particles->numberOfParticles());
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <thread_communicator.h>
+#include <jet/particle_slab_decomposition3.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const int kNumberOfRanks = 3;
+const size_t kNumberOfParticles = 3000;
+
+// Deterministic particle position scattered over z in [-1, 4).
+Vector3D particlePosition(size_t id) {
+    double t = id * 0.6180339887;
+    double z = t - std::floor(t);
+    return Vector3D(
+        std::fmod(id * 0.37, 1.0), std::fmod(id * 0.11, 1.0), 5.0 * z - 1.0);
+}
+
+// Each rank starts with every third particle regardless of the position.
+void addInitialParticles(int rank, ParticleSystemData3* particles) {
+    size_t idData = particles->addScalarData();
+    size_t vectorData = particles->addVectorData();
+    for (size_t id = rank; id < kNumberOfParticles; id += kNumberOfRanks) {
+        particles->addParticle(particlePosition(id), Vector3D(id, 0, 0));
+        size_t i = particles->numberOfParticles() - 1;
+        particles->scalarDataAt(idData)[i] = static_cast<double>(id);
+        particles->vectorDataAt(vectorData)[i] = Vector3D(0, 0, 2.0 * id);
+    }
+}
+
+}  // namespace
+
+TEST(ParticleSlabDecomposition3, Boundaries) {
+    ParticleSlabDecomposition3 decomposition(
+        0.0, 3.0, std::make_shared<SerialCommunicator>());
+    EXPECT_EQ(2u, decomposition.boundaries().size());
+    EXPECT_DOUBLE_EQ(0.0, decomposition.zBegin());
+    EXPECT_DOUBLE_EQ(3.0, decomposition.zEnd());
+    EXPECT_EQ(0, decomposition.ownerRank(-5.0));
+    EXPECT_EQ(0, decomposition.ownerRank(5.0));
+
+    runOnThreadRanks(kNumberOfRanks, [](const CommunicatorPtr& comm) {
+        ParticleSlabDecomposition3 decomposition(0.0, 3.0, comm);
+        int rank = comm->rank();
+        EXPECT_DOUBLE_EQ(rank, decomposition.zBegin());
+        EXPECT_DOUBLE_EQ(rank + 1.0, decomposition.zEnd());
+        EXPECT_EQ(0, decomposition.ownerRank(-1.0));
+        EXPECT_EQ(0, decomposition.ownerRank(0.5));
+        EXPECT_EQ(1, decomposition.ownerRank(1.0));
+        EXPECT_EQ(2, decomposition.ownerRank(2.5));
+        EXPECT_EQ(2, decomposition.ownerRank(10.0));
+    });
+
+    EXPECT_THROW(
+        ParticleSlabDecomposition3(
+            1.0, 1.0, std::make_shared<SerialCommunicator>()),
+        std::invalid_argument);
+}
+
+TEST(ParticleSlabDecomposition3, MigrateParticles) {
+    std::vector<size_t> counts(kNumberOfRanks);
+
+    runOnThreadRanks(kNumberOfRanks, [&](const CommunicatorPtr& comm) {
+        ParticleSlabDecomposition3 decomposition(0.0, 3.0, comm);
+        ParticleSystemData3 particles;
+        addInitialParticles(comm->rank(), &particles);
+
+        decomposition.migrateParticles(&particles);
+
+        counts[comm->rank()] = particles.numberOfParticles();
+        for (size_t i = 0; i < particles.numberOfParticles(); ++i) {
+            double id = particles.scalarDataAt(0)[i];
+            Vector3D expected = particlePosition(static_cast<size_t>(id));
+            EXPECT_EQ(expected, particles.positions()[i]);
+            EXPECT_EQ(Vector3D(id, 0, 0), particles.velocities()[i]);
+            EXPECT_EQ(Vector3D(0, 0, 2.0 * id), particles.vectorDataAt(0)[i]);
+            EXPECT_EQ(
+                comm->rank(),
+                decomposition.ownerRank(particles.positions()[i].z));
+        }
+    });
+
+    std::vector<size_t> expectedCounts(kNumberOfRanks, 0);
+    for (size_t id = 0; id < kNumberOfParticles; ++id) {
+        double z = particlePosition(id).z;
+        int owner = (z < 1.0) ? 0 : ((z < 2.0) ? 1 : 2);
+        ++expectedCounts[owner];
+    }
+
+    for (int rank = 0; rank < kNumberOfRanks; ++rank) {
+        EXPECT_EQ(expectedCounts[rank], counts[rank]);
+    }
+}
+
+TEST(ParticleSlabDecomposition3, ExchangeHaloParticles) {
+    const double radius = 0.2;
+    std::vector<size_t> haloCounts(kNumberOfRanks);
+
+    runOnThreadRanks(kNumberOfRanks, [&](const CommunicatorPtr& comm) {
+        ParticleSlabDecomposition3 decomposition(0.0, 3.0, comm);
+        ParticleSystemData3 particles;
+        addInitialParticles(comm->rank(), &particles);
+        decomposition.migrateParticles(&particles);
+
+        ParticleSystemData3 halo;
+        decomposition.exchangeHaloParticles(particles, radius, &halo);
+
+        haloCounts[comm->rank()] = halo.numberOfParticles();
+        EXPECT_EQ(1u, halo.numberOfScalarData());
+        EXPECT_EQ(1u, halo.numberOfVectorData());
+        for (size_t i = 0; i < halo.numberOfParticles(); ++i) {
+            double id = halo.scalarDataAt(0)[i];
+            double z = halo.positions()[i].z;
+            EXPECT_EQ(
+                particlePosition(static_cast<size_t>(id)),
+                halo.positions()[i]);
+            EXPECT_EQ(Vector3D(0, 0, 2.0 * id), halo.vectorDataAt(0)[i]);
+            EXPECT_NE(comm->rank(), decomposition.ownerRank(z));
+            EXPECT_TRUE(z >= decomposition.zBegin() - radius
+                        && z < decomposition.zEnd() + radius);
+        }
+    });
+
+    std::vector<size_t> expectedCounts(kNumberOfRanks, 0);
+    for (size_t id = 0; id < kNumberOfParticles; ++id) {
+        double z = particlePosition(id).z;
+        if (z >= 1.0 - radius && z < 1.0) {
+            ++expectedCounts[1];
+        } else if (z >= 2.0 - radius && z < 2.0) {
+            ++expectedCounts[2];
+        }
+
+        if (z >= 1.0 && z < 1.0 + radius) {
+            ++expectedCounts[0];
+        } else if (z >= 2.0 && z < 2.0 + radius) {
+            ++expectedCounts[1];
+        }
+    }
+
+    for (int rank = 0; rank < kNumberOfRanks; ++rank) {
+        EXPECT_EQ(expectedCounts[rank], haloCounts[rank]);
+    }
+}
+
+TEST(ParticleSlabDecomposition3, Rebalance) {
+    std::vector<size_t> counts(kNumberOfRanks);
+
+    runOnThreadRanks(kNumberOfRanks, [&](const CommunicatorPtr& comm) {
+        // Most of the particles are in the first slab before the rebalancing
+        ParticleSlabDecomposition3 decomposition(-1.0, 14.0, comm);
+        ParticleSystemData3 particles;
+        addInitialParticles(comm->rank(), &particles);
+        decomposition.migrateParticles(&particles);
+
+        decomposition.rebalance(particles);
+        decomposition.migrateParticles(&particles);
+
+        counts[comm->rank()] = particles.numberOfParticles();
+
+        auto boundaries = decomposition.boundaries();
+        EXPECT_DOUBLE_EQ(-1.0, boundaries[0]);
+        EXPECT_DOUBLE_EQ(14.0, boundaries[kNumberOfRanks]);
+        for (int r = 0; r < kNumberOfRanks; ++r) {
+            EXPECT_LE(boundaries[r], boundaries[r + 1]);
+        }
+    });
+
+    size_t total = 0;
+    for (int rank = 0; rank < kNumberOfRanks; ++rank) {
+        total += counts[rank];
+        EXPECT_NEAR(
+            kNumberOfParticles / kNumberOfRanks,
+            static_cast<double>(counts[rank]),
+            0.02 * kNumberOfParticles);
+    }
+    EXPECT_EQ(kNumberOfParticles, total);
+}
@@ -214,3 +214,42 @@ TEST(ParticleSystemData2, BuildNeighborLists) {
         }
     }
 }
+
+TEST(ParticleSystemData2, SortParticles) {
+    ParticleSystemData2 particleSystem;
+    EXPECT_EQ(0u, particleSystem.sortedIndices().size());
+
+    Array1<Vector2D> positions = {
+        Vector2D(1.0, 1.0),
+        Vector2D(0.0, 1.0),
+        Vector2D(0.0, 0.0),
+        Vector2D(1.0, 0.0)
+    };
+    particleSystem.addParticles(
+        positions.constAccessor(), positions.constAccessor());
+
+    size_t scalarIdx = particleSystem.addScalarData();
+    size_t vectorIdx = particleSystem.addVectorData();
+    auto scalars = particleSystem.scalarDataAt(scalarIdx);
+    auto vectors = particleSystem.vectorDataAt(vectorIdx);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        scalars[i] = static_cast<double>(i);
+        vectors[i] = Vector2D(static_cast<double>(i), 0.0);
+    }
+
+    particleSystem.sortParticles();
+
+    const std::vector<size_t> answer = {2, 3, 1, 0};
+    auto sortedIndices = particleSystem.sortedIndices();
+    ASSERT_EQ(answer.size(), sortedIndices.size());
+
+    scalars = particleSystem.scalarDataAt(scalarIdx);
+    vectors = particleSystem.vectorDataAt(vectorIdx);
+    for (size_t i = 0; i < answer.size(); ++i) {
+        EXPECT_EQ(answer[i], sortedIndices[i]);
+        EXPECT_EQ(positions[answer[i]], particleSystem.positions()[i]);
+        EXPECT_EQ(positions[answer[i]], particleSystem.velocities()[i]);
+        EXPECT_EQ(static_cast<double>(answer[i]), scalars[i]);
+        EXPECT_EQ(static_cast<double>(answer[i]), vectors[i].x);
+    }
+}
@@ -1,7 +1,12 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/parallel.h>
 #include <jet/particle_system_data3.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include <utility>
 #include <vector>
 
 using namespace jet;
@@ -18,6 +23,30 @@ TEST(ParticleSystemData3, Resize) {
     EXPECT_EQ(12u, particleSystem.numberOfParticles());
 }
 
+TEST(ParticleSystemData3, Reserve) {
+    ParticleSystemData3 particleSystem;
+    particleSystem.addScalarData();
+    particleSystem.reserve(100);
+    EXPECT_EQ(0u, particleSystem.numberOfParticles());
+    EXPECT_LE(100u, particleSystem.capacity());
+
+    size_t vectorIdx = particleSystem.addVectorData();
+    const Vector3D* positions = particleSystem.positions().data();
+    const double* scalars = particleSystem.scalarDataAt(0).data();
+    const Vector3D* vectors = particleSystem.vectorDataAt(vectorIdx).data();
+    for (size_t i = 0; i < 100; ++i) {
+        particleSystem.addParticle(Vector3D(1.0, 2.0, 3.0));
+    }
+    EXPECT_EQ(100u, particleSystem.numberOfParticles());
+    EXPECT_EQ(positions, particleSystem.positions().data());
+    EXPECT_EQ(scalars, particleSystem.scalarDataAt(0).data());
+    EXPECT_EQ(vectors, particleSystem.vectorDataAt(vectorIdx).data());
+
+    // Grows geometrically once it is full
+    particleSystem.resize(101);
+    EXPECT_LE(200u, particleSystem.capacity());
+}
+
 TEST(ParticleSystemData3, AddScalarData) {
     ParticleSystemData3 particleSystem;
     particleSystem.resize(12);
@@ -87,6 +116,33 @@ TEST(ParticleSystemData3, AddParticles) {
     EXPECT_EQ(Vector3D(2.0, 1.0, 3.0), f[13]);
 }
 
+TEST(ParticleSystemData3, AddParticlesByMove) {
+    ParticleSystemData3 particleSystem;
+    size_t idx = particleSystem.addScalarData();
+
+    Array1<Vector3D> positions
+        = {Vector3D(1.0, 2.0, 3.0), Vector3D(4.0, 5.0, 6.0)};
+    Array1<Vector3D> velocities
+        = {Vector3D(7.0, 8.0, 9.0), Vector3D(8.0, 7.0, 6.0)};
+    const Vector3D* positionData = positions.data();
+
+    // The empty system takes over the arrays
+    particleSystem.addParticles(std::move(positions), std::move(velocities));
+    EXPECT_EQ(0u, positions.size());
+    EXPECT_EQ(2u, particleSystem.numberOfParticles());
+    EXPECT_EQ(positionData, particleSystem.positions().data());
+    EXPECT_EQ(Vector3D(8.0, 7.0, 6.0), particleSystem.velocities()[1]);
+    EXPECT_EQ(Vector3D(), particleSystem.forces()[1]);
+    EXPECT_EQ(0.0, particleSystem.scalarDataAt(idx)[1]);
+
+    // Otherwise, the arrays are appended
+    particleSystem.addParticles(
+        Array1<Vector3D>({Vector3D(3.0, 2.0, 1.0)}));
+    EXPECT_EQ(3u, particleSystem.numberOfParticles());
+    EXPECT_EQ(Vector3D(3.0, 2.0, 1.0), particleSystem.positions()[2]);
+    EXPECT_EQ(Vector3D(), particleSystem.velocities()[2]);
+}
+
 TEST(ParticleSystemData3, AddParticlesException) {
     ParticleSystemData3 particleSystem;
     particleSystem.resize(12);
@@ -126,6 +182,112 @@ TEST(ParticleSystemData3, AddParticlesException) {
     EXPECT_EQ(12u, particleSystem.numberOfParticles());
 }
 
+TEST(ParticleSystemData3, RemoveParticles) {
+    ParticleSystemData3 particleSystem;
+    size_t scalarIdx = particleSystem.addScalarData();
+    size_t vectorIdx = particleSystem.addVectorData();
+
+    // More particles than a compaction block
+    const size_t n = 10000;
+    particleSystem.resize(n);
+    auto positions = particleSystem.positions();
+    auto scalars = particleSystem.scalarDataAt(scalarIdx);
+    auto vectors = particleSystem.vectorDataAt(vectorIdx);
+    for (size_t i = 0; i < n; ++i) {
+        positions[i] = Vector3D(static_cast<double>(i), 0.0, 0.0);
+        scalars[i] = static_cast<double>(i);
+        vectors[i] = Vector3D(0.0, 0.0, static_cast<double>(i));
+    }
+    size_t capacity = particleSystem.capacity();
+
+    EXPECT_EQ(0u, particleSystem.removeParticles([](size_t) {
+        return false;
+    }));
+    EXPECT_EQ(n, particleSystem.numberOfParticles());
+
+    size_t removed = particleSystem.removeParticles([](size_t i) {
+        return i % 3 != 0;
+    });
+    EXPECT_EQ(n - 3334, removed);
+    EXPECT_EQ(3334u, particleSystem.numberOfParticles());
+    EXPECT_EQ(capacity, particleSystem.capacity());
+
+    positions = particleSystem.positions();
+    scalars = particleSystem.scalarDataAt(scalarIdx);
+    vectors = particleSystem.vectorDataAt(vectorIdx);
+    for (size_t i = 0; i < particleSystem.numberOfParticles(); ++i) {
+        EXPECT_EQ(static_cast<double>(3 * i), positions[i].x);
+        EXPECT_EQ(static_cast<double>(3 * i), scalars[i]);
+        EXPECT_EQ(static_cast<double>(3 * i), vectors[i].z);
+    }
+
+    particleSystem.removeParticles([](size_t) {
+        return true;
+    });
+    EXPECT_EQ(0u, particleSystem.numberOfParticles());
+}
+
+TEST(ParticleSystemData3, ConcurrentAppend) {
+    ParticleSystemData3 particleSystem;
+    size_t scalarIdx = particleSystem.addScalarData();
+    particleSystem.resize(5);
+
+    // Each of the workers appends the even numbers of its range, and the
+    // claims run out before all of them are appended
+    const size_t n = 10000;
+    const size_t maxNumberOfNewParticles = 4000;
+    particleSystem.beginAppend(maxNumberOfNewParticles);
+    auto positions = particleSystem.positions();
+    auto velocities = particleSystem.velocities();
+    auto scalars = particleSystem.scalarDataAt(scalarIdx);
+    parallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t index = 0;
+            if (i % 2 == 0
+                && particleSystem.claimAppendSlots(1, &index) == 1) {
+                positions[index] = Vector3D(static_cast<double>(i), 0, 0);
+                velocities[index] = Vector3D(0, 1, 0);
+                scalars[index] = static_cast<double>(i);
+            }
+        }
+    });
+    EXPECT_EQ(maxNumberOfNewParticles, particleSystem.endAppend());
+    EXPECT_EQ(5 + maxNumberOfNewParticles, particleSystem.numberOfParticles());
+
+    positions = particleSystem.positions();
+    velocities = particleSystem.velocities();
+    scalars = particleSystem.scalarDataAt(scalarIdx);
+    std::vector<size_t> values;
+    for (size_t i = 5; i < particleSystem.numberOfParticles(); ++i) {
+        EXPECT_EQ(scalars[i], positions[i].x);
+        EXPECT_EQ(Vector3D(0, 1, 0), velocities[i]);
+        values.push_back(static_cast<size_t>(positions[i].x));
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_TRUE(std::adjacent_find(values.begin(), values.end())
+        == values.end());
+    for (size_t value : values) {
+        EXPECT_EQ(0u, value % 2);
+    }
+
+    // A claim is cut to the remaining slots, and the unclaimed slots are
+    // dropped
+    particleSystem.beginAppend(10);
+    size_t first = 0;
+    EXPECT_EQ(7u, particleSystem.claimAppendSlots(7, &first));
+    EXPECT_EQ(5 + maxNumberOfNewParticles, first);
+    EXPECT_EQ(3u, particleSystem.claimAppendSlots(7, &first));
+    EXPECT_EQ(5 + maxNumberOfNewParticles + 7, first);
+    EXPECT_EQ(0u, particleSystem.claimAppendSlots(1, &first));
+    EXPECT_EQ(10u, particleSystem.endAppend());
+
+    particleSystem.beginAppend(10);
+    EXPECT_EQ(2u, particleSystem.claimAppendSlots(2, &first));
+    EXPECT_EQ(2u, particleSystem.endAppend());
+    EXPECT_EQ(
+        5 + maxNumberOfNewParticles + 12, particleSystem.numberOfParticles());
+}
+
 TEST(ParticleSystemData3, BuildNeighborSearcher) {
     ParticleSystemData3 particleSystem;
     ParticleSystemData3::VectorData positions = {
@@ -217,3 +379,277 @@ TEST(ParticleSystemData3, BuildNeighborLists) {
         }
     }
 }
+
+TEST(ParticleSystemData3, NeighborSearchSkin) {
+    ParticleSystemData3 particleSystem;
+    EXPECT_DOUBLE_EQ(0.0, particleSystem.neighborSearchSkin());
+    particleSystem.setNeighborSearchSkin(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, particleSystem.neighborSearchSkin());
+
+    ParticleSystemData3::VectorData positions;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            for (int k = 0; k < 8; ++k) {
+                positions.append(0.1 * Vector3D(i, j, k));
+            }
+        }
+    }
+    particleSystem.addParticles(positions);
+
+    const double radius = 0.15;
+    const double skin = 0.04;
+    particleSystem.setNeighborSearchSkin(skin);
+    EXPECT_DOUBLE_EQ(skin, particleSystem.neighborSearchSkin());
+
+    auto expectNeighbors = [&]() {
+        auto x = particleSystem.positions();
+        const auto& neighborLists = particleSystem.neighborLists();
+        ASSERT_EQ(x.size(), neighborLists.size());
+        for (size_t i = 0; i < x.size(); ++i) {
+            const auto& neighbors = neighborLists[i];
+            for (size_t j = 0; j < x.size(); ++j) {
+                if (j != i && x[i].distanceTo(x[j]) <= radius) {
+                    EXPECT_TRUE(
+                        neighbors.end()
+                        != std::find(neighbors.begin(), neighbors.end(), j));
+                }
+            }
+        }
+    };
+
+    particleSystem.buildNeighborSearcher(radius);
+    particleSystem.buildNeighborLists(radius);
+    auto searcher = particleSystem.neighborSearcher();
+    size_t numberOfNeighbors = particleSystem.neighborLists()[0].size();
+    expectNeighbors();
+
+    // Moves within half of the skin keep the searcher and the lists
+    auto x = particleSystem.positions();
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] += 0.01 * Vector3D((i % 3) - 1.0, (i % 5) * 0.5 - 1.0, 0.5);
+    }
+    particleSystem.buildNeighborSearcher(radius);
+    particleSystem.buildNeighborLists(radius);
+    EXPECT_EQ(searcher, particleSystem.neighborSearcher());
+    EXPECT_EQ(numberOfNeighbors, particleSystem.neighborLists()[0].size());
+    expectNeighbors();
+
+    size_t numberOfFound = 0;
+    particleSystem.neighborSearcher()->forEachNearbyPoint(
+        x[0],
+        radius,
+        [&](size_t j, const Vector3D& pt) {
+            EXPECT_EQ(x[j], pt);
+            ++numberOfFound;
+        });
+    size_t numberOfExpected = 0;
+    for (size_t j = 0; j < x.size(); ++j) {
+        if (x[0].distanceTo(x[j]) <= radius) {
+            ++numberOfExpected;
+        }
+    }
+    EXPECT_EQ(numberOfExpected, numberOfFound);
+
+    // Larger moves rebuild both
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] *= 0.5;
+    }
+    particleSystem.buildNeighborSearcher(radius);
+    particleSystem.buildNeighborLists(radius);
+    EXPECT_LT(numberOfNeighbors, particleSystem.neighborLists()[0].size());
+    expectNeighbors();
+}
+
+TEST(ParticleSystemData3, NeighborSearchSkinHashGrid) {
+    ParticleSystemData3 particleSystem;
+
+    // Sparse enough for the hash grid, with bounds that round up to the
+    // next power of two once they cross zero
+    ParticleSystemData3::VectorData positions;
+    for (int i = 0; i < 11; ++i) {
+        for (int j = 0; j < 11; ++j) {
+            for (int k = 0; k < 11; ++k) {
+                positions.append(0.51 * Vector3D(i, j, k));
+            }
+        }
+    }
+    particleSystem.addParticles(positions);
+    particleSystem.setNeighborSearchSkin(0.04);
+    particleSystem.buildNeighborSearcher(0.15);
+    auto searcher = particleSystem.neighborSearcher();
+    ASSERT_NE(
+        nullptr,
+        std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(searcher));
+
+    // Moves within half of the skin keep the searcher
+    auto x = particleSystem.positions();
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] -= Vector3D(0.01, 0.01, 0.01);
+    }
+    particleSystem.buildNeighborSearcher(0.15);
+    EXPECT_EQ(searcher, particleSystem.neighborSearcher());
+}
+
+TEST(ParticleSystemData3, SortParticles) {
+    ParticleSystemData3 particleSystem;
+    EXPECT_EQ(0u, particleSystem.sortedIndices().size());
+
+    Array1<Vector3D> positions = {
+        Vector3D(1.0, 1.0, 1.0),
+        Vector3D(0.0, 1.0, 0.0),
+        Vector3D(0.0, 0.0, 0.0),
+        Vector3D(1.0, 0.0, 0.0)
+    };
+    particleSystem.addParticles(
+        positions.constAccessor(), positions.constAccessor());
+
+    size_t scalarIdx = particleSystem.addScalarData();
+    size_t vectorIdx = particleSystem.addVectorData();
+    auto scalars = particleSystem.scalarDataAt(scalarIdx);
+    auto vectors = particleSystem.vectorDataAt(vectorIdx);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        scalars[i] = static_cast<double>(i);
+        vectors[i] = Vector3D(static_cast<double>(i), 0.0, 0.0);
+    }
+
+    particleSystem.sortParticles();
+
+    const std::vector<size_t> answer = {2, 3, 1, 0};
+    auto sortedIndices = particleSystem.sortedIndices();
+    ASSERT_EQ(answer.size(), sortedIndices.size());
+
+    scalars = particleSystem.scalarDataAt(scalarIdx);
+    vectors = particleSystem.vectorDataAt(vectorIdx);
+    for (size_t i = 0; i < answer.size(); ++i) {
+        EXPECT_EQ(answer[i], sortedIndices[i]);
+        EXPECT_EQ(positions[answer[i]], particleSystem.positions()[i]);
+        EXPECT_EQ(positions[answer[i]], particleSystem.velocities()[i]);
+        EXPECT_EQ(static_cast<double>(answer[i]), scalars[i]);
+        EXPECT_EQ(static_cast<double>(answer[i]), vectors[i].x);
+    }
+}
+
+TEST(ParticleSystemData3, SwapPositionsAndVelocities) {
+    ParticleSystemData3 particleSystem;
+    particleSystem.resize(3);
+    particleSystem.positions()[1] = Vector3D(1.0, 2.0, 3.0);
+
+    ParticleSystemData3::VectorData newPositions(3, Vector3D(4.0, 5.0, 6.0));
+    ParticleSystemData3::VectorData newVelocities(3, Vector3D(0.0, -1.0, 0.0));
+    particleSystem.swapPositionsAndVelocities(&newPositions, &newVelocities);
+
+    EXPECT_EQ(3u, particleSystem.numberOfParticles());
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(Vector3D(4.0, 5.0, 6.0), particleSystem.positions()[i]);
+        EXPECT_EQ(Vector3D(0.0, -1.0, 0.0), particleSystem.velocities()[i]);
+    }
+    EXPECT_EQ(Vector3D(1.0, 2.0, 3.0), newPositions[1]);
+    EXPECT_EQ(Vector3D(), newVelocities[1]);
+}
+
+TEST(ParticleSystemData3, LazyAllocation) {
+    ParticleSystemData3 particleSystem;
+    EXPECT_TRUE(particleSystem.isUsingLazyAllocation());
+    particleSystem.resize(100);
+    size_t memory = particleSystem.memoryInBytes();
+
+    // The layers take no memory until they are accessed
+    size_t scalarIdx = particleSystem.addScalarData(3.0);
+    size_t vectorIdx = particleSystem.addVectorData();
+    size_t zeroIdx = particleSystem.addScalarData();
+    EXPECT_EQ(memory, particleSystem.memoryInBytes());
+
+    // The pending layers give the same values as the allocated ones, where
+    // the new particles get zero
+    particleSystem.resize(150);
+    particleSystem.removeParticles([](size_t i) {
+        return i % 2 == 1;
+    });
+    particleSystem.sortParticles();
+    EXPECT_EQ(75u, particleSystem.numberOfParticles());
+
+    auto scalars = particleSystem.scalarDataAt(scalarIdx);
+    ASSERT_EQ(75u, scalars.size());
+    EXPECT_EQ(50, std::count(scalars.begin(), scalars.end(), 3.0));
+    EXPECT_EQ(25, std::count(scalars.begin(), scalars.end(), 0.0));
+    EXPECT_EQ(75u, particleSystem.vectorDataAt(vectorIdx).size());
+
+    memory = particleSystem.memoryInBytes();
+    EXPECT_EQ(0.0, particleSystem.scalarDataAt(zeroIdx)[74]);
+    EXPECT_EQ(memory + particleSystem.capacity() * sizeof(double),
+              particleSystem.memoryInBytes());
+
+    // A layer added without particles takes zero for the new particles
+    ParticleSystemData3 empty;
+    size_t idx = empty.addScalarData(5.0);
+    empty.addParticle(Vector3D());
+    EXPECT_EQ(0.0, empty.scalarDataAt(idx)[0]);
+
+    std::stringstream strm;
+    ParticleSystemData3 pending;
+    pending.resize(4);
+    pending.addVectorData(Vector3D(1.0, 2.0, 3.0));
+    pending.serialize(&strm);
+    ParticleSystemData3 restored;
+    restored.deserialize(&strm);
+    ASSERT_EQ(1u, restored.numberOfVectorData());
+    EXPECT_EQ(Vector3D(1.0, 2.0, 3.0), restored.vectorDataAt(0)[3]);
+
+    // The layers are allocated at once without the lazy allocation
+    ParticleSystemData3 eager;
+    eager.setIsUsingLazyAllocation(false);
+    EXPECT_FALSE(eager.isUsingLazyAllocation());
+    eager.resize(10);
+    memory = eager.memoryInBytes();
+    eager.addScalarData(1.0);
+    EXPECT_EQ(memory + eager.capacity() * sizeof(double),
+              eager.memoryInBytes());
+}
+
+TEST(ParticleSystemData3, Serialization) {
+    ParticleSystemData3 particleSystem;
+    particleSystem.setRadius(0.25);
+    particleSystem.setMass(2.0);
+
+    Array1<Vector3D> positions = {
+        Vector3D(1.0, 1.0, 1.0),
+        Vector3D(0.0, 1.0, 0.0),
+        Vector3D(0.0, 0.0, 0.0)
+    };
+    particleSystem.addParticles(
+        positions.constAccessor(), positions.constAccessor());
+    size_t scalarIdx = particleSystem.addScalarData(3.0);
+    size_t vectorIdx = particleSystem.addVectorData(Vector3D(4.0, 5.0, 6.0));
+    particleSystem.sortParticles();
+    particleSystem.setNeighborSearcher(
+        std::make_shared<PointParallelHashGridSearcher3>(8, 4, 2, 0.5));
+
+    std::stringstream strm;
+    particleSystem.serialize(&strm);
+
+    ParticleSystemData3 restored;
+    restored.deserialize(&strm);
+    EXPECT_EQ(0.25, restored.radius());
+    EXPECT_EQ(2.0, restored.mass());
+    ASSERT_EQ(3u, restored.numberOfParticles());
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(particleSystem.positions()[i], restored.positions()[i]);
+        EXPECT_EQ(particleSystem.velocities()[i], restored.velocities()[i]);
+        EXPECT_EQ(particleSystem.sortedIndices()[i],
+                  restored.sortedIndices()[i]);
+        EXPECT_EQ(3.0, restored.scalarDataAt(scalarIdx)[i]);
+        EXPECT_EQ(
+            Vector3D(4.0, 5.0, 6.0), restored.vectorDataAt(vectorIdx)[i]);
+    }
+
+    // The searcher is recreated with the same settings and already built
+    auto searcher = std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(
+        restored.neighborSearcher());
+    ASSERT_TRUE(searcher != nullptr);
+    EXPECT_EQ(Size3(8, 4, 2), searcher->resolution());
+    EXPECT_EQ(0.5, searcher->gridSpacing());
+    EXPECT_TRUE(searcher->hasNearbyPoint(Vector3D(0.0, 0.0, 0.1), 0.2));
+
+    std::stringstream badStrm("not a particle system");
+    EXPECT_THROW(restored.deserialize(&badStrm), std::invalid_argument);
+}
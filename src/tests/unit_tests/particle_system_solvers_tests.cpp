@@ -1,8 +1,13 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/constant_vector_field3.h>
+#include <jet/custom_vector_field3.h>
 #include <jet/particle_system_solver2.h>
 #include <jet/particle_system_solver3.h>
+#include <jet/plane3.h>
+#include <jet/rigid_body_collider3.h>
 #include <gtest/gtest.h>
+#include <atomic>
 
 using namespace jet;
 
@@ -118,3 +123,240 @@ TEST(ParticleSystemSolver3, Update) {
         EXPECT_DOUBLE_EQ(0.0, data->velocities()[i].z);
     }
 }
+
+TEST(ParticleSystemSolver3, BatchWind) {
+    auto windFunction = [](const Vector3D& x) {
+        return Vector3D(x.y, 0.0, -x.x);
+    };
+
+    std::atomic<size_t> numberOfCalls(0);
+    auto batchWind = std::make_shared<CustomVectorField3>(
+        [&](const ConstArrayAccessor1<Vector3D>& x,
+            ArrayAccessor1<Vector3D> result) {
+            ++numberOfCalls;
+            for (size_t i = 0; i < x.size(); ++i) {
+                result[i] = windFunction(x[i]);
+            }
+        });
+
+    ParticleSystemSolver3 solver0;
+    ParticleSystemSolver3 solver1;
+    solver0.setWind(std::make_shared<CustomVectorField3>(windFunction));
+    solver1.setWind(batchWind);
+    solver0.setDragCoefficient(0.5);
+    solver1.setDragCoefficient(0.5);
+
+    ParticleSystemData3::VectorData positions(1000);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = Vector3D(0.001 * i, 1.0 - 0.001 * i, 0.5);
+    }
+    solver0.particleSystemData()->addParticles(positions.accessor());
+    solver1.particleSystemData()->addParticles(positions.accessor());
+
+    Frame frame(1, 1.0 / 60.0);
+    solver0.update(frame);
+    solver1.update(frame);
+
+    // Sampled in blocks with the same result as the per-point field
+    EXPECT_LT(0u, numberOfCalls.load());
+    EXPECT_GT(positions.size() / 4, numberOfCalls.load());
+
+    auto data0 = solver0.particleSystemData();
+    auto data1 = solver1.particleSystemData();
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_EQ(data0->positions()[i], data1->positions()[i]);
+        EXPECT_EQ(data0->velocities()[i], data1->velocities()[i]);
+    }
+}
+
+TEST(ParticleSystemSolver3, ConstantWind) {
+    const Vector3D windValue(1.0, 0.5, -2.0);
+    ParticleSystemSolver3 solver0;
+    ParticleSystemSolver3 solver1;
+    ParticleSystemSolver3 solver2;
+    solver0.setWind(std::make_shared<CustomVectorField3>(
+        [&](const Vector3D&) {
+            return windValue;
+        }));
+    solver1.setWind(std::make_shared<ConstantVectorField3>(windValue));
+    solver2.setWind(std::make_shared<ConstantVectorField3>(windValue));
+    solver0.setDragCoefficient(0.5);
+    solver1.setDragCoefficient(0.5);
+    solver2.setDragCoefficient(0.5);
+    solver2.setIsUsingFusedStep(true);
+
+    ParticleSystemData3::VectorData positions(300);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = Vector3D(0.01 * i, 1.0, -0.02 * i);
+    }
+    for (auto* solver : { &solver0, &solver1, &solver2 }) {
+        solver->particleSystemData()->addParticles(positions.accessor());
+    }
+
+    Frame frame(1, 1.0 / 60.0);
+    solver0.update(frame);
+    solver1.update(frame);
+    solver2.update(frame);
+
+    // The constant wind skips the sampling with the same result
+    auto data0 = solver0.particleSystemData();
+    for (auto* solver : { &solver1, &solver2 }) {
+        auto data = solver->particleSystemData();
+        for (size_t i = 0; i < positions.size(); ++i) {
+            EXPECT_EQ(data0->positions()[i], data->positions()[i]);
+            EXPECT_EQ(data0->velocities()[i], data->velocities()[i]);
+        }
+    }
+    EXPECT_GT(data0->velocities()[0].x, 0.0);
+}
+
+TEST(ParticleSystemSolver3, FusedStep) {
+    ParticleSystemSolver3 solver;
+    ParticleSystemSolver3 fusedSolver;
+    fusedSolver.setIsUsingFusedStep(true);
+    EXPECT_TRUE(fusedSolver.isUsingFusedStep());
+    EXPECT_FALSE(solver.isUsingFusedStep());
+
+    auto wind = std::make_shared<CustomVectorField3>(
+        [](const Vector3D& x) {
+            return Vector3D(x.y, 0.0, -x.x);
+        });
+    auto collider = std::make_shared<RigidBodyCollider3>(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, 0.5, 0)));
+
+    for (ParticleSystemSolver3* s : { &solver, &fusedSolver }) {
+        s->setWind(wind);
+        s->setDragCoefficient(0.5);
+        s->setRestitutionCoefficient(0.5);
+        s->setCollider(collider);
+
+        ParticleSystemData3::VectorData positions(1000);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            positions[i] = Vector3D(0.001 * i, 1.0 - 0.0005 * i, 0.5);
+        }
+        s->particleSystemData()->addParticles(positions.accessor());
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 10; frame.advance()) {
+        solver.update(frame);
+        fusedSolver.update(frame);
+    }
+
+    // Same arithmetic in a single pass, including the collisions
+    auto data = solver.particleSystemData();
+    auto fusedData = fusedSolver.particleSystemData();
+    const double radius = fusedData->radius();
+    size_t numberOfCollisions = 0;
+    for (size_t i = 0; i < data->numberOfParticles(); ++i) {
+        EXPECT_EQ(data->positions()[i], fusedData->positions()[i]);
+        EXPECT_EQ(data->velocities()[i], fusedData->velocities()[i]);
+        EXPECT_GE(fusedData->positions()[i].y, 0.5);
+        if (fusedData->positions()[i].y < 0.5 + 2.0 * radius) {
+            ++numberOfCollisions;
+        }
+    }
+    EXPECT_LT(0u, numberOfCollisions);
+
+    // The forces are computed on the fly
+    EXPECT_NE(Vector3D(), data->forces()[0]);
+    EXPECT_EQ(Vector3D(), fusedData->forces()[0]);
+}
+
+TEST(ParticleSystemSolver3, Leapfrog) {
+    ParticleSystemSolver3 solver;
+    ParticleSystemSolver3 leapfrogSolver;
+    ParticleSystemSolver3 fusedLeapfrogSolver;
+    EXPECT_EQ(
+        ParticleSystemSolver3::TimeIntegrator::SemiImplicitEuler,
+        solver.timeIntegrator());
+    leapfrogSolver.setTimeIntegrator(
+        ParticleSystemSolver3::TimeIntegrator::Leapfrog);
+    EXPECT_EQ(
+        ParticleSystemSolver3::TimeIntegrator::Leapfrog,
+        leapfrogSolver.timeIntegrator());
+    fusedLeapfrogSolver.setTimeIntegrator(
+        ParticleSystemSolver3::TimeIntegrator::Leapfrog);
+    fusedLeapfrogSolver.setIsUsingFusedStep(true);
+
+    for (ParticleSystemSolver3* s
+         : { &solver, &leapfrogSolver, &fusedLeapfrogSolver }) {
+        s->setGravity(Vector3D(0, -10, 0));
+        s->setDragCoefficient(0.0);
+        s->particleSystemData()->addParticle(
+            Vector3D(), Vector3D(1.0, 2.0, 0.0));
+    }
+
+    for (Frame frame(0, 0.1); frame.index < 5; frame.advance()) {
+        solver.update(frame);
+        leapfrogSolver.update(frame);
+        fusedLeapfrogSolver.update(frame);
+    }
+
+    // The leapfrog is exact for a constant acceleration, and the Euler
+    // falls behind by the half of a step
+    const double t = 0.4;
+    Vector3D expected(t, 2.0 * t - 5.0 * t * t, 0.0);
+    Vector3D x = leapfrogSolver.particleSystemData()->positions()[0];
+    EXPECT_NEAR(expected.x, x.x, 1e-12);
+    EXPECT_NEAR(expected.y, x.y, 1e-12);
+    EXPECT_NEAR(2.0 - 10.0 * t,
+                leapfrogSolver.particleSystemData()->velocities()[0].y, 1e-12);
+    EXPECT_NEAR(
+        expected.y - 0.5 * 10.0 * 0.1 * t,
+        solver.particleSystemData()->positions()[0].y,
+        1e-12);
+
+    EXPECT_EQ(x, fusedLeapfrogSolver.particleSystemData()->positions()[0]);
+}
+
+TEST(ParticleSystemSolver3, SleepingParams) {
+    ParticleSystemSolver3 solver;
+    EXPECT_DOUBLE_EQ(0.0, solver.sleepingSpeedThreshold());
+    EXPECT_EQ(10u, solver.numberOfStepsToSleep());
+
+    solver.setSleepingSpeedThreshold(0.1);
+    EXPECT_DOUBLE_EQ(0.1, solver.sleepingSpeedThreshold());
+
+    solver.setSleepingSpeedThreshold(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, solver.sleepingSpeedThreshold());
+
+    solver.setNumberOfStepsToSleep(3);
+    EXPECT_EQ(3u, solver.numberOfStepsToSleep());
+}
+
+TEST(ParticleSystemSolver3, SleepingParticles) {
+    ParticleSystemSolver3 solver;
+    solver.setGravity(Vector3D());
+    solver.setDragCoefficient(0.0);
+    solver.setSleepingSpeedThreshold(1e-3);
+    solver.setNumberOfStepsToSleep(5);
+
+    ParticleSystemData3Ptr data = solver.particleSystemData();
+    for (size_t i = 0; i < 10; ++i) {
+        data->addParticle(Vector3D(static_cast<double>(i), 0.0, 0.0));
+    }
+    data->addParticle(Vector3D(0.0, 5.0, 0.0), Vector3D(0.0, 1.0, 0.0));
+    EXPECT_EQ(11u, solver.numberOfActiveParticles());
+
+    Frame frame(0, 1.0 / 60.0);
+    for ( ; frame.index < 20; frame.advance()) {
+        solver.update(frame);
+    }
+
+    // Only the moving particle stays awake
+    EXPECT_EQ(1u, solver.numberOfActiveParticles());
+    for (size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(Vector3D(static_cast<double>(i), 0.0, 0.0),
+                  data->positions()[i]);
+    }
+    EXPECT_GT(data->positions()[10].y, 5.0);
+
+    // Waking everything up by disabling the sleeping
+    solver.setSleepingSpeedThreshold(0.0);
+    solver.setGravity(Vector3D(0, -10, 0));
+    solver.update(frame);
+    EXPECT_EQ(11u, solver.numberOfActiveParticles());
+    for (size_t i = 0; i < 10; ++i) {
+        EXPECT_LT(data->positions()[i].y, 0.0);
+    }
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array1.h>
+#include <jet/particles_to_sdf3.h>
+#include <jet/sph_system_data3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+using namespace jet;
+
+namespace {
+
+// Evaluates the field at a single point using a grid whose first node is the
+// given point.
+double evaluateAt(
+    const ParticlesToSdf3& converter,
+    const Array1<Vector3D>& points,
+    const Vector3D& position) {
+    VertexCenteredScalarGrid3 sdf(
+        Size3(1, 1, 1), Vector3D(1e-3, 1e-3, 1e-3), position);
+    converter.convert(points.constAccessor(), &sdf);
+    return sdf(0, 0, 0);
+}
+
+}  // namespace
+
+TEST(ParticlesToSdf3, Parameters) {
+    ParticlesToSdf3 converter(0.2);
+    EXPECT_DOUBLE_EQ(0.2, converter.kernelRadius());
+    EXPECT_DOUBLE_EQ(0.5, converter.cutOffDensity());
+    EXPECT_TRUE(converter.isUsingAnisotropicKernels());
+    EXPECT_EQ(15u, converter.minNumberOfNeighbors());
+    EXPECT_DOUBLE_EQ(4.0, converter.maxAnisotropyRatio());
+    EXPECT_DOUBLE_EQ(0.9, converter.positionSmoothingFactor());
+
+    converter.setMaxAnisotropyRatio(0.5);
+    EXPECT_DOUBLE_EQ(1.0, converter.maxAnisotropyRatio());
+    converter.setPositionSmoothingFactor(1.5);
+    EXPECT_DOUBLE_EQ(1.0, converter.positionSmoothingFactor());
+    converter.setPositionSmoothingFactor(-1.0);
+    EXPECT_DOUBLE_EQ(0.0, converter.positionSmoothingFactor());
+
+    EXPECT_THROW(converter.setKernelRadius(0.0), std::invalid_argument);
+}
+
+TEST(ParticlesToSdf3, SingleParticle) {
+    Array1<Vector3D> points(1, Vector3D(0.5, 0.5, 0.5));
+
+    // The particle covers a single 8^3 tile, and the other nodes are the
+    // cut-off density
+    VertexCenteredScalarGrid3 sdf(
+        Size3(40, 40, 40), Vector3D(0.025, 0.025, 0.025), Vector3D());
+    ParticlesToSdf3 converter(0.1);
+    converter.convert(points.constAccessor(), &sdf);
+
+    EXPECT_NEAR(-0.5, sdf(20, 20, 20), 1e-12);
+    EXPECT_LT(sdf(21, 20, 20), 0.5);
+    EXPECT_DOUBLE_EQ(0.5, sdf(24, 20, 20));
+    EXPECT_DOUBLE_EQ(0.5, sdf(0, 0, 0));
+    EXPECT_DOUBLE_EQ(0.5, sdf(40, 40, 40));
+
+    Array1<Vector3D> emptyPoints;
+    converter.convert(emptyPoints.constAccessor(), &sdf);
+    sdf.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(0.5, sdf(i, j, k));
+    });
+}
+
+TEST(ParticlesToSdf3, IsotropicMatchesSphInterpolation) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> position(0.3, 0.7);
+    Array1<Vector3D> points(500);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(position(rng), position(rng), position(rng));
+    }
+
+    const double kernelRadius = 0.1;
+    SphSystemData3 sphParticles;
+    sphParticles.addParticles(points.constAccessor());
+    sphParticles.setRelativeKernelRadius(2.0);
+    sphParticles.setTargetSpacing(kernelRadius / 2.0);
+    sphParticles.buildNeighborSearcher();
+    sphParticles.buildNeighborLists();
+    sphParticles.updateDensities();
+    Array1<double> constData(points.size(), 1.0);
+
+    VertexCenteredScalarGrid3 sdf(
+        Size3(20, 20, 20), Vector3D(0.05, 0.05, 0.05), Vector3D());
+    ParticlesToSdf3 converter(kernelRadius);
+    converter.setIsUsingAnisotropicKernels(false);
+    converter.convert(points.constAccessor(), &sdf);
+
+    sdf.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt(0.05 * i, 0.05 * j, 0.05 * k);
+        double expected = 0.5 - sphParticles.interpolate(pt, constData);
+        EXPECT_NEAR(expected, sdf(i, j, k), 1e-9);
+    });
+}
+
+TEST(ParticlesToSdf3, AnisotropicSheet) {
+    // A single layer of particles on a tilted plane
+    const double kernelRadius = 0.1;
+    const double spacing = 0.4 * kernelRadius;
+    const Vector3D center(0.5, 0.5, 0.5);
+    const Vector3D tangent1 = Vector3D(1, -1, 0).normalized();
+    const Vector3D tangent2 = Vector3D(1, 1, -2).normalized();
+    const Vector3D normal = Vector3D(1, 1, 1).normalized();
+
+    Array1<Vector3D> points;
+    for (double v = -10.0; v <= 10.0; v += 1.0) {
+        for (double u = -10.0; u <= 10.0; u += 1.0) {
+            points.append(
+                center + spacing * (u * tangent1 + v * tangent2));
+        }
+    }
+
+    ParticlesToSdf3 isotropic(kernelRadius);
+    isotropic.setIsUsingAnisotropicKernels(false);
+    ParticlesToSdf3 anisotropic(kernelRadius);
+
+    EXPECT_LT(evaluateAt(isotropic, points, center), 0.5);
+    EXPECT_LT(evaluateAt(anisotropic, points, center), 0.0);
+
+    // The flattened kernels are thinner than half of the kernel radius along
+    // the normal, while the isotropic ones still reach there
+    Vector3D above = center + 0.5 * kernelRadius * normal;
+    EXPECT_LT(evaluateAt(isotropic, points, above), 0.5);
+    EXPECT_DOUBLE_EQ(0.5, evaluateAt(anisotropic, points, above));
+
+    // And the surface is smoother between the particles
+    Vector3D between = center + 0.5 * spacing * (tangent1 + tangent2);
+    double anisotropicVariation = std::fabs(
+        evaluateAt(anisotropic, points, center)
+        - evaluateAt(anisotropic, points, between));
+    double isotropicVariation = std::fabs(
+        evaluateAt(isotropic, points, center)
+        - evaluateAt(isotropic, points, between));
+    EXPECT_LT(anisotropicVariation, isotropicVariation);
+}
@@ -1,7 +1,11 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/pci_sph_solver3.h>
+#include <jet/plane3.h>
+#include <jet/rigid_body_collider3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
 
 using namespace jet;
 
@@ -25,3 +29,230 @@ TEST(PciSphSolver3, Parameters) {
     solver.setMaxNumberOfIterations(10);
     EXPECT_DOUBLE_EQ(10, solver.maxNumberOfIterations());
 }
+
+TEST(PciSphSolver3, Checkpoint) {
+    PciSphSolver3 solver;
+    solver.setMaxDensityErrorRatio(0.05);
+    solver.setMaxNumberOfIterations(3);
+    solver.sphSystemData()->addParticle(Vector3D(1.0, 2.0, 3.0));
+
+    Frame frame(1, 1.0 / 60.0);
+    solver.update(frame);
+
+    std::stringstream strm;
+    solver.serialize(&strm);
+
+    PciSphSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_DOUBLE_EQ(0.05, restored.maxDensityErrorRatio());
+    EXPECT_EQ(3u, restored.maxNumberOfIterations());
+    EXPECT_EQ(1u, restored.currentFrame().index);
+    ASSERT_EQ(1u, restored.sphSystemData()->numberOfParticles());
+    EXPECT_EQ(
+        solver.sphSystemData()->positions()[0],
+        restored.sphSystemData()->positions()[0]);
+
+    // The PCISPH section is missing from a plain SPH checkpoint
+    SphSolver3 sphSolver;
+    std::stringstream sphStrm;
+    sphSolver.serialize(&sphStrm);
+    EXPECT_THROW(restored.deserialize(&sphStrm), std::invalid_argument);
+}
+
+TEST(PciSphSolver3, SymmetricPairForces) {
+    PciSphSolver3 solver;
+    PciSphSolver3 symmetricSolver;
+    symmetricSolver.setIsUsingSymmetricPairForces(true);
+    EXPECT_TRUE(symmetricSolver.isUsingSymmetricPairForces());
+    EXPECT_FALSE(solver.isUsingSymmetricPairForces());
+
+    for (PciSphSolver3* s : { &solver, &symmetricSolver }) {
+        s->setViscosityCoefficient(0.1);
+        SphSystemData3Ptr particles = s->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 12; ++i) {
+            for (int j = 0; j < 6; ++j) {
+                for (int k = 0; k < 4; ++k) {
+                    particles->addParticle(
+                        0.9 * targetSpacing * Vector3D(i, j, k),
+                        Vector3D(0.1 * j, -0.2 * k, 0.05 * i));
+                }
+            }
+        }
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 3; frame.advance()) {
+        solver.update(frame);
+        symmetricSolver.update(frame);
+    }
+
+    auto positions = solver.sphSystemData()->positions();
+    auto symmetricPositions = symmetricSolver.sphSystemData()->positions();
+    auto velocities = solver.sphSystemData()->velocities();
+    auto symmetricVelocities = symmetricSolver.sphSystemData()->velocities();
+    ASSERT_EQ(positions.size(), symmetricPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_NEAR(
+            0.0, positions[i].distanceTo(symmetricPositions[i]), 1e-9);
+        EXPECT_NEAR(
+            0.0, velocities[i].distanceTo(symmetricVelocities[i]), 1e-7);
+    }
+}
+
+TEST(PciSphSolver3, Statistics) {
+    PciSphSolver3 solver;
+    solver.setMaxNumberOfIterations(3);
+
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    const double targetSpacing = particles->targetSpacing();
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                particles->addParticle(targetSpacing * Vector3D(i, j, k));
+            }
+        }
+    }
+
+    Frame frame(1, 1.0 / 60.0);
+    solver.update(frame);
+
+    const FrameStatistics& stats = solver.lastFrameStatistics();
+    EXPECT_EQ(1u, stats.frameIndex);
+    ASSERT_FALSE(stats.subTimeSteps.empty());
+
+    double totalTime = 0.0;
+    for (const auto& subStats : stats.subTimeSteps) {
+        totalTime += subStats.timeIntervalInSeconds;
+        EXPECT_EQ(64u, subStats.numberOfParticles);
+        EXPECT_GT(subStats.numberOfNeighbors, 0u);
+        EXPECT_GT(subStats.numberOfPressureIterations, 0u);
+        EXPECT_LE(subStats.numberOfPressureIterations, 3u);
+        EXPECT_GE(subStats.memoryInBytes, particles->memoryInBytes());
+    }
+    EXPECT_NEAR(1.0 / 60.0, totalTime, 1e-12);
+
+    const auto& last = stats.subTimeSteps.back();
+    EXPECT_EQ(solver.lastNumberOfIterations(), last.numberOfPressureIterations);
+    EXPECT_DOUBLE_EQ(solver.lastDensityErrorRatio(), last.pressureResidual);
+}
+
+TEST(PciSphSolver3, PressureWarmStart) {
+    PciSphSolver3 solver;
+    PciSphSolver3 previousSolver;
+    PciSphSolver3 extrapolatedSolver;
+    EXPECT_EQ(
+        PciSphSolver3::PressureWarmStart::None, solver.pressureWarmStart());
+    previousSolver.setPressureWarmStart(
+        PciSphSolver3::PressureWarmStart::Previous);
+    extrapolatedSolver.setPressureWarmStart(
+        PciSphSolver3::PressureWarmStart::Extrapolated);
+
+    // A column of fluid resting on the floor
+    auto floor = std::make_shared<RigidBodyCollider3>(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D()));
+
+    unsigned int numberOfIterations[3] = { 0, 0, 0 };
+    PciSphSolver3* solvers[3]
+        = { &solver, &previousSolver, &extrapolatedSolver };
+    for (size_t s = 0; s < 3; ++s) {
+        solvers[s]->setCollider(floor);
+        solvers[s]->setMaxDensityErrorRatio(0.01);
+        solvers[s]->setMaxNumberOfIterations(20);
+        SphSystemData3Ptr particles = solvers[s]->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                for (int k = 0; k < 8; ++k) {
+                    particles->addParticle(
+                        targetSpacing * Vector3D(i, j + 0.5, k));
+                }
+            }
+        }
+
+        for (Frame frame(0, 1.0 / 60.0); frame.index < 30; frame.advance()) {
+            solvers[s]->update(frame);
+            for (const auto& subStats
+                 : solvers[s]->lastFrameStatistics().subTimeSteps) {
+                numberOfIterations[s] += subStats.numberOfPressureIterations;
+            }
+        }
+    }
+
+    EXPECT_LT(numberOfIterations[1], numberOfIterations[0]);
+    EXPECT_LT(numberOfIterations[2], numberOfIterations[0]);
+    const size_t numberOfScalarData
+        = solver.sphSystemData()->numberOfScalarData();
+    EXPECT_EQ(
+        numberOfScalarData,
+        previousSolver.sphSystemData()->numberOfScalarData());
+    EXPECT_EQ(
+        numberOfScalarData + 1,
+        extrapolatedSolver.sphSystemData()->numberOfScalarData());
+
+    // The previous pressures are restored with the particles
+    std::stringstream strm;
+    extrapolatedSolver.serialize(&strm);
+    PciSphSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_EQ(
+        PciSphSolver3::PressureWarmStart::Extrapolated,
+        restored.pressureWarmStart());
+    Frame frame(30, 1.0 / 60.0);
+    restored.update(frame);
+    EXPECT_EQ(
+        numberOfScalarData + 1,
+        restored.sphSystemData()->numberOfScalarData());
+}
+
+TEST(PciSphSolver3, ActiveSet) {
+    PciSphSolver3 solver;
+    PciSphSolver3 activeSolver;
+    EXPECT_FALSE(solver.isUsingActiveSet());
+    activeSolver.setIsUsingActiveSet(true);
+    EXPECT_TRUE(activeSolver.isUsingActiveSet());
+
+    // A column of fluid resting on the floor
+    auto floor = std::make_shared<RigidBodyCollider3>(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D()));
+
+    size_t numberOfUpdates[2] = { 0, 0 };
+    PciSphSolver3* solvers[2] = { &solver, &activeSolver };
+    for (size_t s = 0; s < 2; ++s) {
+        solvers[s]->setCollider(floor);
+        solvers[s]->setMaxDensityErrorRatio(0.01);
+        solvers[s]->setMaxNumberOfIterations(20);
+        SphSystemData3Ptr particles = solvers[s]->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                for (int k = 0; k < 8; ++k) {
+                    particles->addParticle(
+                        targetSpacing * Vector3D(i, j + 0.5, k));
+                }
+            }
+        }
+
+        for (Frame frame(0, 1.0 / 60.0); frame.index < 30; frame.advance()) {
+            solvers[s]->update(frame);
+            numberOfUpdates[s] += solvers[s]->lastNumberOfParticleUpdates();
+        }
+    }
+
+    // The converged particles are skipped, and the column stays as tall
+    EXPECT_LT(numberOfUpdates[1], numberOfUpdates[0]);
+    auto x = solver.sphSystemData()->positions();
+    auto activeX = activeSolver.sphSystemData()->positions();
+    double maxY = 0.0;
+    double activeMaxY = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        maxY = std::max(maxY, x[i].y);
+        activeMaxY = std::max(activeMaxY, activeX[i].y);
+    }
+    EXPECT_NEAR(maxY, activeMaxY, 0.1 * maxY);
+
+    std::stringstream strm;
+    activeSolver.serialize(&strm);
+    PciSphSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_TRUE(restored.isUsingActiveSet());
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/philox_rng.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(PhiloxRng, KnownAnswers) {
+    // Known answers of Philox4x32-10 from the Random123 library
+    PhiloxRng rng0(0);
+    PhiloxRng::Block block = rng0(0, 0);
+    EXPECT_EQ(0x6627e8d5u, block[0]);
+    EXPECT_EQ(0xe169c58du, block[1]);
+    EXPECT_EQ(0xbc57ac4cu, block[2]);
+    EXPECT_EQ(0x9b00dbd8u, block[3]);
+
+    PhiloxRng rng1(0xffffffffffffffffull);
+    block = rng1(0xffffffffffffffffull, 0xffffffffffffffffull);
+    EXPECT_EQ(0x408f276du, block[0]);
+    EXPECT_EQ(0x41c83b0eu, block[1]);
+    EXPECT_EQ(0xa20bc7c6u, block[2]);
+    EXPECT_EQ(0x6d5451fdu, block[3]);
+
+    PhiloxRng rng2(0x299f31d0a4093822ull);
+    block = rng2(0x85a308d3243f6a88ull, 0x0370734413198a2eull);
+    EXPECT_EQ(0xd16cfe09u, block[0]);
+    EXPECT_EQ(0x94fdccebu, block[1]);
+    EXPECT_EQ(0x5001e420u, block[2]);
+    EXPECT_EQ(0x24126ea1u, block[3]);
+}
+
+TEST(PhiloxRng, Uniform2) {
+    PhiloxRng rng(42);
+    EXPECT_EQ(42u, rng.seed());
+
+    double sum = 0.0;
+    const size_t n = 100000;
+    for (size_t i = 0; i < n; ++i) {
+        std::array<double, 2> u = rng.uniform2(i);
+        EXPECT_LE(0.0, u[0]);
+        EXPECT_GT(1.0, u[0]);
+        EXPECT_LE(0.0, u[1]);
+        EXPECT_GT(1.0, u[1]);
+        sum += u[0] + u[1];
+    }
+    EXPECT_NEAR(0.5, sum / (2 * n), 0.01);
+
+    // Same counter gives the same numbers, and other streams differ
+    std::array<double, 2> u = rng.uniform2(7, 1);
+    EXPECT_EQ(u, rng.uniform2(7, 1));
+    EXPECT_NE(u, rng.uniform2(7, 2));
+    EXPECT_NE(u, PhiloxRng(43).uniform2(7, 1));
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/grid_smoke_solver3.h>
+#include <jet/parallel.h>
+#include <jet/physics_animation_ensemble.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Integrates dx/dt = input, and checks that its sub-steps run serially
+class IntegratingAnimation : public PhysicsAnimation {
+ public:
+    double input = 0.0;
+    double x = 0.0;
+    unsigned int numberOfSteps = 0;
+    bool isSerial = true;
+    bool shouldThrow = false;
+
+ protected:
+    void onAdvanceTimeStep(double timeIntervalInSeconds) override {
+        if (shouldThrow) {
+            throw std::runtime_error("step failed");
+        }
+        x += input * timeIntervalInSeconds;
+        ++numberOfSteps;
+        isSerial &= isSerialExecutionScope();
+    }
+};
+
+std::shared_ptr<GridSmokeSolver3> makeSmokeSolver(double radius) {
+    const size_t n = 16;
+    const double h = 1.0 / n;
+
+    auto solver = std::make_shared<GridSmokeSolver3>();
+    solver->resizeGrid(Size3(n, n, n), Vector3D(h, h, h), Vector3D());
+    Vector3D center(0.5, 0.3, 0.5);
+    solver->smokeDensity()->fill([&](const Vector3D& pt) {
+        return (pt.distanceTo(center) < radius) ? 1.0 : 0.0;
+    });
+    solver->temperature()->fill([&](const Vector3D& pt) {
+        return (pt.distanceTo(center) < radius) ? 1.0 : 0.0;
+    });
+    return solver;
+}
+
+}  // namespace
+
+TEST(PhysicsAnimationEnsemble, Update) {
+    PhysicsAnimationEnsemble ensemble;
+    EXPECT_EQ(0u, ensemble.numberOfAnimations());
+    ensemble.update(Frame(1, 0.1));
+
+    std::vector<std::shared_ptr<IntegratingAnimation>> animations;
+    for (size_t i = 0; i < 20; ++i) {
+        auto animation = std::make_shared<IntegratingAnimation>();
+        animation->input = static_cast<double>(i);
+        animation->setNumberOfFixedSubTimeSteps(
+            static_cast<unsigned int>(i % 3 + 1));
+        ensemble.addAnimation(animation);
+        animations.push_back(animation);
+    }
+    EXPECT_EQ(20u, ensemble.numberOfAnimations());
+    EXPECT_EQ(animations[3], ensemble.animation(3));
+
+    ensemble.update(Frame(2, 0.1));
+    for (size_t i = 0; i < animations.size(); ++i) {
+        EXPECT_EQ(2u, animations[i]->currentFrame().index);
+        EXPECT_EQ(2 * (i % 3 + 1), animations[i]->numberOfSteps);
+        EXPECT_NEAR(0.2 * i, animations[i]->x, 1e-12);
+        EXPECT_TRUE(animations[i]->isSerial);
+    }
+    EXPECT_FALSE(isSerialExecutionScope());
+}
+
+TEST(PhysicsAnimationEnsemble, Exception) {
+    PhysicsAnimationEnsemble ensemble;
+    std::vector<std::shared_ptr<IntegratingAnimation>> animations;
+    for (size_t i = 0; i < 8; ++i) {
+        auto animation = std::make_shared<IntegratingAnimation>();
+        animation->shouldThrow = (i == 5);
+        ensemble.addAnimation(animation);
+        animations.push_back(animation);
+    }
+
+    // The other animations still finish
+    EXPECT_THROW(ensemble.update(Frame(3, 0.1)), std::runtime_error);
+    for (size_t i = 0; i < animations.size(); ++i) {
+        EXPECT_EQ((i == 5) ? 0u : 3u, animations[i]->numberOfSteps);
+    }
+}
+
+TEST(PhysicsAnimationEnsemble, SmokeSolvers) {
+    // The ensemble gives the same results as the solvers run one by one
+    std::vector<std::shared_ptr<GridSmokeSolver3>> expected;
+    PhysicsAnimationEnsemble ensemble;
+    for (size_t i = 0; i < 4; ++i) {
+        double radius = 0.1 + 0.05 * i;
+        expected.push_back(makeSmokeSolver(radius));
+        ensemble.addAnimation(makeSmokeSolver(radius));
+    }
+
+    for (const auto& solver : expected) {
+        SerialExecutionScope scope;
+        solver->update(Frame(2, 1.0 / 60.0));
+    }
+    ensemble.update(Frame(2, 1.0 / 60.0));
+
+    for (size_t n = 0; n < expected.size(); ++n) {
+        auto solver = std::static_pointer_cast<GridSmokeSolver3>(
+            ensemble.animation(n));
+        auto den = solver->smokeDensity();
+        auto expectedDen = expected[n]->smokeDensity();
+        den->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_EQ((*expectedDen)(i, j, k), (*den)(i, j, k));
+        });
+    }
+}
@@ -1,10 +1,27 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array3.h>
+#include <jet/array_samplers3.h>
 #include <jet/pic_solver3.h>
+#include <jet/plane3.h>
+#include <jet/rigid_body_collider3.h>
 #include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
 
 using namespace jet;
 
+namespace {
+
+class TestPicSolver3 : public PicSolver3 {
+ public:
+    using PicSolver3::transferFromParticlesToGrids;
+    using PicSolver3::transferFromGridsToParticles;
+    using PicSolver3::moveParticles;
+};
+
+}  // namespace
+
 TEST(PicSolver3, UpdateEmpty) {
     // Empty solver test
     PicSolver3 solver;
@@ -12,3 +29,257 @@ TEST(PicSolver3, UpdateEmpty) {
     solver.update(frame);
     solver.update(frame);
 }
+
+TEST(PicSolver3, Checkpoint) {
+    PicSolver3 solver;
+    solver.setViscosityCoefficient(0.01);
+    solver.resizeGrid(
+        Size3(8, 8, 8), Vector3D(0.125, 0.125, 0.125), Vector3D());
+
+    auto particles = solver.particleSystemData();
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                particles->addParticle(
+                    Vector3D(0.1 + 0.1 * i, 0.1 + 0.1 * j, 0.1 + 0.1 * k),
+                    Vector3D(0.0, 0.0, 0.5));
+            }
+        }
+    }
+
+    Frame frame(1, 1.0 / 60.0);
+    for ( ; frame.index < 3; frame.advance()) {
+        solver.update(frame);
+    }
+
+    std::stringstream strm;
+    solver.serialize(&strm);
+
+    PicSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_EQ(solver.gridResolution(), restored.gridResolution());
+    EXPECT_DOUBLE_EQ(0.01, restored.viscosityCoefficient());
+
+    Frame restartFrame = frame;
+    for ( ; frame.index < 5; frame.advance()) {
+        solver.update(frame);
+    }
+    for ( ; restartFrame.index < 5; restartFrame.advance()) {
+        restored.update(restartFrame);
+    }
+
+    auto positions = particles->positions();
+    auto restoredPositions = restored.particleSystemData()->positions();
+    ASSERT_EQ(positions.size(), restoredPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_NEAR(0.0, positions[i].distanceTo(restoredPositions[i]), 1e-9);
+    }
+
+    // A grid-only checkpoint has no particle section
+    GridFluidSolver3 gridSolver;
+    std::stringstream gridStrm;
+    gridSolver.serialize(&gridStrm);
+    EXPECT_THROW(restored.deserialize(&gridStrm), std::invalid_argument);
+}
+
+TEST(PicSolver3, TransferAndMoveParticles) {
+    TestPicSolver3 solver;
+    solver.resizeGrid(Size3(6, 5, 4), Vector3D(0.2, 0.2, 0.25), Vector3D());
+
+    auto flow = solver.gridSystemData()->velocity();
+    flow->fill([](const Vector3D& pt) {
+        return Vector3D(
+            std::sin(3.0 * pt.y), pt.x * pt.z, -0.5 - std::cos(2.0 * pt.x));
+    });
+
+    // Including the particles outside of the grid, which clamp the weights
+    auto particles = solver.particleSystemData();
+    for (int i = 0; i < 200; ++i) {
+        particles->addParticle(Vector3D(
+            std::fmod(0.37 * i, 1.4) - 0.1,
+            std::fmod(0.53 * i, 1.2) - 0.1,
+            std::fmod(0.71 * i, 1.2) - 0.1));
+    }
+
+    solver.transferFromGridsToParticles();
+
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        Vector3D expected = flow->sample(positions[i]);
+        EXPECT_DOUBLE_EQ(expected.x, velocities[i].x);
+        EXPECT_DOUBLE_EQ(expected.y, velocities[i].y);
+        EXPECT_DOUBLE_EQ(expected.z, velocities[i].z);
+    }
+
+    // The flow goes downward into the floor collider
+    auto plane = std::make_shared<Plane3>(
+        Vector3D(0, 0, 1), Vector3D(0, 0, 0.3));
+    solver.setCollider(std::make_shared<RigidBodyCollider3>(plane));
+    solver.moveParticles(0.5);
+
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        EXPECT_LE(0.3 - 1e-9, positions[i].z);
+    }
+}
+
+TEST(PicSolver3, TransferWithParticleStencils) {
+    TestPicSolver3 solver;
+    solver.resizeGrid(Size3(5, 6, 4), Vector3D(0.2, 0.2, 0.25), Vector3D());
+
+    auto particles = solver.particleSystemData();
+    for (int i = 0; i < 100; ++i) {
+        double t = i / 100.0;
+        particles->addParticle(
+            Vector3D(1.1 * t - 0.05, 1.2 * t * t, 1.0 - 0.9 * t),
+            Vector3D(t, -t, 0.5));
+    }
+
+    // The transfer back to the particles reuses the stencils of the splat,
+    // and samples the changed grid as if they were computed again
+    solver.transferFromParticlesToGrids();
+    auto flow = solver.gridSystemData()->velocity();
+    flow->fill([](const Vector3D& pt) {
+        return Vector3D(pt.x * pt.y, std::cos(pt.z), pt.x - pt.y);
+    });
+    solver.transferFromGridsToParticles();
+
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        Vector3D expected = flow->sample(positions[i]);
+        EXPECT_DOUBLE_EQ(expected.x, velocities[i].x);
+        EXPECT_DOUBLE_EQ(expected.y, velocities[i].y);
+        EXPECT_DOUBLE_EQ(expected.z, velocities[i].z);
+    }
+}
+
+TEST(PicSolver3, SharedParticleBins) {
+    TestPicSolver3 solver;
+    solver.resizeGrid(
+        Size3(7, 6, 9), Vector3D(0.2, 0.2, 0.125), Vector3D(-0.1, 0.0, 0.1));
+
+    // Including the particles outside of the grid, which are binned to the
+    // boundary cells
+    auto particles = solver.particleSystemData();
+    for (int i = 0; i < 500; ++i) {
+        particles->addParticle(
+            Vector3D(
+                std::fmod(0.37 * i, 1.6) - 0.2,
+                std::fmod(0.53 * i, 1.4) - 0.1,
+                std::fmod(0.71 * i, 1.4) + 0.0),
+            Vector3D(std::sin(0.1 * i), 0.01 * i, std::cos(0.3 * i)));
+    }
+    auto positions = particles->positions();
+    auto velocities = particles->velocities();
+
+    // The splat over the k-slices of the bins matches a serial one
+    solver.transferFromParticlesToGrids();
+    auto flow = solver.gridSystemData()->velocity();
+    Vector3D h = flow->gridSpacing();
+    LinearArraySampler3<double, double> wSampler(
+        flow->wConstAccessor(), h, flow->wOrigin());
+    Array3<double> sums(flow->wSize(), 0.0);
+    Array3<double> weightSums(flow->wSize(), 0.0);
+    for (size_t p = 0; p < particles->numberOfParticles(); ++p) {
+        std::array<Point3UI, 8> indices;
+        std::array<double, 8> weights;
+        wSampler.getCoordinatesAndWeights(positions[p], &indices, &weights);
+        for (int n = 0; n < 8; ++n) {
+            sums(indices[n]) += velocities[p].z * weights[n];
+            weightSums(indices[n]) += weights[n];
+        }
+    }
+    auto w = flow->wConstAccessor();
+    sums.forEachIndex([&](size_t i, size_t j, size_t k) {
+        double expected = weightSums(i, j, k) > 0.0
+            ? sums(i, j, k) / weightSums(i, j, k) : 0.0;
+        EXPECT_NEAR(expected, w(i, j, k), 1e-12);
+    });
+
+    // The distances to the particles in the cells around each point match
+    // the ones to all particles within the band. The particles stand still.
+    solver.setGravity(Vector3D());
+    Array1<Vector3D> oldPositions(particles->numberOfParticles());
+    for (size_t p = 0; p < particles->numberOfParticles(); ++p) {
+        velocities[p] = Vector3D();
+        oldPositions[p] = positions[p];
+    }
+    solver.update(Frame(1, 1.0 / 60.0));
+    auto sdf = solver.signedDistanceField();
+    auto sdfPos = sdf->dataPosition();
+    double radius = 1.2 * 0.2 / std::sqrt(2.0);
+    sdf->forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D pt = sdfPos(i, j, k);
+        double minDist = 2.0 * radius;
+        for (size_t p = 0; p < particles->numberOfParticles(); ++p) {
+            minDist = std::min(minDist, pt.distanceTo(oldPositions[p]));
+        }
+        EXPECT_NEAR(minDist - radius, (*sdf)(i, j, k), 1e-12);
+    });
+}
+
+TEST(PicSolver3, ReseedParticles) {
+    PicSolver3 solver;
+    EXPECT_EQ(0u, solver.minNumberOfParticlesPerCell());
+    EXPECT_EQ(kMaxSize, solver.maxNumberOfParticlesPerCell());
+
+    // Still fluid that fills the grid, so the particles do not move
+    solver.setGravity(Vector3D());
+    solver.resizeGrid(Size3(4, 4, 4), Vector3D(0.25, 0.25, 0.25), Vector3D());
+    solver.setMinNumberOfParticlesPerCell(2);
+    solver.setMaxNumberOfParticlesPerCell(3);
+    EXPECT_EQ(2u, solver.minNumberOfParticlesPerCell());
+    EXPECT_EQ(3u, solver.maxNumberOfParticlesPerCell());
+
+    // A crowded cell, and an empty one in the middle of the others
+    auto particles = solver.particleSystemData();
+    for (size_t i = 0; i < 10; ++i) {
+        particles->addParticle(Vector3D(0.1, 0.1, 0.01 * i + 0.05));
+    }
+    for (size_t k = 0; k < 4; ++k) {
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t i = 0; i < 4; ++i) {
+                bool isCrowded = (i == 0 && j == 0 && k == 0);
+                bool isEmpty = (i == 2 && j == 2 && k == 2);
+                if (isCrowded || isEmpty) {
+                    continue;
+                }
+                particles->addParticle(
+                    Vector3D(0.25 * i + 0.125, 0.25 * j + 0.125,
+                             0.25 * k + 0.125));
+            }
+        }
+    }
+
+    solver.update(Frame(1, 1.0 / 60.0));
+
+    // The crowded cell keeps its first particles, and the others get one
+    // more except the neighbors of the empty cell, which are next to a
+    // starving cell before the seeding
+    EXPECT_EQ(3u + 57u * 2u + 6u, particles->numberOfParticles());
+    auto positions = particles->positions();
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_NEAR(0.01 * i + 0.05, positions[i].z, 1e-9);
+    }
+
+    Array3<size_t> counts(4, 4, 4, 0);
+    for (size_t p = 0; p < particles->numberOfParticles(); ++p) {
+        Vector3D x = positions[p] / 0.25;
+        ++counts(
+            static_cast<size_t>(x.x),
+            static_cast<size_t>(x.y),
+            static_cast<size_t>(x.z));
+    }
+    counts.forEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t distance = (i > 2 ? i - 2 : 2 - i) + (j > 2 ? j - 2 : 2 - j)
+            + (k > 2 ? k - 2 : 2 - k);
+        if (i == 0 && j == 0 && k == 0) {
+            EXPECT_EQ(3u, counts(i, j, k));
+        } else if (distance == 1) {
+            EXPECT_EQ(1u, counts(i, j, k));
+        } else {
+            EXPECT_EQ(2u, counts(i, j, k));
+        }
+    });
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array1.h>
+#include <jet/constants.h>
+#include <jet/point_cell_list_searcher3.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+std::vector<size_t> bruteForceNearbyPoints(
+    const Array1<Vector3D>& points,
+    const Vector3D& origin,
+    double radius) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].distanceTo(origin) <= radius) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+std::vector<size_t> nearbyPoints(
+    const PointCellListSearcher3& searcher,
+    const Array1<Vector3D>& points,
+    const Vector3D& origin,
+    double radius) {
+    std::vector<size_t> result;
+    searcher.forEachNearbyPoint(
+        origin,
+        radius,
+        [&](size_t i, const Vector3D& pt) {
+            EXPECT_EQ(points[i], pt);
+            result.push_back(i);
+        });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+}  // namespace
+
+TEST(PointCellListSearcher3, ForEachNearbyPoint) {
+    Array1<Vector3D> points = {
+        Vector3D(0, 1, 3),
+        Vector3D(2, 5, 4),
+        Vector3D(-1, 3, 0)
+    };
+
+    PointCellListSearcher3 searcher(std::sqrt(10.0));
+    searcher.build(points.accessor());
+
+    std::vector<size_t> found = nearbyPoints(
+        searcher, points, Vector3D(0, 0, 0), std::sqrt(10.0));
+    EXPECT_EQ((std::vector<size_t>{0, 2}), found);
+
+    // The radius is not limited by the cell size
+    found = nearbyPoints(searcher, points, Vector3D(0, 0, 0), 10.0);
+    EXPECT_EQ((std::vector<size_t>{0, 1, 2}), found);
+
+    found = nearbyPoints(searcher, points, Vector3D(100, 0, 0), 1.0);
+    EXPECT_TRUE(found.empty());
+    EXPECT_TRUE(searcher.hasNearbyPoint(Vector3D(2, 5, 3.5), 1.0));
+    EXPECT_FALSE(searcher.hasNearbyPoint(Vector3D(2, 5, 2), 1.0));
+}
+
+TEST(PointCellListSearcher3, RandomPoints) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<> d(-1.0, 2.0);
+
+    Array1<Vector3D> points(2000);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(d(rng), d(rng), 0.2 * d(rng));
+    }
+
+    const double radius = 0.15;
+    PointCellListSearcher3 searcher(radius);
+    searcher.build(points.accessor());
+    EXPECT_EQ(
+        cellListResolution3(points.accessor(), radius),
+        searcher.resolution());
+
+    for (size_t q = 0; q < 200; ++q) {
+        Vector3D origin(d(rng), d(rng), 0.2 * d(rng));
+        EXPECT_EQ(
+            bruteForceNearbyPoints(points, origin, radius),
+            nearbyPoints(searcher, points, origin, radius));
+        EXPECT_EQ(
+            bruteForceNearbyPoints(points, origin, 2.5 * radius),
+            nearbyPoints(searcher, points, origin, 2.5 * radius));
+
+        size_t nearestIndex = searcher.nearest(origin, radius);
+        std::vector<size_t> candidates
+            = bruteForceNearbyPoints(points, origin, radius);
+        if (candidates.empty()) {
+            EXPECT_EQ(kMaxSize, nearestIndex);
+        } else {
+            ASSERT_NE(kMaxSize, nearestIndex);
+            for (size_t i : candidates) {
+                EXPECT_LE(
+                    points[nearestIndex].distanceTo(origin),
+                    points[i].distanceTo(origin));
+            }
+        }
+    }
+}
+
+TEST(PointCellListSearcher3, UpdatePointPositions) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector3D> points(500);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(d(rng), d(rng), d(rng));
+    }
+
+    const double radius = 0.1;
+    PointCellListSearcher3 searcher(radius);
+    searcher.build(points.accessor());
+
+    // The moved points, some of which leave the grid, are still found
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] += 0.3 * Vector3D(d(rng) - 0.5, d(rng) - 0.5, d(rng));
+    }
+    searcher.updatePointPositions(points.accessor());
+
+    for (size_t q = 0; q < 100; ++q) {
+        Vector3D origin(d(rng), d(rng), 1.2 * d(rng));
+        EXPECT_EQ(
+            bruteForceNearbyPoints(points, origin, radius),
+            nearbyPoints(searcher, points, origin, radius));
+    }
+}
+
+TEST(PointCellListSearcher3, Empty) {
+    Array1<Vector3D> points;
+    PointCellListSearcher3 searcher(1.0);
+    searcher.build(points.accessor());
+
+    EXPECT_FALSE(searcher.hasNearbyPoint(Vector3D(), 1.0));
+    EXPECT_EQ(kMaxSize, searcher.nearest(Vector3D(), 1.0));
+    EXPECT_TRUE(
+        nearbyPoints(searcher, points, Vector3D(), 1.0).empty());
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bcc_lattice_point_generator.h>
+#include <jet/fcc_lattice_point_generator.h>
+#include <jet/grid_point_generator3.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+class CustomPointGenerator3 final : public PointGenerator3 {
+ public:
+    void forEachPoint(
+        const BoundingBox3D& boundingBox,
+        double spacing,
+        const std::function<bool(const Vector3D&)>& callback) const override {
+        for (int i = 0; i * spacing <= boundingBox.width(); ++i) {
+            Vector3D point(i * spacing, 0, 0);
+            if (!callback(boundingBox.lowerCorner + point)) {
+                break;
+            }
+        }
+    }
+};
+
+void testSlicedGeneration(
+    const PointGenerator3& generator,
+    const BoundingBox3D& box,
+    double spacing) {
+    std::vector<Vector3D> expected;
+    generator.forEachPoint(box, spacing, [&](const Vector3D& point) {
+        expected.push_back(point);
+        return true;
+    });
+
+    EXPECT_EQ(expected.size(), generator.countPoints(box, spacing));
+
+    Array1<Vector3D> points(3);
+    generator.generate(box, spacing, &points);
+    ASSERT_EQ(expected.size() + 3, points.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], points[i + 3]);
+    }
+
+    // Generates the slices in two ranges into the parts of the same array
+    size_t numberOfSlices = generator.numberOfSlices(box, spacing);
+    size_t middle = numberOfSlices / 2;
+    size_t count1 = generator.countPointsInSlices(box, spacing, 0, middle);
+    size_t count2 = generator.countPointsInSlices(
+        box, spacing, middle, numberOfSlices);
+    ASSERT_EQ(expected.size(), count1 + count2);
+
+    Array1<Vector3D> ranges(count1 + count2);
+    generator.generateRange(
+        box, spacing, 0, middle,
+        ArrayAccessor1<Vector3D>(count1, ranges.data()));
+    generator.generateRange(
+        box, spacing, middle, numberOfSlices,
+        ArrayAccessor1<Vector3D>(count2, ranges.data() + count1));
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], ranges[i]);
+    }
+}
+
+}  // namespace
+
+TEST(PointGenerator3, SlicedGeneration) {
+    BccLatticePointGenerator bcc;
+    FccLatticePointGenerator fcc;
+    GridPointGenerator3 grid;
+    CustomPointGenerator3 custom;
+
+    BoundingBox3D box(Vector3D(-0.3, 0.1, 0.2), Vector3D(0.71, 1.0, 1.33));
+    BoundingBox3D flatBox(Vector3D(0, 0, 0), Vector3D(1, 1, 0));
+
+    for (double spacing : {0.1, 0.07, 0.25}) {
+        testSlicedGeneration(bcc, box, spacing);
+        testSlicedGeneration(fcc, box, spacing);
+        testSlicedGeneration(grid, box, spacing);
+        testSlicedGeneration(custom, box, spacing);
+
+        testSlicedGeneration(bcc, flatBox, spacing);
+        testSlicedGeneration(fcc, flatBox, spacing);
+        testSlicedGeneration(grid, flatBox, spacing);
+    }
+
+    EXPECT_EQ(1u, custom.numberOfSlices(box, 0.1));
+    EXPECT_LT(1u, bcc.numberOfSlices(box, 0.1));
+}
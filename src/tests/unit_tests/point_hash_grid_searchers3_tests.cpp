@@ -8,6 +8,10 @@
 #include <jet/point_parallel_hash_grid_searcher3.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
 using namespace jet;
 
 TEST(PointHashGridSearcher3, ForEachNearbyPoint) {
@@ -47,6 +51,75 @@ TEST(PointHashGridSearcher3, ForEachNearbyPointEmpty) {
         });
 }
 
+TEST(PointHashGridSearcher3, ForEachNearbyPointMatchesBruteForce) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<> d(-2.0, 2.0);
+
+    Array1<Vector3D> points;
+    for (int i = 0; i < 2000; ++i) {
+        points.append(Vector3D(d(rng), d(rng), d(rng)));
+    }
+
+    // The resolution is rounded up to (4, 8, 1), and the domain wraps
+    const double radius = 0.25;
+    PointHashGridSearcher3 searcher(3, 5, 1, 2.0 * radius);
+    searcher.build(points.accessor());
+    EXPECT_EQ(Size3(4, 8, 1), searcher.resolution());
+
+    // Points added after the build are chained to their buckets
+    for (int i = 0; i < 200; ++i) {
+        Vector3D point(d(rng), d(rng), d(rng));
+        points.append(point);
+        searcher.add(point);
+    }
+
+    std::vector<int> visits(points.size());
+    for (int q = 0; q < 100; ++q) {
+        Vector3D origin(d(rng), d(rng), d(rng));
+        std::fill(visits.begin(), visits.end(), 0);
+        searcher.forEachNearbyPoint(
+            origin,
+            radius,
+            [&](size_t i, const Vector3D& pt) {
+                EXPECT_EQ(points[i], pt);
+                ++visits[i];
+            });
+
+        bool hasNearbyPoint = false;
+        for (size_t i = 0; i < points.size(); ++i) {
+            bool isNearby
+                = (points[i] - origin).lengthSquared() <= radius * radius;
+            EXPECT_EQ(isNearby ? 1 : 0, visits[i]);
+            hasNearbyPoint |= isNearby;
+        }
+        EXPECT_EQ(hasNearbyPoint, searcher.hasNearbyPoint(origin, radius));
+    }
+}
+
+TEST(PointHashGridSearcher3, Add) {
+    PointHashGridSearcher3 searcher(4, 4, 4, 1.0);
+    searcher.add(Vector3D(0.5, 0.5, 0.5));
+    searcher.add(Vector3D(0.6, 0.5, 0.5));
+    searcher.add(Vector3D(2.5, 0.5, 0.5));
+
+    size_t key = searcher.getHashKeyFromBucketIndex(Point3I(0, 0, 0));
+    EXPECT_EQ(2u, searcher.numberOfPointsInBucket(key));
+
+    std::vector<size_t> indices;
+    searcher.forEachNearbyPoint(
+        Vector3D(0.55, 0.5, 0.5),
+        0.5,
+        [&](size_t i, const Vector3D&) { indices.push_back(i); });
+    std::sort(indices.begin(), indices.end());
+    EXPECT_EQ(std::vector<size_t>({0, 1}), indices);
+
+    // Rebuilding drops the added points
+    Array1<Vector3D> points = { Vector3D(2.5, 0.5, 0.5) };
+    searcher.build(points.accessor());
+    EXPECT_EQ(0u, searcher.numberOfPointsInBucket(key));
+    EXPECT_FALSE(searcher.hasNearbyPoint(Vector3D(0.55, 0.5, 0.5), 0.5));
+}
+
 TEST(PointParallelHashGridSearcher3, Build) {
     Array1<Vector3D> points;
     BccLatticePointGenerator pointsGenerator;
@@ -68,7 +141,7 @@ TEST(PointParallelHashGridSearcher3, Build) {
                 static_cast<ssize_t>(i),
                 static_cast<ssize_t>(j),
                 static_cast<ssize_t>(k)));
-        size_t value = pointSearcher.buckets()[key].size();
+        size_t value = pointSearcher.numberOfPointsInBucket(key);
         grid(i, j, k) = value;
     });
 
@@ -87,3 +160,33 @@ TEST(PointParallelHashGridSearcher3, Build) {
         EXPECT_EQ(grid(i, j, k), value);
     });
 }
+
+TEST(PointHashGridSearcher3, Statistics) {
+    // The second point wraps into the bucket of the other two
+    Array1<Vector3D> points = {
+        Vector3D(0.5, 0.5, 0.5),
+        Vector3D(4.5, 0.5, 0.5),
+        Vector3D(0.6, 0.5, 0.5),
+        Vector3D(2.5, 1.5, 0.5)
+    };
+
+    PointHashGridSearcher3 searcher(4, 4, 4, 1.0);
+    PointParallelHashGridSearcher3 parallelSearcher(4, 4, 4, 1.0);
+    searcher.build(points.accessor());
+    parallelSearcher.build(points.accessor());
+
+    for (const auto& stats
+         : { searcher.statistics(), parallelSearcher.statistics() }) {
+        EXPECT_EQ(4u, stats.numberOfPoints);
+        EXPECT_EQ(64u, stats.numberOfBuckets);
+        EXPECT_EQ(2u, stats.numberOfNonEmptyBuckets);
+        EXPECT_EQ(3u, stats.maxNumberOfPointsPerBucket);
+        EXPECT_DOUBLE_EQ(4.0 / 64.0, stats.loadFactor);
+        EXPECT_EQ(1u, stats.numberOfCollisions);
+    }
+
+    PointHashGridSearcher3 emptySearcher(4, 4, 4, 1.0);
+    PointHashGridStatistics emptyStats = emptySearcher.statistics();
+    EXPECT_EQ(0u, emptyStats.numberOfPoints);
+    EXPECT_EQ(0u, emptyStats.numberOfNonEmptyBuckets);
+}
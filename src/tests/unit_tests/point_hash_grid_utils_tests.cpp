@@ -0,0 +1,40 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array1.h>
+#include <jet/point_hash_grid_utils.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace jet;
+
+TEST(PointHashGridUtils, SuggestedHashGridResolution3) {
+    Array1<Vector3D> emptyPoints;
+    EXPECT_EQ(
+        Size3(1, 1, 1),
+        suggestedHashGridResolution3(emptyPoints.accessor(), 1.0));
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> position(0.0, 1.0);
+    Array1<Vector3D> points(1000);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(position(rng), position(rng), 0.5 * position(rng));
+    }
+
+    // 4 + 2 cells along x and y, and 2 + 2 along z, rounded up
+    Size3 resolution = suggestedHashGridResolution3(points.accessor(), 0.25);
+    EXPECT_EQ(Size3(8, 8, 4), resolution);
+
+    PointParallelHashGridSearcher3 searcher(resolution, 0.25);
+    searcher.build(points.accessor());
+    EXPECT_EQ(0u, searcher.statistics().numberOfCollisions);
+
+    // Sparse points are capped at eight buckets per point
+    Array1<Vector3D> sparsePoints = {
+        Vector3D(0, 0, 0),
+        Vector3D(100, 0, 0)
+    };
+    EXPECT_EQ(
+        Size3(2, 2, 4),
+        suggestedHashGridResolution3(sparsePoints.accessor(), 1.0));
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/point_neighbor_lists.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(PointNeighborLists, Constructors) {
+    PointNeighborLists lists;
+    EXPECT_EQ(0u, lists.size());
+    EXPECT_TRUE(lists.empty());
+    EXPECT_EQ(1u, lists.offsets().size());
+    EXPECT_EQ(0u, lists.neighbors().size());
+}
+
+TEST(PointNeighborLists, Build) {
+    PointNeighborLists lists;
+
+    // i-th point has neighbors {0, 1, ..., i % 5 - 1}
+    lists.build(
+        100,
+        [](size_t i) {
+            return i % 5;
+        },
+        [](size_t i, uint32_t* neighbors) {
+            for (size_t j = 0; j < i % 5; ++j) {
+                neighbors[j] = static_cast<uint32_t>(j);
+            }
+        });
+
+    EXPECT_EQ(100u, lists.size());
+    EXPECT_EQ(101u, lists.offsets().size());
+    EXPECT_EQ(200u, lists.neighbors().size());
+
+    for (size_t i = 0; i < lists.size(); ++i) {
+        auto neighbors = lists[i];
+        EXPECT_EQ(i % 5, neighbors.size());
+        EXPECT_EQ(i % 5, lists.numberOfNeighbors(i));
+
+        size_t expected = 0;
+        for (size_t j : neighbors) {
+            EXPECT_EQ(expected, j);
+            ++expected;
+        }
+    }
+
+    lists.clear();
+    EXPECT_EQ(0u, lists.size());
+    EXPECT_EQ(0u, lists.neighbors().size());
+}
@@ -3,6 +3,9 @@
 #include <jet/array1.h>
 #include <jet/point_parallel_hash_grid_searcher3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
 
 using namespace jet;
 
@@ -30,6 +33,37 @@ TEST(PointParallelHashGridSearcher3, ForEachNearbyPoint) {
         });
 }
 
+TEST(PointParallelHashGridSearcher3, ForEachNearbyPointVirtual) {
+    Array1<Vector3D> points = {
+        Vector3D(0, 1, 3),
+        Vector3D(2, 5, 4),
+        Vector3D(-1, 3, 0)
+    };
+
+    PointParallelHashGridSearcher3 searcher(4, 4, 4, std::sqrt(10));
+    searcher.build(points.accessor());
+
+    size_t templateCount = 0;
+    searcher.forEachNearbyPoint(
+        Vector3D(0, 0, 0),
+        std::sqrt(10.0),
+        [&templateCount](size_t, const Vector3D&) {
+            ++templateCount;
+        });
+
+    size_t virtualCount = 0;
+    const PointNeighborSearcher3& base = searcher;
+    base.forEachNearbyPoint(
+        Vector3D(0, 0, 0),
+        std::sqrt(10.0),
+        [&virtualCount](size_t, const Vector3D&) {
+            ++virtualCount;
+        });
+
+    EXPECT_EQ(2u, templateCount);
+    EXPECT_EQ(templateCount, virtualCount);
+}
+
 TEST(PointParallelHashGridSearcher3, ForEachNearbyPointEmpty) {
     Array1<Vector3D> points;
 
@@ -42,3 +76,152 @@ TEST(PointParallelHashGridSearcher3, ForEachNearbyPointEmpty) {
         [](size_t, const Vector3D&) {
         });
 }
+
+TEST(PointParallelHashGridSearcher3, Update) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> position(0.0, 1.0);
+
+    Array1<Vector3D> points(500);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(position(rng), position(rng), position(rng));
+    }
+
+    PointParallelHashGridSearcher3 searcher(8, 8, 8, 0.2);
+    searcher.build(points.accessor());
+
+    // Small moves take the merge path, and large ones the full sort
+    for (double scale : { 0.01, 0.5 }) {
+        std::uniform_real_distribution<double> jitter(-scale, scale);
+        for (size_t i = 0; i < points.size(); ++i) {
+            points[i] += Vector3D(jitter(rng), jitter(rng), jitter(rng));
+        }
+
+        searcher.update(points.accessor());
+
+        PointParallelHashGridSearcher3 reference(8, 8, 8, 0.2);
+        reference.build(points.accessor());
+        EXPECT_EQ(reference.startIndexTable(), searcher.startIndexTable());
+        EXPECT_EQ(reference.endIndexTable(), searcher.endIndexTable());
+
+        for (size_t i = 0; i < points.size(); i += 7) {
+            std::vector<size_t> found;
+            searcher.forEachNearbyPoint(
+                points[i],
+                0.1,
+                [&](size_t j, const Vector3D& pt) {
+                    EXPECT_EQ(points[j], pt);
+                    found.push_back(j);
+                });
+
+            std::vector<size_t> expected;
+            for (size_t j = 0; j < points.size(); ++j) {
+                if (points[i].distanceTo(points[j]) <= 0.1) {
+                    expected.push_back(j);
+                }
+            }
+
+            std::sort(found.begin(), found.end());
+            EXPECT_EQ(expected, found);
+        }
+    }
+}
+
+TEST(PointParallelHashGridSearcher3, UpdatePointPositions) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> position(0.0, 1.0);
+    std::uniform_real_distribution<double> jitter(-0.02, 0.02);
+
+    Array1<Vector3D> points(300);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(position(rng), position(rng), position(rng));
+    }
+
+    // Queries within 0.1 stay exact for moves up to 0.25 - 0.1
+    PointParallelHashGridSearcher3 searcher(8, 8, 8, 0.5);
+    searcher.build(points.accessor());
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] += Vector3D(jitter(rng), jitter(rng), jitter(rng));
+    }
+    searcher.updatePointPositions(points.accessor());
+
+    for (size_t i = 0; i < points.size(); i += 5) {
+        size_t numberOfFound = 0;
+        searcher.forEachNearbyPoint(
+            points[i],
+            0.1,
+            [&](size_t j, const Vector3D& pt) {
+                EXPECT_EQ(points[j], pt);
+                EXPECT_LE(points[i].distanceTo(pt), 0.1);
+                ++numberOfFound;
+            });
+
+        size_t numberOfExpected = 0;
+        for (size_t j = 0; j < points.size(); ++j) {
+            if (points[i].distanceTo(points[j]) <= 0.1) {
+                ++numberOfExpected;
+            }
+        }
+        EXPECT_EQ(numberOfExpected, numberOfFound);
+    }
+}
+
+TEST(PointParallelHashGridSearcher3, Nearest) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> position(0.0, 1.0);
+
+    Array1<Vector3D> points(400);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = Vector3D(position(rng), position(rng), position(rng));
+    }
+
+    PointParallelHashGridSearcher3 searcher(4, 4, 4, 0.3);
+    searcher.build(points.accessor());
+
+    const double maxRadius = 0.15;
+    const size_t k = 5;
+    Array1<Vector3D> origins(100);
+    for (size_t i = 0; i < origins.size(); ++i) {
+        origins[i] = Vector3D(position(rng), position(rng), position(rng));
+    }
+
+    Array1<size_t> batchNearest(origins.size());
+    Array1<size_t> batchKNearest(origins.size() * k);
+    searcher.batchNearest(origins.accessor(), maxRadius, batchNearest);
+    searcher.batchKNearest(origins.accessor(), maxRadius, k, batchKNearest);
+
+    for (size_t i = 0; i < origins.size(); ++i) {
+        std::vector<std::pair<double, size_t>> expected;
+        for (size_t j = 0; j < points.size(); ++j) {
+            double distance = origins[i].distanceTo(points[j]);
+            if (distance <= maxRadius) {
+                expected.emplace_back(distance, j);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        size_t nearest = searcher.nearest(origins[i], maxRadius);
+        std::vector<size_t> kNearest;
+        searcher.kNearest(origins[i], maxRadius, k, &kNearest);
+
+        if (expected.empty()) {
+            EXPECT_EQ(kMaxSize, nearest);
+        } else {
+            EXPECT_EQ(expected[0].second, nearest);
+        }
+        EXPECT_EQ(nearest, batchNearest[i]);
+
+        ASSERT_EQ(std::min(k, expected.size()), kNearest.size());
+        for (size_t n = 0; n < k; ++n) {
+            if (n < kNearest.size()) {
+                EXPECT_EQ(expected[n].second, kNearest[n]);
+                EXPECT_EQ(kNearest[n], batchKNearest[i * k + n]);
+            } else {
+                EXPECT_EQ(kMaxSize, batchKNearest[i * k + n]);
+            }
+        }
+    }
+
+    std::vector<size_t> none;
+    searcher.kNearest(origins[0], maxRadius, 0, &none);
+    EXPECT_TRUE(none.empty());
+}
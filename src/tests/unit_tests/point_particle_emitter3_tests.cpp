@@ -19,6 +19,23 @@ TEST(PointParticleEmitter3, Constructors) {
     EXPECT_EQ(18, emitter.maxNumberOfParticles());
 }
 
+TEST(PointParticleEmitter3, PreviewScale) {
+    PointParticleEmitter3 emitter(
+        Vector3D(), Vector3D(0, 1, 0), 3.0, 15.0, 800, 8000);
+
+    emitter.setPreviewScale(2.0);
+    EXPECT_EQ(2.0, emitter.previewScale());
+    EXPECT_EQ(100u, emitter.maxNumberOfNewParticlesPerSecond());
+    EXPECT_EQ(1000u, emitter.maxNumberOfParticles());
+
+    // A positive rate stays positive
+    emitter.setPreviewScale(100.0);
+    EXPECT_EQ(1u, emitter.maxNumberOfNewParticlesPerSecond());
+
+    emitter.setPreviewScale(1.0);
+    EXPECT_EQ(8000u, emitter.maxNumberOfParticles());
+}
+
 TEST(PointParticleEmitter3, Emit) {
     Vector3D dir = Vector3D(0.5, 1.0, -2.0).normalized();
 
@@ -66,3 +83,47 @@ TEST(PointParticleEmitter3, Emit) {
         EXPECT_DOUBLE_EQ(3.0, vel[i].length());
     }
 }
+
+TEST(PointParticleEmitter3, Deterministic) {
+    Vector3D dir = Vector3D(0.5, 1.0, -2.0).normalized();
+
+    // Emitting the same particles over different frames gives the same
+    // velocities, since they are keyed by the emission order.
+    PointParticleEmitter3 emitter1(
+        {1.0, 2.0, 3.0}, dir, 3.0, 15.0, 1000, 5000, 7);
+    PointParticleEmitter3 emitter2(
+        {1.0, 2.0, 3.0}, dir, 3.0, 15.0, 1000, 5000, 7);
+
+    auto particles1 = std::make_shared<ParticleSystemData3>();
+    auto particles2 = std::make_shared<ParticleSystemData3>();
+
+    Frame frame1(0, 5.0);
+    emitter1.emit(frame1, particles1);
+
+    Frame frame2(0, 1.0);
+    for (int i = 0; i < 5; ++i) {
+        emitter2.emit(frame2, particles2);
+        frame2.advance();
+    }
+
+    ASSERT_EQ(5000u, particles1->numberOfParticles());
+    ASSERT_EQ(5000u, particles2->numberOfParticles());
+
+    auto vel1 = particles1->velocities();
+    auto vel2 = particles2->velocities();
+    for (size_t i = 0; i < 5000; ++i) {
+        EXPECT_EQ(vel1[i], vel2[i]);
+    }
+
+    // generate() gives the same particles without adding them
+    PointParticleEmitter3 emitter3(
+        {1.0, 2.0, 3.0}, dir, 3.0, 15.0, 1000, 5000, 7);
+    Array1<Vector3D> newPositions;
+    Array1<Vector3D> newVelocities;
+    emitter3.generate(frame1, particles1, &newPositions, &newVelocities);
+    ASSERT_EQ(5000u, newVelocities.size());
+    EXPECT_EQ(5000u, particles1->numberOfParticles());
+    for (size_t i = 0; i < 5000; ++i) {
+        EXPECT_EQ(vel1[i], newVelocities[i]);
+    }
+}
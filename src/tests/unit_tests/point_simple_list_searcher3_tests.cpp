@@ -3,6 +3,7 @@
 #include <jet/array1.h>
 #include <jet/point_simple_list_searcher3.h>
 #include <gtest/gtest.h>
+#include <vector>
 
 using namespace jet;
 
@@ -29,3 +30,42 @@ TEST(PointSimpleListSearcher3, ForEachNearbyPoint) {
             }
         });
 }
+
+TEST(PointSimpleListSearcher3, Nearest) {
+    Array1<Vector3D> points = {
+        Vector3D(0, 1, 3),
+        Vector3D(2, 5, 4),
+        Vector3D(-1, 3, 0),
+        Vector3D(0, 0, 1)
+    };
+
+    PointSimpleListSearcher3 searcher;
+    searcher.build(points.accessor());
+
+    EXPECT_EQ(3u, searcher.nearest(Vector3D(0, 0, 0), 5.0));
+    EXPECT_EQ(kMaxSize, searcher.nearest(Vector3D(0, 0, 0), 0.5));
+
+    std::vector<size_t> indices;
+    searcher.kNearest(Vector3D(0, 0, 0), 5.0, 2, &indices);
+    ASSERT_EQ(2u, indices.size());
+    EXPECT_EQ(3u, indices[0]);
+    EXPECT_EQ(0u, indices[1]);
+
+    Array1<Vector3D> origins = { Vector3D(0, 0, 0), Vector3D(2, 5, 5) };
+    Array1<size_t> nearest(2);
+    searcher.batchNearest(origins.accessor(), 2.0, nearest);
+    EXPECT_EQ(3u, nearest[0]);
+    EXPECT_EQ(1u, nearest[1]);
+
+    Array1<size_t> kNearest(6);
+    searcher.batchKNearest(origins.accessor(), 2.0, 3, kNearest);
+    EXPECT_EQ(3u, kNearest[0]);
+    EXPECT_EQ(kMaxSize, kNearest[1]);
+    EXPECT_EQ(1u, kNearest[3]);
+    EXPECT_EQ(kMaxSize, kNearest[4]);
+
+    Array1<size_t> wrongSize(1);
+    EXPECT_THROW(
+        searcher.batchNearest(origins.accessor(), 2.0, wrongSize),
+        std::invalid_argument);
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bcc_lattice_point_generator.h>
+#include <jet/poisson_disk_point_generator3.h>
+#include <jet/sph_boundary_particles3.h>
+#include <jet/sphere3.h>
+#include <jet/surface_to_implicit3.h>
+#include <jet/volume_particle_emitter3.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace jet;
+
+namespace {
+
+double minimumDistance(const Array1<Vector3D>& points) {
+    double result = kMaxD;
+    for (size_t i = 0; i < points.size(); ++i) {
+        for (size_t j = i + 1; j < points.size(); ++j) {
+            result = std::min(result, points[i].distanceTo(points[j]));
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST(PoissonDiskPointGenerator3, Generate) {
+    PoissonDiskPointGenerator3 generator;
+    EXPECT_EQ(0u, generator.seed());
+    EXPECT_EQ(30u, generator.numberOfAttempts());
+    EXPECT_THROW(generator.setNumberOfAttempts(0), std::invalid_argument);
+
+    BoundingBox3D box(Vector3D(-0.3, 0.1, 0.2), Vector3D(0.71, 1.0, 1.33));
+    const double spacing = 0.1;
+
+    Array1<Vector3D> points;
+    generator.generate(box, spacing, &points);
+    EXPECT_EQ(points.size(), generator.countPoints(box, spacing));
+    EXPECT_LE(spacing, minimumDistance(points));
+    for (const Vector3D& point : points) {
+        EXPECT_TRUE(box.contains(point));
+    }
+
+    // Close to a maximal sampling, which has about 0.7 points per cubed
+    // spacing, and fewer points than the lattice of the same spacing
+    double volume = box.width() * box.height() * box.depth();
+    EXPECT_LT(0.5 * volume / (spacing * spacing * spacing), points.size());
+    BccLatticePointGenerator bcc;
+    EXPECT_GT(bcc.countPoints(box, spacing), points.size());
+
+    // The same seed gives the same points
+    Array1<Vector3D> again;
+    generator.generate(box, spacing, &again);
+    ASSERT_EQ(points.size(), again.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(points[i], again[i]);
+    }
+
+    generator.setSeed(7);
+    EXPECT_EQ(7u, generator.seed());
+    Array1<Vector3D> other;
+    generator.generate(box, spacing, &other);
+    EXPECT_LE(spacing, minimumDistance(other));
+    EXPECT_FALSE(
+        points.size() == other.size()
+        && std::equal(points.begin(), points.end(), other.begin()));
+
+    // Flat boxes are sampled too
+    Array1<Vector3D> flat;
+    generator.generate(
+        BoundingBox3D(Vector3D(0, 0, 0), Vector3D(1, 1, 0)), spacing, &flat);
+    EXPECT_LT(0u, flat.size());
+    EXPECT_LE(spacing, minimumDistance(flat));
+}
+
+TEST(PoissonDiskPointGenerator3, GenerateOnSurface) {
+    TriangleMesh3 mesh;
+    mesh.addPoint(Vector3D(0, 0, 0));
+    mesh.addPoint(Vector3D(1, 0, 0));
+    mesh.addPoint(Vector3D(1, 1, 0));
+    mesh.addPoint(Vector3D(0, 1, 0));
+    mesh.addPoint(Vector3D(0, 1, 1));
+    mesh.addPointTriangle(Point3UI(0, 1, 2));
+    mesh.addPointTriangle(Point3UI(0, 2, 3));
+    mesh.addPointTriangle(Point3UI(3, 2, 4));
+
+    PoissonDiskPointGenerator3 generator;
+    const double spacing = 0.05;
+    Array1<Vector3D> points(2);
+    generator.generateOnSurface(mesh, spacing, &points);
+    ASSERT_LT(2u, points.size());
+
+    Array1<Vector3D> samples;
+    for (size_t i = 2; i < points.size(); ++i) {
+        samples.append(points[i]);
+    }
+    EXPECT_LE(spacing, minimumDistance(samples));
+    for (const Vector3D& point : samples) {
+        EXPECT_NEAR(0.0, mesh.closestDistance(point), 1e-12);
+    }
+
+    // About 0.6 points per squared spacing of area
+    double area = 1.0 + 0.5 * std::sqrt(2.0);
+    EXPECT_LT(0.5 * area / (spacing * spacing), samples.size());
+
+    // The samples make boundary particles
+    SphBoundaryParticles3 boundary;
+    boundary.build(samples.constAccessor(), 2.0 * spacing);
+    EXPECT_EQ(samples.size(), boundary.numberOfParticles());
+
+    Array1<Vector3D> empty;
+    generator.generateOnSurface(TriangleMesh3(), spacing, &empty);
+    EXPECT_EQ(0u, empty.size());
+}
+
+TEST(PoissonDiskPointGenerator3, Emit) {
+    auto sphere = std::make_shared<SurfaceToImplicit3>(
+        std::make_shared<Sphere3>(Vector3D(0.5, 0.5, 0.5), 0.4));
+    BoundingBox3D box(Vector3D(), Vector3D(1, 1, 1));
+
+    VolumeParticleEmitter3 emitter(sphere, box, 0.1);
+    emitter.setPointGenerator(std::make_shared<PoissonDiskPointGenerator3>());
+
+    auto particles = std::make_shared<ParticleSystemData3>();
+    emitter.emit(Frame(), particles);
+
+    auto pos = particles->positions();
+    EXPECT_LT(0u, pos.size());
+    for (size_t i = 0; i < pos.size(); ++i) {
+        EXPECT_GE(0.4, (pos[i] - Vector3D(0.5, 0.5, 0.5)).length());
+    }
+}
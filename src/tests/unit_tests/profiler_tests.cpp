@@ -0,0 +1,139 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/grid_fluid_solver3.h>
+#include <jet/profiler.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Enables the profiler with no recorded events while alive
+struct ProfilerSession {
+    ProfilerSession() {
+        Profiler::clear();
+        Profiler::setIsEnabled(true);
+    }
+
+    ~ProfilerSession() {
+        Profiler::setIsEnabled(false);
+        Profiler::clear();
+    }
+};
+
+const ProfileReportEntry* findEntry(
+    const std::vector<ProfileReportEntry>& report,
+    const std::string& path) {
+    auto iter = std::find_if(
+        report.begin(),
+        report.end(),
+        [&](const ProfileReportEntry& entry) { return entry.path == path; });
+    return (iter != report.end()) ? &(*iter) : nullptr;
+}
+
+}  // namespace
+
+TEST(Profiler, Disabled) {
+    ProfilerSession session;
+    Profiler::setIsEnabled(false);
+    {
+        JET_PROFILE_SCOPE("outer");
+    }
+
+    EXPECT_TRUE(Profiler::events().empty());
+}
+
+TEST(Profiler, NestedScopes) {
+    ProfilerSession session;
+    for (int i = 0; i < 2; ++i) {
+        JET_PROFILE_SCOPE("outer");
+        {
+            JET_PROFILE_SCOPE("first");
+        }
+        {
+            JET_PROFILE_SCOPE("second");
+            JET_PROFILE_SCOPE("inner");
+        }
+    }
+
+    auto events = Profiler::events();
+    EXPECT_EQ(8u, events.size());
+
+    auto report = Profiler::report();
+    ASSERT_EQ(4u, report.size());
+    EXPECT_EQ("outer", report[0].path);
+    EXPECT_EQ("outer/first", report[1].path);
+    EXPECT_EQ("outer/second", report[2].path);
+    EXPECT_EQ("outer/second/inner", report[3].path);
+    EXPECT_EQ(0u, report[0].depth);
+    EXPECT_EQ(2u, report[3].depth);
+    for (const auto& entry : report) {
+        EXPECT_EQ(2u, entry.count);
+    }
+    EXPECT_GE(
+        report[0].totalDurationInSeconds,
+        report[1].totalDurationInSeconds + report[2].totalDurationInSeconds);
+}
+
+TEST(Profiler, Threads) {
+    ProfilerSession session;
+    std::thread thread([] {
+        JET_PROFILE_SCOPE("worker");
+    });
+    {
+        JET_PROFILE_SCOPE("main");
+    }
+    thread.join();
+
+    auto events = Profiler::events();
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ(0u, events[0].depth);
+    EXPECT_EQ(0u, events[1].depth);
+    EXPECT_NE(events[0].threadIndex, events[1].threadIndex);
+}
+
+TEST(Profiler, ChromeTrace) {
+    ProfilerSession session;
+    {
+        JET_PROFILE_SCOPE("say \"hi\"");
+    }
+
+    std::stringstream strm;
+    Profiler::writeChromeTrace(&strm);
+    std::string json = strm.str();
+
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"say \\\"hi\\\"\""));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"dur\":"));
+}
+
+TEST(Profiler, FrameReport) {
+    ProfilerSession session;
+    GridFluidSolver3 solver;
+    solver.resizeGrid(
+        Size3(4, 4, 4), Vector3D(0.25, 0.25, 0.25), Vector3D());
+    solver.setIsUsingFixedSubTimeSteps(true);
+    solver.setNumberOfFixedSubTimeSteps(3);
+
+    Frame frame(1, 1.0 / 60.0);
+    solver.update(frame);
+    auto report = Profiler::lastFrameReport();
+    auto firstPressure = findEntry(
+        report, "advanceTimeStep/onAdvanceTimeStep/computePressure");
+    ASSERT_NE(nullptr, firstPressure);
+    EXPECT_EQ(3u, firstPressure->count);
+    EXPECT_NE(nullptr, findEntry(report, "advanceTimeStep"));
+
+    // The last frame report only covers the last frame
+    frame.advance();
+    solver.update(frame);
+    report = Profiler::lastFrameReport();
+    EXPECT_EQ(1u, findEntry(report, "advanceTimeStep")->count);
+    EXPECT_EQ(2u, findEntry(Profiler::report(), "advanceTimeStep")->count);
+}
@@ -83,3 +83,33 @@ TEST(Quaternion, BasicSetters) {
         EXPECT_DOUBLE_EQ(0.0, q.z);
     }
 }
+
+TEST(Quaternion, Rotations) {
+    // 90 degrees around the x-axis turns y to z and z to -y
+    QuaternionD q(Vector3D(1, 0, 0), pi<double>() / 2.0);
+    Vector3D y = q * Vector3D(0, 1, 0);
+    Vector3D z = q * Vector3D(0, 0, 1);
+    EXPECT_NEAR(0.0, y.distanceTo(Vector3D(0, 0, 1)), 1e-15);
+    EXPECT_NEAR(0.0, z.distanceTo(Vector3D(0, -1, 0)), 1e-15);
+
+    // The rotation is orthonormal and matches the matrices
+    QuaternionD r(Vector3D(1, 2, 3), 0.7);
+    Matrix3x3D m = r.matrix3();
+    Matrix4x4D m4 = r.matrix4();
+    for (const Vector3D& v : {
+            Vector3D(1, 0, 0), Vector3D(0, 1, 0), Vector3D(0, 0, 1),
+            Vector3D(0.3, -2.0, 1.5) }) {
+        Vector3D rv = r * v;
+        EXPECT_NEAR(v.length(), rv.length(), 1e-14);
+        EXPECT_NEAR(0.0, rv.distanceTo(m * v), 1e-14);
+        Vector4D rv4 = m4 * Vector4D(v.x, v.y, v.z, 1);
+        EXPECT_NEAR(0.0, rv.distanceTo(Vector3D(rv4.x, rv4.y, rv4.z)), 1e-14);
+    }
+
+    // The matrix converts back to the same rotation
+    QuaternionD back(m);
+    EXPECT_NEAR(r.w, back.w, 1e-14);
+    EXPECT_NEAR(r.x, back.x, 1e-14);
+    EXPECT_NEAR(r.y, back.y, 1e-14);
+    EXPECT_NEAR(r.z, back.z, 1e-14);
+}
@@ -1,8 +1,13 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/collider_set3.h>
 #include <jet/rigid_body_collider3.h>
 #include <jet/plane3.h>
+#include <jet/sphere3.h>
 #include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
 
 using namespace jet;
 
@@ -140,3 +145,70 @@ TEST(RigidBodyCollider3, VelocityAt) {
     EXPECT_DOUBLE_EQ(27.0, result.y);
     EXPECT_DOUBLE_EQ(-2.0, result.z);
 }
+
+TEST(RigidBodyCollider3, Version) {
+    RigidBodyCollider3 collider(std::make_shared<Plane3>());
+    RigidBodyCollider3 otherCollider(std::make_shared<Plane3>());
+    EXPECT_NE(collider.version(), otherCollider.version());
+    EXPECT_NE(0u, collider.version());
+
+    uint64_t version = collider.version();
+    collider.linearVelocity = Vector3D(1, 0, 0);
+    EXPECT_EQ(version, collider.version());
+
+    collider.markDirty();
+    EXPECT_NE(version, collider.version());
+}
+
+TEST(ColliderSet3, VelocityAt) {
+    ColliderSet3 colliderSet;
+    EXPECT_EQ(Vector3D(), colliderSet.velocityAt(Vector3D(1, 2, 3)));
+
+    std::vector<std::shared_ptr<Sphere3>> spheres;
+    std::vector<RigidBodyCollider3Ptr> colliders;
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            auto sphere = std::make_shared<Sphere3>(
+                Vector3D(3.0 * i, 0.5 * j, 3.0 * j), 0.5);
+            auto collider = std::make_shared<RigidBodyCollider3>(sphere);
+            collider->linearVelocity = Vector3D(i, j, 1.0);
+            spheres.push_back(sphere);
+            colliders.push_back(collider);
+            colliderSet.addCollider(collider);
+        }
+    }
+
+    // Same as the brute-force search for the closest collider
+    auto check = [&]() {
+        for (int n = 0; n < 50; ++n) {
+            Vector3D pt(
+                6.0 + std::sin(1.3 * n) * 9.0,
+                std::cos(0.7 * n) * 9.0,
+                6.0 + std::sin(2.1 * n + 1.0) * 9.0);
+
+            double closestDistance = kMaxD;
+            size_t closest = 0;
+            for (size_t i = 0; i < colliders.size(); ++i) {
+                double dist = spheres[i]->closestDistance(pt);
+                if (dist < closestDistance) {
+                    closestDistance = dist;
+                    closest = i;
+                }
+            }
+            EXPECT_EQ(
+                colliders[closest]->velocityAt(pt),
+                colliderSet.velocityAt(pt));
+        }
+    };
+    check();
+
+    // The moved collider is found after the set is marked as dirty
+    uint64_t version = colliderSet.version();
+    spheres[0]->center = Vector3D(6.0, 20.0, 6.0);
+    colliderSet.markDirty();
+    EXPECT_NE(version, colliderSet.version());
+    EXPECT_EQ(
+        colliders[0]->velocityAt(Vector3D(6.0, 21.0, 6.0)),
+        colliderSet.velocityAt(Vector3D(6.0, 21.0, 6.0)));
+    check();
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/scratch_arena.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+
+using namespace jet;
+
+TEST(ScratchArena, BucketSize) {
+    EXPECT_EQ(kScratchAlignment, ScratchArena::bucketSize(0));
+    EXPECT_EQ(kScratchAlignment, ScratchArena::bucketSize(1));
+    EXPECT_EQ(kScratchAlignment, ScratchArena::bucketSize(kScratchAlignment));
+    EXPECT_EQ(1024u, ScratchArena::bucketSize(1000));
+    EXPECT_EQ(1024u, ScratchArena::bucketSize(1024));
+    EXPECT_EQ(1280u, ScratchArena::bucketSize(1025));
+
+    // At most a quarter is wasted
+    for (size_t bytes = 65; bytes < 100000; bytes += 997) {
+        size_t bucket = ScratchArena::bucketSize(bytes);
+        EXPECT_LE(bytes, bucket);
+        EXPECT_LE(bucket, bytes + bytes / 4 + kScratchAlignment);
+        EXPECT_EQ(0u, bucket % kScratchAlignment);
+    }
+}
+
+TEST(ScratchArena, Array3) {
+    ScratchArena arena;
+
+    auto a = arena.array3<double>(Size3(10, 20, 30), 4.0);
+    EXPECT_EQ(Size3(10, 20, 30), a.size());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(a.data()) % kScratchAlignment);
+    a.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(4.0, a(i, j, k));
+    });
+
+    auto b = arena.array3<char>(Size3(11, 20, 30), 1);
+    EXPECT_NE(static_cast<void*>(a.data()), static_cast<void*>(b.data()));
+    EXPECT_EQ(2u, arena.numberOfBuffers());
+    EXPECT_EQ(2u, arena.numberOfBuffersInUse());
+
+    auto c = arena.array1<int>(5, 3);
+    auto d = arena.array2<float>(Size2(4, 5), 2.f);
+    EXPECT_EQ(5u, c.size());
+    EXPECT_EQ(3, c[4]);
+    EXPECT_EQ(Size2(4, 5), d.size());
+    EXPECT_EQ(2.f, d(3, 4));
+    EXPECT_EQ(4u, arena.numberOfBuffersInUse());
+}
+
+TEST(ScratchArena, Reuse) {
+    ScratchArena arena;
+
+    // Face-centered data of a 32^3 grid
+    auto u = arena.array3<double>(Size3(33, 32, 32));
+    auto v = arena.array3<double>(Size3(32, 33, 32));
+    auto w = arena.array3<double>(Size3(32, 32, 33));
+    EXPECT_NE(u.data(), v.data());
+    EXPECT_NE(v.data(), w.data());
+    size_t capacity = arena.capacityInBytes();
+    EXPECT_EQ(3u, arena.numberOfBuffers());
+
+    // The next step takes the same buffers regardless of the order
+    for (int step = 0; step < 3; ++step) {
+        arena.reset();
+        EXPECT_EQ(0u, arena.numberOfBuffersInUse());
+
+        arena.array3<double>(Size3(32, 32, 33));
+        arena.array3<double>(Size3(32, 33, 32));
+        auto u2 = arena.array3<double>(Size3(33, 32, 32), 1.0);
+        EXPECT_EQ(1.0, u2(32, 31, 31));
+        EXPECT_EQ(3u, arena.numberOfBuffers());
+        EXPECT_EQ(capacity, arena.capacityInBytes());
+    }
+
+    // A smaller request takes a free buffer, and a larger one allocates
+    arena.reset();
+    arena.array1<double>(10);
+    EXPECT_EQ(3u, arena.numberOfBuffers());
+    arena.array3<double>(Size3(64, 64, 64));
+    EXPECT_EQ(4u, arena.numberOfBuffers());
+
+    arena.clear();
+    EXPECT_EQ(0u, arena.numberOfBuffers());
+    EXPECT_EQ(0u, arena.capacityInBytes());
+}
+
+TEST(ScratchArena, MemoryTag) {
+    size_t scratchBytes = MemoryTracker::bytes(MemoryTag::Scratch);
+    {
+        ScratchArena arena;
+        arena.array3<double>(Size3(16, 16, 16));
+        EXPECT_LE(
+            scratchBytes + 16 * 16 * 16 * sizeof(double),
+            MemoryTracker::bytes(MemoryTag::Scratch));
+
+        // Copies start empty
+        ScratchArena copy(arena);
+        EXPECT_EQ(0u, copy.numberOfBuffers());
+        copy = arena;
+        EXPECT_EQ(0u, copy.numberOfBuffers());
+        EXPECT_EQ(1u, arena.numberOfBuffers());
+    }
+    EXPECT_EQ(scratchBytes, MemoryTracker::bytes(MemoryTag::Scratch));
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/cell_centered_vector_grid3.h>
+#include <jet/constant_vector_field3.h>
+#include <jet/cubic_semi_lagrangian3.h>
+#include <jet/maccormack_advection3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+class SwirlField3 final : public VectorField3 {
+ public:
+    Vector3D sample(const Vector3D& x) const override {
+        return Vector3D(
+            std::sin(x.y) * std::cos(x.z),
+            std::sin(x.z) * std::cos(x.x),
+            std::sin(x.x) * std::cos(x.y));
+    }
+};
+
+double density(const Vector3D& x) {
+    return std::sin(x.x) + std::cos(2.0 * x.y) * x.z;
+}
+
+Vector3D smoke(const Vector3D& x) {
+    return Vector3D(x.y * x.z, std::cos(x.x), x.x - x.y);
+}
+
+class ConstantSemiLagrangian3 final : public SemiLagrangian3 {
+ public:
+    ConstantSemiLagrangian3() : SemiLagrangian3(Interpolation::Custom) {
+    }
+
+ protected:
+    std::function<double(const Vector3D&)>
+    getScalarSamplerFunc(const ScalarGrid3&) const override {
+        return [](const Vector3D&) { return 3.0; };
+    }
+};
+
+}  // namespace
+
+TEST(SemiLagrangian3, BatchedAdvectMatchesSeparateAdvect) {
+    Size3 res(10, 12, 8);
+    Vector3D h(0.5, 0.5, 0.5);
+    Vector3D o(-1.0, 0.0, 1.0);
+
+    CellCenteredScalarGrid3 density0(res, h, o);
+    CellCenteredScalarGrid3 temperature0(res, h, o);
+    VertexCenteredScalarGrid3 fuel0(res, h, o);
+    CellCenteredVectorGrid3 smoke0(res, h, o);
+    density0.fill(density);
+    temperature0.fill([](const Vector3D& x) { return 2.0 * density(x); });
+    fuel0.fill(density);
+    smoke0.fill(smoke);
+
+    SwirlField3 flow;
+    CubicSemiLagrangian3 solver;
+
+    CellCenteredScalarGrid3 density1(res, h, o);
+    CellCenteredScalarGrid3 temperature1(res, h, o);
+    VertexCenteredScalarGrid3 fuel1(res, h, o);
+    CellCenteredVectorGrid3 smoke1(res, h, o);
+    solver.advect(density0, flow, 0.3, &density1);
+    solver.advect(temperature0, flow, 0.3, &temperature1);
+    solver.advect(fuel0, flow, 0.3, &fuel1);
+    solver.advect(smoke0, flow, 0.3, &smoke1);
+
+    CellCenteredScalarGrid3 density2(res, h, o);
+    CellCenteredScalarGrid3 temperature2(res, h, o);
+    VertexCenteredScalarGrid3 fuel2(res, h, o);
+    CellCenteredVectorGrid3 smoke2(res, h, o);
+    solver.advect(
+        {&density0, &temperature0, &fuel0},
+        {&smoke0},
+        flow,
+        0.3,
+        {&density2, &temperature2, &fuel2},
+        {&smoke2});
+
+    density1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(density1(i, j, k), density2(i, j, k));
+        EXPECT_DOUBLE_EQ(temperature1(i, j, k), temperature2(i, j, k));
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).x, smoke2(i, j, k).x);
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).y, smoke2(i, j, k).y);
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).z, smoke2(i, j, k).z);
+    });
+
+    fuel1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(fuel1(i, j, k), fuel2(i, j, k));
+    });
+}
+
+TEST(SemiLagrangian3, SinglePrecisionAdvect) {
+    Size3 res(10, 12, 8);
+    Vector3D h(0.5, 0.5, 0.5);
+    Vector3D o(-1.0, 0.0, 1.0);
+
+    CellCenteredScalarGrid3 density0(res, h, o);
+    CellCenteredScalarGrid3F densityF0(res, h, o);
+    VertexCenteredScalarGrid3 fuel0(res, h, o);
+    VertexCenteredScalarGrid3F fuelF0(res, h, o);
+    density0.fill(density);
+    densityF0.fill(density);
+    fuel0.fill(density);
+    fuelF0.fill(density);
+
+    // The linear solver samples the floats, and the others stage them
+    SwirlField3 flow;
+    std::vector<AdvectionSolver3Ptr> solvers = {
+        std::make_shared<SemiLagrangian3>(),
+        std::make_shared<CubicSemiLagrangian3>(),
+        std::make_shared<MacCormackAdvection3>()
+    };
+    for (const auto& solver : solvers) {
+        CellCenteredScalarGrid3 density1(res, h, o);
+        CellCenteredScalarGrid3F densityF1(res, h, o);
+        VertexCenteredScalarGrid3 fuel1(res, h, o);
+        VertexCenteredScalarGrid3F fuelF1(res, h, o);
+        solver->advect(density0, flow, 0.3, &density1);
+        solver->advect(densityF0, flow, 0.3, &densityF1);
+        solver->advect(fuel0, flow, 0.3, &fuel1);
+        solver->advect(fuelF0, flow, 0.3, &fuelF1);
+
+        density1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(density1(i, j, k), densityF1(i, j, k), 1e-5);
+        });
+        fuel1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_NEAR(fuel1(i, j, k), fuelF1(i, j, k), 1e-5);
+        });
+    }
+}
+
+TEST(CubicSemiLagrangian3, NonMonotonic) {
+    Size3 res(10, 12, 8);
+    Vector3D h(0.5, 0.5, 0.5);
+    Vector3D o(-1.0, 0.0, 1.0);
+
+    CellCenteredScalarGrid3 density0(res, h, o);
+    CellCenteredScalarGrid3 ramp0(res, h, o);
+    CellCenteredVectorGrid3 smoke0(res, h, o);
+    density0.fill(density);
+    ramp0.fill([](const Vector3D& x) { return x.x + 2.0 * x.y - x.z; });
+    smoke0.fill(smoke);
+
+    CubicSemiLagrangian3 solver;
+    EXPECT_TRUE(solver.isMonotonic());
+    solver.setIsMonotonic(false);
+    EXPECT_FALSE(solver.isMonotonic());
+
+    SwirlField3 flow;
+    CellCenteredScalarGrid3 density1(res, h, o);
+    CellCenteredScalarGrid3 ramp1(res, h, o);
+    CellCenteredVectorGrid3 smoke1(res, h, o);
+    solver.advect(density0, flow, 0.3, &density1);
+    solver.advect(smoke0, flow, 0.3, &smoke1);
+
+    CellCenteredScalarGrid3 density2(res, h, o);
+    CellCenteredScalarGrid3 ramp2(res, h, o);
+    CellCenteredVectorGrid3 smoke2(res, h, o);
+    solver.advect(
+        {&density0, &ramp0}, {&smoke0}, flow, 0.3,
+        {&density2, &ramp2}, {&smoke2});
+
+    density1.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(density1(i, j, k), density2(i, j, k));
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).x, smoke2(i, j, k).x);
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).y, smoke2(i, j, k).y);
+        EXPECT_DOUBLE_EQ(smoke1(i, j, k).z, smoke2(i, j, k).z);
+    });
+
+    // Catmull-Rom splines reproduce a linear field away from the boundary
+    ConstantVectorField3 uniformFlow(Vector3D(0.4, -0.3, 0.2));
+    solver.advect(ramp0, uniformFlow, 1.0, &ramp1);
+    auto pos = ramp1.dataPosition();
+    for (size_t k = 3; k + 3 < res.z; ++k) {
+        for (size_t j = 3; j + 3 < res.y; ++j) {
+            for (size_t i = 3; i + 3 < res.x; ++i) {
+                Vector3D x = pos(i, j, k) - Vector3D(0.4, -0.3, 0.2);
+                EXPECT_NEAR(x.x + 2.0 * x.y - x.z, ramp1(i, j, k), 1e-12);
+            }
+        }
+    }
+}
+
+TEST(SemiLagrangian3, BatchedAdvectChecksSizes) {
+    CellCenteredScalarGrid3 input(Size3(2, 2, 2));
+    ConstantVectorField3 flow(Vector3D(1.0, 0.0, 0.0));
+    SemiLagrangian3 solver;
+
+    EXPECT_THROW(
+        solver.advect({&input}, {}, flow, 0.1, {}, {}),
+        std::invalid_argument);
+}
+
+TEST(SemiLagrangian3, CustomSampler) {
+    CellCenteredScalarGrid3 input(Size3(4, 5, 6));
+    CellCenteredScalarGrid3 output(Size3(4, 5, 6));
+    ConstantVectorField3 flow(Vector3D(1.0, 0.0, 0.0));
+    ConstantSemiLagrangian3 solver;
+
+    solver.advect(input, flow, 0.1, &output);
+    output.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(3.0, output(i, j, k));
+    });
+
+    output.fill(0.0);
+    solver.advect({&input}, {}, flow, 0.1, {&output}, {});
+    output.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(3.0, output(i, j, k));
+    });
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/shared_frame_buffer.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace jet;
+
+TEST(SharedFrameBuffer, PublishParticles) {
+    const std::string name = "jet_shared_frame_buffer_tests_particles";
+
+    SharedFramePublisher publisher;
+    ASSERT_TRUE(publisher.open(name, 1 << 16));
+    EXPECT_TRUE(publisher.isOpen());
+    EXPECT_EQ(name, publisher.name());
+
+    SharedFrameViewer viewer;
+    ASSERT_TRUE(viewer.open(name));
+    EXPECT_EQ(0u, viewer.latestSequence());
+    SharedFrameView view;
+    EXPECT_FALSE(viewer.acquireLatest(&view));
+
+    Array1<Vector3D> positions(100);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = Vector3D(i, 2.0 * i, -1.0 * i);
+    }
+    Frame frame(7, 0.5);
+    EXPECT_TRUE(publisher.publishParticles(frame, positions.constAccessor()));
+    publisher.flush();
+    EXPECT_EQ(1u, publisher.numberOfPublishedFrames());
+
+    // The snapshot was taken at the publish
+    positions[0] = Vector3D(-5, -5, -5);
+
+    ASSERT_EQ(1u, viewer.latestSequence());
+    ASSERT_TRUE(viewer.acquireLatest(&view));
+    EXPECT_EQ(SharedFrameType::Particles, view.type);
+    EXPECT_EQ(1u, view.sequence);
+    EXPECT_EQ(7u, view.frameIndex);
+    EXPECT_DOUBLE_EQ(3.5, view.timeInSeconds);
+    ASSERT_EQ(100u, view.points.size());
+    EXPECT_EQ(Vector3D(), view.points[0]);
+    EXPECT_EQ(Vector3D(99, 198, -99), view.points[99]);
+    EXPECT_TRUE(viewer.isValid(view));
+
+    Array1<Vector3D> copied;
+    ASSERT_TRUE(viewer.readParticles(&copied));
+    ASSERT_EQ(100u, copied.size());
+    EXPECT_EQ(Vector3D(3, 6, -3), copied[3]);
+
+    TriangleMesh3 mesh;
+    EXPECT_FALSE(viewer.readTriangleMesh(&mesh));
+
+    // Too large for a slot
+    Array1<Vector3D> large(10000);
+    EXPECT_FALSE(publisher.publishParticles(frame, large.constAccessor()));
+
+    publisher.close();
+    EXPECT_FALSE(publisher.isOpen());
+    EXPECT_FALSE(publisher.publishParticles(frame, positions.constAccessor()));
+
+    // The viewer keeps the mapping after the publisher removes the name
+    EXPECT_TRUE(viewer.readParticles(&copied));
+    EXPECT_FALSE(SharedFrameViewer().open(name));
+}
+
+TEST(SharedFrameBuffer, PublishScalarGridAndMesh) {
+    const std::string name = "jet_shared_frame_buffer_tests_grid_and_mesh";
+
+    SharedFramePublisher publisher;
+    ASSERT_TRUE(publisher.open(name, 1 << 16, 2));
+    SharedFrameViewer viewer;
+    ASSERT_TRUE(viewer.open(name));
+
+    CellCenteredScalarGrid3 sdf(
+        Size3(8, 6, 4), Vector3D(0.5, 0.5, 0.5), Vector3D(1, 2, 3));
+    sdf.fill([](const Vector3D& pt) { return pt.x - pt.y * pt.z; });
+    Frame frame(1, 1.0 / 60.0);
+    EXPECT_TRUE(publisher.publishScalarGrid(frame, sdf));
+    publisher.flush();
+
+    // Modifying the grid after the publish does not change the frame
+    CellCenteredScalarGrid3 expected(sdf);
+    sdf.fill(0.0);
+
+    SharedFrameView view;
+    ASSERT_TRUE(viewer.acquireLatest(&view));
+    EXPECT_EQ(SharedFrameType::ScalarGrid, view.type);
+    EXPECT_EQ(expected.resolution(), view.resolution);
+    EXPECT_EQ(expected.gridSpacing(), view.gridSpacing);
+    EXPECT_EQ(expected.origin(), view.origin);
+    EXPECT_EQ(expected.dataOrigin(), view.dataOrigin);
+    EXPECT_EQ(expected.dataSize(), view.gridData.size());
+
+    CellCenteredScalarGrid3 grid;
+    ASSERT_TRUE(viewer.readScalarGrid(&grid));
+    EXPECT_EQ(expected.resolution(), grid.resolution());
+    expected.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_DOUBLE_EQ(expected(i, j, k), grid(i, j, k));
+        EXPECT_DOUBLE_EQ(expected(i, j, k), view.gridData(i, j, k));
+    });
+
+    // The data layout does not match
+    VertexCenteredScalarGrid3 vertexGrid;
+    EXPECT_FALSE(viewer.readScalarGrid(&vertexGrid));
+
+    TriangleMesh3 mesh;
+    mesh.addPoint(Vector3D(0, 0, 0));
+    mesh.addPoint(Vector3D(1, 0, 0));
+    mesh.addPoint(Vector3D(0, 1, 0));
+    mesh.addPoint(Vector3D(0, 0, 1));
+    mesh.addPointTriangle(Point3UI(0, 2, 1));
+    mesh.addPointTriangle(Point3UI(0, 1, 3));
+    mesh.setTransform(Vector3D(1, 2, 3), QuaternionD());
+    frame.advance();
+    EXPECT_TRUE(publisher.publishTriangleMesh(frame, mesh));
+    publisher.flush();
+
+    // With two slots, the grid view stays valid until the next publish
+    EXPECT_TRUE(viewer.isValid(view));
+
+    TriangleMesh3 copied;
+    ASSERT_TRUE(viewer.readTriangleMesh(&copied));
+    ASSERT_EQ(4u, copied.numberOfPoints());
+    ASSERT_EQ(2u, copied.numberOfTriangles());
+    EXPECT_EQ(Vector3D(2, 2, 3), copied.point(1));
+    EXPECT_EQ(Point3UI(0, 1, 3), copied.pointIndex(1));
+
+    frame.advance();
+    EXPECT_TRUE(publisher.publishScalarGrid(frame, sdf));
+    publisher.flush();
+    EXPECT_EQ(3u, viewer.latestSequence());
+    EXPECT_FALSE(viewer.isValid(view));
+}
+
+TEST(SharedFrameBuffer, LatestFrameWins) {
+    const std::string name = "jet_shared_frame_buffer_tests_latest";
+
+    SharedFramePublisher publisher;
+    ASSERT_TRUE(publisher.open(name, 1 << 12));
+    SharedFrameViewer viewer;
+    ASSERT_TRUE(viewer.open(name));
+
+    Array1<Vector3D> positions(10);
+    for (unsigned int i = 0; i < 50; ++i) {
+        positions[0].x = i;
+        EXPECT_TRUE(publisher.publishParticles(
+            Frame(i, 1.0 / 60.0), positions.constAccessor()));
+    }
+    publisher.flush();
+
+    EXPECT_EQ(
+        50u,
+        publisher.numberOfPublishedFrames()
+            + publisher.numberOfDroppedFrames());
+
+    SharedFrameView view;
+    ASSERT_TRUE(viewer.acquireLatest(&view));
+    EXPECT_EQ(49u, view.frameIndex);
+    EXPECT_EQ(49.0, view.points[0].x);
+}
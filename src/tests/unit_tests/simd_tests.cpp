@@ -0,0 +1,35 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/simd.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+using namespace jet;
+
+TEST(Simd, InstructionSet) {
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    EXPECT_TRUE(isSimdInstructionSetSupported(oldInstructionSet));
+    EXPECT_TRUE(isSimdInstructionSetSupported(SimdInstructionSet::None));
+
+    // Neon and the x86 instruction sets are never supported together
+    EXPECT_FALSE(
+        isSimdInstructionSetSupported(SimdInstructionSet::Neon)
+        && isSimdInstructionSetSupported(SimdInstructionSet::Sse2));
+    SimdInstructionSet unsupported
+        = isSimdInstructionSetSupported(SimdInstructionSet::Neon)
+        ? SimdInstructionSet::Sse2 : SimdInstructionSet::Neon;
+    EXPECT_THROW(setSimdInstructionSet(unsupported), std::invalid_argument);
+    EXPECT_EQ(oldInstructionSet, simdInstructionSet());
+
+    setSimdInstructionSet(SimdInstructionSet::None);
+    EXPECT_EQ(SimdInstructionSet::None, simdInstructionSet());
+    setSimdInstructionSet(oldInstructionSet);
+    EXPECT_EQ(oldInstructionSet, simdInstructionSet());
+
+    EXPECT_EQ(
+        std::string("none"), simdInstructionSetName(SimdInstructionSet::None));
+    EXPECT_EQ(
+        std::string("avx512"),
+        simdInstructionSetName(SimdInstructionSet::Avx512));
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/slab_decomposition3.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace jet;
+
+namespace {
+
+// Communicator which only reports its rank, for testing the ranges.
+class RankOnlyCommunicator final : public Communicator {
+ public:
+    RankOnlyCommunicator(int rank, int size) : _rank(rank), _size(size) {}
+
+    int rank() const override { return _rank; }
+
+    int size() const override { return _size; }
+
+    double sum(double value) override { return value; }
+
+    double max(double value) override { return value; }
+
+    void sendReceive(const void*, size_t, int, void*, size_t, int) override {}
+
+ private:
+    int _rank;
+    int _size;
+};
+
+}  // namespace
+
+TEST(SlabDecomposition3, Ranges) {
+    size_t expectedBegins[3] = {0, 3, 6};
+    size_t expectedEnds[3] = {3, 6, 10};
+
+    for (int rank = 0; rank < 3; ++rank) {
+        SlabDecomposition3 decomposition(
+            Size3(4, 5, 10),
+            std::make_shared<RankOnlyCommunicator>(rank, 3));
+
+        EXPECT_EQ(Size3(4, 5, 10), decomposition.globalSize());
+        EXPECT_EQ(expectedBegins[rank], decomposition.zBegin());
+        EXPECT_EQ(expectedEnds[rank], decomposition.zEnd());
+        EXPECT_EQ(
+            Size3(4, 5, expectedEnds[rank] - expectedBegins[rank]),
+            decomposition.localSize());
+        EXPECT_EQ(rank > 0 ? rank - 1 : kNoRank, decomposition.previousRank());
+        EXPECT_EQ(rank < 2 ? rank + 1 : kNoRank, decomposition.nextRank());
+    }
+
+    EXPECT_THROW(
+        SlabDecomposition3(
+            Size3(4, 5, 2), std::make_shared<RankOnlyCommunicator>(0, 3)),
+        std::invalid_argument);
+}
+
+TEST(SlabDecomposition3, ExchangeGhostLayersWithoutNeighbors) {
+    SlabDecomposition3 decomposition(
+        Size3(2, 3, 4), std::make_shared<SerialCommunicator>());
+
+    Array3<double> local(2, 3, 4, 1.0);
+    Array2<double> backGhost(5, 5, 7.0);
+    Array2<double> frontGhost(5, 5, 7.0);
+
+    decomposition.exchangeGhostLayers(local, &backGhost, &frontGhost);
+
+    EXPECT_EQ(Size2(2, 3), backGhost.size());
+    EXPECT_EQ(Size2(2, 3), frontGhost.size());
+    backGhost.forEach([](double v) { EXPECT_DOUBLE_EQ(0.0, v); });
+    frontGhost.forEach([](double v) { EXPECT_DOUBLE_EQ(0.0, v); });
+
+    Array3<double> wrongSize(2, 3, 3);
+    EXPECT_THROW(
+        decomposition.exchangeGhostLayers(wrongSize, &backGhost, &frontGhost),
+        std::invalid_argument);
+}
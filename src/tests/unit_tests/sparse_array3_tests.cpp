@@ -0,0 +1,104 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/sparse_array3.h>
+#include <jet/vector3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(SparseArray3, Constructors) {
+    SparseArray3<double> arr0;
+    EXPECT_EQ(0u, arr0.width());
+    EXPECT_EQ(0u, arr0.height());
+    EXPECT_EQ(0u, arr0.depth());
+    EXPECT_EQ(0u, arr0.numberOfBricks());
+
+    SparseArray3<double> arr1(20, 9, 17, 3.0);
+    EXPECT_EQ(Size3(20, 9, 17), arr1.size());
+    EXPECT_EQ(3.0, arr1.backgroundValue());
+    EXPECT_EQ(0u, arr1.numberOfBricks());
+    EXPECT_EQ(3.0, arr1(19, 8, 16));
+}
+
+TEST(SparseArray3, Accessors) {
+    SparseArray3<double> arr(20, 9, 17, -1.0);
+    const SparseArray3<double>& constArr = arr;
+
+    // Reading does not allocate
+    EXPECT_EQ(-1.0, constArr(5, 5, 5));
+    EXPECT_FALSE(arr.isAllocated(5, 5, 5));
+    EXPECT_EQ(0u, arr.numberOfBricks());
+
+    arr(5, 5, 5) = 2.0;
+    EXPECT_TRUE(arr.isAllocated(5, 5, 5));
+    EXPECT_TRUE(arr.isAllocated(0, 7, 0));
+    EXPECT_FALSE(arr.isAllocated(8, 5, 5));
+    EXPECT_EQ(1u, arr.numberOfBricks());
+    EXPECT_EQ(2.0, constArr(5, 5, 5));
+    EXPECT_EQ(-1.0, constArr(4, 5, 5));
+
+    // The last brick is partially inside of the array
+    arr(19, 8, 16) = 4.0;
+    EXPECT_EQ(2u, arr.numberOfBricks());
+    EXPECT_EQ(4.0, constArr(19, 8, 16));
+    EXPECT_EQ(2.0, constArr(5, 5, 5));
+
+    size_t count = 0;
+    arr.forEachAllocatedIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_TRUE(arr.isAllocated(i, j, k));
+        ++count;
+    });
+    EXPECT_EQ(8u * 8u * 8u + 4u * 1u * 1u, count);
+
+    arr.parallelForEachAllocatedIndex([&](size_t i, size_t j, size_t k) {
+        arr(i, j, k) += 1.0;
+    });
+    EXPECT_EQ(3.0, constArr(5, 5, 5));
+    EXPECT_EQ(0.0, constArr(0, 0, 0));
+    EXPECT_EQ(-1.0, constArr(10, 0, 0));
+
+    arr.clear();
+    EXPECT_EQ(0u, arr.numberOfBricks());
+    EXPECT_EQ(-1.0, constArr(5, 5, 5));
+}
+
+TEST(SparseArray3, DenseConversion) {
+    Array3<double> dense(30, 20, 10, 0.0);
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        // A thin sheet around j = 12
+        if (j == 12) {
+            dense(i, j, k) = 1.0 + i + 2.0 * k;
+        }
+    });
+
+    SparseArray3<double> arr;
+    arr.set(dense.constAccessor(), 0.0);
+    EXPECT_EQ(dense.size(), arr.size());
+    EXPECT_EQ(4u * 2u, arr.numberOfBricks());
+
+    Array3<double> dense2;
+    arr.copyTo(&dense2);
+    EXPECT_EQ(dense.size(), dense2.size());
+    dense.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(dense(i, j, k), dense2(i, j, k));
+    });
+}
+
+TEST(SparseArray3, Prune) {
+    SparseArray3<Vector3D> arr(32, 32, 32, Vector3D());
+
+    arr(1, 1, 1) = Vector3D(1, 2, 3);
+    arr(9, 1, 1) = Vector3D(4, 5, 6);
+    arr(17, 1, 1) = Vector3D(7, 8, 9);
+    EXPECT_EQ(3u, arr.numberOfBricks());
+
+    arr(9, 1, 1) = Vector3D();
+    arr.prune();
+    EXPECT_EQ(2u, arr.numberOfBricks());
+    EXPECT_FALSE(arr.isAllocated(9, 1, 1));
+
+    const SparseArray3<Vector3D>& constArr = arr;
+    EXPECT_EQ(Vector3D(1, 2, 3), constArr(1, 1, 1));
+    EXPECT_EQ(Vector3D(), constArr(9, 1, 1));
+    EXPECT_EQ(Vector3D(7, 8, 9), constArr(17, 1, 1));
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/sparse_volume3.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+// A ball of smoke in [8, 20) x [12, 18) x [5, 27) of 32^3 data points
+void fillBlob(ScalarGrid3* grid) {
+    grid->fill(0.0);
+    for (size_t k = 5; k < 27; ++k) {
+        for (size_t j = 12; j < 18; ++j) {
+            for (size_t i = 8; i < 20; ++i) {
+                (*grid)(i, j, k) = 0.1 + 0.01 * (i + j + k);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+TEST(SparseVolumeWriter3, Crop) {
+    CellCenteredScalarGrid3 grid(32, 32, 32);
+    fillBlob(&grid);
+
+    SparseVolumeWriter3 writer(grid);
+    EXPECT_DOUBLE_EQ(0.0, writer.threshold());
+    EXPECT_EQ(8u, writer.tileSize());
+
+    writer.update();
+    EXPECT_EQ(Size3(8, 12, 5), writer.cropBegin());
+    EXPECT_EQ(Size3(20, 18, 27), writer.cropEnd());
+
+    // 2 x 1 x 3 tiles, all touching the blob
+    EXPECT_EQ(6u, writer.numberOfActiveTiles());
+
+    // Only the corner of the blob is above the threshold
+    writer.setThreshold(0.1 + 0.01 * (19 + 17 + 25));
+    writer.update();
+    EXPECT_EQ(Size3(19, 17, 26), writer.cropBegin());
+    EXPECT_EQ(Size3(20, 18, 27), writer.cropEnd());
+    EXPECT_EQ(1u, writer.numberOfActiveTiles());
+
+    // Nothing above the threshold
+    writer.setThreshold(1.0);
+    writer.update();
+    EXPECT_EQ(writer.cropBegin(), writer.cropEnd());
+    EXPECT_EQ(0u, writer.numberOfActiveTiles());
+}
+
+TEST(SparseVolumeWriter3, SparseRoundTrip) {
+    CellCenteredScalarGrid3 grid(32, 32, 32, 0.5, 0.5, 0.5, 1.0, 2.0, 3.0);
+    fillBlob(&grid);
+
+    // A hole that leaves one of the tiles empty
+    for (size_t k = 13; k < 21; ++k) {
+        for (size_t j = 12; j < 18; ++j) {
+            for (size_t i = 8; i < 16; ++i) {
+                grid(i, j, k) = 0.0;
+            }
+        }
+    }
+
+    SparseVolumeWriter3 writer(grid);
+    std::stringstream strm;
+    writer.writeSparse(&strm);
+    EXPECT_EQ(5u, writer.numberOfActiveTiles());
+
+    // Much smaller than the dense float data
+    EXPECT_LT(strm.str().size(), 32u * 32u * 32u * sizeof(float) / 10);
+
+    CellCenteredScalarGrid3 grid2(4, 4, 4, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, 7.0);
+    ASSERT_TRUE(readSparseVolume(&strm, &grid2));
+    EXPECT_EQ(grid.resolution(), grid2.resolution());
+    EXPECT_EQ(grid.gridSpacing(), grid2.gridSpacing());
+    EXPECT_EQ(grid.origin(), grid2.origin());
+    grid.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_NEAR(grid(i, j, k), grid2(i, j, k), 1e-3 * grid(i, j, k));
+    });
+
+    // Wrong grid type
+    strm.clear();
+    strm.seekg(0);
+    VertexCenteredScalarGrid3 grid3;
+    EXPECT_FALSE(readSparseVolume(&strm, &grid3));
+
+    std::stringstream garbage("not a volume");
+    EXPECT_FALSE(readSparseVolume(&garbage, &grid2));
+}
+
+TEST(SparseVolumeWriter3, Filter) {
+    CellCenteredScalarGrid3 grid(32, 32, 32);
+    fillBlob(&grid);
+
+    // Clears the blob below k = 10
+    SparseVolumeWriter3 writer(grid);
+    writer.setFilter([](size_t, size_t, size_t k, double value) {
+        return (k < 10) ? 0.0 : 2.0 * value;
+    });
+    writer.update();
+    EXPECT_EQ(Size3(8, 12, 10), writer.cropBegin());
+
+    std::stringstream strm;
+    writer.writeSparse(&strm);
+    CellCenteredScalarGrid3 grid2;
+    ASSERT_TRUE(readSparseVolume(&strm, &grid2));
+    EXPECT_DOUBLE_EQ(0.0, grid2(10, 14, 6));
+    EXPECT_NEAR(2.0 * grid(10, 14, 12), grid2(10, 14, 12), 1e-3);
+}
+
+TEST(SparseVolumeWriter3, Mitsuba) {
+    CellCenteredScalarGrid3 grid(32, 32, 32, 0.5, 0.5, 0.5);
+    fillBlob(&grid);
+
+    SparseVolumeWriter3 writer(grid);
+    std::stringstream strm;
+    writer.writeMitsuba(&strm);
+    std::string data = strm.str();
+    ASSERT_EQ(48u + 12u * 6u * 22u * sizeof(uint16_t), data.size());
+
+    EXPECT_EQ(std::string("VOL"), data.substr(0, 3));
+    EXPECT_EQ(3, data[3]);
+    int32_t encoding[5];
+    float bbox[6];
+    std::memcpy(encoding, data.data() + 4, sizeof(encoding));
+    std::memcpy(bbox, data.data() + 24, sizeof(bbox));
+    EXPECT_EQ(2, encoding[0]);
+    EXPECT_EQ(12, encoding[1]);
+    EXPECT_EQ(6, encoding[2]);
+    EXPECT_EQ(22, encoding[3]);
+    EXPECT_EQ(1, encoding[4]);
+
+    // The corners of the box are the first and last data points
+    EXPECT_FLOAT_EQ(0.25f + 0.5f * 8, bbox[0]);
+    EXPECT_FLOAT_EQ(0.25f + 0.5f * 12, bbox[1]);
+    EXPECT_FLOAT_EQ(0.25f + 0.5f * 5, bbox[2]);
+    EXPECT_FLOAT_EQ(0.25f + 0.5f * 19, bbox[3]);
+    EXPECT_FLOAT_EQ(0.25f + 0.5f * 17, bbox[4]);
+    EXPECT_FLOAT_EQ(0.25f + 0.5f * 26, bbox[5]);
+
+    // An empty grid still gives a valid volume of 2^3 zeros
+    grid.fill(0.0);
+    std::stringstream strm2;
+    writer.writeMitsuba(&strm2);
+    EXPECT_EQ(48u + 8u * sizeof(uint16_t), strm2.str().size());
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bcc_lattice_point_generator.h>
+#include <jet/pci_sph_solver3.h>
+#include <jet/plane3.h>
+#include <jet/sph_boundary_particles3.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace jet;
+
+TEST(SphBoundaryParticles3, Build) {
+    SphBoundaryParticles3 boundary;
+    EXPECT_EQ(0u, boundary.numberOfParticles());
+    EXPECT_EQ(0.0, boundary.sumOfKernelNearby(Vector3D()));
+
+    Plane3 plane(Vector3D(0, 0, 1), Vector3D(0, 0, 0));
+    BoundingBox3D domain(Vector3D(0, 0, -0.5), Vector3D(1, 1, 0.5));
+    boundary.build(plane, domain, 0.05, 0.09);
+
+    EXPECT_EQ(0.09, boundary.kernelRadius());
+    EXPECT_EQ(441u, boundary.numberOfParticles());
+
+    auto positions = boundary.positions();
+    auto volumes = boundary.volumes();
+    for (size_t b = 0; b < boundary.numberOfParticles(); ++b) {
+        EXPECT_NEAR(0.0, positions[b].z, 1e-12);
+        EXPECT_GT(volumes[b], 0.0);
+    }
+
+    // A particle on a corner has fewer neighbors, so a larger volume
+    double cornerVolume = 0.0;
+    double centerVolume = 0.0;
+    for (size_t b = 0; b < boundary.numberOfParticles(); ++b) {
+        if (positions[b].distanceTo(Vector3D(0, 0, 0)) < 1e-9) {
+            cornerVolume = volumes[b];
+        } else if (positions[b].distanceTo(Vector3D(0.5, 0.5, 0)) < 1e-9) {
+            centerVolume = volumes[b];
+        }
+    }
+    EXPECT_GT(cornerVolume, centerVolume);
+    EXPECT_GT(centerVolume, 0.0);
+
+    // The sums vanish outside the kernel radius, and the gradient points
+    // toward the boundary
+    Vector3D origin(0.5, 0.5, 0.03);
+    EXPECT_GT(boundary.sumOfKernelNearby(origin), 0.0);
+    EXPECT_EQ(0.0, boundary.sumOfKernelNearby(Vector3D(0.5, 0.5, 0.1)));
+
+    Vector3D gradient = boundary.sumOfGradientNearby(origin);
+    EXPECT_LT(gradient.z, 0.0);
+    EXPECT_NEAR(0.0, gradient.x, 1e-9 * std::fabs(gradient.z));
+    EXPECT_NEAR(0.0, gradient.y, 1e-9 * std::fabs(gradient.z));
+}
+
+TEST(SphBoundaryParticles3, Densities) {
+    // Fluid particles on a BCC lattice whose bottom layer is one spacing
+    // above the wall at z = -0.5 * spacing
+    auto particles = std::make_shared<SphSystemData3>();
+    const double spacing = particles->targetSpacing();
+    const double h = particles->kernelRadius();
+
+    Array1<Vector3D> points;
+    BccLatticePointGenerator generator;
+    generator.generate(
+        BoundingBox3D(
+            Vector3D(0, 0, 0.5 * spacing),
+            Vector3D(20 * spacing, 20 * spacing, 8 * spacing)),
+        spacing,
+        &points);
+    particles->addParticles(points.constAccessor());
+    particles->buildNeighborSearcher();
+    particles->updateDensities();
+
+    SphBoundaryParticles3 boundary;
+    boundary.build(
+        Plane3(Vector3D(0, 0, 1), Vector3D(0, 0, -0.5 * spacing)),
+        BoundingBox3D(
+            Vector3D(-h, -h, -1),
+            Vector3D(20 * spacing + h, 20 * spacing + h, 1)),
+        0.5 * spacing,
+        h);
+
+    // The particles next to the wall miss about a half of the neighbors,
+    // which the boundary particles make up for
+    const double targetDensity = particles->targetDensity();
+    auto x = particles->positions();
+    auto d = particles->densities();
+    const Vector3D center(10 * spacing, 10 * spacing, 0.5 * spacing);
+    size_t nearest = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (x[i].distanceTo(center) < x[nearest].distanceTo(center)) {
+            nearest = i;
+        }
+    }
+
+    double density = d[nearest];
+    double boundaryDensity
+        = density + targetDensity * boundary.sumOfKernelNearby(x[nearest]);
+    EXPECT_LT(density, 0.8 * targetDensity);
+    EXPECT_NEAR(1.0, boundaryDensity / targetDensity, 0.15);
+}
+
+TEST(SphBoundaryParticles3, PciSphSolver) {
+    PciSphSolver3 solver;
+    EXPECT_EQ(nullptr, solver.boundaryParticles());
+
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    const double spacing = particles->targetSpacing();
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                particles->addParticle(
+                    spacing * Vector3D(i, j, k + 0.5),
+                    Vector3D(0, 0, -1));
+            }
+        }
+    }
+
+    auto boundary = std::make_shared<SphBoundaryParticles3>();
+    boundary->build(
+        Plane3(Vector3D(0, 0, 1), Vector3D()),
+        BoundingBox3D(Vector3D(-1, -1, -1), Vector3D(1, 1, 1)),
+        0.5 * spacing,
+        particles->kernelRadius());
+    solver.setBoundaryParticles(boundary);
+    EXPECT_EQ(boundary, solver.boundaryParticles());
+
+    // Without a collider, only the boundary particles keep the fluid above
+    // the plane
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 10; frame.advance()) {
+        solver.update(frame);
+    }
+
+    auto x = particles->positions();
+    for (size_t i = 0; i < x.size(); ++i) {
+        EXPECT_GT(x[i].z, 0.0);
+    }
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/sph_cuda_solver3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(SphCudaSolver3, UpdateEmpty) {
+    SphCudaSolver3 solver;
+    EXPECT_EQ(SphCudaSolver3::isDeviceAvailable(), solver.isUsingDevice());
+
+    Frame frame;
+    solver.update(frame);
+    solver.update(frame);
+}
+
+TEST(SphCudaSolver3, MatchesSphSolver3) {
+    SphSolver3 solver;
+    SphCudaSolver3 cudaSolver;
+
+    for (SphSolver3* s : { &solver, static_cast<SphSolver3*>(&cudaSolver) }) {
+        s->setViscosityCoefficient(0.1);
+        SphSystemData3Ptr particles = s->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 12; ++i) {
+            for (int j = 0; j < 6; ++j) {
+                for (int k = 0; k < 4; ++k) {
+                    particles->addParticle(
+                        0.9 * targetSpacing * Vector3D(i, j, k),
+                        Vector3D(0.1 * j, -0.2 * k, 0.05 * i));
+                }
+            }
+        }
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 3; frame.advance()) {
+        solver.update(frame);
+        cudaSolver.update(frame);
+    }
+
+    // The device sums the neighbors in a different order
+    auto densities = solver.sphSystemData()->densities();
+    auto cudaDensities = cudaSolver.sphSystemData()->densities();
+    auto positions = solver.sphSystemData()->positions();
+    auto cudaPositions = cudaSolver.sphSystemData()->positions();
+    ASSERT_EQ(positions.size(), cudaPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_NEAR(densities[i], cudaDensities[i], 1e-6 * densities[i]);
+        EXPECT_NEAR(0.0, positions[i].distanceTo(cudaPositions[i]), 1e-6);
+    }
+}
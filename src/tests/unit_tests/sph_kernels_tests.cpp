@@ -1,6 +1,7 @@
 // Copyright (c) 2016 Doyub Kim
 
 #include <jet/sph_kernels2.h>
+#include <jet/sph_kernel_table3.h>
 #include <jet/sph_kernels3.h>
 #include <gtest/gtest.h>
 
@@ -161,3 +162,118 @@ TEST(SphSpikyKernel3, SecondDerivative)
 	EXPECT_LT(value1, value0);
 	EXPECT_LT(value2, value1);
 }
+
+namespace {
+
+// Integrates the kernel over the ball of its support radius.
+template <typename KernelType>
+double integrateKernel3(const KernelType& kernel)
+{
+	const int n = 10000;
+	const double dr = kernel.h / n;
+	double sum = 0.0;
+	for (int i = 0; i < n; ++i)
+	{
+		double r = (i + 0.5) * dr;
+		sum += 4.0 * kPiD * r * r * kernel(r) * dr;
+	}
+	return sum;
+}
+
+// Compares the derivatives with the central differences.
+template <typename KernelType>
+void testKernelDerivatives3(const KernelType& kernel)
+{
+	const double eps = 1e-6 * kernel.h;
+	for (int i = 1; i < 20; ++i)
+	{
+		double r = 0.05 * i * kernel.h;
+		double d1 = (kernel(r + eps) - kernel(r - eps)) / (2.0 * eps);
+		double d2 = (kernel.firstDerivative(r + eps)
+			- kernel.firstDerivative(r - eps)) / (2.0 * eps);
+		EXPECT_NEAR(d1, kernel.firstDerivative(r), 1e-5 * kernel(0.0));
+		EXPECT_NEAR(d2, kernel.secondDerivative(r), 1e-4 * kernel(0.0));
+	}
+	EXPECT_DOUBLE_EQ(0.0, kernel(kernel.h));
+	EXPECT_DOUBLE_EQ(0.0, kernel.firstDerivative(kernel.h));
+}
+
+}  // namespace
+
+TEST(SphStdKernel3, Coefficients)
+{
+	SphStdKernel3 kernel(0.7);
+
+	for (int i = 0; i <= 10; ++i)
+	{
+		double r = 0.07 * i;
+		double x = 1.0 - r * r / kernel.h2;
+		EXPECT_NEAR(
+			315.0 / (64.0 * kPiD * kernel.h3) * x * x * x,
+			kernel(r),
+			1e-12 * kernel(0.0));
+		EXPECT_DOUBLE_EQ(kernel(r), kernel.valueFromSquaredDistance(r * r));
+	}
+
+	EXPECT_NEAR(1.0, integrateKernel3(kernel), 1e-6);
+	testKernelDerivatives3(kernel);
+}
+
+TEST(SphCubicSplineKernel3, KernelFunction)
+{
+	SphCubicSplineKernel3 kernel(0.7);
+
+	EXPECT_NEAR(1.0, integrateKernel3(kernel), 1e-6);
+	testKernelDerivatives3(kernel);
+
+	// Continuous at the joint of the two pieces
+	EXPECT_NEAR(kernel(0.35 - 1e-9), kernel(0.35 + 1e-9), 1e-6);
+	EXPECT_DOUBLE_EQ(0.0, kernel.firstDerivative(0.0));
+}
+
+TEST(SphWendlandKernel3, KernelFunction)
+{
+	SphWendlandKernel3 kernel(0.7);
+
+	EXPECT_NEAR(1.0, integrateKernel3(kernel), 1e-6);
+	testKernelDerivatives3(kernel);
+	EXPECT_DOUBLE_EQ(0.0, kernel.firstDerivative(0.0));
+}
+
+TEST(SphKernelTable3, LookUp)
+{
+	SphKernelTable3<SphWendlandKernel3> empty;
+	EXPECT_EQ(0u, empty.resolution());
+	EXPECT_DOUBLE_EQ(0.0, empty(0.0));
+
+	SphStdKernel3 stdKernel(0.5);
+	SphKernelTable3<SphStdKernel3> stdTable(stdKernel);
+	SphWendlandKernel3 wendland(0.5);
+	SphKernelTable3<SphWendlandKernel3> wendlandTable(wendland, 4096);
+	EXPECT_EQ(SphKernelTable3<SphStdKernel3>::kDefaultResolution,
+		stdTable.resolution());
+	EXPECT_EQ(4096u, wendlandTable.resolution());
+
+	for (int i = 0; i <= 60; ++i)
+	{
+		double r = 0.01 * i;
+		double r2 = r * r;
+		EXPECT_NEAR(stdKernel(r), stdTable(r2), 1e-3 * stdKernel(0.0));
+		EXPECT_NEAR(wendland(r), wendlandTable(r2), 1e-3 * wendland(0.0));
+
+		if (r > 0.0)
+		{
+			EXPECT_NEAR(
+				-stdKernel.firstDerivative(r) / r,
+				stdTable.gradientScale(r2),
+				1e-3 * stdTable.gradientScale(0.0));
+			EXPECT_NEAR(
+				-wendland.firstDerivative(r) / r,
+				wendlandTable.gradientScale(r2),
+				1e-3 * wendlandTable.gradientScale(0.0));
+		}
+	}
+
+	EXPECT_DOUBLE_EQ(0.0, stdTable(0.25));
+	EXPECT_DOUBLE_EQ(0.0, wendlandTable.gradientScale(1.0));
+}
@@ -1,7 +1,10 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/sph_boundary_particles3.h>
 #include <jet/sph_solver3.h>
 #include <gtest/gtest.h>
+#include <sstream>
+#include <string>
 
 using namespace jet;
 
@@ -57,3 +60,216 @@ TEST(SphSolver3, Parameters) {
 
     EXPECT_TRUE(solver.sphSystemData() != nullptr);
 }
+
+TEST(SphSolver3, Checkpoint) {
+    SphSolver3 solver;
+    solver.setViscosityCoefficient(0.1);
+    solver.setSpeedOfSound(50.0);
+
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    const double targetSpacing = particles->targetSpacing();
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            for (int k = 0; k < 5; ++k) {
+                particles->addParticle(
+                    targetSpacing * Vector3D(i, j, k),
+                    Vector3D(0.1 * i, 0.0, -0.1 * k));
+            }
+        }
+    }
+
+    Frame frame(1, 1.0 / 60.0);
+    for ( ; frame.index < 3; frame.advance()) {
+        solver.update(frame);
+    }
+
+    std::stringstream strm;
+    solver.serialize(&strm);
+
+    SphSolver3 restored;
+    restored.deserialize(&strm);
+    EXPECT_EQ(solver.currentFrame().index, restored.currentFrame().index);
+    EXPECT_DOUBLE_EQ(0.1, restored.viscosityCoefficient());
+    EXPECT_DOUBLE_EQ(50.0, restored.speedOfSound());
+    EXPECT_DOUBLE_EQ(
+        particles->mass(), restored.sphSystemData()->mass());
+
+    Frame restartFrame = frame;
+    for ( ; frame.index < 6; frame.advance()) {
+        solver.update(frame);
+    }
+    for ( ; restartFrame.index < 6; restartFrame.advance()) {
+        restored.update(restartFrame);
+    }
+
+    auto positions = particles->positions();
+    auto restoredPositions = restored.sphSystemData()->positions();
+    ASSERT_EQ(positions.size(), restoredPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_NEAR(0.0, positions[i].distanceTo(restoredPositions[i]), 1e-9);
+    }
+
+    // A checkpoint with a broken tag is rejected
+    std::stringstream badStrm;
+    solver.serialize(&badStrm);
+    std::string data = badStrm.str();
+    data[0] = 'X';
+    badStrm.str(data);
+    EXPECT_THROW(restored.deserialize(&badStrm), std::invalid_argument);
+}
+
+TEST(SphSolver3, PreviewScale) {
+    SphSolver3 solver;
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    particles->setTargetSpacing(0.05);
+    const double kernelRadius = particles->kernelRadius();
+    const double mass = particles->mass();
+
+    Array1<Vector3D> points;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            points.append(0.05 * Vector3D(i, 0.0, j));
+        }
+    }
+    auto boundary = std::make_shared<SphBoundaryParticles3>();
+    boundary->build(points.constAccessor(), kernelRadius);
+    solver.setBoundaryParticles(boundary);
+
+    EXPECT_EQ(1.0, solver.previewScale());
+    EXPECT_THROW(solver.setPreviewScale(0.5), std::invalid_argument);
+
+    solver.setPreviewScale(2.0);
+    EXPECT_EQ(2.0, solver.previewScale());
+    EXPECT_DOUBLE_EQ(0.1, particles->targetSpacing());
+    EXPECT_DOUBLE_EQ(2.0 * kernelRadius, particles->kernelRadius());
+    EXPECT_NEAR(8.0 * mass, particles->mass(), 1e-9 * mass);
+    EXPECT_DOUBLE_EQ(particles->kernelRadius(), boundary->kernelRadius());
+    EXPECT_EQ(points.size(), boundary->numberOfParticles());
+
+    solver.setPreviewScale(1.0);
+    EXPECT_DOUBLE_EQ(0.05, particles->targetSpacing());
+    EXPECT_DOUBLE_EQ(kernelRadius, boundary->kernelRadius());
+}
+
+TEST(SphSolver3, SymmetricPairForces) {
+    SphSolver3 solver;
+    SphSolver3 symmetricSolver;
+    symmetricSolver.setIsUsingSymmetricPairForces(true);
+    EXPECT_TRUE(symmetricSolver.isUsingSymmetricPairForces());
+    EXPECT_FALSE(solver.isUsingSymmetricPairForces());
+
+    for (SphSolver3* s : { &solver, &symmetricSolver }) {
+        s->setViscosityCoefficient(0.1);
+        SphSystemData3Ptr particles = s->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 12; ++i) {
+            for (int j = 0; j < 6; ++j) {
+                for (int k = 0; k < 4; ++k) {
+                    particles->addParticle(
+                        0.9 * targetSpacing * Vector3D(i, j, k),
+                        Vector3D(0.1 * j, -0.2 * k, 0.05 * i));
+                }
+            }
+        }
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 3; frame.advance()) {
+        solver.update(frame);
+        symmetricSolver.update(frame);
+    }
+
+    auto positions = solver.sphSystemData()->positions();
+    auto symmetricPositions = symmetricSolver.sphSystemData()->positions();
+    auto velocities = solver.sphSystemData()->velocities();
+    auto symmetricVelocities = symmetricSolver.sphSystemData()->velocities();
+    ASSERT_EQ(positions.size(), symmetricPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_NEAR(
+            0.0, positions[i].distanceTo(symmetricPositions[i]), 1e-9);
+        EXPECT_NEAR(
+            0.0, velocities[i].distanceTo(symmetricVelocities[i]), 1e-7);
+    }
+}
+
+TEST(SphSolver3, PairKernelCache) {
+    SphSolver3 solver;
+    SphSolver3 cachingSolver;
+    EXPECT_FALSE(cachingSolver.isCachingPairKernels());
+    cachingSolver.setIsCachingPairKernels(true);
+    EXPECT_TRUE(cachingSolver.isCachingPairKernels());
+
+    for (SphSolver3* s : { &solver, &cachingSolver }) {
+        s->setIsUsingSymmetricPairForces(true);
+        s->setViscosityCoefficient(0.1);
+        SphSystemData3Ptr particles = s->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 10; ++i) {
+            for (int j = 0; j < 5; ++j) {
+                for (int k = 0; k < 4; ++k) {
+                    particles->addParticle(
+                        0.85 * targetSpacing * Vector3D(i, j, k + 0.1 * i),
+                        Vector3D(0.1 * j, -0.2 * k, 0.05 * i));
+                }
+            }
+        }
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 3; frame.advance()) {
+        solver.update(frame);
+        cachingSolver.update(frame);
+    }
+
+    // The same up to the summation order of the densities
+    auto particles = solver.sphSystemData();
+    auto cachingParticles = cachingSolver.sphSystemData();
+    auto densities = particles->densities();
+    auto cachingDensities = cachingParticles->densities();
+    auto positions = particles->positions();
+    auto cachingPositions = cachingParticles->positions();
+    auto velocities = particles->velocities();
+    auto cachingVelocities = cachingParticles->velocities();
+    ASSERT_EQ(positions.size(), cachingPositions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_NEAR(densities[i], cachingDensities[i], 1e-9 * densities[i]);
+        EXPECT_NEAR(
+            0.0, positions[i].distanceTo(cachingPositions[i]), 1e-9);
+        EXPECT_NEAR(
+            0.0, velocities[i].distanceTo(cachingVelocities[i]), 1e-7);
+    }
+}
+
+TEST(SphSolver3, FusedStep) {
+    SphSolver3 solver;
+    SphSolver3 fusedSolver;
+    fusedSolver.setIsUsingFusedStep(true);
+
+    for (SphSolver3* s : { &solver, &fusedSolver }) {
+        s->setViscosityCoefficient(0.1);
+        SphSystemData3Ptr particles = s->sphSystemData();
+        const double targetSpacing = particles->targetSpacing();
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 6; ++j) {
+                for (int k = 0; k < 4; ++k) {
+                    particles->addParticle(
+                        0.9 * targetSpacing * Vector3D(i, j, k),
+                        Vector3D(0.1 * j, -0.2 * k, 0.05 * i));
+                }
+            }
+        }
+    }
+
+    for (Frame frame(0, 1.0 / 60.0); frame.index < 3; frame.advance()) {
+        solver.update(frame);
+        fusedSolver.update(frame);
+    }
+
+    // The SPH forces are still accumulated before the fused pass
+    auto data = solver.sphSystemData();
+    auto fusedData = fusedSolver.sphSystemData();
+    ASSERT_EQ(data->numberOfParticles(), fusedData->numberOfParticles());
+    for (size_t i = 0; i < data->numberOfParticles(); ++i) {
+        EXPECT_EQ(data->positions()[i], fusedData->positions()[i]);
+        EXPECT_EQ(data->velocities()[i], fusedData->velocities()[i]);
+        EXPECT_EQ(data->forces()[i], fusedData->forces()[i]);
+    }
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/bcc_lattice_point_generator.h>
+#include <jet/sph_kernels3.h>
+#include <jet/sph_system_data3.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+
+using namespace jet;
+
+namespace {
+
+// Max number density over all the lattice points, computed by brute force
+double computeMaxNumberDensity(double spacing, double kernelRadius) {
+    Array1<Vector3D> points;
+    BccLatticePointGenerator pointsGenerator;
+    double r = 1.5 * kernelRadius;
+    pointsGenerator.generate(
+        BoundingBox3D(Vector3D(-r, -r, -r), Vector3D(r, r, r)),
+        spacing,
+        &points);
+
+    SphStdKernel3 kernel(kernelRadius);
+    double maxNumberDensity = 0.0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        double sum = 0.0;
+        for (size_t j = 0; j < points.size(); ++j) {
+            sum += kernel(points[j].distanceTo(points[i]));
+        }
+        maxNumberDensity = std::max(maxNumberDensity, sum);
+    }
+    return maxNumberDensity;
+}
+
+}  // namespace
+
+TEST(SphSystemData3, Mass) {
+    SphSystemData3 data;
+
+    const double relativeRadii[] = { 0.8, 1.8, 2.5 };
+    for (double relativeRadius : relativeRadii) {
+        data.setRelativeKernelRadius(relativeRadius);
+        double answer = data.targetDensity() / computeMaxNumberDensity(
+            data.targetSpacing(), data.kernelRadius());
+        EXPECT_NEAR(answer, data.mass(), 1e-12 * answer);
+    }
+
+    // Changing the density only rescales the mass
+    double mass = data.mass();
+    data.setTargetDensity(2.0 * data.targetDensity());
+    EXPECT_NEAR(2.0 * mass, data.mass(), 1e-12 * mass);
+
+    data.setTargetSpacing(0.05);
+    double answer = data.targetDensity() / computeMaxNumberDensity(
+        data.targetSpacing(), data.kernelRadius());
+    EXPECT_NEAR(answer, data.mass(), 1e-12 * answer);
+}
+
+TEST(SphSystemData3, KernelLoops) {
+    SphSystemData3 data;
+    data.setTargetSpacing(0.1);
+    data.setRelativeKernelRadius(2.5);
+
+    // Jittered lattice with more neighbors per particle than a gather batch
+    Array1<Vector3D> points;
+    BccLatticePointGenerator pointsGenerator;
+    pointsGenerator.generate(
+        BoundingBox3D(Vector3D(), Vector3D(1, 1, 1)), 0.1, &points);
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> jitter(-0.02, 0.02);
+    for (auto& pt : points) {
+        pt += Vector3D(jitter(rng), jitter(rng), jitter(rng));
+    }
+    data.addParticles(points.accessor());
+    data.buildNeighborSearcher();
+    data.buildNeighborLists();
+    data.updateDensities();
+
+    auto p = data.positions();
+    auto d = data.densities();
+    Array1<double> values(data.numberOfParticles());
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = p[i].x - 2.0 * p[i].y * p[i].z;
+    }
+
+    const double h = data.kernelRadius();
+    const double m = data.mass();
+    SphStdKernel3 stdKernel(h);
+    SphSpikyKernel3 spikyKernel(h);
+    for (size_t i = 0; i < data.numberOfParticles(); i += 7) {
+        double density = 0.0;
+        double interpolated = 0.0;
+        Vector3D gradient;
+        double laplacian = 0.0;
+        for (size_t j = 0; j < data.numberOfParticles(); ++j) {
+            double dist = p[i].distanceTo(p[j]);
+            if (dist >= h) {
+                continue;
+            }
+            density += m * stdKernel(dist);
+            interpolated += m / d[j] * stdKernel(dist) * values[j];
+            if (dist > 0.0) {
+                gradient += d[i] * m
+                    * (values[i] / square(d[i]) + values[j] / square(d[j]))
+                    * spikyKernel.gradient(dist, (p[j] - p[i]) / dist);
+            }
+            laplacian += m * (values[j] - values[i]) / d[j]
+                * spikyKernel.secondDerivative(dist);
+        }
+
+        EXPECT_NEAR(density, d[i], 1e-12 * density);
+        EXPECT_NEAR(
+            interpolated,
+            data.interpolate(p[i], values.constAccessor()),
+            1e-12);
+        Vector3D gradientAt = data.gradientAt(i, values.constAccessor());
+        EXPECT_NEAR(gradient.x, gradientAt.x, 1e-9 * (1.0 + gradient.length()));
+        EXPECT_NEAR(gradient.y, gradientAt.y, 1e-9 * (1.0 + gradient.length()));
+        EXPECT_NEAR(gradient.z, gradientAt.z, 1e-9 * (1.0 + gradient.length()));
+        EXPECT_NEAR(
+            laplacian,
+            data.laplacianAt(i, values.constAccessor()),
+            1e-9 * (1.0 + std::fabs(laplacian)));
+    }
+}
@@ -1,6 +1,9 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array1.h>
 #include <jet/sphere3.h>
+#include <jet/simd.h>
+#include <jet/surface_to_implicit3.h>
 #include <gtest/gtest.h>
 
 using namespace jet;
@@ -136,3 +139,53 @@ TEST(Sphere3, ClosestNormal) {
     EXPECT_DOUBLE_EQ(-1.0, result3.y);
     EXPECT_DOUBLE_EQ(0.0, result3.z);
 }
+
+TEST(Sphere3, BatchClosestSignedDistance) {
+    auto sph = std::make_shared<Sphere3>(Vector3D(0.3, -0.2, 0.1), 1.7);
+    SurfaceToImplicit3 s2i(sph);
+
+    Array1<Vector3D> points;
+    for (int k = -6; k <= 6; ++k) {
+        for (int j = -6; j <= 6; ++j) {
+            for (int i = -6; i <= 6; ++i) {
+                points.append(Vector3D(0.4 * i, 0.45 * j, 0.5 * k));
+            }
+        }
+    }
+
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    const SimdInstructionSet instructionSets[] = {
+        SimdInstructionSet::None,
+        SimdInstructionSet::Sse2,
+        SimdInstructionSet::Neon,
+        SimdInstructionSet::Avx,
+        SimdInstructionSet::Avx512
+    };
+
+    Array1<double> scalarDistances(points.size());
+    Array1<double> distances(points.size());
+    for (bool isFlipped : {false, true}) {
+        sph->isNormalFlipped = isFlipped;
+        for (SimdInstructionSet instructionSet : instructionSets) {
+            if (!isSimdInstructionSetSupported(instructionSet)) {
+                continue;
+            }
+            setSimdInstructionSet(instructionSet);
+
+            sph->batchClosestSignedDistance(
+                points.constAccessor(), distances.accessor());
+            if (instructionSet == SimdInstructionSet::None) {
+                scalarDistances.set(distances);
+            }
+
+            // The closed form agrees with the closest points and normals up
+            // to round-off
+            for (size_t i = 0; i < points.size(); ++i) {
+                EXPECT_EQ(scalarDistances[i], distances[i]);
+                EXPECT_NEAR(s2i.signedDistance(points[i]), distances[i], 1e-12);
+            }
+        }
+    }
+
+    setSimdInstructionSet(oldInstructionSet);
+}
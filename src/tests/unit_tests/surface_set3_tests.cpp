@@ -0,0 +1,75 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/box3.h>
+#include <jet/plane3.h>
+#include <jet/sphere3.h>
+#include <jet/surface_set3.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+using namespace jet;
+
+TEST(SurfaceSet3, ManySurfaces) {
+    SurfaceSet3 sset;
+    std::vector<Surface3Ptr> surfaces;
+
+    surfaces.push_back(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, -8, 0)));
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            Vector3D center(3.0 * i - 7.5, 0.5 * j, 3.0 * j - 7.5);
+            if ((i + j) % 2 == 0) {
+                surfaces.push_back(std::make_shared<Sphere3>(center, 0.5));
+            } else {
+                surfaces.push_back(std::make_shared<Box3>(
+                    center - Vector3D(0.5, 0.5, 0.5),
+                    center + Vector3D(0.5, 0.5, 0.5)));
+            }
+        }
+    }
+
+    for (const auto& surface : surfaces) {
+        sset.addSurface(surface);
+    }
+    EXPECT_EQ(surfaces.size(), sset.numberOfSurfaces());
+
+    for (int n = 0; n < 50; ++n) {
+        Vector3D pt(
+            std::sin(1.3 * n) * 11.0,
+            std::cos(0.7 * n) * 11.0,
+            std::sin(2.1 * n + 1.0) * 11.0);
+
+        double expectedDistance = kMaxD;
+        size_t closest = 0;
+        for (size_t i = 0; i < surfaces.size(); ++i) {
+            double dist = surfaces[i]->closestDistance(pt);
+            if (dist < expectedDistance) {
+                expectedDistance = dist;
+                closest = i;
+            }
+        }
+
+        EXPECT_DOUBLE_EQ(expectedDistance, sset.closestDistance(pt));
+        EXPECT_EQ(closest, sset.closestSurfaceIndex(pt));
+
+        Vector3D expectedPoint = surfaces[closest]->closestPoint(pt);
+        Vector3D actualPoint = sset.closestPoint(pt);
+        EXPECT_DOUBLE_EQ(expectedPoint.x, actualPoint.x);
+        EXPECT_DOUBLE_EQ(expectedPoint.y, actualPoint.y);
+        EXPECT_DOUBLE_EQ(expectedPoint.z, actualPoint.z);
+
+        Vector3D expectedNormal = surfaces[closest]->closestNormal(pt);
+        Vector3D actualNormal = sset.closestNormal(pt);
+        EXPECT_DOUBLE_EQ(expectedNormal.x, actualNormal.x);
+        EXPECT_DOUBLE_EQ(expectedNormal.y, actualNormal.y);
+        EXPECT_DOUBLE_EQ(expectedNormal.z, actualNormal.z);
+
+        Ray3D ray(pt, (Vector3D(0.1, 0.2, 0.3) - pt).normalized());
+        bool expectedHit = false;
+        for (const auto& surface : surfaces) {
+            expectedHit |= surface->intersects(ray);
+        }
+        EXPECT_EQ(expectedHit, sset.intersects(ray));
+    }
+}
@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array1.h>
 #include <jet/box3.h>
 #include <jet/surface_to_implicit3.h>
 #include <gtest/gtest.h>
@@ -128,3 +129,27 @@ TEST(SurfaceToImplicit3, ClosestNormal) {
     EXPECT_DOUBLE_EQ(boxNormal.y, s2iNormal.y);
     EXPECT_DOUBLE_EQ(boxNormal.z, s2iNormal.z);
 }
+
+TEST(SurfaceToImplicit3, BatchSignedDistance) {
+    auto box = std::make_shared<Box3>(BoundingBox3D({0, 0, 0}, {1, 2, 3}));
+    SurfaceToImplicit3 s2i(box);
+
+    Array1<Vector3D> points;
+    for (int i = -2; i < 4; ++i) {
+        for (int j = -2; j < 5; ++j) {
+            points.append(Vector3D(0.4 * i, 0.5 * j, 0.8 * j - 0.3 * i));
+        }
+    }
+
+    Array1<double> distances(points.size());
+    Array1<Vector3D> normals(points.size());
+    for (bool isFlipped : {false, true}) {
+        s2i.isNormalFlipped = isFlipped;
+        s2i.batchSignedDistance(points.constAccessor(), distances.accessor());
+        s2i.batchClosestNormal(points.constAccessor(), normals.accessor());
+        for (size_t i = 0; i < points.size(); ++i) {
+            EXPECT_EQ(s2i.signedDistance(points[i]), distances[i]);
+            EXPECT_EQ(s2i.closestNormal(points[i]), normals[i]);
+        }
+    }
+}
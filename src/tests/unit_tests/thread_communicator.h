@@ -0,0 +1,146 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_TESTS_UNIT_TESTS_THREAD_COMMUNICATOR_H_
+#define SRC_TESTS_UNIT_TESTS_THREAD_COMMUNICATOR_H_
+
+#include <jet/communicator.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jet {
+
+// Shared state of the ranks simulated with threads.
+class ThreadGroup {
+ public:
+    explicit ThreadGroup(int size) : _size(size), _values(size) {}
+
+    int size() const { return _size; }
+
+    double reduce(int rank, double value, bool isMax) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        size_t generation = _generation;
+        _values[rank] = value;
+
+        if (++_numberOfArrivals == _size) {
+            _result = _values[0];
+            for (int i = 1; i < _size; ++i) {
+                _result = isMax
+                    ? std::max(_result, _values[i]) : _result + _values[i];
+            }
+            _numberOfArrivals = 0;
+            ++_generation;
+            _condition.notify_all();
+        } else {
+            _condition.wait(lock, [&] { return _generation != generation; });
+        }
+
+        return _result;
+    }
+
+    void sendReceive(
+        int rank,
+        const void* sendData,
+        size_t sendBytes,
+        int destination,
+        void* receiveData,
+        size_t receiveBytes,
+        int source) {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        if (destination != kNoRank) {
+            const char* bytes = static_cast<const char*>(sendData);
+            _mailboxes[std::make_pair(rank, destination)].emplace_back(
+                bytes, bytes + sendBytes);
+            _condition.notify_all();
+        }
+
+        if (source != kNoRank) {
+            auto& mailbox = _mailboxes[std::make_pair(source, rank)];
+            _condition.wait(lock, [&] { return !mailbox.empty(); });
+            EXPECT_EQ(receiveBytes, mailbox.front().size());
+            std::memcpy(receiveData, mailbox.front().data(), receiveBytes);
+            mailbox.pop_front();
+        }
+    }
+
+ private:
+    int _size;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::vector<double> _values;
+    int _numberOfArrivals = 0;
+    size_t _generation = 0;
+    double _result = 0.0;
+    std::map<std::pair<int, int>, std::deque<std::vector<char>>> _mailboxes;
+};
+
+// Communicator of one rank in a ThreadGroup.
+class ThreadCommunicator final : public Communicator {
+ public:
+    ThreadCommunicator(ThreadGroup* group, int rank)
+    : _group(group), _rank(rank) {}
+
+    int rank() const override { return _rank; }
+
+    int size() const override { return _group->size(); }
+
+    double sum(double value) override {
+        return _group->reduce(_rank, value, false);
+    }
+
+    double max(double value) override {
+        return _group->reduce(_rank, value, true);
+    }
+
+    void sendReceive(
+        const void* sendData,
+        size_t sendBytes,
+        int destination,
+        void* receiveData,
+        size_t receiveBytes,
+        int source) override {
+        _group->sendReceive(
+            _rank,
+            sendData,
+            sendBytes,
+            destination,
+            receiveData,
+            receiveBytes,
+            source);
+    }
+
+ private:
+    ThreadGroup* _group;
+    int _rank;
+};
+
+// Runs the function on each rank of a new ThreadGroup in its own thread.
+inline void runOnThreadRanks(
+    int numberOfRanks,
+    const std::function<void(const CommunicatorPtr&)>& function) {
+    ThreadGroup group(numberOfRanks);
+    std::vector<std::thread> threads;
+    for (int rank = 0; rank < numberOfRanks; ++rank) {
+        threads.emplace_back([&, rank] {
+            function(std::make_shared<ThreadCommunicator>(&group, rank));
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace jet
+
+#endif  // SRC_TESTS_UNIT_TESTS_THREAD_COMMUNICATOR_H_
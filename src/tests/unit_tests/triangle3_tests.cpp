@@ -2,6 +2,7 @@
 
 #include <jet/triangle3.h>
 #include <gtest/gtest.h>
+#include <cmath>
 
 using namespace jet;
 
@@ -55,3 +56,24 @@ TEST(Triangle3, Constructors) {
         }
     }
 }
+
+TEST(Triangle3, ClosestPoint) {
+    Triangle3 tri(
+        {{Vector3D(0, 0, 0), Vector3D(2, 0, 0), Vector3D(0, 2, 0)}},
+        {{Vector3D(0, 0, 1), Vector3D(0, 0, 1), Vector3D(0, 0, 1)}},
+        {{Vector2D(), Vector2D(), Vector2D()}});
+
+    // Inside of the face
+    EXPECT_EQ(Vector3D(0.5, 0.5, 0), tri.closestPoint({0.5, 0.5, 3}));
+
+    // Regions of the corners
+    EXPECT_EQ(Vector3D(0, 0, 0), tri.closestPoint({-1, -1, 1}));
+    EXPECT_EQ(Vector3D(2, 0, 0), tri.closestPoint({3, -1, 0}));
+    EXPECT_EQ(Vector3D(0, 2, 0), tri.closestPoint({-1, 4, 0}));
+
+    // Regions of the edges
+    EXPECT_EQ(Vector3D(1, 0, 0), tri.closestPoint({1, -2, 1}));
+    EXPECT_EQ(Vector3D(0, 1.5, 0), tri.closestPoint({-3, 1.5, -1}));
+    EXPECT_EQ(Vector3D(1.5, 0.5, 0), tri.closestPoint({2.5, 1.5, 0}));
+    EXPECT_DOUBLE_EQ(std::sqrt(2.0), tri.closestDistance({2.5, 1.5, 0}));
+}
@@ -1,10 +1,66 @@
 // Copyright (c) 2016 Doyub Kim
 
+#include <jet/array3.h>
+#include <jet/marching_cubes.h>
+#include <jet/parallel.h>
+#include <jet/simd.h>
 #include <jet/triangle_mesh3.h>
+#include <jet/triangle_mesh_stream_writer3.h>
 #include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace jet;
 
+namespace {
+
+// Marches a sphere of radius 0.35 at the center of the unit cube on a grid
+// of 32^3 cells.
+TriangleMesh3 makeSphereMesh() {
+    const double h = 1.0 / 32.0;
+    Array3<double> grid(33, 33, 33);
+    grid.forEachIndex([&](size_t i, size_t j, size_t k) {
+        grid(i, j, k) = (h * Vector3D({i, j, k})).distanceTo(
+            Vector3D(0.5, 0.5, 0.5)) - 0.35;
+    });
+
+    TriangleMesh3 mesh;
+    marchingCubes(grid.constAccessor(), Vector3D(h, h, h), Vector3D(), &mesh);
+    return mesh;
+}
+
+// Returns true if every edge is shared by exactly two triangles with the
+// opposite directions.
+bool isClosedManifold(const TriangleMesh3& mesh) {
+    std::map<std::pair<size_t, size_t>, int> edges;
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        const Point3UI& face = mesh.pointIndex(t);
+        for (size_t c = 0; c < 3; ++c) {
+            ++edges[std::make_pair(face[c], face[(c + 1) % 3])];
+        }
+    }
+    for (const auto& edge : edges) {
+        auto opposite = edges.find(
+            std::make_pair(edge.first.second, edge.first.first));
+        if (edge.second != 1 || opposite == edges.end()
+            || opposite->second != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
 TEST(TriangleMesh3, Constructors) {
     TriangleMesh3 mesh1;
     EXPECT_EQ(0u, mesh1.numberOfPoints());
@@ -12,3 +68,604 @@ TEST(TriangleMesh3, Constructors) {
     EXPECT_EQ(0u, mesh1.numberOfUvs());
     EXPECT_EQ(0u, mesh1.numberOfTriangles());
 }
+
+TEST(TriangleMesh3, MoveMethods) {
+    TriangleMesh3 mesh1;
+    mesh1.addTriangle(Triangle3(
+        {{Vector3D(0, 0, 0), Vector3D(1, 0, 0), Vector3D(0, 1, 0)}},
+        {{Vector3D(0, 0, 1), Vector3D(0, 0, 1), Vector3D(0, 0, 1)}},
+        {{Vector2D(), Vector2D(), Vector2D()}}));
+    EXPECT_DOUBLE_EQ(0.5, mesh1.closestDistance(Vector3D(0.1, 0.1, 0.5)));
+
+    TriangleMesh3 mesh2(std::move(mesh1));
+    EXPECT_EQ(0u, mesh1.numberOfTriangles());
+    EXPECT_EQ(1u, mesh2.numberOfTriangles());
+    EXPECT_DOUBLE_EQ(0.5, mesh2.closestDistance(Vector3D(0.1, 0.1, 0.5)));
+
+    TriangleMesh3 mesh3;
+    mesh3 = std::move(mesh2);
+    EXPECT_EQ(0u, mesh2.numberOfPoints());
+    EXPECT_EQ(3u, mesh3.numberOfPoints());
+    EXPECT_DOUBLE_EQ(0.25, mesh3.closestDistance(Vector3D(0.1, 0.1, 0.25)));
+}
+
+TEST(TriangleMesh3, BvhQueries) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+
+    // Random soup of small triangles
+    TriangleMesh3 mesh;
+    for (size_t i = 0; i < 2000; ++i) {
+        Vector3D center(d(rng), d(rng), d(rng));
+        for (size_t j = 0; j < 3; ++j) {
+            mesh.addPoint(center + 0.05 * Vector3D(d(rng), d(rng), d(rng)));
+        }
+        mesh.addPointTriangle(Point3UI(3 * i, 3 * i + 1, 3 * i + 2));
+    }
+
+    auto check = [&]() {
+        for (size_t n = 0; n < 100; ++n) {
+            Vector3D pt(2.0 * d(rng), 2.0 * d(rng), 2.0 * d(rng));
+
+            // Brute-force answer
+            double minDist = std::numeric_limits<double>::max();
+            size_t closest = 0;
+            for (size_t i = 0; i < mesh.numberOfTriangles(); ++i) {
+                double dist = mesh.triangle(i).closestDistance(pt);
+                if (dist < minDist) {
+                    minDist = dist;
+                    closest = i;
+                }
+            }
+
+            Triangle3 tri = mesh.triangle(closest);
+            EXPECT_DOUBLE_EQ(minDist, mesh.closestDistance(pt));
+            EXPECT_EQ(tri.closestPoint(pt), mesh.closestPoint(pt));
+            EXPECT_EQ(tri.closestNormal(pt), mesh.closestNormal(pt));
+
+            Ray3D ray(pt, Vector3D(d(rng), d(rng), d(rng)).normalized());
+            bool isIntersecting = false;
+            double t = std::numeric_limits<double>::max();
+            for (size_t i = 0; i < mesh.numberOfTriangles(); ++i) {
+                SurfaceRayIntersection3 result
+                    = mesh.triangle(i).closestIntersection(ray);
+                isIntersecting |= result.isIntersecting;
+                t = std::min(t, result.t);
+            }
+            EXPECT_EQ(isIntersecting, mesh.intersects(ray));
+            EXPECT_DOUBLE_EQ(t, mesh.closestIntersection(ray).t);
+        }
+    };
+
+    check();
+
+    // The BVH follows the transforms
+    mesh.translate(Vector3D(0.5, -0.2, 0.1));
+    mesh.scale(1.5);
+    check();
+
+    // Modification through the accessors needs explicit update
+    mesh.point(0) = Vector3D(3, 3, 3);
+    mesh.refitBvh();
+    check();
+
+    mesh.pointIndex(1) = Point3UI(0, 4, 5);
+    mesh.invalidateBvh();
+    check();
+}
+
+TEST(TriangleMesh3, ConcurrentBvhBuild) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+
+    TriangleMesh3 mesh;
+    for (size_t i = 0; i < 20000; ++i) {
+        Vector3D center(d(rng), d(rng), d(rng));
+        for (size_t j = 0; j < 3; ++j) {
+            mesh.addPoint(center + 0.05 * Vector3D(d(rng), d(rng), d(rng)));
+        }
+        mesh.addPointTriangle(Point3UI(3 * i, 3 * i + 1, 3 * i + 2));
+    }
+
+    std::vector<Vector3D> points(256);
+    for (Vector3D& pt : points) {
+        pt = Vector3D(d(rng), d(rng), d(rng));
+    }
+
+    TriangleMesh3 reference(mesh);
+    std::vector<Vector3D> expected(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        expected[i] = reference.closestPoint(points[i]);
+    }
+
+    // The first queries build the BVH with parallel loops, which may run the
+    // sibling queries of the same mesh on the building thread
+    unsigned int oldNumberOfThreads = maxNumberOfThreads();
+    setMaxNumberOfThreads(8);
+    for (int round = 0; round < 4; ++round) {
+        mesh.invalidateBvh();
+        std::vector<Vector3D> results(points.size());
+        parallelFor(kZeroSize, points.size(), kOneSize, [&](size_t i) {
+            results[i] = mesh.closestPoint(points[i]);
+        });
+        for (size_t i = 0; i < points.size(); ++i) {
+            EXPECT_EQ(expected[i], results[i]);
+        }
+    }
+    setMaxNumberOfThreads(oldNumberOfThreads);
+}
+
+TEST(TriangleMesh3, WritePly) {
+    TriangleMesh3 mesh;
+    mesh.addPoint({0, 0, 0});
+    mesh.addPoint({1, 0, 0});
+    mesh.addPoint({0, 1, 0});
+    mesh.addPoint({0, 0, 1});
+    mesh.addPointTriangle({0, 2, 1});
+    mesh.addPointTriangle({0, 1, 3});
+
+    std::stringstream strm;
+    mesh.writePly(&strm);
+    std::string ply = strm.str();
+
+    std::string header = "end_header\n";
+    size_t bodyBegin = ply.find(header);
+    ASSERT_NE(std::string::npos, bodyBegin);
+    bodyBegin += header.size();
+    EXPECT_NE(std::string::npos, ply.find("element vertex 4\n"));
+    EXPECT_NE(std::string::npos, ply.find("element face 2\n"));
+    EXPECT_EQ(std::string::npos, ply.find("property float nx\n"));
+    EXPECT_EQ(bodyBegin + 4 * 3 * sizeof(float) + 2 * 13, ply.size());
+
+    float pt[3];
+    std::memcpy(pt, &ply[bodyBegin + 3 * sizeof(float)], sizeof(pt));
+    EXPECT_FLOAT_EQ(1.f, pt[0]);
+    EXPECT_FLOAT_EQ(0.f, pt[1]);
+
+    uint32_t face[3];
+    size_t faceBegin = bodyBegin + 4 * 3 * sizeof(float) + 13;
+    EXPECT_EQ(3, ply[faceBegin]);
+    std::memcpy(face, &ply[faceBegin + 1], sizeof(face));
+    EXPECT_EQ(0u, face[0]);
+    EXPECT_EQ(1u, face[1]);
+    EXPECT_EQ(3u, face[2]);
+
+    // Per-vertex normals are written as the vertex properties
+    TriangleMesh3 mesh2;
+    for (size_t i = 0; i < 3; ++i) {
+        mesh2.addPoint(mesh.point(i));
+        mesh2.addNormal({0, 0, 1});
+    }
+    mesh2.addPointNormalTriangle({0, 1, 2}, {0, 1, 2});
+    strm.str("");
+    mesh2.writePly(&strm);
+    EXPECT_NE(std::string::npos, strm.str().find("property float nx\n"));
+
+    mesh2.normalIndex(0) = Point3UI(0, 0, 0);
+    strm.str("");
+    mesh2.writePly(&strm);
+    EXPECT_EQ(std::string::npos, strm.str().find("property float nx\n"));
+}
+
+TEST(TriangleMesh3, BinaryReadWrite) {
+    TriangleMesh3 mesh;
+    mesh.addPoint({0, 0, 0});
+    mesh.addPoint({1, 0, 0});
+    mesh.addPoint({0, 1, 0});
+    mesh.addNormal({0, 0, 1});
+    mesh.addUv({0.5, 0.25});
+    mesh.addPointNormalUvTriangle({0, 1, 2}, {0, 0, 0}, {0, 0, 0});
+
+    std::stringstream strm;
+    mesh.writeBinary(&strm);
+
+    TriangleMesh3 mesh2;
+    EXPECT_TRUE(mesh2.readBinary(&strm));
+    EXPECT_EQ(3u, mesh2.numberOfPoints());
+    EXPECT_EQ(1u, mesh2.numberOfTriangles());
+    EXPECT_EQ(mesh.point(1), mesh2.point(1));
+    EXPECT_EQ(mesh.normal(0), mesh2.normal(0));
+    EXPECT_EQ(mesh.uv(0), mesh2.uv(0));
+    EXPECT_EQ(Point3UI(0, 1, 2), mesh2.pointIndex(0));
+    EXPECT_DOUBLE_EQ(0.5, mesh2.closestDistance({0, 0, 0.5}));
+
+    // Reading appends to the existing mesh
+    strm.clear();
+    strm.seekg(0);
+    EXPECT_TRUE(mesh2.readBinary(&strm));
+    EXPECT_EQ(6u, mesh2.numberOfPoints());
+    EXPECT_EQ(Point3UI(3, 4, 5), mesh2.pointIndex(1));
+    EXPECT_EQ(Point3UI(1, 1, 1), mesh2.normalIndex(1));
+    EXPECT_EQ(Point3UI(1, 1, 1), mesh2.uvIndex(1));
+
+    // Chunks written by the stream writer are relative to their first point
+    std::stringstream chunked;
+    TriangleMeshStreamWriter3 writer(&chunked);
+    writer.write(mesh);
+    writer.write(mesh);
+    EXPECT_EQ(6u, writer.numberOfPoints());
+    EXPECT_EQ(2u, writer.numberOfTriangles());
+
+    TriangleMesh3 mesh3;
+    EXPECT_TRUE(mesh3.readBinary(&chunked));
+    EXPECT_EQ(6u, mesh3.numberOfPoints());
+    EXPECT_EQ(Point3UI(3, 4, 5), mesh3.pointIndex(1));
+
+    std::string truncated = chunked.str();
+    truncated.resize(truncated.size() - 4);
+    std::stringstream truncatedStrm(truncated);
+    TriangleMesh3 mesh4;
+    EXPECT_FALSE(mesh4.readBinary(&truncatedStrm));
+
+    std::stringstream obj("v 0 0 0\n");
+    EXPECT_FALSE(mesh4.readBinary(&obj));
+}
+
+TEST(TriangleMesh3, ReadObjFile) {
+    const std::string filename = "triangle_mesh3_tests_read_obj_file.obj";
+
+    // Large enough to be split into several chunks
+    std::stringstream obj;
+    obj.precision(17);
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+    obj << "# comment\no object\n";
+    for (size_t i = 0; i < 40000; ++i) {
+        obj << "v " << d(rng) << ' ' << d(rng) << ' ' << 1e-30 * d(rng)
+            << '\n';
+        obj << "vt " << d(rng) << '\t' << d(rng) << "\r\n";
+        obj << "vn " << d(rng) << ' ' << d(rng) << ' ' << d(rng) << '\n';
+        if (i % 4 == 3) {
+            size_t j = i - 2;
+            obj << "f " << j << '/' << j << '/' << j << ' '
+                << j + 1 << '/' << j + 1 << '/' << j + 1 << ' '
+                << j + 2 << '/' << j + 2 << '/' << j + 2 << '\n';
+            obj << "f -1//-1 -2//-2 -3//-3 -4//-4\n";
+            obj << "s off\nf -4 -3 -1\n";
+        }
+    }
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        file << obj.str() << "v 1e400 0 0";
+    }
+
+    TriangleMesh3 expected;
+    std::stringstream objStrm(obj.str());
+    EXPECT_TRUE(expected.readObj(&objStrm));
+
+    // The last line is not closed by a new line
+    TriangleMesh3 mesh;
+    EXPECT_TRUE(mesh.readObj(filename));
+    ASSERT_EQ(expected.numberOfPoints() + 1, mesh.numberOfPoints());
+    ASSERT_EQ(expected.numberOfNormals(), mesh.numberOfNormals());
+    ASSERT_EQ(expected.numberOfUvs(), mesh.numberOfUvs());
+    ASSERT_EQ(expected.numberOfTriangles(), mesh.numberOfTriangles());
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), mesh.point(40000).x);
+    for (size_t i = 0; i < expected.numberOfPoints(); ++i) {
+        EXPECT_EQ(expected.point(i), mesh.point(i));
+        EXPECT_EQ(expected.normal(i), mesh.normal(i));
+        EXPECT_EQ(expected.uv(i), mesh.uv(i));
+    }
+    for (size_t i = 0; i < expected.numberOfTriangles(); ++i) {
+        EXPECT_EQ(expected.pointIndex(i), mesh.pointIndex(i));
+    }
+
+    // Out-of-range indices keep the mesh unchanged
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        file << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n";
+    }
+    EXPECT_FALSE(mesh.readObj(filename));
+    EXPECT_EQ(expected.numberOfPoints() + 1, mesh.numberOfPoints());
+    EXPECT_EQ(expected.numberOfTriangles(), mesh.numberOfTriangles());
+
+    std::remove(filename.c_str());
+    EXPECT_FALSE(mesh.readObj(filename));
+}
+
+TEST(TriangleMesh3, SetAngleWeightedVertexNormal) {
+    TriangleMesh3 mesh = makeSphereMesh();
+    mesh.setAngleWeightedVertexNormal();
+    ASSERT_EQ(mesh.numberOfPoints(), mesh.numberOfNormals());
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        EXPECT_EQ(mesh.pointIndex(t), mesh.normalIndex(t));
+    }
+
+    // The normals point away from the center
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        Vector3D radial = (mesh.point(i) - Vector3D(0.5, 0.5, 0.5));
+        EXPECT_GT(
+            mesh.normal(i).normalized().dot(radial.normalized()), 0.95);
+    }
+}
+
+TEST(TriangleMesh3, AreaVolumeAndFaceNormals) {
+    TriangleMesh3 mesh = makeSphereMesh();
+
+    // Close to the sphere of radius 0.35
+    const double r = 0.35;
+    EXPECT_NEAR(4.0 * kPiD * r * r, mesh.area(), 0.01);
+    EXPECT_NEAR(4.0 / 3.0 * kPiD * r * r * r, mesh.volume(), 0.002);
+
+    mesh.setFaceNormal();
+    ASSERT_EQ(mesh.numberOfPoints(), mesh.numberOfNormals());
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        EXPECT_EQ(mesh.pointIndex(t), mesh.normalIndex(t));
+    }
+
+    // Each point has the normal of its last triangle
+    std::vector<size_t> lastTriangles(mesh.numberOfPoints(), kMaxSize);
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        for (size_t c = 0; c < 3; ++c) {
+            lastTriangles[mesh.pointIndex(t)[c]] = t;
+        }
+    }
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        ASSERT_NE(kMaxSize, lastTriangles[i]);
+        EXPECT_EQ(
+            mesh.triangle(lastTriangles[i]).faceNormal(), mesh.normal(i));
+    }
+}
+
+TEST(TriangleMesh3, RigidTransform) {
+    TriangleMesh3 mesh = makeSphereMesh();
+    mesh.setAngleWeightedVertexNormal();
+    double area = mesh.area();
+    double volume = mesh.volume();
+
+    const Vector3D translation(0.3, -0.2, 0.5);
+    const QuaternionD orientation(Vector3D(1, 2, 3).normalized(), 0.7);
+
+    // Builds the BVH before setting the transform, which keeps it
+    TriangleMesh3 lazy(mesh);
+    lazy.closestDistance(Vector3D());
+    lazy.setTransform(translation, orientation);
+    EXPECT_TRUE(lazy.hasTransform());
+    EXPECT_EQ(mesh.point(0), lazy.point(0));
+
+    TriangleMesh3 baked(lazy);
+    baked.bakeTransform();
+    EXPECT_FALSE(baked.hasTransform());
+
+    TriangleMesh3 eager(mesh);
+    eager.rotate(orientation);
+    eager.translate(translation);
+
+    EXPECT_NEAR(area, lazy.area(), 1e-12);
+    EXPECT_NEAR(volume, lazy.volume(), 1e-12);
+    EXPECT_NEAR(volume, baked.volume(), 1e-9);
+
+    BoundingBox3D box = lazy.boundingBox();
+    BoundingBox3D bakedBox = baked.boundingBox();
+    EXPECT_LT(box.lowerCorner.distanceTo(bakedBox.lowerCorner), 1e-12);
+    EXPECT_LT(box.upperCorner.distanceTo(bakedBox.upperCorner), 1e-12);
+
+    // Rays toward the center of the sphere
+    const Vector3D center = orientation * Vector3D(0.5, 0.5, 0.5) + translation;
+    Array1<Vector3D> points;
+    Array1<Ray3D> rays;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<> d(-0.5, 1.5);
+    for (size_t i = 0; i < 100; ++i) {
+        Vector3D pt(d(rng), d(rng), d(rng));
+        points.append(pt);
+        rays.append(Ray3D(
+            pt, (center - pt).normalized()));
+    }
+
+    Array1<Vector3D> closestPoints(points.size());
+    Array1<double> distances(points.size());
+    Array1<Vector3D> normals(points.size());
+    Array1<SurfaceRayIntersection3> intersections(rays.size());
+    lazy.batchClosestPoint(points.constAccessor(), closestPoints.accessor());
+    lazy.batchClosestDistance(points.constAccessor(), distances.accessor());
+    lazy.batchClosestNormal(points.constAccessor(), normals.accessor());
+    lazy.batchClosestIntersection(
+        rays.constAccessor(), intersections.accessor());
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        const Vector3D& pt = points[i];
+        EXPECT_NEAR(baked.closestDistance(pt), lazy.closestDistance(pt), 1e-9);
+        EXPECT_NEAR(eager.closestDistance(pt), lazy.closestDistance(pt), 1e-9);
+        EXPECT_LT(
+            baked.closestPoint(pt).distanceTo(lazy.closestPoint(pt)), 1e-9);
+
+        // The closest triangles can differ for the points equidistant to
+        // two triangles, so the normals are only close
+        EXPECT_GT(baked.closestNormal(pt).dot(lazy.closestNormal(pt)), 0.99);
+
+        EXPECT_EQ(lazy.closestPoint(pt), closestPoints[i]);
+        EXPECT_EQ(lazy.closestDistance(pt), distances[i]);
+        EXPECT_EQ(lazy.closestNormal(pt), normals[i]);
+
+        SurfaceRayIntersection3 expected = baked.closestIntersection(rays[i]);
+        SurfaceRayIntersection3 actual = lazy.closestIntersection(rays[i]);
+        EXPECT_EQ(expected.isIntersecting, actual.isIntersecting);
+        EXPECT_EQ(baked.intersects(rays[i]), lazy.intersects(rays[i]));
+        EXPECT_NEAR(expected.t, actual.t, 1e-9);
+        EXPECT_LT(expected.point.distanceTo(actual.point), 1e-9);
+        EXPECT_LT(expected.normal.distanceTo(actual.normal), 1e-9);
+
+        EXPECT_EQ(actual.t, intersections[i].t);
+        EXPECT_EQ(actual.point, intersections[i].point);
+        EXPECT_EQ(actual.normal, intersections[i].normal);
+    }
+
+    // The copies and the moves carry the transform
+    TriangleMesh3 moved(std::move(lazy));
+    EXPECT_FALSE(lazy.hasTransform());
+    EXPECT_EQ(translation, moved.translation());
+    EXPECT_LT(
+        baked.closestPoint(points[0]).distanceTo(
+            moved.closestPoint(points[0])), 1e-9);
+
+    moved.setTransform(Vector3D(), QuaternionD());
+    EXPECT_FALSE(moved.hasTransform());
+    EXPECT_EQ(mesh.closestPoint(points[0]), moved.closestPoint(points[0]));
+}
+
+TEST(TriangleMesh3, DecimateFlat) {
+    // Unit square of 10 x 10 quads on the plane z = 0
+    TriangleMesh3 mesh;
+    const size_t n = 10;
+    for (size_t j = 0; j <= n; ++j) {
+        for (size_t i = 0; i <= n; ++i) {
+            mesh.addPoint(Vector3D(0.1 * i, 0.1 * j, 0.0));
+        }
+    }
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < n; ++i) {
+            size_t p = i + (n + 1) * j;
+            mesh.addPointTriangle(Point3UI(p, p + 1, p + n + 2));
+            mesh.addPointTriangle(Point3UI(p, p + n + 2, p + n + 1));
+        }
+    }
+
+    mesh.decimate(1e-6);
+
+    // Only the boundary points remain, and the area is kept
+    EXPECT_EQ(4 * n, mesh.numberOfPoints());
+    EXPECT_EQ(4 * n - 2, mesh.numberOfTriangles());
+    EXPECT_NEAR(1.0, mesh.area(), 1e-12);
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        Vector3D p = mesh.point(i);
+        EXPECT_EQ(0.0, p.z);
+        EXPECT_TRUE(p.x < 1e-9 || p.x > 1.0 - 1e-9
+            || p.y < 1e-9 || p.y > 1.0 - 1e-9);
+    }
+    EXPECT_FALSE(mesh.hasNormals());
+}
+
+TEST(TriangleMesh3, DecimateSphere) {
+    const double h = 1.0 / 32.0;
+    TriangleMesh3 mesh = makeSphereMesh();
+    ASSERT_TRUE(isClosedManifold(mesh));
+    const size_t numberOfTriangles = mesh.numberOfTriangles();
+    const double volume = mesh.volume();
+
+    mesh.decimate(0.1 * h);
+    EXPECT_LT(mesh.numberOfTriangles(), 0.6 * numberOfTriangles);
+    EXPECT_TRUE(isClosedManifold(mesh));
+    EXPECT_NEAR(volume, mesh.volume(), 0.01 * volume);
+
+    // The remaining points do not move, and the vertex normals of marching
+    // cubes are kept
+    ASSERT_EQ(mesh.numberOfPoints(), mesh.numberOfNormals());
+    for (size_t i = 0; i < mesh.numberOfPoints(); ++i) {
+        Vector3D radial = (mesh.point(i) - Vector3D(0.5, 0.5, 0.5));
+        EXPECT_NEAR(0.35, radial.length(), 0.05 * h);
+        EXPECT_GT(mesh.normal(i).dot(radial.normalized()), 0.95);
+    }
+    for (size_t t = 0; t < mesh.numberOfTriangles(); ++t) {
+        EXPECT_EQ(mesh.pointIndex(t), mesh.normalIndex(t));
+    }
+
+    // A larger error removes more
+    size_t numberOfDecimated = mesh.numberOfTriangles();
+    mesh.decimate(0.5 * h);
+    EXPECT_LT(mesh.numberOfTriangles(), numberOfDecimated);
+    EXPECT_TRUE(isClosedManifold(mesh));
+}
+
+TEST(TriangleMesh3, BatchQueries) {
+    TriangleMesh3 mesh = makeSphereMesh();
+
+    // Points on a grid and rays from a plane toward the sphere
+    Array1<Vector3D> points;
+    Array1<Ray3D> rays;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<> d(-0.2, 0.2);
+    for (size_t j = 0; j < 15; ++j) {
+        for (size_t i = 0; i < 15; ++i) {
+            Vector3D pt(0.07 * i, 0.07 * j, 0.45);
+            points.append(pt);
+            rays.append(Ray3D(
+                pt - Vector3D(0, 0, 1),
+                Vector3D(d(rng), d(rng), 1.0).normalized()));
+        }
+    }
+
+    Array1<Vector3D> closestPoints(points.size());
+    Array1<double> distances(points.size());
+    Array1<Vector3D> normals(points.size());
+    Array1<SurfaceRayIntersection3> intersections(rays.size());
+    for (bool isFlipped : {false, true}) {
+        mesh.isNormalFlipped = isFlipped;
+        mesh.batchClosestPoint(
+            points.constAccessor(), closestPoints.accessor());
+        mesh.batchClosestDistance(points.constAccessor(), distances.accessor());
+        mesh.batchClosestNormal(points.constAccessor(), normals.accessor());
+        mesh.batchClosestIntersection(
+            rays.constAccessor(), intersections.accessor());
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            EXPECT_EQ(mesh.closestPoint(points[i]), closestPoints[i]);
+            EXPECT_EQ(mesh.closestDistance(points[i]), distances[i]);
+            EXPECT_EQ(mesh.closestNormal(points[i]), normals[i]);
+
+            SurfaceRayIntersection3 expected
+                = mesh.closestIntersection(rays[i]);
+            EXPECT_EQ(expected.isIntersecting, intersections[i].isIntersecting);
+            EXPECT_EQ(expected.t, intersections[i].t);
+            EXPECT_EQ(expected.point, intersections[i].point);
+            EXPECT_EQ(expected.normal, intersections[i].normal);
+        }
+    }
+
+    // An empty mesh reports no surface
+    TriangleMesh3 empty;
+    empty.batchClosestDistance(points.constAccessor(), distances.accessor());
+    EXPECT_EQ(std::numeric_limits<double>::max(), distances[0]);
+}
+
+TEST(TriangleMesh3, ClosestPointInstructionSets) {
+    TriangleMesh3 mesh = makeSphereMesh();
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<> d(-0.2, 1.2);
+    Array1<Vector3D> points(333);
+    for (auto& pt : points) {
+        pt = Vector3D(d(rng), d(rng), d(rng));
+    }
+
+    // Brute-force answers, which may pick another one of the triangles that
+    // share the closest point
+    Array1<double> expected(points.size());
+    for (size_t n = 0; n < points.size(); ++n) {
+        expected[n] = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < mesh.numberOfTriangles(); ++i) {
+            expected[n] = std::min(
+                expected[n], mesh.triangle(i).closestDistance(points[n]));
+        }
+    }
+
+    Array1<Vector3D> scalarPoints(points.size());
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    setSimdInstructionSet(SimdInstructionSet::None);
+    mesh.batchClosestPoint(points.constAccessor(), scalarPoints.accessor());
+    for (size_t n = 0; n < points.size(); ++n) {
+        EXPECT_DOUBLE_EQ(expected[n], points[n].distanceTo(scalarPoints[n]));
+    }
+
+    // Identical to the scalar kernel
+    Array1<Vector3D> closestPoints(points.size());
+    Array1<double> distances(points.size());
+    for (SimdInstructionSet instructionSet : {
+            SimdInstructionSet::Sse2, SimdInstructionSet::Neon,
+            SimdInstructionSet::Avx, SimdInstructionSet::Avx512 }) {
+        if (!isSimdInstructionSetSupported(instructionSet)) {
+            continue;
+        }
+        setSimdInstructionSet(instructionSet);
+
+        mesh.batchClosestPoint(
+            points.constAccessor(), closestPoints.accessor());
+        mesh.batchClosestDistance(points.constAccessor(), distances.accessor());
+        for (size_t n = 0; n < points.size(); ++n) {
+            EXPECT_EQ(scalarPoints[n], mesh.closestPoint(points[n]));
+            EXPECT_EQ(scalarPoints[n], closestPoints[n]);
+            EXPECT_EQ(points[n].distanceTo(scalarPoints[n]), distances[n]);
+        }
+    }
+    setSimdInstructionSet(oldInstructionSet);
+}
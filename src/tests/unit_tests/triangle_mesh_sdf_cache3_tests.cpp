@@ -0,0 +1,99 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <triangle_mesh_test_shapes.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/triangle_mesh_sdf_cache3.h>
+#include <jet/triangle_mesh_to_sdf.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+using namespace jet;
+
+namespace {
+
+bool fileExists(const std::string& filename) {
+    return std::ifstream(filename.c_str()).good();
+}
+
+}  // namespace
+
+TEST(TriangleMeshSdfCache3, Key) {
+    TriangleMesh3 mesh = makeCube();
+    VertexCenteredScalarGrid3 grid(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+
+    uint64_t key = TriangleMeshSdfCache3::key(mesh, grid);
+    EXPECT_EQ(key, TriangleMeshSdfCache3::key(mesh, grid));
+    EXPECT_NE(key, TriangleMeshSdfCache3::key(mesh, grid, 2));
+    EXPECT_NE(key, TriangleMeshSdfCache3::key(mesh, grid, 1, true));
+
+    CellCenteredScalarGrid3 cellGrid(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+    EXPECT_NE(key, TriangleMeshSdfCache3::key(mesh, cellGrid));
+
+    // The normals do not change the field
+    TriangleMesh3 withNormals = mesh;
+    withNormals.addNormal({0, 0, 1});
+    EXPECT_EQ(key, TriangleMeshSdfCache3::key(withNormals, grid));
+
+    TriangleMesh3 moved = mesh;
+    moved.point(7) = Vector3D(1, 1, 1.01);
+    EXPECT_NE(key, TriangleMeshSdfCache3::key(moved, grid));
+
+    TriangleMeshSdfCache3 cache("cache/");
+    EXPECT_EQ("cache/00000000000000ff.sdfcache", cache.filename(255));
+    EXPECT_EQ("00000000000000ff.sdfcache",
+              TriangleMeshSdfCache3("").filename(255));
+}
+
+TEST(TriangleMeshSdfCache3, Bake) {
+    TriangleMesh3 mesh = makeCube();
+    TriangleMeshSdfCache3 cache(".");
+
+    VertexCenteredScalarGrid3 expected(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+    triangleMeshToSdf(mesh, &expected);
+
+    std::string filename
+        = cache.filename(TriangleMeshSdfCache3::key(mesh, expected));
+    std::remove(filename.c_str());
+
+    VertexCenteredScalarGrid3 first(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+    EXPECT_FALSE(cache.bake(mesh, &first));
+    EXPECT_TRUE(fileExists(filename));
+
+    VertexCenteredScalarGrid3 second(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+    EXPECT_TRUE(cache.bake(mesh, &second));
+
+    expected.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(expected(i, j, k), first(i, j, k));
+        EXPECT_EQ(expected(i, j, k), second(i, j, k));
+    });
+
+    // A corrupted file is generated again
+    {
+        std::ofstream file(filename.c_str(), std::ofstream::binary);
+        file << "corrupted";
+    }
+    VertexCenteredScalarGrid3 third(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+    EXPECT_FALSE(cache.bake(mesh, &third));
+    EXPECT_TRUE(cache.bake(mesh, &third));
+    expected.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(expected(i, j, k), third(i, j, k));
+    });
+
+    std::remove(filename.c_str());
+
+    // A directory that does not exist only skips the cache
+    TriangleMeshSdfCache3 missing("triangle_mesh_sdf_cache3_tests_missing");
+    VertexCenteredScalarGrid3 fourth(
+        Size3(10, 10, 10), Vector3D(0.2, 0.2, 0.2), Vector3D(-0.5, -0.5, -0.5));
+    EXPECT_FALSE(missing.bake(mesh, &fourth));
+    EXPECT_FALSE(missing.bake(mesh, &fourth));
+    EXPECT_EQ(expected(5, 5, 5), fourth(5, 5, 5));
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_TESTS_UNIT_TESTS_TRIANGLE_MESH_TEST_SHAPES_H_
+#define SRC_TESTS_UNIT_TESTS_TRIANGLE_MESH_TEST_SHAPES_H_
+
+#include <jet/triangle_mesh3.h>
+
+namespace jet {
+
+// Unit cube with two triangles per face
+inline TriangleMesh3 makeCube() {
+    TriangleMesh3 triMesh;
+
+    triMesh.addPoint({0, 0, 0});
+    triMesh.addPoint({0, 0, 1});
+    triMesh.addPoint({0, 1, 0});
+    triMesh.addPoint({0, 1, 1});
+    triMesh.addPoint({1, 0, 0});
+    triMesh.addPoint({1, 0, 1});
+    triMesh.addPoint({1, 1, 0});
+    triMesh.addPoint({1, 1, 1});
+
+    triMesh.addPointTriangle({0, 1, 3});
+    triMesh.addPointTriangle({0, 3, 2});
+    triMesh.addPointTriangle({4, 6, 7});
+    triMesh.addPointTriangle({4, 7, 5});
+    triMesh.addPointTriangle({0, 4, 5});
+    triMesh.addPointTriangle({0, 5, 1});
+    triMesh.addPointTriangle({2, 3, 7});
+    triMesh.addPointTriangle({2, 7, 6});
+    triMesh.addPointTriangle({0, 2, 6});
+    triMesh.addPointTriangle({0, 6, 4});
+    triMesh.addPointTriangle({1, 5, 7});
+    triMesh.addPointTriangle({1, 7, 3});
+
+    return triMesh;
+}
+
+// Unit cube whose faces are split into n x n quads of two triangles each
+inline TriangleMesh3 makeTessellatedCube(size_t n) {
+    TriangleMesh3 triMesh;
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        size_t u = (axis + 1) % 3;
+        size_t v = (axis + 2) % 3;
+        for (size_t side = 0; side < 2; ++side) {
+            size_t base = triMesh.numberOfPoints();
+            for (size_t b = 0; b <= n; ++b) {
+                for (size_t a = 0; a <= n; ++a) {
+                    Vector3D point;
+                    point[axis] = static_cast<double>(side);
+                    point[u] = static_cast<double>(a) / n;
+                    point[v] = static_cast<double>(b) / n;
+                    triMesh.addPoint(point);
+                }
+            }
+            for (size_t b = 0; b < n; ++b) {
+                for (size_t a = 0; a < n; ++a) {
+                    size_t p0 = base + a + (n + 1) * b;
+                    size_t p1 = p0 + 1;
+                    size_t p2 = p0 + n + 1;
+                    size_t p3 = p2 + 1;
+                    if (side == 0) {
+                        triMesh.addPointTriangle(Point3UI(p0, p2, p3));
+                        triMesh.addPointTriangle(Point3UI(p0, p3, p1));
+                    } else {
+                        triMesh.addPointTriangle(Point3UI(p0, p1, p3));
+                        triMesh.addPointTriangle(Point3UI(p0, p3, p2));
+                    }
+                }
+            }
+        }
+    }
+
+    return triMesh;
+}
+
+}  // namespace jet
+
+#endif  // SRC_TESTS_UNIT_TESTS_TRIANGLE_MESH_TEST_SHAPES_H_
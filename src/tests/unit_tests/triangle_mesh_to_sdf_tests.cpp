@@ -0,0 +1,101 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <triangle_mesh_test_shapes.h>
+#include <jet/array3.h>
+#include <jet/box3.h>
+#include <jet/triangle_mesh_to_sdf.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(TriangleMeshToSdf, Cube) {
+    TriangleMesh3 triMesh = makeCube();
+    Box3 box(Vector3D(), Vector3D(1, 1, 1));
+
+    // The grid extends beyond the mesh on the lower side
+    VertexCenteredScalarGrid3 grid(
+        20, 20, 20, 0.1, 0.1, 0.1, -0.52, -0.51, -0.53);
+
+    triangleMeshToSdf(triMesh, &grid);
+
+    auto pos = grid.dataPosition();
+    grid.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        Vector3D x = pos(i, j, k);
+        double answer = box.closestDistance(x);
+        if (box.boundingBox().contains(x)) {
+            answer = -answer;
+        }
+        EXPECT_NEAR(answer, grid(i, j, k), 1e-9)
+            << i << ", " << j << ", " << k;
+    });
+}
+
+TEST(TriangleMeshToSdf, NarrowBand) {
+    TriangleMesh3 triMesh = makeCube();
+
+    VertexCenteredScalarGrid3 grid0(
+        20, 20, 20, 0.1, 0.1, 0.1, -0.52, -0.51, -0.53);
+    VertexCenteredScalarGrid3 grid1(
+        20, 20, 20, 0.1, 0.1, 0.1, -0.52, -0.51, -0.53);
+
+    triangleMeshToSdf(triMesh, &grid0, 2);
+    triangleMeshToSdf(triMesh, &grid1, 2, true);
+
+    // Same within the band, and clamped outside of it
+    grid0.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+        if (std::fabs(grid0(i, j, k)) < 0.2) {
+            EXPECT_DOUBLE_EQ(grid0(i, j, k), grid1(i, j, k))
+                << i << ", " << j << ", " << k;
+        } else {
+            EXPECT_DOUBLE_EQ(
+                (grid0(i, j, k) < 0.0) ? -0.2 : 0.2, grid1(i, j, k))
+                << i << ", " << j << ", " << k;
+        }
+    });
+}
+
+TEST(StreamingTriangleMeshToSdf3, MatchesNarrowBand) {
+    // Enough triangles for the bins to be spilled to the scratch file
+    TriangleMesh3 triMesh = makeTessellatedCube(40);
+
+    VertexCenteredScalarGrid3 grid(
+        20, 20, 20, 0.1, 0.1, 0.1, -0.52, -0.51, -0.53);
+    triangleMeshToSdf(triMesh, &grid, 2, true);
+
+    StreamingTriangleMeshToSdf3 generator(
+        grid.dataSize(), grid.gridSpacing(), grid.dataOrigin(), 2, 4);
+    for (size_t t = 0; t < triMesh.numberOfTriangles(); ++t) {
+        Point3UI indices = triMesh.pointIndex(t);
+        generator.addTriangle(
+            triMesh.point(indices.x),
+            triMesh.point(indices.y),
+            triMesh.point(indices.z));
+    }
+    EXPECT_EQ(triMesh.numberOfTriangles(), generator.numberOfTriangles());
+
+    // Generates twice to check that the bins are kept
+    for (int pass = 0; pass < 2; ++pass) {
+        Array3<double> result(grid.dataSize(), 0.0);
+        size_t nextK = 0;
+
+        generator.generate(
+            [&](size_t kBegin, const ConstArrayAccessor3<double>& slab) {
+                EXPECT_EQ(nextK, kBegin);
+                EXPECT_EQ(grid.dataSize().x, slab.width());
+                EXPECT_EQ(grid.dataSize().y, slab.height());
+                EXPECT_GE(4u, slab.depth());
+
+                slab.forEachIndex([&](size_t i, size_t j, size_t k) {
+                    result(i, j, kBegin + k) = slab(i, j, k);
+                });
+                nextK = kBegin + slab.depth();
+            });
+        EXPECT_EQ(grid.dataSize().z, nextK);
+
+        grid.forEachDataPointIndex([&](size_t i, size_t j, size_t k) {
+            EXPECT_EQ(grid(i, j, k), result(i, j, k))
+                << i << ", " << j << ", " << k;
+        });
+    }
+}
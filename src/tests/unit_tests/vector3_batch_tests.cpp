@@ -0,0 +1,153 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <jet/array3.h>
+#include <jet/simd.h>
+#include <jet/vector3_batch.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+using namespace jet;
+
+namespace {
+
+Array1<Vector3D> makeRandomVectors(size_t n, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+    Array1<Vector3D> vectors(n);
+    for (size_t i = 0; i < n; ++i) {
+        vectors[i] = Vector3D(d(rng), d(rng), d(rng));
+    }
+    return vectors;
+}
+
+}  // namespace
+
+TEST(Vector3Batch, Constructors) {
+    Vector3Batch batch;
+    EXPECT_EQ(0u, batch.size());
+
+    Vector3Batch batch2(5);
+    EXPECT_EQ(5u, batch2.size());
+    EXPECT_EQ(Vector3D(), batch2.at(4));
+
+    batch2.setAt(2, Vector3D(1, 2, 3));
+    EXPECT_EQ(Vector3D(1, 2, 3), batch2.at(2));
+    EXPECT_DOUBLE_EQ(1.0, batch2.x()[2]);
+    EXPECT_DOUBLE_EQ(2.0, batch2.y()[2]);
+    EXPECT_DOUBLE_EQ(3.0, batch2.z()[2]);
+}
+
+TEST(Vector3Batch, LoadAndStore) {
+    Array1<Vector3D> vectors = makeRandomVectors(37, 0);
+    Vector3Batch batch(vectors.constAccessor());
+    ASSERT_EQ(37u, batch.size());
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        EXPECT_EQ(vectors[i], batch.at(i));
+    }
+
+    Array1<Vector3D> stored(37);
+    batch.store(stored.accessor());
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        EXPECT_EQ(vectors[i], stored[i]);
+    }
+
+    Array3<Vector3D> grid(3, 4, 5, Vector3D(1, 2, 3));
+    grid(2, 3, 4) = Vector3D(4, 5, 6);
+    batch.load(grid.constAccessor());
+    ASSERT_EQ(60u, batch.size());
+    EXPECT_EQ(Vector3D(4, 5, 6), batch.at(59));
+
+    Array3<Vector3D> grid2(3, 4, 5);
+    batch.store(grid2.accessor());
+    grid.forEachIndex([&](size_t i, size_t j, size_t k) {
+        EXPECT_EQ(grid(i, j, k), grid2(i, j, k));
+    });
+
+    EXPECT_THROW(batch.store(stored.accessor()), std::invalid_argument);
+}
+
+TEST(Vector3Batch, Operations) {
+    // Not a multiple of any SIMD width and more than one parallel chunk
+    const size_t n = 10003;
+    Array1<Vector3D> a = makeRandomVectors(n, 1);
+    Array1<Vector3D> b = makeRandomVectors(n, 2);
+    Vector3Batch batchA(a.constAccessor());
+    Vector3Batch batchB(b.constAccessor());
+
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    for (SimdInstructionSet instructionSet : {
+            SimdInstructionSet::None, SimdInstructionSet::Sse2,
+            SimdInstructionSet::Neon, SimdInstructionSet::Avx,
+            SimdInstructionSet::Avx512 }) {
+        if (!isSimdInstructionSetSupported(instructionSet)) {
+            continue;
+        }
+        setSimdInstructionSet(instructionSet);
+
+        Array1<double> dots(n);
+        Array1<double> lengths(n);
+        batchA.dot(batchB, dots.accessor());
+        batchA.length(lengths.accessor());
+
+        Vector3Batch normalized(a.constAccessor());
+        normalized.normalize();
+
+        Vector3Batch axpy(n);
+        Vector3Batch::axpy(0.3, batchA, batchB, &axpy);
+
+        // Identical to the scalar operations
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(a[i].dot(b[i]), dots[i]);
+            EXPECT_EQ(a[i].length(), lengths[i]);
+            EXPECT_EQ(a[i].normalized(), normalized.at(i));
+            EXPECT_EQ(0.3 * a[i] + b[i], axpy.at(i));
+        }
+    }
+    setSimdInstructionSet(oldInstructionSet);
+}
+
+TEST(Vector3Batch, Transform) {
+    const size_t n = 10003;
+    Array1<Vector3D> a = makeRandomVectors(n, 3);
+    const Matrix3x3D matrix(
+        0.3, -1.2, 0.5,
+        2.0, 0.1, -0.7,
+        -0.4, 0.9, 1.5);
+    const Vector3D translation(0.25, -3.0, 1.0);
+
+    const SimdInstructionSet oldInstructionSet = simdInstructionSet();
+    for (SimdInstructionSet instructionSet : {
+            SimdInstructionSet::None, SimdInstructionSet::Sse2,
+            SimdInstructionSet::Neon, SimdInstructionSet::Avx,
+            SimdInstructionSet::Avx512 }) {
+        if (!isSimdInstructionSetSupported(instructionSet)) {
+            continue;
+        }
+        setSimdInstructionSet(instructionSet);
+
+        Vector3Batch linear(a.constAccessor());
+        linear.transform(matrix);
+        Vector3Batch affine(a.constAccessor());
+        affine.transform(matrix, translation);
+
+        // Identical to the scalar operations
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(matrix.mul(a[i]), linear.at(i));
+            EXPECT_EQ(matrix.mul(a[i]) + translation, affine.at(i));
+        }
+    }
+    setSimdInstructionSet(oldInstructionSet);
+
+    Vector3Batch empty;
+    empty.transform(matrix, translation);
+    EXPECT_EQ(0u, empty.size());
+}
+
+TEST(Vector3Batch, NormalizeZero) {
+    Vector3Batch batch(9);
+    batch.setAt(0, Vector3D(3, 0, 4));
+    batch.normalize();
+    EXPECT_EQ(Vector3D(0.6, 0.0, 0.8), batch.at(0));
+    EXPECT_TRUE(std::isnan(batch.at(8).x));
+}
@@ -298,3 +298,24 @@ TEST(VertexCenteredScalarGrid3, Serialization) {
     EXPECT_DOUBLE_EQ(1.0, grid2.gridSpacing().y);
     EXPECT_DOUBLE_EQ(1.0, grid2.gridSpacing().z);
 }
+
+TEST(VertexCenteredScalarGrid3F, Basics) {
+    VertexCenteredScalarGrid3F grid(5, 4, 6, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0);
+    EXPECT_EQ(6u, grid.dataSize().x);
+    EXPECT_EQ(5u, grid.dataSize().y);
+    EXPECT_EQ(7u, grid.dataSize().z);
+
+    grid.fill(42.0f);
+    EXPECT_FLOAT_EQ(42.0f, grid(5, 4, 6));
+
+    grid.fill([](const Vector3D& x) { return x.sum(); });
+    grid.forEachDataPointIndex([&] (size_t i, size_t j, size_t k) {
+        EXPECT_FLOAT_EQ(static_cast<float>(i + j + k), grid(i, j, k));
+    });
+
+    VertexCenteredScalarGrid3F grid2;
+    grid2 = grid;
+    auto grid3 = grid2.clone();
+    EXPECT_FLOAT_EQ(15.0f, (*grid3)(5, 4, 6));
+    EXPECT_NEAR(7.5, grid3->sample(Vector3D(2.5, 2.5, 2.5)), 1e-6);
+}
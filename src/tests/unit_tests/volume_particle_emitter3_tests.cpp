@@ -5,6 +5,8 @@
 #include <jet/volume_particle_emitter3.h>
 #include <gtest/gtest.h>
 
+#include <limits>
+
 using namespace jet;
 
 TEST(VolumeParticleEmitter3, Constructors) {
@@ -31,6 +33,39 @@ TEST(VolumeParticleEmitter3, Constructors) {
     EXPECT_EQ(2.5, emitter.initialVelocity().z);
 }
 
+TEST(VolumeParticleEmitter3, PreviewScale) {
+    auto sphere = std::make_shared<SurfaceToImplicit3>(
+        std::make_shared<Sphere3>(Vector3D(0.5, 0.5, 0.5), 0.4));
+    BoundingBox3D box({0.0, 0.0, 0.0}, {1.0, 1.0, 1.0});
+
+    VolumeParticleEmitter3 full(sphere, box, 0.05);
+    VolumeParticleEmitter3 preview(sphere, box, 0.05, Vector3D(), 800);
+    EXPECT_EQ(1.0, preview.previewScale());
+    EXPECT_THROW(preview.setPreviewScale(0.5), std::invalid_argument);
+
+    preview.setPreviewScale(2.0);
+    EXPECT_EQ(2.0, preview.previewScale());
+    EXPECT_DOUBLE_EQ(0.1, preview.spacing());
+    EXPECT_EQ(100u, preview.maxNumberOfParticles());
+
+    // About an eighth of the particles fill the same volume
+    VolumeParticleEmitter3 coarse(sphere, box, 0.05);
+    coarse.setPreviewScale(2.0);
+    EXPECT_EQ(
+        std::numeric_limits<size_t>::max(), coarse.maxNumberOfParticles());
+    auto fullParticles = std::make_shared<ParticleSystemData3>();
+    full.emit(Frame(), fullParticles);
+    auto coarseParticles = std::make_shared<ParticleSystemData3>();
+    coarse.emit(Frame(), coarseParticles);
+    double ratio = static_cast<double>(fullParticles->numberOfParticles())
+        / coarseParticles->numberOfParticles();
+    EXPECT_NEAR(8.0, ratio, 1.5);
+
+    preview.setPreviewScale(1.0);
+    EXPECT_DOUBLE_EQ(0.05, preview.spacing());
+    EXPECT_EQ(800u, preview.maxNumberOfParticles());
+}
+
 TEST(VolumeParticleEmitter3, Emit) {
     auto sphere = std::make_shared<SurfaceToImplicit3>(
         std::make_shared<Sphere3>(Vector3D(1.0, 2.0, 4.0), 3.0));
@@ -80,3 +115,31 @@ TEST(VolumeParticleEmitter3, Emit) {
     emitter.emit(frame, particles);
     EXPECT_LT(69u, particles->numberOfParticles());
 }
+
+TEST(VolumeParticleEmitter3, EmitJitteredOneShot) {
+    auto sphere = std::make_shared<SurfaceToImplicit3>(
+        std::make_shared<Sphere3>(Vector3D(0.5, 0.5, 0.5), 0.4));
+    BoundingBox3D box({0.0, 0.0, 0.0}, {1.0, 1.0, 1.0});
+
+    // More candidates than a random block, and a limit in the middle of them
+    VolumeParticleEmitter3 emitter(sphere, box, 0.02, {}, 5000, 0.5);
+    auto particles = std::make_shared<ParticleSystemData3>();
+    emitter.emit(Frame(), particles);
+    EXPECT_EQ(5000u, particles->numberOfParticles());
+
+    emitter.emit(Frame(), particles);
+    EXPECT_EQ(5000u, particles->numberOfParticles());
+
+    // Same seed gives the same particles
+    VolumeParticleEmitter3 emitter2(sphere, box, 0.02, {}, kMaxSize, 0.5);
+    auto particles2 = std::make_shared<ParticleSystemData3>();
+    emitter2.emit(Frame(), particles2);
+    EXPECT_LT(5000u, particles2->numberOfParticles());
+
+    auto pos = particles->positions();
+    auto pos2 = particles2->positions();
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        EXPECT_EQ(pos2[i], pos[i]);
+        EXPECT_GE(0.4, (pos[i] - Vector3D(0.5, 0.5, 0.5)).length());
+    }
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <validation_tests.h>
+#include <jet/box3.h>
+#include <jet/pci_sph_solver3.h>
+#include <jet/rigid_body_collider3.h>
+#include <jet/timer.h>
+#include <gtest/gtest.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+const double kTargetSpacing = 0.04;
+
+struct DamBreakState {
+    // Indexed by the initial order of the particles, which the sorting of
+    // the particles does not keep
+    std::vector<Vector3D> positions;
+    double densityError = 0.0;
+    double volume = 0.0;
+    double initialVolume = 0.0;
+    double front = 0.0;
+};
+
+// Sum of the particle volumes of the current densities
+double particleVolume(const SphSystemData3Ptr& particles) {
+    particles->buildNeighborSearcher();
+    particles->buildNeighborLists();
+    particles->updateDensities();
+
+    auto densities = particles->densities();
+    double volume = 0.0;
+    for (size_t i = 0; i < particles->numberOfParticles(); ++i) {
+        volume += particles->mass() / densities[i];
+    }
+    return volume;
+}
+
+// Collapses a block of water in a 1 x 1 x 0.5 box, and returns the time of
+// the simulation
+double runDamBreak(
+    const std::function<void(PciSphSolver3*)>& configure,
+    DamBreakState* state) {
+    PciSphSolver3 solver;
+    solver.setViscosityCoefficient(0.01);
+
+    SphSystemData3Ptr particles = solver.sphSystemData();
+    particles->setTargetDensity(1000.0);
+    particles->setTargetSpacing(kTargetSpacing);
+
+    Box3Ptr box = std::make_shared<Box3>(
+        Vector3D(), Vector3D(1.0, 1.0, 0.5));
+    box->isNormalFlipped = true;
+    solver.setCollider(std::make_shared<RigidBodyCollider3>(box));
+
+    std::vector<Vector3D> block;
+    for (double x = 0.5 * kTargetSpacing; x < 0.4; x += kTargetSpacing) {
+        for (double y = 0.5 * kTargetSpacing; y < 0.6; y += kTargetSpacing) {
+            for (double z = 0.5 * kTargetSpacing; z < 0.5;
+                 z += kTargetSpacing) {
+                block.push_back(Vector3D(x, y, z));
+            }
+        }
+    }
+    particles->addParticles(
+        ConstArrayAccessor1<Vector3D>(block.size(), block.data()));
+
+    size_t idIndex = particles->addScalarData();
+    auto ids = particles->scalarDataAt(idIndex);
+    for (size_t i = 0; i < block.size(); ++i) {
+        ids[i] = static_cast<double>(i);
+    }
+
+    configure(&solver);
+
+    state->initialVolume = particleVolume(particles);
+
+    double time = 0.0;
+    unsigned int numberOfFrames = validationNumberOfFrames(40);
+    for (Frame frame(1, 1.0 / 60.0); frame.index <= numberOfFrames;
+         frame.advance()) {
+        Timer timer;
+        solver.update(frame);
+        time += timer.durationInSeconds();
+    }
+
+    state->volume = particleVolume(particles);
+
+    size_t n = particles->numberOfParticles();
+    auto positions = particles->positions();
+    auto densities = particles->densities();
+    ids = particles->scalarDataAt(idIndex);
+    state->positions.resize(n);
+    state->densityError = 0.0;
+    state->front = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        state->positions[static_cast<size_t>(ids[i])] = positions[i];
+        state->densityError
+            += std::fabs(densities[i] / particles->targetDensity() - 1.0);
+        state->front = std::max(state->front, positions[i].x);
+    }
+    state->densityError /= n;
+
+    return time;
+}
+
+}  // namespace
+
+TEST(DamBreak, PciSphSolver3) {
+    const std::string scene = "DamBreak/PciSphSolver3";
+
+    DamBreakState reference;
+    auto report = [&](
+        const std::string& mode,
+        const std::function<void(PciSphSolver3*)>& configure) {
+        DamBreakState state;
+        double time = runDamBreak(configure, &state);
+
+        double positionError = 0.0;
+        if (state.positions.size() == reference.positions.size()) {
+            for (size_t i = 0; i < state.positions.size(); ++i) {
+                positionError += state.positions[i].distanceSquaredTo(
+                    reference.positions[i]);
+            }
+            positionError = std::sqrt(positionError / state.positions.size())
+                / kTargetSpacing;
+        }
+
+        reportValidation(scene, mode, time, {
+            {"density-error", state.densityError},
+            {"volume-drift",
+             std::fabs(state.volume / state.initialVolume - 1.0)},
+            {"position-error", positionError},
+            {"front-error",
+             std::fabs(state.front - reference.front) / kTargetSpacing}});
+
+        EXPECT_LT(state.densityError, 0.05) << mode;
+    };
+
+    double time = runDamBreak([](PciSphSolver3*) {}, &reference);
+    reportValidation(scene, "Reference", time, {
+        {"density-error", reference.densityError},
+        {"volume-drift",
+         std::fabs(reference.volume / reference.initialVolume - 1.0)}});
+
+    report("SymmetricPairForces", [](PciSphSolver3* solver) {
+        solver->setIsUsingSymmetricPairForces(true);
+    });
+    report("CachedPairKernels", [](PciSphSolver3* solver) {
+        solver->setIsCachingPairKernels(true);
+    });
+    report("PreviousPressureWarmStart", [](PciSphSolver3* solver) {
+        solver->setPressureWarmStart(
+            PciSphSolver3::PressureWarmStart::Previous);
+    });
+    report("ExtrapolatedPressureWarmStart", [](PciSphSolver3* solver) {
+        solver->setPressureWarmStart(
+            PciSphSolver3::PressureWarmStart::Extrapolated);
+    });
+    report("NeighborSearchSkin", [](PciSphSolver3* solver) {
+        solver->sphSystemData()->setNeighborSearchSkin(0.25 * kTargetSpacing);
+    });
+    report("ParticleSorting", [](PciSphSolver3* solver) {
+        solver->setParticleSortingInterval(10);
+    });
+    report("FusedStep", [](PciSphSolver3* solver) {
+        solver->setIsUsingFusedStep(true);
+    });
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <validation_tests.h>
+#include <jet/jet.h>
+#include <gtest/gtest.h>
+#include <fstream>
+
+using namespace jet;
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    parseValidationOptions(&argc, argv);
+
+    std::ofstream logFile("validation_tests.log");
+    if (logFile) {
+        Logging::setAllStream(&logFile);
+    }
+
+    int ret = RUN_ALL_TESTS();
+
+    writeValidationResults();
+
+    // The log file closes before the pending messages are written at exit
+    Logging::flush();
+
+    return ret;
+}
@@ -0,0 +1,208 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <validation_tests.h>
+#include <jet/box3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
+#include <jet/fdm_mgpcg_solver3.h>
+#include <jet/grid_fractional_single_phase_pressure_solver3.h>
+#include <jet/grid_smoke_solver3.h>
+#include <jet/implicit_surface_set3.h>
+#include <jet/level_set_utils.h>
+#include <jet/timer.h>
+#include <gtest/gtest.h>
+#include <functional>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+const size_t kResolutionX = 32;
+
+const double kTolerance = 1e-6;
+
+struct SmokePlumeState {
+    Array3<double> density;
+    Array3<double> dye;
+    double divergence = 0.0;
+};
+
+GridFractionalSinglePhasePressureSolver3Ptr pressureSolver(
+    const FdmLinearSystemSolver3Ptr& systemSolver) {
+    auto solver = std::make_shared<GridFractionalSinglePhasePressureSolver3>();
+    solver->setLinearSystemSolver(systemSolver);
+    return solver;
+}
+
+template <typename T>
+void copyData(const ConstArrayAccessor3<T>& data, Array3<double>* output) {
+    output->resize(data.size());
+    data.forEachIndex([&](size_t i, size_t j, size_t k) {
+        (*output)(i, j, k) = static_cast<double>(data(i, j, k));
+    });
+}
+
+// The iterations are not capped before the tolerance, so that all the
+// solvers reach the same one
+unsigned int maxNumberOfIterations() {
+    return static_cast<unsigned int>(
+        kResolutionX * kResolutionX * kResolutionX * 3 / 2);
+}
+
+// Raises a hot plume from a box source in a closed box, which also emits a
+// passive dye in double or single precision, and returns the time of the
+// simulation
+double runSmokePlume(
+    const std::function<void(GridSmokeSolver3*)>& configure,
+    bool isUsingFloatDye,
+    SmokePlumeState* state) {
+    Size3 resolution(kResolutionX, 3 * kResolutionX / 2, kResolutionX);
+    double dx = 1.0 / kResolutionX;
+
+    GridSmokeSolver3 solver;
+    solver.setBuoyancyTemperatureFactor(2.0);
+    solver.setPressureSolver(
+        pressureSolver(
+            std::make_shared<FdmIccgSolver3>(
+                maxNumberOfIterations(), kTolerance)));
+
+    auto grids = solver.gridSystemData();
+    grids->resize(resolution, Vector3D(dx, dx, dx), Vector3D());
+
+    size_t dyeIndex = 0;
+    if (isUsingFloatDye) {
+        dyeIndex = grids->addAdvectableScalarDataF(
+            CellCenteredScalarGrid3F::builder());
+    } else {
+        dyeIndex = grids->addAdvectableScalarData(
+            CellCenteredScalarGrid3::builder());
+    }
+
+    configure(&solver);
+
+    ImplicitSurfaceSet3 source;
+    source.addExplicitSurface(
+        std::make_shared<Box3>(
+            Vector3D(0.4, 0.05, 0.4), Vector3D(0.6, 0.15, 0.6)));
+    auto sourceFunc = [&](const Vector3D& pt) {
+        return 1.0 - smearedHeavisideSdf(source.signedDistance(pt) / dx);
+    };
+
+    auto emit = [&](ScalarGrid3* grid) {
+        auto pos = grid->dataPosition();
+        grid->parallelForEachDataPointIndex(
+            [&](size_t i, size_t j, size_t k) {
+                (*grid)(i, j, k)
+                    = std::max((*grid)(i, j, k), sourceFunc(pos(i, j, k)));
+            });
+    };
+
+    double time = 0.0;
+    unsigned int numberOfFrames = validationNumberOfFrames(60);
+    for (Frame frame(1, 1.0 / 60.0); frame.index <= numberOfFrames;
+         frame.advance()) {
+        emit(solver.smokeDensity().get());
+        emit(solver.temperature().get());
+        if (isUsingFloatDye) {
+            const ScalarGrid3FPtr& dye
+                = grids->advectableScalarDataFAt(dyeIndex);
+            auto pos = dye->dataPosition();
+            dye->parallelForEachDataPointIndex(
+                [&](size_t i, size_t j, size_t k) {
+                    (*dye)(i, j, k) = std::max(
+                        (*dye)(i, j, k),
+                        static_cast<float>(sourceFunc(pos(i, j, k))));
+                });
+        } else {
+            emit(grids->advectableScalarDataAt(dyeIndex).get());
+        }
+
+        Timer timer;
+        solver.update(frame);
+        time += timer.durationInSeconds();
+    }
+
+    copyData(solver.smokeDensity()->constDataAccessor(), &state->density);
+    if (isUsingFloatDye) {
+        copyData(
+            grids->advectableScalarDataFAt(dyeIndex)->constDataAccessor(),
+            &state->dye);
+    } else {
+        copyData(
+            grids->advectableScalarDataAt(dyeIndex)->constDataAccessor(),
+            &state->dye);
+    }
+    state->divergence = divergenceNorm(*solver.velocity());
+
+    return time;
+}
+
+}  // namespace
+
+TEST(SmokePlume, GridSmokeSolver3) {
+    const std::string scene = "SmokePlume/GridSmokeSolver3";
+
+    SmokePlumeState reference;
+    auto report = [&](
+        const std::string& mode,
+        const std::function<void(GridSmokeSolver3*)>& configure,
+        bool isUsingFloatDye) {
+        SmokePlumeState state;
+        double time = runSmokePlume(configure, isUsingFloatDye, &state);
+
+        double densityError = relativeL2Error(
+            state.density.constAccessor(), reference.density.constAccessor());
+        double dyeError = relativeL2Error(
+            state.dye.constAccessor(), reference.dye.constAccessor());
+        reportValidation(scene, mode, time, {
+            {"divergence-norm", state.divergence},
+            {"density-error", densityError},
+            {"dye-error", dyeError}});
+
+        EXPECT_LT(densityError, 0.1) << mode;
+    };
+
+    double time = runSmokePlume([](GridSmokeSolver3*) {}, false, &reference);
+    reportValidation(scene, "Reference", time, {
+        {"divergence-norm", reference.divergence}});
+
+    report("BlockIccg", [](GridSmokeSolver3* solver) {
+        solver->setPressureSolver(
+            pressureSolver(
+                std::make_shared<FdmIccgSolver3>(
+                    maxNumberOfIterations(), kTolerance,
+                    FdmIccgSolver3::BlockIncompleteCholesky)));
+    }, false);
+    report("MixedPrecisionIccg", [](GridSmokeSolver3* solver) {
+        auto systemSolver = std::make_shared<FdmIccgSolver3>(
+            maxNumberOfIterations(), kTolerance);
+        systemSolver->setIsUsingMixedPrecision(true);
+        solver->setPressureSolver(pressureSolver(systemSolver));
+    }, false);
+    report("MatrixFreeCg", [](GridSmokeSolver3* solver) {
+        solver->setPressureSolver(
+            pressureSolver(
+                std::make_shared<FdmMatrixFreeCgSolver3>(
+                    maxNumberOfIterations(), kTolerance)));
+    }, false);
+    report("Mgpcg", [](GridSmokeSolver3* solver) {
+        solver->setPressureSolver(
+            pressureSolver(
+                std::make_shared<FdmMgpcgSolver3>(
+                    4, maxNumberOfIterations(), kTolerance)));
+    }, false);
+    report("PressureWarmStart", [](GridSmokeSolver3* solver) {
+        auto pressure = pressureSolver(
+            std::make_shared<FdmIccgSolver3>(
+                maxNumberOfIterations(), kTolerance));
+        pressure->setIsUsingWarmStart(true);
+        solver->setPressureSolver(pressure);
+    }, false);
+    report("ScalarUpdateInterval", [](GridSmokeSolver3* solver) {
+        solver->setSmokeDensityUpdateInterval(2);
+        solver->setTemperatureUpdateInterval(2);
+    }, false);
+    report("FloatDye", [](GridSmokeSolver3*) {}, true);
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <validation_tests.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_cg_solver3.h>
+#include <jet/fdm_mgpcg_solver3.h>
+#include <jet/grid_fractional_single_phase_pressure_solver3.h>
+#include <jet/implicit_surface_set3.h>
+#include <jet/level_set_liquid_solver3.h>
+#include <jet/plane3.h>
+#include <jet/sphere3.h>
+#include <jet/timer.h>
+#include <gtest/gtest.h>
+#include <functional>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+const size_t kResolution = 32;
+
+const double kTolerance = 1e-6;
+
+struct SphereDropState {
+    CellCenteredScalarGrid3 sdf;
+    double volume = 0.0;
+    double initialVolume = 0.0;
+    double divergence = 0.0;
+};
+
+GridFractionalSinglePhasePressureSolver3Ptr pressureSolver(
+    const FdmLinearSystemSolver3Ptr& systemSolver) {
+    auto solver = std::make_shared<GridFractionalSinglePhasePressureSolver3>();
+    solver->setLinearSystemSolver(systemSolver);
+    return solver;
+}
+
+unsigned int maxNumberOfIterations() {
+    return static_cast<unsigned int>(kResolution * kResolution * kResolution);
+}
+
+// Drops a liquid sphere into a pool in a closed unit box, and returns the
+// time of the simulation
+double runSphereDrop(
+    const std::function<void(LevelSetLiquidSolver3*)>& configure,
+    SphereDropState* state) {
+    double dx = 1.0 / kResolution;
+
+    LevelSetLiquidSolver3 solver;
+    solver.gridSystemData()->resize(
+        Size3(kResolution, kResolution, kResolution),
+        Vector3D(dx, dx, dx),
+        Vector3D());
+    solver.setPressureSolver(
+        pressureSolver(
+            std::make_shared<FdmIccgSolver3>(
+                maxNumberOfIterations(), kTolerance)));
+
+    ImplicitSurfaceSet3 surfaceSet;
+    surfaceSet.addExplicitSurface(
+        std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, 0.3, 0)));
+    surfaceSet.addExplicitSurface(
+        std::make_shared<Sphere3>(Vector3D(0.5, 0.65, 0.5), 0.15));
+
+    ScalarGrid3Ptr sdf = solver.signedDistanceField();
+    sdf->fill([&](const Vector3D& x) {
+        return surfaceSet.signedDistance(x);
+    });
+
+    configure(&solver);
+
+    state->initialVolume = liquidVolume(*sdf);
+
+    double time = 0.0;
+    unsigned int numberOfFrames = validationNumberOfFrames(40);
+    for (Frame frame(1, 1.0 / 60.0); frame.index <= numberOfFrames;
+         frame.advance()) {
+        Timer timer;
+        solver.update(frame);
+        time += timer.durationInSeconds();
+    }
+
+    state->sdf.resize(sdf->resolution(), sdf->gridSpacing(), sdf->origin());
+    state->sdf.parallelForEachDataPointIndex(
+        [&](size_t i, size_t j, size_t k) {
+            state->sdf(i, j, k) = (*sdf)(i, j, k);
+        });
+    state->volume = liquidVolume(*sdf);
+    state->divergence = divergenceNorm(*solver.velocity(), sdf.get());
+
+    return time;
+}
+
+}  // namespace
+
+TEST(SphereDrop, LevelSetLiquidSolver3) {
+    const std::string scene = "SphereDrop/LevelSetLiquidSolver3";
+
+    SphereDropState reference;
+    auto report = [&](
+        const std::string& mode,
+        const std::function<void(LevelSetLiquidSolver3*)>& configure) {
+        SphereDropState state;
+        double time = runSphereDrop(configure, &state);
+
+        double volumeDrift
+            = std::fabs(state.volume / state.initialVolume - 1.0);
+        reportValidation(scene, mode, time, {
+            {"divergence-norm", state.divergence},
+            {"volume-drift", volumeDrift},
+            {"sdf-distance",
+                interfaceDistance(state.sdf, reference.sdf, 3.0)}});
+
+        EXPECT_LT(volumeDrift, 0.1) << mode;
+    };
+
+    double time = runSphereDrop([](LevelSetLiquidSolver3*) {}, &reference);
+    reportValidation(scene, "Reference", time, {
+        {"divergence-norm", reference.divergence},
+        {"volume-drift",
+         std::fabs(reference.volume / reference.initialVolume - 1.0)}});
+
+    report("MatrixFreeCg", [](LevelSetLiquidSolver3* solver) {
+        solver->setPressureSolver(
+            pressureSolver(
+                std::make_shared<FdmMatrixFreeCgSolver3>(
+                    maxNumberOfIterations(), kTolerance)));
+    });
+    report("Mgpcg", [](LevelSetLiquidSolver3* solver) {
+        solver->setPressureSolver(
+            pressureSolver(
+                std::make_shared<FdmMgpcgSolver3>(
+                    4, maxNumberOfIterations(), kTolerance)));
+    });
+    report("CompressedSystem", [](LevelSetLiquidSolver3* solver) {
+        auto pressure = pressureSolver(
+            std::make_shared<FdmIccgSolver3>(
+                maxNumberOfIterations(), kTolerance));
+        pressure->setIsUsingCompressedSystem(true);
+        solver->setPressureSolver(pressure);
+    });
+    report("PressureWarmStart", [](LevelSetLiquidSolver3* solver) {
+        auto pressure = pressureSolver(
+            std::make_shared<FdmIccgSolver3>(
+                maxNumberOfIterations(), kTolerance));
+        pressure->setIsUsingWarmStart(true);
+        solver->setPressureSolver(pressure);
+    });
+    report("NarrowBandLevelSet", [](LevelSetLiquidSolver3* solver) {
+        solver->levelSetSolver()->setIsUsingNarrowBand(true);
+    });
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <validation_tests.h>
+#include <jet/box3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/implicit_surface_set3.h>
+#include <jet/marching_cubes.h>
+#include <jet/sphere3.h>
+#include <jet/timer.h>
+#include <jet/triangle_mesh_sdf_cache3.h>
+#include <jet/triangle_mesh_to_sdf.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+using namespace jet;
+
+namespace {
+
+const size_t kResolution = 64;
+
+// Triangulates a sphere merged with a box, which has both the curved and
+// the sharp features
+TriangleMesh3 buildMesh() {
+    ImplicitSurfaceSet3 surfaceSet;
+    surfaceSet.addExplicitSurface(
+        std::make_shared<Sphere3>(Vector3D(0.4, 0.5, 0.5), 0.25));
+    surfaceSet.addExplicitSurface(
+        std::make_shared<Box3>(
+            Vector3D(0.45, 0.3, 0.35), Vector3D(0.8, 0.7, 0.65)));
+
+    const size_t n = 48;
+    CellCenteredScalarGrid3 grid(
+        Size3(n, n, n), Vector3D(1.0 / n, 1.0 / n, 1.0 / n));
+    grid.fill([&](const Vector3D& x) {
+        return surfaceSet.signedDistance(x);
+    });
+
+    TriangleMesh3 mesh;
+    marchingCubes(
+        grid.constDataAccessor(),
+        grid.gridSpacing(),
+        grid.dataOrigin(),
+        &mesh);
+    return mesh;
+}
+
+CellCenteredScalarGrid3 emptySdf() {
+    double dx = 1.0 / kResolution;
+    return CellCenteredScalarGrid3(
+        Size3(kResolution, kResolution, kResolution), Vector3D(dx, dx, dx));
+}
+
+}  // namespace
+
+TEST(MeshSdf, TriangleMeshToSdf) {
+    const std::string scene = "MeshSdf/TriangleMeshToSdf";
+    const TriangleMesh3 mesh = buildMesh();
+
+    CellCenteredScalarGrid3 reference = emptySdf();
+    auto report = [&](
+        const std::string& mode,
+        const std::function<void(ScalarGrid3*)>& generate) {
+        CellCenteredScalarGrid3 sdf = emptySdf();
+        Timer timer;
+        generate(&sdf);
+        double time = timer.durationInSeconds();
+
+        double sdfDistance = interfaceDistance(sdf, reference, 2.0);
+        reportValidation(scene, mode, time, {
+            {"sdf-distance", sdfDistance},
+            {"mesh-distance", meshDistance(sdf, mesh)}});
+
+        EXPECT_LT(sdfDistance, 1.0) << mode;
+    };
+
+    Timer timer;
+    triangleMeshToSdf(mesh, &reference, 3);
+    double time = timer.durationInSeconds();
+    reportValidation(scene, "Reference", time, {
+        {"mesh-distance", meshDistance(reference, mesh)}});
+
+    report("ExactBand1", [&](ScalarGrid3* sdf) {
+        triangleMeshToSdf(mesh, sdf, 1);
+    });
+    report("NarrowBandOnly", [&](ScalarGrid3* sdf) {
+        triangleMeshToSdf(mesh, sdf, 3, true);
+    });
+
+    // The time of the cache is the one of a hit, since the miss is about the
+    // same as the reference
+    TriangleMeshSdfCache3 cache(".");
+    CellCenteredScalarGrid3 cached = emptySdf();
+    cache.bake(mesh, &cached, 3);
+    report("SdfCacheHit", [&](ScalarGrid3* sdf) {
+        cache.bake(mesh, sdf, 3);
+    });
+    std::remove(
+        cache.filename(TriangleMeshSdfCache3::key(mesh, cached, 3)).c_str());
+}
@@ -0,0 +1,235 @@
+// Copyright (c) 2016 Doyub Kim
+
+#include <validation_tests.h>
+#include <jet/level_set_utils.h>
+#include <jet/marching_cubes.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace jet {
+
+namespace {
+
+struct ValidationOptions {
+    unsigned int numberOfFrames = 0;
+    std::string jsonFilename = "validation_tests.json";
+};
+
+ValidationOptions sOptions;
+std::vector<ValidationResult> sResults;
+
+bool parseOption(const char* arg, const char* name, std::string* value) {
+    size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) == 0 && arg[length] == '=') {
+        *value = arg + length + 1;
+        return true;
+    }
+    return false;
+}
+
+// Returns the time of the first result of the scene, or zero if the scene
+// has no result yet
+double referenceTimeInSeconds(const std::string& scene) {
+    for (const ValidationResult& result : sResults) {
+        if (result.scene == scene) {
+            return result.timeInSeconds;
+        }
+    }
+    return 0.0;
+}
+
+void writeEscaped(const std::string& str, std::ostream* strm) {
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            (*strm) << '\\';
+        }
+        (*strm) << c;
+    }
+}
+
+}  // namespace
+
+void parseValidationOptions(int* argc, char** argv) {
+    int numberOfArgs = 1;
+    for (int i = 1; i < *argc; ++i) {
+        std::string value;
+        if (parseOption(argv[i], "--validation_frames", &value)) {
+            sOptions.numberOfFrames = static_cast<unsigned int>(
+                std::max(std::atoi(value.c_str()), 1));
+        } else if (parseOption(argv[i], "--validation_json", &value)) {
+            sOptions.jsonFilename = value;
+        } else {
+            argv[numberOfArgs++] = argv[i];
+        }
+    }
+    *argc = numberOfArgs;
+}
+
+unsigned int validationNumberOfFrames(unsigned int defaultNumber) {
+    return (sOptions.numberOfFrames > 0)
+        ? sOptions.numberOfFrames : defaultNumber;
+}
+
+void reportValidation(
+    const std::string& scene,
+    const std::string& mode,
+    double timeInSeconds,
+    const ValidationErrors& errors) {
+    ValidationResult result;
+    result.scene = scene;
+    result.mode = mode;
+    result.timeInSeconds = timeInSeconds;
+    result.errors = errors;
+
+    double referenceTime = referenceTimeInSeconds(scene);
+    if (referenceTime > 0.0 && timeInSeconds > 0.0) {
+        result.speedup = referenceTime / timeInSeconds;
+    }
+
+    std::ostringstream strm;
+    strm << std::setprecision(4) << scene << '/' << mode << ": "
+         << timeInSeconds << " s, " << result.speedup << "x";
+    for (const auto& error : errors) {
+        strm << ", " << error.first << " " << error.second;
+    }
+    JET_PRINT_INFO("%s\n", strm.str().c_str());
+
+    sResults.push_back(result);
+}
+
+const std::vector<ValidationResult>& validationResults() {
+    return sResults;
+}
+
+void writeValidationResults(std::ostream* strm) {
+    std::time_t now = std::time(nullptr);
+    char dateStr[32];
+    std::strftime(
+        dateStr, sizeof(dateStr), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    (*strm) << std::setprecision(9);
+    (*strm) << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << dateStr << "\",\n"
+            << "    \"executable\": \"validation_tests\",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency()
+            << ",\n"
+#ifdef JET_DEBUG_MODE
+            << "    \"library_build_type\": \"debug\"\n"
+#else
+            << "    \"library_build_type\": \"release\"\n"
+#endif
+            << "  },\n  \"results\": [";
+
+    for (size_t i = 0; i < sResults.size(); ++i) {
+        const ValidationResult& result = sResults[i];
+        (*strm) << ((i > 0) ? ",\n" : "\n") << "    {\n";
+
+        (*strm) << "      \"scene\": \"";
+        writeEscaped(result.scene, strm);
+        (*strm) << "\",\n      \"mode\": \"";
+        writeEscaped(result.mode, strm);
+        (*strm) << "\",\n";
+
+        (*strm) << "      \"time\": " << result.timeInSeconds << ",\n"
+                << "      \"speedup\": " << result.speedup << ",\n"
+                << "      \"errors\": {";
+
+        for (size_t j = 0; j < result.errors.size(); ++j) {
+            (*strm) << ((j > 0) ? ",\n" : "\n") << "        \"";
+            writeEscaped(result.errors[j].first, strm);
+            (*strm) << "\": " << result.errors[j].second;
+        }
+
+        (*strm) << (result.errors.empty() ? "}\n" : "\n      }\n")
+                << "    }";
+    }
+
+    (*strm) << "\n  ]\n}\n";
+}
+
+void writeValidationResults() {
+    std::ofstream file(sOptions.jsonFilename.c_str());
+    if (file) {
+        writeValidationResults(&file);
+    }
+}
+
+double divergenceNorm(
+    const FaceCenteredGrid3& velocity,
+    const ScalarGrid3* fluidSdf) {
+    double sum = 0.0;
+    size_t count = 0;
+    velocity.forEachCellIndex([&](size_t i, size_t j, size_t k) {
+        if (fluidSdf == nullptr || (*fluidSdf)(i, j, k) < 0.0) {
+            double div = velocity.divergenceAtCellCenter(i, j, k);
+            sum += div * div;
+            ++count;
+        }
+    });
+
+    return (count > 0) ? std::sqrt(sum / count) : 0.0;
+}
+
+double liquidVolume(const ScalarGrid3& sdf) {
+    const Vector3D& h = sdf.gridSpacing();
+    double cellVolume = h.x * h.y * h.z;
+    double dx = h.min();
+
+    double volume = 0.0;
+    sdf.constDataAccessor().forEachIndex([&](size_t i, size_t j, size_t k) {
+        volume += 1.0 - smearedHeavisideSdf(sdf(i, j, k) / dx);
+    });
+
+    return volume * cellVolume;
+}
+
+double interfaceDistance(
+    const ScalarGrid3& sdf,
+    const ScalarGrid3& referenceSdf,
+    double bandWidth) {
+    double dx = referenceSdf.gridSpacing().min();
+
+    double maxDistance = 0.0;
+    referenceSdf.constDataAccessor().forEachIndex(
+        [&](size_t i, size_t j, size_t k) {
+            double phi = referenceSdf(i, j, k);
+            if (std::fabs(phi) < bandWidth * dx) {
+                maxDistance
+                    = std::max(maxDistance, std::fabs(sdf(i, j, k) - phi));
+            }
+        });
+
+    return maxDistance / dx;
+}
+
+double meshDistance(const ScalarGrid3& sdf, const TriangleMesh3& mesh) {
+    TriangleMesh3 levelSet;
+    marchingCubes(
+        sdf.constDataAccessor(),
+        sdf.gridSpacing(),
+        sdf.dataOrigin(),
+        &levelSet,
+        0.0,
+        kMarchingCubesBoundaryFlagNone);
+
+    size_t n = levelSet.numberOfPoints();
+    if (n == 0) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += mesh.closestDistance(levelSet.point(i));
+    }
+
+    return sum / n / sdf.gridSpacing().min();
+}
+
+}  // namespace jet
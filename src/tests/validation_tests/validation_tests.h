@@ -0,0 +1,150 @@
+// Copyright (c) 2016 Doyub Kim
+
+#ifndef SRC_TESTS_VALIDATION_TESTS_VALIDATION_TESTS_H_
+#define SRC_TESTS_VALIDATION_TESTS_VALIDATION_TESTS_H_
+
+#include <jet/array_accessor3.h>
+#include <jet/face_centered_grid3.h>
+#include <jet/scalar_grid3.h>
+#include <jet/triangle_mesh3.h>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+// gtest hack
+namespace testing {
+
+namespace internal {
+
+enum GTestColor {
+    COLOR_DEFAULT,
+    COLOR_RED,
+    COLOR_GREEN,
+    COLOR_YELLOW
+};
+
+extern void ColoredPrintf(GTestColor color, const char* fmt, ...);
+
+}  // namespace internal
+
+}  // namespace testing
+
+#define JET_PRINT_INFO(fmt, ...) \
+    testing::internal::ColoredPrintf( \
+        testing::internal::COLOR_YELLOW,  "[----------] "); \
+    testing::internal::ColoredPrintf( \
+        testing::internal::COLOR_YELLOW, fmt, __VA_ARGS__); \
+
+namespace jet {
+
+//! Error metrics of a name and a value, such as ("volume-drift", 0.01).
+typedef std::vector<std::pair<std::string, double>> ValidationErrors;
+
+//! Timing and errors of a scene run in a mode.
+struct ValidationResult {
+    std::string scene;
+    std::string mode;
+    double timeInSeconds = 0.0;
+
+    //! Time of the reference mode of the scene divided by the time of this
+    //! mode.
+    double speedup = 1.0;
+
+    ValidationErrors errors;
+};
+
+//!
+//! \brief Parses and removes the validation options from the command line.
+//!
+//! The options are --validation_frames=N to run every scene for N frames
+//! instead of its own number, which gives a quick check of the modes, and
+//! --validation_json=FILE for the result file (default is
+//! validation_tests.json).
+//!
+void parseValidationOptions(int* argc, char** argv);
+
+//! Returns the number of frames to run a scene for, which is
+//! \p defaultNumber unless --validation_frames is given.
+unsigned int validationNumberOfFrames(unsigned int defaultNumber);
+
+//!
+//! \brief Records and prints the result of a scene run in a mode.
+//!
+//! The first mode reported for a scene is its reference, which should be the
+//! current production path, and the speedups of the following modes of the
+//! scene are relative to it. The errors of the reference are reported as
+//! well, since metrics such as the volume drift are not zero for it either.
+//!
+void reportValidation(
+    const std::string& scene,
+    const std::string& mode,
+    double timeInSeconds,
+    const ValidationErrors& errors);
+
+//! Returns the results of all the modes run so far.
+const std::vector<ValidationResult>& validationResults();
+
+//! Writes the results in JSON, with the errors of each result as an object.
+void writeValidationResults(std::ostream* strm);
+
+//! Writes the results to the file given by --validation_json.
+void writeValidationResults();
+
+//!
+//! \brief Returns the root-mean-square of the divergence of \p velocity at
+//!     the cell centers.
+//!
+//! If \p fluidSdf is given, only the cells inside of the fluid are counted,
+//! where the field should be cell-centered on the same grid.
+//!
+double divergenceNorm(
+    const FaceCenteredGrid3& velocity,
+    const ScalarGrid3* fluidSdf = nullptr);
+
+//! Returns the volume inside of the zero level set of \p sdf, smeared over
+//! a cell across the interface.
+double liquidVolume(const ScalarGrid3& sdf);
+
+//!
+//! \brief Returns the max difference of \p sdf from \p referenceSdf in the
+//!     grid spacing, within \p bandWidth cells from the reference interface.
+//!
+double interfaceDistance(
+    const ScalarGrid3& sdf,
+    const ScalarGrid3& referenceSdf,
+    double bandWidth);
+
+//!
+//! \brief Returns the mean distance of the zero level set of \p sdf from
+//!     \p mesh in the grid spacing.
+//!
+//! The level set is triangulated by the marching cubes, and the distances
+//! of its vertices to the mesh are averaged.
+//!
+double meshDistance(const ScalarGrid3& sdf, const TriangleMesh3& mesh);
+
+//! Returns the L2-norm of the difference of \p data from \p reference
+//! relative to the L2-norm of the reference.
+template <typename T, typename U>
+double relativeL2Error(
+    const ConstArrayAccessor3<T>& data,
+    const ConstArrayAccessor3<U>& reference) {
+    double diffSquared = 0.0;
+    double referenceSquared = 0.0;
+    reference.forEachIndex([&](size_t i, size_t j, size_t k) {
+        double r = static_cast<double>(reference(i, j, k));
+        double d = static_cast<double>(data(i, j, k)) - r;
+        diffSquared += d * d;
+        referenceSquared += r * r;
+    });
+
+    if (referenceSquared > 0.0) {
+        return std::sqrt(diffSquared / referenceSquared);
+    }
+    return std::sqrt(diffSquared);
+}
+
+}  // namespace jet
+
+#endif  // SRC_TESTS_VALIDATION_TESTS_VALIDATION_TESTS_H_